@@ -0,0 +1,23 @@
+
+// This pounds on macro expansion for performance reasons.  It mimics X-macro
+// tables and Boost.PP-style metaprogramming: the arguments of function-like
+// macros are themselves macro invocations, so argument pre-expansion nests
+// many levels deep, and the pre-expanded arguments are long.
+
+#define ID(x) x
+#define D4(x) ID(ID(ID(ID(x))))
+#define D16(x) D4(D4(D4(D4(x))))
+
+// X-macro table.
+#define ENTRY(name) D16(int name##_v = sizeof(#name);)
+#define TABLE(X) X(a0) X(a1) X(a2) X(a3) X(a4) X(a5) X(a6) X(a7) \
+                 X(a8) X(a9) X(a10) X(a11) X(a12) X(a13) X(a14) X(a15)
+
+#define B0(X) ID(TABLE(X))
+#define B1(X) B0(X) B0(X) B0(X) B0(X) B0(X) B0(X)
+#define B2(X) B1(X) B1(X) B1(X) B1(X) B1(X) B1(X)
+#define B3(X) B2(X) B2(X) B2(X) B2(X) B2(X) B2(X)
+#define B4(X) B3(X) B3(X) B3(X) B3(X) B3(X) B3(X)
+#define B5(X) B4(X) B4(X) B4(X) B4(X) B4(X) B4(X)
+
+B5(ENTRY)
@@ -22,6 +22,7 @@
 #include "clang-c/CXErrorCode.h"
 #include "clang-c/CXString.h"
 #include "clang-c/BuildSystem.h"
+#include "clang-c/CXCompilationDatabase.h"
 
 /**
  * \brief The version constants for the libclang API.
@@ -32,7 +33,7 @@
  * compatible, thus CINDEX_VERSION_MAJOR is expected to remain stable.
  */
 #define CINDEX_VERSION_MAJOR 0
-#define CINDEX_VERSION_MINOR 43
+#define CINDEX_VERSION_MINOR 45
 
 #define CINDEX_VERSION_ENCODE(major, minor) ( \
       ((major) * 10000)                       \
@@ -1485,6 +1486,36 @@ CINDEX_LINKAGE int clang_saveTranslationUnit(CXTranslationUnit TU,
  */
 CINDEX_LINKAGE unsigned clang_suspendTranslationUnit(CXTranslationUnit);
 
+/**
+ * \brief Freeze a translation unit so that it can be queried by several
+ * threads at once.
+ *
+ * Freezing computes the parts of the translation unit that are otherwise
+ * computed, or deserialized from the precompiled preamble, the first time
+ * they are queried. Afterwards, the following functions can be called on the
+ * translation unit concurrently:
+ *
+ *   - the cursor functions, such as \c clang_getCursor(),
+ *     \c clang_getCursorKind(), \c clang_getCursorSpelling(),
+ *     \c clang_getCursorReferenced() and \c clang_visitChildren();
+ *   - the source location and source range functions, such as
+ *     \c clang_getCursorExtent(), \c clang_getExpansionLocation() and
+ *     \c clang_getPresumedLocation();
+ *   - the type functions of complete types, such as \c clang_getCursorType(),
+ *     \c clang_Type_getSizeOf() and \c clang_Type_getOffsetOf();
+ *   - the comment functions, such as \c clang_Cursor_getRawCommentText().
+ *
+ * Other functions, and the disposal of the translation unit, still need to
+ * be serialized by the client.
+ *
+ * A frozen translation unit cannot be reparsed, suspended or used for code
+ * completion.
+ *
+ * \returns 0 on success, or an error code of \c CXErrorCode otherwise.
+ */
+CINDEX_LINKAGE enum CXErrorCode
+clang_freezeTranslationUnit(CXTranslationUnit);
+
 /**
  * \brief Destroy the specified CXTranslationUnit object.
  */
@@ -6165,6 +6196,9 @@ typedef enum {
    * \brief Skip a function/method body that was already parsed during an
    * indexing session associated with a \c CXIndexAction object.
    * Bodies in system headers are always skipped.
+   *
+   * The session may be shared by source files that are indexed concurrently,
+   * in which case a body is parsed by only one of them.
    */
   CXIndexOpt_SkipParsedBodiesInSession = 0x10
 
@@ -6220,6 +6254,35 @@ CINDEX_LINKAGE int clang_indexSourceFileFullArgv(
     int num_command_line_args, struct CXUnsavedFile *unsaved_files,
     unsigned num_unsaved_files, CXTranslationUnit *out_TU, unsigned TU_options);
 
+/**
+ * \brief Index all the source files of a compilation database, in parallel,
+ * via callbacks implemented through #IndexerCallbacks.
+ *
+ * Each compile command of the database is indexed like
+ * #clang_indexSourceFileFullArgv does, in the working directory of the
+ * command. The callbacks are invoked concurrently from several threads, so
+ * they need to be thread-safe. When \c CXIndexOpt_SkipParsedBodiesInSession is
+ * set, a function body of a header that is included by several source files is
+ * parsed only once for all of them.
+ *
+ * \param index_action The indexing session shared by all the source files.
+ *
+ * \param database The compilation database whose compile commands are indexed.
+ *
+ * \param num_threads The number of threads used for indexing. If 0, the number
+ * of hardware threads is used.
+ *
+ * \returns The number of compile commands that failed to be indexed, or a
+ * negative \c CXErrorCode if the arguments are invalid.
+ *
+ * The rest of the parameters are the same as #clang_indexSourceFile.
+ */
+CINDEX_LINKAGE int clang_indexCompilationDatabase(
+    CXIndexAction index_action, CXClientData client_data,
+    IndexerCallbacks *index_callbacks, unsigned index_callbacks_size,
+    unsigned index_options, CXCompilationDatabase database,
+    unsigned TU_options, unsigned num_threads);
+
 /**
  * \brief Index the given translation unit via callbacks implemented through
  * #IndexerCallbacks.
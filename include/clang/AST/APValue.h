@@ -65,6 +65,39 @@ public:
   struct NoLValuePath {};
   struct UninitArray {};
   struct UninitStruct {};
+
+  /// \brief A cache of the element storage of the arrays, structs and unions
+  /// destroyed on this thread, for reuse by those created on this thread
+  /// while the pool is alive.
+  ///
+  /// The constant evaluator creates and destroys aggregate values at a high
+  /// rate, and sets up a pool for each evaluation. Only the storage of small
+  /// aggregates is cached; it is returned to the heap when the pool is
+  /// destroyed. Pools nest, and the innermost pool of the thread is used.
+  class ElementPool {
+  public:
+    ElementPool();
+    ~ElementPool();
+    ElementPool(const ElementPool &) = delete;
+    ElementPool &operator=(const ElementPool &) = delete;
+
+  private:
+    friend class APValue;
+
+    /// \brief The largest number of elements of the storage that is cached,
+    /// and the most pieces of storage cached for each number of elements.
+    enum { MaxPooledElts = 32, MaxPooledPerSize = 32 };
+
+    void *take(unsigned NumElts);
+    bool give(void *Elts, unsigned NumElts);
+
+    ElementPool *Previous;
+    /// \brief The cached storage for I + 1 elements, linked through its
+    /// first pointer.
+    void *FreeLists[MaxPooledElts];
+    unsigned char NumFree[MaxPooledElts];
+  };
+
 private:
   ValueKind Kind;
 
@@ -398,6 +431,9 @@ public:
   }
 
 private:
+  static APValue *allocateElts(unsigned NumElts);
+  static void deallocateElts(APValue *Elts, unsigned NumElts);
+
   void DestroyDataAndMakeUninit();
   void MakeUninit() {
     if (Kind != Uninitialized)
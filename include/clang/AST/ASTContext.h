@@ -29,6 +29,7 @@
 #include "clang/AST/TemplateBase.h"
 #include "clang/AST/TemplateName.h"
 #include "clang/AST/Type.h"
+#include "clang/AST/TypeOrdering.h"
 #include "clang/Basic/AddressSpaces.h"
 #include "clang/Basic/IdentifierTable.h"
 #include "clang/Basic/LangOptions.h"
@@ -230,6 +231,16 @@ class ASTContext : public RefCountedBase<ASTContext> {
   llvm::DenseMap<const MaterializeTemporaryExpr *, APValue *>
     MaterializedTemporaryValues;
 
+  /// \brief Mapping from constexpr function calls, encoded by the constant
+  /// evaluator as the callee and the values of the arguments, to their
+  /// results.
+  llvm::StringMap<APValue *> ConstexprCallResults;
+
+  /// \brief The number of times the constant evaluator looked for, and found,
+  /// the result of a constexpr function call in ConstexprCallResults.
+  unsigned NumConstexprCallLookups = 0;
+  unsigned NumConstexprCallHits = 0;
+
   /// \brief Representation of a "canonical" template template parameter that
   /// is used in canonical template names.
   class CanonicalTemplateTemplateParm : public llvm::FoldingSetNode {
@@ -524,21 +535,8 @@ public:
   /// \brief Contains parents of a node.
   typedef llvm::SmallVector<ast_type_traits::DynTypedNode, 2> ParentVector;
 
-  /// \brief Maps from a node to its parents. This is used for nodes that have
-  /// pointer identity only, which are more common and we can save space by
-  /// only storing a unique pointer to them.
-  typedef llvm::DenseMap<const void *,
-                         llvm::PointerUnion4<const Decl *, const Stmt *,
-                                             ast_type_traits::DynTypedNode *,
-                                             ParentVector *>> ParentMapPointers;
-
-  /// Parent map for nodes without pointer identity. We store a full
-  /// DynTypedNode for all keys.
-  typedef llvm::DenseMap<
-      ast_type_traits::DynTypedNode,
-      llvm::PointerUnion4<const Decl *, const Stmt *,
-                          ast_type_traits::DynTypedNode *, ParentVector *>>
-      ParentMapOtherNodes;
+  /// \brief The parents of the nodes of the translation unit.
+  class ParentMap;
 
   /// Container for either a single DynTypedNode or for an ArrayRef to
   /// DynTypedNode. For use with ParentMap.
@@ -624,7 +622,14 @@ public:
     return BumpAlloc;
   }
 
-  void *Allocate(size_t Size, unsigned Align = 8) const {
+  /// \brief The kinds of AST objects whose allocations in the ASTContext are
+  /// counted separately, for the memory report.
+  enum AllocationKind { AK_Decl, AK_Stmt, AK_Other, AK_NumKinds };
+
+  void *Allocate(size_t Size, unsigned Align = 8,
+                 AllocationKind Kind = AK_Other) const {
+    ++NumAllocations[Kind];
+    AllocatedBytes[Kind] += Size;
     return BumpAlloc.Allocate(Size, Align);
   }
   template <typename T> T *Allocate(size_t Num = 1) const {
@@ -632,6 +637,27 @@ public:
   }
   void Deallocate(void *Ptr) const { }
 
+  /// \brief The number of allocations and the bytes requested through
+  /// Allocate, by AllocationKind.
+  mutable uint64_t NumAllocations[AK_NumKinds] = {};
+  mutable uint64_t AllocatedBytes[AK_NumKinds] = {};
+
+  /// \brief The storage for the statements and expressions of the function
+  /// body being parsed when Sema discards the body once it is checked
+  /// (-fdiscard-function-bodies), or null.  Stmt::operator new allocates
+  /// there instead of in the ASTContext.
+  llvm::BumpPtrAllocator *FunctionBodyAlloc = nullptr;
+
+  /// \brief Set when a node allocated in FunctionBodyAlloc is made reachable
+  /// from outside the function body, which then must not be discarded.
+  mutable bool FunctionBodyEscaped = false;
+
+  /// \brief The storage that FunctionBodyAlloc points to, which is reset
+  /// when the function body is discarded, and the storage of the function
+  /// bodies that had to be kept.
+  llvm::BumpPtrAllocator FunctionBodyStorage;
+  std::vector<llvm::BumpPtrAllocator> KeptFunctionBodies;
+
   /// Return the total amount of physical memory allocated for representing
   /// AST nodes and type information.
   size_t getASTAllocatedMemory() const {
@@ -1034,6 +1060,19 @@ public:
   ASTMutationListener *getASTMutationListener() const { return Listener; }
 
   void PrintStats() const;
+
+  /// \brief Print the hit rate of the cache of constexpr call results.
+  void PrintConstexprCacheStats() const;
+
+  /// \brief Print, as a JSON object, the memory used by the AST broken down
+  /// into types, declarations and statements of each kind, Checked C bounds
+  /// expressions, template specializations, the side tables of the
+  /// ASTContext and the source manager.
+  ///
+  /// The declarations and statements are only counted if their statistics
+  /// were enabled before they were created.
+  void PrintMemoryReport(raw_ostream &OS) const;
+
   const SmallVectorImpl<Type *>& getTypes() const { return Types; }
 
   BuiltinTemplateDecl *buildBuiltinTemplateDecl(BuiltinTemplateKind BTK,
@@ -2521,11 +2560,74 @@ public:
   bool EquivalentInteropTypes(const InteropTypeExpr *Expr1,
                               const InteropTypeExpr *Expr2);
 
+private:
+  /// \brief The bounds expressions of the bounds annotations in function
+  /// types, bucketed by their Lexicographic hash, and the interop type
+  /// expressions of those annotations, keyed by their type.
+  mutable llvm::DenseMap<unsigned, SmallVector<BoundsExpr *, 1>>
+    FunctionTypeBounds;
+  mutable llvm::DenseMap<QualType, InteropTypeExpr *> FunctionTypeInteropTypes;
+
+  /// \brief The parameter types that getInteropTypeAndAdjust adjusts array
+  /// interop types to, keyed by the array types.
+  mutable llvm::DenseMap<QualType, QualType> AdjustedInteropTypes;
+
+public:
+  /// \brief Return bounds annotations equivalent to \p Annots whose bounds
+  /// expression and interop type expression are shared by all function
+  /// types with equivalent annotations.  Function types with the same
+  /// checked interface then have the same annotations, so profiling and
+  /// comparing the annotations of function types compares pointers.
+  BoundsAnnotations
+  getUniquedBoundsAnnotations(const BoundsAnnotations &Annots) const;
+
+  /// \brief The structural hashes of expressions computed by Lexicographic,
+  /// keyed by the expressions with value-preserving operations ignored.
+  /// Expressions that are lexicographically equal without equality facts
+  /// have the same hash.
+  llvm::DenseMap<const Expr *, unsigned> LexicographicHashes;
+
+  /// \brief The types computed by Sema::RewriteBoundsSafeInterfaceTypes,
+  /// keyed by the types they were rewritten from.  The rewritten type only
+  /// depends on the original type, so each type is rewritten once.
+  llvm::DenseMap<QualType, QualType> BoundsSafeInterfaceTypes;
+
+  /// \brief The number of expression comparisons done by Lexicographic,
+  /// including the comparisons of subexpressions.  Reported by
+  /// -fcheckedc-time-report.
+  uint64_t LexicographicComparisons = 0;
+
   BoundsExpr *getPrebuiltByteCountOne();
   BoundsExpr *getPrebuiltCountZero();
   BoundsExpr *getPrebuiltCountOne();
   BoundsExpr *getPrebuiltBoundsUnknown();
 
+private:
+  /// \brief The bounds inferred for the bounds checks of UnaryOperator,
+  /// ArraySubscriptExpr and MemberExpr nodes.  Few of these nodes need a
+  /// bounds check, so the bounds are kept here instead of in every node.
+  /// Bounds read from an AST file are loaded when first asked for.
+  llvm::DenseMap<const Expr *, LazyDeclStmtPtr> ExprBounds;
+
+public:
+  /// \brief Return the bounds attached to \p E by setExprBounds, or null.
+  /// Use the getBoundsExpr method of the expression instead.
+  BoundsExpr *getExprBounds(const Expr *E) const;
+
+  /// \brief Attach the bounds \p B to \p E, or remove them if \p B is
+  /// null.  Use the setBoundsExpr method of the expression instead.
+  void setExprBounds(const Expr *E, BoundsExpr *B);
+
+  /// \brief Remove the bounds attached to the expressions allocated in
+  /// \p Alloc, before it is reset.
+  void forgetExprBounds(llvm::BumpPtrAllocator &Alloc);
+
+  /// \brief Attach to \p E the bounds at \p Offset in the external AST
+  /// source, which are deserialized when getExprBounds first asks for them.
+  void setLazyExprBounds(const Expr *E, uint64_t Offset) {
+    ExprBounds[E] = LazyDeclStmtPtr(Offset);
+  }
+
   // Track the set of member bounds declarations that use a given
   // member path.   For each member bounds declaration, we store the
   // field with the declaration, not the member bound itself.
@@ -2736,6 +2838,10 @@ public:
   APValue *getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
                                          bool MayCreate);
 
+  /// \brief Get the storage for the result of the constexpr function call
+  /// identified by \p Key, as encoded by the constant evaluator.
+  APValue *getConstexprCallResult(StringRef Key, bool MayCreate);
+
   //===--------------------------------------------------------------------===//
   //                    Statistics
   //===--------------------------------------------------------------------===//
@@ -2863,10 +2969,8 @@ private:
   friend class DeclarationNameTable;
 
   void ReleaseDeclContextMaps();
-  void ReleaseParentMapEntries();
 
-  std::unique_ptr<ParentMapPointers> PointerParents;
-  std::unique_ptr<ParentMapOtherNodes> OtherParents;
+  std::unique_ptr<ParentMap> Parents;
 
   std::unique_ptr<VTableContextBase> VTContext;
 
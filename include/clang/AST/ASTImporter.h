@@ -84,6 +84,11 @@ namespace clang {
     /// \brief Declaration (from, to) pairs that are known not to be equivalent
     /// (which we have already complained about).
     NonEquivalentDeclSet NonEquivalentDecls;
+
+    /// \brief Declaration (from, to) pairs that are known to be equivalent,
+    /// so that they are not compared again when they are looked up by later
+    /// imports.
+    NonEquivalentDeclSet EquivalentDecls;
     
   public:
     /// \brief Create a new AST importer.
@@ -286,6 +291,9 @@ namespace clang {
     /// \brief Return the set of declarations that we know are not equivalent.
     NonEquivalentDeclSet &getNonEquivalentDecls() { return NonEquivalentDecls; }
 
+    /// \brief Return the set of declarations that we know are equivalent.
+    NonEquivalentDeclSet &getEquivalentDecls() { return EquivalentDecls; }
+
     /// \brief Called for ObjCInterfaceDecl, ObjCProtocolDecl, and TagDecl.
     /// Mark the Decl as complete, filling it in as much as possible.
     ///
@@ -0,0 +1,98 @@
+//===--- ASTNodeIndex.h - Declarations and statements by kind ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  Provides an index of the declarations and statements of a translation
+//  unit by kind, which tools can iterate over instead of traversing the AST.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_AST_ASTNODEINDEX_H
+#define LLVM_CLANG_AST_ASTNODEINDEX_H
+
+#include "clang/AST/DeclBase.h"
+#include "clang/AST/Stmt.h"
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include <vector>
+
+namespace clang {
+
+class ASTContext;
+
+/// \brief The declarations and statements of a translation unit, grouped by
+/// kind.
+///
+/// Building the index traverses the translation unit once, with the rules of
+/// RecursiveASTVisitor. A tool which only looks at the nodes of a few kinds,
+/// or which runs several analyses over the same translation unit, can then
+/// iterate over these nodes instead of traversing the whole AST each time.
+/// The nodes of a given kind are in the order of the traversal.
+class ASTNodeIndex {
+public:
+  /// \brief Indexes the nodes of the translation unit of \p Context,
+  /// including the template instantiations and the implicit code if
+  /// requested.
+  explicit ASTNodeIndex(ASTContext &Context,
+                        bool IncludeTemplateInstantiations = false,
+                        bool IncludeImplicitCode = false);
+
+  /// \brief Returns the declarations of kind \p K.
+  ArrayRef<Decl *> getDecls(Decl::Kind K) const { return Decls[K]; }
+
+  /// \brief Returns the statements and expressions of class \p SC.
+  ArrayRef<Stmt *> getStmts(Stmt::StmtClass SC) const { return Stmts[SC]; }
+
+  /// \brief Returns the declarations of class \p T, including the ones of
+  /// the classes derived from it, grouped by kind.
+  template <typename T> std::vector<T *> getDeclsOf() const {
+    std::vector<T *> Result;
+    for (unsigned K = 0, E = Decls.size(); K != E; ++K)
+      if (!Decls[K].empty() && isa<T>(Decls[K].front()))
+        for (Decl *D : Decls[K])
+          Result.push_back(cast<T>(D));
+    return Result;
+  }
+
+  /// \brief Returns the statements of class \p T, including the ones of the
+  /// classes derived from it, grouped by class.
+  template <typename T> std::vector<T *> getStmtsOf() const {
+    std::vector<T *> Result;
+    for (unsigned SC = 0, E = Stmts.size(); SC != E; ++SC)
+      if (!Stmts[SC].empty() && isa<T>(Stmts[SC].front()))
+        for (Stmt *S : Stmts[SC])
+          Result.push_back(cast<T>(S));
+    return Result;
+  }
+
+  /// \brief Returns the number of kinds of declarations, which are the
+  /// values of Decl::Kind.
+  unsigned getNumDeclKinds() const { return Decls.size(); }
+
+  /// \brief Returns the number of classes of statements, which are the
+  /// values of Stmt::StmtClass.
+  unsigned getNumStmtClasses() const { return Stmts.size(); }
+
+  /// \brief Returns the number of declarations in the index.
+  unsigned getNumDecls() const { return NumDecls; }
+
+  /// \brief Returns the number of statements and expressions in the index.
+  unsigned getNumStmts() const { return NumStmts; }
+
+private:
+  friend class ASTNodeIndexBuilder;
+
+  std::vector<std::vector<Decl *>> Decls;
+  std::vector<std::vector<Stmt *>> Stmts;
+  unsigned NumDecls = 0;
+  unsigned NumStmts = 0;
+};
+
+} // end namespace clang
+
+#endif
@@ -46,6 +46,11 @@ struct StructuralEquivalenceContext {
   /// (which we have already complained about).
   llvm::DenseSet<std::pair<Decl *, Decl *>> &NonEquivalentDecls;
 
+  /// Canonical declaration (from, to) pairs that are known to be equivalent,
+  /// with the same settings as this context, or null.  The pairs found to be
+  /// equivalent are added to it, so that they are not checked again.
+  llvm::DenseSet<std::pair<Decl *, Decl *>> *EquivalentDecls = nullptr;
+
   /// Whether we're being strict about the spelling of types when
   /// unifying two types.
   bool StrictTypeSpelling;
@@ -93,6 +98,10 @@ struct StructuralEquivalenceContext {
   findUntaggedStructOrUnionIndex(RecordDecl *Anon);
 
 private:
+  /// Record the tentative equivalences, which have all been verified, in
+  /// EquivalentDecls.
+  void recordEquivalences();
+
   /// Finish checking all of the structural equivalences.
   ///
   /// \returns true if an error occurred, false otherwise.
@@ -24,6 +24,8 @@
 #include "clang/Basic/Sanitizers.h"
 #include "clang/Basic/SourceLocation.h"
 #include "clang/Basic/VersionTuple.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
@@ -35,8 +37,7 @@ namespace clang {
   class Expr;
   class VarDecl;
 
-  // List of sets of equivalent expressions.
-  typedef SmallVector<SmallVector<Expr *, 4> *, 4> EquivExprSets;
+  class EquivExprSets;
 
   class Lexicographic {
   public:
@@ -102,6 +103,7 @@ namespace clang {
     Result CompareImpl(const AtomicExpr *E1, const AtomicExpr *E2);
     Result CompareImpl(const BlockExpr *E1, const BlockExpr *E2);
 
+    unsigned HashDecl(const NamedDecl *D) const;
 
   public:
     Lexicographic(ASTContext &Ctx, EquivExprSets *EquivExprs);
@@ -110,12 +112,73 @@ namespace clang {
     /// bounds expressions.
     Result CompareExpr(const Expr *E1, const Expr *E2);
 
+    /// \brief Return true if E1 and E2 are lexicographically equal.  When
+    /// there are no equality facts, expressions with different structural
+    /// hashes are known to differ without walking them.
+    bool EqualExprs(const Expr *E1, const Expr *E2);
+
+    /// \brief A hash of the structure of E that is the same for expressions
+    /// that CompareExpr considers equal without equality facts.  It is
+    /// computed once per expression and cached in the ASTContext, so E must
+    /// not be modified afterwards.
+    unsigned HashExpr(const Expr *E);
+
     /// \brief Compare declarations that may be used by expressions or
     /// or types.
     Result CompareDecl(const NamedDecl *D1, const NamedDecl *D2) const;
     Result CompareType(QualType T1, QualType T2) const;
     Result CompareTypeIgnoreCheckedness(QualType QT1, QualType QT2) const;
   };
+
+  /// \brief Sets of expressions that are known to have the same value,
+  /// such as the target and source of an assignment.
+  ///
+  /// Expressions are identified up to lexicographic equality without facts,
+  /// and the facts are closed under transitivity.  The sets are kept in a
+  /// union-find structure, so recording a fact and testing whether two
+  /// expressions are in the same set take amortized near-constant time
+  /// beyond computing the structural hash of each expression once.
+  class EquivExprSets {
+  public:
+    EquivExprSets(ASTContext &Ctx) : Context(Ctx) {}
+
+    /// \brief Record that E1 and E2 have the same value.  E1 and E2 must
+    /// not be modified afterwards.
+    void addEquality(Expr *E1, Expr *E2);
+
+    /// \brief Return true if the recorded facts imply that E1 and E2 have
+    /// the same value.  Expressions that do not occur in any fact are only
+    /// equivalent to themselves and are reported as not equivalent.
+    bool areEquivalent(const Expr *E1, const Expr *E2);
+
+    /// \brief Return true if no facts have been recorded.
+    bool empty() const { return Exprs.empty(); }
+
+    /// \brief A hash of the sets, which does not depend on the order in
+    /// which the facts were recorded.  Sets for which hasSameSets is true
+    /// have the same hash.
+    unsigned getHash();
+
+    /// \brief Return true if Other divides the same expressions into the
+    /// same sets, so that both imply exactly the same equalities.
+    bool hasSameSets(EquivExprSets &Other);
+
+  private:
+    /// \brief Return the index of the expression recorded for E, or -1 if
+    /// there is none.
+    int lookup(const Expr *E);
+    unsigned getOrAdd(Expr *E);
+    unsigned findRoot(unsigned Index);
+
+    ASTContext &Context;
+    /// \brief The distinct expressions that occur in facts.  The index of an
+    /// expression in this list is its element in Parents and Ranks.
+    SmallVector<Expr *, 8> Exprs;
+    /// \brief The indices in Exprs of the expressions with a given hash.
+    llvm::DenseMap<unsigned, SmallVector<unsigned, 1>> ExprsByHash;
+    SmallVector<unsigned, 8> Parents;
+    SmallVector<unsigned, 8> Ranks;
+  };
 }  // end namespace clang
 
 #endif
@@ -297,6 +297,10 @@ public:
   /// than \p OldD (for instance, if this declaration is newly-created).
   bool declarationReplaces(NamedDecl *OldD, bool IsKnownNewer = true) const;
 
+  /// \brief Determine whether declarationReplaces can only return \c true
+  /// for declarations with the same canonical declaration as this one.
+  bool replacesOnlyRedeclarations() const;
+
   /// \brief Determine whether this declaration has linkage.
   bool hasLinkage() const;
 
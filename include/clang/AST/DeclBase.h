@@ -969,6 +969,10 @@ public:
   static void EnableStatistics();
   static void PrintStats();
 
+  /// \brief Print, as a JSON object, the number of declarations of each kind
+  /// created since statistics were enabled, and the bytes they use.
+  static void PrintMemoryReport(raw_ostream &OS);
+
   /// isTemplateParameter - Determines whether this declaration is a
   /// template parameter.
   bool isTemplateParameter() const;
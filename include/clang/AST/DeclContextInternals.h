@@ -22,6 +22,7 @@
 #include "llvm/ADT/PointerUnion.h"
 #include "llvm/ADT/SmallVector.h"
 #include <algorithm>
+#include <memory>
 
 namespace clang {
 
@@ -32,7 +33,19 @@ class DependentDiagnostic;
 struct StoredDeclsList {
 
   /// \brief When in vector form, this is what the Data pointer points to.
-  typedef SmallVector<NamedDecl *, 4> DeclsTy;
+  struct DeclsTy : SmallVector<NamedDecl *, 4> {
+    /// \brief Once the vector is large, the number of its declarations with
+    /// each canonical declaration, used to rule out redeclarations without
+    /// walking the vector. Only present while none of the declarations come
+    /// from an AST file, whose canonical declarations change when they are
+    /// merged.
+    std::unique_ptr<llvm::DenseMap<const Decl *, unsigned>> CanonicalDecls;
+  };
+
+  /// \brief The number of declarations from which HandleRedeclaration indexes
+  /// the vector by canonical declaration, so that adding to a large overload
+  /// set does not take time linear in its size.
+  enum { MinDeclsForCanonicalIndex = 16 };
 
   /// \brief A collection of declarations, with a flag to indicate if we have
   /// further external declarations.
@@ -83,8 +96,10 @@ public:
   }
 
   void setHasExternalDecls() {
-    if (DeclsTy *Vec = getAsVector())
+    if (DeclsTy *Vec = getAsVector()) {
+      Vec->CanonicalDecls.reset();
       Data = DeclsAndHasExternalTy(Vec, true);
+    }
     else {
       DeclsTy *VT = new DeclsTy();
       if (NamedDecl *OldD = getAsDecl())
@@ -115,6 +130,7 @@ public:
     DeclsTy::iterator I = std::find(Vec.begin(), Vec.end(), D);
     assert(I != Vec.end() && "list does not contain decl");
     Vec.erase(I);
+    unindexDecl(Vec, D);
 
     assert(std::find(Vec.begin(), Vec.end(), D)
              == Vec.end() && "list still contains decl");
@@ -170,13 +186,26 @@ public:
       return true;
     }
 
-    // Determine if this declaration is actually a redeclaration.
     DeclsTy &Vec = *getAsVector();
+
+    // A redeclaration of an entity can only replace a declaration of the same
+    // entity; if there is none, there is nothing to replace.
+    if (!D->isFromASTFile() && D->replacesOnlyRedeclarations()) {
+      if (!Vec.CanonicalDecls && Vec.size() >= MinDeclsForCanonicalIndex)
+        buildCanonicalIndex(Vec);
+      if (Vec.CanonicalDecls &&
+          !Vec.CanonicalDecls->count(D->getCanonicalDecl()))
+        return false;
+    }
+
+    // Determine if this declaration is actually a redeclaration.
     for (DeclsTy::iterator OD = Vec.begin(), ODEnd = Vec.end();
          OD != ODEnd; ++OD) {
       NamedDecl *OldD = *OD;
       if (D->declarationReplaces(OldD, IsKnownNewer)) {
+        unindexDecl(Vec, OldD);
         *OD = D;
+        indexDecl(Vec, D);
         return true;
       }
     }
@@ -233,6 +262,37 @@ public:
       Vec.push_back(TagD);
     } else
       Vec.push_back(D);
+
+    indexDecl(Vec, D);
+  }
+
+private:
+  /// \brief Index the declarations of \p Vec by canonical declaration, if
+  /// none of them comes from an AST file.
+  static void buildCanonicalIndex(DeclsTy &Vec) {
+    if (std::any_of(Vec.begin(), Vec.end(),
+                    [](NamedDecl *D) { return D->isFromASTFile(); }))
+      return;
+    Vec.CanonicalDecls.reset(new llvm::DenseMap<const Decl *, unsigned>());
+    for (NamedDecl *D : Vec)
+      ++(*Vec.CanonicalDecls)[D->getCanonicalDecl()];
+  }
+
+  static void indexDecl(DeclsTy &Vec, NamedDecl *D) {
+    if (!Vec.CanonicalDecls)
+      return;
+    if (D->isFromASTFile())
+      Vec.CanonicalDecls.reset();
+    else
+      ++(*Vec.CanonicalDecls)[D->getCanonicalDecl()];
+  }
+
+  static void unindexDecl(DeclsTy &Vec, NamedDecl *D) {
+    if (!Vec.CanonicalDecls)
+      return;
+    auto I = Vec.CanonicalDecls->find(D->getCanonicalDecl());
+    if (I != Vec.CanonicalDecls->end() && --I->second == 0)
+      Vec.CanonicalDecls->erase(I);
   }
 };
 
@@ -1753,7 +1753,7 @@ public:
 };
 
 enum BoundsCheckKind {
-  BCK_None,
+  BCK_None,                 // proved in bounds statically, so not checked at runtime.
   BCK_NullTermRead,
   BCK_NullTermWriteAssign,  // assignment through a pointer to a null-terminated array.
   BCK_Normal,
@@ -1780,8 +1780,6 @@ private:
   SourceLocation Loc;
   Stmt *Val;
 
-  // Compiler-inferred bounds used for inserting a bounds check.
-  BoundsExpr *Bounds;
 public:
 
   UnaryOperator(Expr *input, Opcode opc, QualType type,
@@ -1792,11 +1790,17 @@ public:
            (input->isInstantiationDependent() ||
             type->isInstantiationDependentType()),
            input->containsUnexpandedParameterPack()),
-      Opc(opc), Loc(l), Val(input), Bounds(nullptr) {}
+      Opc(opc), Loc(l), Val(input) {
+    UnaryOperatorBits.BoundsCheckKind = BCK_Normal;
+    UnaryOperatorBits.HasBounds = false;
+  }
 
   /// \brief Build an empty unary operator.
   explicit UnaryOperator(EmptyShell Empty)
-    : Expr(UnaryOperatorClass, Empty), Opc(UO_AddrOf), Bounds(nullptr) { }
+    : Expr(UnaryOperatorClass, Empty), Opc(UO_AddrOf) {
+    UnaryOperatorBits.BoundsCheckKind = BCK_Normal;
+    UnaryOperatorBits.HasBounds = false;
+  }
 
   Opcode getOpcode() const { return static_cast<Opcode>(Opc); }
   void setOpcode(Opcode O) { Opc = O; }
@@ -1881,18 +1885,19 @@ public:
   /// \brief Return true if this expression is an lvalue-producing
   /// expression that should include a bounds check of the lvalue
   /// that it produces at runtime.
-  bool hasBoundsExpr() const { return Bounds != nullptr; }
-
-  /// \brief The bounds to use during the bounds check of this expression.
-  const BoundsExpr *getBoundsExpr() const {
-    return const_cast<BoundsExpr*>(Bounds);
-  }
+  bool hasBoundsExpr() const { return UnaryOperatorBits.HasBounds; }
 
   /// \brief The bounds to use during the bounds check of this expression.
-  BoundsExpr *getBoundsExpr() { return Bounds; }
+  /// The bounds are kept in \p C, so that the many unary operators without
+  /// a bounds check do not pay for them.
+  BoundsExpr *getBoundsExpr(const ASTContext &C) const;
 
   /// \brief Set the bounds to use during the bounds check of this expression.
-  void setBoundsExpr(BoundsExpr *E) { Bounds = E; }
+  void setBoundsExpr(ASTContext &C, BoundsExpr *E);
+
+  /// \brief Set the bounds to the ones at \p Offset in the AST file that
+  /// \p C reads, to be loaded when first asked for.
+  void setLazyBoundsExpr(ASTContext &C, uint64_t Offset);
 
   static_assert(BCK_MaxKind < (1 << NumBoundsCheckKindBits), "kind field too small");
 
@@ -2214,8 +2219,6 @@ class ArraySubscriptExpr : public Expr {
   Stmt* SubExprs[END_EXPR];
   SourceLocation RBracketLoc;
 
-  // Compiler-inferred bounds used for inserting a bounds check.
-  BoundsExpr *Bounds;
 public:
   ArraySubscriptExpr(Expr *lhs, Expr *rhs, QualType t,
                      ExprValueKind VK, ExprObjectKind OK,
@@ -2227,14 +2230,19 @@ public:
           rhs->isInstantiationDependent()),
          (lhs->containsUnexpandedParameterPack() ||
           rhs->containsUnexpandedParameterPack())),
-    RBracketLoc(rbracketloc), Bounds(nullptr) {
+    RBracketLoc(rbracketloc) {
     SubExprs[LHS] = lhs;
     SubExprs[RHS] = rhs;
+    ArraySubscriptExprBits.BoundsCheckKind = BCK_Normal;
+    ArraySubscriptExprBits.HasBounds = false;
   }
 
   /// \brief Create an empty array subscript expression.
   explicit ArraySubscriptExpr(EmptyShell Shell)
-    : Expr(ArraySubscriptExprClass, Shell), Bounds(nullptr) { }
+    : Expr(ArraySubscriptExprClass, Shell) {
+    ArraySubscriptExprBits.BoundsCheckKind = BCK_Normal;
+    ArraySubscriptExprBits.HasBounds = false;
+  }
 
   /// An array access can be written A[4] or 4[A] (both are equivalent).
   /// - getBase() and getIdx() always present the normalized view: A[4].
@@ -2298,18 +2306,18 @@ public:
 
   /// \brief Return true if this expression include a runtime bounds check of
   /// the lvalue that it produces.
-  bool hasBoundsExpr() const { return Bounds != nullptr; }
+  bool hasBoundsExpr() const { return ArraySubscriptExprBits.HasBounds; }
 
-  /// \brief The bounds to use during the bounds check of this expression.
-  const BoundsExpr *getBoundsExpr() const {
-    return const_cast<BoundsExpr*>(Bounds);
-  }
-
-  /// \brief The bounds to use during the bounds check of this expression.
-  BoundsExpr *getBoundsExpr() { return Bounds; }
+  /// \brief The bounds to use during the bounds check of this expression,
+  /// which are kept in \p C.
+  BoundsExpr *getBoundsExpr(const ASTContext &C) const;
 
   /// \brief Set the bounds to use during the bounds check of this expression.
-  void setBoundsExpr(BoundsExpr *E) { Bounds = E; }
+  void setBoundsExpr(ASTContext &C, BoundsExpr *E);
+
+  /// \brief Set the bounds to the ones at \p Offset in the AST file that
+  /// \p C reads, to be loaded when first asked for.
+  void setLazyBoundsExpr(ASTContext &C, uint64_t Offset);
 
   /// \brief Return the kind of bounds check to do.
   BoundsCheckKind getBoundsCheckKind() const {
@@ -2549,6 +2557,14 @@ class MemberExpr final
   /// was resolved from an overloaded set having size greater than 1.
   bool HadMultipleCandidates : 1;
 
+  /// \brief True if the ASTContext holds compiler-inferred bounds to be used
+  /// to bounds check the base expression X of X->F.
+  bool HasBounds : 1;
+
+  /// \brief True if the bounds checker proved that the base expression X of
+  /// X->F is within its bounds, so that it needs no runtime bounds check.
+  bool BoundsCheckProven : 1;
+
   size_t numTrailingObjects(OverloadToken<MemberExprNameQualifier>) const {
     return HasQualifierOrFoundDecl ? 1 : 0;
   }
@@ -2557,10 +2573,6 @@ class MemberExpr final
     return HasTemplateKWAndArgsInfo ? 1 : 0;
   }
 
-  /// Compiler-inferred bounds expression to be used to bounds check the base
-  /// expression X of X->F, if a bounds check is needed.
-  BoundsExpr *Bounds;
-
 public:
   MemberExpr(Expr *base, bool isarrow, SourceLocation operatorloc,
              ValueDecl *memberdecl, const DeclarationNameInfo &NameInfo,
@@ -2572,7 +2584,7 @@ public:
         MemberLoc(NameInfo.getLoc()), OperatorLoc(operatorloc),
         IsArrow(isarrow), HasQualifierOrFoundDecl(false),
         HasTemplateKWAndArgsInfo(false), HadMultipleCandidates(false),
-        Bounds(nullptr) {
+        HasBounds(false), BoundsCheckProven(false) {
     assert(memberdecl->getDeclName() == NameInfo.getName());
   }
 
@@ -2589,7 +2601,8 @@ public:
         Base(base), MemberDecl(memberdecl), MemberDNLoc(), MemberLoc(l),
         OperatorLoc(operatorloc), IsArrow(isarrow),
         HasQualifierOrFoundDecl(false), HasTemplateKWAndArgsInfo(false),
-        HadMultipleCandidates(false), Bounds(nullptr) {}
+        HadMultipleCandidates(false), HasBounds(false),
+        BoundsCheckProven(false) {}
 
   static MemberExpr *Create(const ASTContext &C, Expr *base, bool isarrow,
                             SourceLocation OperatorLoc,
@@ -2762,19 +2775,25 @@ public:
 
   /// \brief Return true if the base expression lvalue should be
   /// bounds checked
-  bool hasBoundsExpr() const { return Bounds != nullptr; }
+  bool hasBoundsExpr() const { return HasBounds; }
 
-  /// \brief The bounds to use for bounds checking the base expression lvalue.
-  const BoundsExpr *getBoundsExpr() const {
-    return const_cast<BoundsExpr*>(Bounds);
-  }
-
-  /// \brief The bounds to use for bounds checking the base expression lvalue.
-  BoundsExpr *getBoundsExpr() { return Bounds; }
+  /// \brief The bounds to use for bounds checking the base expression lvalue,
+  /// which are kept in \p C.
+  BoundsExpr *getBoundsExpr(const ASTContext &C) const;
 
   /// \brief Set the bounds to use for bounds checking the base expression
   /// lvalue.
-  void setBoundsExpr(BoundsExpr *E) { Bounds = E; }
+  void setBoundsExpr(ASTContext &C, BoundsExpr *E);
+
+  /// \brief Set the bounds to the ones at \p Offset in the AST file that
+  /// \p C reads, to be loaded when first asked for.
+  void setLazyBoundsExpr(ASTContext &C, uint64_t Offset);
+
+  /// \brief Return true if the bounds checker proved that the base
+  /// expression lvalue is within its bounds.
+  bool isBoundsCheckProven() const { return BoundsCheckProven; }
+
+  void setBoundsCheckProven(bool Proven) { BoundsCheckProven = Proven; }
 };
 
 /// CompoundLiteralExpr - [C99 6.5.2.5]
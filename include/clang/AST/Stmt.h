@@ -25,6 +25,7 @@
 #include "llvm/ADT/iterator.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/TrailingObjects.h"
 #include <string>
 
 namespace llvm {
@@ -292,6 +293,8 @@ protected:
 
     unsigned : NumExprBits;
     unsigned BoundsCheckKind : NumBoundsCheckKindBits;
+    /// True if the ASTContext holds inferred bounds for this expression.
+    unsigned HasBounds : 1;
   };
 
   class UnaryOperatorBitFields {
@@ -299,6 +302,8 @@ protected:
 
     unsigned : NumExprBits;
     unsigned BoundsCheckKind : NumBoundsCheckKindBits;
+    /// True if the ASTContext holds inferred bounds for this expression.
+    unsigned HasBounds : 1;
   };
 
   union {
@@ -419,6 +424,11 @@ public:
   static void EnableStatistics();
   static void PrintStats();
 
+  /// \brief Print, as a JSON object, the number of statements and expressions
+  /// of each class created since statistics were enabled, and the bytes they
+  /// use.
+  static void PrintMemoryReport(raw_ostream &OS);
+
   /// \brief Dumps the specified AST fragment and all subtrees to
   /// \c llvm::errs().
   void dump() const;
@@ -426,6 +436,10 @@ public:
   void dump(raw_ostream &OS, SourceManager &SM) const;
   void dump(raw_ostream &OS) const;
 
+  /// \brief Dumps the AST fragment to \p OS like dump(OS), including the
+  /// Checked C bounds that \p Context holds for its expressions.
+  void dump(raw_ostream &OS, const ASTContext &Context) const;
+
   /// dumpColor - same as dump(), but forces color highlighting.
   void dumpColor() const;
 
@@ -478,6 +492,14 @@ public:
   const_child_iterator child_begin() const { return children().begin(); }
   const_child_iterator child_end() const { return children().end(); }
 
+  typedef llvm::iterator_range<StmtPreorderIterator> preorder_range;
+
+  /// \brief Returns this statement and all of its descendants, in preorder,
+  /// without recursion.
+  preorder_range preorder() {
+    return preorder_range(StmtPreorderIterator(this), StmtPreorderIterator());
+  }
+
   /// \brief Produce a unique representation of the given statement.
   ///
   /// \param ID once the profiling operation is complete, will contain
@@ -616,34 +638,42 @@ public:
 
 /// CompoundStmt - This represents a group of statements like { stmt stmt }.
 ///
-class CompoundStmt : public Stmt {
-  Stmt** Body;
+/// The statements of the body are stored after the CompoundStmt itself, and
+/// the brace locations fill the tail padding of Stmt.
+class CompoundStmt final : public Stmt,
+                           private llvm::TrailingObjects<CompoundStmt, Stmt *> {
   SourceLocation LBraceLoc, RBraceLoc;
 
   friend class ASTStmtReader;
+  friend TrailingObjects;
 
-public:
-  CompoundStmt(const ASTContext &C, ArrayRef<Stmt*> Stmts,
-               SourceLocation LB, SourceLocation RB,
+  CompoundStmt(ArrayRef<Stmt*> Stmts, SourceLocation LB, SourceLocation RB,
                bool IsChecked, bool CheckedPropertyDeclared);
 
-  // \brief Build an empty compound statement with a location.
-  explicit CompoundStmt(SourceLocation Loc)
-    : Stmt(CompoundStmtClass), Body(nullptr), LBraceLoc(Loc), RBraceLoc(Loc) {
-    CompoundStmtBits.NumStmts = 0;
+  explicit CompoundStmt(EmptyShell Empty, unsigned NumStmts)
+    : Stmt(CompoundStmtClass, Empty) {
+    CompoundStmtBits.NumStmts = NumStmts;
     CompoundStmtBits.IsCheckedScope = false;
     CompoundStmtBits.CheckedPropertyDeclared = false;
+    std::fill_n(getTrailingObjects<Stmt *>(), NumStmts, nullptr);
   }
 
-  // \brief Build an empty compound statement.
-  explicit CompoundStmt(EmptyShell Empty)
-    : Stmt(CompoundStmtClass, Empty), Body(nullptr) {
+public:
+  static CompoundStmt *Create(const ASTContext &C, ArrayRef<Stmt*> Stmts,
+                              SourceLocation LB, SourceLocation RB,
+                              bool IsChecked, bool CheckedPropertyDeclared);
+
+  // \brief Build an empty compound statement with a location.
+  explicit CompoundStmt(SourceLocation Loc)
+    : Stmt(CompoundStmtClass), LBraceLoc(Loc), RBraceLoc(Loc) {
     CompoundStmtBits.NumStmts = 0;
     CompoundStmtBits.IsCheckedScope = false;
     CompoundStmtBits.CheckedPropertyDeclared = false;
   }
 
-  void setStmts(const ASTContext &C, ArrayRef<Stmt *> Stmts);
+  // \brief Build an empty compound statement with room for \p NumStmts
+  // statements.
+  static CompoundStmt *CreateEmpty(const ASTContext &C, unsigned NumStmts);
 
   bool body_empty() const { return CompoundStmtBits.NumStmts == 0; }
   unsigned size() const { return CompoundStmtBits.NumStmts; }
@@ -665,14 +695,14 @@ public:
   typedef llvm::iterator_range<body_iterator> body_range;
 
   body_range body() { return body_range(body_begin(), body_end()); }
-  body_iterator body_begin() { return Body; }
-  body_iterator body_end() { return Body + size(); }
-  Stmt *body_front() { return !body_empty() ? Body[0] : nullptr; }
-  Stmt *body_back() { return !body_empty() ? Body[size()-1] : nullptr; }
+  body_iterator body_begin() { return getTrailingObjects<Stmt *>(); }
+  body_iterator body_end() { return body_begin() + size(); }
+  Stmt *body_front() { return !body_empty() ? body_begin()[0] : nullptr; }
+  Stmt *body_back() { return !body_empty() ? body_end()[-1] : nullptr; }
 
   void setLastStmt(Stmt *S) {
     assert(!body_empty() && "setLastStmt");
-    Body[size()-1] = S;
+    body_end()[-1] = S;
   }
 
   typedef Stmt* const * const_body_iterator;
@@ -681,13 +711,15 @@ public:
   body_const_range body() const {
     return body_const_range(body_begin(), body_end());
   }
-  const_body_iterator body_begin() const { return Body; }
-  const_body_iterator body_end() const { return Body + size(); }
+  const_body_iterator body_begin() const {
+    return getTrailingObjects<Stmt *>();
+  }
+  const_body_iterator body_end() const { return body_begin() + size(); }
   const Stmt *body_front() const {
-    return !body_empty() ? Body[0] : nullptr;
+    return !body_empty() ? body_begin()[0] : nullptr;
   }
   const Stmt *body_back() const {
-    return !body_empty() ? Body[size() - 1] : nullptr;
+    return !body_empty() ? body_end()[-1] : nullptr;
   }
 
   typedef std::reverse_iterator<body_iterator> reverse_body_iterator;
@@ -720,13 +752,11 @@ public:
   }
 
   // Iterators
-  child_range children() {
-    return child_range(Body, Body + CompoundStmtBits.NumStmts);
-  }
+  child_range children() { return child_range(body_begin(), body_end()); }
 
   const_child_range children() const {
-    return const_child_range(child_iterator(Body),
-                             child_iterator(Body + CompoundStmtBits.NumStmts));
+    return const_child_range(child_iterator(body_begin()),
+                             child_iterator(body_end()));
   }
 };
 
@@ -7,13 +7,15 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines the StmtIterator and ConstStmtIterator classes.
+// This file defines the StmtIterator, ConstStmtIterator and
+// StmtPreorderIterator classes.
 //
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_CLANG_AST_STMTITERATOR_H
 #define LLVM_CLANG_AST_STMTITERATOR_H
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/DataTypes.h"
 #include <cassert>
@@ -155,6 +157,55 @@ struct ConstStmtIterator : public StmtIteratorImpl<ConstStmtIterator,
 inline StmtIterator cast_away_const(const ConstStmtIterator &RHS) {
   return RHS;
 }
+
+/// \brief Iterates over a statement and all of its descendants in preorder.
+///
+/// The statements still to visit are kept on an explicit stack instead of
+/// the call stack, so that deep trees, such as long chains of binary
+/// operators, are walked in constant stack space. Null children are skipped.
+class StmtPreorderIterator
+    : public std::iterator<std::forward_iterator_tag, Stmt *, ptrdiff_t,
+                           Stmt *, Stmt *> {
+  llvm::SmallVector<Stmt *, 16> Stack;
+
+public:
+  /// \brief Builds the end iterator.
+  StmtPreorderIterator() {}
+
+  /// \brief Builds an iterator over \p S and its descendants.
+  explicit StmtPreorderIterator(Stmt *S) {
+    if (S)
+      Stack.push_back(S);
+  }
+
+  Stmt *operator*() const {
+    assert(!Stack.empty() && "dereferencing the end iterator");
+    return Stack.back();
+  }
+
+  StmtPreorderIterator &operator++();
+
+  StmtPreorderIterator operator++(int) {
+    StmtPreorderIterator Tmp = *this;
+    operator++();
+    return Tmp;
+  }
+
+  /// \brief Moves to the statement following the current one and all of its
+  /// descendants.
+  void skipChildren() {
+    assert(!Stack.empty() && "skipping past the end iterator");
+    Stack.pop_back();
+  }
+
+  bool operator==(const StmtPreorderIterator &RHS) const {
+    return Stack == RHS.Stack;
+  }
+
+  bool operator!=(const StmtPreorderIterator &RHS) const {
+    return Stack != RHS.Stack;
+  }
+};
 } // end namespace clang
 
 #endif
@@ -0,0 +1,118 @@
+//===-- SymbolicBounds.h - linear arithmetic over bounds exprs --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the interface for comparing bounds expressions whose
+//  bounds differ by linear expressions over variables, such as
+//  bounds(p, p + n) and bounds(p, p + n - 1).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SYMBOLIC_BOUNDS_H
+#define LLVM_CLANG_SYMBOLIC_BOUNDS_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include <cstdint>
+#include <utility>
+
+namespace clang {
+  class ASTContext;
+  class BoundsExpr;
+  class EquivExprSets;
+  class Expr;
+
+  /// \brief A linear combination c0 + c1 * t1 + ... + cn * tn, where the
+  /// terms ti are integer expressions that are not analyzed further, such
+  /// as variables.  Terms are compared with Lexicographic, so equal terms
+  /// are merged and their coefficients added.
+  struct LinearExpr {
+    int64_t Constant = 0;
+    SmallVector<std::pair<const Expr *, int64_t>, 4> Terms;
+
+    /// \brief Whether this is a constant, when all the terms cancel.
+    bool isConstant() const { return Terms.empty(); }
+  };
+
+  /// \brief A range Base + Lower ... Base + Upper, where Lower and Upper are
+  /// byte offsets from a pointer Base.
+  struct SymbolicRange {
+    const Expr *Base = nullptr;
+    LinearExpr Lower;
+    LinearExpr Upper;
+  };
+
+  /// \brief Prove that one range is within another by subtracting their
+  /// bounds as linear expressions.  A comparison holds if the difference
+  /// is a constant of the right sign.  Integer arithmetic is only treated
+  /// as linear in signed types, where overflow is undefined, so the proofs
+  /// are sound for all values of the terms.  Unsigned arithmetic and
+  /// conversions that may change values are opaque terms.
+  ///
+  /// Each prover has a budget of steps, shared by everything it does.
+  /// Once the budget is used up, every request fails, so the time spent
+  /// per proof is bounded.
+  class SymbolicBoundsProver {
+  public:
+    enum class Result {
+      True,
+      False,
+      Maybe
+    };
+
+    /// \brief EquivExprs, if non-null, holds sets of expressions known to
+    /// be equal, which are used when comparing bases and terms.
+    SymbolicBoundsProver(ASTContext &Ctx, EquivExprSets *EquivExprs,
+                         unsigned Budget = DefaultBudget);
+
+    /// \brief The default budget of steps for one prover.
+    static const unsigned DefaultBudget = 256;
+
+    /// \brief Convert a range bounds expression to a symbolic range.
+    /// Returns false if it cannot be converted.
+    bool createRange(const BoundsExpr *Bounds, SymbolicRange &R);
+
+    /// \brief Create the range of memory accessed by reading or writing
+    /// *(PtrBase + Offset), where Offset may be null.  Returns false if the
+    /// access cannot be converted.
+    bool createAccessRange(const Expr *PtrBase, const Expr *Offset,
+                           SymbolicRange &R);
+
+    /// \brief Determine whether Inner is within Outer.  When the result is
+    /// False, LowerFails and UpperFails are set to which bounds of Inner are
+    /// definitely outside of Outer.
+    Result inRange(const SymbolicRange &Outer, const SymbolicRange &Inner,
+                   bool &LowerFails, bool &UpperFails);
+
+    /// \brief Determine whether the width of Narrow is at most the width of
+    /// Wide.  The bases of the ranges don't matter.
+    Result notWider(const SymbolicRange &Narrow, const SymbolicRange &Wide);
+
+    /// \brief Determine whether R is empty.
+    Result isEmpty(const SymbolicRange &R);
+
+    /// \brief Add Bytes to the upper bound of R.  Returns false on
+    /// overflow.
+    bool addToUpper(SymbolicRange &R, int64_t Bytes);
+
+  private:
+    ASTContext &Context;
+    EquivExprSets *EquivExprs;
+    unsigned Budget;
+
+    bool step();
+    bool equal(const Expr *E1, const Expr *E2);
+    bool addTerm(LinearExpr &L, const Expr *Term, int64_t Coef);
+    bool add(LinearExpr &L, const LinearExpr &R, int64_t Scale);
+    bool linearize(const Expr *E, int64_t Scale, LinearExpr &L);
+    bool splitPointer(const Expr *E, const Expr *&Base, LinearExpr &Offset);
+    Result compare(const LinearExpr &A, const LinearExpr &B);
+  };
+} // end namespace clang
+
+#endif
@@ -1340,7 +1340,8 @@ public:
     return Bounds == nullptr && InteropType == nullptr;
   }
 
-  /// \brief Always write data for individual elements.
+  /// \brief Profile the bounds and interop type expressions by pointer,
+  /// which is exact for the uniqued annotations of function types.
   void Profile(llvm::FoldingSetNodeID &ID, const ASTContext &Ctx) const;
 };
 
@@ -1590,6 +1591,21 @@ protected:
     VectorTypeBitfields VectorTypeBits;
   };
 
+  /// Bitfields caching the Checked C pointer kind of the canonical type, so
+  /// that the checked pointer predicates do not need to desugar the type.
+  /// They are not in the union above, which has no bits left for them.
+  class CheckedPointerBitfields {
+    friend class Type;
+    friend class PointerType;
+
+    /// Whether the canonical type is a PointerType.
+    unsigned IsPointer : 1;
+
+    /// The CheckedPointerKind of the canonical type, if it is a PointerType.
+    unsigned Kind : 2;
+  };
+  CheckedPointerBitfields CheckedPointerBits;
+
 private:
   /// \brief Set whether this type comes from an AST file.
   void setFromAST(bool V = true) const {
@@ -1615,6 +1631,13 @@ protected:
     TypeBits.CachedLocalOrUnnamed = false;
     TypeBits.CachedLinkage = NoLinkage;
     TypeBits.FromAST = false;
+    // A canonical PointerType sets these in its constructor.
+    if (canon.isNull()) {
+      CheckedPointerBits.IsPointer = false;
+      CheckedPointerBits.Kind = (unsigned)CheckedPointerKind::Unchecked;
+    } else {
+      CheckedPointerBits = canon.getTypePtr()->CheckedPointerBits;
+    }
   }
   friend class ASTContext;
 
@@ -2336,6 +2359,10 @@ class PointerType : public Type, public llvm::FoldingSetNode {
          Pointee->containsUnexpandedParameterPack()),
     PointeeType(Pointee) {
       PointerTypeBits.CheckedPointerKind = (unsigned)ptrKind;
+      if (CanonicalPtr.isNull()) {
+        CheckedPointerBits.IsPointer = true;
+        CheckedPointerBits.Kind = (unsigned)ptrKind;
+      }
   }
   friend class ASTContext;  // ASTContext creates these.
 
@@ -5985,35 +6012,29 @@ inline bool Type::isPointerType() const {
   return isa<PointerType>(CanonicalType);
 }
 inline bool Type::isCheckedPointerType() const {
-  if (const PointerType *T = getAs<PointerType>())
-    return T->isChecked();
-  return false;
+  return CheckedPointerBits.IsPointer &&
+         CheckedPointerBits.Kind != (unsigned)CheckedPointerKind::Unchecked;
 }
 inline bool Type::isUncheckedPointerType() const {
-  if (const PointerType *T = getAs<PointerType>())
-    return T->isUnchecked();
-  return false;
+  return CheckedPointerBits.IsPointer &&
+         CheckedPointerBits.Kind == (unsigned)CheckedPointerKind::Unchecked;
 }
 inline bool Type::isCheckedPointerPtrType() const {
-  if (const PointerType *T = getAs<PointerType>())
-    return T->getKind() == CheckedPointerKind::Ptr;
-  return false;
+  return CheckedPointerBits.IsPointer &&
+         CheckedPointerBits.Kind == (unsigned)CheckedPointerKind::Ptr;
 }
 inline bool Type::isCheckedPointerArrayType() const {
-  if (const PointerType *T = getAs<PointerType>())
-    return T->getKind() == CheckedPointerKind::Array ||
-           T->getKind() == CheckedPointerKind::NtArray;
-  return false;
+  return CheckedPointerBits.IsPointer &&
+         (CheckedPointerBits.Kind == (unsigned)CheckedPointerKind::Array ||
+          CheckedPointerBits.Kind == (unsigned)CheckedPointerKind::NtArray);
 }
 inline bool Type::isExactlyCheckedPointerArrayType() const {
-  if (const PointerType *T = getAs<PointerType>())
-    return T->getKind() == CheckedPointerKind::Array;
-  return false;
+  return CheckedPointerBits.IsPointer &&
+         CheckedPointerBits.Kind == (unsigned)CheckedPointerKind::Array;
 }
 inline bool Type::isCheckedPointerNtArrayType() const {
-  if (const PointerType *T = getAs<PointerType>())
-    return T->getKind() == CheckedPointerKind::NtArray;
-  return false;
+  return CheckedPointerBits.IsPointer &&
+         CheckedPointerBits.Kind == (unsigned)CheckedPointerKind::NtArray;
 }
 inline bool Type::isAnyPointerType() const {
   return isPointerType() || isObjCObjectPointerType();
@@ -122,17 +122,38 @@ public:
 
   struct MatchFinderOptions {
     struct Profiling {
-      Profiling(llvm::StringMap<llvm::TimeRecord> &Records)
-          : Records(Records) {}
+      /// \brief How often the matchers of a bucket were tried, and how often
+      /// they matched.
+      struct MatchCounts {
+        uint64_t Attempts = 0;
+        uint64_t Matches = 0;
+      };
+
+      Profiling(llvm::StringMap<llvm::TimeRecord> &Records,
+                llvm::StringMap<MatchCounts> *Counts = nullptr)
+          : Records(Records), Counts(Counts) {}
 
       /// \brief Per bucket timing information.
       llvm::StringMap<llvm::TimeRecord> &Records;
+
+      /// \brief Per bucket match counts, if not null.
+      llvm::StringMap<MatchCounts> *Counts;
     };
 
     /// \brief Enables per-check timers.
     ///
     /// It prints a report after match.
     llvm::Optional<Profiling> CheckProfiling;
+
+    /// \brief Matches the declarations and statements of each kind in turn,
+    /// from an index of the nodes by kind, rather than during a traversal of
+    /// the AST which tries the matchers on every node.
+    ///
+    /// The nodes of the kinds that no matcher can match are skipped as a
+    /// whole. Matches are then reported grouped by node kind instead of in
+    /// traversal order. This only takes effect if all the matchers are
+    /// declaration or statement matchers.
+    bool MatchByNodeKind = false;
   };
 
   MatchFinder(MatchFinderOptions Options = MatchFinderOptions());
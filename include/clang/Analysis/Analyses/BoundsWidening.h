@@ -0,0 +1,101 @@
+//=--- BoundsWidening.h - Widening of null-terminated bounds --*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  Determine for each program point in a function which variables with
+//  null-terminated array pointer types have declared bounds that can be
+//  widened by one element, because the element at their upper bound is
+//  known to be non-null.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_ANALYSIS_ANALYSES_BOUNDSWIDENING_H
+#define LLVM_CLANG_ANALYSIS_ANALYSES_BOUNDSWIDENING_H
+
+#include "clang/AST/Decl.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include <vector>
+
+namespace clang {
+
+class CFG;
+class CFGBlock;
+
+/// \brief Determine for each program point in a function which variables of
+/// _Nt_array_ptr type have a non-null element at the upper bound of their
+/// declared bounds.  The bounds of such a variable can be widened by one
+/// element: the element after the upper bound is still within the
+/// null-terminated array.
+///
+/// The fact for a variable is established on the branch of a condition that
+/// tests the element at its upper bound, as in while (*p) or if (s[i]), and
+/// it ends at an assignment to a variable that the upper bound uses.  Only
+/// local variables whose upper bound uses local variables whose addresses are
+/// never taken are tracked.  Writes through pointers do not end the fact:
+/// they cannot make the array shorter.
+///
+/// The facts at the entry of each CFG block are computed by a forward
+/// worklist solver.  The facts at a statement inside a block are recomputed
+/// from the block entry on demand, continuing from the previous query when
+/// the queries move forward through a block.
+class BoundsWidening {
+public:
+  /// \brief Analyze Cfg, which must have been built with every expression
+  /// added to its blocks (CFG::BuildOptions::setAllAlwaysAdd).
+  BoundsWidening(ASTContext &Ctx, const CFG &Cfg);
+
+  /// \brief Return true if the element at the upper bound of the declared
+  /// bounds of V is known to be non-null immediately before S is evaluated.
+  bool isWidenedBefore(const Stmt *S, const VarDecl *V);
+
+  void dump(raw_ostream &OS) const;
+
+private:
+  typedef std::pair<unsigned, unsigned> Position;
+
+  /// \brief The upper bound of the declared bounds of a tracked variable,
+  /// as a base pointer and an integer offset, which may be null.
+  struct UpperBound {
+    const Expr *Base;
+    const Expr *Offset;
+  };
+
+  void collectVariables();
+  void addCandidate(const VarDecl *V);
+  void solve();
+  void transfer(llvm::BitVector &Facts, const Stmt *S) const;
+  void kill(llvm::BitVector &Facts, const Expr *Target) const;
+  void applyCondition(llvm::BitVector &Facts, const CFGBlock *Block,
+                      bool TrueBranch);
+  int getTestedVar(const Expr *Cond);
+  bool isSameValue(const Expr *E1, const Expr *E2);
+  bool moveCursorTo(Position Pos);
+
+  ASTContext &Context;
+  const CFG &Cfg;
+  /// \brief The tracked variables, their upper bounds, and the tracked
+  /// variables whose facts end when a variable is assigned.
+  std::vector<const VarDecl *> Vars;
+  std::vector<UpperBound> UpperBounds;
+  llvm::DenseMap<const VarDecl *, unsigned> VarIndices;
+  llvm::DenseMap<const VarDecl *, SmallVector<unsigned, 2>> Dependents;
+  /// \brief The block and index of the CFG element for a statement.
+  llvm::DenseMap<const Stmt *, Position> StmtPositions;
+  /// \brief The facts at the entry of each block, indexed by block ID.
+  /// Unreachable blocks have no facts.
+  std::vector<llvm::BitVector> BlockEntryFacts;
+  std::vector<bool> Reachable;
+  std::vector<const CFGBlock *> BlocksByID;
+  /// \brief The facts before the element at CursorPos.
+  llvm::BitVector Cursor;
+  Position CursorPos;
+  bool CursorValid;
+};
+}
+#endif
@@ -20,6 +20,7 @@
 #define LLVM_CLANG_ANALYSIS_ANALYSES_FORMATSTRING_H
 
 #include "clang/AST/CanonicalType.h"
+#include <vector>
 
 namespace clang {
 
@@ -691,6 +692,69 @@ bool ParseScanfString(FormatStringHandler &H,
                       const char *beg, const char *end, const LangOptions &LO,
                       const TargetInfo &Target);
 
+/// The callbacks that parsing a format string makes to its handler, recorded
+/// so that they can be replayed to the handlers of other uses of the string
+/// without parsing it again.  The recorded callbacks point into the parsed
+/// string, which must outlive the recording.
+class ParsedFormatString {
+public:
+  /// Parse the printf format string [beg, end) and record its callbacks.
+  static ParsedFormatString parsePrintf(const char *beg, const char *end,
+                                        const LangOptions &LO,
+                                        const TargetInfo &Target,
+                                        bool isFreeBSDKPrintf);
+
+  /// Parse the scanf format string [beg, end) and record its callbacks.
+  static ParsedFormatString parseScanf(const char *beg, const char *end,
+                                       const LangOptions &LO,
+                                       const TargetInfo &Target);
+
+  /// Make the recorded callbacks to \p H, stopping where parsing the string
+  /// with \p H would.  Returns what ParsePrintfString or ParseScanfString
+  /// would have: true if the processing was stopped early.
+  bool replay(FormatStringHandler &H) const;
+
+private:
+  class Recorder;
+
+  enum CallbackKind {
+    NullChar,
+    Position,
+    InvalidPosition,
+    ZeroPosition,
+    IncompleteSpecifier,
+    EmptyObjCModifierFlag,
+    InvalidObjCModifierFlag,
+    ObjCFlagsWithNonObjCConversion,
+    InvalidPrintfConversionSpecifier,
+    PrintfSpecifier,
+    InvalidScanfConversionSpecifier,
+    ScanfSpecifier,
+    IncompleteScanList
+  };
+
+  /// The arguments of a callback.  Start, End and Pos are the pointers it is
+  /// given in order, and Specifier is the index of its specifier in
+  /// PrintfSpecifiers or ScanfSpecifiers.
+  struct Callback {
+    CallbackKind Kind;
+    const char *Start = nullptr;
+    const char *End = nullptr;
+    const char *Pos = nullptr;
+    unsigned Len = 0;
+    PositionContext Context = FieldWidthPos;
+    unsigned Specifier = 0;
+
+    Callback(CallbackKind Kind) : Kind(Kind) {}
+  };
+
+  std::vector<Callback> Callbacks;
+  std::vector<analyze_printf::PrintfSpecifier> PrintfSpecifiers;
+  std::vector<analyze_scanf::ScanfSpecifier> ScanfSpecifiers;
+  /// What parsing the string returned.
+  bool Stopped = false;
+};
+
 } // end analyze_format_string namespace
 } // end clang namespace
 #endif
@@ -18,6 +18,9 @@
 
 #include "clang/AST/Decl.h"
 #include "clang/AST/CanonBounds.h"
+#include "llvm/ADT/DenseMap.h"
+#include <memory>
+#include <vector>
 
 namespace clang {
 
@@ -27,12 +30,8 @@ class SourceManager;
 
 namespace PartitionRefinement {
   typedef int Element;
-  class ElementMap;
-  struct ListNode;
-  class Set;
-  class SetManager;
 
-  // Represent a partitioning of a set of integers into
+  // Represent a partitioning of a set of non-negative integers into
   // equivalence classes.  Provide operations for refining
   // the partition (dividing existing classes into smaller
   // classes).
@@ -58,19 +57,149 @@ namespace PartitionRefinement {
     /// contains an element of R, divide it into two equivalence classes:
     /// intersection(C, R) and C - R.
     void refine(const Partition *R);
+    /// \brief Make this partition a copy of Other.
+    void assign(const Partition &Other);
+    /// \brief Returns true if this partition has the same equivalence
+    /// classes as Other.
+    bool equals(const Partition &Other) const;
+    /// \brief Append the equivalence classes that are not singletons to
+    /// Result.
+    void getClasses(SmallVectorImpl<SmallVector<Element, 4>> &Result) const;
+    /// \brief Make every element a member of a singleton equivalence
+    /// class.
+    void clear();
     void dump(raw_ostream &OS, Element Elem) const;
     void dump(raw_ostream &OS) const;
 
   private:
-    ListNode *add(Set *S, Element Elem);
-    void remove_if_trivial(Set *S);
-    void refine(const Set *S);
-    void dump(raw_ostream &OS, Set *S) const;
-
-    ElementMap *NodeMap;
-    SetManager *Sets;
-    std::vector<Set *> Scratch;
+    Partition(const Partition &) = delete;
+    Partition &operator=(const Partition &) = delete;
+
+    /// \brief An equivalence class that is not a singleton.  Its members
+    /// are in Members[Start, End), and the slots up to Capacity are
+    /// reserved for members added to it.
+    struct Class {
+      unsigned Start;
+      unsigned End;
+      unsigned Capacity;
+      /// The position of the class in LiveClasses.
+      unsigned LivePos;
+      /// The split marker: the number of members at the front of the
+      /// class that are in the set that the partition is being refined by.
+      unsigned Marked;
+      /// Whether the class is kept by the refinement in progress.
+      bool Kept;
+    };
+
+    int getClass(Element Elem) const;
+    unsigned createClass();
+    void removeClass(unsigned C);
+    void swapSlots(unsigned A, unsigned B);
+    void reserve(unsigned C, unsigned Size);
+    void compact();
+    void append(unsigned C, Element Elem);
+    void split(unsigned C);
+    void dumpClass(raw_ostream &OS, unsigned C) const;
+
+    /// \brief The members of the classes, each class in a contiguous range
+    /// of slots, and the class of each slot.
+    std::vector<Element> Members;
+    std::vector<unsigned> SlotClasses;
+    /// \brief The slot of each element that is not a singleton.
+    llvm::DenseMap<Element, unsigned> Slots;
+    /// \brief The classes, indexed by class number.  The numbers of
+    /// removed classes are in FreeClasses, for reuse.
+    std::vector<Class> Classes;
+    std::vector<unsigned> LiveClasses;
+    std::vector<unsigned> FreeClasses;
+    /// \brief The number of elements that are not singletons.
+    unsigned NumMembers;
+    /// \brief The number of slots reserved by classes, which is at least
+    /// half of the size of the array unless a class needs to be moved.
+    unsigned NumSlots;
+    /// \brief The classes split by a set of the refining partition.
+    std::vector<unsigned> Touched;
   };
 }
+
+/// \brief Conservatively determine for each program point in a function
+/// which variables must be equal to each other or to integer constants.
+///
+/// Only local variables of integer or pointer type whose addresses are never
+/// taken are tracked, so only assignments and declarations of a variable
+/// can change its value.  The equivalence classes at the entry of each CFG
+/// block are computed once by a forward worklist solver that revisits a
+/// block only when the facts flowing into it change.  The facts at a
+/// statement inside a block are recomputed from the block entry on demand,
+/// continuing from the previous query when the queries move forward through
+/// a block.
+class VarEquiv {
+public:
+  /// \brief An equivalence class at a program point: variables that have
+  /// the same value, and the integer constant that they equal, if any.
+  struct EquivClass {
+    SmallVector<const VarDecl *, 4> Vars;
+    bool HasConstant = false;
+    int64_t Constant = 0;
+  };
+
+  /// \brief Analyze Cfg, which must have been built with every expression
+  /// added to its blocks (CFG::BuildOptions::setAllAlwaysAdd).
+  VarEquiv(ASTContext &Ctx, const CFG &Cfg);
+  ~VarEquiv();
+
+  /// \brief Append to Classes the equivalence classes with more than one
+  /// member that hold immediately before S is evaluated.  The facts are
+  /// only meaningful for subexpressions of S if S does not modify
+  /// variables.  Returns false if S is not in a reachable block of the
+  /// CFG.
+  bool getEquivClassesBefore(const Stmt *S,
+                             SmallVectorImpl<EquivClass> &Classes);
+
+  /// \brief The same, for the point just before the declaration of D takes
+  /// effect, which is after its initializer has been evaluated.
+  bool getEquivClassesBefore(const VarDecl *D,
+                             SmallVectorImpl<EquivClass> &Classes);
+
+  void dump(raw_ostream &OS) const;
+
+private:
+  typedef PartitionRefinement::Element Element;
+  typedef PartitionRefinement::Partition Partition;
+  typedef std::pair<unsigned, unsigned> Position;
+
+  void collectVariables();
+  void solve();
+  void transfer(Partition &P, const Stmt *S);
+  Element getValueElement(const Expr *E);
+  Element getVarElement(const Expr *E) const;
+  bool moveCursorTo(Position Pos);
+  void getCursorClasses(SmallVectorImpl<EquivClass> &Classes) const;
+
+  ASTContext &Context;
+  const CFG &Cfg;
+  /// \brief Tracked variables and the constants that variables are assigned
+  /// are numbered as partition elements.  Variables come first.
+  llvm::DenseMap<const VarDecl *, Element> VarElements;
+  std::vector<const VarDecl *> Vars;
+  llvm::DenseMap<int64_t, Element> ConstantElements;
+  std::vector<int64_t> Constants;
+  /// \brief The block and index of the CFG element for a statement or a
+  /// declaration.
+  llvm::DenseMap<const Stmt *, Position> StmtPositions;
+  llvm::DenseMap<const VarDecl *, Position> DeclPositions;
+  /// \brief The facts at the entry of each block, indexed by block ID.
+  std::vector<std::unique_ptr<Partition>> BlockEntryFacts;
+  std::vector<const CFGBlock *> BlocksByID;
+  /// \brief The facts before every CheckpointInterval'th element of a
+  /// block, saved as the cursor passes them so that moving the cursor
+  /// backwards only replays a few elements.
+  static const unsigned CheckpointInterval = 16;
+  std::vector<std::vector<std::unique_ptr<Partition>>> Checkpoints;
+  /// \brief The facts before the element at CursorPos.
+  Partition Cursor;
+  Position CursorPos;
+  bool CursorValid;
+};
 }
 #endif
@@ -171,6 +171,12 @@ class FileManager : public RefCountedBase<FileManager> {
   /// or a directory) as virtual directories.
   void addAncestorsAsVirtualDirs(StringRef Path);
 
+  /// Return the result of an earlier lookup of the file \p Filename under
+  /// the name by which its directory \p Dir was first found, if that name
+  /// differs from the one in \p Filename, or null if there was none.
+  FileEntry *lookupInCanonicalDirectory(StringRef Filename,
+                                        const DirectoryEntry *Dir);
+
 public:
   FileManager(const FileSystemOptions &FileSystemOpts,
               IntrusiveRefCntPtr<vfs::FileSystem> FS = nullptr);
@@ -25,6 +25,15 @@ public:
   /// \brief If set, paths are resolved as if the working directory was
   /// set to the value of WorkingDir.
   std::string WorkingDir;
+
+  /// \brief If set, the file in which the results of stat calls are shared
+  /// with other compilations.
+  std::string StatCachePath;
+
+  /// \brief If nonzero, the size in bytes from which source files are memory
+  /// mapped rather than read into the heap.  Smaller files are always read.
+  /// Otherwise, the memory buffer library decides.
+  unsigned MmapThreshold = 0;
 };
 
 } // end namespace clang
@@ -19,6 +19,7 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/Basic/TokenKinds.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Allocator.h"
@@ -470,9 +471,45 @@ class IdentifierTable {
 
   IdentifierInfoLookup* ExternalLookup;
 
+  /// \brief If non-null, the identifiers are recorded here when they are
+  /// created.
+  SmallVectorImpl<IdentifierInfo *> *CreatedIdentifiers = nullptr;
+
+public:
+  /// \brief The language options that decide which identifiers are keywords,
+  /// as masks of the keyword flags of TokenKinds.def.
+  struct KeywordOptions {
+    explicit KeywordOptions(const LangOptions &LangOpts);
+
+    /// The flags that make a keyword enabled, tested first.
+    unsigned Enabled = 0;
+    /// The flags that make a keyword an extension, tested next.
+    unsigned Extension = 0;
+    /// The flags that make a keyword enabled, tested after Extension.
+    unsigned LateEnabled = 0;
+    /// The flags that make a keyword a keyword of a future standard.
+    unsigned Future = 0;
+    /// The flags that keep a keyword from being added at all.
+    unsigned Excluded = 0;
+
+    bool CXXOperatorNames = false;
+    bool ObjC1 = false;
+    bool ObjC2 = false;
+    bool ParseUnknownAnytype = false;
+    bool DeclSpecKeyword = false;
+  };
+
+private:
+  /// \brief The options the keywords of this table are classified with.
+  KeywordOptions KeywordOpts;
+
 public:
-  /// \brief Create the identifier table, populating it with info about the
-  /// language keywords for the language specified by \p LangOpts.
+  /// \brief Create the identifier table for the language specified by
+  /// \p LangOpts.
+  ///
+  /// The keywords of the language are not added up front: each identifier
+  /// gets its keyword info when it is created, from a perfect hash of the
+  /// keywords computed at compile time.
   IdentifierTable(const LangOptions &LangOpts,
                   IdentifierInfoLookup* externalLookup = nullptr);
 
@@ -485,6 +522,15 @@ public:
   IdentifierInfoLookup *getExternalIdentifierLookup() const {
     return ExternalLookup;
   }
+
+  /// \brief Record the identifiers created from now on in \p Created, or
+  /// stop recording them if it is null.
+  ///
+  /// This lets clients that index the table keep their index up to date
+  /// without walking the whole table again.
+  void setCreatedIdentifiersLog(SmallVectorImpl<IdentifierInfo *> *Created) {
+    CreatedIdentifiers = Created;
+  }
   
   llvm::BumpPtrAllocator& getAllocator() {
     return HashTable.getAllocator();
@@ -512,7 +558,10 @@ public:
     // Make sure getName() knows how to find the IdentifierInfo
     // contents.
     II->Entry = &Entry;
+    addKeywordInfo(*II);
 
+    if (CreatedIdentifiers)
+      CreatedIdentifiers->push_back(II);
     return *II;
   }
 
@@ -543,11 +592,10 @@ public:
     // Make sure getName() knows how to find the IdentifierInfo
     // contents.
     II->Entry = &Entry;
+    addKeywordInfo(*II);
 
-    // If this is the 'import' contextual keyword, mark it as such.
-    if (Name.equals("import"))
-      II->setModulesImport(true);
-
+    if (CreatedIdentifiers)
+      CreatedIdentifiers->push_back(II);
     return *II;
   }
 
@@ -562,7 +610,15 @@ public:
   /// hashing is doing.
   void PrintStats() const;
 
-  void AddKeywords(const LangOptions &LangOpts);
+  /// \brief Set the keyword info of the newly created identifier \p II, if
+  /// it is a keyword of the language of the table: its token kind, whether
+  /// it is an extension or a keyword of a future standard, and whether it is
+  /// a C++ operator keyword, an Objective-C \@keyword or the 'import'
+  /// contextual keyword.
+  ///
+  /// This is done by get() and getOwn(), and must be done by external
+  /// sources that create identifiers which do not go through the table.
+  void addKeywordInfo(IdentifierInfo &II) const;
 };
 
 /// \brief A family of Objective-C methods. 
@@ -149,6 +149,10 @@ public:
   /// host code generation.
   std::string OMPHostIRFile;
 
+  /// \brief The file to which the per-function times of Checked C bounds
+  /// checking are written as JSON, if any (-fcheckedc-time-report-json=).
+  std::string CheckedCTimeReportFile;
+
   /// \brief Indicates whether the front-end is explicitly told that the
   /// input is a header file (i.e. -x c-header).
   bool IsHeaderFile;
@@ -247,6 +251,17 @@ enum TranslationUnitKind {
   /// \brief The translation unit is a module.
   TU_Module
 };
+
+/// \brief Describes the files whose function bodies are skipped when the
+/// parser skips function bodies.
+enum SkipFunctionBodiesScope {
+  /// \brief Skip the function bodies in all files.
+  SFBS_All,
+  /// \brief Skip the function bodies in the files other than the main file.
+  SFBS_Headers,
+  /// \brief Skip the function bodies in system headers.
+  SFBS_SystemHeaders
+};
   
 }  // end namespace clang
 
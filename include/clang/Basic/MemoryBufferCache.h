@@ -12,6 +12,9 @@
 
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Mutex.h"
+#include <cstdint>
+#include <ctime>
 #include <memory>
 
 namespace llvm {
@@ -20,6 +23,80 @@ class MemoryBuffer;
 
 namespace clang {
 
+/// Share the memory buffers of module files across the compiler instances of
+/// a process.
+///
+/// A long-running process that compiles many translation units, such as a
+/// tool built on \a ClangTool, would otherwise read the same module files
+/// again for each of them.  Buffers are keyed by file name, and are only
+/// handed out for the file size and modification time they were read with.
+/// Each \a MemoryBufferCache that uses a buffer holds a reference to it; the
+/// buffers that are not referenced are evicted, least recently used first,
+/// once the cache grows beyond its maximum size.
+///
+/// The buffers only hold the bytes of the files: each reader still checks
+/// that the module file is compatible with its own configuration.
+///
+/// This class is thread-safe.
+class SharedMemoryBufferCache
+    : public llvm::ThreadSafeRefCountedBase<SharedMemoryBufferCache> {
+  struct BufferEntry {
+    std::shared_ptr<llvm::MemoryBuffer> Buffer;
+    uint64_t Size;
+    time_t ModTime;
+
+    /// When the buffer was last handed out, to evict the least recently used
+    /// buffers first.
+    unsigned LastUse;
+  };
+
+  llvm::sys::SmartMutex<true> Mutex;
+
+  /// Cache of buffers.
+  llvm::StringMap<BufferEntry> Buffers;
+
+  /// The total size of the buffers in the cache.
+  uint64_t TotalSize = 0;
+
+  /// The size the cache is trimmed down to.
+  uint64_t MaxSize;
+
+  /// Monotonically increasing use counter.
+  unsigned NextUse = 0;
+
+  /// Evict unused buffers until the cache fits in \c MaxSize.
+  void trim();
+
+public:
+  explicit SharedMemoryBufferCache(uint64_t MaxSize) : MaxSize(MaxSize) {}
+
+  /// The cache shared by all the compiler instances of this process that opt
+  /// in with -fmodules-share-buffers.
+  static SharedMemoryBufferCache &getProcessCache();
+
+  /// Get the buffer for \p Filename if it was read with the given size and
+  /// modification time; else nullptr.
+  std::shared_ptr<llvm::MemoryBuffer> lookupBuffer(llvm::StringRef Filename,
+                                                   uint64_t Size,
+                                                   time_t ModTime);
+
+  /// Store the Buffer read from \p Filename with the given size and
+  /// modification time, replacing any buffer for an older version of the
+  /// file.
+  void addBuffer(llvm::StringRef Filename, uint64_t Size, time_t ModTime,
+                 std::shared_ptr<llvm::MemoryBuffer> Buffer);
+
+  /// Drop the buffer for \p Filename, if any, since the file is about to be
+  /// replaced.  Users of the buffer keep their reference.
+  void removeBuffer(llvm::StringRef Filename);
+
+  /// The total size of the buffers in the cache.
+  uint64_t getTotalSize();
+
+  /// Set the size the cache is trimmed down to, evicting buffers as needed.
+  void setMaxSize(uint64_t NewMaxSize);
+};
+
 /// Manage memory buffers across multiple users.
 ///
 /// Ensures that multiple users have a consistent view of each buffer.  This is
@@ -31,7 +108,7 @@ namespace clang {
 /// been accessed can be purged, preventing use-after-frees.
 class MemoryBufferCache : public llvm::RefCountedBase<MemoryBufferCache> {
   struct BufferEntry {
-    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    std::shared_ptr<llvm::MemoryBuffer> Buffer;
 
     /// Track the timeline of when this was added to the cache.
     unsigned Index;
@@ -46,6 +123,10 @@ class MemoryBufferCache : public llvm::RefCountedBase<MemoryBufferCache> {
   /// Bumped to prevent "older" buffers from being removed.
   unsigned FirstRemovableIndex = 0;
 
+  /// The cache that buffers are shared through with other compiler
+  /// instances, if any.
+  llvm::IntrusiveRefCntPtr<SharedMemoryBufferCache> SharedCache;
+
 public:
   /// Store the Buffer under the Filename.
   ///
@@ -54,6 +135,25 @@ public:
   llvm::MemoryBuffer &addBuffer(llvm::StringRef Filename,
                                 std::unique_ptr<llvm::MemoryBuffer> Buffer);
 
+  /// Share the buffers, read from disk, of this cache through \p Cache.
+  void setSharedCache(llvm::IntrusiveRefCntPtr<SharedMemoryBufferCache> Cache) {
+    SharedCache = std::move(Cache);
+  }
+
+  bool hasSharedCache() const { return SharedCache != nullptr; }
+
+  /// Look for the buffer of \p Filename, with the given size and modification
+  /// time, in the shared cache, and add it to this cache if it is found.
+  ///
+  /// \pre There is not already a buffer for \p Filename in the cache.
+  /// \return the buffer if it was found; else nullptr.
+  llvm::MemoryBuffer *addSharedBuffer(llvm::StringRef Filename, uint64_t Size,
+                                      time_t ModTime);
+
+  /// Publish the buffer of \p Filename, which was read from disk with the
+  /// given size and modification time, to the shared cache, if any.
+  void shareBuffer(llvm::StringRef Filename, uint64_t Size, time_t ModTime);
+
   /// Try to remove a buffer from the cache.
   ///
   /// \return false on success, iff \c !isBufferFinal().
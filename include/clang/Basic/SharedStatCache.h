@@ -0,0 +1,94 @@
+//===--- SharedStatCache.h - Stat cache shared across processes -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the SharedStatCache interface.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_SHAREDSTATCACHE_H
+#define LLVM_CLANG_BASIC_SHAREDSTATCACHE_H
+
+#include "clang/Basic/FileSystemStatCache.h"
+#include "llvm/ADT/Optional.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+class MemoryBuffer;
+template <typename Info> class OnDiskIterableChainedHashTable;
+}
+
+namespace clang {
+
+/// \brief A stat cache that is shared by the compilations on a host through
+/// a memory mapped file.
+///
+/// Only results that are cheap to revalidate are shared: paths that do not
+/// exist, and directories.  Each is valid for as long as the modification
+/// time of its parent directory is unchanged, so looking up a header in many
+/// include directories costs one stat of each directory instead of one stat
+/// per candidate path.  Files are not shared: they are opened right after
+/// they are found, and their stat information can change without changing
+/// their directory.
+///
+/// Results in a directory that was modified in the last few seconds are not
+/// recorded, so that a change within the granularity of the file system
+/// timestamps is not missed.
+class SharedStatCache : public FileSystemStatCache {
+public:
+  /// \brief A recorded result for a path.
+  struct Entry {
+    /// \brief The modification time of the parent directory, in nanoseconds,
+    /// when the result was recorded.
+    uint64_t ParentTime;
+    /// \brief Whether the path exists, in which case it is a directory.
+    bool Exists;
+    llvm::sys::fs::UniqueID UniqueID;
+    uint64_t ModTime;
+  };
+
+  class LookupTrait;
+
+  ~SharedStatCache() override;
+
+  /// \brief Create a cache backed by the file at \p Path, with the results
+  /// recorded there by earlier compilations if the file exists and is valid.
+  static std::unique_ptr<SharedStatCache> create(StringRef Path);
+
+  /// \brief Merge the results recorded by this compilation into the file,
+  /// which is replaced atomically.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool save();
+
+  LookupResult getStat(StringRef Path, FileData &Data, bool isFile,
+                       std::unique_ptr<vfs::File> *F,
+                       vfs::FileSystem &FS) override;
+
+private:
+  typedef llvm::OnDiskIterableChainedHashTable<LookupTrait> TableTy;
+
+  SharedStatCache(StringRef CachePath,
+                  std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+  /// \brief Return the modification time of the directory \p Dir, or None if
+  /// it is not a directory.  The time is computed once per compilation.
+  Optional<uint64_t> getDirectoryTime(StringRef Dir, vfs::FileSystem &FS);
+
+  std::string CachePath;
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<TableTy> Table;
+  llvm::StringMap<Optional<uint64_t>> DirectoryTimes;
+  llvm::StringMap<Entry> NewEntries;
+};
+
+} // end namespace clang
+
+#endif
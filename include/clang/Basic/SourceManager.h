@@ -128,15 +128,22 @@ namespace SrcMgr {
 
     /// \brief A bump pointer allocated array of offsets for each source line.
     ///
-    /// This is lazily computed.  This is owned by the SourceManager
-    /// BumpPointerAllocator object.
+    /// This is lazily computed, and only as far into the file as line
+    /// information has been requested, unless LineTableComplete is set.  This
+    /// is owned by the SourceManager BumpPointerAllocator object.
     unsigned *SourceLineCache;
 
-    /// \brief The number of lines in this ContentCache.
+    /// \brief The number of lines in SourceLineCache.
     ///
-    /// This is only valid if SourceLineCache is non-null.
+    /// This is only valid if SourceLineCache is non-null.  It is the number of
+    /// lines in this ContentCache if LineTableComplete is set.  Otherwise the
+    /// last line in SourceLineCache has not been scanned yet: only the offsets
+    /// before its start are known to be covered.
     unsigned NumLines;
 
+    /// \brief The number of offsets allocated for SourceLineCache.
+    unsigned LineCacheCapacity;
+
     /// \brief Indicates whether the buffer itself was provided to override
     /// the actual file contents.
     ///
@@ -153,19 +160,25 @@ namespace SrcMgr {
     /// after serialization and deserialization.
     unsigned IsTransient : 1;
 
+    /// \brief True if SourceLineCache has the offsets of all of the lines in
+    /// this content cache.
+    unsigned LineTableComplete : 1;
+
     ContentCache(const FileEntry *Ent = nullptr) : ContentCache(Ent, Ent) {}
 
     ContentCache(const FileEntry *Ent, const FileEntry *contentEnt)
       : Buffer(nullptr, false), OrigEntry(Ent), ContentsEntry(contentEnt),
-        SourceLineCache(nullptr), NumLines(0), BufferOverridden(false),
-        IsSystemFile(false), IsTransient(false) {}
+        SourceLineCache(nullptr), NumLines(0), LineCacheCapacity(0),
+        BufferOverridden(false), IsSystemFile(false), IsTransient(false),
+        LineTableComplete(false) {}
     
     /// The copy ctor does not allow copies where source object has either
     /// a non-NULL Buffer or SourceLineCache.  Ownership of allocated memory
     /// is not transferred, so this is a logical error.
     ContentCache(const ContentCache &RHS)
-      : Buffer(nullptr, false), SourceLineCache(nullptr),
-        BufferOverridden(false), IsSystemFile(false), IsTransient(false) {
+      : Buffer(nullptr, false), SourceLineCache(nullptr), LineCacheCapacity(0),
+        BufferOverridden(false), IsSystemFile(false), IsTransient(false),
+        LineTableComplete(false) {
       OrigEntry = RHS.OrigEntry;
       ContentsEntry = RHS.ContentsEntry;
 
@@ -673,6 +686,10 @@ class SourceManager : public RefCountedBase<SourceManager> {
   /// \brief The file ID for the precompiled preamble there is one.
   FileID PreambleFileID;
 
+  /// \brief The file IDs for the main source file in the lower layers of a
+  /// precompiled preamble that was built incrementally, if any.
+  SmallVector<FileID, 2> PreambleLayerFileIDs;
+
   // Statistics for -print-stats.
   mutable unsigned NumLinearScans, NumBinaryProbes;
 
@@ -711,6 +728,12 @@ class SourceManager : public RefCountedBase<SourceManager> {
   mutable llvm::DenseMap<FileID, std::unique_ptr<MacroArgsMap>>
       MacroArgsCacheMap;
 
+  /// \brief True if the data that queries compute on demand was computed for
+  /// all the FileIDs, and the lookup caches above are no longer updated.
+  ///
+  /// \see prepareForConcurrentReads
+  bool ConcurrentReads = false;
+
   /// \brief The stack of modules being built, which is used to detect
   /// cycles in the module dependency graph as modules are being built, as
   /// well as to describe why we're rebuilding a particular module.
@@ -729,6 +752,20 @@ public:
 
   void clearIDTables();
 
+  /// \brief Compute the line tables, the macro argument expansions and the
+  /// other data that queries compute on demand for all the FileIDs, and stop
+  /// updating the caches of the last lookups, so that the SourceManager can
+  /// be queried by several threads at once.
+  ///
+  /// Creating or loading a FileID afterwards makes the SourceManager
+  /// single-threaded again.
+  void prepareForConcurrentReads();
+
+  /// \brief Whether the SourceManager can be queried by several threads at
+  /// once, which is the case after \c prepareForConcurrentReads until it is
+  /// modified again.
+  bool allowsConcurrentReads() const { return ConcurrentReads; }
+
   /// Initialize this source manager suitably to replay the compilation
   /// described by \p Old. Requires that \p Old outlive \p *this.
   void initializeForReplay(const SourceManager &Old);
@@ -785,6 +822,22 @@ public:
   /// \brief Get the file ID for the precompiled preamble if there is one.
   FileID getPreambleFileID() const { return PreambleFileID; }
 
+  /// \brief Add the file ID for the main source file in a lower layer of the
+  /// precompiled preamble.
+  ///
+  /// A preamble that was extended with new directives is a chain of AST
+  /// files, each of which has its own file ID for the main source file.  The
+  /// preamble file ID is the one of the last layer.
+  void addPreambleLayerFileID(FileID Layer) {
+    PreambleLayerFileIDs.push_back(Layer);
+  }
+
+  /// \brief Get the file IDs for the main source file in the lower layers of
+  /// the precompiled preamble.
+  ArrayRef<FileID> getPreambleLayerFileIDs() const {
+    return PreambleLayerFileIDs;
+  }
+
   //===--------------------------------------------------------------------===//
   // Methods to create new FileID's and macro expansions.
   //===--------------------------------------------------------------------===//
@@ -0,0 +1,88 @@
+//===--- TimeTrace.h - Trace of where the compiler spends time --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the interface of the -ftime-trace profiler.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_BASIC_TIMETRACE_H
+#define LLVM_CLANG_BASIC_TIMETRACE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Compiler.h"
+#include <string>
+
+namespace clang {
+
+class TimeTraceProfiler;
+
+/// \brief The profiler of the current thread, or null if it does not trace.
+///
+/// Each thread has a profiler of its own, so that threads building modules
+/// never record into the profiler of the thread that started them.
+extern LLVM_THREAD_LOCAL TimeTraceProfiler *TimeTraceProfilerInstance;
+
+/// \brief Start tracing the current thread, dropping the events that take
+/// less than \p GranularityMicroseconds.
+void timeTraceProfilerInitialize(unsigned GranularityMicroseconds);
+
+/// \brief Stop tracing the current thread and discard its events.
+void timeTraceProfilerCleanup();
+
+/// \brief Whether the current thread is being traced.
+inline bool timeTraceProfilerEnabled() {
+  return TimeTraceProfilerInstance != nullptr;
+}
+
+/// \brief Write the events of the current thread to \p OS in the Chrome
+/// trace event format, which chrome://tracing and Speedscope can show.
+void timeTraceProfilerWrite(raw_ostream &OS);
+
+/// \brief Start an event named \p Name, such as "InstantiateFunction", for
+/// \p Detail, such as the name of the function.
+void timeTraceProfilerBegin(StringRef Name, StringRef Detail);
+
+/// \brief Start an event, only computing its detail if the current thread
+/// is traced.
+void timeTraceProfilerBegin(StringRef Name,
+                            llvm::function_ref<std::string()> Detail);
+
+/// \brief End the most recently started event.
+void timeTraceProfilerEnd();
+
+/// \brief Records an event for the lifetime of the scope, if the current
+/// thread is traced.
+class TimeTraceScope {
+public:
+  explicit TimeTraceScope(StringRef Name) {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerBegin(Name, StringRef());
+  }
+  TimeTraceScope(StringRef Name, StringRef Detail) {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerBegin(Name, Detail);
+  }
+  TimeTraceScope(StringRef Name, llvm::function_ref<std::string()> Detail) {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerBegin(Name, Detail);
+  }
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  TimeTraceScope &operator=(const TimeTraceScope &) = delete;
+  ~TimeTraceScope() {
+    if (TimeTraceProfilerInstance != nullptr)
+      timeTraceProfilerEnd();
+  }
+};
+
+} // end namespace clang
+
+#endif
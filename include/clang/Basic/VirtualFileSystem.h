@@ -28,6 +28,7 @@
 #include <cassert>
 #include <cstdint>
 #include <ctime>
+#include <map>
 #include <memory>
 #include <stack>
 #include <string>
@@ -346,6 +347,41 @@ public:
 /// \brief Get a globally unique ID for a virtual file or directory.
 llvm::sys::fs::UniqueID getNextVirtualUniqueID();
 
+/// \brief Returns true if \p Buffer holds a content store, as written by
+/// \p ContentStoreWriter.
+bool isContentStore(StringRef Buffer);
+
+/// \brief Gets a \p FileSystem for the files of the content store in
+/// \p Buffer, or null if it is not a valid content store.
+///
+/// The file system answers status queries from the index of the store, and
+/// the buffers of its files reference \p Buffer without copying it, so that
+/// a memory mapped store is never read.  The buffers keep \p Buffer alive.
+IntrusiveRefCntPtr<FileSystem>
+getVFSFromContentStore(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+/// \brief Writes a content store: a single file with the contents of a set of
+/// files, followed by a sorted index of their absolute paths.
+///
+/// The parent directories of the files are added to the index.  Files with
+/// the same contents share them.  Each content is followed by a null
+/// character, so that it can be used as a null-terminated buffer in place.
+class ContentStoreWriter {
+  struct FileInfo {
+    std::string Contents;
+    time_t ModificationTime;
+  };
+  std::map<std::string, FileInfo> Files;
+
+public:
+  ContentStoreWriter() = default;
+
+  /// \brief Add a file with the absolute path \p Path.
+  void addFile(StringRef Path, StringRef Contents, time_t ModificationTime);
+
+  void write(llvm::raw_ostream &OS);
+};
+
 /// \brief Gets a \p FileSystem for a virtual file system described in YAML
 /// format.
 IntrusiveRefCntPtr<FileSystem>
@@ -16,10 +16,13 @@
 #define LLVM_CLANG_CROSSTU_CROSSTRANSLATIONUNIT_H
 
 #include "clang/Basic/LLVM.h"
+#include "clang/Sema/BoundsSummary.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <list>
 
 namespace clang {
 class CompilerInstance;
@@ -75,6 +78,45 @@ parseCrossTUIndex(StringRef IndexPath, StringRef CrossTUDir);
 
 std::string createCrossTUIndexString(const llvm::StringMap<std::string> &Index);
 
+/// \brief This function creates an index file in the binary format, which
+///        maps the same USRs to the same file paths as the text format.
+///
+/// The binary format is an on-disk hash table, which is looked up in place
+/// in the memory mapped file instead of being parsed.
+std::string createCrossTUBinaryIndex(const llvm::StringMap<std::string> &Index);
+
+/// \brief Returns true if \p Buffer starts like an index in the binary format.
+bool isCrossTUBinaryIndex(StringRef Buffer);
+
+/// \brief Returns true if \p Buffer is a well-formed index in the binary
+///        format.
+bool isValidCrossTUBinaryIndex(StringRef Buffer);
+
+/// \brief This function looks up \p LookupName in an index in the binary
+///        format, which must be valid.
+///
+/// \return Returns the file path of the definition as found in the index, or
+///         an empty string if the index has none.
+StringRef lookupCrossTUBinaryIndex(StringRef Buffer, StringRef LookupName);
+
+/// \brief This function creates the Checked C bounds summary of a translation
+///        unit, for the callees of the calls in Summary.
+///
+/// The summary has the same layout as an index file: each line consists of
+/// the USR of a function, a space, the number of calls to it, and for each
+/// parameter the smallest number of elements that the calls are proved to
+/// pass for it, or -1.  The summaries of several translation units can be
+/// concatenated.
+std::string createBoundsSummaryString(const sema::BoundsSummary &Summary);
+
+/// \brief This function parses a bounds summary file.  The lines for the
+///        same function, from different translation units, are merged.
+///
+/// \return Returns a map where the USR is the key and the calls to the
+///         function are the value, or an error.
+llvm::Expected<llvm::StringMap<sema::BoundsSummary::CallBounds>>
+parseBoundsSummary(StringRef SummaryPath);
+
 /// \brief This class is used for tools that requires cross translation
 ///        unit capability.
 ///
@@ -84,7 +126,9 @@ std::string createCrossTUIndexString(const llvm::StringMap<std::string> &Index);
 /// In order to use this class, an index file is required that describes
 /// the locations of the AST files for each function definition.
 ///
-/// Note that this class also implements caching.
+/// Note that this class also implements caching. The loaded AST files are
+/// kept until the limit set by setLoadedASTMemoryLimit is exceeded, and then
+/// the least recently used ones are unloaded.
 class CrossTranslationUnitContext {
 public:
   CrossTranslationUnitContext(CompilerInstance &CI);
@@ -136,19 +180,51 @@ public:
   /// \brief Get a name to identify a function.
   static std::string getLookupName(const NamedDecl *ND);
 
+  /// \brief Limit the memory used by the loaded AST files to about \p Bytes.
+  ///        The AST file loaded last is kept even if it exceeds the limit on
+  ///        its own. A limit of 0, the default, keeps every file loaded.
+  ///
+  /// Note that an ASTUnit returned by loadExternalAST may be unloaded by the
+  /// next call to it.
+  void setLoadedASTMemoryLimit(size_t Bytes) { LoadedASTMemoryLimit = Bytes; }
+
   /// \brief Emit diagnostics for the user for potential configuration errors.
   void emitCrossTUDiagnostics(const IndexError &IE);
 
 private:
   ASTImporter &getOrCreateASTImporter(ASTContext &From);
-  const FunctionDecl *findFunctionInDeclContext(const DeclContext *DC,
-                                                StringRef LookupFnName);
-
-  llvm::StringMap<std::unique_ptr<clang::ASTUnit>> FileASTUnitMap;
-  llvm::StringMap<clang::ASTUnit *> FunctionASTUnitMap;
+  /// \brief Add the function definitions of \p DC, and of the contexts in it,
+  ///        to \p Definitions by lookup name, keeping the first of a name.
+  void
+  indexFunctionDefinitions(const DeclContext *DC,
+                           llvm::StringMap<const FunctionDecl *> &Definitions);
+
+  /// \brief Unload the least recently used AST files, other than \p Keep,
+  ///        until the loaded files fit in the memory limit.
+  void unloadASTFiles(StringRef Keep);
+
+  struct LoadedASTFile {
+    std::unique_ptr<clang::ASTUnit> Unit;
+    /// The memory allocated by the AST of the unit, when it was loaded.
+    size_t Memory;
+    /// The position of the file in LoadedASTFileOrder.
+    std::list<StringRef>::iterator OrderPos;
+  };
+  llvm::StringMap<LoadedASTFile> FileASTUnitMap;
+  /// The loaded AST files, from the most recently used one.
+  std::list<StringRef> LoadedASTFileOrder;
+  size_t LoadedASTMemory = 0;
+  size_t LoadedASTMemoryLimit = 0;
   llvm::StringMap<std::string> FunctionFileMap;
+  /// The index file, if it is in the binary format.
+  std::unique_ptr<llvm::MemoryBuffer> BinaryIndex;
   llvm::DenseMap<TranslationUnitDecl *, std::unique_ptr<ASTImporter>>
       ASTUnitImporterMap;
+  /// The function definitions of each loaded unit by lookup name, indexed on
+  /// the first lookup in the unit, so that the unit is only walked once.
+  llvm::DenseMap<TranslationUnitDecl *,
+                 llvm::StringMap<const FunctionDecl *>>
+      ASTUnitDefinitionsMap;
   CompilerInstance &CI;
   ASTContext &Context;
 };
@@ -108,6 +108,23 @@ class Compilation {
   /// Whether an error during the parsing of the input args.
   bool ContainsError;
 
+  /// PrintCommand - Print the command line of \p C with -v or
+  /// CC_PRINT_OPTIONS.
+  ///
+  /// \return Whether the command line could be printed.
+  bool PrintCommand(const Command &C) const;
+
+  /// ExecuteJobsInParallel - Execute the jobs on Driver::ParallelJobs
+  /// threads, each after the jobs which make its inputs.  The output of each
+  /// job is printed in the order of the jobs, and the jobs after the first
+  /// failing one are not reported, as if they were executed in order.
+  ///
+  /// \return False if the output of the jobs couldn't be captured, in which
+  /// case no job was executed.
+  bool ExecuteJobsInParallel(
+      const JobList &Jobs,
+      SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const;
+
 public:
   Compilation(const Driver &D, const ToolChain &DefaultToolChain,
               llvm::opt::InputArgList *Args,
@@ -201,6 +201,18 @@ public:
   /// Whether the driver is generating diagnostics for debugging purposes.
   unsigned CCGenDiagnostics : 1;
 
+  /// The entry point of the -cc1 tools, given the full command line of a
+  /// job, including the executable.
+  typedef int (*CC1ToolFunc)(ArrayRef<const char *> Argv);
+
+  /// The -cc1 tools of this executable, null if they can't be run in the
+  /// driver process.
+  CC1ToolFunc CC1Main = nullptr;
+
+  /// The number of jobs that Compilation::ExecuteJobs runs at once, given
+  /// with -fdriver-jobs=.
+  unsigned ParallelJobs = 1;
+
 private:
   /// Default target triple.
   std::string DefaultTargetTriple;
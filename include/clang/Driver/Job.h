@@ -127,6 +127,22 @@ public:
 
   /// Print a command argument, and optionally quote it.
   static void printArg(llvm::raw_ostream &OS, StringRef Arg, bool Quote);
+
+  /// Whether the command is run in the driver process rather than in a
+  /// process of its own.
+  bool InProcess = false;
+};
+
+/// Like Command, but runs the -cc1 tools of the driver executable in the
+/// driver process when InProcess is set.
+class CC1Command : public Command {
+public:
+  CC1Command(const Action &Source_, const Tool &Creator_,
+             const char *Executable_, const ArgStringList &Arguments_,
+             ArrayRef<InputInfo> Inputs);
+
+  int Execute(ArrayRef<Optional<StringRef>> Redirects, std::string *ErrMsg,
+              bool *ExecutionFailed) const override;
 };
 
 /// Like Command, but with a fallback which is executed in case
@@ -18,6 +18,9 @@
 #include "clang/Basic/LangOptions.h"
 #include "clang/Tooling/Core/Replacement.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include <map>
+#include <mutex>
 #include <system_error>
 
 namespace clang {
@@ -1757,6 +1760,21 @@ tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
                                StringRef FileName = "<stdin>",
                                FormattingAttemptStatus *Status = nullptr);
 
+/// \brief Reformats the given \p Ranges in \p Code like \c reformat, but only
+/// lexes, parses and formats the top-level declarations around \p Ranges.
+///
+/// \p Code is split at the blank lines between top-level declarations, which
+/// are found by a raw lexing pass that is much cheaper than formatting. The
+/// returned ``Replacements`` are the ones \c reformat would return. If the
+/// formatting of \p Ranges may depend on the rest of \p Code, e.g. when the
+/// style derives the pointer alignment from the whole file, or if \p Code
+/// can't be split reliably, the whole \p Code is formatted.
+tooling::Replacements
+reformatIncrementally(const FormatStyle &Style, StringRef Code,
+                      ArrayRef<tooling::Range> Ranges,
+                      StringRef FileName = "<stdin>",
+                      FormattingAttemptStatus *Status = nullptr);
+
 /// \brief Same as above, except if ``IncompleteFormat`` is non-null, its value
 /// will be set to true if any of the affected ranges were not formatted due to
 /// a non-recoverable syntax error.
@@ -1802,6 +1820,38 @@ LangOptions getFormattingLangOpts(const FormatStyle &Style = getLLVMStyle());
 /// of ``getStyle()``.
 extern const char *StyleOptionHelpDescription;
 
+/// \brief A cache of the styles that getStyle() loads from ``.clang-format``
+/// files, to be shared by the calls of getStyle() for many files.
+///
+/// The style loaded for a file only depends on its directory and on its
+/// language, so the configuration files are searched for and parsed once for
+/// each pair of them. The cache is thread-safe. It assumes that the
+/// configuration files do not change while it is in use, and that it is always
+/// used with the same file system.
+class StyleCache {
+public:
+  /// \brief The result of the search for the configuration file of a
+  /// directory: either the style it defines, no style if there is no
+  /// configuration file, or a non-empty error message.
+  struct Entry {
+    llvm::Optional<FormatStyle> Style;
+    std::string Error;
+  };
+
+  /// \brief Looks up the entry of \p Directory for \p Language. Returns
+  /// false if there is none.
+  bool lookup(StringRef Directory, FormatStyle::LanguageKind Language,
+              Entry &Result);
+
+  /// \brief Records the entry of \p Directory for \p Language.
+  void insert(StringRef Directory, FormatStyle::LanguageKind Language,
+              Entry Result);
+
+private:
+  std::map<std::pair<std::string, FormatStyle::LanguageKind>, Entry> Entries;
+  std::mutex Mutex;
+};
+
 /// \brief Construct a FormatStyle based on ``StyleName``.
 ///
 /// ``StyleName`` can take several forms:
@@ -1822,6 +1872,9 @@ extern const char *StyleOptionHelpDescription;
 /// language if the filename isn't sufficient.
 /// \param[in] FS The underlying file system, in which the file resides. By
 /// default, the file system is the real file system.
+/// \param[in] Cache If not null, the cache of the styles loaded from
+/// configuration files in which the style of ``FileName`` is looked up before
+/// searching for the file, and recorded after.
 ///
 /// \returns FormatStyle as specified by ``StyleName``. If ``StyleName`` is
 /// "file" and no file is found, returns ``FallbackStyle``. If no style could be
@@ -1829,7 +1882,8 @@ extern const char *StyleOptionHelpDescription;
 llvm::Expected<FormatStyle> getStyle(StringRef StyleName, StringRef FileName,
                                      StringRef FallbackStyle,
                                      StringRef Code = "",
-                                     vfs::FileSystem *FS = nullptr);
+                                     vfs::FileSystem *FS = nullptr,
+                                     StyleCache *Cache = nullptr);
 
 // \brief Returns a string representation of ``Language``.
 inline StringRef getLanguageName(FormatStyle::LanguageKind Language) {
@@ -23,6 +23,7 @@
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/ModuleLoader.h"
 #include "clang/Lex/PreprocessingRecord.h"
+#include "clang/Sema/BoundsCheckCache.h"
 #include "clang/Sema/CodeCompleteConsumer.h"
 #include "clang/Serialization/ASTBitCodes.h"
 #include "clang/Frontend/PrecompiledPreamble.h"
@@ -220,6 +221,11 @@ private:
   /// \brief A list of the serialization ID numbers for each of the top-level
   /// declarations parsed within the precompiled preamble.
   std::vector<serialization::DeclID> TopLevelDeclsInPreamble;
+
+  /// \brief The serialization ID numbers of the top-level declarations of
+  /// the precompiled preamble, which are kept after TopLevelDeclsInPreamble
+  /// is realized, so that the preamble can be extended.
+  std::vector<serialization::DeclID> PreambleTopLevelDeclIDs;
   
   /// \brief Whether we should be caching code-completion results.
   bool ShouldCacheCodeCompletionResults : 1;
@@ -307,7 +313,24 @@ private:
   std::unique_ptr<CodeCompletionTUInfo> CCTUInfo;
 
   /// \brief The set of cached code-completion results.
+  ///
+  /// The results for the entities of the precompiled preamble come first, so
+  /// that they can be kept when only the rest of the file changes.
   std::vector<CachedCodeCompletionResult> CachedCompletionResults;
+
+  /// \brief The number of results at the beginning of
+  /// \c CachedCompletionResults which are for entities of the precompiled
+  /// preamble.
+  unsigned NumCachedPreambleCompletionResults;
+
+  /// \brief Whether the cached results for the entities of the precompiled
+  /// preamble are still up to date, so that only the other results have to be
+  /// recomputed when the top-level declarations after the preamble change.
+  bool CachedPreambleCompletionsValid;
+
+  /// \brief The memory used by \c CachedCompletionAllocator the last time that
+  /// all the cached code-completion results were recomputed.
+  size_t CachedCompletionMemoryAfterFullRebuild;
   
   /// \brief A mapping from the formatted type name to a unique number for that
   /// type, which is used for type equality comparisons.
@@ -330,13 +353,25 @@ private:
   /// \brief The current hash value for the top-level declaration and macro
   /// definition names
   unsigned CurrentTopLevelHashValue;
+
+  /// \brief The function bodies whose Checked C bounds declarations were
+  /// checked without diagnostics in the last parse, which aren't checked
+  /// again when the translation unit is reparsed.
+  sema::BoundsCheckCache BoundsCache;
   
   /// \brief Bit used by CIndex to mark when a translation unit may be in an
   /// inconsistent state, and is not safe to free.
   unsigned UnsafeToFree : 1;
 
+  /// \brief Whether the ASTUnit was frozen, after which it can be read by
+  /// several threads at once but is never modified again.
+  unsigned Frozen : 1;
+
   /// \brief Cache any "global" code-completion results, so that we can avoid
   /// recomputing them with each completion.
+  ///
+  /// If the cached results for the entities of the precompiled preamble are
+  /// still valid, only the results for the rest of the file are recomputed.
   void CacheCodeCompletionResults();
   
   /// \brief Clear out and deallocate 
@@ -384,15 +419,20 @@ private:
 public:
   class ConcurrencyCheck {
     ASTUnit &Self;
-    
+    /// \brief Whether the check was started, which it isn't if the ASTUnit
+    /// is frozen.
+    bool Started;
+
   public:
     explicit ConcurrencyCheck(ASTUnit &Self)
-      : Self(Self) 
+      : Self(Self), Started(!Self.isFrozen())
     { 
-      Self.ConcurrencyCheckValue.start();
+      if (Started)
+        Self.ConcurrencyCheckValue.start();
     }
     ~ConcurrencyCheck() {
-      Self.ConcurrencyCheckValue.finish();
+      if (Started)
+        Self.ConcurrencyCheckValue.finish();
     }
   };
   friend class ConcurrencyCheck;
@@ -404,6 +444,18 @@ public:
   bool isUnsafeToFree() const { return UnsafeToFree; }
   void setUnsafeToFree(bool Value) { UnsafeToFree = Value; }
 
+  /// \brief Deserialize and compute the data of the AST and of the source
+  /// manager that queries would otherwise compute lazily, so that the ASTUnit
+  /// can be read by several threads at once.
+  ///
+  /// A frozen ASTUnit cannot be reparsed. Reads of the declarations, of the
+  /// redeclaration chains and of the lookup tables, of the sizes and layouts
+  /// of the complete types, of the raw comments and of the source locations
+  /// are safe; other uses still need to be serialized by the client.
+  void freeze();
+
+  bool isFrozen() const { return Frozen; }
+
   const DiagnosticsEngine &getDiagnostics() const { return *Diagnostics; }
   DiagnosticsEngine &getDiagnostics()             { return *Diagnostics; }
   
@@ -510,6 +562,12 @@ public:
   /// Note: This is used internally by the top-level tracking action
   unsigned &getCurrentTopLevelHashValue() { return CurrentTopLevelHashValue; }
 
+  /// \brief Retrieve the cache of Checked C bounds checks that is kept
+  /// across reparses.
+  ///
+  /// Note: This is used internally by the top-level tracking action
+  sema::BoundsCheckCache &getBoundsCheckCache() { return BoundsCache; }
+
   /// \brief Get the source location for the given file:line:col triplet.
   ///
   /// The difference with SourceManager::getLocation is that this method checks
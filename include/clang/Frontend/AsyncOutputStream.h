@@ -0,0 +1,117 @@
+//===--- AsyncOutputStream.h - Write files on a separate thread -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the AsyncFileWriter and AsyncOutputStream classes, which
+//  write to a file on a separate thread.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_ASYNCOUTPUTSTREAM_H
+#define LLVM_CLANG_FRONTEND_ASYNCOUTPUTSTREAM_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace clang {
+
+/// \brief Writes to a file on a separate thread.
+///
+/// The data written is collected in chunks, which a writer thread hands to
+/// the underlying file stream while the compiler keeps producing the rest of
+/// the output. At most a few chunks are queued at once; writing blocks until
+/// the writer thread catches up.
+///
+/// Errors are reported by the underlying file stream when the writer is
+/// destroyed, as if the file had been written to directly.
+class AsyncFileWriter {
+public:
+  /// \brief Write to \p OS, in chunks of \p ChunkSize bytes.
+  explicit AsyncFileWriter(std::unique_ptr<llvm::raw_fd_ostream> OS,
+                           size_t ChunkSize = 1 << 20);
+  AsyncFileWriter(const AsyncFileWriter &) = delete;
+  AsyncFileWriter &operator=(const AsyncFileWriter &) = delete;
+  ~AsyncFileWriter();
+
+  /// \brief Append \p Size bytes to the file.
+  void write(const char *Ptr, size_t Size);
+
+  /// \brief Overwrite \p Size bytes of the file, starting at \p Offset.
+  void pwrite(const char *Ptr, size_t Size, uint64_t Offset);
+
+  /// \brief The number of bytes written.
+  uint64_t tell() const { return Pos; }
+
+  /// \brief Wait until everything written so far is in the file, and stop
+  /// the writer thread. Later writes go to the file directly.
+  void close();
+
+private:
+  /// \brief Data to write at the end of the file, or at \c Offset.
+  struct Block {
+    std::vector<char> Data;
+    uint64_t Offset;
+  };
+  static const uint64_t AppendOffset = ~uint64_t(0);
+
+  /// \brief Queue \p B for the writer thread, once few enough bytes are
+  /// queued.
+  void enqueue(Block B);
+
+  /// \brief Queue the pending chunk, if it is not empty.
+  void enqueuePending();
+
+  /// \brief The body of the writer thread.
+  void writeBlocks();
+
+  std::unique_ptr<llvm::raw_fd_ostream> OS;
+  size_t ChunkSize;
+
+  /// \brief The data that was written, but not queued yet.
+  std::vector<char> Pending;
+
+  /// \brief The number of bytes written.
+  uint64_t Pos = 0;
+
+  std::mutex Mutex;
+  std::condition_variable BlockQueued;
+  std::condition_variable BlockWritten;
+  std::deque<Block> Queue;
+  size_t QueuedBytes = 0;
+  bool Closing = false;
+
+  std::thread Writer;
+};
+
+/// \brief A stream that writes to a file through an AsyncFileWriter.
+///
+/// The writer is shared, so that the owner of the output file can wait for
+/// it to be complete even if the stream is never destroyed.
+class AsyncOutputStream : public llvm::raw_pwrite_stream {
+public:
+  explicit AsyncOutputStream(std::shared_ptr<AsyncFileWriter> Writer)
+      : Writer(std::move(Writer)) {}
+  ~AsyncOutputStream() override;
+
+private:
+  void write_impl(const char *Ptr, size_t Size) override;
+  void pwrite_impl(const char *Ptr, size_t Size, uint64_t Offset) override;
+  uint64_t current_pos() const override { return Writer->tell(); }
+
+  std::shared_ptr<AsyncFileWriter> Writer;
+};
+
+} // end namespace clang
+
+#endif
@@ -106,6 +106,13 @@ public:
     Embed_Marker    // Embed a marker as a placeholder for bitcode.
   };
 
+  enum CheckedCTrapBlockKind {
+    CheckedCTrapPerCheck,   // A separate failure block for each dynamic check.
+    CheckedCTrapPerKind,    // One failure block per function for each kind
+                            // of dynamic check.
+    CheckedCTrapPerFunction // One failure block per function.
+  };
+
   /// The code model to use (-mcmodel).
   std::string CodeModel;
 
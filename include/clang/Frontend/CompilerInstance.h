@@ -27,6 +27,7 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace llvm {
 class raw_fd_ostream;
@@ -37,6 +38,7 @@ class TimerGroup;
 namespace clang {
 class ASTContext;
 class ASTReader;
+class AsyncFileWriter;
 class CodeCompleteConsumer;
 class DiagnosticsEngine;
 class DiagnosticConsumer;
@@ -48,6 +50,7 @@ class MemoryBufferCache;
 class Module;
 class Preprocessor;
 class Sema;
+class SharedStatCache;
 class SourceManager;
 class TargetInfo;
 
@@ -88,6 +91,10 @@ class CompilerInstance : public ModuleLoader {
   /// The file manager.
   IntrusiveRefCntPtr<FileManager> FileMgr;
 
+  /// The stat cache shared with other compilations, which is owned by the
+  /// file manager, or null.
+  SharedStatCache *SharedStats = nullptr;
+
   /// The source manager.
   IntrusiveRefCntPtr<SourceManager> SourceMgr;
 
@@ -180,6 +187,10 @@ class CompilerInstance : public ModuleLoader {
   /// stream.
   std::unique_ptr<llvm::raw_fd_ostream> NonSeekStream;
 
+  /// The writers of the output files that are written on a separate thread,
+  /// which must be done before the files are renamed.
+  std::vector<std::shared_ptr<AsyncFileWriter>> AsyncWriters;
+
   /// The list of active output files.
   std::list<OutputFile> OutputFiles;
 
@@ -410,11 +421,16 @@ public:
   void resetAndLeakFileManager() {
     BuryPointer(FileMgr.get());
     FileMgr.resetWithoutRelease();
+    SharedStats = nullptr;
   }
 
   /// \brief Replace the current file manager and virtual file system.
   void setFileManager(FileManager *Value);
 
+  /// \brief Record the stat results of this compilation in the stat cache
+  /// that is shared with other compilations, if there is one.
+  void saveSharedStatCache();
+
   /// }
   /// @name Source Manager
   /// {
@@ -10,6 +10,7 @@
 #ifndef LLVM_CLANG_FRONTEND_FRONTENDOPTIONS_H
 #define LLVM_CLANG_FRONTEND_FRONTENDOPTIONS_H
 
+#include "clang/Basic/LangOptions.h"
 #include "clang/Frontend/CommandLineSourceLoc.h"
 #include "clang/Serialization/ModuleFileExtension.h"
 #include "clang/Sema/CodeCompleteOptions.h"
@@ -175,8 +176,16 @@ public:
   unsigned ShowHelp : 1;                   ///< Show the -help text.
   unsigned ShowStats : 1;                  ///< Show frontend performance
                                            /// metrics and statistics.
+  unsigned ShowConstexprCacheStats : 1;    ///< Show the hit rate of the cache
+                                           /// of constexpr call results.
+  unsigned ShowMemoryReport : 1;           ///< Show the memory used by the
+                                           /// AST, as JSON.
   unsigned ShowTimers : 1;                 ///< Show timers for individual
                                            /// actions.
+  unsigned TimeTrace : 1;                  ///< Write a trace of where the
+                                           /// compiler spends its time.
+  unsigned AsyncOutput : 1;                ///< Write binary output files on
+                                           /// a separate thread.
   unsigned ShowVersion : 1;                ///< Show the -version text.
   unsigned FixWhatYouCan : 1;              ///< Apply fixes even if there are
                                            /// unfixable errors.
@@ -189,6 +198,9 @@ public:
                                            /// speed up parsing in cases you do
                                            /// not need them (e.g. with code
                                            /// completion).
+  unsigned SkipFunctionBodiesIn : 2;       ///< The files in which
+                                           /// SkipFunctionBodies skips bodies,
+                                           /// a SkipFunctionBodiesScope.
   unsigned UseGlobalModuleIndex : 1;       ///< Whether we can use the
                                            ///< global module index if available.
   unsigned GenerateGlobalModuleIndex : 1;  ///< Whether we can generate the
@@ -327,14 +339,21 @@ public:
   /// Filename to write statistics to.
   std::string StatsFile;
 
+  /// The minimum time in microseconds of the events written by -ftime-trace.
+  unsigned TimeTraceGranularity = 500;
+
 public:
   FrontendOptions() :
     DisableFree(false), RelocatablePCH(false), ShowHelp(false),
-    ShowStats(false), ShowTimers(false), ShowVersion(false),
-    FixWhatYouCan(false), FixOnlyWarnings(false), FixAndRecompile(false),
-    FixToTemporaries(false), ARCMTMigrateEmitARCErrors(false),
-    SkipFunctionBodies(false), UseGlobalModuleIndex(true),
-    GenerateGlobalModuleIndex(true), ASTDumpDecls(false), ASTDumpLookups(false),
+    ShowStats(false), ShowConstexprCacheStats(false), ShowMemoryReport(false),
+    ShowTimers(false),
+    TimeTrace(false), AsyncOutput(false), ShowVersion(false),
+    FixWhatYouCan(false), FixOnlyWarnings(false),
+    FixAndRecompile(false), FixToTemporaries(false),
+    ARCMTMigrateEmitARCErrors(false), SkipFunctionBodies(false),
+    SkipFunctionBodiesIn(SFBS_All),
+    UseGlobalModuleIndex(true), GenerateGlobalModuleIndex(true),
+    ASTDumpDecls(false), ASTDumpLookups(false),
     BuildingImplicitModule(false), ModulesEmbedAllFiles(false),
     IncludeTimestamps(true), ARCMTAction(ARCMT_None),
     ObjCMTAction(ObjCMT_None), ProgramAction(frontend::ParseSyntaxOnly)
@@ -0,0 +1,117 @@
+//===--- ModuleBuildCoordinator.h - Coordinate module builds ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the ModuleBuildCoordinator class, which coordinates the
+//  implicit module builds of the compiler instances of a process.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_MODULEBUILDCOORDINATOR_H
+#define LLVM_CLANG_FRONTEND_MODULEBUILDCOORDINATOR_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringSet.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clang {
+
+/// \brief Coordinates the implicit module builds of the threads of a process.
+///
+/// Lock files only let clang processes wait for each other by polling. The
+/// threads of a process that need the same module file instead claim its
+/// build here: the first thread builds the module, and the other threads
+/// sleep until it is done.
+class ModuleBuildCoordinator {
+public:
+  /// \brief The state of a claim on the build of a module file.
+  enum ClaimState {
+    /// \brief The claim is owned: nobody else in the process builds the
+    /// module file until the claim is destroyed.
+    CS_Owned,
+    /// \brief Another thread was building the module file, and finished.
+    CS_BuiltElsewhere,
+    /// \brief Another thread is building the module file, and did not
+    /// finish in time.
+    CS_Busy
+  };
+
+  /// \brief A claim on the build of a module file, released when it is
+  /// destroyed.
+  class BuildClaim {
+    ModuleBuildCoordinator *Coordinator;
+    std::string ModuleFileName;
+    ClaimState State;
+
+    friend class ModuleBuildCoordinator;
+    BuildClaim(ModuleBuildCoordinator *Coordinator, StringRef ModuleFileName,
+               ClaimState State)
+        : Coordinator(Coordinator), ModuleFileName(ModuleFileName),
+          State(State) {}
+
+  public:
+    BuildClaim(BuildClaim &&Other)
+        : Coordinator(Other.Coordinator),
+          ModuleFileName(std::move(Other.ModuleFileName)),
+          State(Other.State) {
+      Other.State = CS_Busy;
+    }
+    BuildClaim(const BuildClaim &) = delete;
+    BuildClaim &operator=(const BuildClaim &) = delete;
+    ~BuildClaim();
+
+    ClaimState getState() const { return State; }
+    bool isOwned() const { return State == CS_Owned; }
+  };
+
+  /// \brief Claim the build of \p ModuleFileName. If another thread is
+  /// building it, wait for at most \p Timeout for it to finish.
+  BuildClaim claim(StringRef ModuleFileName, std::chrono::seconds Timeout);
+
+  /// \brief Claim the build of \p ModuleFileName if no other thread is
+  /// building it, without waiting.
+  BuildClaim tryClaim(StringRef ModuleFileName);
+
+  /// \brief Whether a thread of the process is building \p ModuleFileName.
+  bool isBeingBuilt(StringRef ModuleFileName);
+
+  /// \brief Run \p Build for each node of a dependency graph on \p NumThreads
+  /// threads, after \p Build succeeded for each of the dependencies of the
+  /// node. \p Dependencies holds the indices of the dependencies of each node;
+  /// the edges that close a cycle are ignored. Nodes that depend on a node
+  /// for which \p Build failed are not built.
+  ///
+  /// \returns whether \p Build succeeded, for each node.
+  static std::vector<bool>
+  buildInDependencyOrder(unsigned NumThreads,
+                         ArrayRef<SmallVector<unsigned, 2>> Dependencies,
+                         llvm::function_ref<bool(unsigned)> Build);
+
+  /// \brief The coordinator shared by all compiler instances of the process.
+  static ModuleBuildCoordinator &getProcessCoordinator();
+
+private:
+  void release(StringRef ModuleFileName);
+
+  std::mutex Mutex;
+  std::condition_variable BuildFinished;
+
+  /// \brief The module files that are being built.
+  llvm::StringSet<> Building;
+};
+
+} // end namespace clang
+
+#endif
@@ -35,6 +35,7 @@ class CompilerInstance;
 class CompilerInvocation;
 class DeclGroupRef;
 class PCHContainerOperations;
+class PreprocessorOptions;
 
 /// \brief Runs lexer to compute suggested preamble bounds.
 PreambleBounds ComputePreambleBounds(const LangOptions &LangOpts,
@@ -72,12 +73,18 @@ public:
   ///
   /// \param Callbacks A set of callbacks to be executed when building
   /// the preamble.
+  ///
+  /// \param Base If non-null, a preamble for which CanExtend returned true
+  /// for the same arguments. Only the directives that follow the preamble of
+  /// \p Base are then processed, and the result is a PCH chained on top of the
+  /// PCH of \p Base, which is kept alive by the new preamble.
   static llvm::ErrorOr<PrecompiledPreamble>
   Build(const CompilerInvocation &Invocation,
         const llvm::MemoryBuffer *MainFileBuffer, PreambleBounds Bounds,
         DiagnosticsEngine &Diagnostics, IntrusiveRefCntPtr<vfs::FileSystem> VFS,
         std::shared_ptr<PCHContainerOperations> PCHContainerOps,
-        PreambleCallbacks &Callbacks);
+        PreambleCallbacks &Callbacks,
+        std::shared_ptr<const PrecompiledPreamble> Base = nullptr);
 
   PrecompiledPreamble(PrecompiledPreamble &&) = default;
   PrecompiledPreamble &operator=(PrecompiledPreamble &&) = default;
@@ -94,6 +101,16 @@ public:
                 const llvm::MemoryBuffer *MainFileBuffer, PreambleBounds Bounds,
                 vfs::FileSystem *VFS) const;
 
+  /// Check whether a preamble for the new contents (\p MainFileBuffer) of the
+  /// main file can be built on top of this PrecompiledPreamble, because the
+  /// new preamble only appends directives to this one.
+  bool CanExtend(const CompilerInvocation &Invocation,
+                 const llvm::MemoryBuffer *MainFileBuffer,
+                 PreambleBounds Bounds, vfs::FileSystem *VFS) const;
+
+  /// The number of PCHs in the chain of this preamble, including its own.
+  unsigned getNumLayers() const { return Base ? Base->getNumLayers() + 1 : 1; }
+
   /// Changes options inside \p CI to use PCH from this preamble. Also remaps
   /// main file to \p MainFileBuffer.
   void AddImplicitPreamble(CompilerInvocation &CI,
@@ -102,7 +119,14 @@ public:
 private:
   PrecompiledPreamble(TempPCHFile PCHFile, std::vector<char> PreambleBytes,
                       bool PreambleEndsAtStartOfLine,
-                      llvm::StringMap<PreambleFileHash> FilesInPreamble);
+                      bool PreambleEndsInConditional,
+                      llvm::StringMap<PreambleFileHash> FilesInPreamble,
+                      std::shared_ptr<const PrecompiledPreamble> Base);
+
+  /// Check that none of the files used by the preamble have changed, taking
+  /// the remapped files of \p PreprocessorOpts into account.
+  bool FilesInPreambleUnchanged(const PreprocessorOptions &PreprocessorOpts,
+                                vfs::FileSystem *VFS) const;
 
   /// A temp file that would be deleted on destructor call. If destructor is not
   /// called for any reason, the file will be deleted at static objects'
@@ -185,6 +209,12 @@ private:
   std::vector<char> PreambleBytes;
   /// See PreambleBounds::PreambleEndsAtStartOfLine
   bool PreambleEndsAtStartOfLine;
+  /// Whether the preamble ends inside a conditional directive, whose stack is
+  /// then replayed by the PCH.
+  bool PreambleEndsInConditional;
+  /// The preamble that this one was built on top of, whose PCH is imported by
+  /// ours.
+  std::shared_ptr<const PrecompiledPreamble> Base;
 };
 
 /// A set of callbacks to gather useful information while building a preamble.
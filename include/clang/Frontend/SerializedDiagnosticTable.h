@@ -0,0 +1,167 @@
+//===--- SerializedDiagnosticTable.h - Aggregated diagnostics ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  A diagnostic table holds the serialized diagnostics of many compilations in
+//  a single file, which is mapped into memory and read in place.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_FRONTEND_SERIALIZEDDIAGNOSTICTABLE_H
+#define LLVM_CLANG_FRONTEND_SERIALIZEDDIAGNOSTICTABLE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace clang {
+namespace serialized_diags {
+
+/// \brief Collects the diagnostics of serialized diagnostics files, to write
+/// them as a diagnostic table.
+///
+/// The files are read one after the other, and only their diagnostics are
+/// kept, in columns, so that the memory used does not depend on the size of
+/// the bitstream of each file. Each distinct string, be it the name of a
+/// compilation, a file name, a category, a flag or a message, is kept once.
+/// Source ranges and fix-its are not kept.
+class DiagnosticTableBuilder {
+public:
+  DiagnosticTableBuilder();
+
+  /// \brief Adds the diagnostics of the serialized diagnostics file \p File,
+  /// as the diagnostics of the compilation \p Compilation, or of \p File if
+  /// \p Compilation is empty.
+  std::error_code addSerializedDiagnostics(StringRef File,
+                                           StringRef Compilation = "");
+
+  /// \brief Returns the number of diagnostics added so far.
+  unsigned getNumDiagnostics() const { return Severities.size(); }
+
+  /// \brief Returns the contents of a diagnostic table with all the
+  /// diagnostics added so far.
+  std::string serialize() const;
+
+private:
+  friend class DiagnosticTableReader;
+
+  /// \brief Returns the index of \p S in Strings, adding it if needed.
+  uint32_t intern(StringRef S);
+
+  llvm::StringMap<uint32_t> StringIndices;
+  std::vector<StringRef> Strings;
+
+  // The columns of the diagnostics, as indices in Strings for the strings.
+  std::vector<uint32_t> Severities;
+  std::vector<uint32_t> Compilations;
+  std::vector<uint32_t> Filenames;
+  std::vector<uint32_t> Lines;
+  std::vector<uint32_t> Columns;
+  std::vector<uint32_t> Categories;
+  std::vector<uint32_t> Flags;
+  std::vector<uint32_t> Messages;
+  std::vector<uint32_t> Parents;
+};
+
+/// \brief A diagnostic table, which is mapped into memory and read in place.
+///
+/// The diagnostics are stored by column, and lookups by file name and by
+/// flag go through on-disk hash tables of the indices of their diagnostics.
+/// Loading the table only checks its header.
+class DiagnosticTable {
+public:
+  /// \brief The value of Entry::Parent for a diagnostic which is not a note
+  /// attached to another one.
+  static const unsigned NoParent = ~0u;
+
+  /// \brief A diagnostic of the table.
+  struct Entry {
+    /// The serialized_diags::Level of the diagnostic.
+    unsigned Severity;
+    StringRef Compilation;
+    StringRef Filename;
+    unsigned Line;
+    unsigned Column;
+    StringRef Category;
+    /// The warning option of the diagnostic, without the leading ``-W``.
+    StringRef Flag;
+    StringRef Message;
+    /// The index of the diagnostic the note is attached to, or NoParent.
+    unsigned Parent;
+  };
+
+  /// \brief Loads a diagnostic table from the specified file.
+  ///
+  /// Returns NULL and sets ErrorMessage if the table could not be loaded.
+  static std::unique_ptr<DiagnosticTable>
+  loadFromFile(StringRef FilePath, std::string &ErrorMessage);
+
+  /// \brief Loads a diagnostic table from a data buffer.
+  ///
+  /// Returns NULL and sets ErrorMessage if the table could not be loaded.
+  static std::unique_ptr<DiagnosticTable>
+  loadFromBuffer(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+                 std::string &ErrorMessage);
+
+  /// \brief Returns the number of diagnostics in the table.
+  unsigned getNumDiagnostics() const { return NumDiagnostics; }
+
+  /// \brief Returns the diagnostic with the given index.
+  Entry getDiagnostic(unsigned Index) const;
+
+  /// \brief Returns the indices of the diagnostics located in \p Filename.
+  std::vector<unsigned> getDiagnosticsInFile(StringRef Filename) const;
+
+  /// \brief Returns the indices of the diagnostics controlled by the warning
+  /// option \p Flag, given without the leading ``-W``.
+  std::vector<unsigned> getDiagnosticsWithFlag(StringRef Flag) const;
+
+private:
+  explicit DiagnosticTable(std::unique_ptr<llvm::MemoryBuffer> Buffer)
+      : Buffer(std::move(Buffer)) {}
+
+  /// \brief Checks the header of the table, and reads the offsets of its
+  /// columns and indices. Returns false if the table is malformed.
+  bool readHeader(std::string &ErrorMessage);
+
+  /// \brief Returns the value of the column at \p ColumnOffset for the
+  /// diagnostic with the given index.
+  uint32_t getValue(uint32_t ColumnOffset, unsigned Index) const;
+
+  /// \brief Returns the string at \p Offset, or an empty string if
+  /// \p Offset is out of bounds.
+  StringRef getString(uint32_t Offset) const;
+
+  /// \brief Returns the indices of the diagnostics of \p Key in the on-disk
+  /// hash table at \p IndexOffset.
+  std::vector<unsigned> lookup(uint32_t IndexOffset, StringRef Key) const;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  uint32_t NumDiagnostics = 0;
+  uint32_t SeverityOffset = 0;
+  uint32_t CompilationOffset = 0;
+  uint32_t FilenameOffset = 0;
+  uint32_t LineOffset = 0;
+  uint32_t ColumnOffset = 0;
+  uint32_t CategoryOffset = 0;
+  uint32_t FlagOffset = 0;
+  uint32_t MessageOffset = 0;
+  uint32_t ParentOffset = 0;
+  uint32_t FileIndexOffset = 0;
+  uint32_t FlagIndexOffset = 0;
+};
+
+} // end namespace serialized_diags
+} // end namespace clang
+
+#endif
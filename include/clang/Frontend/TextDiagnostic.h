@@ -17,6 +17,7 @@
 #define LLVM_CLANG_FRONTEND_TEXTDIAGNOSTIC_H
 
 #include "clang/Frontend/DiagnosticRenderer.h"
+#include "llvm/ADT/DenseMap.h"
 
 namespace clang {
 
@@ -35,6 +36,11 @@ namespace clang {
 class TextDiagnostic : public DiagnosticRenderer {
   raw_ostream &OS;
 
+  /// \brief The number of snippets shown for each location, keyed by the
+  /// character it points to. Only used with a SnippetRepeatLimit, so that a
+  /// header which is included many times shares its counts.
+  llvm::DenseMap<const char *, unsigned> SnippetCounts;
+
 public:
   TextDiagnostic(raw_ostream &OS,
                  const LangOptions &LangOpts,
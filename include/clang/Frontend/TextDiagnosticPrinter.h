@@ -18,6 +18,7 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringSet.h"
 #include <memory>
 
 namespace clang {
@@ -35,8 +36,21 @@ class TextDiagnosticPrinter : public DiagnosticConsumer {
   /// A string to prefix to error messages.
   std::string Prefix;
 
+  /// \brief The diagnostics printed in the current source file, identified by
+  /// their ID, presumed location and message, with -fdiagnostics-deduplicate.
+  llvm::StringSet<> PrintedDiags;
+
   unsigned OwnsOutputStream : 1;
 
+  /// \brief Whether the notes that follow are attached to a diagnostic that
+  /// was not printed again.
+  unsigned SuppressNotes : 1;
+
+  /// \brief Returns true if the diagnostic, or the diagnostic a note is
+  /// attached to, was already printed in the current source file.
+  bool isDuplicate(DiagnosticsEngine::Level Level, const Diagnostic &Info,
+                   StringRef Message);
+
 public:
   TextDiagnosticPrinter(raw_ostream &os, DiagnosticOptions *diags,
                         bool OwnsOutputStream = false);
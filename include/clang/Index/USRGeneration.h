@@ -11,7 +11,11 @@
 #define LLVM_CLANG_INDEX_USRGENERATION_H
 
 #include "clang/Basic/LLVM.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Allocator.h"
+#include <cstdint>
 
 namespace clang {
 class Decl;
@@ -29,6 +33,50 @@ static inline StringRef getUSRSpacePrefix() {
 /// \returns true if the results should be ignored, false otherwise.
 bool generateUSRForDecl(const Decl *D, SmallVectorImpl<char> &Buf);
 
+/// \brief A stable 128-bit hash of a USR.
+struct USRHash {
+  uint64_t High = 0;
+  uint64_t Low = 0;
+
+  bool operator==(const USRHash &RHS) const {
+    return High == RHS.High && Low == RHS.Low;
+  }
+  bool operator!=(const USRHash &RHS) const { return !(*this == RHS); }
+};
+
+/// \brief Generate a stable 64-bit hash of the USR of a Decl, including the
+/// USR prefix, without returning the USR itself. The hash is the same across
+/// runs and hosts, so it can be stored in an index.
+/// \returns true if the results should be ignored, false otherwise.
+bool generateUSRHashForDecl(const Decl *D, uint64_t &Hash);
+
+/// \brief Generate a stable 128-bit hash of the USR of a Decl, including the
+/// USR prefix, for indexes in which 64-bit hashes could collide.
+/// \returns true if the results should be ignored, false otherwise.
+bool generateUSRHashForDecl(const Decl *D, USRHash &Hash);
+
+/// \brief A cache of the USRs of declarations, for clients that look up the
+/// USRs of the same declarations many times.
+///
+/// Each distinct USR is stored once, so the redeclarations of an entity share
+/// the same string. The strings are null-terminated and live as long as the
+/// cache, which must not outlive the ASTContext of the declarations.
+class USRCache {
+public:
+  /// \brief Returns the USR of \p D, or an empty string if the USR of \p D
+  /// should be ignored.
+  StringRef getUSR(const Decl *D);
+
+  void clear() {
+    USRs.clear();
+    Strings.clear();
+  }
+
+private:
+  llvm::DenseMap<const Decl *, StringRef> USRs;
+  llvm::StringSet<llvm::BumpPtrAllocator> Strings;
+};
+
 /// \brief Generate a USR fragment for an Objective-C class.
 void generateUSRForObjCClass(StringRef Cls, raw_ostream &OS,
                              StringRef ExtSymbolDefinedIn = "",
@@ -0,0 +1,41 @@
+//===- DependencyDirectivesSourceMinimizer.h - Minimize sources -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief Defines the minimization of source files to the preprocessor
+/// directives that can affect which files they include.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESSOURCEMINIMIZER_H
+#define LLVM_CLANG_LEX_DEPENDENCYDIRECTIVESSOURCEMINIMIZER_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace clang {
+
+/// \brief Minimize the source \p Input to the directives that can affect the
+/// files that it includes, for dependency scanning.
+///
+/// The result keeps the \#include, \#include_next, \#import, \#define,
+/// \#undef, conditional and \#pragma directives, one per line, with their
+/// comments and line continuations removed.  All other tokens are dropped.
+/// Preprocessing the result finds the same included files as preprocessing
+/// \p Input, at a fraction of the cost.
+///
+/// \returns true if \p Input could not be minimized, for instance because it
+/// has an unterminated comment, in which case \p Output is unspecified.
+bool minimizeSourceToDependencyDirectives(StringRef Input,
+                                          SmallVectorImpl<char> &Output);
+
+} // end namespace clang
+
+#endif
@@ -18,6 +18,7 @@
 #include "clang/Lex/ModuleMap.h"
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/Support/Allocator.h"
@@ -30,6 +31,7 @@ class DiagnosticsEngine;
 class ExternalPreprocessorSource;
 class FileEntry;
 class FileManager;
+class HeaderSearchCache;
 class HeaderSearchOptions;
 class IdentifierInfo;
 class Preprocessor;
@@ -199,6 +201,14 @@ class HeaderSearch {
   };
   llvm::StringMap<LookupFileCacheInfo, llvm::BumpPtrAllocator> LookupFileCache;
 
+  /// \brief The results of LookupFile shared with other compilations, if
+  /// -header-search-cache was given.
+  std::unique_ptr<HeaderSearchCache> SharedLookups;
+
+  /// \brief A hash of the search path configuration, which keys the shared
+  /// results.  Computed on first use.
+  Optional<uint64_t> SearchPathFingerprint;
+
   /// \brief Collection mapping a framework or subframework
   /// name like "Carbon" to the Carbon.framework directory.
   llvm::StringMap<FrameworkCacheEntry, llvm::BumpPtrAllocator> FrameworkMap;
@@ -269,6 +279,7 @@ public:
     AngledDirIdx = angledDirIdx;
     SystemDirIdx = systemDirIdx;
     NoCurDirSearch = noCurDirSearch;
+    SearchPathFingerprint = None;
     //LookupFileCache.clear();
   }
 
@@ -279,6 +290,7 @@ public:
     if (!isAngled)
       AngledDirIdx++;
     SystemDirIdx++;
+    SearchPathFingerprint = None;
   }
 
   /// \brief Set the list of system header prefixes.
@@ -691,7 +703,26 @@ public:
   
   size_t getTotalMemory() const;
 
+  /// \brief Save the LookupFile results shared with other compilations.
+  void saveSharedLookupCache();
+
 private:
+  /// \brief Return the hash of the search path configuration.
+  uint64_t getSearchPathFingerprint();
+
+  /// \brief Look up the shared result of searching for \p Filename from the
+  /// search directory \p StartIdx, and check that it is still valid.
+  ///
+  /// \returns true if a valid result was found, in which case \p HitIdx is
+  /// set to the directory in which to resume the search.
+  bool lookupSharedCache(StringRef Filename, unsigned StartIdx,
+                         unsigned &HitIdx);
+
+  /// \brief Record the result of a complete search for \p Filename from the
+  /// search directory \p StartIdx, if it can be revalidated later.
+  void recordSharedCache(StringRef Filename, unsigned StartIdx,
+                         unsigned HitIdx);
+
   /// \brief Describes what happened when we tried to load a module map file.
   enum LoadModuleMapResult {
     /// \brief The module map file had already been loaded.
@@ -0,0 +1,120 @@
+//===--- HeaderSearchCache.h - Header lookups shared across TUs -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the HeaderSearchCache interface.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LEX_HEADERSEARCHCACHE_H
+#define LLVM_CLANG_LEX_HEADERSEARCHCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include <memory>
+#include <string>
+
+namespace llvm {
+class MemoryBuffer;
+template <typename Info> class OnDiskIterableChainedHashTable;
+}
+
+namespace clang {
+
+namespace vfs {
+class FileSystem;
+}
+
+/// \brief The results of header search lookups, in a file that is shared by
+/// the compilations on a host.
+///
+/// A result records where the search for an \#include spelling, starting at
+/// a given search directory, found its header, or that it found none, for one
+/// configuration of the search path.  It is valid for as long as each of the
+/// directories that the search passed over still does not contain the
+/// header.  For each such directory the result records the nearest existing
+/// ancestor of the path that was probed, and its modification time: the
+/// probed path cannot appear without that time changing.
+class HeaderSearchCache {
+public:
+  /// \brief A directory that did not contain the header.
+  struct Probe {
+    /// \brief The number of path components above the parent of the probed
+    /// path at which the nearest existing ancestor is found.
+    unsigned Up;
+    /// \brief The modification time of that ancestor, in nanoseconds.
+    uint64_t Time;
+  };
+
+  /// \brief The result of a lookup.
+  struct Entry {
+    /// \brief The index of the search directory in which the header was
+    /// found, or the number of search directories if it was not found.
+    unsigned HitIdx;
+    /// \brief The directories before HitIdx, from the start of the search.
+    SmallVector<Probe, 4> Probes;
+  };
+
+  class LookupTrait;
+
+  ~HeaderSearchCache();
+
+  /// \brief Create a cache backed by the file at \p Path, with the results
+  /// recorded there by earlier compilations if the file exists and is valid.
+  static std::unique_ptr<HeaderSearchCache> create(StringRef Path);
+
+  /// \brief Return the result recorded for \p Filename searched from the
+  /// search directory \p StartIdx, in the search path configuration
+  /// \p Fingerprint.  The result still has to be revalidated.
+  Optional<Entry> lookup(uint64_t Fingerprint, unsigned StartIdx,
+                         StringRef Filename);
+
+  /// \brief Record a result to be saved.
+  void record(uint64_t Fingerprint, unsigned StartIdx, StringRef Filename,
+              const Entry &E);
+
+  /// \brief Compute the probe of \p Filename in the directory \p Dir.
+  ///
+  /// \returns None if there is no existing ancestor, or if it was modified
+  /// too recently to be sure that a change would be noticed.
+  Optional<Probe> computeProbe(StringRef Dir, StringRef Filename,
+                               vfs::FileSystem &FS);
+
+  /// \brief Returns true if \p Filename is still not in the directory
+  /// \p Dir, according to the recorded probe \p P.
+  bool isProbeValid(StringRef Dir, StringRef Filename, const Probe &P,
+                    vfs::FileSystem &FS);
+
+  /// \brief Merge the results recorded by this compilation into the file,
+  /// which is replaced atomically.
+  ///
+  /// \returns true if an error occurred, false otherwise.
+  bool save();
+
+private:
+  typedef llvm::OnDiskIterableChainedHashTable<LookupTrait> TableTy;
+
+  HeaderSearchCache(StringRef CachePath,
+                    std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+  /// \brief Return the modification time of the directory \p Dir, or None if
+  /// it is not a directory.  The time is computed once per compilation.
+  Optional<uint64_t> getDirectoryTime(StringRef Dir, vfs::FileSystem &FS);
+
+  std::string CachePath;
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  std::unique_ptr<TableTy> Table;
+  llvm::StringMap<Optional<uint64_t>> DirectoryTimes;
+  llvm::StringMap<Entry> NewEntries;
+};
+
+} // end namespace clang
+
+#endif
@@ -154,6 +154,24 @@ public:
   /// \brief The set of user-provided virtual filesystem overlay files.
   std::vector<std::string> VFSOverlayFiles;
 
+  /// \brief The file through which header search results are shared with
+  /// other compilations, if any.
+  std::string LookupCachePath;
+
+  /// \brief The file in which the build system lists the hashes of the input
+  /// files that it knows to be unchanged, if any.
+  ///
+  /// Each line holds the xxHash64 of the contents of a file, in hexadecimal,
+  /// followed by a space and the path of the file.  The input files of AST
+  /// files whose stored content hash matches are not validated when the AST
+  /// file is loaded, only when they are used.
+  std::string ASTInputFilesManifest;
+
+  /// \brief The number of threads on which the modules that a module uses
+  /// are built before it, when it is built implicitly. Zero or one to build
+  /// each module on the thread that imports it.
+  unsigned ModulesBuildJobs = 0;
+
   /// Include the compiler builtin includes.
   unsigned UseBuiltinIncludes : 1;
 
@@ -177,6 +195,12 @@ public:
   /// \brief Whether to validate system input files when a module is loaded.
   unsigned ModulesValidateSystemHeaders : 1;
 
+  /// \brief Whether to store the hash of the contents of the input files in
+  /// the AST files that are written, and to compare it to the contents of an
+  /// input file whose size or modification time changed before considering
+  /// an AST file out of date.
+  unsigned ValidateASTInputFilesContent : 1;
+
   /// Whether the module includes debug information (-gmodules).
   unsigned UseDebugInfo : 1;
 
@@ -184,6 +208,11 @@ public:
 
   unsigned ModulesHashContent : 1;
 
+  /// \brief Whether to share the buffers of the module files that are read
+  /// with the other compiler instances of the process, through
+  /// \c SharedMemoryBufferCache::getProcessCache().
+  unsigned ModulesShareBuffers : 1;
+
   HeaderSearchOptions(StringRef _Sysroot = "/")
       : Sysroot(_Sysroot), ModuleFormat("raw"), DisableModuleHash(0),
         ImplicitModuleMaps(0), ModuleMapFileHomeIsCwd(0),
@@ -192,8 +221,10 @@ public:
         UseBuiltinIncludes(true), UseStandardSystemIncludes(true),
         UseStandardCXXIncludes(true), UseLibcxx(false), Verbose(false),
         ModulesValidateOncePerBuildSession(false),
-        ModulesValidateSystemHeaders(false), UseDebugInfo(false),
-        ModulesValidateDiagnosticOptions(true), ModulesHashContent(false) {}
+        ModulesValidateSystemHeaders(false),
+        ValidateASTInputFilesContent(false), UseDebugInfo(false),
+        ModulesValidateDiagnosticOptions(true), ModulesHashContent(false),
+        ModulesShareBuffers(false) {}
 
   /// AddPath - Add the \p Path path to the specified \p Group list.
   void AddPath(StringRef Path, frontend::IncludeDirGroup Group,
@@ -39,8 +39,10 @@ class PTHManager : public IdentifierInfoLookup {
 
   class PTHStringLookupTrait;
   class PTHFileLookupTrait;
+  class PTHContentLookupTrait;
   typedef llvm::OnDiskChainedHashTable<PTHStringLookupTrait> PTHStringIdLookup;
   typedef llvm::OnDiskChainedHashTable<PTHFileLookupTrait> PTHFileLookup;
+  typedef llvm::OnDiskChainedHashTable<PTHContentLookupTrait> PTHContentLookup;
 
   /// The memory mapped PTH file.
   std::unique_ptr<const llvm::MemoryBuffer> Buf;
@@ -56,6 +58,14 @@ class PTHManager : public IdentifierInfoLookup {
   ///  and token data in the PTH file.
   std::unique_ptr<PTHFileLookup> FileLookup;
 
+  /// ContentLookup - Abstract data structure used for mapping between the
+  ///  hashes of the contents of files and token data in the PTH file.
+  std::unique_ptr<PTHContentLookup> ContentLookup;
+
+  /// LookupByContent - Whether files are matched to token data by the hash
+  ///  of their contents instead of by name.
+  bool LookupByContent;
+
   /// IdDataTable - Array representing the mapping from persistent IDs to the
   ///  data offset within the PTH file containing the information to
   ///  reconsitute an IdentifierInfo.
@@ -84,6 +94,7 @@ class PTHManager : public IdentifierInfoLookup {
   /// method.
   PTHManager(std::unique_ptr<const llvm::MemoryBuffer> buf,
              std::unique_ptr<PTHFileLookup> fileLookup,
+             std::unique_ptr<PTHContentLookup> contentLookup,
              const unsigned char *idDataTable,
              std::unique_ptr<IdentifierInfo *[], llvm::FreeDeleter> perIDCache,
              std::unique_ptr<PTHStringIdLookup> stringIdLookup, unsigned numIds,
@@ -106,9 +117,20 @@ class PTHManager : public IdentifierInfoLookup {
   }
   IdentifierInfo* LazilyCreateIdentifierInfo(unsigned PersistentID);
 
+  /// CreateLexerAt - Return a PTHLexer for the token data and pp-conditional
+  ///  table at the given offsets within the PTH file.
+  PTHLexer *CreateLexerAt(FileID FID, uint32_t TokenOff, uint32_t PPCondOff);
+
 public:
   // The current PTH version.
-  enum { Version = 10 };
+  enum { Version = 11 };
+
+  /// ContentHash - The key of a file in the table of files by content, the
+  ///  MD5 hash of the contents as two 64-bit words.
+  typedef std::pair<uint64_t, uint64_t> ContentHash;
+
+  /// getContentHash - Compute the key of a file with the given contents.
+  static ContentHash getContentHash(StringRef Contents);
 
   ~PTHManager() override;
 
@@ -130,6 +152,13 @@ public:
 
   void setPreprocessor(Preprocessor *pp) { PP = pp; }
 
+  /// setLookupByContent - Match files to cached tokens by the hash of their
+  ///  contents, so that the tokens of a header are used for every file with
+  ///  the same contents, whatever its path.  The stat information in the PTH
+  ///  file is not used in this mode.
+  void setLookupByContent(bool V) { LookupByContent = V; }
+  bool isLookupByContent() const { return LookupByContent; }
+
   /// CreateLexer - Return a PTHLexer that "lexes" the cached tokens for the
   ///  specified file.  This method returns NULL if no cached tokens exist.
   ///  It is the responsibility of the caller to 'delete' the returned object.
@@ -633,11 +633,20 @@ class Preprocessor {
   /// \brief The file ID for the preprocessor predefines.
   FileID PredefinesFileID;
 
-  /// \{
   /// \brief Cache of macro expanders to reduce malloc traffic.
-  enum { TokenLexerCacheSize = 8 };
-  unsigned NumCachedTokenLexers;
-  std::unique_ptr<TokenLexer> TokenLexerCache[TokenLexerCacheSize];
+  ///
+  /// Holds every expander that is not in use, so once the deepest nesting of
+  /// expansions has been reached, entering a macro no longer allocates.
+  SmallVector<std::unique_ptr<TokenLexer>, 8> TokenLexerCache;
+
+  /// \{
+  /// \brief Token buffers for reading and expanding the arguments of
+  /// function-like macros, reused across expansions to reduce malloc traffic.
+  ///
+  /// Argument pre-expansion nests expansions, so each expansion in progress
+  /// uses the buffer at its depth.
+  std::vector<std::unique_ptr<SmallVector<Token, 128>>> MacroTokenBuffers;
+  unsigned NumActiveMacroTokenBuffers;
   /// \}
 
   /// \brief Keeps macro expanded tokens for TokenLexers.
@@ -1884,6 +1893,21 @@ private:
   void removeCachedMacroExpandedTokensOfLastLexer();
   friend void TokenLexer::ExpandFunctionArguments();
 
+  /// \brief Borrows the token buffer for the current depth of macro
+  /// expansion for as long as it is alive.  The buffer starts out empty.
+  class MacroTokenBuffer {
+    Preprocessor &PP;
+    SmallVectorImpl<Token> &Tokens;
+
+  public:
+    explicit MacroTokenBuffer(Preprocessor &PP)
+        : PP(PP), Tokens(PP.acquireMacroTokenBuffer()) {}
+    ~MacroTokenBuffer() { --PP.NumActiveMacroTokenBuffers; }
+
+    SmallVectorImpl<Token> &get() { return Tokens; }
+  };
+  SmallVectorImpl<Token> &acquireMacroTokenBuffer();
+
   /// Determine whether the next preprocessor token to be
   /// lexed is a '('.  If so, consume the token and return true, if not, this
   /// method should have no observable side-effect on the lexed tokens.
@@ -1915,6 +1939,10 @@ private:
   /// start getting tokens from it using the PTH cache.
   void EnterSourceFileWithPTH(PTHLexer *PL, const DirectoryLookup *Dir);
 
+  /// \brief Replace the contents of the file \p FID by its dependency
+  /// directives, for -minimize-source-for-dependencies.
+  void minimizeSourceFile(FileID FID);
+
   /// \brief Set the FileID for the preprocessor predefines.
   void setPredefinesFileID(FileID FID) {
     assert(PredefinesFileID.isInvalid() && "PredefinesFileID already set!");
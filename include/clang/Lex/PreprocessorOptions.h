@@ -95,6 +95,19 @@ public:
   /// If given, a PTH cache file to use for speeding up header parsing.
   std::string TokenCache;
 
+  /// Whether the files in the token cache are matched by the hash of their
+  /// contents instead of by path.
+  bool TokenCacheByContent = false;
+
+  /// Whether each source file is minimized to the directives that affect the
+  /// files it includes before it is preprocessed.  Only meaningful when just
+  /// preprocessing, for instance to scan dependencies.
+  bool MinimizeSourceForDependencies = false;
+
+  /// If given, the directory in which minimized source files are cached for
+  /// other compilations.
+  std::string MinimizedSourceCachePath;
+
   /// When enabled, preprocessor is in a mode for parsing a single file only.
   ///
   /// Disables #includes of other files and if there are unresolved identifiers
@@ -191,6 +204,9 @@ public:
     ImplicitPCHInclude.clear();
     ImplicitPTHInclude.clear();
     TokenCache.clear();
+    TokenCacheByContent = false;
+    MinimizeSourceForDependencies = false;
+    MinimizedSourceCachePath.clear();
     SingleFileParseMode = false;
     LexEditorPlaceholders = true;
     RetainRemappedFileBuffers = true;
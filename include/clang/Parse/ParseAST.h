@@ -36,16 +36,20 @@ namespace clang {
   /// \param SkipFunctionBodies Whether to skip parsing of function bodies.
   /// This option can be used, for example, to speed up searches for
   /// declarations/definitions when indexing.
+  /// \param SkipScope The files whose function bodies are skipped when
+  /// \p SkipFunctionBodies is set.
   void ParseAST(Preprocessor &pp, ASTConsumer *C,
                 ASTContext &Ctx, bool PrintStats = false,
                 TranslationUnitKind TUKind = TU_Complete,
                 CodeCompleteConsumer *CompletionConsumer = nullptr,
-                bool SkipFunctionBodies = false);
+                bool SkipFunctionBodies = false,
+                SkipFunctionBodiesScope SkipScope = SFBS_All);
 
   /// \brief Parse the main file known to the preprocessor, producing an 
   /// abstract syntax tree.
   void ParseAST(Sema &S, bool PrintStats = false,
-                bool SkipFunctionBodies = false);
+                bool SkipFunctionBodies = false,
+                SkipFunctionBodiesScope SkipScope = SFBS_All);
 
 }  // end namespace clang
 
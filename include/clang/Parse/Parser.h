@@ -303,13 +303,18 @@ class Parser : public CodeCompletionHandler {
   /// declarations/definitions when indexing.
   bool SkipFunctionBodies;
 
+  /// The files whose function bodies are skipped when SkipFunctionBodies is
+  /// set.
+  SkipFunctionBodiesScope SkipFunctionBodiesIn;
+
   /// The location of the expression statement that is being parsed right now.
   /// Used to determine if an expression that is being parsed is a statement or
   /// just a regular sub-expression.
   SourceLocation ExprStatementTokLoc;
 
 public:
-  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies);
+  Parser(Preprocessor &PP, Sema &Actions, bool SkipFunctionBodies,
+         SkipFunctionBodiesScope SkipScope = SFBS_All);
   ~Parser() override;
 
   const LangOptions &getLangOpts() const { return PP.getLangOpts(); }
@@ -1768,6 +1773,14 @@ private:
   QualType SubstituteTypeVariable(QualType QT,
     SmallVector<DeclRefExpr::GenericInstInfo::TypeArgument, 4> &typeNames);
 
+  /// \brief The function types of the instantiations of generic functions,
+  /// keyed by the generic function.  Each entry pairs the type arguments of
+  /// an instantiation with the function type substituted for them, which
+  /// later references with the same type arguments reuse.
+  llvm::DenseMap<const FunctionDecl *,
+                 SmallVector<std::pair<SmallVector<QualType, 2>, QualType>, 1>>
+    GenericFunctionInstantiations;
+
   ExprResult ParseInteropTypeAnnotation(const Declarator &D, bool IsReturn=false);
   bool ParseBoundsAnnotations(const Declarator &D,
                               SourceLocation ColonLoc,
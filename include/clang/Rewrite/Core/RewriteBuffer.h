@@ -13,6 +13,7 @@
 #include "clang/Basic/LLVM.h"
 #include "clang/Rewrite/Core/DeltaTree.h"
 #include "clang/Rewrite/Core/RewriteRope.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 
 namespace clang {
@@ -112,6 +113,34 @@ private:  // Methods only usable by Rewriter.
   }
 };
 
+/// RewriteEdit - A replacement of OrigLength characters at OrigOffset in an
+/// input buffer with NewText.  An edit with an OrigLength of zero is an
+/// insertion.
+struct RewriteEdit {
+  unsigned OrigOffset;
+  unsigned OrigLength;
+  StringRef NewText;
+
+  RewriteEdit(unsigned OrigOffset, unsigned OrigLength, StringRef NewText)
+      : OrigOffset(OrigOffset), OrigLength(OrigLength), NewText(NewText) {}
+};
+
+/// \brief Write to \p Stream the result of applying \p Edits to \p Input.
+///
+/// Unlike a RewriteBuffer, this doesn't keep the rewritten text.  It copies
+/// the unchanged parts of \p Input and the new text of the edits to
+/// \p Stream in a single pass, which is much cheaper when a buffer is
+/// rewritten in a great many places and only written out once.
+///
+/// \p Edits must be sorted by their offset in \p Input and must not overlap;
+/// insertions at the same offset, or at the offset of another edit, are
+/// written in the order of \p Edits.
+///
+/// \returns true if \p Edits are not sorted, overlap, or extend past the end
+/// of \p Input, in which case nothing is written.
+bool writeEditedBuffer(raw_ostream &Stream, StringRef Input,
+                       ArrayRef<RewriteEdit> Edits);
+
 } // end namespace clang
 
 #endif
@@ -0,0 +1,63 @@
+//===--- BoundsCheckCache.h - Reuse of Checked C bounds checks --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines BoundsCheckCache, which remembers the function bodies
+// whose Checked C bounds declarations checked without diagnostics, so that
+// they are not checked again when a translation unit is reparsed.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_BOUNDSCHECKCACHE_H
+#define LLVM_CLANG_SEMA_BOUNDSCHECKCACHE_H
+
+#include <cstddef>
+#include <unordered_set>
+
+namespace clang {
+namespace sema {
+
+/// \brief The fingerprints of the function bodies whose bounds declarations
+/// were checked without diagnostics.  A fingerprint is a hash of the text
+/// of a function and of the declarations that its body refers to (see
+/// Sema::CheckFunctionBodyBoundsDecls).
+///
+/// The cache is owned by an ASTUnit and lives across reparses.  Only the
+/// fingerprints seen during the last parse are kept, so functions that
+/// are deleted or edited don't accumulate.
+class BoundsCheckCache {
+public:
+  /// \brief Start a new parse.  The fingerprints from the parse before it
+  /// become the ones that can be found.
+  void beginParse() {
+    Previous.swap(Current);
+    Current.clear();
+  }
+
+  /// \brief Determine whether a function with Fingerprint was checked
+  /// without diagnostics in the previous parse.  If so, it is kept for the
+  /// next parse.
+  bool isClean(size_t Fingerprint) {
+    if (!Previous.count(Fingerprint))
+      return false;
+    Current.insert(Fingerprint);
+    return true;
+  }
+
+  /// \brief Record that a function with Fingerprint was checked without
+  /// diagnostics.
+  void markClean(size_t Fingerprint) { Current.insert(Fingerprint); }
+
+private:
+  std::unordered_set<size_t> Previous;
+  std::unordered_set<size_t> Current;
+};
+
+} // end namespace sema
+} // end namespace clang
+
+#endif
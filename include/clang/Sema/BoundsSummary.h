@@ -0,0 +1,65 @@
+//===--- BoundsSummary.h - Checked C bounds of call arguments ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines BoundsSummary, a worker object used by Sema that records
+// the bounds that the calls in a translation unit prove for the pointer
+// arguments of the functions they call.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_BOUNDSSUMMARY_H
+#define LLVM_CLANG_SEMA_BOUNDSSUMMARY_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace clang {
+
+class FunctionDecl;
+
+namespace sema {
+
+/// \brief For each function called directly in a translation unit, the
+/// number of elements that the checked array pointer arguments of the calls
+/// are proved to point to.  A whole-program pass that sees the summaries of
+/// all translation units can remove the dynamic checks in a function that
+/// every call proves unnecessary.
+class BoundsSummary {
+public:
+  /// \brief The calls to one function.  MinElements[i] is the smallest
+  /// number of elements of its referent type that argument i points to at
+  /// any of the calls, or -1 if some call does not prove a number.
+  struct CallBounds {
+    unsigned CallSites = 0;
+    SmallVector<int64_t, 4> MinElements;
+
+    /// \brief Add NumCalls calls whose arguments point to at least Elements
+    /// elements.  Arguments past the end of Elements prove nothing.
+    void merge(unsigned NumCalls, ArrayRef<int64_t> Elements);
+  };
+
+  typedef llvm::MapVector<const FunctionDecl *, CallBounds> FunctionMap;
+
+  /// \brief Record a direct call to Callee.  ArgElements[i] is the number of
+  /// elements that argument i is proved to point to, or -1.
+  void addCallSite(const FunctionDecl *Callee, ArrayRef<int64_t> ArgElements);
+
+  /// \brief The calls recorded so far, by the canonical declaration of the
+  /// function called, in the order of their first call.
+  const FunctionMap &functions() const { return Functions; }
+
+private:
+  FunctionMap Functions;
+};
+
+} // end namespace sema
+} // end namespace clang
+
+#endif
@@ -0,0 +1,116 @@
+//===--- BoundsTimeReport.h - Timing of Checked C bounds checks -*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines BoundsTimeReport, a worker object used by Sema that
+// measures the time spent checking Checked C bounds declarations for
+// -fcheckedc-time-report.
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SEMA_BOUNDSTIMEREPORT_H
+#define LLVM_CLANG_SEMA_BOUNDSTIMEREPORT_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Timer.h"
+#include <string>
+
+namespace clang {
+
+class ASTContext;
+class FunctionDecl;
+
+namespace sema {
+
+/// \brief The time spent in the parts of Checked C bounds checking, both
+/// for the whole translation unit and for each function body checked.
+/// The totals are reported through an llvm::TimerGroup.  The per-function
+/// numbers are printed for the functions that took longest to check and,
+/// with -fcheckedc-time-report-json=, written to a file.
+class BoundsTimeReport {
+public:
+  /// \brief The parts of bounds checking that are timed.  The times are
+  /// inclusive: time spent in one part on behalf of another, such as the
+  /// non-modifying checks of inferred bounds, is counted in both.
+  enum Category {
+    BTC_Inference,
+    BTC_DeclValidity,
+    BTC_MemberBounds,
+    BTC_NonModifying,
+    BTC_NumCategories
+  };
+
+  /// \brief Times one part of bounds checking while in scope.  It does
+  /// nothing if the report is null, so callers need not check whether
+  /// -fcheckedc-time-report was given.  Recursive uses for the same part
+  /// are timed once, by the outermost region.
+  class Region {
+    BoundsTimeReport *Report;
+    Category Cat;
+
+  public:
+    Region(BoundsTimeReport *Report, Category Cat) : Report(Report), Cat(Cat) {
+      if (Report)
+        Report->start(Cat);
+    }
+    ~Region() {
+      if (Report)
+        Report->stop(Cat);
+    }
+    Region(const Region &) = delete;
+    Region &operator=(const Region &) = delete;
+  };
+
+  /// \brief Create a report.  JSONFile is the file to which the
+  /// per-function numbers are written, or empty.
+  BoundsTimeReport(ASTContext &Context, StringRef JSONFile);
+
+  /// \brief Attribute the times and expression comparisons until the
+  /// matching finishFunction to FD.
+  void startFunction(const FunctionDecl *FD);
+  void finishFunction();
+
+  /// \brief Print the functions that took longest to check to stderr and
+  /// write all of them to the JSON file, if there is one.
+  void emit();
+
+private:
+  struct FunctionTimes {
+    std::string Name;
+    std::string Location;
+    llvm::TimeRecord Total;
+    llvm::TimeRecord Parts[BTC_NumCategories];
+    uint64_t Comparisons = 0;
+  };
+
+  void start(Category Cat);
+  void stop(Category Cat);
+  void writeJSON();
+
+  ASTContext &Context;
+  std::string JSONFile;
+  llvm::TimerGroup Group;
+  llvm::Timer Timers[BTC_NumCategories];
+  unsigned Depths[BTC_NumCategories];
+  llvm::TimeRecord StartTimes[BTC_NumCategories];
+
+  /// \brief The nesting depth of function bodies being checked, and the
+  /// numbers for the outermost one.
+  unsigned FunctionDepth = 0;
+  FunctionTimes Current;
+  llvm::TimeRecord FunctionStart;
+  uint64_t ComparisonsAtStart = 0;
+
+  SmallVector<FunctionTimes, 16> Functions;
+};
+
+} // end namespace sema
+} // end namespace clang
+
+#endif
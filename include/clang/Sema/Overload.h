@@ -746,6 +746,14 @@ namespace clang {
     SmallVector<OverloadCandidate, 16> Candidates;
     llvm::SmallPtrSet<Decl *, 16> Functions;
 
+    /// \brief The conversion sequences formed for the arguments of the
+    /// candidates, keyed by the argument, the parameter type and the flags
+    /// of the conversion. The candidates that share a parameter type (for
+    /// example, the stream of hundreds of 'operator<<' overloads) reuse one
+    /// conversion sequence.
+    llvm::DenseMap<std::pair<Expr *, std::pair<void *, unsigned>>,
+                   ImplicitConversionSequence> ConversionCache;
+
     // Allocator for ConversionSequenceLists. We store the first few of these
     // inline to avoid allocation for small sets.
     llvm::BumpPtrAllocator SlabAllocator;
@@ -806,6 +814,24 @@ namespace clang {
     /// \brief Clear out all of the candidates.
     void clear(CandidateSetKind CSK);
 
+    /// \brief Return the conversion sequence formed earlier for a candidate
+    /// of this set from \p From to \p ToType with the given \p Flags, if any.
+    const ImplicitConversionSequence *
+    getCachedConversion(Expr *From, QualType ToType, unsigned Flags) const {
+      auto Known = ConversionCache.find(
+          std::make_pair(From, std::make_pair(ToType.getAsOpaquePtr(), Flags)));
+      return Known == ConversionCache.end() ? nullptr : &Known->second;
+    }
+
+    /// \brief Remember the conversion sequence formed from \p From to
+    /// \p ToType with the given \p Flags.
+    void cacheConversion(Expr *From, QualType ToType, unsigned Flags,
+                         const ImplicitConversionSequence &ICS) {
+      ConversionCache.insert(std::make_pair(
+          std::make_pair(From, std::make_pair(ToType.getAsOpaquePtr(), Flags)),
+          ICS));
+    }
+
     typedef SmallVectorImpl<OverloadCandidate>::iterator iterator;
     iterator begin() { return Candidates.begin(); }
     iterator end() { return Candidates.end(); }
@@ -53,6 +53,7 @@
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/TinyPtrVector.h"
 #include <deque>
 #include <memory>
@@ -181,6 +182,7 @@ namespace clang {
   class TypedefNameDecl;
   class TypeLoc;
   class TypoCorrectionConsumer;
+  class TypoCorrectionIndex;
   class UnqualifiedId;
   class UnresolvedLookupExpr;
   class UnresolvedMemberExpr;
@@ -197,9 +199,16 @@ namespace clang {
   struct DeductionFailureInfo;
   class TemplateSpecCandidateSet;
 
+namespace analyze_format_string {
+  class ParsedFormatString;
+}
+
 namespace sema {
   class AccessedEntity;
   class BlockScopeInfo;
+  class BoundsCheckCache;
+  class BoundsSummary;
+  class BoundsTimeReport;
   class CapturedRegionScopeInfo;
   class CapturingScopeInfo;
   class CompoundScopeInfo;
@@ -541,6 +550,11 @@ public:
   /// that's used to parse every top-level function.
   SmallVector<sema::FunctionScopeInfo *, 4> FunctionScopes;
 
+  /// \brief Function scopes that were popped and can be reused for nested
+  /// functions, together with the storage their containers allocated.
+  SmallVector<std::unique_ptr<sema::FunctionScopeInfo>, 4>
+      RecycledFunctionScopes;
+
   typedef LazyVector<TypedefNameDecl *, ExternalSemaSource,
                      &ExternalSemaSource::ReadExtVectorDecls, 2, 2>
     ExtVectorDeclsType;
@@ -2025,6 +2039,18 @@ public:
   /// \c constexpr in C++11 or has an 'auto' return type in C++14).
   bool canSkipFunctionBody(Decl *D);
 
+  /// \brief Determine whether the AST of the body of \p FD can be discarded
+  /// once the body is checked, with -fdiscard-function-bodies.
+  ///
+  /// Only the bodies of C functions that are not inline are discarded.  In
+  /// C++, the bodies of inline, constexpr and template functions and of the
+  /// lambdas in them may be needed again later in the translation unit.
+  bool canDiscardFunctionBody(const FunctionDecl *FD) const;
+
+  /// \brief Replace the checked body \p Body of \p FD by an empty compound
+  /// statement, and recycle the storage of its statements.
+  void DiscardFunctionBody(FunctionDecl *FD, Stmt *Body);
+
   void computeNRVO(Stmt *Body, sema::FunctionScopeInfo *Scope);
   Decl *ActOnFinishFunctionBody(Decl *Decl, Stmt *Body);
   Decl *ActOnFinishFunctionBody(Decl *Decl, Stmt *Body, bool IsInstantiation);
@@ -4700,6 +4726,14 @@ public:
 
   BoundsExpr *CheckNonModifyingBounds(BoundsExpr *Bounds, Expr *E);
 
+  /// \brief Whether bounds expressions are non-modifying, remembered by
+  /// CheckIsNonModifying so that the bounds of a declaration, which are
+  /// checked each time bounds are inferred from it, are only walked once.
+  /// Whether an expression is non-modifying doesn't depend on the context,
+  /// which only changes the diagnostics.  The entries are discarded when
+  /// the storage of the expressions of a function body is released.
+  llvm::DenseMap<const BoundsExpr *, bool> NonModifyingBoundsCache;
+
   bool AbstractForFunctionType(BoundsAnnotations &BA,
                                ArrayRef<DeclaratorChunk::ParamInfo> Params);
   /// \brief Take a bounds expression with positional parameters from a function
@@ -4711,9 +4745,45 @@ public:
   /// MemberBase as the base.  Returns a nullptr if there is an error.
   BoundsExpr *MakeMemberBoundsConcrete(Expr *MemberBase, bool IsArrow,
                                        BoundsExpr *Bounds);
+
+  /// \brief How the bounds of a member are made concrete.
+  enum MemberBoundsShape {
+    /// The bounds don't refer to members, so they are concrete already.
+    MBS_NoMembers,
+    /// count(m) or byte_count(m) for a member m, which are built directly.
+    MBS_MemberCount,
+    /// Other bounds, which are rebuilt by a tree transform.
+    MBS_Other
+  };
+
+  /// \brief The shapes of the member bounds made concrete so far, so that
+  /// each member access doesn't walk the bounds of the member.
+  llvm::DenseMap<const BoundsExpr *, MemberBoundsShape> MemberBoundsShapes;
   BoundsExpr *ConcretizeFromFunctionTypeWithArgs(BoundsExpr *Bounds, ArrayRef<Expr *> Args,
                                                  NonModifyingContext ErrorKind);
 
+  /// \brief The bounds of a parameter of a function type that are checked
+  /// for the arguments of calls through the type.
+  struct FunctionParamBounds {
+    /// The bounds of the parameter, in terms of positional parameters.  For
+    /// a parameter with only an interop type, these are the bounds implied
+    /// by the type.  Null if the parameter has neither.
+    BoundsExpr *Bounds;
+    /// Whether Bounds refer to any parameter.  If not, they don't need to
+    /// be concretized with the arguments of a call.
+    bool UsesParams;
+  };
+
+  /// \brief The bounds of the parameters of function types, computed once
+  /// per type instead of once per call.
+  llvm::DenseMap<const FunctionProtoType *,
+                 SmallVector<FunctionParamBounds, 4>> FunctionTypeParamBounds;
+
+  /// \brief Get the bounds of the parameters of FPT.  The result is
+  /// invalidated by the next call.
+  ArrayRef<FunctionParamBounds>
+  GetFunctionTypeParamBounds(const FunctionProtoType *FPT);
+
   /// ConvertToFullyCheckedType: convert an expression E to a fully checked type. This
   /// is used to retype declrefs and member exprs in checked scopes with bounds-safe
   /// interfaces. The Checked C spec that says that such uses in checked scopes shall be 
@@ -4728,6 +4798,48 @@ public:
   /// null.
   Expr *GetArrayPtrDereference(Expr *E, QualType &Result);
 
+  /// \brief The kinds of bounds that are inferred for an expression.
+  enum BoundsInferenceKind {
+    BIK_LValue,
+    BIK_LValueTarget,
+    BIK_RValue
+  };
+
+  /// \brief An expression and the kind of bounds inferred for it, combined
+  /// with whether the null terminator of null-terminated arrays is included.
+  typedef std::pair<const Expr *, unsigned> InferredBoundsKey;
+
+  /// \brief The bounds inferred for expressions while the bounds
+  /// declarations of a function body are checked.  They are discarded at
+  /// the end of CheckFunctionBodyBoundsDecls.
+  llvm::DenseMap<InferredBoundsKey, BoundsExpr *> InferredBoundsCache;
+  bool InferredBoundsCacheEnabled = false;
+
+  /// \brief The storage for bounds expressions that are built while the
+  /// bounds declarations of a function body are checked, and are only
+  /// compared or reported, never attached to the AST.  Examples are the
+  /// expanded declared bounds of variables and parameters.  It is released
+  /// at the end of CheckFunctionBodyBoundsDecls.  TransientBoundsAlloc
+  /// points to it during the check, and is null otherwise, in which case
+  /// these expressions are allocated in the ASTContext.
+  llvm::BumpPtrAllocator TransientBoundsStorage;
+  llvm::BumpPtrAllocator *TransientBoundsAlloc = nullptr;
+
+  /// \brief The time spent checking bounds, kept for
+  /// -fcheckedc-time-report.  Null if the option wasn't given.
+  std::unique_ptr<sema::BoundsTimeReport> BoundsTimer;
+
+  /// \brief The bounds of the arguments of direct calls, recorded as the
+  /// function bodies are checked.  Null unless the CheckedCBoundsSummary
+  /// language option is set, which tools that write bounds summaries do.
+  std::unique_ptr<sema::BoundsSummary> CallBoundsSummary;
+
+  /// \brief The function bodies whose bounds declarations were checked
+  /// without diagnostics in an earlier parse of the translation unit.  It
+  /// is set by an ASTUnit, so that reparses only check the functions that
+  /// changed, and is null otherwise.
+  sema::BoundsCheckCache *BoundsCache = nullptr;
+
   /// InferLValueBounds - infer a bounds expression for an lvalue.
   /// The bounds determine whether the lvalue to which an
   /// expression evaluates in in range.
@@ -7809,6 +7921,10 @@ public:
   /// given location are ignored if typo correction already failed for it.
   IdentifierSourceLocations TypoCorrectionFailures;
 
+  /// \brief An index of the identifiers of the translation unit for typo
+  /// correction, built on the first typo correction.
+  std::unique_ptr<TypoCorrectionIndex> TypoIndex;
+
   /// \brief Worker object for performing CFG-based warnings.
   sema::AnalysisBasedWarnings AnalysisWarnings;
   threadSafety::BeforeSet *ThreadSafetyDeclCache;
@@ -9772,7 +9888,8 @@ public:
 
   /// Rewrite function types with bounds-safe interfaces on unchecked
   /// types to use the checked types specified by the interfaces.  Recursively
-  /// apply the rewrite to function types nested within the type.
+  /// apply the rewrite to function types nested within the type.  The
+  /// rewritten types are cached in the ASTContext.
   QualType RewriteBoundsSafeInterfaceTypes(QualType Ty);
 
   /// \brief Get the bounds-safe interface type for LHS.
@@ -10683,6 +10800,12 @@ public:
 
   bool FormatStringHasSArg(const StringLiteral *FExpr);
 
+  /// The format strings parsed by -Wformat checking, by the kind of parsing
+  /// and their contents, so that a string checked at many calls is parsed once.
+  /// The recorded callbacks point into the contents in the key of each.
+  llvm::StringMap<std::unique_ptr<analyze_format_string::ParsedFormatString>>
+      ParsedFormatStrings;
+
   static bool GetFormatNSStringIdx(const FormatAttr *Format, unsigned &Idx);
 
 private:
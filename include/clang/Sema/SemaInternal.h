@@ -101,6 +101,47 @@ inline InheritableAttr *getDLLAttr(Decl *D) {
   return nullptr;
 }
 
+/// \brief An index of the identifiers of an IdentifierTable by length and by
+/// the characters they contain, which lets typo correction skip the
+/// identifiers that are too different from the typo without computing their
+/// edit distance from it.
+///
+/// The index is built on its first use, and then records the identifiers
+/// that the table creates.
+class TypoCorrectionIndex {
+public:
+  explicit TypoCorrectionIndex(IdentifierTable &Idents) : Idents(Idents) {}
+  ~TypoCorrectionIndex();
+  TypoCorrectionIndex(const TypoCorrectionIndex &) = delete;
+  TypoCorrectionIndex &operator=(const TypoCorrectionIndex &) = delete;
+
+  /// \brief Call \p Found with the name of each identifier that may differ
+  /// from \p Typo in length by at most \p MaxLengthDifference, and by an edit
+  /// distance of at most \p MaxEditDistance.
+  void findCandidates(StringRef Typo, unsigned MaxLengthDifference,
+                      unsigned MaxEditDistance,
+                      llvm::function_ref<void(StringRef)> Found);
+
+private:
+  struct Entry {
+    const IdentifierInfo *II;
+    /// The characters of the identifier, hashed into 64 bits.
+    uint64_t Chars;
+  };
+
+  static uint64_t getCharMask(StringRef Name);
+  void add(const IdentifierInfo *II);
+
+  IdentifierTable &Idents;
+  bool Built = false;
+
+  /// \brief The identifiers the table created since the index was updated.
+  SmallVector<IdentifierInfo *, 16> Created;
+
+  /// \brief The identifiers of each length.
+  std::vector<std::vector<Entry>> ByLength;
+};
+
 class TypoCorrectionConsumer : public VisibleDeclConsumer {
   typedef SmallVector<TypoCorrection, 1> TypoResultList;
   typedef llvm::StringMap<TypoResultList> TypoResultsMap;
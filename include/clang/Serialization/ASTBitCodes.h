@@ -259,6 +259,12 @@ namespace clang {
       /// These records should not change the \a ASTFileSignature.  See \a
       /// UnhashedControlBlockRecordTypes for the list of records.
       UNHASHED_CONTROL_BLOCK_ID,
+
+      /// \brief A block holding the bounds inferred for a Checked C bounds
+      /// check, written among the statements of the DECLTYPES block.  The
+      /// reader skips it with the enclosing statement; the bounds are
+      /// loaded when they are first used.
+      CHECKEDC_BOUNDS_BLOCK_ID,
     };
 
     /// \brief Record types that occur within the control block.
@@ -347,7 +353,10 @@ namespace clang {
     /// inside the control block.
     enum InputFileRecordTypes {
       /// \brief An input file.
-      INPUT_FILE = 1
+      INPUT_FILE = 1,
+
+      /// \brief The hash of the contents of the input file that precedes it.
+      INPUT_FILE_HASH
     };
 
     /// \brief Record types that occur within the AST block itself.
@@ -31,6 +31,7 @@
 #include "clang/Serialization/Module.h"
 #include "clang/Serialization/ModuleFileExtension.h"
 #include "clang/Serialization/ModuleManager.h"
+#include "clang/Serialization/PagedVector.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallSet.h"
@@ -422,6 +423,24 @@ private:
   /// \brief A timer used to track the time spent deserializing.
   std::unique_ptr<llvm::Timer> ReadTimer;
 
+  /// \brief The content hashes of the input files that the build system
+  /// knows to be unchanged, by path, from the AST input files manifest.
+  llvm::StringMap<uint64_t> TrustedInputFileHashes;
+
+  /// \brief Whether the AST input files manifest has been read.
+  bool ReadInputFilesManifest = false;
+
+  /// \brief If non-null, the group of the timers that track the time spent
+  /// loading each module file.
+  llvm::TimerGroup *ModuleLoadTimerGroup = nullptr;
+
+  /// \brief The timers that track the time spent loading each module file.
+  std::vector<std::unique_ptr<llvm::Timer>> ModuleLoadTimers;
+
+  /// \brief The timers of the module files that are being loaded, innermost
+  /// last.  Only the innermost one is running.
+  SmallVector<llvm::Timer *, 4> ActiveModuleLoadTimers;
+
   /// \brief The location where the module file will be considered as
   /// imported from. For non-module AST types it should be invalid.
   SourceLocation CurrentImportLoc;
@@ -446,7 +465,7 @@ private:
   ///
   /// When the pointer at index I is non-NULL, the type with
   /// ID = (I + 1) << FastQual::Width has already been loaded
-  std::vector<QualType> TypesLoaded;
+  PagedVector<QualType> TypesLoaded;
 
   typedef ContinuousRangeMap<serialization::TypeID, ModuleFile *, 4>
     GlobalTypeMapType;
@@ -460,7 +479,7 @@ private:
   ///
   /// When the pointer at index I is non-NULL, the declaration with ID
   /// = I + 1 has already been loaded.
-  std::vector<Decl *> DeclsLoaded;
+  PagedVector<Decl *> DeclsLoaded;
 
   typedef ContinuousRangeMap<serialization::DeclID, ModuleFile *, 4>
     GlobalDeclMapType;
@@ -567,6 +586,12 @@ private:
   /// \brief Functions or methods that have bodies that will be attached.
   PendingBodiesMap PendingBodies;
 
+  /// \brief The bounds expressions and interop types of function types read
+  /// so far, keyed by the global offset of their CHECKEDC_BOUNDS_BLOCK.
+  /// Function types that the writer found to share structurally equal
+  /// annotations share them after reading too.
+  llvm::DenseMap<uint64_t, Expr *> SharedBoundsExprs;
+
   /// \brief Definitions for which we have added merged definitions but not yet
   /// performed deduplication.
   llvm::SetVector<NamedDecl*> PendingMergedDefinitionsToDeduplicate;
@@ -586,7 +611,7 @@ private:
   /// If the pointer at index I is non-NULL, then it refers to the
   /// IdentifierInfo for the identifier with ID=I+1 that has already
   /// been loaded.
-  std::vector<IdentifierInfo *> IdentifiersLoaded;
+  PagedVector<IdentifierInfo *> IdentifiersLoaded;
 
   typedef ContinuousRangeMap<serialization::IdentID, ModuleFile *, 4>
     GlobalIdentifierMapType;
@@ -919,6 +944,18 @@ private:
   /// in the chain.
   unsigned TotalNumStatements = 0;
 
+  /// \brief The offsets of the function and method bodies that have been
+  /// attached lazily to a declaration, and not yet de-serialized.
+  llvm::DenseSet<uint64_t> LazyFunctionBodies;
+
+  /// \brief The number of function and method bodies de-serialized from
+  /// the chain.
+  unsigned NumFunctionBodiesRead = 0;
+
+  /// \brief The number of function and method bodies that have been
+  /// attached lazily to a declaration.
+  unsigned NumLazyFunctionBodies = 0;
+
   /// \brief The number of macros de-serialized from the chain.
   unsigned NumMacrosRead = 0;
 
@@ -1148,11 +1185,25 @@ private:
     bool Overridden;
     bool Transient;
     bool TopLevelModuleMap;
+    bool HasContentHash;
+    uint64_t ContentHash;
   };
 
   /// \brief Reads the stored information about an input file.
   InputFileInfo readInputFileInfo(ModuleFile &F, unsigned ID);
 
+  /// \brief Determine whether the AST input files manifest vouches for the
+  /// stored contents of the given input file.
+  bool isInputFileTrusted(const InputFileInfo &FI);
+
+  /// \brief Read the AST input files manifest into
+  /// \c TrustedInputFileHashes.
+  void readInputFilesManifest();
+
+  /// \brief Determine whether the contents of \p File still have the hash
+  /// that is stored for it.
+  bool hasStoredContents(const FileEntry *File, const InputFileInfo &FI);
+
   /// \brief Retrieve the file entry and 'overridden' bit for an input
   /// file in the given module file.
   serialization::InputFile getInputFile(ModuleFile &F, unsigned ID,
@@ -1547,6 +1598,12 @@ public:
   void setDeserializationListener(ASTDeserializationListener *Listener,
                                   bool TakeOwnership = false);
 
+  /// \brief Track the time spent loading each module file, excluding the
+  /// module files that it imports, in the timer group \p TG.
+  void setModuleLoadTimerGroup(llvm::TimerGroup *TG) {
+    ModuleLoadTimerGroup = TG;
+  }
+
   /// \brief Determine whether this AST reader has a global index.
   bool hasGlobalIndex() const { return (bool)GlobalIndex; }
 
@@ -2179,6 +2236,17 @@ public:
   /// \brief Reads bounds annotations
   BoundsAnnotations ReadBoundsAnnotations(ModuleFile &F);
 
+  /// \brief Reads the bounds annotations of a function type, which refer to
+  /// bounds expressions shared with other function types.
+  BoundsAnnotations ReadSharedBoundsAnnotations(ModuleFile &F,
+                                                const RecordData &Record,
+                                                unsigned &Idx);
+
+  /// \brief Reads the shared bounds expression or interop type whose
+  /// CHECKEDC_BOUNDS_BLOCK is at \p LocalOffset in \p F, or returns the one
+  /// read before from there.
+  Expr *ReadSharedBoundsExpr(ModuleFile &F, uint64_t LocalOffset);
+
   /// \brief Reads a sub-statement operand during statement reading.
   Stmt *ReadSubStmt() {
     assert(ReadingKind == Read_Stmt &&
@@ -23,10 +23,12 @@
 #include "clang/Serialization/ASTDeserializationListener.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Bitcode/BitstreamWriter.h"
+#include <map>
 #include <queue>
 #include <vector>
 
@@ -194,7 +196,8 @@ private:
   /// the declaration's ID.
   std::vector<serialization::DeclOffset> DeclOffsets;
 
-  /// \brief Sorted (by file offset) vector of pairs of file offset/DeclID.
+  /// \brief Vector of pairs of file offset/DeclID, sorted by file offset when
+  /// the file-level declarations are written.
   typedef SmallVector<std::pair<unsigned, serialization::DeclID>, 64>
     LocDeclIDsTy;
   struct DeclIDInFileInfo {
@@ -275,6 +278,20 @@ private:
   /// just after the stmt record.
   llvm::DenseMap<Stmt *, uint64_t> SubStmtEntries;
 
+  /// \brief True while writing a CHECKEDC_BOUNDS_BLOCK, where the
+  /// abbreviations of the DECLTYPES block are not available.
+  bool WritingBoundsBlock = false;
+
+  /// \brief Offsets of the CHECKEDC_BOUNDS_BLOCKs already written.  Bounds
+  /// shared by several bounds checks are written once.
+  llvm::DenseMap<Expr *, uint64_t> BoundsBlockOffsets;
+
+  /// \brief Offsets of the CHECKEDC_BOUNDS_BLOCKs written for the bounds
+  /// annotations of function types, keyed by the profile of the bounds
+  /// expression or interop type.  The annotations are abstracted over the
+  /// parameters, so checked interfaces that look alike share one block.
+  std::map<llvm::FoldingSetNodeID, uint64_t> SharedBoundsBlocks;
+
   /// @}
 
   /// \brief Offsets of each of the identifier IDs into the identifier
@@ -431,6 +448,15 @@ private:
   /// \brief Write the given subexpression to the bitstream.
   void WriteSubStmt(Stmt *S);
 
+  /// \brief Write a bounds expression or interop type in a block of its
+  /// own, so that it can be loaded lazily or shared, and return its offset.
+  uint64_t WriteBoundsBlock(Expr *E);
+
+  /// \brief Write the bounds expression or interop type of a function type
+  /// in a block shared with the structurally equal ones, and return the
+  /// block's offset, or 0 if \p E is null.
+  uint64_t WriteSharedBoundsBlock(Expr *E);
+
   void WriteBlockInfoBlock();
   void WriteControlBlock(Preprocessor &PP, ASTContext &Context,
                          StringRef isysroot, const std::string &OutputFile);
@@ -505,6 +531,11 @@ private:
   unsigned CharacterLiteralAbbrev = 0;
   unsigned IntegerLiteralAbbrev = 0;
   unsigned ExprImplicitCastAbbrev = 0;
+  unsigned ExprBinaryOperatorAbbrev = 0;
+  unsigned ExprCallAbbrev = 0;
+  unsigned ExprCountBoundsAbbrev = 0;
+  unsigned ExprNullaryBoundsAbbrev = 0;
+  unsigned ExprRangeBoundsAbbrev = 0;
 
   void WriteDeclAbbrevs();
   void WriteDecl(ASTContext &Context, Decl *D);
@@ -668,6 +699,15 @@ public:
   unsigned getCharacterLiteralAbbrev() const { return CharacterLiteralAbbrev; }
   unsigned getIntegerLiteralAbbrev() const { return IntegerLiteralAbbrev; }
   unsigned getExprImplicitCastAbbrev() const { return ExprImplicitCastAbbrev; }
+  unsigned getExprBinaryOperatorAbbrev() const {
+    return ExprBinaryOperatorAbbrev;
+  }
+  unsigned getExprCallAbbrev() const { return ExprCallAbbrev; }
+  unsigned getExprCountBoundsAbbrev() const { return ExprCountBoundsAbbrev; }
+  unsigned getExprNullaryBoundsAbbrev() const {
+    return ExprNullaryBoundsAbbrev;
+  }
+  unsigned getExprRangeBoundsAbbrev() const { return ExprRangeBoundsAbbrev; }
 
   bool hasChain() const { return Chain; }
   ASTReader *getChain() const { return Chain; }
@@ -812,8 +852,22 @@ public:
     StmtsToEmit.push_back(S);
   }
 
+  /// \brief Write the bounds of a bounds check right away, in a block that
+  /// readers of the enclosing statement skip, and add their offset to the
+  /// record.  The reader loads the bounds only when they are asked for.
+  void AddLazyBoundsExpr(BoundsExpr *B) {
+    Record->push_back(Writer->WriteBoundsBlock(B));
+  }
+
   void AddBoundsAnnotations(BoundsAnnotations BA);
 
+  /// \brief Emit the bounds annotations of a function type, sharing their
+  /// expressions with the structurally equal annotations of other types.
+  void AddSharedBoundsAnnotations(BoundsAnnotations BA) {
+    Record->push_back(Writer->WriteSharedBoundsBlock(BA.getBoundsExpr()));
+    Record->push_back(Writer->WriteSharedBoundsBlock(BA.getInteropTypeExpr()));
+  }
+
   /// \brief Add a definition for the given function to the queue of statements
   /// to emit.
   void AddFunctionDefinition(const FunctionDecl *FD);
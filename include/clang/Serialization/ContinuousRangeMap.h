@@ -32,6 +32,12 @@ namespace clang {
 ///
 /// Ranges must be inserted in order. Inserting a new stop I4 into the map will
 /// shrink the fourth range to I3 to I4 and add the new range I4 to inf.
+///
+/// Lookups are on the path of every deserialization, and the maps of an AST
+/// file that imports many modules have many ranges. The keys are therefore
+/// also stored on their own, so that a binary search touches few cache lines,
+/// and each lookup first tries the range found by the previous one, which
+/// makes runs of lookups in the same range constant time.
 template <typename Int, typename V, unsigned InitialCapacity>
 class ContinuousRangeMap {
 public:
@@ -45,6 +51,20 @@ private:
   typedef SmallVector<value_type, InitialCapacity> Representation;
   Representation Rep;
 
+  /// \brief The keys of \c Rep, in the same order.
+  SmallVector<Int, InitialCapacity> Keys;
+
+  /// \brief The index of the range found by the last lookup.
+  mutable unsigned LastFound = 0;
+
+  void rebuildKeys() {
+    Keys.clear();
+    Keys.reserve(Rep.size());
+    for (const_reference Val : Rep)
+      Keys.push_back(Val.first);
+    LastFound = 0;
+  }
+
   struct Compare {
     bool operator ()(const_reference L, Int R) const {
       return L.first < R;
@@ -68,16 +88,20 @@ public:
     assert((Rep.empty() || Rep.back().first < Val.first) &&
            "Must insert keys in order.");
     Rep.push_back(Val);
+    Keys.push_back(Val.first);
   }
   
   void insertOrReplace(const value_type &Val) {
-    iterator I = std::lower_bound(Rep.begin(), Rep.end(), Val, Compare());
+    auto K = std::lower_bound(Keys.begin(), Keys.end(), Val.first);
+    iterator I = Rep.begin() + (K - Keys.begin());
     if (I != Rep.end() && I->first == Val.first) {
       I->second = Val.second;
       return;
     }
     
     Rep.insert(I, Val);
+    Keys.insert(K, Val.first);
+    LastFound = 0;
   }
 
   typedef typename Representation::iterator iterator;
@@ -89,13 +113,22 @@ public:
   const_iterator end() const { return Rep.end(); }
 
   iterator find(Int K) {
-    iterator I = std::upper_bound(Rep.begin(), Rep.end(), K, Compare());
-    // I points to the first entry with a key > K, which is the range that
-    // follows the one containing K.
-    if (I == Rep.begin())
+    unsigned N = Keys.size();
+    // Try the range found by the last lookup, then the one that follows it.
+    if (LastFound < N && !(K < Keys[LastFound])) {
+      if (LastFound + 1 == N || K < Keys[LastFound + 1])
+        return Rep.begin() + LastFound;
+      if (LastFound + 2 == N || K < Keys[LastFound + 2])
+        return Rep.begin() + ++LastFound;
+    }
+
+    auto I = std::upper_bound(Keys.begin(), Keys.end(), K);
+    // I points to the first key > K, which starts the range that follows the
+    // one containing K.
+    if (I == Keys.begin())
       return Rep.end();
-    --I;
-    return I;
+    LastFound = I - Keys.begin() - 1;
+    return Rep.begin() + LastFound;
   }
   const_iterator find(Int K) const {
     return const_cast<ContinuousRangeMap*>(this)->find(K);
@@ -117,14 +150,17 @@ public:
     
     ~Builder() {
       std::sort(Self.Rep.begin(), Self.Rep.end(), Compare());
-      std::unique(Self.Rep.begin(), Self.Rep.end(),
-                  [](const_reference A, const_reference B) {
-        // FIXME: we should not allow any duplicate keys, but there are a lot of
-        // duplicate 0 -> 0 mappings to remove first.
-        assert((A == B || A.first != B.first) &&
-               "ContinuousRangeMap::Builder given non-unique keys");
-        return A == B;
-      });
+      Self.Rep.erase(
+          std::unique(Self.Rep.begin(), Self.Rep.end(),
+                      [](const_reference A, const_reference B) {
+            // FIXME: we should not allow any duplicate keys, but there are a
+            // lot of duplicate 0 -> 0 mappings to remove first.
+            assert((A == B || A.first != B.first) &&
+                   "ContinuousRangeMap::Builder given non-unique keys");
+            return A == B;
+          }),
+          Self.Rep.end());
+      Self.rebuildKeys();
     }
     
     void insert(const value_type &Val) {
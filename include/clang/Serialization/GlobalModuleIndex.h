@@ -10,7 +10,8 @@
 // This file defines the GlobalModuleIndex class, which manages a global index
 // containing all of the identifiers known to the various modules within a given
 // subdirectory of the module cache. It is used to improve the performance of
-// queries such as "do any modules know about this identifier?"
+// queries such as "do any modules know about this identifier?" and "can this
+// module know about this name?"
 //
 //===----------------------------------------------------------------------===//
 #ifndef LLVM_CLANG_SERIALIZATION_GLOBALMODULEINDEX_H
@@ -72,7 +73,7 @@ class GlobalModuleIndex {
 
   /// \brief Information about a given module file.
   struct ModuleInfo {
-    ModuleInfo() : File(), Size(), ModTime() { }
+    ModuleInfo() : File(), Size(), ModTime(), NumNameFilterHashes() { }
 
     /// \brief The module file, once it has been resolved.
     ModuleFile *File;
@@ -90,6 +91,15 @@ class GlobalModuleIndex {
     /// \brief The module IDs on which this module directly depends.
     /// FIXME: We don't really need a vector here.
     llvm::SmallVector<unsigned, 4> Dependencies;
+
+    /// \brief A bloom filter of the names known to this module file and to
+    /// the module files on which it depends, or empty if the index has no
+    /// filter for this module file.
+    StringRef NameFilter;
+
+    /// \brief The number of bits of the name filter that are set for each
+    /// name.
+    unsigned NumNameFilterHashes;
   };
 
   /// \brief A mapping from module IDs to information about each module.
@@ -115,6 +125,12 @@ class GlobalModuleIndex {
   /// \brief The number of identifier lookup hits, where we recognize the
   /// identifier.
   unsigned NumIdentifierLookupHits;
+
+  /// \brief The number of queries of the name filter of a module file.
+  unsigned NumNameFilterLookups;
+
+  /// \brief The number of name filter queries that ruled out a module file.
+  unsigned NumNameFilterRejections;
   
   /// \brief Internal constructor. Use \c readIndex() to read an index.
   explicit GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
@@ -179,6 +195,27 @@ public:
   /// \returns true if the identifier is known to the index, false otherwise.
   bool lookupIdentifier(StringRef Name, HitSet &Hits);
 
+  /// \brief Determine whether the given module file may have information
+  /// about the given name, according to its name filter.
+  ///
+  /// Unlike the identifier index, which only knows about the identifiers
+  /// that are interesting to identifier lookup, the name filter covers every
+  /// identifier that the module file and the module files on which it
+  /// depends know about, including the names of C++ declarations, macros,
+  /// and selector pieces.  It can return false positives, but never false
+  /// negatives.
+  ///
+  /// \returns false if \p File provably has no information about \p Name,
+  /// true otherwise, including when \p File is not known to the index.
+  bool mayContainName(ModuleFile *File, StringRef Name);
+
+  /// \brief Look for all of the module files that may have information about
+  /// the given name, according to their name filters.
+  ///
+  /// \param Hits Will be populated with the set of module files whose name
+  /// filter accepts this name, and the module files that have no filter.
+  void lookupName(StringRef Name, HitSet &Hits);
+
   /// \brief Note that the given module file has been loaded.
   ///
   /// \returns false if the global module index has information about this
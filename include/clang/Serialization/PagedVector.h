@@ -0,0 +1,90 @@
+//===--- PagedVector.h - Vector allocated one page at a time ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines the PagedVector class, which is a vector whose storage
+//  is only allocated for the pages of elements that are accessed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SERIALIZATION_PAGEDVECTOR_H
+#define LLVM_CLANG_SERIALIZATION_PAGEDVECTOR_H
+
+#include "clang/Basic/LLVM.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace clang {
+
+/// \brief A vector of value-initialized elements whose storage is allocated
+/// one page at a time, on the first access to an element of the page.
+///
+/// The AST reader keeps one entry per type, declaration and identifier of
+/// each loaded AST file, most of which are never deserialized.  Resizing a
+/// PagedVector does not touch the elements, so the cost of loading an AST
+/// file does not depend on the number of entities that it contains, and the
+/// references to the elements stay valid when the vector grows.
+template <typename T, unsigned PageSize = 1024>
+class PagedVector {
+  static_assert(PageSize > 0, "empty pages");
+
+  std::vector<std::unique_ptr<T[]>> Pages;
+  size_t Size = 0;
+
+public:
+  size_t size() const { return Size; }
+  bool empty() const { return Size == 0; }
+
+  /// \brief Resize the vector to \p NewSize elements.  The new elements are
+  /// value-initialized.
+  void resize(size_t NewSize) {
+    if (NewSize < Size) {
+      // Reset the elements that remain in the last page, so that they are
+      // value-initialized again if the vector grows.
+      size_t NumPages = (NewSize + PageSize - 1) / PageSize;
+      if (NumPages && Pages[NumPages - 1])
+        for (size_t I = NewSize; I != NumPages * PageSize; ++I)
+          Pages[NumPages - 1][I % PageSize] = T();
+      Pages.resize(NumPages);
+    } else {
+      Pages.resize((NewSize + PageSize - 1) / PageSize);
+    }
+    Size = NewSize;
+  }
+
+  T &operator[](size_t Index) {
+    assert(Index < Size && "index out of range");
+    std::unique_ptr<T[]> &Page = Pages[Index / PageSize];
+    if (!Page)
+      Page.reset(new T[PageSize]());
+    return Page[Index % PageSize];
+  }
+
+  /// \brief Return the number of elements that differ from a
+  /// value-initialized element, without allocating any page.
+  size_t countNonDefault() const {
+    size_t Count = 0;
+    for (size_t P = 0, E = Pages.size(); P != E; ++P) {
+      if (!Pages[P])
+        continue;
+      size_t Begin = P * PageSize;
+      size_t End = std::min(Begin + PageSize, Size);
+      for (size_t I = Begin; I != End; ++I)
+        if (!(Pages[P][I - Begin] == T()))
+          ++Count;
+    }
+    return Count;
+  }
+};
+
+} // end namespace clang
+
+#endif
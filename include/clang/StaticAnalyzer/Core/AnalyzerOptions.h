@@ -139,6 +139,10 @@ public:
   AnalysisPurgeMode AnalysisPurgeOpt;
   
   std::string AnalyzeSpecificFunction;
+
+  /// \brief The directory recording the functions whose analysis produced no
+  /// reports, which are skipped while they do not change.
+  std::string IncrementalCacheDir;
   
   /// \brief The maximum number of times the analyzer visits a block.
   unsigned maxBlockVisitOnPath;
@@ -155,6 +159,11 @@ public:
   unsigned ShowEnabledCheckerList : 1;
   unsigned AnalyzeAll : 1;
   unsigned AnalyzerDisplayProgress : 1;
+
+  /// \brief Print the names of the functions to analyze instead of analyzing
+  /// them.
+  unsigned AnalyzerListFunctions : 1;
+
   unsigned AnalyzeNestedBlocks : 1;
 
   /// \brief The flag regulates if we should eagerly assume evaluations of
@@ -173,6 +182,9 @@ public:
   unsigned visualizeExplodedGraphWithUbiGraph : 1;
   unsigned UnoptimizedCFG : 1;
   unsigned PrintStats : 1;
+
+  /// \brief Print the resources used by each checker callback.
+  unsigned PrintCheckerStats : 1;
   
   /// \brief Do not re-analyze paths leading to exhausted nodes with a different
   /// strategy. We get better code coverage when retry is enabled.
@@ -263,6 +275,9 @@ private:
   /// \sa getGraphTrimInterval
   Optional<unsigned> GraphTrimInterval;
 
+  /// \sa shouldTrimGraphAggressively
+  Optional<bool> GraphTrimAggressive;
+
   /// \sa getMaxTimesInlineLarge
   Optional<unsigned> MaxTimesInlineLarge;
 
@@ -272,6 +287,9 @@ private:
   /// \sa getMaxNodesPerTopLevelFunction
   Optional<unsigned> MaxNodesPerTopLevelFunction;
 
+  /// \sa getNumAnalysisJobs
+  Optional<unsigned> NumAnalysisJobs;
+
   /// \sa shouldInlineLambdas
   Optional<bool> InlineLambdas;
 
@@ -281,9 +299,15 @@ private:
   /// \sa shouldUnrollLoops
   Optional<bool> UnrollLoops;
 
+  /// \sa shouldMergeStates
+  Optional<bool> MergeStates;
+
   /// \sa shouldDisplayNotesAsEvents
   Optional<bool> DisplayNotesAsEvents;
 
+  /// \sa shouldUseCallSummaries
+  Optional<bool> UseCallSummaries;
+
   /// A helper function that retrieves option for a given full-qualified
   /// checker name.
   /// Options for checkers can be specified via 'analyzer-config' command-line
@@ -546,6 +570,13 @@ public:
   /// node reclamation, set the option to "0".
   unsigned getGraphTrimInterval();
 
+  /// Returns true if the recycled nodes should include the nodes that purge
+  /// dead symbols before each statement. Path diagnostics do not rely on
+  /// these nodes, but they are tagged, so they are kept by default.
+  ///
+  /// This is controlled by the 'graph-trim-aggressive' config option.
+  bool shouldTrimGraphAggressively();
+
   /// Returns the maximum times a large function could be inlined.
   ///
   /// This is controlled by the 'max-times-inline-large' config option.
@@ -565,6 +596,12 @@ public:
   /// This is controlled by the 'max-nodes' config option.
   unsigned getMaxNodesPerTopLevelFunction();
 
+  /// Returns the number of processes that analyze the top level functions of
+  /// the translation unit at once. 1 is default.
+  ///
+  /// This is controlled by the 'jobs' config option.
+  unsigned getNumAnalysisJobs();
+
   /// Returns true if lambdas should be inlined. Otherwise a sink node will be
   /// generated each time a LambdaExpr is visited.
   bool shouldInlineLambdas();
@@ -577,6 +614,21 @@ public:
   /// This is controlled by the 'unroll-loops' config option.
   bool shouldUnrollLoops();
 
+  /// Returns true if the paths reaching a block from several predecessors
+  /// should be merged when their states only differ in the constraints on
+  /// their symbols. This loses precision, as the merged constraints are
+  /// widened to cover both paths.
+  /// This is controlled by the 'merge-states' config option.
+  bool shouldMergeStates();
+
+  /// Returns true if the calls to C functions that are not inlined should be
+  /// evaluated with a summary of the body of the callee, instead of
+  /// invalidating all the memory the callee could reach. The summary tells
+  /// whether the callee writes memory that outlives the call, and the
+  /// constants it returns.
+  /// This is controlled by the 'call-summaries' config option.
+  bool shouldUseCallSummaries();
+
   /// Returns true if the bug reporter should transparently treat extra note
   /// diagnostic pieces as event diagnostic pieces. Useful when the diagnostic
   /// consumer doesn't support the extra note pieces.
@@ -596,6 +648,7 @@ public:
     ShowEnabledCheckerList(0),
     AnalyzeAll(0),
     AnalyzerDisplayProgress(0),
+    AnalyzerListFunctions(0),
     AnalyzeNestedBlocks(0),
     eagerlyAssumeBinOpBifurcation(0),
     TrimGraph(0),
@@ -603,6 +656,7 @@ public:
     visualizeExplodedGraphWithUbiGraph(0),
     UnoptimizedCFG(0),
     PrintStats(0),
+    PrintCheckerStats(0),
     NoRetryExhausted(0),
     // Cap the stack depth at 4 calls (5 stack frames, base + 4 calls).
     InlineMaxStackDepth(5),
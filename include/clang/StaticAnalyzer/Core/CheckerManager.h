@@ -20,6 +20,7 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/Store.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Timer.h"
 #include <utility>
 #include <vector>
 
@@ -107,7 +108,8 @@ class CheckerManager {
 
 public:
   CheckerManager(const LangOptions &langOpts, AnalyzerOptions &AOptions)
-      : LangOpts(langOpts), AOptions(AOptions) {}
+      : LangOpts(langOpts), AOptions(AOptions),
+        CollectCheckerStats(AOptions.PrintCheckerStats) {}
 
   ~CheckerManager();
 
@@ -390,6 +392,32 @@ public:
   void runCheckersForPrintState(raw_ostream &Out, ProgramStateRef State,
                                 const char *NL, const char *Sep);
 
+//===----------------------------------------------------------------------===//
+// Statistics of the checker callbacks.
+//===----------------------------------------------------------------------===//
+
+  /// \brief The resources used by a callback of a checker.
+  struct CheckerCallbackStats {
+    /// The number of nodes the callback was run on.
+    uint64_t Calls = 0;
+    /// The number of nodes the callback added to the exploded graph.
+    uint64_t Nodes = 0;
+    /// The time spent and the memory allocated by the callback.
+    llvm::TimeRecord Time;
+  };
+
+  /// \brief Returns the statistics of \p Callback of \p Checker, or null if
+  /// they are not collected, which they are with -analyzer-checker-stats.
+  CheckerCallbackStats *getCheckerStats(const CheckerBase *Checker,
+                                        StringRef Callback) {
+    if (!CollectCheckerStats)
+      return nullptr;
+    return &CheckerStats[std::make_pair(Checker, Callback)];
+  }
+
+  /// \brief Print the statistics of the checker callbacks, as JSON.
+  void printCheckerStats(raw_ostream &Out) const;
+
 //===----------------------------------------------------------------------===//
 // Internal registration functions for AST traversing.
 //===----------------------------------------------------------------------===//
@@ -625,6 +653,11 @@ private:
   
   typedef llvm::DenseMap<EventTag, EventInfo> EventsTy;
   EventsTy Events;
+
+  bool CollectCheckerStats;
+  llvm::DenseMap<std::pair<const CheckerBase *, StringRef>,
+                 CheckerCallbackStats>
+      CheckerStats;
 };
 
 } // end ento namespace
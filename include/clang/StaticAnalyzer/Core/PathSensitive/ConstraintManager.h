@@ -151,6 +151,17 @@ public:
 
   virtual void EndPath(ProgramStateRef state) {}
 
+  /// \brief Returns a state whose constraints admit the values of the symbols
+  /// in both \p Old and \p New, or null if the states differ in something
+  /// other than their constraints.
+  ///
+  /// The joined state may admit values that neither state does, so paths
+  /// continuing from it may be infeasible. If the joined state is \p Old, the
+  /// constraints of \p New are already covered by it.
+  virtual ProgramStateRef joinStates(ProgramStateRef Old, ProgramStateRef New) {
+    return nullptr;
+  }
+
   /// Convenience method to query the state to see if a symbol is null or
   /// not null, or if neither assumption can be made.
   ConditionTruthVal isNull(ProgramStateRef State, SymbolRef Sym) {
@@ -284,6 +284,9 @@ protected:
   /// Counter to determine when to reclaim nodes.
   unsigned ReclaimCounter;
 
+  /// The tag of the nodes purging dead symbols that may be reclaimed, if any.
+  const ProgramPointTag *ReclaimablePurgeTag;
+
 public:
 
   /// \brief Retrieve the node associated with a (Location,State) pair,
@@ -385,9 +388,12 @@ public:
        InterExplodedGraphMap *InverseMap = nullptr) const;
 
   /// Enable tracking of recently allocated nodes for potential reclamation
-  /// when calling reclaimRecentlyAllocatedNodes().
-  void enableNodeReclamation(unsigned Interval) {
+  /// when calling reclaimRecentlyAllocatedNodes(). The PreStmtPurgeDeadSymbols
+  /// nodes tagged with \p PurgeTag are reclaimed as well.
+  void enableNodeReclamation(unsigned Interval,
+                             const ProgramPointTag *PurgeTag = nullptr) {
     ReclaimCounter = ReclaimNodeInterval = Interval;
+    ReclaimablePurgeTag = PurgeTag;
   }
 
   /// Reclaim "uninteresting" nodes created since the last time this method
@@ -84,6 +84,11 @@ private:
   /// Whether or not GC is enabled in this analysis.
   bool ObjCGCEnabled;
 
+  /// The state that the paths reaching each join point were merged into,
+  /// when states are merged.
+  llvm::DenseMap<std::pair<const CFGBlock *, const LocationContext *>,
+                 ProgramStateRef> JoinedStates;
+
   /// The BugReporter associated with this engine.  It is important that
   ///  this object be placed at the very end of member variables so that its
   ///  destructor is called before the rest of the ExprEngine is destroyed.
@@ -474,6 +479,10 @@ public:
   std::pair<const ProgramPointTag *, const ProgramPointTag*>
     geteagerlyAssumeBinOpBifurcationTags();
 
+  /// Returns the tag of the nodes with the state cleaned up from dead
+  /// bindings and symbols.
+  static const ProgramPointTag *getCleanupNodeTag();
+
   SVal evalMinus(SVal X) {
     return X.isValid() ? svalBuilder.evalMinus(X.castAs<NonLoc>()) : X;
   }
@@ -19,7 +19,9 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/Optional.h"
+#include "llvm/ADT/APSInt.h"
 #include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/SmallVector.h"
 #include <deque>
 
 namespace clang {
@@ -29,6 +31,20 @@ typedef std::deque<Decl*> SetOfDecls;
 typedef llvm::DenseSet<const Decl*> SetOfConstDecls;
 
 class FunctionSummariesTy {
+public:
+  /// The effects of a call to a function, as far as they are known from the
+  /// body of the function without analyzing it.
+  struct CallSummary {
+    /// True if the function writes no memory that outlives the call, and
+    /// returns no pointer.
+    bool HasNoSideEffects = false;
+
+    /// The values returned by the function, sorted and unique, if all of
+    /// them are integer constants.
+    SmallVector<llvm::APSInt, 4> ReturnValues;
+  };
+
+private:
   class FunctionSummary {
   public:
     /// Marks the IDs of the basic blocks visited during the analyzes.
@@ -56,6 +72,8 @@ class FunctionSummariesTy {
   typedef llvm::DenseMap<const Decl *, FunctionSummary> MapTy;
   MapTy Map;
 
+  llvm::DenseMap<const FunctionDecl *, CallSummary> CallSummaries;
+
 public:
   MapTy::iterator findOrInsertSummary(const Decl *D) {
     MapTy::iterator I = Map.find(D);
@@ -130,6 +148,11 @@ public:
     return 0;
   }
 
+  /// Get the summary of the calls to \p FD, which must be a C function with
+  /// a body. The summary is computed from the body the first time it is
+  /// requested; recursive functions are taken to have side effects.
+  const CallSummary &getCallSummary(const FunctionDecl *FD);
+
   unsigned getTotalNumBasicBlocks();
   unsigned getTotalNumVisitedBasicBlocks();
 
@@ -34,6 +34,18 @@ enum ChangeKind {
   UpdateMove // Same as Move plus Update.
 };
 
+/// How the nodes of the two trees are matched.
+enum class MatchingMode {
+  /// GumTree's top-down matching of identical subtrees, then bottom-up
+  /// matching of the nodes whose descendants are most alike.  Both phases
+  /// take quadratic time in the size of the trees.
+  GumTree,
+  /// Matching of identical subtrees by their hashes, then of the parents of
+  /// matched nodes, which takes linear time.  The optimal mapping is only
+  /// computed for the small subtrees left, within a time budget.
+  Linear
+};
+
 /// Represents a Clang AST node, alongside some additional information.
 struct Node {
   NodeId Parent, LeftMostDescendant, RightMostDescendant;
@@ -57,6 +69,10 @@ public:
   // Returns the ID of the node that is mapped to the given node in SourceTree.
   NodeId getMapped(const SyntaxTree &SourceTree, NodeId Id) const;
 
+  /// Returns how the nodes were matched, which depends on the size of the
+  /// trees when ComparisonOptions::LinearMatchingThreshold is set.
+  MatchingMode getMatchingMode() const;
+
   class Impl;
 
 private:
@@ -115,6 +131,17 @@ struct ComparisonOptions {
 
   bool StopAfterTopDown = false;
 
+  MatchingMode Mode = MatchingMode::GumTree;
+
+  /// Trees whose sizes add up to more than this many nodes are matched with
+  /// MatchingMode::Linear, whatever Mode is.  -1 means no limit.
+  int LinearMatchingThreshold = -1;
+
+  /// With MatchingMode::Linear, no more optimal mappings are computed once
+  /// this many milliseconds have been spent matching.  0 means no limit.
+  /// The memory of each optimal mapping is bounded by MaxSize.
+  unsigned TimeBudgetMs = 0;
+
   /// Returns false if the nodes should never be matched.
   bool isMatchingAllowed(const Node &N1, const Node &N2) const {
     return N1.getType().isSame(N2.getType());
@@ -0,0 +1,116 @@
+//===--- BinaryCompilationDatabase.h - ---------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  The BinaryCompilationDatabase finds compilation databases supplied as a file
+//  'compile_commands.bin', which is written from another compilation database,
+//  typically a JSON one.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_TOOLING_BINARYCOMPILATIONDATABASE_H
+#define LLVM_CLANG_TOOLING_BINARYCOMPILATIONDATABASE_H
+
+#include "clang/Basic/LLVM.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/FileMatchTrie.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace clang {
+namespace tooling {
+
+/// \brief A compilation database in a binary file, which is mapped into memory
+/// and decoded lazily.
+///
+/// Each distinct string of the database, be it a directory, a file name or a
+/// command line argument, is stored once. The compile commands are records of
+/// references to these strings, and the commands of each file are found
+/// through an on-disk hash table of the native absolute paths of the files.
+/// Loading the database only checks its header; the commands are decoded
+/// when they are requested.
+///
+/// Files which are not in the hash table are matched against the files of the
+/// database like JSONCompilationDatabase does, which decodes all of their
+/// paths the first time it is needed.
+class BinaryCompilationDatabase : public CompilationDatabase {
+public:
+  /// \brief Loads a binary compilation database from the specified file.
+  ///
+  /// Returns NULL and sets ErrorMessage if the database could not be
+  /// loaded from the given file.
+  static std::unique_ptr<BinaryCompilationDatabase>
+  loadFromFile(StringRef FilePath, std::string &ErrorMessage);
+
+  /// \brief Loads a binary compilation database from a data buffer.
+  ///
+  /// Returns NULL and sets ErrorMessage if the database could not be loaded.
+  static std::unique_ptr<BinaryCompilationDatabase>
+  loadFromBuffer(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+                 std::string &ErrorMessage);
+
+  /// \brief Returns the contents of a binary compilation database with all
+  /// the compile commands of \p Database.
+  static std::string serialize(const CompilationDatabase &Database);
+
+  /// \brief Returns all compile commands in which the specified file was
+  /// compiled.
+  std::vector<CompileCommand>
+  getCompileCommands(StringRef FilePath) const override;
+
+  /// \brief Returns the list of all files available in the compilation database.
+  std::vector<std::string> getAllFiles() const override;
+
+  /// \brief Returns all compile commands for all the files in the compilation
+  /// database.
+  std::vector<CompileCommand> getAllCompileCommands() const override;
+
+private:
+  explicit BinaryCompilationDatabase(std::unique_ptr<llvm::MemoryBuffer> Buffer)
+      : Buffer(std::move(Buffer)) {}
+
+  /// \brief Checks the header of the database, and reads the offsets of its
+  /// tables. Returns false if the database is malformed.
+  bool readHeader(std::string &ErrorMessage);
+
+  /// \brief Returns the string at \p Offset, or an empty string if
+  /// \p Offset is out of bounds.
+  StringRef getString(uint32_t Offset) const;
+
+  /// \brief Decodes the compile command with the given index.
+  CompileCommand getCommand(uint32_t Index) const;
+
+  /// \brief Appends to \p Commands the compile commands of the file with the
+  /// native absolute path \p NativeFilePath. Returns false if the file is not
+  /// in the database.
+  bool lookupCommands(StringRef NativeFilePath,
+                      std::vector<CompileCommand> &Commands) const;
+
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  uint32_t NumCommands = 0;
+  uint32_t CommandsOffset = 0;
+  uint32_t NumArguments = 0;
+  uint32_t ArgumentsOffset = 0;
+  uint32_t NumFiles = 0;
+  uint32_t FilesOffset = 0;
+  uint32_t IndexOffset = 0;
+
+  /// \brief The paths of all the files, built on the first lookup of a path
+  /// which is not in the hash table.
+  mutable FileMatchTrie MatchTrie;
+  mutable std::once_flag MatchTrieFlag;
+};
+
+} // end namespace tooling
+} // end namespace clang
+
+#endif
@@ -253,6 +253,17 @@ class Replacements {
   /// category of replacements.
   llvm::Error add(const Replacement &R);
 
+  /// \brief Creates a set of replacements from \p Replaces, which can be in
+  /// any order.
+  ///
+  /// This is equivalent to calling `add()` for each of \p Replaces, but sorts
+  /// them once and then only checks each replacement for conflicts with the
+  /// one before it, so that it runs in O(n log n) for n replacements. Returns
+  /// an llvm::Error if \p Replaces don't all have the same file path or if
+  /// some of them are order-dependent.
+  static llvm::Expected<Replacements>
+  createFromUnsorted(std::vector<Replacement> Replaces);
+
   /// \brief Merges \p Replaces into the current replacements. \p Replaces
   /// refers to code after applying the current replacements.
   LLVM_NODISCARD Replacements merge(const Replacements &Replaces) const;
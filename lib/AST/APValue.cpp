@@ -17,8 +17,11 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/Expr.h"
 #include "clang/AST/Type.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
 using namespace clang;
 
 namespace {
@@ -102,23 +105,83 @@ struct APValue::MemberPointerData : MemberPointerBase {
   }
 };
 
-// FIXME: Reduce the malloc traffic here.
+/// The innermost element pool of this thread, if any.
+static LLVM_THREAD_LOCAL APValue::ElementPool *CurrentElementPool;
+
+APValue::ElementPool::ElementPool() : Previous(CurrentElementPool) {
+  std::fill(std::begin(FreeLists), std::end(FreeLists), nullptr);
+  std::fill(std::begin(NumFree), std::end(NumFree), 0);
+  CurrentElementPool = this;
+}
+
+APValue::ElementPool::~ElementPool() {
+  assert(CurrentElementPool == this && "element pools destroyed out of order");
+  CurrentElementPool = Previous;
+  for (void *Elts : FreeLists) {
+    while (Elts) {
+      void *Next = *static_cast<void **>(Elts);
+      ::operator delete(Elts);
+      Elts = Next;
+    }
+  }
+}
+
+void *APValue::ElementPool::take(unsigned NumElts) {
+  if (NumElts > MaxPooledElts || !NumFree[NumElts - 1])
+    return nullptr;
+  void *Elts = FreeLists[NumElts - 1];
+  FreeLists[NumElts - 1] = *static_cast<void **>(Elts);
+  --NumFree[NumElts - 1];
+  return Elts;
+}
+
+bool APValue::ElementPool::give(void *Elts, unsigned NumElts) {
+  if (NumElts > MaxPooledElts || NumFree[NumElts - 1] == MaxPooledPerSize)
+    return false;
+  *static_cast<void **>(Elts) = FreeLists[NumElts - 1];
+  FreeLists[NumElts - 1] = Elts;
+  ++NumFree[NumElts - 1];
+  return true;
+}
+
+APValue *APValue::allocateElts(unsigned NumElts) {
+  if (!NumElts)
+    return nullptr;
+  void *Mem = CurrentElementPool ? CurrentElementPool->take(NumElts) : nullptr;
+  if (!Mem)
+    Mem = ::operator new(NumElts * sizeof(APValue));
+  APValue *Elts = static_cast<APValue *>(Mem);
+  for (unsigned I = 0; I != NumElts; ++I)
+    new (Elts + I) APValue();
+  return Elts;
+}
+
+void APValue::deallocateElts(APValue *Elts, unsigned NumElts) {
+  if (!NumElts)
+    return;
+  for (unsigned I = 0; I != NumElts; ++I)
+    Elts[I].~APValue();
+  if (!CurrentElementPool || !CurrentElementPool->give(Elts, NumElts))
+    ::operator delete(Elts);
+}
 
 APValue::Arr::Arr(unsigned NumElts, unsigned Size) :
-  Elts(new APValue[NumElts + (NumElts != Size ? 1 : 0)]),
+  Elts(allocateElts(NumElts + (NumElts != Size ? 1 : 0))),
   NumElts(NumElts), ArrSize(Size) {}
-APValue::Arr::~Arr() { delete [] Elts; }
+APValue::Arr::~Arr() {
+  deallocateElts(Elts, NumElts + (NumElts != ArrSize ? 1 : 0));
+}
 
 APValue::StructData::StructData(unsigned NumBases, unsigned NumFields) :
-  Elts(new APValue[NumBases+NumFields]),
+  Elts(allocateElts(NumBases+NumFields)),
   NumBases(NumBases), NumFields(NumFields) {}
 APValue::StructData::~StructData() {
-  delete [] Elts;
+  deallocateElts(Elts, NumBases + NumFields);
 }
 
-APValue::UnionData::UnionData() : Field(nullptr), Value(new APValue) {}
+APValue::UnionData::UnionData() : Field(nullptr), Value(allocateElts(1)) {}
 APValue::UnionData::~UnionData () {
-  delete Value;
+  deallocateElts(Value, 1);
 }
 
 APValue::APValue(const APValue &RHS) : Kind(Uninitialized) {
@@ -39,7 +39,9 @@
 #include "llvm/ADT/Triple.h"
 #include "llvm/Support/Capacity.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
+#include <deque>
 #include <map>
 
 using namespace clang;
@@ -766,8 +768,6 @@ ASTContext::ASTContext(LangOptions &LOpts, SourceManager &SM,
 }
 
 ASTContext::~ASTContext() {
-  ReleaseParentMapEntries();
-
   // Release the DenseMaps associated with DeclContext objects.
   // FIXME: Is this the ideal solution?
   ReleaseDeclContextMaps();
@@ -801,28 +801,13 @@ ASTContext::~ASTContext() {
        MaterializedTemporaryValues)
     MTVPair.second->~APValue();
 
+  for (const auto &Result : ConstexprCallResults)
+    Result.second->~APValue();
+
   for (const auto &Value : ModuleInitializers)
     Value.second->~PerModuleInitializers();
 }
 
-void ASTContext::ReleaseParentMapEntries() {
-  if (!PointerParents) return;
-  for (const auto &Entry : *PointerParents) {
-    if (Entry.second.is<ast_type_traits::DynTypedNode *>()) {
-      delete Entry.second.get<ast_type_traits::DynTypedNode *>();
-    } else if (Entry.second.is<ParentVector *>()) {
-      delete Entry.second.get<ParentVector *>();
-    }
-  }
-  for (const auto &Entry : *OtherParents) {
-    if (Entry.second.is<ast_type_traits::DynTypedNode *>()) {
-      delete Entry.second.get<ast_type_traits::DynTypedNode *>();
-    } else if (Entry.second.is<ParentVector *>()) {
-      delete Entry.second.get<ParentVector *>();
-    }
-  }
-}
-
 void ASTContext::AddDeallocation(void (*Callback)(void*), void *Data) {
   Deallocations.push_back({Callback, Data});
 }
@@ -883,6 +868,9 @@ void ASTContext::PrintStats() const {
                << NumImplicitDestructors
                << " implicit destructors created\n";
 
+  if (getLangOpts().CPlusPlus)
+    PrintConstexprCacheStats();
+
   if (ExternalSource) {
     llvm::errs() << "\n";
     ExternalSource->PrintStats();
@@ -891,6 +879,86 @@ void ASTContext::PrintStats() const {
   BumpAlloc.PrintStats();
 }
 
+void ASTContext::PrintConstexprCacheStats() const {
+  llvm::errs() << NumConstexprCallHits << "/" << NumConstexprCallLookups
+               << " constexpr call results reused, "
+               << ConstexprCallResults.size() << " cached\n";
+}
+
+void ASTContext::PrintMemoryReport(raw_ostream &OS) const {
+  static const char *const AllocationKindNames[] = {"decls", "stmts",
+                                                    "other"};
+  OS << "{\n  \"total\": " << BumpAlloc.getTotalMemory() << ",\n";
+  OS << "  \"allocated\": {";
+  for (unsigned K = 0; K != AK_NumKinds; ++K)
+    OS << (K ? ", " : "") << '"' << AllocationKindNames[K]
+       << "\": {\"count\": " << NumAllocations[K]
+       << ", \"bytes\": " << AllocatedBytes[K] << "}";
+  OS << "},\n";
+
+  // Types are not allocated through a single path, so they are counted by
+  // walking them. Their trailing objects, such as the parameter types of a
+  // function prototype, are not included.
+  uint64_t Counts[] = {
+#define TYPE(Name, Parent) 0,
+#define ABSTRACT_TYPE(Name, Parent)
+#include "clang/AST/TypeNodes.def"
+    0 // Extra
+  };
+  for (const Type *T : Types)
+    Counts[(unsigned)T->getTypeClass()]++;
+
+  uint64_t TotalTypeBytes = 0;
+  unsigned Idx = 0;
+#define TYPE(Name, Parent)                                              \
+  TotalTypeBytes += Counts[Idx++] * sizeof(Name##Type);
+#define ABSTRACT_TYPE(Name, Parent)
+#include "clang/AST/TypeNodes.def"
+  OS << "  \"types\": {\"count\": " << Types.size()
+     << ", \"bytes\": " << TotalTypeBytes << ", \"kinds\": {";
+  const char *Separator = "";
+  Idx = 0;
+#define TYPE(Name, Parent)                                              \
+  if (Counts[Idx]) {                                                    \
+    OS << Separator << "\"" #Name "\": {\"count\": " << Counts[Idx]     \
+       << ", \"bytes\": " << Counts[Idx] * sizeof(Name##Type) << "}";    \
+    Separator = ", ";                                                   \
+  }                                                                     \
+  ++Idx;
+#define ABSTRACT_TYPE(Name, Parent)
+#include "clang/AST/TypeNodes.def"
+  OS << "}},\n";
+
+  OS << "  \"decls\": ";
+  Decl::PrintMemoryReport(OS);
+  OS << ",\n  \"stmts\": ";
+  Stmt::PrintMemoryReport(OS);
+  OS << ",\n";
+
+  size_t BoundsSideTables = llvm::capacity_in_bytes(ExprBounds) +
+                            llvm::capacity_in_bytes(FunctionTypeBounds) +
+                            llvm::capacity_in_bytes(FunctionTypeInteropTypes) +
+                            llvm::capacity_in_bytes(AdjustedInteropTypes) +
+                            llvm::capacity_in_bytes(BoundsSafeInterfaceTypes);
+  size_t TemplateSideTables =
+      llvm::capacity_in_bytes(TemplateOrInstantiation) +
+      llvm::capacity_in_bytes(InstantiatedFromUsingDecl) +
+      llvm::capacity_in_bytes(InstantiatedFromUsingShadowDecl) +
+      llvm::capacity_in_bytes(InstantiatedFromUnnamedFieldDecl) +
+      llvm::capacity_in_bytes(ClassScopeSpecializationPattern);
+  OS << "  \"sideTables\": {\"bytes\": " << getSideTableAllocatedMemory()
+     << ", \"bounds\": " << BoundsSideTables
+     << ", \"templates\": " << TemplateSideTables << "},\n";
+
+  SourceManager::MemoryBufferSizes Buffers = SourceMgr.getMemoryBufferSizes();
+  OS << "  \"sourceManager\": {\"contentCaches\": "
+     << SourceMgr.getContentCacheSize()
+     << ", \"dataStructures\": " << SourceMgr.getDataStructureSizes()
+     << ", \"mallocBuffers\": " << Buffers.malloc_bytes
+     << ", \"mmapBuffers\": " << Buffers.mmap_bytes << "}\n";
+  OS << "}\n";
+}
+
 void ASTContext::mergeDefinitionIntoModule(NamedDecl *ND, Module *M,
                                            bool NotifyListeners) {
   if (NotifyListeners)
@@ -3280,9 +3348,22 @@ static bool isCanonicalExceptionSpecification(
 
 QualType ASTContext::getFunctionTypeInternal(
     QualType ResultTy, ArrayRef<QualType> ArgArray,
-    const FunctionProtoType::ExtProtoInfo &EPI, bool OnlyWantCanonical) const {
+    const FunctionProtoType::ExtProtoInfo &OrigEPI,
+    bool OnlyWantCanonical) const {
   size_t NumArgs = ArgArray.size();
 
+  // Checked C: replace the bounds annotations by the uniqued ones, so that
+  // profiling the function type only needs to profile their pointers.
+  FunctionProtoType::ExtProtoInfo EPI = OrigEPI;
+  SmallVector<BoundsAnnotations, 8> ParamAnnots;
+  if (EPI.ParamAnnots) {
+    ParamAnnots.reserve(NumArgs);
+    for (unsigned i = 0; i != NumArgs; ++i)
+      ParamAnnots.push_back(getUniquedBoundsAnnotations(EPI.ParamAnnots[i]));
+    EPI.ParamAnnots = ParamAnnots.data();
+  }
+  EPI.ReturnAnnots = getUniquedBoundsAnnotations(EPI.ReturnAnnots);
+
   // Unique functions, to guarantee there is only one function of a particular
   // structure.
   llvm::FoldingSetNodeID ID;
@@ -9048,11 +9129,51 @@ bool ASTContext::isNotAllowedForNoPrototypeFunction(QualType QT) const {
   return false;
 }
 
+BoundsAnnotations
+ASTContext::getUniquedBoundsAnnotations(const BoundsAnnotations &Annots) const {
+  BoundsExpr *Bounds = Annots.getBoundsExpr();
+  InteropTypeExpr *IType = Annots.getInteropTypeExpr();
+
+  // The hash only narrows the candidates: expressions with the same hash
+  // are shared only when Lexicographic finds them equal.
+  if (Bounds) {
+    Lexicographic Lex(const_cast<ASTContext &>(*this), nullptr);
+    unsigned Hash = Lex.HashExpr(Bounds);
+    SmallVectorImpl<BoundsExpr *> &Candidates = FunctionTypeBounds[Hash];
+    auto It = llvm::find_if(Candidates, [&](BoundsExpr *Candidate) {
+      return Candidate == Bounds ||
+             Lex.CompareExpr(Candidate, Bounds) == Lexicographic::Result::Equal;
+    });
+    if (It != Candidates.end())
+      Bounds = *It;
+    else {
+      Candidates.push_back(Bounds);
+      FunctionBodyEscaped |= FunctionBodyAlloc != nullptr;
+    }
+  }
+
+  // A null type is the empty key of the map, and only invalid interop
+  // types have one, so those are not shared.
+  if (IType && !IType->getType().isNull()) {
+    InteropTypeExpr *&Existing = FunctionTypeInteropTypes[IType->getType()];
+    if (Existing)
+      IType = Existing;
+    else {
+      Existing = IType;
+      FunctionBodyEscaped |= FunctionBodyAlloc != nullptr;
+    }
+  }
+
+  return BoundsAnnotations(Bounds, IType);
+}
+
 bool ASTContext::EquivalentBounds(const BoundsExpr *Expr1, const BoundsExpr *Expr2,
                                   EquivExprSets *EquivExprs) {
+  if (Expr1 == Expr2)
+    return true;
+
   if (Expr1 && Expr2) {
-    Lexicographic::Result Cmp = Lexicographic(*this, EquivExprs).CompareExpr(Expr1, Expr2);
-    return Cmp == Lexicographic::Result::Equal;
+    return Lexicographic(*this, EquivExprs).EqualExprs(Expr1, Expr2);
   }
 
   // One or both bounds expressions are null pointers.
@@ -9069,7 +9190,7 @@ bool ASTContext::EquivalentBounds(const BoundsExpr *Expr1, const BoundsExpr *Exp
 bool ASTContext::EquivalentInteropTypes(
   const InteropTypeExpr *Expr1,
   const InteropTypeExpr *Expr2) {
-  if (Expr1 == nullptr && Expr2 == nullptr)
+  if (Expr1 == Expr2)
     return true;
 
   if (Expr1 != nullptr && Expr2 != nullptr && Expr1->getType() == Expr2->getType())
@@ -9094,6 +9215,10 @@ bool ASTContext::EquivalentAnnotations(
 
 BoundsExpr *ASTContext::getPrebuiltCountZero() {
   if (!PrebuiltCountZero) {
+    // The prebuilt bounds are shared, so they outlive the function body
+    // that first asks for them.
+    llvm::SaveAndRestore<llvm::BumpPtrAllocator *> InContext(FunctionBodyAlloc,
+                                                             nullptr);
     llvm::APInt Zero(getIntWidth(IntTy), 0);
     IntegerLiteral *ZeroLiteral = new (*this) IntegerLiteral(*this, Zero, IntTy, SourceLocation());
     PrebuiltCountZero =
@@ -9106,6 +9231,8 @@ BoundsExpr *ASTContext::getPrebuiltCountZero() {
 
 BoundsExpr *ASTContext::getPrebuiltCountOne() {
   if (!PrebuiltCountOne) {
+    llvm::SaveAndRestore<llvm::BumpPtrAllocator *> InContext(FunctionBodyAlloc,
+                                                             nullptr);
     llvm::APInt One(getIntWidth(IntTy), 1);
     IntegerLiteral *OneLiteral = new (*this) IntegerLiteral(*this, One, IntTy,
                                                             SourceLocation());
@@ -9120,6 +9247,8 @@ BoundsExpr *ASTContext::getPrebuiltCountOne() {
 
 BoundsExpr *ASTContext::getPrebuiltByteCountOne() {
   if (!PrebuiltByteCountOne) {
+    llvm::SaveAndRestore<llvm::BumpPtrAllocator *> InContext(FunctionBodyAlloc,
+                                                             nullptr);
     llvm::APInt One(getIntWidth(IntTy), 1);
     IntegerLiteral *OneLiteral = new (*this) IntegerLiteral(*this, One, IntTy,
                                                             SourceLocation());
@@ -9134,6 +9263,8 @@ BoundsExpr *ASTContext::getPrebuiltByteCountOne() {
 
 BoundsExpr *ASTContext::getPrebuiltBoundsUnknown() {
   if (!PrebuiltBoundsUnknown) {
+    llvm::SaveAndRestore<llvm::BumpPtrAllocator *> InContext(FunctionBodyAlloc,
+                                                             nullptr);
     PrebuiltBoundsUnknown =
       new (*this) NullaryBoundsExpr(BoundsExpr::Kind::Unknown,
                                     SourceLocation(), SourceLocation());
@@ -9145,8 +9276,14 @@ BoundsExpr *ASTContext::getPrebuiltBoundsUnknown() {
  QualType ASTContext::getInteropTypeAndAdjust(const InteropTypeExpr *BA, bool IsParam) const {
   if (!BA) return QualType();
   QualType ResultType = BA->getType();
-  if (IsParam && !ResultType.isNull() && ResultType->isArrayType())
-    ResultType = getAdjustedParameterType(ResultType);
+  if (IsParam && !ResultType.isNull() && ResultType->isArrayType()) {
+    // Uses of parameters get their interop type each time, so the decayed
+    // type of each array interop type is only built once.
+    QualType &Adjusted = AdjustedInteropTypes[ResultType];
+    if (Adjusted.isNull())
+      Adjusted = getAdjustedParameterType(ResultType);
+    ResultType = Adjusted;
+  }
   return ResultType;
 }
 
@@ -9189,6 +9326,26 @@ void ASTContext::addMemberBoundsUse(const MemberPath &Path,
   UsingBounds[Path].push_back(Bounds);
 }
 
+BoundsExpr *ASTContext::getExprBounds(const Expr *E) const {
+  auto It = ExprBounds.find(E);
+  if (It == ExprBounds.end())
+    return nullptr;
+  return cast_or_null<BoundsExpr>(It->second.get(getExternalSource()));
+}
+
+void ASTContext::setExprBounds(const Expr *E, BoundsExpr *B) {
+  if (B)
+    ExprBounds[E] = LazyDeclStmtPtr(B);
+  else
+    ExprBounds.erase(E);
+}
+
+void ASTContext::forgetExprBounds(llvm::BumpPtrAllocator &Alloc) {
+  for (auto It = ExprBounds.begin(), End = ExprBounds.end(); It != End; ++It)
+    if (Alloc.identifyObject(It->first))
+      ExprBounds.erase(It);
+}
+
 //===----------------------------------------------------------------------===//
 //                         Integer Predicates
 //===----------------------------------------------------------------------===//
@@ -9963,7 +10120,12 @@ size_t ASTContext::getSideTableAllocatedMemory() const {
          llvm::capacity_in_bytes(OverriddenMethods) +
          llvm::capacity_in_bytes(Types) +
          llvm::capacity_in_bytes(VariableArrayTypes) +
-         llvm::capacity_in_bytes(ClassScopeSpecializationPattern);
+         llvm::capacity_in_bytes(ClassScopeSpecializationPattern) +
+         llvm::capacity_in_bytes(ExprBounds) +
+         llvm::capacity_in_bytes(FunctionTypeBounds) +
+         llvm::capacity_in_bytes(FunctionTypeInteropTypes) +
+         llvm::capacity_in_bytes(AdjustedInteropTypes) +
+         llvm::capacity_in_bytes(BoundsSafeInterfaceTypes);
 }
 
 /// getIntTypeForBitwidth -
@@ -10092,6 +10254,21 @@ ASTContext::getMaterializedTemporaryValue(const MaterializeTemporaryExpr *E,
   return MaterializedTemporaryValues.lookup(E);
 }
 
+APValue *ASTContext::getConstexprCallResult(StringRef Key, bool MayCreate) {
+  if (MayCreate) {
+    APValue *&Result = ConstexprCallResults[Key];
+    if (!Result)
+      Result = new (*this) APValue;
+    return Result;
+  }
+
+  ++NumConstexprCallLookups;
+  APValue *Result = ConstexprCallResults.lookup(Key);
+  if (Result)
+    ++NumConstexprCallHits;
+  return Result;
+}
+
 bool ASTContext::AtomicUsesUnsupportedLibcall(const AtomicExpr *E) const {
   const llvm::Triple &T = getTargetInfo().getTriple();
   if (!T.isOSDarwin())
@@ -10110,16 +10287,129 @@ bool ASTContext::AtomicUsesUnsupportedLibcall(const AtomicExpr *E) const {
   return (Size != Align || toBits(sizeChars) > MaxInlineWidthInBits);
 }
 
-namespace {
+/// \brief The parents of the nodes of a translation unit, as defined by the
+/// traversal of RecursiveASTVisitor.
+///
+/// A parent is a pointer to a Decl, to a Stmt, or to one of the other parent
+/// nodes, such as TypeLocs, which are each stored once. The parents of the
+/// nodes with pointer identity, which are most of the nodes, are kept in a
+/// vector of (node, parent) pairs sorted by node, rather than in a hash
+/// table with an entry per node. Only the rare nodes with several parents,
+/// such as the statements of templates, get a vector of DynTypedNodes, in a
+/// side table.
+class ASTContext::ParentMap {
+  typedef llvm::PointerUnion3<const Decl *, const Stmt *,
+                              const ast_type_traits::DynTypedNode *>
+      ParentRef;
+
+  /// \brief A RecursiveASTVisitor that records, in preorder, the parent of
+  /// each node it traverses.
+  ///
+  /// Note that the relationship described here is purely in terms of AST
+  /// traversal - there are other relationships (for example declaration
+  /// context) in the AST that are better modeled by special matchers.
+  class Builder;
+
+  static ast_type_traits::DynTypedNode toDynTypedNode(ParentRef Parent) {
+    if (const auto *D = Parent.dyn_cast<const Decl *>())
+      return ast_type_traits::DynTypedNode::create(*D);
+    if (const auto *S = Parent.dyn_cast<const Stmt *>())
+      return ast_type_traits::DynTypedNode::create(*S);
+    return *Parent.get<const ast_type_traits::DynTypedNode *>();
+  }
+
+  /// \brief Sorts \p Entries by node, keeping the parents of each node in
+  /// traversal order, and moves the parents of the nodes which have several
+  /// of them to \p Multiple.
+  template <typename KeyT, typename CompareT>
+  static void
+  finalize(std::vector<std::pair<KeyT, ParentRef>> &Entries,
+           llvm::DenseMap<KeyT, ParentVector> &Multiple, CompareT Less) {
+    std::stable_sort(Entries.begin(), Entries.end(),
+                     [&](const std::pair<KeyT, ParentRef> &LHS,
+                         const std::pair<KeyT, ParentRef> &RHS) {
+                       return Less(LHS.first, RHS.first);
+                     });
+    auto Out = Entries.begin();
+    for (auto I = Entries.begin(), E = Entries.end(); I != E;) {
+      auto Next = std::next(I);
+      while (Next != E && !Less(I->first, Next->first))
+        ++Next;
+      if (Next != std::next(I)) {
+        ParentVector Vector;
+        for (auto P = I; P != Next; ++P) {
+          ast_type_traits::DynTypedNode Parent = toDynTypedNode(P->second);
+          // Skip duplicates for types that have memoization data.
+          // We must check that the type has memoization data before calling
+          // std::find() because DynTypedNode::operator== can't compare all
+          // types.
+          if (!Parent.getMemoizationData() ||
+              std::find(Vector.begin(), Vector.end(), Parent) == Vector.end())
+            Vector.push_back(Parent);
+        }
+        if (Vector.size() > 1) {
+          Multiple[I->first] = std::move(Vector);
+          // A null parent means that the parents are in Multiple.
+          I->second = ParentRef();
+        }
+      }
+      *Out++ = *I;
+      I = Next;
+    }
+    Entries.erase(Out, Entries.end());
+    Entries.shrink_to_fit();
+  }
 
-ast_type_traits::DynTypedNode getSingleDynTypedNodeFromParentMap(
-    ASTContext::ParentMapPointers::mapped_type U) {
-  if (const auto *D = U.dyn_cast<const Decl *>())
-    return ast_type_traits::DynTypedNode::create(*D);
-  if (const auto *S = U.dyn_cast<const Stmt *>())
-    return ast_type_traits::DynTypedNode::create(*S);
-  return *U.get<ast_type_traits::DynTypedNode *>();
-}
+  template <typename KeyT, typename CompareT>
+  static DynTypedNodeList
+  lookup(const KeyT &Key,
+         const std::vector<std::pair<KeyT, ParentRef>> &Entries,
+         const llvm::DenseMap<KeyT, ParentVector> &Multiple, CompareT Less) {
+    auto I = std::lower_bound(Entries.begin(), Entries.end(), Key,
+                              [&](const std::pair<KeyT, ParentRef> &Entry,
+                                  const KeyT &Key) {
+                                return Less(Entry.first, Key);
+                              });
+    if (I == Entries.end() || Less(Key, I->first))
+      return llvm::ArrayRef<ast_type_traits::DynTypedNode>();
+    if (I->second.isNull())
+      return llvm::makeArrayRef(Multiple.find(Key)->second);
+    return toDynTypedNode(I->second);
+  }
+
+  static bool lessPointer(const void *LHS, const void *RHS) {
+    return std::less<const void *>()(LHS, RHS);
+  }
+
+  static bool lessNode(const ast_type_traits::DynTypedNode &LHS,
+                       const ast_type_traits::DynTypedNode &RHS) {
+    return LHS < RHS;
+  }
+
+  std::vector<std::pair<const void *, ParentRef>> PointerParents;
+  std::vector<std::pair<ast_type_traits::DynTypedNode, ParentRef>>
+      OtherParents;
+  llvm::DenseMap<const void *, ParentVector> MultiplePointerParents;
+  llvm::DenseMap<ast_type_traits::DynTypedNode, ParentVector>
+      MultipleOtherParents;
+
+  /// \brief The parents which are neither Decls nor Stmts, which the
+  /// ParentRefs point to.
+  std::deque<ast_type_traits::DynTypedNode> OtherParentNodes;
+
+public:
+  /// \brief Builds the parent map of the translation unit \p TU.
+  explicit ParentMap(TranslationUnitDecl &TU);
+
+  DynTypedNodeList getParents(const ast_type_traits::DynTypedNode &Node) const {
+    if (Node.getNodeKind().hasPointerIdentity())
+      return lookup(Node.getMemoizationData(), PointerParents,
+                    MultiplePointerParents, lessPointer);
+    return lookup(Node, OtherParents, MultipleOtherParents, lessNode);
+  }
+};
+
+namespace {
 
 /// Template specializations to abstract away from pointers and TypeLocs.
 /// @{
@@ -10138,158 +10428,112 @@ createDynTypedNode(const NestedNameSpecifierLoc &Node) {
 }
 /// @}
 
-  /// \brief A \c RecursiveASTVisitor that builds a map from nodes to their
-  /// parents as defined by the \c RecursiveASTVisitor.
-  ///
-  /// Note that the relationship described here is purely in terms of AST
-  /// traversal - there are other relationships (for example declaration context)
-  /// in the AST that are better modeled by special matchers.
-  ///
-  /// FIXME: Currently only builds up the map using \c Stmt and \c Decl nodes.
-  class ParentMapASTVisitor : public RecursiveASTVisitor<ParentMapASTVisitor> {
-  public:
-    /// \brief Builds and returns the translation unit's parent map.
-    ///
-    ///  The caller takes ownership of the returned \c ParentMap.
-    static std::pair<ASTContext::ParentMapPointers *,
-                     ASTContext::ParentMapOtherNodes *>
-    buildMap(TranslationUnitDecl &TU) {
-      ParentMapASTVisitor Visitor(new ASTContext::ParentMapPointers,
-                                  new ASTContext::ParentMapOtherNodes);
-      Visitor.TraverseDecl(&TU);
-      return std::make_pair(Visitor.Parents, Visitor.OtherParents);
-    }
-
-  private:
-    typedef RecursiveASTVisitor<ParentMapASTVisitor> VisitorBase;
-
-    ParentMapASTVisitor(ASTContext::ParentMapPointers *Parents,
-                        ASTContext::ParentMapOtherNodes *OtherParents)
-        : Parents(Parents), OtherParents(OtherParents) {}
-
-    bool shouldVisitTemplateInstantiations() const {
-      return true;
-    }
-    bool shouldVisitImplicitCode() const {
-      return true;
-    }
+} // anonymous namespace
 
-    template <typename T, typename MapNodeTy, typename BaseTraverseFn,
-              typename MapTy>
-    bool TraverseNode(T Node, MapNodeTy MapNode,
-                      BaseTraverseFn BaseTraverse, MapTy *Parents) {
-      if (!Node)
-        return true;
-      if (ParentStack.size() > 0) {
-        // FIXME: Currently we add the same parent multiple times, but only
-        // when no memoization data is available for the type.
-        // For example when we visit all subexpressions of template
-        // instantiations; this is suboptimal, but benign: the only way to
-        // visit those is with hasAncestor / hasParent, and those do not create
-        // new matches.
-        // The plan is to enable DynTypedNode to be storable in a map or hash
-        // map. The main problem there is to implement hash functions /
-        // comparison operators for all types that DynTypedNode supports that
-        // do not have pointer identity.
-        auto &NodeOrVector = (*Parents)[MapNode];
-        if (NodeOrVector.isNull()) {
-          if (const auto *D = ParentStack.back().get<Decl>())
-            NodeOrVector = D;
-          else if (const auto *S = ParentStack.back().get<Stmt>())
-            NodeOrVector = S;
-          else
-            NodeOrVector =
-                new ast_type_traits::DynTypedNode(ParentStack.back());
-        } else {
-          if (!NodeOrVector.template is<ASTContext::ParentVector *>()) {
-            auto *Vector = new ASTContext::ParentVector(
-                1, getSingleDynTypedNodeFromParentMap(NodeOrVector));
-            delete NodeOrVector
-                    .template dyn_cast<ast_type_traits::DynTypedNode *>();
-            NodeOrVector = Vector;
-          }
+class ASTContext::ParentMap::Builder
+    : public RecursiveASTVisitor<ASTContext::ParentMap::Builder> {
+public:
+  explicit Builder(ParentMap &Map) : Map(Map) {}
 
-          auto *Vector =
-              NodeOrVector.template get<ASTContext::ParentVector *>();
-          // Skip duplicates for types that have memoization data.
-          // We must check that the type has memoization data before calling
-          // std::find() because DynTypedNode::operator== can't compare all
-          // types.
-          bool Found = ParentStack.back().getMemoizationData() &&
-                       std::find(Vector->begin(), Vector->end(),
-                                 ParentStack.back()) != Vector->end();
-          if (!Found)
-            Vector->push_back(ParentStack.back());
-        }
-      }
-      ParentStack.push_back(createDynTypedNode(Node));
-      bool Result = BaseTraverse();
-      ParentStack.pop_back();
-      return Result;
-    }
+private:
+  typedef RecursiveASTVisitor<Builder> VisitorBase;
 
-    bool TraverseDecl(Decl *DeclNode) {
-      return TraverseNode(DeclNode, DeclNode,
-                          [&] { return VisitorBase::TraverseDecl(DeclNode); },
-                          Parents);
-    }
+  /// \brief A node of the path to the node being traversed, and the
+  /// reference its children record, once one of them needed it.
+  struct StackEntry {
+    ast_type_traits::DynTypedNode Node;
+    ParentRef Ref;
+  };
 
-    bool TraverseStmt(Stmt *StmtNode) {
-      return TraverseNode(StmtNode, StmtNode,
-                          [&] { return VisitorBase::TraverseStmt(StmtNode); },
-                          Parents);
-    }
+  bool shouldVisitTemplateInstantiations() const {
+    return true;
+  }
+  bool shouldVisitImplicitCode() const {
+    return true;
+  }
 
-    bool TraverseTypeLoc(TypeLoc TypeLocNode) {
-      return TraverseNode(
-          TypeLocNode, ast_type_traits::DynTypedNode::create(TypeLocNode),
-          [&] { return VisitorBase::TraverseTypeLoc(TypeLocNode); },
-          OtherParents);
+  ParentRef getParentRef() {
+    StackEntry &Parent = ParentStack.back();
+    if (Parent.Ref.isNull()) {
+      if (const auto *D = Parent.Node.get<Decl>()) {
+        Parent.Ref = D;
+      } else if (const auto *S = Parent.Node.get<Stmt>()) {
+        Parent.Ref = S;
+      } else {
+        Map.OtherParentNodes.push_back(Parent.Node);
+        Parent.Ref = &Map.OtherParentNodes.back();
+      }
     }
+    return Parent.Ref;
+  }
 
-    bool TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc NNSLocNode) {
-      return TraverseNode(
-          NNSLocNode, ast_type_traits::DynTypedNode::create(NNSLocNode),
-          [&] {
-            return VisitorBase::TraverseNestedNameSpecifierLoc(NNSLocNode);
-          },
-          OtherParents);
+  template <typename T, typename BaseTraverseFn>
+  bool TraverseNode(T Node, BaseTraverseFn BaseTraverse) {
+    if (!Node)
+      return true;
+    ast_type_traits::DynTypedNode DynNode = createDynTypedNode(Node);
+    if (!ParentStack.empty()) {
+      // FIXME: Currently we add the same parent multiple times, but only
+      // when no memoization data is available for the type.
+      // For example when we visit all subexpressions of template
+      // instantiations; this is suboptimal, but benign: the only way to
+      // visit those is with hasAncestor / hasParent, and those do not create
+      // new matches.
+      if (DynNode.getNodeKind().hasPointerIdentity())
+        Map.PointerParents.emplace_back(DynNode.getMemoizationData(),
+                                        getParentRef());
+      else
+        Map.OtherParents.emplace_back(DynNode, getParentRef());
     }
+    ParentStack.push_back({DynNode, ParentRef()});
+    bool Result = BaseTraverse();
+    ParentStack.pop_back();
+    return Result;
+  }
 
-    ASTContext::ParentMapPointers *Parents;
-    ASTContext::ParentMapOtherNodes *OtherParents;
-    llvm::SmallVector<ast_type_traits::DynTypedNode, 16> ParentStack;
-
-    friend class RecursiveASTVisitor<ParentMapASTVisitor>;
-  };
+  bool TraverseDecl(Decl *DeclNode) {
+    return TraverseNode(DeclNode,
+                        [&] { return VisitorBase::TraverseDecl(DeclNode); });
+  }
 
-} // anonymous namespace
+  bool TraverseStmt(Stmt *StmtNode) {
+    return TraverseNode(StmtNode,
+                        [&] { return VisitorBase::TraverseStmt(StmtNode); });
+  }
 
-template <typename NodeTy, typename MapTy>
-static ASTContext::DynTypedNodeList getDynNodeFromMap(const NodeTy &Node,
-                                                      const MapTy &Map) {
-  auto I = Map.find(Node);
-  if (I == Map.end()) {
-    return llvm::ArrayRef<ast_type_traits::DynTypedNode>();
+  bool TraverseTypeLoc(TypeLoc TypeLocNode) {
+    return TraverseNode(TypeLocNode, [&] {
+      return VisitorBase::TraverseTypeLoc(TypeLocNode);
+    });
   }
-  if (auto *V = I->second.template dyn_cast<ASTContext::ParentVector *>()) {
-    return llvm::makeArrayRef(*V);
+
+  bool TraverseNestedNameSpecifierLoc(NestedNameSpecifierLoc NNSLocNode) {
+    return TraverseNode(NNSLocNode, [&] {
+      return VisitorBase::TraverseNestedNameSpecifierLoc(NNSLocNode);
+    });
   }
-  return getSingleDynTypedNodeFromParentMap(I->second);
+
+  ParentMap &Map;
+  llvm::SmallVector<StackEntry, 16> ParentStack;
+
+  friend class RecursiveASTVisitor<Builder>;
+  friend class ParentMap;
+};
+
+ASTContext::ParentMap::ParentMap(TranslationUnitDecl &TU) {
+  Builder(*this).TraverseDecl(&TU);
+  finalize(PointerParents, MultiplePointerParents, lessPointer);
+  finalize(OtherParents, MultipleOtherParents, lessNode);
 }
 
 ASTContext::DynTypedNodeList
 ASTContext::getParents(const ast_type_traits::DynTypedNode &Node) {
-  if (!PointerParents) {
+  if (!Parents) {
     // We always need to run over the whole translation unit, as
     // hasAncestor can escape any subtree.
-    auto Maps = ParentMapASTVisitor::buildMap(*getTranslationUnitDecl());
-    PointerParents.reset(Maps.first);
-    OtherParents.reset(Maps.second);
+    Parents = llvm::make_unique<ParentMap>(*getTranslationUnitDecl());
   }
-  if (Node.getNodeKind().hasPointerIdentity())
-    return getDynNodeFromMap(Node.getMemoizationData(), *PointerParents);
-  return getDynNodeFromMap(Node, *OtherParents);
+  return Parents->getParents(Node);
 }
 
 bool
@@ -99,6 +99,9 @@ namespace  {
     const CommandTraits *Traits;
     const SourceManager *SM;
 
+    /// The context holding the Checked C bounds of expressions, if known.
+    const ASTContext *Context = nullptr;
+
     /// Pending[i] is an action to dump an entity at level i.
     llvm::SmallVector<std::function<void(bool isLastChild)>, 32> Pending;
 
@@ -215,6 +218,7 @@ namespace  {
       : OS(OS), Traits(Traits), SM(SM), ShowColors(ShowColors) {}
 
     void setDeserialize(bool D) { Deserialize = D; }
+    void setContext(const ASTContext *C) { Context = C; }
 
     void dumpDecl(const Decl *D);
     void dumpStmt(const Stmt *S);
@@ -2300,7 +2304,8 @@ void ASTDumper::VisitUnaryOperator(const UnaryOperator *Node) {
   VisitExpr(Node);
   OS << " " << (Node->isPostfix() ? "postfix" : "prefix")
      << " '" << UnaryOperator::getOpcodeStr(Node->getOpcode()) << "'";
-  if (const BoundsExpr *Bounds = Node->getBoundsExpr()) {
+  if (const BoundsExpr *Bounds =
+        Context ? Node->getBoundsExpr(*Context) : nullptr) {
     dumpChild([=] {
       OS << "Bounds";
       dumpStmt(Bounds);
@@ -2335,10 +2340,13 @@ void ASTDumper::VisitMemberExpr(const MemberExpr *Node) {
   VisitExpr(Node);
   OS << " " << (Node->isArrow() ? "->" : ".") << *Node->getMemberDecl();
   dumpPointer(Node->getMemberDecl());
-  if (const BoundsExpr *Bounds = Node->getBoundsExpr()) {
+  if (const BoundsExpr *Bounds =
+        Context ? Node->getBoundsExpr(*Context) : nullptr) {
     dumpChild([=] {
       OS << "Base Expr Bounds";
       dumpStmt(Bounds);
+      OS << "BoundsCheckKind ";
+      dumpBoundsCheckKind(Node->isBoundsCheckProven() ? BCK_None : BCK_Normal);
     });
   }
 }
@@ -2377,7 +2385,8 @@ void ASTDumper::VisitOpaqueValueExpr(const OpaqueValueExpr *Node) {
 
 void ASTDumper::VisitArraySubscriptExpr(const ArraySubscriptExpr *Node) {
   VisitExpr(Node);
-  if (const BoundsExpr *Bounds = Node->getBoundsExpr()) {
+  if (const BoundsExpr *Bounds =
+        Context ? Node->getBoundsExpr(*Context) : nullptr) {
     dumpChild([=] {
       OS << "Bounds";
       dumpStmt(Bounds);
@@ -2873,12 +2882,14 @@ LLVM_DUMP_METHOD void Decl::dump(raw_ostream &OS, bool Deserialize) const {
   ASTDumper P(OS, &getASTContext().getCommentCommandTraits(),
               &getASTContext().getSourceManager());
   P.setDeserialize(Deserialize);
+  P.setContext(&getASTContext());
   P.dumpDecl(this);
 }
 
 LLVM_DUMP_METHOD void Decl::dumpColor() const {
   ASTDumper P(llvm::errs(), &getASTContext().getCommentCommandTraits(),
               &getASTContext().getSourceManager(), /*ShowColors*/true);
+  P.setContext(&getASTContext());
   P.dumpDecl(this);
 }
 
@@ -2895,6 +2906,7 @@ LLVM_DUMP_METHOD void DeclContext::dumpLookups(raw_ostream &OS,
   ASTContext &Ctx = cast<TranslationUnitDecl>(DC)->getASTContext();
   ASTDumper P(OS, &Ctx.getCommentCommandTraits(), &Ctx.getSourceManager());
   P.setDeserialize(Deserialize);
+  P.setContext(&Ctx);
   P.dumpLookups(this, DumpDecls);
 }
 
@@ -2916,6 +2928,13 @@ LLVM_DUMP_METHOD void Stmt::dump(raw_ostream &OS) const {
   P.dumpStmt(this);
 }
 
+LLVM_DUMP_METHOD void Stmt::dump(raw_ostream &OS,
+                                 const ASTContext &Context) const {
+  ASTDumper P(OS, nullptr, nullptr);
+  P.setContext(&Context);
+  P.dumpStmt(this);
+}
+
 LLVM_DUMP_METHOD void Stmt::dump() const {
   ASTDumper P(llvm::errs(), nullptr, nullptr);
   P.dumpStmt(this);
@@ -1228,6 +1228,7 @@ bool ASTNodeImporter::IsStructuralMatch(RecordDecl *FromRecord,
                                    ToRecord->getASTContext(),
                                    Importer.getNonEquivalentDecls(),
                                    false, Complain);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsStructurallyEquivalent(FromRecord, ToRecord);
 }
 
@@ -1236,6 +1237,7 @@ bool ASTNodeImporter::IsStructuralMatch(VarDecl *FromVar, VarDecl *ToVar,
   StructuralEquivalenceContext Ctx(
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), false, Complain);
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsStructurallyEquivalent(FromVar, ToVar);
 }
 
@@ -1243,6 +1245,7 @@ bool ASTNodeImporter::IsStructuralMatch(EnumDecl *FromEnum, EnumDecl *ToEnum) {
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
                                    Importer.getNonEquivalentDecls());
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsStructurallyEquivalent(FromEnum, ToEnum);
 }
 
@@ -1262,6 +1265,7 @@ bool ASTNodeImporter::IsStructuralMatch(ClassTemplateDecl *From,
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
                                    Importer.getNonEquivalentDecls());
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsStructurallyEquivalent(From, To);
 }
 
@@ -1270,6 +1274,7 @@ bool ASTNodeImporter::IsStructuralMatch(VarTemplateDecl *From,
   StructuralEquivalenceContext Ctx(Importer.getFromContext(),
                                    Importer.getToContext(),
                                    Importer.getNonEquivalentDecls());
+  Ctx.EquivalentDecls = &Importer.getEquivalentDecls();
   return Ctx.IsStructurallyEquivalent(From, To);
 }
 
@@ -2239,6 +2244,7 @@ Decl *ASTNodeImporter::VisitFriendDecl(FriendDecl *D) {
   StructuralEquivalenceContext Context(
       Importer.getFromContext(), Importer.getToContext(),
       Importer.getNonEquivalentDecls(), false, false);
+  Context.EquivalentDecls = &Importer.getEquivalentDecls();
 
   while (ImportedFriend) {
     if (D->getFriendDecl() && ImportedFriend->getFriendDecl()) {
@@ -3974,11 +3980,9 @@ Stmt *ASTNodeImporter::VisitCompoundStmt(CompoundStmt *S) {
 
   SourceLocation ToLBraceLoc = Importer.Import(S->getLBracLoc());
   SourceLocation ToRBraceLoc = Importer.Import(S->getRBracLoc());
-  return new (Importer.getToContext()) CompoundStmt(Importer.getToContext(),
-                                                    ToStmts,
-                                                    ToLBraceLoc, ToRBraceLoc,
-                                                    S->isChecked(),
-                                                    S->isCheckedPropertyDeclared());
+  return CompoundStmt::Create(Importer.getToContext(), ToStmts, ToLBraceLoc,
+                              ToRBraceLoc, S->isChecked(),
+                              S->isCheckedPropertyDeclared());
 }
 
 Stmt *ASTNodeImporter::VisitCaseStmt(CaseStmt *S) {
@@ -6274,5 +6278,6 @@ bool ASTImporter::IsStructurallyEquivalent(QualType From, QualType To,
 
   StructuralEquivalenceContext Ctx(FromContext, ToContext, NonEquivalentDecls,
                                    false, Complain);
+  Ctx.EquivalentDecls = &EquivalentDecls;
   return Ctx.IsStructurallyEquivalent(From, To);
 }
@@ -0,0 +1,65 @@
+//===--- ASTNodeIndex.cpp - Declarations and statements by kind -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ASTNodeIndex class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTNodeIndex.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+
+using namespace clang;
+
+namespace clang {
+class ASTNodeIndexBuilder : public RecursiveASTVisitor<ASTNodeIndexBuilder> {
+  ASTNodeIndex &Index;
+  bool IncludeTemplateInstantiations;
+  bool IncludeImplicitCode;
+
+public:
+  ASTNodeIndexBuilder(ASTNodeIndex &Index, bool IncludeTemplateInstantiations,
+                      bool IncludeImplicitCode)
+      : Index(Index),
+        IncludeTemplateInstantiations(IncludeTemplateInstantiations),
+        IncludeImplicitCode(IncludeImplicitCode) {}
+
+  bool shouldVisitTemplateInstantiations() const {
+    return IncludeTemplateInstantiations;
+  }
+  bool shouldVisitImplicitCode() const { return IncludeImplicitCode; }
+
+  bool VisitDecl(Decl *D) {
+    Index.Decls[D->getKind()].push_back(D);
+    ++Index.NumDecls;
+    return true;
+  }
+
+  bool VisitStmt(Stmt *S) {
+    Index.Stmts[S->getStmtClass()].push_back(S);
+    ++Index.NumStmts;
+    return true;
+  }
+};
+} // end namespace clang
+
+ASTNodeIndex::ASTNodeIndex(ASTContext &Context,
+                           bool IncludeTemplateInstantiations,
+                           bool IncludeImplicitCode) {
+  unsigned NumDeclKinds = 0;
+#define DECL(DERIVED, BASE) ++NumDeclKinds;
+#define ABSTRACT_DECL(DECL)
+#include "clang/AST/DeclNodes.inc"
+  Decls.resize(NumDeclKinds);
+  Stmts.resize(Stmt::lastStmtConstant + 1);
+
+  ASTNodeIndexBuilder Builder(*this, IncludeTemplateInstantiations,
+                              IncludeImplicitCode);
+  Builder.TraverseDecl(Context.getTranslationUnitDecl());
+}
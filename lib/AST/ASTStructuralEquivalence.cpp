@@ -1178,13 +1178,13 @@ static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
 /// Determine structural equivalence of two declarations.
 static bool IsStructurallyEquivalent(StructuralEquivalenceContext &Context,
                                      Decl *D1, Decl *D2) {
-  // FIXME: Check for known structural equivalences via a callback of some sort.
-
-  // Check whether we already know that these two declarations are not
+  // Check whether we already know whether these two declarations are
   // structurally equivalent.
-  if (Context.NonEquivalentDecls.count(
-          std::make_pair(D1->getCanonicalDecl(), D2->getCanonicalDecl())))
+  std::pair<Decl *, Decl *> P(D1->getCanonicalDecl(), D2->getCanonicalDecl());
+  if (Context.NonEquivalentDecls.count(P))
     return false;
+  if (Context.EquivalentDecls && Context.EquivalentDecls->count(P))
+    return true;
 
   // Determine whether we've already produced a tentative equivalence for D1.
   Decl *&EquivToD1 = Context.TentativeEquivalences[D1->getCanonicalDecl()];
@@ -1262,7 +1262,10 @@ bool StructuralEquivalenceContext::IsStructurallyEquivalent(Decl *D1,
   if (!::IsStructurallyEquivalent(*this, D1, D2))
     return false;
 
-  return !Finish();
+  if (Finish())
+    return false;
+  recordEquivalences();
+  return true;
 }
 
 bool StructuralEquivalenceContext::IsStructurallyEquivalent(QualType T1,
@@ -1270,7 +1273,26 @@ bool StructuralEquivalenceContext::IsStructurallyEquivalent(QualType T1,
   if (!::IsStructurallyEquivalent(*this, T1, T2))
     return false;
 
-  return !Finish();
+  if (Finish())
+    return false;
+  recordEquivalences();
+  return true;
+}
+
+void StructuralEquivalenceContext::recordEquivalences() {
+  if (!EquivalentDecls)
+    return;
+  for (const auto &P : TentativeEquivalences) {
+    // A tag without a definition is equivalent to any tag of the same name,
+    // which may no longer hold once it is completed.
+    if (const auto *Tag1 = dyn_cast<TagDecl>(P.first))
+      if (!Tag1->getDefinition())
+        continue;
+    if (const auto *Tag2 = dyn_cast<TagDecl>(P.second))
+      if (!Tag2->getDefinition())
+        continue;
+    EquivalentDecls->insert(P);
+  }
 }
 
 bool StructuralEquivalenceContext::Finish() {
@@ -15,6 +15,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/ADT/APInt.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/Support/raw_ostream.h"
 #include "clang/AST/CanonBounds.h"
 #include "clang/AST/ASTContext.h"
@@ -303,6 +305,7 @@ Lexicographic::CompareDecl(const NamedDecl *D1Arg, const NamedDecl *D2Arg) const
 }
 
 Result Lexicographic::CompareExpr(const Expr *Arg1, const Expr *Arg2) {
+   ++Context.LexicographicComparisons;
    if (Trace) {
      raw_ostream &OS = llvm::outs();
      OS << "Lexicographic comparing expressions\n";
@@ -451,49 +454,169 @@ Result Lexicographic::CompareExpr(const Expr *Arg1, const Expr *Arg2) {
    return Result::Equal;
 }
 
-// See if the expressions are considered equivalent using the list of lists
-// of equivalent expressions.
-Result Lexicographic::CheckEquivExprs(Result Current, const Expr *E1, const Expr *E2) {
-  if (!EquivExprs)
-    return Current;
-
-  // Important: compare expressions for equivalence without using equality facts.
-  // This keep the asymptotic complexity of this method linear in the number of AST nodes
-  // for E1, E2, and EquivExprs.  It also avoid the complexities of having to avoid
-  // infinite recursions.
-  Lexicographic SimpleComparer = Lexicographic(Context, nullptr);
-  // Iterate over the list of sets.
-  for (auto OuterList = EquivExprs->begin(); OuterList != EquivExprs->end();
-       ++OuterList) {
-    bool LHSAppears = false;
-    bool RHSAppears = false;
-    // See if the LHS expression appears in the set.
-    SmallVector<Expr *, 4> *ExprList = *OuterList;
-    for (auto InnerList = ExprList->begin(); InnerList != ExprList->end(); ++InnerList) {
-      if (SimpleComparer.CompareExpr(E1, *InnerList)  == Result::Equal) {
-        LHSAppears = true;
-        break;
-      }
-    }
-    if (!LHSAppears)
-      continue;
-
-    // See if the RHS expression appears in the set.
-    for (auto InnerList = ExprList->begin(); InnerList != ExprList->end(); ++InnerList) {
-      if (SimpleComparer.CompareExpr(E2, *InnerList)  == Result::Equal) {
-        RHSAppears = true;
-        break;
-      }
-    }
-
-    // If both appear, consider them equivalent.
-    if (RHSAppears)
-      return Result::Equal;
+bool Lexicographic::EqualExprs(const Expr *E1, const Expr *E2) {
+  // Equality facts can make expressions of different structure equal.
+  if ((!EquivExprs || EquivExprs->empty()) && HashExpr(E1) != HashExpr(E2))
+    return false;
+  return CompareExpr(E1, E2) == Result::Equal;
+}
+
+// The hash of a declaration covers only what CompareDecl compares: the
+// kind, and the position of parameters or the name of other declarations.
+unsigned Lexicographic::HashDecl(const NamedDecl *Arg) const {
+  const NamedDecl *D = dyn_cast<NamedDecl>(Arg->getCanonicalDecl());
+  if (!D)
+    return 0;
+  llvm::hash_code Hash = llvm::hash_value(D->getKind());
+  if (const ParmVarDecl *Parm = dyn_cast<ParmVarDecl>(D))
+    return llvm::hash_combine(Hash, Parm->getFunctionScopeIndex(),
+                              Parm->getFunctionScopeDepth());
+  if (const IdentifierInfo *Name = D->getIdentifier())
+    return llvm::hash_combine(Hash, Name->getName());
+  return Hash;
+}
+
+unsigned Lexicographic::HashExpr(const Expr *Arg) {
+  Expr *E = IgnoreValuePreservingOperations(Context, const_cast<Expr *>(Arg));
+  auto It = Context.LexicographicHashes.find(E);
+  if (It != Context.LexicographicHashes.end())
+    return It->second;
+
+  // CompareExpr compares any two casts by their cast kind and type, so all
+  // cast classes hash alike.  Only some of the properties that CompareExpr
+  // compares are hashed; the rest are left to the full comparison.
+  Stmt::StmtClass Class =
+    isa<CastExpr>(E) ? Stmt::ImplicitCastExprClass : E->getStmtClass();
+  llvm::hash_code Hash = llvm::hash_value(Class);
+  if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(E))
+    Hash = llvm::hash_combine(Hash, HashDecl(DR->getDecl()));
+  else if (const IntegerLiteral *IL = dyn_cast<IntegerLiteral>(E))
+    Hash = llvm::hash_combine(Hash, IL->getValue());
+  else if (const CharacterLiteral *CL = dyn_cast<CharacterLiteral>(E))
+    Hash = llvm::hash_combine(Hash, CL->getValue());
+  else if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E))
+    Hash = llvm::hash_combine(Hash, UO->getOpcode());
+  else if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    Hash = llvm::hash_combine(Hash, BO->getOpcode());
+  else if (const CastExpr *CE = dyn_cast<CastExpr>(E))
+    Hash = llvm::hash_combine(Hash, CE->getCastKind());
+  else if (const MemberExpr *ME = dyn_cast<MemberExpr>(E))
+    Hash = llvm::hash_combine(Hash, ME->isArrow(),
+                              HashDecl(ME->getMemberDecl()));
+
+  for (const Stmt *Child : E->children()) {
+    const Expr *ChildExpr = dyn_cast_or_null<Expr>(Child);
+    Hash = llvm::hash_combine(Hash, ChildExpr ? HashExpr(ChildExpr) : 0);
   }
 
+  unsigned Result = Hash;
+  Context.LexicographicHashes[E] = Result;
+  return Result;
+}
+
+// See if the expressions are considered equivalent using the equality facts.
+Result Lexicographic::CheckEquivExprs(Result Current, const Expr *E1, const Expr *E2) {
+  if (EquivExprs && EquivExprs->areEquivalent(E1, E2))
+    return Result::Equal;
   return Current;
- }
+}
 
+// Important: expressions are looked up without using equality facts.  This
+// keeps the cost of a lookup linear in the number of AST nodes of the
+// expression and avoids infinite recursion through CheckEquivExprs.
+int EquivExprSets::lookup(const Expr *E) {
+  Lexicographic SimpleComparer(Context, nullptr);
+  auto It = ExprsByHash.find(SimpleComparer.HashExpr(E));
+  if (It == ExprsByHash.end())
+    return -1;
+  for (unsigned Index : It->second)
+    if (SimpleComparer.CompareExpr(E, Exprs[Index]) == Result::Equal)
+      return Index;
+  return -1;
+}
+
+unsigned EquivExprSets::getOrAdd(Expr *E) {
+  int Index = lookup(E);
+  if (Index >= 0)
+    return Index;
+  unsigned NewIndex = Exprs.size();
+  Exprs.push_back(E);
+  Parents.push_back(NewIndex);
+  Ranks.push_back(0);
+  ExprsByHash[Lexicographic(Context, nullptr).HashExpr(E)].push_back(NewIndex);
+  return NewIndex;
+}
+
+unsigned EquivExprSets::findRoot(unsigned Index) {
+  // Path halving: point every other node on the path at its grandparent.
+  while (Parents[Index] != Index) {
+    Parents[Index] = Parents[Parents[Index]];
+    Index = Parents[Index];
+  }
+  return Index;
+}
+
+void EquivExprSets::addEquality(Expr *E1, Expr *E2) {
+  unsigned Root1 = findRoot(getOrAdd(E1));
+  unsigned Root2 = findRoot(getOrAdd(E2));
+  if (Root1 == Root2)
+    return;
+  // Union by rank.
+  if (Ranks[Root1] < Ranks[Root2])
+    std::swap(Root1, Root2);
+  Parents[Root2] = Root1;
+  if (Ranks[Root1] == Ranks[Root2])
+    ++Ranks[Root1];
+}
+
+bool EquivExprSets::areEquivalent(const Expr *E1, const Expr *E2) {
+  if (empty())
+    return false;
+  int Index1 = lookup(E1);
+  if (Index1 < 0)
+    return false;
+  int Index2 = lookup(E2);
+  if (Index2 < 0)
+    return false;
+  return findRoot(Index1) == findRoot(Index2);
+}
+
+// The hash of a set combines the hashes of its members commutatively, and
+// the hash of the sets combines the mixed hashes of the sets commutatively,
+// so that neither depends on the order of the facts or on the choice of
+// roots.
+unsigned EquivExprSets::getHash() {
+  Lexicographic SimpleComparer(Context, nullptr);
+  llvm::SmallDenseMap<unsigned, unsigned, 8> SetHashes;
+  for (unsigned Index = 0, E = Exprs.size(); Index != E; ++Index)
+    SetHashes[findRoot(Index)] += SimpleComparer.HashExpr(Exprs[Index]);
+  unsigned Hash = Exprs.size();
+  for (auto &Entry : SetHashes)
+    Hash += llvm::hash_value(Entry.second);
+  return Hash;
+}
+
+bool EquivExprSets::hasSameSets(EquivExprSets &Other) {
+  if (Exprs.size() != Other.Exprs.size())
+    return false;
+  // The expressions of each set are distinct, so the sets are the same if
+  // every expression is in Other and the sets correspond one to one.
+  llvm::SmallDenseMap<unsigned, unsigned, 8> OtherRoots;
+  llvm::SmallDenseSet<unsigned, 8> MatchedRoots;
+  for (unsigned Index = 0, E = Exprs.size(); Index != E; ++Index) {
+    int OtherIndex = Other.lookup(Exprs[Index]);
+    if (OtherIndex < 0)
+      return false;
+    unsigned OtherRoot = Other.findRoot(OtherIndex);
+    auto Inserted = OtherRoots.insert({findRoot(Index), OtherRoot});
+    if (Inserted.second) {
+      if (!MatchedRoots.insert(OtherRoot).second)
+        return false;
+    } else if (Inserted.first->second != OtherRoot)
+      return false;
+  }
+  return true;
+}
 
 Result
 Lexicographic::CompareType(QualType QT1, QualType QT2) const {
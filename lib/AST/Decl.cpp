@@ -1630,6 +1630,11 @@ bool NamedDecl::declarationReplaces(NamedDecl *OldD, bool IsKnownNewer) const {
   return false;
 }
 
+bool NamedDecl::replacesOnlyRedeclarations() const {
+  // Parameters replace any parameter of the same name; see above.
+  return isRedeclarable(getKind()) && !isa<ParmVarDecl>(this);
+}
+
 bool NamedDecl::hasLinkage() const {
   return getFormalLinkage() != NoLinkage;
 }
@@ -56,7 +56,7 @@ void *Decl::operator new(std::size_t Size, const ASTContext &Context,
   // resulting pointer will still be 8-byte aligned.
   static_assert(sizeof(unsigned) * 2 >= alignof(Decl),
                 "Decl won't be misaligned");
-  void *Start = Context.Allocate(Size + Extra + 8);
+  void *Start = Context.Allocate(Size + Extra + 8, 8, ASTContext::AK_Decl);
   void *Result = (char*)Start + 8;
 
   unsigned *PrefixPtr = (unsigned *)Result - 2;
@@ -82,13 +82,14 @@ void *Decl::operator new(std::size_t Size, const ASTContext &Ctx,
     size_t ExtraAlign =
         llvm::OffsetToAlignment(sizeof(Module *), alignof(Decl));
     char *Buffer = reinterpret_cast<char *>(
-        ::operator new(ExtraAlign + sizeof(Module *) + Size + Extra, Ctx));
+        Ctx.Allocate(ExtraAlign + sizeof(Module *) + Size + Extra, 8,
+                     ASTContext::AK_Decl));
     Buffer += ExtraAlign;
     auto *ParentModule =
         Parent ? cast<Decl>(Parent)->getOwningModule() : nullptr;
     return new (Buffer) Module*(ParentModule) + 1;
   }
-  return ::operator new(Size + Extra, Ctx);
+  return Ctx.Allocate(Size + Extra, 8, ASTContext::AK_Decl);
 }
 
 Module *Decl::getOwningModuleSlow() const {
@@ -170,6 +171,37 @@ void Decl::PrintStats() {
   llvm::errs() << "Total bytes = " << totalBytes << "\n";
 }
 
+void Decl::PrintMemoryReport(raw_ostream &OS) {
+  uint64_t TotalDecls = 0, TotalBytes = 0;
+  uint64_t SpecializationDecls = 0, SpecializationBytes = 0;
+#define DECL(DERIVED, BASE)                                             \
+  TotalDecls += n##DERIVED##s;                                          \
+  TotalBytes += n##DERIVED##s * sizeof(DERIVED##Decl);                  \
+  if ((Decl::DERIVED >= Decl::firstClassTemplateSpecialization &&       \
+       Decl::DERIVED <= Decl::lastClassTemplateSpecialization) ||       \
+      (Decl::DERIVED >= Decl::firstVarTemplateSpecialization &&         \
+       Decl::DERIVED <= Decl::lastVarTemplateSpecialization)) {         \
+    SpecializationDecls += n##DERIVED##s;                               \
+    SpecializationBytes += n##DERIVED##s * sizeof(DERIVED##Decl);       \
+  }
+#define ABSTRACT_DECL(DECL)
+#include "clang/AST/DeclNodes.inc"
+
+  OS << "{\"count\": " << TotalDecls << ", \"bytes\": " << TotalBytes
+     << ", \"templateSpecializations\": {\"count\": " << SpecializationDecls
+     << ", \"bytes\": " << SpecializationBytes << "}, \"kinds\": {";
+  const char *Separator = "";
+#define DECL(DERIVED, BASE)                                             \
+  if (n##DERIVED##s > 0) {                                              \
+    OS << Separator << "\"" #DERIVED "\": {\"count\": " << n##DERIVED##s  \
+       << ", \"bytes\": " << n##DERIVED##s * sizeof(DERIVED##Decl) << "}"; \
+    Separator = ", ";                                                   \
+  }
+#define ABSTRACT_DECL(DECL)
+#include "clang/AST/DeclNodes.inc"
+  OS << "}}";
+}
+
 void Decl::add(Kind k) {
   switch (k) {
 #define DECL(DERIVED, BASE) case DERIVED: ++n##DERIVED##s; break;
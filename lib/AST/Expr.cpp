@@ -1166,6 +1166,33 @@ OverloadedOperatorKind UnaryOperator::getOverloadedOperator(Opcode Opc) {
   }
 }
 
+BoundsExpr *UnaryOperator::getBoundsExpr(const ASTContext &C) const {
+  return hasBoundsExpr() ? C.getExprBounds(this) : nullptr;
+}
+
+void UnaryOperator::setBoundsExpr(ASTContext &C, BoundsExpr *E) {
+  C.setExprBounds(this, E);
+  UnaryOperatorBits.HasBounds = E != nullptr;
+}
+
+void UnaryOperator::setLazyBoundsExpr(ASTContext &C, uint64_t Offset) {
+  C.setLazyExprBounds(this, Offset);
+  UnaryOperatorBits.HasBounds = true;
+}
+
+BoundsExpr *ArraySubscriptExpr::getBoundsExpr(const ASTContext &C) const {
+  return hasBoundsExpr() ? C.getExprBounds(this) : nullptr;
+}
+
+void ArraySubscriptExpr::setBoundsExpr(ASTContext &C, BoundsExpr *E) {
+  C.setExprBounds(this, E);
+  ArraySubscriptExprBits.HasBounds = E != nullptr;
+}
+
+void ArraySubscriptExpr::setLazyBoundsExpr(ASTContext &C, uint64_t Offset) {
+  C.setLazyExprBounds(this, Offset);
+  ArraySubscriptExprBits.HasBounds = true;
+}
 
 //===----------------------------------------------------------------------===//
 // Postfix Operators.
@@ -1508,6 +1535,20 @@ MemberExpr *MemberExpr::Create(
   return E;
 }
 
+BoundsExpr *MemberExpr::getBoundsExpr(const ASTContext &C) const {
+  return hasBoundsExpr() ? C.getExprBounds(this) : nullptr;
+}
+
+void MemberExpr::setBoundsExpr(ASTContext &C, BoundsExpr *E) {
+  C.setExprBounds(this, E);
+  HasBounds = E != nullptr;
+}
+
+void MemberExpr::setLazyBoundsExpr(ASTContext &C, uint64_t Offset) {
+  C.setLazyExprBounds(this, Offset);
+  HasBounds = true;
+}
+
 SourceLocation MemberExpr::getLocStart() const {
   if (isImplicitAccess()) {
     if (hasQualifier())
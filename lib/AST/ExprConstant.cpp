@@ -44,6 +44,7 @@
 #include "clang/AST/TypeLoc.h"
 #include "clang/Basic/Builtins.h"
 #include "clang/Basic/TargetInfo.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstring>
 #include <functional>
@@ -561,6 +562,11 @@ namespace {
   /// evaluate the expression regardless of what the RHS is, but C only allows
   /// certain things in certain situations.
   struct EvalInfo {
+    /// ElementPool - Recycles the storage of the aggregate values created and
+    /// destroyed during the evaluation. This is declared first so that it
+    /// outlives any values owned by the other members.
+    APValue::ElementPool ElementPool;
+
     ASTContext &Ctx;
 
     /// EvalStatus - Contains information about the evaluation.
@@ -4250,6 +4256,85 @@ static bool EvaluateArgs(ArrayRef<const Expr*> Args, ArgVector &ArgValues,
   return Success;
 }
 
+template<typename T>
+static void appendToCallKey(SmallVectorImpl<char> &Key, const T &Value) {
+  const char *Bytes = reinterpret_cast<const char *>(&Value);
+  Key.append(Bytes, Bytes + sizeof(T));
+}
+
+static void appendToCallKey(SmallVectorImpl<char> &Key, const APInt &Value) {
+  appendToCallKey(Key, Value.getBitWidth());
+  const char *Bytes = reinterpret_cast<const char *>(Value.getRawData());
+  Key.append(Bytes, Bytes + Value.getNumWords() * sizeof(uint64_t));
+}
+
+static void appendToCallKey(SmallVectorImpl<char> &Key,
+                            const APFloat &Value) {
+  appendToCallKey(Key, &Value.getSemantics());
+  appendToCallKey(Key, Value.bitcastToAPInt());
+}
+
+/// Append an encoding of \p Value to the key \p Key of a constexpr call in
+/// the cache of call results. Values which hold lvalues are not encoded, as
+/// the call could modify the objects they designate.
+///
+/// \returns false if the value could not be encoded.
+static bool appendToCallKey(SmallVectorImpl<char> &Key, const APValue &Value) {
+  appendToCallKey(Key, static_cast<unsigned char>(Value.getKind()));
+  switch (Value.getKind()) {
+  case APValue::Uninitialized:
+    return true;
+  case APValue::Int:
+    appendToCallKey(Key, Value.getInt().isUnsigned());
+    appendToCallKey(Key, static_cast<const APInt &>(Value.getInt()));
+    return true;
+  case APValue::Float:
+    appendToCallKey(Key, Value.getFloat());
+    return true;
+  case APValue::ComplexInt:
+    appendToCallKey(Key, Value.getComplexIntReal().isUnsigned());
+    appendToCallKey(Key, static_cast<const APInt &>(Value.getComplexIntReal()));
+    appendToCallKey(Key, static_cast<const APInt &>(Value.getComplexIntImag()));
+    return true;
+  case APValue::ComplexFloat:
+    appendToCallKey(Key, Value.getComplexFloatReal());
+    appendToCallKey(Key, Value.getComplexFloatImag());
+    return true;
+  case APValue::Vector:
+    appendToCallKey(Key, Value.getVectorLength());
+    for (unsigned I = 0, N = Value.getVectorLength(); I != N; ++I)
+      if (!appendToCallKey(Key, Value.getVectorElt(I)))
+        return false;
+    return true;
+  case APValue::Array:
+    appendToCallKey(Key, Value.getArrayInitializedElts());
+    appendToCallKey(Key, Value.getArraySize());
+    for (unsigned I = 0, N = Value.getArrayInitializedElts(); I != N; ++I)
+      if (!appendToCallKey(Key, Value.getArrayInitializedElt(I)))
+        return false;
+    return !Value.hasArrayFiller() ||
+           appendToCallKey(Key, Value.getArrayFiller());
+  case APValue::Struct:
+    appendToCallKey(Key, Value.getStructNumBases());
+    appendToCallKey(Key, Value.getStructNumFields());
+    for (unsigned I = 0, N = Value.getStructNumBases(); I != N; ++I)
+      if (!appendToCallKey(Key, Value.getStructBase(I)))
+        return false;
+    for (unsigned I = 0, N = Value.getStructNumFields(); I != N; ++I)
+      if (!appendToCallKey(Key, Value.getStructField(I)))
+        return false;
+    return true;
+  case APValue::Union:
+    appendToCallKey(Key, Value.getUnionField());
+    return appendToCallKey(Key, Value.getUnionValue());
+  case APValue::LValue:
+  case APValue::MemberPointer:
+  case APValue::AddrLabelDiff:
+    return false;
+  }
+  llvm_unreachable("unknown APValue kind");
+}
+
 /// Evaluate a function call.
 static bool HandleFunctionCall(SourceLocation CallLoc,
                                const FunctionDecl *Callee, const LValue *This,
@@ -4260,6 +4345,29 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   if (!EvaluateArgs(Args, ArgValues, Info))
     return false;
 
+  // A call with no 'this' and no arguments that designate objects can neither
+  // read nor modify the objects of its caller, so its result only depends on
+  // the values of its arguments. Reuse the result of a previous call with the
+  // same values; the result of a call is only recorded if we could see that
+  // its evaluation produced no notes, side-effects or undefined behavior.
+  SmallString<64> CallKey;
+  bool MemoizeCall = !This && !Info.checkingPotentialConstantExpression();
+  if (MemoizeCall) {
+    appendToCallKey(CallKey, Callee->getCanonicalDecl());
+    for (const APValue &Arg : ArgValues)
+      if (!(MemoizeCall = appendToCallKey(CallKey, Arg)))
+        break;
+  }
+  if (MemoizeCall) {
+    if (APValue *Cached = Info.Ctx.getConstexprCallResult(CallKey, false)) {
+      Result = *Cached;
+      return true;
+    }
+    MemoizeCall = Info.EvalStatus.Diag && Info.EvalStatus.Diag->empty() &&
+                  !Info.EvalStatus.HasSideEffects &&
+                  !Info.EvalStatus.HasUndefinedBehavior;
+  }
+
   if (!Info.CheckCallLimit(CallLoc))
     return false;
 
@@ -4297,11 +4405,21 @@ static bool HandleFunctionCall(SourceLocation CallLoc,
   StmtResult Ret = {Result, ResultSlot};
   EvalStmtResult ESR = EvaluateStmt(Ret, Info, Body);
   if (ESR == ESR_Succeeded) {
-    if (Callee->getReturnType()->isVoidType())
-      return true;
-    Info.FFDiag(Callee->getLocEnd(), diag::note_constexpr_no_return);
+    if (!Callee->getReturnType()->isVoidType()) {
+      Info.FFDiag(Callee->getLocEnd(), diag::note_constexpr_no_return);
+      return false;
+    }
+  } else if (ESR != ESR_Returned) {
+    return false;
   }
-  return ESR == ESR_Returned;
+
+  SmallString<64> ResultKey;
+  if (MemoizeCall && Info.EvalStatus.Diag->empty() &&
+      !Info.EvalStatus.HasSideEffects &&
+      !Info.EvalStatus.HasUndefinedBehavior &&
+      appendToCallKey(ResultKey, Result))
+    *Info.Ctx.getConstexprCallResult(CallKey, true) = Result;
+  return true;
 }
 
 /// Evaluate a constructor call.
@@ -52,7 +52,9 @@ static StmtClassNameTable &getStmtInfoTableEntry(Stmt::StmtClass E) {
 
 void *Stmt::operator new(size_t bytes, const ASTContext& C,
                          unsigned alignment) {
-  return ::operator new(bytes, C, alignment);
+  if (C.FunctionBodyAlloc)
+    return C.FunctionBodyAlloc->Allocate(bytes, alignment);
+  return C.Allocate(bytes, alignment, ASTContext::AK_Stmt);
 }
 
 const char *Stmt::getStmtClassName() const {
@@ -84,6 +86,40 @@ void Stmt::PrintStats() {
   llvm::errs() << "Total bytes = " << sum << "\n";
 }
 
+void Stmt::PrintMemoryReport(raw_ostream &OS) {
+  // Ensure the table is primed.
+  getStmtInfoTableEntry(Stmt::NullStmtClass);
+
+  uint64_t TotalStmts = 0, TotalBytes = 0;
+  uint64_t BoundsExprs = 0, BoundsExprBytes = 0;
+  for (int i = 0; i != Stmt::lastStmtConstant+1; i++) {
+    if (StmtClassInfo[i].Name == nullptr) continue;
+    uint64_t Bytes =
+        (uint64_t)StmtClassInfo[i].Counter * StmtClassInfo[i].Size;
+    TotalStmts += StmtClassInfo[i].Counter;
+    TotalBytes += Bytes;
+    if (i >= Stmt::firstBoundsExprConstant &&
+        i <= Stmt::lastBoundsExprConstant) {
+      BoundsExprs += StmtClassInfo[i].Counter;
+      BoundsExprBytes += Bytes;
+    }
+  }
+
+  OS << "{\"count\": " << TotalStmts << ", \"bytes\": " << TotalBytes
+     << ", \"boundsExprs\": {\"count\": " << BoundsExprs
+     << ", \"bytes\": " << BoundsExprBytes << "}, \"kinds\": {";
+  const char *Separator = "";
+  for (int i = 0; i != Stmt::lastStmtConstant+1; i++) {
+    if (StmtClassInfo[i].Name == nullptr) continue;
+    if (StmtClassInfo[i].Counter == 0) continue;
+    OS << Separator << '"' << StmtClassInfo[i].Name
+       << "\": {\"count\": " << StmtClassInfo[i].Counter << ", \"bytes\": "
+       << (uint64_t)StmtClassInfo[i].Counter * StmtClassInfo[i].Size << "}";
+    Separator = ", ";
+  }
+  OS << "}}";
+}
+
 void Stmt::addStmtClass(StmtClass s) {
   ++getStmtInfoTableEntry(s).Counter;
 }
@@ -279,7 +315,7 @@ SourceLocation Stmt::getLocEnd() const {
   llvm_unreachable("unknown statement kind");
 }
 
-CompoundStmt::CompoundStmt(const ASTContext &C, ArrayRef<Stmt*> Stmts,
+CompoundStmt::CompoundStmt(ArrayRef<Stmt*> Stmts,
                            SourceLocation LB, SourceLocation RB,
                            bool IsCheckedScope, bool CheckedPropertyDeclared)
   : Stmt(CompoundStmtClass), LBraceLoc(LB), RBraceLoc(RB) {
@@ -289,24 +325,26 @@ CompoundStmt::CompoundStmt(const ASTContext &C, ArrayRef<Stmt*> Stmts,
   CompoundStmtBits.IsCheckedScope = IsCheckedScope;
   CompoundStmtBits.CheckedPropertyDeclared = CheckedPropertyDeclared;
 
-  if (Stmts.size() == 0) {
-    Body = nullptr;
-    return;
-  }
-
-  Body = new (C) Stmt*[Stmts.size()];
-  std::copy(Stmts.begin(), Stmts.end(), Body);
+  std::copy(Stmts.begin(), Stmts.end(), getTrailingObjects<Stmt *>());
 }
 
-void CompoundStmt::setStmts(const ASTContext &C, ArrayRef<Stmt *> Stmts) {
-  if (Body)
-    C.Deallocate(Body);
-  CompoundStmtBits.NumStmts = Stmts.size();
-  assert(CompoundStmtBits.NumStmts == Stmts.size() &&
-         "NumStmts doesn't fit in bits of CompoundStmtBits.NumStmts!");
+CompoundStmt *CompoundStmt::Create(const ASTContext &C, ArrayRef<Stmt*> Stmts,
+                                   SourceLocation LB, SourceLocation RB,
+                                   bool IsCheckedScope,
+                                   bool CheckedPropertyDeclared) {
+  // Go through Stmt::operator new, so that the statements of a function body
+  // that is discarded are discarded with it.
+  void *Mem = Stmt::operator new(totalSizeToAlloc<Stmt *>(Stmts.size()), C,
+                                 alignof(CompoundStmt));
+  return new (Mem) CompoundStmt(Stmts, LB, RB, IsCheckedScope,
+                                CheckedPropertyDeclared);
+}
 
-  Body = new (C) Stmt*[Stmts.size()];
-  std::copy(Stmts.begin(), Stmts.end(), Body);
+CompoundStmt *CompoundStmt::CreateEmpty(const ASTContext &C,
+                                        unsigned NumStmts) {
+  void *Mem = Stmt::operator new(totalSizeToAlloc<Stmt *>(NumStmts), C,
+                                 alignof(CompoundStmt));
+  return new (Mem) CompoundStmt(EmptyShell(), NumStmts);
 }
 
 const char *LabelStmt::getName() const {
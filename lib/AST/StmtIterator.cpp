@@ -7,12 +7,15 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// This file defines internal methods for StmtIterator.
+// This file defines internal methods for StmtIterator and
+// StmtPreorderIterator.
 //
 //===----------------------------------------------------------------------===//
 
 #include "clang/AST/StmtIterator.h"
 #include "clang/AST/Decl.h"
+#include "clang/AST/Stmt.h"
+#include <algorithm>
 
 using namespace clang;
 
@@ -112,3 +115,16 @@ Stmt*& StmtIteratorBase::GetDeclExpr() const {
   VarDecl* VD = cast<VarDecl>(*DGI);
   return *VD->getInitAddress();
 }
+
+StmtPreorderIterator &StmtPreorderIterator::operator++() {
+  assert(!Stack.empty() && "incrementing the end iterator");
+  Stmt *S = Stack.pop_back_val();
+
+  // Push the children in reverse, so that the first one is visited next.
+  size_t FirstChild = Stack.size();
+  for (Stmt *Child : S->children())
+    if (Child)
+      Stack.push_back(Child);
+  std::reverse(Stack.begin() + FirstChild, Stack.end());
+  return *this;
+}
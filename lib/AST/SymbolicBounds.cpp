@@ -0,0 +1,286 @@
+//===- SymbolicBounds.cpp: linear arithmetic over bounds expressions -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the comparison of ranges whose bounds are linear
+//  expressions over variables.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/SymbolicBounds.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/CanonBounds.h"
+#include "clang/AST/Expr.h"
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/APSInt.h"
+
+using namespace clang;
+using Result = SymbolicBoundsProver::Result;
+
+namespace {
+  // Add or multiply 64-bit signed integers.  These return true on overflow.
+  bool AddOverflow(int64_t A, int64_t B, int64_t &R) {
+    bool Overflow;
+    R = llvm::APInt(64, A, true).sadd_ov(llvm::APInt(64, B, true), Overflow)
+          .getSExtValue();
+    return Overflow;
+  }
+
+  bool MulOverflow(int64_t A, int64_t B, int64_t &R) {
+    bool Overflow;
+    R = llvm::APInt(64, A, true).smul_ov(llvm::APInt(64, B, true), Overflow)
+          .getSExtValue();
+    return Overflow;
+  }
+
+  // Get the value of an integer constant as a 64-bit signed integer.
+  bool GetInt64(const llvm::APSInt &V, int64_t &R) {
+    if (V.isSigned() ? V.getMinSignedBits() > 64 : V.getActiveBits() > 63)
+      return false;
+    R = V.isSigned() ? V.getSExtValue() : (int64_t) V.getZExtValue();
+    return true;
+  }
+}
+
+SymbolicBoundsProver::SymbolicBoundsProver(ASTContext &Ctx,
+                                           EquivExprSets *EquivExprs,
+                                           unsigned Budget) :
+  Context(Ctx), EquivExprs(EquivExprs), Budget(Budget) {
+}
+
+bool SymbolicBoundsProver::step() {
+  if (Budget == 0)
+    return false;
+  --Budget;
+  return true;
+}
+
+bool SymbolicBoundsProver::equal(const Expr *E1, const Expr *E2) {
+  if (!step())
+    return false;
+  return Lexicographic(Context, EquivExprs).EqualExprs(E1, E2);
+}
+
+bool SymbolicBoundsProver::addTerm(LinearExpr &L, const Expr *Term,
+                                   int64_t Coef) {
+  if (Coef == 0)
+    return true;
+  for (auto I = L.Terms.begin(), E = L.Terms.end(); I != E; ++I) {
+    if (!equal(I->first, Term)) {
+      if (Budget == 0)
+        return false;
+      continue;
+    }
+    if (AddOverflow(I->second, Coef, I->second))
+      return false;
+    if (I->second == 0)
+      L.Terms.erase(I);
+    return true;
+  }
+  L.Terms.push_back(std::make_pair(Term, Coef));
+  return true;
+}
+
+bool SymbolicBoundsProver::add(LinearExpr &L, const LinearExpr &R,
+                               int64_t Scale) {
+  int64_t C;
+  if (MulOverflow(R.Constant, Scale, C) ||
+      AddOverflow(L.Constant, C, L.Constant))
+    return false;
+  for (const auto &T : R.Terms) {
+    if (MulOverflow(T.second, Scale, C) || !addTerm(L, T.first, C))
+      return false;
+  }
+  return true;
+}
+
+// Add Scale * E to L.  E has integer type.
+bool SymbolicBoundsProver::linearize(const Expr *E, int64_t Scale,
+                                     LinearExpr &L) {
+  if (!step())
+    return false;
+  E = E->IgnoreParens();
+
+  llvm::APSInt V;
+  if (E->isIntegerConstantExpr(V, Context)) {
+    int64_t C;
+    if (!GetInt64(V, C) || MulOverflow(C, Scale, C))
+      return false;
+    return !AddOverflow(L.Constant, C, L.Constant);
+  }
+
+  // Signed arithmetic cannot overflow, so it can be rearranged.  All other
+  // integer expressions are terms.
+  QualType Ty = E->getType();
+  if (Ty->isSignedIntegerType()) {
+    if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+      switch (BO->getOpcode()) {
+        case BO_Add:
+          return linearize(BO->getLHS(), Scale, L) &&
+                 linearize(BO->getRHS(), Scale, L);
+        case BO_Sub: {
+          int64_t Negated;
+          return !MulOverflow(Scale, -1, Negated) &&
+                 linearize(BO->getLHS(), Scale, L) &&
+                 linearize(BO->getRHS(), Negated, L);
+        }
+        case BO_Mul: {
+          llvm::APSInt Factor;
+          const Expr *Other = nullptr;
+          if (BO->getRHS()->isIntegerConstantExpr(Factor, Context))
+            Other = BO->getLHS();
+          else if (BO->getLHS()->isIntegerConstantExpr(Factor, Context))
+            Other = BO->getRHS();
+          if (!Other)
+            break;
+          int64_t F;
+          if (!GetInt64(Factor, F) || MulOverflow(Scale, F, F))
+            return false;
+          return linearize(Other, F, L);
+        }
+        default:
+          break;
+      }
+    } else if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
+      if (UO->getOpcode() == UO_Plus)
+        return linearize(UO->getSubExpr(), Scale, L);
+      if (UO->getOpcode() == UO_Minus) {
+        int64_t Negated;
+        return !MulOverflow(Scale, -1, Negated) &&
+               linearize(UO->getSubExpr(), Negated, L);
+      }
+    } else if (const CastExpr *CE = dyn_cast<CastExpr>(E)) {
+      // Look through conversions that preserve the value.
+      const Expr *SubExpr = CE->getSubExpr();
+      QualType SubTy = SubExpr->getType();
+      if (CE->getCastKind() == CK_NoOp)
+        return linearize(SubExpr, Scale, L);
+      if (CE->getCastKind() == CK_IntegralCast && SubTy->isIntegerType()) {
+        unsigned Width = Context.getIntWidth(Ty);
+        unsigned SubWidth = Context.getIntWidth(SubTy);
+        if (SubTy->isSignedIntegerType() ? SubWidth <= Width
+                                         : SubWidth < Width)
+          return linearize(SubExpr, Scale, L);
+      }
+    }
+  }
+
+  return addTerm(L, E, Scale);
+}
+
+// Split a pointer expression E into a base and a byte offset from the base,
+// adding the offset to Offset.
+bool SymbolicBoundsProver::splitPointer(const Expr *E, const Expr *&Base,
+                                        LinearExpr &Offset) {
+  if (!step())
+    return false;
+  E = E->IgnoreParens();
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
+    if (BO->isAdditiveOp()) {
+      const Expr *Ptr = nullptr;
+      const Expr *Int = nullptr;
+      if (BO->getLHS()->getType()->isPointerType()) {
+        Ptr = BO->getLHS();
+        Int = BO->getRHS();
+      } else if (BO->getOpcode() == BO_Add &&
+                 BO->getRHS()->getType()->isPointerType()) {
+        Ptr = BO->getRHS();
+        Int = BO->getLHS();
+      }
+      if (Ptr && Int->getType()->isIntegerType()) {
+        const Type *Pointee = Ptr->getType()->getPointeeOrArrayElementType();
+        if (!Pointee->isIncompleteType()) {
+          int64_t Size =
+            Context.getTypeSizeInChars(QualType(Pointee, 0)).getQuantity();
+          if (BO->getOpcode() == BO_Sub)
+            Size = -Size;
+          return splitPointer(Ptr, Base, Offset) &&
+                 linearize(Int, Size, Offset);
+        }
+      }
+    }
+  }
+  Base = E;
+  return true;
+}
+
+bool SymbolicBoundsProver::createRange(const BoundsExpr *Bounds,
+                                       SymbolicRange &R) {
+  const RangeBoundsExpr *RB = dyn_cast<RangeBoundsExpr>(Bounds);
+  if (!RB)
+    return false;
+  const Expr *UpperBase;
+  R = SymbolicRange();
+  return splitPointer(RB->getLowerExpr(), R.Base, R.Lower) &&
+         splitPointer(RB->getUpperExpr(), UpperBase, R.Upper) &&
+         equal(R.Base, UpperBase);
+}
+
+bool SymbolicBoundsProver::createAccessRange(const Expr *PtrBase,
+                                             const Expr *Offset,
+                                             SymbolicRange &R) {
+  const QualType PtrTy = PtrBase->getType();
+  if (!PtrTy->isPointerType())
+    return false;
+  const Type *Pointee = PtrTy->getPointeeOrArrayElementType();
+  if (Pointee->isIncompleteType())
+    return false;
+  int64_t Size =
+    Context.getTypeSizeInChars(QualType(Pointee, 0)).getQuantity();
+  R = SymbolicRange();
+  if (!splitPointer(PtrBase, R.Base, R.Lower))
+    return false;
+  if (Offset && !linearize(Offset, Size, R.Lower))
+    return false;
+  R.Upper = R.Lower;
+  return !AddOverflow(R.Upper.Constant, Size, R.Upper.Constant);
+}
+
+bool SymbolicBoundsProver::addToUpper(SymbolicRange &R, int64_t Bytes) {
+  return !AddOverflow(R.Upper.Constant, Bytes, R.Upper.Constant);
+}
+
+// Determine whether A <= B.
+Result SymbolicBoundsProver::compare(const LinearExpr &A,
+                                     const LinearExpr &B) {
+  LinearExpr Diff = B;
+  if (!add(Diff, A, -1) || !Diff.isConstant())
+    return Result::Maybe;
+  return Diff.Constant >= 0 ? Result::True : Result::False;
+}
+
+Result SymbolicBoundsProver::inRange(const SymbolicRange &Outer,
+                                     const SymbolicRange &Inner,
+                                     bool &LowerFails, bool &UpperFails) {
+  LowerFails = false;
+  UpperFails = false;
+  if (!equal(Outer.Base, Inner.Base))
+    return Result::Maybe;
+  Result Lower = compare(Outer.Lower, Inner.Lower);
+  Result Upper = compare(Inner.Upper, Outer.Upper);
+  if (Lower == Result::True && Upper == Result::True)
+    return Result::True;
+  LowerFails = Lower == Result::False;
+  UpperFails = Upper == Result::False;
+  if (LowerFails || UpperFails)
+    return Result::False;
+  return Result::Maybe;
+}
+
+Result SymbolicBoundsProver::notWider(const SymbolicRange &Narrow,
+                                      const SymbolicRange &Wide) {
+  LinearExpr NarrowWidth = Narrow.Upper;
+  LinearExpr WideWidth = Wide.Upper;
+  if (!add(NarrowWidth, Narrow.Lower, -1) || !add(WideWidth, Wide.Lower, -1))
+    return Result::Maybe;
+  return compare(NarrowWidth, WideWidth);
+}
+
+Result SymbolicBoundsProver::isEmpty(const SymbolicRange &R) {
+  return compare(R.Upper, R.Lower);
+}
@@ -76,16 +76,10 @@ bool QualType::isConstant(QualType T, const ASTContext &Ctx) {
 
 void BoundsAnnotations::Profile(llvm::FoldingSetNodeID &ID,
                                 const ASTContext &Ctx) const {
-  BoundsExpr *Bounds = getBoundsExpr();
-  InteropTypeExpr *IType = getInteropTypeExpr();
-  if (Bounds)
-    Bounds->Profile(ID, Ctx, true);
-  else
-    ID.AddPointer(nullptr);
-  if (IType)
-    IType->Profile(ID, Ctx, true);
-  else
-    ID.AddPointer(nullptr);
+  // ASTContext::getFunctionTypeInternal uniques the annotations of function
+  // types, so equivalent annotations have the same expressions.
+  ID.AddPointer(getBoundsExpr());
+  ID.AddPointer(getInteropTypeExpr());
 }
 
 unsigned ConstantArrayType::getNumAddressingBits(const ASTContext &Context,
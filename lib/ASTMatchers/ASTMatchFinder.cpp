@@ -19,6 +19,7 @@
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
+#include "clang/AST/ASTNodeIndex.h"
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/StringMap.h"
@@ -312,6 +313,8 @@ public:
   ~MatchASTVisitor() override {
     if (Options.CheckProfiling) {
       Options.CheckProfiling->Records = std::move(TimeByBucket);
+      if (Options.CheckProfiling->Counts)
+        *Options.CheckProfiling->Counts = std::move(CountsByBucket);
     }
   }
 
@@ -377,6 +380,22 @@ public:
     return true;
   }
 
+  // Matches the declarations and statements of the translation unit one kind
+  // after the other, skipping the kinds that no matcher can match.
+  void matchNodesByKind() {
+    ASTNodeIndex Index(*ActiveASTContext,
+                       /*IncludeTemplateInstantiations=*/true,
+                       /*IncludeImplicitCode=*/true);
+    // The traversal collects the aliases of the types as it goes; collect
+    // them all before matching instead.
+    for (TypedefNameDecl *DeclNode : Index.getDeclsOf<TypedefNameDecl>())
+      VisitTypedefNameDecl(DeclNode);
+    for (unsigned K = 0, E = Index.getNumDeclKinds(); K != E; ++K)
+      matchNodesOfKind(Index.getDecls(static_cast<Decl::Kind>(K)));
+    for (unsigned SC = 0, E = Index.getNumStmtClasses(); SC != E; ++SC)
+      matchNodesOfKind(Index.getStmts(static_cast<Stmt::StmtClass>(SC)));
+  }
+
   bool TraverseDecl(Decl *DeclNode);
   bool TraverseStmt(Stmt *StmtNode);
   bool TraverseType(QualType TypeNode);
@@ -535,12 +554,17 @@ private:
   template <typename T, typename MC>
   void matchWithoutFilter(const T &Node, const MC &Matchers) {
     const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
+    const bool EnableMatchCounts =
+        EnableCheckProfiling && Options.CheckProfiling->Counts;
     TimeBucketRegion Timer;
     for (const auto &MP : Matchers) {
       if (EnableCheckProfiling)
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
-      if (MP.first.matches(Node, this, &Builder)) {
+      bool Matched = MP.first.matches(Node, this, &Builder);
+      if (EnableMatchCounts)
+        countMatchAttempt(MP.second, Matched);
+      if (Matched) {
         MatchVisitor Visitor(ActiveASTContext, MP.second);
         Builder.visitMatches(&Visitor);
       }
@@ -557,6 +581,8 @@ private:
       return;
 
     const bool EnableCheckProfiling = Options.CheckProfiling.hasValue();
+    const bool EnableMatchCounts =
+        EnableCheckProfiling && Options.CheckProfiling->Counts;
     TimeBucketRegion Timer;
     auto &Matchers = this->Matchers->DeclOrStmt;
     for (unsigned short I : Filter) {
@@ -564,13 +590,40 @@ private:
       if (EnableCheckProfiling)
         Timer.setBucket(&TimeByBucket[MP.second->getID()]);
       BoundNodesTreeBuilder Builder;
-      if (MP.first.matchesNoKindCheck(DynNode, this, &Builder)) {
+      bool Matched = MP.first.matchesNoKindCheck(DynNode, this, &Builder);
+      if (EnableMatchCounts)
+        countMatchAttempt(MP.second, Matched);
+      if (Matched) {
         MatchVisitor Visitor(ActiveASTContext, MP.second);
         Builder.visitMatches(&Visitor);
       }
     }
   }
 
+  /// \brief Matches the nodes \p Nodes, which all have the same kind, unless
+  /// no matcher can match nodes of that kind.
+  template <typename T> void matchNodesOfKind(ArrayRef<T *> Nodes) {
+    if (Nodes.empty())
+      return;
+    auto Kind = ast_type_traits::ASTNodeKind::getFromNode(*Nodes.front());
+    auto it = MatcherFiltersMap.find(Kind);
+    const auto &Filter =
+        it != MatcherFiltersMap.end() ? it->second : getFilterForKind(Kind);
+    if (Filter.empty())
+      return;
+    for (T *Node : Nodes)
+      matchWithFilter(ast_type_traits::DynTypedNode::create(*Node));
+  }
+
+  /// \brief Records that the matcher of \p Callback was tried, and whether
+  /// it matched.
+  void countMatchAttempt(MatchFinder::MatchCallback *Callback, bool Matched) {
+    auto &Counts = CountsByBucket[Callback->getID()];
+    ++Counts.Attempts;
+    if (Matched)
+      ++Counts.Matches;
+  }
+
   const std::vector<unsigned short> &
   getFilterForKind(ast_type_traits::ASTNodeKind Kind) {
     auto &Filter = MatcherFiltersMap[Kind];
@@ -752,6 +805,10 @@ private:
   /// Used to get the appropriate bucket for each matcher.
   llvm::StringMap<llvm::TimeRecord> TimeByBucket;
 
+  /// \brief Bucket to match counts map, when the counts are requested.
+  llvm::StringMap<MatchFinder::MatchFinderOptions::Profiling::MatchCounts>
+      CountsByBucket;
+
   const MatchFinder::MatchersByType *Matchers;
 
   /// \brief Filtered list of matcher indices for each matcher kind.
@@ -1014,7 +1071,13 @@ void MatchFinder::matchAST(ASTContext &Context) {
   internal::MatchASTVisitor Visitor(&Matchers, Options);
   Visitor.set_active_ast_context(&Context);
   Visitor.onStartOfTranslationUnit();
-  Visitor.TraverseDecl(Context.getTranslationUnitDecl());
+  if (Options.MatchByNodeKind && Matchers.Type.empty() &&
+      Matchers.NestedNameSpecifier.empty() &&
+      Matchers.NestedNameSpecifierLoc.empty() && Matchers.TypeLoc.empty() &&
+      Matchers.CtorInit.empty())
+    Visitor.matchNodesByKind();
+  else
+    Visitor.TraverseDecl(Context.getTranslationUnitDecl());
   Visitor.onEndOfTranslationUnit();
 }
 
@@ -0,0 +1,443 @@
+//=--- BoundsWidening.cpp - Widening of null-terminated bounds -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  Determine for each program point in a function which variables with
+//  null-terminated array pointer types have declared bounds that can be
+//  widened by one element, because the element at their upper bound is
+//  known to be non-null.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Analysis/Analyses/BoundsWidening.h"
+#include "clang/Analysis/Analyses/PostOrderCFGView.h"
+#include "clang/Analysis/CFG.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Attr.h"
+#include "clang/AST/CanonBounds.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include <functional>
+#include <queue>
+
+using namespace clang;
+
+// Strip parentheses and implicit casts that do not change the value of E.
+static const Expr *IgnoreValuePreservingCasts(const Expr *E) {
+  while (true) {
+    E = E->IgnoreParens();
+    const ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(E);
+    if (!ICE)
+      return E;
+    CastKind CK = ICE->getCastKind();
+    if (CK != CK_LValueToRValue && CK != CK_NoOp && CK != CK_BitCast &&
+        CK != CK_IntegralCast)
+      return E;
+    E = ICE->getSubExpr();
+  }
+}
+
+// Return the variable that E reads, ignoring casts that do not change its
+// value, or null.
+static const VarDecl *GetReadVar(const Expr *E) {
+  if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(
+        IgnoreValuePreservingCasts(E)))
+    return dyn_cast<VarDecl>(DR->getDecl());
+  return nullptr;
+}
+
+// Split a pointer expression E into a base pointer and an integer offset,
+// which is null if E is not a pointer addition.
+static void SplitPointer(const Expr *E, const Expr *&Base,
+                         const Expr *&Offset) {
+  E = IgnoreValuePreservingCasts(E);
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(E))
+    if (BO->getOpcode() == BO_Add) {
+      if (BO->getLHS()->getType()->isPointerType()) {
+        Base = BO->getLHS();
+        Offset = BO->getRHS();
+        return;
+      }
+      if (BO->getRHS()->getType()->isPointerType()) {
+        Base = BO->getRHS();
+        Offset = BO->getLHS();
+        return;
+      }
+    }
+  Base = E;
+  Offset = nullptr;
+}
+
+// Returns true if the value of V can only be changed by its declaration and
+// assignments to it, provided that its address is not taken.
+static bool IsTrackableVar(const VarDecl *V) {
+  return V->hasLocalStorage() && !V->hasAttr<BlocksAttr>() &&
+         !V->getType().isVolatileQualified();
+}
+
+namespace {
+  // Collect the variables used by an upper bound expression.
+  class CollectVars : public RecursiveASTVisitor<CollectVars> {
+  public:
+    SmallVector<const VarDecl *, 2> Vars;
+    bool VisitDeclRefExpr(DeclRefExpr *DR) {
+      if (const VarDecl *V = dyn_cast<VarDecl>(DR->getDecl()))
+        Vars.push_back(V);
+      return true;
+    }
+  };
+}
+
+BoundsWidening::BoundsWidening(ASTContext &Ctx, const CFG &Cfg)
+    : Context(Ctx), Cfg(Cfg), CursorPos(0, 0), CursorValid(false) {
+  collectVariables();
+  solve();
+}
+
+// Number the tracked variables and record where each statement occurs in
+// the CFG.
+void BoundsWidening::collectVariables() {
+  llvm::SetVector<const VarDecl *> Candidates;
+  llvm::SmallPtrSet<const VarDecl *, 8> AddressTaken;
+  BlocksByID.resize(Cfg.getNumBlockIDs());
+  for (const CFGBlock *Block : Cfg) {
+    BlocksByID[Block->getBlockID()] = Block;
+    unsigned Index = 0;
+    for (const CFGElement &Elem : *Block) {
+      Position Pos(Block->getBlockID(), Index++);
+      Optional<CFGStmt> CS = Elem.getAs<CFGStmt>();
+      if (!CS)
+        continue;
+      const Stmt *S = CS->getStmt();
+      StmtPositions.insert(std::make_pair(S, Pos));
+      if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+        for (const Decl *D : DS->decls())
+          if (const VarDecl *VD = dyn_cast<VarDecl>(D))
+            Candidates.insert(VD);
+      } else if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(S)) {
+        if (const VarDecl *VD = dyn_cast<VarDecl>(DR->getDecl()))
+          Candidates.insert(VD);
+      } else if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+        if (UO->getOpcode() == UO_AddrOf)
+          if (const VarDecl *VD = GetReadVar(UO->getSubExpr()))
+            AddressTaken.insert(VD);
+      }
+    }
+  }
+
+  for (const VarDecl *V : Candidates) {
+    if (!V->getType()->isCheckedPointerNtArrayType() || !IsTrackableVar(V) ||
+        AddressTaken.count(V))
+      continue;
+    const BoundsExpr *B = V->getBoundsExpr();
+    if (!B)
+      continue;
+    UpperBound Upper;
+    if (const CountBoundsExpr *CB = dyn_cast<CountBoundsExpr>(B)) {
+      if (!CB->isElementCount())
+        continue;
+      Upper.Base = nullptr;
+      Upper.Offset = CB->getCountExpr();
+    } else if (const RangeBoundsExpr *RB = dyn_cast<RangeBoundsExpr>(B)) {
+      SplitPointer(RB->getUpperExpr(), Upper.Base, Upper.Offset);
+    } else
+      continue;
+
+    // The facts for V end when a variable used by its upper bound changes,
+    // so those variables must be trackable too.
+    CollectVars Collector;
+    Collector.TraverseStmt(const_cast<BoundsExpr *>(B));
+    bool Trackable = true;
+    for (const VarDecl *Used : Collector.Vars)
+      if (Used != V && (!IsTrackableVar(Used) || AddressTaken.count(Used))) {
+        Trackable = false;
+        break;
+      }
+    if (!Trackable)
+      continue;
+
+    unsigned Index = Vars.size();
+    VarIndices[V] = Index;
+    Vars.push_back(V);
+    UpperBounds.push_back(Upper);
+    Dependents[V].push_back(Index);
+    for (const VarDecl *Used : Collector.Vars) {
+      SmallVector<unsigned, 2> &Deps = Dependents[Used];
+      if (std::find(Deps.begin(), Deps.end(), Index) == Deps.end())
+        Deps.push_back(Index);
+    }
+  }
+}
+
+// End the facts that depend on Target, if it is a variable.
+void BoundsWidening::kill(llvm::BitVector &Facts, const Expr *Target) const {
+  const VarDecl *V = GetReadVar(Target);
+  if (!V)
+    return;
+  auto It = Dependents.find(V);
+  if (It == Dependents.end())
+    return;
+  for (unsigned Index : It->second)
+    Facts.reset(Index);
+}
+
+// Update the facts for the evaluation of the CFG element S.
+void BoundsWidening::transfer(llvm::BitVector &Facts, const Stmt *S) const {
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+    if (BO->isAssignmentOp())
+      kill(Facts, BO->getLHS());
+  } else if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+    if (UO->isIncrementDecrementOp())
+      kill(Facts, UO->getSubExpr());
+  } else if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+    for (const Decl *D : DS->decls()) {
+      const VarDecl *VD = dyn_cast<VarDecl>(D);
+      if (!VD)
+        continue;
+      auto It = Dependents.find(VD);
+      if (It != Dependents.end())
+        for (unsigned Index : It->second)
+          Facts.reset(Index);
+    }
+  }
+}
+
+// Returns true if E1 and E2 are integer offsets or pointers with the same
+// value.  A null offset is zero.
+bool BoundsWidening::isSameValue(const Expr *E1, const Expr *E2) {
+  llvm::APSInt Value1, Value2;
+  bool Constant1 = !E1 || (!E1->isValueDependent() &&
+                           E1->getType()->isIntegerType() &&
+                           E1->EvaluateAsInt(Value1, Context));
+  bool Constant2 = !E2 || (!E2->isValueDependent() &&
+                           E2->getType()->isIntegerType() &&
+                           E2->EvaluateAsInt(Value2, Context));
+  if (Constant1 || Constant2) {
+    if (!Constant1 || !Constant2)
+      return false;
+    if (!E1)
+      return !E2 || Value2 == 0;
+    if (!E2)
+      return Value1 == 0;
+    return llvm::APSInt::isSameValue(Value1, Value2);
+  }
+  return Lexicographic(Context, nullptr).EqualExprs(
+    IgnoreValuePreservingCasts(E1), IgnoreValuePreservingCasts(E2));
+}
+
+// Return the index of the tracked variable whose upper bound element Cond
+// reads, or -1.
+int BoundsWidening::getTestedVar(const Expr *Cond) {
+  const Expr *Base, *Offset;
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(Cond)) {
+    if (UO->getOpcode() != UO_Deref)
+      return -1;
+    SplitPointer(UO->getSubExpr(), Base, Offset);
+  } else if (const ArraySubscriptExpr *AS =
+               dyn_cast<ArraySubscriptExpr>(Cond)) {
+    Base = AS->getBase();
+    Offset = AS->getIdx();
+  } else
+    return -1;
+
+  const VarDecl *V = GetReadVar(Base);
+  if (!V)
+    return -1;
+  auto It = VarIndices.find(V);
+  if (It == VarIndices.end())
+    return -1;
+  const UpperBound &Upper = UpperBounds[It->second];
+  // A count bounds expression has the variable itself as its base.
+  if (Upper.Base && !isSameValue(Base, Upper.Base))
+    return -1;
+  if (!isSameValue(Offset, Upper.Offset))
+    return -1;
+  return It->second;
+}
+
+// Add to Facts what the condition of the terminator of Block implies on the
+// true or false branch from Block.
+void BoundsWidening::applyCondition(llvm::BitVector &Facts,
+                                    const CFGBlock *Block, bool TrueBranch) {
+  std::function<void(const Expr *, bool)> Apply =
+    [&](const Expr *Cond, bool Branch) {
+      Cond = Cond->IgnoreParenImpCasts();
+      if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(Cond))
+        if (UO->getOpcode() == UO_LNot)
+          return Apply(UO->getSubExpr(), !Branch);
+      if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(Cond)) {
+        BinaryOperatorKind Op = BO->getOpcode();
+        if ((Op == BO_LAnd && Branch) || (Op == BO_LOr && !Branch)) {
+          Apply(BO->getLHS(), Branch);
+          Apply(BO->getRHS(), Branch);
+          return;
+        }
+        if (Op == BO_EQ || Op == BO_NE) {
+          // e == 0 and e != 0, in either order.
+          llvm::APSInt Value;
+          const Expr *Tested = nullptr;
+          const Expr *RHS = BO->getRHS(), *LHS = BO->getLHS();
+          if (!RHS->isValueDependent() && RHS->EvaluateAsInt(Value, Context) &&
+              Value == 0)
+            Tested = LHS;
+          else if (!LHS->isValueDependent() &&
+                   LHS->EvaluateAsInt(Value, Context) && Value == 0)
+            Tested = RHS;
+          if (Tested)
+            Apply(Tested, Op == BO_NE ? Branch : !Branch);
+          return;
+        }
+      }
+      if (Branch) {
+        int Index = getTestedVar(Cond);
+        if (Index >= 0)
+          Facts.set(Index);
+      }
+    };
+
+  const Stmt *Terminator = Block->getTerminator().getStmt();
+  if (!Terminator || isa<SwitchStmt>(Terminator) ||
+      isa<IndirectGotoStmt>(Terminator))
+    return;
+  if (const Expr *Cond =
+        dyn_cast_or_null<Expr>(Block->getTerminatorCondition()))
+    Apply(Cond, TrueBranch);
+}
+
+// Compute the facts at the entry of each block, in the same way as VarEquiv,
+// but with the facts along an edge from a conditional branch extended by
+// what its condition implies.  The facts are met by intersection.
+void BoundsWidening::solve() {
+  unsigned NumBlockIDs = Cfg.getNumBlockIDs();
+  BlockEntryFacts.resize(NumBlockIDs);
+  Reachable.resize(NumBlockIDs, false);
+  if (Vars.empty())
+    return;
+
+  std::vector<llvm::BitVector> ExitFacts(NumBlockIDs);
+  std::vector<bool> HasExit(NumBlockIDs, false);
+
+  PostOrderCFGView POV(&Cfg);
+  std::vector<const CFGBlock *> Blocks;
+  std::vector<unsigned> Order(NumBlockIDs, 0);
+  for (const CFGBlock *Block : POV) {
+    Order[Block->getBlockID()] = Blocks.size();
+    Blocks.push_back(Block);
+  }
+
+  std::priority_queue<unsigned, std::vector<unsigned>,
+                      std::greater<unsigned>> Worklist;
+  llvm::BitVector Queued(Blocks.size(), true);
+  for (unsigned I = 0, E = Blocks.size(); I != E; ++I)
+    Worklist.push(I);
+
+  unsigned NumVars = Vars.size();
+  llvm::BitVector Facts(NumVars), Edge(NumVars);
+  while (!Worklist.empty()) {
+    unsigned Number = Worklist.top();
+    Worklist.pop();
+    Queued.reset(Number);
+    const CFGBlock *Block = Blocks[Number];
+    unsigned ID = Block->getBlockID();
+
+    bool First = true;
+    for (CFGBlock::const_pred_iterator I = Block->pred_begin(),
+           E = Block->pred_end(); I != E; ++I) {
+      const CFGBlock *Pred = *I;
+      if (!Pred || !HasExit[Pred->getBlockID()])
+        continue;
+      Edge = ExitFacts[Pred->getBlockID()];
+      // An edge taken on one outcome of a two-way branch.
+      if (Pred->succ_size() == 2) {
+        const CFGBlock *TrueSucc = *Pred->succ_begin();
+        const CFGBlock *FalseSucc = *(Pred->succ_begin() + 1);
+        if (TrueSucc != FalseSucc)
+          applyCondition(Edge, Pred, Block == TrueSucc);
+      }
+      if (First)
+        Facts = Edge;
+      else
+        Facts &= Edge;
+      First = false;
+    }
+    if (First)
+      Facts.reset();
+
+    BlockEntryFacts[ID] = Facts;
+    Reachable[ID] = true;
+
+    for (const CFGElement &Elem : *Block)
+      if (Optional<CFGStmt> CS = Elem.getAs<CFGStmt>())
+        transfer(Facts, CS->getStmt());
+
+    if (HasExit[ID] && ExitFacts[ID] == Facts)
+      continue;
+    HasExit[ID] = true;
+    ExitFacts[ID] = Facts;
+
+    for (CFGBlock::const_succ_iterator I = Block->succ_begin(),
+           E = Block->succ_end(); I != E; ++I) {
+      const CFGBlock *Succ = *I;
+      if (!Succ || Queued.test(Order[Succ->getBlockID()]))
+        continue;
+      Queued.set(Order[Succ->getBlockID()]);
+      Worklist.push(Order[Succ->getBlockID()]);
+    }
+  }
+}
+
+// Compute the facts before the element at Pos in Cursor.  Returns false if
+// the block is unreachable.
+bool BoundsWidening::moveCursorTo(Position Pos) {
+  if (!Reachable[Pos.first])
+    return false;
+  if (!CursorValid || CursorPos.first != Pos.first ||
+      CursorPos.second > Pos.second) {
+    Cursor = BlockEntryFacts[Pos.first];
+    CursorPos = Position(Pos.first, 0);
+    CursorValid = true;
+  }
+
+  const CFGBlock *Block = BlocksByID[Pos.first];
+  while (CursorPos.second < Pos.second) {
+    CFGElement Elem = (*Block)[CursorPos.second];
+    if (Optional<CFGStmt> CS = Elem.getAs<CFGStmt>())
+      transfer(Cursor, CS->getStmt());
+    ++CursorPos.second;
+  }
+  return true;
+}
+
+bool BoundsWidening::isWidenedBefore(const Stmt *S, const VarDecl *V) {
+  auto Var = VarIndices.find(V);
+  if (Var == VarIndices.end())
+    return false;
+  auto It = StmtPositions.find(S);
+  if (It == StmtPositions.end() || !moveCursorTo(It->second))
+    return false;
+  return Cursor.test(Var->second);
+}
+
+void BoundsWidening::dump(raw_ostream &OS) const {
+  for (const CFGBlock *Block : BlocksByID) {
+    if (!Block)
+      continue;
+    OS << "Block B" << Block->getBlockID() << ":";
+    if (!Reachable[Block->getBlockID()]) {
+      OS << " unreachable\n";
+      continue;
+    }
+    const llvm::BitVector &Entry = BlockEntryFacts[Block->getBlockID()];
+    if (Entry.none())
+      OS << " no widened bounds";
+    for (int I = Entry.find_first(); I >= 0; I = Entry.find_next(I))
+      OS << " " << Vars[I]->getName();
+    OS << "\n";
+  }
+}
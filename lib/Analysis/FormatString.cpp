@@ -951,3 +951,193 @@ bool FormatSpecifier::namedTypeToLengthModifier(QualType QT,
   }
   return false;
 }
+
+//===----------------------------------------------------------------------===//
+// Methods on ParsedFormatString.
+//===----------------------------------------------------------------------===//
+
+namespace clang {
+namespace analyze_format_string {
+/// Records the callbacks of the parsing of a format string, and lets the
+/// parsing go on after each of them.
+class ParsedFormatString::Recorder : public FormatStringHandler {
+  ParsedFormatString &P;
+
+  Callback &add(CallbackKind Kind, const char *Start = nullptr,
+                unsigned Len = 0) {
+    P.Callbacks.push_back(Callback(Kind));
+    Callback &C = P.Callbacks.back();
+    C.Start = Start;
+    C.Len = Len;
+    return C;
+  }
+
+  bool addPrintf(CallbackKind Kind, const analyze_printf::PrintfSpecifier &FS,
+                 const char *Start, unsigned Len) {
+    add(Kind, Start, Len).Specifier = P.PrintfSpecifiers.size();
+    P.PrintfSpecifiers.push_back(FS);
+    return true;
+  }
+
+  bool addScanf(CallbackKind Kind, const analyze_scanf::ScanfSpecifier &FS,
+                const char *Start, unsigned Len) {
+    add(Kind, Start, Len).Specifier = P.ScanfSpecifiers.size();
+    P.ScanfSpecifiers.push_back(FS);
+    return true;
+  }
+
+public:
+  Recorder(ParsedFormatString &P) : P(P) {}
+
+  void HandleNullChar(const char *nullCharacter) override {
+    add(NullChar, nullCharacter);
+  }
+
+  void HandlePosition(const char *startPos, unsigned posLen) override {
+    add(Position, startPos, posLen);
+  }
+
+  void HandleInvalidPosition(const char *startPos, unsigned posLen,
+                             PositionContext p) override {
+    add(InvalidPosition, startPos, posLen).Context = p;
+  }
+
+  void HandleZeroPosition(const char *startPos, unsigned posLen) override {
+    add(ZeroPosition, startPos, posLen);
+  }
+
+  void HandleIncompleteSpecifier(const char *startSpecifier,
+                                 unsigned specifierLen) override {
+    add(IncompleteSpecifier, startSpecifier, specifierLen);
+  }
+
+  void HandleEmptyObjCModifierFlag(const char *startFlags,
+                                   unsigned flagsLen) override {
+    add(EmptyObjCModifierFlag, startFlags, flagsLen);
+  }
+
+  void HandleInvalidObjCModifierFlag(const char *startFlag,
+                                     unsigned flagLen) override {
+    add(InvalidObjCModifierFlag, startFlag, flagLen);
+  }
+
+  void HandleObjCFlagsWithNonObjCConversion(
+      const char *flagsStart, const char *flagsEnd,
+      const char *conversionPosition) override {
+    Callback &C = add(ObjCFlagsWithNonObjCConversion, flagsStart);
+    C.End = flagsEnd;
+    C.Pos = conversionPosition;
+  }
+
+  bool HandleInvalidPrintfConversionSpecifier(
+      const analyze_printf::PrintfSpecifier &FS, const char *startSpecifier,
+      unsigned specifierLen) override {
+    return addPrintf(InvalidPrintfConversionSpecifier, FS, startSpecifier,
+                     specifierLen);
+  }
+
+  bool HandlePrintfSpecifier(const analyze_printf::PrintfSpecifier &FS,
+                             const char *startSpecifier,
+                             unsigned specifierLen) override {
+    return addPrintf(PrintfSpecifier, FS, startSpecifier, specifierLen);
+  }
+
+  bool HandleInvalidScanfConversionSpecifier(
+      const analyze_scanf::ScanfSpecifier &FS, const char *startSpecifier,
+      unsigned specifierLen) override {
+    return addScanf(InvalidScanfConversionSpecifier, FS, startSpecifier,
+                    specifierLen);
+  }
+
+  bool HandleScanfSpecifier(const analyze_scanf::ScanfSpecifier &FS,
+                            const char *startSpecifier,
+                            unsigned specifierLen) override {
+    return addScanf(ScanfSpecifier, FS, startSpecifier, specifierLen);
+  }
+
+  void HandleIncompleteScanList(const char *start, const char *end) override {
+    add(IncompleteScanList, start).End = end;
+  }
+};
+} // end namespace analyze_format_string
+} // end namespace clang
+
+using clang::analyze_format_string::ParsedFormatString;
+
+ParsedFormatString
+ParsedFormatString::parsePrintf(const char *beg, const char *end,
+                                const LangOptions &LO,
+                                const TargetInfo &Target,
+                                bool isFreeBSDKPrintf) {
+  ParsedFormatString P;
+  Recorder R(P);
+  P.Stopped = ParsePrintfString(R, beg, end, LO, Target, isFreeBSDKPrintf);
+  return P;
+}
+
+ParsedFormatString ParsedFormatString::parseScanf(const char *beg,
+                                                  const char *end,
+                                                  const LangOptions &LO,
+                                                  const TargetInfo &Target) {
+  ParsedFormatString P;
+  Recorder R(P);
+  P.Stopped = ParseScanfString(R, beg, end, LO, Target);
+  return P;
+}
+
+bool ParsedFormatString::replay(FormatStringHandler &H) const {
+  // The recorder let the parsing go on after each callback that returns
+  // whether to go on, so the replay stops where H stops it.
+  for (const Callback &C : Callbacks) {
+    switch (C.Kind) {
+    case NullChar:
+      H.HandleNullChar(C.Start);
+      break;
+    case Position:
+      H.HandlePosition(C.Start, C.Len);
+      break;
+    case InvalidPosition:
+      H.HandleInvalidPosition(C.Start, C.Len, C.Context);
+      break;
+    case ZeroPosition:
+      H.HandleZeroPosition(C.Start, C.Len);
+      break;
+    case IncompleteSpecifier:
+      H.HandleIncompleteSpecifier(C.Start, C.Len);
+      break;
+    case EmptyObjCModifierFlag:
+      H.HandleEmptyObjCModifierFlag(C.Start, C.Len);
+      break;
+    case InvalidObjCModifierFlag:
+      H.HandleInvalidObjCModifierFlag(C.Start, C.Len);
+      break;
+    case ObjCFlagsWithNonObjCConversion:
+      H.HandleObjCFlagsWithNonObjCConversion(C.Start, C.End, C.Pos);
+      break;
+    case InvalidPrintfConversionSpecifier:
+      if (!H.HandleInvalidPrintfConversionSpecifier(
+              PrintfSpecifiers[C.Specifier], C.Start, C.Len))
+        return true;
+      break;
+    case PrintfSpecifier:
+      if (!H.HandlePrintfSpecifier(PrintfSpecifiers[C.Specifier], C.Start,
+                                   C.Len))
+        return true;
+      break;
+    case InvalidScanfConversionSpecifier:
+      if (!H.HandleInvalidScanfConversionSpecifier(
+              ScanfSpecifiers[C.Specifier], C.Start, C.Len))
+        return true;
+      break;
+    case ScanfSpecifier:
+      if (!H.HandleScanfSpecifier(ScanfSpecifiers[C.Specifier], C.Start,
+                                  C.Len))
+        return true;
+      break;
+    case IncompleteScanList:
+      H.HandleIncompleteScanList(C.Start, C.End);
+      break;
+    }
+  }
+  return Stopped;
+}
@@ -21,13 +21,19 @@
 #include "clang/Analysis/AnalysisDeclContext.h"
 #include "clang/Analysis/CFG.h"
 #include "clang/Analysis/DomainSpecific/ObjCNoReturn.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/FoldingSet.h"
 #include "llvm/ADT/Optional.h"
-#include "llvm/ADT/PackedVector.h"
-#include "llvm/ADT/SmallBitVector.h"
+#include "llvm/ADT/PriorityQueue.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/SaveAndRestore.h"
+#include <algorithm>
+#include <functional>
 #include <utility>
+#include <vector>
 
 using namespace clang;
 
@@ -102,25 +108,110 @@ static bool isAlwaysUninit(const Value v) {
 
 namespace {
 
-typedef llvm::PackedVector<Value, 2, llvm::SmallBitVector> ValueVector;
+/// The values of the tracked variables, two bits per variable, packed into
+/// words so that vectors are merged and compared a word at a time.
+class ValueVector {
+public:
+  typedef uint64_t Word;
+  enum { ValuesPerWord = 32 };
+
+  class reference {
+    ValueVector &vec;
+    unsigned idx;
+  public:
+    reference(ValueVector &vec, unsigned idx) : vec(vec), idx(idx) {}
+    reference &operator=(Value v) {
+      vec.set(idx, v);
+      return *this;
+    }
+    operator Value() const { return vec.get(idx); }
+  };
+
+  ValueVector() : numValues(0) {}
+
+  unsigned size() const { return numValues; }
+  void resize(unsigned n) {
+    numValues = n;
+    words.resize((n + ValuesPerWord - 1) / ValuesPerWord);
+  }
+  void reset() { std::fill(words.begin(), words.end(), 0); }
+
+  /// Return the value of the variable with index \p i from the word that
+  /// holds it.
+  static Value getFromWord(Word w, unsigned i) {
+    return Value((w >> getShift(i)) & 0x3);
+  }
+
+  Value get(unsigned i) const {
+    return getFromWord(words[i / ValuesPerWord], i);
+  }
+  void set(unsigned i, Value v) {
+    Word &w = words[i / ValuesPerWord];
+    w = (w & ~(Word(0x3) << getShift(i))) | (Word(v) << getShift(i));
+  }
+
+  Value operator[](unsigned i) const { return get(i); }
+  reference operator[](unsigned i) { return reference(*this, i); }
+
+  ArrayRef<Word> getWords() const { return words; }
+  MutableArrayRef<Word> getWords() { return words; }
+
+private:
+  static unsigned getShift(unsigned i) { return 2 * (i % ValuesPerWord); }
+
+  SmallVector<Word, 4> words;
+  unsigned numValues;
+};
+
+/// The values of ChunkWords consecutive words of the vector of a block.  A
+/// block usually changes the values of only a few of the variables, so the
+/// chunks are uniqued and shared between all the blocks that have the same
+/// values for them.  For a huge function, the memory for the values then
+/// grows with what the blocks change rather than with the number of
+/// variables times the number of blocks.
+class ValueChunk : public llvm::FoldingSetNode {
+public:
+  enum { ChunkWords = 8 };
+  ValueVector::Word words[ChunkWords];
+
+  void Profile(llvm::FoldingSetNodeID &ID) const { Profile(ID, words); }
+
+  static void Profile(llvm::FoldingSetNodeID &ID,
+                      const ValueVector::Word *words) {
+    for (unsigned i = 0; i != ChunkWords; ++i)
+      ID.AddInteger(words[i]);
+  }
+};
 
 class CFGBlockValues {
   const CFG &cfg;
-  SmallVector<ValueVector, 8> vals;
+  /// The chunks of the values at the end of each block, numChunks of them
+  /// per block.  A null chunk has all of its values Unknown, which is what
+  /// the blocks start with.
+  std::vector<const ValueChunk *> vals;
+  unsigned numChunks;
+  llvm::FoldingSet<ValueChunk> chunks;
+  llvm::BumpPtrAllocator chunkAllocator;
   ValueVector scratch;
   DeclToIndex declToIndex;
+
+  const ValueChunk **getChunks(const CFGBlock *block) {
+    return vals.data() + block->getBlockID() * numChunks;
+  }
+
+  /// Return the unique chunk with the values of \p words, or null if they
+  /// are all Unknown.
+  const ValueChunk *getChunk(const ValueVector::Word *words);
+
 public:
   CFGBlockValues(const CFG &cfg);
 
   unsigned getNumEntries() const { return declToIndex.size(); }
   
   void computeSetOfDeclarations(const DeclContext &dc);  
-  ValueVector &getValueVector(const CFGBlock *block) {
-    return vals[block->getBlockID()];
-  }
 
   void setAllScratchValues(Value V);
-  void mergeIntoScratch(ValueVector const &source, bool isFirst);
+  void mergeIntoScratch(const CFGBlock *block, bool isFirst);
   bool updateValueVectorWithScratch(const CFGBlock *block);
   
   bool hasNoDeclarations() const {
@@ -135,12 +226,18 @@ public:
                  const VarDecl *vd) {
     const Optional<unsigned> &idx = declToIndex.getValueIndex(vd);
     assert(idx.hasValue());
-    return getValueVector(block)[idx.getValue()];
+    unsigned wordIdx = idx.getValue() / ValueVector::ValuesPerWord;
+    const ValueChunk *chunk =
+        getChunks(block)[wordIdx / ValueChunk::ChunkWords];
+    if (!chunk)
+      return Unknown;
+    return ValueVector::getFromWord(
+        chunk->words[wordIdx % ValueChunk::ChunkWords], idx.getValue());
   }
 };  
 } // end anonymous namespace
 
-CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c), vals(0) {}
+CFGBlockValues::CFGBlockValues(const CFG &c) : cfg(c), numChunks(0) {}
 
 void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc) {
   declToIndex.computeMap(dc);
@@ -149,13 +246,28 @@ void CFGBlockValues::computeSetOfDeclarations(const DeclContext &dc) {
   unsigned n = cfg.getNumBlockIDs();
   if (!n)
     return;
-  vals.resize(n);
-  for (unsigned i = 0; i < n; ++i)
-    vals[i].resize(decls);
+  numChunks = (scratch.getWords().size() + ValueChunk::ChunkWords - 1) /
+              ValueChunk::ChunkWords;
+  vals.assign(n * numChunks, nullptr);
+}
+
+const ValueChunk *CFGBlockValues::getChunk(const ValueVector::Word *words) {
+  if (std::all_of(words, words + ValueChunk::ChunkWords,
+                  [](ValueVector::Word w) { return w == 0; }))
+    return nullptr;
+  llvm::FoldingSetNodeID ID;
+  ValueChunk::Profile(ID, words);
+  void *insertPos;
+  if (ValueChunk *chunk = chunks.FindNodeOrInsertPos(ID, insertPos))
+    return chunk;
+  ValueChunk *chunk = new (chunkAllocator) ValueChunk();
+  std::copy(words, words + ValueChunk::ChunkWords, chunk->words);
+  chunks.InsertNode(chunk, insertPos);
+  return chunk;
 }
 
 #if DEBUG_LOGGING
-static void printVector(const CFGBlock *block, ValueVector &bv,
+static void printVector(const CFGBlock *block, const ValueVector &bv,
                         unsigned num) {
   llvm::errs() << block->getBlockID() << " :";
   for (unsigned i = 0; i < bv.size(); ++i) {
@@ -170,19 +282,48 @@ void CFGBlockValues::setAllScratchValues(Value V) {
     scratch[I] = V;
 }
 
-void CFGBlockValues::mergeIntoScratch(ValueVector const &source,
-                                      bool isFirst) {
-  if (isFirst)
-    scratch = source;
-  else
-    scratch |= source;
+void CFGBlockValues::mergeIntoScratch(const CFGBlock *block, bool isFirst) {
+  MutableArrayRef<ValueVector::Word> dst = scratch.getWords();
+  const ValueChunk **src = getChunks(block);
+  for (unsigned c = 0; c != numChunks; ++c) {
+    unsigned begin = c * ValueChunk::ChunkWords;
+    unsigned end = std::min<unsigned>(begin + ValueChunk::ChunkWords,
+                                      dst.size());
+    const ValueChunk *chunk = src[c];
+    if (!chunk) {
+      if (isFirst)
+        std::fill(dst.begin() + begin, dst.begin() + end, 0);
+      continue;
+    }
+    for (unsigned i = begin; i != end; ++i) {
+      if (isFirst)
+        dst[i] = chunk->words[i - begin];
+      else
+        dst[i] |= chunk->words[i - begin];
+    }
+  }
 }
 
 bool CFGBlockValues::updateValueVectorWithScratch(const CFGBlock *block) {
-  ValueVector &dst = getValueVector(block);
-  bool changed = (dst != scratch);
-  if (changed)
-    dst = scratch;
+  ArrayRef<ValueVector::Word> src = scratch.getWords();
+  const ValueChunk **dst = getChunks(block);
+  bool changed = false;
+  // Only the chunks that differ from the current values of the block are
+  // looked up again.
+  for (unsigned c = 0; c != numChunks; ++c) {
+    ValueVector::Word words[ValueChunk::ChunkWords] = {};
+    unsigned begin = c * ValueChunk::ChunkWords;
+    unsigned end = std::min<unsigned>(begin + ValueChunk::ChunkWords,
+                                      src.size());
+    std::copy(src.begin() + begin, src.begin() + end, words);
+    const ValueChunk *chunk = dst[c];
+    if (chunk ? std::equal(words, words + ValueChunk::ChunkWords, chunk->words)
+              : std::all_of(words, words + ValueChunk::ChunkWords,
+                            [](ValueVector::Word w) { return w == 0; }))
+      continue;
+    dst[c] = getChunk(words);
+    changed = true;
+  }
 #if DEBUG_LOGGING
   printVector(block, scratch, 0);
 #endif
@@ -204,56 +345,70 @@ ValueVector::reference CFGBlockValues::operator[](const VarDecl *vd) {
 //====------------------------------------------------------------------------//
 
 namespace {
+/// A worklist that always hands out the block that comes first in reverse
+/// post order.  Blocks are enqueued again only when the values of one of
+/// their predecessors change, and an update along a back edge is propagated
+/// through the loop body in order, so that each block is visited with the
+/// values of as many of its predecessors as possible.
 class DataflowWorklist {
-  PostOrderCFGView::iterator PO_I, PO_E;
-  SmallVector<const CFGBlock *, 20> worklist;
+  /// The reachable blocks, in reverse post order.
+  SmallVector<const CFGBlock *, 20> blocks;
+  /// The position in reverse post order of each block, by block ID.
+  SmallVector<unsigned, 20> blockOrder;
+  llvm::PriorityQueue<unsigned, SmallVector<unsigned, 20>,
+                      std::greater<unsigned>> worklist;
   llvm::BitVector enqueuedBlocks;
+  llvm::BitVector reachableBlocks;
+
+  void enqueueBlock(const CFGBlock *block);
+
 public:
-  DataflowWorklist(const CFG &cfg, PostOrderCFGView &view)
-    : PO_I(view.begin()), PO_E(view.end()),
-      enqueuedBlocks(cfg.getNumBlockIDs(), true) {
-        // Treat the first block as already analyzed.
-        if (PO_I != PO_E) {
-          assert(*PO_I == &cfg.getEntry());
-          enqueuedBlocks[(*PO_I)->getBlockID()] = false;
-          ++PO_I;
-        }
-      }
+  DataflowWorklist(const CFG &cfg, PostOrderCFGView &view);
   
   void enqueueSuccessors(const CFGBlock *block);
   const CFGBlock *dequeue();
 };
 }
 
+DataflowWorklist::DataflowWorklist(const CFG &cfg, PostOrderCFGView &view)
+    : blockOrder(cfg.getNumBlockIDs()),
+      enqueuedBlocks(cfg.getNumBlockIDs()),
+      reachableBlocks(cfg.getNumBlockIDs()) {
+  for (PostOrderCFGView::iterator I = view.begin(), E = view.end(); I != E;
+       ++I) {
+    const CFGBlock *block = *I;
+    blockOrder[block->getBlockID()] = blocks.size();
+    reachableBlocks[block->getBlockID()] = true;
+    blocks.push_back(block);
+  }
+  // Treat the first block as already analyzed, and visit all the others at
+  // least once.
+  assert(blocks.empty() || blocks.front() == &cfg.getEntry());
+  for (unsigned i = 1, e = blocks.size(); i < e; ++i)
+    enqueueBlock(blocks[i]);
+}
+
+void DataflowWorklist::enqueueBlock(const CFGBlock *block) {
+  unsigned id = block->getBlockID();
+  if (!reachableBlocks[id] || enqueuedBlocks[id])
+    return;
+  worklist.push(blockOrder[id]);
+  enqueuedBlocks[id] = true;
+}
+
 void DataflowWorklist::enqueueSuccessors(const clang::CFGBlock *block) {
   for (CFGBlock::const_succ_iterator I = block->succ_begin(),
        E = block->succ_end(); I != E; ++I) {
-    const CFGBlock *Successor = *I;
-    if (!Successor || enqueuedBlocks[Successor->getBlockID()])
-      continue;
-    worklist.push_back(Successor);
-    enqueuedBlocks[Successor->getBlockID()] = true;
+    if (const CFGBlock *Successor = *I)
+      enqueueBlock(Successor);
   }
 }
 
 const CFGBlock *DataflowWorklist::dequeue() {
-  const CFGBlock *B = nullptr;
-
-  // First dequeue from the worklist.  This can represent
-  // updates along backedges that we want propagated as quickly as possible.
-  if (!worklist.empty())
-    B = worklist.pop_back_val();
-
-  // Next dequeue from the initial reverse post order.  This is the
-  // theoretical ideal in the presence of no back edges.
-  else if (PO_I != PO_E) {
-    B = *PO_I;
-    ++PO_I;
-  }
-  else {
+  if (worklist.empty())
     return nullptr;
-  }
-
+  const CFGBlock *B = blocks[worklist.top()];
+  worklist.pop();
   assert(enqueuedBlocks[B->getBlockID()] == true);
   enqueuedBlocks[B->getBlockID()] = false;
   return B;
@@ -809,7 +964,7 @@ static bool runOnBlock(const CFGBlock *block, const CFG &cfg,
     if (!pred)
       continue;
     if (wasAnalyzed[pred->getBlockID()]) {
-      vals.mergeIntoScratch(vals.getValueVector(pred), isFirst);
+      vals.mergeIntoScratch(pred, isFirst);
       isFirst = false;
     }
   }
@@ -878,12 +1033,8 @@ void clang::runUninitializedVariablesAnalysis(
   cfg.VisitBlockStmts(classification);
 
   // Mark all variables uninitialized at the entry.
-  const CFGBlock &entry = cfg.getEntry();
-  ValueVector &vec = vals.getValueVector(&entry);
-  const unsigned n = vals.getNumEntries();
-  for (unsigned j = 0; j < n ; ++j) {
-    vec[j] = Uninitialized;
-  }
+  vals.setAllScratchValues(Uninitialized);
+  vals.updateValueVectorWithScratch(&cfg.getEntry());
 
   // Proceed with the workist.
   DataflowWorklist worklist(cfg, *ac.getAnalysis<PostOrderCFGView>());
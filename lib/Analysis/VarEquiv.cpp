@@ -14,8 +14,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/Analysis/Analyses/VarEquiv.h"
+#include "clang/Analysis/Analyses/PostOrderCFGView.h"
 #include "clang/Analysis/CFG.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Attr.h"
 #include "clang/AST/StmtVisitor.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
 
 using namespace clang;
 
@@ -23,372 +32,693 @@ using namespace clang;
 // operations for partition refinement of the equivalence classes.
 //
 // Partition refinement works as follows: suppose we have a partitioning of a
-// set of/ integers into sets S1, ... SN. Given a set R (the refinement set),
-// divide each set SI that  contains a member of R into two new sets:
+// set of integers into sets S1, ... SN. Given a set R (the refinement set),
+// divide each set SI that contains a member of R into two new sets:
 // - SI intersected with R
 // - SI minus R
 //
 // This "refines" the partition into equal or smaller sets.  This operation
-// can be used to intersect multiple sets of equivalence lasses efficiently.
+// can be used to intersect multiple sets of equivalence classes efficiently.
 //
-// Partition refinement can be implemented so that the intersection can
-// be done in time O(R) and space O(maximum integer in the set) by using
-// a clever representation.  The representation is described at
-// https://en.wikipedia.org/wiki/Partition_refinement.
+// We use the array layout of the algorithm of Paige and Tarjan, described at
+// https://en.wikipedia.org/wiki/Partition_refinement.  The members of each
+// equivalence class are contiguous in one array of members, and each element
+// maps to its slot in the array.  To split a class by R, the members of the
+// class that are in R are swapped to the front of the class, and counted by
+// a split marker.  The front of the class then becomes a new class, without
+// moving any member.  Refining by R takes time O(R), plus the time to make
+// the members that are not in any class of R singletons.
 //
 // We expect equivalence classes to be sparse (consist mostly of singleton
-// equivalence classes), so we implement partition refinment in a more
-// space-efficient fashion. Our implementation uses time O(R * log(N)),
-// where N is the number of integers not in singleton/ equivalence classes,
-// and uses space O(N) to represent a partition.
+// equivalence classes), so singleton classes are not represented: only the
+// members of non-singleton classes have a slot, and they are mapped to it by
+// a hash table.  The space used by a partition is O(N), where N is the number
+// of integers in non-singleton classes, and copying a partition copies a few
+// arrays, without allocating memory for each element.
 //
-// The original algorithm requires a mapping operation from individual
-// integers that is constant time.  This is done using a dense array.
-// We use a tree instead.   We did not use a hash table because we
-// expect on average for there to be only a few integers in non-singleton
-// equivalence classes, and a hash table would be less efficient for that.
+// Elements can be added to classes.  Each class reserves the slots after its
+// members up to its capacity; a class that runs out of slots is moved to the
+// end of the array with twice the capacity, and the array is compacted when
+// most of its slots are unused.
 
 namespace clang {
 namespace PartitionRefinement {
-  typedef int Element;
 
-// We represent each equivalence class as an unordered doubly-linked list so 
-// that we can easily add/remove elements from the set.
-class Set;
+Partition::Partition() : NumMembers(0), NumSlots(0) {}
 
-struct ListNode {
-  ListNode(Element E, Set *S) : Elem(E), ContainingSet(S), Prev(nullptr), Next(nullptr) {
-  }
-
-  Element Elem;
-  Set *ContainingSet;
-
-  ListNode *Prev;
-  ListNode *Next;
-};
-
-class Set {
-public:
-  struct ListNode *Head;
-  Set *Intersected; // scratch pointer used during refinement.
-  int InternalId;   // Internal id of set use by SetManager. May change
-                    // as sets are removed/added.
-
-  Set() : Head(nullptr), Intersected(nullptr), InternalId(Sentinel) {}
-
-  bool isEmpty() {
-    return Head == nullptr;
-  }
-
-  bool isSingleton() const {
-    return Head != nullptr && Head->Prev == nullptr && Head->Next == nullptr;
-  }
-
-  static const int Sentinel = -1;
-};
-
-// SetManager tracks a list of sets.
-class SetManager {
-private:
-  std::vector<Set *> Sets;
-
-public:
-  // Add S to the list of sets. Return the position where S was
-  // added.  We don't set the id because sometimes a set needs
-  // to be tracked in two lists.
-  void add(Set *S) {
-    assert(S->InternalId == Set::Sentinel);
-    S->InternalId = Sets.size();
-    Sets.push_back(S);
-  }
-
-  void assignTo(std::vector<Set *> &Target) const {
-    Target.assign(Sets.begin(), Sets.end());
-  }
-
-  Set *get(unsigned i) const {
-    if (i < Sets.size())
-      return Sets[i];
-    else
-      return nullptr;
-  }
+Partition::~Partition() {}
 
-  // Remove a set from the list of set by swapping the 
-  // set at the end of the list with this set.  Updates
-  // the Id for the swapped set.
-  void remove(Set *S) {
-    int Id = S->InternalId;
-    int size = Sets.size();
-    assert(Id >= 0 && Id < size);
-    if (Id != size - 1) {
-      Set *SwapTarget = Sets[size - 1];
-      Sets[Id] = SwapTarget;
-      SwapTarget->InternalId = Id;
-    }
-    Sets.pop_back();
-  }
-
-  void clear() {
-    Sets.clear();
-  }
-
-  int size() const {
-    return Sets.size();
-  }
-};
+// Make every element a singleton again.
+void Partition::clear() {
+  Members.clear();
+  SlotClasses.clear();
+  Slots.clear();
+  Classes.clear();
+  LiveClasses.clear();
+  FreeClasses.clear();
+  NumMembers = 0;
+  NumSlots = 0;
+}
 
-// Map an equivalence set element to its list node.
-class ElementMap {
-private:
-    std::map<Element, ListNode *> Tree;
+void Partition::assign(const Partition &Other) {
+  if (&Other == this)
+    return;
+  Members = Other.Members;
+  SlotClasses = Other.SlotClasses;
+  Slots = Other.Slots;
+  Classes = Other.Classes;
+  LiveClasses = Other.LiveClasses;
+  FreeClasses = Other.FreeClasses;
+  NumMembers = Other.NumMembers;
+  NumSlots = Other.NumSlots;
+}
 
-public:
-  ElementMap() {
-  }
-      
-  ListNode *get(Element Elem) const {
-    auto Lookup = Tree.find(Elem);
-    if (Lookup == Tree.end())
-      return nullptr;
-    else
-      return Lookup->second;
+// Two partitions are the same if they have the same number of non-trivial
+// sets over the same number of elements, and each set of this partition is
+// within one set of Other.
+bool Partition::equals(const Partition &Other) const {
+  if (LiveClasses.size() != Other.LiveClasses.size() ||
+      NumMembers != Other.NumMembers)
+    return false;
+  for (unsigned C : LiveClasses) {
+    const Class &K = Classes[C];
+    int OtherClass = Other.getClass(Members[K.Start]);
+    if (OtherClass < 0)
+      return false;
+    for (unsigned I = K.Start + 1; I < K.End; I++)
+      if (Other.getClass(Members[I]) != OtherClass)
+        return false;
   }
+  return true;
+}
 
-  void remove(Element Elem) {
-    auto Lookup = Tree.find(Elem);
-    if (Lookup == Tree.end())
-      return;
-    Tree.erase(Lookup);
+void Partition::getClasses(
+    SmallVectorImpl<SmallVector<Element, 4>> &Result) const {
+  for (unsigned C : LiveClasses) {
+    const Class &K = Classes[C];
+    Result.emplace_back(Members.begin() + K.Start, Members.begin() + K.End);
   }
+}
 
-  void set(Element Elem,ListNode *Node) {
-    Tree[Elem] = Node;
-  }
-};
+// Return the class of Elem, or -1 if Elem is a singleton.
+int Partition::getClass(Element Elem) const {
+  auto It = Slots.find(Elem);
+  if (It == Slots.end())
+    return -1;
+  return SlotClasses[It->second];
+}
 
-// Unlink the node from its current set.
-void unlinkNode(ListNode *Node) {
-  if (Node->Prev) {
-    Node->Prev->Next = Node->Next;
-  }
-  if (Node->Next) {
-    Node->Next->Prev = Node->Prev;
-  }
-  if (Node == Node->ContainingSet->Head) {
-    assert(Node->Prev == nullptr);
-    Node->ContainingSet->Head = Node->Next;
+// Create an empty class, whose slots start at the end of the array.
+unsigned Partition::createClass() {
+  unsigned C;
+  if (FreeClasses.empty()) {
+    C = Classes.size();
+    Classes.emplace_back();
+  } else {
+    C = FreeClasses.back();
+    FreeClasses.pop_back();
   }
+  Class &K = Classes[C];
+  K.Start = K.End = K.Capacity = Members.size();
+  K.Marked = 0;
+  K.Kept = false;
+  K.LivePos = LiveClasses.size();
+  LiveClasses.push_back(C);
+  return C;
 }
 
-// Link the node to set S
-void linkNode(Set *S, ListNode *Node) {
-  Node->ContainingSet = S;
-  ListNode *Head = S->Head;
-  Node->Prev = nullptr;
-  Node->Next = Head;
-  S->Head = Node;
-  if (Head != nullptr) {
-    Head->Prev = Node;
-  }
+// Remove the class C, making its members singletons.
+void Partition::removeClass(unsigned C) {
+  Class &K = Classes[C];
+  for (unsigned I = K.Start; I < K.End; I++)
+    Slots.erase(Members[I]);
+  NumMembers -= K.End - K.Start;
+  NumSlots -= K.Capacity - K.Start;
+  unsigned Last = LiveClasses.back();
+  LiveClasses[K.LivePos] = Last;
+  Classes[Last].LivePos = K.LivePos;
+  LiveClasses.pop_back();
+  FreeClasses.push_back(C);
 }
 
-// Move a node from its current set to set S.
-void moveNode(Set *S, ListNode *Node) {
-  unlinkNode(Node);
-  linkNode(S, Node);
+// Swap the members in two slots of the same class.
+void Partition::swapSlots(unsigned A, unsigned B) {
+  if (A == B)
+    return;
+  std::swap(Members[A], Members[B]);
+  Slots[Members[A]] = A;
+  Slots[Members[B]] = B;
 }
 
-void Partition::remove_if_trivial(Set *S) {
-  if (S->isEmpty()) {
-    Sets->remove(S);
-    delete S;
-  }
-  else if (S->isSingleton()) {
-    Sets->remove(S);
-    NodeMap->remove(S->Head->Elem);
-    delete S->Head;
-    delete S;
+// Make sure that the class C has room for Size members.
+void Partition::reserve(unsigned C, unsigned Size) {
+  if (Classes[C].Capacity - Classes[C].Start >= Size)
+    return;
+  unsigned NewCapacity = std::max(2 * Size, 4u);
+  if (Classes[C].Capacity != Members.size() &&
+      Members.size() > 2 * NumSlots + 64)
+    compact();
+
+  Class &K = Classes[C];
+  NumSlots += NewCapacity - (K.Capacity - K.Start);
+  if (K.Capacity == Members.size()) {
+    // The class is at the end of the array, so it grows in place.
+    K.Capacity = K.Start + NewCapacity;
+    Members.resize(K.Capacity);
+    SlotClasses.resize(K.Capacity);
+    return;
   }
-}
 
-Partition::Partition() {
-  Sets = new SetManager();
-  NodeMap = new ElementMap();
+  // Move the class to the end of the array.  Its slots are no longer used.
+  unsigned NewStart = Members.size();
+  Members.resize(NewStart + NewCapacity);
+  SlotClasses.resize(NewStart + NewCapacity);
+  for (unsigned I = K.Start; I < K.End; I++) {
+    unsigned Slot = NewStart + (I - K.Start);
+    Members[Slot] = Members[I];
+    SlotClasses[Slot] = C;
+    Slots[Members[Slot]] = Slot;
+  }
+  K.End = NewStart + (K.End - K.Start);
+  K.Start = NewStart;
+  K.Capacity = NewStart + NewCapacity;
 }
 
-Partition::~Partition() {
-  delete Sets;
-  delete NodeMap;
+// Move the slots of all classes to the front of the array, without the
+// slots that are no longer reserved by any class in between.
+void Partition::compact() {
+  std::vector<Element> NewMembers(NumSlots);
+  std::vector<unsigned> NewSlotClasses(NumSlots);
+  unsigned NewStart = 0;
+  for (unsigned C : LiveClasses) {
+    Class &K = Classes[C];
+    for (unsigned I = K.Start; I < K.End; I++) {
+      unsigned Slot = NewStart + (I - K.Start);
+      NewMembers[Slot] = Members[I];
+      NewSlotClasses[Slot] = C;
+      Slots[Members[I]] = Slot;
+    }
+    K.End = NewStart + (K.End - K.Start);
+    K.Capacity = NewStart + (K.Capacity - K.Start);
+    K.Start = NewStart;
+    NewStart = K.Capacity;
+  }
+  Members.swap(NewMembers);
+  SlotClasses.swap(NewSlotClasses);
 }
 
-// Add Elem to the set S.  It is an error if Elem is already a member 
-// of another set.
-ListNode *Partition::add(Set *S, Element Elem) {
-  assert((NodeMap->get(Elem) == nullptr || 
-          NodeMap->get(Elem)->ContainingSet == S) &&
-         "add operation makes this no longer a partition");
-  ListNode *Node = new ListNode(Elem, S);
-  NodeMap->set(Elem, Node);
-  linkNode(S, Node);
-  return Node;
+// Add Elem, which must be a singleton, to the class C.
+void Partition::append(unsigned C, Element Elem) {
+  assert(Elem >= 0 && "elements must be non-negative");
+  reserve(C, Classes[C].End - Classes[C].Start + 1);
+  Class &K = Classes[C];
+  Members[K.End] = Elem;
+  SlotClasses[K.End] = C;
+  Slots[Elem] = K.End;
+  K.End++;
+  NumMembers++;
 }
 
-// Add Elem to the set S for Member.  If Member does not have
+// Add Elem to the set for Member.  If Member does not have
 // a set, create a new set to contain Elem and Member.
 // It is an error if Elem is already a member of another set.
 void Partition::add(Element Member, Element Elem) {
   if (Member == Elem)  // nothing to do - this is a singleton set.
     return;
 
-  ListNode *Node = NodeMap->get(Member);
-  if (Node == nullptr) {
-    Set *S = new Set();
-    Sets->add(S);
-    Node = add(S , Member);
+  int C = getClass(Member);
+  int ElemClass = getClass(Elem);
+  if (C >= 0 && ElemClass == C)
+    return;
+  assert(ElemClass < 0 && "add operation makes this no longer a partition");
+  if (C < 0) {
+    C = createClass();
+    append(C, Member);
   }
-  add(Node->ContainingSet, Elem);
+  append(C, Elem);
 }
 
 bool Partition::isSingleton(Element Elem) const {
-  return NodeMap->get(Elem) == nullptr;
+  return Slots.count(Elem) == 0;
 }
 
 // Make Elem a singleton equivalance class and remove it
 // from any other equivalence classes that is a member of.
 void Partition::makeSingleton(Element Elem) {
-  ListNode *Node = NodeMap->get(Elem);
-  if (Node != nullptr) {
-    Set *S = Node->ContainingSet;
-    assert(S != nullptr);
-    unlinkNode(Node);
-    NodeMap->remove(Elem);
-    delete Node;
-    remove_if_trivial(S); // S may point to freed memory after this.
-  }
+  auto It = Slots.find(Elem);
+  if (It == Slots.end())
+    return;
+  unsigned C = SlotClasses[It->second];
+  Class &K = Classes[C];
+  swapSlots(It->second, K.End - 1);
+  K.End--;
+  Slots.erase(Elem);
+  NumMembers--;
+  if (K.End - K.Start == 1)
+    removeClass(C);
 }
 
-  // For each equivalence class C with a member in S,
-  // split C into two sets:
-  // * C intersected with S
-  // * C - S.
-  //
-  // S must be a set from a different PartitionEquivalence.
-  // We create a new set for C intersectd with S and use
-  // the original set for S to hold C - S.
-
-void Partition::refine(const Set *S) {
-  Scratch.clear();
-
-  for (ListNode *Current = S->Head; Current != nullptr;
-       Current = Current->Next) {
-    Element CurrentElem = Current->Elem;
-    ListNode *Target = NodeMap->get(CurrentElem);
-    if (Target != nullptr) {
-      Set *TargetSet = Target->ContainingSet;
-      Set *Intersected = TargetSet->Intersected;
-      if (Intersected == nullptr) {
-        Intersected = new Set();
-        Sets->add(Intersected);
-        TargetSet->Intersected = Intersected;
-        Scratch.push_back(TargetSet);
-      }
-      moveNode(Intersected, Target);
-    }
+// The members of the class C at the front of it, up to its split marker,
+// are members of the same set of the refining partition.  Make them a class
+// of their own, which is kept by the refinement.
+void Partition::split(unsigned C) {
+  unsigned Marked = Classes[C].Marked;
+  Classes[C].Marked = 0;
+  if (Marked == Classes[C].End - Classes[C].Start) {
+    Classes[C].Kept = true;
+    return;
   }
 
-  unsigned count = Scratch.size();
-  for (unsigned i = 0; i < count; i++) {
-    Set *Split = Scratch[i];
-    Set *Intersected = Split->Intersected;
-    Split->Intersected = nullptr;
-    remove_if_trivial(Split);
-    remove_if_trivial(Intersected);
+  unsigned Start = Classes[C].Start;
+  Classes[C].Start += Marked;
+  if (Marked == 1) {
+    Slots.erase(Members[Start]);
+    NumMembers--;
+    NumSlots--;
+  } else {
+    unsigned Intersected = createClass();
+    Class &K = Classes[Intersected];
+    K.Start = Start;
+    K.End = K.Capacity = Start + Marked;
+    K.Kept = true;
+    for (unsigned I = Start; I < K.End; I++)
+      SlotClasses[I] = Intersected;
   }
-  Scratch.clear();
+  if (Classes[C].End - Classes[C].Start == 1)
+    removeClass(C);
 }
 
-void Partition::refine(const Partition *R) { // TODO: mark R as const?
+void Partition::refine(const Partition *R) {
   assert(R != this);
-  // First check that all elements of the current equivalence classes
-  // are members of at least one equivalence class in R.  Elements
-  // not in any equivalence class in R are in singleton equivalence
-  // classes.  These are not represented in sets and need to be deleted.
-
-  Sets->assignTo(Scratch);  // avoid modifying list of sets we are iterating over.
-  unsigned count = Scratch.size();
-  for (unsigned i = 0; i < count; i++) {
-    Set *S = Scratch[i];
-    ListNode *Current = S->Head;
-    while (Current != nullptr) {
-      // Save next pointer now in case we delete Current.
-      ListNode *Next = Current->Next;
-      if (R->isSingleton(Current->Elem)) {
-        unlinkNode(Current);
-        NodeMap->remove(Current->Elem);
-        delete Current;
-      }
-      Current = Next;
+  for (unsigned C : LiveClasses)
+    Classes[C].Kept = false;
+
+  // For each equivalence class S of R, and each class C with a member in S,
+  // split C into two sets:
+  // * C intersected with S
+  // * C - S.
+  for (unsigned RC : R->LiveClasses) {
+    const Class &S = R->Classes[RC];
+    for (unsigned I = S.Start; I < S.End; I++) {
+      auto It = Slots.find(R->Members[I]);
+      if (It == Slots.end())
+        continue;
+      unsigned C = SlotClasses[It->second];
+      Class &K = Classes[C];
+      if (K.Marked == 0)
+        Touched.push_back(C);
+      swapSlots(It->second, K.Start + K.Marked);
+      K.Marked++;
     }
-    remove_if_trivial(S); 
+    for (unsigned C : Touched)
+      split(C);
+    Touched.clear();
   }
 
-
-  count = R->Sets->size();
-  for (unsigned i = 0; i < count; i++)
-    refine(R->Sets->get(i));
+  // What is left of the classes that were not kept are members that are
+  // singletons in R, so they become singletons.
+  for (unsigned C : LiveClasses)
+    if (!Classes[C].Kept)
+      Touched.push_back(C);
+  for (unsigned C : Touched)
+    removeClass(C);
+  Touched.clear();
 }
 
 // Return a representative element from the equivalence set
 // for Elem.
 Element Partition::getRepresentative(Element Elem) const {
-  ListNode *Node = NodeMap->get(Elem);
-  if (Node == nullptr) {
+  int C = getClass(Elem);
+  if (C < 0)
     return Elem;
-  } else {
-    return Node->ContainingSet->Head->Elem;
-  }
+  return Members[Classes[C].Start];
 }
 
-void Partition::dump(raw_ostream &OS, Set *S) const {
-  ListNode *Current = S->Head;
+void Partition::dumpClass(raw_ostream &OS, unsigned C) const {
+  const Class &K = Classes[C];
   OS << "Set ";
-  OS << "(Internal Id " << S->InternalId << ") ";
+  OS << "(Internal Id " << K.LivePos << ") ";
   OS << "{";
-  bool first = true;
-  while (Current != nullptr) {
-    if (!first)
+  // The most recently added members come first.
+  for (unsigned I = K.End; I != K.Start; I--) {
+    if (I != K.End)
       OS << ", ";
-    OS << Current->Elem;
-    first = false;
-    Current = Current->Next;
+    OS << Members[I - 1];
   }
   OS << "}";
 }
 
 // Dump the set that Elem is equivalent to.
 void Partition::dump(raw_ostream &OS, Element Elem) const {
-  ListNode *Node = NodeMap->get(Elem);
+  int C = getClass(Elem);
   OS << Elem;
   OS << ": ";
-  if (Node == nullptr) {
+  if (C < 0) {
     OS << "Itself";
     return;
   }
-  dump(OS, Node->ContainingSet);
+  dumpClass(OS, C);
 }
 
 // Dump all the sets
 void Partition::dump(raw_ostream &OS) const {
-  unsigned Count = Sets->size();
-  if (Count == 0)
+  if (LiveClasses.empty())
     OS << "Equivalence classes are all trivial\n";
   else
     OS << "Non-trivial equivalence classes:\n";
-      
-  for (unsigned i = 0; i < Count; i++) {
-    dump(OS, Sets->get(i));
+
+  for (unsigned C : LiveClasses) {
+    dumpClass(OS, C);
     OS << "\n";
   }
 }
 } // namespace PartitionRefinement
 } // namespace Clang
+
+//===----------------------------------------------------------------------===//
+// Equality of variables at program points.
+//===----------------------------------------------------------------------===//
+
+// Returns true if D is a variable whose value can only be changed by its
+// declaration and assignments to it, provided that its address is not
+// taken.
+static bool IsTrackableVar(const VarDecl *D) {
+  if (!D->hasLocalStorage() || D->hasAttr<BlocksAttr>())
+    return false;
+  QualType Ty = D->getType();
+  return !Ty.isVolatileQualified() &&
+         (Ty->isIntegerType() || Ty->isPointerType());
+}
+
+VarEquiv::VarEquiv(ASTContext &Ctx, const CFG &Cfg)
+    : Context(Ctx), Cfg(Cfg), CursorPos(0, 0), CursorValid(false) {
+  collectVariables();
+  solve();
+}
+
+VarEquiv::~VarEquiv() {}
+
+// Number the tracked variables and record where each statement and
+// declaration occurs in the CFG.
+void VarEquiv::collectVariables() {
+  llvm::SetVector<const VarDecl *> Candidates;
+  llvm::SmallPtrSet<const VarDecl *, 8> AddressTaken;
+  BlocksByID.resize(Cfg.getNumBlockIDs());
+  for (const CFGBlock *Block : Cfg) {
+    BlocksByID[Block->getBlockID()] = Block;
+    unsigned Index = 0;
+    for (const CFGElement &Elem : *Block) {
+      Position Pos(Block->getBlockID(), Index++);
+      Optional<CFGStmt> CS = Elem.getAs<CFGStmt>();
+      if (!CS)
+        continue;
+      const Stmt *S = CS->getStmt();
+      StmtPositions.insert(std::make_pair(S, Pos));
+      if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+        for (const Decl *D : DS->decls())
+          if (const VarDecl *VD = dyn_cast<VarDecl>(D)) {
+            DeclPositions.insert(std::make_pair(VD, Pos));
+            if (IsTrackableVar(VD))
+              Candidates.insert(VD);
+          }
+      } else if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(S)) {
+        if (const VarDecl *VD = dyn_cast<VarDecl>(DR->getDecl()))
+          if (IsTrackableVar(VD))
+            Candidates.insert(VD);
+      } else if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+        if (UO->getOpcode() == UO_AddrOf)
+          if (const DeclRefExpr *DR =
+                dyn_cast<DeclRefExpr>(UO->getSubExpr()->IgnoreParens()))
+            if (const VarDecl *VD = dyn_cast<VarDecl>(DR->getDecl()))
+              AddressTaken.insert(VD);
+      }
+    }
+  }
+
+  for (const VarDecl *VD : Candidates)
+    if (!AddressTaken.count(VD)) {
+      VarElements[VD] = Vars.size();
+      Vars.push_back(VD);
+    }
+}
+
+// Return the element for E if E is a use of a tracked variable, ignoring
+// parentheses and implicit casts that do not change the value, or -1.
+VarEquiv::Element VarEquiv::getVarElement(const Expr *E) const {
+  while (true) {
+    E = E->IgnoreParens();
+    const ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(E);
+    if (!ICE)
+      break;
+    CastKind CK = ICE->getCastKind();
+    if (CK != CK_LValueToRValue && CK != CK_NoOp && CK != CK_BitCast)
+      break;
+    E = ICE->getSubExpr();
+  }
+  if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(E))
+    if (const VarDecl *VD = dyn_cast<VarDecl>(DR->getDecl())) {
+      auto It = VarElements.find(VD);
+      if (It != VarElements.end())
+        return It->second;
+    }
+  return -1;
+}
+
+// Return the element for the value of E: a tracked variable or an integer
+// constant.  Returns -1 if the value is neither.
+VarEquiv::Element VarEquiv::getValueElement(const Expr *E) {
+  Element Elem = getVarElement(E);
+  if (Elem >= 0)
+    return Elem;
+  llvm::APSInt Value;
+  if (!E->getType()->isIntegerType() || E->isValueDependent() ||
+      !E->EvaluateAsInt(Value, Context))
+    return -1;
+  // Constants are identified by their mathematical value.
+  if (Value.isSigned() ? Value.getMinSignedBits() > 64
+                       : Value.getActiveBits() > 63)
+    return -1;
+  int64_t Constant = Value.getExtValue();
+  auto It = ConstantElements.find(Constant);
+  if (It != ConstantElements.end())
+    return It->second;
+  Element NewElem = Vars.size() + Constants.size();
+  ConstantElements[Constant] = NewElem;
+  Constants.push_back(Constant);
+  return NewElem;
+}
+
+// Update the facts in P for the evaluation of the CFG element S.
+void VarEquiv::transfer(Partition &P, const Stmt *S) {
+  if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+    if (!BO->isAssignmentOp())
+      return;
+    Element Target = getVarElement(BO->getLHS());
+    if (Target < 0)
+      return;
+    Element Source = BO->getOpcode() == BO_Assign ?
+      getValueElement(BO->getRHS()) : -1;
+    if (Source == Target)
+      return;
+    P.makeSingleton(Target);
+    if (Source >= 0)
+      P.add(Source, Target);
+  } else if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+    if (UO->isIncrementDecrementOp()) {
+      Element Target = getVarElement(UO->getSubExpr());
+      if (Target >= 0)
+        P.makeSingleton(Target);
+    }
+  } else if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+    for (const Decl *D : DS->decls()) {
+      const VarDecl *VD = dyn_cast<VarDecl>(D);
+      if (!VD)
+        continue;
+      auto It = VarElements.find(VD);
+      if (It == VarElements.end())
+        continue;
+      Element Target = It->second;
+      P.makeSingleton(Target);
+      if (const Expr *Init = VD->getInit()) {
+        Element Source = getValueElement(Init);
+        if (Source >= 0 && Source != Target)
+          P.add(Source, Target);
+      }
+    }
+  }
+}
+
+// Compute the facts at the entry of each block.  Blocks are taken from the
+// worklist in reverse post-order, so that every predecessor of a block is
+// processed before it, except along back edges.  The facts at a block entry
+// are the intersection of the facts at the exits of the predecessors that
+// have been processed, and a block is only processed again when the facts
+// at the exit of one of its predecessors change.
+void VarEquiv::solve() {
+  unsigned NumBlockIDs = Cfg.getNumBlockIDs();
+  BlockEntryFacts.resize(NumBlockIDs);
+  Checkpoints.resize(NumBlockIDs);
+  std::vector<std::unique_ptr<Partition>> ExitFacts(NumBlockIDs);
+
+  PostOrderCFGView POV(&Cfg);
+  std::vector<const CFGBlock *> Blocks;
+  std::vector<unsigned> Order(NumBlockIDs, 0);
+  for (const CFGBlock *Block : POV) {
+    Order[Block->getBlockID()] = Blocks.size();
+    Blocks.push_back(Block);
+  }
+
+  std::priority_queue<unsigned, std::vector<unsigned>,
+                      std::greater<unsigned>> Worklist;
+  llvm::BitVector Queued(Blocks.size(), true);
+  for (unsigned I = 0, E = Blocks.size(); I != E; ++I)
+    Worklist.push(I);
+
+  Partition Facts;
+  while (!Worklist.empty()) {
+    unsigned Number = Worklist.top();
+    Worklist.pop();
+    Queued.reset(Number);
+    const CFGBlock *Block = Blocks[Number];
+    unsigned ID = Block->getBlockID();
+
+    bool First = true;
+    for (CFGBlock::const_pred_iterator I = Block->pred_begin(),
+           E = Block->pred_end(); I != E; ++I) {
+      const CFGBlock *Pred = *I;
+      if (!Pred || !ExitFacts[Pred->getBlockID()])
+        continue;
+      if (First)
+        Facts.assign(*ExitFacts[Pred->getBlockID()]);
+      else
+        Facts.refine(ExitFacts[Pred->getBlockID()].get());
+      First = false;
+    }
+    if (First)
+      Facts.clear();
+
+    if (!BlockEntryFacts[ID])
+      BlockEntryFacts[ID] = llvm::make_unique<Partition>();
+    BlockEntryFacts[ID]->assign(Facts);
+
+    for (const CFGElement &Elem : *Block)
+      if (Optional<CFGStmt> CS = Elem.getAs<CFGStmt>())
+        transfer(Facts, CS->getStmt());
+
+    std::unique_ptr<Partition> &Exit = ExitFacts[ID];
+    if (Exit && Exit->equals(Facts))
+      continue;
+    if (!Exit)
+      Exit = llvm::make_unique<Partition>();
+    Exit->assign(Facts);
+
+    for (CFGBlock::const_succ_iterator I = Block->succ_begin(),
+           E = Block->succ_end(); I != E; ++I) {
+      const CFGBlock *Succ = *I;
+      if (!Succ || Queued.test(Order[Succ->getBlockID()]))
+        continue;
+      Queued.set(Order[Succ->getBlockID()]);
+      Worklist.push(Order[Succ->getBlockID()]);
+    }
+  }
+}
+
+// Compute the facts before the element at Pos in Cursor.  Returns false if
+// the block is unreachable.
+bool VarEquiv::moveCursorTo(Position Pos) {
+  const Partition *Entry = BlockEntryFacts[Pos.first].get();
+  if (!Entry)
+    return false;
+
+  std::vector<std::unique_ptr<Partition>> &Saved = Checkpoints[Pos.first];
+  if (!CursorValid || CursorPos.first != Pos.first ||
+      CursorPos.second > Pos.second) {
+    // Restart from the closest saved facts before Pos.
+    unsigned Checkpoint = std::min<size_t>(Pos.second / CheckpointInterval,
+                                           Saved.size());
+    Cursor.assign(Checkpoint == 0 ? *Entry : *Saved[Checkpoint - 1]);
+    CursorPos = Position(Pos.first, Checkpoint * CheckpointInterval);
+    CursorValid = true;
+  }
+
+  const CFGBlock *Block = BlocksByID[Pos.first];
+  while (CursorPos.second < Pos.second) {
+    CFGElement Elem = (*Block)[CursorPos.second];
+    if (Optional<CFGStmt> CS = Elem.getAs<CFGStmt>())
+      transfer(Cursor, CS->getStmt());
+    ++CursorPos.second;
+    if (CursorPos.second % CheckpointInterval == 0 &&
+        CursorPos.second / CheckpointInterval == Saved.size() + 1) {
+      Saved.push_back(llvm::make_unique<Partition>());
+      Saved.back()->assign(Cursor);
+    }
+  }
+  return true;
+}
+
+void VarEquiv::getCursorClasses(SmallVectorImpl<EquivClass> &Classes) const {
+  SmallVector<SmallVector<Element, 4>, 4> Sets;
+  Cursor.getClasses(Sets);
+  for (const SmallVector<Element, 4> &Set : Sets) {
+    EquivClass Class;
+    for (Element Elem : Set) {
+      if (static_cast<unsigned>(Elem) < Vars.size())
+        Class.Vars.push_back(Vars[Elem]);
+      else {
+        Class.HasConstant = true;
+        Class.Constant = Constants[Elem - Vars.size()];
+      }
+    }
+    Classes.push_back(Class);
+  }
+}
+
+bool VarEquiv::getEquivClassesBefore(const Stmt *S,
+                                     SmallVectorImpl<EquivClass> &Classes) {
+  auto It = StmtPositions.find(S);
+  if (It == StmtPositions.end() || !moveCursorTo(It->second))
+    return false;
+  getCursorClasses(Classes);
+  return true;
+}
+
+bool VarEquiv::getEquivClassesBefore(const VarDecl *D,
+                                     SmallVectorImpl<EquivClass> &Classes) {
+  auto It = DeclPositions.find(D);
+  if (It == DeclPositions.end() || !moveCursorTo(It->second))
+    return false;
+  getCursorClasses(Classes);
+  return true;
+}
+
+void VarEquiv::dump(raw_ostream &OS) const {
+  for (const CFGBlock *Block : BlocksByID) {
+    if (!Block)
+      continue;
+    OS << "Block B" << Block->getBlockID() << ":";
+    const Partition *Entry = BlockEntryFacts[Block->getBlockID()].get();
+    if (!Entry) {
+      OS << " unreachable\n";
+      continue;
+    }
+    SmallVector<SmallVector<Element, 4>, 4> Sets;
+    Entry->getClasses(Sets);
+    if (Sets.empty())
+      OS << " no facts";
+    for (const SmallVector<Element, 4> &Set : Sets) {
+      OS << " {";
+      bool First = true;
+      for (Element Elem : Set) {
+        if (!First)
+          OS << ", ";
+        First = false;
+        if (static_cast<unsigned>(Elem) < Vars.size())
+          OS << Vars[Elem]->getName();
+        else
+          OS << Constants[Elem - Vars.size()];
+      }
+      OS << "}";
+    }
+    OS << "\n";
+  }
+}
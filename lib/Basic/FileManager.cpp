@@ -212,6 +212,25 @@ const DirectoryEntry *FileManager::getDirectory(StringRef DirName,
   return &UDE;
 }
 
+FileEntry *
+FileManager::lookupInCanonicalDirectory(StringRef Filename,
+                                        const DirectoryEntry *Dir) {
+  StringRef DirName = llvm::sys::path::parent_path(Filename);
+  if (DirName.empty())
+    DirName = ".";
+  StringRef Name = llvm::sys::path::filename(Filename);
+  if (Dir->getName() == DirName || Name == "." || Name == "..")
+    return nullptr;
+
+  // Both names refer to the same entry of the same directory.
+  SmallString<128> CanonicalName(Dir->getName());
+  llvm::sys::path::append(CanonicalName, Name);
+  auto Known = SeenFileEntries.find(CanonicalName);
+  if (Known == SeenFileEntries.end())
+    return nullptr;
+  return Known->second;
+}
+
 const FileEntry *FileManager::getFile(StringRef Filename, bool openFile,
                                       bool CacheFailure) {
   ++NumFileLookups;
@@ -248,6 +267,21 @@ const FileEntry *FileManager::getFile(StringRef Filename, bool openFile,
     return nullptr;
   }
   
+  // If the directory was first reached under another name, for instance
+  // through a symlink, the file has already been looked up if it was looked up
+  // under that name.  Reuse that result rather than opening the file again.
+  if (FileEntry *UFE = lookupInCanonicalDirectory(InterndFileName, DirInfo)) {
+    if (UFE == NON_EXISTENT_FILE) {
+      if (!CacheFailure)
+        SeenFileEntries.erase(Filename);
+      return nullptr;
+    }
+    NamedFileEnt.second = UFE;
+    // As below, use the last name by which the file was accessed.
+    UFE->Name = InterndFileName;
+    return UFE;
+  }
+
   // FIXME: Use the directory info to prune this, before doing the stat syscall.
   // FIXME: This will reduce the # syscalls.
 
@@ -424,12 +458,19 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
   if (isVolatile)
     FileSize = -1;
 
+  // Files below the mmap threshold are read into the heap, which reading a
+  // volatile file has to do anyway.  Above it, the file is mapped whenever
+  // the memory buffer library can map it.
+  bool ReadIntoHeap =
+      isVolatile || (FileSystemOpts.MmapThreshold &&
+                     Entry->getSize() < FileSystemOpts.MmapThreshold);
+
   StringRef Filename = Entry->getName();
   // If the file is already open, use the open file descriptor.
   if (Entry->File) {
     auto Result =
         Entry->File->getBuffer(Filename, FileSize,
-                               /*RequiresNullTerminator=*/true, isVolatile);
+                               /*RequiresNullTerminator=*/true, ReadIntoHeap);
     // FIXME: we need a set of APIs that can make guarantees about whether a
     // FileEntry is open or not.
     if (ShouldCloseOpenFile)
@@ -441,12 +482,12 @@ FileManager::getBufferForFile(const FileEntry *Entry, bool isVolatile,
 
   if (FileSystemOpts.WorkingDir.empty())
     return FS->getBufferForFile(Filename, FileSize,
-                                /*RequiresNullTerminator=*/true, isVolatile);
+                                /*RequiresNullTerminator=*/true, ReadIntoHeap);
 
   SmallString<128> FilePath(Entry->getName());
   FixupRelativePath(FilePath);
   return FS->getBufferForFile(FilePath, FileSize,
-                              /*RequiresNullTerminator=*/true, isVolatile);
+                              /*RequiresNullTerminator=*/true, ReadIntoHeap);
 }
 
 llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
@@ -75,16 +75,7 @@ IdentifierIterator *IdentifierInfoLookup::getIdentifiers() {
 IdentifierTable::IdentifierTable(const LangOptions &LangOpts,
                                  IdentifierInfoLookup* externalLookup)
   : HashTable(8192), // Start with space for 8K identifiers.
-    ExternalLookup(externalLookup) {
-
-  // Populate the identifier table with info about keywords for the current
-  // language.
-  AddKeywords(LangOpts);
-      
-
-  // Add the '_experimental_modules_import' contextual keyword.
-  get("import").setModulesImport(true);
-}
+    ExternalLookup(externalLookup), KeywordOpts(LangOpts) {}
 
 //===----------------------------------------------------------------------===//
 // Language Keyword Implementation
@@ -130,108 +121,194 @@ namespace {
   };
 }
 
+IdentifierTable::KeywordOptions::KeywordOptions(const LangOptions &LangOpts)
+    : CXXOperatorNames(LangOpts.CXXOperatorNames), ObjC1(LangOpts.ObjC1),
+      ObjC2(LangOpts.ObjC2), ParseUnknownAnytype(LangOpts.ParseUnknownAnytype),
+      DeclSpecKeyword(LangOpts.DeclSpecKeyword) {
+  if (LangOpts.CPlusPlus) Enabled |= KEYCXX;
+  if (LangOpts.CPlusPlus11) Enabled |= KEYCXX11;
+  if (LangOpts.CPlusPlus2a) Enabled |= KEYCXX2A;
+  if (LangOpts.C99) Enabled |= KEYC99;
+  if (LangOpts.GNUKeywords) Extension |= KEYGNU;
+  if (LangOpts.MicrosoftExt) Extension |= KEYMS;
+  if (LangOpts.Borland) Extension |= KEYBORLAND;
+  if (LangOpts.Bool) LateEnabled |= BOOLSUPPORT;
+  if (LangOpts.Half) LateEnabled |= HALFSUPPORT;
+  if (LangOpts.WChar) LateEnabled |= WCHARSUPPORT;
+  if (LangOpts.AltiVec) LateEnabled |= KEYALTIVEC;
+  if (LangOpts.OpenCL) LateEnabled |= KEYOPENCL;
+  if (!LangOpts.CPlusPlus) LateEnabled |= KEYNOCXX;
+  if (LangOpts.C11) LateEnabled |= KEYC11;
+  // We treat bridge casts as objective-C keywords so we can warn on them
+  // in non-arc mode.
+  if (LangOpts.ObjC2) LateEnabled |= KEYARC;
+  if (LangOpts.ObjC2) LateEnabled |= KEYOBJC2;
+  if (LangOpts.ConceptsTS) LateEnabled |= KEYCONCEPTS;
+  if (LangOpts.CoroutinesTS) LateEnabled |= KEYCOROUTINES;
+  if (LangOpts.ModulesTS) LateEnabled |= KEYMODULES;
+  if (LangOpts.CheckedC) LateEnabled |= KEYCHECKEDC;
+  if (LangOpts.CPlusPlus) Future |= KEYALLCXX;
+
+  // Don't add these keywords under MSVCCompat.
+  if (LangOpts.MSVCCompat &&
+      !LangOpts.isCompatibleWithMSVC(LangOptions::MSVC2015))
+    Excluded |= KEYNOMS18;
+  // Don't add these keywords under OpenCL.
+  if (LangOpts.OpenCL)
+    Excluded |= KEYNOOPENCL;
+}
+
 /// \brief Translates flags as specified in TokenKinds.def into keyword status
 /// in the given language standard.
-static KeywordStatus getKeywordStatus(const LangOptions &LangOpts,
-                                      unsigned Flags) {
+static KeywordStatus
+getKeywordStatus(const IdentifierTable::KeywordOptions &KeywordOpts,
+                 unsigned Flags) {
   if (Flags == KEYALL) return KS_Enabled;
-  if (LangOpts.CPlusPlus && (Flags & KEYCXX)) return KS_Enabled;
-  if (LangOpts.CPlusPlus11 && (Flags & KEYCXX11)) return KS_Enabled;
-  if (LangOpts.CPlusPlus2a && (Flags & KEYCXX2A)) return KS_Enabled;
-  if (LangOpts.C99 && (Flags & KEYC99)) return KS_Enabled;
-  if (LangOpts.GNUKeywords && (Flags & KEYGNU)) return KS_Extension;
-  if (LangOpts.MicrosoftExt && (Flags & KEYMS)) return KS_Extension;
-  if (LangOpts.Borland && (Flags & KEYBORLAND)) return KS_Extension;
-  if (LangOpts.Bool && (Flags & BOOLSUPPORT)) return KS_Enabled;
-  if (LangOpts.Half && (Flags & HALFSUPPORT)) return KS_Enabled;
-  if (LangOpts.WChar && (Flags & WCHARSUPPORT)) return KS_Enabled;
-  if (LangOpts.AltiVec && (Flags & KEYALTIVEC)) return KS_Enabled;
-  if (LangOpts.OpenCL && (Flags & KEYOPENCL)) return KS_Enabled;
-  if (!LangOpts.CPlusPlus && (Flags & KEYNOCXX)) return KS_Enabled;
-  if (LangOpts.C11 && (Flags & KEYC11)) return KS_Enabled;
-  // We treat bridge casts as objective-C keywords so we can warn on them
-  // in non-arc mode.
-  if (LangOpts.ObjC2 && (Flags & KEYARC)) return KS_Enabled;
-  if (LangOpts.ObjC2 && (Flags & KEYOBJC2)) return KS_Enabled;
-  if (LangOpts.ConceptsTS && (Flags & KEYCONCEPTS)) return KS_Enabled;
-  if (LangOpts.CoroutinesTS && (Flags & KEYCOROUTINES)) return KS_Enabled;
-  if (LangOpts.ModulesTS && (Flags & KEYMODULES)) return KS_Enabled;
-  if (LangOpts.CheckedC && (Flags & KEYCHECKEDC)) return KS_Enabled;
-  if (LangOpts.CPlusPlus && (Flags & KEYALLCXX)) return KS_Future;
+  if (Flags & KeywordOpts.Enabled) return KS_Enabled;
+  if (Flags & KeywordOpts.Extension) return KS_Extension;
+  if (Flags & KeywordOpts.LateEnabled) return KS_Enabled;
+  if (Flags & KeywordOpts.Future) return KS_Future;
   return KS_Disabled;
 }
 
-/// AddKeyword - This method is used to associate a token ID with specific
-/// identifiers because they are language keywords.  This causes the lexer to
-/// automatically map matching identifiers to specialized token codes.
-static void AddKeyword(StringRef Keyword,
-                       tok::TokenKind TokenCode, unsigned Flags,
-                       const LangOptions &LangOpts, IdentifierTable &Table) {
-  KeywordStatus AddResult = getKeywordStatus(LangOpts, Flags);
-
-  // Don't add this keyword under MSVCCompat.
-  if (LangOpts.MSVCCompat && (Flags & KEYNOMS18) &&
-      !LangOpts.isCompatibleWithMSVC(LangOptions::MSVC2015))
-    return;
-
-  // Don't add this keyword under OpenCL.
-  if (LangOpts.OpenCL && (Flags & KEYNOOPENCL))
-    return;
-
-  // Don't add this keyword if disabled in this language.
-  if (AddResult == KS_Disabled) return;
-
-  IdentifierInfo &Info =
-      Table.get(Keyword, AddResult == KS_Future ? tok::identifier : TokenCode);
-  Info.setIsExtensionToken(AddResult == KS_Extension);
-  Info.setIsFutureCompatKeyword(AddResult == KS_Future);
+/// \brief Returns the FNV-1a hash of the \p Len characters at \p Name.
+///
+/// The identifiers are classified by switches on the hash of their name,
+/// whose cases are the hashes of the keywords, computed at compile time.
+/// The hash is perfect for the keywords of each switch: two keywords with
+/// the same hash would be duplicate case values.
+static constexpr uint32_t hashKeyword(const char *Name, size_t Len,
+                                      uint32_t Hash = 2166136261u) {
+  return Len == 0 ? Hash
+                  : hashKeyword(Name + 1, Len - 1,
+                                (Hash ^ static_cast<unsigned char>(*Name)) *
+                                    16777619u);
+}
+
+/// \brief Returns hashKeyword(Name.data(), Name.size()), without recursing
+/// once per character.
+static uint32_t hashIdentifier(StringRef Name) {
+  uint32_t Hash = 2166136261u;
+  for (char C : Name)
+    Hash = (Hash ^ static_cast<unsigned char>(C)) * 16777619u;
+  return Hash;
+}
+
+/// \brief Finds the keyword spelled \p Name, as a KEYWORD of TokenKinds.def.
+static bool lookupKeyword(StringRef Name, uint32_t Hash,
+                          tok::TokenKind &TokenCode, unsigned &Flags) {
+  switch (Hash) {
+#define KEYWORD(NAME, FLAGS)                                                   \
+  case hashKeyword(#NAME, sizeof(#NAME) - 1):                                  \
+    TokenCode = tok::kw_##NAME;                                                \
+    Flags = FLAGS;                                                             \
+    return Name == #NAME;
+// These are only keywords with the options that enable them.
+#define TESTING_KEYWORD(NAME, FLAGS) KEYWORD(NAME, 0)
+#include "clang/Basic/TokenKinds.def"
+  default:
+    return false;
+  }
 }
 
-/// AddCXXOperatorKeyword - Register a C++ operator keyword alternative
-/// representations.
-static void AddCXXOperatorKeyword(StringRef Keyword,
-                                  tok::TokenKind TokenCode,
-                                  IdentifierTable &Table) {
-  IdentifierInfo &Info = Table.get(Keyword, TokenCode);
-  Info.setIsCPlusPlusOperatorKeyword();
+/// \brief Finds the keyword spelled \p Name, as an ALIAS of TokenKinds.def.
+static bool lookupAlias(StringRef Name, uint32_t Hash,
+                        tok::TokenKind &TokenCode, unsigned &Flags) {
+  switch (Hash) {
+#define ALIAS(NAME, TOK, FLAGS)                                                \
+  case hashKeyword(NAME, sizeof(NAME) - 1):                                    \
+    TokenCode = tok::kw_##TOK;                                                 \
+    Flags = FLAGS;                                                             \
+    return Name == NAME;
+#include "clang/Basic/TokenKinds.def"
+  default:
+    return false;
+  }
 }
 
-/// AddObjCKeyword - Register an Objective-C \@keyword like "class" "selector"
-/// or "property".
-static void AddObjCKeyword(StringRef Name,
-                           tok::ObjCKeywordKind ObjCID,
-                           IdentifierTable &Table) {
-  Table.get(Name).setObjCKeywordID(ObjCID);
+/// \brief Finds the C++ operator keyword spelled \p Name.
+static bool lookupCXXOperatorKeyword(StringRef Name, uint32_t Hash,
+                                     tok::TokenKind &TokenCode) {
+  switch (Hash) {
+#define CXX_KEYWORD_OPERATOR(NAME, ALIAS)                                      \
+  case hashKeyword(#NAME, sizeof(#NAME) - 1):                                  \
+    TokenCode = tok::ALIAS;                                                    \
+    return Name == #NAME;
+#include "clang/Basic/TokenKinds.def"
+  default:
+    return false;
+  }
 }
 
-/// AddKeywords - Add all keywords to the symbol table.
-///
-void IdentifierTable::AddKeywords(const LangOptions &LangOpts) {
-  // Add keywords and tokens for the current language.
-#define KEYWORD(NAME, FLAGS) \
-  AddKeyword(StringRef(#NAME), tok::kw_ ## NAME,  \
-             FLAGS, LangOpts, *this);
-#define ALIAS(NAME, TOK, FLAGS) \
-  AddKeyword(StringRef(NAME), tok::kw_ ## TOK,  \
-             FLAGS, LangOpts, *this);
-#define CXX_KEYWORD_OPERATOR(NAME, ALIAS) \
-  if (LangOpts.CXXOperatorNames)          \
-    AddCXXOperatorKeyword(StringRef(#NAME), tok::ALIAS, *this);
-#define OBJC1_AT_KEYWORD(NAME) \
-  if (LangOpts.ObjC1)          \
-    AddObjCKeyword(StringRef(#NAME), tok::objc_##NAME, *this);
-#define OBJC2_AT_KEYWORD(NAME) \
-  if (LangOpts.ObjC2)          \
-    AddObjCKeyword(StringRef(#NAME), tok::objc_##NAME, *this);
-#define TESTING_KEYWORD(NAME, FLAGS)
+/// \brief Finds the Objective-C \@keyword spelled \p Name, like "class"
+/// "selector" or "property".
+static bool lookupObjCKeyword(StringRef Name, uint32_t Hash,
+                              tok::ObjCKeywordKind &ObjCID, bool &IsObjC2) {
+  switch (Hash) {
+#define OBJC1_AT_KEYWORD(NAME)                                                 \
+  case hashKeyword(#NAME, sizeof(#NAME) - 1):                                  \
+    ObjCID = tok::objc_##NAME;                                                 \
+    IsObjC2 = false;                                                           \
+    return Name == #NAME;
+#define OBJC2_AT_KEYWORD(NAME)                                                 \
+  case hashKeyword(#NAME, sizeof(#NAME) - 1):                                  \
+    ObjCID = tok::objc_##NAME;                                                 \
+    IsObjC2 = true;                                                            \
+    return Name == #NAME;
 #include "clang/Basic/TokenKinds.def"
+  default:
+    return false;
+  }
+}
+
+void IdentifierTable::addKeywordInfo(IdentifierInfo &II) const {
+  StringRef Name = II.getName();
+  uint32_t Hash = hashIdentifier(Name);
+
+  // Associate the token ID of a language keyword with its identifier. This
+  // causes the lexer to automatically map matching identifiers to
+  // specialized token codes.
+  auto AddKeyword = [&](tok::TokenKind TokenCode, unsigned Flags) {
+    if (Flags & KeywordOpts.Excluded)
+      return;
+    KeywordStatus AddResult = getKeywordStatus(KeywordOpts, Flags);
+    // Don't add this keyword if disabled in this language.
+    if (AddResult == KS_Disabled)
+      return;
+    II.TokenID = AddResult == KS_Future ? tok::identifier : TokenCode;
+    II.setIsExtensionToken(AddResult == KS_Extension);
+    II.setIsFutureCompatKeyword(AddResult == KS_Future);
+  };
+
+  tok::TokenKind TokenCode;
+  unsigned Flags;
+  if (lookupKeyword(Name, Hash, TokenCode, Flags)) {
+    if ((TokenCode == tok::kw___unknown_anytype &&
+         KeywordOpts.ParseUnknownAnytype) ||
+        (TokenCode == tok::kw___declspec && KeywordOpts.DeclSpecKeyword))
+      Flags = KEYALL;
+    AddKeyword(TokenCode, Flags);
+  }
+  // An alias with the spelling of a keyword comes after it in
+  // TokenKinds.def, and wins over it, like 'private' in OpenCL.
+  if (lookupAlias(Name, Hash, TokenCode, Flags))
+    AddKeyword(TokenCode, Flags);
+
+  if (KeywordOpts.CXXOperatorNames &&
+      lookupCXXOperatorKeyword(Name, Hash, TokenCode)) {
+    II.TokenID = TokenCode;
+    II.setIsCPlusPlusOperatorKeyword();
+  }
 
-  if (LangOpts.ParseUnknownAnytype)
-    AddKeyword("__unknown_anytype", tok::kw___unknown_anytype, KEYALL,
-               LangOpts, *this);
+  tok::ObjCKeywordKind ObjCID;
+  bool IsObjC2;
+  if (lookupObjCKeyword(Name, Hash, ObjCID, IsObjC2) &&
+      (IsObjC2 ? KeywordOpts.ObjC2 : KeywordOpts.ObjC1))
+    II.setObjCKeywordID(ObjCID);
 
-  if (LangOpts.DeclSpecKeyword)
-    AddKeyword("__declspec", tok::kw___declspec, KEYALL, LangOpts, *this);
+  // Mark the 'import' contextual keyword.
+  if (Name == "import")
+    II.setModulesImport(true);
 }
 
 /// \brief Checks if the specified token kind represents a keyword in the
@@ -239,9 +316,10 @@ void IdentifierTable::AddKeywords(const LangOptions &LangOpts) {
 /// \returns Status of the keyword in the language.
 static KeywordStatus getTokenKwStatus(const LangOptions &LangOpts,
                                       tok::TokenKind K) {
+  IdentifierTable::KeywordOptions KeywordOpts(LangOpts);
   switch (K) {
 #define KEYWORD(NAME, FLAGS) \
-  case tok::kw_##NAME: return getKeywordStatus(LangOpts, FLAGS);
+  case tok::kw_##NAME: return getKeywordStatus(KeywordOpts, FLAGS);
 #include "clang/Basic/TokenKinds.def"
   default: return KS_Disabled;
   }
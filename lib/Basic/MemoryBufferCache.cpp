@@ -12,15 +12,116 @@
 
 using namespace clang;
 
+SharedMemoryBufferCache &SharedMemoryBufferCache::getProcessCache() {
+  // Keep a reference, so that the cache outlives its users.
+  static llvm::IntrusiveRefCntPtr<SharedMemoryBufferCache> Cache(
+      new SharedMemoryBufferCache(/*MaxSize=*/uint64_t(1) << 30));
+  return *Cache;
+}
+
+std::shared_ptr<llvm::MemoryBuffer>
+SharedMemoryBufferCache::lookupBuffer(llvm::StringRef Filename, uint64_t Size,
+                                      time_t ModTime) {
+  llvm::sys::SmartScopedLock<true> Lock(Mutex);
+  auto I = Buffers.find(Filename);
+  if (I == Buffers.end() || I->second.Size != Size ||
+      I->second.ModTime != ModTime)
+    return nullptr;
+  I->second.LastUse = NextUse++;
+  return I->second.Buffer;
+}
+
+void SharedMemoryBufferCache::addBuffer(
+    llvm::StringRef Filename, uint64_t Size, time_t ModTime,
+    std::shared_ptr<llvm::MemoryBuffer> Buffer) {
+  llvm::sys::SmartScopedLock<true> Lock(Mutex);
+  BufferEntry &Entry = Buffers[Filename];
+  if (Entry.Buffer)
+    TotalSize -= Entry.Buffer->getBufferSize();
+  TotalSize += Buffer->getBufferSize();
+  Entry.Buffer = std::move(Buffer);
+  Entry.Size = Size;
+  Entry.ModTime = ModTime;
+  Entry.LastUse = NextUse++;
+  trim();
+}
+
+void SharedMemoryBufferCache::removeBuffer(llvm::StringRef Filename) {
+  llvm::sys::SmartScopedLock<true> Lock(Mutex);
+  auto I = Buffers.find(Filename);
+  if (I == Buffers.end())
+    return;
+  TotalSize -= I->second.Buffer->getBufferSize();
+  Buffers.erase(I);
+}
+
+uint64_t SharedMemoryBufferCache::getTotalSize() {
+  llvm::sys::SmartScopedLock<true> Lock(Mutex);
+  return TotalSize;
+}
+
+void SharedMemoryBufferCache::setMaxSize(uint64_t NewMaxSize) {
+  llvm::sys::SmartScopedLock<true> Lock(Mutex);
+  MaxSize = NewMaxSize;
+  trim();
+}
+
+void SharedMemoryBufferCache::trim() {
+  while (TotalSize > MaxSize) {
+    // Find the least recently used buffer that no MemoryBufferCache holds.
+    auto Victim = Buffers.end();
+    for (auto I = Buffers.begin(), E = Buffers.end(); I != E; ++I) {
+      if (I->second.Buffer.use_count() != 1)
+        continue;
+      if (Victim == Buffers.end() ||
+          I->second.LastUse < Victim->second.LastUse)
+        Victim = I;
+    }
+    if (Victim == Buffers.end())
+      return;
+    TotalSize -= Victim->second.Buffer->getBufferSize();
+    Buffers.erase(Victim);
+  }
+}
+
 llvm::MemoryBuffer &
 MemoryBufferCache::addBuffer(llvm::StringRef Filename,
                              std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+  // This is a new version of the file, which other users should not see.
+  if (SharedCache)
+    SharedCache->removeBuffer(Filename);
+
   auto Insertion =
       Buffers.insert({Filename, BufferEntry{std::move(Buffer), NextIndex++}});
   assert(Insertion.second && "Already has a buffer");
   return *Insertion.first->second.Buffer;
 }
 
+llvm::MemoryBuffer *MemoryBufferCache::addSharedBuffer(llvm::StringRef Filename,
+                                                       uint64_t Size,
+                                                       time_t ModTime) {
+  if (!SharedCache)
+    return nullptr;
+  std::shared_ptr<llvm::MemoryBuffer> Buffer =
+      SharedCache->lookupBuffer(Filename, Size, ModTime);
+  if (!Buffer)
+    return nullptr;
+
+  auto Insertion =
+      Buffers.insert({Filename, BufferEntry{std::move(Buffer), NextIndex++}});
+  assert(Insertion.second && "Already has a buffer");
+  return Insertion.first->second.Buffer.get();
+}
+
+void MemoryBufferCache::shareBuffer(llvm::StringRef Filename, uint64_t Size,
+                                    time_t ModTime) {
+  if (!SharedCache)
+    return;
+  auto I = Buffers.find(Filename);
+  assert(I != Buffers.end() && "No buffer to share...");
+  SharedCache->addBuffer(Filename, Size, ModTime, I->second.Buffer);
+}
+
 llvm::MemoryBuffer *MemoryBufferCache::lookupBuffer(llvm::StringRef Filename) {
   auto I = Buffers.find(Filename);
   if (I == Buffers.end())
@@ -41,6 +142,9 @@ bool MemoryBufferCache::tryToRemoveBuffer(llvm::StringRef Filename) {
   if (I->second.Index < FirstRemovableIndex)
     return true;
 
+  // The file is out of date, and will be rebuilt.
+  if (SharedCache)
+    SharedCache->removeBuffer(Filename);
   Buffers.erase(I);
   return false;
 }
@@ -0,0 +1,319 @@
+//===--- SharedStatCache.cpp - Stat cache shared across processes ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the SharedStatCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/SharedStatCache.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+
+using namespace clang;
+
+/// The signature at the start of a stat cache file.
+static const char Signature[8] = {'C', 'L', 'S', 'T', 'A', 'T', 'C', 0};
+
+/// The stat cache file version.
+static const unsigned CurrentVersion = 1;
+
+/// The size of the header: the signature, the version, and the offsets of
+/// the buckets and of the payload of the hash table.
+static const unsigned HeaderSize = sizeof(Signature) + 3 * sizeof(uint32_t);
+
+/// The number of seconds for which results in a modified directory are not
+/// recorded.
+static const unsigned RecentSeconds = 2;
+
+/// The size of the data of an entry: the parent directory time, whether the
+/// path exists, and the unique ID and modification time of a directory.
+static const unsigned EntryDataSize = 8 + 1 + 3 * 8;
+
+static uint64_t toNanoseconds(llvm::sys::TimePoint<> Time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Time.time_since_epoch()).count();
+}
+
+class SharedStatCache::LookupTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef Entry data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(const internal_key_type &a,
+                       const internal_key_type &b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(const internal_key_type &a) {
+    return llvm::HashString(a);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(d);
+    return std::make_pair(KeyLen, EntryDataSize);
+  }
+
+  static const internal_key_type &
+  GetInternalKey(const external_key_type &x) { return x; }
+
+  static const external_key_type &
+  GetExternalKey(const internal_key_type &x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    return StringRef((const char *)d, n);
+  }
+
+  static data_type ReadData(const internal_key_type &, const unsigned char *d,
+                            unsigned) {
+    using namespace llvm::support;
+    Entry E;
+    E.ParentTime = endian::readNext<uint64_t, little, unaligned>(d);
+    E.Exists = *d++ != 0;
+    uint64_t Device = endian::readNext<uint64_t, little, unaligned>(d);
+    uint64_t File = endian::readNext<uint64_t, little, unaligned>(d);
+    E.UniqueID = llvm::sys::fs::UniqueID(Device, File);
+    E.ModTime = endian::readNext<uint64_t, little, unaligned>(d);
+    return E;
+  }
+};
+
+namespace {
+class StatCacheWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef SharedStatCache::Entry data_type;
+  typedef const data_type &data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::HashString(Key);
+  }
+
+  std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref) {
+    using namespace llvm::support;
+    endian::Writer<little>(Out).write<uint16_t>(Key.size());
+    return std::make_pair(Key.size(), EntryDataSize);
+  }
+
+  void EmitKey(raw_ostream &Out, key_type_ref Key, unsigned) {
+    Out.write(Key.data(), Key.size());
+  }
+
+  void EmitData(raw_ostream &Out, key_type_ref, data_type_ref E, unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint64_t>(E.ParentTime);
+    LE.write<uint8_t>(E.Exists);
+    LE.write<uint64_t>(E.UniqueID.getDevice());
+    LE.write<uint64_t>(E.UniqueID.getFile());
+    LE.write<uint64_t>(E.ModTime);
+  }
+};
+} // end anonymous namespace
+
+SharedStatCache::SharedStatCache(StringRef CachePath,
+                                 std::unique_ptr<llvm::MemoryBuffer> Buffer)
+    : CachePath(CachePath), Buffer(std::move(Buffer)) {
+  if (!this->Buffer)
+    return;
+
+  using namespace llvm::support;
+  const unsigned char *Start =
+      (const unsigned char *)this->Buffer->getBufferStart();
+  size_t Size = this->Buffer->getBufferSize();
+  if (Size < HeaderSize || memcmp(Start, Signature, sizeof(Signature)) != 0)
+    return;
+
+  const unsigned char *D = Start + sizeof(Signature);
+  uint32_t Version = endian::readNext<uint32_t, little, unaligned>(D);
+  uint32_t BucketOffset = endian::readNext<uint32_t, little, unaligned>(D);
+  uint32_t PayloadOffset = endian::readNext<uint32_t, little, unaligned>(D);
+  if (Version != CurrentVersion || PayloadOffset < HeaderSize ||
+      BucketOffset < PayloadOffset || BucketOffset >= Size ||
+      BucketOffset % 4 != 0)
+    return;
+
+  Table.reset(TableTy::Create(Start + BucketOffset, Start + PayloadOffset,
+                              Start));
+}
+
+SharedStatCache::~SharedStatCache() {}
+
+std::unique_ptr<SharedStatCache> SharedStatCache::create(StringRef Path) {
+  // A missing or unreadable file starts an empty cache.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+      llvm::MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  if (BufferOrErr)
+    Buffer = std::move(*BufferOrErr);
+  return std::unique_ptr<SharedStatCache>(
+      new SharedStatCache(Path, std::move(Buffer)));
+}
+
+Optional<uint64_t> SharedStatCache::getDirectoryTime(StringRef Dir,
+                                                     vfs::FileSystem &FS) {
+  auto Known = DirectoryTimes.find(Dir);
+  if (Known != DirectoryTimes.end())
+    return Known->second;
+
+  Optional<uint64_t> Time;
+  llvm::ErrorOr<vfs::Status> Status = FS.status(Dir);
+  if (Status && Status->isDirectory() && !Status->IsVFSMapped)
+    Time = toNanoseconds(Status->getLastModificationTime());
+  DirectoryTimes[Dir] = Time;
+  return Time;
+}
+
+SharedStatCache::LookupResult
+SharedStatCache::getStat(StringRef Path, FileData &Data, bool isFile,
+                         std::unique_ptr<vfs::File> *F, vfs::FileSystem &FS) {
+  // Relative paths depend on the working directory of the compilation.
+  StringRef Parent = llvm::sys::path::parent_path(Path);
+  if (!llvm::sys::path::is_absolute(Path) || Parent.empty())
+    return statChained(Path, Data, isFile, F, FS);
+
+  Optional<uint64_t> ParentTime = getDirectoryTime(Parent, FS);
+  if (!ParentTime)
+    return statChained(Path, Data, isFile, F, FS);
+
+  if (Table) {
+    TableTy::iterator I = Table->find(Path);
+    if (I != Table->end()) {
+      Entry E = *I;
+      if (E.ParentTime == *ParentTime) {
+        if (!E.Exists)
+          return CacheMissing;
+
+        Data.Name = Path;
+        Data.Size = 0;
+        Data.ModTime = E.ModTime;
+        Data.UniqueID = E.UniqueID;
+        Data.IsDirectory = true;
+        Data.IsNamedPipe = false;
+        Data.InPCH = false;
+        Data.IsVFSMapped = false;
+        return CacheExists;
+      }
+    }
+  }
+
+  LookupResult Result = statChained(Path, Data, isFile, F, FS);
+
+  // Record the missing paths and the directories in directories that were
+  // not modified recently.
+  uint64_t Now = toNanoseconds(std::chrono::system_clock::now());
+  uint64_t Recent = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::seconds(RecentSeconds)).count();
+  if (*ParentTime + Recent > Now)
+    return Result;
+
+  // A file that could not be opened may still exist, for instance as a
+  // directory on some systems.
+  if (Result == CacheMissing && F && FS.status(Path))
+    return Result;
+
+  Entry E;
+  E.ParentTime = *ParentTime;
+  E.Exists = Result == CacheExists;
+  E.UniqueID = llvm::sys::fs::UniqueID(0, 0);
+  E.ModTime = 0;
+  if (E.Exists) {
+    if (!Data.IsDirectory || Data.IsVFSMapped)
+      return Result;
+    E.UniqueID = Data.UniqueID;
+    E.ModTime = Data.ModTime;
+  }
+  NewEntries[Path] = E;
+  return Result;
+}
+
+bool SharedStatCache::save() {
+  if (NewEntries.empty())
+    return false;
+
+  llvm::OnDiskChainedHashTableGenerator<StatCacheWriterTrait> Generator;
+  StatCacheWriterTrait Trait;
+  for (const auto &NewEntry : NewEntries)
+    Generator.insert(NewEntry.first(), NewEntry.second, Trait);
+
+  // Keep the results recorded by other compilations, unless they are
+  // replaced or their parent directory is known to have changed.
+  if (Table) {
+    for (TableTy::key_iterator I = Table->key_begin(), E = Table->key_end();
+         I != E; ++I) {
+      StringRef Path = *I;
+      if (NewEntries.count(Path))
+        continue;
+      Entry Old = *Table->find(Path);
+      auto Known = DirectoryTimes.find(llvm::sys::path::parent_path(Path));
+      if (Known != DirectoryTimes.end() &&
+          (!Known->second || *Known->second != Old.ParentTime))
+        continue;
+      Generator.insert(Path, Old, Trait);
+    }
+  }
+
+  SmallString<4096> Contents;
+  {
+    using namespace llvm::support;
+    llvm::raw_svector_ostream Out(Contents);
+    endian::Writer<little> LE(Out);
+    Out.write(Signature, sizeof(Signature));
+    LE.write<uint32_t>(CurrentVersion);
+    // The offsets of the buckets and the payload are filled in below.
+    LE.write<uint32_t>(0);
+    LE.write<uint32_t>(0);
+    uint32_t PayloadOffset = Out.tell();
+    uint32_t BucketOffset = Generator.Emit(Out, Trait);
+    uint32_t Offsets[2] = {
+        endian::byte_swap<uint32_t, little>(BucketOffset),
+        endian::byte_swap<uint32_t, little>(PayloadOffset)};
+    memcpy(&Contents[sizeof(Signature) + sizeof(uint32_t)], Offsets,
+           sizeof(Offsets));
+  }
+
+  // Write the new contents to a temporary file next to the cache, and move it
+  // into place, so that other compilations never see a partial file.
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(CachePath + "-%%%%%%%%", FD, TempPath))
+    return true;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out.write(Contents.data(), Contents.size());
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return true;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, CachePath)) {
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+  return false;
+}
@@ -328,6 +328,7 @@ SourceManager::~SourceManager() {
 }
 
 void SourceManager::clearIDTables() {
+  ConcurrentReads = false;
   MainFileID = FileID();
   LocalSLocEntryTable.clear();
   LoadedSLocEntryTable.clear();
@@ -445,6 +446,7 @@ std::pair<int, unsigned>
 SourceManager::AllocateLoadedSLocEntries(unsigned NumSLocEntries,
                                          unsigned TotalSize) {
   assert(ExternalSLocEntries && "Don't have an external sloc source");
+  ConcurrentReads = false;
   // Make sure we're not about to run out of source locations.
   if (CurrentLoadedOffset - TotalSize < NextLocalOffset)
     return std::make_pair(0, 0);
@@ -525,6 +527,7 @@ FileID SourceManager::createFileID(const ContentCache *File,
                                    SourceLocation IncludePos,
                                    SrcMgr::CharacteristicKind FileCharacter,
                                    int LoadedID, unsigned LoadedOffset) {
+  ConcurrentReads = false;
   if (LoadedID < 0) {
     assert(LoadedID != -1 && "Loading sentinel FileID");
     unsigned Index = unsigned(-LoadedID) - 2;
@@ -578,6 +581,7 @@ SourceManager::createExpansionLocImpl(const ExpansionInfo &Info,
                                       unsigned TokLength,
                                       int LoadedID,
                                       unsigned LoadedOffset) {
+  ConcurrentReads = false;
   if (LoadedID < 0) {
     assert(LoadedID != -1 && "Loading sentinel FileID");
     unsigned Index = unsigned(-LoadedID) - 2;
@@ -723,9 +727,10 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
 
       // If this isn't an expansion, remember it.  We have good locality across
       // FileID lookups.
-      if (!I->isExpansion())
+      if (!I->isExpansion() && !ConcurrentReads) {
         LastFileIDLookup = Res;
-      NumLinearScans += NumProbes+1;
+        NumLinearScans += NumProbes+1;
+      }
       return Res;
     }
     if (++NumProbes == 8)
@@ -764,9 +769,10 @@ FileID SourceManager::getFileIDLocal(unsigned SLocOffset) const {
 
       // If this isn't a macro expansion, remember it.  We have good locality
       // across FileID lookups.
-      if (!LocalSLocEntryTable[MiddleIndex].isExpansion())
+      if (!LocalSLocEntryTable[MiddleIndex].isExpansion() && !ConcurrentReads) {
         LastFileIDLookup = Res;
-      NumBinaryProbes += NumProbes;
+        NumBinaryProbes += NumProbes;
+      }
       return Res;
     }
 
@@ -804,9 +810,10 @@ FileID SourceManager::getFileIDLoaded(unsigned SLocOffset) const {
     if (E.getOffset() <= SLocOffset) {
       FileID Res = FileID::get(-int(I) - 2);
 
-      if (!E.isExpansion())
+      if (!E.isExpansion() && !ConcurrentReads) {
         LastFileIDLookup = Res;
-      NumLinearScans += NumProbes + 1;
+        NumLinearScans += NumProbes + 1;
+      }
       return Res;
     }
   }
@@ -838,9 +845,10 @@ FileID SourceManager::getFileIDLoaded(unsigned SLocOffset) const {
 
     if (isOffsetInFileID(FileID::get(-int(MiddleIndex) - 2), SLocOffset)) {
       FileID Res = FileID::get(-int(MiddleIndex) - 2);
-      if (!E.isExpansion())
+      if (!E.isExpansion() && !ConcurrentReads) {
         LastFileIDLookup = Res;
-      NumBinaryProbes += NumProbes;
+        NumBinaryProbes += NumProbes;
+      }
       return Res;
     }
 
@@ -1167,28 +1175,65 @@ unsigned SourceManager::getPresumedColumnNumber(SourceLocation Loc,
 #include <emmintrin.h>
 #endif
 
+/// The number of bytes that are scanned for newlines, at least, each time the
+/// line table of a file is extended.  The table is computed in chunks so that
+/// a query near the start of a huge file does not scan all of it.
+static const unsigned LineTableChunkSize = 1 << 20;
+
+/// Append the offset of the start of a line to the line table of \p FI.
+static void AddLineOffset(ContentCache *FI, llvm::BumpPtrAllocator &Alloc,
+                          unsigned Offs) {
+  if (FI->NumLines == FI->LineCacheCapacity) {
+    // The old array is left to the allocator; since the capacity doubles,
+    // this wastes at most as much memory as the final table uses.
+    unsigned NewCapacity = FI->LineCacheCapacity * 2;
+    unsigned *NewCache = Alloc.Allocate<unsigned>(NewCapacity);
+    std::copy(FI->SourceLineCache, FI->SourceLineCache + FI->NumLines,
+              NewCache);
+    FI->SourceLineCache = NewCache;
+    FI->LineCacheCapacity = NewCapacity;
+  }
+  FI->SourceLineCache[FI->NumLines++] = Offs;
+}
+
+/// Extend the line table of \p FI until it covers the line containing
+/// \p UntilOffset and has at least \p UntilLine lines, or until it is
+/// complete.
 static LLVM_ATTRIBUTE_NOINLINE void
 ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
                    llvm::BumpPtrAllocator &Alloc,
-                   const SourceManager &SM, bool &Invalid);
+                   const SourceManager &SM, unsigned UntilOffset,
+                   unsigned UntilLine, bool &Invalid);
 static void ComputeLineNumbers(DiagnosticsEngine &Diag, ContentCache *FI,
                                llvm::BumpPtrAllocator &Alloc,
-                               const SourceManager &SM, bool &Invalid) {
+                               const SourceManager &SM, unsigned UntilOffset,
+                               unsigned UntilLine, bool &Invalid) {
   // Note that calling 'getBuffer()' may lazily page in the file.
   MemoryBuffer *Buffer = FI->getBuffer(Diag, SM, SourceLocation(), &Invalid);
   if (Invalid)
     return;
 
-  // Find the file offsets of all of the *physical* source lines.  This does
-  // not look at trigraphs, escaped newlines, or anything else tricky.
-  SmallVector<unsigned, 256> LineOffsets;
+  // Find the file offsets of the *physical* source lines.  This does not look
+  // at trigraphs, escaped newlines, or anything else tricky.
+  if (!FI->SourceLineCache) {
+    // Line #1 starts at char 0.
+    FI->LineCacheCapacity = 256;
+    FI->SourceLineCache = Alloc.Allocate<unsigned>(FI->LineCacheCapacity);
+    FI->SourceLineCache[0] = 0;
+    FI->NumLines = 1;
+    FI->LineTableComplete = false;
+  }
+  if (FI->LineTableComplete)
+    return;
 
-  // Line #1 starts at char 0.
-  LineOffsets.push_back(0);
+  // Resume the scan at the start of the last line that was found.
+  unsigned Offs = FI->SourceLineCache[FI->NumLines - 1];
+  uint64_t StopOffs = std::max<uint64_t>(UntilOffset,
+                                         (uint64_t)Offs + LineTableChunkSize);
 
-  const unsigned char *Buf = (const unsigned char *)Buffer->getBufferStart();
+  const unsigned char *Buf =
+      (const unsigned char *)Buffer->getBufferStart() + Offs;
   const unsigned char *End = (const unsigned char *)Buffer->getBufferEnd();
-  unsigned Offs = 0;
   while (1) {
     // Skip over the contents of the line.
     const unsigned char *NextBuf = (const unsigned char *)Buf;
@@ -1240,7 +1285,10 @@ FoundSpecialChar:
       }
       ++Offs;
       ++Buf;
-      LineOffsets.push_back(Offs);
+      AddLineOffset(FI, Alloc, Offs);
+      // Stop at a line boundary once the requested position is covered.
+      if (Offs > StopOffs && FI->NumLines >= UntilLine)
+        return;
     } else {
       // Otherwise, this is a null.  If end of file, exit.
       if (Buf == End) break;
@@ -1250,10 +1298,46 @@ FoundSpecialChar:
     }
   }
 
-  // Copy the offsets into the FileInfo structure.
-  FI->NumLines = LineOffsets.size();
-  FI->SourceLineCache = Alloc.Allocate<unsigned>(LineOffsets.size());
-  std::copy(LineOffsets.begin(), LineOffsets.end(), FI->SourceLineCache);
+  FI->LineTableComplete = true;
+}
+
+void SourceManager::prepareForConcurrentReads() {
+  // Create the recovery buffer now, it may be needed by any query.
+  getFakeContentCacheForRecovery();
+
+  // Load all the entries of the PCH and modules, they are loaded lazily.
+  for (unsigned I = 0, N = loaded_sloc_entry_size(); I != N; ++I)
+    if (!SLocEntryLoaded[I])
+      getLoadedSLocEntry(I);
+
+  auto Prepare = [&](FileID FID, const SrcMgr::SLocEntry &Entry) {
+    getDecomposedIncludedLoc(FID);
+    if (!Entry.isFile())
+      return;
+    ContentCache *Content =
+        const_cast<ContentCache *>(Entry.getFile().getContentCache());
+    if (!Content)
+      return;
+    bool Invalid = false;
+    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, ~0U, 0,
+                       Invalid);
+    getMacroArgExpandedLocation(getLocForStartOfFile(FID));
+  };
+  // Skip the dummy entry at index 0.
+  for (unsigned I = 1, N = local_sloc_entry_size(); I != N; ++I)
+    Prepare(FileID::get(I), getLocalSLocEntry(I));
+  for (unsigned I = 0, N = loaded_sloc_entry_size(); I != N; ++I)
+    Prepare(FileID::get(-int(I) - 2), getLoadedSLocEntry(I));
+
+  ConcurrentReads = true;
+}
+
+/// Returns true if the line table of \p FI does not yet tell which line the
+/// offset \p FilePos is on.
+static bool needsMoreLineNumbers(const ContentCache *FI, unsigned FilePos) {
+  return !FI->SourceLineCache ||
+         (!FI->LineTableComplete &&
+          FilePos >= FI->SourceLineCache[FI->NumLines - 1]);
 }
 
 /// getLineNumber - Given a SourceLocation, return the spelling line number
@@ -1283,11 +1367,12 @@ unsigned SourceManager::getLineNumber(FileID FID, unsigned FilePos,
     Content = const_cast<ContentCache*>(Entry.getFile().getContentCache());
   }
   
-  // If this is the first use of line information for this buffer, compute the
-  /// SourceLineCache for it on demand.
-  if (!Content->SourceLineCache) {
+  // If this is the first use of line information for this part of the buffer,
+  /// compute the SourceLineCache for it on demand.
+  if (needsMoreLineNumbers(Content, FilePos)) {
     bool MyInvalid = false;
-    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, MyInvalid);
+    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, FilePos,
+                       /*UntilLine=*/0, MyInvalid);
     if (Invalid)
       *Invalid = MyInvalid;
     if (MyInvalid)
@@ -1347,10 +1432,12 @@ unsigned SourceManager::getLineNumber(FileID FID, unsigned FilePos,
     = std::lower_bound(SourceLineCache, SourceLineCacheEnd, QueriedFilePos);
   unsigned LineNo = Pos-SourceLineCacheStart;
 
-  LastLineNoFileIDQuery = FID;
-  LastLineNoContentCache = Content;
-  LastLineNoFilePos = QueriedFilePos;
-  LastLineNoResult = LineNo;
+  if (!ConcurrentReads) {
+    LastLineNoFileIDQuery = FID;
+    LastLineNoContentCache = Content;
+    LastLineNoFilePos = QueriedFilePos;
+    LastLineNoResult = LineNo;
+  }
   return LineNo;
 }
 
@@ -1721,11 +1808,13 @@ SourceLocation SourceManager::translateLineCol(FileID FID,
   if (!Content)
     return SourceLocation();
 
-  // If this is the first use of line information for this buffer, compute the
+  // If this is the first use of line information for this line, compute the
   // SourceLineCache for it on demand.
-  if (!Content->SourceLineCache) {
+  if (!Content->SourceLineCache ||
+      (!Content->LineTableComplete && Line > Content->NumLines)) {
     bool MyInvalid = false;
-    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this, MyInvalid);
+    ComputeLineNumbers(Diag, Content, ContentCacheAlloc, *this,
+                       /*UntilOffset=*/0, Line, MyInvalid);
     if (MyInvalid)
       return SourceLocation();
   }
@@ -1912,7 +2001,18 @@ SourceManager::getMacroArgExpandedLocation(SourceLocation Loc) const {
   if (FID.isInvalid())
     return Loc;
 
-  std::unique_ptr<MacroArgsMap> &MacroArgsCache = MacroArgsCacheMap[FID];
+  // With concurrent reads, the map was computed for all the files; look it up
+  // without inserting anything.
+  std::unique_ptr<MacroArgsMap> LocalMacroArgsCache;
+  std::unique_ptr<MacroArgsMap> *CachedMacroArgs;
+  if (ConcurrentReads) {
+    auto Found = MacroArgsCacheMap.find(FID);
+    CachedMacroArgs = Found != MacroArgsCacheMap.end() ? &Found->second
+                                                       : &LocalMacroArgsCache;
+  } else {
+    CachedMacroArgs = &MacroArgsCacheMap[FID];
+  }
+  std::unique_ptr<MacroArgsMap> &MacroArgsCache = *CachedMacroArgs;
   if (!MacroArgsCache) {
     MacroArgsCache = llvm::make_unique<MacroArgsMap>();
     computeMacroArgsCache(*MacroArgsCache, FID);
@@ -1939,11 +2039,20 @@ SourceManager::getDecomposedIncludedLoc(FileID FID) const {
 
   typedef std::pair<FileID, unsigned> DecompTy;
   typedef llvm::DenseMap<FileID, DecompTy> MapTy;
-  std::pair<MapTy::iterator, bool>
-    InsertOp = IncludedLocMap.insert(std::make_pair(FID, DecompTy()));
-  DecompTy &DecompLoc = InsertOp.first->second;
-  if (!InsertOp.second)
-    return DecompLoc; // already in map.
+  DecompTy LocalDecompLoc;
+  DecompTy *CachedDecompLoc = &LocalDecompLoc;
+  if (ConcurrentReads) {
+    MapTy::iterator Found = IncludedLocMap.find(FID);
+    if (Found != IncludedLocMap.end())
+      return Found->second;
+  } else {
+    std::pair<MapTy::iterator, bool>
+      InsertOp = IncludedLocMap.insert(std::make_pair(FID, DecompTy()));
+    if (!InsertOp.second)
+      return InsertOp.first->second; // already in map.
+    CachedDecompLoc = &InsertOp.first->second;
+  }
+  DecompTy &DecompLoc = *CachedDecompLoc;
 
   SourceLocation UpperLoc;
   bool Invalid = false;
@@ -2067,8 +2176,12 @@ std::pair<bool, bool> SourceManager::isInTheSameTranslationUnit(
 
   // If we are comparing a source location with multiple locations in the same
   // file, we get a big win by caching the result.
+  // With concurrent reads, the cache of the last query cannot be shared, so
+  // use a cache local to this query.
+  InBeforeInTUCacheEntry LocalCache;
   InBeforeInTUCacheEntry &IsBeforeInTUCache =
-    getInBeforeInTUCache(LOffs.first, ROffs.first);
+      ConcurrentReads ? LocalCache
+                      : getInBeforeInTUCache(LOffs.first, ROffs.first);
 
   // If we are comparing a source location with multiple locations in the same
   // file, we get a big win by caching the result.
@@ -0,0 +1,179 @@
+//===--- TimeTrace.cpp - Trace of where the compiler spends time ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the -ftime-trace profiler.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/TimeTrace.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <vector>
+
+using namespace clang;
+
+namespace clang {
+LLVM_THREAD_LOCAL TimeTraceProfiler *TimeTraceProfilerInstance = nullptr;
+
+class TimeTraceProfiler {
+  typedef std::chrono::steady_clock Clock;
+  typedef std::chrono::microseconds Microseconds;
+
+  struct Event {
+    Clock::time_point Start;
+    Microseconds Duration;
+    std::string Name;
+    std::string Detail;
+  };
+
+  /// The events that have started but not ended, innermost last.
+  std::vector<Event> Stack;
+
+  /// The events that ended and were long enough to be written.
+  std::vector<Event> Events;
+
+  /// The number of occurrences and total time of each event name, counting
+  /// only the outermost of nested occurrences.
+  llvm::StringMap<std::pair<unsigned, Microseconds>> Totals;
+
+  Clock::time_point StartTime;
+  Microseconds Granularity;
+
+public:
+  explicit TimeTraceProfiler(unsigned GranularityMicroseconds)
+      : StartTime(Clock::now()), Granularity(GranularityMicroseconds) {}
+
+  void begin(StringRef Name, std::string Detail) {
+    Stack.push_back(
+        Event{Clock::now(), Microseconds(0), Name.str(), std::move(Detail)});
+  }
+
+  void end() {
+    assert(!Stack.empty() && "time trace event ended but never started");
+    Event E = std::move(Stack.back());
+    Stack.pop_back();
+    E.Duration = std::chrono::duration_cast<Microseconds>(Clock::now() -
+                                                          E.Start);
+
+    if (std::none_of(Stack.begin(), Stack.end(),
+                     [&](const Event &Outer) { return Outer.Name == E.Name; })) {
+      auto &Total = Totals[E.Name];
+      ++Total.first;
+      Total.second += E.Duration;
+    }
+
+    if (E.Duration >= Granularity)
+      Events.push_back(std::move(E));
+  }
+
+  void write(raw_ostream &OS);
+};
+} // end namespace clang
+
+/// Write \p S as a JSON string.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    switch (C) {
+    case '"':  OS << "\\\""; break;
+    case '\\': OS << "\\\\"; break;
+    case '\n': OS << "\\n"; break;
+    case '\t': OS << "\\t"; break;
+    default:
+      if (C < 0x20)
+        OS << llvm::format("\\u%04x", C);
+      else
+        OS << C;
+    }
+  }
+  OS << '"';
+}
+
+void TimeTraceProfiler::write(raw_ostream &OS) {
+  // Events that have not ended, such as those of files that a fatal error
+  // left open, are not written.
+  OS << "{\"traceEvents\":[";
+  bool First = true;
+  auto writeEvent = [&](unsigned Tid, Microseconds Start, Microseconds Dur,
+                        StringRef Name, StringRef ArgName, StringRef Arg) {
+    if (!First)
+      OS << ",";
+    First = false;
+    OS << "\n{\"pid\":1,\"tid\":" << Tid << ",\"ph\":\"X\",\"ts\":"
+       << Start.count() << ",\"dur\":" << Dur.count() << ",\"name\":";
+    writeJSONString(OS, Name);
+    OS << ",\"args\":{";
+    writeJSONString(OS, ArgName);
+    OS << ":";
+    writeJSONString(OS, Arg);
+    OS << "}}";
+  };
+
+  for (const Event &E : Events)
+    writeEvent(0,
+               std::chrono::duration_cast<Microseconds>(E.Start - StartTime),
+               E.Duration, E.Name, "detail", E.Detail);
+
+  // Put the totals next to the events, longest first, each in a row of its
+  // own.
+  std::vector<std::pair<StringRef, std::pair<unsigned, Microseconds>>>
+      SortedTotals;
+  for (const auto &Total : Totals)
+    SortedTotals.push_back(std::make_pair(Total.getKey(), Total.getValue()));
+  std::sort(SortedTotals.begin(), SortedTotals.end(),
+            [](const decltype(SortedTotals)::value_type &A,
+               const decltype(SortedTotals)::value_type &B) {
+              if (A.second.second != B.second.second)
+                return A.second.second > B.second.second;
+              return A.first < B.first;
+            });
+  unsigned Tid = 1;
+  for (const auto &Total : SortedTotals)
+    writeEvent(Tid++, Microseconds(0), Total.second.second,
+               ("Total " + Total.first).str(), "count",
+               llvm::utostr(Total.second.first));
+
+  OS << "\n],\n\"displayTimeUnit\":\"ms\"}\n";
+}
+
+void clang::timeTraceProfilerInitialize(unsigned GranularityMicroseconds) {
+  assert(!TimeTraceProfilerInstance && "time trace profiler already started");
+  TimeTraceProfilerInstance = new TimeTraceProfiler(GranularityMicroseconds);
+}
+
+void clang::timeTraceProfilerCleanup() {
+  delete TimeTraceProfilerInstance;
+  TimeTraceProfilerInstance = nullptr;
+}
+
+void clang::timeTraceProfilerWrite(raw_ostream &OS) {
+  assert(TimeTraceProfilerInstance && "time trace profiler not started");
+  TimeTraceProfilerInstance->write(OS);
+}
+
+void clang::timeTraceProfilerBegin(StringRef Name, StringRef Detail) {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->begin(Name, Detail.str());
+}
+
+void clang::timeTraceProfilerBegin(StringRef Name,
+                                   llvm::function_ref<std::string()> Detail) {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->begin(Name, Detail());
+}
+
+void clang::timeTraceProfilerEnd() {
+  if (TimeTraceProfilerInstance)
+    TimeTraceProfilerInstance->end();
+}
@@ -18,6 +18,8 @@
 #include "llvm/ADT/iterator_range.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
@@ -682,6 +684,392 @@ std::error_code InMemoryFileSystem::setCurrentWorkingDirectory(const Twine &P) {
 }
 }
 
+//===-----------------------------------------------------------------------===/
+// ContentStoreFileSystem implementation
+//===-----------------------------------------------------------------------===/
+
+// A content store starts with a header:
+//   char     Signature[8]
+//   uint32_t Version
+//   uint32_t NumEntries
+//   uint64_t IndexOffset
+// The index is an array of NumEntries records, sorted by path:
+//   uint64_t PathOffset
+//   uint64_t DataOffset
+//   uint64_t Size
+//   int64_t  ModificationTime
+//   uint32_t PathLength
+//   uint32_t Kind
+// Integers are little-endian, and offsets are from the start of the store.
+// The contents of a file are followed by a null character.
+
+static const char ContentStoreSignature[] = {'C', 'L', 'V', 'F',
+                                             'S', 'C', 'A', 'S'};
+static const uint32_t ContentStoreVersion = 1;
+static const uint64_t ContentStoreHeaderSize = 24;
+static const uint64_t ContentStoreRecordSize = 40;
+
+namespace {
+
+enum ContentStoreEntryKind { CSK_File = 0, CSK_Directory = 1 };
+
+/// A buffer that references the contents of a file in a content store, and
+/// keeps the store alive.
+class ContentStoreBuffer : public llvm::MemoryBuffer {
+  std::shared_ptr<llvm::MemoryBuffer> Store;
+  std::string Name;
+
+public:
+  ContentStoreBuffer(std::shared_ptr<llvm::MemoryBuffer> Store,
+                     StringRef Contents, StringRef Name,
+                     bool RequiresNullTerminator)
+      : Store(std::move(Store)), Name(Name) {
+    init(Contents.begin(), Contents.end(), RequiresNullTerminator);
+  }
+
+  StringRef getBufferIdentifier() const override { return Name; }
+  BufferKind getBufferKind() const override { return Store->getBufferKind(); }
+};
+
+class ContentStoreFile : public File {
+  std::shared_ptr<llvm::MemoryBuffer> Store;
+  Status S;
+  StringRef Contents;
+
+public:
+  ContentStoreFile(std::shared_ptr<llvm::MemoryBuffer> Store, Status S,
+                   StringRef Contents)
+      : Store(std::move(Store)), S(std::move(S)), Contents(Contents) {}
+
+  llvm::ErrorOr<Status> status() override { return S; }
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>>
+  getBuffer(const Twine &Name, int64_t FileSize, bool RequiresNullTerminator,
+            bool IsVolatile) override {
+    return std::unique_ptr<llvm::MemoryBuffer>(new ContentStoreBuffer(
+        Store, Contents, Name.str(), RequiresNullTerminator));
+  }
+  std::error_code close() override { return std::error_code(); }
+};
+
+class ContentStoreFileSystem : public FileSystem {
+  std::shared_ptr<llvm::MemoryBuffer> Store;
+  const char *Index;
+  unsigned NumEntries;
+
+  /// The unique IDs of the entries, allocated when they are first needed.
+  std::vector<UniqueID> UniqueIDs;
+
+  std::string WorkingDirectory;
+
+  ContentStoreFileSystem(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+                         const char *Index, unsigned NumEntries)
+      : Store(std::move(Buffer)), Index(Index), NumEntries(NumEntries),
+        UniqueIDs(NumEntries) {
+    SmallString<128> CWD;
+    if (!llvm::sys::fs::current_path(CWD))
+      WorkingDirectory = CWD.str();
+  }
+
+public:
+  struct Entry {
+    StringRef Path;
+    StringRef Contents;
+    int64_t ModificationTime;
+    bool IsDirectory;
+  };
+
+  static IntrusiveRefCntPtr<FileSystem>
+  create(std::unique_ptr<llvm::MemoryBuffer> Buffer);
+
+  /// Read the entry at \p Idx of the index.  Returns false if it is malformed.
+  bool getEntry(unsigned Idx, Entry &E) const;
+
+  /// Returns the index of the first entry whose path is not less than \p Path.
+  unsigned lowerBound(StringRef Path) const;
+
+  /// Find the entry of \p P, made absolute and without dots.
+  llvm::ErrorOr<unsigned> lookup(const Twine &P, Entry &E) const;
+
+  Status getStatus(StringRef Name, unsigned Idx, const Entry &E);
+
+  llvm::ErrorOr<Status> status(const Twine &Path) override;
+  llvm::ErrorOr<std::unique_ptr<File>>
+  openFileForRead(const Twine &Path) override;
+  directory_iterator dir_begin(const Twine &Dir, std::error_code &EC) override;
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override;
+
+  unsigned getNumEntries() const { return NumEntries; }
+};
+
+} // end anonymous namespace
+
+IntrusiveRefCntPtr<FileSystem>
+ContentStoreFileSystem::create(std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < ContentStoreHeaderSize || !isContentStore(Data))
+    return nullptr;
+
+  using namespace llvm::support;
+  const unsigned char *D =
+      (const unsigned char *)Data.data() + sizeof(ContentStoreSignature);
+  uint32_t Version = endian::readNext<uint32_t, little, unaligned>(D);
+  uint32_t NumEntries = endian::readNext<uint32_t, little, unaligned>(D);
+  uint64_t IndexOffset = endian::readNext<uint64_t, little, unaligned>(D);
+  if (Version != ContentStoreVersion || IndexOffset > Data.size() ||
+      (Data.size() - IndexOffset) / ContentStoreRecordSize < NumEntries)
+    return nullptr;
+
+  const char *Index = Data.data() + IndexOffset;
+  return new ContentStoreFileSystem(std::move(Buffer), Index, NumEntries);
+}
+
+bool ContentStoreFileSystem::getEntry(unsigned Idx, Entry &E) const {
+  using namespace llvm::support;
+  StringRef Data = Store->getBuffer();
+  const unsigned char *D =
+      (const unsigned char *)Index + uint64_t(Idx) * ContentStoreRecordSize;
+  uint64_t PathOffset = endian::readNext<uint64_t, little, unaligned>(D);
+  uint64_t DataOffset = endian::readNext<uint64_t, little, unaligned>(D);
+  uint64_t Size = endian::readNext<uint64_t, little, unaligned>(D);
+  E.ModificationTime = endian::readNext<int64_t, little, unaligned>(D);
+  uint32_t PathLength = endian::readNext<uint32_t, little, unaligned>(D);
+  uint32_t Kind = endian::readNext<uint32_t, little, unaligned>(D);
+
+  if (PathOffset > Data.size() || Data.size() - PathOffset < PathLength)
+    return false;
+  E.Path = Data.substr(PathOffset, PathLength);
+  E.IsDirectory = Kind == CSK_Directory;
+  if (E.IsDirectory) {
+    E.Contents = StringRef();
+    return true;
+  }
+
+  // The contents must be followed by their null terminator.
+  if (Kind != CSK_File || DataOffset > Data.size() ||
+      Data.size() - DataOffset <= Size || Data[DataOffset + Size] != '\0')
+    return false;
+  E.Contents = Data.substr(DataOffset, Size);
+  return true;
+}
+
+unsigned ContentStoreFileSystem::lowerBound(StringRef Path) const {
+  unsigned Lo = 0, Hi = NumEntries;
+  while (Lo < Hi) {
+    unsigned Mid = Lo + (Hi - Lo) / 2;
+    Entry E;
+    // A malformed entry sorts first, so that it is never found.
+    if (!getEntry(Mid, E) || E.Path < Path)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+  return Lo;
+}
+
+llvm::ErrorOr<unsigned> ContentStoreFileSystem::lookup(const Twine &P,
+                                                       Entry &E) const {
+  SmallString<128> Path;
+  P.toVector(Path);
+  if (std::error_code EC = makeAbsolute(Path))
+    return EC;
+  llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+
+  unsigned Idx = lowerBound(Path);
+  if (Idx == NumEntries || !getEntry(Idx, E) || E.Path != Path)
+    return make_error_code(llvm::errc::no_such_file_or_directory);
+  return Idx;
+}
+
+Status ContentStoreFileSystem::getStatus(StringRef Name, unsigned Idx,
+                                         const Entry &E) {
+  UniqueID &ID = UniqueIDs[Idx];
+  if (ID.getFile() == 0)
+    ID = getNextVirtualUniqueID();
+  return Status(Name, ID, llvm::sys::toTimePoint(time_t(E.ModificationTime)),
+                0, 0, E.Contents.size(),
+                E.IsDirectory ? file_type::directory_file
+                              : file_type::regular_file,
+                perms::all_all);
+}
+
+llvm::ErrorOr<Status> ContentStoreFileSystem::status(const Twine &Path) {
+  Entry E;
+  llvm::ErrorOr<unsigned> Idx = lookup(Path, E);
+  if (!Idx)
+    return Idx.getError();
+  return getStatus(Path.str(), *Idx, E);
+}
+
+llvm::ErrorOr<std::unique_ptr<File>>
+ContentStoreFileSystem::openFileForRead(const Twine &Path) {
+  Entry E;
+  llvm::ErrorOr<unsigned> Idx = lookup(Path, E);
+  if (!Idx)
+    return Idx.getError();
+  if (E.IsDirectory)
+    return make_error_code(llvm::errc::invalid_argument);
+  return std::unique_ptr<File>(
+      new ContentStoreFile(Store, getStatus(Path.str(), *Idx, E), E.Contents));
+}
+
+namespace {
+/// Iterates over the entries of a content store whose path is in the
+/// directory Dir.  They all follow each other in the index, since they start
+/// with the path of Dir.
+class ContentStoreDirIterator : public clang::vfs::detail::DirIterImpl {
+  IntrusiveRefCntPtr<ContentStoreFileSystem> FS;
+  std::string Dir;
+  std::string Prefix;
+  unsigned Idx;
+
+  /// Move to the first child of Dir at or after Idx.
+  void findChild() {
+    for (; Idx != FS->getNumEntries(); ++Idx) {
+      ContentStoreFileSystem::Entry E;
+      if (!FS->getEntry(Idx, E))
+        continue;
+      if (!E.Path.startswith(Prefix))
+        break;
+      StringRef Name = E.Path.substr(Prefix.size());
+      if (Name.empty() || Name.find('/') != StringRef::npos)
+        continue;
+      SmallString<128> Path(Dir);
+      llvm::sys::path::append(Path, Name);
+      CurrentEntry = FS->getStatus(Path, Idx, E);
+      return;
+    }
+    CurrentEntry = Status();
+  }
+
+public:
+  ContentStoreDirIterator() {}
+  ContentStoreDirIterator(ContentStoreFileSystem &StoreFS, StringRef Dir,
+                          StringRef DirPath)
+      : FS(&StoreFS), Dir(Dir), Prefix(DirPath) {
+    if (!StringRef(Prefix).endswith("/"))
+      Prefix += '/';
+    Idx = FS->lowerBound(Prefix);
+    findChild();
+  }
+
+  std::error_code increment() override {
+    ++Idx;
+    findChild();
+    return std::error_code();
+  }
+};
+} // end anonymous namespace
+
+directory_iterator ContentStoreFileSystem::dir_begin(const Twine &Dir,
+                                                     std::error_code &EC) {
+  Entry E;
+  llvm::ErrorOr<unsigned> Idx = lookup(Dir, E);
+  if (!Idx) {
+    EC = Idx.getError();
+    return directory_iterator(std::make_shared<ContentStoreDirIterator>());
+  }
+  if (!E.IsDirectory) {
+    EC = make_error_code(llvm::errc::not_a_directory);
+    return directory_iterator(std::make_shared<ContentStoreDirIterator>());
+  }
+  return directory_iterator(
+      std::make_shared<ContentStoreDirIterator>(*this, Dir.str(), E.Path));
+}
+
+std::error_code
+ContentStoreFileSystem::setCurrentWorkingDirectory(const Twine &P) {
+  SmallString<128> Path;
+  P.toVector(Path);
+  if (std::error_code EC = makeAbsolute(Path))
+    return EC;
+  llvm::sys::path::remove_dots(Path, /*remove_dot_dot=*/true);
+  WorkingDirectory = Path.str();
+  return std::error_code();
+}
+
+bool vfs::isContentStore(StringRef Buffer) {
+  return Buffer.startswith(
+      StringRef(ContentStoreSignature, sizeof(ContentStoreSignature)));
+}
+
+IntrusiveRefCntPtr<FileSystem>
+vfs::getVFSFromContentStore(std::unique_ptr<llvm::MemoryBuffer> Buffer) {
+  return ContentStoreFileSystem::create(std::move(Buffer));
+}
+
+void ContentStoreWriter::addFile(StringRef Path, StringRef Contents,
+                                 time_t ModificationTime) {
+  assert(llvm::sys::path::is_absolute(Path) && "paths must be absolute");
+  FileInfo &Info = Files[Path];
+  Info.Contents = Contents;
+  Info.ModificationTime = ModificationTime;
+}
+
+void ContentStoreWriter::write(llvm::raw_ostream &OS) {
+  struct Record {
+    const FileInfo *File = nullptr;
+    uint64_t PathOffset = 0;
+    uint64_t DataOffset = 0;
+  };
+
+  // Collect the files and their parent directories, in path order.
+  std::map<StringRef, Record> Records;
+  for (const auto &F : Files) {
+    Records[F.first].File = &F.second;
+    for (StringRef Dir = llvm::sys::path::parent_path(F.first); !Dir.empty();
+         Dir = llvm::sys::path::parent_path(Dir))
+      if (!Records.insert(std::make_pair(Dir, Record())).second)
+        break;
+  }
+
+  // Lay out the paths after the index, followed by the contents, which are
+  // shared between files.
+  uint64_t Offset =
+      ContentStoreHeaderSize + Records.size() * ContentStoreRecordSize;
+  for (auto &R : Records) {
+    R.second.PathOffset = Offset;
+    Offset += R.first.size();
+  }
+  llvm::StringMap<uint64_t> ContentOffsets;
+  std::vector<StringRef> Contents;
+  for (auto &R : Records) {
+    if (!R.second.File)
+      continue;
+    StringRef Data = R.second.File->Contents;
+    auto Inserted = ContentOffsets.insert(std::make_pair(Data, Offset));
+    if (Inserted.second) {
+      Contents.push_back(Data);
+      Offset += Data.size() + 1;
+    }
+    R.second.DataOffset = Inserted.first->second;
+  }
+
+  using namespace llvm::support;
+  endian::Writer<little> LE(OS);
+  OS.write(ContentStoreSignature, sizeof(ContentStoreSignature));
+  LE.write<uint32_t>(ContentStoreVersion);
+  LE.write<uint32_t>(Records.size());
+  LE.write<uint64_t>(ContentStoreHeaderSize);
+  for (const auto &R : Records) {
+    const FileInfo *File = R.second.File;
+    LE.write<uint64_t>(R.second.PathOffset);
+    LE.write<uint64_t>(R.second.DataOffset);
+    LE.write<uint64_t>(File ? File->Contents.size() : 0);
+    LE.write<int64_t>(File ? File->ModificationTime : 0);
+    LE.write<uint32_t>(R.first.size());
+    LE.write<uint32_t>(File ? CSK_File : CSK_Directory);
+  }
+  for (const auto &R : Records)
+    OS << R.first;
+  for (StringRef Data : Contents) {
+    OS << Data;
+    OS.write('\0');
+  }
+}
+
 //===-----------------------------------------------------------------------===/
 // RedirectingFileSystem implementation
 //===-----------------------------------------------------------------------===/
@@ -8,9 +8,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/CodeGen/BackendUtil.h"
+#include "CheckedCBoundsCheckLowering.h"
+#include "CheckedCCheckRemarks.h"
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/LangOptions.h"
 #include "clang/Basic/TargetOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Frontend/CodeGenOptions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/Utils.h"
@@ -171,6 +174,22 @@ static void addBoundsCheckingPass(const PassManagerBuilder &Builder,
   PM.add(createBoundsCheckingPass());
 }
 
+static void addCheckedCBoundsCheckLoweringPass(const PassManagerBuilder &Builder,
+                                               legacy::PassManagerBase &PM) {
+  const PassManagerBuilderWrapper &BuilderWrapper =
+      static_cast<const PassManagerBuilderWrapper&>(Builder);
+  const CodeGenOptions &CGOpts = BuilderWrapper.getCGOpts();
+  PM.add(CodeGen::createCheckedCBoundsCheckLoweringPass(
+      Builder.OptLevel > 0,
+      CGOpts.getCheckedCTrapBlocks() != CodeGenOptions::CheckedCTrapPerCheck,
+      CGOpts.CheckedCStickyLoopChecks, CGOpts.CheckedCCheckCalls));
+}
+
+static void addCheckedCCheckRemarksPass(const PassManagerBuilder &Builder,
+                                        legacy::PassManagerBase &PM) {
+  PM.add(CodeGen::createCheckedCCheckRemarksPass());
+}
+
 static void addSanitizerCoveragePass(const PassManagerBuilder &Builder,
                                      legacy::PassManagerBase &PM) {
   const PassManagerBuilderWrapper &BuilderWrapper =
@@ -528,6 +547,24 @@ void EmitAssemblyHelper::CreatePasses(legacy::PassManager &MPM,
                            addBoundsCheckingPass);
   }
 
+  // Checked C bounds checks emitted as calls are expanded once the scalar
+  // optimizations have simplified the addresses they check.
+  if (CodeGenOpts.CheckedCLateCheckLowering) {
+    PMBuilder.addExtension(PassManagerBuilder::EP_ScalarOptimizerLate,
+                           addCheckedCBoundsCheckLoweringPass);
+    PMBuilder.addExtension(PassManagerBuilder::EP_EnabledOnOptLevel0,
+                           addCheckedCBoundsCheckLoweringPass);
+  }
+
+  // The remarks on the Checked C checks that survived optimization are
+  // reported once the optimizer is done with them.
+  if (CodeGenOpts.CheckedCCheckRemarks) {
+    PMBuilder.addExtension(PassManagerBuilder::EP_OptimizerLast,
+                           addCheckedCCheckRemarksPass);
+    PMBuilder.addExtension(PassManagerBuilder::EP_EnabledOnOptLevel0,
+                           addCheckedCCheckRemarksPass);
+  }
+
   if (CodeGenOpts.SanitizeCoverageType ||
       CodeGenOpts.SanitizeCoverageIndirectCalls ||
       CodeGenOpts.SanitizeCoverageTraceCmp) {
@@ -645,6 +682,10 @@ static void setCommandLineOpts(const CodeGenOptions &CodeGenOpts) {
   }
   for (const std::string &BackendOption : CodeGenOpts.BackendOptions)
     BackendArgs.push_back(BackendOption.c_str());
+  // Leave the global options alone if there is nothing to set, so that
+  // compilations on other threads can keep reading them.
+  if (BackendArgs.size() == 1)
+    return;
   BackendArgs.push_back(nullptr);
   llvm::cl::ParseCommandLineOptions(BackendArgs.size() - 1,
                                     BackendArgs.data());
@@ -779,18 +820,22 @@ void EmitAssemblyHelper::EmitAssembly(BackendAction Action,
 
     PerFunctionPasses.doInitialization();
     for (Function &F : *TheModule)
-      if (!F.isDeclaration())
+      if (!F.isDeclaration()) {
+        TimeTraceScope TimeScope("OptFunction", F.getName());
         PerFunctionPasses.run(F);
+      }
     PerFunctionPasses.doFinalization();
   }
 
   {
     PrettyStackTraceString CrashInfo("Per-module optimization passes");
+    TimeTraceScope TimeScope("OptModule", TheModule->getName());
     PerModulePasses.run(*TheModule);
   }
 
   {
     PrettyStackTraceString CrashInfo("Code generation");
+    TimeTraceScope TimeScope("CodeGenPasses", TheModule->getName());
     CodeGenPasses.run(*TheModule);
   }
 }
@@ -918,6 +963,18 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
                                                CodeGenOpts.DebugPassManager);
       }
     }
+
+    if (CodeGenOpts.CheckedCLateCheckLowering)
+      MPM.addPass(createModuleToFunctionPassAdaptor(
+          CodeGen::CheckedCBoundsCheckLoweringPass(
+              CodeGenOpts.OptimizationLevel > 0,
+              CodeGenOpts.getCheckedCTrapBlocks() !=
+                  CodeGenOptions::CheckedCTrapPerCheck,
+              CodeGenOpts.CheckedCStickyLoopChecks,
+              CodeGenOpts.CheckedCCheckCalls)));
+
+    if (CodeGenOpts.CheckedCCheckRemarks)
+      MPM.addPass(CodeGen::CheckedCCheckRemarksPass());
   }
 
   // FIXME: We still use the legacy pass manager to do code generation. We
@@ -974,12 +1031,14 @@ void EmitAssemblyHelper::EmitAssemblyWithNewPassManager(
   // Now that we have all of the passes ready, run them.
   {
     PrettyStackTraceString CrashInfo("Optimizer");
+    TimeTraceScope TimeScope("OptModule", TheModule->getName());
     MPM.run(*TheModule, MAM);
   }
 
   // Now if needed, run the legacy PM for codegen.
   if (NeedCodeGen) {
     PrettyStackTraceString CrashInfo("Code generation");
+    TimeTraceScope TimeScope("CodeGenPasses", TheModule->getName());
     CodeGenPasses.run(*TheModule);
   }
 }
@@ -1112,6 +1171,8 @@ void clang::EmitBackendOutput(DiagnosticsEngine &Diags,
                               const llvm::DataLayout &TDesc, Module *M,
                               BackendAction Action,
                               std::unique_ptr<raw_pwrite_stream> OS) {
+  TimeTraceScope TimeScope("Backend");
+
   if (!CGOpts.ThinLTOIndexFile.empty()) {
     // If we are performing a ThinLTO importing compile, load the function index
     // into memory and pass it into runThinLTOBackend, which will run the
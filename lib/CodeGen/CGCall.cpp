@@ -2363,6 +2363,8 @@ void CodeGenFunction::EmitFunctionProlog(const CGFunctionInfo &FI,
                                           +llvm::Value::MaximumAlignment);
             AI->addAttrs(llvm::AttrBuilder().addAlignmentAttr(Alignment));
           }
+
+          AddCheckedCDereferenceableAttr(AI, PVD);
         }
 
         if (Arg->getType().isRestrictQualified())
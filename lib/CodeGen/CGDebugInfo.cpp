@@ -119,6 +119,12 @@ void ApplyDebugLocation::init(SourceLocation TemporaryLocation,
 
 ApplyDebugLocation::ApplyDebugLocation(CodeGenFunction &CGF, const Expr *E)
     : CGF(&CGF) {
+  // Every expression that is emitted gets here, so don't compute the location
+  // of the expression when there is no debug info to attach it to.
+  if (!CGF.getDebugInfo()) {
+    this->CGF = nullptr;
+    return;
+  }
   init(E->getExprLoc());
 }
 
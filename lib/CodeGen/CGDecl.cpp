@@ -1260,15 +1260,17 @@ void CodeGenFunction::EmitAutoVarInit(const AutoVarEmission &emission) {
 
   // If this is a simple aggregate initialization, we can optimize it
   // in various ways.
-  bool isVolatile = type.isVolatileQualified();
+  EmitConstantAggregateInit(Loc, getContext().getTypeSizeInChars(type),
+                            constant, type.isVolatileQualified(), &D);
+}
 
-  llvm::Value *SizeVal =
-    llvm::ConstantInt::get(IntPtrTy,
-                           getContext().getTypeSizeInChars(type).getQuantity());
+void CodeGenFunction::EmitConstantAggregateInit(Address Loc, CharUnits Size,
+                                                llvm::Constant *constant,
+                                                bool isVolatile,
+                                                const VarDecl *D) {
+  llvm::Value *SizeVal = llvm::ConstantInt::get(IntPtrTy, Size.getQuantity());
 
-  llvm::Type *BP = AllocaInt8PtrTy;
-  if (Loc.getType() != BP)
-    Loc = Builder.CreateBitCast(Loc, BP);
+  Loc = Builder.CreateElementBitCast(Loc, Int8Ty);
 
   // If the initializer is all or mostly zeros, codegen with memset then do
   // a few stores afterward.
@@ -1278,30 +1280,28 @@ void CodeGenFunction::EmitAutoVarInit(const AutoVarEmission &emission) {
                          isVolatile);
     // Zero and undef don't require a stores.
     if (!constant->isNullValue() && !isa<llvm::UndefValue>(constant)) {
-      Loc = Builder.CreateBitCast(Loc, constant->getType()->getPointerTo());
+      Loc = Builder.CreateElementBitCast(Loc, constant->getType());
       emitStoresForInitAfterMemset(constant, Loc.getPointer(),
                                    isVolatile, Builder);
     }
   } else {
     // Otherwise, create a temporary global with the initializer then
-    // memcpy from the global to the alloca.
-    std::string Name = getStaticDeclName(CGM, D);
+    // memcpy from the global to the destination.
     unsigned AS = 0;
-    if (getLangOpts().OpenCL) {
+    if (getLangOpts().OpenCL)
       AS = CGM.getContext().getTargetAddressSpace(LangAS::opencl_constant);
-      BP = llvm::PointerType::getInt8PtrTy(getLLVMContext(), AS);
-    }
     llvm::GlobalVariable *GV =
       new llvm::GlobalVariable(CGM.getModule(), constant->getType(), true,
                                llvm::GlobalValue::PrivateLinkage,
-                               constant, Name, nullptr,
+                               constant,
+                               D ? getStaticDeclName(CGM, *D) : "agg.init",
+                               nullptr,
                                llvm::GlobalValue::NotThreadLocal, AS);
     GV->setAlignment(Loc.getAlignment().getQuantity());
     GV->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
 
-    Address SrcPtr = Address(GV, Loc.getAlignment());
-    if (SrcPtr.getType() != BP)
-      SrcPtr = Builder.CreateBitCast(SrcPtr, BP);
+    Address SrcPtr =
+        Builder.CreateElementBitCast(Address(GV, Loc.getAlignment()), Int8Ty);
 
     Builder.CreateMemCpy(Loc, SrcPtr, SizeVal, isVolatile);
   }
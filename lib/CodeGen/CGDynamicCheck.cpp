@@ -11,8 +11,14 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "CheckedCBoundsCheckLowering.h"
+#include "CheckedCCheckRemarks.h"
 #include "CodeGenFunction.h"
+#include "SanitizerMetadata.h"
+#include "clang/AST/CanonBounds.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Support/SaveAndRestore.h"
 
 using namespace clang;
 using namespace CodeGen;
@@ -26,9 +32,28 @@ namespace {
 
   STATISTIC(NumDynamicChecksExplicit, "The # of dynamic _Dynamic_check(cond) checks found");
   STATISTIC(NumDynamicChecksNonNull, "The # of dynamic non-null checks found");
+  STATISTIC(NumDynamicChecksNonNullElided, "The # of dynamic non-null checks elided (due to the pointer being known non-null)");
   STATISTIC(NumDynamicChecksOverflow, "The # of dynamic overflow checks found");
+  STATISTIC(NumDynamicChecksOverflowCombined, "The # of dynamic overflow checks done by the bounds check of the dereference of their result");
   STATISTIC(NumDynamicChecksRange, "The # of dynamic bounds checks found");
+  STATISTIC(NumDynamicChecksIndex, "The # of dynamic bounds checks done as one comparison of an index with a count");
+  STATISTIC(NumDynamicChecksProven, "The # of dynamic bounds checks omitted (due to the access being proved in bounds)");
+  STATISTIC(NumDynamicChecksNullTermConstant, "The # of dynamic bounds checks of constants written through null-terminated pointers");
   STATISTIC(NumDynamicChecksCast, "The # of dynamic cast checks found");
+
+  STATISTIC(NumDynamicChecksHoisted, "The # of dynamic bounds checks hoisted out of loops");
+  STATISTIC(NumDynamicChecksVersioned, "The # of dynamic bounds checks removed from the unchecked versions of loops");
+  STATISTIC(NumLoopsVersioned, "The # of loops versioned on a test that their bounds checks succeed");
+  STATISTIC(NumDynamicChecksCoalesced, "The # of dynamic bounds checks removed by coalescing them with other checks");
+  STATISTIC(NumDynamicCastChecksSubsumed, "The # of dynamic cast checks combined with the checks of accesses through their result");
+  STATISTIC(NumDynamicChecksSubsumedByCast, "The # of dynamic checks of accesses combined with the check of a dynamic bounds cast");
+
+  STATISTIC(NumDereferenceableParams, "The # of checked pointer parameters with a dereferenceable_or_null attribute");
+  STATISTIC(NumDereferenceableLoads, "The # of loads of _Ptr values with dereferenceable_or_null metadata");
+  STATISTIC(NumAddressSanitizerChecksSkipped, "The # of loads and stores kept from AddressSanitizer instrumentation (due to being checked by Checked C)");
+
+  STATISTIC(NumDynamicCheckFailedBlocks, "The # of dynamic check failure blocks emitted");
+  STATISTIC(NumDynamicCheckFailedBlocksShared, "The # of dynamic checks that reused a shared failure block");
 }
 
 //
@@ -40,10 +65,12 @@ void CodeGenFunction::EmitExplicitDynamicCheck(const Expr *Condition) {
     return;
 
   ++NumDynamicChecksExplicit;
+  SaveAndRestore<SourceLocation> SavedCheckLoc(DynamicCheckLoc,
+                                               Condition->getExprLoc());
 
   // Emit Check
   Value *ConditionVal = EvaluateExprAsBool(Condition);
-  EmitDynamicCheckBlocks(ConditionVal);
+  EmitDynamicCheckBlocks(ConditionVal, DCK_Explicit);
 }
 
 //
@@ -59,18 +86,70 @@ void CodeGenFunction::EmitDynamicNonNullCheck(const Address BaseAddr, const Qual
 
   ++NumDynamicChecksNonNull;
 
+  // Pointers to allocas, globals and the like can never be null.
+  Value *Ptr = BaseAddr.getPointer()->stripPointerCasts();
+  if (!isa<Constant>(Ptr) && isKnownNonZero(Ptr, CGM.getDataLayout())) {
+    ++NumDynamicChecksNonNullElided;
+    return;
+  }
+
+  // Neither can a pointer that an earlier check in a dominating block has
+  // already tested.
+  BasicBlock *Current = Builder.GetInsertBlock();
+  if (Current != KnownNonNullBlock) {
+    KnownNonNullValues.clear();
+    KnownNonNullBlock = Current;
+  }
+  if (!KnownNonNullValues.insert(Ptr).second) {
+    ++NumDynamicChecksNonNullElided;
+    return;
+  }
+
   Value *ConditionVal = Builder.CreateIsNotNull(BaseAddr.getPointer(), "_Dynamic_check.non_null");
-  EmitDynamicCheckBlocks(ConditionVal);
+  EmitDynamicCheckBlocks(ConditionVal, DCK_NonNull);
 }
 
-// TODO: This is currently unused. It may never be used.
-void CodeGenFunction::EmitDynamicOverflowCheck(const Address BaseAddr, const QualType BaseTy, const Address PtrAddr) {
-  if (!getLangOpts().CheckedC)
+// The overflow check of p + i is usually followed by the bounds check of
+// *(p + i).  The two are then done with a single branch: the condition that
+// the arithmetic did not overflow is and-ed into the range condition.
+void CodeGenFunction::EmitDynamicOverflowCheck(const Expr *E, Value *Result,
+                                               bool SignedIndices,
+                                               bool IsSubtraction) {
+  if (!getLangOpts().CheckedC ||
+      !CGM.getCodeGenOpts().CheckedCOverflowChecks || EmittingCheckedCBounds)
+    return;
+
+  // As for the pointer overflow sanitizer, arithmetic that has been folded
+  // to a constant, or that is not in the default address space, is left
+  // alone.
+  auto *GEP = dyn_cast<llvm::GEPOperator>(Result);
+  if (!GEP || isa<Constant>(Result) ||
+      Result->getType()->getPointerAddressSpace())
     return;
 
   ++NumDynamicChecksOverflow;
+  Value *IntPtr = nullptr;
+  Value *ComputedGEP = nullptr;
+  Value *Condition = EmitPointerArithmeticNoOverflow(
+      GEP, SignedIndices, IsSubtraction, IntPtr, ComputedGEP);
+  if (!Condition)
+    return;
 
-  // EmitDynamicCheckBlocks(Condition);
+  if (E == DeferredOverflowCheckExpr) {
+    PendingOverflowCheck = Condition;
+    return;
+  }
+  SaveAndRestore<SourceLocation> SavedCheckLoc(DynamicCheckLoc,
+                                               E->getExprLoc());
+  EmitDynamicCheckBlocks(Condition, DCK_Overflow);
+}
+
+void CodeGenFunction::EmitPendingOverflowCheck() {
+  if (!PendingOverflowCheck)
+    return;
+  Value *Condition = PendingOverflowCheck;
+  PendingOverflowCheck = nullptr;
+  EmitDynamicCheckBlocks(Condition, DCK_Overflow);
 }
 
 void CodeGenFunction::EmitDynamicBoundsCheck(const Address PtrAddr, const BoundsExpr *Bounds,
@@ -84,6 +163,12 @@ void CodeGenFunction::EmitDynamicBoundsCheck(const Address PtrAddr, const Bounds
   if (Bounds->isAny() || Bounds->isInvalid())
     return;
 
+  // The bounds checker proved that the access is in bounds.
+  if (CheckKind == BoundsCheckKind::BCK_None) {
+    ++NumDynamicChecksProven;
+    return;
+  }
+
   // We'll insert the bounds check for an assignment through a null-terminated pointer
   // later, when we know the value.
   if (CheckKind == BoundsCheckKind::BCK_NullTermWriteAssign && !Val)
@@ -99,6 +184,12 @@ void CodeGenFunction::EmitDynamicBoundsCheck(const Address PtrAddr, const Bounds
 
   ++NumDynamicChecksRange;
 
+  // The bounds may contain accesses of their own, which must not take the
+  // overflow check of this one.
+  Value *OverflowCheck = nullptr;
+  std::swap(OverflowCheck, PendingOverflowCheck);
+  SaveAndRestore<bool> EmittingBounds(EmittingCheckedCBounds, true);
+
   // Emit the code to generate the pointer values
   Address Lower = EmitPointerWithAlignment(BoundsRange->getLowerExpr());
 
@@ -116,6 +207,31 @@ void CodeGenFunction::EmitDynamicBoundsCheck(const Address PtrAddr, const Bounds
   if (Upper.getType() != PtrAddr.getType())
     Upper = Builder.CreateBitCast(Upper, PtrAddr.getType());
 
+  // A write through a null-terminated pointer at the upper bound is allowed
+  // if the value written is a nul.  When the value is a constant, whether
+  // the write is allowed there is known now.
+  bool AllowsNulAtUpper = false;
+  if (CheckKind == BCK_NullTermWriteAssign)
+    if (const Constant *C = dyn_cast<Constant>(Val)) {
+      AllowsNulAtUpper = C->isNullValue();
+      ++NumDynamicChecksNullTermConstant;
+    }
+
+  // With late lowering, the check is emitted as a call that LLVM optimizes
+  // and expands after the scalar optimizations have run.  Writes of values
+  // that are not constants through null-terminated pointers need the extra
+  // check at the upper bound, so they are always expanded here.
+  if (CGM.getCodeGenOpts().CheckedCLateCheckLowering &&
+      (CheckKind != BCK_NullTermWriteAssign || isa<Constant>(Val))) {
+    ++NumDynamicChecksInserted;
+    EmitDynamicCheckProfileCounter(DCK_Range);
+    bool AllowsUpper = CheckKind == BCK_NullTermRead || AllowsNulAtUpper;
+    EmitDynamicBoundsCheckCall(PtrAddr, Lower, Upper, AllowsUpper ? 0 : 1);
+    // The call cannot take the overflow check, which is emitted on its own.
+    PendingOverflowCheck = OverflowCheck;
+    return;
+  }
+
   // Make the lower check
   Value *LowerChk = Builder.CreateICmpULE(
       Lower.getPointer(), PtrAddr.getPointer(), "_Dynamic_check.lower");
@@ -123,7 +239,12 @@ void CodeGenFunction::EmitDynamicBoundsCheck(const Address PtrAddr, const Bounds
   // Make the upper check
   Value *UpperChk;
   assert(CheckKind != BCK_None);
-  if (CheckKind != BCK_NullTermRead)
+  if (CheckKind == BCK_NullTermWriteAssign && AllowsNulAtUpper)
+    // Writing a constant nul, such as a terminator, is allowed at the upper
+    // bound, like a read.  This needs no additional check.
+    UpperChk = Builder.CreateICmpULE(PtrAddr.getPointer(), Upper.getPointer(),
+                                     "_Dynamic_check.upper");
+  else if (CheckKind != BCK_NullTermRead)
     UpperChk = Builder.CreateICmpULT(PtrAddr.getPointer(), Upper.getPointer(),
                                      "_Dynamic_check.upper");
   else
@@ -132,21 +253,170 @@ void CodeGenFunction::EmitDynamicBoundsCheck(const Address PtrAddr, const Bounds
     UpperChk = Builder.CreateICmpULE(PtrAddr.getPointer(), Upper.getPointer(),
                                      "_Dynamic_check.upper");
   llvm::Value *Condition = Builder.CreateAnd(LowerChk, UpperChk, "_Dynamic_check.range");
+  // The overflow check of the pointer arithmetic that computed PtrAddr is
+  // done by the same branch, unless a failed range check gets a second
+  // chance at the upper bound of a null-terminated pointer.
+  if (OverflowCheck) {
+    if (CheckKind == BCK_NullTermWriteAssign && !isa<Constant>(Val))
+      PendingOverflowCheck = OverflowCheck;
+    else {
+      Condition = Builder.CreateAnd(Condition, OverflowCheck,
+                                    "_Dynamic_check.no_overflow");
+      ++NumDynamicChecksOverflowCombined;
+    }
+  }
   if (const ConstantInt *ConditionConstant = dyn_cast<ConstantInt>(Condition)) {
-    if (ConditionConstant->isOne())
+    if (ConditionConstant->isOne()) {
+      ++NumDynamicChecksElided;
       return;
+    }
   }
+
+  ++NumDynamicChecksInserted;
+  EmitDynamicCheckProfileCounter(DCK_Range);
+
+  BasicBlock *Begin = Builder.GetInsertBlock();
   BasicBlock *DyCkSuccess = createBasicBlock("_Dynamic_check.succeeded");
   BasicBlock *DyCkFailure;
-  if (CheckKind == BCK_NullTermWriteAssign)
+  if (CheckKind == BCK_NullTermWriteAssign && !isa<Constant>(Val))
     DyCkFailure = EmitNulltermWriteAdditionalCheck(PtrAddr, Upper, LowerChk,
                                                    Val, DyCkSuccess);
   else
-    DyCkFailure = EmitDynamicCheckFailedBlock();
-  Builder.CreateCondBr(Condition, DyCkSuccess, DyCkFailure);
+    DyCkFailure = EmitDynamicCheckFailedBlock(DCK_Range);
+  TagDynamicCheck(Builder.CreateCondBr(Condition, DyCkSuccess, DyCkFailure,
+                                       createProfileWeightsForDynamicCheck()),
+                  DCK_Range);
   // This ensures the success block comes directly after the branch
   EmitBlock(DyCkSuccess);
   Builder.SetInsertPoint(DyCkSuccess);
+  // Every path to the success block goes through Begin.
+  if (KnownNonNullBlock == Begin)
+    KnownNonNullBlock = DyCkSuccess;
+}
+
+void CodeGenFunction::EmitDynamicBoundsCheckCall(const Address PtrAddr,
+                                                 const Address Lower,
+                                                 const Address Upper,
+                                                 uint64_t Size) {
+  // The callee is opaque to the optimizer except that it only touches memory
+  // that the program cannot see, so loads and stores may be optimized across
+  // it.  It is deliberately not nounwind, so that memory accesses guarded by
+  // the check are not speculated above it.
+  llvm::Type *Args[] = { Int8PtrTy, Int8PtrTy, Int8PtrTy, Int64Ty };
+  llvm::FunctionType *FTy = llvm::FunctionType::get(VoidTy, Args, false);
+  llvm::AttributeList Attrs = llvm::AttributeList::get(
+      getLLVMContext(), llvm::AttributeList::FunctionIndex,
+      llvm::Attribute::InaccessibleMemOnly);
+  llvm::Constant *CheckFn =
+    CGM.CreateRuntimeFunction(FTy, CheckedCBoundsCheckFnName, Attrs);
+
+  llvm::Value *CallArgs[] = {
+    Builder.CreateBitCast(PtrAddr.getPointer(), Int8PtrTy),
+    Builder.CreateBitCast(Lower.getPointer(), Int8PtrTy),
+    Builder.CreateBitCast(Upper.getPointer(), Int8PtrTy),
+    llvm::ConstantInt::get(Int64Ty, Size)
+  };
+  TagDynamicCheck(EmitRuntimeCall(CheckFn, CallArgs), DCK_Range);
+}
+
+// Sema expands count(e) bounds of b to bounds(b, b + e), and byte_count(e)
+// bounds to the same with b cast to _Array_ptr<char> (see ExpandToRange in
+// SemaBounds.cpp).  If Range has this form, return e and set Lower to the
+// lower bound.
+static const Expr *GetCountOfRange(ASTContext &Ctx,
+                                   const RangeBoundsExpr *Range,
+                                   const Expr *&Lower) {
+  Lower = Range->getLowerExpr();
+  const BinaryOperator *Upper =
+    dyn_cast<BinaryOperator>(Range->getUpperExpr()->IgnoreParens());
+  if (!Upper || Upper->getOpcode() != BO_Add ||
+      !Upper->getLHS()->getType()->isPointerType() ||
+      !Upper->getRHS()->getType()->isIntegerType())
+    return nullptr;
+
+  // The expansion shares the lower bound with the upper bound.  Bounds
+  // written as a range are compared.
+  if (Upper->getLHS() != Lower) {
+    Lexicographic Lex(Ctx, nullptr);
+    if (Lex.CompareExpr(Upper->getLHS(), Lower) !=
+        Lexicographic::Result::Equal)
+      return nullptr;
+  }
+  return Upper->getRHS();
+}
+
+bool CodeGenFunction::EmitDynamicIndexBoundsCheck(const ArraySubscriptExpr *E,
+                                                  Value *Index) {
+  if (!getLangOpts().CheckedC || CGM.getCodeGenOpts().CheckedCLateCheckLowering)
+    return false;
+
+  // Writes through null-terminated pointers need the value written.
+  BoundsCheckKind CheckKind = E->getBoundsCheckKind();
+  if (CheckKind != BCK_Normal && CheckKind != BCK_NullTermRead)
+    return false;
+
+  ASTContext &Ctx = getContext();
+  const RangeBoundsExpr *Range =
+    dyn_cast_or_null<RangeBoundsExpr>(E->getBoundsExpr(Ctx));
+  if (!Range || Range->isInvalid())
+    return false;
+  const Expr *Lower;
+  const Expr *Count = GetCountOfRange(Ctx, Range, Lower);
+  if (!Count || !Lower->getType()->isPointerType())
+    return false;
+
+  // The base of the access must be the base of the bounds, evaluated again.
+  // Casts between pointer types do not change the address.
+  const Expr *Base = E->getBase();
+  if (!Base->getType()->isPointerType() || Base->HasSideEffects(Ctx) ||
+      Ctx.getAsVariableArrayType(E->getType()))
+    return false;
+  Lexicographic Lex(Ctx, nullptr);
+  if (Lex.CompareExpr(Base->IgnoreParenCasts(), Lower->IgnoreParenCasts()) !=
+      Lexicographic::Result::Equal)
+    return false;
+
+  // The count is in elements of the type pointed to by the lower bound.
+  QualType LowerElemTy = Lower->getType()->getPointeeType();
+  if (LowerElemTy->isIncompleteType() || E->getType()->isIncompleteType())
+    return false;
+  CharUnits ElemSize = Ctx.getTypeSizeInChars(E->getType());
+  CharUnits LowerElemSize = Ctx.getTypeSizeInChars(LowerElemTy);
+  if (ElemSize.isZero() ||
+      (ElemSize != LowerElemSize && !LowerElemSize.isOne()))
+    return false;
+
+  // Emits code as follows:
+  //   %count = max(%n, 0)       (if n is signed)
+  //   %index = %i <u %count     (or %i <=u %count for reads of
+  //                              null-terminated pointers)
+  //
+  // With the lower bound b, b <= b + i && b + i < b + n holds exactly when
+  // 0 <= i < n.  As an unsigned comparison, a negative i is too large, and
+  // a negative n is an empty range.
+  ++NumDynamicChecksRange;
+  ++NumDynamicChecksIndex;
+
+  if (ElemSize != LowerElemSize)
+    Index = Builder.CreateMul(
+        Index, llvm::ConstantInt::get(IntPtrTy, ElemSize.getQuantity()));
+
+  bool CountSigned = Count->getType()->isSignedIntegerOrEnumerationType();
+  Value *N = Builder.CreateIntCast(EmitScalarExpr(Count), IntPtrTy,
+                                   CountSigned);
+  if (CountSigned) {
+    Value *Zero = llvm::ConstantInt::get(IntPtrTy, 0);
+    N = Builder.CreateSelect(Builder.CreateICmpSGT(N, Zero), N, Zero,
+                             "_Dynamic_check.count");
+  }
+
+  Value *Condition;
+  if (CheckKind == BCK_NullTermRead)
+    Condition = Builder.CreateICmpULE(Index, N, "_Dynamic_check.index");
+  else
+    Condition = Builder.CreateICmpULT(Index, N, "_Dynamic_check.index");
+  EmitDynamicCheckBlocks(Condition, DCK_Range);
+  return true;
 }
 
 void CodeGenFunction::EmitDynamicBoundsCastCheck(const Address BaseAddr,
@@ -231,40 +501,7 @@ void CodeGenFunction::EmitDynamicBoundsCastCheck(const Address BaseAddr,
 
   Builder.SetInsertPoint(DyCkSubsumption);
 
-  // SubRange - bounds(lb, ub) vs CastRange - bounds(castlb, castub)
-  // Dynamic_check(lb <= castlb && castub <= ub)
-  // If required, we will be bitcasting castlb and castub at the
-  // LLVM IR level to match the types of lb and ub respectively.
-
-  // Emit the code to generate pointers for SubRange, lb and ub
-  Address Lower = EmitPointerWithAlignment(SubRange->getLowerExpr());
-  Address Upper = EmitPointerWithAlignment(SubRange->getUpperExpr());
-
-  // Emit the code to generate pointers for CastRange, castlb and castub
-
-  Address CastLower = EmitPointerWithAlignment(CastRange->getLowerExpr());
-  // We will be comparing CastLower to Lower. Their types may not match,
-  // so we're going to bitcast CastLower to match the type of Lower if needed.
-  if (CastLower.getType() != Lower.getType())
-    CastLower = Builder.CreateBitCast(CastLower, Lower.getType());
-
-  Address CastUpper = EmitPointerWithAlignment(CastRange->getUpperExpr());
-  // Again we're going to bitcast CastUpper to match the type of Upper
-  // if needed.
-  if (CastUpper.getType() != Upper.getType())
-    CastUpper = Builder.CreateBitCast(CastUpper, Upper.getType());
-
-  // Make the lower check (Lower <= CastLower)
-  Value *LowerChk = Builder.CreateICmpULE(
-      Lower.getPointer(), CastLower.getPointer(), "_Dynamic_check.lower");
-
-  // Make the upper check (CastUpper <= Upper)
-  Value *UpperChk = Builder.CreateICmpULE(
-      CastUpper.getPointer(), Upper.getPointer(), "_Dynamic_check.upper");
-
-  // Make Both Checks
-  Value *CastCond =
-      Builder.CreateAnd(LowerChk, UpperChk, "_Dynamic_check.cast");
+  Value *CastCond = EmitDynamicBoundsCastCondition(SubRange, CastRange);
 
   // Constant Folding:
   // If CastCond is true (one), then we need to insert a direct branch
@@ -301,18 +538,1060 @@ void CodeGenFunction::EmitDynamicBoundsCastCheck(const Address BaseAddr,
   }
 
   ++NumDynamicChecksInserted;
+  EmitDynamicCheckProfileCounter(DCK_Cast);
 
-  BasicBlock *DyCkFail = EmitDynamicCheckFailedBlock();
+  BasicBlock *DyCkFail = EmitDynamicCheckFailedBlock(DCK_Cast);
 
   // Insert the CastCond Branch
-  Builder.CreateCondBr(CastCond, DyCkSuccess, DyCkFail);
+  TagDynamicCheck(Builder.CreateCondBr(CastCond, DyCkSuccess, DyCkFail,
+                                       createProfileWeightsForDynamicCheck()),
+                  DCK_Cast);
 
   // This ensures the success block comes directly after the subsumption branch
   EmitBlock(DyCkSuccess);
   Builder.SetInsertPoint(DyCkSuccess);
 }
 
-void CodeGenFunction::EmitDynamicCheckBlocks(Value *Condition) {
+Value *CodeGenFunction::EmitDynamicBoundsCastCondition(
+    const RangeBoundsExpr *SubRange, const RangeBoundsExpr *CastRange) {
+  // SubRange - bounds(lb, ub) vs CastRange - bounds(castlb, castub)
+  // Dynamic_check(lb <= castlb && castub <= ub)
+  // If required, we will be bitcasting castlb and castub at the
+  // LLVM IR level to match the types of lb and ub respectively.
+
+  // Emit the code to generate pointers for SubRange, lb and ub
+  Address Lower = EmitPointerWithAlignment(SubRange->getLowerExpr());
+  Address Upper = EmitPointerWithAlignment(SubRange->getUpperExpr());
+
+  // Emit the code to generate pointers for CastRange, castlb and castub
+
+  Address CastLower = EmitPointerWithAlignment(CastRange->getLowerExpr());
+  // We will be comparing CastLower to Lower. Their types may not match,
+  // so we're going to bitcast CastLower to match the type of Lower if needed.
+  if (CastLower.getType() != Lower.getType())
+    CastLower = Builder.CreateBitCast(CastLower, Lower.getType());
+
+  Address CastUpper = EmitPointerWithAlignment(CastRange->getUpperExpr());
+  // Again we're going to bitcast CastUpper to match the type of Upper
+  // if needed.
+  if (CastUpper.getType() != Upper.getType())
+    CastUpper = Builder.CreateBitCast(CastUpper, Upper.getType());
+
+  // Make the lower check (Lower <= CastLower)
+  Value *LowerChk = Builder.CreateICmpULE(
+      Lower.getPointer(), CastLower.getPointer(), "_Dynamic_check.lower");
+
+  // Make the upper check (CastUpper <= Upper)
+  Value *UpperChk = Builder.CreateICmpULE(
+      CastUpper.getPointer(), Upper.getPointer(), "_Dynamic_check.upper");
+
+  // Make Both Checks
+  return Builder.CreateAnd(LowerChk, UpperChk, "_Dynamic_check.cast");
+}
+
+void CodeGenFunction::EmitDynamicBoundsRangeCheck(const Address First,
+                                                  const Address Last,
+                                                  const RangeBoundsExpr *Bounds,
+                                                  BoundsCheckKind CheckKind) {
+  ++NumDynamicChecksRange;
+  Value *Condition = EmitDynamicBoundsRangeCondition(First, Last, Bounds,
+                                                     CheckKind);
+  EmitDynamicCheckBlocks(Condition, DCK_Range);
+}
+
+Value *
+CodeGenFunction::EmitDynamicBoundsRangeCondition(const Address First,
+                                                 const Address Last,
+                                                 const RangeBoundsExpr *Bounds,
+                                                 BoundsCheckKind CheckKind) {
+  // Emits code as follows:
+  //   %lower_ok = %lower <= %first
+  //   %upper_ok = %last < %upper  (or %last <= %upper for reads of
+  //                                null-terminated pointers)
+  //   %range = %lower_ok && %upper_ok
+  //
+  // This is only sound if %first <= %last, which the caller guarantees.
+  SaveAndRestore<bool> EmittingBounds(EmittingCheckedCBounds, true);
+  Address Lower = EmitPointerWithAlignment(Bounds->getLowerExpr());
+  if (Lower.getType() != First.getType())
+    Lower = Builder.CreateBitCast(Lower, First.getType());
+
+  Address Upper = EmitPointerWithAlignment(Bounds->getUpperExpr());
+  if (Upper.getType() != Last.getType())
+    Upper = Builder.CreateBitCast(Upper, Last.getType());
+
+  Value *LowerChk = Builder.CreateICmpULE(
+      Lower.getPointer(), First.getPointer(), "_Dynamic_check.lower");
+
+  Value *UpperChk;
+  if (CheckKind != BCK_NullTermRead)
+    UpperChk = Builder.CreateICmpULT(Last.getPointer(), Upper.getPointer(),
+                                     "_Dynamic_check.upper");
+  else
+    UpperChk = Builder.CreateICmpULE(Last.getPointer(), Upper.getPointer(),
+                                     "_Dynamic_check.upper");
+
+  return Builder.CreateAnd(LowerChk, UpperChk, "_Dynamic_check.range");
+}
+
+//
+// Moving bounds checks earlier (-fcheckedc-hoist-checks and
+// -fcheckedc-coalesce-checks)
+//
+// The checks for a memory access can be done before the access itself, as
+// long as the values that the check uses are the same at both points and
+// the access is certain to be executed.  This is used in two ways.
+//
+// Hoisting: for a loop of the form
+//
+//   for (...; i < n; i++) {
+//     ... p[i + c] ...
+//   }
+//
+// where the bounds of p[i + c] and the base p are loop-invariant and the
+// subscript is evaluated on every iteration, the per-iteration range check
+// is replaced by a single check in the loop preheader that the addresses
+// p + (i + c) ... p + (n - 1 + c) are all within bounds.  The preheader
+// check is only done if the loop executes at least once.
+//
+// Coalescing: in a sequence of statements without control flow, the
+// accesses p[e + c1], ..., p[e + cn] with the same bounds are checked once,
+// before the sequence, by checking that p + (e + min(ci)) ...
+// p + (e + max(ci)) are within bounds.
+//
+// A consequence is that a failing check traps before the code preceding the
+// bad access has run.  Checked C only requires that a bad access is never
+// performed, so this is allowed.
+//
+
+namespace {
+  typedef llvm::SmallPtrSet<const VarDecl *, 8> VarSet;
+
+  // A region of code (a loop, or a sequence of statements) in which checks
+  // are moved to the start of the region.
+  struct CheckRegion {
+    // Variables that may have different values at different points in the
+    // region: those assigned, incremented, decremented or declared in it.
+    VarSet Modified;
+    // Variables whose address is taken in the function.
+    const VarSet *AddressTaken;
+  };
+
+  // A memory access with a range bounds check.  The address being checked
+  // is Base + (Index + Offset), in units of the type pointed to by Base.
+  struct CheckedAccess {
+    const Expr *E;     // The array subscript, dereference or member access.
+    const Expr *Base;
+    const Expr *Index; // Null if the index is the constant Offset.
+    int64_t Offset;
+    const RangeBoundsExpr *Bounds;
+    BoundsCheckKind Kind;
+  };
+
+  // Information about a for loop whose checks may be hoisted.
+  struct HoistableLoop : CheckRegion {
+    const VarDecl *InductionVar;
+    const Expr *UpperBound;   // The n in i < n or i <= n.
+    bool InclusiveUpperBound; // True for i <= n.
+  };
+}
+
+static const VarDecl *GetVarDecl(const Expr *E) {
+  if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(E->IgnoreParenImpCasts()))
+    return dyn_cast<VarDecl>(DR->getDecl());
+  return nullptr;
+}
+
+// Collect the variables whose address is taken in S.
+static void CollectAddressTakenVars(const Stmt *S, VarSet &AddressTaken) {
+  if (!S)
+    return;
+
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(S))
+    if (UO->getOpcode() == UO_AddrOf)
+      if (const DeclRefExpr *DR =
+            dyn_cast<DeclRefExpr>(UO->getSubExpr()->IgnoreParens()))
+        if (const VarDecl *V = dyn_cast<VarDecl>(DR->getDecl()))
+          AddressTaken.insert(V);
+
+  for (const Stmt *SubStmt : S->children())
+    CollectAddressTakenVars(SubStmt, AddressTaken);
+}
+
+// Collect the variables that may be modified by S.  Return false if S
+// contains a jump out of the region or a label that may be jumped to from
+// outside the region, in which case no checks may be moved.
+static bool CollectModifiedVars(const Stmt *S, VarSet &Modified) {
+  if (!S)
+    return true;
+
+  switch (S->getStmtClass()) {
+    case Stmt::BreakStmtClass:
+    case Stmt::ReturnStmtClass:
+    case Stmt::GotoStmtClass:
+    case Stmt::IndirectGotoStmtClass:
+    case Stmt::LabelStmtClass:
+    case Stmt::CaseStmtClass:
+    case Stmt::DefaultStmtClass:
+    case Stmt::GCCAsmStmtClass:
+    case Stmt::MSAsmStmtClass:
+      return false;
+    case Stmt::DeclStmtClass:
+      for (const Decl *D : cast<DeclStmt>(S)->decls())
+        if (const VarDecl *V = dyn_cast<VarDecl>(D))
+          Modified.insert(V);
+      break;
+    case Stmt::BinaryOperatorClass:
+    case Stmt::CompoundAssignOperatorClass: {
+      const BinaryOperator *BO = cast<BinaryOperator>(S);
+      if (BO->isAssignmentOp())
+        if (const VarDecl *V = GetVarDecl(BO->getLHS()))
+          Modified.insert(V);
+      break;
+    }
+    case Stmt::UnaryOperatorClass: {
+      const UnaryOperator *UO = cast<UnaryOperator>(S);
+      if (UO->isIncrementDecrementOp())
+        if (const VarDecl *V = GetVarDecl(UO->getSubExpr()))
+          Modified.insert(V);
+      break;
+    }
+    default:
+      break;
+  }
+
+  for (const Stmt *SubStmt : S->children())
+    if (!CollectModifiedVars(SubStmt, Modified))
+      return false;
+  return true;
+}
+
+// Returns true if V can only be modified by code that names it directly,
+// so that CollectModifiedVars finds all of its modifications.
+static bool IsTrackableVar(const VarDecl *V, const CheckRegion &Region) {
+  return V->hasLocalStorage() && !V->hasAttr<BlocksAttr>() &&
+         !V->getType().isVolatileQualified() && !Region.AddressTaken->count(V);
+}
+
+static bool IsInvariantVar(const VarDecl *V, const CheckRegion &Region) {
+  return IsTrackableVar(V, Region) && !Region.Modified.count(V);
+}
+
+// Returns true if E has no side effects and evaluates to the same value
+// everywhere in the region.  This only accepts a small set of expressions
+// over local variables, which covers typical bounds and loop limits.
+static bool IsRegionInvariant(const Expr *E, const CheckRegion &Region) {
+  E = E->IgnoreParens();
+  switch (E->getStmtClass()) {
+    case Expr::IntegerLiteralClass:
+    case Expr::CharacterLiteralClass:
+      return true;
+    case Expr::UnaryExprOrTypeTraitExprClass:
+      return !cast<UnaryExprOrTypeTraitExpr>(E)->getTypeOfArgument()
+                  ->isVariablyModifiedType();
+    case Expr::DeclRefExprClass: {
+      const DeclRefExpr *DR = cast<DeclRefExpr>(E);
+      if (isa<EnumConstantDecl>(DR->getDecl()))
+        return true;
+      const VarDecl *V = dyn_cast<VarDecl>(DR->getDecl());
+      return V && !DR->refersToEnclosingVariableOrCapture() &&
+             IsInvariantVar(V, Region);
+    }
+    case Expr::ImplicitCastExprClass:
+    case Expr::CStyleCastExprClass: {
+      const CastExpr *CE = cast<CastExpr>(E);
+      const Expr *SubExpr = CE->getSubExpr();
+      switch (CE->getCastKind()) {
+        case CK_LValueToRValue:
+          return isa<DeclRefExpr>(SubExpr->IgnoreParens()) &&
+                 IsRegionInvariant(SubExpr, Region);
+        case CK_ArrayToPointerDecay: {
+          // The address of an array variable never changes.
+          const DeclRefExpr *DR =
+            dyn_cast<DeclRefExpr>(SubExpr->IgnoreParens());
+          return DR && isa<VarDecl>(DR->getDecl()) &&
+                 !DR->refersToEnclosingVariableOrCapture();
+        }
+        case CK_NoOp:
+        case CK_BitCast:
+        case CK_IntegralCast:
+        case CK_IntegralToPointer:
+        case CK_PointerToIntegral:
+        case CK_NullToPointer:
+          return IsRegionInvariant(SubExpr, Region);
+        default:
+          return false;
+      }
+    }
+    case Expr::UnaryOperatorClass: {
+      const UnaryOperator *UO = cast<UnaryOperator>(E);
+      if (UO->getOpcode() != UO_Plus && UO->getOpcode() != UO_Minus)
+        return false;
+      return IsRegionInvariant(UO->getSubExpr(), Region);
+    }
+    case Expr::BinaryOperatorClass: {
+      const BinaryOperator *BO = cast<BinaryOperator>(E);
+      switch (BO->getOpcode()) {
+        case BO_Add:
+        case BO_Sub:
+        case BO_Mul:
+          return IsRegionInvariant(BO->getLHS(), Region) &&
+                 IsRegionInvariant(BO->getRHS(), Region);
+        default:
+          return false;
+      }
+    }
+    default:
+      return false;
+  }
+}
+
+// Split an integer expression into the form Index + Offset, where Offset is
+// a constant.  Index is set to null if the whole expression is constant.
+static void SplitConstantOffset(ASTContext &Ctx, const Expr *E,
+                                const Expr *&Index, llvm::APSInt &Offset) {
+  if (E->EvaluateAsInt(Offset, Ctx)) {
+    Index = nullptr;
+    return;
+  }
+
+  Index = E;
+  Offset = llvm::APSInt::get(0);
+  const BinaryOperator *BO = dyn_cast<BinaryOperator>(E->IgnoreParenImpCasts());
+  if (!BO || (BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub))
+    return;
+
+  llvm::APSInt C;
+  if (BO->getRHS()->EvaluateAsInt(C, Ctx)) {
+    Index = BO->getLHS();
+    Offset = BO->getOpcode() == BO_Sub ? -C : C;
+  } else if (BO->getOpcode() == BO_Add &&
+             BO->getLHS()->EvaluateAsInt(C, Ctx)) {
+    Index = BO->getRHS();
+    Offset = C;
+  }
+}
+
+// If E is a memory access with a range bounds check that can be moved,
+// describe it in Access.
+static bool GetCheckedAccess(ASTContext &Ctx, const Expr *E,
+                             CheckedAccess &Access) {
+  const BoundsExpr *Bounds = nullptr;
+  const Expr *IndexExpr = nullptr;
+  Access.E = E;
+  switch (E->getStmtClass()) {
+    case Expr::ArraySubscriptExprClass: {
+      const ArraySubscriptExpr *ASE = cast<ArraySubscriptExpr>(E);
+      if (Ctx.getAsVariableArrayType(ASE->getType()))
+        return false;
+      Access.Base = ASE->getBase();
+      IndexExpr = ASE->getIdx();
+      Bounds = ASE->getBoundsExpr(Ctx);
+      Access.Kind = ASE->getBoundsCheckKind();
+      break;
+    }
+    case Expr::UnaryOperatorClass: {
+      const UnaryOperator *UO = cast<UnaryOperator>(E);
+      if (UO->getOpcode() != UO_Deref)
+        return false;
+      Access.Base = UO->getSubExpr();
+      const BinaryOperator *BO =
+        dyn_cast<BinaryOperator>(Access.Base->IgnoreParens());
+      if (BO && BO->getOpcode() == BO_Add &&
+          BO->getLHS()->getType()->isPointerType()) {
+        Access.Base = BO->getLHS();
+        IndexExpr = BO->getRHS();
+      }
+      Bounds = UO->getBoundsExpr(Ctx);
+      Access.Kind = UO->getBoundsCheckKind();
+      break;
+    }
+    case Expr::MemberExprClass: {
+      // Only the base pointer of a -> access is checked.
+      const MemberExpr *ME = cast<MemberExpr>(E);
+      if (!ME->isArrow())
+        return false;
+      Access.Base = ME->getBase();
+      Bounds = ME->getBoundsExpr(Ctx);
+      Access.Kind = ME->isBoundsCheckProven() ? BCK_None : BCK_Normal;
+      break;
+    }
+    default:
+      return false;
+  }
+
+  Access.Bounds = dyn_cast_or_null<RangeBoundsExpr>(Bounds);
+  if (!Access.Bounds ||
+      (Access.Kind != BCK_Normal && Access.Kind != BCK_NullTermRead &&
+       Access.Kind != BCK_NullTermWriteAssign) ||
+      !Access.Base->getType()->isPointerType())
+    return false;
+
+  llvm::APSInt Offset = llvm::APSInt::get(0);
+  Access.Index = nullptr;
+  if (IndexExpr)
+    SplitConstantOffset(Ctx, IndexExpr, Access.Index, Offset);
+  if (Offset.getMinSignedBits() > 32)
+    return false;
+  Access.Offset = Offset.getSExtValue();
+  return true;
+}
+
+// Returns true if evaluating S may transfer control somewhere other than
+// to the statement following it, or only conditionally evaluates some of its
+// subexpressions.  Accesses in such statements may not be executed every
+// time the statement is.
+static bool HasConditionalControlFlow(const Stmt *S) {
+  if (!S)
+    return false;
+
+  switch (S->getStmtClass()) {
+    case Stmt::CompoundStmtClass:
+    case Stmt::DeclStmtClass:
+      break;
+    case Stmt::BinaryOperatorClass: {
+      const BinaryOperator *BO = cast<BinaryOperator>(S);
+      if (BO->isLogicalOp())
+        return true;
+      break;
+    }
+    default:
+      // Other statements are control flow; other expressions are fine.
+      if (!isa<Expr>(S))
+        return true;
+      if (isa<AbstractConditionalOperator>(S) || isa<StmtExpr>(S) ||
+          isa<ChooseExpr>(S) || isa<BlockExpr>(S))
+        return true;
+      break;
+  }
+
+  for (const Stmt *SubStmt : S->children())
+    if (HasConditionalControlFlow(SubStmt))
+      return true;
+  return false;
+}
+
+// Collect the accesses in S whose checks can be moved to the start of the
+// region: those whose base and bounds are invariant in the region.  Writes
+// through null-terminated pointers may also write a nul at the upper bound,
+// which a moved check does not allow, so they are only collected if
+// NullTermWrites is set.
+static void CollectMovableAccesses(ASTContext &Ctx, const Stmt *S,
+                                   const CheckRegion &Region,
+                                   SmallVectorImpl<CheckedAccess> &Found,
+                                   bool NullTermWrites = false) {
+  if (!S)
+    return;
+
+  // Do not look into expressions that are not evaluated.
+  if (isa<UnaryExprOrTypeTraitExpr>(S))
+    return;
+
+  CheckedAccess Access;
+  if (const Expr *E = dyn_cast<Expr>(S))
+    if (GetCheckedAccess(Ctx, E, Access) &&
+        (NullTermWrites || Access.Kind != BCK_NullTermWriteAssign) &&
+        IsRegionInvariant(Access.Base, Region) &&
+        IsRegionInvariant(Access.Bounds->getLowerExpr(), Region) &&
+        IsRegionInvariant(Access.Bounds->getUpperExpr(), Region))
+      Found.push_back(Access);
+
+  for (const Stmt *SubStmt : S->children())
+    CollectMovableAccesses(Ctx, SubStmt, Region, Found, NullTermWrites);
+}
+
+// Compute the addresses Base + (First + Access.Offset) and
+// Base + (Last + Access.Offset).
+static std::pair<Address, Address>
+EmitMovedAccessRange(CodeGenFunction &CGF, const CheckedAccess &Access,
+                     Address Base, Value *First, Value *Last) {
+  CGBuilderTy &Builder = CGF.Builder;
+  // These addresses may be out of bounds, so the GEPs are not inbounds.
+  Value *Offset = llvm::ConstantInt::get(CGF.IntPtrTy, Access.Offset, true);
+  Address FirstAddr(Builder.CreateGEP(Base.getPointer(),
+                                      Builder.CreateAdd(First, Offset)),
+                    Base.getAlignment());
+  Address LastAddr(Builder.CreateGEP(Base.getPointer(),
+                                     Builder.CreateAdd(Last, Offset)),
+                   Base.getAlignment());
+  return std::make_pair(FirstAddr, LastAddr);
+}
+
+// Emit the checks for Access for the indices First ... Last.  First and
+// Last are of type intptr_t and exclude Access.Offset.
+static void EmitMovedAccessCheck(CodeGenFunction &CGF,
+                                 const CheckedAccess &Access,
+                                 Value *First, Value *Last) {
+  SaveAndRestore<SourceLocation> SavedCheckLoc(CGF.DynamicCheckLoc,
+                                               Access.E->getExprLoc());
+  Address Base = CGF.EmitPointerWithAlignment(Access.Base);
+  CGF.EmitDynamicNonNullCheck(Base, Access.Base->getType());
+
+  std::pair<Address, Address> Range =
+      EmitMovedAccessRange(CGF, Access, Base, First, Last);
+  CGF.EmitDynamicBoundsRangeCheck(Range.first, Range.second, Access.Bounds,
+                                  Access.Kind);
+}
+
+// Emit a value that is true if the checks for Access for the indices
+// First ... Last would all succeed.
+static Value *EmitMovedAccessCondition(CodeGenFunction &CGF,
+                                       const CheckedAccess &Access,
+                                       Value *First, Value *Last) {
+  CGBuilderTy &Builder = CGF.Builder;
+  Address Base = CGF.EmitPointerWithAlignment(Access.Base);
+  std::pair<Address, Address> Range =
+      EmitMovedAccessRange(CGF, Access, Base, First, Last);
+  Value *Condition = CGF.EmitDynamicBoundsRangeCondition(
+      Range.first, Range.second, Access.Bounds, Access.Kind);
+
+  QualType BaseTy = Access.Base->getType();
+  if (BaseTy->isCheckedPointerType() || BaseTy->isCheckedArrayType())
+    Condition = Builder.CreateAnd(
+        Builder.CreateIsNotNull(Base.getPointer(), "_Dynamic_check.non_null"),
+        Condition);
+  return Condition;
+}
+
+// Match a for loop whose induction variable IV, of type IVType, counts up
+// by 1 to a loop-invariant bound, and whose body does not leave the loop
+// other than through the condition.  AddressTaken is the set of variables
+// whose address is taken in the function.
+static bool MatchCountedLoop(ASTContext &Ctx, const ForStmt &S,
+                             const VarSet *AddressTaken, HoistableLoop &Loop,
+                             const Expr *&IV, QualType &IVType) {
+  if (!S.getCond() || !S.getInc() || !S.getBody() || S.getConditionVariable())
+    return false;
+
+  // Match the condition i < n, i <= n, n > i or n >= i.
+  const BinaryOperator *Cond =
+    dyn_cast<BinaryOperator>(S.getCond()->IgnoreParens());
+  if (!Cond)
+    return false;
+  IV = nullptr;
+  switch (Cond->getOpcode()) {
+    case BO_LT:
+    case BO_LE:
+      IV = Cond->getLHS();
+      Loop.UpperBound = Cond->getRHS();
+      Loop.InclusiveUpperBound = Cond->getOpcode() == BO_LE;
+      break;
+    case BO_GT:
+    case BO_GE:
+      IV = Cond->getRHS();
+      Loop.UpperBound = Cond->getLHS();
+      Loop.InclusiveUpperBound = Cond->getOpcode() == BO_GE;
+      break;
+    default:
+      return false;
+  }
+
+  const DeclRefExpr *IVRef = dyn_cast<DeclRefExpr>(IV->IgnoreParenImpCasts());
+  if (!IVRef || IVRef->refersToEnclosingVariableOrCapture())
+    return false;
+  Loop.InductionVar = dyn_cast<VarDecl>(IVRef->getDecl());
+  if (!Loop.InductionVar)
+    return false;
+
+  // The comparison must be done in the (promoted) type of the induction
+  // variable, so that the values of the induction variable are exactly the
+  // values that are compared.
+  IVType = Loop.InductionVar->getType();
+  if (!IVType->isIntegerType())
+    return false;
+  if (Ctx.isPromotableIntegerType(IVType))
+    IVType = Ctx.getPromotedIntegerType(IVType);
+  if (!Ctx.hasSameUnqualifiedType(IVType, IV->getType()))
+    return false;
+
+  // Match the increment ++i, i++ or i += 1.
+  const Expr *Inc = S.getInc()->IgnoreParens();
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(Inc)) {
+    if (!UO->isIncrementOp() ||
+        GetVarDecl(UO->getSubExpr()) != Loop.InductionVar)
+      return false;
+  } else if (const CompoundAssignOperator *CA =
+               dyn_cast<CompoundAssignOperator>(Inc)) {
+    llvm::APSInt Step;
+    if (CA->getOpcode() != BO_AddAssign ||
+        GetVarDecl(CA->getLHS()) != Loop.InductionVar ||
+        !CA->getRHS()->EvaluateAsInt(Step, Ctx) || Step != 1)
+      return false;
+  } else
+    return false;
+
+  // The induction variable may only be modified by the increment.
+  if (!CollectModifiedVars(S.getBody(), Loop.Modified) ||
+      Loop.Modified.count(Loop.InductionVar))
+    return false;
+  Loop.Modified.insert(Loop.InductionVar);
+
+  Loop.AddressTaken = AddressTaken;
+
+  return IsTrackableVar(Loop.InductionVar, Loop) &&
+         IsRegionInvariant(Loop.UpperBound, Loop);
+}
+
+// Remove the accesses whose index is not the induction variable of Loop.
+static void KeepInductionVarAccesses(const HoistableLoop &Loop,
+                                     SmallVectorImpl<CheckedAccess> &Accesses) {
+  Accesses.erase(
+      std::remove_if(Accesses.begin(), Accesses.end(),
+                     [&Loop](const CheckedAccess &A) {
+                       return !A.Index ||
+                              GetVarDecl(A.Index) != Loop.InductionVar;
+                     }),
+      Accesses.end());
+}
+
+// Emit the first and last values of the induction variable of Loop, as
+// intptr_t.  This is only meaningful if the loop is entered.
+static void EmitIterationRange(CodeGenFunction &CGF, const HoistableLoop &Loop,
+                               const Expr *IV, QualType IVType, Value *&First,
+                               Value *&Last) {
+  CGBuilderTy &Builder = CGF.Builder;
+  bool IVSigned = IVType->isSignedIntegerOrEnumerationType();
+  First = Builder.CreateIntCast(CGF.EmitScalarExpr(IV), CGF.IntPtrTy,
+                                IVSigned, "_Dynamic_check.first_index");
+  Last = Builder.CreateIntCast(CGF.EmitScalarExpr(Loop.UpperBound),
+                               CGF.IntPtrTy, IVSigned);
+  if (!Loop.InclusiveUpperBound)
+    Last = Builder.CreateSub(Last, llvm::ConstantInt::get(CGF.IntPtrTy, 1),
+                             "_Dynamic_check.last_index");
+}
+
+void CodeGenFunction::ComputeCheckedCAddressTakenVars() {
+  if (CheckedCAddressTakenVarsComputed)
+    return;
+  if (CurCodeDecl)
+    CollectAddressTakenVars(CurCodeDecl->getBody(), CheckedCAddressTakenVars);
+  CheckedCAddressTakenVarsComputed = true;
+}
+
+void CodeGenFunction::EmitHoistedBoundsChecks(
+    const ForStmt &S, SmallVectorImpl<const Expr *> &Hoisted) {
+  if (!getLangOpts().CheckedC)
+    return;
+
+  ComputeCheckedCAddressTakenVars();
+  ASTContext &Ctx = getContext();
+  HoistableLoop Loop;
+  const Expr *IV;
+  QualType IVType;
+  if (!MatchCountedLoop(Ctx, S, &CheckedCAddressTakenVars, Loop, IV, IVType))
+    return;
+
+  // Only accesses that are evaluated on every iteration of the loop can
+  // be hoisted.  These are the ones in the leading statements of the body
+  // that contain no control flow.
+  SmallVector<CheckedAccess, 4> Candidates;
+  const Stmt *Body = S.getBody();
+  if (const CompoundStmt *CS = dyn_cast<CompoundStmt>(Body)) {
+    for (const Stmt *BodyStmt : CS->body()) {
+      if (HasConditionalControlFlow(BodyStmt))
+        break;
+      CollectMovableAccesses(Ctx, BodyStmt, Loop, Candidates);
+    }
+  } else if (!HasConditionalControlFlow(Body))
+    CollectMovableAccesses(Ctx, Body, Loop, Candidates);
+
+  // The index of the access must be the induction variable.
+  KeepInductionVarAccesses(Loop, Candidates);
+  if (Candidates.empty())
+    return;
+
+  // Emits code as follows:
+  //
+  // %preheader:
+  //   ... (loop initialization)
+  //   %cond = (i < n)
+  //   br i1 %cond, %hoisted, %hoisted.cont
+  // %hoisted:
+  //   (non-null and range checks for p + (i + c) ... p + (n - 1 + c))
+  //   br %hoisted.cont
+  // %hoisted.cont:
+  //   br %for.cond
+  BasicBlock *HoistBlock = createBasicBlock("_Dynamic_check.hoisted");
+  BasicBlock *ContBlock = createBasicBlock("_Dynamic_check.hoisted.cont");
+  Builder.CreateCondBr(EvaluateExprAsBool(S.getCond()), HoistBlock, ContBlock);
+  EmitBlock(HoistBlock);
+
+  Value *First, *Last;
+  EmitIterationRange(*this, Loop, IV, IVType, First, Last);
+
+  SaveAndRestore<const char *> SavedOrigin(DynamicCheckOrigin, "hoisted");
+  for (const CheckedAccess &Access : Candidates) {
+    if (HoistedBoundsChecks.count(Access.E))
+      continue;
+    EmitMovedAccessCheck(*this, Access, First, Last);
+    ++NumDynamicChecksHoisted;
+    HoistedBoundsChecks.insert(Access.E);
+    Hoisted.push_back(Access.E);
+  }
+
+  EmitBranch(ContBlock);
+  EmitBlock(ContBlock);
+}
+
+llvm::BasicBlock *CodeGenFunction::EmitLoopVersionTest(
+    const ForStmt &S, SmallVectorImpl<const Expr *> &Unchecked) {
+  if (!getLangOpts().CheckedC)
+    return nullptr;
+
+  ComputeCheckedCAddressTakenVars();
+  ASTContext &Ctx = getContext();
+  HoistableLoop Loop;
+  const Expr *IV;
+  QualType IVType;
+  if (!MatchCountedLoop(Ctx, S, &CheckedCAddressTakenVars, Loop, IV, IVType))
+    return nullptr;
+
+  // Unlike hoisting, versioning does not need the accesses to be evaluated
+  // on every iteration: if the test fails, the checked loop is run instead,
+  // so a check that fails only for an iteration that does not evaluate the
+  // access never traps.  For the same reason, writes through null-terminated
+  // pointers can be tested strictly below the upper bound: a nul written
+  // at the upper bound is done by the checked loop.
+  SmallVector<CheckedAccess, 4> Candidates;
+  CollectMovableAccesses(Ctx, S.getBody(), Loop, Candidates,
+                         /*NullTermWrites=*/true);
+  KeepInductionVarAccesses(Loop, Candidates);
+  Candidates.erase(
+      std::remove_if(Candidates.begin(), Candidates.end(),
+                     [this](const CheckedAccess &A) {
+                       return HoistedBoundsChecks.count(A.E) != 0;
+                     }),
+      Candidates.end());
+  if (Candidates.empty())
+    return nullptr;
+
+  // Emits code as follows:
+  //
+  // %preheader:
+  //   ... (loop initialization)
+  //   %cond = (i < n)
+  //   br i1 %cond, %version_test, %checked_loop
+  // %version_test:
+  //   %ok = (p != null && p + (i + c) ... p + (n - 1 + c) in bounds) && ...
+  //   br i1 %ok, %unchecked_loop, %checked_loop
+  // %unchecked_loop:
+  //   (the loop, without the checks for these accesses)
+  // %checked_loop:
+  //   (the loop)
+  //
+  // The caller emits both loops.
+  BasicBlock *TestBlock = createBasicBlock("_Dynamic_check.version_test");
+  BasicBlock *UncheckedBlock = createBasicBlock("_Dynamic_check.unchecked_loop");
+  BasicBlock *CheckedBlock = createBasicBlock("_Dynamic_check.checked_loop");
+  Builder.CreateCondBr(EvaluateExprAsBool(S.getCond()), TestBlock,
+                       CheckedBlock);
+  EmitBlock(TestBlock);
+
+  Value *First, *Last;
+  EmitIterationRange(*this, Loop, IV, IVType, First, Last);
+
+  Value *InBounds = nullptr;
+  for (const CheckedAccess &Access : Candidates) {
+    Value *Condition = EmitMovedAccessCondition(*this, Access, First, Last);
+    InBounds = InBounds ? Builder.CreateAnd(InBounds, Condition) : Condition;
+    ++NumDynamicChecksVersioned;
+    HoistedBoundsChecks.insert(Access.E);
+    Unchecked.push_back(Access.E);
+  }
+  ++NumLoopsVersioned;
+
+  // The test stands for the range checks of all of the accesses.
+  SaveAndRestore<SourceLocation> SavedCheckLoc(DynamicCheckLoc,
+                                               S.getForLoc());
+  SaveAndRestore<const char *> SavedOrigin(DynamicCheckOrigin, "versioned");
+  TagDynamicCheck(Builder.CreateCondBr(InBounds, UncheckedBlock, CheckedBlock,
+                                       createProfileWeightsForDynamicCheck()),
+                  DCK_Range);
+  EmitBlock(UncheckedBlock);
+  return CheckedBlock;
+}
+
+unsigned CodeGenFunction::EmitCoalescedBoundsChecks(
+    ArrayRef<const Stmt *> Stmts, SmallVectorImpl<const Expr *> &Coalesced) {
+  // Find the leading statements that contain no control flow.
+  unsigned RunLength = 0;
+  while (RunLength != Stmts.size() &&
+         !HasConditionalControlFlow(Stmts[RunLength]))
+    ++RunLength;
+  Stmts = Stmts.slice(0, RunLength);
+
+  if (!getLangOpts().CheckedC || Stmts.empty() || !HaveInsertPoint())
+    return RunLength;
+
+  CheckRegion Region;
+  for (const Stmt *S : Stmts)
+    if (!CollectModifiedVars(S, Region.Modified))
+      return RunLength;
+  ComputeCheckedCAddressTakenVars();
+  Region.AddressTaken = &CheckedCAddressTakenVars;
+
+  // Accesses that are already checked, for example because the check was
+  // hoisted out of an enclosing loop, are ignored.
+  SmallVector<CheckedAccess, 8> Accesses;
+  for (const Stmt *S : Stmts)
+    CollectMovableAccesses(getContext(), S, Region, Accesses);
+  Accesses.erase(std::remove_if(Accesses.begin(), Accesses.end(),
+                                [this](const CheckedAccess &A) {
+                                  return HoistedBoundsChecks.count(A.E) != 0;
+                                }),
+                 Accesses.end());
+  if (Accesses.size() < 2)
+    return RunLength;
+
+  // Group the accesses that have the same base, index, bounds and kind of
+  // check.  Each group with more than one member gets a single check for the
+  // smallest and largest offsets.
+  Lexicographic Lex(getContext(), nullptr);
+  auto SameExpr = [&Lex](const Expr *E1, const Expr *E2) {
+    if (!E1 || !E2)
+      return E1 == E2;
+    return Lex.CompareExpr(E1, E2) == Lexicographic::Result::Equal;
+  };
+  auto SameGroup = [&](const CheckedAccess &A1, const CheckedAccess &A2) {
+    return A1.Kind == A2.Kind &&
+           getContext().hasSameType(A1.Base->getType(), A2.Base->getType()) &&
+           SameExpr(A1.Base, A2.Base) && SameExpr(A1.Index, A2.Index) &&
+           SameExpr(A1.Bounds->getLowerExpr(), A2.Bounds->getLowerExpr()) &&
+           SameExpr(A1.Bounds->getUpperExpr(), A2.Bounds->getUpperExpr());
+  };
+
+  SmallVector<bool, 8> Grouped(Accesses.size(), false);
+  SaveAndRestore<const char *> SavedOrigin(DynamicCheckOrigin, "coalesced");
+  for (unsigned I = 0, N = Accesses.size(); I != N; ++I) {
+    if (Grouped[I])
+      continue;
+    const CheckedAccess &Leader = Accesses[I];
+    if (Leader.Index && !IsRegionInvariant(Leader.Index, Region))
+      continue;
+
+    SmallVector<const CheckedAccess *, 4> Group;
+    Group.push_back(&Leader);
+    int64_t MinOffset = Leader.Offset, MaxOffset = Leader.Offset;
+    for (unsigned J = I + 1; J != N; ++J) {
+      if (Grouped[J] || !SameGroup(Leader, Accesses[J]))
+        continue;
+      Grouped[J] = true;
+      Group.push_back(&Accesses[J]);
+      MinOffset = std::min(MinOffset, Accesses[J].Offset);
+      MaxOffset = std::max(MaxOffset, Accesses[J].Offset);
+    }
+    if (Group.size() < 2)
+      continue;
+
+    Value *Index = llvm::ConstantInt::get(IntPtrTy, 0);
+    if (Leader.Index)
+      Index = Builder.CreateIntCast(
+          EmitScalarExpr(Leader.Index), IntPtrTy,
+          Leader.Index->getType()->isSignedIntegerOrEnumerationType());
+    CheckedAccess Widened = Leader;
+    Widened.Offset = 0;
+    EmitMovedAccessCheck(
+        *this, Widened,
+        Builder.CreateAdd(Index,
+                          llvm::ConstantInt::get(IntPtrTy, MinOffset, true)),
+        Builder.CreateAdd(Index,
+                          llvm::ConstantInt::get(IntPtrTy, MaxOffset, true)));
+
+    for (const CheckedAccess *Access : Group) {
+      if (HoistedBoundsChecks.insert(Access->E).second)
+        Coalesced.push_back(Access->E);
+    }
+    NumDynamicChecksCoalesced += Group.size() - 1;
+  }
+
+  return RunLength;
+}
+
+//
+// Combining the checks of dynamic bounds casts with the checks of the
+// accesses through their result (-fcheckedc-subsume-cast-checks)
+//
+// A dynamic bounds cast is usually stored in a local variable and used for
+// accesses right away:
+//
+//   _Array_ptr<char> q : count(4) = _Dynamic_bounds_cast<_Array_ptr<char>>(p, count(4));
+//   q[0] = q[1] + q[2];
+//
+// The cast check
+//
+//   q == null || (the cast bounds are within the bounds of p)
+//
+// and the non-null and range checks of the accesses through q in the next
+// statement are done with a single branch, right after q is set:
+//
+//   q != null && (the cast bounds are within the bounds of p) &&
+//   (each access is within the bounds of q)
+//
+// This fails in the same cases as the separate checks: if q is null, the
+// cast check succeeds and the first access fails its non-null check.  As
+// for coalescing, the checks of the accesses are moved before the code that
+// precedes them in the next statement, so that statement must be free of
+// control flow, and the bases, indices and bounds of the accesses must not
+// be modified by it.  The bounds of the cast are evaluated again after q is
+// set, so they must not be modified by the statement that sets q.
+//
+
+// If S declares or assigns a local checked pointer variable with a dynamic
+// bounds cast, return the variable and set Cast to the cast.
+static const VarDecl *GetBoundsCastTarget(const Stmt *S,
+                                          const BoundsCastExpr *&Cast) {
+  const VarDecl *V = nullptr;
+  const Expr *Init = nullptr;
+  if (const DeclStmt *DS = dyn_cast<DeclStmt>(S)) {
+    if (!DS->isSingleDecl())
+      return nullptr;
+    V = dyn_cast<VarDecl>(DS->getSingleDecl());
+    if (V)
+      Init = V->getInit();
+  } else if (const BinaryOperator *BO = dyn_cast<BinaryOperator>(S)) {
+    if (BO->getOpcode() == BO_Assign) {
+      V = GetVarDecl(BO->getLHS());
+      Init = BO->getRHS();
+    }
+  }
+  if (!V || !Init || !V->getType()->isCheckedPointerType())
+    return nullptr;
+
+  Cast = dyn_cast<BoundsCastExpr>(Init->IgnoreParenImpCasts());
+  if (!Cast || Cast->getCastKind() != CK_DynamicPtrBounds)
+    return nullptr;
+  return V;
+}
+
+// Collect the accesses through the _Ptr variable V in S, which only have a
+// non-null check.
+static void CollectPtrAccesses(const Stmt *S, const VarDecl *V,
+                               SmallVectorImpl<const Expr *> &Found) {
+  if (!S || isa<UnaryExprOrTypeTraitExpr>(S))
+    return;
+
+  const Expr *Base = nullptr;
+  if (const UnaryOperator *UO = dyn_cast<UnaryOperator>(S)) {
+    if (UO->getOpcode() == UO_Deref)
+      Base = UO->getSubExpr();
+  } else if (const MemberExpr *ME = dyn_cast<MemberExpr>(S)) {
+    if (ME->isArrow())
+      Base = ME->getBase();
+  }
+  if (Base && GetVarDecl(Base) == V)
+    Found.push_back(cast<Expr>(S));
+
+  for (const Stmt *SubStmt : S->children())
+    CollectPtrAccesses(SubStmt, V, Found);
+}
+
+bool CodeGenFunction::EmitSubsumedBoundsCastCheck(
+    const Stmt *S, const Stmt *Next, SmallVectorImpl<const Expr *> &Subsumed) {
+  if (!getLangOpts().CheckedC || !HaveInsertPoint())
+    return false;
+
+  const BoundsCastExpr *Cast = nullptr;
+  const VarDecl *V = GetBoundsCastTarget(S, Cast);
+  if (!V || HasConditionalControlFlow(S) || HasConditionalControlFlow(Next))
+    return false;
+
+  const RangeBoundsExpr *SubRange =
+    dyn_cast_or_null<RangeBoundsExpr>(Cast->getSubExprBoundsExpr());
+  const RangeBoundsExpr *CastRange =
+    dyn_cast_or_null<RangeBoundsExpr>(Cast->getNormalizedBoundsExpr());
+  if (!SubRange || !CastRange || SubRange->isInvalid() ||
+      CastRange->isInvalid())
+    return false;
+
+  ComputeCheckedCAddressTakenVars();
+  CheckRegion CastRegion;
+  CastRegion.AddressTaken = &CheckedCAddressTakenVars;
+  CheckRegion NextRegion;
+  NextRegion.AddressTaken = &CheckedCAddressTakenVars;
+  if (!IsTrackableVar(V, CastRegion) ||
+      !CollectModifiedVars(S, CastRegion.Modified) ||
+      !CollectModifiedVars(Next, NextRegion.Modified) ||
+      !IsRegionInvariant(SubRange->getLowerExpr(), CastRegion) ||
+      !IsRegionInvariant(SubRange->getUpperExpr(), CastRegion) ||
+      !IsRegionInvariant(CastRange->getLowerExpr(), CastRegion) ||
+      !IsRegionInvariant(CastRange->getUpperExpr(), CastRegion))
+    return false;
+
+  // Find the accesses through V in Next whose checks can be done after S.
+  // Accesses already checked before a run of statements are left alone.
+  SmallVector<CheckedAccess, 4> Accesses;
+  SmallVector<const Expr *, 4> PtrAccesses;
+  if (V->getType()->isCheckedPointerPtrType()) {
+    if (!NextRegion.Modified.count(V))
+      CollectPtrAccesses(Next, V, PtrAccesses);
+  } else {
+    CollectMovableAccesses(getContext(), Next, NextRegion, Accesses);
+    Accesses.erase(
+        std::remove_if(Accesses.begin(), Accesses.end(),
+                       [&](const CheckedAccess &A) {
+                         return GetVarDecl(A.Base) != V ||
+                                (A.Index &&
+                                 !IsRegionInvariant(A.Index, NextRegion));
+                       }),
+        Accesses.end());
+  }
+  auto IsChecked = [this](const Expr *E) {
+    return HoistedBoundsChecks.count(E) != 0;
+  };
+  Accesses.erase(std::remove_if(Accesses.begin(), Accesses.end(),
+                                [&](const CheckedAccess &A) {
+                                  return IsChecked(A.E);
+                                }),
+                 Accesses.end());
+  PtrAccesses.erase(
+      std::remove_if(PtrAccesses.begin(), PtrAccesses.end(), IsChecked),
+      PtrAccesses.end());
+  if (Accesses.empty() && PtrAccesses.empty())
+    return false;
+
+  // Emit S without the cast check, then the combined check.
+  HoistedBoundsChecks.insert(Cast);
+  EmitStmt(S);
+  HoistedBoundsChecks.erase(Cast);
+  if (!HaveInsertPoint())
+    return true;
+
+  SaveAndRestore<SourceLocation> SavedCheckLoc(DynamicCheckLoc,
+                                               Cast->getExprLoc());
+  ++NumDynamicChecksCast;
+  ++NumDynamicCastChecksSubsumed;
+
+  Value *Target = Builder.CreateLoad(GetAddrOfLocalVar(V),
+                                     "_Dynamic_check.cast_result");
+  Value *Condition =
+    Builder.CreateIsNotNull(Target, "_Dynamic_check.non_null");
+  Condition = Builder.CreateAnd(
+    Condition, EmitDynamicBoundsCastCondition(SubRange, CastRange));
+
+  for (const CheckedAccess &Access : Accesses) {
+    Value *Index = llvm::ConstantInt::get(IntPtrTy, 0);
+    if (Access.Index)
+      Index = Builder.CreateIntCast(
+          EmitScalarExpr(Access.Index), IntPtrTy,
+          Access.Index->getType()->isSignedIntegerOrEnumerationType());
+    Condition = Builder.CreateAnd(
+      Condition, EmitMovedAccessCondition(*this, Access, Index, Index));
+    HoistedBoundsChecks.insert(Access.E);
+    Subsumed.push_back(Access.E);
+  }
+  for (const Expr *E : PtrAccesses) {
+    HoistedBoundsChecks.insert(E);
+    Subsumed.push_back(E);
+  }
+  NumDynamicChecksSubsumedByCast += Accesses.size() + PtrAccesses.size();
+
+  SaveAndRestore<const char *> SavedOrigin(DynamicCheckOrigin, "combined");
+  EmitDynamicCheckBlocks(Condition, DCK_Cast);
+  return true;
+}
+
+void CodeGenFunction::EmitDynamicCheckBlocks(Value *Condition,
+                                             DynamicCheckKind Kind) {
   assert(Condition->getType()->isIntegerTy(1) &&
          "May only dynamic check boolean conditions");
 
@@ -327,31 +1606,306 @@ void CodeGenFunction::EmitDynamicCheckBlocks(Value *Condition) {
   }
 
   ++NumDynamicChecksInserted;
+  EmitDynamicCheckProfileCounter(Kind);
 
+  BasicBlock *Begin = Builder.GetInsertBlock();
   BasicBlock *DyCkSuccess = createBasicBlock("_Dynamic_check.succeeded");
-  BasicBlock *DyCkFail = EmitDynamicCheckFailedBlock();
+  BasicBlock *DyCkFail = EmitDynamicCheckFailedBlock(Kind);
 
-  Builder.CreateCondBr(Condition, DyCkSuccess, DyCkFail);
+  TagDynamicCheck(Builder.CreateCondBr(Condition, DyCkSuccess, DyCkFail,
+                                       createProfileWeightsForDynamicCheck()),
+                  Kind);
   // This ensures the success block comes directly after the branch
   EmitBlock(DyCkSuccess);
   Builder.SetInsertPoint(DyCkSuccess);
+  // The facts known in Begin still hold in its only normal successor.
+  if (KnownNonNullBlock == Begin)
+    KnownNonNullBlock = DyCkSuccess;
+}
+
+//
+// Tagging dynamic checks for the checkedc-checks remarks
+//
+
+// The kinds as named by -fcheckedc-check-profile.
+static const char *getDynamicCheckKindName(
+    CodeGenFunction::DynamicCheckKind Kind) {
+  switch (Kind) {
+    case CodeGenFunction::DCK_Explicit: return "explicit";
+    case CodeGenFunction::DCK_NonNull: return "non-null";
+    case CodeGenFunction::DCK_Range: return "range";
+    case CodeGenFunction::DCK_Cast: return "cast";
+    case CodeGenFunction::DCK_Overflow: return "overflow";
+    case CodeGenFunction::DCK_NumKinds: break;
+  }
+  llvm_unreachable("unexpected dynamic check kind");
 }
 
-BasicBlock *CodeGenFunction::EmitDynamicCheckFailedBlock() {
+void CodeGenFunction::TagDynamicCheck(Instruction *Check,
+                                      DynamicCheckKind Kind) {
+  if (!CGM.getCodeGenOpts().CheckedCCheckRemarks)
+    return;
+
+  // The remarks are reported at the checked expression rather than at the
+  // statement that the branch is attributed to.
+  llvm::DebugLoc Loc;
+  if (DynamicCheckLoc.isValid())
+    Loc = SourceLocToDebugLoc(DynamicCheckLoc);
+  if (!Loc)
+    Loc = Check->getDebugLoc();
+
+  LLVMContext &Ctx = getLLVMContext();
+  Metadata *Fields[] = {
+    MDString::get(Ctx, getDynamicCheckKindName(Kind)),
+    MDString::get(Ctx, DynamicCheckOrigin),
+    Loc.get(),
+    ValueAsMetadata::get(CurFn)
+  };
+  MDNode *Tag = MDNode::getDistinct(Ctx, Fields);
+  Check->setMetadata(CheckedCCheckMDName, Tag);
+  CGM.getModule().getOrInsertNamedMetadata(CheckedCChecksMDName)
+    ->addOperand(Tag);
+}
+
+//
+// Accesses that AddressSanitizer does not need to instrument
+// (-fcheckedc-asan-skip-checked-accesses)
+//
+
+void CodeGenFunction::MarkCheckedCInBounds(LValue &LV,
+                                           const BoundsExpr *Bounds) {
+  if (!CGM.getCodeGenOpts().CheckedCASanSkipCheckedAccesses)
+    return;
+  // Accesses without bounds are not checked by Checked C, and bounds(any)
+  // allow any access.
+  if (!Bounds || Bounds->isInvalid() || Bounds->isAny())
+    return;
+  LV.setCheckedCInBounds(true);
+}
+
+void CodeGenFunction::DisableAddressSanitizerForAccess(Instruction *Access) {
+  // The nosanitize metadata also keeps other sanitizers from instrumenting
+  // the access.  MemorySanitizer and ThreadSanitizer, which would lose more
+  // than a range check, cannot be used with AddressSanitizer.
+  if (!SanOpts.hasOneOf(SanitizerKind::Address | SanitizerKind::KernelAddress))
+    return;
+  CGM.getSanitizerMetadata()->disableSanitizerForInstruction(Access);
+  ++NumAddressSanitizerChecksSkipped;
+}
+
+//
+// Telling LLVM how far checked pointers can be dereferenced
+// (-fcheckedc-dereferenceable-bounds)
+//
+// A _Ptr<T> is null or points to a T, and a pointer with count(n) bounds is
+// null or points to n elements.  This is what dereferenceable_or_null says,
+// and it lets LLVM speculate loads through the pointer, for example out of
+// a loop.  Facts that only hold after a dynamic check are not passed on:
+// nonnull or dereferenceable metadata on the checked value would let LLVM
+// fold the check itself away.
+//
+
+uint64_t CodeGenFunction::getCheckedCDereferenceableBytes(
+    QualType Ty, const BoundsExpr *Bounds) {
+  if (!Ty->isCheckedPointerType())
+    return 0;
+  QualType PointeeTy = Ty->getPointeeType();
+  bool HasSize = !PointeeTy->isIncompleteType() &&
+                 !PointeeTy->isFunctionType() &&
+                 PointeeTy->isConstantSizeType();
+  uint64_t ElementSize =
+      HasSize ? getContext().getTypeSizeInChars(PointeeTy).getQuantity() : 0;
+  if (Ty->isCheckedPointerPtrType())
+    return ElementSize;
+
+  const CountBoundsExpr *CBE = dyn_cast_or_null<CountBoundsExpr>(Bounds);
+  if (!CBE || CBE->isInvalid())
+    return 0;
+  llvm::APSInt Count;
+  if (!CBE->getCountExpr()->EvaluateAsInt(Count, getContext()) ||
+      Count.isNegative() || Count.getActiveBits() > 32)
+    return 0;
+  if (CBE->isByteCount())
+    return Count.getZExtValue();
+  return ElementSize * Count.getZExtValue();
+}
+
+void CodeGenFunction::EmitCheckedCDereferenceableMetadata(llvm::LoadInst *Load,
+                                                          QualType Ty) {
+  if (!CGM.getCodeGenOpts().CheckedCDereferenceableBounds ||
+      !Ty->isCheckedPointerPtrType())
+    return;
+  uint64_t Bytes = getCheckedCDereferenceableBytes(Ty, nullptr);
+  if (!Bytes || getContext().getTargetAddressSpace(Ty->getPointeeType()) != 0)
+    return;
+  llvm::Metadata *Size =
+      llvm::ConstantAsMetadata::get(Builder.getInt64(Bytes));
+  Load->setMetadata(llvm::LLVMContext::MD_dereferenceable_or_null,
+                    llvm::MDNode::get(getLLVMContext(), Size));
+  ++NumDereferenceableLoads;
+}
+
+void CodeGenFunction::AddCheckedCDereferenceableAttr(llvm::Argument *Arg,
+                                                     const ParmVarDecl *PVD) {
+  if (!CGM.getCodeGenOpts().CheckedCDereferenceableBounds)
+    return;
+  QualType Ty = PVD->getType();
+  uint64_t Bytes = getCheckedCDereferenceableBytes(Ty, PVD->getBoundsExpr());
+  if (!Bytes || getContext().getTargetAddressSpace(Ty->getPointeeType()) != 0)
+    return;
+  Arg->addAttrs(llvm::AttrBuilder().addDereferenceableOrNullAttr(Bytes));
+  ++NumDereferenceableParams;
+}
+
+//
+// Counting the executions of dynamic checks (-fcheckedc-check-profile)
+//
+
+void CodeGenFunction::EmitDynamicCheckProfileCounter(DynamicCheckKind Kind) {
+  if (!CGM.getCodeGenOpts().CheckedCCheckProfile)
+    return;
+
+  Address Counter(CGM.getCheckedCCheckCounter(DynamicCheckLoc, Kind),
+                  CharUnits::fromQuantity(8));
+  Value *Count = Builder.CreateLoad(Counter, "_Dynamic_check.count");
+  Builder.CreateStore(Builder.CreateAdd(Count, Builder.getInt64(1)), Counter);
+}
+
+/// The type of a record in the check profile table.  It must match
+/// struct __checkedc_check_profile_record in
+/// runtime/checkedc/CheckProfile.c.
+static llvm::StructType *getCheckProfileRecordType(CodeGenModule &CGM) {
+  return llvm::StructType::get(CGM.Int8PtrTy, CGM.Int32Ty, CGM.Int32Ty,
+                               CGM.Int32Ty, CGM.Int64Ty->getPointerTo());
+}
+
+llvm::GlobalVariable *
+CodeGenModule::getCheckedCCheckCounter(SourceLocation Loc, unsigned Kind) {
+  SourceManager &SM = getContext().getSourceManager();
+  if (Loc.isValid())
+    Loc = SM.getExpansionLoc(Loc);
+  llvm::GlobalVariable *&Counter =
+    CheckedCCheckCounters[std::make_pair(Loc.getRawEncoding(), Kind)];
+  if (Counter)
+    return Counter;
+
+  Counter = new llvm::GlobalVariable(getModule(), Int64Ty, false,
+                                     llvm::GlobalValue::PrivateLinkage,
+                                     llvm::ConstantInt::get(Int64Ty, 0),
+                                     "__checkedc_check_counter");
+  Counter->setAlignment(8);
+
+  std::string FileName = "<unknown>";
+  unsigned Line = 0, Column = 0;
+  PresumedLoc PLoc = SM.getPresumedLoc(Loc);
+  if (PLoc.isValid()) {
+    FileName = PLoc.getFilename();
+    Line = PLoc.getLine();
+    Column = PLoc.getColumn();
+  }
+  llvm::Constant *Fields[] = {
+    GetAddrOfConstantCString(FileName).getPointer(),
+    llvm::ConstantInt::get(Int32Ty, Line),
+    llvm::ConstantInt::get(Int32Ty, Column),
+    llvm::ConstantInt::get(Int32Ty, Kind),
+    Counter
+  };
+  CheckedCCheckProfileRecords.push_back(
+    llvm::ConstantStruct::get(getCheckProfileRecordType(*this), Fields));
+  return Counter;
+}
+
+void CodeGenModule::EmitCheckedCCheckProfile() {
+  if (CheckedCCheckProfileRecords.empty())
+    return;
+
+  llvm::StructType *RecordTy = getCheckProfileRecordType(*this);
+  llvm::ArrayType *TableTy =
+    llvm::ArrayType::get(RecordTy, CheckedCCheckProfileRecords.size());
+  auto *Table = new llvm::GlobalVariable(
+      getModule(), TableTy, true, llvm::GlobalValue::PrivateLinkage,
+      llvm::ConstantArray::get(TableTy, CheckedCCheckProfileRecords),
+      "__checkedc_check_profile_records");
+
+  // void __checkedc_check_profile_register(
+  //     struct __checkedc_check_profile_record *Records, unsigned Count);
+  llvm::Type *Args[] = { RecordTy->getPointerTo(), Int32Ty };
+  llvm::Constant *RegisterFn = CreateRuntimeFunction(
+      llvm::FunctionType::get(VoidTy, Args, false),
+      "__checkedc_check_profile_register");
+
+  llvm::Function *Init = llvm::Function::Create(
+      llvm::FunctionType::get(VoidTy, false),
+      llvm::GlobalValue::InternalLinkage, "__checkedc_check_profile_init",
+      &getModule());
+  Init->setDoesNotThrow();
+  CGBuilderTy Builder(*this,
+                      llvm::BasicBlock::Create(VMContext, "entry", Init));
+  llvm::Constant *Zeros[] = { Builder.getInt32(0), Builder.getInt32(0) };
+  llvm::Value *CallArgs[] = {
+    llvm::ConstantExpr::getInBoundsGetElementPtr(TableTy, Table, Zeros),
+    llvm::ConstantInt::get(Int32Ty, CheckedCCheckProfileRecords.size())
+  };
+  Builder.CreateCall(RegisterFn, CallArgs);
+  Builder.CreateRetVoid();
+  AddGlobalCtor(Init);
+}
+
+static const char *getDynamicCheckFailedBlockName(
+    CodeGenFunction::DynamicCheckKind Kind) {
+  switch (Kind) {
+    case CodeGenFunction::DCK_Explicit: return "_Dynamic_check.failed.explicit";
+    case CodeGenFunction::DCK_NonNull: return "_Dynamic_check.failed.nonnull";
+    case CodeGenFunction::DCK_Range: return "_Dynamic_check.failed.range";
+    case CodeGenFunction::DCK_Cast: return "_Dynamic_check.failed.cast";
+    case CodeGenFunction::DCK_Overflow: return "_Dynamic_check.failed.overflow";
+    case CodeGenFunction::DCK_NumKinds: break;
+  }
+  llvm_unreachable("unexpected dynamic check kind");
+}
+
+BasicBlock *CodeGenFunction::EmitDynamicCheckFailedBlock(DynamicCheckKind Kind) {
+  // Look for a failure block that can be shared.  Blocks are never shared
+  // within funclets, because a funclet may not branch to a block outside of
+  // it.
+  CodeGenOptions::CheckedCTrapBlockKind Sharing =
+    CGM.getCodeGenOpts().getCheckedCTrapBlocks();
+  BasicBlock **SharedBlock = nullptr;
+  if (Sharing != CodeGenOptions::CheckedCTrapPerCheck && !CurrentFuncletPad) {
+    if (Sharing == CodeGenOptions::CheckedCTrapPerFunction)
+      Kind = DCK_Explicit;
+    SharedBlock = &DynamicCheckFailedBlocks[Kind];
+    if (*SharedBlock) {
+      ++NumDynamicCheckFailedBlocksShared;
+      return *SharedBlock;
+    }
+  }
+
+  ++NumDynamicCheckFailedBlocks;
+
   // Save current insert point
   BasicBlock *Begin = Builder.GetInsertBlock();
 
   // Add a "failed block", which will be inserted at the end of CurFn
-  BasicBlock *FailBlock = createBasicBlock("_Dynamic_check.failed", CurFn);
+  const char *Name = "_Dynamic_check.failed";
+  if (Sharing == CodeGenOptions::CheckedCTrapPerKind)
+    Name = getDynamicCheckFailedBlockName(Kind);
+  BasicBlock *FailBlock = createBasicBlock(Name, CurFn);
   Builder.SetInsertPoint(FailBlock);
   CallInst *TrapCall = Builder.CreateCall(CGM.getIntrinsic(Intrinsic::trap));
   TrapCall->setDoesNotReturn();
   TrapCall->setDoesNotThrow();
+  // Keep the failure path out of the way of the hot code.
+  TrapCall->addAttribute(llvm::AttributeList::FunctionIndex,
+                         llvm::Attribute::Cold);
   Builder.CreateUnreachable();
 
   // Return the insert point back to the saved insert point
   Builder.SetInsertPoint(Begin);
 
+  if (SharedBlock)
+    *SharedBlock = FailBlock;
+
   return FailBlock;
 }
 
@@ -369,11 +1923,12 @@ BasicBlock *CodeGenFunction::EmitNulltermWriteAdditionalCheck(
   Builder.SetInsertPoint(FailBlock);
   Value *AtUpper = Builder.CreateICmpEQ(PtrAddr.getPointer(), Upper.getPointer(),
                                         "_Dynamic_check.at_upper");
-  BasicBlock *OnFailure = EmitDynamicCheckFailedBlock();
+  BasicBlock *OnFailure = EmitDynamicCheckFailedBlock(DCK_Range);
   llvm::Value *Condition1 = Builder.CreateAnd(LowerChk, AtUpper, "_Dynamic_check.nt_upper_bound");
   Value *IsZero = Builder.CreateIsNull(Val, "_Dynamic_check.write_nul");
   llvm::Value *Condition2 = Builder.CreateAnd(Condition1, IsZero, "_Dynamic_check.allowed_write");
-  Builder.CreateCondBr(Condition2, Succeeded, OnFailure);
+  Builder.CreateCondBr(Condition2, Succeeded, OnFailure,
+                       createProfileWeightsForDynamicCheck());
   // Return the insert point back to the saved insert point
   Builder.SetInsertPoint(Begin);
 
@@ -382,17 +1937,20 @@ BasicBlock *CodeGenFunction::EmitNulltermWriteAdditionalCheck(
 
 BoundsExpr *CodeGenFunction::GetNullTermBoundsCheck(Expr *E) {
   E = E->IgnoreParenCasts();
+  // The check may already have been done before an enclosing loop.
+  if (HoistedBoundsChecks.count(E))
+    return nullptr;
   switch (E->getStmtClass()) {
     case Expr::UnaryOperatorClass: {
       UnaryOperator *UO = cast<UnaryOperator>(E);
       if (UO->getBoundsCheckKind() == BoundsCheckKind::BCK_NullTermWriteAssign)
-        return UO->getBoundsExpr();
+        return UO->getBoundsExpr(getContext());
       break;
     }
     case Expr::ArraySubscriptExprClass: {
       ArraySubscriptExpr *AS = cast<ArraySubscriptExpr>(E);
       if (AS->getBoundsCheckKind() == BoundsCheckKind::BCK_NullTermWriteAssign)
-        return AS->getBoundsExpr();
+        return AS->getBoundsExpr(getContext());
       break;
     }
     default:
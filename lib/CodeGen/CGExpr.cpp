@@ -36,6 +36,7 @@
 #include "llvm/Support/ConvertUTF.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Transforms/Utils/SanitizerStats.h"
 
 #include <string>
@@ -1123,6 +1124,8 @@ LValue CodeGenFunction::EmitCheckedLValue(const Expr *E, TypeCheckKind TCK) {
 ///
 LValue CodeGenFunction::EmitLValue(const Expr *E) {
   ApplyDebugLocation DL(*this, E);
+  llvm::SaveAndRestore<SourceLocation> SavedCheckLoc(DynamicCheckLoc,
+                                                     E->getExprLoc());
   switch (E->getStmtClass()) {
   default: return EmitUnsupportedLValue(E, "l-value expression");
 
@@ -1388,7 +1391,8 @@ llvm::Value *CodeGenFunction::EmitLoadOfScalar(LValue lvalue,
                                                SourceLocation Loc) {
   return EmitLoadOfScalar(lvalue.getAddress(), lvalue.isVolatile(),
                           lvalue.getType(), Loc, lvalue.getBaseInfo(),
-                          lvalue.getTBAAInfo(), lvalue.isNontemporal());
+                          lvalue.getTBAAInfo(), lvalue.isNontemporal(),
+                          lvalue.isCheckedCInBounds());
 }
 
 static bool hasBooleanRepresentation(QualType Ty) {
@@ -1499,7 +1503,8 @@ llvm::Value *CodeGenFunction::EmitLoadOfScalar(Address Addr, bool Volatile,
                                                SourceLocation Loc,
                                                LValueBaseInfo BaseInfo,
                                                TBAAAccessInfo TBAAInfo,
-                                               bool isNontemporal) {
+                                               bool isNontemporal,
+                                               bool isCheckedCInBounds) {
   if (!CGM.getCodeGenOpts().PreserveVec3Type) {
     // For better performance, handle vector loads differently.
     if (Ty->isVectorType()) {
@@ -1538,6 +1543,9 @@ llvm::Value *CodeGenFunction::EmitLoadOfScalar(Address Addr, bool Volatile,
         Load->getContext(), llvm::ConstantAsMetadata::get(Builder.getInt32(1)));
     Load->setMetadata(CGM.getModule().getMDKindID("nontemporal"), Node);
   }
+  if (isCheckedCInBounds)
+    DisableAddressSanitizerForAccess(Load);
+  EmitCheckedCDereferenceableMetadata(Load, Ty);
 
   CGM.DecorateInstructionWithTBAA(Load, TBAAInfo);
 
@@ -1580,7 +1588,8 @@ void CodeGenFunction::EmitStoreOfScalar(llvm::Value *Value, Address Addr,
                                         bool Volatile, QualType Ty,
                                         LValueBaseInfo BaseInfo,
                                         TBAAAccessInfo TBAAInfo,
-                                        bool isInit, bool isNontemporal) {
+                                        bool isInit, bool isNontemporal,
+                                        bool isCheckedCInBounds) {
   if (!CGM.getCodeGenOpts().PreserveVec3Type) {
     // Handle vectors differently to get better performance.
     if (Ty->isVectorType()) {
@@ -1620,6 +1629,8 @@ void CodeGenFunction::EmitStoreOfScalar(llvm::Value *Value, Address Addr,
                           llvm::ConstantAsMetadata::get(Builder.getInt32(1)));
     Store->setMetadata(CGM.getModule().getMDKindID("nontemporal"), Node);
   }
+  if (isCheckedCInBounds)
+    DisableAddressSanitizerForAccess(Store);
 
   CGM.DecorateInstructionWithTBAA(Store, TBAAInfo);
 }
@@ -1628,7 +1639,8 @@ void CodeGenFunction::EmitStoreOfScalar(llvm::Value *value, LValue lvalue,
                                         bool isInit) {
   EmitStoreOfScalar(value, lvalue.getAddress(), lvalue.isVolatile(),
                     lvalue.getType(), lvalue.getBaseInfo(),
-                    lvalue.getTBAAInfo(), isInit, lvalue.isNontemporal());
+                    lvalue.getTBAAInfo(), isInit, lvalue.isNontemporal(),
+                    lvalue.isCheckedCInBounds());
 }
 
 /// EmitLoadOfLValue - Given an expression that represents a value lvalue, this
@@ -2461,6 +2473,15 @@ LValue CodeGenFunction::EmitUnaryOpLValue(const UnaryOperator *E) {
     QualType T = BaseTy->getPointeeType();
     assert(!T.isNull() && "CodeGenFunction::EmitUnaryOpLValue: Illegal type");
 
+    SharedBoundsScope SharedBases(*this, E->getBoundsExpr(getContext()),
+                                  E->getBoundsCheckKind() != BCK_None &&
+                                    !HoistedBoundsChecks.count(E));
+    // The overflow check of *(p + i) is combined with its bounds check.
+    llvm::SaveAndRestore<const Expr *> DeferredOverflowCheck(
+        DeferredOverflowCheckExpr,
+        E->getBoundsCheckKind() != BCK_None && !HoistedBoundsChecks.count(E)
+            ? E->getSubExpr()->IgnoreParens()
+            : nullptr);
     LValueBaseInfo BaseInfo;
     TBAAAccessInfo TBAAInfo;
     Address Addr = EmitPointerWithAlignment(E->getSubExpr(), &BaseInfo,
@@ -2468,9 +2489,13 @@ LValue CodeGenFunction::EmitUnaryOpLValue(const UnaryOperator *E) {
     LValue LV = MakeAddrLValue(Addr, T, BaseInfo, TBAAInfo);
     LV.getQuals().setAddressSpace(ExprTy.getAddressSpace());
 
-    EmitDynamicNonNullCheck(Addr, BaseTy);
-    EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(), E->getBoundsCheckKind(),
-                           nullptr);
+    if (!HoistedBoundsChecks.count(E)) {
+      EmitDynamicNonNullCheck(Addr, BaseTy);
+      EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(getContext()),
+                             E->getBoundsCheckKind(), nullptr);
+    }
+    EmitPendingOverflowCheck();
+    MarkCheckedCInBounds(LV, E->getBoundsExpr(getContext()));
     // We should not generate __weak write barrier on indirect reference
     // of a pointer to object; as in void foo (__weak id *param); *param = 0;
     // But, we continue to generate __strong write barrier on indirect write
@@ -3188,6 +3213,9 @@ static Address emitArraySubscriptGEP(CodeGenFunction &CGF, Address addr,
 
 LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
                                                bool Accessed) {
+  SharedBoundsScope SharedBases(*this, E->getBoundsExpr(getContext()),
+                                E->getBoundsCheckKind() != BCK_None &&
+                                  !HoistedBoundsChecks.count(E));
   // The index must always be an integer, which is not an aggregate.  Emit it
   // in lexical order (this complexity is, sadly, required by C++17).
   llvm::Value *IdxPre =
@@ -3216,6 +3244,8 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
   IdxPre = nullptr;
 
   QualType BaseTy = E->getBase()->getType();
+  // The index as an intptr_t, for the Checked C bounds check.
+  llvm::Value *CheckedIdx = nullptr;
 
   // If the base is a vector type, then we are forming a vector element lvalue
   // with this subscript.
@@ -3230,7 +3260,7 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
     LValue LV = LValue::MakeVectorElt(LHS.getAddress(), Idx,
       E->getBase()->getType(), LHS.getBaseInfo(), TBAAAccessInfo());
 
-    EmitDynamicBoundsCheck(LV.getVectorAddress(), E->getBoundsExpr(),
+    EmitDynamicBoundsCheck(LV.getVectorAddress(), E->getBoundsExpr(getContext()),
                             E->getBoundsCheckKind(), nullptr);
 
     return LV;
@@ -3250,8 +3280,8 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
                                  SignedIndices, E->getExprLoc());
     LValue AddrLV = MakeAddrLValue(Addr, EltType, LV.getBaseInfo(),
                                    CGM.getTBAAInfoForSubobject(LV, EltType));
-    EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(), E->getBoundsCheckKind(),
-      nullptr);
+    EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(getContext()),
+                           E->getBoundsCheckKind(), nullptr);
 
     return AddrLV;
   }
@@ -3331,8 +3361,10 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
     else
       ArrayLV = EmitLValue(Array);
     auto *Idx = EmitIdxAfterBase(/*Promote*/true);
+    CheckedIdx = Idx;
 
-    EmitDynamicNonNullCheck(ArrayLV.getAddress(), BaseTy);
+    if (!HoistedBoundsChecks.count(E))
+      EmitDynamicNonNullCheck(ArrayLV.getAddress(), BaseTy);
 
     // Propagate the alignment from the array itself to the result.
     Addr = emitArraySubscriptGEP(
@@ -3345,7 +3377,9 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
     // The base must be a pointer; emit it with an estimate of its alignment.
     Addr = EmitPointerWithAlignment(E->getBase(), &EltBaseInfo, &EltTBAAInfo);
     auto *Idx = EmitIdxAfterBase(/*Promote*/true);
-    EmitDynamicNonNullCheck(Addr, BaseTy);
+    CheckedIdx = Idx;
+    if (!HoistedBoundsChecks.count(E))
+      EmitDynamicNonNullCheck(Addr, BaseTy);
     Addr = emitArraySubscriptGEP(*this, Addr, Idx, E->getType(),
                                  !getLangOpts().isSignedOverflowDefined(),
                                  SignedIndices, E->getExprLoc());
@@ -3353,8 +3387,14 @@ LValue CodeGenFunction::EmitArraySubscriptExpr(const ArraySubscriptExpr *E,
 
   LValue LV = MakeAddrLValue(Addr, E->getType(), EltBaseInfo, EltTBAAInfo);
 
-  EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(), E->getBoundsCheckKind(),
-                         nullptr);
+  // The check may already have been done in the preheader of an enclosing
+  // loop.  With count bounds of the base, it may be done on the index.
+  if (!HoistedBoundsChecks.count(E) &&
+      !(CheckedIdx && CGM.getCodeGenOpts().CheckedCIndexBoundsChecks &&
+        EmitDynamicIndexBoundsCheck(E, CheckedIdx)))
+    EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(getContext()),
+                           E->getBoundsCheckKind(), nullptr);
+  MarkCheckedCInBounds(LV, E->getBoundsExpr(getContext()));
 
   if (getLangOpts().ObjC1 &&
       getLangOpts().getGC() != LangOptions::NonGC) {
@@ -3625,9 +3665,32 @@ LValue CodeGenFunction::EmitMemberExpr(const MemberExpr *E) {
   // If this is s.x, emit s as an lvalue.  If it is s->x, emit s as a scalar.
   LValue BaseLV;
   if (E->isArrow()) {
+    SharedBoundsScope SharedBases(*this, E->getBoundsExpr(getContext()),
+                                  !E->isBoundsCheckProven() &&
+                                    !HoistedBoundsChecks.count(E));
     LValueBaseInfo BaseInfo;
     TBAAAccessInfo TBAAInfo;
-    Address Addr = EmitPointerWithAlignment(BaseExpr, &BaseInfo, &TBAAInfo);
+    Address Addr = Address::invalid();
+    // The base of a member used in the bounds of a memory access is the
+    // base of a member of the access, which was already emitted.
+    const SharedBoundsValues::ArrowBase *Shared = nullptr;
+    if (SharedBounds) {
+      auto It = SharedBounds->ArrowBases.find(BaseExpr);
+      if (It != SharedBounds->ArrowBases.end())
+        Shared = &It->second;
+    }
+    if (Shared) {
+      Addr = Shared->Addr;
+      BaseInfo = Shared->BaseInfo;
+      TBAAInfo = Shared->TBAAInfo;
+    } else {
+      Addr = EmitPointerWithAlignment(BaseExpr, &BaseInfo, &TBAAInfo);
+      if (SharedBounds && !isInConditionalBranch() &&
+          !BaseExpr->IgnoreParenImpCasts()->getType().isVolatileQualified())
+        SharedBounds->ArrowBases.insert(
+          std::make_pair(BaseExpr, SharedBoundsValues::ArrowBase{
+                                     Addr, BaseInfo, TBAAInfo}));
+    }
     QualType BaseTy = BaseExpr->getType();
     QualType PtrTy = BaseExpr->getType()->getPointeeType();
     SanitizerSet SkippedChecks;
@@ -3641,20 +3704,27 @@ LValue CodeGenFunction::EmitMemberExpr(const MemberExpr *E) {
 
     BaseLV = MakeAddrLValue(Addr, PtrTy, BaseInfo, TBAAInfo);
 
-    EmitDynamicNonNullCheck(Addr, BaseTy);
     // We only check the Base LValue, as we assume that any field is definitely
     // within the size of the struct. This may not be the case with a "flexible
     // array member" (6.7.2.1.18), but this member is an array, so is either
     // unchecked, or is a checked array with its own bounds.
     // A second reason for always checking the BaseLV is that it is the same for
     // all the fields in the struct, so more of the checks should optimize away.
-    EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(), BCK_Normal, nullptr);
+    if (!HoistedBoundsChecks.count(E)) {
+      EmitDynamicNonNullCheck(Addr, BaseTy);
+      EmitDynamicBoundsCheck(Addr, E->getBoundsExpr(getContext()),
+                             E->isBoundsCheckProven() ? BCK_None : BCK_Normal,
+                             nullptr);
+    }
+    MarkCheckedCInBounds(BaseLV, E->getBoundsExpr(getContext()));
   } else
     BaseLV = EmitCheckedLValue(BaseExpr, TCK_MemberAccess);
 
   NamedDecl *ND = E->getMemberDecl();
   if (auto *Field = dyn_cast<FieldDecl>(ND)) {
     LValue LV = EmitLValueForField(BaseLV, Field);
+    // A member is within the struct that contains it.
+    LV.setCheckedCInBounds(BaseLV.isCheckedCInBounds());
     setObjCGCLValueClass(getContext(), E, LV);
     return LV;
   }
@@ -3783,7 +3853,7 @@ LValue CodeGenFunction::EmitLValueForField(LValue base,
           Layout.getFieldOffset(field->getFieldIndex()) / CharWidth;
 
     // Update the final access type.
-    FieldTBAAInfo.AccessType = CGM.getTBAATypeInfo(FieldType);
+    FieldTBAAInfo.AccessType = CGM.getTBAAFieldTypeInfo(field);
   }
 
   Address addr = base.getAddress();
@@ -4790,8 +4860,10 @@ llvm::Value *CodeGenFunction::EmitBoundsCast(CastExpr *CE) {
     CharUnits Align = getContext().getTypeAlignInChars(DestTy);
     Addr = Address(Result, Align);
   }
-  if (Kind == CK_DynamicPtrBounds) {
+  if (Kind == CK_DynamicPtrBounds && !HoistedBoundsChecks.count(CE)) {
     BoundsCastExpr *BCE = cast<BoundsCastExpr>(CE);
+    llvm::SaveAndRestore<SourceLocation> SavedCheckLoc(DynamicCheckLoc,
+                                                       CE->getExprLoc());
     EmitDynamicBoundsCastCheck(Addr,
                                BCE->getNormalizedBoundsExpr(),
                                BCE->getSubExprBoundsExpr());
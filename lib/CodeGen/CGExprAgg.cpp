@@ -14,6 +14,7 @@
 #include "CodeGenFunction.h"
 #include "CGObjCRuntime.h"
 #include "CodeGenModule.h"
+#include "ConstantEmitter.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclTemplate.h"
@@ -1131,20 +1132,6 @@ void AggExprEmitter::EmitNullInitializationToLValue(LValue lv) {
 }
 
 void AggExprEmitter::VisitInitListExpr(InitListExpr *E) {
-#if 0
-  // FIXME: Assess perf here?  Figure out what cases are worth optimizing here
-  // (Length of globals? Chunks of zeroed-out space?).
-  //
-  // If we can, prefer a copy from a global; this is a lot less code for long
-  // globals, and it's easier for the current optimizers to analyze.
-  if (llvm::Constant* C = CGF.CGM.EmitConstantExpr(E, E->getType(), &CGF)) {
-    llvm::GlobalVariable* GV =
-    new llvm::GlobalVariable(CGF.CGM.getModule(), C->getType(), true,
-                             llvm::GlobalValue::InternalLinkage, C, "");
-    EmitFinalDestCopy(E->getType(), CGF.MakeAddrLValue(GV, E->getType()));
-    return;
-  }
-#endif
   if (E->hadArrayRangeDesignator())
     CGF.ErrorUnsupported(E, "GNU array range designator extension");
 
@@ -1153,6 +1140,24 @@ void AggExprEmitter::VisitInitListExpr(InitListExpr *E) {
 
   AggValueSlot Dest = EnsureSlot(E->getType());
 
+  // A large initializer made only of constants is cheaper to emit as a copy
+  // of a constant global, or as a memset and a few stores, than as a store to
+  // each element. Initializers that are mostly zero have already been given a
+  // memset by EmitAggExpr, which leaves only their nonzero parts to store.
+  CharUnits Size = CGF.getContext().getTypeSizeInChars(E->getType());
+  if (!Dest.isZeroed() && !Dest.requiresGCollection() &&
+      Size > CharUnits::fromQuantity(16) &&
+      E->getType().isPODType(CGF.getContext()) &&
+      E->isConstantInitializer(CGF.getContext(), false)) {
+    ConstantEmitter Emitter(CGF);
+    if (llvm::Constant *C =
+            Emitter.tryEmitAbstractForMemory(E, E->getType())) {
+      CGF.EmitConstantAggregateInit(Dest.getAddress(), Size, C,
+                                    Dest.isVolatile());
+      return;
+    }
+  }
+
   LValue DestLV = CGF.MakeAddrLValue(Dest.getAddress(), E->getType());
 
   // Handle initialization of an array.
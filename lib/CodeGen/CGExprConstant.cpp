@@ -1801,6 +1801,76 @@ ConstantLValueEmitter::VisitMaterializeTemporaryExpr(
   return CGM.GetAddrOfGlobalTemporary(E, Inner);
 }
 
+/// Collect the bits of the elements of \p Value, an array of integers or
+/// floating-point values whose elements all have the size of \p T.
+template <typename T>
+static std::vector<T> getDataArrayElements(const APValue &Value) {
+  auto GetBits = [](const APValue &Elt) -> T {
+    if (Elt.isInt())
+      return T(Elt.getInt().getZExtValue());
+    return T(Elt.getFloat().bitcastToAPInt().getZExtValue());
+  };
+  std::vector<T> Elts(Value.getArraySize(),
+                      Value.hasArrayFiller() ? GetBits(Value.getArrayFiller())
+                                             : T(0));
+  for (unsigned I = 0, E = Value.getArrayInitializedElts(); I != E; ++I)
+    Elts[I] = GetBits(Value.getArrayInitializedElt(I));
+  return Elts;
+}
+
+/// Try to emit \p Value, an array of elements of type \p ElemTy, straight
+/// into a ConstantDataArray. This is the constant that emitting each element
+/// on its own and building a ConstantArray from them produces, but it does
+/// not create and unique a constant for each element of large tables.
+static llvm::Constant *tryEmitDataArray(CodeGenModule &CGM,
+                                        const APValue &Value,
+                                        llvm::Type *ElemTy) {
+  if (!Value.hasArrayFiller() &&
+      Value.getArrayInitializedElts() != Value.getArraySize())
+    return nullptr;
+
+  bool IsFP = ElemTy->isFloatTy() || ElemTy->isDoubleTy();
+  if (!IsFP && !(ElemTy->isIntegerTy() &&
+                 llvm::ConstantDataSequential::isElementTypeCompatible(ElemTy)))
+    return nullptr;
+
+  unsigned Bits = ElemTy->getPrimitiveSizeInBits();
+  const llvm::fltSemantics &Semantics = ElemTy->isFloatTy()
+                                            ? llvm::APFloat::IEEEsingle()
+                                            : llvm::APFloat::IEEEdouble();
+  auto IsDataElement = [&](const APValue &Elt) {
+    if (IsFP)
+      return Elt.isFloat() && &Elt.getFloat().getSemantics() == &Semantics;
+    return Elt.isInt() && Elt.getInt().getBitWidth() == Bits;
+  };
+  if (Value.hasArrayFiller() && !IsDataElement(Value.getArrayFiller()))
+    return nullptr;
+  for (unsigned I = 0, E = Value.getArrayInitializedElts(); I != E; ++I)
+    if (!IsDataElement(Value.getArrayInitializedElt(I)))
+      return nullptr;
+
+  llvm::LLVMContext &Ctx = CGM.getLLVMContext();
+  switch (Bits) {
+  case 8:
+    return llvm::ConstantDataArray::get(Ctx,
+                                        getDataArrayElements<uint8_t>(Value));
+  case 16:
+    return llvm::ConstantDataArray::get(Ctx,
+                                        getDataArrayElements<uint16_t>(Value));
+  case 32: {
+    std::vector<uint32_t> Elts = getDataArrayElements<uint32_t>(Value);
+    return IsFP ? llvm::ConstantDataArray::getFP(Ctx, Elts)
+                : llvm::ConstantDataArray::get(Ctx, Elts);
+  }
+  case 64: {
+    std::vector<uint64_t> Elts = getDataArrayElements<uint64_t>(Value);
+    return IsFP ? llvm::ConstantDataArray::getFP(Ctx, Elts)
+                : llvm::ConstantDataArray::get(Ctx, Elts);
+  }
+  }
+  return nullptr;
+}
+
 llvm::Constant *ConstantEmitter::tryEmitPrivate(const APValue &Value,
                                                 QualType DestType) {
   switch (Value.getKind()) {
@@ -1904,6 +1974,10 @@ llvm::Constant *ConstantEmitter::tryEmitPrivate(const APValue &Value,
       return llvm::ConstantAggregateZero::get(AType);
     }
 
+    if (!CAT->getElementType()->isAtomicType())
+      if (llvm::Constant *C = tryEmitDataArray(CGM, Value, CommonElementType))
+        return C;
+
     SmallVector<llvm::Constant*, 16> Elts;
     Elts.reserve(NumElements);
     for (unsigned I = 0; I < NumElements; ++I) {
@@ -1347,7 +1347,18 @@ Value *ScalarExprEmitter::VisitMemberExpr(MemberExpr *E) {
     }
   }
 
-  return EmitLoadOfLValue(E);
+  // A member used in the bounds of a Checked C memory access may be a
+  // member of the access, which was already loaded.
+  CodeGenFunction::SharedBoundsValues *Shared = CGF.SharedBounds;
+  if (!Shared || E->getType().isVolatileQualified())
+    return EmitLoadOfLValue(E);
+  auto It = Shared->MemberValues.find(E);
+  if (It != Shared->MemberValues.end())
+    return It->second;
+  Value *V = EmitLoadOfLValue(E);
+  if (!CGF.isInConditionalBranch())
+    Shared->MemberValues[E] = V;
+  return V;
 }
 
 Value *ScalarExprEmitter::VisitArraySubscriptExpr(ArraySubscriptExpr *E) {
@@ -2800,11 +2811,17 @@ static Value *emitPointerArithmetic(CodeGenFunction &CGF,
     return CGF.Builder.CreateBitCast(result, pointer->getType());
   }
 
+  Value *result;
   if (CGF.getLangOpts().isSignedOverflowDefined())
-    return CGF.Builder.CreateGEP(pointer, index, "add.ptr");
+    result = CGF.Builder.CreateGEP(pointer, index, "add.ptr");
+  else
+    result = CGF.EmitCheckedInBoundsGEP(pointer, index, isSigned,
+                                        isSubtraction, op.E->getExprLoc(),
+                                        "add.ptr");
 
-  return CGF.EmitCheckedInBoundsGEP(pointer, index, isSigned, isSubtraction,
-                                    op.E->getExprLoc(), "add.ptr");
+  if (pointerOperand->getType()->isCheckedPointerArrayType())
+    CGF.EmitDynamicOverflowCheck(op.E, result, isSigned, isSubtraction);
+  return result;
 }
 
 // Construct an fmuladd intrinsic to represent a fused mul-add of MulOp and
@@ -3946,30 +3963,9 @@ LValue CodeGenFunction::EmitCompoundAssignmentLValue(
   llvm_unreachable("Unhandled compound assignment operator");
 }
 
-Value *CodeGenFunction::EmitCheckedInBoundsGEP(Value *Ptr,
-                                               ArrayRef<Value *> IdxList,
-                                               bool SignedIndices,
-                                               bool IsSubtraction,
-                                               SourceLocation Loc,
-                                               const Twine &Name) {
-  Value *GEPVal = Builder.CreateInBoundsGEP(Ptr, IdxList, Name);
-
-  // If the pointer overflow sanitizer isn't enabled, do nothing.
-  if (!SanOpts.has(SanitizerKind::PointerOverflow))
-    return GEPVal;
-
-  // If the GEP has already been reduced to a constant, leave it be.
-  if (isa<llvm::Constant>(GEPVal))
-    return GEPVal;
-
-  // Only check for overflows in the default address space.
-  if (GEPVal->getType()->getPointerAddressSpace())
-    return GEPVal;
-
-  auto *GEP = cast<llvm::GEPOperator>(GEPVal);
-  assert(GEP->isInBounds() && "Expected inbounds GEP");
-
-  SanitizerScope SanScope(this);
+Value *CodeGenFunction::EmitPointerArithmeticNoOverflow(
+    llvm::GEPOperator *GEP, bool SignedIndices, bool IsSubtraction,
+    llvm::Value *&IntPtr, llvm::Value *&ComputedGEP) {
   auto &VMContext = getLLVMContext();
   const auto &DL = CGM.getDataLayout();
   auto *IntPtrTy = DL.getIntPtrType(GEP->getPointerOperandType());
@@ -4042,12 +4038,12 @@ Value *CodeGenFunction::EmitCheckedInBoundsGEP(Value *Ptr,
 
   // Common case: if the total offset is zero, don't emit a check.
   if (TotalOffset == Zero)
-    return GEPVal;
+    return nullptr;
 
   // Now that we've computed the total offset, add it to the base pointer (with
   // wrapping semantics).
-  auto *IntPtr = Builder.CreatePtrToInt(GEP->getPointerOperand(), IntPtrTy);
-  auto *ComputedGEP = Builder.CreateAdd(IntPtr, TotalOffset);
+  IntPtr = Builder.CreatePtrToInt(GEP->getPointerOperand(), IntPtrTy);
+  ComputedGEP = Builder.CreateAdd(IntPtr, TotalOffset);
 
   // The GEP is valid if:
   // 1) The total offset doesn't overflow, and
@@ -4069,6 +4065,39 @@ Value *CodeGenFunction::EmitCheckedInBoundsGEP(Value *Ptr,
     auto *NegOrZeroValid = Builder.CreateICmpULE(ComputedGEP, IntPtr);
     ValidGEP = Builder.CreateAnd(NegOrZeroValid, NoOffsetOverflow);
   }
+  return ValidGEP;
+}
+
+Value *CodeGenFunction::EmitCheckedInBoundsGEP(Value *Ptr,
+                                               ArrayRef<Value *> IdxList,
+                                               bool SignedIndices,
+                                               bool IsSubtraction,
+                                               SourceLocation Loc,
+                                               const Twine &Name) {
+  Value *GEPVal = Builder.CreateInBoundsGEP(Ptr, IdxList, Name);
+
+  // If the pointer overflow sanitizer isn't enabled, do nothing.
+  if (!SanOpts.has(SanitizerKind::PointerOverflow))
+    return GEPVal;
+
+  // If the GEP has already been reduced to a constant, leave it be.
+  if (isa<llvm::Constant>(GEPVal))
+    return GEPVal;
+
+  // Only check for overflows in the default address space.
+  if (GEPVal->getType()->getPointerAddressSpace())
+    return GEPVal;
+
+  auto *GEP = cast<llvm::GEPOperator>(GEPVal);
+  assert(GEP->isInBounds() && "Expected inbounds GEP");
+
+  SanitizerScope SanScope(this);
+  llvm::Value *IntPtr = nullptr;
+  llvm::Value *ComputedGEP = nullptr;
+  llvm::Value *ValidGEP = EmitPointerArithmeticNoOverflow(
+      GEP, SignedIndices, IsSubtraction, IntPtr, ComputedGEP);
+  if (!ValidGEP)
+    return GEPVal;
 
   llvm::Constant *StaticArgs[] = {EmitCheckSourceLocation(Loc)};
   // Pass the computed GEP to the runtime to avoid emitting poisoned arguments.
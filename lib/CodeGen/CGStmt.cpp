@@ -21,6 +21,7 @@
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Sema/LoopHint.h"
 #include "clang/Sema/SemaDiagnostic.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/IR/CallSite.h"
 #include "llvm/IR/DataLayout.h"
@@ -376,9 +377,42 @@ CodeGenFunction::EmitCompoundStmtWithoutScope(const CompoundStmt &S,
                                               bool GetLast,
                                               AggValueSlot AggSlot) {
 
-  for (CompoundStmt::const_body_iterator I = S.body_begin(),
-       E = S.body_end()-GetLast; I != E; ++I)
-    EmitStmt(*I);
+  // With -fcheckedc-coalesce-checks, the Checked C bounds checks for each
+  // run of statements without control flow are emitted before the run.
+  bool CoalesceChecks = CGM.getCodeGenOpts().CheckedCCoalesceChecks;
+  SmallVector<const Expr *, 8> CoalescedChecks;
+  unsigned RunLeft = 0;
+
+  // With -fcheckedc-subsume-cast-checks, the check of a dynamic bounds cast
+  // is combined with the checks of the accesses through its result in the
+  // next statement.
+  bool SubsumeCastChecks = CGM.getCodeGenOpts().CheckedCSubsumeCastChecks;
+  SmallVector<const Expr *, 4> CastSubsumedChecks;
+
+  ArrayRef<const Stmt *> Body(S.body_begin(), S.body_end() - GetLast);
+  for (unsigned I = 0, E = Body.size(); I != E; ++I) {
+    if (CoalesceChecks && RunLeft == 0) {
+      for (const Expr *Access : CoalescedChecks)
+        HoistedBoundsChecks.erase(Access);
+      CoalescedChecks.clear();
+      RunLeft = EmitCoalescedBoundsChecks(Body.slice(I), CoalescedChecks);
+    }
+    SmallVector<const Expr *, 4> Subsumed;
+    if (!SubsumeCastChecks || I + 1 == E ||
+        !EmitSubsumedBoundsCastCheck(Body[I], Body[I + 1], Subsumed))
+      EmitStmt(Body[I]);
+    // The accesses subsumed by the previous statement were in this one.
+    for (const Expr *Access : CastSubsumedChecks)
+      HoistedBoundsChecks.erase(Access);
+    CastSubsumedChecks = std::move(Subsumed);
+    if (RunLeft)
+      --RunLeft;
+  }
+
+  for (const Expr *Access : CoalescedChecks)
+    HoistedBoundsChecks.erase(Access);
+  for (const Expr *Access : CastSubsumedChecks)
+    HoistedBoundsChecks.erase(Access);
 
   Address RetAlloca = Address::invalid();
   if (GetLast) {
@@ -827,6 +861,51 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S,
   if (S.getInit())
     EmitStmt(S.getInit());
 
+  // With -fcheckedc-version-loops, first emit a copy of the loop without
+  // the Checked C bounds checks of the body that a single test before the
+  // loop shows cannot fail, then the checked loop for when the test fails.
+  bool Versioned = false;
+  if (CGM.getCodeGenOpts().CheckedCVersionLoops) {
+    SmallVector<const Expr *, 4> UncheckedAccesses;
+    if (llvm::BasicBlock *CheckedLoop =
+            EmitLoopVersionTest(S, UncheckedAccesses)) {
+      // The declarations in the body are emitted again in the checked loop.
+      DeclMapTy SavedDeclMap = LocalDeclMap;
+      EmitForStmtLoop(S, ForAttrs, LoopExit, ForScope.requiresCleanups());
+      LoopStack.pop();
+      for (const Expr *E : UncheckedAccesses)
+        HoistedBoundsChecks.erase(E);
+      LocalDeclMap = SavedDeclMap;
+      EmitBlock(CheckedLoop);
+      Versioned = true;
+    }
+  }
+
+  // Emit the loop-invariant Checked C bounds checks for the body here, in
+  // the preheader, instead of on every iteration.
+  SmallVector<const Expr *, 4> HoistedChecks;
+  if (CGM.getCodeGenOpts().CheckedCHoistChecks && !Versioned)
+    EmitHoistedBoundsChecks(S, HoistedChecks);
+
+  EmitForStmtLoop(S, ForAttrs, LoopExit, ForScope.requiresCleanups());
+
+  for (const Expr *E : HoistedChecks)
+    HoistedBoundsChecks.erase(E);
+
+  ForScope.ForceCleanup();
+
+  LoopStack.pop();
+
+  // Emit the fall-through block.
+  EmitBlock(LoopExit.getBlock(), true);
+}
+
+/// Emit the part of the for loop S after its initialization.  This leaves
+/// the loop on LoopStack.
+void CodeGenFunction::EmitForStmtLoop(const ForStmt &S,
+                                      ArrayRef<const Attr *> ForAttrs,
+                                      JumpDest LoopExit,
+                                      bool ForScopeRequiresCleanups) {
   // Start the loop with a block that tests the condition.
   // If there's an increment, the continue scope will be overwritten
   // later.
@@ -862,7 +941,7 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S,
     llvm::BasicBlock *ExitBlock = LoopExit.getBlock();
     // If there are any cleanups between here and the loop-exit scope,
     // create a block to stage a loop exit along.
-    if (ForScope.requiresCleanups())
+    if (ForScopeRequiresCleanups)
       ExitBlock = createBasicBlock("for.cond.cleanup");
 
     // As long as the condition is true, iterate the loop.
@@ -906,13 +985,6 @@ void CodeGenFunction::EmitForStmt(const ForStmt &S,
 
   EmitStopPoint(&S);
   EmitBranch(CondBlock);
-
-  ForScope.ForceCleanup();
-
-  LoopStack.pop();
-
-  // Emit the fall-through block.
-  EmitBlock(LoopExit.getBlock(), true);
 }
 
 void
@@ -1539,6 +1611,76 @@ static bool FindCaseStatementsForValue(const SwitchStmt &S,
          FoundCase;
 }
 
+/// Lower \p SI, a switch in a loop of a function with the threaded_dispatch
+/// attribute, to an indirect branch through a table of the addresses of its
+/// cases, if its case values are dense enough. The optimizer then duplicates
+/// the indirect branch into the cases that loop back to the switch.
+static void emitThreadedDispatch(CodeGenFunction &CGF, llvm::SwitchInst *SI) {
+  const unsigned MinCases = 4;
+  const unsigned MaxTableSize = 4096;
+  unsigned NumCases = SI->getNumCases();
+  if (NumCases < MinCases)
+    return;
+
+  llvm::APInt Min = SI->case_begin()->getCaseValue()->getValue();
+  llvm::APInt Max = Min;
+  for (auto Case : SI->cases()) {
+    const llvm::APInt &Value = Case.getCaseValue()->getValue();
+    if (Value.slt(Min))
+      Min = Value;
+    if (Value.sgt(Max))
+      Max = Value;
+  }
+  // Require a quarter of the table to be cases.
+  llvm::APInt Span = Max - Min;
+  if (Span.uge(MaxTableSize) || Span.getZExtValue() >= NumCases * 4)
+    return;
+  unsigned TableSize = Span.getZExtValue() + 1;
+
+  llvm::BasicBlock *DefaultDest = SI->getDefaultDest();
+  SmallVector<llvm::Constant *, 64> Targets(
+      TableSize, llvm::BlockAddress::get(CGF.CurFn, DefaultDest));
+  for (auto Case : SI->cases())
+    Targets[(Case.getCaseValue()->getValue() - Min).getZExtValue()] =
+        llvm::BlockAddress::get(CGF.CurFn, Case.getCaseSuccessor());
+
+  llvm::ArrayType *TableTy = llvm::ArrayType::get(CGF.Int8PtrTy, TableSize);
+  auto *Table = new llvm::GlobalVariable(
+      CGF.CGM.getModule(), TableTy, /*isConstant=*/true,
+      llvm::GlobalValue::PrivateLinkage,
+      llvm::ConstantArray::get(TableTy, Targets), "switch.targets");
+  Table->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+
+  // Branch to the default for the values outside of the table, and through
+  // the table for the others.
+  llvm::Value *Cond = SI->getCondition();
+  llvm::BasicBlock *DispatchBlock = CGF.createBasicBlock(
+      "sw.dispatch", CGF.CurFn, SI->getParent()->getNextNode());
+  CGBuilderTy Builder(CGF, SI);
+  llvm::Value *Index =
+      Builder.CreateSub(Cond, llvm::ConstantInt::get(Cond->getType(), Min));
+  llvm::Value *InTable = Builder.CreateICmpULT(
+      Index, llvm::ConstantInt::get(Cond->getType(), TableSize));
+  Builder.CreateCondBr(InTable, DispatchBlock, DefaultDest);
+
+  Builder.SetInsertPoint(DispatchBlock);
+  llvm::Value *Indices[] = {
+      llvm::ConstantInt::get(CGF.IntPtrTy, 0),
+      Builder.CreateZExtOrTrunc(Index, CGF.IntPtrTy)};
+  llvm::Value *Slot = Builder.CreateInBoundsGEP(TableTy, Table, Indices);
+  llvm::Value *Target =
+      Builder.CreateAlignedLoad(Slot, CGF.getPointerAlign(), "sw.target");
+  llvm::IndirectBrInst *Branch = Builder.CreateIndirectBr(Target, NumCases);
+  llvm::SmallPtrSet<llvm::BasicBlock *, 16> Dests;
+  Dests.insert(DefaultDest);
+  Branch->addDestination(DefaultDest);
+  for (auto Case : SI->cases())
+    if (Dests.insert(Case.getCaseSuccessor()).second)
+      Branch->addDestination(Case.getCaseSuccessor());
+
+  SI->eraseFromParent();
+}
+
 void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
   // Handle nested switch statements.
   llvm::SwitchInst *SavedSwitchInsn = SwitchInsn;
@@ -1682,6 +1824,12 @@ void CodeGenFunction::EmitSwitchStmt(const SwitchStmt &S) {
                               createProfileWeights(*SwitchWeights));
     delete SwitchWeights;
   }
+
+  // Dispatch loops are the switch statements within loops.
+  if (OuterContinue.isValid() && CurCodeDecl &&
+      CurCodeDecl->hasAttr<ThreadedDispatchAttr>())
+    emitThreadedDispatch(*this, SwitchInsn);
+
   SwitchInsn = SavedSwitchInsn;
   SwitchWeights = SavedSwitchWeights;
   CaseRangeBlock = SavedCRBlock;
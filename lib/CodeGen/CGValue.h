@@ -222,6 +222,10 @@ class LValue {
   // this lvalue.
   bool Nontemporal : 1;
 
+  // This flag shows if Checked C has shown that accesses to this lvalue are
+  // in bounds, statically or with a dynamic check.
+  bool CheckedCInBounds : 1;
+
   Expr *BaseIvarExp;
 
 private:
@@ -241,6 +245,7 @@ private:
     this->Ivar = this->ObjIsArray = this->NonGC = this->GlobalObjCRef = false;
     this->ImpreciseLifetime = false;
     this->Nontemporal = false;
+    this->CheckedCInBounds = false;
     this->ThreadLocalRef = false;
     this->BaseIvarExp = nullptr;
   }
@@ -287,6 +292,8 @@ public:
   }
   bool isNontemporal() const { return Nontemporal; }
   void setNontemporal(bool Value) { Nontemporal = Value; }
+  bool isCheckedCInBounds() const { return CheckedCInBounds; }
+  void setCheckedCInBounds(bool Value) { CheckedCInBounds = Value; }
 
   bool isObjCWeak() const {
     return Quals.getObjCGCAttr() == Qualifiers::Weak;
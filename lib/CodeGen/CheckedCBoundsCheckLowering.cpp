@@ -0,0 +1,703 @@
+//===--- CheckedCBoundsCheckLowering.cpp - Lower Checked C checks ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// With -fcheckedc-late-check-lowering, CodeGen emits Checked C bounds checks
+// as calls to __checkedc_bounds_check instead of compares and branches.  The
+// optimizer treats the calls as opaque, so the address computations feeding
+// them are simplified by the usual passes while the checks themselves stay
+// intact.  This pass runs late in the pipeline.  It removes the checks that
+// are implied by other checks, merges checks of nearby ranges, and expands
+// the remaining calls into the same code that CodeGen would have emitted.
+//
+// With -fcheckedc-sticky-loop-checks, the checks in innermost loops are
+// lowered so that they do not branch out of the loop, which would keep the
+// loop from being vectorized.  Checks of addresses that advance by a fixed
+// stride on every iteration are replaced by one check of the whole range
+// before the loop.  If the loop then writes to memory only through checked
+// addresses, the remaining checks OR their failures into a flag, which is
+// tested on exit from the loop.
+//
+// With -fcheckedc-check-calls, the remaining checks are not expanded but
+// become calls to __checkedc_check_range, a helper defined once per image,
+// which trades the speed of the inline compares for code size.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CheckedCBoundsCheckLowering.h"
+#include "CheckedCCheckRemarks.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/AssumptionCache.h"
+#include "llvm/Analysis/EHPersonalities.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpander.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/SSAUpdater.h"
+
+using namespace clang;
+using namespace CodeGen;
+using namespace llvm;
+
+#define DEBUG_TYPE "checkedc-bounds-check-lowering"
+
+STATISTIC(NumBoundsChecksExpanded, "The # of Checked C bounds checks expanded");
+STATISTIC(NumBoundsChecksDominated, "The # of Checked C bounds checks removed because a dominating check implies them");
+STATISTIC(NumBoundsChecksMerged, "The # of Checked C bounds checks merged into an earlier check");
+STATISTIC(NumBoundsChecksBeforeLoop, "The # of Checked C bounds checks in loops replaced by a check before the loop");
+STATISTIC(NumBoundsChecksSticky, "The # of Checked C bounds checks in loops whose failure is tested on exit from the loop");
+STATISTIC(NumBoundsChecksCalled, "The # of Checked C bounds checks lowered to calls to the out-of-line helper");
+
+const char clang::CodeGen::CheckedCBoundsCheckFnName[] =
+  "__checkedc_bounds_check";
+const char clang::CodeGen::CheckedCCheckRangeFnName[] =
+  "__checkedc_check_range";
+
+/// The most checks with the same bounds and base that a check is compared
+/// against when looking for a dominating check.  This keeps the pass linear
+/// in practice for functions with very many accesses to the same buffer.
+static const unsigned MaxDominatingCheckCandidates = 64;
+
+namespace {
+  /// A bounds check whose checked range is a constant byte range
+  /// [Start, End) from Base.  Base is null if the range is not constant.
+  struct BoundsCheckInfo {
+    CallInst *Call;
+    Value *Base;
+    int64_t Start;
+    int64_t End;
+
+    Value *getLower() const { return Call->getArgOperand(1); }
+    Value *getUpper() const { return Call->getArgOperand(2); }
+  };
+
+  typedef std::pair<std::pair<Value *, Value *>, Value *> BoundsCheckKey;
+}
+
+static BoundsCheckInfo getBoundsCheckInfo(CallInst *Call,
+                                          const DataLayout &DL) {
+  BoundsCheckInfo Info = { Call, nullptr, 0, 0 };
+  const ConstantInt *Size = dyn_cast<ConstantInt>(Call->getArgOperand(3));
+  if (!Size || Size->isNegative() || Size->getValue().getActiveBits() > 32)
+    return Info;
+  int64_t Offset = 0;
+  Value *Base = GetPointerBaseWithConstantOffset(Call->getArgOperand(0),
+                                                 Offset, DL);
+  if (Base->getType()->getPointerAddressSpace() !=
+      Call->getArgOperand(0)->getType()->getPointerAddressSpace())
+    return Info;
+  Info.Base = Base;
+  Info.Start = Offset;
+  Info.End = Offset + Size->getSExtValue();
+  return Info;
+}
+
+static BoundsCheckKey getBoundsCheckKey(const BoundsCheckInfo &Info) {
+  return std::make_pair(std::make_pair(Info.getLower(), Info.getUpper()),
+                        Info.Base);
+}
+
+/// Remove the checks whose range is contained in the range of a dominating
+/// check with the same bounds.
+static void removeDominatedChecks(SmallVectorImpl<BoundsCheckInfo> &Checks,
+                                  DominatorTree &DT) {
+  DenseMap<BoundsCheckKey, SmallVector<BoundsCheckInfo *, 4>> Groups;
+  for (BoundsCheckInfo &Info : Checks)
+    if (Info.Base)
+      Groups[getBoundsCheckKey(Info)].push_back(&Info);
+
+  // Strict dominance is a partial order, so a check removed here always
+  // has a surviving check that dominates it and implies it.
+  for (auto &Group : Groups) {
+    SmallVectorImpl<BoundsCheckInfo *> &Members = Group.second;
+    for (BoundsCheckInfo *Info : Members) {
+      unsigned Candidates = 0;
+      for (BoundsCheckInfo *Other : Members) {
+        if (Other == Info || !Other->Call)
+          continue;
+        if (++Candidates > MaxDominatingCheckCandidates)
+          break;
+        if (Other->Start <= Info->Start && Info->End <= Other->End &&
+            DT.dominates(Other->Call, Info->Call)) {
+          ++NumBoundsChecksDominated;
+          Info->Call->eraseFromParent();
+          Info->Call = nullptr;
+          break;
+        }
+      }
+    }
+  }
+
+  Checks.erase(remove_if(Checks, [](const BoundsCheckInfo &Info) {
+    return !Info.Call;
+  }), Checks.end());
+}
+
+/// Widen \p Into so that it also checks the range of \p From.
+static void widenCheck(BoundsCheckInfo &Into, const BoundsCheckInfo &From) {
+  int64_t Start = std::min(Into.Start, From.Start);
+  int64_t End = std::max(Into.End, From.End);
+  if (Start == Into.Start && End == Into.End)
+    return;
+
+  CallInst *Call = Into.Call;
+  IRBuilder<> Builder(Call);
+  Value *Ptr = Call->getArgOperand(0);
+  if (Start != Into.Start) {
+    const DataLayout &DL = Call->getModule()->getDataLayout();
+    Value *Base = Builder.CreatePointerCast(Into.Base, Ptr->getType());
+    Ptr = Builder.CreateGEP(Builder.getInt8Ty(), Base,
+                            ConstantInt::get(DL.getIntPtrType(Ptr->getType()),
+                                             Start));
+    Call->setArgOperand(0, Ptr);
+  }
+  Value *Size = Call->getArgOperand(3);
+  Call->setArgOperand(3, ConstantInt::get(Size->getType(), End - Start));
+  Into.Start = Start;
+  Into.End = End;
+}
+
+/// Merge each check into an earlier check in the same block with the same
+/// bounds and base, provided that the earlier check always reaches the later
+/// one.  The merged check traps if either check would have trapped.  It may
+/// trap before side effects that used to precede the later check.
+static void mergeAdjacentChecks(Function &F,
+                                SmallVectorImpl<BoundsCheckInfo> &Checks,
+                                DominatorTree &DT) {
+  DenseMap<CallInst *, BoundsCheckInfo *> InfoForCall;
+  for (BoundsCheckInfo &Info : Checks)
+    InfoForCall[Info.Call] = &Info;
+
+  for (BasicBlock &BB : F) {
+    SmallVector<BoundsCheckInfo *, 8> Open;
+    for (auto I = BB.begin(), E = BB.end(); I != E; ) {
+      Instruction *Inst = &*I++;
+      BoundsCheckInfo *Info = nullptr;
+      if (CallInst *Call = dyn_cast<CallInst>(Inst))
+        Info = InfoForCall.lookup(Call);
+      if (!Info) {
+        if (!isGuaranteedToTransferExecutionToSuccessor(Inst))
+          Open.clear();
+        continue;
+      }
+      if (!Info->Base)
+        continue;
+
+      Instruction *BaseInst = dyn_cast<Instruction>(Info->Base);
+      BoundsCheckInfo *Into = nullptr;
+      for (BoundsCheckInfo *Earlier : Open) {
+        if (getBoundsCheckKey(*Earlier) == getBoundsCheckKey(*Info) &&
+            (!BaseInst || DT.dominates(BaseInst, Earlier->Call))) {
+          Into = Earlier;
+          break;
+        }
+      }
+      if (!Into) {
+        Open.push_back(Info);
+        continue;
+      }
+
+      ++NumBoundsChecksMerged;
+      widenCheck(*Into, *Info);
+      Info->Call->eraseFromParent();
+      Info->Call = nullptr;
+    }
+  }
+
+  Checks.erase(remove_if(Checks, [](const BoundsCheckInfo &Info) {
+    return !Info.Call;
+  }), Checks.end());
+}
+
+static BasicBlock *createTrapBlock(Function &F, const DebugLoc &Loc) {
+  BasicBlock *FailBlock =
+    BasicBlock::Create(F.getContext(), "_Dynamic_check.failed", &F);
+  IRBuilder<> Builder(FailBlock);
+  Builder.SetCurrentDebugLocation(Loc);
+  CallInst *TrapCall = Builder.CreateCall(
+    Intrinsic::getDeclaration(F.getParent(), Intrinsic::trap));
+  TrapCall->setDoesNotReturn();
+  TrapCall->setDoesNotThrow();
+  TrapCall->addAttribute(AttributeList::FunctionIndex, Attribute::Cold);
+  Builder.CreateUnreachable();
+  return FailBlock;
+}
+
+/// Emit, before \p InsertBefore, a value that is true if the Size bytes at
+/// Ptr lie within [Lower, Upper).
+static Value *emitCheckCondition(Value *Ptr, Value *Lower, Value *Upper,
+                                 Value *Size, Instruction *InsertBefore) {
+  IRBuilder<> Builder(InsertBefore);
+  Value *LowerChk = Builder.CreateICmpULE(Lower, Ptr, "_Dynamic_check.lower");
+  Value *UpperChk;
+  const ConstantInt *ConstantSize = dyn_cast<ConstantInt>(Size);
+  if (ConstantSize && ConstantSize->isZero())
+    UpperChk = Builder.CreateICmpULE(Ptr, Upper, "_Dynamic_check.upper");
+  else if (ConstantSize) {
+    // Compare the last byte rather than the end of the range, so that a
+    // range ending at the top of the address space does not wrap around.
+    Value *Last = Ptr;
+    if (!ConstantSize->isOne())
+      Last = Builder.CreateGEP(Builder.getInt8Ty(), Ptr,
+                               ConstantInt::get(Size->getType(),
+                                                ConstantSize->getValue() - 1),
+                               "_Dynamic_check.last");
+    UpperChk = Builder.CreateICmpULT(Last, Upper, "_Dynamic_check.upper");
+  } else {
+    // The range must also not wrap around.
+    Value *End = Builder.CreateGEP(Builder.getInt8Ty(), Ptr, Size,
+                                   "_Dynamic_check.end");
+    UpperChk = Builder.CreateAnd(
+        Builder.CreateICmpULE(Ptr, End),
+        Builder.CreateICmpULE(End, Upper), "_Dynamic_check.upper");
+  }
+  return Builder.CreateAnd(LowerChk, UpperChk, "_Dynamic_check.range");
+}
+
+/// Emit, before \p Call, a value that is true if the check that \p Call
+/// stands for succeeds.
+static Value *emitCheckCondition(CallInst *Call) {
+  return emitCheckCondition(Call->getArgOperand(0), Call->getArgOperand(1),
+                            Call->getArgOperand(2), Call->getArgOperand(3),
+                            Call);
+}
+
+/// Split the block before \p Before, and branch to a trap block unless
+/// \p Condition is true.  The branch is the check tagged by \p Tag, if any.
+static void emitTrapBranch(Instruction *Before, Value *Condition,
+                           const DebugLoc &Loc, MDNode *Tag,
+                           bool ShareTrapBlocks,
+                           BasicBlock *&SharedTrapBlock) {
+  Function &F = *Before->getFunction();
+  BasicBlock *Head = Before->getParent();
+  BasicBlock *Succeeded =
+    Head->splitBasicBlock(Before->getIterator(), "_Dynamic_check.succeeded");
+  BasicBlock *Failed = SharedTrapBlock;
+  if (!Failed) {
+    Failed = createTrapBlock(F, Loc);
+    if (ShareTrapBlocks)
+      SharedTrapBlock = Failed;
+  }
+  Head->getTerminator()->eraseFromParent();
+  BranchInst *Branch = BranchInst::Create(Succeeded, Failed, Condition, Head);
+  Branch->setDebugLoc(Loc);
+  // As in CodeGen, the check is expected to pass.
+  MDBuilder MDHelper(F.getContext());
+  Branch->setMetadata(LLVMContext::MD_prof,
+                      MDHelper.createBranchWeights((1U << 20) - 1, 1));
+  if (Tag)
+    Branch->setMetadata(CheckedCCheckMDName, Tag);
+}
+
+/// Return the helper that does the check of a call to
+/// __checkedc_bounds_check of type \p FnTy out of line, and define it in
+/// \p M if it is not defined yet.
+///
+/// The helper is emitted by this pass rather than provided by a runtime
+/// library, so that its calling convention is the one the calls use
+/// whatever compiler built the rest of the program.  It is linkonce_odr and
+/// hidden, in a comdat where the target has them, so that an image has one
+/// copy.  On x86-64 it preserves the registers that the caller would have to
+/// save otherwise, so the calls cost little more code than the calls to
+/// __checkedc_bounds_check.  It is not marked cold, which would make the
+/// blocks that call it cold too, but its failure path is.
+static Function *getCheckRangeHelper(Module &M, FunctionType *FnTy) {
+  if (Function *Helper = M.getFunction(CheckedCCheckRangeFnName))
+    return Helper->getFunctionType() == FnTy ? Helper : nullptr;
+
+  Function *Helper = Function::Create(FnTy, GlobalValue::LinkOnceODRLinkage,
+                                      CheckedCCheckRangeFnName, &M);
+  Helper->setVisibility(GlobalValue::HiddenVisibility);
+  Triple T(M.getTargetTriple());
+  if (T.supportsCOMDAT())
+    Helper->setComdat(M.getOrInsertComdat(CheckedCCheckRangeFnName));
+  if (T.getArch() == Triple::x86_64 && !T.isOSWindows())
+    Helper->setCallingConv(CallingConv::PreserveMost);
+  // The inliner runs around this pass, and would undo the saving.
+  Helper->addFnAttr(Attribute::NoInline);
+  Helper->addFnAttr(Attribute::OptimizeForSize);
+  Helper->addFnAttr(Attribute::MinSize);
+
+  BasicBlock *Entry = BasicBlock::Create(M.getContext(), "entry", Helper);
+  ReturnInst *Ret = ReturnInst::Create(M.getContext(), Entry);
+  Function::arg_iterator Args = Helper->arg_begin();
+  Value *Ptr = &*Args++;
+  Value *Lower = &*Args++;
+  Value *Upper = &*Args++;
+  Value *Size = &*Args++;
+  BasicBlock *TrapBlock = nullptr;
+  emitTrapBranch(Ret, emitCheckCondition(Ptr, Lower, Upper, Size, Ret),
+                 DebugLoc(), /*Tag=*/nullptr, /*ShareTrapBlocks=*/false,
+                 TrapBlock);
+  return Helper;
+}
+
+/// Replace \p Call with compares of the pointer against the bounds and a
+/// branch to a trap block, or, if \p Helper is set, with a call to it.
+static void expandCheck(CallInst *Call, bool ShareTrapBlocks,
+                        BasicBlock *&SharedTrapBlock, Function *Helper) {
+  ++NumBoundsChecksExpanded;
+
+  Value *Condition = emitCheckCondition(Call);
+  if (const ConstantInt *ConstantCondition = dyn_cast<ConstantInt>(Condition))
+    if (ConstantCondition->isOne()) {
+      Call->eraseFromParent();
+      return;
+    }
+
+  // The call keeps its tag and its debug location.
+  if (Helper) {
+    ++NumBoundsChecksCalled;
+    RecursivelyDeleteTriviallyDeadInstructions(Condition);
+    Call->setCalledFunction(Helper);
+    Call->setCallingConv(Helper->getCallingConv());
+    return;
+  }
+
+  emitTrapBranch(Call, Condition, Call->getDebugLoc(),
+                 Call->getMetadata(CheckedCCheckMDName), ShareTrapBlocks,
+                 SharedTrapBlock);
+  Call->eraseFromParent();
+}
+
+namespace {
+  /// The flag of a loop whose checks were made sticky, to be tested on
+  /// entry to the exit block Exit.
+  struct StickyLoopExit {
+    BasicBlock *Exit;
+    Value *Failed;
+    DebugLoc Loc;
+  };
+}
+
+/// If the check \p Info in the loop \p L checks an address that advances
+/// by a fixed non-negative stride on every iteration, replace it with a
+/// check of the whole range before the loop.  The loop must be rotated, so
+/// that its body runs BackedgeTakenCount + 1 times once the preheader is
+/// reached, and the check must run on every iteration.
+static bool moveCheckBeforeLoop(BoundsCheckInfo &Info, Loop *L,
+                                const SCEV *BackedgeTakenCount,
+                                ScalarEvolution &SE, DominatorTree &DT,
+                                SCEVExpander &Expander) {
+  CallInst *Call = Info.Call;
+  BasicBlock *Latch = L->getLoopLatch();
+  if (!Latch || L->getExitingBlock() != Latch ||
+      !DT.dominates(Call->getParent(), Latch) ||
+      !L->isLoopInvariant(Info.getLower()) ||
+      !L->isLoopInvariant(Info.getUpper()) ||
+      !isa<ConstantInt>(Call->getArgOperand(3)))
+    return false;
+
+  const SCEVAddRecExpr *AR =
+    dyn_cast<SCEVAddRecExpr>(SE.getSCEV(Call->getArgOperand(0)));
+  if (!AR || AR->getLoop() != L || !AR->isAffine())
+    return false;
+  const SCEVConstant *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+  if (!Step || Step->getAPInt().isNegative())
+    return false;
+
+  const SCEV *Start = AR->getStart();
+  const SCEV *Count =
+    SE.getTruncateOrZeroExtend(BackedgeTakenCount, Step->getType());
+  const SCEV *Last = SE.getAddExpr(Start, SE.getMulExpr(Step, Count));
+  if (!isSafeToExpand(Start, SE) || !isSafeToExpand(Last, SE))
+    return false;
+
+  // The new check is of the bytes from the first address to the end of the
+  // last access.
+  Instruction *InsertPt = L->getLoopPreheader()->getTerminator();
+  Type *PtrTy = Call->getArgOperand(0)->getType();
+  Value *First = Expander.expandCodeFor(Start, PtrTy, InsertPt);
+  Value *LastPtr = Expander.expandCodeFor(Last, PtrTy, InsertPt);
+  IRBuilder<> Builder(InsertPt);
+  Value *Size = Call->getArgOperand(3);
+  Value *Length = Builder.CreateAdd(
+      Builder.CreateSub(Builder.CreatePtrToInt(LastPtr, Size->getType()),
+                        Builder.CreatePtrToInt(First, Size->getType())),
+      Size, "_Dynamic_check.length");
+  CallInst *NewCall = cast<CallInst>(Call->clone());
+  NewCall->setArgOperand(0, First);
+  NewCall->setArgOperand(3, Length);
+  NewCall->insertBefore(InsertPt);
+
+  ++NumBoundsChecksBeforeLoop;
+  Call->eraseFromParent();
+  Info.Call = NewCall;
+  Info.Base = nullptr;
+  return true;
+}
+
+/// Returns true if \p I may have effects, other than trapping, that must
+/// not happen after a failed check in the same loop.  Stores through the
+/// pointers in \p Checked are known to be in bounds.
+static bool hasVisibleEffects(Instruction &I, Function *CheckFn,
+                              const SmallPtrSetImpl<Value *> &Checked) {
+  if (CallInst *Call = dyn_cast<CallInst>(&I))
+    if (Call->getCalledFunction() == CheckFn)
+      return false;
+  if (isa<DbgInfoIntrinsic>(I))
+    return false;
+  if (IntrinsicInst *II = dyn_cast<IntrinsicInst>(&I))
+    if (II->getIntrinsicID() == Intrinsic::lifetime_start ||
+        II->getIntrinsicID() == Intrinsic::lifetime_end)
+      return false;
+  if (StoreInst *SI = dyn_cast<StoreInst>(&I))
+    if (SI->isSimple() &&
+        Checked.count(SI->getPointerOperand()->stripPointerCasts()))
+      return false;
+  return I.mayWriteToMemory() || I.mayThrow();
+}
+
+/// Lower the checks in the innermost loop \p L so that they do not branch
+/// out of the loop, if that is possible without making the effects of the
+/// loop visible before a failed check traps.
+static void makeLoopChecksSticky(Loop *L, Function *CheckFn,
+                                 SmallVectorImpl<BoundsCheckInfo> &Checks,
+                                 ScalarEvolution &SE, DominatorTree &DT,
+                                 SCEVExpander &Expander,
+                                 SmallVectorImpl<StickyLoopExit> &Exits) {
+  BasicBlock *Preheader = L->getLoopPreheader();
+  if (!Preheader || !L->hasDedicatedExits())
+    return;
+  // The loop must run a fixed number of iterations, so that loads from
+  // out-of-bounds addresses cannot keep it from reaching the exit.
+  const SCEV *BackedgeTakenCount = SE.getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BackedgeTakenCount))
+    return;
+
+  SmallVector<BoundsCheckInfo *, 8> InLoop;
+  for (BoundsCheckInfo &Info : Checks)
+    if (L->contains(Info.Call))
+      InLoop.push_back(&Info);
+  if (InLoop.empty())
+    return;
+
+  SmallPtrSet<Value *, 8> Checked;
+  SmallVector<BoundsCheckInfo *, 8> Remaining;
+  for (BoundsCheckInfo *Info : InLoop) {
+    Value *Ptr = Info->Call->getArgOperand(0)->stripPointerCasts();
+    if (moveCheckBeforeLoop(*Info, L, BackedgeTakenCount, SE, DT, Expander))
+      Checked.insert(Ptr);
+    else
+      Remaining.push_back(Info);
+  }
+  if (Remaining.empty())
+    return;
+
+  SmallVector<BasicBlock *, 4> ExitBlocks;
+  L->getExitBlocks(ExitBlocks);
+  for (BasicBlock *Exit : ExitBlocks)
+    if (Exit->isEHPad())
+      return;
+  for (BasicBlock *BB : L->blocks())
+    for (Instruction &I : *BB)
+      if (hasVisibleEffects(I, CheckFn, Checked))
+        return;
+
+  // Each check ORs its failure into the flag:
+  //
+  // %preheader:
+  //   br %header
+  // %header:
+  //   %failed = phi i1 [ false, %preheader ], [ %failed.next, %latch ]
+  //   ...
+  //   %failed.next = or i1 %failed, !(check condition)
+  //   ...
+  // %exit:
+  //   (trap if %failed.next)
+  LLVMContext &Ctx = Preheader->getContext();
+  SSAUpdater Updater;
+  Updater.Initialize(Type::getInt1Ty(Ctx), "_Dynamic_check.failed_flag");
+  Updater.AddAvailableValue(Preheader, ConstantInt::getFalse(Ctx));
+
+  // The first flag update in each block is given its incoming value once
+  // all of the updates are known.
+  DenseMap<BasicBlock *, Instruction *> LastUpdate;
+  SmallVector<Instruction *, 8> FirstUpdates;
+  for (BoundsCheckInfo *Info : Remaining) {
+    CallInst *Call = Info->Call;
+    BasicBlock *BB = Call->getParent();
+    Value *Condition = emitCheckCondition(Call);
+    IRBuilder<> Builder(Call);
+    Instruction *&Last = LastUpdate[BB];
+    Value *Incoming = Last ? static_cast<Value *>(Last)
+                           : UndefValue::get(Builder.getInt1Ty());
+    // This is created directly, so that it is not constant folded.
+    Instruction *Update = BinaryOperator::CreateOr(
+        Incoming, Builder.CreateNot(Condition), "_Dynamic_check.failed_flag",
+        Call);
+    // The update is what is left of the check in the loop.
+    if (MDNode *Tag = Call->getMetadata(CheckedCCheckMDName))
+      Update->setMetadata(CheckedCCheckMDName, Tag);
+    if (!Last)
+      FirstUpdates.push_back(Update);
+    Last = Update;
+  }
+  // The checks in a block are in program order, so Last is the final update
+  // in its block.
+  for (auto &Entry : LastUpdate)
+    Updater.AddAvailableValue(Entry.first, Entry.second);
+  for (Instruction *Update : FirstUpdates)
+    Update->setOperand(0, Updater.GetValueInMiddleOfBlock(Update->getParent()));
+
+  DebugLoc Loc = Remaining.front()->Call->getDebugLoc();
+  for (BasicBlock *Exit : ExitBlocks) {
+    StickyLoopExit StickyExit = { Exit, Updater.GetValueInMiddleOfBlock(Exit),
+                                  Loc };
+    Exits.push_back(StickyExit);
+  }
+
+  for (BoundsCheckInfo *Info : Remaining) {
+    ++NumBoundsChecksSticky;
+    Info->Call->eraseFromParent();
+    Info->Call = nullptr;
+  }
+}
+
+/// Make the checks in the innermost loops of \p F sticky where possible.
+static void makeStickyLoopChecks(Function &F, Function *CheckFn,
+                                 SmallVectorImpl<BoundsCheckInfo> &Checks,
+                                 DominatorTree &DT,
+                                 SmallVectorImpl<StickyLoopExit> &Exits) {
+  LoopInfo LI(DT);
+  if (LI.empty())
+    return;
+
+  TargetLibraryInfoImpl TLII(Triple(F.getParent()->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  AssumptionCache AC(F);
+  ScalarEvolution SE(F, TLI, AC, DT, LI);
+  SCEVExpander Expander(SE, F.getParent()->getDataLayout(),
+                        "_Dynamic_check");
+
+  SmallVector<Loop *, 8> Worklist(LI.begin(), LI.end());
+  while (!Worklist.empty()) {
+    Loop *L = Worklist.pop_back_val();
+    if (L->empty())
+      makeLoopChecksSticky(L, CheckFn, Checks, SE, DT, Expander, Exits);
+    else
+      Worklist.append(L->begin(), L->end());
+  }
+
+  Checks.erase(remove_if(Checks, [](const BoundsCheckInfo &Info) {
+    return !Info.Call;
+  }), Checks.end());
+}
+
+bool clang::CodeGen::lowerCheckedCBoundsChecks(Function &F, bool Optimize,
+                                               bool ShareTrapBlocks,
+                                               bool StickyLoopChecks,
+                                               bool CheckCalls) {
+  Function *CheckFn = F.getParent()->getFunction(CheckedCBoundsCheckFnName);
+  if (!CheckFn || F.isDeclaration())
+    return false;
+
+  const DataLayout &DL = F.getParent()->getDataLayout();
+  SmallVector<BoundsCheckInfo, 16> Checks;
+  for (Instruction &I : instructions(F))
+    if (CallInst *Call = dyn_cast<CallInst>(&I))
+      if (Call->getCalledFunction() == CheckFn)
+        Checks.push_back(getBoundsCheckInfo(Call, DL));
+  if (Checks.empty())
+    return false;
+
+  SmallVector<StickyLoopExit, 4> StickyExits;
+  if (Optimize && !F.hasFnAttribute(Attribute::OptimizeNone)) {
+    DominatorTree DT(F);
+    removeDominatedChecks(Checks, DT);
+    mergeAdjacentChecks(F, Checks, DT);
+    if (StickyLoopChecks)
+      makeStickyLoopChecks(F, CheckFn, Checks, DT, StickyExits);
+  }
+
+  // A funclet may not branch to a block outside of it, so trap blocks are
+  // not shared in functions that use funclets.
+  if (F.hasPersonalityFn() &&
+      isFuncletEHPersonality(classifyEHPersonality(F.getPersonalityFn())))
+    ShareTrapBlocks = false;
+
+  Function *Helper = nullptr;
+  if (CheckCalls)
+    Helper = getCheckRangeHelper(*F.getParent(), CheckFn->getFunctionType());
+
+  BasicBlock *SharedTrapBlock = nullptr;
+  for (BoundsCheckInfo &Info : Checks)
+    expandCheck(Info.Call, ShareTrapBlocks, SharedTrapBlock, Helper);
+  for (StickyLoopExit &StickyExit : StickyExits) {
+    IRBuilder<> Builder(&*StickyExit.Exit->getFirstInsertionPt());
+    Value *Succeeded = Builder.CreateNot(StickyExit.Failed,
+                                         "_Dynamic_check.sticky");
+    emitTrapBranch(&*Builder.GetInsertPoint(), Succeeded, StickyExit.Loc,
+                   /*Tag=*/nullptr, ShareTrapBlocks, SharedTrapBlock);
+  }
+  return true;
+}
+
+namespace {
+  class CheckedCBoundsCheckLowering : public FunctionPass {
+    bool Optimize;
+    bool ShareTrapBlocks;
+    bool StickyLoopChecks;
+    bool CheckCalls;
+
+  public:
+    static char ID;
+
+    CheckedCBoundsCheckLowering(bool Optimize, bool ShareTrapBlocks,
+                                bool StickyLoopChecks, bool CheckCalls)
+      : FunctionPass(ID), Optimize(Optimize),
+        ShareTrapBlocks(ShareTrapBlocks), StickyLoopChecks(StickyLoopChecks),
+        CheckCalls(CheckCalls) {}
+
+    // The checks must be expanded even in functions that are not optimized,
+    // because __checkedc_bounds_check is never defined.
+    bool runOnFunction(Function &F) override {
+      return lowerCheckedCBoundsChecks(F, Optimize, ShareTrapBlocks,
+                                       StickyLoopChecks, CheckCalls);
+    }
+
+    StringRef getPassName() const override {
+      return "Checked C bounds check lowering";
+    }
+  };
+}
+
+char CheckedCBoundsCheckLowering::ID = 0;
+
+FunctionPass *
+clang::CodeGen::createCheckedCBoundsCheckLoweringPass(bool Optimize,
+                                                      bool ShareTrapBlocks,
+                                                      bool StickyLoopChecks,
+                                                      bool CheckCalls) {
+  return new CheckedCBoundsCheckLowering(Optimize, ShareTrapBlocks,
+                                         StickyLoopChecks, CheckCalls);
+}
+
+PreservedAnalyses
+CheckedCBoundsCheckLoweringPass::run(Function &F,
+                                     FunctionAnalysisManager &AM) {
+  if (!lowerCheckedCBoundsChecks(F, Optimize, ShareTrapBlocks,
+                                 StickyLoopChecks, CheckCalls))
+    return PreservedAnalyses::all();
+  return PreservedAnalyses::none();
+}
@@ -0,0 +1,81 @@
+//===--- CheckedCBoundsCheckLowering.h - Lower Checked C checks ---*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the pass that optimizes and expands the calls to
+// __checkedc_bounds_check emitted for -fcheckedc-late-check-lowering.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_CODEGEN_CHECKEDCBOUNDSCHECKLOWERING_H
+#define LLVM_CLANG_LIB_CODEGEN_CHECKEDCBOUNDSCHECKLOWERING_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+class Function;
+class FunctionPass;
+}
+
+namespace clang {
+namespace CodeGen {
+
+/// The name of the function that stands for a Checked C bounds check until
+/// the check is expanded.  A call
+///
+///   __checkedc_bounds_check(i8* ptr, i8* lower, i8* upper, i64 size)
+///
+/// checks that the bytes [ptr, ptr + size) lie within [lower, upper), and
+/// traps otherwise.  A size of 0 only checks that lower <= ptr <= upper.
+extern const char CheckedCBoundsCheckFnName[];
+
+/// The name of the helper with the same parameters that the lowering
+/// defines and calls instead of expanding a check, with
+/// -fcheckedc-check-calls.
+extern const char CheckedCCheckRangeFnName[];
+
+/// Remove the bounds checks in \p F that are implied by other checks when
+/// \p Optimize is set, and expand the remaining checks into compares and
+/// branches to trap blocks.  The trap blocks are shared within the function
+/// when \p ShareTrapBlocks is set.  When \p Optimize and
+/// \p StickyLoopChecks are set, checks in innermost loops are lowered
+/// without branches out of the loop where possible.  When \p CheckCalls is
+/// set, the remaining checks call an out-of-line helper instead of being
+/// expanded.  Returns true if \p F was changed.
+bool lowerCheckedCBoundsChecks(llvm::Function &F, bool Optimize,
+                               bool ShareTrapBlocks, bool StickyLoopChecks,
+                               bool CheckCalls);
+
+/// Create the legacy pass manager version of the lowering.
+llvm::FunctionPass *createCheckedCBoundsCheckLoweringPass(bool Optimize,
+                                                          bool ShareTrapBlocks,
+                                                          bool StickyLoopChecks,
+                                                          bool CheckCalls);
+
+/// The new pass manager version of the lowering.
+class CheckedCBoundsCheckLoweringPass
+    : public llvm::PassInfoMixin<CheckedCBoundsCheckLoweringPass> {
+  bool Optimize;
+  bool ShareTrapBlocks;
+  bool StickyLoopChecks;
+  bool CheckCalls;
+
+public:
+  CheckedCBoundsCheckLoweringPass(bool Optimize, bool ShareTrapBlocks,
+                                  bool StickyLoopChecks, bool CheckCalls)
+      : Optimize(Optimize), ShareTrapBlocks(ShareTrapBlocks),
+        StickyLoopChecks(StickyLoopChecks), CheckCalls(CheckCalls) {}
+
+  llvm::PreservedAnalyses run(llvm::Function &F,
+                              llvm::FunctionAnalysisManager &AM);
+};
+
+} // end namespace CodeGen
+} // end namespace clang
+
+#endif
@@ -0,0 +1,167 @@
+//===--- CheckedCCheckRemarks.cpp - Remarks on Checked C checks -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// When optimization remarks are requested, CodeGen tags each Checked C
+// dynamic check that it emits, and lists the tags in the module.  This pass
+// runs at the end of the optimization pipeline.  It reports a missed
+// optimization for each check that is still in the code, with whether the
+// check is in a loop, and a passed optimization for each check that the
+// optimizer removed.  The remarks go through the usual remark machinery,
+// so -fsave-optimization-record writes them to the YAML record, with their
+// hotness when a profile is used, and the checks that cost the most at run
+// time can be found by sorting the record.
+//
+//===----------------------------------------------------------------------===//
+
+#include "CheckedCCheckRemarks.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+using namespace clang;
+using namespace CodeGen;
+using namespace llvm;
+
+const char clang::CodeGen::CheckedCCheckMDName[] = "checkedc.check";
+const char clang::CodeGen::CheckedCChecksMDName[] = "checkedc.checks";
+const char clang::CodeGen::CheckedCCheckRemarksPassName[] = "checkedc-checks";
+
+namespace {
+  /// The fields of the tag of a check.
+  struct CheckTag {
+    StringRef Kind = "dynamic";
+    StringRef Origin;
+    DebugLoc Loc;
+    Function *F = nullptr;
+  };
+}
+
+static CheckTag getCheckTag(const MDNode *Tag) {
+  CheckTag Info;
+  if (Tag->getNumOperands() != 4)
+    return Info;
+  if (MDString *Kind = dyn_cast_or_null<MDString>(Tag->getOperand(0).get()))
+    Info.Kind = Kind->getString();
+  if (MDString *Origin = dyn_cast_or_null<MDString>(Tag->getOperand(1).get()))
+    Info.Origin = Origin->getString();
+  Info.Loc = DebugLoc(dyn_cast_or_null<DILocation>(Tag->getOperand(2).get()));
+  // The operand is cleared if the function is deleted.
+  if (ValueAsMetadata *F =
+          dyn_cast_or_null<ValueAsMetadata>(Tag->getOperand(3).get()))
+    Info.F = dyn_cast<Function>(F->getValue());
+  return Info;
+}
+
+/// Add how CodeGen placed the check to \p R, unless it was emitted at the
+/// access that it checks.
+static void addOrigin(DiagnosticInfoOptimizationBase &R, const CheckTag &Info) {
+  if (!Info.Origin.empty() && Info.Origin != "access")
+    R << " (" << ore::NV("Origin", Info.Origin) << ")";
+}
+
+bool clang::CodeGen::emitCheckedCCheckRemarks(Module &M) {
+  NamedMDNode *Checks = M.getNamedMetadata(CheckedCChecksMDName);
+  if (!Checks)
+    return false;
+
+  // The checks left in the code.  Copies of a check, made for example by
+  // inlining or unrolling, share its tag and are reported one by one.
+  SmallPtrSet<const MDNode *, 32> Kept;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    SmallVector<Instruction *, 16> Tagged;
+    for (Instruction &I : instructions(F))
+      if (I.getMetadata(CheckedCCheckMDName))
+        Tagged.push_back(&I);
+    if (Tagged.empty())
+      continue;
+
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+    OptimizationRemarkEmitter ORE(&F);
+    for (Instruction *I : Tagged) {
+      const MDNode *Tag = I->getMetadata(CheckedCCheckMDName);
+      Kept.insert(Tag);
+      CheckTag Info = getCheckTag(Tag);
+      OptimizationRemarkMissed R(CheckedCCheckRemarksPassName,
+                                 "CheckNotRemoved",
+                                 Info.Loc ? Info.Loc : I->getDebugLoc(),
+                                 I->getParent());
+      R << ore::NV("Kind", Info.Kind) << " check";
+      if (Loop *L = LI.getLoopFor(I->getParent()))
+        R << " in a loop of depth " << ore::NV("LoopDepth", L->getLoopDepth());
+      R << " was not removed";
+      addOrigin(R, Info);
+      ORE.emit(R);
+    }
+  }
+
+  // The checks that are no longer in the code, and whose function still
+  // is, were removed by the optimizer.  The checks of a function that was
+  // deleted, for example after being inlined everywhere, went away with it.
+  DenseMap<Function *, std::unique_ptr<OptimizationRemarkEmitter>> OREs;
+  for (const MDNode *Tag : Checks->operands()) {
+    if (Kept.count(Tag))
+      continue;
+    CheckTag Info = getCheckTag(Tag);
+    if (!Info.F || Info.F->isDeclaration())
+      continue;
+    std::unique_ptr<OptimizationRemarkEmitter> &ORE = OREs[Info.F];
+    if (!ORE)
+      ORE.reset(new OptimizationRemarkEmitter(Info.F));
+    OptimizationRemark R(CheckedCCheckRemarksPassName, "CheckRemoved",
+                         Info.Loc, &Info.F->getEntryBlock());
+    R << ore::NV("Kind", Info.Kind) << " check was removed by optimization";
+    addOrigin(R, Info);
+    ORE->emit(R);
+  }
+  return false;
+}
+
+namespace {
+  class CheckedCCheckRemarks : public ModulePass {
+  public:
+    static char ID;
+
+    CheckedCCheckRemarks() : ModulePass(ID) {}
+
+    bool runOnModule(Module &M) override {
+      return emitCheckedCCheckRemarks(M);
+    }
+
+    void getAnalysisUsage(AnalysisUsage &AU) const override {
+      AU.setPreservesAll();
+    }
+
+    StringRef getPassName() const override {
+      return "Checked C check remarks";
+    }
+  };
+}
+
+char CheckedCCheckRemarks::ID = 0;
+
+ModulePass *clang::CodeGen::createCheckedCCheckRemarksPass() {
+  return new CheckedCCheckRemarks();
+}
+
+PreservedAnalyses CheckedCCheckRemarksPass::run(Module &M,
+                                                ModuleAnalysisManager &AM) {
+  emitCheckedCCheckRemarks(M);
+  return PreservedAnalyses::all();
+}
@@ -0,0 +1,69 @@
+//===--- CheckedCCheckRemarks.h - Remarks on Checked C checks ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the pass that reports, as optimization remarks of the
+// checkedc-checks pass, which Checked C dynamic checks emitted by CodeGen
+// survived optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_CODEGEN_CHECKEDCCHECKREMARKS_H
+#define LLVM_CLANG_LIB_CODEGEN_CHECKEDCCHECKREMARKS_H
+
+#include "llvm/IR/PassManager.h"
+
+namespace llvm {
+class Module;
+class ModulePass;
+}
+
+namespace clang {
+namespace CodeGen {
+
+/// The kind of the metadata that tags the branch (or, before late lowering,
+/// the call to __checkedc_bounds_check) of a Checked C dynamic check.  The
+/// tag is a distinct node
+///
+///   !{!"kind", !"origin", DILocation, Function}
+///
+/// where kind is the kind of check, as named by -fcheckedc-check-profile,
+/// origin is how CodeGen placed the check ("access", "hoisted",
+/// "coalesced", "versioned" or "combined"), the location is that of the
+/// checked expression and the function is the one the check was emitted in.
+/// Passes that copy a check copy its tag.
+extern const char CheckedCCheckMDName[];
+
+/// The name of the named metadata that lists the tags of all of the checks
+/// emitted by CodeGen, so that the checks removed by optimization can be
+/// found.
+extern const char CheckedCChecksMDName[];
+
+/// The name that the remarks are reported under, as in
+/// -Rpass-missed=checkedc-checks.
+extern const char CheckedCCheckRemarksPassName[];
+
+/// Report a missed-optimization remark for each tagged check left in \p M,
+/// and a remark for each check that optimization removed.  Returns false,
+/// as \p M is not changed.
+bool emitCheckedCCheckRemarks(llvm::Module &M);
+
+/// Create the legacy pass manager version of the remarks pass.
+llvm::ModulePass *createCheckedCCheckRemarksPass();
+
+/// The new pass manager version of the remarks pass.
+class CheckedCCheckRemarksPass
+    : public llvm::PassInfoMixin<CheckedCCheckRemarksPass> {
+public:
+  llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &AM);
+};
+
+} // end namespace CodeGen
+} // end namespace clang
+
+#endif
@@ -41,6 +41,7 @@
 
 namespace llvm {
 class BasicBlock;
+class GEPOperator;
 class LLVMContext;
 class MDNode;
 class Module;
@@ -1183,6 +1184,9 @@ private:
   llvm::MDNode *createProfileWeights(ArrayRef<uint64_t> Weights);
   llvm::MDNode *createProfileWeightsForLoop(const Stmt *Cond,
                                             uint64_t LoopCount);
+  /// Calculate branch weights for a Checked C dynamic check, which is
+  /// expected to pass.
+  llvm::MDNode *createProfileWeightsForDynamicCheck();
 
 public:
   /// Increment the profiler's counter for the given statement by \p StepV.
@@ -1237,6 +1241,119 @@ private:
   // enter/leave scopes.
   llvm::DenseMap<const Expr*, llvm::Value*> VLASizeMap;
 
+  /// HoistedBoundsChecks - The Checked C memory accesses and dynamic bounds
+  /// casts whose dynamic checks are emitted elsewhere, in the preheader of
+  /// an enclosing loop, before a run of statements or combined with another
+  /// check, so no check needs to be emitted when the expression itself is
+  /// emitted.
+  llvm::SmallPtrSet<const Expr *, 8> HoistedBoundsChecks;
+
+  /// CheckedCAddressTakenVars - The local variables whose address is taken
+  /// somewhere in the current function.  Computed lazily when hoisting
+  /// Checked C bounds checks.
+  llvm::SmallPtrSet<const VarDecl *, 8> CheckedCAddressTakenVars;
+  bool CheckedCAddressTakenVarsComputed = false;
+
+  /// KnownNonNullValues - The pointer values that Checked C non-null checks
+  /// have already proven non-null.  The set is only valid in
+  /// KnownNonNullBlock, which is dominated by all of those checks, and is
+  /// discarded when code is emitted into any other block.
+  llvm::SmallPtrSet<llvm::Value *, 8> KnownNonNullValues;
+  llvm::BasicBlock *KnownNonNullBlock = nullptr;
+
+  /// DeferredOverflowCheckExpr - The pointer arithmetic whose Checked C
+  /// overflow check is combined with the bounds check of the dereference of
+  /// its result.  PendingOverflowCheck is the condition that the arithmetic
+  /// did not overflow, once it has been emitted and until the bounds check
+  /// takes it.
+  const Expr *DeferredOverflowCheckExpr = nullptr;
+  llvm::Value *PendingOverflowCheck = nullptr;
+
+  /// EmittingCheckedCBounds - Set while the declared bounds of a Checked C
+  /// bounds check are emitted.  They describe memory that exists, so their
+  /// pointer arithmetic does not overflow and is not checked.
+  bool EmittingCheckedCBounds = false;
+
+public:
+  /// \brief The values emitted for the member expressions, and for the bases
+  /// of arrow member expressions, of a Checked C memory access.  The bounds
+  /// of a member are built from the same base expressions as the access, as
+  /// in s->buf[i] with buf : count(s->len), so its bounds check reuses the
+  /// loads of the access instead of evaluating the base again.  This binds
+  /// the shared expressions in the way OpaqueValueMapping binds opaque
+  /// values.
+  struct SharedBoundsValues {
+    struct ArrowBase {
+      Address Addr;
+      LValueBaseInfo BaseInfo;
+      TBAAAccessInfo TBAAInfo;
+    };
+    llvm::DenseMap<const Expr *, ArrowBase> ArrowBases;
+    llvm::DenseMap<const Expr *, llvm::Value *> MemberValues;
+  };
+
+  /// SharedBounds - The shared values of the memory access being emitted
+  /// with a bounds check, or null.
+  SharedBoundsValues *SharedBounds = nullptr;
+
+  /// \brief Share the evaluation of the member bases of a Checked C memory
+  /// access with its bounds check while in scope, if the access has a range
+  /// bounds check.  Values are only recorded outside conditional branches,
+  /// so that they dominate the check.  The accesses nested in an access,
+  /// such as the member base checks of its base, record their values with
+  /// those of the outermost access, whose check is emitted last.
+  class SharedBoundsScope {
+    CodeGenFunction &CGF;
+    SharedBoundsValues *Saved;
+    SharedBoundsValues Values;
+    bool Active;
+
+  public:
+    SharedBoundsScope(CodeGenFunction &CGF, const BoundsExpr *Bounds,
+                      bool Checked)
+        : CGF(CGF), Saved(CGF.SharedBounds),
+          Active(!Saved && Checked && Bounds && isa<RangeBoundsExpr>(Bounds)) {
+      if (Active)
+        CGF.SharedBounds = &Values;
+    }
+    ~SharedBoundsScope() {
+      if (Active)
+        CGF.SharedBounds = Saved;
+    }
+    SharedBoundsScope(const SharedBoundsScope &) = delete;
+    SharedBoundsScope &operator=(const SharedBoundsScope &) = delete;
+  };
+
+  /// DynamicCheckLoc - The location of the expression whose Checked C
+  /// dynamic checks are being emitted.  With -fcheckedc-check-profile, the
+  /// execution counters of the checks are keyed by it.
+  SourceLocation DynamicCheckLoc;
+
+  /// DynamicCheckOrigin - How the Checked C dynamic checks being emitted
+  /// were placed: "access" for checks at the accesses they check, or the
+  /// optimization that moved or combined them.  Recorded in the tags of the
+  /// checks for the checkedc-checks remarks.
+  const char *DynamicCheckOrigin = "access";
+
+  /// \brief The kinds of Checked C dynamic checks.  With
+  /// -fcheckedc-trap-blocks=kind, checks of different kinds branch to
+  /// different failure blocks.  The values are also the kinds recorded by
+  /// -fcheckedc-check-profile, which runtime/checkedc/CheckProfile.c names.
+  enum DynamicCheckKind {
+    DCK_Explicit,
+    DCK_NonNull,
+    DCK_Range,
+    DCK_Cast,
+    DCK_Overflow,
+    DCK_NumKinds
+  };
+
+private:
+  /// DynamicCheckFailedBlocks - The failure blocks shared by the Checked C
+  /// dynamic checks in this function, indexed by DynamicCheckKind.  Only
+  /// used with -fcheckedc-trap-blocks=kind or =function.
+  llvm::BasicBlock *DynamicCheckFailedBlocks[DCK_NumKinds] = {};
+
   /// A block containing a single 'unreachable' instruction.  Created
   /// lazily by getUnreachableBlock().
   llvm::BasicBlock *UnreachableBlock;
@@ -2512,6 +2629,14 @@ public:
   };
   AutoVarEmission EmitAutoVarAlloca(const VarDecl &var);
   void EmitAutoVarInit(const AutoVarEmission &emission);
+
+  /// Initialize the \p Size bytes at \p Loc with \p Init, a constant
+  /// aggregate: with a memset and a few stores if it is mostly zero, and
+  /// otherwise with a memcpy from a private global, which is named after \p D
+  /// if it is the initializer of a variable.
+  void EmitConstantAggregateInit(Address Loc, CharUnits Size,
+                                 llvm::Constant *Init, bool IsVolatile,
+                                 const VarDecl *D = nullptr);
   void EmitAutoVarCleanups(const AutoVarEmission &emission);  
   void emitAutoVarTypeCleanup(const AutoVarEmission &emission,
                               QualType::DestructionKind dtorKind);
@@ -2612,6 +2737,8 @@ public:
   void EmitDoStmt(const DoStmt &S, ArrayRef<const Attr *> Attrs = None);
   void EmitForStmt(const ForStmt &S,
                    ArrayRef<const Attr *> Attrs = None);
+  void EmitForStmtLoop(const ForStmt &S, ArrayRef<const Attr *> ForAttrs,
+                       JumpDest LoopExit, bool ForScopeRequiresCleanups);
   void EmitReturnStmt(const ReturnStmt &S);
   void EmitDeclStmt(const DeclStmt &S);
   void EmitBreakStmt(const BreakStmt &S);
@@ -2624,17 +2751,111 @@ public:
 
   void EmitExplicitDynamicCheck(const Expr *Condition);
   void EmitDynamicNonNullCheck(const Address BaseAddr, const QualType BaseTy);
-  void EmitDynamicOverflowCheck(const Address BaseAddr, const QualType BaseTy,
-                                const Address PtrAddr);
+  /// \brief With -fcheckedc-overflow-checks, check that Result, the GEP
+  /// emitted for the pointer arithmetic E on a checked array pointer, did
+  /// not overflow.  If E is DeferredOverflowCheckExpr, the condition is left
+  /// in PendingOverflowCheck for the bounds check of the dereference.
+  void EmitDynamicOverflowCheck(const Expr *E, llvm::Value *Result,
+                                bool SignedIndices, bool IsSubtraction);
+  /// \brief Emit the overflow check left in PendingOverflowCheck, if the
+  /// bounds check that it was deferred to did not take it.
+  void EmitPendingOverflowCheck();
   /// \brief Emit a dynamic bounds check.  ValueToStore is optional and is
   /// used for bounds checking writes to NUL-terminated pointers.
   void EmitDynamicBoundsCheck(const Address PtrAddr, const BoundsExpr *Bounds,
                               BoundsCheckKind Kind, llvm::Value *ValueToStore);
+  /// \brief Emit the dynamic bounds check of the array subscript E, whose
+  /// index is Index as an intptr_t, as one comparison of the index with the
+  /// count of its bounds.  Returns false, without emitting anything, if the
+  /// bounds are not count bounds of the base of E.
+  bool EmitDynamicIndexBoundsCheck(const ArraySubscriptExpr *E,
+                                   llvm::Value *Index);
   void EmitDynamicBoundsCastCheck(const Address BaseAddr,
                                   const BoundsExpr *CastBounds,
                                   const BoundsExpr *SubExprBounds);
-  void EmitDynamicCheckBlocks(llvm::Value *Condition);
-  llvm::BasicBlock *EmitDynamicCheckFailedBlock();
+  /// \brief Emit a value that is true if the bounds CastRange of a dynamic
+  /// bounds cast are within the bounds SubRange of the expression cast.
+  llvm::Value *EmitDynamicBoundsCastCondition(const RangeBoundsExpr *SubRange,
+                                              const RangeBoundsExpr *CastRange);
+  /// \brief If S sets a local checked pointer variable to a dynamic bounds
+  /// cast and Next accesses memory through the variable, emit S and then a
+  /// single check for the cast and the accesses.  The accesses are added to
+  /// Subsumed and to HoistedBoundsChecks.  Returns false, without emitting
+  /// anything, if S is not emitted this way.
+  bool EmitSubsumedBoundsCastCheck(const Stmt *S, const Stmt *Next,
+                                   SmallVectorImpl<const Expr *> &Subsumed);
+  /// \brief Emit, in the preheader of the loop S, the dynamic checks for
+  /// array subscripts in the loop body whose bounds are loop-invariant and
+  /// whose index is an affine function of the loop induction variable.
+  /// The subscripts whose checks were hoisted are added to Hoisted and to
+  /// HoistedBoundsChecks.
+  void EmitHoistedBoundsChecks(const ForStmt &S,
+                               SmallVectorImpl<const Expr *> &Hoisted);
+  /// \brief Emit, in the preheader of the loop S, a test that the dynamic
+  /// checks for array subscripts in the loop body whose index is the loop
+  /// induction variable succeed on every iteration.  If the test is emitted,
+  /// the insertion point is left where the loop without those checks should
+  /// be emitted, the subscripts are added to Unchecked and to
+  /// HoistedBoundsChecks, and the block to emit the checked loop in is
+  /// returned.  Otherwise, returns null.
+  llvm::BasicBlock *EmitLoopVersionTest(const ForStmt &S,
+                                        SmallVectorImpl<const Expr *> &Unchecked);
+  /// \brief Emit together the dynamic checks for the accesses in the leading
+  /// statements of Stmts that contain no control flow, coalescing checks of
+  /// the same base and bounds at constant offsets into one check.  The
+  /// accesses whose checks were emitted are added to Coalesced and to
+  /// HoistedBoundsChecks.  Returns the number of statements covered.
+  unsigned EmitCoalescedBoundsChecks(ArrayRef<const Stmt *> Stmts,
+                                     SmallVectorImpl<const Expr *> &Coalesced);
+  void ComputeCheckedCAddressTakenVars();
+  /// \brief Emit a dynamic check that the range of addresses [First, Last]
+  /// lies within Bounds.
+  void EmitDynamicBoundsRangeCheck(const Address First, const Address Last,
+                                   const RangeBoundsExpr *Bounds,
+                                   BoundsCheckKind Kind);
+  /// \brief Emit a value that is true if the range of addresses
+  /// [First, Last] lies within Bounds.
+  llvm::Value *EmitDynamicBoundsRangeCondition(const Address First,
+                                               const Address Last,
+                                               const RangeBoundsExpr *Bounds,
+                                               BoundsCheckKind Kind);
+  /// \brief Emit a call to __checkedc_bounds_check for the range of Size
+  /// bytes at PtrAddr, to be expanded late by the LLVM pass pipeline.
+  void EmitDynamicBoundsCheckCall(const Address PtrAddr, const Address Lower,
+                                  const Address Upper, uint64_t Size);
+  /// \brief With -fcheckedc-check-profile, increment the execution counter
+  /// of the dynamic check of the given kind at DynamicCheckLoc.
+  void EmitDynamicCheckProfileCounter(DynamicCheckKind Kind);
+  /// \brief When optimization remarks are requested, tag Check, the branch
+  /// or call of a dynamic check of the given kind at DynamicCheckLoc, so
+  /// that the checkedc-checks remarks can report whether it survived
+  /// optimization.
+  void TagDynamicCheck(llvm::Instruction *Check, DynamicCheckKind Kind);
+  /// \brief With -fcheckedc-asan-skip-checked-accesses, mark LV, an access
+  /// that Checked C checks against Bounds statically or at runtime, so that
+  /// its loads and stores are not instrumented by AddressSanitizer.
+  void MarkCheckedCInBounds(LValue &LV, const BoundsExpr *Bounds);
+  /// \brief Keep AddressSanitizer from instrumenting Access, a load or store
+  /// of an lvalue marked by MarkCheckedCInBounds.
+  void DisableAddressSanitizerForAccess(llvm::Instruction *Access);
+  /// \brief Return the number of bytes that a non-null pointer of the
+  /// Checked C type Ty, with the declared bounds Bounds, can be dereferenced
+  /// at, or 0 if that is not a constant.
+  uint64_t getCheckedCDereferenceableBytes(QualType Ty,
+                                           const BoundsExpr *Bounds);
+  /// \brief With -fcheckedc-dereferenceable-bounds, tell LLVM how many bytes
+  /// the pointer loaded by Load, of type Ty, can be dereferenced at.
+  void EmitCheckedCDereferenceableMetadata(llvm::LoadInst *Load, QualType Ty);
+  /// \brief With -fcheckedc-dereferenceable-bounds, tell LLVM how many bytes
+  /// the checked pointer parameter PVD, passed as Arg, can be dereferenced
+  /// at.
+  void AddCheckedCDereferenceableAttr(llvm::Argument *Arg,
+                                      const ParmVarDecl *PVD);
+  void EmitDynamicCheckBlocks(llvm::Value *Condition, DynamicCheckKind Kind);
+  /// \brief Return the block that a failed dynamic check of the given kind
+  /// branches to.  Depending on -fcheckedc-trap-blocks, this is either a new
+  /// block or one shared with other checks in the function.
+  llvm::BasicBlock *EmitDynamicCheckFailedBlock(DynamicCheckKind Kind);
   llvm::BasicBlock *EmitNulltermWriteAdditionalCheck(const Address PtrAddr,
                                                      const Address Upper,
                                                      llvm::Value *LowerChk,
@@ -3119,7 +3340,8 @@ public:
   llvm::Value *EmitLoadOfScalar(Address Addr, bool Volatile, QualType Ty,
                                 SourceLocation Loc, LValueBaseInfo BaseInfo,
                                 TBAAAccessInfo TBAAInfo,
-                                bool isNontemporal = false);
+                                bool isNontemporal = false,
+                                bool isCheckedCInBounds = false);
 
   /// EmitLoadOfScalar - Load a scalar value from an address, taking
   /// care to appropriately convert from the memory representation to
@@ -3141,7 +3363,8 @@ public:
   void EmitStoreOfScalar(llvm::Value *Value, Address Addr,
                          bool Volatile, QualType Ty,
                          LValueBaseInfo BaseInfo, TBAAAccessInfo TBAAInfo,
-                         bool isInit = false, bool isNontemporal = false);
+                         bool isInit = false, bool isNontemporal = false,
+                         bool isCheckedCInBounds = false);
 
   /// EmitStoreOfScalar - Store a scalar value to an address, taking
   /// care to appropriately convert from the memory representation to
@@ -3710,6 +3933,16 @@ public:
                                       SourceLocation Loc,
                                       const Twine &Name = "");
 
+  /// Return a condition that is true if the address computed by \p GEP does
+  /// not overflow, or null if the GEP adds nothing to its base.  \p IntPtr
+  /// and \p ComputedGEP are set to the base and the computed address as
+  /// integers.
+  llvm::Value *EmitPointerArithmeticNoOverflow(llvm::GEPOperator *GEP,
+                                               bool SignedIndices,
+                                               bool IsSubtraction,
+                                               llvm::Value *&IntPtr,
+                                               llvm::Value *&ComputedGEP);
+
   /// Specifies which type of sanitizer check to apply when handling a
   /// particular builtin.
   enum BuiltinCheckKind {
@@ -368,6 +368,15 @@ private:
   /// Map used to get unique annotation strings.
   llvm::StringMap<llvm::Constant*> AnnotationStrings;
 
+  /// The execution counters of the Checked C dynamic checks in this module,
+  /// keyed by the raw expansion location and kind of the check.  Only used
+  /// with -fcheckedc-check-profile.
+  llvm::DenseMap<std::pair<unsigned, unsigned>, llvm::GlobalVariable *>
+    CheckedCCheckCounters;
+
+  /// The records of the Checked C check profile table, one per counter.
+  std::vector<llvm::Constant *> CheckedCCheckProfileRecords;
+
   llvm::StringMap<llvm::GlobalVariable *> CFConstantStringMap;
 
   llvm::DenseMap<llvm::Constant *, llvm::GlobalVariable *> ConstantStringMap;
@@ -658,6 +667,10 @@ public:
   /// the given type.
   llvm::MDNode *getTBAATypeInfo(QualType QTy);
 
+  /// getTBAAFieldTypeInfo - Get metadata used to describe accesses to the
+  /// given member.
+  llvm::MDNode *getTBAAFieldTypeInfo(const FieldDecl *FD);
+
   /// getTBAAAccessInfo - Get TBAA information that describes an access to
   /// an object of the given type.
   TBAAAccessInfo getTBAAAccessInfo(QualType AccessType);
@@ -943,6 +956,11 @@ public:
     CXXGlobalDtors.emplace_back(DtorFn, Object);
   }
 
+  /// Return the execution counter for the Checked C dynamic check of the
+  /// given kind at Loc, creating it and its profile record if needed.
+  llvm::GlobalVariable *getCheckedCCheckCounter(SourceLocation Loc,
+                                                unsigned Kind);
+
   /// Create a new runtime function with the specified type and name.
   llvm::Constant *
   CreateRuntimeFunction(llvm::FunctionType *Ty, StringRef Name,
@@ -1331,6 +1349,10 @@ private:
   /// \brief Emit the link options introduced by imported modules.
   void EmitModuleLinkOptions();
 
+  /// Emit the table of Checked C dynamic check counters and the constructor
+  /// that registers it with the check profile runtime.
+  void EmitCheckedCCheckProfile();
+
   /// \brief Emit aliases for internal-linkage declarations inside "C" language
   /// linkage specifications, giving them the "expected" name where possible.
   void EmitStaticExternCAliases();
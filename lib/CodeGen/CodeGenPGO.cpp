@@ -21,6 +21,8 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MD5.h"
+#include "llvm/Support/ManagedStatic.h"
+#include <mutex>
 
 static llvm::cl::opt<bool> EnableValueProfiling(
   "enable-value-profiling", llvm::cl::ZeroOrMore,
@@ -898,6 +900,103 @@ CodeGenFunction::createProfileWeights(ArrayRef<uint64_t> Weights) {
   return MDHelper.createBranchWeights(ScaledWeights);
 }
 
+llvm::MDNode *CodeGenFunction::createProfileWeightsForDynamicCheck() {
+  // A failed Checked C dynamic check traps, so a profiled run never records
+  // a failure and the check executes as often as the code around it.
+  if (PGO.haveRegionCounts())
+    if (uint64_t Count = getCurrentProfileCount())
+      return createProfileWeights(Count, 0);
+
+  // Otherwise, give the hint that we very much don't expect the check to
+  // fail.  Value chosen to match UR_NONTAKEN_WEIGHT, see
+  // BranchProbabilityInfo.cpp.
+  llvm::MDBuilder MDHelper(CGM.getLLVMContext());
+  return MDHelper.createBranchWeights((1U << 20) - 1, 1);
+}
+
+namespace {
+/// The profile readers released by translation units that are done, for
+/// the next ones in the same process.  A reader is used by one translation
+/// unit at a time, so a reader that is acquired leaves the cache until it is
+/// released.
+struct IndexedProfileReaderCache {
+  struct Entry {
+    std::string Path;
+    llvm::sys::fs::file_status Status;
+    std::unique_ptr<llvm::IndexedInstrProfReader> Reader;
+  };
+
+  /// The number of readers kept.  Each keeps its profile mapped.
+  static const unsigned MaxEntries = 2;
+
+  std::mutex Lock;
+  std::vector<Entry> Entries;
+  /// The status of the file of each acquired reader when it was opened.
+  llvm::DenseMap<const llvm::IndexedInstrProfReader *,
+                 llvm::sys::fs::file_status> Acquired;
+};
+} // end anonymous namespace
+
+static llvm::ManagedStatic<IndexedProfileReaderCache> ProfileReaderCache;
+
+/// Return true if a reader opened when \p Old was the status of its file can
+/// be used now that the status is \p New.
+static bool isSameProfileFile(const llvm::sys::fs::file_status &Old,
+                              const llvm::sys::fs::file_status &New) {
+  return Old.getUniqueID() == New.getUniqueID() &&
+         Old.getSize() == New.getSize() &&
+         Old.getLastModificationTime() == New.getLastModificationTime();
+}
+
+llvm::Expected<std::unique_ptr<llvm::IndexedInstrProfReader>>
+CodeGen::acquireIndexedProfileReader(StringRef Path) {
+  // Without a status, the reader reports why the file cannot be read.
+  llvm::sys::fs::file_status Status;
+  if (llvm::sys::fs::status(Path, Status))
+    return llvm::IndexedInstrProfReader::create(Path);
+
+  IndexedProfileReaderCache &Cache = *ProfileReaderCache;
+  {
+    std::lock_guard<std::mutex> Guard(Cache.Lock);
+    for (auto I = Cache.Entries.begin(), E = Cache.Entries.end(); I != E;
+         ++I) {
+      if (I->Path != Path || !isSameProfileFile(I->Status, Status))
+        continue;
+      std::unique_ptr<llvm::IndexedInstrProfReader> Reader =
+          std::move(I->Reader);
+      Cache.Entries.erase(I);
+      Cache.Acquired[Reader.get()] = Status;
+      return std::move(Reader);
+    }
+  }
+
+  auto ReaderOrErr = llvm::IndexedInstrProfReader::create(Path);
+  if (ReaderOrErr) {
+    std::lock_guard<std::mutex> Guard(Cache.Lock);
+    Cache.Acquired[ReaderOrErr->get()] = Status;
+  }
+  return ReaderOrErr;
+}
+
+void CodeGen::releaseIndexedProfileReader(
+    StringRef Path, std::unique_ptr<llvm::IndexedInstrProfReader> Reader) {
+  if (!Reader)
+    return;
+
+  IndexedProfileReaderCache &Cache = *ProfileReaderCache;
+  std::lock_guard<std::mutex> Guard(Cache.Lock);
+  auto Acquired = Cache.Acquired.find(Reader.get());
+  if (Acquired == Cache.Acquired.end())
+    return;
+  llvm::sys::fs::file_status Status = Acquired->second;
+  Cache.Acquired.erase(Acquired);
+
+  // The oldest reader goes first.
+  if (Cache.Entries.size() >= IndexedProfileReaderCache::MaxEntries)
+    Cache.Entries.erase(Cache.Entries.begin());
+  Cache.Entries.push_back({Path, Status, std::move(Reader)});
+}
+
 llvm::MDNode *CodeGenFunction::createProfileWeightsForLoop(const Stmt *Cond,
                                                            uint64_t LoopCount) {
   if (!PGO.haveRegionCounts())
@@ -115,6 +115,20 @@ public:
   }
 };
 
+/// Open the indexed profile at \p Path for a translation unit.  The reader
+/// maps the profile and reads its header and summary; the records of
+/// functions are read from the mapped file when they are looked up.  When
+/// several translation units are compiled in one process, a reader that an
+/// earlier one released is reused, as long as the file has not changed, so
+/// the profile is only opened once.
+llvm::Expected<std::unique_ptr<llvm::IndexedInstrProfReader>>
+acquireIndexedProfileReader(StringRef Path);
+
+/// Give back a reader from acquireIndexedProfileReader once the translation
+/// unit that used it is done.
+void releaseIndexedProfileReader(
+    StringRef Path, std::unique_ptr<llvm::IndexedInstrProfReader> Reader);
+
 }  // end namespace CodeGen
 }  // end namespace clang
 
@@ -18,6 +18,7 @@
 #include "CodeGenTBAA.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Attr.h"
+#include "clang/AST/Expr.h"
 #include "clang/AST/Mangle.h"
 #include "clang/AST/RecordLayout.h"
 #include "clang/Frontend/CodeGenOptions.h"
@@ -33,7 +34,8 @@ CodeGenTBAA::CodeGenTBAA(ASTContext &Ctx, llvm::LLVMContext& VMContext,
                          const CodeGenOptions &CGO,
                          const LangOptions &Features, MangleContext &MContext)
   : Context(Ctx), CodeGenOpts(CGO), Features(Features), MContext(MContext),
-    MDHelper(VMContext), Root(nullptr), Char(nullptr) {
+    MDHelper(VMContext), Root(nullptr), Char(nullptr),
+    BoundsMember(nullptr) {
 }
 
 CodeGenTBAA::~CodeGenTBAA() {
@@ -72,6 +74,41 @@ llvm::MDNode *CodeGenTBAA::getChar() {
   return Char;
 }
 
+/// Add the members of \p RD that \p E refers to by name to \p Members.
+static void collectBoundsMemberUses(const Stmt *E, const RecordDecl *RD,
+                                    llvm::DenseSet<const FieldDecl *> &Members) {
+  if (!E)
+    return;
+  if (const DeclRefExpr *DR = dyn_cast<DeclRefExpr>(E))
+    if (const FieldDecl *FD = dyn_cast<FieldDecl>(DR->getDecl()))
+      if (FD->getParent() == RD)
+        Members.insert(FD->getCanonicalDecl());
+  for (const Stmt *Child : E->children())
+    collectBoundsMemberUses(Child, RD, Members);
+}
+
+bool CodeGenTBAA::isBoundsMember(const FieldDecl *FD) {
+  if (!Features.CheckedC || !FD->getType()->isScalarType())
+    return false;
+
+  // Checked C rejects taking the address of a member used in the bounds of a
+  // checked or integral member of its struct, in checked and unchecked code
+  // alike (see CheckedCAlias.cpp). Members used only in bounds-safe
+  // interfaces can still have their address taken in unchecked code.
+  const RecordDecl *RD = FD->getParent();
+  if (BoundsMemberRecords.insert(RD).second) {
+    for (const FieldDecl *Member : RD->fields()) {
+      QualType MemberTy = Member->getType();
+      if (Member->hasBoundsExpr() &&
+          (MemberTy->isCheckedPointerType() ||
+           MemberTy->isCheckedArrayType() ||
+           MemberTy->isIntegralType(Context)))
+        collectBoundsMemberUses(Member->getBoundsExpr(), RD, BoundsMembers);
+    }
+  }
+  return BoundsMembers.count(FD->getCanonicalDecl());
+}
+
 static bool TypeHasMayAlias(QualType QTy) {
   // Tagged types have declarations, and therefore may have attributes.
   if (const TagType *TTy = dyn_cast<TagType>(QTy))
@@ -198,6 +235,18 @@ llvm::MDNode *CodeGenTBAA::getTypeInfo(QualType QTy) {
   return MetadataCache[Ty] = getChar();
 }
 
+llvm::MDNode *CodeGenTBAA::getFieldTypeInfo(const FieldDecl *FD) {
+  llvm::MDNode *N = getTypeInfo(FD->getType());
+  // Members that are not accessed with their own type keep it, so that
+  // accesses with char types still alias them.
+  if (!N || N == getChar() || !isBoundsMember(FD))
+    return N;
+
+  if (!BoundsMember)
+    BoundsMember = createTBAAScalarType("checked bounds member", getChar());
+  return BoundsMember;
+}
+
 TBAAAccessInfo CodeGenTBAA::getVTablePtrAccessInfo() {
   return TBAAAccessInfo(createTBAAScalarType("vtable pointer", getRoot()));
 }
@@ -228,6 +277,14 @@ CodeGenTBAA::CollectFields(uint64_t BaseOffset,
       uint64_t Offset = BaseOffset +
                         Layout.getFieldOffset(idx) / Context.getCharWidth();
       QualType FieldQTy = i->getType();
+      if (!MayAlias && !TypeHasMayAlias(FieldQTy) && isBoundsMember(*i)) {
+        uint64_t Size = Context.getTypeSizeInChars(FieldQTy).getQuantity();
+        llvm::MDNode *TBAATag =
+            getAccessTagInfo(TBAAAccessInfo(getFieldTypeInfo(*i)));
+        Fields.push_back(
+            llvm::MDBuilder::TBAAStructField(Offset, Size, TBAATag));
+        continue;
+      }
       if (!CollectFields(Offset, FieldQTy, Fields,
                          MayAlias || TypeHasMayAlias(FieldQTy)))
         return false;
@@ -277,7 +334,7 @@ llvm::MDNode *CodeGenTBAA::getBaseTypeInfo(QualType QTy) {
          e = RD->field_end(); i != e; ++i, ++idx) {
       QualType FieldQTy = i->getType();
       llvm::MDNode *FieldNode = isValidBaseType(FieldQTy) ?
-          getBaseTypeInfo(FieldQTy) : getTypeInfo(FieldQTy);
+          getBaseTypeInfo(FieldQTy) : getFieldTypeInfo(*i);
       if (!FieldNode)
         return BaseTypeMetadataCache[Ty] = nullptr;
       Fields.push_back(std::make_pair(
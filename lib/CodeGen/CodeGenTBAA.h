@@ -18,15 +18,18 @@
 #include "clang/AST/Type.h"
 #include "clang/Basic/LLVM.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Metadata.h"
 
 namespace clang {
   class ASTContext;
   class CodeGenOptions;
+  class FieldDecl;
   class LangOptions;
   class MangleContext;
   class QualType;
+  class RecordDecl;
   class Type;
 
 namespace CodeGen {
@@ -120,8 +123,14 @@ class CodeGenTBAA {
   /// them for struct assignments.
   llvm::DenseMap<const Type *, llvm::MDNode *> StructMetadataCache;
 
+  /// The Checked C members that are used in the bounds of checked members of
+  /// their struct, and the structs whose members have been looked at.
+  llvm::DenseSet<const FieldDecl *> BoundsMembers;
+  llvm::DenseSet<const RecordDecl *> BoundsMemberRecords;
+
   llvm::MDNode *Root;
   llvm::MDNode *Char;
+  llvm::MDNode *BoundsMember;
 
   /// getRoot - This is the mdnode for the root of the metadata type graph
   /// for this translation unit.
@@ -131,6 +140,11 @@ class CodeGenTBAA {
   /// considered to be equivalent to it.
   llvm::MDNode *getChar();
 
+  /// isBoundsMember - Whether \p FD is a Checked C member that the bounds of a
+  /// checked member of the same struct use. The address of such a member can't
+  /// be taken, so it is only ever accessed as a member of its struct.
+  bool isBoundsMember(const FieldDecl *FD);
+
   /// CollectFields - Collect information about the fields of a type for
   /// !tbaa.struct metadata formation. Return false for an unsupported type.
   bool CollectFields(uint64_t BaseOffset,
@@ -154,6 +168,11 @@ public:
   /// given type.
   llvm::MDNode *getTypeInfo(QualType QTy);
 
+  /// getFieldTypeInfo - Get metadata used to describe accesses to the member
+  /// \p FD. Checked C members used in member bounds get a type of their own,
+  /// which accesses through pointers to their type don't alias.
+  llvm::MDNode *getFieldTypeInfo(const FieldDecl *FD);
+
   /// getVTablePtrAccessInfo - Get the TBAA information that describes an
   /// access to a virtual table pointer.
   TBAAAccessInfo getVTablePtrAccessInfo();
@@ -15,6 +15,7 @@
 #include "CodeGenFunction.h"
 #include "clang/AST/StmtVisitor.h"
 #include "clang/Lex/Lexer.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Optional.h"
@@ -133,6 +134,23 @@ private:
   llvm::SmallDenseMap<FileID, std::pair<unsigned, SourceLocation>, 8>
       FileIDMapping;
 
+  /// \brief Where a file or macro expansion is nested.
+  struct FileNesting {
+    /// \brief The file or expansion that includes or expands it, if any.
+    FileID Parent;
+    /// \brief The number of files and expansions it is nested in.
+    unsigned Depth;
+  };
+
+  /// \brief The nesting of the files and expansions seen so far, so that
+  /// chains of nested macro expansions are walked once rather than once per
+  /// query.
+  llvm::DenseMap<FileID, FileNesting> FileNestings;
+
+  /// \brief The raw start and end locations of the regions in
+  /// \c SourceRegions.
+  llvm::DenseSet<std::pair<unsigned, unsigned>> AddedRegions;
+
 public:
   /// \brief The coverage mapping regions for this function
   llvm::SmallVector<CounterMappingRegion, 32> MappingRegions;
@@ -186,14 +204,46 @@ public:
     return SM.getBufferName(SM.getSpellingLoc(Loc)) == "<built-in>";
   }
 
+  /// \brief Get where \c File is included or expanded, and how deeply.
+  FileNesting getFileNesting(FileID File) {
+    auto Known = FileNestings.find(File);
+    if (Known != FileNestings.end())
+      return Known->second;
+
+    FileNesting Nesting = {FileID(), 0};
+    SourceLocation ParentLoc =
+        getIncludeOrExpansionLoc(SM.getComposedLoc(File, 0));
+    if (ParentLoc.isValid()) {
+      Nesting.Parent = SM.getFileID(ParentLoc);
+      Nesting.Depth = getFileNesting(Nesting.Parent).Depth + 1;
+    }
+    FileNestings[File] = Nesting;
+    return Nesting;
+  }
+
   /// \brief Check whether \c Loc is included or expanded from \c Parent.
   bool isNestedIn(SourceLocation Loc, FileID Parent) {
-    do {
-      Loc = getIncludeOrExpansionLoc(Loc);
-      if (Loc.isInvalid())
-        return false;
-    } while (!SM.isInFileID(Loc, Parent));
-    return true;
+    unsigned ParentDepth = getFileNesting(Parent).Depth;
+    FileNesting Nesting = getFileNesting(SM.getFileID(Loc));
+    if (Nesting.Depth <= ParentDepth)
+      return false;
+    while (Nesting.Depth > ParentDepth + 1)
+      Nesting = getFileNesting(Nesting.Parent);
+    return Nesting.Parent == Parent;
+  }
+
+  /// \brief Add \c Region to the regions of this function.
+  void addSourceRegion(const SourceMappingRegion &Region) {
+    AddedRegions.insert(std::make_pair(Region.getStartLoc().getRawEncoding(),
+                                       Region.getEndLoc().getRawEncoding()));
+    SourceRegions.push_back(Region);
+  }
+
+  /// \brief Check whether a region with bounds \c StartLoc and \c EndLoc
+  /// is already added to \c SourceRegions.
+  bool isRegionAlreadyAdded(SourceLocation StartLoc, SourceLocation EndLoc) {
+    return AddedRegions.count(
+        std::make_pair(StartLoc.getRawEncoding(), EndLoc.getRawEncoding()));
   }
 
   /// \brief Get the start of \c S ignoring macro arguments and builtin macros.
@@ -232,11 +282,7 @@ public:
       if (SM.isInSystemHeader(SM.getSpellingLoc(Loc)))
         continue;
 
-      unsigned Depth = 0;
-      for (SourceLocation Parent = getIncludeOrExpansionLoc(Loc);
-           Parent.isValid(); Parent = getIncludeOrExpansionLoc(Parent))
-        ++Depth;
-      FileLocs.push_back(std::make_pair(Loc, Depth));
+      FileLocs.push_back(std::make_pair(Loc, getFileNesting(File).Depth));
     }
     std::stable_sort(FileLocs.begin(), FileLocs.end(), llvm::less_second());
 
@@ -405,7 +451,7 @@ struct EmptyCoverageMappingBuilder : public CoverageMappingBuilder {
         EndFileID = SM.getFileID(End);
       }
     }
-    SourceRegions.emplace_back(Counter(), Start, End);
+    addSourceRegion(SourceMappingRegion(Counter(), Start, End));
   }
 
   /// \brief Write the mapping data to the output stream
@@ -541,7 +587,8 @@ struct CounterCoverageMappingBuilder
           assert(SM.isWrittenInSameFile(NestedLoc, EndLoc));
 
           if (!isRegionAlreadyAdded(NestedLoc, EndLoc))
-            SourceRegions.emplace_back(Region.getCounter(), NestedLoc, EndLoc);
+            addSourceRegion(
+                SourceMappingRegion(Region.getCounter(), NestedLoc, EndLoc));
 
           EndLoc = getPreciseTokenLocEnd(getIncludeOrExpansionLoc(EndLoc));
           if (EndLoc.isInvalid())
@@ -557,7 +604,7 @@ struct CounterCoverageMappingBuilder
           MostRecentLocation = getIncludeOrExpansionLoc(EndLoc);
 
         assert(SM.isWrittenInSameFile(Region.getStartLoc(), EndLoc));
-        SourceRegions.push_back(Region);
+        addSourceRegion(Region);
 
         if (ParentOfDeferredRegion) {
           ParentOfDeferredRegion = false;
@@ -603,17 +650,6 @@ struct CounterCoverageMappingBuilder
     return ExitCount;
   }
 
-  /// \brief Check whether a region with bounds \c StartLoc and \c EndLoc
-  /// is already added to \c SourceRegions.
-  bool isRegionAlreadyAdded(SourceLocation StartLoc, SourceLocation EndLoc) {
-    return SourceRegions.rend() !=
-           std::find_if(SourceRegions.rbegin(), SourceRegions.rend(),
-                        [&](const SourceMappingRegion &Region) {
-                          return Region.getStartLoc() == StartLoc &&
-                                 Region.getEndLoc() == EndLoc;
-                        });
-  }
-
   /// \brief Adjust the most recently visited location to \c EndLoc.
   ///
   /// This should be used after visiting any statements in non-source order.
@@ -672,8 +708,8 @@ struct CounterCoverageMappingBuilder
         // correct count. We avoid creating redundant regions by stopping once
         // we've seen this region.
         if (StartLocs.insert(Loc).second)
-          SourceRegions.emplace_back(I.getCounter(), Loc,
-                                     getEndOfFileOrMacro(Loc));
+          addSourceRegion(SourceMappingRegion(I.getCounter(), Loc,
+                                              getEndOfFileOrMacro(Loc)));
         Loc = getIncludeOrExpansionLoc(Loc);
       }
       I.setStartLoc(getPreciseTokenLocEnd(Loc));
@@ -687,8 +723,8 @@ struct CounterCoverageMappingBuilder
       while (isNestedIn(Loc, ParentFile)) {
         SourceLocation FileStart = getStartOfFileOrMacro(Loc);
         if (StartLocs.insert(FileStart).second)
-          SourceRegions.emplace_back(*ParentCounter, FileStart,
-                                     getEndOfFileOrMacro(Loc));
+          addSourceRegion(SourceMappingRegion(*ParentCounter, FileStart,
+                                              getEndOfFileOrMacro(Loc)));
         Loc = getIncludeOrExpansionLoc(Loc);
       }
     }
@@ -20,9 +20,12 @@
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Index/USRGeneration.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include <fstream>
@@ -61,6 +64,72 @@ public:
 };
 
 static llvm::ManagedStatic<IndexErrorCategory> Category;
+
+// The binary index starts with a header of the magic number, the version and
+// the offset of the bucket array of the on-disk hash table, which follows.
+const char BinaryIndexMagic[] = {'C', 'T', 'U', 'I'};
+const uint32_t BinaryIndexVersion = 1;
+const size_t BinaryIndexHeaderSize = 12;
+
+/// The traits of the on-disk hash table of the binary index, which maps USRs
+/// to file paths.
+class BinaryIndexInfo {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef data_type;
+  typedef StringRef data_type_ref;
+  typedef StringRef internal_key_type;
+  typedef StringRef external_key_type;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+  static hash_value_type ComputeHash(internal_key_type Key) {
+    return llvm::HashString(Key);
+  }
+  static internal_key_type GetInternalKey(external_key_type Key) {
+    return Key;
+  }
+  static external_key_type GetExternalKey(internal_key_type Key) {
+    return Key;
+  }
+
+  static std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<offset_type>(Key.size());
+    LE.write<offset_type>(Data.size());
+    return std::make_pair(Key.size(), Data.size());
+  }
+  static void EmitKey(raw_ostream &Out, key_type_ref Key, offset_type) {
+    Out << Key;
+  }
+  static void EmitData(raw_ostream &Out, key_type_ref, data_type_ref Data,
+                       offset_type) {
+    Out << Data;
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<offset_type, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<offset_type, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+  static internal_key_type ReadKey(const unsigned char *D, offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+  static data_type ReadData(internal_key_type, const unsigned char *D,
+                            offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+};
+
+typedef llvm::OnDiskChainedHashTable<BinaryIndexInfo> BinaryIndexTable;
 } // end anonymous namespace
 
 char IndexError::ID;
@@ -111,6 +180,99 @@ createCrossTUIndexString(const llvm::StringMap<std::string> &Index) {
   return Result.str();
 }
 
+std::string
+createCrossTUBinaryIndex(const llvm::StringMap<std::string> &Index) {
+  llvm::OnDiskChainedHashTableGenerator<BinaryIndexInfo> Generator;
+  for (const auto &E : Index)
+    Generator.insert(E.getKey(), E.getValue());
+
+  using namespace llvm::support;
+  SmallString<4096> Result;
+  llvm::raw_svector_ostream OS(Result);
+  OS.write(BinaryIndexMagic, sizeof(BinaryIndexMagic));
+  endian::Writer<little> LE(OS);
+  LE.write<uint32_t>(BinaryIndexVersion);
+  LE.write<uint32_t>(0);
+  uint32_t TableOffset = Generator.Emit(OS);
+  endian::write32le(&Result[8], TableOffset);
+  return Result.str();
+}
+
+bool isCrossTUBinaryIndex(StringRef Buffer) {
+  return Buffer.startswith(
+      StringRef(BinaryIndexMagic, sizeof(BinaryIndexMagic)));
+}
+
+bool isValidCrossTUBinaryIndex(StringRef Buffer) {
+  using namespace llvm::support;
+  if (Buffer.size() < BinaryIndexHeaderSize || !isCrossTUBinaryIndex(Buffer))
+    return false;
+  const unsigned char *Base = Buffer.bytes_begin();
+  if (endian::read32le(Base + 4) != BinaryIndexVersion)
+    return false;
+  // The bucket array starts with the number of buckets and of entries.
+  uint64_t TableOffset = endian::read32le(Base + 8);
+  if (TableOffset < BinaryIndexHeaderSize || TableOffset % 4 != 0 ||
+      TableOffset + 8 > Buffer.size())
+    return false;
+  uint64_t NumBuckets = endian::read32le(Base + TableOffset);
+  return NumBuckets != 0 && TableOffset + 8 + NumBuckets * 4 <= Buffer.size();
+}
+
+StringRef lookupCrossTUBinaryIndex(StringRef Buffer, StringRef LookupName) {
+  assert(isValidCrossTUBinaryIndex(Buffer) && "Invalid binary index");
+  const unsigned char *Base = Buffer.bytes_begin();
+  std::unique_ptr<BinaryIndexTable> Table(BinaryIndexTable::Create(
+      Base + llvm::support::endian::read32le(Base + 8), Base));
+  auto It = Table->find(LookupName);
+  if (It == Table->end())
+    return StringRef();
+  return *It;
+}
+
+std::string createBoundsSummaryString(const sema::BoundsSummary &Summary) {
+  std::ostringstream Result;
+  for (const auto &E : Summary.functions()) {
+    Result << CrossTranslationUnitContext::getLookupName(E.first) << " "
+           << E.second.CallSites;
+    for (int64_t Elements : E.second.MinElements)
+      Result << " " << Elements;
+    Result << '\n';
+  }
+  return Result.str();
+}
+
+llvm::Expected<llvm::StringMap<sema::BoundsSummary::CallBounds>>
+parseBoundsSummary(StringRef SummaryPath) {
+  std::ifstream SummaryFile(SummaryPath);
+  if (!SummaryFile)
+    return llvm::make_error<IndexError>(index_error_code::missing_index_file,
+                                        SummaryPath.str());
+
+  llvm::StringMap<sema::BoundsSummary::CallBounds> Result;
+  std::string Line;
+  unsigned LineNo = 1;
+  while (std::getline(SummaryFile, Line)) {
+    SmallVector<StringRef, 8> Fields;
+    StringRef(Line).split(Fields, ' ', -1, /*KeepEmpty=*/false);
+    unsigned CallSites;
+    if (Fields.size() < 2 || Fields[1].getAsInteger(10, CallSites))
+      return llvm::make_error<IndexError>(
+          index_error_code::invalid_index_format, SummaryPath.str(), LineNo);
+    SmallVector<int64_t, 4> Elements;
+    for (StringRef Field : llvm::makeArrayRef(Fields).drop_front(2)) {
+      int64_t Value;
+      if (Field.getAsInteger(10, Value) || Value < -1)
+        return llvm::make_error<IndexError>(
+            index_error_code::invalid_index_format, SummaryPath.str(), LineNo);
+      Elements.push_back(Value);
+    }
+    Result[Fields[0]].merge(CallSites, Elements);
+    LineNo++;
+  }
+  return Result;
+}
+
 CrossTranslationUnitContext::CrossTranslationUnitContext(CompilerInstance &CI)
     : CI(CI), Context(CI.getASTContext()) {}
 
@@ -123,27 +285,22 @@ std::string CrossTranslationUnitContext::getLookupName(const NamedDecl *ND) {
   return DeclUSR.str();
 }
 
-/// Recursively visits the function decls of a DeclContext, and looks up a
-/// function based on USRs.
-const FunctionDecl *
-CrossTranslationUnitContext::findFunctionInDeclContext(const DeclContext *DC,
-                                                       StringRef LookupFnName) {
+/// Recursively visits the function decls of a DeclContext, and indexes their
+/// definitions based on USRs.
+void CrossTranslationUnitContext::indexFunctionDefinitions(
+    const DeclContext *DC, llvm::StringMap<const FunctionDecl *> &Definitions) {
   assert(DC && "Declaration Context must not be null");
   for (const Decl *D : DC->decls()) {
     const auto *SubDC = dyn_cast<DeclContext>(D);
     if (SubDC)
-      if (const auto *FD = findFunctionInDeclContext(SubDC, LookupFnName))
-        return FD;
+      indexFunctionDefinitions(SubDC, Definitions);
 
     const auto *ND = dyn_cast<FunctionDecl>(D);
     const FunctionDecl *ResultDecl;
     if (!ND || !ND->hasBody(ResultDecl))
       continue;
-    if (getLookupName(ResultDecl) != LookupFnName)
-      continue;
-    return ResultDecl;
+    Definitions.insert(std::make_pair(getLookupName(ResultDecl), ResultDecl));
   }
-  return nullptr;
 }
 
 llvm::Expected<const FunctionDecl *>
@@ -166,10 +323,18 @@ CrossTranslationUnitContext::getCrossTUDefinition(const FunctionDecl *FD,
   assert(&Unit->getFileManager() ==
          &Unit->getASTContext().getSourceManager().getFileManager());
 
+  // The definitions already imported from the unit are found in the index,
+  // and then in the mapping of the importer of the unit, without walking or
+  // comparing the declarations again.
   TranslationUnitDecl *TU = Unit->getASTContext().getTranslationUnitDecl();
-  if (const FunctionDecl *ResultDecl =
-          findFunctionInDeclContext(TU, LookupFnName))
-    return importDefinition(ResultDecl);
+  auto DefinitionsEntry = ASTUnitDefinitionsMap.try_emplace(TU);
+  llvm::StringMap<const FunctionDecl *> &Definitions =
+      DefinitionsEntry.first->second;
+  if (DefinitionsEntry.second)
+    indexFunctionDefinitions(TU, Definitions);
+  auto It = Definitions.find(LookupFnName);
+  if (It != Definitions.end())
+    return importDefinition(It->second);
   return llvm::make_error<IndexError>(index_error_code::failed_import);
 }
 
@@ -198,15 +363,22 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
   //        a lookup name from a single translation unit. If multiple
   //        translation units contains functions with the same lookup name an
   //        error will be returned.
-  ASTUnit *Unit = nullptr;
-  auto FnUnitCacheEntry = FunctionASTUnitMap.find(LookupName);
-  if (FnUnitCacheEntry == FunctionASTUnitMap.end()) {
-    if (FunctionFileMap.empty()) {
-      SmallString<256> IndexFile = CrossTUDir;
-      if (llvm::sys::path::is_absolute(IndexName))
-        IndexFile = IndexName;
-      else
-        llvm::sys::path::append(IndexFile, IndexName);
+  if (FunctionFileMap.empty() && !BinaryIndex) {
+    SmallString<256> IndexFile = CrossTUDir;
+    if (llvm::sys::path::is_absolute(IndexName))
+      IndexFile = IndexName;
+    else
+      llvm::sys::path::append(IndexFile, IndexName);
+    // An index in the binary format is memory mapped and looked up in place.
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+        llvm::MemoryBuffer::getFile(IndexFile, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false);
+    if (BufferOrErr && isCrossTUBinaryIndex((*BufferOrErr)->getBuffer())) {
+      if (!isValidCrossTUBinaryIndex((*BufferOrErr)->getBuffer()))
+        return llvm::make_error<IndexError>(
+            index_error_code::invalid_index_format, IndexFile.str());
+      BinaryIndex = std::move(*BufferOrErr);
+    } else {
       llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
           parseCrossTUIndex(IndexFile, CrossTUDir);
       if (IndexOrErr)
@@ -214,35 +386,80 @@ llvm::Expected<ASTUnit *> CrossTranslationUnitContext::loadExternalAST(
       else
         return IndexOrErr.takeError();
     }
+  }
 
+  SmallString<256> ASTFileName;
+  if (BinaryIndex) {
+    StringRef FileName =
+        lookupCrossTUBinaryIndex(BinaryIndex->getBuffer(), LookupName);
+    if (FileName.empty())
+      return llvm::make_error<IndexError>(index_error_code::missing_definition);
+    ASTFileName = CrossTUDir;
+    llvm::sys::path::append(ASTFileName, FileName);
+  } else {
     auto It = FunctionFileMap.find(LookupName);
     if (It == FunctionFileMap.end())
       return llvm::make_error<IndexError>(index_error_code::missing_definition);
-    StringRef ASTFileName = It->second;
-    auto ASTCacheEntry = FileASTUnitMap.find(ASTFileName);
-    if (ASTCacheEntry == FileASTUnitMap.end()) {
-      IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
-      TextDiagnosticPrinter *DiagClient =
-          new TextDiagnosticPrinter(llvm::errs(), &*DiagOpts);
-      IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
-      IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
-          new DiagnosticsEngine(DiagID, &*DiagOpts, DiagClient));
-
-      std::unique_ptr<ASTUnit> LoadedUnit(ASTUnit::LoadFromASTFile(
-          ASTFileName, CI.getPCHContainerOperations()->getRawReader(),
-          ASTUnit::LoadEverything, Diags, CI.getFileSystemOpts()));
-      Unit = LoadedUnit.get();
-      FileASTUnitMap[ASTFileName] = std::move(LoadedUnit);
-    } else {
-      Unit = ASTCacheEntry->second.get();
-    }
-    FunctionASTUnitMap[LookupName] = Unit;
-  } else {
-    Unit = FnUnitCacheEntry->second;
+    ASTFileName = It->second;
+  }
+
+  auto ASTCacheEntry = FileASTUnitMap.find(ASTFileName);
+  if (ASTCacheEntry != FileASTUnitMap.end()) {
+    LoadedASTFile &File = ASTCacheEntry->second;
+    LoadedASTFileOrder.splice(LoadedASTFileOrder.begin(), LoadedASTFileOrder,
+                              File.OrderPos);
+    return File.Unit.get();
+  }
+
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts = new DiagnosticOptions();
+  TextDiagnosticPrinter *DiagClient =
+      new TextDiagnosticPrinter(llvm::errs(), &*DiagOpts);
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+  IntrusiveRefCntPtr<DiagnosticsEngine> Diags(
+      new DiagnosticsEngine(DiagID, &*DiagOpts, DiagClient));
+
+  std::unique_ptr<ASTUnit> LoadedUnit(ASTUnit::LoadFromASTFile(
+      ASTFileName.str(), CI.getPCHContainerOperations()->getRawReader(),
+      ASTUnit::LoadEverything, Diags, CI.getFileSystemOpts()));
+  ASTUnit *Unit = LoadedUnit.get();
+  auto &Entry = *FileASTUnitMap.try_emplace(ASTFileName).first;
+  LoadedASTFile &File = Entry.second;
+  File.Unit = std::move(LoadedUnit);
+  File.Memory = 0;
+  if (Unit) {
+    ASTContext &Ctx = Unit->getASTContext();
+    File.Memory =
+        Ctx.getASTAllocatedMemory() + Ctx.getSideTableAllocatedMemory();
   }
+  LoadedASTMemory += File.Memory;
+  File.OrderPos =
+      LoadedASTFileOrder.insert(LoadedASTFileOrder.begin(), Entry.getKey());
+  unloadASTFiles(Entry.getKey());
   return Unit;
 }
 
+void CrossTranslationUnitContext::unloadASTFiles(StringRef Keep) {
+  if (!LoadedASTMemoryLimit)
+    return;
+  while (LoadedASTMemory > LoadedASTMemoryLimit &&
+         LoadedASTFileOrder.back() != Keep) {
+    auto It = FileASTUnitMap.find(LoadedASTFileOrder.back());
+    assert(It != FileASTUnitMap.end() && "Loaded AST file is not cached");
+    LoadedASTFile &File = It->second;
+    // The definitions imported from the unit are complete copies, which do
+    // not refer to it, but its importer does.
+    if (File.Unit) {
+      TranslationUnitDecl *TU =
+          File.Unit->getASTContext().getTranslationUnitDecl();
+      ASTUnitImporterMap.erase(TU);
+      ASTUnitDefinitionsMap.erase(TU);
+    }
+    LoadedASTMemory -= File.Memory;
+    LoadedASTFileOrder.pop_back();
+    FileASTUnitMap.erase(It);
+  }
+}
+
 llvm::Expected<const FunctionDecl *>
 CrossTranslationUnitContext::importDefinition(const FunctionDecl *FD) {
   ASTImporter &Importer = getOrCreateASTImporter(FD->getASTContext());
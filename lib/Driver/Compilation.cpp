@@ -14,9 +14,14 @@
 #include "clang/Driver/Options.h"
 #include "clang/Driver/ToolChain.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
+#include <condition_variable>
+#include <mutex>
 
 using namespace clang::driver;
 using namespace clang;
@@ -137,8 +142,7 @@ bool Compilation::CleanupFileMap(const ArgStringMap &Files,
   return Success;
 }
 
-int Compilation::ExecuteCommand(const Command &C,
-                                const Command *&FailingCommand) const {
+bool Compilation::PrintCommand(const Command &C) const {
   if ((getDriver().CCPrintOptions ||
        getArgs().hasArg(options::OPT_v)) && !getDriver().CCGenDiagnostics) {
     raw_ostream *OS = &llvm::errs();
@@ -153,9 +157,8 @@ int Compilation::ExecuteCommand(const Command &C,
       if (EC) {
         getDriver().Diag(clang::diag::err_drv_cc_print_options_failure)
             << EC.message();
-        FailingCommand = &C;
         delete OS;
-        return 1;
+        return false;
       }
     }
 
@@ -167,6 +170,15 @@ int Compilation::ExecuteCommand(const Command &C,
     if (OS != &llvm::errs())
       delete OS;
   }
+  return true;
+}
+
+int Compilation::ExecuteCommand(const Command &C,
+                                const Command *&FailingCommand) const {
+  if (!PrintCommand(C)) {
+    FailingCommand = &C;
+    return 1;
+  }
 
   std::string Error;
   bool ExecutionFailed;
@@ -182,9 +194,175 @@ int Compilation::ExecuteCommand(const Command &C,
   return ExecutionFailed ? 1 : Res;
 }
 
+namespace {
+/// A job of ExecuteJobsInParallel.
+struct ParallelJob {
+  const Command *Cmd;
+  /// The jobs which must finish before this one starts.
+  SmallVector<unsigned, 2> Dependencies;
+  /// The files that the stdout and stderr of the job are written to.
+  SmallString<128> StdoutFile, StderrFile;
+  enum { Waiting, Running, Done } State = Waiting;
+  int Result = 0;
+  bool ExecutionFailed = false;
+  std::string Error;
+};
+}
+
+/// Add to \p Dependencies the jobs which make the inputs of \p A, given the
+/// job which each action is the source of.
+static void
+collectJobDependencies(const Action *A,
+                       const llvm::DenseMap<const Action *, unsigned> &JobOf,
+                       llvm::SmallPtrSetImpl<const Action *> &Visited,
+                       SmallVectorImpl<unsigned> &Dependencies) {
+  for (const Action *Input : A->inputs()) {
+    if (!Visited.insert(Input).second)
+      continue;
+    auto It = JobOf.find(Input);
+    if (It != JobOf.end())
+      Dependencies.push_back(It->second);
+    else
+      collectJobDependencies(Input, JobOf, Visited, Dependencies);
+  }
+}
+
+/// Write the contents of \p File to \p OS, and remove it.
+static void replayOutput(StringRef File, raw_ostream &OS) {
+  if (auto Buffer = llvm::MemoryBuffer::getFile(File))
+    OS << (*Buffer)->getBuffer();
+  OS.flush();
+  llvm::sys::fs::remove(File);
+}
+
+bool Compilation::ExecuteJobsInParallel(
+    const JobList &Jobs,
+    SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  std::vector<ParallelJob> Items(Jobs.size());
+  llvm::DenseMap<const Action *, unsigned> JobOf;
+  unsigned LastPrecompile = ~0U;
+  unsigned I = 0;
+  for (const auto &Job : Jobs) {
+    ParallelJob &Item = Items[I];
+    Item.Cmd = &Job;
+    // A job depends on the earlier jobs of its action, such as the split of
+    // the debug info of an object file, and on the jobs which make the inputs
+    // of its action. Precompiled headers may be used by any later job.
+    const Action *Source = &Job.getSource();
+    auto It = JobOf.find(Source);
+    if (It != JobOf.end())
+      Item.Dependencies.push_back(It->second);
+    llvm::SmallPtrSet<const Action *, 16> Visited;
+    collectJobDependencies(Source, JobOf, Visited, Item.Dependencies);
+    if (LastPrecompile != ~0U)
+      Item.Dependencies.push_back(LastPrecompile);
+    JobOf[Source] = I;
+    if (isa<PrecompileJobAction>(Source))
+      LastPrecompile = I;
+
+    if (llvm::sys::fs::createTemporaryFile("clang-job", "out",
+                                           Item.StdoutFile) ||
+        llvm::sys::fs::createTemporaryFile("clang-job", "err",
+                                           Item.StderrFile)) {
+      for (const ParallelJob &Created :
+           llvm::makeArrayRef(Items).slice(0, I + 1)) {
+        if (!Created.StdoutFile.empty())
+          llvm::sys::fs::remove(Created.StdoutFile);
+        if (!Created.StderrFile.empty())
+          llvm::sys::fs::remove(Created.StderrFile);
+      }
+      return false;
+    }
+    ++I;
+  }
+
+  std::mutex Mutex;
+  std::condition_variable JobFinished;
+  unsigned NumRunning = 0;
+  unsigned FirstFailure = Items.size();
+  unsigned NextToReport = 0;
+  llvm::ThreadPool Pool(getDriver().ParallelJobs);
+
+  std::unique_lock<std::mutex> Lock(Mutex);
+  for (;;) {
+    // Print the output of the finished jobs in order, up to the first
+    // failing one. The output of the later jobs is dropped.
+    for (; NextToReport != Items.size() &&
+           Items[NextToReport].State == ParallelJob::Done;
+         ++NextToReport) {
+      ParallelJob &Item = Items[NextToReport];
+      if (NextToReport > FirstFailure) {
+        llvm::sys::fs::remove(Item.StdoutFile);
+        llvm::sys::fs::remove(Item.StderrFile);
+        continue;
+      }
+      if (!PrintCommand(*Item.Cmd) && !Item.Result)
+        Item.Result = 1;
+      replayOutput(Item.StdoutFile, llvm::outs());
+      replayOutput(Item.StderrFile, llvm::errs());
+      if (!Item.Error.empty())
+        getDriver().Diag(clang::diag::err_drv_command_failure) << Item.Error;
+      if (int Res = Item.ExecutionFailed ? 1 : Item.Result) {
+        FailingCommands.push_back(std::make_pair(Res, Item.Cmd));
+        FirstFailure = NextToReport;
+      }
+    }
+
+    // Start the jobs whose dependencies have finished. No job after a
+    // failing one is started, as the jobs would stop there if they were
+    // executed in order.
+    for (unsigned J = 0;
+         J < FirstFailure && NumRunning < getDriver().ParallelJobs; ++J) {
+      ParallelJob &Item = Items[J];
+      if (Item.State != ParallelJob::Waiting ||
+          llvm::any_of(Item.Dependencies, [&](unsigned D) {
+            return Items[D].State != ParallelJob::Done;
+          }))
+        continue;
+      Item.State = ParallelJob::Running;
+      ++NumRunning;
+      Pool.async([&, J] {
+        ParallelJob &Item = Items[J];
+        Optional<StringRef> JobRedirects[] = {None, StringRef(Item.StdoutFile),
+                                              StringRef(Item.StderrFile)};
+        std::string Error;
+        bool ExecutionFailed = false;
+        int Res = Item.Cmd->Execute(JobRedirects, &Error, &ExecutionFailed);
+
+        std::lock_guard<std::mutex> Guard(Mutex);
+        Item.Result = Res;
+        Item.ExecutionFailed = ExecutionFailed;
+        Item.Error = std::move(Error);
+        Item.State = ParallelJob::Done;
+        if ((Res || ExecutionFailed) && J < FirstFailure)
+          FirstFailure = J;
+        --NumRunning;
+        JobFinished.notify_one();
+      });
+    }
+
+    if (!NumRunning)
+      break;
+    JobFinished.wait(Lock);
+  }
+
+  // Remove the output files of the jobs that were never started.
+  for (; NextToReport != Items.size(); ++NextToReport) {
+    llvm::sys::fs::remove(Items[NextToReport].StdoutFile);
+    llvm::sys::fs::remove(Items[NextToReport].StderrFile);
+  }
+  return true;
+}
+
 void Compilation::ExecuteJobs(
     const JobList &Jobs,
     SmallVectorImpl<std::pair<int, const Command *>> &FailingCommands) const {
+  // Independent jobs are run at once with -fdriver-jobs=, unless the output
+  // is redirected to generate crash diagnostics.
+  if (getDriver().ParallelJobs > 1 && Jobs.size() > 1 && Redirects.empty() &&
+      ExecuteJobsInParallel(Jobs, FailingCommands))
+    return;
+
   for (const auto &Job : Jobs) {
     const Command *FailingCommand = nullptr;
     if (int Res = ExecuteCommand(Job, FailingCommand)) {
@@ -707,6 +707,15 @@ Compilation *Driver::BuildCompilation(ArrayRef<const char *> ArgList) {
       BitcodeEmbed = static_cast<BitcodeEmbedMode>(Model);
   }
 
+  if (const Arg *A = Args.getLastArg(options::OPT_fdriver_jobs_EQ)) {
+    StringRef Value = A->getValue();
+    if (Value.getAsInteger(10, ParallelJobs) || ParallelJobs == 0) {
+      Diags.Report(diag::err_drv_invalid_int_value) << A->getAsString(Args)
+                                                    << Value;
+      ParallelJobs = 1;
+    }
+  }
+
   std::unique_ptr<llvm::opt::InputArgList> UArgs =
       llvm::make_unique<InputArgList>(std::move(Args));
 
@@ -2856,6 +2865,13 @@ void Driver::BuildJobs(Compilation &C) const {
                        /*TargetDeviceOffloadKind*/ Action::OFK_None);
   }
 
+  // Only run the compiler in the driver process for single job compilations:
+  // it does not clean up all of its global state, such as the options given
+  // with -mllvm, after it runs.
+  if (C.getJobs().size() > 1)
+    for (auto &J : C.getJobs())
+      J.InProcess = false;
+
   // If the user passed -Qunused-arguments or there were errors, don't warn
   // about any unused arguments.
   if (Diags.hasErrorOccurred() ||
@@ -20,8 +20,10 @@
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
@@ -357,6 +359,45 @@ int Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
                                    /*memoryLimit*/ 0, ErrMsg, ExecutionFailed);
 }
 
+CC1Command::CC1Command(const Action &Source_, const Tool &Creator_,
+                       const char *Executable_,
+                       const ArgStringList &Arguments_,
+                       ArrayRef<InputInfo> Inputs)
+    : Command(Source_, Creator_, Executable_, Arguments_, Inputs) {
+  InProcess = true;
+}
+
+int CC1Command::Execute(ArrayRef<llvm::Optional<StringRef>> Redirects,
+                        std::string *ErrMsg, bool *ExecutionFailed) const {
+  const Driver &D = getCreator().getToolChain().getDriver();
+  // Redirected output needs a process of its own.
+  if (!InProcess || !D.CC1Main || !Redirects.empty())
+    return Command::Execute(Redirects, ErrMsg, ExecutionFailed);
+
+  SmallVector<const char *, 128> Argv;
+  Argv.push_back(getExecutable());
+  Argv.append(getArguments().begin(), getArguments().end());
+
+  // The command always starts, as there is no process to create.
+  if (ExecutionFailed)
+    *ExecutionFailed = false;
+
+  // Turn crashes of the compiler into a failure of the command, as if it
+  // crashed in a process of its own, so that the driver still generates the
+  // crash reproducer.
+  llvm::CrashRecoveryContext::Enable();
+  llvm::CrashRecoveryContext CRC;
+  const void *PrettyState = llvm::SavePrettyStackState();
+  int Res = 0;
+  if (!CRC.RunSafely([&]() { Res = D.CC1Main(Argv); })) {
+    // Drop the stack trace entries of the compiler, which the crash unwound
+    // without destroying.
+    llvm::RestorePrettyStackState(PrettyState);
+    return -2;
+  }
+  return Res;
+}
+
 FallbackCommand::FallbackCommand(const Action &Source_, const Tool &Creator_,
                                  const char *Executable_,
                                  const ArgStringList &Arguments_,
@@ -576,6 +576,10 @@ void ToolChain::addClangWarningOptions(ArgStringList &CC1Args) const {}
 
 void ToolChain::addProfileRTLibs(const llvm::opt::ArgList &Args,
                                  llvm::opt::ArgStringList &CmdArgs) const {
+  if (Args.hasFlag(options::OPT_fcheckedc_check_profile,
+                   options::OPT_fno_checkedc_check_profile, false))
+    CmdArgs.push_back(getCompilerRTArgString(Args, "checkedc_check_profile"));
+
   if (!needsProfileRT(Args)) return;
 
   CmdArgs.push_back(getCompilerRTArgString(Args, "profile"));
@@ -2598,6 +2598,8 @@ static void RenderModulesOptions(Compilation &C, const Driver &D,
   }
 
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_validate_system_headers);
+  Args.AddLastArg(CmdArgs, options::OPT_fvalidate_ast_input_files_content);
+  Args.AddLastArg(CmdArgs, options::OPT_fast_input_files_manifest_EQ);
   Args.AddLastArg(CmdArgs, options::OPT_fmodules_disable_diagnostic_validation);
 }
 
@@ -3800,6 +3802,12 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     CmdArgs.push_back(A->getValue());
   }
 
+  if (Arg *A =
+          Args.getLastArg(options::OPT_fdiagnostics_snippet_repeat_limit_EQ)) {
+    CmdArgs.push_back("-fdiagnostics-snippet-repeat-limit");
+    CmdArgs.push_back(A->getValue());
+  }
+
   // Pass -fmessage-length=.
   CmdArgs.push_back("-fmessage-length");
   if (Arg *A = Args.getLastArg(options::OPT_fmessage_length_EQ)) {
@@ -3846,6 +3854,7 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     Args.AddLastArg(CmdArgs, options::OPT_fzvector);
 
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_show_template_tree);
+  Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_deduplicate);
   Args.AddLastArg(CmdArgs, options::OPT_fno_elide_type);
 
   // Forward flags for OpenMP. We don't do this if the current action is an
@@ -3904,6 +3913,10 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_print_source_range_info);
   Args.AddLastArg(CmdArgs, options::OPT_fdiagnostics_parseable_fixits);
   Args.AddLastArg(CmdArgs, options::OPT_ftime_report);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace);
+  Args.AddLastArg(CmdArgs, options::OPT_ftime_trace_granularity_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_fdiscard_function_bodies);
+  Args.AddLastArg(CmdArgs, options::OPT_fasync_output);
   Args.AddLastArg(CmdArgs, options::OPT_ftrapv);
 
   if (Arg *A = Args.getLastArg(options::OPT_ftrapv_handler_EQ)) {
@@ -4112,6 +4125,37 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
   Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_extension);
   Args.AddLastArg(CmdArgs, options::OPT_fno_checkedc_extension);
   Args.AddLastArg(CmdArgs, options::OPT_fdump_inferred_bounds);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_flow_sensitive_bounds,
+                  options::OPT_fno_checkedc_flow_sensitive_bounds);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_symbolic_bounds,
+                  options::OPT_fno_checkedc_symbolic_bounds);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_time_report);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_time_report_json_EQ);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_hoist_checks,
+                  options::OPT_fno_checkedc_hoist_checks);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_coalesce_checks,
+                  options::OPT_fno_checkedc_coalesce_checks);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_index_bounds_checks,
+                  options::OPT_fno_checkedc_index_bounds_checks);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_subsume_cast_checks,
+                  options::OPT_fno_checkedc_subsume_cast_checks);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_late_check_lowering,
+                  options::OPT_fno_checkedc_late_check_lowering);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_check_profile,
+                  options::OPT_fno_checkedc_check_profile);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_version_loops,
+                  options::OPT_fno_checkedc_version_loops);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_sticky_loop_checks,
+                  options::OPT_fno_checkedc_sticky_loop_checks);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_check_calls,
+                  options::OPT_fno_checkedc_check_calls);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_asan_skip_checked_accesses,
+                  options::OPT_fno_checkedc_asan_skip_checked_accesses);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_dereferenceable_bounds,
+                  options::OPT_fno_checkedc_dereferenceable_bounds);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_overflow_checks,
+                  options::OPT_fno_checkedc_overflow_checks);
+  Args.AddLastArg(CmdArgs, options::OPT_fcheckedc_trap_blocks_EQ);
 
   // -fno-declspec is default, except for PS4.
   if (Args.hasFlag(options::OPT_fdeclspec, options::OPT_fno_declspec,
@@ -4602,6 +4646,11 @@ void Clang::ConstructJob(Compilation &C, const JobAction &JA,
     // fails, so that the main compilation's fallback to cl.exe runs.
     C.addCommand(llvm::make_unique<ForceSuccessCommand>(JA, *this, Exec,
                                                         CmdArgs, Inputs));
+  } else if (D.CC1Main && !D.CCGenDiagnostics &&
+             Args.hasFlag(options::OPT_fintegrated_cc1,
+                          options::OPT_fno_integrated_cc1, false)) {
+    C.addCommand(
+        llvm::make_unique<CC1Command>(JA, *this, Exec, CmdArgs, Inputs));
   } else {
     C.addCommand(llvm::make_unique<Command>(JA, *this, Exec, CmdArgs, Inputs));
   }
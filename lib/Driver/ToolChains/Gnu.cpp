@@ -22,10 +22,16 @@
 #include "clang/Driver/DriverDiagnostic.h"
 #include "clang/Driver/Options.h"
 #include "clang/Driver/Tool.h"
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Support/CodeGen.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/TargetParser.h"
+#include <chrono>
+#include <cstdlib>
 #include <system_error>
 
 using namespace clang::driver;
@@ -1621,6 +1627,36 @@ void Generic_GCC::GCCInstallationDetector::init(
     }
   }
 
+  // With CLANG_GCC_INSTALLATION_CACHE set to a directory, the result of the
+  // detection is cached there, keyed by its inputs, and reused as long as
+  // none of the paths that it looked at changed.
+  std::string CacheFile, CacheKey;
+  const char *CacheDir = ::getenv("CLANG_GCC_INSTALLATION_CACHE");
+  if (CacheDir && *CacheDir &&
+      TargetTriple.getOS() != llvm::Triple::Solaris) {
+    llvm::raw_string_ostream Key(CacheKey);
+    Key << "target " << TargetTriple.str() << "\n"
+        << "sysroot " << D.SysRoot << "\n";
+    for (const std::string &Prefix : Prefixes)
+      Key << "prefix " << Prefix << "\n";
+    for (StringRef Alias : ExtraTripleAliases)
+      Key << "alias " << Alias << "\n";
+    // The machine options select the multilibs, which an installation needs
+    // to be chosen.
+    for (const Arg *A :
+         Args.filtered(options::OPT_m_Group, options::OPT_EB, options::OPT_EL))
+      Key << "arg " << A->getAsString(Args) << "\n";
+    Key.flush();
+
+    SmallString<128> Path(CacheDir);
+    llvm::sys::path::append(
+        Path, "gcc-" + llvm::utohexstr(size_t(llvm::hash_value(CacheKey))));
+    CacheFile = Path.str();
+    if (loadCachedDetection(CacheFile, CacheKey, TargetTriple, Args))
+      return;
+    RecordProbes = true;
+  }
+
   // Try to respect gcc-config on Gentoo. However, do that only
   // if --gcc-toolchain is not provided or equal to the Gentoo install
   // in /usr. This avoids accidentally enforcing the system GCC version
@@ -1644,10 +1680,12 @@ void Generic_GCC::GCCInstallationDetector::init(
   // installation available. GCC installs are ranked by version number.
   Version = GCCVersion::Parse("0.0.0");
   for (const std::string &Prefix : Prefixes) {
+    recordProbe(Prefix);
     if (!D.getVFS().exists(Prefix))
       continue;
     for (StringRef Suffix : CandidateLibDirs) {
       const std::string LibDir = Prefix + Suffix.str();
+      recordProbe(LibDir);
       if (!D.getVFS().exists(LibDir))
         continue;
       for (StringRef Candidate : ExtraTripleAliases) // Try these first.
@@ -1657,6 +1695,7 @@ void Generic_GCC::GCCInstallationDetector::init(
     }
     for (StringRef Suffix : CandidateBiarchLibDirs) {
       const std::string LibDir = Prefix + Suffix.str();
+      recordProbe(LibDir);
       if (!D.getVFS().exists(LibDir))
         continue;
       for (StringRef Candidate : CandidateBiarchTripleAliases)
@@ -1664,6 +1703,108 @@ void Generic_GCC::GCCInstallationDetector::init(
                                /*NeedsBiarchSuffix=*/ true);
     }
   }
+
+  if (RecordProbes) {
+    saveCachedDetection(CacheFile, CacheKey);
+    RecordProbes = false;
+    Probes.clear();
+  }
+}
+
+/// The modification time of \p Path in nanoseconds, or -1 if it doesn't
+/// exist.
+static int64_t getPathStamp(vfs::FileSystem &FS, const Twine &Path) {
+  llvm::ErrorOr<vfs::Status> Status = FS.status(Path);
+  if (!Status)
+    return -1;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Status->getLastModificationTime().time_since_epoch())
+      .count();
+}
+
+void Generic_GCC::GCCInstallationDetector::recordProbe(const Twine &Path) {
+  if (RecordProbes)
+    Probes.emplace_back(Path.str(), getPathStamp(D.getVFS(), Path));
+}
+
+bool Generic_GCC::GCCInstallationDetector::loadCachedDetection(
+    StringRef CacheFile, StringRef Key, const llvm::Triple &TargetTriple,
+    const ArgList &Args) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
+      llvm::MemoryBuffer::getFile(CacheFile);
+  if (!File || !(*File)->getBuffer().startswith(Key))
+    return false;
+
+  SmallVector<StringRef, 32> Lines;
+  (*File)->getBuffer().drop_front(Key.size()).split(Lines, '\n', -1, false);
+  std::set<std::string> Candidates;
+  StringRef Triple, InstallPath, ParentLibPath;
+  bool Biarch = false;
+  for (StringRef Line : Lines) {
+    StringRef Kind, Value;
+    std::tie(Kind, Value) = Line.split(' ');
+    if (Kind == "probe") {
+      StringRef Stamp, Path;
+      std::tie(Stamp, Path) = Value.split(' ');
+      int64_t Recorded;
+      if (Stamp.getAsInteger(10, Recorded) ||
+          getPathStamp(D.getVFS(), Path) != Recorded)
+        return false;
+    } else if (Kind == "candidate") {
+      Candidates.insert(Value);
+    } else if (Kind == "gcc-triple") {
+      Triple = Value;
+    } else if (Kind == "biarch") {
+      Biarch = Value == "1";
+    } else if (Kind == "install") {
+      InstallPath = Value;
+    } else if (Kind == "parent-lib") {
+      ParentLibPath = Value;
+    } else {
+      return false;
+    }
+  }
+
+  // The multilibs of the installation are detected again, as they are not
+  // cached.
+  if (!InstallPath.empty()) {
+    if (!ScanGCCForMultilibs(TargetTriple, Args, InstallPath, Biarch))
+      return false;
+    Version = GCCVersion::Parse(llvm::sys::path::filename(InstallPath));
+    GCCTriple.setTriple(Triple);
+    GCCInstallPath = InstallPath;
+    GCCParentLibPath = ParentLibPath;
+    InstallNeedsBiarchSuffix = Biarch;
+    IsValid = true;
+  }
+  CandidateGCCInstallPaths = std::move(Candidates);
+  return true;
+}
+
+void Generic_GCC::GCCInstallationDetector::saveCachedDetection(
+    StringRef CacheFile, StringRef Key) const {
+  // The entry is written to a file of its own and renamed, so that other
+  // drivers never read a partial entry.
+  int FD;
+  SmallString<128> TempFile;
+  llvm::sys::fs::create_directories(llvm::sys::path::parent_path(CacheFile));
+  if (llvm::sys::fs::createUniqueFile(CacheFile + "-%%%%%%%%", FD, TempFile))
+    return;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Key;
+    for (const auto &Probe : Probes)
+      OS << "probe " << Probe.second << " " << Probe.first << "\n";
+    for (const std::string &Candidate : CandidateGCCInstallPaths)
+      OS << "candidate " << Candidate << "\n";
+    if (IsValid)
+      OS << "gcc-triple " << GCCTriple.str() << "\n"
+         << "biarch " << InstallNeedsBiarchSuffix << "\n"
+         << "install " << GCCInstallPath << "\n"
+         << "parent-lib " << GCCParentLibPath << "\n";
+  }
+  if (llvm::sys::fs::rename(TempFile, CacheFile))
+    llvm::sys::fs::remove(TempFile);
 }
 
 void Generic_GCC::GCCInstallationDetector::print(raw_ostream &OS) const {
@@ -2080,6 +2221,7 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
       continue;
 
     StringRef LibSuffix = Suffix.LibSuffix;
+    recordProbe(LibDir + "/" + LibSuffix);
     std::error_code EC;
     for (vfs::directory_iterator
              LI = D.getVFS().dir_begin(LibDir + "/" + LibSuffix, EC),
@@ -2095,10 +2237,12 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
       if (CandidateVersion <= Version)
         continue;
 
+      recordProbe(LI->getName());
       if (!ScanGCCForMultilibs(TargetTriple, Args, LI->getName(),
                                NeedsBiarchSuffix))
         continue;
 
+      InstallNeedsBiarchSuffix = NeedsBiarchSuffix;
       Version = CandidateVersion;
       GCCTriple.setTriple(CandidateTriple);
       // FIXME: We hack together the directory name here instead of
@@ -2114,6 +2258,7 @@ void Generic_GCC::GCCInstallationDetector::ScanLibDirForGCCTriple(
 bool Generic_GCC::GCCInstallationDetector::ScanGentooGccConfig(
     const llvm::Triple &TargetTriple, const ArgList &Args,
     StringRef CandidateTriple, bool NeedsBiarchSuffix) {
+  recordProbe(D.SysRoot + "/etc/env.d/gcc/config-" + CandidateTriple);
   llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> File =
       D.getVFS().getBufferForFile(D.SysRoot + "/etc/env.d/gcc/config-" +
                                   CandidateTriple.str());
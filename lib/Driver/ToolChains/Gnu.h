@@ -14,6 +14,7 @@
 #include "clang/Driver/Tool.h"
 #include "clang/Driver/ToolChain.h"
 #include <set>
+#include <vector>
 
 namespace clang {
 namespace driver {
@@ -208,6 +209,14 @@ public:
     /// The set of multilibs that the detected installation supports.
     MultilibSet Multilibs;
 
+    /// Whether the detected installation was found with the biarch triples.
+    bool InstallNeedsBiarchSuffix = false;
+
+    /// When the result of the detection is cached, the paths that it looked
+    /// at, with their modification times, or -1 for the missing ones.
+    std::vector<std::pair<std::string, int64_t>> Probes;
+    bool RecordProbes = false;
+
   public:
     explicit GCCInstallationDetector(const Driver &D) : IsValid(false), D(D) {}
     void init(const llvm::Triple &TargetTriple, const llvm::opt::ArgList &Args,
@@ -271,6 +280,18 @@ public:
                              const llvm::opt::ArgList &Args,
                              StringRef CandidateTriple,
                              bool NeedsBiarchSuffix = false);
+
+    /// Record the state of \p Path, which the detection is about to look at.
+    void recordProbe(const Twine &Path);
+
+    /// Reuse the detection cached in \p CacheFile for \p Key, if none of
+    /// the paths it looked at changed since.
+    bool loadCachedDetection(StringRef CacheFile, StringRef Key,
+                             const llvm::Triple &TargetTriple,
+                             const llvm::opt::ArgList &Args);
+
+    /// Write the result of the detection and its probes to \p CacheFile.
+    void saveCachedDetection(StringRef CacheFile, StringRef Key) const;
   };
 
 protected:
@@ -2004,6 +2004,260 @@ tooling::Replacements reformat(const FormatStyle &Style, StringRef Code,
       .first;
 }
 
+namespace {
+
+/// \brief A point between two top-level declarations at which code can be
+/// split for incremental formatting.
+struct SplitPoint {
+  /// \brief The start of the line of the first token after the split.
+  unsigned LineStart;
+  /// \brief The end of the line of the first token after the split.
+  unsigned LineEnd;
+  /// \brief The end of the last token before the split.
+  unsigned PrevTokenEnd;
+  /// \brief The number of namespaces and extern blocks the split is in.
+  unsigned Depth;
+  /// \brief The smallest number of namespaces and extern blocks the code
+  /// between the previous split point and this one is in.
+  unsigned MinDepth;
+};
+
+} // end anonymous namespace
+
+/// \brief Finds the part of \p Code that contains \p Ranges and that can be
+/// formatted on its own, i.e. that starts and ends at blank lines between
+/// top-level declarations. On success, the part is [Begin, End), and no
+/// replacement may change its text after LastTokenEnd.
+static bool findIncrementalWindow(const FormatStyle &Style, StringRef Code,
+                                  ArrayRef<tooling::Range> Ranges,
+                                  StringRef FileName, unsigned &Begin,
+                                  unsigned &End, unsigned &LastTokenEnd) {
+  unsigned RangesBegin = Code.size(), RangesEnd = 0;
+  for (const tooling::Range &R : Ranges) {
+    RangesBegin = std::min(RangesBegin, R.getOffset());
+    RangesEnd = std::max(RangesEnd, R.getOffset() + R.getLength());
+  }
+
+  std::unique_ptr<Environment> Env =
+      Environment::CreateVirtualEnvironment(Code, FileName, Ranges);
+  const SourceManager &SM = Env->getSourceManager();
+  FileID ID = Env->getFileID();
+  Lexer Lex(ID, SM.getBuffer(ID), SM, getFormattingLangOpts(Style));
+  Lex.SetCommentRetentionState(true);
+
+  // The split points of the code read so far, starting with the start of the
+  // code, and the one that starts the part to format.
+  SmallVector<SplitPoint, 16> Splits;
+  Splits.push_back({0, 0, 0, 0, 0});
+  size_t BeginIndex = 0;
+
+  // Whether each open brace starts a namespace or an extern block, whose
+  // content isn't indented.
+  SmallVector<bool, 8> Braces;
+  unsigned BlockDepth = 0, TransparentDepth = 0, MinDepth = 0, PPDepth = 0;
+  bool InDirective = false, ExpectDirectiveName = false, SeenElse = false;
+  bool PendingTransparent = false, FormattingOff = false;
+  tok::TokenKind PrevSignificant = tok::unknown;
+  StringRef PrevRawIdentifier;
+  unsigned PrevTokenEnd = 0;
+
+  Token Tok;
+  for (Lex.LexFromRawLexer(Tok); Tok.isNot(tok::eof);
+       Lex.LexFromRawLexer(Tok)) {
+    unsigned Offset = SM.getFileOffset(Tok.getLocation());
+    StringRef Text = Code.substr(Offset, Tok.getLength());
+
+    if (Tok.isAtStartOfLine()) {
+      InDirective = false;
+      StringRef Gap = Code.slice(PrevTokenEnd, Offset);
+      unsigned Newlines = Gap.count('\n');
+      if (BlockDepth == 0 && PPDepth == 0 && !FormattingOff &&
+          Tok.isNot(tok::r_brace) && Newlines >= 2 &&
+          Newlines <= Style.MaxEmptyLinesToKeep + 1 &&
+          (PrevSignificant == tok::unknown || PrevSignificant == tok::semi ||
+           PrevSignificant == tok::r_brace)) {
+        unsigned LineStart = PrevTokenEnd + Gap.rfind('\n') + 1;
+        size_t LineEnd = Code.find('\n', Offset);
+        if (LineEnd == StringRef::npos)
+          LineEnd = Code.size();
+        Splits.push_back({LineStart, unsigned(LineEnd), PrevTokenEnd,
+                          TransparentDepth, MinDepth});
+        MinDepth = TransparentDepth;
+        const SplitPoint &Split = Splits.back();
+        if (LineEnd < RangesBegin) {
+          BeginIndex = Splits.size() - 1;
+        } else if (PrevTokenEnd > RangesEnd && !SeenElse) {
+          // Stop at the first split point after the ranges at which the
+          // namespaces of the start of the part are closed.
+          const SplitPoint &BeginSplit = Splits[BeginIndex];
+          bool Balanced = Split.Depth == BeginSplit.Depth;
+          for (size_t I = BeginIndex + 1; Balanced && I < Splits.size(); ++I)
+            Balanced = Splits[I].MinDepth >= BeginSplit.Depth;
+          if (Balanced) {
+            Begin = BeginSplit.LineStart;
+            LastTokenEnd = Split.PrevTokenEnd;
+            End = Code.find('\n', LastTokenEnd) + 1;
+            return true;
+          }
+        }
+      }
+
+      if (Tok.is(tok::hash)) {
+        InDirective = true;
+        ExpectDirectiveName = true;
+        PrevTokenEnd = Offset + Tok.getLength();
+        continue;
+      }
+    }
+    PrevTokenEnd = Offset + Tok.getLength();
+
+    if (Tok.is(tok::comment)) {
+      if (Text == "// clang-format off" || Text == "/* clang-format off */")
+        FormattingOff = true;
+      else if (Text == "// clang-format on" || Text == "/* clang-format on */")
+        FormattingOff = false;
+      continue;
+    }
+    if (InDirective) {
+      if (ExpectDirectiveName && Tok.is(tok::raw_identifier)) {
+        StringRef Name = Tok.getRawIdentifier();
+        if (Name == "if" || Name == "ifdef" || Name == "ifndef") {
+          ++PPDepth;
+        } else if (Name == "elif" || Name == "else") {
+          if (PPDepth == 0)
+            return false;
+          SeenElse = true;
+        } else if (Name == "endif") {
+          if (PPDepth == 0)
+            return false;
+          --PPDepth;
+        }
+      }
+      ExpectDirectiveName = false;
+      continue;
+    }
+
+    switch (Tok.getKind()) {
+    case tok::raw_identifier:
+      if (BlockDepth == 0 &&
+          Style.NamespaceIndentation == FormatStyle::NI_None &&
+          Tok.getRawIdentifier() == "namespace")
+        PendingTransparent = true;
+      break;
+    case tok::string_literal:
+      if (BlockDepth == 0 && PrevSignificant == tok::raw_identifier &&
+          PrevRawIdentifier == "extern")
+        PendingTransparent = true;
+      break;
+    case tok::l_brace:
+      Braces.push_back(PendingTransparent);
+      if (PendingTransparent)
+        ++TransparentDepth;
+      else
+        ++BlockDepth;
+      PendingTransparent = false;
+      break;
+    case tok::r_brace:
+      if (Braces.empty())
+        return false;
+      if (Braces.pop_back_val()) {
+        --TransparentDepth;
+        MinDepth = std::min(MinDepth, TransparentDepth);
+      } else {
+        --BlockDepth;
+      }
+      PendingTransparent = false;
+      break;
+    case tok::semi:
+    case tok::equal:
+    case tok::l_paren:
+      PendingTransparent = false;
+      break;
+    default:
+      break;
+    }
+    PrevSignificant = Tok.getKind();
+    PrevRawIdentifier =
+        Tok.is(tok::raw_identifier) ? Tok.getRawIdentifier() : StringRef();
+  }
+
+  // The part to format extends to the end of the code, which must close all
+  // the braces and conditionals that were opened.
+  if (!Braces.empty() || PPDepth != 0)
+    return false;
+  const SplitPoint &BeginSplit = Splits[BeginIndex];
+  if (BeginSplit.Depth != 0)
+    return false;
+  Begin = BeginSplit.LineStart;
+  End = Code.size();
+  LastTokenEnd = Code.size();
+  return true;
+}
+
+tooling::Replacements reformatIncrementally(const FormatStyle &Style,
+                                            StringRef Code,
+                                            ArrayRef<tooling::Range> Ranges,
+                                            StringRef FileName,
+                                            FormattingAttemptStatus *Status) {
+  FormatStyle Expanded = expandPresets(Style);
+  // Styles that are derived from the whole file, or that depend on context
+  // outside of top-level declarations, need to see the whole file.
+  if (Ranges.empty() || Expanded.DisableFormat ||
+      Expanded.Language != FormatStyle::LK_Cpp ||
+      Expanded.DerivePointerAlignment ||
+      Expanded.ExperimentalAutoDetectBinPacking ||
+      Expanded.Standard == FormatStyle::LS_Auto ||
+      Expanded.IndentPPDirectives != FormatStyle::PPDIS_None)
+    return reformat(Style, Code, Ranges, FileName, Status);
+
+  unsigned Begin, End, LastTokenEnd;
+  if (!findIncrementalWindow(Expanded, Code, Ranges, FileName, Begin, End,
+                             LastTokenEnd) ||
+      (Begin == 0 && End == Code.size()))
+    return reformat(Style, Code, Ranges, FileName, Status);
+
+  // The line endings are derived from the whole file.
+  StringRef Part = Code.slice(Begin, End);
+  auto UsesCRLF = [](StringRef Text) {
+    return Text.count('\r') * 2 > Text.count('\n');
+  };
+  if (UsesCRLF(Part) != UsesCRLF(Code))
+    return reformat(Style, Code, Ranges, FileName, Status);
+
+  std::vector<tooling::Range> PartRanges;
+  for (const tooling::Range &R : Ranges) {
+    unsigned RangeBegin = std::max(R.getOffset(), Begin);
+    unsigned RangeEnd = std::min(R.getOffset() + R.getLength(), End);
+    if (RangeBegin <= RangeEnd)
+      PartRanges.push_back(
+          tooling::Range(RangeBegin - Begin, RangeEnd - RangeBegin));
+  }
+
+  FormattingAttemptStatus PartStatus;
+  tooling::Replacements PartReplaces =
+      reformat(Style, Part, PartRanges, FileName, &PartStatus);
+  std::vector<tooling::Replacement> Replaces;
+  for (const tooling::Replacement &R : PartReplaces) {
+    // The whitespace after the last token of the part belongs to the next
+    // declaration, so changing it needs the whole file.
+    if (Begin + R.getOffset() + R.getLength() > LastTokenEnd)
+      return reformat(Style, Code, Ranges, FileName, Status);
+    Replaces.emplace_back(FileName, Begin + R.getOffset(), R.getLength(),
+                          R.getReplacementText());
+  }
+  if (Status) {
+    *Status = PartStatus;
+    if (!PartStatus.FormatComplete && PartStatus.Line > 0)
+      Status->Line += Code.substr(0, Begin).count('\n');
+  }
+  auto Result = tooling::Replacements::createFromUnsorted(std::move(Replaces));
+  if (!Result) {
+    llvm::consumeError(Result.takeError());
+    return reformat(Style, Code, Ranges, FileName, Status);
+  }
+  return std::move(*Result);
+}
+
 tooling::Replacements cleanup(const FormatStyle &Style, StringRef Code,
                               ArrayRef<tooling::Range> Ranges,
                               StringRef FileName) {
@@ -2089,45 +2343,29 @@ static FormatStyle::LanguageKind getLanguageByFileName(StringRef FileName) {
   return FormatStyle::LK_Cpp;
 }
 
-llvm::Expected<FormatStyle> getStyle(StringRef StyleName, StringRef FileName,
-                                     StringRef FallbackStyleName,
-                                     StringRef Code, vfs::FileSystem *FS) {
-  if (!FS) {
-    FS = vfs::getRealFileSystem().get();
-  }
-  FormatStyle Style = getLLVMStyle();
-  Style.Language = getLanguageByFileName(FileName);
-
-  // This is a very crude detection of whether a header contains ObjC code that
-  // should be improved over time and probably be done on tokens, not one the
-  // bare content of the file.
-  if (Style.Language == FormatStyle::LK_Cpp && FileName.endswith(".h") &&
-      (Code.contains("\n- (") || Code.contains("\n+ (")))
-    Style.Language = FormatStyle::LK_ObjC;
-
-  FormatStyle FallbackStyle = getNoStyle();
-  if (!getPredefinedStyle(FallbackStyleName, Style.Language, &FallbackStyle))
-    return make_string_error("Invalid fallback style \"" + FallbackStyleName);
-
-  if (StyleName.startswith("{")) {
-    // Parse YAML/JSON style from the command line.
-    if (std::error_code ec = parseConfiguration(StyleName, &Style))
-      return make_string_error("Error parsing -style: " + ec.message());
-    return Style;
-  }
+bool StyleCache::lookup(StringRef Directory,
+                        FormatStyle::LanguageKind Language, Entry &Result) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto I = Entries.find(std::make_pair(Directory.str(), Language));
+  if (I == Entries.end())
+    return false;
+  Result = I->second;
+  return true;
+}
 
-  if (!StyleName.equals_lower("file")) {
-    if (!getPredefinedStyle(StyleName, Style.Language, &Style))
-      return make_string_error("Invalid value for -style");
-    return Style;
-  }
+void StyleCache::insert(StringRef Directory,
+                        FormatStyle::LanguageKind Language, Entry Result) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Entries[std::make_pair(Directory.str(), Language)] = std::move(Result);
+}
 
-  // Look for .clang-format/_clang-format file in the file's parent directories.
+// Looks for a .clang-format/_clang-format file in the parent directories of
+// the absolute path \p Path, and parses it over \p Style. Returns None if
+// there is no such file.
+static llvm::Expected<llvm::Optional<FormatStyle>>
+loadStyleFromConfigFile(StringRef Path, FormatStyle Style,
+                        vfs::FileSystem *FS) {
   SmallString<128> UnsuitableConfigFiles;
-  SmallString<128> Path(FileName);
-  if (std::error_code EC = FS->makeAbsolute(Path))
-    return make_string_error(EC.message());
-
   for (StringRef Directory = Path; !Directory.empty();
        Directory = llvm::sys::path::parent_path(Directory)) {
 
@@ -2179,6 +2417,72 @@ llvm::Expected<FormatStyle> getStyle(StringRef StyleName, StringRef FileName,
     return make_string_error("Configuration file(s) do(es) not support " +
                              getLanguageName(Style.Language) + ": " +
                              UnsuitableConfigFiles);
+  return llvm::None;
+}
+
+llvm::Expected<FormatStyle> getStyle(StringRef StyleName, StringRef FileName,
+                                     StringRef FallbackStyleName,
+                                     StringRef Code, vfs::FileSystem *FS,
+                                     StyleCache *Cache) {
+  if (!FS) {
+    FS = vfs::getRealFileSystem().get();
+  }
+  FormatStyle Style = getLLVMStyle();
+  Style.Language = getLanguageByFileName(FileName);
+
+  // This is a very crude detection of whether a header contains ObjC code that
+  // should be improved over time and probably be done on tokens, not one the
+  // bare content of the file.
+  if (Style.Language == FormatStyle::LK_Cpp && FileName.endswith(".h") &&
+      (Code.contains("\n- (") || Code.contains("\n+ (")))
+    Style.Language = FormatStyle::LK_ObjC;
+
+  FormatStyle FallbackStyle = getNoStyle();
+  if (!getPredefinedStyle(FallbackStyleName, Style.Language, &FallbackStyle))
+    return make_string_error("Invalid fallback style \"" + FallbackStyleName);
+
+  if (StyleName.startswith("{")) {
+    // Parse YAML/JSON style from the command line.
+    if (std::error_code ec = parseConfiguration(StyleName, &Style))
+      return make_string_error("Error parsing -style: " + ec.message());
+    return Style;
+  }
+
+  if (!StyleName.equals_lower("file")) {
+    if (!getPredefinedStyle(StyleName, Style.Language, &Style))
+      return make_string_error("Invalid value for -style");
+    return Style;
+  }
+
+  // Look for .clang-format/_clang-format file in the file's parent directories.
+  SmallString<128> Path(FileName);
+  if (std::error_code EC = FS->makeAbsolute(Path))
+    return make_string_error(EC.message());
+
+  // The search starts from the file itself when it is a directory, so such
+  // paths are not cached with the files of their parent directory.
+  StringRef CacheKey;
+  if (Cache) {
+    auto Status = FS->status(Path);
+    if (!Status ||
+        Status->getType() != llvm::sys::fs::file_type::directory_file)
+      CacheKey = llvm::sys::path::parent_path(Path);
+  }
+  StyleCache::Entry Result;
+  if (CacheKey.empty() || !Cache->lookup(CacheKey, Style.Language, Result)) {
+    llvm::Expected<llvm::Optional<FormatStyle>> LoadedStyle =
+        loadStyleFromConfigFile(Path, Style, FS);
+    if (LoadedStyle)
+      Result.Style = std::move(*LoadedStyle);
+    else
+      Result.Error = llvm::toString(LoadedStyle.takeError());
+    if (!CacheKey.empty())
+      Cache->insert(CacheKey, Style.Language, Result);
+  }
+  if (!Result.Error.empty())
+    return make_string_error(Result.Error);
+  if (Result.Style)
+    return *Result.Style;
   return FallbackStyle;
 }
 
@@ -840,8 +840,8 @@ private:
   /// \brief An edge in the solution space from \c Previous->State to \c State,
   /// inserting a newline dependent on the \c NewLine.
   struct StateNode {
-    StateNode(const LineState &State, bool NewLine, StateNode *Previous)
-        : State(State), NewLine(NewLine), Previous(Previous) {}
+    StateNode(LineState State, bool NewLine, StateNode *Previous)
+        : State(std::move(State)), NewLine(NewLine), Previous(Previous) {}
     LineState State;
     bool NewLine;
     StateNode *Previous;
@@ -856,6 +856,15 @@ private:
                               std::greater<QueueItem>>
       QueueType;
 
+  /// \brief The states that were examined, which had the lowest penalty of
+  /// all the equal states.
+  typedef std::set<LineState *, CompareLineStatePointers> SeenSet;
+
+  /// \brief The lowest penalty of the states in the queue, for each distinct
+  /// state.
+  typedef std::map<LineState *, unsigned, CompareLineStatePointers>
+      QueuedPenaltyMap;
+
   /// \brief Analyze the entire solution space starting from \p InitialState.
   ///
   /// This implements a variant of Dijkstra's algorithm on the graph that spans
@@ -865,7 +874,8 @@ private:
   ///
   /// If \p DryRun is \c false, directly applies the changes.
   unsigned analyzeSolutionSpace(LineState &InitialState, bool DryRun) {
-    std::set<LineState *, CompareLineStatePointers> Seen;
+    SeenSet Seen;
+    QueuedPenaltyMap Queued;
 
     // Increasing count of \c StateNode items we have created. This is used to
     // create a deterministic order independent of the container.
@@ -890,6 +900,11 @@ private:
       }
       Queue.pop();
 
+      // The state leaves the queue, and may be changed below.
+      auto QueuedIt = Queued.find(&Node->State);
+      if (QueuedIt != Queued.end() && QueuedIt->first == &Node->State)
+        Queued.erase(QueuedIt);
+
       // Cut off the analysis of certain solutions if the analysis gets too
       // complex. See description of IgnoreStackForComparison.
       if (Count > 50000)
@@ -901,9 +916,11 @@ private:
 
       FormatDecision LastFormat = Node->State.NextToken->Decision;
       if (LastFormat == FD_Unformatted || LastFormat == FD_Continue)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/false, &Count, &Queue,
+                            Seen, Queued);
       if (LastFormat == FD_Unformatted || LastFormat == FD_Break)
-        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue);
+        addNextStateToQueue(Penalty, Node, /*NewLine=*/true, &Count, &Queue,
+                            Seen, Queued);
     }
 
     if (Queue.empty()) {
@@ -927,22 +944,42 @@ private:
   ///
   /// Assume the current state is \p PreviousNode and has been reached with a
   /// penalty of \p Penalty. Insert a line break if \p NewLine is \c true.
+  ///
+  /// The state is dropped if an equal state was already examined, or is in
+  /// the queue with a penalty that isn't higher, since that state would be
+  /// taken from the queue first and the new one skipped. Many paths through
+  /// long braced lists and call chains lead to the same states, so this keeps
+  /// the queue proportional to the number of distinct states.
   void addNextStateToQueue(unsigned Penalty, StateNode *PreviousNode,
-                           bool NewLine, unsigned *Count, QueueType *Queue) {
+                           bool NewLine, unsigned *Count, QueueType *Queue,
+                           SeenSet &Seen, QueuedPenaltyMap &Queued) {
     if (NewLine && !Indenter->canBreak(PreviousNode->State))
       return;
     if (!NewLine && Indenter->mustBreak(PreviousNode->State))
       return;
 
-    StateNode *Node = new (Allocator.Allocate())
-        StateNode(PreviousNode->State, NewLine, PreviousNode);
-    if (!formatChildren(Node->State, NewLine, /*DryRun=*/true, Penalty))
+    LineState State = PreviousNode->State;
+    if (!formatChildren(State, NewLine, /*DryRun=*/true, Penalty))
       return;
 
-    Penalty += Indenter->addTokenToState(Node->State, NewLine, true);
+    Penalty += Indenter->addTokenToState(State, NewLine, true);
 
-    Queue->push(QueueItem(OrderedPenalty(Penalty, *Count), Node));
-    ++(*Count);
+    // Count the dropped states too, so that the order of the other states and
+    // the cut-off of complex analyses don't change.
+    unsigned Order = (*Count)++;
+    if (Seen.count(&State))
+      return;
+    auto QueuedIt = Queued.find(&State);
+    if (QueuedIt != Queued.end()) {
+      if (QueuedIt->second <= Penalty)
+        return;
+      Queued.erase(QueuedIt);
+    }
+
+    StateNode *Node = new (Allocator.Allocate())
+        StateNode(std::move(State), NewLine, PreviousNode);
+    Queued.insert(std::make_pair(&Node->State, Penalty));
+    Queue->push(QueueItem(OrderedPenalty(Penalty, Order), Node));
   }
 
   /// \brief Applies the best formatting by reconstructing the path in the
@@ -15,6 +15,7 @@
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/DeclVisitor.h"
+#include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/AST/StmtVisitor.h"
 #include "clang/AST/TypeOrdering.h"
 #include "clang/Basic/Diagnostic.h"
@@ -32,6 +33,7 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
 #include "clang/Sema/Sema.h"
+#include "clang/Sema/SemaConsumer.h"
 #include "clang/Serialization/ASTReader.h"
 #include "clang/Serialization/ASTWriter.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -193,10 +195,13 @@ ASTUnit::ASTUnit(bool _MainFileIsAST)
     NumWarningsInPreamble(0),
     ShouldCacheCodeCompletionResults(false),
     IncludeBriefCommentsInCodeCompletion(false), UserFilesAreVolatile(false),
+    NumCachedPreambleCompletionResults(0),
+    CachedPreambleCompletionsValid(false),
+    CachedCompletionMemoryAfterFullRebuild(0),
     CompletionCacheTopLevelHashValue(0),
     PreambleTopLevelHashValue(0),
     CurrentTopLevelHashValue(0),
-    UnsafeToFree(false) { 
+    UnsafeToFree(false), Frozen(false) { 
   if (getenv("LIBCLANG_OBJTRACKING"))
     fprintf(stderr, "+++ %u translation units\n", ++ActiveASTUnitObjects);
 }
@@ -304,6 +309,38 @@ static unsigned getDeclShowContexts(const NamedDecl *ND,
   return Contexts;
 }
 
+/// \brief Determine whether the entity of a global code-completion result was
+/// first declared or defined in the precompiled preamble, whose entities are
+/// loaded from the preamble's AST file.
+static bool isCompletionResultFromPreamble(const CodeCompletionResult &R,
+                                           Preprocessor &PP) {
+  SourceLocation Loc;
+  switch (R.Kind) {
+  case CodeCompletionResult::RK_Declaration:
+    // Use the first declaration, so that a redeclaration after the preamble
+    // does not add a second result for the same entity.
+    Loc = R.Declaration->getCanonicalDecl()->getLocation();
+    break;
+
+  case CodeCompletionResult::RK_Macro: {
+    const MacroDirective *MD = PP.getLocalMacroDirectiveHistory(R.Macro);
+    if (!MD)
+      return false;
+    while (const MacroDirective *Prev = MD->getPrevious())
+      MD = Prev;
+    Loc = MD->getLocation();
+    break;
+  }
+
+  case CodeCompletionResult::RK_Keyword:
+  case CodeCompletionResult::RK_Pattern:
+    return false;
+  }
+
+  // Implicit declarations are recreated identically by every parse.
+  return Loc.isInvalid() || PP.getSourceManager().isLoadedSourceLocation(Loc);
+}
+
 void ASTUnit::CacheCodeCompletionResults() {
   if (!TheSema)
     return;
@@ -311,22 +348,51 @@ void ASTUnit::CacheCodeCompletionResults() {
   SimpleTimer Timer(WantTiming);
   Timer.setOutput("Cache global code completions for " + getMainFileName());
 
-  // Clear out the previous results.
-  ClearCachedCompletionResults();
-  
+  // If the preamble did not change since the results were cached, only the
+  // results for the rest of the main file need to be recomputed. Since their
+  // strings are allocated next to the ones that are kept, recompute all the
+  // results once the allocator has grown too much. Entities loaded from
+  // modules are indistinguishable from those of the preamble, so always
+  // recompute everything when modules are enabled.
+  bool OnlyAfterPreamble =
+      Preamble && CachedPreambleCompletionsValid && CachedCompletionAllocator &&
+      !Ctx->getLangOpts().Modules &&
+      CachedCompletionAllocator->getTotalMemory() <
+          2 * CachedCompletionMemoryAfterFullRebuild;
+
+  if (OnlyAfterPreamble) {
+    CachedCompletionResults.resize(NumCachedPreambleCompletionResults);
+  } else {
+    // Clear out the previous results.
+    ClearCachedCompletionResults();
+    CachedCompletionAllocator =
+        std::make_shared<GlobalCodeCompletionAllocator>();
+  }
+
   // Gather the set of global code completions.
   typedef CodeCompletionResult Result;
   SmallVector<Result, 8> Results;
-  CachedCompletionAllocator = std::make_shared<GlobalCodeCompletionAllocator>();
   CodeCompletionTUInfo CCTUInfo(CachedCompletionAllocator);
   TheSema->GatherGlobalCodeCompletions(*CachedCompletionAllocator,
                                        CCTUInfo, Results);
   
-  // Translate global code completions into cached completions.
+  // Translate global code completions into cached completions. The results
+  // for the entities of the preamble are kept apart, so that they can be
+  // placed before the others.
+  std::vector<CachedCodeCompletionResult> PreambleResults;
+  std::vector<CachedCodeCompletionResult> OtherResults;
   llvm::DenseMap<CanQualType, unsigned> CompletionTypes;
   CodeCompletionContext CCContext(CodeCompletionContext::CCC_TopLevel);
 
   for (Result &R : Results) {
+    bool FromPreamble =
+        Preamble && !Ctx->getLangOpts().Modules &&
+        isCompletionResultFromPreamble(R, TheSema->getPreprocessor());
+    if (FromPreamble && OnlyAfterPreamble)
+      continue;
+    std::vector<CachedCodeCompletionResult> &CachedResults =
+        FromPreamble ? PreambleResults : OtherResults;
+
     switch (R.Kind) {
     case Result::RK_Declaration: {
       bool IsNestedNameSpecifier = false;
@@ -354,17 +420,21 @@ void ASTUnit::CacheCodeCompletionResults() {
         // Determine whether we have already seen this type. If so, we save
         // ourselves the work of formatting the type string by using the 
         // temporary, CanQualType-based hash table to find the associated value.
+        // The type strings of the results that were kept stay mapped to
+        // their values.
         unsigned &TypeValue = CompletionTypes[CanUsageType];
         if (TypeValue == 0) {
-          TypeValue = CompletionTypes.size();
-          CachedCompletionTypes[QualType(CanUsageType).getAsString()]
-            = TypeValue;
+          unsigned &CachedTypeValue =
+              CachedCompletionTypes[QualType(CanUsageType).getAsString()];
+          if (CachedTypeValue == 0)
+            CachedTypeValue = CachedCompletionTypes.size();
+          TypeValue = CachedTypeValue;
         }
         
         CachedResult.Type = TypeValue;
       }
       
-      CachedCompletionResults.push_back(CachedResult);
+      CachedResults.push_back(CachedResult);
       
       /// Handle nested-name-specifiers in C++.
       if (TheSema->Context.getLangOpts().CPlusPlus && IsNestedNameSpecifier &&
@@ -401,7 +471,7 @@ void ASTUnit::CacheCodeCompletionResults() {
           CachedResult.Priority = CCP_NestedNameSpecifier;
           CachedResult.TypeClass = STC_Void;
           CachedResult.Type = 0;
-          CachedCompletionResults.push_back(CachedResult);
+          CachedResults.push_back(CachedResult);
         }
       }
       break;
@@ -437,18 +507,31 @@ void ASTUnit::CacheCodeCompletionResults() {
       CachedResult.Availability = R.Availability;
       CachedResult.TypeClass = STC_Void;
       CachedResult.Type = 0;
-      CachedCompletionResults.push_back(CachedResult);
+      CachedResults.push_back(CachedResult);
       break;
     }
     }
   }
   
+  CachedCompletionResults.insert(CachedCompletionResults.end(),
+                                 PreambleResults.begin(),
+                                 PreambleResults.end());
+  NumCachedPreambleCompletionResults = CachedCompletionResults.size();
+  CachedCompletionResults.insert(CachedCompletionResults.end(),
+                                 OtherResults.begin(), OtherResults.end());
+  if (!OnlyAfterPreamble)
+    CachedCompletionMemoryAfterFullRebuild =
+        CachedCompletionAllocator->getTotalMemory();
+  CachedPreambleCompletionsValid = Preamble.hasValue();
+
   // Save the current top-level hash value.
   CompletionCacheTopLevelHashValue = CurrentTopLevelHashValue;
 }
 
 void ASTUnit::ClearCachedCompletionResults() {
   CachedCompletionResults.clear();
+  NumCachedPreambleCompletionResults = 0;
+  CachedPreambleCompletionsValid = false;
   CachedCompletionTypes.clear();
   CachedCompletionAllocator = nullptr;
 }
@@ -853,7 +936,7 @@ void AddTopLevelDeclarationToHash(Decl *D, unsigned &Hash) {
   }
 }
 
-class TopLevelDeclTrackerConsumer : public ASTConsumer {
+class TopLevelDeclTrackerConsumer : public SemaConsumer {
   ASTUnit &Unit;
   unsigned &Hash;
   
@@ -909,6 +992,10 @@ public:
   ASTDeserializationListener *GetASTDeserializationListener() override {
     return Unit.getDeserializationListener();
   }
+
+  void InitializeSema(Sema &S) override {
+    S.BoundsCache = &Unit.getBoundsCheckCache();
+  }
 };
 
 class TopLevelDeclTrackerAction : public ASTFrontendAction {
@@ -1154,6 +1241,7 @@ bool ASTUnit::Parse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
   else
     PreambleSrcLocCache.clear();
 
+  BoundsCache.beginParse();
   if (!Act->Execute())
     goto error;
 
@@ -1264,6 +1352,7 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   if (!Bounds.Size)
     return nullptr;
 
+  std::shared_ptr<const PrecompiledPreamble> BasePreamble;
   if (Preamble) {
     if (Preamble->CanReuse(PreambleInvocationIn, MainFileBuffer.get(), Bounds,
                            VFS.get())) {
@@ -1278,10 +1367,21 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
 
       PreambleRebuildCounter = 1;
       return MainFileBuffer;
+    } else if (AllowRebuild &&
+               Preamble->CanExtend(PreambleInvocationIn, MainFileBuffer.get(),
+                                   Bounds, VFS.get())) {
+      // Directives were only appended to the preamble: precompile them on top
+      // of the existing preamble, which keeps its diagnostics and top-level
+      // declarations.
+      BasePreamble = std::make_shared<PrecompiledPreamble>(std::move(*Preamble));
+      Preamble.reset();
+      TopLevelDeclsInPreamble.clear();
+      PreambleRebuildCounter = 1;
     } else {
       Preamble.reset();
       PreambleDiagnostics.clear();
       TopLevelDeclsInPreamble.clear();
+      PreambleTopLevelDeclIDs.clear();
       PreambleRebuildCounter = 1;
     }
   }
@@ -1315,11 +1415,17 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
 
     llvm::ErrorOr<PrecompiledPreamble> NewPreamble = PrecompiledPreamble::Build(
         PreambleInvocationIn, MainFileBuffer.get(), Bounds, *Diagnostics, VFS,
-        PCHContainerOps, Callbacks);
+        PCHContainerOps, Callbacks, BasePreamble);
     if (NewPreamble) {
       Preamble = std::move(*NewPreamble);
       PreambleRebuildCounter = 1;
+      // The cached completions of the old preamble may not match the new one.
+      CachedPreambleCompletionsValid = false;
     } else {
+      if (BasePreamble) {
+        PreambleDiagnostics.clear();
+        PreambleTopLevelDeclIDs.clear();
+      }
       switch (static_cast<BuildPreambleError>(NewPreamble.getError().value())) {
       case BuildPreambleError::CouldntCreateTempFile:
       case BuildPreambleError::PreambleIsEmpty:
@@ -1341,20 +1447,34 @@ ASTUnit::getMainBufferWithPrecompiledPreamble(
   assert(Preamble && "Preamble wasn't built");
 
   TopLevelDecls.clear();
-  TopLevelDeclsInPreamble = Callbacks.takeTopLevelDeclIDs();
+  std::vector<serialization::DeclID> NewTopLevelDeclIDs =
+      Callbacks.takeTopLevelDeclIDs();
+  if (!BasePreamble) {
+    PreambleTopLevelDeclIDs.clear();
+    PreambleDiagnostics.clear();
+    NumWarningsInPreamble = 0;
+  }
+  // The declarations of the lower layers keep their IDs, since their PCHs
+  // are loaded first.
+  PreambleTopLevelDeclIDs.insert(PreambleTopLevelDeclIDs.end(),
+                                 NewTopLevelDeclIDs.begin(),
+                                 NewTopLevelDeclIDs.end());
+  TopLevelDeclsInPreamble = PreambleTopLevelDeclIDs;
   PreambleTopLevelHashValue = Callbacks.getHash();
 
-  NumWarningsInPreamble = getDiagnostics().getNumWarnings();
+  NumWarningsInPreamble += getDiagnostics().getNumWarnings();
 
   checkAndRemoveNonDriverDiags(NewPreambleDiags);
   StoredDiagnostics = std::move(NewPreambleDiags);
-  PreambleDiagnostics = std::move(NewPreambleDiagsStandalone);
+  PreambleDiagnostics.append(NewPreambleDiagsStandalone.begin(),
+                             NewPreambleDiagsStandalone.end());
 
   // If the hash of top-level entities differs from the hash of the top-level
   // entities the last time we rebuilt the preamble, clear out the completion
   // cache.
   if (CurrentTopLevelHashValue != PreambleTopLevelHashValue) {
     CompletionCacheTopLevelHashValue = 0;
+    CachedPreambleCompletionsValid = false;
     PreambleTopLevelHashValue = CurrentTopLevelHashValue;
   }
 
@@ -1704,6 +1824,8 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
   CI->getHeaderSearchOpts().ResourceDir = ResourceFilesPath;
 
   CI->getFrontendOpts().SkipFunctionBodies = SkipFunctionBodies;
+  // Clients of the ASTUnit look at the function bodies.
+  CI->getLangOpts()->DiscardFunctionBodies = false;
 
   if (ModuleFormat)
     CI->getHeaderSearchOpts().ModuleFormat = ModuleFormat.getValue();
@@ -1759,7 +1881,7 @@ ASTUnit *ASTUnit::LoadFromCommandLine(
 bool ASTUnit::Reparse(std::shared_ptr<PCHContainerOperations> PCHContainerOps,
                       ArrayRef<RemappedFile> RemappedFiles,
                       IntrusiveRefCntPtr<vfs::FileSystem> VFS) {
-  if (!Invocation)
+  if (!Invocation || Frozen)
     return true;
 
   if (!VFS) {
@@ -2449,6 +2571,16 @@ SourceLocation ASTUnit::mapLocationFromPreamble(SourceLocation Loc) const {
     return FileLoc.getLocWithOffset(Offs);
   }
 
+  // The lower layers of an extended preamble contain a prefix of the main
+  // file, at the same offsets.
+  for (FileID LayerID : SourceMgr->getPreambleLayerFileIDs()) {
+    if (SourceMgr->isInFileID(Loc, LayerID, &Offs)) {
+      SourceLocation FileLoc
+          = SourceMgr->getLocForStartOfFile(SourceMgr->getMainFileID());
+      return FileLoc.getLocWithOffset(Offs);
+    }
+  }
+
   return Loc;
 }
 
@@ -2480,8 +2612,13 @@ bool ASTUnit::isInPreambleFileID(SourceLocation Loc) const {
   
   if (Loc.isInvalid() || FID.isInvalid())
     return false;
-  
-  return SourceMgr->isInFileID(Loc, FID);
+
+  if (SourceMgr->isInFileID(Loc, FID))
+    return true;
+  for (FileID LayerID : SourceMgr->getPreambleLayerFileIDs())
+    if (SourceMgr->isInFileID(Loc, LayerID))
+      return true;
+  return false;
 }
 
 bool ASTUnit::isInMainFileID(SourceLocation Loc) const {
@@ -2611,6 +2748,68 @@ InputKind ASTUnit::getInputKind() const {
   return InputKind(Lang, Fmt, PP);
 }
 
+namespace {
+
+/// \brief Computes the data of the declarations that is otherwise computed, or
+/// deserialized, the first time it is queried.
+class FreezeVisitor : public RecursiveASTVisitor<FreezeVisitor> {
+  ASTContext &Ctx;
+
+public:
+  explicit FreezeVisitor(ASTContext &Ctx) : Ctx(Ctx) {}
+
+  bool shouldVisitTemplateInstantiations() const { return true; }
+  bool shouldVisitImplicitCode() const { return true; }
+
+  bool VisitDecl(Decl *D) {
+    D->getMostRecentDecl();
+    Ctx.getRawCommentForAnyRedecl(D);
+    if (auto *DC = dyn_cast<DeclContext>(D))
+      if (DC->isLookupContext() && !DC->isFunctionOrMethod())
+        (void)DC->lookups();
+    return true;
+  }
+};
+
+} // anonymous namespace
+
+/// \brief Whether the size of \p T can be computed.
+static bool hasComputableTypeInfo(ASTContext &Ctx, QualType T) {
+  if (T->isDependentType() || T->isIncompleteType() ||
+      !T->isConstantSizeType() || T->isUndeducedType())
+    return false;
+  const Type *Base = Ctx.getBaseElementType(T).getTypePtr();
+  if (const auto *RT = Base->getAs<RecordType>())
+    return !RT->getDecl()->isInvalidDecl();
+  return true;
+}
+
+void ASTUnit::freeze() {
+  if (Frozen)
+    return;
+
+  if (Ctx) {
+    FreezeVisitor(*Ctx).TraverseDecl(Ctx->getTranslationUnitDecl());
+
+    // Computing the size of a type may create other types, so iterate over a
+    // copy of the list.
+    SmallVector<Type *, 0> Types(Ctx->getTypes().begin(),
+                                 Ctx->getTypes().end());
+    for (Type *T : Types) {
+      if (!T->isCanonicalUnqualified())
+        continue;
+      QualType QT(T, 0);
+      if (hasComputableTypeInfo(*Ctx, QT))
+        Ctx->getTypeInfo(QT);
+    }
+  }
+
+  if (SourceMgr)
+    SourceMgr->prepareForConcurrentReads();
+
+  Frozen = true;
+}
+
 #ifndef NDEBUG
 ASTUnit::ConcurrencyState::ConcurrencyState() {
   Mutex = new llvm::sys::MutexImpl(/*recursive=*/true);
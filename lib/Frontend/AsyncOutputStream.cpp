@@ -0,0 +1,134 @@
+//===--- AsyncOutputStream.cpp - Write output on a separate thread --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the AsyncFileWriter and AsyncOutputStream classes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/AsyncOutputStream.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace clang;
+
+/// The number of chunks that may be queued before writing blocks.
+static const size_t MaxQueuedChunks = 4;
+
+AsyncFileWriter::AsyncFileWriter(std::unique_ptr<llvm::raw_fd_ostream> OS,
+                                 size_t ChunkSize)
+    : OS(std::move(OS)), ChunkSize(ChunkSize) {
+  Pending.reserve(ChunkSize);
+  Writer = std::thread([this] { writeBlocks(); });
+}
+
+AsyncFileWriter::~AsyncFileWriter() { close(); }
+
+void AsyncFileWriter::write(const char *Ptr, size_t Size) {
+  Pos += Size;
+  if (!Writer.joinable()) {
+    OS->write(Ptr, Size);
+    return;
+  }
+  Pending.insert(Pending.end(), Ptr, Ptr + Size);
+  if (Pending.size() >= ChunkSize)
+    enqueuePending();
+}
+
+void AsyncFileWriter::pwrite(const char *Ptr, size_t Size, uint64_t Offset) {
+  if (!Writer.joinable()) {
+    OS->pwrite(Ptr, Size, Offset);
+    return;
+  }
+
+  // Patch the part of the range that was not queued yet in place, and queue
+  // the rest, which the writer thread writes after the data it overwrites.
+  uint64_t PendingStart = Pos - Pending.size();
+  if (Offset + Size > PendingStart) {
+    uint64_t Begin = std::max(Offset, PendingStart);
+    std::memcpy(Pending.data() + (Begin - PendingStart), Ptr + (Begin - Offset),
+                Offset + Size - Begin);
+    Size = Begin - Offset;
+  }
+  if (Size)
+    enqueue({std::vector<char>(Ptr, Ptr + Size), Offset});
+}
+
+void AsyncFileWriter::close() {
+  if (!Writer.joinable())
+    return;
+  enqueuePending();
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Closing = true;
+  }
+  BlockQueued.notify_one();
+  Writer.join();
+  OS->flush();
+}
+
+void AsyncFileWriter::enqueuePending() {
+  if (Pending.empty())
+    return;
+  Block B{std::move(Pending), AppendOffset};
+  Pending.clear();
+  Pending.reserve(ChunkSize);
+  enqueue(std::move(B));
+}
+
+void AsyncFileWriter::enqueue(Block B) {
+  {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    BlockWritten.wait(Lock, [&] {
+      return Queue.empty() || QueuedBytes < MaxQueuedChunks * ChunkSize;
+    });
+    QueuedBytes += B.Data.size();
+    Queue.push_back(std::move(B));
+  }
+  BlockQueued.notify_one();
+}
+
+void AsyncFileWriter::writeBlocks() {
+  while (true) {
+    Block B;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      BlockQueued.wait(Lock, [&] { return !Queue.empty() || Closing; });
+      if (Queue.empty())
+        return;
+      B = std::move(Queue.front());
+      Queue.pop_front();
+    }
+
+    if (B.Offset == AppendOffset)
+      OS->write(B.Data.data(), B.Data.size());
+    else
+      OS->pwrite(B.Data.data(), B.Data.size(), B.Offset);
+
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      QueuedBytes -= B.Data.size();
+    }
+    BlockWritten.notify_one();
+  }
+}
+
+AsyncOutputStream::~AsyncOutputStream() {
+  flush();
+  Writer->close();
+}
+
+void AsyncOutputStream::write_impl(const char *Ptr, size_t Size) {
+  Writer->write(Ptr, Size);
+}
+
+void AsyncOutputStream::pwrite_impl(const char *Ptr, size_t Size,
+                                    uint64_t Offset) {
+  flush();
+  Writer->pwrite(Ptr, Size, Offset);
+}
@@ -21,6 +21,7 @@
 #include "clang/Lex/Lexer.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Support/EndianStream.h"
@@ -171,6 +172,45 @@ public:
   }
 };
 
+/// ContentPTHEntryInfo - The trait of the table mapping from the hashes of
+/// file contents to token data.  The keys and data have a fixed size, so
+/// their lengths are not emitted.
+class ContentPTHEntryInfo {
+public:
+  typedef PTHManager::ContentHash key_type;
+  typedef const key_type &key_type_ref;
+
+  typedef PTHEntry data_type;
+  typedef const PTHEntry &data_type_ref;
+
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref K) {
+    return (hash_value_type) K.first;
+  }
+
+  static std::pair<unsigned,unsigned>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref K, data_type_ref E) {
+    return std::make_pair(2 * sizeof(uint64_t), 2 * sizeof(uint32_t));
+  }
+
+  static void EmitKey(raw_ostream &Out, key_type_ref K, unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint64_t>(K.first);
+    LE.write<uint64_t>(K.second);
+  }
+
+  static void EmitData(raw_ostream &Out, key_type_ref, data_type_ref E,
+                       unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint32_t>(E.getTokenOffset());
+    LE.write<uint32_t>(E.getPPCondTableOffset());
+  }
+};
+
 class OffsetOpt {
   bool valid;
   Offset off;
@@ -183,6 +223,8 @@ public:
 } // end anonymous namespace
 
 typedef llvm::OnDiskChainedHashTableGenerator<FileEntryPTHEntryInfo> PTHMap;
+typedef llvm::OnDiskChainedHashTableGenerator<ContentPTHEntryInfo>
+    PTHContentMap;
 
 namespace {
 class PTHWriter {
@@ -194,6 +236,7 @@ class PTHWriter {
   IDMap IM;
   std::vector<llvm::StringMapEntry<OffsetOpt>*> StrEntries;
   PTHMap PM;
+  PTHContentMap CM;
   CachedStrsTy CachedStrs;
   uint32_t idcount;
   Offset CurStrOffset;
@@ -239,6 +282,10 @@ class PTHWriter {
   /// token data.
   Offset EmitFileTable() { return PM.Emit(Out); }
 
+  /// EmitContentTable - Emit a table mapping from the hashes of file contents
+  /// to PTH token data.
+  Offset EmitContentTable() { return CM.Emit(Out); }
+
   PTHEntry LexTokens(Lexer& L);
   Offset EmitCachedSpellings();
 
@@ -490,9 +537,9 @@ void PTHWriter::GeneratePTH(StringRef MainFile) {
   Out << "cfe-pth" << '\0';
   Emit32(PTHManager::Version);
 
-  // Leave 4 words for the prologue.
+  // Leave 5 words for the prologue.
   Offset PrologueOffset = Out.tell();
-  for (unsigned i = 0; i < 4; ++i)
+  for (unsigned i = 0; i < 5; ++i)
     Emit32(0);
 
   // Write the name of the MainFile.
@@ -508,23 +555,33 @@ void PTHWriter::GeneratePTH(StringRef MainFile) {
   // for each file and cache the tokens.
   SourceManager &SM = PP.getSourceManager();
   const LangOptions &LOpts = PP.getLangOpts();
+  llvm::DenseSet<PTHManager::ContentHash> CachedContents;
 
   for (SourceManager::fileinfo_iterator I = SM.fileinfo_begin(),
        E = SM.fileinfo_end(); I != E; ++I) {
     const SrcMgr::ContentCache &C = *I->second;
     const FileEntry *FE = C.OrigEntry;
 
-    // FIXME: Handle files with non-absolute paths.
-    if (llvm::sys::path::is_relative(FE->getName()))
-      continue;
-
     const llvm::MemoryBuffer *B = C.getBuffer(PP.getDiagnostics(), SM);
     if (!B) continue;
 
+    // Files with the same contents share their tokens in the table of files
+    // by content.  Files are found in the table of files by name only by an
+    // absolute path.
+    // FIXME: Handle files with non-absolute paths.
+    PTHManager::ContentHash Hash = PTHManager::getContentHash(B->getBuffer());
+    bool IsRelative = llvm::sys::path::is_relative(FE->getName());
+    if (IsRelative && CachedContents.count(Hash))
+      continue;
+
     FileID FID = SM.createFileID(FE, SourceLocation(), SrcMgr::C_User);
     const llvm::MemoryBuffer *FromFile = SM.getBuffer(FID);
     Lexer L(FID, FromFile, SM, LOpts);
-    PM.insert(FE, LexTokens(L));
+    PTHEntry Entry = LexTokens(L);
+    if (!IsRelative)
+      PM.insert(FE, Entry);
+    if (CachedContents.insert(Hash).second)
+      CM.insert(Hash, Entry);
   }
 
   // Write out the identifier table.
@@ -536,12 +593,16 @@ void PTHWriter::GeneratePTH(StringRef MainFile) {
   // Write out the file table.
   Offset FileTableOff = EmitFileTable();
 
+  // Write out the table of files by content.
+  Offset ContentTableOff = EmitContentTable();
+
   // Finally, write the prologue.
   uint64_t Off = PrologueOffset;
   pwrite32le(Out, IdTableOff.first, Off);
   pwrite32le(Out, IdTableOff.second, Off);
   pwrite32le(Out, FileTableOff, Off);
   pwrite32le(Out, SpellingOff, Off);
+  pwrite32le(Out, ContentTableOff, Off);
 }
 
 namespace {
@@ -15,20 +15,25 @@
 #include "clang/Basic/Diagnostic.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/MemoryBufferCache.h"
+#include "clang/Basic/SharedStatCache.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Basic/TargetInfo.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Basic/Version.h"
 #include "clang/Config/config.h"
+#include "clang/Frontend/AsyncOutputStream.h"
 #include "clang/Frontend/ChainedDiagnosticConsumer.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Frontend/FrontendDiagnostic.h"
 #include "clang/Frontend/LogDiagnosticPrinter.h"
+#include "clang/Frontend/ModuleBuildCoordinator.h"
 #include "clang/Frontend/SerializedDiagnosticPrinter.h"
 #include "clang/Frontend/TextDiagnosticPrinter.h"
 #include "clang/Frontend/Utils.h"
 #include "clang/Frontend/VerifyDiagnosticConsumer.h"
 #include "clang/Lex/HeaderSearch.h"
+#include "clang/Lex/PPCallbacks.h"
 #include "clang/Lex/PTHManager.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
@@ -92,6 +97,7 @@ void CompilerInstance::setAuxTarget(TargetInfo *Value) { AuxTarget = Value; }
 
 void CompilerInstance::setFileManager(FileManager *Value) {
   FileMgr = Value;
+  SharedStats = nullptr;
   if (Value)
     VirtualFileSystem = Value->getVirtualFileSystem();
   else
@@ -203,6 +209,9 @@ static void collectVFSEntries(CompilerInstance &CI,
         llvm::MemoryBuffer::getFile(VFSFile);
     if (!Buffer)
       return;
+    // The files of a content store have no real path to collect.
+    if (vfs::isContentStore(Buffer.get()->getBuffer()))
+      continue;
     vfs::collectVFSFromYAML(std::move(Buffer.get()), /*DiagHandler*/ nullptr,
                             VFSFile, VFSEntries);
   }
@@ -309,9 +318,23 @@ FileManager *CompilerInstance::createFileManager() {
       return nullptr;
   }
   FileMgr = new FileManager(getFileSystemOpts(), VirtualFileSystem);
+  SharedStats = nullptr;
+  if (!getFileSystemOpts().StatCachePath.empty()) {
+    std::unique_ptr<SharedStatCache> Cache =
+        SharedStatCache::create(getFileSystemOpts().StatCachePath);
+    SharedStats = Cache.get();
+    FileMgr->addStatCache(std::move(Cache));
+  }
   return FileMgr.get();
 }
 
+void CompilerInstance::saveSharedStatCache() {
+  // The cache is only an optimization, so failing to update it is not an
+  // error.
+  if (SharedStats)
+    SharedStats->save();
+}
+
 // Source Manager
 
 void CompilerInstance::createSourceManager(FileManager &FileMgr) {
@@ -370,6 +393,39 @@ static void InitializeFileRemapping(DiagnosticsEngine &Diags,
 
 // Preprocessor
 
+namespace {
+/// Records an -ftime-trace event for each file the preprocessor enters.
+class TimeTracePPCallbacks : public PPCallbacks {
+  SourceManager &SM;
+  /// The number of entered files whose event has not ended.
+  unsigned Depth = 0;
+
+public:
+  explicit TimeTracePPCallbacks(SourceManager &SM) : SM(SM) {}
+
+  void FileChanged(SourceLocation Loc, FileChangeReason Reason,
+                   SrcMgr::CharacteristicKind FileType,
+                   FileID PrevFID) override {
+    if (Reason == EnterFile) {
+      ++Depth;
+      timeTraceProfilerBegin("Source", [&]() -> std::string {
+        PresumedLoc PLoc = SM.getPresumedLoc(Loc);
+        return PLoc.isValid() ? PLoc.getFilename() : "";
+      });
+    } else if (Reason == ExitFile && Depth > 0) {
+      --Depth;
+      timeTraceProfilerEnd();
+    }
+  }
+
+  // The main file is never exited.
+  void EndOfMainFile() override {
+    for (; Depth > 0; --Depth)
+      timeTraceProfilerEnd();
+  }
+};
+} // end anonymous namespace
+
 void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
   const PreprocessorOptions &PPOpts = getPreprocessorOpts();
 
@@ -378,6 +434,12 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
   if (!PPOpts.TokenCache.empty())
     PTHMgr = PTHManager::Create(PPOpts.TokenCache, getDiagnostics());
 
+  // Read module files through the process-wide cache if requested. Module
+  // builds share the PCMCache of their importer, which is already set up.
+  if (getHeaderSearchOpts().ModulesShareBuffers &&
+      !getPCMCache().hasSharedCache())
+    getPCMCache().setSharedCache(&SharedMemoryBufferCache::getProcessCache());
+
   // Create the Preprocessor.
   HeaderSearch *HeaderInfo =
       new HeaderSearch(getHeaderSearchOptsPtr(), getSourceManager(),
@@ -394,6 +456,7 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
   // IdentifierTable's ctor.
   if (PTHMgr) {
     PTHMgr->setPreprocessor(&*PP);
+    PTHMgr->setLookupByContent(PPOpts.TokenCacheByContent);
     PP->setPTHManager(PTHMgr);
   }
 
@@ -469,6 +532,10 @@ void CompilerInstance::createPreprocessor(TranslationUnitKind TUKind) {
                            /*ShowAllHeaders=*/true, /*OutputPath=*/"",
                            /*ShowDepth=*/true, /*MSStyle=*/true);
   }
+
+  if (timeTraceProfilerEnabled())
+    PP->addPPCallbacks(
+        llvm::make_unique<TimeTracePPCallbacks>(getSourceManager()));
 }
 
 std::string CompilerInstance::getSpecificModuleCachePath() {
@@ -651,6 +718,9 @@ void CompilerInstance::addOutputFile(OutputFile &&OutFile) {
 }
 
 void CompilerInstance::clearOutputFiles(bool EraseFiles) {
+  for (auto &Writer : AsyncWriters)
+    Writer->close();
+  AsyncWriters.clear();
   for (OutputFile &OF : OutputFiles) {
     if (!OF.TempFilename.empty()) {
       if (EraseFiles) {
@@ -813,8 +883,13 @@ std::unique_ptr<llvm::raw_pwrite_stream> CompilerInstance::createOutputFile(
   if (TempPathName)
     *TempPathName = TempFile;
 
-  if (!Binary || OS->supportsSeeking())
-    return std::move(OS);
+  if (!Binary || OS->supportsSeeking()) {
+    if (!Binary || !getFrontendOpts().AsyncOutput)
+      return std::move(OS);
+    // Write the file on a separate thread while the output is produced.
+    AsyncWriters.push_back(std::make_shared<AsyncFileWriter>(std::move(OS)));
+    return llvm::make_unique<AsyncOutputStream>(AsyncWriters.back());
+  }
 
   auto B = llvm::make_unique<llvm::buffer_ostream>(*OS);
   assert(!NonSeekStream);
@@ -1059,6 +1134,9 @@ static InputKind::Language getLanguageFromOptions(const LangOptions &LangOpts) {
 /// \brief Compile a module file for the given module, using the options 
 /// provided by the importing compiler instance. Returns true if the module
 /// was built without errors.
+///
+/// An \p Isolated build does not share any state with the importing instance
+/// that is not safe to use from another thread, and drops its diagnostics.
 static bool
 compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
                   StringRef ModuleName, FrontendInputFile Input,
@@ -1066,7 +1144,8 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
                   llvm::function_ref<void(CompilerInstance &)> PreBuildStep =
                       [](CompilerInstance &) {},
                   llvm::function_ref<void(CompilerInstance &)> PostBuildStep =
-                      [](CompilerInstance &) {}) {
+                      [](CompilerInstance &) {},
+                  bool Isolated = false) {
   // Construct a compiler invocation for creating this module.
   auto Invocation =
       std::make_shared<CompilerInvocation>(ImportingInstance.getInvocation());
@@ -1098,10 +1177,19 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   // instance.
   PreprocessorOptions &ImportingPPOpts
     = ImportingInstance.getInvocation().getPreprocessorOpts();
-  if (!ImportingPPOpts.FailedModules)
-    ImportingPPOpts.FailedModules =
+  if (Isolated) {
+    PPOpts.FailedModules =
         std::make_shared<PreprocessorOptions::FailedModulesSet>();
-  PPOpts.FailedModules = ImportingPPOpts.FailedModules;
+  } else {
+    if (!ImportingPPOpts.FailedModules)
+      ImportingPPOpts.FailedModules =
+          std::make_shared<PreprocessorOptions::FailedModulesSet>();
+    PPOpts.FailedModules = ImportingPPOpts.FailedModules;
+  }
+
+  // The modules that an isolated build imports are built on its own thread.
+  if (Isolated)
+    HSOpts.ModulesBuildJobs = 0;
 
   // If there is a module map file, build the module using the module map.
   // Set up the inputs/outputs so that we build the module from its umbrella
@@ -1126,21 +1214,34 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   // Construct a compiler instance that will be used to actually create the
   // module.  Since we're sharing a PCMCache,
   // CompilerInstance::CompilerInstance is responsible for finalizing the
-  // buffers to prevent use-after-frees.
+  // buffers to prevent use-after-frees.  An isolated build reads the module
+  // files that it imports into a PCMCache of its own.
+  IntrusiveRefCntPtr<MemoryBufferCache> PCMCache =
+      Isolated ? new MemoryBufferCache
+               : &ImportingInstance.getPreprocessor().getPCMCache();
   CompilerInstance Instance(ImportingInstance.getPCHContainerOperations(),
-                            &ImportingInstance.getPreprocessor().getPCMCache());
+                            PCMCache.get());
   auto &Inv = *Invocation;
   Instance.setInvocation(std::move(Invocation));
 
-  Instance.createDiagnostics(new ForwardingDiagnosticConsumer(
+  if (Isolated)
+    Instance.createDiagnostics(new IgnoringDiagConsumer,
+                               /*ShouldOwnClient=*/true);
+  else
+    Instance.createDiagnostics(new ForwardingDiagnosticConsumer(
                                    ImportingInstance.getDiagnosticClient()),
-                             /*ShouldOwnClient=*/true);
+                               /*ShouldOwnClient=*/true);
 
   Instance.setVirtualFileSystem(&ImportingInstance.getVirtualFileSystem());
 
   // Note that this module is part of the module build stack, so that we
   // can detect cycles in the module graph.
-  Instance.setFileManager(&ImportingInstance.getFileManager());
+  if (Isolated)
+    Instance.setFileManager(
+        new FileManager(ImportingInstance.getFileSystemOpts(),
+                        &ImportingInstance.getVirtualFileSystem()));
+  else
+    Instance.setFileManager(&ImportingInstance.getFileManager());
   Instance.createSourceManager(Instance.getFileManager());
   SourceManager &SourceMgr = Instance.getSourceManager();
   SourceMgr.setModuleBuildStack(
@@ -1151,12 +1252,14 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   // If we're collecting module dependencies, we need to share a collector
   // between all of the module CompilerInstances. Other than that, we don't
   // want to produce any dependency output from the module build.
-  Instance.setModuleDepCollector(ImportingInstance.getModuleDepCollector());
+  if (!Isolated)
+    Instance.setModuleDepCollector(ImportingInstance.getModuleDepCollector());
   Inv.getDependencyOutputOpts() = DependencyOutputOptions();
 
-  ImportingInstance.getDiagnostics().Report(ImportLoc,
-                                            diag::remark_module_build)
-    << ModuleName << ModuleFileName;
+  if (!Isolated)
+    ImportingInstance.getDiagnostics().Report(ImportLoc,
+                                              diag::remark_module_build)
+      << ModuleName << ModuleFileName;
 
   PreBuildStep(Instance);
 
@@ -1173,9 +1276,10 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
 
   PostBuildStep(Instance);
 
-  ImportingInstance.getDiagnostics().Report(ImportLoc,
-                                            diag::remark_module_build_done)
-    << ModuleName;
+  if (!Isolated)
+    ImportingInstance.getDiagnostics().Report(ImportLoc,
+                                              diag::remark_module_build_done)
+      << ModuleName;
 
   // Delete the temporary module map file.
   // FIXME: Even though we're executing under crash protection, it would still
@@ -1186,28 +1290,37 @@ compileModuleImpl(CompilerInstance &ImportingInstance, SourceLocation ImportLoc,
   return !Instance.getDiagnostics().hasErrorOccurred();
 }
 
-/// \brief Compile a module file for the given module, using the options 
-/// provided by the importing compiler instance. Returns true if the module
-/// was built without errors.
-static bool compileModuleImpl(CompilerInstance &ImportingInstance,
-                              SourceLocation ImportLoc,
-                              Module *Module,
-                              StringRef ModuleFileName) {
+namespace {
+/// \brief The inputs of the build of a module, taken from the module map of
+/// the importing compiler instance.
+struct ModuleBuildInputs {
+  std::string ModuleName;
+  FrontendInputFile Input;
+  std::string OriginalModuleMapFile;
+
+  /// \brief The contents of the module map of the input, if the module was
+  /// inferred and has no module map file of its own.
+  Optional<std::string> InferredModuleMap;
+};
+} // end anonymous namespace
+
+static ModuleBuildInputs
+getModuleBuildInputs(CompilerInstance &ImportingInstance, Module *Module) {
   InputKind IK(getLanguageFromOptions(ImportingInstance.getLangOpts()),
                InputKind::ModuleMap);
 
   // Get or create the module map that we'll use to build this module.
   ModuleMap &ModMap 
     = ImportingInstance.getPreprocessor().getHeaderSearchInfo().getModuleMap();
-  bool Result;
+  ModuleBuildInputs Inputs;
+  Inputs.ModuleName = Module->getTopLevelModuleName();
+  Inputs.OriginalModuleMapFile =
+      ModMap.getModuleMapFileForUniquing(Module)->getName();
   if (const FileEntry *ModuleMapFile =
           ModMap.getContainingModuleMapFile(Module)) {
     // Use the module map where this module resides.
-    Result = compileModuleImpl(
-        ImportingInstance, ImportLoc, Module->getTopLevelModuleName(),
-        FrontendInputFile(ModuleMapFile->getName(), IK, +Module->IsSystem),
-        ModMap.getModuleMapFileForUniquing(Module)->getName(),
-        ModuleFileName);
+    Inputs.Input =
+        FrontendInputFile(ModuleMapFile->getName(), IK, +Module->IsSystem);
   } else {
     // FIXME: We only need to fake up an input file here as a way of
     // transporting the module's directory to the module map parser. We should
@@ -1221,20 +1334,47 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
     Module->print(OS);
     OS.flush();
 
-    Result = compileModuleImpl(
-        ImportingInstance, ImportLoc, Module->getTopLevelModuleName(),
-        FrontendInputFile(FakeModuleMapFile, IK, +Module->IsSystem),
-        ModMap.getModuleMapFileForUniquing(Module)->getName(),
-        ModuleFileName,
-        [&](CompilerInstance &Instance) {
-      std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
-          llvm::MemoryBuffer::getMemBuffer(InferredModuleMapContent);
-      ModuleMapFile = Instance.getFileManager().getVirtualFile(
-          FakeModuleMapFile, InferredModuleMapContent.size(), 0);
-      Instance.getSourceManager().overrideFileContents(
-          ModuleMapFile, std::move(ModuleMapBuffer));
-    });
+    Inputs.Input = FrontendInputFile(FakeModuleMapFile, IK, +Module->IsSystem);
+    Inputs.InferredModuleMap = std::move(InferredModuleMapContent);
   }
+  return Inputs;
+}
+
+static bool compileModuleImpl(CompilerInstance &ImportingInstance,
+                              SourceLocation ImportLoc,
+                              const ModuleBuildInputs &Inputs,
+                              StringRef ModuleFileName, bool Isolated) {
+  if (!Inputs.InferredModuleMap)
+    return compileModuleImpl(
+        ImportingInstance, ImportLoc, Inputs.ModuleName, Inputs.Input,
+        Inputs.OriginalModuleMapFile, ModuleFileName,
+        [](CompilerInstance &) {}, [](CompilerInstance &) {}, Isolated);
+
+  return compileModuleImpl(
+      ImportingInstance, ImportLoc, Inputs.ModuleName, Inputs.Input,
+      Inputs.OriginalModuleMapFile, ModuleFileName,
+      [&](CompilerInstance &Instance) {
+    const std::string &InferredModuleMapContent = *Inputs.InferredModuleMap;
+    std::unique_ptr<llvm::MemoryBuffer> ModuleMapBuffer =
+        llvm::MemoryBuffer::getMemBuffer(InferredModuleMapContent);
+    const FileEntry *ModuleMapFile = Instance.getFileManager().getVirtualFile(
+        Inputs.Input.getFile(), InferredModuleMapContent.size(), 0);
+    Instance.getSourceManager().overrideFileContents(
+        ModuleMapFile, std::move(ModuleMapBuffer));
+  }, [](CompilerInstance &) {}, Isolated);
+}
+
+/// \brief Compile a module file for the given module, using the options 
+/// provided by the importing compiler instance. Returns true if the module
+/// was built without errors.
+static bool compileModuleImpl(CompilerInstance &ImportingInstance,
+                              SourceLocation ImportLoc,
+                              Module *Module,
+                              StringRef ModuleFileName) {
+  bool Result = compileModuleImpl(ImportingInstance, ImportLoc,
+                                  getModuleBuildInputs(ImportingInstance,
+                                                       Module),
+                                  ModuleFileName, /*Isolated=*/false);
 
   // We've rebuilt a module. If we're allowed to generate or update the global
   // module index, record that fact in the importing compiler instance.
@@ -1245,6 +1385,133 @@ static bool compileModuleImpl(CompilerInstance &ImportingInstance,
   return Result;
 }
 
+/// \brief Build the missing module files of the modules that \p Module uses,
+/// and of the modules that they use, on a pool of threads, so that the
+/// modules that do not depend on each other are built concurrently.
+///
+/// The use declarations of the module maps are the only dependencies between
+/// modules that are known before the modules are built. A module that fails
+/// to build here is built again, with diagnostics, when it is imported.
+static void prebuildUsedModules(CompilerInstance &ImportingInstance,
+                                SourceLocation ImportLoc, Module *Module) {
+  unsigned NumThreads =
+      ImportingInstance.getHeaderSearchOpts().ModulesBuildJobs;
+  // The module dependency collector is not safe to share between threads.
+  if (NumThreads < 2 || ImportingInstance.getModuleDepCollector())
+    return;
+
+  HeaderSearch &HS = ImportingInstance.getPreprocessor().getHeaderSearchInfo();
+  ModuleMap &ModMap = HS.getModuleMap();
+  ModuleBuildStack BuildStack =
+      ImportingInstance.getSourceManager().getModuleBuildStack();
+  const auto &FailedModules =
+      ImportingInstance.getPreprocessorOpts().FailedModules;
+
+  struct UsedModule {
+    ModuleBuildInputs Inputs;
+    std::string ModuleFileName;
+  };
+  std::vector<UsedModule> UsedModules;
+  std::vector<SmallVector<unsigned, 2>> Dependencies;
+  const unsigned NotBuilt = ~0U;
+  llvm::DenseMap<clang::Module *, unsigned> ModuleIndex;
+  ModuleIndex[Module->getTopLevelModule()] = NotBuilt;
+
+  auto forEachUse = [&](clang::Module *TopLevel,
+                        llvm::function_ref<void(clang::Module *)> Action) {
+    SmallVector<clang::Module *, 8> Worklist(1, TopLevel);
+    while (!Worklist.empty()) {
+      clang::Module *Sub = Worklist.pop_back_val();
+      ModMap.resolveUses(Sub, /*Complain=*/false);
+      for (clang::Module *Use : Sub->DirectUses)
+        Action(Use);
+      Worklist.append(Sub->submodule_begin(), Sub->submodule_end());
+    }
+  };
+
+  // Add the top-level module of \p M to the modules to build, and return its
+  // index, unless its module file does not need to be built.
+  std::function<unsigned(clang::Module *)> addModule =
+      [&](clang::Module *M) -> unsigned {
+    M = M->getTopLevelModule();
+    auto Known = ModuleIndex.find(M);
+    if (Known != ModuleIndex.end())
+      return Known->second;
+    ModuleIndex[M] = NotBuilt;
+
+    if (M->getASTFile() || !M->isAvailable() ||
+        (FailedModules && FailedModules->hasAlreadyFailed(M->Name)) ||
+        llvm::any_of(BuildStack,
+                     [&](const std::pair<std::string, FullSourceLoc> &Entry) {
+                       return Entry.first == M->Name;
+                     }))
+      return NotBuilt;
+    std::string ModuleFileName = HS.getCachedModuleFileName(M);
+    if (ModuleFileName.empty() || llvm::sys::fs::exists(ModuleFileName))
+      return NotBuilt;
+
+    unsigned Index = UsedModules.size();
+    ModuleIndex[M] = Index;
+    UsedModules.push_back(
+        {getModuleBuildInputs(ImportingInstance, M), ModuleFileName});
+    Dependencies.emplace_back();
+
+    SmallVector<unsigned, 2> Uses;
+    forEachUse(M, [&](clang::Module *Use) {
+      unsigned UseIndex = addModule(Use);
+      if (UseIndex != NotBuilt)
+        Uses.push_back(UseIndex);
+    });
+    Dependencies[Index] = std::move(Uses);
+    return Index;
+  };
+  forEachUse(Module->getTopLevelModule(),
+             [&](clang::Module *Use) { addModule(Use); });
+  if (UsedModules.empty())
+    return;
+
+  ModuleBuildCoordinator &Coordinator =
+      ModuleBuildCoordinator::getProcessCoordinator();
+  std::vector<bool> Built = ModuleBuildCoordinator::buildInDependencyOrder(
+      NumThreads, Dependencies, [&](unsigned Index) {
+        const UsedModule &Used = UsedModules[Index];
+
+        // Leave the modules that another thread or process is building to
+        // the import that needs them.
+        ModuleBuildCoordinator::BuildClaim Claim =
+            Coordinator.tryClaim(Used.ModuleFileName);
+        if (!Claim.isOwned())
+          return false;
+        llvm::sys::fs::create_directories(
+            llvm::sys::path::parent_path(Used.ModuleFileName));
+        llvm::LockFileManager Locked(Used.ModuleFileName);
+        if (Locked != llvm::LockFileManager::LFS_Owned)
+          return false;
+
+        return compileModuleImpl(ImportingInstance, ImportLoc, Used.Inputs,
+                                 Used.ModuleFileName, /*Isolated=*/true);
+      });
+
+  DiagnosticsEngine &Diags = ImportingInstance.getDiagnostics();
+  bool BuiltAny = false;
+  for (unsigned Index = 0, N = UsedModules.size(); Index != N; ++Index) {
+    if (!Built[Index])
+      continue;
+    const UsedModule &Used = UsedModules[Index];
+    Diags.Report(ImportLoc, diag::remark_module_build)
+        << Used.Inputs.ModuleName << Used.ModuleFileName;
+    Diags.Report(ImportLoc, diag::remark_module_build_done)
+        << Used.Inputs.ModuleName;
+    BuiltAny = true;
+  }
+
+  // We've rebuilt modules. If we're allowed to generate or update the global
+  // module index, record that fact in the importing compiler instance.
+  if (BuiltAny &&
+      ImportingInstance.getFrontendOpts().GenerateGlobalModuleIndex)
+    ImportingInstance.setBuildGlobalModuleIndex(true);
+}
+
 static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
                                  SourceLocation ImportLoc,
                                  SourceLocation ModuleNameLoc, Module *Module,
@@ -1261,8 +1528,31 @@ static bool compileAndLoadModule(CompilerInstance &ImportingInstance,
   StringRef Dir = llvm::sys::path::parent_path(ModuleFileName);
   llvm::sys::fs::create_directories(Dir);
 
+  prebuildUsedModules(ImportingInstance, ImportLoc, Module);
+
+  ModuleBuildCoordinator &Coordinator =
+      ModuleBuildCoordinator::getProcessCoordinator();
   while (1) {
     unsigned ModuleLoadCapabilities = ASTReader::ARR_Missing;
+
+    // If another thread of this process is building the module, wait for it
+    // to finish rather than polling its lock file, then read its result.
+    ModuleBuildCoordinator::BuildClaim Claim =
+        Coordinator.claim(ModuleFileName, std::chrono::minutes(5));
+    if (Claim.getState() == ModuleBuildCoordinator::CS_BuiltElsewhere) {
+      ASTReader::ASTReadResult ReadResult =
+          ImportingInstance.getModuleManager()->ReadAST(
+              ModuleFileName, serialization::MK_ImplicitModule, ImportLoc,
+              ModuleLoadCapabilities | ASTReader::ARR_OutOfDate);
+      // If the other thread failed, build the module ourselves.
+      if (ReadResult == ASTReader::OutOfDate ||
+          ReadResult == ASTReader::Missing)
+        continue;
+      if (ReadResult != ASTReader::Success && !Diags.hasErrorOccurred())
+        diagnoseBuildFailure();
+      return ReadResult == ASTReader::Success;
+    }
+
     llvm::LockFileManager Locked(ModuleFileName);
     switch (Locked) {
     case llvm::LockFileManager::LFS_Error:
@@ -1501,6 +1791,7 @@ void CompilerInstance::createModuleManager() {
         HSOpts.ModulesValidateSystemHeaders,
         getFrontendOpts().UseGlobalModuleIndex,
         std::move(ReadTimer));
+    ModuleManager->setModuleLoadTimerGroup(FrontendTimerGroup.get());
     if (hasASTConsumer()) {
       ModuleManager->setDeserializationListener(
         getASTConsumer().GetASTDeserializationListener());
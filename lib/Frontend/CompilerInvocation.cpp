@@ -250,15 +250,19 @@ static bool ParseAnalyzerArgs(AnalyzerOptions &Opts, ArgList &Args,
   Opts.NoRetryExhausted = Args.hasArg(OPT_analyzer_disable_retry_exhausted);
   Opts.AnalyzeAll = Args.hasArg(OPT_analyzer_opt_analyze_headers);
   Opts.AnalyzerDisplayProgress = Args.hasArg(OPT_analyzer_display_progress);
+  Opts.AnalyzerListFunctions = Args.hasArg(OPT_analyzer_list_functions);
   Opts.AnalyzeNestedBlocks =
     Args.hasArg(OPT_analyzer_opt_analyze_nested_blocks);
   Opts.eagerlyAssumeBinOpBifurcation = Args.hasArg(OPT_analyzer_eagerly_assume);
   Opts.AnalyzeSpecificFunction = Args.getLastArgValue(OPT_analyze_function);
+  Opts.IncrementalCacheDir =
+      Args.getLastArgValue(OPT_analyzer_incremental_cache);
   Opts.UnoptimizedCFG = Args.hasArg(OPT_analysis_UnoptimizedCFG);
   Opts.TrimGraph = Args.hasArg(OPT_trim_egraph);
   Opts.maxBlockVisitOnPath =
       getLastArgIntValue(Args, OPT_analyzer_max_loop, 4, Diags);
   Opts.PrintStats = Args.hasArg(OPT_analyzer_stats);
+  Opts.PrintCheckerStats = Args.hasArg(OPT_analyzer_checker_stats);
   Opts.InlineMaxStackDepth =
       getLastArgIntValue(Args, OPT_analyzer_inline_max_stack_depth,
                          Opts.InlineMaxStackDepth, Diags);
@@ -775,6 +779,53 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
   }
 
   Opts.PreserveVec3Type = Args.hasArg(OPT_fpreserve_vec3_type);
+  Opts.CheckedCHoistChecks = Args.hasFlag(OPT_fcheckedc_hoist_checks,
+                                          OPT_fno_checkedc_hoist_checks, false);
+  Opts.CheckedCCoalesceChecks =
+      Args.hasFlag(OPT_fcheckedc_coalesce_checks,
+                   OPT_fno_checkedc_coalesce_checks, false);
+  Opts.CheckedCIndexBoundsChecks =
+      Args.hasFlag(OPT_fcheckedc_index_bounds_checks,
+                   OPT_fno_checkedc_index_bounds_checks, false);
+  Opts.CheckedCSubsumeCastChecks =
+      Args.hasFlag(OPT_fcheckedc_subsume_cast_checks,
+                   OPT_fno_checkedc_subsume_cast_checks, false);
+  Opts.CheckedCCheckCalls =
+      Args.hasFlag(OPT_fcheckedc_check_calls, OPT_fno_checkedc_check_calls,
+                   false);
+  Opts.CheckedCLateCheckLowering =
+      Args.hasFlag(OPT_fcheckedc_late_check_lowering,
+                   OPT_fno_checkedc_late_check_lowering,
+                   Opts.CheckedCCheckCalls);
+  Opts.CheckedCCheckProfile =
+      Args.hasFlag(OPT_fcheckedc_check_profile,
+                   OPT_fno_checkedc_check_profile, false);
+  Opts.CheckedCVersionLoops =
+      Args.hasFlag(OPT_fcheckedc_version_loops,
+                   OPT_fno_checkedc_version_loops, false);
+  Opts.CheckedCStickyLoopChecks =
+      Args.hasFlag(OPT_fcheckedc_sticky_loop_checks,
+                   OPT_fno_checkedc_sticky_loop_checks, false);
+  Opts.CheckedCASanSkipCheckedAccesses =
+      Args.hasFlag(OPT_fcheckedc_asan_skip_checked_accesses,
+                   OPT_fno_checkedc_asan_skip_checked_accesses, false);
+  Opts.CheckedCDereferenceableBounds =
+      Args.hasFlag(OPT_fcheckedc_dereferenceable_bounds,
+                   OPT_fno_checkedc_dereferenceable_bounds, false);
+  Opts.CheckedCOverflowChecks =
+      Args.hasFlag(OPT_fcheckedc_overflow_checks,
+                   OPT_fno_checkedc_overflow_checks, false);
+  if (Arg *A = Args.getLastArg(OPT_fcheckedc_trap_blocks_EQ)) {
+    StringRef Name = A->getValue();
+    if (Name == "check")
+      Opts.setCheckedCTrapBlocks(CodeGenOptions::CheckedCTrapPerCheck);
+    else if (Name == "kind")
+      Opts.setCheckedCTrapBlocks(CodeGenOptions::CheckedCTrapPerKind);
+    else if (Name == "function")
+      Opts.setCheckedCTrapBlocks(CodeGenOptions::CheckedCTrapPerFunction);
+    else
+      Diags.Report(diag::err_drv_invalid_value) << A->getAsString(Args) << Name;
+  }
   Opts.InstrumentFunctions = Args.hasArg(OPT_finstrument_functions);
   Opts.XRayInstrumentFunctions = Args.hasArg(OPT_fxray_instrument);
   Opts.XRayInstructionThreshold =
@@ -948,6 +999,12 @@ static bool ParseCodeGenArgs(CodeGenOptions &Opts, ArgList &Args, InputKind IK,
     NeedLocTracking = true;
   }
 
+  // The checkedc-checks remarks are reported by a pass that needs the
+  // Checked C checks to be tagged when they are emitted.
+  Opts.CheckedCCheckRemarks = !Opts.OptRecordFile.empty() ||
+                              Opts.OptimizationRemarkPattern ||
+                              Opts.OptimizationRemarkMissedPattern;
+
   Opts.DiagnosticsWithHotness =
       Args.hasArg(options::OPT_fdiagnostics_show_hotness);
   bool UsingSampleProfile = !Opts.SampleProfileFile.empty();
@@ -1156,6 +1213,7 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
   Opts.setVerifyIgnoreUnexpected(DiagMask);
   Opts.ElideType = !Args.hasArg(OPT_fno_elide_type);
   Opts.ShowTemplateTree = Args.hasArg(OPT_fdiagnostics_show_template_tree);
+  Opts.DeduplicateDiagnostics = Args.hasArg(OPT_fdiagnostics_deduplicate);
   Opts.ErrorLimit = getLastArgIntValue(Args, OPT_ferror_limit, 0, Diags);
   Opts.MacroBacktraceLimit =
       getLastArgIntValue(Args, OPT_fmacro_backtrace_limit,
@@ -1172,6 +1230,8 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
   Opts.SnippetLineLimit = getLastArgIntValue(
       Args, OPT_fcaret_diagnostics_max_lines,
       DiagnosticOptions::DefaultSnippetLineLimit, Diags);
+  Opts.SnippetRepeatLimit = getLastArgIntValue(
+      Args, OPT_fdiagnostics_snippet_repeat_limit, 0, Diags);
   Opts.TabStop = getLastArgIntValue(Args, OPT_ftabstop,
                                     DiagnosticOptions::DefaultTabStop, Diags);
   if (Opts.TabStop == 0 || Opts.TabStop > DiagnosticOptions::MaxTabStop) {
@@ -1187,8 +1247,11 @@ bool clang::ParseDiagnosticArgs(DiagnosticOptions &Opts, ArgList &Args,
   return Success;
 }
 
-static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args) {
+static void ParseFileSystemArgs(FileSystemOptions &Opts, ArgList &Args,
+                                DiagnosticsEngine &Diags) {
   Opts.WorkingDir = Args.getLastArgValue(OPT_working_directory);
+  Opts.StatCachePath = Args.getLastArgValue(OPT_stat_cache);
+  Opts.MmapThreshold = getLastArgIntValue(Args, OPT_mmap_threshold, 0, Diags);
 }
 
 /// Parse the argument to the -ftest-module-file-extension
@@ -1337,7 +1400,13 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.RelocatablePCH = Args.hasArg(OPT_relocatable_pch);
   Opts.ShowHelp = Args.hasArg(OPT_help);
   Opts.ShowStats = Args.hasArg(OPT_print_stats);
+  Opts.ShowConstexprCacheStats = Args.hasArg(OPT_fconstexpr_cache_stats);
+  Opts.ShowMemoryReport = Args.hasArg(OPT_fast_memory_report);
   Opts.ShowTimers = Args.hasArg(OPT_ftime_report);
+  Opts.TimeTrace = Args.hasArg(OPT_ftime_trace);
+  Opts.TimeTraceGranularity =
+      getLastArgIntValue(Args, OPT_ftime_trace_granularity_EQ, 500, Diags);
+  Opts.AsyncOutput = Args.hasArg(OPT_fasync_output);
   Opts.ShowVersion = Args.hasArg(OPT_version);
   Opts.ASTMergeFiles = Args.getAllArgValues(OPT_ast_merge);
   Opts.LLVMArgs = Args.getAllArgValues(OPT_mllvm);
@@ -1349,6 +1418,21 @@ static InputKind ParseFrontendArgs(FrontendOptions &Opts, ArgList &Args,
   Opts.ASTDumpAll = Args.hasArg(OPT_ast_dump_all);
   Opts.ASTDumpFilter = Args.getLastArgValue(OPT_ast_dump_filter);
   Opts.ASTDumpLookups = Args.hasArg(OPT_ast_dump_lookups);
+  if (const Arg *A = Args.getLastArg(OPT_fskip_function_bodies_EQ)) {
+    StringRef Name = A->getValue();
+    unsigned Scope = llvm::StringSwitch<unsigned>(Name)
+                         .Case("all", SFBS_All)
+                         .Case("headers", SFBS_Headers)
+                         .Case("system-headers", SFBS_SystemHeaders)
+                         .Default(~0U);
+    if (Scope == ~0U) {
+      Diags.Report(diag::err_drv_invalid_value) << A->getAsString(Args)
+                                                << Name;
+    } else {
+      Opts.SkipFunctionBodies = true;
+      Opts.SkipFunctionBodiesIn = Scope;
+    }
+  }
   Opts.UseGlobalModuleIndex = !Args.hasArg(OPT_fno_modules_global_index);
   Opts.GenerateGlobalModuleIndex = Opts.UseGlobalModuleIndex;
   Opts.ModuleMapFiles = Args.getAllArgValues(OPT_fmodule_map_file);
@@ -1569,8 +1653,12 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
   }
   for (const Arg *A : Args.filtered(OPT_fprebuilt_module_path))
     Opts.AddPrebuiltModulePath(A->getValue());
+  Opts.LookupCachePath = Args.getLastArgValue(OPT_header_search_cache);
   Opts.DisableModuleHash = Args.hasArg(OPT_fdisable_module_hash);
   Opts.ModulesHashContent = Args.hasArg(OPT_fmodules_hash_content);
+  Opts.ModulesShareBuffers = Args.hasArg(OPT_fmodules_share_buffers);
+  Opts.ModulesBuildJobs =
+      getLastArgIntValue(Args, OPT_fmodules_build_jobs_EQ, 0);
   Opts.ModulesValidateDiagnosticOptions =
       !Args.hasArg(OPT_fmodules_disable_diagnostic_validation);
   Opts.ImplicitModuleMaps = Args.hasArg(OPT_fimplicit_module_maps);
@@ -1585,6 +1673,10 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
       getLastArgUInt64Value(Args, OPT_fbuild_session_timestamp, 0);
   Opts.ModulesValidateSystemHeaders =
       Args.hasArg(OPT_fmodules_validate_system_headers);
+  Opts.ValidateASTInputFilesContent =
+      Args.hasArg(OPT_fvalidate_ast_input_files_content);
+  Opts.ASTInputFilesManifest =
+      Args.getLastArgValue(OPT_fast_input_files_manifest_EQ);
   if (const Arg *A = Args.getLastArg(OPT_fmodule_format_EQ))
     Opts.ModuleFormat = A->getValue();
 
@@ -1598,6 +1690,7 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
   bool IsIndexHeaderMap = false;
   bool IsSysrootSpecified =
       Args.hasArg(OPT__sysroot_EQ) || Args.hasArg(OPT_isysroot);
+  SmallString<128> Buffer;
   for (const Arg *A : Args.filtered(OPT_I, OPT_F, OPT_index_header_map)) {
     if (A->getOption().matches(OPT_index_header_map)) {
       // -index-header-map applies to the next -I or -F.
@@ -1609,13 +1702,14 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
         IsIndexHeaderMap ? frontend::IndexHeaderMap : frontend::Angled;
 
     bool IsFramework = A->getOption().matches(OPT_F);
-    std::string Path = A->getValue();
-
-    if (IsSysrootSpecified && !IsFramework && A->getValue()[0] == '=') {
-      SmallString<32> Buffer;
-      llvm::sys::path::append(Buffer, Opts.Sysroot,
-                              llvm::StringRef(A->getValue()).substr(1));
-      Path = Buffer.str();
+    // Refer to the argument itself rather than copying it, unless the sysroot
+    // has to be prepended.
+    StringRef Path = A->getValue();
+
+    if (IsSysrootSpecified && !IsFramework && Path.startswith("=")) {
+      Buffer.clear();
+      llvm::sys::path::append(Buffer, Opts.Sysroot, Path.substr(1));
+      Path = Buffer;
     }
 
     Opts.AddPath(Path, Group, IsFramework,
@@ -1627,12 +1721,16 @@ static void ParseHeaderSearchArgs(HeaderSearchOptions &Opts, ArgList &Args,
   StringRef Prefix = ""; // FIXME: This isn't the correct default prefix.
   for (const Arg *A :
        Args.filtered(OPT_iprefix, OPT_iwithprefix, OPT_iwithprefixbefore)) {
-    if (A->getOption().matches(OPT_iprefix))
+    if (A->getOption().matches(OPT_iprefix)) {
       Prefix = A->getValue();
-    else if (A->getOption().matches(OPT_iwithprefix))
-      Opts.AddPath(Prefix.str() + A->getValue(), frontend::After, false, true);
-    else
-      Opts.AddPath(Prefix.str() + A->getValue(), frontend::Angled, false, true);
+      continue;
+    }
+    Buffer = Prefix;
+    Buffer += A->getValue();
+    Opts.AddPath(Buffer, A->getOption().matches(OPT_iwithprefix)
+                             ? frontend::After
+                             : frontend::Angled,
+                 false, true);
   }
 
   for (const Arg *A : Args.filtered(OPT_idirafter))
@@ -2152,6 +2250,16 @@ static void ParseLangArgs(LangOptions &Opts, ArgList &Args, InputKind IK,
 
   if (Args.hasArg(OPT_fdump_inferred_bounds))
     Opts.DumpInferredBounds = true;
+  Opts.CheckedCFlowSensitiveBounds =
+    Args.hasFlag(OPT_fcheckedc_flow_sensitive_bounds,
+                 OPT_fno_checkedc_flow_sensitive_bounds, false);
+  Opts.CheckedCSymbolicBounds =
+    Args.hasFlag(OPT_fcheckedc_symbolic_bounds,
+                 OPT_fno_checkedc_symbolic_bounds, false);
+  Opts.CheckedCTimeReportFile =
+    Args.getLastArgValue(OPT_fcheckedc_time_report_json_EQ);
+  Opts.CheckedCTimeReport = Args.hasArg(OPT_fcheckedc_time_report) ||
+                            !Opts.CheckedCTimeReportFile.empty();
 
   Opts.WritableStrings = Args.hasArg(OPT_fwritable_strings);
   Opts.ConstStrings = Args.hasFlag(OPT_fconst_strings, OPT_fno_const_strings,
@@ -2575,6 +2683,7 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
       Opts.TokenCache = A->getValue();
   else
     Opts.TokenCache = Opts.ImplicitPTHInclude;
+  Opts.TokenCacheByContent = Args.hasArg(OPT_token_cache_by_content);
   Opts.UsePredefines = !Args.hasArg(OPT_undef);
   Opts.DetailedRecord = Args.hasArg(OPT_detailed_preprocessing_record);
   Opts.DisablePCHValidation = Args.hasArg(OPT_fno_validate_pch);
@@ -2646,6 +2755,14 @@ static void ParsePreprocessorArgs(PreprocessorOptions &Opts, ArgList &Args,
   // "editor placeholder in source file" error in PP only mode.
   if (isStrictlyPreprocessorAction(Action))
     Opts.LexEditorPlaceholders = false;
+
+  // Minimized sources cannot be parsed, only preprocessed.
+  if (isStrictlyPreprocessorAction(Action)) {
+    Opts.MinimizeSourceForDependencies =
+        Args.hasArg(OPT_minimize_source_for_dependencies);
+    Opts.MinimizedSourceCachePath =
+        Args.getLastArgValue(OPT_minimized_source_cache);
+  }
 }
 
 static void ParsePreprocessorOutputArgs(PreprocessorOutputOptions &Opts,
@@ -2733,7 +2850,7 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
       ParseDiagnosticArgs(Res.getDiagnosticOpts(), Args, &Diags,
                           false /*DefaultDiagColor*/, false /*DefaultShowOpt*/);
   ParseCommentArgs(LangOpts.CommentOpts, Args);
-  ParseFileSystemArgs(Res.getFileSystemOpts(), Args);
+  ParseFileSystemArgs(Res.getFileSystemOpts(), Args, Diags);
   // FIXME: We shouldn't have to pass the DashX option around here
   InputKind DashX = ParseFrontendArgs(Res.getFrontendOpts(), Args, Diags,
                                       LangOpts.IsHeaderFile);
@@ -2762,6 +2879,12 @@ bool CompilerInvocation::CreateFromArgs(CompilerInvocation &Res,
                   Res.getPreprocessorOpts(), Diags);
     if (Res.getFrontendOpts().ProgramAction == frontend::RewriteObjC)
       LangOpts.ObjCExceptions = 1;
+    // Function bodies can only be discarded when nothing but the
+    // diagnostics of Sema looks at the AST.
+    LangOpts.DiscardFunctionBodies =
+        Args.hasArg(OPT_fdiscard_function_bodies) &&
+        Res.getFrontendOpts().ProgramAction == frontend::ParseSyntaxOnly &&
+        Res.getFrontendOpts().AddPluginActions.empty();
   }
 
   if (LangOpts.CUDA) {
@@ -2959,8 +3082,12 @@ createVFSFromCompilerInvocation(const CompilerInvocation &CI,
       return IntrusiveRefCntPtr<vfs::FileSystem>();
     }
 
-    IntrusiveRefCntPtr<vfs::FileSystem> FS = vfs::getVFSFromYAML(
-        std::move(Buffer.get()), /*DiagHandler*/ nullptr, File);
+    IntrusiveRefCntPtr<vfs::FileSystem> FS;
+    if (vfs::isContentStore(Buffer.get()->getBuffer()))
+      FS = vfs::getVFSFromContentStore(std::move(Buffer.get()));
+    else
+      FS = vfs::getVFSFromYAML(std::move(Buffer.get()),
+                               /*DiagHandler*/ nullptr, File);
     if (!FS.get()) {
       Diags.Report(diag::err_invalid_vfs_overlay) << File;
       return IntrusiveRefCntPtr<vfs::FileSystem>();
@@ -923,6 +923,12 @@ void FrontendAction::EndSourceFile() {
   // Finalize the action.
   EndSourceFileAction();
 
+  if (CI.getFrontendOpts().ShowConstexprCacheStats && CI.hasASTContext())
+    CI.getASTContext().PrintConstexprCacheStats();
+
+  if (CI.getFrontendOpts().ShowMemoryReport && CI.hasASTContext())
+    CI.getASTContext().PrintMemoryReport(llvm::errs());
+
   // Sema references the ast consumer, so reset sema first.
   //
   // FIXME: There is more per-file stuff we could just drop here?
@@ -950,6 +956,10 @@ void FrontendAction::EndSourceFile() {
   // FrontendAction.
   CI.clearOutputFiles(/*EraseFiles=*/shouldEraseOutputFiles());
 
+  if (CI.hasPreprocessor())
+    CI.getPreprocessor().getHeaderSearchInfo().saveSharedLookupCache();
+  CI.saveSharedStatCache();
+
   if (isCurrentFileAST()) {
     if (DisableFree) {
       CI.resetAndLeakPreprocessor();
@@ -995,8 +1005,17 @@ void ASTFrontendAction::ExecuteAction() {
   if (!CI.hasSema())
     CI.createSema(getTranslationUnitKind(), CompletionConsumer);
 
+  // The memory report breaks the declarations and statements down by kind
+  // from their global statistics.
+  if (CI.getFrontendOpts().ShowMemoryReport) {
+    Decl::EnableStatistics();
+    Stmt::EnableStatistics();
+  }
+
   ParseAST(CI.getSema(), CI.getFrontendOpts().ShowStats,
-           CI.getFrontendOpts().SkipFunctionBodies);
+           CI.getFrontendOpts().SkipFunctionBodies,
+           static_cast<SkipFunctionBodiesScope>(
+               CI.getFrontendOpts().SkipFunctionBodiesIn));
 }
 
 void PluginASTAction::anchor() { }
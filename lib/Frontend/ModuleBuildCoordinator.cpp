@@ -0,0 +1,114 @@
+//===--- ModuleBuildCoordinator.cpp - Coordinate module builds ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the ModuleBuildCoordinator class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/ModuleBuildCoordinator.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <functional>
+
+using namespace clang;
+
+ModuleBuildCoordinator::BuildClaim::~BuildClaim() {
+  if (State == CS_Owned)
+    Coordinator->release(ModuleFileName);
+}
+
+ModuleBuildCoordinator::BuildClaim
+ModuleBuildCoordinator::claim(StringRef ModuleFileName,
+                              std::chrono::seconds Timeout) {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  if (Building.insert(ModuleFileName).second)
+    return BuildClaim(this, ModuleFileName, CS_Owned);
+
+  bool Finished = BuildFinished.wait_for(Lock, Timeout, [&] {
+    return !Building.count(ModuleFileName);
+  });
+  return BuildClaim(this, ModuleFileName,
+                    Finished ? CS_BuiltElsewhere : CS_Busy);
+}
+
+ModuleBuildCoordinator::BuildClaim
+ModuleBuildCoordinator::tryClaim(StringRef ModuleFileName) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  if (Building.insert(ModuleFileName).second)
+    return BuildClaim(this, ModuleFileName, CS_Owned);
+  return BuildClaim(this, ModuleFileName, CS_Busy);
+}
+
+bool ModuleBuildCoordinator::isBeingBuilt(StringRef ModuleFileName) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  return Building.count(ModuleFileName);
+}
+
+void ModuleBuildCoordinator::release(StringRef ModuleFileName) {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Building.erase(ModuleFileName);
+  }
+  BuildFinished.notify_all();
+}
+
+std::vector<bool> ModuleBuildCoordinator::buildInDependencyOrder(
+    unsigned NumThreads, ArrayRef<SmallVector<unsigned, 2>> Dependencies,
+    llvm::function_ref<bool(unsigned)> Build) {
+  unsigned NumNodes = Dependencies.size();
+
+  // Compute the length of the longest chain of dependencies of each node;
+  // the nodes with the same depth do not depend on each other.
+  enum { Unvisited, Visiting, Visited };
+  std::vector<char> VisitState(NumNodes, Unvisited);
+  std::vector<unsigned> Depth(NumNodes, 0);
+  std::vector<SmallVector<unsigned, 2>> AcyclicDependencies(NumNodes);
+  unsigned MaxDepth = 0;
+  std::function<void(unsigned)> Visit = [&](unsigned Node) {
+    VisitState[Node] = Visiting;
+    for (unsigned Dep : Dependencies[Node]) {
+      if (Dep >= NumNodes || VisitState[Dep] == Visiting)
+        continue;
+      if (VisitState[Dep] == Unvisited)
+        Visit(Dep);
+      AcyclicDependencies[Node].push_back(Dep);
+      Depth[Node] = std::max(Depth[Node], Depth[Dep] + 1);
+    }
+    MaxDepth = std::max(MaxDepth, Depth[Node]);
+    VisitState[Node] = Visited;
+  };
+  for (unsigned Node = 0; Node != NumNodes; ++Node)
+    if (VisitState[Node] == Unvisited)
+      Visit(Node);
+
+  // Build the nodes one depth at a time. Each task writes its own element,
+  // so the results are not packed into a vector<bool> until the end.
+  std::vector<char> Succeeded(NumNodes, false);
+  llvm::ThreadPool Pool(std::max(NumThreads, 1u));
+  for (unsigned D = 0; NumNodes && D <= MaxDepth; ++D) {
+    for (unsigned Node = 0; Node != NumNodes; ++Node) {
+      if (Depth[Node] != D)
+        continue;
+      bool DependenciesBuilt =
+          std::all_of(AcyclicDependencies[Node].begin(),
+                      AcyclicDependencies[Node].end(),
+                      [&](unsigned Dep) { return Succeeded[Dep]; });
+      if (DependenciesBuilt)
+        Pool.async([&, Node] { Succeeded[Node] = Build(Node); });
+    }
+    Pool.wait();
+  }
+
+  return std::vector<bool>(Succeeded.begin(), Succeeded.end());
+}
+
+ModuleBuildCoordinator &ModuleBuildCoordinator::getProcessCoordinator() {
+  static ModuleBuildCoordinator Coordinator;
+  return Coordinator;
+}
@@ -203,8 +203,11 @@ llvm::ErrorOr<PrecompiledPreamble> PrecompiledPreamble::Build(
     const llvm::MemoryBuffer *MainFileBuffer, PreambleBounds Bounds,
     DiagnosticsEngine &Diagnostics, IntrusiveRefCntPtr<vfs::FileSystem> VFS,
     std::shared_ptr<PCHContainerOperations> PCHContainerOps,
-    PreambleCallbacks &Callbacks) {
+    PreambleCallbacks &Callbacks,
+    std::shared_ptr<const PrecompiledPreamble> Base) {
   assert(VFS && "VFS is null");
+  assert((!Base || Base->PreambleBytes.size() < Bounds.Size) &&
+         "Base preamble is not a prefix of the new one?");
 
   if (!Bounds.Size)
     return BuildPreambleError::PreambleIsEmpty;
@@ -232,8 +235,19 @@ llvm::ErrorOr<PrecompiledPreamble> PrecompiledPreamble::Build(
   FrontendOpts.ProgramAction = frontend::GeneratePCH;
   // FIXME: Generate the precompiled header into memory?
   FrontendOpts.OutputFile = PreamblePCHFile->getFilePath();
-  PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
-  PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  if (Base) {
+    // Load the PCH of the base preamble, and only preprocess the directives
+    // that follow it. The PCH we write is then chained on top of it.
+    PreprocessorOpts.PrecompiledPreambleBytes.first =
+        Base->PreambleBytes.size();
+    PreprocessorOpts.PrecompiledPreambleBytes.second =
+        Base->PreambleEndsAtStartOfLine;
+    PreprocessorOpts.ImplicitPCHInclude = Base->GetPCHPath();
+    PreprocessorOpts.DisablePCHValidation = true;
+  } else {
+    PreprocessorOpts.PrecompiledPreambleBytes.first = 0;
+    PreprocessorOpts.PrecompiledPreambleBytes.second = false;
+  }
   // Inform preprocessor to record conditional stack when building the preamble.
   PreprocessorOpts.GeneratePreamble = true;
 
@@ -309,6 +323,9 @@ llvm::ErrorOr<PrecompiledPreamble> PrecompiledPreamble::Build(
 
   Act->Execute();
 
+  bool PreambleEndsInConditional =
+      Clang->getPreprocessor().hasRecordedPreamble();
+
   // Run the callbacks.
   Callbacks.AfterExecute(*Clang);
 
@@ -320,6 +337,8 @@ llvm::ErrorOr<PrecompiledPreamble> PrecompiledPreamble::Build(
   // Keep track of all of the files that the source manager knows about,
   // so we can verify whether they have changed or not.
   llvm::StringMap<PrecompiledPreamble::PreambleFileHash> FilesInPreamble;
+  if (Base)
+    FilesInPreamble = Base->FilesInPreamble;
 
   SourceManager &SourceMgr = Clang->getSourceManager();
   for (auto &Filename : PreambleDepCollector->getDependencies()) {
@@ -339,7 +358,8 @@ llvm::ErrorOr<PrecompiledPreamble> PrecompiledPreamble::Build(
 
   return PrecompiledPreamble(
       std::move(*PreamblePCHFile), std::move(PreambleBytes),
-      PreambleEndsAtStartOfLine, std::move(FilesInPreamble));
+      PreambleEndsAtStartOfLine, PreambleEndsInConditional,
+      std::move(FilesInPreamble), std::move(Base));
 }
 
 PreambleBounds PrecompiledPreamble::getBounds() const {
@@ -355,10 +375,6 @@ bool PrecompiledPreamble::CanReuse(const CompilerInvocation &Invocation,
       Bounds.Size <= MainFileBuffer->getBufferSize() &&
       "Buffer is too large. Bounds were calculated from a different buffer?");
 
-  auto PreambleInvocation = std::make_shared<CompilerInvocation>(Invocation);
-  PreprocessorOptions &PreprocessorOpts =
-      PreambleInvocation->getPreprocessorOpts();
-
   if (!Bounds.Size)
     return false;
 
@@ -373,7 +389,39 @@ bool PrecompiledPreamble::CanReuse(const CompilerInvocation &Invocation,
     return false;
   // The preamble has not changed. We may be able to re-use the precompiled
   // preamble.
+  return FilesInPreambleUnchanged(Invocation.getPreprocessorOpts(), VFS);
+}
+
+bool PrecompiledPreamble::CanExtend(const CompilerInvocation &Invocation,
+                                    const llvm::MemoryBuffer *MainFileBuffer,
+                                    PreambleBounds Bounds,
+                                    vfs::FileSystem *VFS) const {
+  assert(
+      Bounds.Size <= MainFileBuffer->getBufferSize() &&
+      "Buffer is too large. Bounds were calculated from a different buffer?");
+
+  // Each layer is an AST file that lookups have to go through, so keep the
+  // chain short and rebuild the whole preamble once it gets too long.
+  const unsigned MaxNumLayers = 8;
+  if (getNumLayers() >= MaxNumLayers)
+    return false;
+
+  // The new directives must start on a line of their own, outside of any
+  // conditional directive of our preamble.
+  if (!PreambleEndsAtStartOfLine || PreambleEndsInConditional)
+    return false;
+
+  // The new preamble must start with ours.
+  if (Bounds.Size <= PreambleBytes.size() ||
+      memcmp(PreambleBytes.data(), MainFileBuffer->getBufferStart(),
+             PreambleBytes.size()) != 0)
+    return false;
+
+  return FilesInPreambleUnchanged(Invocation.getPreprocessorOpts(), VFS);
+}
 
+bool PrecompiledPreamble::FilesInPreambleUnchanged(
+    const PreprocessorOptions &PreprocessorOpts, vfs::FileSystem *VFS) const {
   // Check that none of the files used by the preamble have changed.
   // First, make a record of those files that have been overridden via
   // remapping or unsaved_files.
@@ -443,11 +491,14 @@ void PrecompiledPreamble::AddImplicitPreamble(
 
 PrecompiledPreamble::PrecompiledPreamble(
     TempPCHFile PCHFile, std::vector<char> PreambleBytes,
-    bool PreambleEndsAtStartOfLine,
-    llvm::StringMap<PreambleFileHash> FilesInPreamble)
+    bool PreambleEndsAtStartOfLine, bool PreambleEndsInConditional,
+    llvm::StringMap<PreambleFileHash> FilesInPreamble,
+    std::shared_ptr<const PrecompiledPreamble> Base)
     : PCHFile(std::move(PCHFile)), FilesInPreamble(std::move(FilesInPreamble)),
       PreambleBytes(std::move(PreambleBytes)),
-      PreambleEndsAtStartOfLine(PreambleEndsAtStartOfLine) {}
+      PreambleEndsAtStartOfLine(PreambleEndsAtStartOfLine),
+      PreambleEndsInConditional(PreambleEndsInConditional),
+      Base(std::move(Base)) {}
 
 llvm::ErrorOr<PrecompiledPreamble::TempPCHFile>
 PrecompiledPreamble::TempPCHFile::CreateNewPreamblePCHFile() {
@@ -0,0 +1,398 @@
+//===--- SerializedDiagnosticTable.cpp - Aggregated diagnostics -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file contains the implementation of diagnostic tables.
+//
+//  The table starts with a header of the magic number, the version, the number
+//  of diagnostics and the offsets of its columns and indices, all of them 32
+//  bit little endian. The columns, one value per diagnostic, are:
+//  - the severity, a serialized_diags::Level;
+//  - the offsets of the name of the compilation and of the file name;
+//  - the line and the column;
+//  - the offsets of the category, the flag and the message;
+//  - the index of the diagnostic a note is attached to, or ~0.
+//  The strings, each of them its length followed by its characters, lie
+//  between the header and the columns. The indices by file name and by flag
+//  are on-disk hash tables, which map each string to the indices of its
+//  diagnostics.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/SerializedDiagnosticTable.h"
+#include "clang/Frontend/SerializedDiagnosticReader.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+namespace serialized_diags {
+
+namespace {
+
+const char DiagnosticTableMagic[] = {'C', 'D', 'T', 'B'};
+const uint32_t DiagnosticTableVersion = 1;
+const unsigned DiagnosticTableNumColumns = 9;
+const size_t DiagnosticTableHeaderSize = 12 + 4 * DiagnosticTableNumColumns + 8;
+
+/// The traits of the on-disk hash tables of the table, which map file names
+/// and flags to the indices of their diagnostics.
+class DiagnosticIndexInfo {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef data_type;
+  typedef StringRef data_type_ref;
+  typedef StringRef internal_key_type;
+  typedef StringRef external_key_type;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+  static hash_value_type ComputeHash(internal_key_type Key) {
+    return llvm::HashString(Key);
+  }
+  static internal_key_type GetInternalKey(external_key_type Key) {
+    return Key;
+  }
+  static external_key_type GetExternalKey(internal_key_type Key) {
+    return Key;
+  }
+
+  static std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<offset_type>(Key.size());
+    LE.write<offset_type>(Data.size());
+    return std::make_pair(Key.size(), Data.size());
+  }
+  static void EmitKey(raw_ostream &Out, key_type_ref Key, offset_type) {
+    Out << Key;
+  }
+  static void EmitData(raw_ostream &Out, key_type_ref, data_type_ref Data,
+                       offset_type) {
+    Out << Data;
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<offset_type, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<offset_type, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+  static internal_key_type ReadKey(const unsigned char *D, offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+  static data_type ReadData(internal_key_type, const unsigned char *D,
+                            offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+};
+
+typedef llvm::OnDiskChainedHashTable<DiagnosticIndexInfo> DiagnosticIndexTable;
+
+} // end namespace
+
+const unsigned DiagnosticTable::NoParent;
+
+/// \brief Reads a serialized diagnostics file into the columns of a
+/// DiagnosticTableBuilder.
+class DiagnosticTableReader : public SerializedDiagnosticReader {
+public:
+  DiagnosticTableReader(DiagnosticTableBuilder &Builder, uint32_t Compilation)
+      : Builder(Builder), Compilation(Compilation) {}
+
+protected:
+  std::error_code visitStartOfDiagnostic() override {
+    Stack.push_back(DiagnosticTable::NoParent);
+    return std::error_code();
+  }
+
+  std::error_code visitEndOfDiagnostic() override {
+    if (!Stack.empty())
+      Stack.pop_back();
+    return std::error_code();
+  }
+
+  std::error_code visitCategoryRecord(unsigned ID, StringRef Name) override {
+    Categories[ID] = Builder.intern(Name);
+    return std::error_code();
+  }
+
+  std::error_code visitDiagFlagRecord(unsigned ID, StringRef Name) override {
+    Flags[ID] = Builder.intern(Name);
+    return std::error_code();
+  }
+
+  std::error_code visitFilenameRecord(unsigned ID, unsigned Size,
+                                      unsigned Timestamp,
+                                      StringRef Name) override {
+    Filenames[ID] = Builder.intern(Name);
+    return std::error_code();
+  }
+
+  std::error_code visitDiagnosticRecord(unsigned Severity,
+                                        const Location &Location,
+                                        unsigned Category, unsigned Flag,
+                                        StringRef Message) override {
+    uint32_t Index = Builder.Severities.size();
+    uint32_t Parent = DiagnosticTable::NoParent;
+    if (!Stack.empty()) {
+      if (Stack.size() > 1)
+        Parent = Stack[Stack.size() - 2];
+      Stack.back() = Index;
+    }
+    // The IDs that were not defined, including 0, map to the empty string.
+    Builder.Severities.push_back(Severity);
+    Builder.Compilations.push_back(Compilation);
+    Builder.Filenames.push_back(Filenames.lookup(Location.FileID));
+    Builder.Lines.push_back(Location.Line);
+    Builder.Columns.push_back(Location.Col);
+    Builder.Categories.push_back(Categories.lookup(Category));
+    Builder.Flags.push_back(Flags.lookup(Flag));
+    Builder.Messages.push_back(Builder.intern(Message));
+    Builder.Parents.push_back(Parent);
+    return std::error_code();
+  }
+
+private:
+  DiagnosticTableBuilder &Builder;
+  uint32_t Compilation;
+
+  /// The maps from the IDs of the file to the indices of the strings.
+  llvm::DenseMap<unsigned, uint32_t> Categories;
+  llvm::DenseMap<unsigned, uint32_t> Flags;
+  llvm::DenseMap<unsigned, uint32_t> Filenames;
+
+  /// The indices of the diagnostics whose blocks are being read.
+  SmallVector<uint32_t, 4> Stack;
+};
+
+DiagnosticTableBuilder::DiagnosticTableBuilder() {
+  // The empty string comes first, since missing strings map to 0.
+  intern("");
+}
+
+uint32_t DiagnosticTableBuilder::intern(StringRef S) {
+  auto Inserted = StringIndices.insert(std::make_pair(S, Strings.size()));
+  if (Inserted.second)
+    Strings.push_back(Inserted.first->getKey());
+  return Inserted.first->second;
+}
+
+std::error_code
+DiagnosticTableBuilder::addSerializedDiagnostics(StringRef File,
+                                                 StringRef Compilation) {
+  size_t NumDiagnostics = Severities.size();
+  uint32_t CompilationIndex = intern(Compilation.empty() ? File : Compilation);
+  DiagnosticTableReader Reader(*this, CompilationIndex);
+  std::error_code EC = Reader.readDiagnostics(File);
+  if (EC) {
+    // Drop the diagnostics of a file which could not be read entirely.
+    for (std::vector<uint32_t> *Column :
+         {&Severities, &Compilations, &Filenames, &Lines, &Columns,
+          &Categories, &Flags, &Messages, &Parents})
+      Column->resize(NumDiagnostics);
+  }
+  return EC;
+}
+
+std::string DiagnosticTableBuilder::serialize() const {
+  using namespace llvm::support;
+  SmallString<4096> Result;
+  llvm::raw_svector_ostream OS(Result);
+  endian::Writer<little> LE(OS);
+  OS.write(DiagnosticTableMagic, sizeof(DiagnosticTableMagic));
+  LE.write<uint32_t>(DiagnosticTableVersion);
+  while (OS.tell() != DiagnosticTableHeaderSize)
+    LE.write<uint32_t>(0);
+
+  std::vector<uint32_t> StringOffsets;
+  StringOffsets.reserve(Strings.size());
+  for (StringRef S : Strings) {
+    StringOffsets.push_back(OS.tell());
+    LE.write<uint32_t>(S.size());
+    OS << S;
+  }
+  while (OS.tell() % 4)
+    LE.write<uint8_t>(0);
+
+  auto WriteColumn = [&](const std::vector<uint32_t> &Column,
+                         bool IsString) -> uint32_t {
+    uint32_t Offset = OS.tell();
+    for (uint32_t Value : Column)
+      LE.write<uint32_t>(IsString ? StringOffsets[Value] : Value);
+    return Offset;
+  };
+  uint32_t Header[DiagnosticTableNumColumns + 3];
+  Header[0] = Severities.size();
+  Header[1] = WriteColumn(Severities, false);
+  Header[2] = WriteColumn(Compilations, true);
+  Header[3] = WriteColumn(Filenames, true);
+  Header[4] = WriteColumn(Lines, false);
+  Header[5] = WriteColumn(Columns, false);
+  Header[6] = WriteColumn(Categories, true);
+  Header[7] = WriteColumn(Flags, true);
+  Header[8] = WriteColumn(Messages, true);
+  Header[9] = WriteColumn(Parents, false);
+
+  auto WriteIndex = [&](const std::vector<uint32_t> &Column) -> uint32_t {
+    llvm::MapVector<uint32_t, std::string> Diagnostics;
+    for (uint32_t I = 0, E = Column.size(); I != E; ++I) {
+      if (Column[I] == 0)
+        continue;
+      llvm::raw_string_ostream Indices(Diagnostics[Column[I]]);
+      endian::Writer<little>(Indices).write<uint32_t>(I);
+    }
+    llvm::OnDiskChainedHashTableGenerator<DiagnosticIndexInfo> Generator;
+    for (const auto &Entry : Diagnostics)
+      Generator.insert(Strings[Entry.first], Entry.second);
+    return Generator.Emit(OS);
+  };
+  Header[10] = WriteIndex(Filenames);
+  Header[11] = WriteIndex(Flags);
+
+  for (unsigned I = 0; I != llvm::array_lengthof(Header); ++I)
+    endian::write32le(&Result[8 + 4 * I], Header[I]);
+  return Result.str();
+}
+
+std::unique_ptr<DiagnosticTable>
+DiagnosticTable::loadFromFile(StringRef FilePath, std::string &ErrorMessage) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> TableBuffer =
+      llvm::MemoryBuffer::getFile(FilePath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (std::error_code Result = TableBuffer.getError()) {
+    ErrorMessage = "Error while opening diagnostic table: " + Result.message();
+    return nullptr;
+  }
+  return loadFromBuffer(std::move(*TableBuffer), ErrorMessage);
+}
+
+std::unique_ptr<DiagnosticTable>
+DiagnosticTable::loadFromBuffer(std::unique_ptr<llvm::MemoryBuffer> Buffer,
+                                std::string &ErrorMessage) {
+  std::unique_ptr<DiagnosticTable> Table(
+      new DiagnosticTable(std::move(Buffer)));
+  if (!Table->readHeader(ErrorMessage))
+    return nullptr;
+  return Table;
+}
+
+bool DiagnosticTable::readHeader(std::string &ErrorMessage) {
+  using namespace llvm::support;
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < DiagnosticTableHeaderSize ||
+      !Data.startswith(
+          StringRef(DiagnosticTableMagic, sizeof(DiagnosticTableMagic)))) {
+    ErrorMessage = "Not a diagnostic table.";
+    return false;
+  }
+  const unsigned char *Base = Data.bytes_begin();
+  if (endian::read32le(Base + 4) != DiagnosticTableVersion) {
+    ErrorMessage = "Unsupported diagnostic table version.";
+    return false;
+  }
+  NumDiagnostics = endian::read32le(Base + 8);
+  uint32_t *Offsets[] = {&SeverityOffset, &CompilationOffset, &FilenameOffset,
+                         &LineOffset,     &ColumnOffset,      &CategoryOffset,
+                         &FlagOffset,     &MessageOffset,     &ParentOffset,
+                         &FileIndexOffset, &FlagIndexOffset};
+  for (unsigned I = 0; I != llvm::array_lengthof(Offsets); ++I)
+    *Offsets[I] = endian::read32le(Base + 12 + 4 * I);
+
+  auto InBounds = [&](uint64_t Offset, uint64_t Size) {
+    return Offset >= DiagnosticTableHeaderSize && Offset + Size <= Data.size();
+  };
+  bool Valid = true;
+  for (unsigned I = 0; I != DiagnosticTableNumColumns; ++I)
+    Valid &= InBounds(*Offsets[I], uint64_t(NumDiagnostics) * 4);
+  // Each bucket array starts with the number of buckets and of entries.
+  for (uint32_t IndexOffset : {FileIndexOffset, FlagIndexOffset}) {
+    if (!Valid || IndexOffset % 4 != 0 || !InBounds(IndexOffset, 8)) {
+      Valid = false;
+      break;
+    }
+    uint64_t NumBuckets = endian::read32le(Base + IndexOffset);
+    Valid = NumBuckets != 0 && InBounds(IndexOffset, 8 + NumBuckets * 4);
+  }
+  if (!Valid) {
+    ErrorMessage = "Malformed diagnostic table.";
+    return false;
+  }
+  return true;
+}
+
+uint32_t DiagnosticTable::getValue(uint32_t ColumnOffset,
+                                   unsigned Index) const {
+  assert(Index < NumDiagnostics && "Invalid diagnostic index");
+  return llvm::support::endian::read32le(Buffer->getBuffer().bytes_begin() +
+                                         ColumnOffset + Index * 4);
+}
+
+StringRef DiagnosticTable::getString(uint32_t Offset) const {
+  StringRef Data = Buffer->getBuffer();
+  if (uint64_t(Offset) + 4 > Data.size())
+    return StringRef();
+  uint32_t Length =
+      llvm::support::endian::read32le(Data.bytes_begin() + Offset);
+  return Data.substr(Offset + 4, Length);
+}
+
+DiagnosticTable::Entry DiagnosticTable::getDiagnostic(unsigned Index) const {
+  Entry Result;
+  Result.Severity = getValue(SeverityOffset, Index);
+  Result.Compilation = getString(getValue(CompilationOffset, Index));
+  Result.Filename = getString(getValue(FilenameOffset, Index));
+  Result.Line = getValue(LineOffset, Index);
+  Result.Column = getValue(ColumnOffset, Index);
+  Result.Category = getString(getValue(CategoryOffset, Index));
+  Result.Flag = getString(getValue(FlagOffset, Index));
+  Result.Message = getString(getValue(MessageOffset, Index));
+  Result.Parent = getValue(ParentOffset, Index);
+  return Result;
+}
+
+std::vector<unsigned> DiagnosticTable::lookup(uint32_t IndexOffset,
+                                              StringRef Key) const {
+  const unsigned char *Base = Buffer->getBuffer().bytes_begin();
+  std::unique_ptr<DiagnosticIndexTable> Table(
+      DiagnosticIndexTable::Create(Base + IndexOffset, Base));
+  std::vector<unsigned> Result;
+  auto It = Table->find(Key);
+  if (It == Table->end())
+    return Result;
+  StringRef Indices = *It;
+  for (size_t I = 0; I + 4 <= Indices.size(); I += 4) {
+    uint32_t Index =
+        llvm::support::endian::read32le(Indices.bytes_begin() + I);
+    if (Index < NumDiagnostics)
+      Result.push_back(Index);
+  }
+  return Result;
+}
+
+std::vector<unsigned>
+DiagnosticTable::getDiagnosticsInFile(StringRef Filename) const {
+  return lookup(FileIndexOffset, Filename);
+}
+
+std::vector<unsigned>
+DiagnosticTable::getDiagnosticsWithFlag(StringRef Flag) const {
+  return lookup(FlagIndexOffset, Flag);
+}
+
+} // end namespace serialized_diags
+} // end namespace clang
@@ -1152,6 +1152,15 @@ void TextDiagnostic::emitSnippetAndCaret(
   if (Invalid)
     return;
 
+  // Stop showing the snippet of a location once it has been shown enough
+  // times, for instance for a header which is included many times.
+  if (unsigned Limit = DiagOpts->SnippetRepeatLimit) {
+    if (++SnippetCounts[BufData.data() + LocInfo.second] > Limit) {
+      emitParseableFixits(Hints, SM);
+      return;
+    }
+  }
+
   unsigned CaretLineNo = Loc.getLineNumber();
   unsigned CaretColNo = Loc.getColumnNumber();
 
@@ -1169,19 +1178,30 @@ void TextDiagnostic::emitSnippetAndCaret(
     if (auto OptionalRange = findLinesForRange(*I, FID, SM))
       Lines = maybeAddRange(Lines, *OptionalRange, MaxLines);
 
-  for (unsigned LineNo = Lines.first; LineNo != Lines.second + 1; ++LineNo) {
-    const char *BufStart = BufData.data();
-    const char *BufEnd = BufStart + BufData.size();
+  const char *BufStart = BufData.data();
+  const char *BufEnd = BufStart + BufData.size();
 
-    // Rewind from the current position to the start of the line.
-    const char *LineStart =
-        BufStart +
-        SM.getDecomposedLoc(SM.translateLineCol(FID, LineNo, 1)).second;
+  // Only the first line is looked up in the source manager; the next ones
+  // start after the end of the previous one.
+  const char *LineStart =
+      BufStart +
+      SM.getDecomposedLoc(SM.translateLineCol(FID, Lines.first, 1)).second;
+  const char *LineEnd = LineStart;
+  for (unsigned LineNo = Lines.first; LineNo != Lines.second + 1; ++LineNo) {
+    if (LineNo != Lines.first) {
+      // Skip the end of the previous line, counting \r\n and \n\r as one.
+      if (LineEnd == BufEnd)
+        break;
+      LineStart = LineEnd + 1;
+      if (LineStart != BufEnd && (*LineStart == '\n' || *LineStart == '\r') &&
+          *LineStart != *LineEnd)
+        ++LineStart;
+    }
     if (LineStart == BufEnd)
       break;
 
     // Compute the line end.
-    const char *LineEnd = LineStart;
+    LineEnd = LineStart;
     while (*LineEnd != '\n' && *LineEnd != '\r' && LineEnd != BufEnd)
       ++LineEnd;
 
@@ -26,7 +26,7 @@ TextDiagnosticPrinter::TextDiagnosticPrinter(raw_ostream &os,
                                              DiagnosticOptions *diags,
                                              bool _OwnsOutputStream)
   : OS(os), DiagOpts(diags),
-    OwnsOutputStream(_OwnsOutputStream) {
+    OwnsOutputStream(_OwnsOutputStream), SuppressNotes(false) {
 }
 
 TextDiagnosticPrinter::~TextDiagnosticPrinter() {
@@ -38,6 +38,8 @@ void TextDiagnosticPrinter::BeginSourceFile(const LangOptions &LO,
                                             const Preprocessor *PP) {
   // Build the TextDiagnostic utility.
   TextDiag.reset(new TextDiagnostic(OS, LO, &*DiagOpts));
+  PrintedDiags.clear();
+  SuppressNotes = false;
 }
 
 void TextDiagnosticPrinter::EndSourceFile() {
@@ -107,6 +109,30 @@ static void printDiagnosticOptions(raw_ostream &OS,
     OS << ']';
 }
 
+bool TextDiagnosticPrinter::isDuplicate(DiagnosticsEngine::Level Level,
+                                        const Diagnostic &Info,
+                                        StringRef Message) {
+  if (Level == DiagnosticsEngine::Note)
+    return SuppressNotes;
+
+  // The presumed location is used rather than the location itself, so that
+  // the diagnostics of a header are identical wherever it is included.
+  SmallString<256> Key;
+  llvm::raw_svector_ostream KeyStream(Key);
+  KeyStream << Info.getID() << ':';
+  if (Info.getLocation().isValid()) {
+    FullSourceLoc Loc =
+        FullSourceLoc(Info.getLocation(), Info.getSourceManager()).getFileLoc();
+    PresumedLoc PLoc = Loc.getPresumedLoc(DiagOpts->ShowPresumedLoc);
+    if (PLoc.isValid())
+      KeyStream << PLoc.getFilename() << ':' << PLoc.getLine() << ':'
+                << PLoc.getColumn();
+  }
+  KeyStream << ':' << Message;
+  SuppressNotes = !PrintedDiags.insert(KeyStream.str()).second;
+  return SuppressNotes;
+}
+
 void TextDiagnosticPrinter::HandleDiagnostic(DiagnosticsEngine::Level Level,
                                              const Diagnostic &Info) {
   // Default implementation (Warnings/errors count).
@@ -120,6 +146,12 @@ void TextDiagnosticPrinter::HandleDiagnostic(DiagnosticsEngine::Level Level,
   llvm::raw_svector_ostream DiagMessageStream(OutStr);
   printDiagnosticOptions(DiagMessageStream, Level, Info, *DiagOpts);
 
+  // Drop the diagnostics which are printed again, with their notes, before
+  // rendering their source snippets. They are still counted above.
+  if (DiagOpts->DeduplicateDiagnostics &&
+      isDuplicate(Level, Info, DiagMessageStream.str()))
+    return;
+
   // Keeps track of the starting position of the location
   // information (e.g., "foo.c:10:4:") that precedes the error
   // message. We use this information to determine how long the
@@ -12,7 +12,9 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/DeclVisitor.h"
 #include "clang/Lex/PreprocessingRecord.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace clang;
@@ -1036,6 +1038,42 @@ bool clang::index::generateUSRForDecl(const Decl *D,
   return UG.ignoreResults();
 }
 
+bool clang::index::generateUSRHashForDecl(const Decl *D, uint64_t &Hash) {
+  // The generator patches the USR in place, so it is built in a buffer that
+  // is large enough for most USRs to stay off the heap.
+  SmallString<512> Buf;
+  if (generateUSRForDecl(D, Buf))
+    return true;
+  Hash = llvm::xxHash64(Buf);
+  return false;
+}
+
+bool clang::index::generateUSRHashForDecl(const Decl *D, USRHash &Hash) {
+  SmallString<512> Buf;
+  if (generateUSRForDecl(D, Buf))
+    return true;
+  llvm::MD5 Hasher;
+  Hasher.update(Buf);
+  llvm::MD5::MD5Result Result;
+  Hasher.final(Result);
+  Hash.High = Result.high();
+  Hash.Low = Result.low();
+  return false;
+}
+
+StringRef USRCache::getUSR(const Decl *D) {
+  auto Cached = USRs.find(D);
+  if (Cached != USRs.end())
+    return Cached->second;
+
+  StringRef USR;
+  SmallString<512> Buf;
+  if (!generateUSRForDecl(D, Buf))
+    USR = Strings.insert(Buf).first->getKey();
+  USRs[D] = USR;
+  return USR;
+}
+
 bool clang::index::generateUSRForMacro(const MacroDefinitionRecord *MD,
                                        const SourceManager &SM,
                                        SmallVectorImpl<char> &Buf) {
@@ -0,0 +1,401 @@
+//===- DependencyDirectivesSourceMinimizer.cpp - Minimize sources ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the minimization of source files to the preprocessor
+//  directives that can affect which files they include.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "clang/Basic/CharInfo.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSwitch.h"
+
+using namespace clang;
+
+namespace {
+
+/// \brief The kinds of directive that are kept.
+enum DirectiveKind {
+  DK_Dropped,
+  DK_Include,
+  DK_Other
+};
+
+/// \brief Minimizes one buffer.
+///
+/// The input is scanned one logical character at a time: line splices are
+/// skipped, except inside raw string literals.  Comments, and string,
+/// character and raw string literals are recognized everywhere, so that a
+/// '#' in any of them is never mistaken for the start of a directive.
+class Minimizer {
+  const char *Cur;
+  const char *const End;
+  SmallVectorImpl<char> &Out;
+
+  /// \brief Whether the characters that are scanned are copied to the output.
+  bool Copying = false;
+
+  /// \brief Whether an error was found.
+  bool Failed = false;
+
+public:
+  Minimizer(StringRef Input, SmallVectorImpl<char> &Out)
+      : Cur(Input.begin()), End(Input.end()), Out(Out) {}
+
+  /// \returns true on error.
+  bool minimize();
+
+private:
+  bool atEnd() { return peekPtr() == End; }
+
+  /// \brief Return the length of the line splice at \p P, or 0 if there is
+  /// none.  Like the lexer, this accepts whitespace after the backslash.
+  unsigned getSpliceLength(const char *P) const {
+    if (P == End || *P != '\\')
+      return 0;
+    const char *Q = P + 1;
+    while (Q != End && (*Q == ' ' || *Q == '\t'))
+      ++Q;
+    if (Q == End || !isVerticalWhitespace(*Q))
+      return 0;
+    const char *R = Q + 1;
+    if (R != End && isVerticalWhitespace(*R) && *R != *Q)
+      ++R;
+    return R - P;
+  }
+
+  const char *skipSplices(const char *P) const {
+    while (unsigned Len = getSpliceLength(P))
+      P += Len;
+    return P;
+  }
+
+  /// \brief Move past any line splices, and return the position of the
+  /// current logical character.
+  const char *peekPtr() { return Cur = skipSplices(Cur); }
+
+  /// \brief Return the current logical character, or 0 at the end.
+  char peek() {
+    const char *P = peekPtr();
+    return P == End ? 0 : *P;
+  }
+
+  /// \brief Return the logical character after the current one, or 0 at the
+  /// end.
+  char peekNext() {
+    const char *P = peekPtr();
+    if (P == End)
+      return 0;
+    P = skipSplices(P + 1);
+    return P == End ? 0 : *P;
+  }
+
+  /// \brief Move past the current logical character, copying it if needed.
+  void advance() {
+    if (atEnd())
+      return;
+    if (Copying)
+      Out.push_back(*Cur);
+    ++Cur;
+  }
+
+  /// \brief Move past the newline at the current position.
+  void skipNewline() {
+    char C = *Cur++;
+    if (Cur != End && isVerticalWhitespace(*Cur) && *Cur != C)
+      ++Cur;
+  }
+
+  void skipLineComment();
+  bool skipBlockComment(bool &SawNewline);
+  void lexQuoted(char Quote);
+  void lexRawString();
+  void lexNumber();
+  void lexIdentifier();
+  bool skipLeadingSpace();
+  void scanRestOfLine();
+  void handleDirective();
+};
+
+} // end anonymous namespace
+
+void Minimizer::skipLineComment() {
+  bool WasCopying = Copying;
+  Copying = false;
+  while (!atEnd() && !isVerticalWhitespace(*Cur))
+    advance();
+  Copying = WasCopying;
+}
+
+/// \returns true if the comment is not terminated.
+bool Minimizer::skipBlockComment(bool &SawNewline) {
+  bool WasCopying = Copying;
+  Copying = false;
+  advance();
+  advance();
+  while (true) {
+    if (atEnd()) {
+      Copying = WasCopying;
+      return true;
+    }
+    if (*Cur == '*' && peekNext() == '/')
+      break;
+    // Line splices are skipped by advance, so this is a real newline.
+    if (isVerticalWhitespace(*Cur))
+      SawNewline = true;
+    advance();
+  }
+  advance();
+  advance();
+  Copying = WasCopying;
+  return false;
+}
+
+void Minimizer::lexQuoted(char Quote) {
+  advance();
+  while (!atEnd()) {
+    char C = *Cur;
+    // An unterminated literal ends at the end of the line.
+    if (isVerticalWhitespace(C))
+      return;
+    advance();
+    if (C == Quote)
+      return;
+    if (C == '\\' && !atEnd() && !isVerticalWhitespace(*Cur))
+      advance();
+  }
+}
+
+void Minimizer::lexRawString() {
+  // Line splices are reverted in raw string literals, so they are scanned
+  // directly.
+  const char *Quote = peekPtr();
+  const char *Delim = Quote + 1;
+  const char *P = Delim;
+  while (P != End && P - Delim <= 16 && *P != '(' && *P != ')' &&
+         *P != '\\' && !isWhitespace(*P) && *P != '"')
+    ++P;
+  if (P == End || *P != '(' || P - Delim > 16) {
+    // Not a raw string literal; the lexer will treat it as a normal one.
+    lexQuoted('"');
+    return;
+  }
+
+  StringRef Delimiter(Delim, P - Delim);
+  const char *Body = P + 1;
+  for (const char *Q = Body; Q != End; ++Q) {
+    if (*Q != ')')
+      continue;
+    StringRef Rest(Q + 1, End - Q - 1);
+    if (Rest.size() <= Delimiter.size() || !Rest.startswith(Delimiter) ||
+        Rest[Delimiter.size()] != '"')
+      continue;
+    const char *Stop = Rest.begin() + Delimiter.size() + 1;
+    if (Copying)
+      Out.append(Quote, Stop);
+    Cur = Stop;
+    return;
+  }
+  Failed = true;
+  Cur = End;
+}
+
+void Minimizer::lexNumber() {
+  // A pp-number, which may contain digit separators and signed exponents.
+  char Prev = 0;
+  while (!atEnd()) {
+    char C = *Cur;
+    if (isIdentifierBody(C) || C == '.' ||
+        ((C == '+' || C == '-') &&
+         (Prev == 'e' || Prev == 'E' || Prev == 'p' || Prev == 'P')) ||
+        (C == '\'' && isIdentifierBody(peekNext()))) {
+      advance();
+      Prev = C;
+      continue;
+    }
+    break;
+  }
+}
+
+void Minimizer::lexIdentifier() {
+  SmallString<8> Prefix;
+  while (!atEnd() && (isIdentifierBody(*Cur, /*AllowDollar=*/true) ||
+                      (unsigned char)*Cur >= 0x80)) {
+    if (Prefix.size() < 4)
+      Prefix.push_back(*Cur);
+    advance();
+  }
+  if (peek() == '"' && (Prefix == "R" || Prefix == "LR" || Prefix == "uR" ||
+                        Prefix == "UR" || Prefix == "u8R"))
+    lexRawString();
+}
+
+/// \brief Skip the whitespace and comments at the start of a line.
+///
+/// \returns true if the next character is still the first token on the line,
+/// false if a comment spanned several lines.
+bool Minimizer::skipLeadingSpace() {
+  bool AtLineStart = true;
+  while (!atEnd()) {
+    char C = *Cur;
+    if (isHorizontalWhitespace(C)) {
+      ++Cur;
+      continue;
+    }
+    if (C != '/' || peekNext() != '*')
+      break;
+    bool SawNewline = false;
+    if (skipBlockComment(SawNewline)) {
+      Failed = true;
+      return false;
+    }
+    if (SawNewline)
+      AtLineStart = false;
+  }
+  return AtLineStart;
+}
+
+/// \brief Scan up to and including the end of the logical line, copying it
+/// if needed.  Comments in the copy are replaced by a space, and runs of
+/// whitespace by a single space.
+void Minimizer::scanRestOfLine() {
+  while (!Failed && !atEnd()) {
+    char C = *Cur;
+    if (isVerticalWhitespace(C)) {
+      skipNewline();
+      return;
+    }
+    if (C == '/' && peekNext() == '/') {
+      skipLineComment();
+      continue;
+    }
+    if (C == '/' && peekNext() == '*') {
+      bool SawNewline = false;
+      if (skipBlockComment(SawNewline)) {
+        Failed = true;
+        return;
+      }
+      if (Copying && !Out.empty() && Out.back() != ' ')
+        Out.push_back(' ');
+      continue;
+    }
+    if (isHorizontalWhitespace(C)) {
+      ++Cur;
+      if (Copying && !Out.empty() && Out.back() != ' ')
+        Out.push_back(' ');
+      continue;
+    }
+    if (C == '"' || C == '\'') {
+      lexQuoted(C);
+      continue;
+    }
+    if (isDigit(C) || (C == '.' && isDigit(peekNext()))) {
+      lexNumber();
+      continue;
+    }
+    if (isIdentifierHead(C, /*AllowDollar=*/true) || (unsigned char)C >= 0x80) {
+      lexIdentifier();
+      continue;
+    }
+    advance();
+  }
+}
+
+/// \brief Handle the line of a directive, whose '#' has been consumed.
+void Minimizer::handleDirective() {
+  while (!atEnd() && (isHorizontalWhitespace(*Cur) ||
+                      (*Cur == '/' && peekNext() == '*'))) {
+    if (*Cur != '/') {
+      ++Cur;
+      continue;
+    }
+    bool SawNewline = false;
+    if (skipBlockComment(SawNewline)) {
+      Failed = true;
+      return;
+    }
+  }
+
+  SmallString<16> Name;
+  while (!atEnd() && isIdentifierBody(*Cur)) {
+    Name.push_back(*Cur);
+    advance();
+  }
+
+  DirectiveKind Kind = llvm::StringSwitch<DirectiveKind>(Name)
+      .Cases("include", "include_next", "import", "__include_macros",
+             DK_Include)
+      .Cases("define", "undef", "if", "ifdef", "ifndef", DK_Other)
+      .Cases("elif", "else", "endif", "pragma", DK_Other)
+      .Default(DK_Dropped);
+  if (Kind == DK_Dropped) {
+    scanRestOfLine();
+    return;
+  }
+
+  Out.push_back('#');
+  Out.append(Name.begin(), Name.end());
+  Copying = true;
+
+  // Copy a header name as is, since it is not made of tokens.
+  if (Kind == DK_Include) {
+    while (!atEnd() && isHorizontalWhitespace(*Cur))
+      ++Cur;
+    Out.push_back(' ');
+    if (peek() == '<') {
+      while (!atEnd() && !isVerticalWhitespace(*Cur)) {
+        char C = *Cur;
+        advance();
+        if (C == '>')
+          break;
+      }
+    }
+  }
+
+  scanRestOfLine();
+  Copying = false;
+  while (!Out.empty() && Out.back() == ' ')
+    Out.pop_back();
+  Out.push_back('\n');
+}
+
+bool Minimizer::minimize() {
+  // Skip a UTF-8 byte order mark.
+  if (End - Cur >= 3 && StringRef(Cur, 3) == "\xEF\xBB\xBF")
+    Cur += 3;
+
+  while (!Failed && !atEnd()) {
+    if (!skipLeadingSpace()) {
+      scanRestOfLine();
+      continue;
+    }
+    if (atEnd())
+      break;
+    if (*Cur == '#') {
+      ++Cur;
+      handleDirective();
+      continue;
+    }
+    if (*Cur == '%' && peekNext() == ':') {
+      advance();
+      advance();
+      handleDirective();
+      continue;
+    }
+    scanRestOfLine();
+  }
+  return Failed;
+}
+
+bool clang::minimizeSourceToDependencyDirectives(
+    StringRef Input, SmallVectorImpl<char> &Output) {
+  Output.clear();
+  return Minimizer(Input, Output).minimize();
+}
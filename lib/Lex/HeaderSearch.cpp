@@ -14,8 +14,10 @@
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/VirtualFileSystem.h"
 #include "clang/Lex/ExternalPreprocessorSource.h"
 #include "clang/Lex/HeaderMap.h"
+#include "clang/Lex/HeaderSearchCache.h"
 #include "clang/Lex/HeaderSearchOptions.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/Lexer.h"
@@ -25,6 +27,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Capacity.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/Path.h"
 #include <cstdio>
 #include <utility>
@@ -70,6 +73,9 @@ HeaderSearch::HeaderSearch(std::shared_ptr<HeaderSearchOptions> HSOpts,
   NumIncluded = 0;
   NumMultiIncludeFileOptzn = 0;
   NumFrameworkLookups = NumSubFrameworkLookups = 0;
+
+  if (!this->HSOpts->LookupCachePath.empty())
+    SharedLookups = HeaderSearchCache::create(this->HSOpts->LookupCachePath);
 }
 
 HeaderSearch::~HeaderSearch() {
@@ -755,6 +761,10 @@ const FileEntry *HeaderSearch::LookupFile(
   // being relex/pp'd, but they would still have to search through a
   // (potentially huge) series of SearchDirs to find it.
   LookupFileCacheInfo &CacheLookup = LookupFileCache[Filename];
+  unsigned StartIdx = i;
+  // Whether this search probes every directory from StartIdx, so that its
+  // result can be shared with other compilations.
+  bool FullWalk = true;
 
   // If the entry has been previously looked up, the first value will be
   // non-zero.  If the value is equal to i (the start point of our search), then
@@ -762,6 +772,7 @@ const FileEntry *HeaderSearch::LookupFile(
   if (!SkipCache && CacheLookup.StartIdx == i+1) {
     // Skip querying potentially lots of directories for this lookup.
     i = CacheLookup.HitIdx;
+    FullWalk = false;
     if (CacheLookup.MappedName) {
       Filename = CacheLookup.MappedName;
       if (IsMapped)
@@ -772,6 +783,14 @@ const FileEntry *HeaderSearch::LookupFile(
     // our search start.  We will fill in our found location below, so prime the
     // start point value.
     CacheLookup.reset(/*StartIdx=*/i+1);
+
+    // Another compilation with the same search path may already know which
+    // directories do not contain this file.
+    unsigned HitIdx;
+    if (!SkipCache && lookupSharedCache(Filename, StartIdx, HitIdx)) {
+      i = HitIdx;
+      FullWalk = false;
+    }
   }
 
   SmallString<64> MappedName;
@@ -833,6 +852,8 @@ const FileEntry *HeaderSearch::LookupFile(
 
     // Remember this location for the next lookup we do.
     CacheLookup.HitIdx = i;
+    if (FullWalk)
+      recordSharedCache(Filename, StartIdx, i);
     return FE;
   }
 
@@ -875,9 +896,95 @@ const FileEntry *HeaderSearch::LookupFile(
 
   // Otherwise, didn't find it. Remember we didn't find this.
   CacheLookup.HitIdx = SearchDirs.size();
+  if (FullWalk)
+    recordSharedCache(Filename, StartIdx, SearchDirs.size());
   return nullptr;
 }
 
+uint64_t HeaderSearch::getSearchPathFingerprint() {
+  if (SearchPathFingerprint)
+    return *SearchPathFingerprint;
+
+  // Relative search directories are resolved against the working directory.
+  llvm::MD5 Hash;
+  SmallString<256> CWD;
+  if (!llvm::sys::fs::current_path(CWD))
+    Hash.update(CWD);
+  Hash.update(StringRef("\0", 1));
+  Hash.update(FileMgr.getFileSystemOpts().WorkingDir);
+  Hash.update(StringRef("\0", 1));
+  for (const DirectoryLookup &DL : SearchDirs) {
+    uint8_t Kind[2] = {uint8_t(DL.getLookupType()),
+                       uint8_t(DL.getDirCharacteristic())};
+    Hash.update(Kind);
+    Hash.update(DL.getName());
+    Hash.update(StringRef("\0", 1));
+  }
+  uint32_t Indices[3] = {AngledDirIdx, SystemDirIdx, NoCurDirSearch};
+  Hash.update(ArrayRef<uint8_t>((const uint8_t *)Indices, sizeof(Indices)));
+
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  uint64_t Fingerprint;
+  memcpy(&Fingerprint, &Result, sizeof(Fingerprint));
+  SearchPathFingerprint = Fingerprint;
+  return *SearchPathFingerprint;
+}
+
+bool HeaderSearch::lookupSharedCache(StringRef Filename, unsigned StartIdx,
+                                     unsigned &HitIdx) {
+  if (!SharedLookups)
+    return false;
+
+  Optional<HeaderSearchCache::Entry> E =
+      SharedLookups->lookup(getSearchPathFingerprint(), StartIdx, Filename);
+  if (!E || E->HitIdx < StartIdx || E->HitIdx > SearchDirs.size() ||
+      E->Probes.size() != E->HitIdx - StartIdx)
+    return false;
+
+  // Each directory that was passed over must still not contain the file.
+  vfs::FileSystem &FS = *FileMgr.getVirtualFileSystem();
+  for (unsigned j = StartIdx; j != E->HitIdx; ++j) {
+    if (!SearchDirs[j].isNormalDir() ||
+        !SharedLookups->isProbeValid(SearchDirs[j].getDir()->getName(),
+                                     Filename, E->Probes[j - StartIdx], FS))
+      return false;
+  }
+
+  // The directory in which the file was found is searched again, so a file
+  // that was removed from it is not returned.
+  HitIdx = E->HitIdx;
+  return true;
+}
+
+void HeaderSearch::recordSharedCache(StringRef Filename, unsigned StartIdx,
+                                     unsigned HitIdx) {
+  if (!SharedLookups)
+    return;
+
+  // Only the absence of a file in a plain directory can be revalidated from
+  // directory modification times; header maps and frameworks cannot.
+  HeaderSearchCache::Entry E;
+  E.HitIdx = HitIdx;
+  vfs::FileSystem &FS = *FileMgr.getVirtualFileSystem();
+  for (unsigned j = StartIdx; j != HitIdx; ++j) {
+    if (!SearchDirs[j].isNormalDir())
+      return;
+    Optional<HeaderSearchCache::Probe> P = SharedLookups->computeProbe(
+        SearchDirs[j].getDir()->getName(), Filename, FS);
+    if (!P)
+      return;
+    E.Probes.push_back(*P);
+  }
+  SharedLookups->record(getSearchPathFingerprint(), StartIdx, Filename, E);
+}
+
+void HeaderSearch::saveSharedLookupCache() {
+  // The cache is only an optimization, so a failure to save it is ignored.
+  if (SharedLookups)
+    SharedLookups->save();
+}
+
 /// LookupSubframeworkHeader - Look up a subframework for the specified
 /// \#include file.  For example, if \#include'ing <HIToolbox/HIToolbox.h> from
 /// within ".../Carbon.framework/Headers/Carbon.h", check to see if HIToolbox
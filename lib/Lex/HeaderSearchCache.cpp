@@ -0,0 +1,336 @@
+//===--- HeaderSearchCache.cpp - Header lookups shared across TUs ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the HeaderSearchCache class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/HeaderSearchCache.h"
+#include "clang/Basic/VirtualFileSystem.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <chrono>
+
+using namespace clang;
+
+/// The signature at the start of a header search cache file.
+static const char Signature[8] = {'C', 'L', 'H', 'D', 'R', 'S', 'C', 0};
+
+/// The header search cache file version.
+static const unsigned CurrentVersion = 1;
+
+/// The size of the header: the signature, the version, and the offsets of
+/// the buckets and of the payload of the hash table.
+static const unsigned HeaderSize = sizeof(Signature) + 3 * sizeof(uint32_t);
+
+/// The number of seconds for which probes of a modified directory are not
+/// recorded.
+static const unsigned RecentSeconds = 2;
+
+static uint64_t toNanoseconds(llvm::sys::TimePoint<> Time) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             Time.time_since_epoch()).count();
+}
+
+/// Return the key of a lookup: the search path fingerprint and the start
+/// index, followed by the spelling.
+static std::string getKey(uint64_t Fingerprint, unsigned StartIdx,
+                          StringRef Filename) {
+  std::string Key;
+  llvm::raw_string_ostream Out(Key);
+  using namespace llvm::support;
+  endian::Writer<little> LE(Out);
+  LE.write<uint64_t>(Fingerprint);
+  LE.write<uint32_t>(StartIdx);
+  Out << Filename;
+  return Out.str();
+}
+
+static unsigned getDataLength(const HeaderSearchCache::Entry &E) {
+  return 4 + 2 + E.Probes.size() * (1 + 8);
+}
+
+class HeaderSearchCache::LookupTrait {
+public:
+  typedef StringRef external_key_type;
+  typedef StringRef internal_key_type;
+  typedef Entry data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static bool EqualKey(const internal_key_type &a,
+                       const internal_key_type &b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(const internal_key_type &a) {
+    return llvm::HashString(a);
+  }
+
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&d) {
+    using namespace llvm::support;
+    unsigned KeyLen = endian::readNext<uint16_t, little, unaligned>(d);
+    unsigned DataLen = endian::readNext<uint16_t, little, unaligned>(d);
+    return std::make_pair(KeyLen, DataLen);
+  }
+
+  static const internal_key_type &
+  GetInternalKey(const external_key_type &x) { return x; }
+
+  static const external_key_type &
+  GetExternalKey(const internal_key_type &x) { return x; }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned n) {
+    return StringRef((const char *)d, n);
+  }
+
+  static data_type ReadData(const internal_key_type &, const unsigned char *d,
+                            unsigned) {
+    using namespace llvm::support;
+    Entry E;
+    E.HitIdx = endian::readNext<uint32_t, little, unaligned>(d);
+    unsigned NumProbes = endian::readNext<uint16_t, little, unaligned>(d);
+    for (unsigned I = 0; I != NumProbes; ++I) {
+      Probe P;
+      P.Up = *d++;
+      P.Time = endian::readNext<uint64_t, little, unaligned>(d);
+      E.Probes.push_back(P);
+    }
+    return E;
+  }
+};
+
+namespace {
+class HeaderSearchCacheWriterTrait {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef HeaderSearchCache::Entry data_type;
+  typedef const data_type &data_type_ref;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static hash_value_type ComputeHash(key_type_ref Key) {
+    return llvm::HashString(Key);
+  }
+
+  std::pair<unsigned, unsigned>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref E) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    unsigned DataLen = getDataLength(E);
+    LE.write<uint16_t>(Key.size());
+    LE.write<uint16_t>(DataLen);
+    return std::make_pair(Key.size(), DataLen);
+  }
+
+  void EmitKey(raw_ostream &Out, key_type_ref Key, unsigned) {
+    Out.write(Key.data(), Key.size());
+  }
+
+  void EmitData(raw_ostream &Out, key_type_ref, data_type_ref E, unsigned) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<uint32_t>(E.HitIdx);
+    LE.write<uint16_t>(E.Probes.size());
+    for (const HeaderSearchCache::Probe &P : E.Probes) {
+      LE.write<uint8_t>(P.Up);
+      LE.write<uint64_t>(P.Time);
+    }
+  }
+};
+} // end anonymous namespace
+
+HeaderSearchCache::HeaderSearchCache(StringRef CachePath,
+                                     std::unique_ptr<llvm::MemoryBuffer> Buffer)
+    : CachePath(CachePath), Buffer(std::move(Buffer)) {
+  if (!this->Buffer)
+    return;
+
+  using namespace llvm::support;
+  const unsigned char *Start =
+      (const unsigned char *)this->Buffer->getBufferStart();
+  size_t Size = this->Buffer->getBufferSize();
+  if (Size < HeaderSize || memcmp(Start, Signature, sizeof(Signature)) != 0)
+    return;
+
+  const unsigned char *D = Start + sizeof(Signature);
+  uint32_t Version = endian::readNext<uint32_t, little, unaligned>(D);
+  uint32_t BucketOffset = endian::readNext<uint32_t, little, unaligned>(D);
+  uint32_t PayloadOffset = endian::readNext<uint32_t, little, unaligned>(D);
+  if (Version != CurrentVersion || PayloadOffset < HeaderSize ||
+      BucketOffset < PayloadOffset || BucketOffset >= Size ||
+      BucketOffset % 4 != 0)
+    return;
+
+  Table.reset(TableTy::Create(Start + BucketOffset, Start + PayloadOffset,
+                              Start));
+}
+
+HeaderSearchCache::~HeaderSearchCache() {}
+
+std::unique_ptr<HeaderSearchCache> HeaderSearchCache::create(StringRef Path) {
+  // A missing or unreadable file starts an empty cache.
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> BufferOrErr =
+      llvm::MemoryBuffer::getFile(Path, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  std::unique_ptr<llvm::MemoryBuffer> Buffer;
+  if (BufferOrErr)
+    Buffer = std::move(*BufferOrErr);
+  return std::unique_ptr<HeaderSearchCache>(
+      new HeaderSearchCache(Path, std::move(Buffer)));
+}
+
+Optional<HeaderSearchCache::Entry>
+HeaderSearchCache::lookup(uint64_t Fingerprint, unsigned StartIdx,
+                          StringRef Filename) {
+  std::string Key = getKey(Fingerprint, StartIdx, Filename);
+  auto New = NewEntries.find(Key);
+  if (New != NewEntries.end())
+    return New->second;
+
+  if (!Table)
+    return None;
+  TableTy::iterator I = Table->find(Key);
+  if (I == Table->end())
+    return None;
+  return *I;
+}
+
+void HeaderSearchCache::record(uint64_t Fingerprint, unsigned StartIdx,
+                               StringRef Filename, const Entry &E) {
+  // The lengths of the keys and data are stored in 16 bits.
+  std::string Key = getKey(Fingerprint, StartIdx, Filename);
+  if (Key.size() > UINT16_MAX || getDataLength(E) > UINT16_MAX)
+    return;
+  NewEntries[Key] = E;
+}
+
+Optional<uint64_t> HeaderSearchCache::getDirectoryTime(StringRef Dir,
+                                                       vfs::FileSystem &FS) {
+  auto Known = DirectoryTimes.find(Dir);
+  if (Known != DirectoryTimes.end())
+    return Known->second;
+
+  Optional<uint64_t> Time;
+  llvm::ErrorOr<vfs::Status> Status = FS.status(Dir);
+  if (Status && Status->isDirectory() && !Status->IsVFSMapped)
+    Time = toNanoseconds(Status->getLastModificationTime());
+  DirectoryTimes[Dir] = Time;
+  return Time;
+}
+
+Optional<HeaderSearchCache::Probe>
+HeaderSearchCache::computeProbe(StringRef Dir, StringRef Filename,
+                                vfs::FileSystem &FS) {
+  SmallString<256> Path(Dir);
+  llvm::sys::path::append(Path, Filename);
+
+  StringRef Ancestor = llvm::sys::path::parent_path(Path);
+  for (unsigned Up = 0; !Ancestor.empty() && Up <= UINT8_MAX; ++Up) {
+    if (Optional<uint64_t> Time = getDirectoryTime(Ancestor, FS)) {
+      uint64_t Now = toNanoseconds(std::chrono::system_clock::now());
+      uint64_t Recent = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::seconds(RecentSeconds)).count();
+      if (*Time + Recent > Now)
+        return None;
+
+      Probe P;
+      P.Up = Up;
+      P.Time = *Time;
+      return P;
+    }
+    Ancestor = llvm::sys::path::parent_path(Ancestor);
+  }
+  return None;
+}
+
+bool HeaderSearchCache::isProbeValid(StringRef Dir, StringRef Filename,
+                                     const Probe &P, vfs::FileSystem &FS) {
+  SmallString<256> Path(Dir);
+  llvm::sys::path::append(Path, Filename);
+
+  StringRef Ancestor = llvm::sys::path::parent_path(Path);
+  for (unsigned Up = 0; Up != P.Up && !Ancestor.empty(); ++Up)
+    Ancestor = llvm::sys::path::parent_path(Ancestor);
+  if (Ancestor.empty())
+    return false;
+
+  Optional<uint64_t> Time = getDirectoryTime(Ancestor, FS);
+  return Time && *Time == P.Time;
+}
+
+bool HeaderSearchCache::save() {
+  if (NewEntries.empty())
+    return false;
+
+  llvm::OnDiskChainedHashTableGenerator<HeaderSearchCacheWriterTrait>
+      Generator;
+  HeaderSearchCacheWriterTrait Trait;
+  for (const auto &NewEntry : NewEntries)
+    Generator.insert(NewEntry.first(), NewEntry.second, Trait);
+
+  // Keep the results recorded by other compilations that were not replaced.
+  if (Table) {
+    for (TableTy::key_iterator I = Table->key_begin(), E = Table->key_end();
+         I != E; ++I) {
+      StringRef Key = *I;
+      if (!NewEntries.count(Key))
+        Generator.insert(Key, *Table->find(Key), Trait);
+    }
+  }
+
+  SmallString<4096> Contents;
+  {
+    using namespace llvm::support;
+    llvm::raw_svector_ostream Out(Contents);
+    endian::Writer<little> LE(Out);
+    Out.write(Signature, sizeof(Signature));
+    LE.write<uint32_t>(CurrentVersion);
+    // The offsets of the buckets and the payload are filled in below.
+    LE.write<uint32_t>(0);
+    LE.write<uint32_t>(0);
+    uint32_t PayloadOffset = Out.tell();
+    uint32_t BucketOffset = Generator.Emit(Out, Trait);
+    uint32_t Offsets[2] = {
+        endian::byte_swap<uint32_t, little>(BucketOffset),
+        endian::byte_swap<uint32_t, little>(PayloadOffset)};
+    memcpy(&Contents[sizeof(Signature) + sizeof(uint32_t)], Offsets,
+           sizeof(Offsets));
+  }
+
+  // Write the new contents to a temporary file next to the cache, and move it
+  // into place, so that other compilations never see a partial file.
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(CachePath + "-%%%%%%%%", FD, TempPath))
+    return true;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out.write(Contents.data(), Contents.size());
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return true;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, CachePath)) {
+    llvm::sys::fs::remove(TempPath);
+    return true;
+  }
+  return false;
+}
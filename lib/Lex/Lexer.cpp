@@ -1403,6 +1403,144 @@ void Lexer::SetByteOffset(unsigned Offset, bool StartOfLine) {
   IsAtPhysicalStartOfLine = StartOfLine;
 }
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN)
+#include <arm_neon.h>
+#elif __ALTIVEC__
+#include <altivec.h>
+#undef bool
+#endif
+
+// The scanners below skip over runs of uninteresting characters 16 bytes at
+// a time.  Each returns a pointer to the first interesting character that it
+// finds, or to where it stopped if the remainder of the buffer is shorter
+// than a chunk, and the caller finishes the run one character at a time.
+// Every scanner stops at a '\0', so it never passes the end of the buffer or
+// a code-completion point.
+#if defined(__SSE2__) || \
+    (defined(__ARM_NEON) && !defined(__ARM_BIG_ENDIAN))
+#define LEXER_VECTOR_SCAN 1
+
+#ifdef __SSE2__
+typedef __m128i ByteVector;
+/// The number of bits of a match mask that represent one byte.
+static const unsigned MatchBitsPerByte = 1;
+static const uint64_t AllBytesMatch = 0xFFFF;
+
+static inline ByteVector loadBytes(const char *Ptr) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+}
+
+static inline ByteVector bytesEqual(ByteVector V, char C) {
+  return _mm_cmpeq_epi8(V, _mm_set1_epi8(C));
+}
+
+/// Match the bytes in [Lo, Hi].  The signed comparisons are right for the
+/// ASCII ranges used here: bytes >= 0x80 are negative and never match.
+static inline ByteVector bytesInRange(ByteVector V, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(Hi + 1), V));
+}
+
+static inline ByteVector orBytes(ByteVector A, ByteVector B) {
+  return _mm_or_si128(A, B);
+}
+
+static inline uint64_t getMatchMask(ByteVector Matches) {
+  return static_cast<unsigned>(_mm_movemask_epi8(Matches));
+}
+#else
+typedef uint8x16_t ByteVector;
+/// NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves a
+/// nibble for every byte.
+static const unsigned MatchBitsPerByte = 4;
+static const uint64_t AllBytesMatch = ~0ULL;
+
+static inline ByteVector loadBytes(const char *Ptr) {
+  return vld1q_u8(reinterpret_cast<const uint8_t *>(Ptr));
+}
+
+static inline ByteVector bytesEqual(ByteVector V, char C) {
+  return vceqq_u8(V, vdupq_n_u8(C));
+}
+
+static inline ByteVector bytesInRange(ByteVector V, char Lo, char Hi) {
+  return vandq_u8(vcgeq_u8(V, vdupq_n_u8(Lo)), vcleq_u8(V, vdupq_n_u8(Hi)));
+}
+
+static inline ByteVector orBytes(ByteVector A, ByteVector B) {
+  return vorrq_u8(A, B);
+}
+
+static inline uint64_t getMatchMask(ByteVector Matches) {
+  uint8x8_t Nibbles = vshrn_n_u16(vreinterpretq_u16_u8(Matches), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(Nibbles), 0);
+}
+#endif
+
+static inline const char *getFirstMatch(const char *Ptr, uint64_t Mask) {
+  return Ptr + llvm::countTrailingZeros(Mask) / MatchBitsPerByte;
+}
+#endif
+
+/// Skip horizontal whitespace, as isHorizontalWhitespace.
+static const char *scanHorizontalWhitespace(const char *Ptr,
+                                            const char *BufferEnd) {
+#ifdef LEXER_VECTOR_SCAN
+  while (Ptr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(Ptr);
+    ByteVector Spaces =
+        orBytes(orBytes(bytesEqual(V, ' '), bytesEqual(V, '\t')),
+                orBytes(bytesEqual(V, '\f'), bytesEqual(V, '\v')));
+    if (uint64_t Mask = ~getMatchMask(Spaces) & AllBytesMatch)
+      return getFirstMatch(Ptr, Mask);
+    Ptr += 16;
+  }
+#endif
+  return Ptr;
+}
+
+/// Skip to the '\n', '\r' or '\0' that may end a line comment.
+static const char *scanLineCommentBody(const char *Ptr,
+                                       const char *BufferEnd) {
+#ifdef LEXER_VECTOR_SCAN
+  while (Ptr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(Ptr);
+    ByteVector Ends =
+        orBytes(orBytes(bytesEqual(V, '\n'), bytesEqual(V, '\r')),
+                bytesEqual(V, '\0'));
+    if (uint64_t Mask = getMatchMask(Ends))
+      return getFirstMatch(Ptr, Mask);
+    Ptr += 16;
+  }
+#endif
+  return Ptr;
+}
+
+/// Skip the characters [_A-Za-z0-9] of an identifier, as isIdentifierBody.
+static const char *scanIdentifierBody(const char *Ptr, const char *BufferEnd) {
+#ifdef LEXER_VECTOR_SCAN
+  while (Ptr + 16 <= BufferEnd) {
+    ByteVector V = loadBytes(Ptr);
+    // Setting bit 5 maps the upper case letters onto the lower case ones and
+    // no other byte onto a letter.
+#ifdef __SSE2__
+    ByteVector Lower = _mm_or_si128(V, _mm_set1_epi8(0x20));
+#else
+    ByteVector Lower = vorrq_u8(V, vdupq_n_u8(0x20));
+#endif
+    ByteVector Body = orBytes(orBytes(bytesInRange(Lower, 'a', 'z'),
+                                      bytesInRange(V, '0', '9')),
+                              bytesEqual(V, '_'));
+    if (uint64_t Mask = ~getMatchMask(Body) & AllBytesMatch)
+      return getFirstMatch(Ptr, Mask);
+    Ptr += 16;
+  }
+#endif
+  return Ptr;
+}
+
 static bool isAllowedIDChar(uint32_t C, const LangOptions &LangOpts) {
   if (LangOpts.AsmPreprocessor) {
     return false;
@@ -1525,6 +1663,7 @@ bool Lexer::tryConsumeIdentifierUTF8Char(const char *&CurPtr) {
 bool Lexer::LexIdentifier(Token &Result, const char *CurPtr) {
   // Match [_A-Za-z0-9]*, we have already matched [_A-Za-z$]
   unsigned Size;
+  CurPtr = scanIdentifierBody(CurPtr, BufferEnd);
   unsigned char C = *CurPtr++;
   while (isIdentifierBody(C))
     C = *CurPtr++;
@@ -2023,9 +2162,15 @@ bool Lexer::SkipWhitespace(Token &Result, const char *CurPtr,
 
   // Skip consecutive spaces efficiently.
   while (true) {
-    // Skip horizontal whitespace very aggressively.
-    while (isHorizontalWhitespace(Char))
+    // Skip horizontal whitespace very aggressively.  Runs longer than one
+    // character, such as indentation, are skipped a chunk at a time.
+    while (isHorizontalWhitespace(Char)) {
       Char = *++CurPtr;
+      if (isHorizontalWhitespace(Char)) {
+        CurPtr = scanHorizontalWhitespace(CurPtr, BufferEnd);
+        Char = *CurPtr;
+      }
+    }
 
     // Otherwise if we have something other than whitespace, we're done.
     if (!isVerticalWhitespace(Char))
@@ -2093,6 +2238,7 @@ bool Lexer::SkipLineComment(Token &Result, const char *CurPtr,
   // character that ends the line comment.
   char C;
   while (true) {
+    CurPtr = scanLineCommentBody(CurPtr, BufferEnd);
     C = *CurPtr;
     // Skip over characters in the fast loop.
     while (C != 0 &&                // Potentially EOF.
@@ -2300,13 +2446,6 @@ static bool isEndOfBlockCommentWithEscapedNewLine(const char *CurPtr,
   return true;
 }
 
-#ifdef __SSE2__
-#include <emmintrin.h>
-#elif __ALTIVEC__
-#include <altivec.h>
-#undef bool
-#endif
-
 /// We have just read from input the / and * characters that started a comment.
 /// Read until we find the * and / characters that terminate the comment.
 /// Note that we don't bother decoding trigraphs or escaped newlines in block
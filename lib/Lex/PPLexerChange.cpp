@@ -15,14 +15,19 @@
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/LexDiagnostic.h"
 #include "clang/Lex/MacroInfo.h"
 #include "clang/Lex/PTHManager.h"
+#include "clang/Lex/PreprocessorOptions.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <ctime>
 using namespace clang;
 
 PPCallbacks::~PPCallbacks() {}
@@ -81,6 +86,9 @@ bool Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
       return false;
     }
   }
+
+  if (PPOpts->MinimizeSourceForDependencies)
+    minimizeSourceFile(FID);
   
   // Get the MemoryBuffer for this FID, if it fails, we fail.
   bool Invalid = false;
@@ -104,6 +112,83 @@ bool Preprocessor::EnterSourceFile(FileID FID, const DirectoryLookup *CurDir,
   return false;
 }
 
+/// Write a minimized source to the cache, atomically.
+static void writeMinimizedSource(StringRef Path, StringRef Contents) {
+  if (llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path)))
+    return;
+
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return;
+  {
+    llvm::raw_fd_ostream Out(FD, /*shouldClose=*/true);
+    Out << Contents;
+    Out.close();
+    if (Out.has_error()) {
+      Out.clear_error();
+      llvm::sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (llvm::sys::fs::rename(TempPath, Path))
+    llvm::sys::fs::remove(TempPath);
+}
+
+void Preprocessor::minimizeSourceFile(FileID FID) {
+  // A file whose contents are overridden is either minimized already, or was
+  // remapped by the client.
+  const FileEntry *FE = SourceMgr.getFileEntryForID(FID);
+  if (!FE || SourceMgr.isFileOverridden(FE))
+    return;
+
+  // Minimized files are cached under a hash of their name, size and
+  // modification time, so that a file is not even read on a hit.
+  SmallString<128> CachePath;
+  if (!PPOpts->MinimizedSourceCachePath.empty()) {
+    llvm::MD5 Hash;
+    Hash.update(FE->getName());
+    Hash.update(StringRef("\0", 1));
+    uint64_t Stamp[2] = {uint64_t(FE->getSize()),
+                         uint64_t(FE->getModificationTime())};
+    Hash.update(ArrayRef<uint8_t>((const uint8_t *)Stamp, sizeof(Stamp)));
+    llvm::MD5::MD5Result Result;
+    Hash.final(Result);
+    SmallString<32> Name;
+    llvm::MD5::stringifyResult(Result, Name);
+    Name += ".min";
+    CachePath = PPOpts->MinimizedSourceCachePath;
+    llvm::sys::path::append(CachePath, Name);
+
+    if (llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Cached =
+            llvm::MemoryBuffer::getFile(CachePath)) {
+      SourceMgr.overrideFileContents(
+          FE, llvm::MemoryBuffer::getMemBufferCopy((*Cached)->getBuffer(),
+                                                   FE->getName()));
+      return;
+    }
+  }
+
+  // If the file cannot be read, EnterSourceFile reports it.
+  bool Invalid = false;
+  const llvm::MemoryBuffer *Buffer = SourceMgr.getBuffer(FID, &Invalid);
+  if (Invalid)
+    return;
+
+  // A file that cannot be minimized is preprocessed as is.
+  SmallString<1024> Minimized;
+  if (minimizeSourceToDependencyDirectives(Buffer->getBuffer(), Minimized))
+    return;
+
+  // A file modified within the granularity of its timestamp could change
+  // again without changing the key.
+  if (!CachePath.empty() && FE->getModificationTime() + 2 < time(nullptr))
+    writeMinimizedSource(CachePath, Minimized);
+
+  SourceMgr.overrideFileContents(
+      FE, llvm::MemoryBuffer::getMemBufferCopy(Minimized, FE->getName()));
+}
+
 /// EnterSourceFileWithLexer - Add a source file to the top of the include stack
 ///  and start lexing tokens from it instead of the current buffer.
 void Preprocessor::EnterSourceFileWithLexer(Lexer *TheLexer,
@@ -160,10 +245,10 @@ void Preprocessor::EnterSourceFileWithPTH(PTHLexer *PL,
 void Preprocessor::EnterMacro(Token &Tok, SourceLocation ILEnd,
                               MacroInfo *Macro, MacroArgs *Args) {
   std::unique_ptr<TokenLexer> TokLexer;
-  if (NumCachedTokenLexers == 0) {
+  if (TokenLexerCache.empty()) {
     TokLexer = llvm::make_unique<TokenLexer>(Tok, ILEnd, Macro, Args, *this);
   } else {
-    TokLexer = std::move(TokenLexerCache[--NumCachedTokenLexers]);
+    TokLexer = TokenLexerCache.pop_back_val();
     TokLexer->Init(Tok, ILEnd, Macro, Args);
   }
 
@@ -210,11 +295,11 @@ void Preprocessor::EnterTokenStream(const Token *Toks, unsigned NumToks,
 
   // Create a macro expander to expand from the specified token stream.
   std::unique_ptr<TokenLexer> TokLexer;
-  if (NumCachedTokenLexers == 0) {
+  if (TokenLexerCache.empty()) {
     TokLexer = llvm::make_unique<TokenLexer>(
         Toks, NumToks, DisableMacroExpansion, OwnsTokens, *this);
   } else {
-    TokLexer = std::move(TokenLexerCache[--NumCachedTokenLexers]);
+    TokLexer = TokenLexerCache.pop_back_val();
     TokLexer->Init(Toks, NumToks, DisableMacroExpansion, OwnsTokens);
   }
 
@@ -567,11 +652,8 @@ bool Preprocessor::HandleEndOfTokenLexer(Token &Result) {
       MacroExpandingLexersStack.back().first == CurTokenLexer.get())
     removeCachedMacroExpandedTokensOfLastLexer();
 
-  // Delete or cache the now-dead macro expander.
-  if (NumCachedTokenLexers == TokenLexerCacheSize)
-    CurTokenLexer.reset();
-  else
-    TokenLexerCache[NumCachedTokenLexers++] = std::move(CurTokenLexer);
+  // Cache the now-dead macro expander.
+  TokenLexerCache.push_back(std::move(CurTokenLexer));
 
   // Handle this like a #include file being popped off the stack.
   return HandleEndOfFile(Result, true);
@@ -584,11 +666,8 @@ void Preprocessor::RemoveTopOfLexerStack() {
   assert(!IncludeMacroStack.empty() && "Ran out of stack entries to load");
 
   if (CurTokenLexer) {
-    // Delete or cache the now-dead macro expander.
-    if (NumCachedTokenLexers == TokenLexerCacheSize)
-      CurTokenLexer.reset();
-    else
-      TokenLexerCache[NumCachedTokenLexers++] = std::move(CurTokenLexer);
+    // Cache the now-dead macro expander.
+    TokenLexerCache.push_back(std::move(CurTokenLexer));
   }
 
   PopIncludeMacroStack();
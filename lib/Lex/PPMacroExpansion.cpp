@@ -761,9 +761,10 @@ MacroArgs *Preprocessor::ReadMacroCallArgumentList(Token &MacroName,
   assert(Tok.is(tok::l_paren) && "Error computing l-paren-ness?");
 
   // ArgTokens - Build up a list of tokens that make up each argument.  Each
-  // argument is separated by an EOF token.  Use a SmallVector so we can avoid
-  // heap allocations in the common case.
-  SmallVector<Token, 64> ArgTokens;
+  // argument is separated by an EOF token.  Use a pooled buffer so we can
+  // avoid heap allocations.
+  MacroTokenBuffer ArgTokenBuffer(*this);
+  SmallVectorImpl<Token> &ArgTokens = ArgTokenBuffer.get();
   bool ContainsCodeCompletionTok = false;
   bool FoundElidedComma = false;
 
@@ -1050,6 +1051,17 @@ void Preprocessor::removeCachedMacroExpandedTokensOfLastLexer() {
   MacroExpandingLexersStack.pop_back();
 }
 
+SmallVectorImpl<Token> &Preprocessor::acquireMacroTokenBuffer() {
+  // The buffers are allocated separately, so that growing the pool does not
+  // move the buffers that enclosing expansions are using.
+  if (NumActiveMacroTokenBuffers == MacroTokenBuffers.size())
+    MacroTokenBuffers.push_back(llvm::make_unique<SmallVector<Token, 128>>());
+  SmallVectorImpl<Token> &Tokens =
+      *MacroTokenBuffers[NumActiveMacroTokenBuffers++];
+  Tokens.clear();
+  return Tokens;
+}
+
 /// ComputeDATE_TIME - Compute the current time, enter it into the specified
 /// scratch buffer, then return DATELoc/TIMELoc locations with the position of
 /// the identifier tokens inserted.
@@ -22,6 +22,7 @@
 #include "clang/Lex/Token.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/EndianStream.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include <memory>
 #include <system_error>
@@ -365,6 +366,48 @@ public:
   }
 };
 
+class PTHManager::PTHContentLookupTrait {
+public:
+  typedef PTHManager::ContentHash external_key_type;
+  typedef external_key_type internal_key_type;
+  typedef PTHFileData data_type;
+  typedef unsigned hash_value_type;
+  typedef unsigned offset_type;
+
+  static const internal_key_type &
+  GetInternalKey(const external_key_type &x) { return x; }
+
+  static bool EqualKey(const internal_key_type &a,
+                       const internal_key_type &b) {
+    return a == b;
+  }
+
+  static hash_value_type ComputeHash(const internal_key_type &a) {
+    return (hash_value_type) a.first;
+  }
+
+  // The keys and data have a fixed size, so their lengths are not stored.
+  static std::pair<unsigned, unsigned>
+  ReadKeyDataLength(const unsigned char *&) {
+    return std::make_pair(2 * sizeof(uint64_t), 2 * sizeof(uint32_t));
+  }
+
+  static internal_key_type ReadKey(const unsigned char *d, unsigned) {
+    using namespace llvm::support;
+    uint64_t Low = endian::readNext<uint64_t, little, unaligned>(d);
+    uint64_t High = endian::readNext<uint64_t, little, unaligned>(d);
+    return std::make_pair(Low, High);
+  }
+
+  static PTHFileData ReadData(const internal_key_type &,
+                              const unsigned char *d, unsigned) {
+    using namespace llvm::support;
+    uint32_t x = endian::readNext<uint32_t, little, unaligned>(d);
+    uint32_t y = endian::readNext<uint32_t, little, unaligned>(d);
+    return PTHFileData(x, y);
+  }
+};
+
 class PTHManager::PTHStringLookupTrait {
 public:
   typedef uint32_t data_type;
@@ -414,12 +457,16 @@ public:
 
 PTHManager::PTHManager(
     std::unique_ptr<const llvm::MemoryBuffer> buf,
-    std::unique_ptr<PTHFileLookup> fileLookup, const unsigned char *idDataTable,
+    std::unique_ptr<PTHFileLookup> fileLookup,
+    std::unique_ptr<PTHContentLookup> contentLookup,
+    const unsigned char *idDataTable,
     std::unique_ptr<IdentifierInfo *[], llvm::FreeDeleter> perIDCache,
     std::unique_ptr<PTHStringIdLookup> stringIdLookup, unsigned numIds,
     const unsigned char *spellingBase, const char *originalSourceFile)
     : Buf(std::move(buf)), PerIDCache(std::move(perIDCache)),
-      FileLookup(std::move(fileLookup)), IdDataTable(idDataTable),
+      FileLookup(std::move(fileLookup)),
+      ContentLookup(std::move(contentLookup)), LookupByContent(false),
+      IdDataTable(idDataTable),
       StringIdLookup(std::move(stringIdLookup)), NumIds(numIds), PP(nullptr),
       SpellingBase(spellingBase), OriginalSourceFile(originalSourceFile) {}
 
@@ -543,14 +590,27 @@ PTHManager *PTHManager::Create(StringRef file, DiagnosticsEngine &Diags) {
     }
   }
 
+  // Construct the table mapping from the hashes of file contents to cached
+  // tokens.
+  const unsigned char* ContentTableOffset = PrologueOffset + sizeof(uint32_t)*4;
+  const unsigned char *ContentTable =
+      BufBeg + endian::readNext<uint32_t, little, aligned>(ContentTableOffset);
+  if (!(ContentTable > BufBeg && ContentTable < BufEnd)) {
+    Diags.Report(diag::err_invalid_pth_file) << file;
+    return nullptr;
+  }
+
+  std::unique_ptr<PTHContentLookup> CL(
+      PTHContentLookup::Create(ContentTable, BufBeg));
+
   // Compute the address of the original source file.
-  const unsigned char* originalSourceBase = PrologueOffset + sizeof(uint32_t)*4;
+  const unsigned char* originalSourceBase = PrologueOffset + sizeof(uint32_t)*5;
   unsigned len =
       endian::readNext<uint16_t, little, unaligned>(originalSourceBase);
   if (!len) originalSourceBase = nullptr;
 
   // Create the new PTHManager.
-  return new PTHManager(std::move(File), std::move(FL), IData,
+  return new PTHManager(std::move(File), std::move(FL), std::move(CL), IData,
                         std::move(PerIDCache), std::move(SL), NumIds,
                         spellingBase, (const char *)originalSourceBase);
 }
@@ -575,6 +635,13 @@ IdentifierInfo* PTHManager::LazilyCreateIdentifierInfo(unsigned PersistentID) {
   // Store the new IdentifierInfo in the cache.
   PerIDCache[PersistentID] = II;
   assert(II->getNameStart() && II->getNameStart()[0] != '\0');
+
+  // The identifier does not go through the identifier table when it is
+  // lexed, so it cannot get its keyword info there. The identifiers looked
+  // up before the preprocessor is set are the ones its constructor creates,
+  // none of which are keywords.
+  if (PP)
+    PP->getIdentifierTable().addKeywordInfo(*II);
   return II;
 }
 
@@ -591,12 +658,40 @@ IdentifierInfo* PTHManager::get(StringRef Name) {
   return GetIdentifierInfo(*I-1);
 }
 
+PTHManager::ContentHash PTHManager::getContentHash(StringRef Contents) {
+  llvm::MD5 Hash;
+  Hash.update(Contents);
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+
+  uint64_t Words[2];
+  static_assert(sizeof(Words) == sizeof(Result), "unexpected MD5 size");
+  memcpy(Words, &Result, sizeof(Words));
+  return std::make_pair(Words[0], Words[1]);
+}
+
 PTHLexer *PTHManager::CreateLexer(FileID FID) {
-  const FileEntry *FE = PP->getSourceManager().getFileEntryForID(FID);
+  SourceManager &SM = PP->getSourceManager();
+  const FileEntry *FE = SM.getFileEntryForID(FID);
   if (!FE)
     return nullptr;
 
-  using namespace llvm::support;
+  if (LookupByContent) {
+    bool Invalid = false;
+    const llvm::MemoryBuffer *B = SM.getBuffer(FID, &Invalid);
+    if (Invalid)
+      return nullptr;
+
+    // Lookup the contents of the file in the table of files by content.
+    PTHContentLookup::iterator I =
+        ContentLookup->find(getContentHash(B->getBuffer()));
+    if (I == ContentLookup->end()) // No tokens available?
+      return nullptr;
+
+    const PTHFileData &FileData = *I;
+    return CreateLexerAt(FID, FileData.getTokenOffset(),
+                         FileData.getPPCondOffset());
+  }
 
   // Lookup the FileEntry object in our file lookup data structure.  It will
   // return a variant that indicates whether or not there is an offset within
@@ -607,13 +702,20 @@ PTHLexer *PTHManager::CreateLexer(FileID FID) {
     return nullptr;
 
   const PTHFileData& FileData = *I;
+  return CreateLexerAt(FID, FileData.getTokenOffset(),
+                       FileData.getPPCondOffset());
+}
+
+PTHLexer *PTHManager::CreateLexerAt(FileID FID, uint32_t TokenOff,
+                                    uint32_t PPCondOff) {
+  using namespace llvm::support;
 
   const unsigned char *BufStart = (const unsigned char *)Buf->getBufferStart();
   // Compute the offset of the token data within the buffer.
-  const unsigned char* data = BufStart + FileData.getTokenOffset();
+  const unsigned char* data = BufStart + TokenOff;
 
   // Get the location of pp-conditional table.
-  const unsigned char* ppcond = BufStart + FileData.getPPCondOffset();
+  const unsigned char* ppcond = BufStart + PPCondOff;
   uint32_t Len = endian::readNext<uint32_t, little, aligned>(ppcond);
   if (Len == 0) ppcond = nullptr;
 
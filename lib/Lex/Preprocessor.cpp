@@ -112,7 +112,7 @@ Preprocessor::Preprocessor(std::shared_ptr<PreprocessorOptions> PPOpts,
   MacroExpansionInDirectivesOverride = false;
   InMacroArgs = false;
   InMacroArgPreExpansion = false;
-  NumCachedTokenLexers = 0;
+  NumActiveMacroTokenBuffers = 0;
   PragmasEnabled = true;
   ParsingIfOrElifDirective = false;
   PreprocessedOutput = false;
@@ -175,7 +175,7 @@ Preprocessor::~Preprocessor() {
   // Free any cached macro expanders.
   // This populates MacroArgCache, so all TokenLexers need to be destroyed
   // before the code below that frees up the MacroArgCache list.
-  std::fill(TokenLexerCache, TokenLexerCache + NumCachedTokenLexers, nullptr);
+  TokenLexerCache.clear();
   CurTokenLexer.reset();
 
   // Free any cached MacroArgs.
@@ -222,7 +222,10 @@ void Preprocessor::FinalizeForModelFile() {
 
 void Preprocessor::setPTHManager(PTHManager* pm) {
   PTH.reset(pm);
-  FileMgr.addStatCache(PTH->createStatCache());
+  // The stat information is only valid for the paths of the files that the
+  // PTH file was generated from.
+  if (!PTH->isLookupByContent())
+    FileMgr.addStatCache(PTH->createStatCache());
 }
 
 void Preprocessor::DumpToken(const Token &Tok, bool DumpFlags) const {
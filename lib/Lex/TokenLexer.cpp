@@ -225,7 +225,8 @@ void TokenLexer::stringifyVAOPTContents(
 /// Expand the arguments of a function-like macro so that we can quickly
 /// return preexpanded tokens from Tokens.
 void TokenLexer::ExpandFunctionArguments() {
-  SmallVector<Token, 128> ResultToks;
+  Preprocessor::MacroTokenBuffer ResultBuffer(PP);
+  SmallVectorImpl<Token> &ResultToks = ResultBuffer.get();
 
   // Loop through 'Tokens', expanding them into ResultToks.  Keep
   // track of whether we change anything.  If not, no need to keep them.  If so,
@@ -944,6 +945,7 @@ static void updateConsecutiveMacroArgTokens(SourceManager &SM,
 
   SourceLocation FirstLoc = begin_tokens->getLocation();
   SourceLocation CurLoc = FirstLoc;
+  unsigned CurLength = begin_tokens->getLength();
 
   // Compare the source location offset of tokens and group together tokens that
   // are close, even if their locations point to different FileIDs. e.g.
@@ -965,14 +967,17 @@ static void updateConsecutiveMacroArgTokens(SourceManager &SM,
     if (!SM.isInSameSLocAddrSpace(CurLoc, NextLoc, &RelOffs))
       break; // Token from different local/loaded location.
     // Check that token is not before the previous token or more than 50
-    // "characters" away.
-    if (RelOffs < 0 || RelOffs > 50)
+    // "characters" past its end.  The distance is measured from the end of the
+    // previous token so that long tokens, such as the string literals of
+    // generated tables, do not need an SLocEntry each.
+    if (RelOffs < 0 || RelOffs - int(CurLength) > 50)
       break;
 
     if (CurLoc.isMacroID() && !SM.isWrittenInSameFile(CurLoc, NextLoc))
       break; // Token from a different macro.
 
     CurLoc = NextLoc;
+    CurLength = NextTok->getLength();
   }
 
   // For the consecutive tokens, find the length of the SLocEntry to contain
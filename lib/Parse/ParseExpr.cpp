@@ -3352,8 +3352,24 @@ bool Parser::ParseGenericFunctionExpression(ExprResult &Res) {
   // Add parsed list of type names to declRefExpr for future references
   declRef->SetGenericInstInfo(Actions.getASTContext(), typeArgumentInfos);
 
-  // Substitute Type Variables of Function Type in DeclRefExpr
-  declRef->setType(SubstituteTypeVariable(funDecl->getType(), typeArgumentInfos));
+  // Substitute Type Variables of Function Type in DeclRefExpr, unless an
+  // earlier reference has already instantiated the function with the same
+  // type arguments.
+  SmallVector<QualType, 2> typeArguments;
+  for (const auto &typeArgumentInfo : typeArgumentInfos)
+    typeArguments.push_back(typeArgumentInfo.typeName);
+  auto &instantiations = GenericFunctionInstantiations[funDecl];
+  auto instantiation = llvm::find_if(instantiations,
+    [&](const std::pair<SmallVector<QualType, 2>, QualType> &I) {
+      return I.first == typeArguments;
+    });
+  if (instantiation == instantiations.end()) {
+    QualType instantiatedType =
+      SubstituteTypeVariable(funDecl->getType(), typeArgumentInfos);
+    instantiations.push_back({ typeArguments, instantiatedType });
+    instantiation = std::prev(instantiations.end());
+  }
+  declRef->setType(instantiation->second);
   return false;
 }
 
@@ -2077,6 +2077,15 @@ Decl *Parser::ParseFunctionTryBlock(Decl *Decl, ParseScope &BodyScope) {
 bool Parser::trySkippingFunctionBody() {
   assert(SkipFunctionBodies &&
          "Should only be called when SkipFunctionBodies is enabled");
+  if (SkipFunctionBodiesIn != SFBS_All) {
+    SourceManager &SM = PP.getSourceManager();
+    SourceLocation Loc = SM.getExpansionLoc(Tok.getLocation());
+    if (SkipFunctionBodiesIn == SFBS_Headers
+            ? SM.isWrittenInMainFile(Loc)
+            : !SM.isInSystemHeader(Loc))
+      return false;
+  }
+
   if (!PP.isCodeCompletionEnabled()) {
     SkipFunctionBody();
     return true;
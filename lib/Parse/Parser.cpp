@@ -47,12 +47,16 @@ IdentifierInfo *Parser::getSEHExceptKeyword() {
   return Ident__except;
 }
 
-Parser::Parser(Preprocessor &pp, Sema &actions, bool skipFunctionBodies)
+Parser::Parser(Preprocessor &pp, Sema &actions, bool skipFunctionBodies,
+               SkipFunctionBodiesScope SkipScope)
   : PP(pp), Actions(actions), Diags(PP.getDiagnostics()),
     GreaterThanIsOperator(true), ColonIsSacred(false), 
     InMessageExpression(false), TemplateParameterDepth(0),
     ParsingInObjCContainer(false) {
   SkipFunctionBodies = pp.isCodeCompletionEnabled() || skipFunctionBodies;
+  // Code completion skips the bodies that do not contain the completion
+  // point, wherever they are.
+  SkipFunctionBodiesIn = pp.isCodeCompletionEnabled() ? SFBS_All : SkipScope;
   Tok.startToken();
   Tok.setKind(tok::eof);
   Actions.CurScope = nullptr;
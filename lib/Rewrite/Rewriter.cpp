@@ -31,6 +31,26 @@ raw_ostream &RewriteBuffer::write(raw_ostream &os) const {
   return os;
 }
 
+bool clang::writeEditedBuffer(raw_ostream &Stream, StringRef Input,
+                              ArrayRef<RewriteEdit> Edits) {
+  // Check all the edits first, so that nothing is written if they are invalid.
+  unsigned LastEnd = 0;
+  for (const RewriteEdit &E : Edits) {
+    if (E.OrigOffset < LastEnd || E.OrigOffset > Input.size() ||
+        E.OrigLength > Input.size() - E.OrigOffset)
+      return true;
+    LastEnd = E.OrigOffset + E.OrigLength;
+  }
+
+  unsigned Pos = 0;
+  for (const RewriteEdit &E : Edits) {
+    Stream << Input.slice(Pos, E.OrigOffset) << E.NewText;
+    Pos = E.OrigOffset + E.OrigLength;
+  }
+  Stream << Input.substr(Pos);
+  return false;
+}
+
 /// \brief Return true if this character is non-new-line whitespace:
 /// ' ', '\\t', '\\f', '\\v', '\\r'.
 static inline bool isWhitespaceExceptNL(unsigned char c) {
@@ -0,0 +1,43 @@
+//===--- BoundsSummary.cpp - Checked C bounds of call arguments -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the summary of the bounds of call arguments.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/BoundsSummary.h"
+#include "clang/AST/Decl.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace sema;
+
+void BoundsSummary::CallBounds::merge(unsigned NumCalls,
+                                      ArrayRef<int64_t> Elements) {
+  if (NumCalls == 0)
+    return;
+  if (CallSites == 0)
+    MinElements.assign(Elements.begin(), Elements.end());
+  else {
+    if (MinElements.size() < Elements.size())
+      MinElements.resize(Elements.size(), -1);
+    for (unsigned I = 0, E = MinElements.size(); I != E; ++I) {
+      if (I >= Elements.size() || Elements[I] < 0)
+        MinElements[I] = -1;
+      else if (MinElements[I] >= 0)
+        MinElements[I] = std::min(MinElements[I], Elements[I]);
+    }
+  }
+  CallSites += NumCalls;
+}
+
+void BoundsSummary::addCallSite(const FunctionDecl *Callee,
+                                ArrayRef<int64_t> ArgElements) {
+  Functions[Callee->getCanonicalDecl()].merge(1, ArgElements);
+}
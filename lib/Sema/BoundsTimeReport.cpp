@@ -0,0 +1,169 @@
+//===--- BoundsTimeReport.cpp - Timing of Checked C bounds checks ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the time report for -fcheckedc-time-report.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Sema/BoundsTimeReport.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/Basic/Diagnostic.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace sema;
+
+namespace {
+  // The names of the timers, also used as the JSON fields, and their
+  // descriptions for each category.
+  struct CategoryInfo {
+    const char *Name;
+    const char *Description;
+  };
+
+  const CategoryInfo Categories[BoundsTimeReport::BTC_NumCategories] = {
+    { "inference", "Bounds inference" },
+    { "decl-validity", "Bounds declaration validity proofs" },
+    { "member-bounds", "Member bounds concretization" },
+    { "non-modifying", "Non-modifying expression checks" }
+  };
+
+  // The number of functions printed to stderr.  The JSON file has all of
+  // them.
+  const unsigned NumFunctionsPrinted = 20;
+
+  void WriteJSONString(raw_ostream &OS, StringRef S) {
+    OS << '"';
+    for (char C : S) {
+      switch (C) {
+        case '"': OS << "\\\""; break;
+        case '\\': OS << "\\\\"; break;
+        case '\n': OS << "\\n"; break;
+        case '\t': OS << "\\t"; break;
+        default:
+          if (static_cast<unsigned char>(C) < 0x20)
+            OS << llvm::format("\\u%04x", static_cast<unsigned char>(C));
+          else
+            OS << C;
+      }
+    }
+    OS << '"';
+  }
+}
+
+BoundsTimeReport::BoundsTimeReport(ASTContext &Context, StringRef JSONFile)
+  : Context(Context), JSONFile(JSONFile),
+    Group("checkedc-bounds", "Checked C bounds checking") {
+  for (unsigned I = 0; I != BTC_NumCategories; ++I) {
+    Timers[I].init(Categories[I].Name, Categories[I].Description, Group);
+    Depths[I] = 0;
+  }
+}
+
+void BoundsTimeReport::start(Category Cat) {
+  if (Depths[Cat]++ != 0)
+    return;
+  Timers[Cat].startTimer();
+  StartTimes[Cat] = llvm::TimeRecord::getCurrentTime(true);
+}
+
+void BoundsTimeReport::stop(Category Cat) {
+  assert(Depths[Cat] != 0 && "unbalanced bounds checking timer");
+  if (--Depths[Cat] != 0)
+    return;
+  llvm::TimeRecord Elapsed = llvm::TimeRecord::getCurrentTime(false);
+  Timers[Cat].stopTimer();
+  Elapsed -= StartTimes[Cat];
+  if (FunctionDepth != 0)
+    Current.Parts[Cat] += Elapsed;
+}
+
+void BoundsTimeReport::startFunction(const FunctionDecl *FD) {
+  if (FunctionDepth++ != 0)
+    return;
+  Current = FunctionTimes();
+  Current.Name = FD->getQualifiedNameAsString();
+  Current.Location =
+    FD->getLocation().printToString(Context.getSourceManager());
+  ComparisonsAtStart = Context.LexicographicComparisons;
+  FunctionStart = llvm::TimeRecord::getCurrentTime(true);
+}
+
+void BoundsTimeReport::finishFunction() {
+  assert(FunctionDepth != 0 && "unbalanced function timing");
+  if (--FunctionDepth != 0)
+    return;
+  Current.Total = llvm::TimeRecord::getCurrentTime(false);
+  Current.Total -= FunctionStart;
+  Current.Comparisons = Context.LexicographicComparisons - ComparisonsAtStart;
+  Functions.push_back(std::move(Current));
+}
+
+void BoundsTimeReport::emit() {
+  if (!JSONFile.empty())
+    writeJSON();
+
+  SmallVector<const FunctionTimes *, 16> Sorted;
+  for (const FunctionTimes &F : Functions)
+    Sorted.push_back(&F);
+  std::stable_sort(Sorted.begin(), Sorted.end(),
+                   [](const FunctionTimes *A, const FunctionTimes *B) {
+                     return A->Total.getWallTime() > B->Total.getWallTime();
+                   });
+  if (Sorted.size() > NumFunctionsPrinted)
+    Sorted.resize(NumFunctionsPrinted);
+
+  raw_ostream &OS = llvm::errs();
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "          Checked C bounds checking time per function (wall, "
+        "seconds)\n"
+     << "===" << std::string(73, '-') << "===\n";
+  OS << "  Total functions checked: " << Functions.size() << "\n"
+     << "  Total expression comparisons: "
+     << Context.LexicographicComparisons << "\n\n";
+  OS << "     Total   Infer  Proofs Members  NonMod  Compares  Function\n";
+  for (const FunctionTimes *F : Sorted) {
+    OS << llvm::format("  %8.4f", F->Total.getWallTime());
+    for (unsigned I = 0; I != BTC_NumCategories; ++I)
+      OS << llvm::format(" %7.4f", F->Parts[I].getWallTime());
+    OS << llvm::format(" %9llu", (unsigned long long)F->Comparisons)
+       << "  " << F->Name << " (" << F->Location << ")\n";
+  }
+  OS << "\n";
+}
+
+void BoundsTimeReport::writeJSON() {
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(JSONFile, EC, llvm::sys::fs::F_Text);
+  if (EC) {
+    Context.getDiagnostics().Report(diag::err_cannot_open_file)
+      << JSONFile << EC.message();
+    return;
+  }
+
+  OS << "{\n  \"functions\": [";
+  for (unsigned I = 0, E = Functions.size(); I != E; ++I) {
+    const FunctionTimes &F = Functions[I];
+    OS << (I == 0 ? "\n" : ",\n") << "    { \"name\": ";
+    WriteJSONString(OS, F.Name);
+    OS << ", \"location\": ";
+    WriteJSONString(OS, F.Location);
+    OS << llvm::format(", \"total\": %.6f", F.Total.getWallTime());
+    for (unsigned C = 0; C != BTC_NumCategories; ++C)
+      OS << ", \"" << Categories[C].Name << "\": "
+         << llvm::format("%.6f", F.Parts[C].getWallTime());
+    OS << ", \"comparisons\": " << F.Comparisons << " }";
+  }
+  OS << "\n  ],\n  \"comparisons\": " << Context.LexicographicComparisons
+     << "\n}\n";
+}
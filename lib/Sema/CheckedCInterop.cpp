@@ -297,5 +297,15 @@ public:
 }
 
 QualType Sema::RewriteBoundsSafeInterfaceTypes(QualType Ty) {
-  return TransformFunctionTypeToChecked(*this).TransformType(Ty);
+  // The null type is the empty key of the cache.
+  if (Ty.isNull())
+    return Ty;
+
+  auto It = Context.BoundsSafeInterfaceTypes.find(Ty);
+  if (It != Context.BoundsSafeInterfaceTypes.end())
+    return It->second;
+
+  QualType Result = TransformFunctionTypeToChecked(*this).TransformType(Ty);
+  Context.BoundsSafeInterfaceTypes[Ty] = Result;
+  return Result;
 }
@@ -49,6 +49,7 @@ void FunctionScopeInfo::Clear() {
 
   SwitchStack.clear();
   Returns.clear();
+  CompoundScopes.clear();
   ErrorTrap.reset();
   PossiblyUnreachableDiags.clear();
   WeakObjectUses.clear();
@@ -20,11 +20,14 @@
 #include "clang/AST/Expr.h"
 #include "clang/AST/ExprCXX.h"
 #include "clang/AST/StmtCXX.h"
+#include "clang/Analysis/Analyses/FormatString.h"
 #include "clang/Basic/DiagnosticOptions.h"
 #include "clang/Basic/PartialDiagnostic.h"
 #include "clang/Basic/TargetInfo.h"
 #include "clang/Lex/HeaderSearch.h"
 #include "clang/Lex/Preprocessor.h"
+#include "clang/Sema/BoundsSummary.h"
+#include "clang/Sema/BoundsTimeReport.h"
 #include "clang/Sema/CXXFieldCollector.h"
 #include "clang/Sema/DelayedDiagnostic.h"
 #include "clang/Sema/ExternalSemaSource.h"
@@ -146,6 +149,12 @@ Sema::Sema(Preprocessor &pp, ASTContext &ctxt, ASTConsumer &consumer,
       CurScope(nullptr), Ident_super(nullptr), Ident___float128(nullptr) {
   TUScope = nullptr;
 
+  if (getLangOpts().CheckedCTimeReport)
+    BoundsTimer.reset(new sema::BoundsTimeReport(
+        Context, getLangOpts().CheckedCTimeReportFile));
+  if (getLangOpts().CheckedCBoundsSummary)
+    CallBoundsSummary.reset(new sema::BoundsSummary());
+
   LoadedExternalKnownNamespaces = false;
   for (unsigned I = 0; I != NSAPI::NumNSNumberLiteralMethods; ++I)
     NSNumberLiteralMethods[I] = nullptr;
@@ -856,6 +865,9 @@ void Sema::ActOnEndOfTranslationUnit() {
   if (PP.isCodeCompletionEnabled())
     return;
 
+  if (BoundsTimer)
+    BoundsTimer->emit();
+
   // Complete translation units and modules define vtables and perform implicit
   // instantiations. PCH files do not.
   if (TUKind != TU_Prefix) {
@@ -1363,7 +1375,13 @@ void Sema::PushFunctionScope() {
     return;
   }
 
-  FunctionScopes.push_back(new FunctionScopeInfo(getDiagnostics()));
+  if (!RecycledFunctionScopes.empty()) {
+    FunctionScopeInfo *Scope = RecycledFunctionScopes.pop_back_val().release();
+    Scope->Clear();
+    FunctionScopes.push_back(Scope);
+  } else {
+    FunctionScopes.push_back(new FunctionScopeInfo(getDiagnostics()));
+  }
   if (LangOpts.OpenMP)
     pushOpenMPFunctionRegion();
 }
@@ -1403,7 +1421,14 @@ void Sema::PopFunctionScopeInfo(const AnalysisBasedWarnings::Policy *WP,
     for (const auto &PUD : Scope->PossiblyUnreachableDiags)
       Diag(PUD.Loc, PUD.PD);
 
-  if (FunctionScopes.back() != Scope)
+  if (FunctionScopes.back() == Scope)
+    return;
+
+  // Keep the scopes of nested functions around, rather than freeing them and
+  // their containers, so that the next nested function can reuse them.
+  if (!isa<CapturingScopeInfo>(Scope))
+    RecycledFunctionScopes.emplace_back(Scope);
+  else
     delete Scope;
 }
 
@@ -32,8 +32,19 @@
 
 #include "clang/AST/CanonBounds.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/AST/SymbolicBounds.h"
+#include "clang/Analysis/Analyses/BoundsWidening.h"
+#include "clang/Analysis/Analyses/VarEquiv.h"
+#include "clang/Analysis/CFG.h"
+#include "clang/Basic/TimeTrace.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Sema/BoundsCheckCache.h"
+#include "clang/Sema/BoundsSummary.h"
+#include "clang/Sema/BoundsTimeReport.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/SaveAndRestore.h"
 #include "TreeTransform.h"
 
 using namespace clang;
@@ -66,6 +77,32 @@ public:
 };
 }
 
+namespace {
+  // Returns true if E refers to a positional parameter.
+  bool UsesPositionalParameters(const Stmt *E) {
+    if (isa<PositionalParameterExpr>(E))
+      return true;
+    for (const Stmt *Child : E->children())
+      if (Child && UsesPositionalParameters(Child))
+        return true;
+    return false;
+  }
+
+  // Returns true if E refers to a parameter or a local variable, which
+  // abstraction for a function type replaces or reports.  Other bounds,
+  // such as count(10) or bounds in terms of globals, are left as they are.
+  bool UsesLocalVariables(const Stmt *E) {
+    if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
+      const VarDecl *V = dyn_cast<VarDecl>(DRE->getDecl());
+      return V && V->isLocalVarDeclOrParm();
+    }
+    for (const Stmt *Child : E->children())
+      if (Child && UsesLocalVariables(Child))
+        return true;
+    return false;
+  }
+}
+
 namespace {
   class AbstractBoundsExpr : public TreeTransform<AbstractBoundsExpr> {
     typedef TreeTransform<AbstractBoundsExpr> BaseTransform;
@@ -140,6 +177,9 @@ bool Sema::AbstractForFunctionType(
   // as  aresult of abstraction.  Just return the original annotation.
   if (!Expr)
     return false;
+  // Rebuilding bounds that don't refer to parameters would only copy them.
+  if (!UsesLocalVariables(Expr))
+    return false;
 
   BoundsExpr *Result = nullptr;
   ExprResult AbstractedBounds =
@@ -187,7 +227,7 @@ namespace {
 
 BoundsExpr *Sema::ConcretizeFromFunctionType(BoundsExpr *Expr,
                                              ArrayRef<ParmVarDecl *> Params) {
-  if (!Expr)
+  if (!Expr || !UsesPositionalParameters(Expr))
     return Expr;
 
   BoundsExpr *Result;
@@ -264,12 +304,76 @@ namespace {
   };
 }
 
+namespace {
+  // Returns true if Arg is a use of a non-volatile variable or an integer
+  // constant.  These are non-modifying expressions.
+  bool IsSimpleArgument(Expr *Arg) {
+    Arg = Arg->IgnoreParenImpCasts();
+    if (isa<IntegerLiteral>(Arg) || isa<CharacterLiteral>(Arg))
+      return true;
+    if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(Arg))
+      return isa<VarDecl>(DRE->getDecl()) &&
+             !DRE->getType().isVolatileQualified();
+    return false;
+  }
+
+  // Concretize count(n) and byte_count(n) bounds, where n is a parameter
+  // whose argument is simple, without a TreeTransform.  This is the result
+  // that ConcretizeBoundsExprWithArgs produces: the argument converted to
+  // the parameter type becomes the count.  Returns null for other bounds.
+  BoundsExpr *ConcretizeSimpleCountBounds(Sema &S, BoundsExpr *Bounds,
+                                          ArrayRef<Expr *> Args) {
+    CountBoundsExpr *CBE = dyn_cast<CountBoundsExpr>(Bounds);
+    if (!CBE)
+      return nullptr;
+    Expr *Count = CBE->getCountExpr();
+    if (ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(Count))
+      if (ICE->getCastKind() == CK_LValueToRValue)
+        Count = ICE->getSubExpr();
+    PositionalParameterExpr *PE = dyn_cast<PositionalParameterExpr>(Count);
+    if (!PE || PE->getIndex() >= Args.size() ||
+        !IsSimpleArgument(Args[PE->getIndex()]))
+      return nullptr;
+    Expr *Arg = S.MakeAssignmentImplicitCastExplicit(Args[PE->getIndex()]);
+    // Building the bounds through Sema would apply the integer promotions.
+    QualType ArgTy = Arg->getType();
+    if (!Arg->isRValue() || !ArgTy->isIntegerType() ||
+        ArgTy->isPromotableIntegerType() ||
+        !S.Context.isPromotableBitField(Arg).isNull())
+      return nullptr;
+    return new (S.Context) CountBoundsExpr(CBE->getKind(), Arg,
+                                           CBE->getStartLoc(),
+                                           CBE->getRParenLoc());
+  }
+}
+
+ArrayRef<Sema::FunctionParamBounds>
+Sema::GetFunctionTypeParamBounds(const FunctionProtoType *FPT) {
+  auto It = FunctionTypeParamBounds.find(FPT);
+  if (It != FunctionTypeParamBounds.end())
+    return It->second;
+
+  SmallVector<FunctionParamBounds, 4> &Result = FunctionTypeParamBounds[FPT];
+  for (unsigned I = 0, E = FPT->getNumParams(); I != E; ++I) {
+    const BoundsAnnotations ParamAnnots = FPT->getParamAnnots(I);
+    BoundsExpr *Bounds = const_cast<BoundsExpr *>(ParamAnnots.getBoundsExpr());
+    const InteropTypeExpr *IType = ParamAnnots.getInteropTypeExpr();
+    if (!Bounds && IType)
+      Bounds = CreateTypeBasedBounds(nullptr, IType->getType(), true, true);
+    Result.push_back({ Bounds, Bounds && UsesPositionalParameters(Bounds) });
+  }
+  return Result;
+}
+
 BoundsExpr *Sema::ConcretizeFromFunctionTypeWithArgs(
   BoundsExpr *Bounds, ArrayRef<Expr *> Args,
   NonModifyingContext ErrorKind) {
-  if (!Bounds || Bounds->isInvalid())
+  if (!Bounds || Bounds->isInvalid() || !UsesPositionalParameters(Bounds))
     return Bounds;
 
+  if (BoundsExpr *Result = ConcretizeSimpleCountBounds(*this, Bounds, Args))
+    return Result;
+
   auto CheckArgs = CheckForModifyingArgs(*this, Args, ErrorKind);
   CheckArgs.TraverseStmt(Bounds);
   if (CheckArgs.FoundModifyingArg())
@@ -301,6 +405,44 @@ BoundsExpr *Sema::ConcretizeFromFunctionTypeWithArgs(
 }
 
 namespace {
+  // Returns true if E refers to a member.
+  bool UsesMembers(const Stmt *E) {
+    if (const DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E))
+      return isa<FieldDecl>(DRE->getDecl());
+    for (const Stmt *Child : E->children())
+      if (Child && UsesMembers(Child))
+        return true;
+    return false;
+  }
+
+  // If E, without its implicit casts, refers to a member, return the
+  // reference.
+  DeclRefExpr *GetMemberReference(Expr *E) {
+    while (ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(E))
+      E = ICE->getSubExpr();
+    DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E);
+    if (DRE && isa<FieldDecl>(DRE->getDecl()))
+      return DRE;
+    return nullptr;
+  }
+
+  // Create the access to the member that E refers to, through Base.
+  // Returns null if Base is an rvalue.
+  MemberExpr *CreateMemberAccess(ASTContext &Context, Expr *Base,
+                                 bool IsArrow, DeclRefExpr *E) {
+    if (Base->isRValue() && !IsArrow)
+      return nullptr;
+    ExprValueKind ResultKind;
+    if (IsArrow)
+      ResultKind = VK_LValue;
+    else
+      ResultKind = Base->isLValue() ? VK_LValue : VK_RValue;
+    return new (Context) MemberExpr(Base, IsArrow, SourceLocation(),
+                                    cast<FieldDecl>(E->getDecl()),
+                                    SourceLocation(), E->getType(),
+                                    ResultKind, OK_Ordinary);
+  }
+
   class ConcretizeMemberBounds : public TreeTransform<ConcretizeMemberBounds> {
     typedef TreeTransform<ConcretizeMemberBounds> BaseTransform;
 
@@ -326,20 +468,12 @@ namespace {
     //
     // rVvalue structs can arise from function returns of struct values.
     ExprResult TransformDeclRefExpr(DeclRefExpr *E) {
-      if (FieldDecl *FD = dyn_cast<FieldDecl>(E->getDecl())) {
-        if (Base->isRValue() && !IsArrow)
+      if (isa<FieldDecl>(E->getDecl())) {
+        MemberExpr *ME = CreateMemberAccess(SemaRef.getASTContext(), Base,
+                                            IsArrow, E);
+        if (!ME)
           // For now, return an error if we see an rvalue base.
           return ExprError();
-        ASTContext &Context = SemaRef.getASTContext();
-        ExprValueKind ResultKind;
-        if (IsArrow)
-          ResultKind = VK_LValue;
-        else
-          ResultKind = Base->isLValue() ? VK_LValue : VK_RValue;
-        MemberExpr *ME =
-          new (Context) MemberExpr(Base, IsArrow,
-                                   SourceLocation(), FD, SourceLocation(),
-                                   E->getType(), ResultKind, OK_Ordinary);
         return ME;
       }
       return E;
@@ -351,7 +485,43 @@ BoundsExpr *Sema::MakeMemberBoundsConcrete(
   Expr *Base,
   bool IsArrow,
   BoundsExpr *Bounds) {
+  sema::BoundsTimeReport::Region Timing(BoundsTimer.get(),
+    sema::BoundsTimeReport::BTC_MemberBounds);
+  auto It = MemberBoundsShapes.find(Bounds);
+  if (It == MemberBoundsShapes.end()) {
+    MemberBoundsShape Shape = MBS_Other;
+    if (!UsesMembers(Bounds))
+      Shape = MBS_NoMembers;
+    else if (CountBoundsExpr *CBE = dyn_cast<CountBoundsExpr>(Bounds))
+      if (GetMemberReference(CBE->getCountExpr()))
+        Shape = MBS_MemberCount;
+    It = MemberBoundsShapes.insert({ Bounds, Shape }).first;
+  }
+
   ExprSubstitutionScope Scope(*this); // suppress diagnostics
+  switch (It->second) {
+    case MBS_NoMembers:
+      return Bounds;
+    case MBS_MemberCount: {
+      // Build the bounds as the transform would: the implicit casts of the
+      // count are recomputed for the member access.
+      CountBoundsExpr *CBE = cast<CountBoundsExpr>(Bounds);
+      MemberExpr *ME =
+        CreateMemberAccess(Context, Base, IsArrow,
+                           GetMemberReference(CBE->getCountExpr()));
+      if (!ME)
+        return nullptr;
+      ExprResult ConcreteBounds =
+        ActOnCountBoundsExpr(CBE->getStartLoc(), CBE->getKind(), ME,
+                             CBE->getRParenLoc());
+      if (ConcreteBounds.isInvalid())
+        return nullptr;
+      return cast<BoundsExpr>(ConcreteBounds.get());
+    }
+    case MBS_Other:
+      break;
+  }
+
   ExprResult ConcreteBounds =
     ConcretizeMemberBounds(*this, Base, IsArrow).TransformExpr(Bounds);
   if (ConcreteBounds.isInvalid())
@@ -403,13 +573,22 @@ namespace {
   class BoundsInference {
 
   private:
-    // TODO: be more flexible about where bounds expression are allocated.
     Sema &SemaRef;
     ASTContext &Context;
     // When this flag is set to true, include the null terminator in the
     // bounds of a null-terminated array.  This is used when calculating
     // physical sizes during casts to pointers to null-terminated arrays.
     bool IncludeNullTerminator;
+    // The storage for the casts, arithmetic and ranges built by this object,
+    // if they are transient.  Null if they are allocated in the ASTContext.
+    llvm::BumpPtrAllocator *Scratch;
+
+    // Allocate memory for a node of type T.
+    template <typename T> void *AllocateNode() {
+      if (Scratch)
+        return Scratch->Allocate(sizeof(T), alignof(T));
+      return Context.Allocate(sizeof(T), alignof(T));
+    }
 
     BoundsExpr *CreateBoundsUnknown() {
       return Context.getPrebuiltBoundsUnknown();
@@ -471,6 +650,10 @@ namespace {
   public:
     ImplicitCastExpr *CreateImplicitCast(QualType Target, CastKind CK,
                                          Expr *E) {
+      if (Scratch)
+        return new (AllocateNode<ImplicitCastExpr>())
+          ImplicitCastExpr(ImplicitCastExpr::OnStack, Target, CK, E,
+                           ExprValueKind::VK_RValue);
       return ImplicitCastExpr::Create(Context, Target, CK, E, nullptr,
                                        ExprValueKind::VK_RValue);
     }
@@ -619,16 +802,18 @@ namespace {
             }
           }
           Expr *UpperBound =
-            new (Context) BinaryOperator(LowerBound, Count,
-                                          BinaryOperatorKind::BO_Add,
-                                          ResultTy,
-                                          ExprValueKind::VK_RValue,
-                                          ExprObjectKind::OK_Ordinary,
-                                          SourceLocation(),
-                                          FPOptions());
-          RangeBoundsExpr *R = new (Context) RangeBoundsExpr(LowerBound, UpperBound,
-                                               SourceLocation(),
-                                               SourceLocation());
+            new (AllocateNode<BinaryOperator>())
+              BinaryOperator(LowerBound, Count,
+                             BinaryOperatorKind::BO_Add,
+                             ResultTy,
+                             ExprValueKind::VK_RValue,
+                             ExprObjectKind::OK_Ordinary,
+                             SourceLocation(),
+                             FPOptions());
+          RangeBoundsExpr *R =
+            new (AllocateNode<RangeBoundsExpr>())
+              RangeBoundsExpr(LowerBound, UpperBound, SourceLocation(),
+                              SourceLocation());
           return R;
         }
         default:
@@ -636,9 +821,70 @@ namespace {
       }
     }
 
+    // Expand the bounds B declared for the variable D to a range bounds
+    // expression.
+    BoundsExpr *ExpandToRange(VarDecl *D, BoundsExpr *B) {
+      QualType QT = D->getType();
+      ExprResult ER = SemaRef.BuildDeclRefExpr(D, QT,
+                                               clang::ExprValueKind::VK_LValue,
+                                               SourceLocation());
+      if (ER.isInvalid())
+        return nullptr;
+      Expr *Base = ER.get();
+      if (!QT->isArrayType())
+        Base = CreateImplicitCast(QT, CastKind::CK_LValueToRValue, Base);
+      return ExpandToRange(Base, B);
+    }
+
+    typedef BoundsExpr *(BoundsInference::*InferenceFn)(Expr *E);
+
+    // While the bounds declarations of a function body are checked, the
+    // same subexpressions are asked for their bounds many times.  Look up
+    // the bounds of E inferred by Compute in the cache of the function,
+    // computing them if needed.
+    BoundsExpr *Memoize(Expr *E, Sema::BoundsInferenceKind Kind,
+                        InferenceFn Compute) {
+      if (!SemaRef.InferredBoundsCacheEnabled)
+        return (this->*Compute)(E);
+      Sema::InferredBoundsKey Key(E, (Kind << 1) | IncludeNullTerminator);
+      auto It = SemaRef.InferredBoundsCache.find(Key);
+      if (It != SemaRef.InferredBoundsCache.end())
+        return It->second;
+      // Computing the bounds may add to the cache, so do not hold on to It.
+      BoundsExpr *Bounds = (this->*Compute)(E);
+      SemaRef.InferredBoundsCache[Key] = Bounds;
+      return Bounds;
+    }
+
   public:
     BoundsInference(Sema &S, bool IncludeNullTerminator = false) : SemaRef(S),
-      Context(S.getASTContext()), IncludeNullTerminator(IncludeNullTerminator) {
+      Context(S.getASTContext()), IncludeNullTerminator(IncludeNullTerminator),
+      Scratch(nullptr) {
+    }
+
+    // Create an object whose casts, arithmetic and ranges are allocated in
+    // the transient bounds storage of the function body being checked, if
+    // there is one.  The expressions it builds must not be attached to the
+    // AST.
+    static BoundsInference Transient(Sema &S) {
+      BoundsInference BI(S);
+      BI.Scratch = S.TransientBoundsAlloc;
+      return BI;
+    }
+
+    BoundsExpr *LValueBounds(Expr *E) {
+      return Memoize(E, Sema::BIK_LValue,
+                     &BoundsInference::ComputeLValueBounds);
+    }
+
+    BoundsExpr *LValueTargetBounds(Expr *E) {
+      return Memoize(E, Sema::BIK_LValueTarget,
+                     &BoundsInference::ComputeLValueTargetBounds);
+    }
+
+    BoundsExpr *RValueBounds(Expr *E) {
+      return Memoize(E, Sema::BIK_RValue,
+                     &BoundsInference::ComputeRValueBounds);
     }
 
     // Compute bounds for a variable expression or member reference expression
@@ -665,7 +911,7 @@ namespace {
     // The returned bounds expression may contain a modifying expression within
     // it. It is the caller's responsibility to validate that the bounds
     // expression is non-modifying.
-    BoundsExpr *LValueBounds(Expr *E) {
+    BoundsExpr *ComputeLValueBounds(Expr *E) {
       // E may not be an lvalue if there is a typechecking error when struct 
       // accesses member array incorrectly.
       if (!E->isLValue()) return CreateBoundsInferenceError();
@@ -844,7 +1090,7 @@ namespace {
     // The returned bounds expression may contain a modifying expression within
     // it. It is the caller's responsibility to validate that the bounds
     // expression is non-modifying.
-    BoundsExpr *LValueTargetBounds(Expr *E) {
+    BoundsExpr *ComputeLValueTargetBounds(Expr *E) {
       if (!E->isLValue()) return CreateBoundsInferenceError();
       E = E->IgnoreParens();
       QualType QT = E->getType();
@@ -984,7 +1230,7 @@ namespace {
     // The returned bounds expression may contain a modifying expression within
     // it. It is the caller's responsibility to validate that the bounds
     // expression is non-modifying.
-    BoundsExpr *RValueBounds(Expr *E) {
+    BoundsExpr *ComputeRValueBounds(Expr *E) {
       if (!E->isRValue()) return CreateBoundsInferenceError();
 
       E = E->IgnoreParens();
@@ -1292,6 +1538,8 @@ BoundsExpr *Sema::CheckNonModifyingBounds(BoundsExpr *B, Expr *E) {
 }
 
 BoundsExpr *Sema::InferLValueBounds(Expr *E) {
+  sema::BoundsTimeReport::Region Timing(BoundsTimer.get(),
+    sema::BoundsTimeReport::BTC_Inference);
   BoundsExpr *Bounds = BoundsInference(*this).LValueBounds(E);
   return CheckNonModifyingBounds(Bounds, E);
 }
@@ -1303,11 +1551,15 @@ BoundsExpr *Sema::CreateTypeBasedBounds(Expr *E, QualType Ty, bool IsParam,
 }
 
 BoundsExpr *Sema::InferLValueTargetBounds(Expr *E) {
+  sema::BoundsTimeReport::Region Timing(BoundsTimer.get(),
+    sema::BoundsTimeReport::BTC_Inference);
   BoundsExpr *Bounds = BoundsInference(*this).LValueTargetBounds(E);
   return CheckNonModifyingBounds(Bounds, E);
 }
 
 BoundsExpr *Sema::InferRValueBounds(Expr *E, bool IncludeNullTerminator) {
+  sema::BoundsTimeReport::Region Timing(BoundsTimer.get(),
+    sema::BoundsTimeReport::BTC_Inference);
   BoundsExpr *Bounds =
     BoundsInference(*this, IncludeNullTerminator).RValueBounds(E);
   return CheckNonModifyingBounds(Bounds, E);
@@ -1322,16 +1574,7 @@ BoundsExpr *Sema::ExpandToRange(Expr *Base, BoundsExpr *B) {
 }
 
 BoundsExpr *Sema::ExpandToRange(VarDecl *D, BoundsExpr *B) {
-  QualType QT = D->getType();
-  ExprResult ER = BuildDeclRefExpr(D, QT,
-                                   clang::ExprValueKind::VK_LValue, SourceLocation());
-  if (ER.isInvalid())
-    return nullptr;
-  Expr *Base = ER.get();
-  BoundsInference BI(*this);
-  if (!QT->isArrayType())
-    Base = BI.CreateImplicitCast(QT, CastKind::CK_LValueToRValue, Base);
-  return BI.ExpandToRange(Base, B);
+  return BoundsInference(*this).ExpandToRange(D, B);
 }
 
 Expr *Sema::MakeAssignmentImplicitCastExplicit(Expr *E) {
@@ -1381,12 +1624,20 @@ namespace {
     uint64_t PointerWidth;
     BoundsExpr *ReturnBounds; // return bounds expression for enclosing
                               // function, if any.
+    VarEquiv *Facts;          // equalities between variables computed by
+                              // dataflow analysis, if enabled.
+    BoundsWidening *Widening; // null-terminated pointers whose bounds can be
+                              // widened, if dataflow analysis is enabled.
+    // The expressions used to state those equalities, created once per
+    // variable or constant.
+    llvm::DenseMap<const VarDecl *, Expr *> VarValues;
+    llvm::DenseMap<std::pair<const Type *, int64_t>, Expr *> IntegerConstants;
 
     void DumpAssignmentBounds(raw_ostream &OS, BinaryOperator *E,
                               BoundsExpr *LValueTargetBounds,
                               BoundsExpr *RHSBounds) {
       OS << "\n";
-      E->dump(OS);
+      E->dump(OS, S.Context);
       if (LValueTargetBounds) {
         OS << "Target Bounds:\n";
         LValueTargetBounds->dump(OS);
@@ -1401,7 +1652,7 @@ namespace {
                               BoundsExpr *Declared, BoundsExpr *NormalizedDeclared,
                               BoundsExpr *SubExprBounds) {
       OS << "\n";
-      E->dump(OS);
+      E->dump(OS, S.Context);
       if (Declared) {
         OS << "Declared Bounds:\n";
         Declared->dump(OS);
@@ -1428,7 +1679,7 @@ namespace {
 
     void DumpExpression(raw_ostream &OS, Expr *E) {
       OS << "\n";
-      E->dump(OS);
+      E->dump(OS, S.Context);
     }
 
     // Add bounds check to an lvalue expression, if it is an Array_ptr
@@ -1457,6 +1708,7 @@ namespace {
         // Null-terminated array pointers have special semantics for
         // bounds checks.
         if (PtrType->isCheckedPointerNtArrayType()) {
+          LValueBounds = WidenBounds(Deref, LValueBounds);
           if (OpKind == OperationKind::Read)
             Kind = BCK_NullTermRead;
           else if (OpKind == OperationKind::Assign)
@@ -1467,16 +1719,19 @@ namespace {
           S.Diag(E->getLocStart(), diag::err_expected_bounds) << E->getSourceRange();
           LValueBounds = S.CreateInvalidBoundsExpr();
         } else {
-          CheckBoundsAtMemoryAccess(Deref, LValueBounds, Kind, InCheckedScope);
+          ProofResult Result = CheckBoundsAtMemoryAccess(Deref, LValueBounds,
+                                                         Kind, InCheckedScope);
+          if (IsProvenAccess(Result, InCheckedScope))
+            Kind = BCK_None;
         }
         if (UnaryOperator *UO = dyn_cast<UnaryOperator>(Deref)) {
           assert(!UO->hasBoundsExpr());
-          UO->setBoundsExpr(LValueBounds);
+          UO->setBoundsExpr(S.Context, LValueBounds);
           UO->setBoundsCheckKind(Kind);
 
         } else if (ArraySubscriptExpr *AS = dyn_cast<ArraySubscriptExpr>(Deref)) {
           assert(!AS->hasBoundsExpr());
-          AS->setBoundsExpr(LValueBounds);
+          AS->setBoundsExpr(S.Context, LValueBounds);
           AS->setBoundsCheckKind(Kind);
         } else
           llvm_unreachable("unexpected expression kind");
@@ -1484,6 +1739,91 @@ namespace {
       return NeedsBoundsCheck;
     }
 
+    // Return the variable whose value is the pointer that Deref accesses
+    // memory through, ignoring pointer arithmetic, or null.
+    const VarDecl *GetAccessedVar(Expr *Deref) {
+      Expr *Ptr;
+      if (UnaryOperator *UO = dyn_cast<UnaryOperator>(Deref))
+        Ptr = UO->getSubExpr();
+      else if (ArraySubscriptExpr *AS = dyn_cast<ArraySubscriptExpr>(Deref))
+        Ptr = AS->getBase();
+      else
+        return nullptr;
+      while (true) {
+        Ptr = Ptr->IgnoreParens();
+        if (ImplicitCastExpr *ICE = dyn_cast<ImplicitCastExpr>(Ptr)) {
+          if (ICE->getCastKind() != CK_LValueToRValue &&
+              ICE->getCastKind() != CK_NoOp)
+            return nullptr;
+          Ptr = ICE->getSubExpr();
+        } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(Ptr)) {
+          if (BO->getOpcode() != BO_Add && BO->getOpcode() != BO_Sub)
+            return nullptr;
+          if (BO->getLHS()->getType()->isPointerType()) {
+            if (!BO->getRHS()->getType()->isIntegerType())
+              return nullptr;
+            Ptr = BO->getLHS();
+          } else if (BO->getOpcode() == BO_Add)
+            Ptr = BO->getRHS();
+          else
+            return nullptr;
+        } else
+          break;
+      }
+      if (DeclRefExpr *DR = dyn_cast<DeclRefExpr>(Ptr))
+        return dyn_cast<VarDecl>(DR->getDecl());
+      return nullptr;
+    }
+
+    // If the element at the upper bound of Bounds, the bounds of the
+    // _Nt_array_ptr that Deref accesses memory through, is known to be
+    // non-null before Deref, return the bounds widened by one element.
+    // The widened bounds are kept on the AST for code generation, so they
+    // are allocated in the ASTContext.
+    BoundsExpr *WidenBounds(Expr *Deref, BoundsExpr *Bounds) {
+      if (!Widening)
+        return Bounds;
+      RangeBoundsExpr *Range = dyn_cast<RangeBoundsExpr>(Bounds);
+      const VarDecl *V = GetAccessedVar(Deref);
+      if (!Range || !V || !Widening->isWidenedBefore(Deref, V))
+        return Bounds;
+
+      // Fold the increment into a constant offset: (lo, p + c) becomes
+      // (lo, p + (c + 1)) rather than (lo, (p + c) + 1).
+      Expr *Upper = Range->getUpperExpr();
+      Expr *Base = Upper;
+      QualType OffsetTy = S.Context.IntTy;
+      llvm::APSInt Offset(S.Context.getIntWidth(OffsetTy), false);
+      if (BinaryOperator *BO = dyn_cast<BinaryOperator>(Upper->IgnoreParens()))
+        if (BO->getOpcode() == BO_Add &&
+            BO->getLHS()->getType()->isPointerType()) {
+          Expr *RHS = BO->getRHS();
+          llvm::APSInt Value;
+          if (RHS->isIntegerConstantExpr(Value, S.Context)) {
+            OffsetTy = RHS->getType();
+            Base = BO->getLHS();
+            Offset = Value;
+          }
+        }
+      bool Overflow;
+      llvm::APSInt One(llvm::APInt(Offset.getBitWidth(), 1),
+                       Offset.isUnsigned());
+      Offset = Offset.isUnsigned() ? Offset.uadd_ov(One, Overflow)
+                                   : Offset.sadd_ov(One, Overflow);
+      if (Overflow)
+        return Bounds;
+      Expr *Increment = IntegerLiteral::Create(S.Context, Offset, OffsetTy,
+                                               SourceLocation());
+      Expr *WidenedUpper =
+        new (S.Context) BinaryOperator(Base, Increment, BO_Add,
+                                       Base->getType(), VK_RValue,
+                                       OK_Ordinary, SourceLocation(),
+                                       FPOptions());
+      return new (S.Context) RangeBoundsExpr(Range->getLowerExpr(),
+                                             WidenedUpper, SourceLocation(),
+                                             SourceLocation());
+    }
+
     // Add bounds check to the base expression of a member reference, if the
     // base expression is an Array_ptr dereference.  Such base expressions
     // always need bounds checks, even though their lvalues are only used for an
@@ -1505,9 +1845,11 @@ namespace {
           S.Diag(Base->getLocStart(), diag::err_expected_bounds) << Base->getSourceRange();
           Bounds = S.CreateInvalidBoundsExpr();
         } else {
-          CheckBoundsAtMemoryAccess(E, Bounds, BCK_Normal, InCheckedScope);
+          ProofResult Result = CheckBoundsAtMemoryAccess(E, Bounds, BCK_Normal,
+                                                         InCheckedScope);
+          E->setBoundsCheckProven(IsProvenAccess(Result, InCheckedScope));
         }
-        E->setBoundsExpr(Bounds);
+        E->setBoundsExpr(S.Context, Bounds);
         return true;
       }
 
@@ -1611,8 +1953,7 @@ namespace {
 
       // Does R partially overlap this range?
       ProofResult PartialOverlap(ConstantSizedRange &R) {
-        if (Lexicographic(S.Context, nullptr).CompareExpr(Base, R.Base) ==
-            Lexicographic::Result::Equal) {
+        if (Lexicographic(S.Context, nullptr).EqualExprs(Base, R.Base)) {
           if (!IsEmpty() && !R.IsEmpty()) {
             // R.LowerOffset is within this range, but R.UpperOffset is above the range
             if (LowerOffset <= R.LowerOffset && R.LowerOffset < UpperOffset &&
@@ -1638,6 +1979,18 @@ namespace {
         return UpperOffset - LowerOffset;
       }
 
+      Expr *GetBase() {
+        return Base;
+      }
+
+      const llvm::APSInt &GetLower() {
+        return LowerOffset;
+      }
+
+      const llvm::APSInt &GetUpper() {
+        return UpperOffset;
+      }
+
       void SetBase(Expr *B) {
         Base = B;
       }
@@ -1749,8 +2102,7 @@ namespace {
     }
 
     static bool EqualValue(ASTContext &Ctx, Expr *E1, Expr *E2, EquivExprSets *EquivExprs) {
-      Lexicographic::Result R = Lexicographic(Ctx, EquivExprs).CompareExpr(E1, E2);
-      return R == Lexicographic::Result::Equal;
+      return Lexicographic(Ctx, EquivExprs).EqualExprs(E1, E2);
     }
 
     // Convert a bounds expression to a constant-sized range.  Returns true if the
@@ -1786,7 +2138,50 @@ namespace {
       return false;
     }
 
+    // The number of elements of the referent type of ParamType that Arg, an
+    // argument with bounds ArgBounds, is proved to point to, or -1.  This is
+    // recorded for the bounds summary.
+    int64_t GetArgElementCount(Expr *Arg, BoundsExpr *ArgBounds,
+                               QualType ParamType) {
+      llvm::APSInt ElemSize;
+      if (!ParamType->isCheckedPointerArrayType() ||
+          !getReferentSizeInChars(ParamType, ElemSize) || ElemSize == 0)
+        return -1;
+      ConstantSizedRange Range(S);
+      if (!CreateConstantRange(ArgBounds, &Range, nullptr))
+        return -1;
+      Expr *ArgBase;
+      llvm::APSInt ArgOffset;
+      SplitIntoBaseAndOffset(Arg, ArgBase, ArgOffset);
+      if (!EqualValue(S.Context, Range.GetBase(), ArgBase, nullptr) ||
+          Range.GetLower() > ArgOffset || Range.GetUpper() < ArgOffset)
+        return -1;
+      llvm::APSInt Size = Range.GetUpper() - ArgOffset;
+      return (Size / ElemSize).getExtValue();
+    }
+
+    // A proof of the validity of declared bounds, remembered for the rest
+    // of the function.  Generated code checks the same pairs of bounds over
+    // and over, for example at each p = p + 1.
+    struct DeclValidityProof {
+      const BoundsExpr *DeclaredBounds;
+      const BoundsExpr *SrcBounds;
+      ProofStmtKind Kind;
+      // A copy of the equality facts of the proof, or null if there were
+      // none.
+      std::unique_ptr<EquivExprSets> EquivExprs;
+      ProofResult Result;
+      ProofFailure Cause;
+    };
+
+    // The proofs, keyed by a hash of the bounds, the kind of proof and the
+    // facts.  Bounds are matched up to lexicographic equality without facts.
+    llvm::DenseMap<unsigned, SmallVector<DeclValidityProof, 1>>
+      DeclValidityProofs;
+
     // Try to prove that SrcBounds implies the validity of DeclaredBounds.
+    // EquivExprs, if non-null, holds the sets of expressions known to be
+    // equal at the point of the check.
     //
     // If Kind is StaticBoundsCast, check whether a static cast between Ptr
     // types from SrcBounds to DestBounds is legal.
@@ -1796,6 +2191,8 @@ namespace {
                                         EquivExprSets *EquivExprs,
                                         ProofStmtKind Kind =
                                           ProofStmtKind::BoundsDeclaration) {
+      sema::BoundsTimeReport::Region Timing(S.BoundsTimer.get(),
+        sema::BoundsTimeReport::BTC_DeclValidity);
       assert(BoundsUtil::IsStandardForm(DeclaredBounds) &&
         "declared bounds not in standard form");
       assert(BoundsUtil::IsStandardForm(SrcBounds) &&
@@ -1814,6 +2211,41 @@ namespace {
       if (DeclaredBounds->isUnknown())
         return ProofResult::True;
 
+      if (EquivExprs && EquivExprs->empty())
+        EquivExprs = nullptr;
+      Lexicographic Lex(S.Context, nullptr);
+      unsigned Hash = llvm::hash_combine(Lex.HashExpr(DeclaredBounds),
+                                         Lex.HashExpr(SrcBounds),
+                                         (unsigned) Kind,
+                                         EquivExprs ? EquivExprs->getHash() : 0);
+      for (DeclValidityProof &Proof : DeclValidityProofs[Hash]) {
+        if (Proof.Kind == Kind &&
+            !Proof.EquivExprs == !EquivExprs &&
+            Lex.EqualExprs(Proof.DeclaredBounds, DeclaredBounds) &&
+            Lex.EqualExprs(Proof.SrcBounds, SrcBounds) &&
+            (!EquivExprs || Proof.EquivExprs->hasSameSets(*EquivExprs))) {
+          Cause = Proof.Cause;
+          return Proof.Result;
+        }
+      }
+
+      ProofResult Result = ProveBoundsDeclValidityUncached(
+        DeclaredBounds, SrcBounds, Cause, EquivExprs, Kind);
+      DeclValidityProof Proof = {
+        DeclaredBounds, SrcBounds, Kind,
+        std::unique_ptr<EquivExprSets>(
+          EquivExprs ? new EquivExprSets(*EquivExprs) : nullptr),
+        Result, Cause
+      };
+      DeclValidityProofs[Hash].push_back(std::move(Proof));
+      return Result;
+    }
+
+    ProofResult ProveBoundsDeclValidityUncached(const BoundsExpr *DeclaredBounds,
+                                                const BoundsExpr *SrcBounds,
+                                                ProofFailure &Cause,
+                                                EquivExprSets *EquivExprs,
+                                                ProofStmtKind Kind) {
       if (S.Context.EquivalentBounds(DeclaredBounds, SrcBounds, EquivExprs))
         return ProofResult::True;
 
@@ -1847,15 +2279,124 @@ namespace {
             return ProofResult::True;
           }
         }
-        return R;
+        if (R != ProofResult::Maybe)
+          return R;
       }
+      if (S.getLangOpts().CheckedCSymbolicBounds)
+        return ProveSymbolicBoundsDeclValidity(DeclaredBounds, SrcBounds,
+                                               Cause, EquivExprs, Kind);
       return ProofResult::Maybe;
     }
 
+    static ProofResult ConvertSymbolicResult(SymbolicBoundsProver::Result R) {
+      switch (R) {
+        case SymbolicBoundsProver::Result::True: return ProofResult::True;
+        case SymbolicBoundsProver::Result::False: return ProofResult::False;
+        case SymbolicBoundsProver::Result::Maybe: return ProofResult::Maybe;
+      }
+      llvm_unreachable("unexpected symbolic proof result");
+    }
+
+    // Try to prove that SrcBounds implies the validity of DeclaredBounds when
+    // their bounds differ by linear expressions over variables, such as
+    // bounds(p, p + n - 1) and bounds(p, p + n).  This is used with
+    // -fcheckedc-symbolic-bounds when the constant-sized ranges don't decide
+    // the proof.
+    ProofResult ProveSymbolicBoundsDeclValidity(const BoundsExpr *DeclaredBounds,
+                                                const BoundsExpr *SrcBounds,
+                                                ProofFailure &Cause,
+                                                EquivExprSets *EquivExprs,
+                                                ProofStmtKind Kind) {
+      SymbolicBoundsProver Prover(S.Context, EquivExprs);
+      SymbolicRange DeclaredRange, SrcRange;
+      if (!Prover.createRange(DeclaredBounds, DeclaredRange) ||
+          !Prover.createRange(SrcBounds, SrcRange))
+        return ProofResult::Maybe;
+
+      ProofResult Width =
+        ConvertSymbolicResult(Prover.notWider(DeclaredRange, SrcRange));
+      if (Kind == ProofStmtKind::StaticBoundsCast && Width == ProofResult::True)
+        return ProofResult::True;
+
+      bool LowerFails, UpperFails;
+      ProofResult R = ConvertSymbolicResult(
+        Prover.inRange(SrcRange, DeclaredRange, LowerFails, UpperFails));
+      if (R == ProofResult::True)
+        return R;
+      Cause = ProofFailure::None;
+      if (LowerFails)
+        Cause = CombineFailures(Cause, ProofFailure::LowerBound);
+      if (UpperFails)
+        Cause = CombineFailures(Cause, ProofFailure::UpperBound);
+      if (Prover.isEmpty(SrcRange) == SymbolicBoundsProver::Result::True)
+        Cause = CombineFailures(Cause, ProofFailure::Empty);
+      if (Width == ProofResult::False) {
+        Cause = CombineFailures(Cause, ProofFailure::Width);
+        R = ProofResult::False;
+      }
+      return R;
+    }
+
     // Try to prove that PtrBase + Offset is within Bounds, where PtrBase has pointer type.
-    // Offset is optional and may be a nullptr.
+    // Offset is optional and may be a nullptr.  EquivExprs, if non-null, holds the sets
+    // of expressions known to be equal at the access.
     ProofResult ProveMemoryAccessInRange(Expr *PtrBase, Expr *Offset, BoundsExpr *Bounds,
-                                         BoundsCheckKind Kind, ProofFailure &Cause) {
+                                         BoundsCheckKind Kind, ProofFailure &Cause,
+                                         EquivExprSets *EquivExprs) {
+      ProofResult R = ProveConstantMemoryAccessInRange(PtrBase, Offset, Bounds,
+                                                       Kind, Cause, EquivExprs);
+      if (R == ProofResult::Maybe && S.getLangOpts().CheckedCSymbolicBounds)
+        R = ProveSymbolicMemoryAccessInRange(PtrBase, Offset, Bounds, Kind,
+                                             Cause, EquivExprs);
+      return R;
+    }
+
+    // Try to prove that PtrBase + Offset is within Bounds using linear
+    // expressions over variables for the bounds and the offset.
+    ProofResult ProveSymbolicMemoryAccessInRange(Expr *PtrBase, Expr *Offset,
+                                                 BoundsExpr *Bounds,
+                                                 BoundsCheckKind Kind,
+                                                 ProofFailure &Cause,
+                                                 EquivExprSets *EquivExprs) {
+      SymbolicBoundsProver Prover(S.Context, EquivExprs);
+      SymbolicRange ValidRange, AccessRange;
+      if (!Prover.createRange(Bounds, ValidRange) ||
+          !Prover.createAccessRange(PtrBase, Offset, AccessRange))
+        return ProofResult::Maybe;
+      if (Kind == BoundsCheckKind::BCK_NullTermRead) {
+        llvm::APSInt ElementSize;
+        if (!getReferentSizeInChars(PtrBase->getType(), ElementSize) ||
+            !Prover.addToUpper(ValidRange, ElementSize.getExtValue()))
+          return ProofResult::Maybe;
+      }
+
+      bool LowerFails, UpperFails;
+      ProofResult R = ConvertSymbolicResult(
+        Prover.inRange(ValidRange, AccessRange, LowerFails, UpperFails));
+      if (R == ProofResult::True)
+        return R;
+      Cause = ProofFailure::None;
+      if (LowerFails)
+        Cause = CombineFailures(Cause, ProofFailure::LowerBound);
+      if (UpperFails)
+        Cause = CombineFailures(Cause, ProofFailure::UpperBound);
+      if (Prover.isEmpty(ValidRange) == SymbolicBoundsProver::Result::True)
+        Cause = CombineFailures(Cause, ProofFailure::Empty);
+      if (Prover.notWider(AccessRange, ValidRange) ==
+            SymbolicBoundsProver::Result::False) {
+        Cause = CombineFailures(Cause, ProofFailure::Width);
+        R = ProofResult::False;
+      }
+      return R;
+    }
+
+    // Try to prove that PtrBase + Offset is within Bounds when Bounds is a
+    // constant-sized range and Offset is a constant.
+    ProofResult ProveConstantMemoryAccessInRange(Expr *PtrBase, Expr *Offset,
+                                                 BoundsExpr *Bounds,
+                                                 BoundsCheckKind Kind,
+                                                 ProofFailure &Cause,
+                                                 EquivExprSets *EquivExprs) {
 #ifdef TRACE_RANGE
       llvm::outs() << "Examining:\nPtrBase\n";
       PtrBase->dump(llvm::outs());
@@ -1871,7 +2412,7 @@ namespace {
              "bounds not in standard form");
       Cause = ProofFailure::None;
       ConstantSizedRange ValidRange(S);
-      if (!CreateConstantRange(Bounds, &ValidRange, nullptr))
+      if (!CreateConstantRange(Bounds, &ValidRange, EquivExprs))
         return ProofResult::Maybe;
 
       bool Overflow;
@@ -1912,7 +2453,7 @@ namespace {
       llvm::outs() << "Valid range:\n";
       ValidRange.Dump(llvm::outs());
 #endif
-      ProofResult R = ValidRange.InRange(MemoryAccessRange, Cause, nullptr);
+      ProofResult R = ValidRange.InRange(MemoryAccessRange, Cause, EquivExprs);
       if (R == ProofResult::True)
         return R;
       if (R == ProofResult::False || R == ProofResult::Maybe) {
@@ -1953,25 +2494,97 @@ namespace {
         S.Diag(Loc, diag::note_upper_out_of_bounds) << (unsigned) Kind;
     }
 
+    // The value of a variable, as it is used in bounds expressions.
+    Expr *GetVarValue(const VarDecl *D) {
+      Expr *&Value = VarValues[D];
+      if (!Value) {
+        VarDecl *Var = const_cast<VarDecl *>(D);
+        DeclRefExpr *Ref =
+          DeclRefExpr::Create(S.getASTContext(), NestedNameSpecifierLoc(),
+                              SourceLocation(), Var, false, SourceLocation(),
+                              Var->getType(), ExprValueKind::VK_LValue);
+        Value = BoundsInference::Transient(S).CreateImplicitCast(
+          Var->getType().getUnqualifiedType(), CK_LValueToRValue, Ref);
+      }
+      return Value;
+    }
+
+    Expr *GetIntegerConstant(QualType Ty, int64_t Value) {
+      Ty = Ty.getCanonicalType().getUnqualifiedType();
+      Expr *&Lit = IntegerConstants[std::make_pair(Ty.getTypePtr(), Value)];
+      if (!Lit) {
+        llvm::APInt Val(S.Context.getIntWidth(Ty), Value, /*isSigned=*/true);
+        Lit = IntegerLiteral::Create(S.Context, Val, Ty, SourceLocation());
+      }
+      return Lit;
+    }
+
+    // Add to EquivExprs the equalities in Classes, leaving out Changed, a
+    // variable whose value changes at the program point.
+    void AddFlowFacts(ArrayRef<VarEquiv::EquivClass> Classes,
+                      const VarDecl *Changed, EquivExprSets &EquivExprs) {
+      for (const VarEquiv::EquivClass &Class : Classes) {
+        Expr *First = nullptr;
+        for (const VarDecl *V : Class.Vars) {
+          if (V == Changed)
+            continue;
+          Expr *Value = GetVarValue(V);
+          if (First)
+            EquivExprs.addEquality(First, Value);
+          else
+            First = Value;
+          const BuiltinType *BT = V->getType()->getAs<BuiltinType>();
+          if (Class.HasConstant && BT && BT->isInteger() &&
+              !BT->isBooleanType())
+            EquivExprs.addEquality(Value,
+                                   GetIntegerConstant(V->getType(),
+                                                      Class.Constant));
+        }
+      }
+    }
+
+    // Add to EquivExprs the dataflow facts that hold just before S is
+    // evaluated.
+    void AddFlowFactsBefore(Stmt *St, const VarDecl *Changed,
+                            EquivExprSets &EquivExprs) {
+      SmallVector<VarEquiv::EquivClass, 4> Classes;
+      if (Facts && Facts->getEquivClassesBefore(St, Classes))
+        AddFlowFacts(Classes, Changed, EquivExprs);
+    }
+
+    // Add to EquivExprs the dataflow facts that hold just before the
+    // declaration of D takes effect.
+    void AddFlowFactsBefore(VarDecl *D, EquivExprSets &EquivExprs) {
+      SmallVector<VarEquiv::EquivClass, 4> Classes;
+      if (Facts && Facts->getEquivClassesBefore(D, Classes))
+        AddFlowFacts(Classes, D, EquivExprs);
+    }
+
     // Given an assignment target = e, where target has declared bounds
     // DeclaredBounds and and e has inferred bounds SrcBounds, make sure
     // that SrcBounds implies that DeclaredBounds are provably true.
-    void CheckBoundsDeclAtAssignment(SourceLocation ExprLoc, Expr *Target,
+    void CheckBoundsDeclAtAssignment(BinaryOperator *E, Expr *Target,
                                      BoundsExpr *DeclaredBounds, Expr *Src,
                                      BoundsExpr *SrcBounds,
                                      bool InCheckedScope) {
+      SourceLocation ExprLoc = E->getExprLoc();
       // Record expression equality implied by assignment.
-      SmallVector<SmallVector <Expr *, 4> *, 4> EquivExprs;
-      SmallVector<Expr *, 4> EqualExpr;
+      EquivExprSets EquivExprs(S.Context);
       // TODO: make sure assignment to lvalue doesn't modify value used in Src.
       if (S.CheckIsNonModifying(Target, Sema::NonModifyingContext::NMC_Unknown,
                                 Sema::NonModifyingMessage::NMM_None) &&
           S.CheckIsNonModifying(Src, Sema::NonModifyingContext::NMC_Unknown,
                                 Sema::NonModifyingMessage::NMM_None)) {
-        Expr *TargetExpr = BoundsInference(S).CreateImplicitCast(Target->getType(), CK_LValueToRValue, Target);
-        EqualExpr.push_back(TargetExpr);
-        EqualExpr.push_back(Src);
-        EquivExprs.push_back(&EqualExpr);
+        // The facts about the target variable itself no longer hold.
+        const VarDecl *Changed = nullptr;
+        if (DeclRefExpr *DR = dyn_cast<DeclRefExpr>(Target->IgnoreParens()))
+          Changed = dyn_cast<VarDecl>(DR->getDecl());
+        AddFlowFactsBefore(E, Changed, EquivExprs);
+        Expr *TargetExpr =
+          BoundsInference::Transient(S).CreateImplicitCast(Target->getType(),
+                                                           CK_LValueToRValue,
+                                                           Target);
+        EquivExprs.addEquality(TargetExpr, Src);
       }
 
       ProofFailure Cause;
@@ -2030,10 +2643,10 @@ namespace {
                                       BoundsExpr *SrcBounds,
                                       bool InCheckedScope) {
       // Record expression equality implied by initialization.
-      SmallVector<SmallVector <Expr *, 4> *, 4> EquivExprs;
-      SmallVector<Expr *, 4> EqualExpr;
+      EquivExprSets EquivExprs(S.Context);
       if (S.CheckIsNonModifying(Src, Sema::NonModifyingContext::NMC_Unknown,
                                 Sema::NonModifyingMessage::NMM_None)) {
+        AddFlowFactsBefore(D, EquivExprs);
         // TODO: make sure variable being initialized isn't read by Src.
         DeclRefExpr *TargetDeclRef =
           DeclRefExpr::Create(S.getASTContext(), NestedNameSpecifierLoc(),
@@ -2048,10 +2661,10 @@ namespace {
           Kind = CK_LValueToRValue;
           TargetTy = D->getType();
         }
-        Expr *TargetExpr = BoundsInference(S).CreateImplicitCast(TargetTy, Kind, TargetDeclRef);
-        EqualExpr.push_back(TargetExpr);
-        EqualExpr.push_back(Src);
-        EquivExprs.push_back(&EqualExpr);
+        Expr *TargetExpr =
+          BoundsInference::Transient(S).CreateImplicitCast(TargetTy, Kind,
+                                                           TargetDeclRef);
+        EquivExprs.addEquality(TargetExpr, Src);
         /*
         llvm::outs() << "Dumping target/src equality relation";
         TargetExpr->dump(llvm::outs());
@@ -2112,24 +2725,41 @@ namespace {
       }
     }
 
-    void CheckBoundsAtMemoryAccess(Expr *Deref, BoundsExpr *ValidRange,
-                                   BoundsCheckKind CheckKind,
-                                   bool InCheckedScope) {
+    // Accesses that are proved to be in bounds are not checked at runtime
+    // in checked scopes, and anywhere when dataflow facts are used.  Other
+    // proved accesses in unchecked scopes keep their runtime checks.
+    bool IsProvenAccess(ProofResult Result, bool InCheckedScope) {
+      return Result == ProofResult::True && (Facts || InCheckedScope);
+    }
+
+    ProofResult CheckBoundsAtMemoryAccess(Expr *Deref, BoundsExpr *ValidRange,
+                                          BoundsCheckKind CheckKind,
+                                          bool InCheckedScope) {
+      // The dataflow facts before the access hold throughout it if it
+      // does not modify variables.
+      EquivExprSets EquivExprs(S.Context);
+      if (Facts &&
+          S.CheckIsNonModifying(Deref, Sema::NonModifyingContext::NMC_Unknown,
+                                Sema::NonModifyingMessage::NMM_None))
+        AddFlowFactsBefore(Deref, nullptr, EquivExprs);
+
       ProofFailure Cause;
       ProofResult Result;
       ProofStmtKind ProofKind;
       if (UnaryOperator *UO = dyn_cast<UnaryOperator>(Deref)) {
         ProofKind = ProofStmtKind::MemoryAccess;
         Result = ProveMemoryAccessInRange(UO->getSubExpr(), nullptr, ValidRange,
-                                          CheckKind, Cause);
+                                          CheckKind, Cause, &EquivExprs);
       } else if (ArraySubscriptExpr *AS = dyn_cast<ArraySubscriptExpr>(Deref)) {
         ProofKind = ProofStmtKind::MemoryAccess;
         Result = ProveMemoryAccessInRange(AS->getBase(), AS->getIdx(),
-                                          ValidRange, CheckKind, Cause);
+                                          ValidRange, CheckKind, Cause,
+                                          &EquivExprs);
       } else if (MemberExpr *ME = dyn_cast<MemberExpr>(Deref)) {
         assert(ME->isArrow());
         ProofKind = ProofStmtKind::MemberArrowBase;
-        Result = ProveMemoryAccessInRange(ME->getBase(), nullptr, ValidRange, CheckKind, Cause);
+        Result = ProveMemoryAccessInRange(ME->getBase(), nullptr, ValidRange,
+                                          CheckKind, Cause, &EquivExprs);
       } else {
         llvm_unreachable("unexpected expression kind");
       }
@@ -2140,15 +2770,40 @@ namespace {
         S.Diag(ExprLoc, DiagId) << (unsigned) ProofKind << Deref->getSourceRange();
         ExplainProofFailure(ExprLoc, Cause, ProofKind);
         S.Diag(ExprLoc, diag::note_expanded_inferred_bounds) << ValidRange;
-      }
+      } else if (!IsProvenAccess(Result, InCheckedScope))
+        ExplainKeptCheck(Deref, ValidRange, Result, Cause, ProofKind);
+      return Result;
+    }
+
+    // Explain, with -Rcheckedc-checks, why the memory access Deref is
+    // checked at runtime.
+    void ExplainKeptCheck(Expr *Deref, BoundsExpr *ValidRange,
+                          ProofResult Result, ProofFailure Cause,
+                          ProofStmtKind ProofKind) {
+      SourceLocation ExprLoc = Deref->getExprLoc();
+      if (S.Diags.isIgnored(diag::remark_bounds_check_not_removed, ExprLoc))
+        return;
+      enum { NotComparable, MaybeEmpty, UncheckedScope } Reason;
+      if (Result == ProofResult::True)
+        Reason = UncheckedScope;
+      else if (TestFailure(Cause, ProofFailure::Empty))
+        Reason = MaybeEmpty;
+      else
+        Reason = NotComparable;
+      S.Diag(ExprLoc, diag::remark_bounds_check_not_removed)
+        << (unsigned) ProofKind << (unsigned) Reason
+        << Deref->getSourceRange();
+      S.Diag(ExprLoc, diag::note_expanded_inferred_bounds) << ValidRange;
     }
 
 
   public:
-    CheckBoundsDeclarations(Sema &S, BoundsExpr *ReturnBounds) : S(S),
+    CheckBoundsDeclarations(Sema &S, BoundsExpr *ReturnBounds,
+                            VarEquiv *Facts = nullptr,
+                            BoundsWidening *Widening = nullptr) : S(S),
       DumpBounds(S.getLangOpts().DumpInferredBounds),
       PointerWidth(S.Context.getTargetInfo().getPointerWidth(0)),
-      ReturnBounds(ReturnBounds) {}
+      ReturnBounds(ReturnBounds), Facts(Facts), Widening(Widening) {}
 
     void TraverseStmt(Stmt *S, bool InCheckedScope) {
       if (!S)
@@ -2253,7 +2908,7 @@ namespace {
              RHSBounds = S.CreateInvalidBoundsExpr();
           }
 
-          CheckBoundsDeclAtAssignment(E->getExprLoc(), LHS, LHSTargetBounds,
+          CheckBoundsDeclAtAssignment(E, LHS, LHSTargetBounds,
                                       RHS, RHSBounds, InCheckedScope);
         }
       }
@@ -2286,16 +2941,25 @@ namespace {
       }
       const FunctionType *FuncTy = PointeeType->getAs<FunctionType>();
       assert(FuncTy);
+      // Direct calls are recorded in the bounds summary, if there is one,
+      // including calls that prove nothing about their arguments.
+      FunctionDecl *Callee = CE->getDirectCallee();
+      sema::BoundsSummary *Summary =
+        Callee ? S.CallBoundsSummary.get() : nullptr;
       const FunctionProtoType *FuncProtoTy = FuncTy->getAs<FunctionProtoType>();
-      if (!FuncProtoTy)
-        return;
-      if (!FuncProtoTy->hasParamAnnots())
+      if (!FuncProtoTy || !FuncProtoTy->hasParamAnnots()) {
+        if (Summary)
+          Summary->addCallSite(Callee, None);
         return;
+      }
       unsigned NumParams = FuncProtoTy->getNumParams();
       unsigned NumArgs = CE->getNumArgs();
       unsigned Count = (NumParams < NumArgs) ? NumParams : NumArgs;
+      SmallVector<int64_t, 4> ArgElements(Summary ? Count : 0, -1);
       ArrayRef<Expr *> ArgExprs = llvm::makeArrayRef(const_cast<Expr**>(CE->getArgs()),
                                                      CE->getNumArgs());
+      ArrayRef<Sema::FunctionParamBounds> ParamBoundsInfo =
+        S.GetFunctionTypeParamBounds(FuncProtoTy);
       for (unsigned i = 0; i < Count; i++) {
         QualType ParamType = FuncProtoTy->getParamType(i);
         // Skip checking bounds for unchecked pointer parameters, unless
@@ -2307,17 +2971,13 @@ namespace {
 
         // We want to check the argument expression implies the desired parameter bounds.
         // To compute the desired parameter bounds, we substitute the arguments for
-        // parameters in the parameter bounds expression.
-        const BoundsAnnotations ParamAnnots = FuncProtoTy->getParamAnnots(i);
-        const BoundsExpr *ParamBounds = ParamAnnots.getBoundsExpr();
-        const InteropTypeExpr *ParamIType = ParamAnnots.getInteropTypeExpr();
-        if (!ParamBounds && !ParamIType)
+        // parameters in the parameter bounds expression.  The parameter bounds,
+        // including those implied by an interop type annotation, are computed
+        // once per function type.
+        const BoundsExpr *ParamBounds = ParamBoundsInfo[i].Bounds;
+        if (!ParamBounds)
           continue;
 
-        if (!ParamBounds && ParamIType)
-          ParamBounds = S.CreateTypeBasedBounds(nullptr, ParamIType->getType(),
-                                                true, true);
-
         // Check after handling the interop type annotation, not before, because
         // handling the interop type annotation could make the bounds known.
         if (ParamBounds->isUnknown())
@@ -2333,15 +2993,19 @@ namespace {
           continue;
         } else if (ArgBounds->isInvalid())
           continue;
+        if (Summary)
+          ArgElements[i] = GetArgElementCount(Arg, ArgBounds, ParamType);
 
         // Concretize parameter bounds with argument expressions. This fails
         // and returns null if an argument expression is a modifying
         // expression,  We issue an error during concretization about that.
-        BoundsExpr *SubstParamBounds =
-          S.ConcretizeFromFunctionTypeWithArgs(
-            const_cast<BoundsExpr *>(ParamBounds),
-            ArgExprs,
-            Sema::NonModifyingContext::NMC_Function_Parameter);
+        BoundsExpr *SubstParamBounds = const_cast<BoundsExpr *>(ParamBounds);
+        if (ParamBoundsInfo[i].UsesParams)
+          SubstParamBounds =
+            S.ConcretizeFromFunctionTypeWithArgs(
+              SubstParamBounds,
+              ArgExprs,
+              Sema::NonModifyingContext::NMC_Function_Parameter);
 
         if (!SubstParamBounds)
           continue;
@@ -2355,14 +3019,16 @@ namespace {
           if (true /* S.CheckIsNonModifying(Arg,
                               Sema::NonModifyingContext::NMC_Function_Parameter,
                                     Sema::NonModifyingMessage::NMM_Error) */)
-            SubstParamBounds = S.ExpandToRange(Arg,
-                                    const_cast<BoundsExpr *>(SubstParamBounds));
+            SubstParamBounds = BoundsInference::Transient(S).ExpandToRange(
+              Arg, const_cast<BoundsExpr *>(SubstParamBounds));
            else
              continue;
         }
 
         CheckBoundsDeclAtCallArg(i, SubstParamBounds, Arg, ArgBounds, InCheckedScope);
       }
+      if (Summary)
+        Summary->addCallSite(Callee, ArgElements);
       return;
    }
 
@@ -2504,7 +3170,8 @@ namespace {
              << Init->getSourceRange();
          InitBounds = S.CreateInvalidBoundsExpr();
        } else {
-         BoundsExpr *NormalizedDeclaredBounds = S.ExpandToRange(D, DeclaredBounds);
+         BoundsExpr *NormalizedDeclaredBounds =
+           BoundsInference::Transient(S).ExpandToRange(D, DeclaredBounds);
          CheckBoundsDeclAtInitializer(D->getLocation(), D, NormalizedDeclaredBounds,
            Init, InitBounds, InCheckedScope);
        }
@@ -2755,10 +3422,264 @@ namespace {
   };
 }
 
+namespace {
+  // Compute the fingerprint of a function body for the BoundsCheckCache.
+  // It is a hash of the text of the function, of the declarations that the
+  // function refers to, and of the declarations of the types that it uses,
+  // transitively.  The text is taken from the source buffers, so the
+  // fingerprint can't be computed if any of it comes from macro expansions,
+  // whose definitions may change without changing the text.  The types of
+  // declarations are hashed as well, because they can depend on macros too,
+  // such as the sizes of arrays.
+  class BoundsCheckFingerprint :
+    public RecursiveASTVisitor<BoundsCheckFingerprint> {
+  private:
+    Sema &S;
+    SourceManager &SM;
+    bool Valid;
+    bool InAnnotations;
+    llvm::hash_code Hash;
+    llvm::SmallPtrSet<const Decl *, 16> SeenDecls;
+    llvm::SmallPtrSet<const Type *, 16> SeenTypes;
+    SmallVector<const Decl *, 16> Worklist;
+
+  public:
+    BoundsCheckFingerprint(Sema &S) :
+      S(S), SM(S.getSourceManager()), Valid(true), InAnnotations(false),
+      Hash(0) {}
+
+    // Compute the fingerprint of FD, whose body is Body.  Returns false if
+    // it can't be computed.
+    bool Compute(FunctionDecl *FD, Stmt *Body, size_t &Fingerprint) {
+      // Some checks are skipped after errors that prevent compilation.
+      Hash = llvm::hash_combine(Hash,
+        S.getDiagnostics().hasUncompilableErrorOccurred());
+      AddDecl(FD);
+      AddText(Body->getLocStart(), Body->getLocEnd());
+      if (Valid)
+        TraverseStmt(Body);
+      while (Valid && !Worklist.empty())
+        HashDecl(Worklist.pop_back_val());
+      Fingerprint = Hash;
+      return Valid;
+    }
+
+    bool VisitStmt(Stmt *St) {
+      if (!InAnnotations &&
+          (St->getLocStart().isMacroID() || St->getLocEnd().isMacroID()))
+        Valid = false;
+      return Valid;
+    }
+
+    bool VisitExpr(Expr *E) {
+      AddTypeDecls(E->getType());
+      return true;
+    }
+
+    bool VisitCompoundStmt(CompoundStmt *CS) {
+      // Checked scopes can be set by pragmas outside of the function.
+      Hash = llvm::hash_combine(Hash, CS->isChecked());
+      return true;
+    }
+
+    bool VisitDeclRefExpr(DeclRefExpr *E) {
+      AddDecl(E->getDecl());
+      return true;
+    }
+
+    bool VisitMemberExpr(MemberExpr *E) {
+      AddDecl(E->getMemberDecl());
+      return true;
+    }
+
+    // Bounds annotations aren't traversed as part of declarations.
+    bool VisitDeclaratorDecl(DeclaratorDecl *D) {
+      TraverseAnnotations(D);
+      return Valid;
+    }
+
+  private:
+    // The annotations aren't always part of the source range of a
+    // declaration, so they are hashed as printed.
+    void TraverseAnnotations(DeclaratorDecl *D) {
+      if (BoundsExpr *Bounds = D->getBoundsExpr()) {
+        std::string Str;
+        llvm::raw_string_ostream OS(Str);
+        Bounds->printPretty(OS, nullptr, S.getPrintingPolicy());
+        Hash = llvm::hash_combine(Hash, OS.str());
+        llvm::SaveAndRestore<bool> Printed(InAnnotations, true);
+        TraverseStmt(Bounds);
+      }
+      if (InteropTypeExpr *IType = D->getInteropTypeExpr()) {
+        Hash = llvm::hash_combine(Hash, IType->getType().getAsString());
+        AddTypeDecls(IType->getType());
+      }
+    }
+
+    void AddDecl(const Decl *D) {
+      if (D && SeenDecls.insert(D).second)
+        Worklist.push_back(D);
+    }
+
+    // Hash the text from the start of Begin to the end of the token at End.
+    void AddText(SourceLocation Begin, SourceLocation End) {
+      if (Begin.isInvalid() || End.isInvalid() || Begin.isMacroID() ||
+          End.isMacroID()) {
+        Valid = false;
+        return;
+      }
+      std::pair<FileID, unsigned> B = SM.getDecomposedLoc(Begin);
+      std::pair<FileID, unsigned> E = SM.getDecomposedLoc(End);
+      if (B.first != E.first || B.second > E.second) {
+        Valid = false;
+        return;
+      }
+      unsigned EndOffset =
+        E.second + Lexer::MeasureTokenLength(End, SM, S.getLangOpts());
+      bool Invalid = false;
+      StringRef Buffer = SM.getBufferData(B.first, &Invalid);
+      if (Invalid || EndOffset > Buffer.size()) {
+        Valid = false;
+        return;
+      }
+      Hash = llvm::hash_combine(Hash, Buffer.slice(B.second, EndOffset));
+    }
+
+    // Add the declarations of the typedefs and tags that T is built from.
+    void AddTypeDecls(QualType T) {
+      if (T.isNull() || !SeenTypes.insert(T.getTypePtr()).second)
+        return;
+      const Type *Ty = T.getTypePtr();
+      if (const TypedefType *TT = dyn_cast<TypedefType>(Ty)) {
+        AddDecl(TT->getDecl());
+        AddTypeDecls(TT->desugar());
+        return;
+      }
+      QualType Desugared = T.getSingleStepDesugaredType(S.Context);
+      if (Desugared != T) {
+        AddTypeDecls(Desugared);
+        return;
+      }
+      if (const TagType *TT = dyn_cast<TagType>(Ty)) {
+        TagDecl *D = TT->getDecl();
+        AddDecl(D->getDefinition() ? D->getDefinition() : D);
+      } else if (const PointerType *PT = dyn_cast<PointerType>(Ty))
+        AddTypeDecls(PT->getPointeeType());
+      else if (const ArrayType *AT = dyn_cast<ArrayType>(Ty))
+        AddTypeDecls(AT->getElementType());
+      else if (const FunctionType *FT = dyn_cast<FunctionType>(Ty)) {
+        AddTypeDecls(FT->getReturnType());
+        if (const FunctionProtoType *FPT = dyn_cast<FunctionProtoType>(FT))
+          for (QualType ParamTy : FPT->getParamTypes())
+            AddTypeDecls(ParamTy);
+      }
+    }
+
+    void HashDecl(const Decl *D) {
+      const ValueDecl *VD = dyn_cast<ValueDecl>(D);
+      if (VD) {
+        Hash = llvm::hash_combine(Hash, VD->getType().getAsString());
+        AddTypeDecls(VD->getType());
+      }
+
+      // Implicit declarations, such as those of builtin functions, have no
+      // text.
+      if (D->isImplicit() || D->getLocation().isInvalid()) {
+        if (const NamedDecl *ND = dyn_cast<NamedDecl>(D))
+          Hash = llvm::hash_combine(Hash, ND->getNameAsString());
+        return;
+      }
+
+      if (const FunctionDecl *FD = dyn_cast<FunctionDecl>(D)) {
+        // The bounds of the parameters and the return value can come from
+        // any of the declarations of the function.  The bodies don't matter.
+        for (const FunctionDecl *Redecl : FD->redecls()) {
+          if (Redecl->doesThisDeclarationHaveABody())
+            AddText(Redecl->getLocStart(), Redecl->getBody()->getLocStart());
+          else
+            AddText(Redecl->getLocStart(), Redecl->getLocEnd());
+          FunctionDecl *F = const_cast<FunctionDecl *>(Redecl);
+          TraverseAnnotations(F);
+          for (ParmVarDecl *Param : F->parameters())
+            TraverseAnnotations(Param);
+        }
+        return;
+      }
+
+      AddText(D->getLocStart(), D->getLocEnd());
+      if (const DeclaratorDecl *DD = dyn_cast<DeclaratorDecl>(D))
+        TraverseAnnotations(const_cast<DeclaratorDecl *>(DD));
+      if (const EnumConstantDecl *ECD = dyn_cast<EnumConstantDecl>(D))
+        Hash = llvm::hash_combine(Hash, ECD->getInitVal().toString(10));
+      if (const RecordDecl *RD = dyn_cast<RecordDecl>(D))
+        for (const FieldDecl *Field : RD->fields())
+          AddDecl(Field);
+    }
+  };
+}
+
 void Sema::CheckFunctionBodyBoundsDecls(FunctionDecl *FD, Stmt *Body) {
+  TimeTraceScope TimeScope("CheckBounds",
+                           [&]() { return FD->getQualifiedNameAsString(); });
+
+  // When a translation unit is reparsed, functions that didn't change and
+  // were checked without diagnostics the last time aren't checked again.
+  // The AST of a reparse isn't used for code generation, so the bounds
+  // that the checks attach to expressions aren't needed.
+  size_t Fingerprint = 0;
+  bool UseCache = BoundsCache &&
+    BoundsCheckFingerprint(*this).Compute(FD, Body, Fingerprint);
+  if (UseCache && BoundsCache->isClean(Fingerprint))
+    return;
+  DiagnosticErrorTrap Trap(getDiagnostics());
+  unsigned NumWarnings = getDiagnostics().getNumWarnings();
+
+  if (BoundsTimer)
+    BoundsTimer->startFunction(FD);
+  // The bounds inferred for expressions in the body are cached while it is
+  // checked, and discarded afterwards.
+  llvm::SaveAndRestore<bool> CacheInferredBounds(InferredBoundsCacheEnabled,
+                                                 true);
+  // Expressions that are only built to be compared or reported are
+  // allocated in storage that is released afterwards.
+  llvm::SaveAndRestore<llvm::BumpPtrAllocator *>
+    UseTransientBounds(TransientBoundsAlloc, &TransientBoundsStorage);
+  // With -fcheckedc-flow-sensitive-bounds, equalities between variables at
+  // each program point are computed on the CFG up front and used by the
+  // proofs.
+  // The bounds of null-terminated pointers are widened on the branches of
+  // tests of the elements at their upper bounds.
+  std::unique_ptr<CFG> Cfg;
+  std::unique_ptr<VarEquiv> Facts;
+  std::unique_ptr<BoundsWidening> Widening;
+  if (getLangOpts().CheckedCFlowSensitiveBounds &&
+      !getDiagnostics().hasUncompilableErrorOccurred()) {
+    CFG::BuildOptions BO;
+    BO.setAllAlwaysAdd();
+    Cfg = CFG::buildCFG(FD, Body, &getASTContext(), BO);
+    if (Cfg) {
+      Facts = llvm::make_unique<VarEquiv>(getASTContext(), *Cfg);
+      Widening = llvm::make_unique<BoundsWidening>(getASTContext(), *Cfg);
+    }
+  }
   // The IsChecked argument to TraverseStmt doesn't matter - the body will be a
   // compound statement and we'll pick up the checked-ness from that.
-  CheckBoundsDeclarations(*this, FD->getBoundsExpr()).TraverseStmt(Body, false);
+  CheckBoundsDeclarations(*this, FD->getBoundsExpr(), Facts.get(),
+                          Widening.get())
+    .TraverseStmt(Body, false);
+  InferredBoundsCache.clear();
+  if (TransientBoundsStorage.getBytesAllocated() != 0) {
+    // The hashes and the non-modifying results of the transient expressions
+    // are keyed by their addresses, which the storage will reuse.
+    Context.LexicographicHashes.clear();
+    NonModifyingBoundsCache.clear();
+    TransientBoundsStorage.Reset();
+  }
+  if (BoundsTimer)
+    BoundsTimer->finishFunction();
+  if (UseCache && !Trap.hasErrorOccurred() &&
+      getDiagnostics().getNumWarnings() == NumWarnings)
+    BoundsCache->markClean(Fingerprint);
 }
 
 void Sema::CheckTopLevelBoundsDecls(VarDecl *D) {
@@ -2881,10 +3802,25 @@ namespace {
 
 bool Sema::CheckIsNonModifying(Expr *E, NonModifyingContext Req,
                                NonModifyingMessage Message) {
+  sema::BoundsTimeReport::Region Timing(BoundsTimer.get(),
+    sema::BoundsTimeReport::BTC_NonModifying);
+  // A bounds expression is only walked again to report why it is
+  // modifying.
+  BoundsExpr *Bounds = dyn_cast_or_null<BoundsExpr>(E);
+  if (Bounds) {
+    auto It = NonModifyingBoundsCache.find(Bounds);
+    if (It != NonModifyingBoundsCache.end() &&
+        (It->second || Message == NonModifyingMessage::NMM_None))
+      return It->second;
+  }
+
   NonModifiyingExprSema Checker(*this, Req, Message);
   Checker.TraverseStmt(E);
 
-  return Checker.isNonModifyingExpr();
+  bool Result = Checker.isNonModifyingExpr();
+  if (Bounds)
+    NonModifyingBoundsCache[Bounds] = Result;
+  return Result;
 }
 
 /* Will uncomment this in a future pull request.
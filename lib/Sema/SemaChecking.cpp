@@ -6661,6 +6661,31 @@ bool CheckScanfHandler::HandleScanfSpecifier(
   return true;
 }
 
+/// Returns the recorded parsing of the format string \p Str, as a scanf string
+/// if \p Kind is 's', or else as a printf one, for FreeBSD's kprintf if it is
+/// 'k'. The callbacks point into a copy of \p Str, which \p Beg is set to.
+static const analyze_format_string::ParsedFormatString &
+getParsedFormatString(Sema &S, char Kind, StringRef Str, const char *&Beg) {
+  SmallString<128> Key;
+  Key += Kind;
+  Key += Str;
+  auto Entry = S.ParsedFormatStrings.try_emplace(Key).first;
+  Beg = Entry->getKeyData() + 1;
+  std::unique_ptr<analyze_format_string::ParsedFormatString> &Parsed =
+      Entry->second;
+  if (!Parsed) {
+    const char *End = Beg + Str.size();
+    Parsed.reset(new analyze_format_string::ParsedFormatString(
+        Kind == 's'
+            ? analyze_format_string::ParsedFormatString::parseScanf(
+                  Beg, End, S.getLangOpts(), S.Context.getTargetInfo())
+            : analyze_format_string::ParsedFormatString::parsePrintf(
+                  Beg, End, S.getLangOpts(), S.Context.getTargetInfo(),
+                  Kind == 'k')));
+  }
+  return *Parsed;
+}
+
 static void CheckFormatString(Sema &S, const FormatStringLiteral *FExpr,
                               const Expr *OrigFormatExpr,
                               ArrayRef<const Expr *> Args,
@@ -6712,28 +6737,34 @@ static void CheckFormatString(Sema &S, const FormatStringLiteral *FExpr,
     return;
   }
 
+  // The parsing of a string only depends on its contents, so the same format
+  // string, as used by a logging macro, is only parsed once, and the parsing
+  // is replayed to the handler of each call. The handler is given the copy
+  // of the string that the parsing points into.
   if (Type == Sema::FST_Printf || Type == Sema::FST_NSString ||
       Type == Sema::FST_FreeBSDKPrintf || Type == Sema::FST_OSLog ||
       Type == Sema::FST_OSTrace) {
+    const char *Beg;
+    const analyze_format_string::ParsedFormatString &Parsed =
+        getParsedFormatString(S, Type == Sema::FST_FreeBSDKPrintf ? 'k' : 'p',
+                              StringRef(Str, StrLen), Beg);
     CheckPrintfHandler H(
         S, FExpr, OrigFormatExpr, Type, firstDataArg, numDataArgs,
-        (Type == Sema::FST_NSString || Type == Sema::FST_OSTrace), Str,
+        (Type == Sema::FST_NSString || Type == Sema::FST_OSTrace), Beg,
         HasVAListArg, Args, format_idx, inFunctionCall, CallType,
         CheckedVarArgs, UncoveredArg);
 
-    if (!analyze_format_string::ParsePrintfString(H, Str, Str + StrLen,
-                                                  S.getLangOpts(),
-                                                  S.Context.getTargetInfo(),
-                                            Type == Sema::FST_FreeBSDKPrintf))
+    if (!Parsed.replay(H))
       H.DoneProcessing();
   } else if (Type == Sema::FST_Scanf) {
+    const char *Beg;
+    const analyze_format_string::ParsedFormatString &Parsed =
+        getParsedFormatString(S, 's', StringRef(Str, StrLen), Beg);
     CheckScanfHandler H(S, FExpr, OrigFormatExpr, Type, firstDataArg,
-                        numDataArgs, Str, HasVAListArg, Args, format_idx,
+                        numDataArgs, Beg, HasVAListArg, Args, format_idx,
                         inFunctionCall, CallType, CheckedVarArgs, UncoveredArg);
 
-    if (!analyze_format_string::ParseScanfString(H, Str, Str + StrLen,
-                                                 S.getLangOpts(),
-                                                 S.Context.getTargetInfo()))
+    if (!Parsed.replay(H))
       H.DoneProcessing();
   } // TODO: handle other formats
 }
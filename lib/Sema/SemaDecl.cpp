@@ -5907,6 +5907,11 @@ NamedDecl *Sema::HandleDeclarator(Scope *S, Declarator &D,
   if (!New)
     return nullptr;
 
+  // A block-scope extern declaration is a redeclaration of an entity outside
+  // of the function, so the function body can't be discarded.
+  if (Context.FunctionBodyAlloc && New->isLocalExternDecl())
+    Context.FunctionBodyEscaped = true;
+
   // If this has an identifier and is not a function template specialization,
   // add it to the scope stack.
   if (New->getDeclName() && AddToScope) {
@@ -13279,6 +13284,13 @@ Decl *Sema::ActOnStartOfFunctionDef(Scope *FnBodyScope, Decl *D,
     }
   }
 
+  // The statements of a body that is discarded once it is checked are
+  // allocated in storage that is recycled for the next body.
+  if (canDiscardFunctionBody(FD)) {
+    Context.FunctionBodyAlloc = &Context.FunctionBodyStorage;
+    Context.FunctionBodyEscaped = false;
+  }
+
   // Ensure that the function's exception specification is instantiated.
   if (const FunctionProtoType *FPT = FD->getType()->getAs<FunctionProtoType>())
     ResolveExceptionSpec(D->getLocation(), FPT);
@@ -13361,6 +13373,38 @@ bool Sema::canSkipFunctionBody(Decl *D) {
   return Consumer.shouldSkipFunctionBody(D);
 }
 
+bool Sema::canDiscardFunctionBody(const FunctionDecl *FD) const {
+  const LangOptions &LangOpts = getLangOpts();
+  return LangOpts.DiscardFunctionBodies && !LangOpts.CPlusPlus &&
+         !LangOpts.ObjC1 && !LangOpts.OpenMP && !FD->isInlined() &&
+         !Context.FunctionBodyAlloc;
+}
+
+void Sema::DiscardFunctionBody(FunctionDecl *FD, Stmt *Body) {
+  Context.FunctionBodyAlloc = nullptr;
+
+  // A node of the body that can be reached from outside of it, such as the
+  // bounds of a block-scope extern declaration, keeps the whole body.
+  if (Context.FunctionBodyEscaped) {
+    Context.KeptFunctionBodies.push_back(
+        std::move(Context.FunctionBodyStorage));
+    Context.FunctionBodyStorage = llvm::BumpPtrAllocator();
+    return;
+  }
+
+  // The empty body still makes FD a definition, with the same extent.
+  if (Body)
+    FD->setBody(CompoundStmt::Create(Context, None, Body->getLocStart(),
+                                     Body->getLocEnd(), false, false));
+  // The bounds, hashes, non-modifying results and member bounds shapes of
+  // expressions are keyed by their addresses, which the storage will reuse.
+  Context.forgetExprBounds(Context.FunctionBodyStorage);
+  Context.LexicographicHashes.clear();
+  NonModifyingBoundsCache.clear();
+  MemberBoundsShapes.clear();
+  Context.FunctionBodyStorage.Reset();
+}
+
 Decl *Sema::ActOnSkippedFunctionBody(Decl *Decl) {
   if (FunctionDecl *FD = dyn_cast_or_null<FunctionDecl>(Decl))
     FD->setHasSkippedBody();
@@ -13670,6 +13714,9 @@ Decl *Sema::ActOnFinishFunctionBody(Decl *dcl, Stmt *Body,
     DiscardCleanupsInEvaluationContext();
   }
 
+  if (FD && Context.FunctionBodyAlloc == &Context.FunctionBodyStorage)
+    DiscardFunctionBody(FD, Body);
+
   return dcl;
 }
 
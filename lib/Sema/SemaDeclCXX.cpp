@@ -12270,10 +12270,10 @@ void Sema::DefineImplicitLambdaToFunctionPointerConversion(
                                         VK_LValue, Conv->getLocation()).get();
    assert(FunctionRef && "Can't refer to __invoke function?");
    Stmt *Return = BuildReturnStmt(Conv->getLocation(), FunctionRef).get();
-   Conv->setBody(new (Context) CompoundStmt(Context, Return,
-                                            Conv->getLocation(),
-                                            Conv->getLocation(),
-                                            false, false));
+   Conv->setBody(CompoundStmt::Create(Context, Return,
+                                      Conv->getLocation(),
+                                      Conv->getLocation(),
+                                      false, false));
 
   Conv->markUsed(Context);
   Conv->setReferenced();
@@ -12334,10 +12334,10 @@ void Sema::DefineImplicitLambdaToBlockPointerConversion(
 
   // Set the body of the conversion function.
   Stmt *ReturnS = Return.get();
-  Conv->setBody(new (Context) CompoundStmt(Context, ReturnS,
-                                           Conv->getLocation(),
-                                           Conv->getLocation(),
-                                           false, false));
+  Conv->setBody(CompoundStmt::Create(Context, ReturnS,
+                                     Conv->getLocation(),
+                                     Conv->getLocation(),
+                                     false, false));
   Conv->markUsed(Context);
 
   // We're done; notify the mutation listener, if any.
@@ -14634,9 +14634,13 @@ void Sema::MarkFunctionReferenced(SourceLocation Loc, FunctionDecl *Func,
     ResolveExceptionSpec(Loc, FPT);
 
   // If we don't need to mark the function as used, and we don't need to
-  // try to provide a definition, there's nothing more to do.
+  // try to provide a definition, there's nothing more to do. Only check that
+  // a body is present: getBody() would de-serialize a body that was loaded
+  // lazily from an AST file.
+  const FunctionDecl *Definition = nullptr;
   if ((Func->isUsed(/*CheckUsedAttr=*/false) || !OdrUse) &&
-      (!NeedDefinition || Func->getBody()))
+      (!NeedDefinition ||
+       (Func->hasBody(Definition) && !Definition->isLateTemplateParsed())))
     return;
 
   // Note that this declaration has been used.
@@ -40,6 +40,7 @@
 #include "llvm/ADT/TinyPtrVector.h"
 #include "llvm/ADT/edit_distance.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include <algorithm>
 #include <iterator>
 #include <list>
@@ -3955,6 +3956,56 @@ void TypoCorrectionConsumer::FoundDecl(NamedDecl *ND, NamedDecl *Hiding,
   FoundName(Name->getName());
 }
 
+TypoCorrectionIndex::~TypoCorrectionIndex() {
+  if (Built)
+    Idents.setCreatedIdentifiersLog(nullptr);
+}
+
+uint64_t TypoCorrectionIndex::getCharMask(StringRef Name) {
+  uint64_t Mask = 0;
+  for (char C : Name)
+    Mask |= uint64_t(1) << (static_cast<unsigned char>(C) % 64);
+  return Mask;
+}
+
+void TypoCorrectionIndex::add(const IdentifierInfo *II) {
+  StringRef Name = II->getName();
+  if (Name.size() >= ByLength.size())
+    ByLength.resize(Name.size() + 1);
+  ByLength[Name.size()].push_back({II, getCharMask(Name)});
+}
+
+void TypoCorrectionIndex::findCandidates(
+    StringRef Typo, unsigned MaxLengthDifference, unsigned MaxEditDistance,
+    llvm::function_ref<void(StringRef)> Found) {
+  if (!Built) {
+    for (const auto &I : Idents)
+      if (I.getValue())
+        add(I.getValue());
+    Idents.setCreatedIdentifiersLog(&Created);
+    Built = true;
+  }
+  for (const IdentifierInfo *II : Created)
+    add(II);
+  Created.clear();
+
+  // Each character that occurs in one of the names but not in the other
+  // needs an edit of its own, and so does each hash of such characters.
+  uint64_t TypoChars = getCharMask(Typo);
+  size_t MinLength = Typo.size() - std::min(Typo.size(),
+                                            size_t(MaxLengthDifference));
+  size_t MaxLength = std::min(Typo.size() + MaxLengthDifference,
+                              ByLength.size() - 1);
+  for (size_t Length = MinLength; Length <= MaxLength; ++Length) {
+    for (const Entry &E : ByLength[Length]) {
+      if (llvm::countPopulation(E.Chars & ~TypoChars) > MaxEditDistance ||
+          llvm::countPopulation(TypoChars & ~E.Chars) > MaxEditDistance)
+        continue;
+      Found(E.II->getName());
+    }
+  }
+}
+
 void TypoCorrectionConsumer::FoundName(StringRef Name) {
   // Compute the edit distance between the typo and the name of this
   // entity, and add the identifier to the list of results.
@@ -4644,10 +4695,16 @@ std::unique_ptr<TypoCorrectionConsumer> Sema::makeTypoCorrectionConsumer(
 
   if (IsUnqualifiedLookup || SearchNamespaces) {
     // For unqualified lookup, look through all of the names that we have
-    // seen in this translation unit.
-    // FIXME: Re-add the ability to skip very unlikely potential corrections.
-    for (const auto &I : Context.Idents)
-      Consumer->FoundName(I.getKey());
+    // seen in this translation unit. The index skips the names that addName
+    // would reject for their length or for their edit distance.
+    if (!TypoIndex)
+      TypoIndex.reset(new TypoCorrectionIndex(Context.Idents));
+    StringRef TypoStr = Typo->getName();
+    TypoIndex->findCandidates(TypoStr, TypoStr.size() / 3,
+                              (TypoStr.size() + 2) / 3,
+                              [&](StringRef Name) {
+                                Consumer->FoundName(Name);
+                              });
 
     // Walk through identifiers in external identifier sources.
     // FIXME: Re-add the ability to skip very unlikely potential corrections.
@@ -843,6 +843,7 @@ void OverloadCandidateSet::clear(CandidateSetKind CSK) {
   NumInlineBytesUsed = 0;
   Candidates.clear();
   Functions.clear();
+  ConversionCache.clear();
   Kind = CSK;
 }
 
@@ -4991,6 +4992,29 @@ TryCopyInitialization(Sema &S, Expr *From, QualType ToType,
                                /*AllowObjCConversionOnExplicit=*/false);
 }
 
+/// \brief Try to copy-initialize a parameter of type \p ToType of a candidate
+/// of \p CandidateSet from the argument \p From, reusing the conversion
+/// sequence formed for an earlier candidate with the same parameter type.
+static ImplicitConversionSequence
+TryCopyInitialization(Sema &S, OverloadCandidateSet &CandidateSet, Expr *From,
+                      QualType ToType, bool SuppressUserConversions,
+                      bool InOverloadResolution,
+                      bool AllowObjCWritebackConversion,
+                      bool AllowExplicit = false) {
+  unsigned Flags = SuppressUserConversions | InOverloadResolution << 1 |
+                   AllowObjCWritebackConversion << 2 | AllowExplicit << 3;
+  if (const ImplicitConversionSequence *Cached =
+          CandidateSet.getCachedConversion(From, ToType, Flags))
+    return *Cached;
+
+  ImplicitConversionSequence ICS =
+      TryCopyInitialization(S, From, ToType, SuppressUserConversions,
+                            InOverloadResolution, AllowObjCWritebackConversion,
+                            AllowExplicit);
+  CandidateSet.cacheConversion(From, ToType, Flags, ICS);
+  return ICS;
+}
+
 static bool TryCopyInitialization(const CanQualType FromQTy,
                                   const CanQualType ToQTy,
                                   Sema &S,
@@ -6028,7 +6052,7 @@ Sema::AddOverloadCandidate(FunctionDecl *Function,
       // parameter of F.
       QualType ParamType = Proto->getParamType(ArgIdx);
       Candidate.Conversions[ArgIdx]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamType,
+        = TryCopyInitialization(*this, CandidateSet, Args[ArgIdx], ParamType,
                                 SuppressUserConversions,
                                 /*InOverloadResolution=*/true,
                                 /*AllowObjCWritebackConversion=*/
@@ -6540,7 +6564,7 @@ Sema::AddMethodCandidate(CXXMethodDecl *Method, DeclAccessPair FoundDecl,
       // parameter of F.
       QualType ParamType = Proto->getParamType(ArgIdx);
       Candidate.Conversions[ArgIdx + 1]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamType,
+        = TryCopyInitialization(*this, CandidateSet, Args[ArgIdx], ParamType,
                                 SuppressUserConversions,
                                 /*InOverloadResolution=*/true,
                                 /*AllowObjCWritebackConversion=*/
@@ -7223,7 +7247,8 @@ void Sema::AddBuiltinCandidate(QualType *ParamTys, ArrayRef<Expr *> Args,
         = TryContextuallyConvertToBool(*this, Args[ArgIdx]);
     } else {
       Candidate.Conversions[ArgIdx]
-        = TryCopyInitialization(*this, Args[ArgIdx], ParamTys[ArgIdx],
+        = TryCopyInitialization(*this, CandidateSet, Args[ArgIdx],
+                                ParamTys[ArgIdx],
                                 ArgIdx == 0 && IsAssignmentOperator,
                                 /*InOverloadResolution=*/false,
                                 /*AllowObjCWritebackConversion=*/
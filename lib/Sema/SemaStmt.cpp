@@ -377,8 +377,8 @@ StmtResult Sema::ActOnCompoundStmt(SourceLocation L, SourceLocation R,
       DiagnoseEmptyLoopBody(Elts[i], Elts[i + 1]);
   }
 
-  return new (Context) CompoundStmt(Context, Elts, L, R, isChecked,
-                                    checkedPropertyDeclared);
+  return CompoundStmt::Create(Context, Elts, L, R, isChecked,
+                              checkedPropertyDeclared);
 }
 
 StmtResult
@@ -19,6 +19,7 @@
 #include "clang/AST/DeclTemplate.h"
 #include "clang/AST/Expr.h"
 #include "clang/Basic/LangOptions.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/Sema/DeclSpec.h"
 #include "clang/Sema/Initialization.h"
 #include "clang/Sema/Lookup.h"
@@ -715,6 +716,15 @@ namespace {
     SourceLocation Loc;
     DeclarationName Entity;
 
+    /// \brief The types built for the typename-specifiers naming a member of
+    /// a complete class, keyed by the instantiated nested-name-specifier
+    /// (and whether the 'typename' keyword was used) and the member name.
+    ///
+    /// Repeated uses of a typename-specifier such as 'typename T::value_type'
+    /// within one instantiation then look up the member only once.
+    llvm::DenseMap<std::pair<void *, const IdentifierInfo *>, QualType>
+        DependentNameTypes;
+
   public:
     typedef TreeTransform<TemplateInstantiator> inherited;
 
@@ -852,6 +862,15 @@ namespace {
                                    NestedNameSpecifierLoc QualifierLoc,
                                    QualType T);
 
+    /// \brief Rebuild a typename-specifier, reusing the type built for the
+    /// same specifier earlier in this instantiation.
+    QualType RebuildDependentNameType(ElaboratedTypeKeyword Keyword,
+                                      SourceLocation KeywordLoc,
+                                      NestedNameSpecifierLoc QualifierLoc,
+                                      const IdentifierInfo *Id,
+                                      SourceLocation IdLoc,
+                                      bool DeducedTSTContext);
+
     TemplateName
     TransformTemplateName(CXXScopeSpec &SS, TemplateName Name,
                           SourceLocation NameLoc,
@@ -1091,6 +1110,44 @@ TemplateInstantiator::RebuildElaboratedType(SourceLocation KeywordLoc,
                                                                     T);
 }
 
+QualType TemplateInstantiator::RebuildDependentNameType(
+    ElaboratedTypeKeyword Keyword, SourceLocation KeywordLoc,
+    NestedNameSpecifierLoc QualifierLoc, const IdentifierInfo *Id,
+    SourceLocation IdLoc, bool DeducedTSTContext) {
+  if (Keyword != ETK_None && Keyword != ETK_Typename)
+    return inherited::RebuildDependentNameType(Keyword, KeywordLoc,
+                                               QualifierLoc, Id, IdLoc,
+                                               DeducedTSTContext);
+
+  NestedNameSpecifier *NNS = QualifierLoc.getNestedNameSpecifier();
+  std::pair<void *, const IdentifierInfo *> Key(
+      llvm::PointerIntPair<NestedNameSpecifier *, 1>(NNS,
+                                                     Keyword == ETK_Typename)
+          .getOpaqueValue(),
+      Id);
+  auto Known = DependentNameTypes.find(Key);
+  if (Known != DependentNameTypes.end())
+    return Known->second;
+
+  QualType T = inherited::RebuildDependentNameType(
+      Keyword, KeywordLoc, QualifierLoc, Id, IdLoc, DeducedTSTContext);
+  if (T.isNull() || T->isDependentType() || T->getContainedDeducedType())
+    return T;
+
+  // Only remember the result of a lookup into a complete class, which cannot
+  // change, and that did not name the injected-class-name of the class, for
+  // which a warning is produced at each use.
+  CXXRecordDecl *RD = NNS->getAsRecordDecl();
+  if (!RD || !RD->hasDefinition() || RD->getDefinition()->isBeingDefined())
+    return T;
+  if (auto *FoundRD = T->getAsCXXRecordDecl())
+    if (declaresSameEntity(FoundRD, RD))
+      return T;
+
+  DependentNameTypes[Key] = T;
+  return T;
+}
+
 TemplateName TemplateInstantiator::TransformTemplateName(
     CXXScopeSpec &SS, TemplateName Name, SourceLocation NameLoc,
     QualType ObjectType, NamedDecl *FirstQualifierInScope,
@@ -2013,6 +2070,13 @@ Sema::InstantiateClass(SourceLocation PointOfInstantiation,
   assert(!Inst.isAlreadyInstantiating() && "should have been caught by caller");
   PrettyDeclStackTraceEntry CrashInfo(*this, Instantiation, SourceLocation(),
                                       "instantiating class definition");
+  TimeTraceScope TimeScope("InstantiateClass", [&]() {
+    std::string Name;
+    llvm::raw_string_ostream OS(Name);
+    Instantiation->getNameForDiagnostic(OS, getPrintingPolicy(),
+                                        /*Qualified=*/true);
+    return OS.str();
+  });
 
   // Enter the scope of this instantiation. We don't use
   // PushDeclContext because we don't have a scope.
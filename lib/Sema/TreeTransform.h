@@ -9174,7 +9174,7 @@ ExprResult
 TreeTransform<Derived>::TransformUnaryOperator(UnaryOperator *E) {
   ExprResult SubExpr;
 
-  assert(E->getBoundsExpr() == nullptr &&
+  assert(!E->hasBoundsExpr() &&
          "inferred bounds checks should not be present");
 
   if (E->getOpcode() == UO_AddrOf)
@@ -9348,7 +9348,7 @@ TreeTransform<Derived>::TransformUnaryExprOrTypeTraitExpr(
 template<typename Derived>
 ExprResult
 TreeTransform<Derived>::TransformArraySubscriptExpr(ArraySubscriptExpr *E) {
-  assert(E->getBoundsExpr() == nullptr &&
+  assert(!E->hasBoundsExpr() &&
          "inferred bounds checks should not be present");
   ExprResult LHS = getDerived().TransformExpr(E->getLHS());
   if (LHS.isInvalid())
@@ -9431,7 +9431,7 @@ TreeTransform<Derived>::TransformCallExpr(CallExpr *E) {
 template<typename Derived>
 ExprResult
 TreeTransform<Derived>::TransformMemberExpr(MemberExpr *E) {
-  assert(E->getBoundsExpr() == nullptr &&
+  assert(!E->hasBoundsExpr() &&
          "inferred bounds checks should not be present");
   ExprResult Base = getDerived().TransformExpr(E->getBase());
   if (Base.isInvalid())
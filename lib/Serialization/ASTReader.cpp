@@ -81,6 +81,7 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SaveAndRestore.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -2031,10 +2032,81 @@ ASTReader::readInputFileInfo(ModuleFile &F, unsigned ID) {
   R.TopLevelModuleMap = static_cast<bool>(Record[5]);
   R.Filename = Blob;
   ResolveImportedPath(F, R.Filename);
+
+  // The hash of the contents, if it was recorded, follows.
+  R.HasContentHash = false;
+  R.ContentHash = 0;
+  llvm::BitstreamEntry Entry =
+      Cursor.advance(BitstreamCursor::AF_DontPopBlockAtEnd);
+  if (Entry.Kind == llvm::BitstreamEntry::Record) {
+    Record.clear();
+    if (Cursor.readRecord(Entry.ID, Record) == INPUT_FILE_HASH &&
+        Record.size() == 2) {
+      R.HasContentHash = true;
+      R.ContentHash = Record[0] | (Record[1] << 32);
+    }
+  }
   return R;
 }
 
+void ASTReader::readInputFilesManifest() {
+  ReadInputFilesManifest = true;
+  StringRef Path =
+      PP.getHeaderSearchInfo().getHeaderSearchOpts().ASTInputFilesManifest;
+  if (Path.empty())
+    return;
+
+  auto Buffer = FileMgr.getBufferForFile(Path);
+  if (!Buffer) {
+    Diag(diag::err_fe_ast_input_files_manifest_invalid)
+        << Path << Buffer.getError().message();
+    return;
+  }
+
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    Line = Line.rtrim("\r");
+    if (Line.empty())
+      continue;
+    StringRef Hex, Filename;
+    std::tie(Hex, Filename) = Line.split(' ');
+    uint64_t Hash;
+    if (Filename.empty() || Hex.getAsInteger(16, Hash)) {
+      Diag(diag::err_fe_ast_input_files_manifest_invalid)
+          << Path << ("malformed line '" + Line + "'").str();
+      TrustedInputFileHashes.clear();
+      return;
+    }
+    TrustedInputFileHashes[Filename] = Hash;
+  }
+}
+
+bool ASTReader::isInputFileTrusted(const InputFileInfo &FI) {
+  if (!FI.HasContentHash || FI.Overridden || FI.Transient)
+    return false;
+  if (!ReadInputFilesManifest)
+    readInputFilesManifest();
+  auto Known = TrustedInputFileHashes.find(FI.Filename);
+  return Known != TrustedInputFileHashes.end() &&
+         Known->second == FI.ContentHash;
+}
+
 static unsigned moduleKindForDiagnostic(ModuleKind Kind);
+
+/// \brief Determine whether an input file whose modification time changed
+/// still has the contents whose hash is stored in the AST file.
+bool ASTReader::hasStoredContents(const FileEntry *File,
+                                  const InputFileInfo &FI) {
+  if (!FI.HasContentHash || FI.StoredSize != File->getSize() ||
+      !PP.getHeaderSearchInfo().getHeaderSearchOpts()
+           .ValidateASTInputFilesContent)
+    return false;
+  auto Buffer = FileMgr.getBufferForFile(File);
+  return Buffer && llvm::xxHash64((*Buffer)->getBuffer()) == FI.ContentHash;
+}
+
 InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
   // If this ID is bogus, just return an empty input file.
   if (ID == 0 || ID > F.InputFilesLoaded.size())
@@ -2120,7 +2192,8 @@ InputFile ASTReader::getInputFile(ModuleFile &F, unsigned ID, bool Complain) {
       (StoredSize != File->getSize() ||
        (StoredTime && StoredTime != File->getModificationTime() &&
         !DisableValidation)
-       )) {
+       ) &&
+      !hasStoredContents(File, FI)) {
     if (Complain) {
       // Build a list of the PCH imports that got us here (in reverse).
       SmallVector<ModuleFile *, 4> ImportStack(1, &F);
@@ -2337,6 +2410,12 @@ ASTReader::ReadControlBlock(ModuleFile &F,
           N = NumInputs;
 
         for (unsigned I = 0; I < N; ++I) {
+          // The input files that the build system vouches for are only
+          // validated when they are used, which saves a stat for each of
+          // them.
+          if (!HSOpts.ASTInputFilesManifest.empty() &&
+              isInputFileTrusted(readInputFileInfo(F, I+1)))
+            continue;
           InputFile IF = getInputFile(F, I+1, Complain);
           if (!IF.getFile() || IF.isOutOfDate())
             return OutOfDate;
@@ -3975,6 +4054,13 @@ ASTReader::ASTReadResult ASTReader::ReadAST(StringRef FileName,
     // from which the preamble was built.
     if (Type == MK_Preamble) {
       SourceMgr.setPreambleFileID(PrimaryModule.OriginalSourceFileID);
+
+      // A preamble that was built on top of another preamble also has the
+      // file IDs of each lower layer for the same source file.
+      for (ModuleFile &F : ModuleMgr)
+        if (&F != &PrimaryModule && F.Kind == MK_Preamble &&
+            F.OriginalSourceFileID.isValid())
+          SourceMgr.addPreambleLayerFileID(F.OriginalSourceFileID);
     } else if (Type == MK_MainFile) {
       SourceMgr.setMainFileID(PrimaryModule.OriginalSourceFileID);
     }
@@ -4034,6 +4120,37 @@ static unsigned moduleKindForDiagnostic(ModuleKind Kind) {
   llvm_unreachable("unknown module kind");
 }
 
+namespace {
+
+/// \brief Charges the time spent until it is destroyed to the timer of a
+/// module file, and suspends the timer of the module file that imports it.
+class ModuleLoadTimeRegion {
+  SmallVectorImpl<llvm::Timer *> &Active;
+  llvm::Timer *T;
+
+public:
+  ModuleLoadTimeRegion(SmallVectorImpl<llvm::Timer *> &Active, llvm::Timer *T)
+      : Active(Active), T(T) {
+    if (!T)
+      return;
+    if (!Active.empty())
+      Active.back()->stopTimer();
+    Active.push_back(T);
+    T->startTimer();
+  }
+
+  ~ModuleLoadTimeRegion() {
+    if (!T)
+      return;
+    T->stopTimer();
+    Active.pop_back();
+    if (!Active.empty())
+      Active.back()->startTimer();
+  }
+};
+
+} // end anonymous namespace
+
 ASTReader::ASTReadResult
 ASTReader::ReadASTCore(StringRef FileName,
                        ModuleKind Type,
@@ -4086,6 +4203,15 @@ ASTReader::ReadASTCore(StringRef FileName,
 
   assert(M && "Missing module file");
 
+  llvm::Timer *LoadTimer = nullptr;
+  if (ModuleLoadTimerGroup) {
+    ModuleLoadTimers.push_back(llvm::make_unique<llvm::Timer>(
+        "reading_module_file." + FileName.str(),
+        "Reading module file " + FileName.str(), *ModuleLoadTimerGroup));
+    LoadTimer = ModuleLoadTimers.back().get();
+  }
+  ModuleLoadTimeRegion LoadTimeRegion(ActiveModuleLoadTimers, LoadTimer);
+
   ModuleFile &F = *M;
   BitstreamCursor &Stream = F.Stream;
   Stream = BitstreamCursor(PCHContainerRdr.ExtractPCH(*F.Buffer));
@@ -4756,7 +4882,7 @@ bool ASTReader::readASTFileControlBlock(
         StringRef Blob;
         bool shouldContinue = false;
         switch ((InputFileRecordTypes)Cursor.readRecord(Code, Record, &Blob)) {
-        case INPUT_FILE:
+        case INPUT_FILE: {
           bool Overridden = static_cast<bool>(Record[3]);
           std::string Filename = Blob;
           ResolveImportedPath(Filename, ModuleDir);
@@ -4764,6 +4890,10 @@ bool ASTReader::readASTFileControlBlock(
               Filename, isSystemFile, Overridden, /*IsExplicitModule*/false);
           break;
         }
+        case INPUT_FILE_HASH:
+          // The offsets only point at INPUT_FILE records.
+          break;
+        }
         if (!shouldContinue)
           break;
       }
@@ -5955,7 +6085,7 @@ QualType ASTReader::readTypeRecord(unsigned Index) {
     EPI.RefQualifier = static_cast<RefQualifierKind>(Record[Idx++]);
     SmallVector<QualType, 8> ExceptionStorage;
     readExceptionSpec(*Loc.F, ExceptionStorage, EPI.ExceptionSpec, Record, Idx);
-    EPI.ReturnAnnots = ReadBoundsAnnotations(*Loc.F);
+    EPI.ReturnAnnots = ReadSharedBoundsAnnotations(*Loc.F, Record, Idx);
 
     unsigned NumParams = Record[Idx++];
     SmallVector<QualType, 16> ParamTypes;
@@ -5965,7 +6095,7 @@ QualType ASTReader::readTypeRecord(unsigned Index) {
     if (HasParamAnnots) {
       SmallVector<BoundsAnnotations, 16> ParamAnnots;
       for (unsigned I = 0; I != NumParams; ++I) {
-        ParamAnnots.push_back(ReadBoundsAnnotations(*Loc.F));
+        ParamAnnots.push_back(ReadSharedBoundsAnnotations(*Loc.F, Record, Idx));
       }
       EPI.ParamAnnots = ParamAnnots.data();
     } else
@@ -7068,7 +7198,7 @@ SourceLocation ASTReader::getSourceLocationForDeclID(GlobalDeclID ID) {
 
   unsigned Index = ID - NUM_PREDEF_DECL_IDS;
 
-  if (Index > DeclsLoaded.size()) {
+  if (Index >= DeclsLoaded.size()) {
     Error("declaration ID out-of-range for AST file");
     return SourceLocation();
   }
@@ -7226,6 +7356,8 @@ Stmt *ASTReader::GetExternalDeclStmt(uint64_t Offset) {
   assert(NumCurrentElementsDeserializing == 0 &&
          "should not be called while already deserializing");
   Deserializing D(this);
+  if (LazyFunctionBodies.erase(Offset))
+    ++NumFunctionBodiesRead;
   return ReadStmtFromStream(*Loc.F);
 }
 
@@ -7362,9 +7494,18 @@ ASTReader::FindExternalVisibleDeclsByName(const DeclContext *DC,
 
   Deserializing LookupResults(this);
 
+  // If the global module index has a name filter for a module file, don't
+  // search its lookup table for a name that it doesn't know about.
+  StringRef FilterName;
+  if (Name.getNameKind() == DeclarationName::Identifier && !loadGlobalIndex())
+    FilterName = Name.getAsIdentifierInfo()->getName();
+  auto ShouldSearchFile = [&](ModuleFile *F) {
+    return FilterName.empty() || GlobalIndex->mayContainName(F, FilterName);
+  };
+
   // Load the list of declarations.
   SmallVector<NamedDecl *, 64> Decls;
-  for (DeclID ID : It->second.Table.find(Name)) {
+  for (DeclID ID : It->second.Table.find(Name, ShouldSearchFile)) {
     NamedDecl *ND = cast<NamedDecl>(GetDecl(ID));
     if (ND->getDeclName() == Name)
       Decls.push_back(ND);
@@ -7438,16 +7579,9 @@ void ASTReader::StartTranslationUnit(ASTConsumer *Consumer) {
 void ASTReader::PrintStats() {
   std::fprintf(stderr, "*** AST File Statistics:\n");
 
-  unsigned NumTypesLoaded
-    = TypesLoaded.size() - std::count(TypesLoaded.begin(), TypesLoaded.end(),
-                                      QualType());
-  unsigned NumDeclsLoaded
-    = DeclsLoaded.size() - std::count(DeclsLoaded.begin(), DeclsLoaded.end(),
-                                      (Decl *)nullptr);
-  unsigned NumIdentifiersLoaded
-    = IdentifiersLoaded.size() - std::count(IdentifiersLoaded.begin(),
-                                            IdentifiersLoaded.end(),
-                                            (IdentifierInfo *)nullptr);
+  unsigned NumTypesLoaded = TypesLoaded.countNonDefault();
+  unsigned NumDeclsLoaded = DeclsLoaded.countNonDefault();
+  unsigned NumIdentifiersLoaded = IdentifiersLoaded.countNonDefault();
   unsigned NumMacrosLoaded
     = MacrosLoaded.size() - std::count(MacrosLoaded.begin(),
                                        MacrosLoaded.end(),
@@ -7485,6 +7619,10 @@ void ASTReader::PrintStats() {
     std::fprintf(stderr, "  %u/%u statements read (%f%%)\n",
                  NumStatementsRead, TotalNumStatements,
                  ((float)NumStatementsRead/TotalNumStatements * 100));
+  if (NumLazyFunctionBodies)
+    std::fprintf(stderr, "  %u/%u function bodies read (%f%%)\n",
+                 NumFunctionBodiesRead, NumLazyFunctionBodies,
+                 ((float)NumFunctionBodiesRead/NumLazyFunctionBodies * 100));
   if (TotalNumMacros)
     std::fprintf(stderr, "  %u/%u macros read (%f%%)\n",
                  NumMacrosRead, TotalNumMacros,
@@ -7903,10 +8041,21 @@ void ASTReader::ReadMethodPool(Selector Sel) {
   Generation = getGeneration();
   SelectorOutOfDate[Sel] = false;
 
+  // If there is a global index, use the name filters of the module files to
+  // determine which of them provably don't know about this selector.
+  GlobalModuleIndex::HitSet Hits;
+  GlobalModuleIndex::HitSet *HitsPtr = nullptr;
+  if (const IdentifierInfo *FirstPiece = Sel.getIdentifierInfoForSlot(0)) {
+    if (!loadGlobalIndex()) {
+      GlobalIndex->lookupName(FirstPiece->getName(), Hits);
+      HitsPtr = &Hits;
+    }
+  }
+
   // Search for methods defined with this selector.
   ++NumMethodPoolLookups;
   ReadMethodPoolVisitor Visitor(*this, Sel, PriorGeneration);
-  ModuleMgr.visit(Visitor);
+  ModuleMgr.visit(Visitor, HitsPtr);
 
   if (Visitor.getInstanceMethods().empty() &&
       Visitor.getFactoryMethods().empty())
@@ -9212,14 +9361,19 @@ void ASTReader::finishPendingActions() {
       const FunctionDecl *Defn = nullptr;
       if (!getContext().getLangOpts().Modules || !FD->hasBody(Defn)) {
         FD->setLazyBody(PB->second);
+        if (LazyFunctionBodies.insert(PB->second).second)
+          ++NumLazyFunctionBodies;
       } else
         mergeDefinitionVisibility(const_cast<FunctionDecl*>(Defn), FD);
       continue;
     }
 
     ObjCMethodDecl *MD = cast<ObjCMethodDecl>(PB->first);
-    if (!getContext().getLangOpts().Modules || !MD->hasBody())
+    if (!getContext().getLangOpts().Modules || !MD->hasBody()) {
       MD->setLazyBody(PB->second);
+      if (LazyFunctionBodies.insert(PB->second).second)
+        ++NumLazyFunctionBodies;
+    }
   }
   PendingBodies.clear();
 
@@ -115,11 +115,10 @@ void ASTStmtReader::VisitNullStmt(NullStmt *S) {
 
 void ASTStmtReader::VisitCompoundStmt(CompoundStmt *S) {
   VisitStmt(S);
-  SmallVector<Stmt *, 16> Stmts;
   unsigned NumStmts = Record.readInt();
-  while (NumStmts--)
-    Stmts.push_back(Record.readSubStmt());
-  S->setStmts(Record.getContext(), Stmts);
+  assert(NumStmts == S->size() && "NumStmts is wrong ?");
+  for (Stmt *&SubStmt : S->body())
+    SubStmt = Record.readSubStmt();
   S->LBraceLoc = ReadSourceLocation();
   S->RBraceLoc = ReadSourceLocation();
 }
@@ -568,7 +567,9 @@ void ASTStmtReader::VisitUnaryOperator(UnaryOperator *E) {
   E->setOperatorLoc(ReadSourceLocation());
   bool hasBoundsExpr = Record.readInt();
   if (hasBoundsExpr) {
-    E->setBoundsExpr(Record.readBoundsExpr());
+    E->setLazyBoundsExpr(Record.getContext(),
+                         Record.getGlobalBitOffset(Record.readInt()));
+    E->setBoundsCheckKind((BoundsCheckKind)Record.readInt());
   }
 }
 
@@ -634,7 +635,9 @@ void ASTStmtReader::VisitArraySubscriptExpr(ArraySubscriptExpr *E) {
   E->setRBracketLoc(ReadSourceLocation());
   bool hasBoundsExpr = Record.readInt();
   if (hasBoundsExpr) {
-    E->setBoundsExpr(Record.readBoundsExpr());
+    E->setLazyBoundsExpr(Record.getContext(),
+                         Record.getGlobalBitOffset(Record.readInt()));
+    E->setBoundsCheckKind((BoundsCheckKind)Record.readInt());
   }
 }
 
@@ -3112,6 +3115,31 @@ BoundsAnnotations ASTReader::ReadBoundsAnnotations(ModuleFile &F) {
                            cast_or_null<InteropTypeExpr>(IType));
 }
 
+BoundsAnnotations
+ASTReader::ReadSharedBoundsAnnotations(ModuleFile &F, const RecordData &Record,
+                                       unsigned &Idx) {
+  Expr *Bounds = ReadSharedBoundsExpr(F, Record[Idx++]);
+  Expr *IType = ReadSharedBoundsExpr(F, Record[Idx++]);
+  return BoundsAnnotations(cast_or_null<BoundsExpr>(Bounds),
+                           cast_or_null<InteropTypeExpr>(IType));
+}
+
+Expr *ASTReader::ReadSharedBoundsExpr(ModuleFile &F, uint64_t LocalOffset) {
+  if (!LocalOffset)
+    return nullptr;
+  uint64_t Offset = getGlobalBitOffset(F, LocalOffset);
+  auto Known = SharedBoundsExprs.find(Offset);
+  if (Known != SharedBoundsExprs.end())
+    return Known->second;
+
+  RecordLocation Loc = getLocalBitOffset(Offset);
+  SavedStreamPosition SavedPosition(Loc.F->DeclsCursor);
+  Loc.F->DeclsCursor.JumpToBit(Loc.Offset);
+  Expr *E = cast_or_null<Expr>(ReadStmtFromStream(*Loc.F));
+  SharedBoundsExprs[Offset] = E;
+  return E;
+}
+
 Expr *ASTReader::ReadSubExpr() {
   return cast_or_null<Expr>(ReadSubStmt());
 }
@@ -3180,7 +3208,8 @@ Stmt *ASTReader::ReadStmtFromStream(ModuleFile &F) {
       break;
 
     case STMT_COMPOUND:
-      S = new (Context) CompoundStmt(Empty);
+      S = CompoundStmt::CreateEmpty(
+          Context, /*NumStmts=*/Record[ASTStmtReader::NumStmtFields]);
       break;
 
     case STMT_CASE:
@@ -3367,9 +3396,11 @@ Stmt *ASTReader::ReadStmtFromStream(ModuleFile &F) {
       SourceLocation OperatorLoc = Record.readSourceLocation();
 
       bool HadBoundsExpr = Record.readInt();
-      BoundsExpr *Bounds = nullptr;
+      uint64_t BoundsOffset = 0;
+      bool BoundsCheckProven = false;
       if (HadBoundsExpr) {
-        Bounds = Record.readBoundsExpr();
+        BoundsOffset = Record.getGlobalBitOffset(Record.readInt());
+        BoundsCheckProven = Record.readInt();
       }
 
       S = MemberExpr::Create(Context, Base, IsArrow, OperatorLoc, QualifierLoc,
@@ -3380,8 +3411,10 @@ Stmt *ASTReader::ReadStmtFromStream(ModuleFile &F) {
                                     MemberD->getDeclName());
       if (HadMultipleCandidates)
         cast<MemberExpr>(S)->setHadMultipleCandidates(true);
-      if (HadBoundsExpr)
-        cast<MemberExpr>(S)->setBoundsExpr(Bounds);
+      if (HadBoundsExpr) {
+        cast<MemberExpr>(S)->setLazyBoundsExpr(Context, BoundsOffset);
+        cast<MemberExpr>(S)->setBoundsCheckProven(BoundsCheckProven);
+      }
       break;
     }
 
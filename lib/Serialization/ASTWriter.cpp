@@ -82,6 +82,7 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -295,7 +296,7 @@ void ASTTypeWriter::VisitFunctionProtoType(const FunctionProtoType *T) {
   Record.push_back(T->getTypeQuals());
   Record.push_back(static_cast<unsigned>(T->getRefQualifier()));
   addExceptionSpec(T, Record);
-  Record.AddBoundsAnnotations(T->getReturnAnnots());
+  Record.AddSharedBoundsAnnotations(T->getReturnAnnots());
 
   Record.push_back(T->getNumParams());
   for (unsigned I = 0, N = T->getNumParams(); I != N; ++I)
@@ -303,7 +304,7 @@ void ASTTypeWriter::VisitFunctionProtoType(const FunctionProtoType *T) {
 
   if (T->hasParamAnnots())
     for (unsigned I = 0, N = T->getNumParams(); I != N; ++I)
-      Record.AddBoundsAnnotations(T->getParamAnnots(I));
+      Record.AddSharedBoundsAnnotations(T->getParamAnnots(I));
 
   if (T->hasExtParameterInfos()) {
     for (unsigned I = 0, N = T->getNumParams(); I != N; ++I)
@@ -1053,6 +1054,9 @@ static void AddStmtsExprs(llvm::BitstreamWriter &Stream,
   RECORD(EXPR_CXX_UUIDOF_EXPR);
   RECORD(EXPR_CXX_UUIDOF_TYPE);
   RECORD(EXPR_LAMBDA);
+  RECORD(EXPR_COUNT_BOUNDS_EXPR);
+  RECORD(EXPR_NULLARY_BOUNDS_EXPR);
+  RECORD(EXPR_RANGE_BOUNDS_EXPR);
 #undef RECORD
 }
 
@@ -1084,6 +1088,7 @@ void ASTWriter::WriteBlockInfoBlock() {
 
   BLOCK(INPUT_FILES_BLOCK);
   RECORD(INPUT_FILE);
+  RECORD(INPUT_FILE_HASH);
 
   // AST Top-Level Block.
   BLOCK(AST_BLOCK);
@@ -1298,6 +1303,9 @@ void ASTWriter::WriteBlockInfoBlock() {
   // Statements and Exprs can occur in the Decls and Types block.
   AddStmtsExprs(Stream, Record);
 
+  // Checked C bounds, loaded lazily, occur among the statements.
+  BLOCK(CHECKEDC_BOUNDS_BLOCK);
+
   BLOCK(PREPROCESSOR_DETAIL_BLOCK);
   RECORD(PPD_MACRO_EXPANSION);
   RECORD(PPD_MACRO_DEFINITION);
@@ -1735,6 +1743,7 @@ namespace  {
   /// \brief An input file.
   struct InputFileEntry {
     const FileEntry *File;
+    const SrcMgr::ContentCache *Cache;
     bool IsSystemFile;
     bool IsTransient;
     bool BufferOverridden;
@@ -1761,6 +1770,13 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
   IFAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob)); // File name
   unsigned IFAbbrevCode = Stream.EmitAbbrev(std::move(IFAbbrev));
 
+  // Create input file hash abbreviation.
+  auto IFHAbbrev = std::make_shared<BitCodeAbbrev>();
+  IFHAbbrev->Add(BitCodeAbbrevOp(INPUT_FILE_HASH));
+  IFHAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32)); // Low bits
+  IFHAbbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 32)); // High bits
+  unsigned IFHAbbrevCode = Stream.EmitAbbrev(std::move(IFHAbbrev));
+
   // Get all ContentCache objects for files, sorted by whether the file is a
   // system one or not. System files go at the back, users files at the front.
   std::deque<InputFileEntry> SortedFiles;
@@ -1779,6 +1795,7 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
 
     InputFileEntry Entry;
     Entry.File = Cache->OrigEntry;
+    Entry.Cache = Cache;
     Entry.IsSystemFile = Cache->IsSystemFile;
     Entry.IsTransient = Cache->IsTransient;
     Entry.BufferOverridden = Cache->BufferOverridden;
@@ -1818,6 +1835,20 @@ void ASTWriter::WriteInputFiles(SourceManager &SourceMgr,
         Entry.IsTopLevelModuleMap};
 
     EmitRecordWithPath(IFAbbrevCode, Record, Entry.File->getName());
+
+    // Emit the hash of the contents of the file, if requested.  There is
+    // nothing to validate for an overridden file.
+    if (HSOpts.ValidateASTInputFilesContent && !Entry.BufferOverridden) {
+      bool Invalid = false;
+      const llvm::MemoryBuffer *Buffer = Entry.Cache->getBuffer(
+          SourceMgr.getDiagnostics(), SourceMgr, SourceLocation(), &Invalid);
+      if (!Invalid) {
+        uint64_t Hash = llvm::xxHash64(Buffer->getBuffer());
+        RecordData::value_type HashRecord[] = {INPUT_FILE_HASH, uint32_t(Hash),
+                                               uint32_t(Hash >> 32)};
+        Stream.EmitRecordWithAbbrev(IFHAbbrevCode, HashRecord);
+      }
+    }
   }
 
   Stream.ExitBlock();
@@ -3181,6 +3212,9 @@ void ASTWriter::WriteFileDeclIDsMap() {
   SmallVector<DeclID, 256> FileGroupedDeclIDs;
   for (auto &FileDeclEntry : SortedFileDeclIDs) {
     DeclIDInFileInfo &Info = *FileDeclEntry.second;
+    // Declarations at the same offset stay in the order they were written.
+    std::stable_sort(Info.DeclIDs.begin(), Info.DeclIDs.end(),
+                     llvm::less_first());
     Info.FirstDeclIndex = FileGroupedDeclIDs.size();
     for (auto &LocDeclEntry : Info.DeclIDs)
       FileGroupedDeclIDs.push_back(LocDeclEntry.second);
@@ -5501,18 +5535,10 @@ void ASTWriter::associateDeclWithFile(const Decl *D, DeclID ID) {
   if (!Info)
     Info = new DeclIDInFileInfo();
 
-  std::pair<unsigned, serialization::DeclID> LocDecl(Offset, ID);
-  LocDeclIDsTy &Decls = Info->DeclIDs;
-
-  if (Decls.empty() || Decls.back().first <= Offset) {
-    Decls.push_back(LocDecl);
-    return;
-  }
-
-  LocDeclIDsTy::iterator I =
-      std::upper_bound(Decls.begin(), Decls.end(), LocDecl, llvm::less_first());
-
-  Decls.insert(I, LocDecl);
+  // Declarations are written in ID order rather than in source order, so
+  // keeping the vector sorted here would be quadratic in the number of
+  // declarations of a file.  It is sorted once by WriteFileDeclIDsMap.
+  Info->DeclIDs.push_back(std::make_pair(Offset, ID));
 }
 
 void ASTRecordWriter::AddDeclarationName(DeclarationName Name) {
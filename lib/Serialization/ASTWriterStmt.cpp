@@ -45,6 +45,8 @@ namespace clang {
     uint64_t Emit() {
       assert(Code != serialization::STMT_NULL_PTR &&
              "unhandled sub-statement writing AST file");
+      if (Writer.WritingBoundsBlock)
+        AbbrevToUse = 0;
       return Record.EmitStmt(Code, AbbrevToUse);
     }
 
@@ -524,7 +526,8 @@ void ASTStmtWriter::VisitUnaryOperator(UnaryOperator *E) {
   Record.AddSourceLocation(E->getOperatorLoc());
   Record.push_back(E->hasBoundsExpr());
   if (E->hasBoundsExpr()) {
-    Record.AddStmt(E->getBoundsExpr());
+    Record.AddLazyBoundsExpr(E->getBoundsExpr(*Writer.Context));
+    Record.push_back(E->getBoundsCheckKind());
   }
   Code = serialization::EXPR_UNARY_OPERATOR;
 }
@@ -585,7 +588,8 @@ void ASTStmtWriter::VisitArraySubscriptExpr(ArraySubscriptExpr *E) {
   Record.AddSourceLocation(E->getRBracketLoc());
   Record.push_back(E->hasBoundsExpr());
   if (E->hasBoundsExpr()) {
-    Record.AddStmt(E->getBoundsExpr());
+    Record.AddLazyBoundsExpr(E->getBoundsExpr(*Writer.Context));
+    Record.push_back(E->getBoundsCheckKind());
   }
   Code = serialization::EXPR_ARRAY_SUBSCRIPT;
 }
@@ -608,6 +612,11 @@ void ASTStmtWriter::VisitCallExpr(CallExpr *E) {
   for (CallExpr::arg_iterator Arg = E->arg_begin(), ArgEnd = E->arg_end();
        Arg != ArgEnd; ++Arg)
     Record.AddStmt(*Arg);
+
+  // Subclasses of CallExpr append to the record.
+  if (E->getStmtClass() == Stmt::CallExprClass)
+    AbbrevToUse = Writer.getExprCallAbbrev();
+
   Code = serialization::EXPR_CALL;
 }
 
@@ -645,7 +654,8 @@ void ASTStmtWriter::VisitMemberExpr(MemberExpr *E) {
   Record.AddSourceLocation(E->getOperatorLoc());
   Record.push_back(E->hasBoundsExpr());
   if (E->hasBoundsExpr()) {
-    Record.AddStmt(E->getBoundsExpr());
+    Record.AddLazyBoundsExpr(E->getBoundsExpr(*Writer.Context));
+    Record.push_back(E->isBoundsCheckProven());
   }
   Record.AddDeclarationNameLoc(E->MemberDNLoc,
                                E->getMemberDecl()->getDeclName());
@@ -709,6 +719,11 @@ void ASTStmtWriter::VisitBinaryOperator(BinaryOperator *E) {
   Record.push_back(E->getOpcode()); // FIXME: stable encoding
   Record.AddSourceLocation(E->getOperatorLoc());
   Record.push_back(E->getFPFeatures().getInt());
+
+  // CompoundAssignOperator appends to the record.
+  if (E->getStmtClass() == Stmt::BinaryOperatorClass)
+    AbbrevToUse = Writer.getExprBinaryOperatorAbbrev();
+
   Code = serialization::EXPR_BINARY_OPERATOR;
 }
 
@@ -745,7 +760,9 @@ ASTStmtWriter::VisitBinaryConditionalOperator(BinaryConditionalOperator *E) {
 void ASTStmtWriter::VisitImplicitCastExpr(ImplicitCastExpr *E) {
   VisitCastExpr(E);
 
-  if (E->path_size() == 0 && !E->hasBoundsExpr())
+  if (E->path_size() == 0 && !E->isBoundsSafeInterface() &&
+      !E->hasBoundsExpr() && !E->hasNormalizedBoundsExpr() &&
+      !E->hasSubExprBoundsExpr())
     AbbrevToUse = Writer.getExprImplicitCastAbbrev();
 
   Code = serialization::EXPR_IMPLICIT_CAST;
@@ -999,6 +1016,7 @@ void ASTStmtWriter::VisitCountBoundsExpr(CountBoundsExpr *E) {
   Record.AddStmt(E->getCountExpr());
   Record.AddSourceLocation(E->getStartLoc());
   Record.AddSourceLocation(E->getRParenLoc());
+  AbbrevToUse = Writer.getExprCountBoundsAbbrev();
   Code = serialization::EXPR_COUNT_BOUNDS_EXPR;
 }
 
@@ -1007,6 +1025,7 @@ void ASTStmtWriter::VisitNullaryBoundsExpr(NullaryBoundsExpr *E) {
   Record.push_back(E->getKind());
   Record.AddSourceLocation(E->getStartLoc());
   Record.AddSourceLocation(E->getRParenLoc());
+  AbbrevToUse = Writer.getExprNullaryBoundsAbbrev();
   Code = serialization::EXPR_NULLARY_BOUNDS_EXPR;
 }
 
@@ -1017,6 +1036,7 @@ void ASTStmtWriter::VisitRangeBoundsExpr(RangeBoundsExpr *E) {
   Record.AddStmt(E->getUpperExpr());
   Record.AddSourceLocation(E->getStartLoc());
   Record.AddSourceLocation(E->getRParenLoc());
+  AbbrevToUse = Writer.getExprRangeBoundsAbbrev();
   Code = serialization::EXPR_RANGE_BOUNDS_EXPR;
 }
 
@@ -2806,6 +2826,47 @@ void ASTWriter::WriteSubStmt(Stmt *S) {
   SubStmtEntries[S] = Offset;
 }
 
+uint64_t ASTWriter::WriteBoundsBlock(Expr *E) {
+  auto Known = BoundsBlockOffsets.find(E);
+  if (Known != BoundsBlockOffsets.end())
+    return Known->second;
+
+  // An enclosing statement may still be being written.  The block is read
+  // on its own, so it must not refer to the statements written for it.
+  llvm::DenseMap<Stmt *, uint64_t> EnclosingEntries;
+  llvm::DenseSet<Stmt *> EnclosingParents;
+  std::swap(EnclosingEntries, SubStmtEntries);
+  std::swap(EnclosingParents, ParentStmts);
+  bool WasWritingBoundsBlock = WritingBoundsBlock;
+  WritingBoundsBlock = true;
+
+  // Use the code width of the DECLTYPES block, whose cursor reads the bounds.
+  Stream.EnterSubblock(serialization::CHECKEDC_BOUNDS_BLOCK_ID, 5);
+  uint64_t Offset = Stream.GetCurrentBitNo();
+  WriteSubStmt(E);
+  Stream.EmitRecord(serialization::STMT_STOP, ArrayRef<uint32_t>());
+  Stream.ExitBlock();
+
+  WritingBoundsBlock = WasWritingBoundsBlock;
+  std::swap(EnclosingEntries, SubStmtEntries);
+  std::swap(EnclosingParents, ParentStmts);
+  BoundsBlockOffsets[E] = Offset;
+  return Offset;
+}
+
+uint64_t ASTWriter::WriteSharedBoundsBlock(Expr *E) {
+  if (!E)
+    return 0;
+  llvm::FoldingSetNodeID ID;
+  E->Profile(ID, *Context, /*Canonical=*/false);
+  auto Known = SharedBoundsBlocks.find(ID);
+  if (Known != SharedBoundsBlocks.end())
+    return Known->second;
+  uint64_t Offset = WriteBoundsBlock(E);
+  SharedBoundsBlocks.insert(std::make_pair(std::move(ID), Offset));
+  return Offset;
+}
+
 /// \brief Flush all of the statements that have been added to the
 /// queue via AddStmt().
 void ASTRecordWriter::FlushStmts() {
@@ -29,6 +29,7 @@
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/OnDiskHashTable.h"
 #include "llvm/Support/Path.h"
+#include <algorithm>
 #include <cstdio>
 using namespace clang;
 using namespace serialization;
@@ -50,7 +51,9 @@ namespace {
     /// \brief Describes a module, including its file name and dependencies.
     MODULE,
     /// \brief The index for identifiers.
-    IDENTIFIER_INDEX
+    IDENTIFIER_INDEX,
+    /// \brief The bloom filter of the names known to a module.
+    MODULE_NAME_FILTER
   };
 }
 
@@ -58,7 +61,28 @@ namespace {
 static const char * const IndexFileName = "modules.idx";
 
 /// \brief The global index file version.
-static const unsigned CurrentVersion = 1;
+static const unsigned CurrentVersion = 2;
+
+/// \brief The number of bits of a name filter per name that it contains,
+/// which gives a false positive rate of about 1%.
+static const unsigned NameFilterBitsPerName = 10;
+
+/// \brief The number of bits of a name filter that are set for each name.
+static const unsigned NumNameFilterHashes = 7;
+
+/// \brief Compute the two hashes from which the bits of a name filter
+/// that correspond to a name are derived.
+static std::pair<uint32_t, uint32_t> getNameFilterHashes(StringRef Name) {
+  uint64_t H = llvm::HashString(Name) | (uint64_t)Name.size() << 32;
+  // Mix the bits, with the finalizer of MurmurHash3, so that both halves
+  // depend on the whole name.
+  H ^= H >> 33;
+  H *= 0xff51afd7ed558ccdULL;
+  H ^= H >> 33;
+  H *= 0xc4ceb9fe1a85ec53ULL;
+  H ^= H >> 33;
+  return std::make_pair(uint32_t(H), uint32_t(H >> 32) | 1);
+}
 
 //----------------------------------------------------------------------------//
 // Global module index reader.
@@ -126,7 +150,8 @@ typedef llvm::OnDiskIterableChainedHashTable<IdentifierIndexReaderTrait>
 GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
                                      llvm::BitstreamCursor Cursor)
     : Buffer(std::move(Buffer)), IdentifierIndex(), NumIdentifierLookups(),
-      NumIdentifierLookupHits() {
+      NumIdentifierLookupHits(), NumNameFilterLookups(),
+      NumNameFilterRejections() {
   // Read the global index.
   bool InGlobalIndexBlock = false;
   bool Done = false;
@@ -224,6 +249,16 @@ GlobalModuleIndex::GlobalModuleIndex(std::unique_ptr<llvm::MemoryBuffer> Buffer,
             (const unsigned char *)Blob.data(), IdentifierIndexReaderTrait());
       }
       break;
+
+    case MODULE_NAME_FILTER: {
+      // The filter refers to the buffer, which lives as long as the index.
+      if (Record.size() < 2 || Record[0] >= Modules.size() || Blob.empty())
+        return;
+      unsigned ID = Record[0];
+      Modules[ID].NameFilter = Blob;
+      Modules[ID].NumNameFilterHashes = Record[1];
+      break;
+    }
     }
   }
 }
@@ -313,6 +348,38 @@ bool GlobalModuleIndex::lookupIdentifier(StringRef Name, HitSet &Hits) {
   return true;
 }
 
+bool GlobalModuleIndex::mayContainName(ModuleFile *File, StringRef Name) {
+  llvm::DenseMap<ModuleFile *, unsigned>::iterator Known
+    = ModulesByFile.find(File);
+  if (Known == ModulesByFile.end())
+    return true;
+
+  const ModuleInfo &Info = Modules[Known->second];
+  if (Info.NameFilter.empty())
+    return true;
+
+  ++NumNameFilterLookups;
+  std::pair<uint32_t, uint32_t> Hashes = getNameFilterHashes(Name);
+  uint64_t NumBits = (uint64_t)Info.NameFilter.size() * 8;
+  for (unsigned I = 0; I != Info.NumNameFilterHashes; ++I) {
+    uint64_t Bit = (Hashes.first + (uint64_t)I * Hashes.second) % NumBits;
+    if (!(Info.NameFilter[Bit / 8] & (1 << (Bit % 8)))) {
+      ++NumNameFilterRejections;
+      return false;
+    }
+  }
+  return true;
+}
+
+void GlobalModuleIndex::lookupName(StringRef Name, HitSet &Hits) {
+  Hits.clear();
+  for (unsigned I = 0, N = Modules.size(); I != N; ++I) {
+    if (ModuleFile *MF = Modules[I].File)
+      if (mayContainName(MF, Name))
+        Hits.insert(MF);
+  }
+}
+
 bool GlobalModuleIndex::loadedModuleFile(ModuleFile *File) {
   // Look for the module in the global module index based on the module name.
   StringRef Name = File->ModuleName;
@@ -347,6 +414,12 @@ void GlobalModuleIndex::printStats() {
             NumIdentifierLookupHits, NumIdentifierLookups,
             (double)NumIdentifierLookupHits*100.0/NumIdentifierLookups);
   }
+  if (NumNameFilterLookups) {
+    fprintf(stderr, "  %u / %u name filter lookups ruled out a module file "
+                    "(%f%%)\n",
+            NumNameFilterRejections, NumNameFilterLookups,
+            (double)NumNameFilterRejections*100.0/NumNameFilterLookups);
+  }
   std::fprintf(stderr, "\n");
 }
 
@@ -377,6 +450,14 @@ namespace {
     /// a module ID.
     SmallVector<unsigned, 4> Dependencies;
     ASTFileSignature Signature;
+
+    /// \brief Whether this module file has been loaded into the builder, as
+    /// opposed to only being known as a dependency.
+    bool Loaded = false;
+
+    /// \brief The name filter hashes of the identifiers stored in this
+    /// module file.
+    std::vector<std::pair<uint32_t, uint32_t>> NameHashes;
   };
 
   struct ImportedModuleFileInfo {
@@ -417,6 +498,14 @@ namespace {
     /// \brief Write the block-info block for the global module index file.
     void emitBlockInfoBlock(llvm::BitstreamWriter &Stream);
 
+    /// \brief Compute the name filter of the given module file, which covers
+    /// the names known to it and to the module files on which it depends.
+    ///
+    /// \returns false if some of these module files have not been loaded, in
+    /// which case no filter can be built.
+    bool computeNameFilter(const ModuleFileInfo &Info,
+                           SmallVectorImpl<char> &Filter);
+
     /// \brief Retrieve the module file information for the given file.
     ModuleFileInfo &getModuleFileInfo(const FileEntry *File) {
       llvm::MapVector<const FileEntry *, ModuleFileInfo>::iterator Known
@@ -482,6 +571,7 @@ GlobalModuleIndexBuilder::emitBlockInfoBlock(llvm::BitstreamWriter &Stream) {
   RECORD(INDEX_METADATA);
   RECORD(MODULE);
   RECORD(IDENTIFIER_INDEX);
+  RECORD(MODULE_NAME_FILTER);
 #undef RECORD
 #undef BLOCK
 
@@ -531,6 +621,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
   // Record this module file and assign it a unique ID (if it doesn't have
   // one already).
   unsigned ID = getModuleFileInfo(File).ID;
+  getModuleFileInfo(File).Loaded = true;
 
   // Search for the blocks and records we care about.
   enum { Other, ControlBlock, ASTBlock, DiagnosticOptionsBlock } State = Other;
@@ -660,6 +751,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
               (const unsigned char *)Blob.data() + Record[0],
               (const unsigned char *)Blob.data() + sizeof(uint32_t),
               (const unsigned char *)Blob.data()));
+      auto &NameHashes = getModuleFileInfo(File).NameHashes;
       for (InterestingIdentifierTable::data_iterator D = Table->data_begin(),
                                                      DEnd = Table->data_end();
            D != DEnd; ++D) {
@@ -668,6 +760,7 @@ bool GlobalModuleIndexBuilder::loadModuleFile(const FileEntry *File) {
           InterestingIdentifiers[Ident.first].push_back(ID);
         else
           (void)InterestingIdentifiers[Ident.first];
+        NameHashes.push_back(getNameFilterHashes(Ident.first));
       }
     }
 
@@ -725,6 +818,45 @@ public:
 
 }
 
+bool
+GlobalModuleIndexBuilder::computeNameFilter(const ModuleFileInfo &Info,
+                                            SmallVectorImpl<char> &Filter) {
+  // An AST file only stores the identifiers that the files it imports don't,
+  // but its declarations can be named by any of them, so collect the names of
+  // all the module files that it transitively depends on.
+  std::vector<std::pair<uint32_t, uint32_t>> Hashes;
+  llvm::SmallVector<unsigned, 16> Worklist(1, Info.ID);
+  llvm::SmallVector<bool, 64> Seen(ModuleFiles.size());
+  Seen[Info.ID] = true;
+  while (!Worklist.empty()) {
+    const ModuleFileInfo &Dep = (ModuleFiles.begin() + Worklist.pop_back_val())
+                                    ->second;
+    if (!Dep.Loaded)
+      return false;
+    Hashes.insert(Hashes.end(), Dep.NameHashes.begin(), Dep.NameHashes.end());
+    for (unsigned DepID : Dep.Dependencies) {
+      if (!Seen[DepID]) {
+        Seen[DepID] = true;
+        Worklist.push_back(DepID);
+      }
+    }
+  }
+  std::sort(Hashes.begin(), Hashes.end());
+  Hashes.erase(std::unique(Hashes.begin(), Hashes.end()), Hashes.end());
+
+  uint64_t NumBits =
+      std::max<uint64_t>(64, Hashes.size() * NameFilterBitsPerName);
+  Filter.assign((NumBits + 7) / 8, 0);
+  NumBits = (uint64_t)Filter.size() * 8;
+  for (const auto &H : Hashes) {
+    for (unsigned I = 0; I != NumNameFilterHashes; ++I) {
+      uint64_t Bit = (H.first + (uint64_t)I * H.second) % NumBits;
+      Filter[Bit / 8] |= 1 << (Bit % 8);
+    }
+  }
+  return true;
+}
+
 bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
   for (auto MapEntry : ImportedModuleFiles) {
     auto *File = MapEntry.first;
@@ -778,6 +910,28 @@ bool GlobalModuleIndexBuilder::writeIndex(llvm::BitstreamWriter &Stream) {
     Stream.EmitRecord(MODULE, Record);
   }
 
+  // Write the name filters of the module files.
+  {
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(MODULE_NAME_FILTER));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::VBR, 6));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, 8));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+    unsigned FilterAbbrev = Stream.EmitAbbrev(std::move(Abbrev));
+
+    SmallVector<char, 1024> Filter;
+    for (ModuleFilesMap::iterator M = ModuleFiles.begin(),
+                                  MEnd = ModuleFiles.end();
+         M != MEnd; ++M) {
+      if (!computeNameFilter(M->second, Filter))
+        continue;
+      uint64_t Record[] = {MODULE_NAME_FILTER, M->second.ID,
+                           NumNameFilterHashes};
+      Stream.EmitRecordWithBlob(FilterAbbrev, Record,
+                                StringRef(Filter.data(), Filter.size()));
+    }
+  }
+
   // Write the identifier -> module file mapping.
   {
     llvm::OnDiskChainedHashTableGenerator<IdentifierIndexWriterTrait> Generator;
@@ -149,6 +149,13 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
     NewModule->Buffer = &PCMCache->addBuffer(FileName, std::move(Buffer));
   } else if (llvm::MemoryBuffer *Buffer = PCMCache->lookupBuffer(FileName)) {
     NewModule->Buffer = Buffer;
+  } else if (llvm::MemoryBuffer *Buffer =
+                 Entry ? PCMCache->addSharedBuffer(
+                             FileName, Entry->getSize(),
+                             Entry->getModificationTime())
+                       : nullptr) {
+    // Another compiler instance of this process already read the file.
+    NewModule->Buffer = Buffer;
   } else {
     // Open the AST file.
     llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buf((std::error_code()));
@@ -170,6 +177,9 @@ ModuleManager::addModule(StringRef FileName, ModuleKind Type,
     }
 
     NewModule->Buffer = &PCMCache->addBuffer(FileName, std::move(*Buf));
+    if (Entry)
+      PCMCache->shareBuffer(FileName, Entry->getSize(),
+                            Entry->getModificationTime());
   }
 
   // Initialize the stream.
@@ -214,6 +214,14 @@ public:
 
   /// \brief Find and read the lookup results for \p EKey.
   data_type find(const external_key_type &EKey) {
+    return find(EKey, [](file_type) { return true; });
+  }
+
+  /// \brief Find and read the lookup results for \p EKey, only searching
+  /// the on-disk tables of the files for which \p ShouldSearchFile returns
+  /// true.
+  template <typename FilterFn>
+  data_type find(const external_key_type &EKey, FilterFn ShouldSearchFile) {
     data_type Result;
 
     if (!PendingOverrides.empty())
@@ -234,6 +242,8 @@ public:
     data_type_builder ResultBuilder(Result);
 
     for (auto *ODT : tables()) {
+      if (!ShouldSearchFile(ODT->File))
+        continue;
       auto &HT = ODT->Table;
       auto It = HT.find_hashed(Key, KeyHash);
       if (It != HT.end())
@@ -41,7 +41,9 @@ bool BuiltinFunctionChecker::evalCall(const CallExpr *CE,
   default:
     return false;
 
-  case Builtin::BI__builtin_assume: {
+  case Builtin::BI__builtin_assume:
+  // A failed _Dynamic_check stops the program, so it need not be explored.
+  case Builtin::BI_Dynamic_check: {
     assert (CE->arg_begin() != CE->arg_end());
     SVal ArgSVal = state->getSVal(CE->getArg(0), LCtx);
     if (ArgSVal.isUndef())
@@ -0,0 +1,217 @@
+//== CheckedCDynamicChecksChecker.cpp - Model Checked C checks --*- C++ -*--==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This defines CheckedCDynamicChecksChecker, which models the dynamic bounds
+// checks that Checked C inserts for memory accesses through checked pointers
+// and for dynamic_bounds_cast. A failed check stops the program, so the paths
+// on which a check fails are sinks, and the paths past a check are
+// constrained to the pointer being in bounds.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ClangSACheckers.h"
+#include "clang/AST/Expr.h"
+#include "clang/StaticAnalyzer/Core/Checker.h"
+#include "clang/StaticAnalyzer/Core/CheckerManager.h"
+#include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+
+using namespace clang;
+using namespace ento;
+
+namespace {
+class CheckedCDynamicChecksChecker
+    : public Checker<check::PostStmt<UnaryOperator>,
+                     check::PostStmt<ArraySubscriptExpr>,
+                     check::PostStmt<MemberExpr>,
+                     check::PostStmt<CastExpr>> {
+  void checkBounds(SVal Ptr, const BoundsExpr *Bounds, BoundsCheckKind Kind,
+                   CheckerContext &C) const;
+
+public:
+  void checkPostStmt(const UnaryOperator *UO, CheckerContext &C) const;
+  void checkPostStmt(const ArraySubscriptExpr *ASE, CheckerContext &C) const;
+  void checkPostStmt(const MemberExpr *ME, CheckerContext &C) const;
+  void checkPostStmt(const CastExpr *CE, CheckerContext &C) const;
+};
+} // end anonymous namespace
+
+/// Compute the value of \p E, an operand of a bounds expression. The program
+/// does not evaluate the bounds expressions, so their values are computed
+/// from the store, as of the check that uses them.
+static SVal getBoundsOperandVal(const Expr *E, CheckerContext &C) {
+  E = E->IgnoreParens();
+  ProgramStateRef State = C.getState();
+  SValBuilder &SVB = C.getSValBuilder();
+
+  if (Optional<SVal> V = SVB.getConstantVal(E))
+    return *V;
+
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(E)) {
+    if (const auto *VD = dyn_cast<VarDecl>(DRE->getDecl()))
+      return State->getLValue(VD, C.getLocationContext());
+    return UnknownVal();
+  }
+
+  if (const auto *CE = dyn_cast<CastExpr>(E)) {
+    SVal V = getBoundsOperandVal(CE->getSubExpr(), C);
+    if (V.isUnknownOrUndef())
+      return UnknownVal();
+    if (CE->getCastKind() == CK_LValueToRValue) {
+      if (Optional<Loc> L = V.getAs<Loc>())
+        return State->getSVal(*L, CE->getType());
+      return UnknownVal();
+    }
+    return SVB.evalCast(V, CE->getType(), CE->getSubExpr()->getType());
+  }
+
+  if (const auto *BO = dyn_cast<BinaryOperator>(E)) {
+    if (!BO->isAdditiveOp() && !BO->isMultiplicativeOp())
+      return UnknownVal();
+    SVal LHS = getBoundsOperandVal(BO->getLHS(), C);
+    SVal RHS = getBoundsOperandVal(BO->getRHS(), C);
+    if (LHS.isUnknownOrUndef() || RHS.isUnknownOrUndef())
+      return UnknownVal();
+    return SVB.evalBinOp(State, BO->getOpcode(), LHS, RHS, BO->getType());
+  }
+
+  if (const auto *UO = dyn_cast<UnaryOperator>(E)) {
+    // The value of a pointer is the location of what it points to, and
+    // the other way around.
+    if (UO->getOpcode() == UO_Deref || UO->getOpcode() == UO_AddrOf)
+      return getBoundsOperandVal(UO->getSubExpr(), C);
+    return UnknownVal();
+  }
+
+  if (const auto *ME = dyn_cast<MemberExpr>(E)) {
+    const auto *FD = dyn_cast<FieldDecl>(ME->getMemberDecl());
+    SVal Base = getBoundsOperandVal(ME->getBase(), C);
+    if (!FD || Base.isUnknownOrUndef())
+      return UnknownVal();
+    return State->getLValue(FD, Base);
+  }
+
+  return UnknownVal();
+}
+
+/// Assume that \p Cond holds, if it is known.
+static ProgramStateRef assumeHolds(ProgramStateRef State, SVal Cond) {
+  if (!State)
+    return nullptr;
+  if (Optional<DefinedOrUnknownSVal> DV = Cond.getAs<DefinedOrUnknownSVal>())
+    return State->assume(*DV, true);
+  return State;
+}
+
+/// Assume that \p LHS is less than \p RHS (or equal to it, if \p OrEqual).
+static ProgramStateRef assumeLess(ProgramStateRef State, SVal LHS, SVal RHS,
+                                  bool OrEqual, CheckerContext &C) {
+  if (!State || LHS.isUnknownOrUndef() || RHS.isUnknownOrUndef())
+    return State;
+  SVal Cond = C.getSValBuilder().evalBinOp(State, OrEqual ? BO_LE : BO_LT,
+                                           LHS, RHS,
+                                           C.getASTContext().IntTy);
+  return assumeHolds(State, Cond);
+}
+
+void CheckedCDynamicChecksChecker::checkBounds(SVal Ptr,
+                                               const BoundsExpr *Bounds,
+                                               BoundsCheckKind Kind,
+                                               CheckerContext &C) const {
+  // Checks are only emitted for bounds that are ranges. Bounds that are
+  // any, unknown or invalid are not checked at runtime.
+  const auto *Range = dyn_cast_or_null<RangeBoundsExpr>(Bounds);
+  if (!Range || Kind == BCK_None || Ptr.isUnknownOrUndef())
+    return;
+
+  SVal Lower = getBoundsOperandVal(Range->getLowerExpr(), C);
+  SVal Upper = getBoundsOperandVal(Range->getUpperExpr(), C);
+
+  // Null-terminated pointers may be read at their upper bound, and written
+  // there if the value written is a nul, which is checked with the
+  // assignment.
+  ProgramStateRef State = C.getState();
+  State = assumeLess(State, Lower, Ptr, /*OrEqual=*/true, C);
+  State = assumeLess(State, Ptr, Upper, /*OrEqual=*/Kind != BCK_Normal, C);
+  if (!State) {
+    C.generateSink(C.getState(), C.getPredecessor());
+    return;
+  }
+  C.addTransition(State);
+}
+
+void CheckedCDynamicChecksChecker::checkPostStmt(const UnaryOperator *UO,
+                                                 CheckerContext &C) const {
+  if (UO->getOpcode() != UO_Deref || !UO->hasBoundsExpr())
+    return;
+  checkBounds(C.getSVal(UO), UO->getBoundsExpr(C.getASTContext()),
+              UO->getBoundsCheckKind(), C);
+}
+
+void CheckedCDynamicChecksChecker::checkPostStmt(const ArraySubscriptExpr *ASE,
+                                                 CheckerContext &C) const {
+  if (!ASE->hasBoundsExpr())
+    return;
+  checkBounds(C.getSVal(ASE), ASE->getBoundsExpr(C.getASTContext()),
+              ASE->getBoundsCheckKind(), C);
+}
+
+void CheckedCDynamicChecksChecker::checkPostStmt(const MemberExpr *ME,
+                                                 CheckerContext &C) const {
+  // The base pointer of a member access is checked, as the members of the
+  // object it points to are entirely in bounds if it is.
+  if (!ME->isArrow() || !ME->hasBoundsExpr())
+    return;
+  checkBounds(C.getSVal(ME->getBase()), ME->getBoundsExpr(C.getASTContext()),
+              ME->isBoundsCheckProven() ? BCK_None : BCK_Normal, C);
+}
+
+void CheckedCDynamicChecksChecker::checkPostStmt(const CastExpr *CE,
+                                                 CheckerContext &C) const {
+  // dynamic_bounds_cast checks that its operand is null, or that the bounds
+  // of the operand contain the bounds of the cast.
+  const auto *BCE = dyn_cast<BoundsCastExpr>(CE);
+  if (!BCE || BCE->getCastKind() != CK_DynamicPtrBounds)
+    return;
+  const auto *CastRange =
+      dyn_cast_or_null<RangeBoundsExpr>(BCE->getNormalizedBoundsExpr());
+  const auto *SubRange =
+      dyn_cast_or_null<RangeBoundsExpr>(BCE->getSubExprBoundsExpr());
+  if (!CastRange || !SubRange)
+    return;
+
+  Optional<DefinedOrUnknownSVal> Ptr =
+      C.getSVal(BCE).getAs<DefinedOrUnknownSVal>();
+  if (!Ptr)
+    return;
+  ProgramStateRef NonNull, Null;
+  std::tie(NonNull, Null) = C.getState()->assume(*Ptr);
+  if (!NonNull)
+    return;
+
+  SVal Lower = getBoundsOperandVal(SubRange->getLowerExpr(), C);
+  SVal Upper = getBoundsOperandVal(SubRange->getUpperExpr(), C);
+  SVal CastLower = getBoundsOperandVal(CastRange->getLowerExpr(), C);
+  SVal CastUpper = getBoundsOperandVal(CastRange->getUpperExpr(), C);
+  ProgramStateRef Passes = NonNull;
+  Passes = assumeLess(Passes, Lower, CastLower, /*OrEqual=*/true, C);
+  Passes = assumeLess(Passes, CastUpper, Upper, /*OrEqual=*/true, C);
+
+  // A null operand passes the check whatever the bounds are, and the
+  // constraints on both cases cannot be kept at once.
+  if (!Passes && !Null)
+    C.generateSink(C.getState(), C.getPredecessor());
+  else if (!Passes)
+    C.addTransition(Null);
+  else if (!Null)
+    C.addTransition(Passes);
+}
+
+void ento::registerCheckedCDynamicChecksChecker(CheckerManager &mgr) {
+  mgr.registerChecker<CheckedCDynamicChecksChecker>();
+}
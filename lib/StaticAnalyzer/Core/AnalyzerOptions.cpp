@@ -324,6 +324,13 @@ unsigned AnalyzerOptions::getGraphTrimInterval() {
   return GraphTrimInterval.getValue();
 }
 
+bool AnalyzerOptions::shouldTrimGraphAggressively() {
+  if (!GraphTrimAggressive.hasValue())
+    GraphTrimAggressive =
+        getBooleanOption("graph-trim-aggressive", /*Default=*/false);
+  return GraphTrimAggressive.getValue();
+}
+
 unsigned AnalyzerOptions::getMaxTimesInlineLarge() {
   if (!MaxTimesInlineLarge.hasValue())
     MaxTimesInlineLarge = getOptionAsInteger("max-times-inline-large", 32);
@@ -356,6 +363,14 @@ unsigned AnalyzerOptions::getMaxNodesPerTopLevelFunction() {
   return MaxNodesPerTopLevelFunction.getValue();
 }
 
+unsigned AnalyzerOptions::getNumAnalysisJobs() {
+  if (!NumAnalysisJobs.hasValue()) {
+    int Jobs = getOptionAsInteger("jobs", 1);
+    NumAnalysisJobs = Jobs > 1 ? Jobs : 1;
+  }
+  return NumAnalysisJobs.getValue();
+}
+
 bool AnalyzerOptions::shouldSynthesizeBodies() {
   return getBooleanOption("faux-bodies", true);
 }
@@ -386,6 +401,18 @@ bool AnalyzerOptions::shouldUnrollLoops() {
   return UnrollLoops.getValue();
 }
 
+bool AnalyzerOptions::shouldMergeStates() {
+  if (!MergeStates.hasValue())
+    MergeStates = getBooleanOption("merge-states", /*Default=*/false);
+  return MergeStates.getValue();
+}
+
+bool AnalyzerOptions::shouldUseCallSummaries() {
+  if (!UseCallSummaries.hasValue())
+    UseCallSummaries = getBooleanOption("call-summaries", /*Default=*/false);
+  return UseCallSummaries.getValue();
+}
+
 bool AnalyzerOptions::shouldDisplayNotesAsEvents() {
   if (!DisplayNotesAsEvents.hasValue())
     DisplayNotesAsEvents =
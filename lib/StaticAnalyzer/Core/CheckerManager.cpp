@@ -17,10 +17,47 @@
 #include "clang/StaticAnalyzer/Core/Checker.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CallEvent.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/CheckerContext.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 
 using namespace clang;
 using namespace ento;
 
+namespace {
+/// Adds the time and the memory used while it is alive, and the nodes added
+/// to the graph, to the statistics of a checker callback, if they are
+/// collected.
+class CheckerStatsScope {
+  CheckerManager::CheckerCallbackStats *Stats;
+  const ExplodedGraph *G;
+  unsigned NumNodes;
+  llvm::TimeRecord Start;
+
+public:
+  CheckerStatsScope(CheckerManager &Mgr, const CheckerBase *Checker,
+                    StringRef Callback, unsigned Calls = 1,
+                    const ExplodedGraph *G = nullptr)
+      : Stats(Mgr.getCheckerStats(Checker, Callback)), G(G) {
+    if (!Stats)
+      return;
+    Stats->Calls += Calls;
+    NumNodes = G ? G->size() : 0;
+    Start = llvm::TimeRecord::getCurrentTime(/*Start=*/true);
+  }
+
+  ~CheckerStatsScope() {
+    if (!Stats)
+      return;
+    llvm::TimeRecord Time = llvm::TimeRecord::getCurrentTime(/*Start=*/false);
+    Time -= Start;
+    Stats->Time += Time;
+    if (G && G->size() > NumNodes)
+      Stats->Nodes += G->size() - NumNodes;
+  }
+};
+} // end anonymous namespace
+
 bool CheckerManager::hasPathSensitiveCheckers() const {
   return !StmtCheckers.empty()              ||
          !PreObjCMessageCheckers.empty()    ||
@@ -74,16 +111,20 @@ void CheckerManager::runCheckersOnASTDecl(const Decl *D, AnalysisManager& mgr,
 
   assert(checkers);
   for (CachedDeclCheckers::iterator
-         I = checkers->begin(), E = checkers->end(); I != E; ++I)
+         I = checkers->begin(), E = checkers->end(); I != E; ++I) {
+    CheckerStatsScope Stats(*this, I->Checker, "ASTDecl");
     (*I)(D, mgr, BR);
+  }
 }
 
 void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
                                           BugReporter &BR) {
   assert(D && D->hasBody());
 
-  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i)
+  for (unsigned i = 0, e = BodyCheckers.size(); i != e; ++i) {
+    CheckerStatsScope Stats(*this, BodyCheckers[i].Checker, "ASTCodeBody");
     BodyCheckers[i](D, mgr, BR);
+  }
 }
 
 //===----------------------------------------------------------------------===//
@@ -93,7 +134,8 @@ void CheckerManager::runCheckersOnASTBody(const Decl *D, AnalysisManager& mgr,
 template <typename CHECK_CTX>
 static void expandGraphWithCheckers(CHECK_CTX checkCtx,
                                     ExplodedNodeSet &Dst,
-                                    const ExplodedNodeSet &Src) {
+                                    const ExplodedNodeSet &Src,
+                                    StringRef Callback) {
   const NodeBuilderContext &BldrCtx = checkCtx.Eng.getBuilderContext();
   if (Src.empty())
     return;
@@ -118,6 +160,9 @@ static void expandGraphWithCheckers(CHECK_CTX checkCtx,
     }
 
     NodeBuilder B(*PrevSet, *CurrSet, BldrCtx);
+    CheckerStatsScope Stats(checkCtx.Eng.getCheckerManager(), I->Checker,
+                            Callback, PrevSet->size(),
+                            &checkCtx.Eng.getGraph());
     for (ExplodedNodeSet::iterator NI = PrevSet->begin(), NE = PrevSet->end();
          NI != NE; ++NI) {
       checkCtx.runChecker(*I, B, *NI);
@@ -171,7 +216,7 @@ void CheckerManager::runCheckersForStmt(bool isPreVisit,
                                         bool WasInlined) {
   CheckStmtContext C(isPreVisit, getCachedStmtCheckersFor(S, isPreVisit),
                      S, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, isPreVisit ? "PreStmt" : "PostStmt");
 }
 
 namespace {
@@ -226,7 +271,19 @@ void CheckerManager::runCheckersForObjCMessage(ObjCMessageVisitKind visitKind,
                                                bool WasInlined) {
   auto &checkers = getObjCMessageCheckers(visitKind);
   CheckObjCMessageContext C(visitKind, checkers, msg, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  StringRef Callback;
+  switch (visitKind) {
+  case ObjCMessageVisitKind::Pre:
+    Callback = "PreObjCMessage";
+    break;
+  case ObjCMessageVisitKind::Post:
+    Callback = "PostObjCMessage";
+    break;
+  case ObjCMessageVisitKind::MessageNil:
+    Callback = "ObjCMessageNil";
+    break;
+  }
+  expandGraphWithCheckers(C, Dst, Src, Callback);
 }
 
 const std::vector<CheckerManager::CheckObjCMessageFunc> &
@@ -282,7 +339,7 @@ void CheckerManager::runCheckersForCallEvent(bool isPreVisit,
                      isPreVisit ? PreCallCheckers
                                 : PostCallCheckers,
                      Call, Eng, WasInlined);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, isPreVisit ? "PreCall" : "PostCall");
 }
 
 namespace {
@@ -329,7 +386,7 @@ void CheckerManager::runCheckersForLocation(ExplodedNodeSet &Dst,
                                             ExprEngine &Eng) {
   CheckLocationContext C(LocationCheckers, location, isLoad, NodeEx,
                          BoundEx, Eng);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, "Location");
 }
 
 namespace {
@@ -367,7 +424,7 @@ void CheckerManager::runCheckersForBind(ExplodedNodeSet &Dst,
                                         const Stmt *S, ExprEngine &Eng,
                                         const ProgramPoint &PP) {
   CheckBindContext C(BindCheckers, location, val, S, Eng, PP);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, "Bind");
 }
 
 void CheckerManager::runCheckersForEndAnalysis(ExplodedGraph &G,
@@ -408,7 +465,7 @@ void CheckerManager::runCheckersForBeginFunction(ExplodedNodeSet &Dst,
   ExplodedNodeSet Src;
   Src.insert(Pred);
   CheckBeginFunctionContext C(BeginFunctionCheckers, Eng, L);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, "BeginFunction");
 }
 
 /// \brief Run checkers for end of path.
@@ -429,6 +486,8 @@ void CheckerManager::runCheckersForEndFunction(NodeBuilderContext &BC,
     const ProgramPoint &L = BlockEntrance(BC.Block,
                                           Pred->getLocationContext(),
                                           checkFn.Checker);
+    CheckerStatsScope Stats(*this, checkFn.Checker, "EndFunction", 1,
+                            &Eng.getGraph());
     CheckerContext C(Bldr, Eng, Pred, L);
     checkFn(C);
   }
@@ -466,7 +525,7 @@ void CheckerManager::runCheckersForBranchCondition(const Stmt *Condition,
   ExplodedNodeSet Src;
   Src.insert(Pred);
   CheckBranchConditionContext C(BranchConditionCheckers, Condition, Eng);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, "BranchCondition");
 }
 
 /// \brief Run checkers for live symbols.
@@ -515,7 +574,7 @@ void CheckerManager::runCheckersForDeadSymbols(ExplodedNodeSet &Dst,
                                                ExprEngine &Eng,
                                                ProgramPoint::Kind K) {
   CheckDeadSymbolsContext C(DeadSymbolsCheckers, SymReaper, S, Eng, K);
-  expandGraphWithCheckers(C, Dst, Src);
+  expandGraphWithCheckers(C, Dst, Src, "DeadSymbols");
 }
 
 /// \brief Run checkers for region changes.
@@ -568,6 +627,8 @@ CheckerManager::runCheckersForEvalAssume(ProgramStateRef state,
     // bail out.
     if (!state)
       return nullptr;
+    CheckerStatsScope Stats(*this, EvalAssumeCheckers[i].Checker,
+                            "EvalAssume");
     state = EvalAssumeCheckers[i](state, Cond, Assumption);
   }
   return state;
@@ -599,6 +660,8 @@ void CheckerManager::runCheckersForEvalCall(ExplodedNodeSet &Dst,
       { // CheckerContext generates transitions(populates checkDest) on
         // destruction, so introduce the scope to make sure it gets properly
         // populated.
+        CheckerStatsScope Stats(*this, EI->Checker, "EvalCall", 1,
+                                &Eng.getGraph());
         CheckerContext C(B, Eng, Pred, L);
         evaluated = (*EI)(CE, C);
       }
@@ -638,6 +701,41 @@ void CheckerManager::runCheckersForPrintState(raw_ostream &Out,
     I->second->printState(Out, State, NL, Sep);
 }
 
+void CheckerManager::printCheckerStats(raw_ostream &Out) const {
+  typedef std::pair<std::pair<std::string, StringRef>,
+                    const CheckerCallbackStats *> Entry;
+  std::vector<Entry> Entries;
+  for (const auto &I : CheckerStats) {
+    const CheckerBase *Checker = I.first.first;
+    StringRef Name = Checker->getCheckName().getName();
+    if (Name.empty())
+      Name = Checker->getTagDescription();
+    Entries.push_back(
+        Entry(std::make_pair(Name.str(), I.first.second), &I.second));
+  }
+  std::sort(Entries.begin(), Entries.end(),
+            [](const Entry &LHS, const Entry &RHS) {
+              return LHS.first < RHS.first;
+            });
+
+  Out << "{\n  \"checkers\": [";
+  const char *Sep = "\n";
+  for (const Entry &E : Entries) {
+    const CheckerCallbackStats &Stats = *E.second;
+    Out << Sep << "    { \"checker\": \"";
+    Out.write_escaped(E.first.first);
+    Out << "\", \"callback\": \"" << E.first.second << "\", \"calls\": "
+        << Stats.Calls << ", \"nodes\": " << Stats.Nodes
+        << ", \"wall_time\": "
+        << llvm::format("%.6f", Stats.Time.getWallTime())
+        << ", \"process_time\": "
+        << llvm::format("%.6f", Stats.Time.getProcessTime())
+        << ", \"mem_used\": " << Stats.Time.getMemUsed() << " }";
+    Sep = ",\n";
+  }
+  Out << "\n  ]\n}\n";
+}
+
 //===----------------------------------------------------------------------===//
 // Internal registration functions for AST traversing.
 //===----------------------------------------------------------------------===//
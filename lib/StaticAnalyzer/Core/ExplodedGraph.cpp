@@ -46,7 +46,7 @@ void ExplodedNode::SetAuditor(ExplodedNode::Auditor* A) {
 //===----------------------------------------------------------------------===//
 
 ExplodedGraph::ExplodedGraph()
-  : NumNodes(0), ReclaimNodeInterval(0) {}
+  : NumNodes(0), ReclaimNodeInterval(0), ReclaimablePurgeTag(nullptr) {}
 
 ExplodedGraph::~ExplodedGraph() {}
 
@@ -76,7 +76,8 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // are used only for intermediate processing, and are not essential
   // for analyzer history:
   //
-  // (a) PreStmtPurgeDeadSymbols
+  // (a) PreStmtPurgeDeadSymbols, if it has no tag or the tag it was enabled
+  //     for
   //
   // We then discard all other nodes where *all* of the following conditions
   // apply:
@@ -109,7 +110,8 @@ bool ExplodedGraph::shouldCollect(const ExplodedNode *node) {
   // analysis history and are not consulted by any client code.
   ProgramPoint progPoint = node->getLocation();
   if (progPoint.getAs<PreStmtPurgeDeadSymbols>())
-    return !progPoint.getTag();
+    return !progPoint.getTag() ||
+           (ReclaimablePurgeTag && progPoint.getTag() == ReclaimablePurgeTag);
 
   // Condition 3.
   if (!progPoint.getAs<PostStmt>() || progPoint.getAs<PostStore>())
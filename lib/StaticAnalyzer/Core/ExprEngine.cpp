@@ -91,7 +91,10 @@ ExprEngine::ExprEngine(AnalysisManager &mgr, bool gcEnabled,
   unsigned TrimInterval = mgr.options.getGraphTrimInterval();
   if (TrimInterval != 0) {
     // Enable eager node reclaimation when constructing the ExplodedGraph.
-    G.enableNodeReclamation(TrimInterval);
+    G.enableNodeReclamation(TrimInterval,
+                            mgr.options.shouldTrimGraphAggressively()
+                                ? getCleanupNodeTag()
+                                : nullptr);
   }
 }
 
@@ -437,14 +440,13 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
   CleanedState = StateMgr.removeDeadBindings(CleanedState, SFC, SymReaper);
 
   // Process any special transfer function for dead symbols.
-  // A tag to track convenience transitions, which can be removed at cleanup.
-  static SimpleProgramPointTag cleanupTag(TagProviderName, "Clean Node");
+  const ProgramPointTag *cleanupTag = getCleanupNodeTag();
   if (!SymReaper.hasDeadSymbols()) {
     // Generate a CleanedNode that has the environment and store cleaned
     // up. Since no symbols are dead, we can optimize and not clean out
     // the constraint manager.
     StmtNodeBuilder Bldr(Pred, Out, *currBldrCtx);
-    Bldr.generateNode(DiagnosticStmt, Pred, CleanedState, &cleanupTag, K);
+    Bldr.generateNode(DiagnosticStmt, Pred, CleanedState, cleanupTag, K);
 
   } else {
     // Call checkers with the non-cleaned state so that they could query the
@@ -476,7 +478,7 @@ void ExprEngine::removeDead(ExplodedNode *Pred, ExplodedNodeSet &Out,
       // generate a transition to that state.
       ProgramStateRef CleanedCheckerSt =
         StateMgr.getPersistentStateWithGDM(CleanedState, CheckerState);
-      Bldr.generateNode(DiagnosticStmt, *I, CleanedCheckerSt, &cleanupTag, K);
+      Bldr.generateNode(DiagnosticStmt, *I, CleanedCheckerSt, cleanupTag, K);
     }
   }
 }
@@ -1486,14 +1488,13 @@ void ExprEngine::Visit(const Stmt *S, ExplodedNode *Pred,
       Bldr.addNodes(Dst);
       break;
     }
-    // The static analyzer knows nothing about Checked C extensions to
-    // the AST, so we should never see these.
+    // Checked C bounds expressions have no value of their own; the checks
+    // that use them are modeled by the CheckedCDynamicChecks checker.
     case Stmt::PositionalParameterExprClass:
     case Stmt::CountBoundsExprClass:
     case Stmt::InteropTypeExprClass:
     case Stmt::NullaryBoundsExprClass:
     case Stmt::RangeBoundsExprClass:
-      llvm_unreachable("Do not expect to see Checked C extensions");
       break;
   }
 }
@@ -1566,6 +1567,27 @@ void ExprEngine::processCFGBlockEntrance(const BlockEdge &L,
                                          NodeBuilderWithSinks &nodeBuilder,
                                          ExplodedNode *Pred) {
   PrettyStackTraceLocationContext CrashInfo(Pred->getLocationContext());
+  // If we reach a block with several predecessors, merge this path into the
+  // paths reaching it before, if their states only differ in constraints.
+  // The path is dropped if the constraints it adds are already covered.
+  const CFGBlock *Block = nodeBuilder.getContext().getBlock();
+  if (Block->pred_size() > 1 && AMgr.options.shouldMergeStates()) {
+    ProgramStateRef &Joined =
+        JoinedStates[std::make_pair(Block, Pred->getLocationContext())];
+    ProgramStateRef State = Pred->getState();
+    if (Joined)
+      if (ProgramStateRef JoinedState =
+              getConstraintManager().joinStates(Joined, State))
+        State = JoinedState;
+    Joined = State;
+    if (State != Pred->getState()) {
+      ExplodedNode *JoinedNode = nodeBuilder.generateNode(State, Pred);
+      if (!JoinedNode)
+        return;
+      Pred = JoinedNode;
+    }
+  }
+
   // If we reach a loop which has a known bound (and meets
   // other constraints) then consider completely unrolling it.
   if(AMgr.options.shouldUnrollLoops()) {
@@ -2576,6 +2598,12 @@ void ExprEngine::evalLocation(ExplodedNodeSet &Dst,
   BldrTop.addNodes(Tmp);
 }
 
+const ProgramPointTag *ExprEngine::getCleanupNodeTag() {
+  // A tag to track convenience transitions, which can be removed at cleanup.
+  static SimpleProgramPointTag cleanupTag(TagProviderName, "Clean Node");
+  return &cleanupTag;
+}
+
 std::pair<const ProgramPointTag *, const ProgramPointTag*>
 ExprEngine::geteagerlyAssumeBinOpBifurcationTags() {
   static SimpleProgramPointTag
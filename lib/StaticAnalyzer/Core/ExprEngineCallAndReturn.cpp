@@ -558,13 +558,67 @@ ProgramStateRef ExprEngine::bindReturnValue(const CallEvent &Call,
   return State->BindExpr(E, LCtx, R);
 }
 
+/// Returns the summary of the body of the function called by \p Call, if
+/// summaries are enabled and the callee is a C function with a body.
+static const FunctionSummariesTy::CallSummary *
+getCallSummary(const CallEvent &Call, FunctionSummariesTy &Summaries,
+               AnalyzerOptions &Opts) {
+  const auto *FC = dyn_cast<SimpleFunctionCall>(&Call);
+  if (!FC)
+    return nullptr;
+  const FunctionDecl *FD = FC->getDecl();
+  const FunctionDecl *Def;
+  if (!FD || !FD->hasBody(Def))
+    return nullptr;
+  const LangOptions &LangOpts = Def->getASTContext().getLangOpts();
+  if (LangOpts.CPlusPlus || LangOpts.ObjC1 || !Opts.shouldUseCallSummaries())
+    return nullptr;
+  return &Summaries.getCallSummary(Def);
+}
+
+/// Assume that \p V is one of \p Values, which are sorted, or leave
+/// \p State as is if it cannot be.
+static ProgramStateRef assumeOneOf(ProgramStateRef State,
+                                   DefinedOrUnknownSVal V,
+                                   ArrayRef<llvm::APSInt> Values,
+                                   QualType Ty, BasicValueFactory &BVF) {
+  APSIntType IntTy = BVF.getAPSIntType(Ty);
+  ProgramStateRef Constrained = State->assumeInclusiveRange(
+      V, BVF.getValue(IntTy.convert(Values.front())),
+      BVF.getValue(IntTy.convert(Values.back())), true);
+
+  // Exclude the values between each pair of consecutive return values.
+  for (unsigned I = 1, E = Values.size(); Constrained && I != E; ++I) {
+    llvm::APSInt From = IntTy.convert(Values[I - 1]);
+    llvm::APSInt To = IntTy.convert(Values[I]);
+    if (++From > --To)
+      continue;
+    Constrained = Constrained->assumeInclusiveRange(V, BVF.getValue(From),
+                                                    BVF.getValue(To), false);
+  }
+  return Constrained ? Constrained : State;
+}
+
 // Conservatively evaluate call by invalidating regions and binding
 // a conjured return value.
 void ExprEngine::conservativeEvalCall(const CallEvent &Call, NodeBuilder &Bldr,
                                       ExplodedNode *Pred,
                                       ProgramStateRef State) {
-  State = Call.invalidateRegions(currBldrCtx->blockCount(), State);
+  // A function without side effects writes nothing that the caller can
+  // read, and a function that only returns constants returns one of them.
+  const FunctionSummariesTy::CallSummary *Summary =
+      getCallSummary(Call, *Engine.FunctionSummaries, AMgr.options);
+  if (!Summary || !Summary->HasNoSideEffects)
+    State = Call.invalidateRegions(currBldrCtx->blockCount(), State);
   State = bindReturnValue(Call, Pred->getLocationContext(), State);
+  if (Summary && !Summary->ReturnValues.empty()) {
+    const Expr *E = Call.getOriginExpr();
+    if (Optional<DefinedOrUnknownSVal> RetVal =
+            State->getSVal(E, Pred->getLocationContext())
+                .getAs<DefinedOrUnknownSVal>())
+      State = assumeOneOf(State, *RetVal, Summary->ReturnValues,
+                          Call.getResultType(), getBasicVals());
+  }
 
   // And make the result node.
   Bldr.generateNode(Call.getProgramPoint(), State, Pred);
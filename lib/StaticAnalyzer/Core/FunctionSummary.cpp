@@ -12,9 +12,148 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Core/PathSensitive/FunctionSummary.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Expr.h"
+#include "clang/AST/Stmt.h"
+#include <algorithm>
 using namespace clang;
 using namespace ento;
 
+/// The largest number of return values that a summary keeps.
+static const unsigned MaxSummaryReturnValues = 8;
+
+/// Returns true if \p E designates memory that only lives as long as the
+/// call: a parameter or a non-static local variable, an element of a local
+/// array, or a member of either.
+static bool isLocalLValue(const Expr *E) {
+  E = E->IgnoreParens();
+  if (const auto *DRE = dyn_cast<DeclRefExpr>(E)) {
+    const auto *VD = dyn_cast<VarDecl>(DRE->getDecl());
+    return VD && VD->hasLocalStorage() && !VD->getType()->isReferenceType();
+  }
+  if (const auto *ME = dyn_cast<MemberExpr>(E))
+    return !ME->isArrow() && isLocalLValue(ME->getBase());
+  if (const auto *ASE = dyn_cast<ArraySubscriptExpr>(E)) {
+    const Expr *Base = ASE->getBase()->IgnoreParenImpCasts();
+    return Base->getType()->isArrayType() && isLocalLValue(Base);
+  }
+  return false;
+}
+
+namespace {
+/// Walks the body of a C function to find out whether it writes memory that
+/// outlives the call, and which values it returns.
+class CallSummaryBuilder {
+  FunctionSummariesTy &Summaries;
+  ASTContext &Ctx;
+
+public:
+  bool HasNoSideEffects = true;
+
+  /// The values of the return statements, or None if one of them is not a
+  /// constant.
+  Optional<SmallVector<llvm::APSInt, 4>> Returns;
+
+  CallSummaryBuilder(FunctionSummariesTy &Summaries, ASTContext &Ctx)
+      : Summaries(Summaries), Ctx(Ctx) {}
+
+  void visit(const Stmt *S);
+};
+} // end anonymous namespace
+
+void CallSummaryBuilder::visit(const Stmt *S) {
+  switch (S->getStmtClass()) {
+  case Stmt::CallExprClass: {
+    const FunctionDecl *Callee = cast<CallExpr>(S)->getDirectCallee();
+    const FunctionDecl *Def;
+    if (!Callee || !Callee->hasBody(Def) ||
+        !Summaries.getCallSummary(Def).HasNoSideEffects)
+      HasNoSideEffects = false;
+    break;
+  }
+  case Stmt::BinaryOperatorClass:
+  case Stmt::CompoundAssignOperatorClass: {
+    const auto *BO = cast<BinaryOperator>(S);
+    if (BO->isAssignmentOp() && !isLocalLValue(BO->getLHS()))
+      HasNoSideEffects = false;
+    break;
+  }
+  case Stmt::UnaryOperatorClass: {
+    const auto *UO = cast<UnaryOperator>(S);
+    if (UO->isIncrementDecrementOp() && !isLocalLValue(UO->getSubExpr()))
+      HasNoSideEffects = false;
+    break;
+  }
+  case Stmt::DeclStmtClass:
+    for (const Decl *D : cast<DeclStmt>(S)->decls())
+      if (const auto *VD = dyn_cast<VarDecl>(D))
+        if (VD->isStaticLocal())
+          HasNoSideEffects = false;
+    break;
+  case Stmt::ReturnStmtClass:
+    if (Returns) {
+      const Expr *RV = cast<ReturnStmt>(S)->getRetValue();
+      llvm::APSInt Value;
+      if (RV && RV->EvaluateAsInt(Value, Ctx))
+        Returns->push_back(Value);
+      else
+        Returns.reset();
+    }
+    break;
+  // The statements that may write memory without an assignment, or leave
+  // the function other than by returning.
+  case Stmt::AtomicExprClass:
+  case Stmt::BlockExprClass:
+  case Stmt::GCCAsmStmtClass:
+  case Stmt::IndirectGotoStmtClass:
+  case Stmt::MSAsmStmtClass:
+  case Stmt::PseudoObjectExprClass:
+  case Stmt::VAArgExprClass:
+    HasNoSideEffects = false;
+    break;
+  default:
+    if (isa<CallExpr>(S))
+      HasNoSideEffects = false;
+    break;
+  }
+
+  for (const Stmt *Child : S->children())
+    if (Child)
+      visit(Child);
+}
+
+const FunctionSummariesTy::CallSummary &
+FunctionSummariesTy::getCallSummary(const FunctionDecl *FD) {
+  auto I = CallSummaries.find(FD);
+  if (I != CallSummaries.end())
+    return I->second;
+
+  // Calls made while the summary is computed find this empty summary, so
+  // that recursive functions are taken to have side effects.
+  CallSummaries[FD] = CallSummary();
+
+  CallSummary Summary;
+  QualType RetTy = FD->getReturnType();
+  CallSummaryBuilder Builder(*this, FD->getASTContext());
+  if (RetTy->isIntegralOrEnumerationType())
+    Builder.Returns.emplace();
+  Builder.visit(FD->getBody());
+
+  // A returned pointer may alias the arguments, which the checkers only
+  // learn of from the escape of the arguments when the call invalidates them.
+  Summary.HasNoSideEffects = Builder.HasNoSideEffects &&
+                             (RetTy->isVoidType() || RetTy->isArithmeticType());
+
+  if (Builder.Returns) {
+    SmallVector<llvm::APSInt, 4> &Returns = *Builder.Returns;
+    std::sort(Returns.begin(), Returns.end());
+    Returns.erase(std::unique(Returns.begin(), Returns.end()), Returns.end());
+    if (Returns.size() <= MaxSummaryReturnValues)
+      Summary.ReturnValues = std::move(Returns);
+  }
+  return CallSummaries[FD] = std::move(Summary);
+}
+
 unsigned FunctionSummariesTy::getTotalNumBasicBlocks() {
   unsigned Total = 0;
   for (MapTy::iterator I = Map.begin(), E = Map.end(); I != E; ++I) {
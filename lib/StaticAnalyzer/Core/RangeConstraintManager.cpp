@@ -17,8 +17,11 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramState.h"
 #include "clang/StaticAnalyzer/Core/PathSensitive/ProgramStateTrait.h"
 #include "llvm/ADT/FoldingSet.h"
-#include "llvm/ADT/ImmutableSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <iterator>
 
 using namespace clang;
 using namespace ento;
@@ -48,66 +51,111 @@ public:
   }
 };
 
-class RangeTrait : public llvm::ImutContainerInfo<Range> {
-public:
-  // When comparing if one Range is less than another, we should compare
-  // the actual APSInt values instead of their pointers.  This keeps the order
-  // consistent (instead of comparing by pointer values) and can potentially
-  // be used to speed up some of the operations in RangeSet.
-  static inline bool isLess(key_type_ref lhs, key_type_ref rhs) {
-    return *lhs.first < *rhs.first ||
-           (!(*rhs.first < *lhs.first) && *lhs.second < *rhs.second);
-  }
-};
-
 /// RangeSet contains a set of ranges. If the set is empty, then
 ///  there the value of a symbol is overly constrained and there are no
 ///  possible values for that symbol.
+///
+/// The ranges are kept sorted in a small vector, which is interned by the
+/// factory, so that most sets need a single allocation and equal sets share
+/// the same vector.
 class RangeSet {
-  typedef llvm::ImmutableSet<Range, RangeTrait> PrimRangeSet;
-  PrimRangeSet ranges; // no need to make const, since it is an
-                       // ImmutableSet - this allows default operator=
-                       // to work.
 public:
-  typedef PrimRangeSet::Factory Factory;
-  typedef PrimRangeSet::iterator iterator;
+  /// The sorted, disjoint ranges of a set.
+  typedef llvm::SmallVector<Range, 4> ContainerType;
+  typedef ContainerType::const_iterator iterator;
+
+  /// Factory - Interns the range vectors of the sets. Its sets live as long
+  ///  as it does.
+  class Factory {
+  public:
+    RangeSet getEmptySet() { return RangeSet(&EmptyRanges); }
+
+    /// Returns the set of \p Ranges, which must be sorted and disjoint.
+    RangeSet getRangeSet(ContainerType &&Ranges) {
+      if (Ranges.empty())
+        return getEmptySet();
+
+      llvm::FoldingSetNodeID ID;
+      profile(ID, Ranges);
+      void *InsertPos;
+      if (Node *N = Cache.FindNodeOrInsertPos(ID, InsertPos))
+        return RangeSet(&N->Ranges);
+
+      Node *N = new (Allocator.Allocate()) Node(std::move(Ranges));
+      Cache.InsertNode(N, InsertPos);
+      return RangeSet(&N->Ranges);
+    }
+
+    RangeSet getRangeSet(Range R) {
+      ContainerType Ranges;
+      Ranges.push_back(R);
+      return getRangeSet(std::move(Ranges));
+    }
+
+  private:
+    struct Node : public llvm::FoldingSetNode {
+      explicit Node(ContainerType &&Ranges) : Ranges(std::move(Ranges)) {}
+      void Profile(llvm::FoldingSetNodeID &ID) const { profile(ID, Ranges); }
+
+      ContainerType Ranges;
+    };
+
+    static void profile(llvm::FoldingSetNodeID &ID,
+                        const ContainerType &Ranges) {
+      for (const Range &R : Ranges)
+        R.Profile(ID);
+    }
 
-  RangeSet(PrimRangeSet RS) : ranges(RS) {}
+    ContainerType EmptyRanges;
+    llvm::FoldingSet<Node> Cache;
+    llvm::SpecificBumpPtrAllocator<Node> Allocator;
+  };
 
   /// Create a new set with all ranges of this set and RS.
   /// Possible intersections are not checked here.
   RangeSet addRange(Factory &F, const RangeSet &RS) {
-    PrimRangeSet Ranges(RS.ranges);
-    for (const auto &range : ranges)
-      Ranges = F.add(Ranges, range);
-    return RangeSet(Ranges);
+    ContainerType Ranges;
+    Ranges.reserve(ranges->size() + RS.ranges->size());
+    std::merge(begin(), end(), RS.begin(), RS.end(),
+               std::back_inserter(Ranges), isLess);
+    return F.getRangeSet(std::move(Ranges));
   }
 
-  iterator begin() const { return ranges.begin(); }
-  iterator end() const { return ranges.end(); }
+  iterator begin() const { return ranges->begin(); }
+  iterator end() const { return ranges->end(); }
 
-  bool isEmpty() const { return ranges.isEmpty(); }
+  bool isEmpty() const { return ranges->empty(); }
 
   /// Construct a new RangeSet representing '{ [from, to] }'.
   RangeSet(Factory &F, const llvm::APSInt &from, const llvm::APSInt &to)
-      : ranges(F.add(F.getEmptySet(), Range(from, to))) {}
+      : RangeSet(F.getRangeSet(Range(from, to))) {}
 
   /// Profile - Generates a hash profile of this RangeSet for use
-  ///  by FoldingSet.
-  void Profile(llvm::FoldingSetNodeID &ID) const { ranges.Profile(ID); }
+  ///  by FoldingSet. The vectors are interned, so equal sets have the same
+  ///  one.
+  void Profile(llvm::FoldingSetNodeID &ID) const { ID.AddPointer(ranges); }
 
   /// getConcreteValue - If a symbol is contrained to equal a specific integer
   ///  constant then this method returns that value.  Otherwise, it returns
   ///  NULL.
   const llvm::APSInt *getConcreteValue() const {
-    return ranges.isSingleton() ? ranges.begin()->getConcreteValue() : nullptr;
+    return ranges->size() == 1 ? ranges->front().getConcreteValue() : nullptr;
   }
 
 private:
-  void IntersectInRange(BasicValueFactory &BV, Factory &F,
-                        const llvm::APSInt &Lower, const llvm::APSInt &Upper,
-                        PrimRangeSet &newRanges, PrimRangeSet::iterator &i,
-                        PrimRangeSet::iterator &e) const {
+  explicit RangeSet(const ContainerType *Ranges) : ranges(Ranges) {}
+
+  // When comparing if one Range is less than another, we should compare
+  // the actual APSInt values instead of their pointers.  This keeps the order
+  // consistent (instead of comparing by pointer values).
+  static bool isLess(const Range &lhs, const Range &rhs) {
+    return lhs.From() < rhs.From() ||
+           (!(rhs.From() < lhs.From()) && lhs.To() < rhs.To());
+  }
+
+  void IntersectInRange(BasicValueFactory &BV, const llvm::APSInt &Lower,
+                        const llvm::APSInt &Upper, ContainerType &newRanges,
+                        iterator &i, iterator &e) const {
     // There are six cases for each range R in the set:
     //   1. R is entirely before the intersection range.
     //   2. R is entirely after the intersection range.
@@ -126,24 +174,28 @@ private:
 
       if (i->Includes(Lower)) {
         if (i->Includes(Upper)) {
-          newRanges =
-              F.add(newRanges, Range(BV.getValue(Lower), BV.getValue(Upper)));
+          newRanges.push_back(Range(BV.getValue(Lower), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, Range(BV.getValue(Lower), i->To()));
+          newRanges.push_back(Range(BV.getValue(Lower), i->To()));
       } else {
         if (i->Includes(Upper)) {
-          newRanges = F.add(newRanges, Range(i->From(), BV.getValue(Upper)));
+          newRanges.push_back(Range(i->From(), BV.getValue(Upper)));
           break;
         } else
-          newRanges = F.add(newRanges, *i);
+          newRanges.push_back(*i);
       }
     }
   }
 
   const llvm::APSInt &getMinValue() const {
     assert(!isEmpty());
-    return ranges.begin()->From();
+    return ranges->front().From();
+  }
+
+  const llvm::APSInt &getMaxValue() const {
+    assert(!isEmpty());
+    return ranges->back().To();
   }
 
   bool pin(llvm::APSInt &Lower, llvm::APSInt &Upper) const {
@@ -240,20 +292,50 @@ public:
     if (!pin(Lower, Upper))
       return F.getEmptySet();
 
-    PrimRangeSet newRanges = F.getEmptySet();
+    ContainerType newRanges;
 
-    PrimRangeSet::iterator i = begin(), e = end();
+    iterator i = begin(), e = end();
     if (Lower <= Upper)
-      IntersectInRange(BV, F, Lower, Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, Upper, newRanges, i, e);
     else {
       // The order of the next two statements is important!
       // IntersectInRange() does not reset the iteration state for i and e.
       // Therefore, the lower range most be handled first.
-      IntersectInRange(BV, F, BV.getMinValue(Upper), Upper, newRanges, i, e);
-      IntersectInRange(BV, F, Lower, BV.getMaxValue(Lower), newRanges, i, e);
+      IntersectInRange(BV, BV.getMinValue(Upper), Upper, newRanges, i, e);
+      IntersectInRange(BV, Lower, BV.getMaxValue(Lower), newRanges, i, e);
     }
 
-    return newRanges;
+    // The lower range is handled first, so the ranges are still sorted.
+    return F.getRangeSet(std::move(newRanges));
+  }
+
+  /// Returns true if each range of \p Other is within a range of this set.
+  bool contains(const RangeSet &Other) const {
+    for (const Range &R : Other) {
+      bool Found = false;
+      for (const Range &Mine : *ranges) {
+        if (Mine.Includes(R.From()) && Mine.Includes(R.To())) {
+          Found = true;
+          break;
+        }
+      }
+      if (!Found)
+        return false;
+    }
+    return true;
+  }
+
+  /// Returns a set with a single range, which covers the values of this set
+  /// and of \p Other. The bounds that \p Other extends past are widened to
+  /// the limits of the type, so that repeatedly widening the ranges of a
+  /// symbol that grows on each path, such as a loop counter, terminates.
+  RangeSet widen(BasicValueFactory &BV, Factory &F,
+                 const RangeSet &Other) const {
+    const llvm::APSInt &Min = getMinValue();
+    const llvm::APSInt &Max = getMaxValue();
+    return RangeSet(F,
+                    Other.getMinValue() < Min ? BV.getMinValue(Min) : Min,
+                    Max < Other.getMaxValue() ? BV.getMaxValue(Max) : Max);
   }
 
   void print(raw_ostream &os) const {
@@ -274,6 +356,9 @@ public:
   bool operator==(const RangeSet &other) const {
     return ranges == other.ranges;
   }
+
+private:
+  const ContainerType *ranges;
 };
 } // end anonymous namespace
 
@@ -301,6 +386,9 @@ public:
   ProgramStateRef removeDeadBindings(ProgramStateRef State,
                                      SymbolReaper &SymReaper) override;
 
+  ProgramStateRef joinStates(ProgramStateRef Old,
+                             ProgramStateRef New) override;
+
   void print(ProgramStateRef State, raw_ostream &Out, const char *nl,
              const char *sep) override;
 
@@ -460,6 +548,37 @@ RangeConstraintManager::removeDeadBindings(ProgramStateRef State,
   return Changed ? State->set<ConstraintRange>(CR) : State;
 }
 
+/// The constraints of a symbol are kept if they cover its constraints in
+/// \p New, and are widened to a single range covering both otherwise. The
+/// symbols that are only constrained in one state are unconstrained in the
+/// joined state.
+ProgramStateRef RangeConstraintManager::joinStates(ProgramStateRef Old,
+                                                   ProgramStateRef New) {
+  if (Old == New)
+    return Old;
+  if (Old->remove<ConstraintRange>() != New->remove<ConstraintRange>())
+    return nullptr;
+
+  bool Changed = false;
+  BasicValueFactory &BV = getBasicVals();
+  ConstraintRangeTy CR = Old->get<ConstraintRange>();
+  ConstraintRangeTy::Factory &CRFactory = Old->get_context<ConstraintRange>();
+
+  for (ConstraintRangeTy::iterator I = CR.begin(), E = CR.end(); I != E; ++I) {
+    SymbolRef Sym = I.getKey();
+    const RangeSet *NewRanges = New->get<ConstraintRange>(Sym);
+    if (!NewRanges) {
+      Changed = true;
+      CR = CRFactory.remove(CR, Sym);
+    } else if (!I.getData().contains(*NewRanges)) {
+      Changed = true;
+      CR = CRFactory.add(CR, Sym, I.getData().widen(BV, F, *NewRanges));
+    }
+  }
+
+  return Changed ? Old->set<ConstraintRange>(CR) : Old;
+}
+
 RangeSet RangeConstraintManager::getRange(ProgramStateRef State,
                                           SymbolRef Sym) {
   if (ConstraintRangeTy::data_type *V = State->get<ConstraintRange>(Sym))
@@ -13,6 +13,10 @@
 #include "clang/StaticAnalyzer/Core/PathSensitive/SimpleConstraintManager.h"
 
 #include "clang/Config/config.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/Statistic.h"
 
 using namespace clang;
 using namespace ento;
@@ -21,6 +25,16 @@ using namespace ento;
 
 #include <z3.h>
 
+#define DEBUG_TYPE "Z3ConstraintManager"
+
+STATISTIC(NumZ3Queries, "The # of satisfiability queries sent to Z3");
+STATISTIC(NumZ3QueriesCached,
+          "The # of satisfiability queries answered from the cache");
+STATISTIC(NumZ3ConstraintsPushed,
+          "The # of state constraints asserted in a new solver scope");
+STATISTIC(NumZ3ConstraintsPopped,
+          "The # of state constraints popped from the solver");
+
 // Forward declarations
 namespace {
 class Z3Expr;
@@ -187,6 +201,7 @@ public:
 class Z3Expr {
   friend class Z3Model;
   friend class Z3Solver;
+  friend class Z3ConstraintManager;
 
   Z3_ast AST;
 
@@ -841,25 +856,6 @@ public:
     Z3_solver_assert(Z3Context::ZC, Solver, Exp.AST);
   }
 
-  /// Given a program state, construct the logical conjunction and add it to
-  /// the solver
-  void addStateConstraints(ProgramStateRef State) {
-    // TODO: Don't add all the constraints, only the relevant ones
-    ConstraintZ3Ty CZ = State->get<ConstraintZ3>();
-    ConstraintZ3Ty::iterator I = CZ.begin(), IE = CZ.end();
-
-    // Construct the logical AND of all the constraints
-    if (I != IE) {
-      std::vector<Z3_ast> ASTs;
-
-      while (I != IE)
-        ASTs.push_back(I++->second.AST);
-
-      Z3Expr Conj = Z3Expr::fromNBinOp(BO_LAnd, ASTs);
-      addConstraint(Conj);
-    }
-  }
-
   /// Check if the constraints are satisfiable
   Z3_lbool check() { return Z3_solver_check(Z3Context::ZC, Solver); }
 
@@ -891,6 +887,32 @@ class Z3ConstraintManager : public SimpleConstraintManager {
   Z3Context Context;
   mutable Z3Solver Solver;
 
+  /// The constraints asserted in Solver, each in a solver scope of its own,
+  /// in the order they were asserted.  Successive queries usually come from
+  /// states along a path of the exploded graph, whose constraints only grow,
+  /// so a query pops the scopes of the constraints that its state does not
+  /// have and asserts the ones that are new, instead of starting over.
+  mutable std::vector<std::pair<SymbolRef, Z3Expr>> Asserted;
+  /// The symbols and ASTs of the constraints in Asserted.
+  mutable llvm::DenseSet<std::pair<const void *, const void *>> AssertedKeys;
+
+  /// A satisfiability result, with the constraints and the query that it is
+  /// for.  Holding them keeps the keys of the entry from being reused.
+  struct SatResult {
+    ConstraintZ3Ty Constraints;
+    llvm::Optional<Z3Expr> Query;
+    Z3_lbool Result;
+  };
+
+  /// The results of earlier queries, keyed by the root of the constraint
+  /// set and the AST of the query.  The sets are canonicalized by their
+  /// factory, so the root identifies the constraints.
+  mutable llvm::DenseMap<std::pair<const void *, const void *>, SatResult>
+      SatCache;
+
+  /// The number of results cached before the cache is cleared.
+  static const unsigned MaxSatCacheSize = 1 << 16;
+
 public:
   Z3ConstraintManager(SubEngine *SE, SValBuilder &SB)
       : SimpleConstraintManager(SE, SB),
@@ -942,6 +964,14 @@ private:
   // Generate and check a Z3 model, using the given constraint.
   Z3_lbool checkZ3Model(ProgramStateRef State, const Z3Expr &Exp) const;
 
+  // Make the constraints asserted in the solver the constraints of the
+  // given set, popping and pushing as few as possible.
+  void assertStateConstraints(ConstraintZ3Ty CZ) const;
+
+  // Check whether the constraints of the state, and the query if there is
+  // one, are satisfiable, using the cached result if there is one.
+  Z3_lbool checkSat(ProgramStateRef State, const Z3Expr *Query) const;
+
   // Generate a Z3Expr that represents the given symbolic expression.
   // Sets the hasComparison parameter if the expression has a comparison
   // operator.
@@ -1121,16 +1151,8 @@ ConditionTruthVal Z3ConstraintManager::checkNull(ProgramStateRef State,
   // Negate the constraint
   Z3Expr NotExp = getZ3ZeroExpr(VarExp, RetTy, false);
 
-  Solver.reset();
-  Solver.addStateConstraints(State);
-
-  Solver.push();
-  Solver.addConstraint(Exp);
-  Z3_lbool isSat = Solver.check();
-
-  Solver.pop();
-  Solver.addConstraint(NotExp);
-  Z3_lbool isNotSat = Solver.check();
+  Z3_lbool isSat = checkSat(State, &Exp);
+  Z3_lbool isNotSat = checkSat(State, &NotExp);
 
   // Zero is the only possible solution
   if (isSat == Z3_L_TRUE && isNotSat == Z3_L_FALSE)
@@ -1156,8 +1178,8 @@ const llvm::APSInt *Z3ConstraintManager::getSymVal(ProgramStateRef State,
 
     Z3Expr Exp = getZ3DataExpr(SD->getSymbolID(), Ty);
 
-    Solver.reset();
-    Solver.addStateConstraints(State);
+    // The model needs a check of the solver, so the cache is not used.
+    assertStateConstraints(State->get<ConstraintZ3>());
 
     // Constraints are unsatisfiable
     if (Solver.check() != Z3_L_TRUE)
@@ -1175,8 +1197,7 @@ const llvm::APSInt *Z3ConstraintManager::getSymVal(ProgramStateRef State,
                             : Z3Expr::fromAPSInt(Value),
         false);
 
-    Solver.addConstraint(NotExp);
-    if (Solver.check() == Z3_L_TRUE)
+    if (checkSat(State, &NotExp) == Z3_L_TRUE)
       return nullptr;
 
     // This is the only solution, store it
@@ -1251,10 +1272,62 @@ ProgramStateRef Z3ConstraintManager::assumeZ3Expr(ProgramStateRef State,
 
 Z3_lbool Z3ConstraintManager::checkZ3Model(ProgramStateRef State,
                                            const Z3Expr &Exp) const {
-  Solver.reset();
-  Solver.addConstraint(Exp);
-  Solver.addStateConstraints(State);
-  return Solver.check();
+  return checkSat(State, &Exp);
+}
+
+void Z3ConstraintManager::assertStateConstraints(ConstraintZ3Ty CZ) const {
+  // Keep the longest prefix of the asserted constraints that are all in CZ.
+  unsigned Kept = 0;
+  while (Kept < Asserted.size() && CZ.contains(Asserted[Kept]))
+    ++Kept;
+  if (Kept < Asserted.size()) {
+    Solver.pop(Asserted.size() - Kept);
+    NumZ3ConstraintsPopped += Asserted.size() - Kept;
+    for (unsigned I = Kept, E = Asserted.size(); I != E; ++I)
+      AssertedKeys.erase(
+          std::make_pair(Asserted[I].first, Asserted[I].second.AST));
+    Asserted.erase(Asserted.begin() + Kept, Asserted.end());
+  }
+
+  // Assert the constraints of CZ that are not asserted yet.
+  for (const ConstraintZ3Ty::value_type &C : CZ) {
+    if (!AssertedKeys.insert(std::make_pair(C.first, C.second.AST)).second)
+      continue;
+    Solver.push();
+    Solver.addConstraint(C.second);
+    Asserted.push_back(C);
+    ++NumZ3ConstraintsPushed;
+  }
+}
+
+Z3_lbool Z3ConstraintManager::checkSat(ProgramStateRef State,
+                                       const Z3Expr *Query) const {
+  ConstraintZ3Ty CZ = State->get<ConstraintZ3>();
+  std::pair<const void *, const void *> Key(CZ.getRootWithoutRetain(),
+                                            Query ? Query->AST : nullptr);
+  auto Cached = SatCache.find(Key);
+  if (Cached != SatCache.end()) {
+    ++NumZ3QueriesCached;
+    return Cached->second.Result;
+  }
+
+  ++NumZ3Queries;
+  assertStateConstraints(CZ);
+  Z3_lbool Result;
+  if (Query) {
+    Solver.push();
+    Solver.addConstraint(*Query);
+    Result = Solver.check();
+    Solver.pop();
+  } else
+    Result = Solver.check();
+
+  if (SatCache.size() >= MaxSatCacheSize)
+    SatCache.clear();
+  SatResult Entry = {CZ, Query ? llvm::Optional<Z3Expr>(*Query) : llvm::None,
+                     Result};
+  SatCache.insert(std::make_pair(Key, std::move(Entry)));
+  return Result;
 }
 
 Z3Expr Z3ConstraintManager::getZ3Expr(SymbolRef Sym, QualType *RetTy,
@@ -12,6 +12,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "clang/StaticAnalyzer/Frontend/AnalysisConsumer.h"
+#include "IncrementalAnalysisCache.h"
 #include "ModelInjector.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/DeclCXX.h"
@@ -40,10 +41,18 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <memory>
 #include <queue>
 #include <utility>
 
+#ifdef LLVM_ON_UNIX
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace clang;
 using namespace ento;
 
@@ -192,6 +201,21 @@ public:
   /// translation unit.
   FunctionSummariesTy FunctionSummaries;
 
+  /// Whether the path-sensitive analysis produced reports since this was last
+  /// cleared.
+  bool ProducedReports = false;
+
+  /// The digest of the analyzer options, taken before they are queried.
+  std::string ConfigDigest;
+
+  /// The functions that produced no reports in the previous runs, if the
+  /// analysis is incremental.
+  std::unique_ptr<IncrementalAnalysisCache> Cache;
+
+  /// The functions of the call graph by name, for looking up the functions
+  /// recorded in the cache.
+  llvm::StringMap<const Decl *> DeclsByName;
+
   AnalysisConsumer(const Preprocessor &pp, const std::string &outdir,
                    AnalyzerOptionsRef opts, ArrayRef<std::string> plugins,
                    CodeInjector *injector)
@@ -199,6 +223,8 @@ public:
         OutDir(outdir), Opts(std::move(opts)), Plugins(plugins),
         Injector(injector) {
     DigestAnalyzerOptions();
+    if (!Opts->IncrementalCacheDir.empty())
+      ConfigDigest = IncrementalAnalysisCache::digestOptions(*Opts);
     if (Opts->PrintStats) {
       llvm::EnableStatistics(false);
       TUTotalTimer = new llvm::Timer("time", "Analyzer Total Time");
@@ -311,6 +337,25 @@ public:
   /// use it to define the order in which the functions should be visited.
   void HandleDeclsCallGraph(const unsigned LocalTUDeclsSize);
 
+  /// \brief A top level function for which the path-sensitive analysis
+  /// produced reports: its index in the analysis order, and the inlining
+  /// mode it was analyzed with.
+  typedef std::pair<unsigned, ExprEngine::InliningModes> ReportingFunction;
+
+  /// \brief Analyze the functions of \p Order whose index is \p Job modulo
+  /// \p NumJobs, skipping those inlined into the functions analyzed before.
+  /// \param Reporting [out] If given, the functions for which reports were
+  /// produced are added to it.
+  void HandleDeclsInOrder(ArrayRef<Decl *> Order, unsigned Job,
+                          unsigned NumJobs,
+                          std::vector<ReportingFunction> *Reporting = nullptr);
+
+  /// \brief Analyze the functions of \p Order on \p NumJobs child processes,
+  /// and analyze again the functions for which they produced reports, so
+  /// that the reports are emitted by this process.
+  /// \returns false if no child process could be started.
+  bool HandleDeclsInParallel(ArrayRef<Decl *> Order, unsigned NumJobs);
+
   /// \brief Run analyzes(syntax or path sensitive) on the given function.
   /// \param Mode - determines if we are requesting syntax only or path
   /// sensitive only analysis.
@@ -473,30 +518,95 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   // inlined functions. The topological order allows the "do not reanalyze
   // previously inlined function" performance heuristic to be triggered more
   // often.
-  SetOfConstDecls Visited;
-  SetOfConstDecls VisitedAsTopLevel;
+  std::vector<Decl *> Order;
   llvm::ReversePostOrderTraversal<clang::CallGraph*> RPOT(&CG);
   for (llvm::ReversePostOrderTraversal<clang::CallGraph*>::rpo_iterator
          I = RPOT.begin(), E = RPOT.end(); I != E; ++I) {
     NumFunctionTopLevel++;
 
-    CallGraphNode *N = *I;
-    Decl *D = N->getDecl();
-
     // Skip the abstract root node.
-    if (!D)
-      continue;
+    if (Decl *D = (*I)->getDecl())
+      Order.push_back(D);
+  }
+
+  // Skip the functions that produced no reports before, if they did not
+  // change. The functions inlined into them are only known after analyzing
+  // them, so this is not done when every function is analyzed on its own.
+  const SourceManager &SM = Ctx->getSourceManager();
+  const FileEntry *MainFile = SM.getFileEntryForID(SM.getMainFileID());
+  if (!Opts->IncrementalCacheDir.empty() && !Opts->AnalyzerListFunctions &&
+      MainFile && Mgr->options.InliningMode != All) {
+    SmallString<128> MainPath(MainFile->getName());
+    llvm::sys::fs::make_absolute(MainPath);
+    Cache = llvm::make_unique<IncrementalAnalysisCache>(
+        Opts->IncrementalCacheDir, MainPath, ConfigDigest);
+    for (const Decl *D : Order)
+      DeclsByName[getFunctionName(D)] = D;
+    HandleDeclsInOrder(Order, /*Job=*/0, /*NumJobs=*/1);
+    if (!Cache->write())
+      llvm::errs() << "warning: could not write the analysis cache for "
+                   << MainPath << '\n';
+    Cache.reset();
+    return;
+  }
+
+  // Analyze on child processes, unless they would write output of their own.
+  unsigned NumJobs = std::min<size_t>(Mgr->options.getNumAnalysisJobs(),
+                                      Order.size());
+  if (NumJobs > 1 && !Opts->AnalyzerDisplayProgress &&
+      !Opts->AnalyzerListFunctions && !Opts->PrintStats &&
+      !Opts->PrintCheckerStats && !Opts->visualizeExplodedGraphWithGraphViz &&
+      !Opts->visualizeExplodedGraphWithUbiGraph &&
+      HandleDeclsInParallel(Order, NumJobs))
+    return;
+
+  HandleDeclsInOrder(Order, /*Job=*/0, /*NumJobs=*/1);
+}
+
+void AnalysisConsumer::HandleDeclsInOrder(
+    ArrayRef<Decl *> Order, unsigned Job, unsigned NumJobs,
+    std::vector<ReportingFunction> *Reporting) {
+  SetOfConstDecls Visited;
+  SetOfConstDecls VisitedAsTopLevel;
+  for (unsigned I = Job, E = Order.size(); I < E; I += NumJobs) {
+    Decl *D = Order[I];
 
     // Skip the functions which have been processed already or previously
     // inlined.
     if (shouldSkipFunction(D, Visited, VisitedAsTopLevel))
       continue;
 
-    // Analyze the function.
+    // Analyze the function, unless it is unchanged since it last produced no
+    // reports.
     SetOfConstDecls VisitedCallees;
+    ExprEngine::InliningModes IMode = getInliningModeForFunction(D, Visited);
+
+    bool Cached = false;
+    std::string Name;
+    if (Cache) {
+      Name = getFunctionName(D);
+      SmallVector<const Decl *, 8> CachedCallees;
+      auto FindDecl = [this](StringRef CalleeName) {
+        return DeclsByName.lookup(CalleeName);
+      };
+      Cached = Cache->lookup(Name, IMode, D, FindDecl, CachedCallees);
+      VisitedCallees.insert(CachedCallees.begin(), CachedCallees.end());
+    }
 
-    HandleCode(D, AM_Path, getInliningModeForFunction(D, Visited),
-               (Mgr->options.InliningMode == All ? nullptr : &VisitedCallees));
+    if (!Cached) {
+      ProducedReports = false;
+      HandleCode(D, AM_Path, IMode,
+                 Mgr->options.InliningMode == All ? nullptr : &VisitedCallees);
+      if (Reporting && ProducedReports)
+        Reporting->push_back(ReportingFunction(I, IMode));
+
+      if (Cache && !ProducedReports) {
+        std::vector<std::pair<std::string, const Decl *>> Callees;
+        for (const Decl *Callee : VisitedCallees)
+          Callees.emplace_back(getFunctionName(Callee), Callee);
+        Cache->record(Name, IMode, D, Callees);
+      }
+    }
 
     // Add the visited callees to the global visited set.
     for (const Decl *Callee : VisitedCallees)
@@ -508,6 +618,112 @@ void AnalysisConsumer::HandleDeclsCallGraph(const unsigned LocalTUDeclsSize) {
   }
 }
 
+bool AnalysisConsumer::HandleDeclsInParallel(ArrayRef<Decl *> Order,
+                                             unsigned NumJobs) {
+#ifdef LLVM_ON_UNIX
+  // Each child process analyzes a share of the functions on its own copy of
+  // the AST and of the analyzer state, and sends back the functions for
+  // which it produced reports, followed by ~0U once it is done. It exits
+  // without flushing its diagnostic consumers.
+  struct Child {
+    pid_t PID;
+    int FD;
+  };
+  SmallVector<Child, 8> Children;
+  for (unsigned Job = 0; Job != NumJobs; ++Job) {
+    int FDs[2];
+    if (pipe(FDs) != 0)
+      break;
+    pid_t PID = fork();
+    if (PID == 0) {
+      close(FDs[0]);
+      std::vector<ReportingFunction> Reporting;
+      HandleDeclsInOrder(Order, Job, NumJobs, &Reporting);
+
+      std::vector<uint32_t> Data;
+      for (const ReportingFunction &F : Reporting)
+        Data.push_back(F.first << 1 |
+                       (F.second == ExprEngine::Inline_Minimal));
+      Data.push_back(~0U);
+      const char *Ptr = reinterpret_cast<const char *>(Data.data());
+      size_t Size = Data.size() * sizeof(uint32_t);
+      while (Size) {
+        ssize_t Written = write(FDs[1], Ptr, Size);
+        if (Written < 0 && errno == EINTR)
+          continue;
+        if (Written <= 0)
+          _exit(1);
+        Ptr += Written;
+        Size -= Written;
+      }
+      _exit(0);
+    }
+    close(FDs[1]);
+    if (PID < 0) {
+      close(FDs[0]);
+      break;
+    }
+    Children.push_back({PID, FDs[0]});
+  }
+  if (Children.empty())
+    return false;
+
+  // Analyze the share of the child processes that failed, or could not be
+  // started, here.
+  std::vector<ReportingFunction> Reporting;
+  for (unsigned Job = 0; Job != NumJobs; ++Job) {
+    bool Done = false;
+    if (Job < Children.size()) {
+      std::vector<uint32_t> Data;
+      uint32_t Buffer[1024];
+      size_t Size = 0;
+      while (true) {
+        ssize_t Read = read(Children[Job].FD,
+                            reinterpret_cast<char *>(Buffer) + Size,
+                            sizeof(Buffer) - Size);
+        if (Read < 0 && errno == EINTR)
+          continue;
+        if (Read <= 0)
+          break;
+        Size += Read;
+        size_t Complete = Size / sizeof(uint32_t);
+        Data.insert(Data.end(), Buffer, Buffer + Complete);
+        Size -= Complete * sizeof(uint32_t);
+        std::memmove(Buffer, Buffer + Complete, Size);
+      }
+      close(Children[Job].FD);
+
+      int Status = 0;
+      pid_t Waited;
+      while ((Waited = waitpid(Children[Job].PID, &Status, 0)) < 0 &&
+             errno == EINTR)
+        ;
+      Done = Waited == Children[Job].PID && WIFEXITED(Status) &&
+             WEXITSTATUS(Status) == 0 && !Data.empty() && Data.back() == ~0U;
+      if (Done) {
+        Data.pop_back();
+        for (uint32_t Entry : Data)
+          if ((Entry >> 1) < Order.size())
+            Reporting.push_back(ReportingFunction(
+                Entry >> 1, Entry & 1 ? ExprEngine::Inline_Minimal
+                                      : ExprEngine::Inline_Regular));
+      }
+    }
+    if (!Done)
+      HandleDeclsInOrder(Order, Job, NumJobs);
+  }
+
+  // The diagnostic consumers sort the reports, so the order in which the
+  // functions are analyzed again does not change the output.
+  std::sort(Reporting.begin(), Reporting.end());
+  for (const ReportingFunction &F : Reporting)
+    HandleCode(Order[F.first], AM_Path, F.second);
+  return true;
+#else
+  return false;
+#endif
+}
+
 void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
   // Don't run the actions if an error has occurred with parsing the file.
   DiagnosticsEngine &Diags = PP.getDiagnostics();
@@ -563,6 +779,9 @@ void AnalysisConsumer::HandleTranslationUnit(ASTContext &C) {
 
   if (TUTotalTimer) TUTotalTimer->stopTimer();
 
+  if (Opts->PrintCheckerStats)
+    checkerMgr->printCheckerStats(llvm::errs());
+
   // Count how many basic blocks we have not covered.
   NumBlocksInAnalyzedFunctions = FunctionSummaries.getTotalNumBasicBlocks();
   if (NumBlocksInAnalyzedFunctions > 0)
@@ -672,6 +891,14 @@ void AnalysisConsumer::HandleCode(Decl *D, AnalysisMode Mode,
   if (Mgr->getAnalysisDeclContext(D)->isBodyAutosynthesized())
     return;
 
+  // List the functions that the path-sensitive analysis would start from,
+  // so that they can be analyzed separately with -analyze-function.
+  if (Opts->AnalyzerListFunctions) {
+    if (Mode & AM_Path)
+      llvm::outs() << "FUNCTION: " << getFunctionName(D) << '\n';
+    return;
+  }
+
   DisplayFunction(D, Mode, IMode);
   CFG *DeclCFG = Mgr->getCFG(D);
   if (DeclCFG)
@@ -726,7 +953,10 @@ void AnalysisConsumer::ActionExprEngine(Decl *D, bool ObjCGCEnabled,
     Eng.ViewGraph(Mgr->options.TrimGraph);
 
   // Display warnings.
-  Eng.getBugReporter().FlushReports();
+  BugReporter &BR = Eng.getBugReporter();
+  BR.FlushReports();
+  if (BR.EQClasses_begin() != BR.EQClasses_end())
+    ProducedReports = true;
 }
 
 void AnalysisConsumer::RunPathSensitiveChecks(Decl *D,
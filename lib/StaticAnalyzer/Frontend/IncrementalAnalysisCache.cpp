@@ -0,0 +1,185 @@
+//===-- IncrementalAnalysisCache.cpp -------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the IncrementalAnalysisCache class.
+//
+// The cache file has a line for each recorded function, with tab separated
+// fields: the name of the function, its inlining mode and its fingerprint,
+// followed by the name and the fingerprint of each function inlined into it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "IncrementalAnalysisCache.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/ODRHash.h"
+#include "clang/Basic/Version.h"
+#include "clang/StaticAnalyzer/Core/AnalyzerOptions.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+
+using namespace clang;
+using namespace ento;
+
+static std::string getDigest(llvm::MD5 &Hash) {
+  llvm::MD5::MD5Result Result;
+  Hash.final(Result);
+  SmallString<32> Str;
+  llvm::MD5::stringifyResult(Result, Str);
+  return Str.str();
+}
+
+IncrementalAnalysisCache::IncrementalAnalysisCache(StringRef Dir,
+                                                   StringRef MainFile,
+                                                   StringRef ConfigDigest) {
+  llvm::MD5 Hash;
+  Hash.update(ConfigDigest);
+  Hash.update(MainFile);
+  SmallString<128> FilePath(Dir);
+  llvm::sys::path::append(FilePath, getDigest(Hash) + ".cache");
+  Path = FilePath.str();
+
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+      llvm::MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return;
+
+  SmallVector<StringRef, 64> Lines;
+  (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                               /*KeepEmpty=*/false);
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 8> Fields;
+    Line.split(Fields, '\t');
+    if (Fields.size() < 3 || Fields.size() % 2 == 0)
+      continue;
+
+    Entry E;
+    if (Fields[1].getAsInteger(10, E.Mode) ||
+        Fields[2].getAsInteger(10, E.Fingerprint))
+      continue;
+    bool Valid = true;
+    for (unsigned I = 3, N = Fields.size(); I != N; I += 2) {
+      unsigned Fingerprint;
+      if (Fields[I + 1].getAsInteger(10, Fingerprint)) {
+        Valid = false;
+        break;
+      }
+      E.Callees.emplace_back(Fields[I], Fingerprint);
+    }
+    if (Valid)
+      Previous[Fields[0]] = std::move(E);
+  }
+}
+
+std::string IncrementalAnalysisCache::digestOptions(
+    const AnalyzerOptions &Opts) {
+  llvm::MD5 Hash;
+  Hash.update(getClangFullVersion());
+  for (const auto &Checker : Opts.CheckersControlList) {
+    Hash.update(Checker.first);
+    Hash.update(Checker.second ? "+" : "-");
+  }
+
+  // The configuration table is not ordered.
+  std::vector<std::pair<StringRef, StringRef>> Config;
+  for (const auto &Option : Opts.Config)
+    Config.emplace_back(Option.getKey(), Option.getValue());
+  std::sort(Config.begin(), Config.end());
+  for (const auto &Option : Config) {
+    Hash.update(Option.first);
+    Hash.update("=");
+    Hash.update(Option.second);
+    Hash.update(",");
+  }
+
+  std::string Str;
+  llvm::raw_string_ostream OS(Str);
+  OS << Opts.AnalysisStoreOpt << ' ' << Opts.AnalysisConstraintsOpt << ' '
+     << Opts.AnalysisPurgeOpt << ' ' << Opts.maxBlockVisitOnPath << ' '
+     << Opts.InlineMaxStackDepth << ' ' << Opts.InliningMode << ' '
+     << Opts.AnalyzeAll << Opts.AnalyzeNestedBlocks
+     << Opts.eagerlyAssumeBinOpBifurcation << Opts.UnoptimizedCFG
+     << Opts.NoRetryExhausted << ' ' << Opts.AnalyzeSpecificFunction;
+  Hash.update(OS.str());
+  return getDigest(Hash);
+}
+
+unsigned IncrementalAnalysisCache::getFingerprint(const Decl *D) {
+  const Stmt *Body = D->getBody();
+  if (!Body)
+    return 0;
+
+  ODRHash Hash;
+  if (const auto *FD = dyn_cast<FunctionDecl>(D))
+    Hash.AddQualType(FD->getType());
+  Hash.AddStmt(Body);
+  return Hash.CalculateHash();
+}
+
+bool IncrementalAnalysisCache::lookup(
+    StringRef Name, unsigned Mode, const Decl *D,
+    llvm::function_ref<const Decl *(StringRef)> FindDecl,
+    SmallVectorImpl<const Decl *> &Callees) {
+  auto I = Previous.find(Name);
+  if (I == Previous.end() || I->second.Mode != Mode ||
+      I->second.Fingerprint != getFingerprint(D))
+    return false;
+
+  SmallVector<const Decl *, 8> Found;
+  for (const auto &Callee : I->second.Callees) {
+    const Decl *CalleeDecl = FindDecl(Callee.first);
+    if (!CalleeDecl || getFingerprint(CalleeDecl) != Callee.second)
+      return false;
+    Found.push_back(CalleeDecl);
+  }
+
+  Callees.append(Found.begin(), Found.end());
+  Current[Name] = I->second;
+  return true;
+}
+
+void IncrementalAnalysisCache::record(
+    StringRef Name, unsigned Mode, const Decl *D,
+    ArrayRef<std::pair<std::string, const Decl *>> Callees) {
+  Entry &E = Current[Name];
+  E.Mode = Mode;
+  E.Fingerprint = getFingerprint(D);
+  E.Callees.clear();
+  for (const auto &Callee : Callees)
+    E.Callees.emplace_back(Callee.first, getFingerprint(Callee.second));
+}
+
+bool IncrementalAnalysisCache::write() {
+  // Write to a temporary file first, so that concurrent runs never read a
+  // partially written cache.
+  llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path));
+  int FD;
+  SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(Path + "-%%%%%%%%", FD, TempPath))
+    return false;
+
+  llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+  for (const auto &I : Current) {
+    const Entry &E = I.getValue();
+    OS << I.getKey() << '\t' << E.Mode << '\t' << E.Fingerprint;
+    for (const auto &Callee : E.Callees)
+      OS << '\t' << Callee.first << '\t' << Callee.second;
+    OS << '\n';
+  }
+  OS.close();
+  if (OS.has_error()) {
+    OS.clear_error();
+    llvm::sys::fs::remove(TempPath);
+    return false;
+  }
+  return !llvm::sys::fs::rename(TempPath, Path);
+}
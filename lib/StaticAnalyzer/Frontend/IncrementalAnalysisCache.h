@@ -0,0 +1,93 @@
+//===-- IncrementalAnalysisCache.h ------------------------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file defines the clang::ento::IncrementalAnalysisCache class,
+/// which records the functions whose analysis produced no reports, so that
+/// later runs of the analyzer can skip them while they do not change.
+///
+/// A function is identified by its name, and fingerprinted by a hash of its
+/// body and of the body of every function that was inlined into it. The
+/// recorded functions are kept in one file for each translation unit and
+/// analyzer configuration.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_SA_FRONTEND_INCREMENTALANALYSISCACHE_H
+#define LLVM_CLANG_SA_FRONTEND_INCREMENTALANALYSISCACHE_H
+
+#include "clang/Basic/LLVM.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace clang {
+
+class AnalyzerOptions;
+class Decl;
+
+namespace ento {
+
+class IncrementalAnalysisCache {
+public:
+  /// \brief Load the functions recorded in the cache file for \p MainFile
+  /// under \p Dir, given the digest of the analyzer configuration.
+  IncrementalAnalysisCache(StringRef Dir, StringRef MainFile,
+                           StringRef ConfigDigest);
+
+  /// \brief Returns a digest of the options that the reports depend on.
+  static std::string digestOptions(const AnalyzerOptions &Opts);
+
+  /// \brief Returns a hash of the body of \p D, which does not depend on
+  /// the addresses of the declarations it refers to.
+  static unsigned getFingerprint(const Decl *D);
+
+  /// \brief Returns true if \p D, called \p Name, was recorded for the
+  /// inlining mode \p Mode, and neither it nor the functions inlined into it
+  /// changed since. The carried over functions are written back by write().
+  /// \param FindDecl Returns the declaration of the function with the given
+  /// name, or null if there is none.
+  /// \param Callees [out] The functions that were inlined into \p D.
+  bool lookup(StringRef Name, unsigned Mode, const Decl *D,
+              llvm::function_ref<const Decl *(StringRef)> FindDecl,
+              SmallVectorImpl<const Decl *> &Callees);
+
+  /// \brief Record that the analysis of \p D, called \p Name, produced no
+  /// reports with the inlining mode \p Mode, while inlining \p Callees,
+  /// which are pairs of names and declarations.
+  void record(StringRef Name, unsigned Mode, const Decl *D,
+              ArrayRef<std::pair<std::string, const Decl *>> Callees);
+
+  /// \brief Write the functions recorded or carried over by this run.
+  /// \returns false if the cache file could not be written.
+  bool write();
+
+private:
+  struct Entry {
+    unsigned Mode;
+    unsigned Fingerprint;
+    std::vector<std::pair<std::string, unsigned>> Callees;
+  };
+
+  /// \brief The path of the cache file.
+  std::string Path;
+
+  /// \brief The functions recorded by the previous run.
+  llvm::StringMap<Entry> Previous;
+
+  /// \brief The functions to record for the next run.
+  llvm::StringMap<Entry> Current;
+};
+
+} // end namespace ento
+} // end namespace clang
+
+#endif
@@ -15,10 +15,14 @@
 
 #include "clang/AST/RecursiveASTVisitor.h"
 #include "clang/Lex/Lexer.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PriorityQueue.h"
 
+#include <chrono>
 #include <limits>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 using namespace llvm;
@@ -58,6 +62,7 @@ class ASTDiff::Impl {
 public:
   SyntaxTree::Impl &T1, &T2;
   Mapping TheMapping;
+  MatchingMode Mode;
 
   Impl(SyntaxTree::Impl &T1, SyntaxTree::Impl &T2,
        const ComparisonOptions &Options);
@@ -103,6 +108,13 @@ private:
   // Tries to match any yet unmapped nodes, in a bottom-up fashion.
   void matchBottomUp(Mapping &M) const;
 
+  // Returns a mapping of identical subtrees, found by their hashes.
+  Mapping matchIdenticalSubtrees() const;
+
+  // Matches the yet unmapped nodes to the parent of the nodes that most of
+  // their children are mapped to, in a bottom-up fashion.
+  void matchParentsOfMapped(Mapping &M) const;
+
   const ComparisonOptions &Options;
 
   friend class ZhangShashaMatcher;
@@ -903,14 +915,140 @@ Mapping ASTDiff::Impl::matchTopDown() const {
   return M;
 }
 
+// Returns, for each node of the tree, a hash of its subtree, from the types
+// and values of its nodes.  Identical subtrees have the same hash.
+static std::vector<size_t> getSubtreeHashes(const SyntaxTree::Impl &Tree) {
+  std::vector<size_t> Hashes(Tree.getSize());
+  // The children of a node come after it in preorder.
+  for (int I = Tree.getSize() - 1; I >= 0; --I) {
+    NodeId Id(I);
+    const Node &N = Tree.getNode(Id);
+    hash_code Hash = hash_combine(
+        ast_type_traits::ASTNodeKind::DenseMapInfo::getHashValue(N.getType()),
+        hash_value(Tree.getNodeValue(Id)), N.Children.size());
+    for (NodeId Child : N.Children)
+      Hash = hash_combine(Hash, Hashes[Child]);
+    Hashes[Id] = Hash;
+  }
+  return Hashes;
+}
+
+Mapping ASTDiff::Impl::matchIdenticalSubtrees() const {
+  Mapping M(T1.getSize() + T2.getSize());
+  std::vector<size_t> Hashes1 = getSubtreeHashes(T1);
+  std::vector<size_t> Hashes2 = getSubtreeHashes(T2);
+
+  // The subtrees of T2 that are high enough to be matched, in preorder, by
+  // their hash.  Sub-subtrees of a matched subtree are mapped with it.
+  struct Candidates {
+    std::vector<NodeId> Ids;
+    size_t Next = 0;
+  };
+  std::unordered_map<size_t, Candidates> CandidatesByHash;
+  for (NodeId Id2 : T2)
+    if (T2.getNode(Id2).Height > Options.MinHeight)
+      CandidatesByHash[Hashes2[Id2]].Ids.push_back(Id2);
+
+  // Visiting T1 in preorder matches the largest subtrees first, and each
+  // subtree with the first identical one of T2 that is still unmapped.
+  for (NodeId Id1 = T1.getRootId(), E = T1.end(); Id1 < E;) {
+    const Node &N1 = T1.getNode(Id1);
+    if (N1.Height <= Options.MinHeight) {
+      ++Id1;
+      continue;
+    }
+    auto It = CandidatesByHash.find(Hashes1[Id1]);
+    NodeId Match;
+    if (It != CandidatesByHash.end()) {
+      Candidates &C = It->second;
+      while (C.Next < C.Ids.size() && M.hasDst(C.Ids[C.Next]))
+        ++C.Next;
+      for (size_t I = C.Next, CE = C.Ids.size(); I < CE; ++I) {
+        NodeId Id2 = C.Ids[I];
+        if (!M.hasDst(Id2) && identical(Id1, Id2)) {
+          Match = Id2;
+          break;
+        }
+      }
+    }
+    if (Match.isInvalid()) {
+      ++Id1;
+      continue;
+    }
+    for (int I = 0, NE = T1.getNumberOfDescendants(Id1); I < NE; ++I)
+      M.link(Id1 + I, Match + I);
+    Id1 = N1.RightMostDescendant + 1;
+  }
+  return M;
+}
+
+void ASTDiff::Impl::matchParentsOfMapped(Mapping &M) const {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point Deadline =
+      Clock::now() + std::chrono::milliseconds(Options.TimeBudgetMs);
+  bool InBudget = true;
+  auto AddOptimalMapping = [&](NodeId Id1, NodeId Id2) {
+    if (InBudget && Options.TimeBudgetMs && Clock::now() >= Deadline)
+      InBudget = false;
+    if (InBudget)
+      addOptimalMapping(M, Id1, Id2);
+  };
+
+  std::vector<NodeId> Postorder = getSubtreePostorder(T1, T1.getRootId());
+  for (NodeId Id1 : Postorder) {
+    if (Id1 == T1.getRootId())
+      break;
+    if (M.hasSrc(Id1))
+      continue;
+    // Each child that is mapped votes for the parent of the node that it is
+    // mapped to, unlike findCandidate, which looks at all of T2.
+    DenseMap<int, int> Votes;
+    NodeId Candidate;
+    int MostVotes = 0;
+    for (NodeId Child : T1.getNode(Id1).Children) {
+      NodeId Dst = M.getDst(Child);
+      if (Dst.isInvalid())
+        continue;
+      NodeId Parent = T2.getNode(Dst).Parent;
+      if (Parent.isInvalid() || M.hasDst(Parent) ||
+          !isMatchingPossible(Id1, Parent))
+        continue;
+      int NumVotes = ++Votes[Parent];
+      if (NumVotes > MostVotes) {
+        MostVotes = NumVotes;
+        Candidate = Parent;
+      }
+    }
+    if (Candidate.isValid()) {
+      M.link(Id1, Candidate);
+      AddOptimalMapping(Id1, Candidate);
+    }
+  }
+  if (!M.hasSrc(T1.getRootId()) && !M.hasDst(T2.getRootId()) &&
+      isMatchingPossible(T1.getRootId(), T2.getRootId())) {
+    M.link(T1.getRootId(), T2.getRootId());
+    AddOptimalMapping(T1.getRootId(), T2.getRootId());
+  }
+}
+
 ASTDiff::Impl::Impl(SyntaxTree::Impl &T1, SyntaxTree::Impl &T2,
                     const ComparisonOptions &Options)
-    : T1(T1), T2(T2), Options(Options) {
+    : T1(T1), T2(T2), Mode(Options.Mode), Options(Options) {
+  if (Options.LinearMatchingThreshold >= 0 &&
+      T1.getSize() + T2.getSize() > Options.LinearMatchingThreshold)
+    Mode = MatchingMode::Linear;
   computeMapping();
   computeChangeKinds(TheMapping);
 }
 
 void ASTDiff::Impl::computeMapping() {
+  if (Mode == MatchingMode::Linear) {
+    TheMapping = matchIdenticalSubtrees();
+    if (Options.StopAfterTopDown)
+      return;
+    matchParentsOfMapped(TheMapping);
+    return;
+  }
   TheMapping = matchTopDown();
   if (Options.StopAfterTopDown)
     return;
@@ -970,6 +1108,8 @@ NodeId ASTDiff::getMapped(const SyntaxTree &SourceTree, NodeId Id) const {
   return DiffImpl->getMapped(SourceTree.TreeImpl, Id);
 }
 
+MatchingMode ASTDiff::getMatchingMode() const { return DiffImpl->Mode; }
+
 SyntaxTree::SyntaxTree(ASTContext &AST)
     : TreeImpl(llvm::make_unique<SyntaxTree::Impl>(
           this, AST.getTranslationUnitDecl(), AST)) {}
@@ -0,0 +1,253 @@
+//===- lib/Tooling/AllTUsExecution.cpp - Execute actions on all TUs. ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/AllTUsExecution.h"
+#include "clang/Tooling/ToolExecutorPluginRegistry.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+namespace clang {
+namespace tooling {
+
+static llvm::Error make_string_error(const llvm::Twine &Message) {
+  return llvm::make_error<llvm::StringError>(Message,
+                                             llvm::inconvertibleErrorCode());
+}
+
+const char *AllTUsToolExecutor::ExecutorName = "AllTUsToolExecutor";
+
+static ArgumentsAdjuster getDefaultArgumentsAdjusters() {
+  return combineAdjusters(
+      getClangStripOutputAdjuster(),
+      combineAdjusters(getClangSyntaxOnlyAdjuster(),
+                       getClangStripDependencyFileAdjuster()));
+}
+
+namespace {
+
+class ThreadSafeToolResults : public ToolResults {
+public:
+  void addResult(StringRef Key, StringRef Value) override {
+    std::unique_lock<std::mutex> LockGuard(Mutex);
+    Results.addResult(Key, Value);
+  }
+
+  std::vector<std::pair<std::string, std::string>> AllKVResults() override {
+    return Results.AllKVResults();
+  }
+
+  void forEachResult(llvm::function_ref<void(StringRef Key, StringRef Value)>
+                         Callback) override {
+    Results.forEachResult(Callback);
+  }
+
+private:
+  InMemoryToolResults Results;
+  std::mutex Mutex;
+};
+
+/// \brief The status of the files looked up by all the tools of an execution,
+/// including the files that were found missing.
+class SharedStatusCache {
+public:
+  llvm::ErrorOr<vfs::Status> status(StringRef Path, vfs::FileSystem &FS) {
+    {
+      std::unique_lock<std::mutex> LockGuard(Mutex);
+      auto I = Statuses.find(Path);
+      if (I != Statuses.end())
+        return I->second;
+    }
+    llvm::ErrorOr<vfs::Status> Status = FS.status(Path);
+    std::unique_lock<std::mutex> LockGuard(Mutex);
+    Statuses.insert(std::make_pair(Path, Status));
+    return Status;
+  }
+
+private:
+  llvm::StringMap<llvm::ErrorOr<vfs::Status>> Statuses;
+  std::mutex Mutex;
+};
+
+/// \brief A view of the real file system with a working directory of its own,
+/// so that the tools running on different threads do not change the working
+/// directory of the process. The status of the files is looked up in a cache
+/// shared by all the tools.
+class ToolFileSystem : public vfs::FileSystem {
+public:
+  ToolFileSystem(IntrusiveRefCntPtr<vfs::FileSystem> RealFS,
+                 SharedStatusCache &StatusCache, StringRef WorkingDirectory)
+      : RealFS(std::move(RealFS)), StatusCache(StatusCache),
+        WorkingDirectory(WorkingDirectory) {}
+
+  llvm::ErrorOr<vfs::Status> status(const Twine &Path) override {
+    SmallString<128> AbsPath;
+    if (std::error_code EC = getAbsolutePath(Path, AbsPath))
+      return EC;
+    return StatusCache.status(AbsPath, *RealFS);
+  }
+
+  llvm::ErrorOr<std::unique_ptr<vfs::File>>
+  openFileForRead(const Twine &Path) override {
+    SmallString<128> AbsPath;
+    if (std::error_code EC = getAbsolutePath(Path, AbsPath))
+      return EC;
+    return RealFS->openFileForRead(AbsPath);
+  }
+
+  vfs::directory_iterator dir_begin(const Twine &Dir,
+                                    std::error_code &EC) override {
+    SmallString<128> AbsPath;
+    if ((EC = getAbsolutePath(Dir, AbsPath)))
+      return vfs::directory_iterator();
+    return RealFS->dir_begin(AbsPath, EC);
+  }
+
+  std::error_code setCurrentWorkingDirectory(const Twine &Path) override {
+    SmallString<128> AbsPath;
+    if (std::error_code EC = getAbsolutePath(Path, AbsPath))
+      return EC;
+    llvm::ErrorOr<vfs::Status> Status = status(AbsPath);
+    if (!Status)
+      return Status.getError();
+    if (!Status->isDirectory())
+      return std::make_error_code(std::errc::not_a_directory);
+    WorkingDirectory = AbsPath.str();
+    return std::error_code();
+  }
+
+  llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override {
+    return WorkingDirectory;
+  }
+
+private:
+  std::error_code getAbsolutePath(const Twine &Path,
+                                  SmallVectorImpl<char> &AbsPath) const {
+    Path.toVector(AbsPath);
+    if (std::error_code EC = makeAbsolute(AbsPath))
+      return EC;
+    llvm::sys::path::remove_dots(AbsPath, /*remove_dot_dot=*/false);
+    return std::error_code();
+  }
+
+  IntrusiveRefCntPtr<vfs::FileSystem> RealFS;
+  SharedStatusCache &StatusCache;
+  std::string WorkingDirectory;
+};
+
+} // namespace
+
+AllTUsToolExecutor::AllTUsToolExecutor(
+    const CompilationDatabase &Compilations, unsigned ThreadCount,
+    llvm::ArrayRef<std::string> SourcePaths,
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps)
+    : Compilations(Compilations), SourcePaths(SourcePaths),
+      PCHContainerOps(std::move(PCHContainerOps)),
+      Results(new ThreadSafeToolResults), Context(Results.get()),
+      ThreadCount(ThreadCount) {}
+
+AllTUsToolExecutor::AllTUsToolExecutor(
+    CommonOptionsParser Options, unsigned ThreadCount,
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps)
+    : OptionsParser(std::move(Options)),
+      Compilations(OptionsParser->getCompilations()),
+      SourcePaths(OptionsParser->getSourcePathList()),
+      PCHContainerOps(std::move(PCHContainerOps)),
+      Results(new ThreadSafeToolResults), Context(Results.get()),
+      ThreadCount(ThreadCount) {}
+
+llvm::Error AllTUsToolExecutor::execute(
+    llvm::ArrayRef<
+        std::pair<std::unique_ptr<FrontendActionFactory>, ArgumentsAdjuster>>
+        Actions) {
+  if (Actions.empty())
+    return make_string_error("No action to execute.");
+
+  if (Actions.size() != 1)
+    return make_string_error(
+        "Only support executing exactly 1 action at this point.");
+
+  llvm::SmallString<128> InitialWorkingDir;
+  if (std::error_code EC = llvm::sys::fs::current_path(InitialWorkingDir))
+    return make_string_error("Cannot detect current path: " + EC.message());
+
+  std::string ErrorMsg;
+  std::mutex TUMutex;
+  auto AppendError = [&](llvm::Twine Err) {
+    std::unique_lock<std::mutex> LockGuard(TUMutex);
+    ErrorMsg += Err.str();
+  };
+
+  std::vector<std::string> Files =
+      SourcePaths.empty() ? Compilations.getAllFiles() : SourcePaths;
+  SharedStatusCache StatusCache;
+  IntrusiveRefCntPtr<vfs::FileSystem> RealFS = vfs::getRealFileSystem();
+  auto &Action = Actions.front();
+  {
+    unsigned NumThreads = ThreadCount;
+    if (NumThreads == 0)
+      NumThreads = std::max(1u, std::thread::hardware_concurrency());
+    llvm::ThreadPool Pool(NumThreads);
+    for (const std::string &File : Files) {
+      Pool.async([&, File]() {
+        ClangTool Tool(Compilations, File, PCHContainerOps,
+                       new ToolFileSystem(RealFS, StatusCache,
+                                          InitialWorkingDir));
+        Tool.clearArgumentsAdjusters();
+        Tool.appendArgumentsAdjuster(Action.second);
+        Tool.appendArgumentsAdjuster(getDefaultArgumentsAdjusters());
+        for (const auto &FileAndContent : OverlayFiles)
+          Tool.mapVirtualFile(FileAndContent.first(), FileAndContent.second);
+        if (Tool.run(Action.first.get()))
+          AppendError(llvm::Twine("Failed to run action on ") + File + "\n");
+      });
+    }
+    Pool.wait();
+  }
+
+  if (!ErrorMsg.empty())
+    return make_string_error(ErrorMsg);
+
+  return llvm::Error::success();
+}
+
+static llvm::cl::opt<unsigned> ExecutorConcurrency(
+    "execute-concurrency",
+    llvm::cl::desc("The number of threads used to process all files in "
+                   "parallel. Set to 0 for hardware concurrency."),
+    llvm::cl::init(0));
+
+class AllTUsToolExecutorPlugin : public ToolExecutorPlugin {
+public:
+  llvm::Expected<std::unique_ptr<ToolExecutor>>
+  create(CommonOptionsParser &OptionsParser) override {
+    if (OptionsParser.getSourcePathList().empty() &&
+        OptionsParser.getCompilations().getAllFiles().empty())
+      return make_string_error(
+          "[AllTUsToolExecutorPlugin] No file found in the compilation "
+          "database or in positional arguments.");
+    return llvm::make_unique<AllTUsToolExecutor>(std::move(OptionsParser),
+                                                 ExecutorConcurrency);
+  }
+};
+
+// This anchor is used to force the linker to link in the generated object file
+// and thus register the plugin.
+volatile int AllTUsToolExecutorAnchorSource = 0;
+
+static ToolExecutorPluginRegistry::Add<AllTUsToolExecutorPlugin>
+    X("all-TUs", "Runs FrontendActions on all TUs in the compilation database, "
+                 "or on the files provided via positional arguments, in "
+                 "parallel. Tool results are stored in memory.");
+
+} // end namespace tooling
+} // end namespace clang
@@ -0,0 +1,363 @@
+//===--- BinaryCompilationDatabase.cpp - ----------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file contains the implementation of the BinaryCompilationDatabase.
+//
+//  The database starts with a header of the magic number, the version and the
+//  sizes and offsets of its tables, all of them 32 bit little endian:
+//  - the commands, each of them the offsets of its directory, file name and
+//    output strings, the index of its first argument and its number of
+//    arguments;
+//  - the arguments, which are offsets of strings;
+//  - the files, which are offsets of their native absolute paths;
+//  - the bucket array of an on-disk hash table, which maps the native absolute
+//    path of each file to the indices of its commands.
+//  The strings, each of them its length followed by its characters, lie
+//  between the header and the tables.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/BinaryCompilationDatabase.h"
+#include "clang/Tooling/CompilationDatabasePluginRegistry.h"
+#include "llvm/ADT/MapVector.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/OnDiskHashTable.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+namespace tooling {
+
+namespace {
+
+const char BinaryDatabaseMagic[] = {'C', 'C', 'D', 'B'};
+const uint32_t BinaryDatabaseVersion = 1;
+const size_t BinaryDatabaseHeaderSize = 36;
+const size_t BinaryDatabaseCommandSize = 20;
+
+/// The traits of the on-disk hash table of the files, which maps the paths
+/// of the files to the indices of their commands.
+class FileIndexInfo {
+public:
+  typedef StringRef key_type;
+  typedef StringRef key_type_ref;
+  typedef StringRef data_type;
+  typedef StringRef data_type_ref;
+  typedef StringRef internal_key_type;
+  typedef StringRef external_key_type;
+  typedef uint32_t hash_value_type;
+  typedef uint32_t offset_type;
+
+  static bool EqualKey(internal_key_type A, internal_key_type B) {
+    return A == B;
+  }
+  static hash_value_type ComputeHash(internal_key_type Key) {
+    return llvm::HashString(Key);
+  }
+  static internal_key_type GetInternalKey(external_key_type Key) {
+    return Key;
+  }
+  static external_key_type GetExternalKey(internal_key_type Key) {
+    return Key;
+  }
+
+  static std::pair<offset_type, offset_type>
+  EmitKeyDataLength(raw_ostream &Out, key_type_ref Key, data_type_ref Data) {
+    using namespace llvm::support;
+    endian::Writer<little> LE(Out);
+    LE.write<offset_type>(Key.size());
+    LE.write<offset_type>(Data.size());
+    return std::make_pair(Key.size(), Data.size());
+  }
+  static void EmitKey(raw_ostream &Out, key_type_ref Key, offset_type) {
+    Out << Key;
+  }
+  static void EmitData(raw_ostream &Out, key_type_ref, data_type_ref Data,
+                       offset_type) {
+    Out << Data;
+  }
+
+  static std::pair<offset_type, offset_type>
+  ReadKeyDataLength(const unsigned char *&D) {
+    using namespace llvm::support;
+    offset_type KeyLen = endian::readNext<offset_type, little, unaligned>(D);
+    offset_type DataLen = endian::readNext<offset_type, little, unaligned>(D);
+    return std::make_pair(KeyLen, DataLen);
+  }
+  static internal_key_type ReadKey(const unsigned char *D, offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+  static data_type ReadData(internal_key_type, const unsigned char *D,
+                            offset_type Len) {
+    return StringRef(reinterpret_cast<const char *>(D), Len);
+  }
+};
+
+typedef llvm::OnDiskChainedHashTable<FileIndexInfo> FileIndexTable;
+
+/// Returns the native absolute path of the file compiled by \p Command, the
+/// way JSONCompilationDatabase indexes it.
+std::string getNativeFilePath(const CompileCommand &Command) {
+  SmallString<128> NativeFilePath;
+  if (llvm::sys::path::is_relative(Command.Filename)) {
+    SmallString<128> AbsolutePath(Command.Directory);
+    llvm::sys::path::append(AbsolutePath, Command.Filename);
+    llvm::sys::path::native(AbsolutePath, NativeFilePath);
+  } else {
+    llvm::sys::path::native(Command.Filename, NativeFilePath);
+  }
+  return NativeFilePath.str();
+}
+
+class BinaryCompilationDatabasePlugin : public CompilationDatabasePlugin {
+  std::unique_ptr<CompilationDatabase>
+  loadFromDirectory(StringRef Directory, std::string &ErrorMessage) override {
+    SmallString<1024> DatabasePath(Directory);
+    llvm::sys::path::append(DatabasePath, "compile_commands.bin");
+    return BinaryCompilationDatabase::loadFromFile(DatabasePath, ErrorMessage);
+  }
+};
+
+} // end namespace
+
+// Register the BinaryCompilationDatabasePlugin with the
+// CompilationDatabasePluginRegistry using this statically initialized variable.
+static CompilationDatabasePluginRegistry::Add<BinaryCompilationDatabasePlugin>
+X("binary-compilation-database", "Reads binary compilation databases");
+
+// This anchor is used to force the linker to link in the generated object file
+// and thus register the BinaryCompilationDatabasePlugin.
+volatile int BinaryAnchorSource = 0;
+
+std::unique_ptr<BinaryCompilationDatabase>
+BinaryCompilationDatabase::loadFromFile(StringRef FilePath,
+                                        std::string &ErrorMessage) {
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> DatabaseBuffer =
+      llvm::MemoryBuffer::getFile(FilePath, /*FileSize=*/-1,
+                                  /*RequiresNullTerminator=*/false);
+  if (std::error_code Result = DatabaseBuffer.getError()) {
+    ErrorMessage = "Error while opening binary database: " + Result.message();
+    return nullptr;
+  }
+  return loadFromBuffer(std::move(*DatabaseBuffer), ErrorMessage);
+}
+
+std::unique_ptr<BinaryCompilationDatabase>
+BinaryCompilationDatabase::loadFromBuffer(
+    std::unique_ptr<llvm::MemoryBuffer> Buffer, std::string &ErrorMessage) {
+  std::unique_ptr<BinaryCompilationDatabase> Database(
+      new BinaryCompilationDatabase(std::move(Buffer)));
+  if (!Database->readHeader(ErrorMessage))
+    return nullptr;
+  return Database;
+}
+
+std::string
+BinaryCompilationDatabase::serialize(const CompilationDatabase &Database) {
+  using namespace llvm::support;
+  std::vector<CompileCommand> Commands = Database.getAllCompileCommands();
+
+  SmallString<4096> Result;
+  llvm::raw_svector_ostream OS(Result);
+  endian::Writer<little> LE(OS);
+  OS.write(BinaryDatabaseMagic, sizeof(BinaryDatabaseMagic));
+  LE.write<uint32_t>(BinaryDatabaseVersion);
+  while (OS.tell() != BinaryDatabaseHeaderSize)
+    LE.write<uint32_t>(0);
+
+  // Write each distinct string once, before the tables which refer to them.
+  llvm::StringMap<uint32_t> StringOffsets;
+  auto Intern = [&](StringRef S) {
+    auto Inserted = StringOffsets.insert(std::make_pair(S, 0));
+    if (Inserted.second) {
+      Inserted.first->second = OS.tell();
+      LE.write<uint32_t>(S.size());
+      OS << S;
+    }
+    return Inserted.first->second;
+  };
+
+  std::vector<uint32_t> Records;
+  std::vector<uint32_t> Arguments;
+  llvm::MapVector<std::string, std::string> FileCommands;
+  for (uint32_t I = 0, E = Commands.size(); I != E; ++I) {
+    const CompileCommand &Command = Commands[I];
+    Records.push_back(Intern(Command.Directory));
+    Records.push_back(Intern(Command.Filename));
+    Records.push_back(Intern(Command.Output));
+    Records.push_back(Arguments.size());
+    Records.push_back(Command.CommandLine.size());
+    for (const std::string &Argument : Command.CommandLine)
+      Arguments.push_back(Intern(Argument));
+
+    llvm::raw_string_ostream Indices(FileCommands[getNativeFilePath(Command)]);
+    endian::Writer<little>(Indices).write<uint32_t>(I);
+  }
+  std::vector<uint32_t> Files;
+  for (const auto &File : FileCommands)
+    Files.push_back(Intern(File.first));
+
+  uint32_t CommandsOffset = OS.tell();
+  for (uint32_t Value : Records)
+    LE.write<uint32_t>(Value);
+  uint32_t ArgumentsOffset = OS.tell();
+  for (uint32_t Value : Arguments)
+    LE.write<uint32_t>(Value);
+  uint32_t FilesOffset = OS.tell();
+  for (uint32_t Value : Files)
+    LE.write<uint32_t>(Value);
+
+  llvm::OnDiskChainedHashTableGenerator<FileIndexInfo> Generator;
+  for (const auto &File : FileCommands)
+    Generator.insert(File.first, File.second);
+  uint32_t IndexOffset = Generator.Emit(OS);
+
+  const uint32_t Header[] = {
+      static_cast<uint32_t>(Commands.size()),  CommandsOffset,
+      static_cast<uint32_t>(Arguments.size()), ArgumentsOffset,
+      static_cast<uint32_t>(Files.size()),     FilesOffset,
+      IndexOffset};
+  for (unsigned I = 0; I != llvm::array_lengthof(Header); ++I)
+    endian::write32le(&Result[8 + 4 * I], Header[I]);
+  return Result.str();
+}
+
+bool BinaryCompilationDatabase::readHeader(std::string &ErrorMessage) {
+  using namespace llvm::support;
+  StringRef Data = Buffer->getBuffer();
+  if (Data.size() < BinaryDatabaseHeaderSize ||
+      !Data.startswith(
+          StringRef(BinaryDatabaseMagic, sizeof(BinaryDatabaseMagic)))) {
+    ErrorMessage = "Not a binary compilation database.";
+    return false;
+  }
+  const unsigned char *Base = Data.bytes_begin();
+  if (endian::read32le(Base + 4) != BinaryDatabaseVersion) {
+    ErrorMessage = "Unsupported binary compilation database version.";
+    return false;
+  }
+  NumCommands = endian::read32le(Base + 8);
+  CommandsOffset = endian::read32le(Base + 12);
+  NumArguments = endian::read32le(Base + 16);
+  ArgumentsOffset = endian::read32le(Base + 20);
+  NumFiles = endian::read32le(Base + 24);
+  FilesOffset = endian::read32le(Base + 28);
+  IndexOffset = endian::read32le(Base + 32);
+
+  auto InBounds = [&](uint64_t Offset, uint64_t Size) {
+    return Offset >= BinaryDatabaseHeaderSize && Offset + Size <= Data.size();
+  };
+  // The bucket array starts with the number of buckets and of entries.
+  bool Valid =
+      InBounds(CommandsOffset,
+               uint64_t(NumCommands) * BinaryDatabaseCommandSize) &&
+      InBounds(ArgumentsOffset, uint64_t(NumArguments) * 4) &&
+      InBounds(FilesOffset, uint64_t(NumFiles) * 4) && IndexOffset % 4 == 0 &&
+      InBounds(IndexOffset, 8);
+  if (Valid) {
+    uint64_t NumBuckets = endian::read32le(Base + IndexOffset);
+    Valid = NumBuckets != 0 && InBounds(IndexOffset, 8 + NumBuckets * 4);
+  }
+  if (!Valid) {
+    ErrorMessage = "Malformed binary compilation database.";
+    return false;
+  }
+  return true;
+}
+
+StringRef BinaryCompilationDatabase::getString(uint32_t Offset) const {
+  StringRef Data = Buffer->getBuffer();
+  if (uint64_t(Offset) + 4 > Data.size())
+    return StringRef();
+  uint32_t Length =
+      llvm::support::endian::read32le(Data.bytes_begin() + Offset);
+  return Data.substr(Offset + 4, Length);
+}
+
+CompileCommand BinaryCompilationDatabase::getCommand(uint32_t Index) const {
+  using namespace llvm::support;
+  const unsigned char *Base = Buffer->getBuffer().bytes_begin();
+  const unsigned char *Record =
+      Base + CommandsOffset + Index * BinaryDatabaseCommandSize;
+  uint32_t FirstArgument = endian::read32le(Record + 12);
+  uint32_t NumCommandArguments = endian::read32le(Record + 16);
+  std::vector<std::string> CommandLine;
+  if (uint64_t(FirstArgument) + NumCommandArguments <= NumArguments) {
+    CommandLine.reserve(NumCommandArguments);
+    const unsigned char *Argument = Base + ArgumentsOffset + FirstArgument * 4;
+    for (uint32_t I = 0; I != NumCommandArguments; ++I)
+      CommandLine.push_back(getString(endian::read32le(Argument + I * 4)));
+  }
+  return CompileCommand(getString(endian::read32le(Record)),
+                        getString(endian::read32le(Record + 4)),
+                        std::move(CommandLine),
+                        getString(endian::read32le(Record + 8)));
+}
+
+bool BinaryCompilationDatabase::lookupCommands(
+    StringRef NativeFilePath, std::vector<CompileCommand> &Commands) const {
+  const unsigned char *Base = Buffer->getBuffer().bytes_begin();
+  std::unique_ptr<FileIndexTable> Table(
+      FileIndexTable::Create(Base + IndexOffset, Base));
+  auto It = Table->find(NativeFilePath);
+  if (It == Table->end())
+    return false;
+  StringRef Indices = *It;
+  for (size_t I = 0; I + 4 <= Indices.size(); I += 4) {
+    uint32_t Index =
+        llvm::support::endian::read32le(Indices.bytes_begin() + I);
+    if (Index < NumCommands)
+      Commands.push_back(getCommand(Index));
+  }
+  return true;
+}
+
+std::vector<CompileCommand>
+BinaryCompilationDatabase::getCompileCommands(StringRef FilePath) const {
+  SmallString<128> NativeFilePath;
+  llvm::sys::path::native(FilePath, NativeFilePath);
+
+  std::vector<CompileCommand> Commands;
+  if (lookupCommands(NativeFilePath, Commands))
+    return Commands;
+
+  std::call_once(MatchTrieFlag, [this] {
+    for (const std::string &File : getAllFiles())
+      MatchTrie.insert(File);
+  });
+  std::string Error;
+  llvm::raw_string_ostream ES(Error);
+  StringRef Match = MatchTrie.findEquivalent(NativeFilePath, ES);
+  if (!Match.empty())
+    lookupCommands(Match, Commands);
+  return Commands;
+}
+
+std::vector<std::string> BinaryCompilationDatabase::getAllFiles() const {
+  const unsigned char *Files = Buffer->getBuffer().bytes_begin() + FilesOffset;
+  std::vector<std::string> Result;
+  Result.reserve(NumFiles);
+  for (uint32_t I = 0; I != NumFiles; ++I)
+    Result.push_back(getString(llvm::support::endian::read32le(Files + I * 4)));
+  return Result;
+}
+
+std::vector<CompileCommand>
+BinaryCompilationDatabase::getAllCompileCommands() const {
+  std::vector<CompileCommand> Commands;
+  Commands.reserve(NumCommands);
+  for (uint32_t I = 0; I != NumCommands; ++I)
+    Commands.push_back(getCommand(I));
+  return Commands;
+}
+
+} // end namespace tooling
+} // end namespace clang
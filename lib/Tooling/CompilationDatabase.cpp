@@ -342,5 +342,10 @@ namespace tooling {
 extern volatile int JSONAnchorSource;
 static int LLVM_ATTRIBUTE_UNUSED JSONAnchorDest = JSONAnchorSource;
 
+// This anchor is used to force the linker to link in the generated object file
+// and thus register the BinaryCompilationDatabasePlugin.
+extern volatile int BinaryAnchorSource;
+static int LLVM_ATTRIBUTE_UNUSED BinaryAnchorDest = BinaryAnchorSource;
+
 } // end namespace tooling
 } // end namespace clang
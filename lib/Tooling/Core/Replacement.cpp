@@ -325,6 +325,42 @@ llvm::Error Replacements::add(const Replacement &R) {
 
 namespace {
 
+llvm::Expected<Replacements>
+Replacements::createFromUnsorted(std::vector<Replacement> Replaces) {
+  Replacements Result;
+  if (Replaces.empty())
+    return Result;
+
+  for (const Replacement &R : Replaces)
+    if (R.getFilePath() != Replaces.front().getFilePath())
+      return llvm::make_error<ReplacementError>(
+          replacement_error::wrong_file_path, R, Replaces.front());
+
+  std::sort(Replaces.begin(), Replaces.end());
+  for (const Replacement &R : Replaces) {
+    // Header insertions sort last, and never conflict.
+    if (R.getOffset() == UINT_MAX || Result.Replaces.empty()) {
+      Result.Replaces.insert(Result.Replaces.end(), R);
+      continue;
+    }
+    // The replacements in `Result` don't overlap, so the last one ends after
+    // all the others, and `R` doesn't start before it. `R` can only conflict
+    // with the replacements before it if it starts before the end of the last
+    // one, or if both are insertions at the same offset. Let `add()` handle
+    // these cases.
+    const Replacement &Last = *Result.Replaces.rbegin();
+    bool BothInsertions = R.getLength() == 0 && Last.getLength() == 0;
+    if (R.getOffset() < Last.getOffset() + Last.getLength() ||
+        (BothInsertions && R.getOffset() == Last.getOffset())) {
+      if (auto Err = Result.add(R))
+        return std::move(Err);
+      continue;
+    }
+    Result.Replaces.insert(Result.Replaces.end(), R);
+  }
+  return Result;
+}
+
 // Represents a merged replacement, i.e. a replacement consisting of multiple
 // overlapping replacements from 'First' and 'Second' in mergeReplacements.
 //
@@ -555,28 +591,25 @@ llvm::Expected<std::string> applyAllReplacements(StringRef Code,
   if (Replaces.empty())
     return Code.str();
 
-  IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
-      new vfs::InMemoryFileSystem);
-  FileManager Files(FileSystemOptions(), InMemoryFileSystem);
-  DiagnosticsEngine Diagnostics(
-      IntrusiveRefCntPtr<DiagnosticIDs>(new DiagnosticIDs),
-      new DiagnosticOptions);
-  SourceManager SourceMgr(Diagnostics, Files);
-  Rewriter Rewrite(SourceMgr, LangOptions());
-  InMemoryFileSystem->addFile(
-      "<stdin>", 0, llvm::MemoryBuffer::getMemBuffer(Code, "<stdin>"));
-  FileID ID = SourceMgr.createFileID(Files.getFile("<stdin>"), SourceLocation(),
-                                     clang::SrcMgr::C_User);
-  for (auto I = Replaces.rbegin(), E = Replaces.rend(); I != E; ++I) {
-    Replacement Replace("<stdin>", I->getOffset(), I->getLength(),
-                        I->getReplacementText());
-    if (!Replace.apply(Rewrite))
+  // The replacements are sorted and don't overlap, so they can be applied in
+  // a single pass over the code.
+  std::vector<RewriteEdit> Edits;
+  Edits.reserve(Replaces.size());
+  for (const Replacement &R : Replaces) {
+    if (R.getOffset() > Code.size() ||
+        R.getLength() > Code.size() - R.getOffset())
       return llvm::make_error<ReplacementError>(
-          replacement_error::fail_to_apply, Replace);
+          replacement_error::fail_to_apply,
+          Replacement("<stdin>", R.getOffset(), R.getLength(),
+                      R.getReplacementText()));
+    Edits.emplace_back(R.getOffset(), R.getLength(), R.getReplacementText());
   }
   std::string Result;
+  Result.reserve(Code.size());
   llvm::raw_string_ostream OS(Result);
-  Rewrite.getEditBuffer(ID).write(OS);
+  bool Failed = writeEditedBuffer(OS, Code, Edits);
+  assert(!Failed && "Replacements must be sorted and must not overlap.");
+  (void)Failed;
   OS.flush();
   return Result;
 }
@@ -183,13 +183,12 @@ createReplacementsForHeaders(llvm::StringRef FilePath, llvm::StringRef Code,
 llvm::Expected<Replacements>
 combineReplacementsInChanges(llvm::StringRef FilePath,
                              llvm::ArrayRef<AtomicChange> Changes) {
-  Replacements Replaces;
+  std::vector<Replacement> Replaces;
   for (const auto &Change : Changes)
     for (const auto &R : Change.getReplacements())
-      if (auto Err = Replaces.add(Replacement(
-              FilePath, R.getOffset(), R.getLength(), R.getReplacementText())))
-        return std::move(Err);
-  return Replaces;
+      Replaces.emplace_back(FilePath, R.getOffset(), R.getLength(),
+                            R.getReplacementText());
+  return Replacements::createFromUnsorted(std::move(Replaces));
 }
 
 } // end namespace
@@ -0,0 +1,87 @@
+/*===- CheckProfile.c - Runtime for -fcheckedc-check-profile --------------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+/*
+ * Each module compiled with -fcheckedc-check-profile has a table with one
+ * record per Checked C dynamic check, keyed by source location and kind.  A
+ * constructor in the module registers the table here.  At exit, the counts
+ * of all registered tables are written to the file named by the environment
+ * variable CHECKEDC_CHECK_PROFILE, or to stderr if it is not set, one line
+ * per check:
+ *
+ *   file:line:column: kind count
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Must match the record type in clang's lib/CodeGen/CGDynamicCheck.cpp. */
+struct __checkedc_check_profile_record {
+  const char *file;
+  unsigned line;
+  unsigned column;
+  unsigned kind;
+  unsigned long long *counter;
+};
+
+struct check_profile_table {
+  struct __checkedc_check_profile_record *records;
+  unsigned count;
+  struct check_profile_table *next;
+};
+
+static struct check_profile_table *tables;
+
+/* Indexed by CodeGenFunction::DynamicCheckKind. */
+static const char *const kind_names[] = {
+  "explicit", "non-null", "range", "cast", "overflow"
+};
+
+static const char *kind_name(unsigned kind) {
+  if (kind < sizeof(kind_names) / sizeof(kind_names[0]))
+    return kind_names[kind];
+  return "unknown";
+}
+
+static void write_check_profile(void) {
+  const char *name = getenv("CHECKEDC_CHECK_PROFILE");
+  FILE *out = stderr;
+  struct check_profile_table *table;
+  unsigned i;
+
+  if (name && *name) {
+    out = fopen(name, "w");
+    if (!out) {
+      fprintf(stderr, "checkedc-check-profile: cannot open '%s'\n", name);
+      return;
+    }
+  }
+
+  for (table = tables; table; table = table->next)
+    for (i = 0; i < table->count; i++) {
+      const struct __checkedc_check_profile_record *r = &table->records[i];
+      fprintf(out, "%s:%u:%u: %s %llu\n", r->file, r->line, r->column,
+              kind_name(r->kind), *r->counter);
+    }
+
+  if (out != stderr)
+    fclose(out);
+}
+
+void __checkedc_check_profile_register(
+    struct __checkedc_check_profile_record *records, unsigned count) {
+  struct check_profile_table *table = malloc(sizeof(*table));
+  if (!table)
+    return;
+  if (!tables)
+    atexit(write_check_profile);
+  table->records = records;
+  table->count = count;
+  table->next = tables;
+  tables = table;
+}
@@ -0,0 +1,37 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config jobs=3 -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-output=plist -o %t.serial.plist %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-config jobs=3 -analyzer-output=plist -o %t.parallel.plist %s
+// RUN: diff %t.serial.plist %t.parallel.plist
+
+// The top level functions are analyzed on several processes, and the reports
+// are the same as with a single one.
+
+void deref(int *p) {
+  *p = 0; // expected-warning {{Dereference of null pointer (loaded from variable 'p')}}
+}
+
+void callsDeref() {
+  deref(0);
+}
+
+int divide(int x, int y) {
+  return x / y; // expected-warning {{Division by zero}}
+}
+
+int callsDivide() {
+  return divide(1, 0);
+}
+
+int noReports(int x) {
+  return x + 1;
+}
+
+int uninitialized() {
+  int x;
+  return x; // expected-warning {{Undefined or garbage value returned to caller}}
+}
+
+void alsoNull() {
+  int *p = 0;
+  *p = 1; // expected-warning {{Dereference of null pointer (loaded from variable 'p')}}
+}
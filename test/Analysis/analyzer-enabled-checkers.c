@@ -3,6 +3,7 @@
 
 // CHECK: OVERVIEW: Clang Static Analyzer Enabled Checkers List
 // CHECK: core.CallAndMessage
+// CHECK: core.CheckedCDynamicChecks
 // CHECK: core.DivideZero
 // CHECK: core.DynamicTypePropagation
 // CHECK: core.NonNullParamChecker
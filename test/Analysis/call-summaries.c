@@ -0,0 +1,67 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -analyzer-config ipa=none,call-summaries=true -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -analyzer-config ipa=none -DNO_SUMMARIES -verify %s
+
+void clang_analyzer_eval(int);
+
+int global;
+
+int square(int x) {
+  int result = x * x;
+  return result;
+}
+
+int sign(int x) {
+  if (x > 0)
+    return 1;
+  if (x < 0)
+    return -1;
+  return 0;
+}
+
+int setGlobal(int x) {
+  global = x;
+  return 3;
+}
+
+int recurse(int x) {
+  return x ? recurse(x - 1) : 0;
+}
+
+int callsPure(int x) {
+  int a[2];
+  a[0] = square(x);
+  return a[0];
+}
+
+void noSideEffects(void) {
+  global = 1;
+  square(2);
+  callsPure(2);
+#ifdef NO_SUMMARIES
+  clang_analyzer_eval(global == 1); // expected-warning{{UNKNOWN}}
+#else
+  clang_analyzer_eval(global == 1); // expected-warning{{TRUE}}
+#endif
+}
+
+void sideEffects(void) {
+  global = 1;
+  recurse(2);
+  clang_analyzer_eval(global == 1); // expected-warning{{UNKNOWN}}
+  global = 1;
+  setGlobal(2);
+  clang_analyzer_eval(global == 1); // expected-warning{{UNKNOWN}}
+}
+
+void returnValues(int x) {
+#ifdef NO_SUMMARIES
+  clang_analyzer_eval(setGlobal(x) == 3); // expected-warning{{UNKNOWN}}
+  clang_analyzer_eval(sign(x) <= 1); // expected-warning{{UNKNOWN}}
+#else
+  clang_analyzer_eval(setGlobal(x) == 3); // expected-warning{{TRUE}}
+  clang_analyzer_eval(sign(x) <= 1); // expected-warning{{TRUE}}
+  int s = sign(x);
+  clang_analyzer_eval(s != 0 && s != 1 && s != -1); // expected-warning{{FALSE}}
+  clang_analyzer_eval(square(x) == 4); // expected-warning{{UNKNOWN}}
+#endif
+}
@@ -0,0 +1,51 @@
+// RUN: %clang_analyze_cc1 -fcheckedc-extension -analyzer-checker=core,debug.ExprInspection -verify %s
+
+void clang_analyzer_eval(int);
+void clang_analyzer_warnIfReached(void);
+
+void explicit_check(int x) {
+  _Dynamic_check(x > 10);
+  clang_analyzer_eval(x > 10); // expected-warning {{TRUE}}
+}
+
+void failed_explicit_check(void) {
+  _Dynamic_check(0);
+  clang_analyzer_warnIfReached(); // no-warning
+}
+
+int in_bounds(_Array_ptr<int> p : count(2)) {
+  int x = p[1];
+  clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  return x;
+}
+
+int out_of_bounds(_Array_ptr<int> p : count(2)) {
+  int x = p[5];
+  clang_analyzer_warnIfReached(); // no-warning
+  return x;
+}
+
+int out_of_bounds_deref(_Array_ptr<int> p : count(2)) {
+  int x = *(p + 2);
+  clang_analyzer_warnIfReached(); // no-warning
+  return x;
+}
+
+int nt_read_at_upper_bound(_Nt_array_ptr<char> p : count(2)) {
+  char c = p[2];
+  clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  return c;
+}
+
+int bounds_cast(_Array_ptr<int> p : count(4)) {
+  _Array_ptr<int> q : count(2) = _Dynamic_bounds_cast<_Array_ptr<int>>(p, count(2));
+  clang_analyzer_warnIfReached(); // expected-warning {{REACHABLE}}
+  return q[1];
+}
+
+int failed_bounds_cast(void) {
+  int a _Checked[4] = { 0 };
+  _Array_ptr<int> q : count(8) = _Dynamic_bounds_cast<_Array_ptr<int>>(a, count(8));
+  clang_analyzer_warnIfReached(); // no-warning
+  return q[0];
+}
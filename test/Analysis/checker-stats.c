@@ -0,0 +1,18 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-checker-stats %s 2>&1 | FileCheck %s
+
+int load(int *p) {
+  return *p;
+}
+
+int divide(int x) {
+  if (x)
+    return 10 / x;
+  return 0;
+}
+
+// CHECK: {
+// CHECK-NEXT: "checkers": [
+// CHECK: { "checker": "core.DivideZero", "callback": "PreStmt", "calls": {{[1-9][0-9]*}}, "nodes": {{[0-9]+}}, "wall_time": {{[0-9.]+}}, "process_time": {{[0-9.]+}}, "mem_used": {{-?[0-9]+}} }
+// CHECK: { "checker": "core.NullDereference", "callback": "Location", "calls": {{[1-9][0-9]*}}, "nodes": {{[0-9]+}},
+// CHECK: ]
+// CHECK-NEXT: }
@@ -0,0 +1,36 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: sed -e 's/@VALUE@/1/' %s > %t/input.c
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress -analyzer-incremental-cache %t/cache %t/input.c 2>&1 | FileCheck %s --check-prefix=FIRST
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress -analyzer-incremental-cache %t/cache %t/input.c 2>&1 | FileCheck %s --check-prefix=UNCHANGED
+// RUN: sed -e 's/@VALUE@/2/' %s > %t/input.c
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-display-progress -analyzer-incremental-cache %t/cache %t/input.c 2>&1 | FileCheck %s --check-prefix=CHANGED
+
+// The functions are analyzed again only if they produced reports, or if they
+// or one of the functions inlined into them changed.
+
+int callee(int x) {
+  return x + @VALUE@;
+}
+
+int clean(int x) {
+  return callee(x);
+}
+
+int divide(int x) {
+  if (x == 0)
+    return 1 / x;
+  return 0;
+}
+
+// FIRST-DAG: (Path,  Inline_Regular): {{.*}}input.c clean
+// FIRST-DAG: (Path,  Inline_Regular): {{.*}}input.c divide
+// FIRST-DAG: warning: Division by zero
+
+// UNCHANGED-NOT: (Path,  Inline_Regular): {{.*}}input.c c{{allee|lean}}
+// UNCHANGED: (Path,  Inline_Regular): {{.*}}input.c divide
+// UNCHANGED-NOT: (Path,  Inline_Regular): {{.*}}input.c c{{allee|lean}}
+// UNCHANGED: warning: Division by zero
+// UNCHANGED-NOT: (Path,  Inline_Regular): {{.*}}input.c c{{allee|lean}}
+
+// CHANGED-DAG: (Path,  Inline_Regular): {{.*}}input.c clean
+// CHANGED-DAG: (Path,  Inline_Regular): {{.*}}input.c divide
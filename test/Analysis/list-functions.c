@@ -0,0 +1,16 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-list-functions %s | FileCheck %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core -analyzer-list-functions -analyzer-config ipa=none %s | FileCheck %s
+
+void callee(int *p) {
+  *p = 0;
+}
+
+void caller(void) {
+  int x;
+  callee(&x);
+}
+
+// The functions are listed whether or not they would be inlined.
+// CHECK-DAG: FUNCTION: callee
+// CHECK-DAG: FUNCTION: caller
+// CHECK-NOT: FUNCTION:
@@ -0,0 +1,43 @@
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -analyzer-config merge-states=true -verify %s
+// RUN: %clang_analyze_cc1 -analyzer-checker=core,debug.ExprInspection -DNO_MERGE -verify %s
+
+void clang_analyzer_eval(int);
+void clang_analyzer_numTimesReached();
+
+int chain(int a, int b, int c) {
+  if (a) {}
+  if (b) {}
+  if (c) {}
+#ifdef NO_MERGE
+  clang_analyzer_numTimesReached(); // expected-warning {{8}}
+#else
+  clang_analyzer_numTimesReached(); // expected-warning {{4}}
+#endif
+  return a + b + c;
+}
+
+int widened(int x) {
+  if (x == 0)
+    clang_analyzer_eval(x == 0); // expected-warning {{TRUE}}
+  else
+    clang_analyzer_eval(x == 0); // expected-warning {{FALSE}}
+#ifdef NO_MERGE
+  clang_analyzer_eval(x == 0); // expected-warning {{TRUE}} expected-warning {{FALSE}}
+#else
+  // The else branch reaches the join point first and keeps its constraints;
+  // the other path continues with constraints covering both paths.
+  clang_analyzer_eval(x == 0); // expected-warning {{FALSE}} expected-warning {{UNKNOWN}}
+#endif
+  return x;
+}
+
+int differentStores(int x) {
+  int y;
+  if (x > 0)
+    y = 1;
+  else
+    y = 2;
+  // Paths with different stores are not merged.
+  clang_analyzer_eval(y == 1); // expected-warning {{TRUE}} expected-warning {{FALSE}}
+  return x;
+}
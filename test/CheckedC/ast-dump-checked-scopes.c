@@ -54,3 +54,39 @@ _Unchecked void f5(void) {}
 // For inherited-unchecked, we don't print anything to avoid breaking
 // existing tests.
 // CHECK-NOT: {{.*-checked}}
+
+// In checked scopes, accesses that are proved to be in bounds have the
+// None bounds check kind, and are not checked at runtime.
+
+struct S {
+  int f;
+};
+
+int f6(int i, _Array_ptr<struct S> p : count(1)) _Checked {
+  int a _Checked[10] = { 0 };
+  return a[3] + a[i] + p->f;
+}
+
+// CHECK: FunctionDecl {{.*}} f6
+// CHECK: ArraySubscriptExpr
+// CHECK-NEXT: Bounds
+// CHECK: BoundsCheckKind None
+// CHECK: ArraySubscriptExpr
+// CHECK-NEXT: Bounds
+// CHECK: BoundsCheckKind Normal
+// CHECK: MemberExpr {{.*}} ->f
+// CHECK-NEXT: Base Expr Bounds
+// CHECK: BoundsCheckKind None
+
+int f7(int i, _Array_ptr<struct S> p : count(1)) {
+  int a _Checked[10] = { 0 };
+  return a[3] + p->f;
+}
+
+// CHECK: FunctionDecl {{.*}} f7
+// CHECK: ArraySubscriptExpr
+// CHECK-NEXT: Bounds
+// CHECK: BoundsCheckKind Normal
+// CHECK: MemberExpr {{.*}} ->f
+// CHECK-NEXT: Base Expr Bounds
+// CHECK: BoundsCheckKind Normal
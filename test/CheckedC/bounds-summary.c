@@ -0,0 +1,24 @@
+// Tests the summary of the Checked C bounds of the arguments of calls that
+// clang-func-mapping writes with -bounds-summary.
+//
+// RUN: %clang_func_map -bounds-summary %s -- -fcheckedc-extension | FileCheck %s
+
+int sum(_Array_ptr<int> p : count(n), int n, int *q);
+int first(_Array_ptr<int> p : count(1));
+int plain(int x);
+
+// The smallest number of elements over the calls is recorded for each
+// checked array pointer argument.  Other arguments prove nothing.
+// CHECK: c:@F@sum 3 8 -1 -1
+int f1(_Array_ptr<int> a : count(10), int *q) {
+  return sum(a, 10, q) + sum(a + 2, 8, q) + sum(a, 9, q);
+}
+
+// Arguments whose bounds are not constant-sized prove nothing, and calls to
+// functions without bounds are recorded too.
+// CHECK: c:@F@first 2 -1
+// CHECK: c:@F@plain 1
+int f2(_Array_ptr<int> a : count(n), int n) {
+  int b _Checked[4] = { 0 };
+  return first(a) + first(b) + plain(n);
+}
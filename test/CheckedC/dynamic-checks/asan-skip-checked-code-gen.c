@@ -0,0 +1,58 @@
+// Tests that the accesses that Checked C checks are in bounds are kept from
+// AddressSanitizer instrumentation (-fcheckedc-asan-skip-checked-accesses).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fsanitize=address -fcheckedc-asan-skip-checked-accesses %s -emit-llvm -O0 -disable-llvm-passes -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fsanitize=address %s -emit-llvm -O0 -disable-llvm-passes -o - | FileCheck %s --check-prefix=NOSKIP
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-asan-skip-checked-accesses %s -emit-llvm -O0 -disable-llvm-passes -o - | FileCheck %s --check-prefix=NOSKIP
+
+// NOSKIP-NOT: !nosanitize
+
+// The read of p[i] is checked at run time.
+// CHECK-LABEL: define i32 @f1
+// CHECK: _Dynamic_check.succeeded:
+// CHECK: load i32, i32* %{{.*}}, align 4, !nosanitize
+// CHECK: }
+int f1(_Array_ptr<int> p : count(n), int n, int i) {
+  return p[i];
+}
+
+// The store through *p is checked at run time.
+// CHECK-LABEL: define void @f2
+// CHECK: _Dynamic_check.succeeded:
+// CHECK: store i32 %{{.*}}, i32* %{{.*}}, align 4, !nosanitize
+// CHECK: }
+void f2(_Array_ptr<int> p : count(1), int v) {
+  *p = v;
+}
+
+// The check of p[2] is proved statically, so there is no dynamic check, but
+// the access is still in bounds.
+// CHECK-LABEL: define i32 @f3
+// CHECK-NOT: _Dynamic_check
+// CHECK: load i32, i32* %{{.*}}, align 4, !nosanitize
+// CHECK: }
+int f3(_Array_ptr<int> p : count(10)) {
+  return p[2];
+}
+
+// A member of a struct reached through a checked pointer is within the
+// struct.
+struct S {
+  int a;
+  int b;
+};
+
+// CHECK-LABEL: define i32 @f4
+// CHECK: load i32, i32* %b, align 4, !nosanitize
+// CHECK: }
+int f4(_Array_ptr<struct S> s : count(1)) {
+  return s->b;
+}
+
+// Accesses through unchecked pointers are left to AddressSanitizer.
+// CHECK-LABEL: define i32 @f5
+// CHECK-NOT: !nosanitize
+// CHECK: }
+int f5(int *p, int i) {
+  return p[i];
+}
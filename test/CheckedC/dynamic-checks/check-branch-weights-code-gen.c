@@ -0,0 +1,17 @@
+// Tests that dynamic checks are marked as unlikely to fail and that their
+// failure paths are marked cold.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering %s -emit-llvm -O0 -o - | FileCheck %s
+
+// CHECK-LABEL: define i32 @f1
+// CHECK: br i1 %_Dynamic_check.non_null, label %{{.*}}, label %{{.*}}, !prof ![[WEIGHTS:[0-9]+]]
+// CHECK: br i1 %_Dynamic_check.range, label %{{.*}}, label %{{.*}}, !prof ![[WEIGHTS]]
+// CHECK: _Dynamic_check.failed{{[a-zA-Z0-9.]*}}:
+// CHECK-NEXT: call void @llvm.trap() #[[TRAP:[0-9]+]]
+int f1(_Array_ptr<int> p : count(n), int n) {
+  return p[1];
+}
+
+// CHECK: attributes #[[TRAP]] = { cold
+// CHECK: ![[WEIGHTS]] = !{!"branch_weights", i32 1048575, i32 1}
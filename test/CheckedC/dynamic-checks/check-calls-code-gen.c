@@ -0,0 +1,55 @@
+// Tests for lowering dynamic bounds checks to calls to an out-of-line helper
+// (-fcheckedc-check-calls).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-check-calls %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-check-calls %s -emit-llvm -Os -o - | FileCheck %s --check-prefix=CHECK-OPT
+// RUN: %clang_cc1 -triple x86_64-pc-windows-msvc -fcheckedc-extension -fcheckedc-check-calls %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-WIN
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-check-calls -fno-checkedc-check-calls %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-INLINE
+
+int f1(_Array_ptr<int> p : count(n), int n) {
+  return p[0] + p[1] + p[2];
+}
+
+// CHECK-LABEL: define i32 @f1
+// CHECK-NOT: call void @__checkedc_bounds_check
+// CHECK-NOT: _Dynamic_check.range
+// CHECK: call preserve_mostcc void @__checkedc_check_range(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 1)
+// CHECK: call preserve_mostcc void @__checkedc_check_range(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 1)
+// CHECK: call preserve_mostcc void @__checkedc_check_range(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 1)
+// CHECK-NOT: _Dynamic_check.range
+// CHECK: ret i32
+
+// When optimizing, the three range checks are merged into one call.  The
+// non-null check of p is still expanded inline.
+// CHECK-OPT-LABEL: define i32 @f1
+// CHECK-OPT: call preserve_mostcc void @__checkedc_check_range(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 {{[0-9]+}})
+// CHECK-OPT-NOT: call preserve_mostcc void @__checkedc_check_range
+// CHECK-OPT: }
+
+// CHECK-INLINE-LABEL: define i32 @f1
+// CHECK-INLINE-NOT: __checkedc_check_range
+// CHECK-INLINE: br i1 %_Dynamic_check.range{{[0-9]*}}, label %_Dynamic_check.succeeded{{[0-9]*}}, label %_Dynamic_check.failed{{[0-9]*}}
+
+// Reads through null-terminated pointers pass a size of 0.
+int f2(_Nt_array_ptr<char> s : count(0)) {
+  return *s;
+}
+
+// CHECK-LABEL: define i32 @f2
+// CHECK: call preserve_mostcc void @__checkedc_check_range(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 0)
+
+// The helper is defined once in the module, and does the check that the
+// late lowering would have expanded.
+// CHECK: define linkonce_odr hidden preserve_mostcc void @__checkedc_check_range(i8*, i8*, i8*, i64) {{.*}}comdat
+// CHECK: %_Dynamic_check.end = getelementptr i8, i8* %0, i64 %3
+// CHECK: br i1 %_Dynamic_check.range, label %_Dynamic_check.succeeded, label %_Dynamic_check.failed
+// CHECK: ret void
+// CHECK: call void @llvm.trap()
+// CHECK-NOT: define {{.*}} @__checkedc_check_range
+
+// CHECK-OPT: define linkonce_odr hidden preserve_mostcc void @__checkedc_check_range(i8*, i8*, i8*, i64) {{.*}}comdat
+
+// Windows targets use the C calling convention for the helper.
+// CHECK-WIN-LABEL: define {{.*}}i32 @f1
+// CHECK-WIN: call void @__checkedc_check_range(
+// CHECK-WIN: define linkonce_odr hidden void @__checkedc_check_range(i8*, i8*, i8*, i64) {{.*}}comdat
@@ -0,0 +1,33 @@
+// Tests for counting the executions of dynamic checks
+// (-fcheckedc-check-profile).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-check-profile %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=NOPROFILE
+
+// Each check gets its own counter, and the table of counters is registered
+// by a module constructor.
+// CHECK: [[NONNULL:@__checkedc_check_counter[0-9.]*]] = private global i64 0, align 8
+// CHECK: [[RANGE:@__checkedc_check_counter[0-9.]*]] = private global i64 0, align 8
+// CHECK: @__checkedc_check_profile_records = private constant [2 x { i8*, i32, i32, i32, i64* }]
+// CHECK-SAME: { i8* getelementptr {{.*}}, i32 [[@LINE+16]], i32 10, i32 1, i64* [[NONNULL]] }
+// CHECK-SAME: { i8* getelementptr {{.*}}, i32 [[@LINE+15]], i32 10, i32 2, i64* [[RANGE]] }
+// CHECK: @llvm.global_ctors = appending global {{.*}} @__checkedc_check_profile_init
+//
+// NOPROFILE-NOT: __checkedc_check
+
+// CHECK-LABEL: define i32 @f1
+// CHECK: [[COUNT:%_Dynamic_check.count[0-9]*]] = load i64, i64* [[NONNULL]]
+// CHECK-NEXT: [[INC:%[a-zA-Z0-9.]*]] = add i64 [[COUNT]], 1
+// CHECK-NEXT: store i64 [[INC]], i64* [[NONNULL]]
+// CHECK: _Dynamic_check.non_null
+// CHECK: [[COUNT2:%_Dynamic_check.count[0-9]*]] = load i64, i64* [[RANGE]]
+// CHECK-NEXT: [[INC2:%[a-zA-Z0-9.]*]] = add i64 [[COUNT2]], 1
+// CHECK-NEXT: store i64 [[INC2]], i64* [[RANGE]]
+// CHECK: _Dynamic_check.range
+int f1(_Array_ptr<int> p : count(n), int n, int i) {
+  return p[i];
+}
+
+// CHECK-LABEL: define internal void @__checkedc_check_profile_init()
+// CHECK: call void @__checkedc_check_profile_register({ i8*, i32, i32, i32, i64* }* getelementptr inbounds ({{.*}} @__checkedc_check_profile_records, i32 0, i32 0), i32 2)
+// CHECK-NEXT: ret void
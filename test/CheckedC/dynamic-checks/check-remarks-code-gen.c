@@ -0,0 +1,60 @@
+// Tests of the checkedc-checks optimization remarks, which report the
+// dynamic checks that are left after optimization and the ones that the
+// optimizer removed.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-hoist-checks %s -O0 -Rpass-missed=checkedc-checks -emit-llvm-only -verify
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering %s -O2 -Rpass=checkedc-checks -Rpass-missed=checkedc-checks -emit-llvm-only -verify -DOPT
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -O0 -Rpass-missed=checkedc-checks -emit-llvm -o - 2>/dev/null | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -O0 -opt-record-file %t.yaml -emit-llvm-only
+// RUN: FileCheck %s --check-prefix=YAML < %t.yaml
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -O0 -emit-llvm -o - | FileCheck %s --check-prefix=NOTAGS
+
+#ifndef OPT
+int g _Checked[10];
+
+// Each check that is emitted is tagged with its kind and origin.
+// CHECK-LABEL: define i32 @f1
+// CHECK: br i1 %_Dynamic_check.non_null{{.*}}, !checkedc.check ![[NONNULL:[0-9]+]]
+// CHECK: br i1 %_Dynamic_check.range{{.*}}, !checkedc.check ![[RANGE:[0-9]+]]
+//
+// NOTAGS-NOT: !checkedc.check
+int f1(_Array_ptr<int> p : count(n), int n, int i) {
+  return p[i]; // expected-remark {{non-null check was not removed}} expected-remark {{range check was not removed}}
+}
+
+// The checks in a loop are reported with the depth of the loop.  The
+// index is not the induction variable, so the check is not hoisted.
+int f2(int m) {
+  int sum = 0;
+  for (int j = 0; j < m; j++)
+    sum += g[j % 10]; // expected-remark {{range check in a loop of depth 1 was not removed}}
+  return sum;
+}
+
+// Checks hoisted out of a loop are reported as such.
+int f3(_Array_ptr<int> p : count(n), int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++)
+    sum += p[i]; // expected-remark {{non-null check was not removed (hoisted)}} expected-remark {{range check was not removed (hoisted)}}
+  return sum;
+}
+
+// CHECK: !checkedc.checks = !{![[NONNULL]], ![[RANGE]],
+// CHECK: ![[NONNULL]] = distinct !{!"non-null", !"access", !{{[0-9]+}}, i32 (i32*, i32, i32)* @f1}
+// CHECK: ![[RANGE]] = distinct !{!"range", !"access", !{{[0-9]+}}, i32 (i32*, i32, i32)* @f1}
+
+// YAML: Pass: checkedc-checks
+// YAML-NEXT: Name: CheckNotRemoved
+// YAML-NEXT: DebugLoc: { File: {{.*}}check-remarks-code-gen.c{{.*}}, Line: 22, Column: {{[0-9]+}} }
+// YAML-NEXT: Function: f1
+// YAML-NEXT: Args:
+// YAML-NEXT: - Kind: non-null
+// YAML-NEXT: - String: ' check was not removed'
+
+#else
+// Late lowering merges the three range checks into one, and removes the
+// other two.
+int f4(_Array_ptr<int> p : count(n), int n) {
+  return p[0] + p[1] + p[2]; // expected-remark {{non-null check was not removed}} expected-remark {{range check was not removed}} expected-remark 2 {{range check was removed by optimization}}
+}
+#endif
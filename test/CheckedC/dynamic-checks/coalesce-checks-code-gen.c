@@ -0,0 +1,52 @@
+// Tests for coalescing dynamic bounds checks on the same base and bounds in
+// straight-line code (-fcheckedc-coalesce-checks).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-coalesce-checks %s -emit-llvm -O0 -o - | FileCheck %s
+
+// The three reads are checked once, for the offsets 0 ... 2 from i.
+// CHECK-LABEL: define i32 @f1
+// CHECK: add i64 {{%[a-zA-Z0-9.]*}}, 0
+// CHECK: add i64 {{%[a-zA-Z0-9.]*}}, 2
+// CHECK: _Dynamic_check.range
+// CHECK-NOT: _Dynamic_check.range
+// CHECK: ret i32
+int f1(_Array_ptr<int> p : count(n), int n, int i) {
+  int a = p[i];
+  int b = p[i + 1];
+  int c = p[i + 2];
+  return a + b + c;
+}
+
+struct S {
+  int a;
+  int b;
+  int c;
+};
+
+// Field-by-field reads through the same pointer are checked once.
+// CHECK-LABEL: define i32 @f2
+// CHECK: _Dynamic_check.range
+// CHECK-NOT: _Dynamic_check.range
+// CHECK: ret i32
+int f2(_Array_ptr<struct S> s : count(1)) {
+  int x = s->a;
+  x += s->b;
+  x += s->c;
+  return x;
+}
+
+// Control flow ends a run of statements, and accesses whose index changes
+// are not coalesced.
+// CHECK-LABEL: define i32 @f3
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: ret i32
+int f3(_Array_ptr<int> p : count(n), int n, int i) {
+  int a = p[i];
+  if (a)
+    a = p[i + 1];
+  i++;
+  a += p[i];
+  return a;
+}
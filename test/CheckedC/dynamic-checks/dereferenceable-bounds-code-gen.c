@@ -0,0 +1,47 @@
+// Tests that checked pointers with constant bounds are marked as
+// dereferenceable_or_null (-fcheckedc-dereferenceable-bounds).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-dereferenceable-bounds %s -emit-llvm -O0 -disable-llvm-passes -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -disable-llvm-passes -o - | FileCheck %s --check-prefix=NODEREF
+
+// NODEREF-NOT: dereferenceable_or_null
+
+// CHECK-LABEL: define i32 @f1(i32* dereferenceable_or_null(64) %p)
+int f1(_Array_ptr<int> p : count(16)) {
+  return p[3];
+}
+
+// CHECK-LABEL: define i32 @f2(i32* dereferenceable_or_null(12) %p)
+int f2(_Array_ptr<int> p : byte_count(12)) {
+  return p[1];
+}
+
+// CHECK-LABEL: define i32 @f3(i32* dereferenceable_or_null(4) %p)
+int f3(_Ptr<int> p) {
+  return *p;
+}
+
+// The bounds are not constant.
+// CHECK-LABEL: define i32 @f4(i32* %p, i32 %n)
+int f4(_Array_ptr<int> p : count(n), int n) {
+  return p[0];
+}
+
+// Unchecked pointers are not marked.
+// CHECK-LABEL: define i32 @f5(i32* %p)
+int f5(int *p) {
+  return *p;
+}
+
+// A _Ptr loaded from memory is null or points to its referent.
+struct Node {
+  int value;
+  _Ptr<struct Node> next;
+};
+
+// CHECK-LABEL: define i32 @f6
+// CHECK: load %struct.Node*, %struct.Node** %{{.*}}, align 8, !dereferenceable_or_null ![[SIZE:[0-9]+]]
+// CHECK: ![[SIZE]] = !{i64 16}
+int f6(_Ptr<struct Node> n) {
+  return n->next->value;
+}
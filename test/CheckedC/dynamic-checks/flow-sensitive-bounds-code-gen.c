@@ -0,0 +1,32 @@
+// Tests that accesses proved in bounds with dataflow facts are not checked
+// at runtime (-fcheckedc-flow-sensitive-bounds).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-flow-sensitive-bounds %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=NOFACTS
+
+// q is known to equal p, so q[1] is within bounds(p, p + 3).  The pointer
+// is still checked for null.
+// CHECK-LABEL: define i32 @f1
+// CHECK: _Dynamic_check.non_null
+// CHECK-NOT: _Dynamic_check.range
+// CHECK: ret i32
+//
+// NOFACTS-LABEL: define i32 @f1
+// NOFACTS: _Dynamic_check.range
+int f1(_Array_ptr<int> p : count(3)) {
+  _Array_ptr<int> q : bounds(p, p + 3) = p;
+  return q[1];
+}
+
+// Accesses at variable offsets are still checked, and so are accesses
+// after the facts that prove them are ended by an assignment.
+// CHECK-LABEL: define i32 @f2
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: ret i32
+int f2(_Array_ptr<int> p : count(3), _Array_ptr<int> r : count(3), int i) {
+  _Array_ptr<int> q : bounds(p, p + 3) = p;
+  int x = p[i];
+  q = r;
+  return x + q[1];
+}
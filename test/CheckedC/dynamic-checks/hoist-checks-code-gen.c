@@ -0,0 +1,81 @@
+// Tests for hoisting loop-invariant dynamic bounds checks into the loop
+// preheader (-fcheckedc-hoist-checks).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-hoist-checks %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=NOHOIST
+
+// The check for p[i] is done once, before the loop.
+// CHECK-LABEL: define i32 @f1
+// CHECK: _Dynamic_check.hoisted:
+// CHECK: [[FIRST:%_Dynamic_check.first_index[a-zA-Z0-9.]*]] = sext i32 {{%[a-zA-Z0-9.]*}} to i64
+// CHECK: [[LAST:%_Dynamic_check.last_index[a-zA-Z0-9.]*]] = sub i64 {{%[a-zA-Z0-9.]*}}, 1
+// CHECK: _Dynamic_check.non_null
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.hoisted.cont:
+// CHECK: for.body:
+// CHECK-NOT: _Dynamic_check
+// CHECK: for.inc:
+//
+// NOHOIST-LABEL: define i32 @f1
+// NOHOIST-NOT: _Dynamic_check.hoisted
+// NOHOIST: for.body:
+// NOHOIST: _Dynamic_check.range
+int f1(_Array_ptr<int> p : count(n), int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++)
+    sum += p[i];
+  return sum;
+}
+
+// Constant offsets from the induction variable are hoisted, as are
+// accesses to checked arrays.
+// CHECK-LABEL: define void @f2
+// CHECK: _Dynamic_check.hoisted:
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: for.body:
+// CHECK-NOT: _Dynamic_check
+// CHECK: for.inc:
+void f2(void) {
+  int a _Checked[10];
+  int b _Checked[11];
+  for (int i = 0; i < 10; ++i) {
+    a[i] = b[i + 1];
+  }
+}
+
+// Accesses that are not executed on every iteration, or whose bounds may
+// change during the loop, are still checked in the body.
+// CHECK-LABEL: define void @f3
+// CHECK-NOT: _Dynamic_check.hoisted
+// CHECK: for.body:
+// CHECK: _Dynamic_check.range
+void f3(_Array_ptr<int> p : count(n), int n) {
+  for (int i = 0; i < n; i++) {
+    if (i != 3)
+      p[i] = 0;
+  }
+}
+
+// CHECK-LABEL: define void @f4
+// CHECK-NOT: _Dynamic_check.hoisted
+// CHECK: for.body:
+// CHECK: _Dynamic_check.range
+void f4(_Array_ptr<int> p : count(n), int n) {
+  for (int i = 0; i < n; i++) {
+    _Array_ptr<int> q : count(n) = p;
+    q[i] = 0;
+  }
+}
+
+// A loop that may exit early is not hoisted.
+// CHECK-LABEL: define void @f5
+// CHECK-NOT: _Dynamic_check.hoisted
+// CHECK: for.body:
+// CHECK: _Dynamic_check.range
+void f5(_Array_ptr<int> p : count(n), int n) {
+  for (int i = 0; i < n; i++) {
+    if (p[i] == 0)
+      break;
+  }
+}
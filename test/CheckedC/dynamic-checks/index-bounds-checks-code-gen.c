@@ -0,0 +1,50 @@
+// Tests for checking subscripts of pointers with count bounds by comparing
+// the index with the count (-fcheckedc-index-bounds-checks).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-index-bounds-checks %s -emit-llvm -O0 -o - | FileCheck %s
+
+// A signed count is clamped at zero, and the index is compared once.
+// CHECK-LABEL: define i32 @f1
+// CHECK: _Dynamic_check.count = select
+// CHECK: _Dynamic_check.index = icmp ult i64
+// CHECK-NOT: _Dynamic_check.lower
+// CHECK: ret i32
+int f1(_Array_ptr<int> p : count(n), int n, int i) {
+  return p[i];
+}
+
+// An unsigned count needs no clamping.
+// CHECK-LABEL: define i32 @f2
+// CHECK-NOT: _Dynamic_check.count
+// CHECK: _Dynamic_check.index = icmp ult i64
+// CHECK: ret i32
+int f2(_Array_ptr<int> p : count(n), unsigned n, int i) {
+  return p[i];
+}
+
+// With byte_count bounds, the index is scaled to bytes.
+// CHECK-LABEL: define i32 @f3
+// CHECK: mul i64 {{%[a-zA-Z0-9.]*}}, 4
+// CHECK: _Dynamic_check.index = icmp ult i64
+// CHECK: ret i32
+int f3(_Array_ptr<int> p : byte_count(n), int n, int i) {
+  return p[i];
+}
+
+// A read through a null-terminated pointer may read at the upper bound.
+// CHECK-LABEL: define signext i8 @f4
+// CHECK: _Dynamic_check.index = icmp ule i64
+// CHECK: ret i8
+char f4(_Nt_array_ptr<char> p : count(n), int n, int i) {
+  return p[i];
+}
+
+// Bounds whose base is not the base of the access are checked as pointers.
+// CHECK-LABEL: define i32 @f5
+// CHECK-NOT: _Dynamic_check.index
+// CHECK: _Dynamic_check.lower
+// CHECK: ret i32
+int f5(_Array_ptr<int> p : bounds(q, q + n), _Array_ptr<int> q, int n,
+       int i) {
+  return p[i];
+}
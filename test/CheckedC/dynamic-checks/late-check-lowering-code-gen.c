@@ -0,0 +1,47 @@
+// Tests for emitting dynamic bounds checks as calls that are expanded late
+// in the LLVM pass pipeline (-fcheckedc-late-check-lowering).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering %s -emit-llvm -O0 -disable-llvm-passes -o - | FileCheck %s --check-prefix=CHECK-CALL
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-EXPAND
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering %s -emit-llvm -O2 -o - | FileCheck %s --check-prefix=CHECK-OPT
+
+int f1(_Array_ptr<int> p : count(n), int n) {
+  return p[0] + p[1] + p[2];
+}
+
+// CHECK-CALL-LABEL: define i32 @f1
+// CHECK-CALL: call void @__checkedc_bounds_check(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 1)
+// CHECK-CALL: call void @__checkedc_bounds_check(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 1)
+// CHECK-CALL: call void @__checkedc_bounds_check(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 1)
+// CHECK-CALL-NOT: _Dynamic_check.range
+// CHECK-CALL: ret i32
+
+// CHECK-EXPAND-LABEL: define i32 @f1
+// CHECK-EXPAND-NOT: call void @__checkedc_bounds_check
+// CHECK-EXPAND: br i1 %_Dynamic_check.range{{[0-9]*}}, label %_Dynamic_check.succeeded{{[0-9]*}}, label %_Dynamic_check.failed{{[0-9]*}}
+// CHECK-EXPAND: br i1 %_Dynamic_check.range{{[0-9]*}}, label %_Dynamic_check.succeeded{{[0-9]*}}, label %_Dynamic_check.failed{{[0-9]*}}
+// CHECK-EXPAND: br i1 %_Dynamic_check.range{{[0-9]*}}, label %_Dynamic_check.succeeded{{[0-9]*}}, label %_Dynamic_check.failed{{[0-9]*}}
+// CHECK-EXPAND-NOT: call void @__checkedc_bounds_check
+// CHECK-EXPAND: ret i32
+
+// When optimizing, the three range checks are merged into one.  Together
+// with the non-null check of p, that leaves two traps.
+// CHECK-OPT-LABEL: define i32 @f1
+// CHECK-OPT-NOT: call void @__checkedc_bounds_check
+// CHECK-OPT: call void @llvm.trap()
+// CHECK-OPT: call void @llvm.trap()
+// CHECK-OPT-NOT: call void @llvm.trap()
+// CHECK-OPT: }
+
+// Reads through null-terminated pointers may read the element at the upper
+// bound, which is checked with a size of 0.
+int f2(_Nt_array_ptr<char> s : count(0)) {
+  return *s;
+}
+
+// CHECK-CALL-LABEL: define i32 @f2
+// CHECK-CALL: call void @__checkedc_bounds_check(i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i8* {{%[a-zA-Z0-9.]*}}, i64 0)
+//
+// CHECK-EXPAND-LABEL: define i32 @f2
+// CHECK-EXPAND: %_Dynamic_check.upper = icmp ule i8* {{%[a-zA-Z0-9.]*}}, {{%[a-zA-Z0-9.]*}}
+
@@ -0,0 +1,75 @@
+// Tests for versioning loops on a single test that their dynamic bounds
+// checks succeed (-fcheckedc-version-loops).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-version-loops %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=NOVERSION
+
+// The accesses to a, b and c are tested once, before the loop.  The first
+// copy of the loop has no checks and the second copy has all of them.
+// CHECK-LABEL: define void @f1
+// CHECK: br i1 {{%[a-zA-Z0-9.]*}}, label %_Dynamic_check.version_test, label %_Dynamic_check.checked_loop
+// CHECK: _Dynamic_check.version_test:
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: br i1 {{%[a-zA-Z0-9.]*}}, label %_Dynamic_check.unchecked_loop, label %_Dynamic_check.checked_loop, !prof
+// CHECK: _Dynamic_check.unchecked_loop:
+// CHECK: for.body:
+// CHECK-NOT: _Dynamic_check
+// CHECK: for.inc:
+// CHECK: _Dynamic_check.checked_loop:
+// CHECK: for.body{{[0-9]+}}:
+// CHECK: _Dynamic_check.non_null
+// CHECK: _Dynamic_check.range
+// CHECK: for.end:
+//
+// NOVERSION-LABEL: define void @f1
+// NOVERSION-NOT: _Dynamic_check.version_test
+// NOVERSION: for.body:
+// NOVERSION: _Dynamic_check.range
+void f1(_Array_ptr<int> a : count(len), _Array_ptr<int> b : count(len),
+        _Array_ptr<int> c : count(len), int len) {
+  for (int i = 0; i < len; i++)
+    a[i] = b[i] + c[i];
+}
+
+// Accesses that are not evaluated on every iteration can still be tested
+// before the loop, because the checked loop runs if the test fails.
+// CHECK-LABEL: define void @f2
+// CHECK: _Dynamic_check.version_test:
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.unchecked_loop:
+// CHECK: for.body:
+// CHECK-NOT: _Dynamic_check
+// CHECK: for.inc:
+// CHECK: _Dynamic_check.checked_loop:
+void f2(_Array_ptr<int> p : count(n), int n) {
+  for (int i = 0; i < n; i++) {
+    int x = i * 2;
+    if (i != 3)
+      p[i] = x;
+  }
+}
+
+// A loop that may exit early, or whose bounds may change, is not versioned.
+// CHECK-LABEL: define void @f3
+// CHECK-NOT: _Dynamic_check.version_test
+// CHECK: for.body:
+// CHECK: _Dynamic_check.range
+void f3(_Array_ptr<int> p : count(n), int n) {
+  for (int i = 0; i < n; i++) {
+    if (p[i] == 0)
+      break;
+  }
+}
+
+// CHECK-LABEL: define void @f4
+// CHECK-NOT: _Dynamic_check.version_test
+// CHECK: for.body:
+// CHECK: _Dynamic_check.range
+void f4(_Array_ptr<int> p : count(n), int n) {
+  for (int i = 0; i < n; i++) {
+    _Array_ptr<int> q : count(n) = p;
+    q[i] = 0;
+  }
+}
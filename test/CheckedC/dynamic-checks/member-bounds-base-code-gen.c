@@ -0,0 +1,35 @@
+// Tests that a dynamic bounds check on an access through a struct member
+// whose bounds are declared in terms of other members of the same struct
+// reuses the base of the access instead of evaluating it again.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s
+
+struct S {
+  _Array_ptr<int> buf : count(len);
+  int len;
+};
+
+// s and s->buf are loaded once, and the lower and upper bounds of the check
+// use those loads.
+// CHECK-LABEL: define i32 @f1
+// CHECK: load %struct.S*, %struct.S**
+// CHECK-NOT: load %struct.S*, %struct.S**
+// CHECK: load i32*, i32**
+// CHECK-NOT: load i32*, i32**
+// CHECK: _Dynamic_check.range
+// CHECK: ret i32
+int f1(_Ptr<struct S> s, int i) {
+  return s->buf[i];
+}
+
+// The same holds for a write through the member.
+// CHECK-LABEL: define void @f2
+// CHECK: load %struct.S*, %struct.S**
+// CHECK-NOT: load %struct.S*, %struct.S**
+// CHECK: load i32*, i32**
+// CHECK-NOT: load i32*, i32**
+// CHECK: _Dynamic_check.range
+// CHECK: ret void
+void f2(_Ptr<struct S> s, int i) {
+  s->buf[i] = 0;
+}
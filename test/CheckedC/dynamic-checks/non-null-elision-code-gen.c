@@ -0,0 +1,36 @@
+// Tests that non-null checks are not emitted for pointers that are known to
+// be non-null.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s
+
+// Accesses to local checked arrays only need a bounds check.
+// CHECK-LABEL: define i32 @f1
+// CHECK-NOT: _Dynamic_check.non_null
+// CHECK: _Dynamic_check.range
+// CHECK: ret i32
+int f1(int i) {
+  int a _Checked[10] = { 0 };
+  return a[i];
+}
+
+struct S {
+  int a;
+  int b;
+};
+
+// The address of a local variable is never null.
+// CHECK-LABEL: define i32 @f2
+// CHECK-NOT: _Dynamic_check.non_null
+// CHECK: ret i32
+int f2(void) _Checked {
+  struct S s = { 0, 1 };
+  return (&s)->a + (&s)->b;
+}
+
+// Pointers loaded from memory are still checked.
+// CHECK-LABEL: define i32 @f3
+// CHECK: _Dynamic_check.non_null
+// CHECK: ret i32
+int f3(_Ptr<struct S> p) {
+  return p->a;
+}
@@ -0,0 +1,54 @@
+// Tests for the dynamic bounds checks of writes through null-terminated
+// pointers.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-version-loops %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=VERSION
+
+// Writing a constant nul is allowed at the upper bound, so the check is a
+// single range check, with no additional check at the upper bound.
+// CHECK-LABEL: define void @f1
+// CHECK: %_Dynamic_check.upper = icmp ule i8* {{%[a-zA-Z0-9.]*}}, {{%[a-zA-Z0-9.]*}}
+// CHECK-NOT: _Nullterm_range_check
+// CHECK: ret void
+void f1(_Nt_array_ptr<char> s : count(n), int n) {
+  s[n] = '\0';
+}
+
+// Writing another constant is never allowed at the upper bound.
+// CHECK-LABEL: define void @f2
+// CHECK: %_Dynamic_check.upper = icmp ult i8* {{%[a-zA-Z0-9.]*}}, {{%[a-zA-Z0-9.]*}}
+// CHECK-NOT: _Nullterm_range_check
+// CHECK: ret void
+void f2(_Nt_array_ptr<char> s : count(n), int n) {
+  s[0] = 'a';
+}
+
+// Other values need the additional check when the write is at the upper
+// bound.
+// CHECK-LABEL: define void @f3
+// CHECK: %_Dynamic_check.upper = icmp ult i8* {{%[a-zA-Z0-9.]*}}, {{%[a-zA-Z0-9.]*}}
+// CHECK: _Nullterm_range_check.failed
+// CHECK: %_Dynamic_check.write_nul
+// CHECK: ret void
+void f3(_Nt_array_ptr<char> s : count(n), int n, int i, char c) {
+  s[i] = c;
+}
+
+// The writes in a copy loop are tested once, strictly below the upper
+// bound, before the unchecked copy of the loop.
+// VERSION-LABEL: define void @f4
+// VERSION: _Dynamic_check.version_test:
+// VERSION: %_Dynamic_check.upper = icmp ult
+// VERSION: _Dynamic_check.unchecked_loop:
+// VERSION: for.body:
+// VERSION-NOT: _Dynamic_check
+// VERSION-NOT: _Nullterm_range_check
+// VERSION: for.inc:
+// VERSION: _Dynamic_check.checked_loop:
+// VERSION: _Nullterm_range_check.failed
+// VERSION: for.end:
+void f4(_Nt_array_ptr<char> dst : count(n), _Array_ptr<char> src : count(n),
+        int n) {
+  for (int i = 0; i < n; i++)
+    dst[i] = src[i];
+}
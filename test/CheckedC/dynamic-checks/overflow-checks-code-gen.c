@@ -0,0 +1,49 @@
+// Tests for the overflow checks of pointer arithmetic on checked array
+// pointers (-fcheckedc-overflow-checks), and for their combination with the
+// bounds checks of the dereferences of the results.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-overflow-checks %s -emit-llvm -O0 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=NOOVERFLOW
+
+// NOOVERFLOW-NOT: with.overflow
+
+// The overflow check of p + i is done by the branch of the bounds check.
+// CHECK-LABEL: define i32 @f1
+// CHECK: call { i64, i1 } @llvm.smul.with.overflow.i64
+// CHECK: _Dynamic_check.non_null
+// CHECK: %_Dynamic_check.range = and i1
+// CHECK: %_Dynamic_check.no_overflow = and i1 %_Dynamic_check.range
+// CHECK: br i1 %_Dynamic_check.no_overflow
+// CHECK-NOT: br i1
+// CHECK: load i32
+// CHECK: }
+int f1(_Array_ptr<int> p : count(n), int n, int i) {
+  return *(p + i);
+}
+
+// Arithmetic whose result is not dereferenced has its own check.
+// CHECK-LABEL: define void @f2
+// CHECK: call { i64, i1 } @llvm.smul.with.overflow.i64
+// CHECK: br i1
+// CHECK: _Dynamic_check.succeeded:
+// CHECK: store i32*
+// CHECK: }
+void f2(_Array_ptr<int> p : count(n), int n, int i) {
+  _Array_ptr<int> q : bounds(p, p + n) = p + i;
+}
+
+// Arithmetic on unchecked pointers is not checked.
+// CHECK-LABEL: define i32 @f3
+// CHECK-NOT: with.overflow
+// CHECK: }
+int f3(int *p, int i) {
+  return *(p + i);
+}
+
+// A constant offset of zero cannot overflow.
+// CHECK-LABEL: define i32 @f4
+// CHECK-NOT: _Dynamic_check.no_overflow
+// CHECK: }
+int f4(_Array_ptr<int> p : count(1)) {
+  return *(p + 0);
+}
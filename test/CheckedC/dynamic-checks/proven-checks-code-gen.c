@@ -0,0 +1,46 @@
+// Tests that accesses in checked scopes that the bounds checker proves to be
+// in bounds get no dynamic bounds check.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s
+
+struct Msg {
+  int len;
+  int data _Checked[8];
+};
+
+// Constant indices into a local checked array are proved in bounds, and
+// the array is never null, so there are no checks.
+// CHECK-LABEL: define i32 @f1
+// CHECK-NOT: _Dynamic_check
+// CHECK: ret i32
+int f1(void) _Checked {
+  int a _Checked[4] = { 0, 1, 2, 3 };
+  return a[0] + a[3];
+}
+
+// The base of p->len is proved within count(1).  The pointer may still be
+// null, so it keeps its non-null check.
+// CHECK-LABEL: define i32 @f2
+// CHECK: _Dynamic_check.non_null
+// CHECK-NOT: _Dynamic_check.range
+// CHECK: ret i32
+int f2(_Array_ptr<struct Msg> p : count(1)) _Checked {
+  return p->len;
+}
+
+// Accesses at variable indices are still checked.
+// CHECK-LABEL: define i32 @f3
+// CHECK: _Dynamic_check.range
+// CHECK: ret i32
+int f3(int i) _Checked {
+  int a _Checked[4] = { 0, 1, 2, 3 };
+  return a[i];
+}
+
+// Outside checked scopes, proved accesses keep their checks.
+// CHECK-LABEL: define i32 @f4
+// CHECK: _Dynamic_check.range
+// CHECK: ret i32
+int f4(_Array_ptr<struct Msg> p : count(1)) {
+  return p->len;
+}
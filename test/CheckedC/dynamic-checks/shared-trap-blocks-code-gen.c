@@ -0,0 +1,45 @@
+// Tests for sharing the failure blocks of dynamic checks
+// (-fcheckedc-trap-blocks).
+//
+// RUN: %clang_cc1 -fcheckedc-extension %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-CHECK
+// RUN: %clang_cc1 -fcheckedc-extension -fcheckedc-trap-blocks=check %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-CHECK
+// RUN: %clang_cc1 -fcheckedc-extension -fcheckedc-trap-blocks=function %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-FUNCTION
+// RUN: %clang_cc1 -fcheckedc-extension -fcheckedc-trap-blocks=kind %s -emit-llvm -O0 -o - | FileCheck %s --check-prefix=CHECK-KIND
+// RUN: not %clang_cc1 -fcheckedc-extension -fcheckedc-trap-blocks=bogus %s -emit-llvm -O0 -o - 2>&1 | FileCheck %s --check-prefix=CHECK-INVALID
+
+// CHECK-INVALID: error: invalid value 'bogus' in '-fcheckedc-trap-blocks=bogus'
+
+int f1(_Array_ptr<int> p : count(3), _Ptr<int> q) {
+  return p[0] + p[1] + p[2] + *q;
+}
+
+// Each check has its own failure block.
+// CHECK-CHECK-LABEL: define i32 @f1
+// CHECK-CHECK: br i1 %_Dynamic_check.non_null, label %{{.*}}, label %[[FAIL1:_Dynamic_check.failed[a-zA-Z0-9.]*]]
+// CHECK-CHECK: br i1 %_Dynamic_check.range, label %{{.*}}, label %[[FAIL2:_Dynamic_check.failed[a-zA-Z0-9.]*]]
+// CHECK-CHECK-NOT: label %[[FAIL1]]{{,|$}}
+// CHECK-CHECK-NOT: label %[[FAIL2]]{{,|$}}
+// CHECK-CHECK: ret i32
+
+// All checks share one failure block.
+// CHECK-FUNCTION-LABEL: define i32 @f1
+// CHECK-FUNCTION: br i1 %_Dynamic_check.non_null, label %{{.*}}, label %[[FAIL:_Dynamic_check.failed[a-zA-Z0-9.]*]]
+// CHECK-FUNCTION: br i1 %_Dynamic_check.range, label %{{.*}}, label %[[FAIL]]{{,|$}}
+// CHECK-FUNCTION: br i1 %_Dynamic_check.non_null{{[0-9]+}}, label %{{.*}}, label %[[FAIL]]{{,|$}}
+// CHECK-FUNCTION: br i1 %_Dynamic_check.range{{[0-9]+}}, label %{{.*}}, label %[[FAIL]]{{,|$}}
+// CHECK-FUNCTION: [[FAIL]]:
+// CHECK-FUNCTION-NEXT: call void @llvm.trap()
+// CHECK-FUNCTION-NEXT: unreachable
+// CHECK-FUNCTION-NOT: _Dynamic_check.failed
+// CHECK-FUNCTION: }
+
+// Checks of the same kind share a failure block.
+// CHECK-KIND-LABEL: define i32 @f1
+// CHECK-KIND: br i1 %_Dynamic_check.non_null, label %{{.*}}, label %[[NONNULL:_Dynamic_check.failed.nonnull[a-zA-Z0-9.]*]]
+// CHECK-KIND: br i1 %_Dynamic_check.range, label %{{.*}}, label %[[RANGE:_Dynamic_check.failed.range[a-zA-Z0-9.]*]]
+// CHECK-KIND: br i1 %_Dynamic_check.non_null{{[0-9]+}}, label %{{.*}}, label %[[NONNULL]]{{,|$}}
+// CHECK-KIND: br i1 %_Dynamic_check.range{{[0-9]+}}, label %{{.*}}, label %[[RANGE]]{{,|$}}
+// CHECK-KIND: [[NONNULL]]:
+// CHECK-KIND-NEXT: call void @llvm.trap()
+// CHECK-KIND: [[RANGE]]:
+// CHECK-KIND-NEXT: call void @llvm.trap()
@@ -0,0 +1,37 @@
+// Tests for lowering dynamic bounds checks in innermost loops without
+// branches out of the loop (-fcheckedc-sticky-loop-checks).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering -fcheckedc-sticky-loop-checks %s -emit-llvm -O2 -o - | FileCheck %s
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-late-check-lowering %s -emit-llvm -O2 -o - | FileCheck %s --check-prefix=NOSTICKY
+
+// The check of q[i] is done once, before the loop, for the whole range of
+// q that the loop reads.  The check of p[q[i]] sets a flag that is tested
+// after the loop.
+// CHECK-LABEL: define i32 @f1
+// CHECK-NOT: call void @__checkedc_bounds_check
+// CHECK: %_Dynamic_check.length
+// CHECK: %_Dynamic_check.failed_flag{{[0-9.a-z]*}} = phi i1
+// CHECK: call void @llvm.trap()
+// CHECK: }
+//
+// NOSTICKY-LABEL: define i32 @f1
+// NOSTICKY-NOT: _Dynamic_check.failed_flag
+// NOSTICKY: }
+int f1(_Array_ptr<int> p : count(m), int m,
+       _Array_ptr<int> q : count(n), int n) {
+  int sum = 0;
+  for (int i = 0; i < n; i++)
+    sum += p[q[i]];
+  return sum;
+}
+
+// The loop stores through a pointer that is not checked before the loop,
+// so its checks must trap before the store.
+// CHECK-LABEL: define void @f2
+// CHECK-NOT: _Dynamic_check.failed_flag
+// CHECK: }
+void f2(int *out, _Array_ptr<int> p : count(m), int m,
+        _Array_ptr<int> q : count(n), int n) {
+  for (int i = 0; i < n; i++)
+    out[q[i]] = p[i];
+}
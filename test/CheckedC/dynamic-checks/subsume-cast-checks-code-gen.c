@@ -0,0 +1,57 @@
+// Tests for combining the checks of dynamic bounds casts with the checks of
+// the accesses through their result (-fcheckedc-subsume-cast-checks).
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension -fcheckedc-subsume-cast-checks %s -emit-llvm -O0 -o - | FileCheck %s
+
+// The cast check and the checks of the three reads are done with one
+// branch after q is set.
+// CHECK-LABEL: define i32 @f1
+// CHECK-NOT: _Dynamic_check.subsumption
+// CHECK: _Dynamic_check.cast_result
+// CHECK: %_Dynamic_check.cast = and i1
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: _Dynamic_check.range
+// CHECK: br i1
+// CHECK-NOT: br i1
+// CHECK: ret i32
+int f1(_Array_ptr<char> p : count(n), int n, int len, int i) {
+  _Array_ptr<char> q : count(len) = _Dynamic_bounds_cast<_Array_ptr<char>>(p, count(len));
+  int x = q[i] + q[i + 1] + q[i + 2];
+  return x;
+}
+
+struct hdr {
+  int type;
+  int len;
+};
+
+// For a _Ptr, the accesses only need the non-null check, which is part of
+// the combined check.
+// CHECK-LABEL: define i32 @f2
+// CHECK-NOT: _Dynamic_check.subsumption
+// CHECK: _Dynamic_check.cast_result
+// CHECK: _Dynamic_check.non_null
+// CHECK: %_Dynamic_check.cast = and i1
+// CHECK: br i1
+// CHECK-NOT: br i1
+// CHECK: ret i32
+int f2(_Array_ptr<char> p : count(n), int n) {
+  _Ptr<struct hdr> h = _Dynamic_bounds_cast<_Ptr<struct hdr>>(p);
+  int x = h->type + h->len;
+  return x;
+}
+
+// The cast is not combined when the next statement has control flow, or
+// does not access memory through the result.
+// CHECK-LABEL: define i32 @f3
+// CHECK: _Dynamic_check.subsumption
+// CHECK: _Dynamic_check.subsumption
+// CHECK: ret i32
+int f3(_Array_ptr<char> p : count(n), int n, int len, int i) {
+  _Array_ptr<char> q : count(len) = _Dynamic_bounds_cast<_Array_ptr<char>>(p, count(len));
+  int x = n ? q[i] : 0;
+  _Array_ptr<char> r : count(len) = _Dynamic_bounds_cast<_Array_ptr<char>>(p, count(len));
+  x += n;
+  return x + r[i];
+}
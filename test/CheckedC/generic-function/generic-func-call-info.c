@@ -68,3 +68,21 @@ void callPolymorphicTypes(void) {
   // CHECK-AST-NEXT: DeclRefExpr {{0x[0-9a-f]+}} <col:{{[0-9]+}}> 'int (_Ptr<int>, _Ptr<int>, int (*)(_Ptr<int>, _Ptr<int>))' instantiated Function {{0x[0-9a-f]+}} 'funcPtrGenericTest' '_For_any(1) int (_Ptr<T>, _Ptr<T>, int (*)(_Ptr<T>, _Ptr<T>))'
   // CHECK-AST-NEXT: BuiltinType {{0x[0-9a-f]+}} 'int'
 }
+
+void callRepeatedInstantiations(void) {
+  int t = 0;
+  char c = 0;
+  _Ptr<int> pt = &t;
+  _Ptr<char> pc = &c;
+
+  // Check that instantiations with different type arguments are kept apart
+  // when an instantiation is repeated.
+  ptrGenericTest<int>(pt, t);
+  ptrGenericTest<char>(pc, t);
+  ptrGenericTest<int>(pt, t);
+
+  // CHECK-AST: FunctionDecl {{.*}} callRepeatedInstantiations
+  // CHECK-AST: DeclRefExpr {{.*}} '_Ptr<int> (_Ptr<int>, int)' instantiated Function {{.*}} 'ptrGenericTest'
+  // CHECK-AST: DeclRefExpr {{.*}} '_Ptr<char> (_Ptr<char>, int)' instantiated Function {{.*}} 'ptrGenericTest'
+  // CHECK-AST: DeclRefExpr {{.*}} '_Ptr<int> (_Ptr<int>, int)' instantiated Function {{.*}} 'ptrGenericTest'
+}
@@ -0,0 +1,54 @@
+// Tests that the bounds inferred for bounds checks in a Pre-Compiled Header
+// (PCH) are written to it, and are loaded when code generation and the AST
+// dumper ask for them.
+//
+// RUN: %clang_cc1 -fcheckedc-extension -emit-pch -o %t %s
+// RUN: %clang_cc1 -fcheckedc-extension -include-pch %t -emit-llvm -O0 -o - %s | FileCheck %s --check-prefix=CHECK-IR
+// RUN: %clang_cc1 -fcheckedc-extension -include-pch %t -ast-dump-all %s | FileCheck %s --check-prefix=CHECK-AST
+
+#ifndef HEADER
+#define HEADER
+
+struct S {
+  int f;
+};
+
+static inline int subscript(_Array_ptr<int> p : count(n), int n, int i) {
+  return p[i];
+}
+
+static inline int deref(_Array_ptr<int> p : count(1)) {
+  return *p;
+}
+
+static inline int arrow(_Array_ptr<struct S> s : count(1)) {
+  return s->f;
+}
+
+#else
+
+int f(_Array_ptr<int> p : count(2), _Array_ptr<struct S> s : count(1)) {
+  return subscript(p, 2, 1) + deref(p) + arrow(s);
+}
+
+// CHECK-AST: FunctionDecl {{.*}} subscript
+// CHECK-AST: ArraySubscriptExpr
+// CHECK-AST-NEXT: Bounds
+// CHECK-AST-NEXT: RangeBoundsExpr
+// CHECK-AST: FunctionDecl {{.*}} deref
+// CHECK-AST: UnaryOperator {{.*}} prefix '*'
+// CHECK-AST-NEXT: Bounds
+// CHECK-AST-NEXT: RangeBoundsExpr
+// CHECK-AST: FunctionDecl {{.*}} arrow
+// CHECK-AST: MemberExpr {{.*}} ->f
+// CHECK-AST-NEXT: Base Expr Bounds
+// CHECK-AST-NEXT: RangeBoundsExpr
+
+// CHECK-IR: define internal i32 @subscript
+// CHECK-IR: _Dynamic_check.range
+// CHECK-IR: define internal i32 @deref
+// CHECK-IR: _Dynamic_check.range
+// CHECK-IR: define internal i32 @arrow
+// CHECK-IR: _Dynamic_check.range
+
+#endif
@@ -0,0 +1,50 @@
+// Tests that calls, binary operators and bounds expressions are written to a
+// Pre-Compiled Header (PCH) with abbreviations, and are read back correctly.
+//
+// RUN: %clang_cc1 -fcheckedc-extension -emit-pch -o %t %s
+// RUN: llvm-bcanalyzer -dump %t | FileCheck %s --check-prefix=CHECK-BITCODE
+// RUN: %clang_cc1 -fcheckedc-extension -include-pch %t -ast-dump-all %s | FileCheck %s --check-prefix=CHECK-AST
+
+#ifndef HEADER
+#define HEADER
+
+static inline int add(int a, int b) {
+  return a + b;
+}
+
+static inline int sum(_Array_ptr<int> p : count(n), int n) {
+  return add(p[0], p[n - 1]);
+}
+
+static inline int first(_Array_ptr<int> p : bounds(p, p + 1)) {
+  return *p;
+}
+
+static inline _Array_ptr<int> none(void) : bounds(unknown) {
+  return 0;
+}
+
+#else
+
+int f(_Array_ptr<int> p : count(2)) {
+  return sum(p, 2) + first(p);
+}
+
+// CHECK-AST: FunctionDecl {{.*}} add
+// CHECK-AST: BinaryOperator {{.*}} '+'
+// CHECK-AST: FunctionDecl {{.*}} sum
+// CHECK-AST: CountBoundsExpr
+// CHECK-AST: Element
+// CHECK-AST: CallExpr
+// CHECK-AST: FunctionDecl {{.*}} first
+// CHECK-AST: RangeBoundsExpr
+// CHECK-AST: FunctionDecl {{.*}} none
+// CHECK-AST: NullaryBoundsExpr {{.*}} Unknown
+
+#endif
+
+// CHECK-BITCODE-DAG: <EXPR_BINARY_OPERATOR abbrevid=
+// CHECK-BITCODE-DAG: <EXPR_CALL abbrevid=
+// CHECK-BITCODE-DAG: <EXPR_COUNT_BOUNDS_EXPR abbrevid=
+// CHECK-BITCODE-DAG: <EXPR_RANGE_BOUNDS_EXPR abbrevid=
+// CHECK-BITCODE-DAG: <EXPR_NULLARY_BOUNDS_EXPR abbrevid=
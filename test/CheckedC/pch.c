@@ -114,6 +114,14 @@ int* int_val2(void) : itype(_Array_ptr<int>); // expected-error{{function redecl
 int* int_val2(void) : itype(_Ptr<int>);
 int* int_val2(void);
 
+// Shared bounds annotations
+int shared_fn2(_Array_ptr<int> b : count(m + 1), int m); // expected-error{{function redeclaration has conflicting parameter bounds}}
+int shared_fn2(_Array_ptr<int> b : count(m), int m);
+int shared_fn3(int *p : itype(_Ptr<int>), int *q : itype(_Array_ptr<int>)); // expected-error{{function redeclaration has conflicting parameter interop type}}
+int shared_fn3(int *p : itype(_Ptr<int>), int *q : itype(_Ptr<int>));
+_Ptr<int(_Array_ptr<int> arr : count(i), int i)> shared_fp1 = shared_fn1;
+_Ptr<int(_Array_ptr<int> arr : count(i), int i)> shared_fp2 = shared_fn2;
+
 
 //
 // Bounds Expressions on Struct Members
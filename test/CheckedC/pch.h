@@ -64,6 +64,12 @@ _Array_ptr<int> pos_fn2(int len) : count(len);
 int int_val(int *ptr : itype(_Ptr<int>));
 int* int_val2(void) : itype(_Ptr<int>);
 
+// Function types with structurally equal bounds annotations, which share
+// them in the AST file
+int shared_fn1(_Array_ptr<int> a : count(n), int n);
+int shared_fn2(_Array_ptr<int> b : count(m), int m);
+int shared_fn3(int *p : itype(_Ptr<int>), int *q : itype(_Ptr<int>));
+
 //
 // Bounds Expressions on Struct Members
 //
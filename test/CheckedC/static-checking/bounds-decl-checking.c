@@ -290,3 +290,24 @@ int f31(_Ptr<void> p) {
   test_f30(p);
   return 0;
 }
+
+// The proof for a pair of bounds is remembered for the rest of the function.
+// Later checks of the same bounds get the same diagnostics.
+void f32(_Array_ptr<int> p : count(5)) {
+  _Array_ptr<int> q : bounds(p, p + 5) = 0;
+  _Array_ptr<int> r : bounds(p, p + 6) = 0;
+  for (int i = 0; i < 2; i++) {
+    q = p; // No error expected
+    r = p; // expected-error {{declared bounds for r are invalid after assignment}} \
+           // expected-note {{destination bounds are wider than the source bounds}} \
+           // expected-note {{destination upper bound is above source upper bound}} \
+           // expected-note {{(expanded) declared bounds are 'bounds(p, p + 6)'}} \
+           // expected-note {{(expanded) inferred bounds are 'bounds(p, p + 5)'}}
+    q = p;
+    r = p; // expected-error {{declared bounds for r are invalid after assignment}} \
+           // expected-note {{destination bounds are wider than the source bounds}} \
+           // expected-note {{destination upper bound is above source upper bound}} \
+           // expected-note {{(expanded) declared bounds are 'bounds(p, p + 6)'}} \
+           // expected-note {{(expanded) inferred bounds are 'bounds(p, p + 5)'}}
+  }
+}
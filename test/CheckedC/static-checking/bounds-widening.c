@@ -0,0 +1,61 @@
+// Tests for widening the bounds of null-terminated pointers on the branches
+// of tests of the element at their upper bound
+// (-fcheckedc-flow-sensitive-bounds).
+//
+// RUN: %clang_cc1 -fcheckedc-extension -fcheckedc-flow-sensitive-bounds -verify -verify-ignore-unexpected=note %s
+// RUN: %clang_cc1 -fcheckedc-extension -fcheckedc-flow-sensitive-bounds -ast-dump %s 2>/dev/null | FileCheck %s
+
+// The element after the upper bound can be read once the element at the
+// upper bound is known to be non-null.
+char f1(_Nt_array_ptr<char> p : count(0)) {
+  if (*p)
+    return p[1];
+  return 0;
+}
+
+// CHECK: FunctionDecl {{.*}} f1
+// CHECK: ArraySubscriptExpr
+// CHECK-NEXT: Bounds
+// CHECK-NEXT: RangeBoundsExpr
+// CHECK: BinaryOperator {{.*}} '+'
+// CHECK: IntegerLiteral {{.*}} 1
+// CHECK: BoundsCheckKind None
+
+// Negated tests and comparisons with zero, and the left operand of &&.
+char f2(_Nt_array_ptr<char> s : bounds(s, s + 2)) {
+  char c = 0;
+  if (!s[2])
+    return 0;
+  c = s[3];
+  while (*(s + 2) != '\0' && c)
+    c = s[3];
+  return c;
+}
+
+// CHECK: FunctionDecl {{.*}} f2
+// CHECK: ArraySubscriptExpr
+// CHECK: BoundsCheckKind None
+// CHECK: ArraySubscriptExpr
+// CHECK: BoundsCheckKind None
+
+// Tests of other elements, and tests on the wrong branch, do not widen the
+// bounds.
+char f3(_Nt_array_ptr<char> p : count(0)) {
+  if (p[1])                   // expected-warning {{out-of-bounds memory access}}
+    return p[1];              // expected-warning {{out-of-bounds memory access}}
+  if (*p == 0)
+    return p[1];              // expected-warning {{out-of-bounds memory access}}
+  return 0;
+}
+
+// Assignments to the pointer end the widening, as do joins with paths on
+// which the element was not tested.
+char f4(_Nt_array_ptr<char> q : count(0), int c) {
+  if (*q) {
+    q = "a";
+    return q[1];              // expected-warning {{out-of-bounds memory access}}
+  }
+  if (c && *q)
+    c = 2;
+  return q[1];                // expected-warning {{out-of-bounds memory access}}
+}
@@ -0,0 +1,35 @@
+// Tests for checking arguments against the parameter bounds of function
+// types.  The parameter bounds are computed once per function type, and
+// count bounds whose arguments are variables or constants are concretized
+// without rebuilding the bounds.
+//
+// RUN: %clang -cc1 -fcheckedc-extension -Wcheck-bounds-decls -verify %s
+
+void buf_write(_Array_ptr<char> b : count(n), int n);
+void buf_first(_Array_ptr<char> b : count(1), int n);
+
+void f1(_Array_ptr<char> q : count(n), int n) {
+  buf_write(q, n);   // No error expected.
+  buf_write(q, n);   // No error expected.
+  buf_first(q, n);   // expected-warning {{cannot prove argument meets declared bounds for 1st parameter}} \
+                     // expected-note {{(expanded) expected argument bounds are 'bounds(q, q + 1)'}} \
+                     // expected-note {{(expanded) inferred bounds are 'bounds(q, q + n)'}}
+}
+
+void f2(_Array_ptr<char> r : count(5)) {
+  buf_write(r, 5);   // No error expected.
+  buf_write(r, 3);   // No error expected.
+  buf_write(r, 10);  // expected-error {{argument does not meet declared bounds for 1st parameter}} \
+                     // expected-note {{destination bounds are wider than the source bounds}} \
+                     // expected-note {{destination upper bound is above source upper bound}} \
+                     // expected-note {{(expanded) expected argument bounds are 'bounds(r, r + 10)'}} \
+                     // expected-note {{(expanded) inferred bounds are 'bounds(r, r + 5)'}}
+}
+
+// Arguments that are not simple still go through the full substitution,
+// which reports modifying arguments.
+void f3(_Array_ptr<char> q : count(10), int n) {
+  volatile int vn = 1;
+  buf_write(q, n++); // expected-error {{increment expression not allowed in argument for parameter used in function parameter bounds expression}}
+  buf_write(q, vn);  // expected-error {{volatile expression not allowed in argument for parameter used in function parameter bounds expression}}
+}
@@ -0,0 +1,35 @@
+// Tests of the -Rcheckedc-checks remarks, which explain why the bounds
+// checker could not remove the dynamic bounds check of a memory access.
+//
+// RUN: %clang_cc1 -fcheckedc-extension -fsyntax-only -Rcheckedc-checks -verify -verify-ignore-unexpected=note %s
+// RUN: %clang_cc1 -fcheckedc-extension -fsyntax-only %s 2>&1 | FileCheck %s --check-prefix=DEFAULT
+
+// The remarks are off by default.
+// DEFAULT-NOT: remark:
+// DEFAULT: warning: out-of-bounds memory access
+// DEFAULT-NOT: remark:
+
+struct S {
+  int f;
+};
+
+void f1(_Array_ptr<int> p : count(n), int n, int i) {
+  int x = p[i];     // expected-remark {{bounds check of memory access is kept: its address cannot be compared with its bounds statically}}
+  x = *(p + 1);     // expected-remark {{bounds check of memory access is kept: its address cannot be compared with its bounds statically}}
+}
+
+void f2(_Array_ptr<int> p : count(4)) {
+  int x = p[1];     // expected-remark {{bounds check of memory access is kept: it is provably in bounds, but is in an unchecked scope}}
+  _Checked {
+    x = p[2];
+  }
+  x = p[4];         // expected-warning {{out-of-bounds memory access}}
+}
+
+void f3(_Array_ptr<int> p : bounds(q, q), _Array_ptr<int> q) {
+  int x = *p;       // expected-remark {{bounds check of memory access is kept: its bounds may be an empty range}}
+}
+
+int f4(_Array_ptr<struct S> s : count(n), int n) {
+  return s->f;      // expected-remark {{bounds check of base value is kept: its address cannot be compared with its bounds statically}}
+}
@@ -0,0 +1,48 @@
+// Tests that discarding the AST of function bodies once they are checked
+// keeps the diagnostics of the bounds checks and of the declarations that
+// follow the bodies.
+//
+// RUN: %clang -cc1 -fsyntax-only -fcheckedc-extension -fdiscard-function-bodies -Wcheck-bounds-decls -Wundefined-internal -verify %s
+
+static int helper(_Array_ptr<int> p : count(n), int n) {
+  return n > 0 ? p[0] : 0;
+}
+
+void f1(_Array_ptr<int> p : count(5)) {
+  _Array_ptr<int> q : bounds(p, p + 5) = p;
+  _Array_ptr<int> r : bounds(p, p + 6) = p; // expected-error {{declared bounds for 'r' are invalid after initialization}} \
+                                            // expected-note {{destination bounds are wider than the source bounds}} \
+                                            // expected-note {{destination upper bound is above source upper bound}} \
+                                            // expected-note {{(expanded) declared bounds are 'bounds(p, p + 6)'}} \
+                                            // expected-note {{(expanded) inferred bounds are 'bounds(p, p + 5)'}}
+  helper(q, 5);
+}
+
+// The discarded body still makes f2 a definition.
+void f2(void) { // expected-note {{previous definition is here}}
+  int a[10];
+  a[0] = helper(a, 10);
+}
+
+void f2(void) {} // expected-error {{redefinition of 'f2'}}
+
+// The bounds of a block-scope extern declaration are compared with those of
+// the later declarations, so the body that declares it is kept.
+void f3(_Array_ptr<int> p : count(4)) {
+  extern int g3(_Array_ptr<int> a : count(n), int n);
+  _Ptr<int (_Array_ptr<int> : count(2), int)> fp = 0;
+  g3(p, 4);
+}
+
+int g3(_Array_ptr<int> a : count(n), int n);
+
+int g3(_Array_ptr<int> a : count(n - 1), int n); // expected-error {{conflicting parameter bounds}}
+
+void f4(_Array_ptr<int> p : count(5)) {
+  _Array_ptr<int> s : bounds(p - 1, p + 5) = p; // expected-error {{declared bounds for 's' are invalid after initialization}} \
+                                                // expected-note {{destination bounds are wider than the source bounds}} \
+                                                // expected-note {{destination lower bound is below source lower bound}} \
+                                                // expected-note {{(expanded) declared bounds are 'bounds(p - 1, p + 5)'}} \
+                                                // expected-note {{(expanded) inferred bounds are 'bounds(p, p + 5)'}}
+  f1(p);
+}
@@ -0,0 +1,61 @@
+// Tests for using equalities between variables computed by dataflow
+// analysis when checking bounds declarations
+// (-fcheckedc-flow-sensitive-bounds).
+//
+// RUN: %clang_cc1 -fcheckedc-extension -Wcheck-bounds-decls -fcheckedc-flow-sensitive-bounds -verify -verify-ignore-unexpected=note %s
+//
+// Without the dataflow facts, each of the declarations below that has no
+// expected warning cannot be proved valid.
+
+// q is known to equal p when r is declared.
+void f1(_Array_ptr<int> p : count(5)) {
+  _Array_ptr<int> q : count(5) = p;
+  _Array_ptr<int> r : bounds(q, p + 5) = p;
+}
+
+// n is known to equal 3.
+void f2(_Array_ptr<int> p : count(3)) {
+  int n = 3;
+  _Array_ptr<int> q : count(n) = p;
+}
+
+// Facts are propagated through loops that do not change the variables.
+void f3(_Array_ptr<int> p : count(3), int m) {
+  int n = 3;
+  for (int i = 0; i < m; i++) {
+    _Array_ptr<int> q : count(n) = p;
+  }
+}
+
+// Assignments end facts, and facts hold after a join only if they hold on
+// every path into it.
+void f4(_Array_ptr<int> p : count(3), int m, int c) {
+  int n = 3;
+  n = m;
+  _Array_ptr<int> q : count(n) = p; // expected-warning {{cannot prove declared bounds for 'q' are valid after initialization}}
+  int k = 3;
+  if (c)
+    k = 4;
+  _Array_ptr<int> r : count(k) = p; // expected-warning {{cannot prove declared bounds for 'r' are valid after initialization}}
+  int j = 4;
+  if (c)
+    j = 3;
+  else
+    j = 3;
+  _Array_ptr<int> s : count(j) = p;
+}
+
+// Variables whose address is taken are not tracked.
+void f5(_Array_ptr<int> p : count(3)) {
+  int n = 3;
+  int *pn = &n;
+  _Array_ptr<int> q : count(n) = p; // expected-warning {{cannot prove declared bounds for 'q' are valid after initialization}}
+}
+
+// The facts about the variable being assigned do not carry over.
+void f6(_Array_ptr<int> p : count(5), _Array_ptr<int> t : count(5)) {
+  _Array_ptr<int> q : count(5) = p;
+  _Array_ptr<int> r : bounds(p, p + 5) = p;
+  r = t; // expected-warning {{cannot prove declared bounds for r are valid after assignment}}
+  r = q;
+}
@@ -0,0 +1,19 @@
+// Tests that function types with equivalent bounds annotations are the
+// same type, and that function types with different bounds annotations
+// are not.
+//
+// RUN: %clang_cc1 -fcheckedc-extension -fsyntax-only -verify %s
+
+int f1(_Array_ptr<int> a : count(n), int n);
+int f1(_Array_ptr<int> b : count((n)), int n);
+int f1(_Array_ptr<int> c : count(n + 1), int n); // expected-error{{function redeclaration has conflicting parameter bounds}}
+
+_Array_ptr<int> f2(int *p : itype(_Ptr<int>)) : count(2);
+_Array_ptr<int> f2(int *q : itype(_Ptr<int>)) : count((2));
+
+int f3(_Array_ptr<char> p : byte_count(len), unsigned len);
+int f3(_Array_ptr<char> p : byte_count(len + 1), unsigned len); // expected-error{{function redeclaration has conflicting parameter bounds}}
+
+_Ptr<int(_Array_ptr<int> arr : count(i), int i)> fp1 = f1;
+_Ptr<int(_Array_ptr<int> arr : count((i)), int i)> fp2 = f1;
+_Ptr<int(_Array_ptr<int> arr : count(i + 1), int i)> fp3 = f1; // expected-error{{incompatible type}}
@@ -0,0 +1,27 @@
+// Tests that reparsing a translation unit through libclang reports the
+// same bounds checking diagnostics.  Functions that checked without
+// diagnostics are not checked again if they didn't change, and the other
+// functions are.
+//
+// RUN: env CINDEXTEST_EDITING=1 c-index-test -test-load-source-reparse 3 local -fcheckedc-extension -Wcheck-bounds-decls %s 2>&1 | FileCheck %s
+
+struct S {
+  _Array_ptr<int> data : count(len);
+  int len;
+};
+
+int f1(struct S *s) {
+  _Array_ptr<int> q : count(s->len) = s->data;
+  return q[0];
+}
+
+void f2(_Array_ptr<int> p : count(n), int n, int m) {
+  _Array_ptr<int> q : count(m) = p;
+}
+
+void f3(_Array_ptr<int> p : count(5)) {
+  _Array_ptr<int> q : count(10) = p;
+}
+
+// CHECK-DAG: reparse-bounds.c:19:19: warning: cannot prove declared bounds for 'q' are valid after initialization
+// CHECK-DAG: reparse-bounds.c:23:19: error: declared bounds for 'q' are invalid after initialization
@@ -0,0 +1,45 @@
+// Tests for proving bounds whose bounds differ by linear expressions over
+// variables (-fcheckedc-symbolic-bounds).
+//
+// RUN: %clang_cc1 -fcheckedc-extension -Wcheck-bounds-decls -fcheckedc-symbolic-bounds -verify -verify-ignore-unexpected=note %s
+//
+// Without the option, each of the declarations and calls below that has no
+// expected diagnostic cannot be proved valid.
+
+void f1(_Array_ptr<int> p : count(n), int n) {
+  _Array_ptr<int> q : count(n - 1) = p;
+  _Array_ptr<int> r : bounds(p + 1, p + n) = p;
+  _Array_ptr<int> s : bounds(p + n - n, p + 2 * n - n) = p;
+}
+
+void take(_Array_ptr<int> b : count(k), int k);
+
+void f2(_Array_ptr<int> p : count(n), int n) {
+  take(p, n - 1);
+  take(p + 1, n - 1);
+  take(p, n + 1); // expected-error {{argument does not meet declared bounds for 1st parameter}}
+}
+
+// Bounds that are provably wider than the source bounds are errors.
+void f3(_Array_ptr<int> p : count(n), int n) {
+  _Array_ptr<int> q : count(n + 1) = p; // expected-error {{declared bounds for 'q' are invalid after initialization}}
+  _Array_ptr<int> r : bounds(p - 1, p + n) = p; // expected-error {{declared bounds for 'r' are invalid after initialization}}
+}
+
+// Unsigned arithmetic may wrap around, so it is not rearranged.
+void f4(_Array_ptr<int> p : count(n), unsigned int n) {
+  _Array_ptr<int> q : count(n - 1) = p; // expected-warning {{cannot prove declared bounds for 'q' are valid after initialization}}
+}
+
+// Different variables are unrelated.
+void f5(_Array_ptr<int> p : count(n), int n, int m) {
+  _Array_ptr<int> q : count(m) = p; // expected-warning {{cannot prove declared bounds for 'q' are valid after initialization}}
+}
+
+// Memory accesses with offsets that are linear expressions.
+void f6(_Array_ptr<int> p : bounds(p + i, p + i + 2), int i) {
+  int x = p[i];
+  x = p[i + 1];
+  x = p[i + 2]; // expected-warning {{out-of-bounds memory access}}
+  x = p[i - 1]; // expected-warning {{out-of-bounds memory access}}
+}
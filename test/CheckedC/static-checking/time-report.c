@@ -0,0 +1,41 @@
+// Tests for reporting the time spent checking bounds (-fcheckedc-time-report).
+//
+// RUN: %clang_cc1 -fcheckedc-extension -fsyntax-only -fcheckedc-time-report %s 2>&1 | FileCheck %s
+// RUN: rm -f %t.json
+// RUN: %clang_cc1 -fcheckedc-extension -fsyntax-only -fcheckedc-time-report-json=%t.json %s 2>/dev/null
+// RUN: FileCheck %s --check-prefix=JSON < %t.json
+// RUN: not %clang_cc1 -fcheckedc-extension -fsyntax-only -fcheckedc-time-report-json=%t.dir/does/not/exist.json %s 2>&1 | FileCheck %s --check-prefix=BADFILE
+
+void f1(_Array_ptr<int> p : count(n), int n) {
+  _Array_ptr<int> q : count(n) = p;
+  q[0] = 1;
+}
+
+struct S {
+  _Array_ptr<int> data : count(len);
+  int len;
+};
+
+int f2(struct S *s) {
+  return s->data[0];
+}
+
+// CHECK: Checked C bounds checking time per function
+// CHECK: Total functions checked: 2
+// CHECK: Total expression comparisons: {{[0-9]+}}
+// CHECK-DAG: {{[0-9.]+ +[0-9.]+ +[0-9.]+ +[0-9.]+ +[0-9.]+ +[0-9]+}}  f1 ({{.*}}time-report.c:9:6)
+// CHECK-DAG: {{[0-9.]+ +[0-9.]+ +[0-9.]+ +[0-9.]+ +[0-9.]+ +[0-9]+}}  f2 ({{.*}}time-report.c:19:5)
+// CHECK: Checked C bounds checking
+// CHECK-DAG: Bounds inference
+// CHECK-DAG: Bounds declaration validity proofs
+// CHECK-DAG: Member bounds concretization
+
+// JSON: {
+// JSON-NEXT: "functions": [
+// JSON-NEXT: { "name": "f1", "location": "{{.*}}time-report.c:9:6", "total": {{[0-9.]+}}, "inference": {{[0-9.]+}}, "decl-validity": {{[0-9.]+}}, "member-bounds": {{[0-9.]+}}, "non-modifying": {{[0-9.]+}}, "comparisons": {{[0-9]+}} },
+// JSON-NEXT: { "name": "f2", "location": "{{.*}}time-report.c:19:5", "total": {{[0-9.]+}}, "inference": {{[0-9.]+}}, "decl-validity": {{[0-9.]+}}, "member-bounds": {{[0-9.]+}}, "non-modifying": {{[0-9.]+}}, "comparisons": {{[0-9]+}} }
+// JSON-NEXT: ],
+// JSON-NEXT: "comparisons": {{[0-9]+}}
+// JSON-NEXT: }
+
+// BADFILE: fatal error: cannot open file '{{.*}}exist.json'
@@ -0,0 +1,45 @@
+// Tests that members used in the bounds of checked members of their struct
+// get a TBAA type of their own. Their address can't be taken, so stores
+// through pointers to their type can't modify them.
+//
+// RUN: %clang_cc1 -triple x86_64-unknown-unknown -fcheckedc-extension %s -emit-llvm -O1 -disable-llvm-passes -o - | FileCheck %s
+
+struct S {
+  _Array_ptr<int> buf : count(len);
+  int len;
+  int other;
+};
+
+// Members used only in bounds-safe interfaces can have their address taken
+// in unchecked code, so they keep the TBAA type of their type.
+struct U {
+  int *p : count(n);
+  int n;
+};
+
+// CHECK-LABEL: define i32 @get_len
+// CHECK: load i32, i32* {{%.*}}, align 8, !tbaa [[LEN:![0-9]+]]
+int get_len(struct S *s) { return s->len; }
+
+// CHECK-LABEL: define i32 @get_other
+// CHECK: load i32, i32* {{%.*}}, align 4, !tbaa [[OTHER:![0-9]+]]
+int get_other(struct S *s) { return s->other; }
+
+// CHECK-LABEL: define i32 @get_n
+// CHECK: load i32, i32* {{%.*}}, align 8, !tbaa [[N:![0-9]+]]
+int get_n(struct U *u) { return u->n; }
+
+// CHECK-LABEL: define void @copy
+// CHECK: call void @llvm.memcpy{{.*}}, !tbaa.struct [[COPY:![0-9]+]]
+void copy(struct S *a, struct S *b) { *a = *b; }
+
+// CHECK-DAG: [[LEN]] = !{[[S:![0-9]+]], [[BOUNDS:![0-9]+]], i64 8}
+// CHECK-DAG: [[S]] = !{!"S", [[PTR:![0-9]+]], i64 0, [[BOUNDS]], i64 8, [[INT:![0-9]+]], i64 12}
+// CHECK-DAG: [[BOUNDS]] = !{!"checked bounds member", [[CHAR:![0-9]+]], i64 0}
+// CHECK-DAG: [[INT]] = !{!"int", [[CHAR]], i64 0}
+// CHECK-DAG: [[OTHER]] = !{[[S]], [[INT]], i64 12}
+// CHECK-DAG: [[N]] = !{[[U:![0-9]+]], [[INT]], i64 8}
+// CHECK-DAG: [[U]] = !{!"U", [[PTR]], i64 0, [[INT]], i64 8}
+// CHECK-DAG: [[COPY]] = !{i64 0, i64 8, [[PTRTAG:![0-9]+]], i64 8, i64 4, [[BOUNDSTAG:![0-9]+]], i64 12, i64 4, [[INTTAG:![0-9]+]]}
+// CHECK-DAG: [[BOUNDSTAG]] = !{[[BOUNDS]], [[BOUNDS]], i64 0}
+// CHECK-DAG: [[INTTAG]] = !{[[INT]], [[INT]], i64 0}
@@ -0,0 +1,5 @@
+void launder(int *p);
+
+static inline int first(int *p) {
+  return *p;
+}
@@ -0,0 +1,10 @@
+#include "header_decls.h"
+
+void fb(void) {
+  int a = 0;
+  int *b = &a;
+  int *e = &a;
+
+  first(b);
+  launder(e);
+}
@@ -0,0 +1,6 @@
+// A system header for system_decls.c. Most of its declarations are not
+// used.
+extern int *sys_global;
+extern int *sys_unused(int *p, int **q);
+extern void sys_mut(int *p);
+extern int *sys_unused2(void (*f)(int *, char *), char *s);
@@ -0,0 +1,33 @@
+// Tests for Checked C rewriter tool.
+//
+// Checks that the declarations of a header that an earlier compilation unit
+// included constrain a later one, although they are not visited again.
+//
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: cp %s %t/a.c && cp %S/Inputs/header_decls_b.c %t/b.c
+// RUN: cp %S/Inputs/header_decls.h %t/header_decls.h
+// RUN: checked-c-convert -base-dir=%t -output-postfix=checked %t/a.c %t/b.c --
+// RUN: FileCheck -match-full-lines -check-prefix=CHECK-A %s < %t/a.checked.c
+// RUN: FileCheck -match-full-lines -check-prefix=CHECK-B %s < %t/b.checked.c
+#include "header_decls.h"
+
+void launder(int *p) {
+  char *c = (char *)p;
+  *c = 1;
+}
+//CHECK-A: void launder(int *p) {
+
+void fa(void) {
+  int a = 0;
+  int *b = &a;
+
+  first(b);
+}
+//CHECK-A: void fa(void) {
+//CHECK-A-NEXT: int a = 0;
+//CHECK-A-NEXT: _Ptr<int> b = &a;
+
+//CHECK-B: void fb(void) {
+//CHECK-B-NEXT: int a = 0;
+//CHECK-B-NEXT: _Ptr<int> b = &a;
+//CHECK-B-NEXT: int *e = &a;
@@ -0,0 +1,22 @@
+// Tests for Checked C rewriter tool.
+//
+// Checks that the declarations in system headers that are used constrain
+// the program, although the variables of the ones in system headers are
+// only made when they are used.
+//
+// RUN: checked-c-convert %s -- -isystem %S/Inputs | FileCheck -match-full-lines %s
+// RUN: checked-c-convert %s -- -isystem %S/Inputs | %clang_cc1 -isystem %S/Inputs -verify -fcheckedc-extension -x c -
+// expected-no-diagnostics
+#include <system_decls.h>
+
+void f1(void) {
+  int a = 0;
+  int *b = &a;
+  int *c = &a;
+
+  sys_mut(c);
+}
+//CHECK: void f1(void) {
+//CHECK-NEXT: int a = 0;
+//CHECK-NEXT: _Ptr<int> b = &a;
+//CHECK-NEXT: int *c = &a;
@@ -0,0 +1,43 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm -o - %s | FileCheck %s
+
+// Large aggregates initialized only with constants are copied from a constant
+// global, or set with a memset and a few stores, instead of being stored an
+// element at a time.
+
+struct Message { int kind, flags, length, checksum; long id; char tag[8]; };
+struct Big { int a[64]; };
+
+void use(struct Message *);
+void use_big(struct Big *);
+
+// CHECK: @agg.init = private unnamed_addr constant %struct.Message { i32 1, i32 2, i32 3, i32 4, i64 5, [8 x i8] c"hello\00\00\00" }, align 8
+
+// CHECK-LABEL: define void @dense(
+// CHECK: call void @llvm.memcpy.p0i8.p0i8.i64(i8* {{.*}}, i8* bitcast (%struct.Message* @agg.init to i8*), i64 32, i32 8, i1 false)
+// CHECK-NOT: store i32
+// CHECK: ret void
+void dense(struct Message *m) {
+  *m = (struct Message){ 1, 2, 3, 4, 5, "hello" };
+  use(m);
+}
+
+// CHECK-LABEL: define void @sparse(
+// CHECK: call void @llvm.memset.p0i8.i64(i8* {{.*}}, i8 0, i64 256, i32 4, i1 false)
+// CHECK: store i32 7
+// CHECK-NOT: store
+// CHECK: ret void
+void sparse(struct Big *b) {
+  *b = (struct Big){ { [10] = 7 } };
+  use_big(b);
+}
+
+// Initializers with values that are not constant store their elements.
+// CHECK-LABEL: define void @not_constant(
+// CHECK-NOT: @llvm.memcpy
+// CHECK: store i32 1
+// CHECK: store i32 %
+// CHECK: ret void
+void not_constant(struct Message *m, int flags) {
+  *m = (struct Message){ 1, flags, 3, 4, 5, "hello" };
+  use(m);
+}
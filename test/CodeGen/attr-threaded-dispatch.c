@@ -0,0 +1,105 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm -o - %s | FileCheck %s
+
+enum Op { OP_INC, OP_DEC, OP_DBL, OP_NEG, OP_RET };
+
+// CHECK: @switch.targets = private unnamed_addr constant [5 x i8*] [i8* blockaddress(@run, [[INC:%[^)]+]]), i8* blockaddress(@run, [[DEC:%[^)]+]]), i8* blockaddress(@run, [[DBL:%[^)]+]]), i8* blockaddress(@run, [[NEG:%[^)]+]]), i8* blockaddress(@run, [[RET:%[^)]+]])]
+// CHECK: @switch.targets.1 = private unnamed_addr constant [7 x i8*] [i8* blockaddress(@sparse_holes, [[B10:%[^)]+]]), i8* blockaddress(@sparse_holes, [[HOLE:%[^)]+]]), i8* blockaddress(@sparse_holes, [[B12:%[^)]+]]), i8* blockaddress(@sparse_holes, [[HOLE]]), i8* blockaddress(@sparse_holes, [[B14:%[^)]+]]), i8* blockaddress(@sparse_holes, [[HOLE]]), i8* blockaddress(@sparse_holes, [[B16:%[^)]+]])]
+
+// CHECK-LABEL: define i32 @run(
+// CHECK: [[INDEX:%.*]] = sub i32 {{%.*}}, 0
+// CHECK: [[IN:%.*]] = icmp ult i32 [[INDEX]], 5
+// CHECK: br i1 [[IN]], label {{%.*}}, label %[[DEFAULT:.*]]
+// CHECK: [[WIDE:%.*]] = zext i32 [[INDEX]] to i64
+// CHECK: [[SLOT:%.*]] = getelementptr inbounds [5 x i8*], [5 x i8*]* @switch.targets, i64 0, i64 [[WIDE]]
+// CHECK: [[TARGET:%.*]] = load i8*, i8** [[SLOT]], align 8
+// CHECK: indirectbr i8* [[TARGET]], [label %[[DEFAULT]], label [[INC]], label [[DEC]], label [[DBL]], label [[NEG]], label [[RET]]]
+__attribute__((threaded_dispatch))
+int run(const unsigned char *pc) {
+  int acc = 0;
+  for (;;) {
+    switch (*pc++) {
+    case OP_INC: acc++; break;
+    case OP_DEC: acc--; break;
+    case OP_DBL: acc *= 2; break;
+    case OP_NEG: acc = -acc; break;
+    case OP_RET: return acc;
+    }
+  }
+}
+
+// CHECK-LABEL: define i32 @sparse_holes(
+// CHECK: sub i32 {{%.*}}, 10
+// CHECK: icmp ult i32 {{%.*}}, 7
+// CHECK: indirectbr
+__attribute__((threaded_dispatch))
+int sparse_holes(const int *pc) {
+  int acc = 0;
+  while (1) {
+    switch (*pc++) {
+    case 10: acc++; break;
+    case 12: acc--; break;
+    case 14: acc *= 2; break;
+    case 16: return acc;
+    }
+  }
+}
+
+// Switches outside of loops, with too few cases or with sparse cases keep
+// the switch instruction.
+
+// CHECK-LABEL: define i32 @not_in_loop(
+// CHECK: switch i32
+// CHECK-NOT: indirectbr
+__attribute__((threaded_dispatch))
+int not_in_loop(int op) {
+  switch (op) {
+  case 0: return 1;
+  case 1: return 2;
+  case 2: return 3;
+  case 3: return 4;
+  }
+  return 0;
+}
+
+// CHECK-LABEL: define i32 @few_cases(
+// CHECK: switch i32
+// CHECK-NOT: indirectbr
+__attribute__((threaded_dispatch))
+int few_cases(const int *pc) {
+  for (;;) {
+    switch (*pc++) {
+    case 0: break;
+    case 1: return 1;
+    }
+  }
+}
+
+// CHECK-LABEL: define i32 @sparse(
+// CHECK: switch i32
+// CHECK-NOT: indirectbr
+__attribute__((threaded_dispatch))
+int sparse(const int *pc) {
+  for (;;) {
+    switch (*pc++) {
+    case 0: break;
+    case 100: break;
+    case 200: break;
+    case 300: return 1;
+    }
+  }
+}
+
+// CHECK-LABEL: define i32 @no_attr(
+// CHECK: switch i32
+// CHECK-NOT: indirectbr
+int no_attr(const int *pc) {
+  int acc = 0;
+  for (;;) {
+    switch (*pc++) {
+    case 0: acc++; break;
+    case 1: acc--; break;
+    case 2: acc *= 2; break;
+    case 3: return acc;
+    }
+  }
+}
@@ -0,0 +1,35 @@
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm -o - %s | FileCheck %s
+
+// Arrays of integers and floating-point values are emitted as data arrays.
+
+unsigned char u8[4] = { 1, 2, 255 };
+// CHECK: @u8 = global [4 x i8] c"\01\02\FF\00"
+
+short s16[3] = { -1, 2, 3 };
+// CHECK: @s16 = global [3 x i16] [i16 -1, i16 2, i16 3]
+
+int i32[5] = { 1, -2, [4] = 7 };
+// CHECK: @i32 = global [5 x i32] [i32 1, i32 -2, i32 0, i32 0, i32 7]
+
+long long i64[2] = { 0x123456789aLL };
+// CHECK: @i64 = global [2 x i64] [i64 78187493530, i64 0]
+
+float f32[3] = { 1.0f, 0.5f };
+// CHECK: @f32 = global [3 x float] [float 1.000000e+00, float 5.000000e-01, float 0.000000e+00]
+
+double f64[2] = { 2.0, -0.0 };
+// CHECK: @f64 = global [2 x double] [double 2.000000e+00, double -0.000000e+00]
+
+int zeros[100] = { 0, 0 };
+// CHECK: @zeros = global [100 x i32] zeroinitializer
+
+enum E { A = 1, B = 2 };
+enum E enums[2] = { B, A };
+// CHECK: @enums = global [2 x i32] [i32 2, i32 1]
+
+// Arrays of other element types are emitted an element at a time.
+_Bool bools[3] = { 1, 0, 1 };
+// CHECK: @bools = global [3 x i8] c"\01\00\01"
+
+long double ld[2] = { 1.0L };
+// CHECK: @ld = global [2 x x86_fp80] [x86_fp80 0xK3FFF8000000000000000, x86_fp80 0xK00000000000000000000]
@@ -0,0 +1 @@
+template <typename T> T twice(T X) { return X + X; }
@@ -0,0 +1,28 @@
+// The jobs of the inputs are run at once, and their diagnostics are
+// printed in the order of the inputs.
+// RUN: %clang -fdriver-jobs=2 -fsyntax-only %s %S/Inputs/driver-jobs.c 2>&1 \
+// RUN:   | FileCheck %s
+// CHECK: warning: first input
+// CHECK: warning: second input
+
+// The jobs after a failing job are not reported.
+// RUN: not %clang -fdriver-jobs=2 -fsyntax-only -DFAIL %s \
+// RUN:   %S/Inputs/driver-jobs.c 2>&1 | FileCheck --check-prefix=FAIL %s
+// FAIL: error: first input
+// FAIL-NOT: second input
+
+// The option is not passed to the compiler.
+// RUN: %clang -fdriver-jobs=4 -fsyntax-only %s -### 2>&1 \
+// RUN:   | FileCheck --check-prefix=ARGS %s
+// ARGS-NOT: fdriver-jobs
+// ARGS: "-cc1"
+
+// RUN: not %clang -fdriver-jobs=0 -fsyntax-only %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=INVALID %s
+// INVALID: invalid integral value '0' in '-fdriver-jobs=0'
+
+#ifdef FAIL
+#error first input
+#else
+#warning first input
+#endif
@@ -0,0 +1,28 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: %clangxx -S -ftime-trace -ftime-trace-granularity=0 -o %t/ftime-trace.s %s
+// RUN: FileCheck %s < %t/ftime-trace.json
+// RUN: %clangxx -### -c -ftime-trace -ftime-trace-granularity=50 %s 2>&1 \
+// RUN:   | FileCheck --check-prefix=DRIVER %s
+
+// CHECK: {"traceEvents":[
+// CHECK-DAG: "name":"Source","args":{"detail":"{{.*}}Inputs{{/|\\\\}}ftime-trace.h"}
+// CHECK-DAG: "name":"InstantiateFunction","args":{"detail":"twice<int>"}
+// CHECK-DAG: "name":"InstantiateClass","args":{"detail":"Box<int>"}
+// CHECK-DAG: "name":"CodeGenFunction","args":{"detail":"use"}
+// CHECK-DAG: "name":"Frontend"
+// CHECK-DAG: "name":"Backend"
+// CHECK-DAG: "name":"ExecuteCompiler"
+// CHECK-DAG: "name":"Total InstantiateFunction","args":{"count":"1"}
+// CHECK: "displayTimeUnit":"ms"}
+
+// DRIVER: "-ftime-trace"
+// DRIVER-SAME: "-ftime-trace-granularity=50"
+
+#include "Inputs/ftime-trace.h"
+
+template <typename T> struct Box { T Value; };
+
+int use() {
+  Box<int> B = {twice(21)};
+  return B.Value;
+}
@@ -0,0 +1,24 @@
+// The detected GCC installation is cached in the directory given by
+// CLANG_GCC_INSTALLATION_CACHE, and detected again once the directories
+// that the detection looked at change.
+// REQUIRES: shell
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: cp -r %S/Inputs/basic_linux_tree %t/tree
+// RUN: env CLANG_GCC_INSTALLATION_CACHE=%t/cache %clang -v \
+// RUN:   --target=x86_64-unknown-linux --gcc-toolchain="" --sysroot=%t/tree \
+// RUN:   2>&1 | FileCheck --check-prefix=OLD %s
+// RUN: ls %t/cache | FileCheck --check-prefix=ENTRY %s
+// RUN: env CLANG_GCC_INSTALLATION_CACHE=%t/cache %clang -v \
+// RUN:   --target=x86_64-unknown-linux --gcc-toolchain="" --sysroot=%t/tree \
+// RUN:   2>&1 | FileCheck --check-prefix=OLD %s
+// OLD: Found candidate GCC installation: {{.*}}tree/usr/lib/gcc/x86_64-unknown-linux/4.6.0
+// OLD: Selected GCC installation: {{.*}}tree/usr/lib/gcc/x86_64-unknown-linux/4.6.0
+// ENTRY: gcc-{{[0-9A-F]+$}}
+
+// RUN: mkdir %t/tree/usr/lib/gcc/x86_64-unknown-linux/4.7.0
+// RUN: touch %t/tree/usr/lib/gcc/x86_64-unknown-linux/4.7.0/crtbegin.o
+// RUN: env CLANG_GCC_INSTALLATION_CACHE=%t/cache %clang -v \
+// RUN:   --target=x86_64-unknown-linux --gcc-toolchain="" --sysroot=%t/tree \
+// RUN:   2>&1 | FileCheck --check-prefix=NEW %s
+// NEW: Selected GCC installation: {{.*}}tree/usr/lib/gcc/x86_64-unknown-linux/4.7.0
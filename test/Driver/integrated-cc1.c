@@ -0,0 +1,21 @@
+// RUN: %clang -target x86_64-unknown-linux-gnu -fintegrated-cc1 -S -emit-llvm %s -o - | FileCheck %s
+// RUN: %clang -target x86_64-unknown-linux-gnu -fintegrated-cc1 -fno-integrated-cc1 -S -emit-llvm %s -o - | FileCheck %s
+// CHECK: define i32 @f()
+
+// A crash of the compiler run in the driver process is reported like the
+// crash of a compiler process, with a reproducer.
+// RUN: rm -rf %t
+// RUN: mkdir %t
+// RUN: not env TMPDIR=%t TEMP=%t TMP=%t %clang -fintegrated-cc1 -fsyntax-only -DCRASH %s 2>&1 | FileCheck --check-prefix=CRASH %s
+// RUN: cat %t/integrated-cc1-*.c | FileCheck --check-prefix=CRASHSRC %s
+// REQUIRES: crash-recovery
+// REQUIRES: shell
+// CRASH: clang frontend command failed due to signal
+// CRASH: Preprocessed source(s) and associated run script(s) are located at:
+// CRASHSRC: int f()
+
+int f() { return 0; }
+
+#ifdef CRASH
+#pragma clang __debug parser_crash
+#endif
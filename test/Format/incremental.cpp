@@ -0,0 +1,13 @@
+// RUN: grep -Ev "// *[A-Z-]+:" %s \
+// RUN:   | clang-format -style=LLVM -incremental -lines=3:4 \
+// RUN:   | FileCheck -strict-whitespace %s
+// CHECK: {{^int\ \ \*\ \ i;$}}
+int  *  i;
+
+// CHECK: {{^int\ \*j;$}}
+// CHECK: {{^int\ \*k;$}}
+int   *   j;
+int*k;
+
+// CHECK: {{^int\ \ \*\ \ l;$}}
+int  *  l;
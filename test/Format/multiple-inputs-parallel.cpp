@@ -0,0 +1,25 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t/a %t/b
+// RUN: printf "BasedOnStyle: LLVM\nIndentWidth: 3\n" > %t/a/.clang-format
+// RUN: printf "BasedOnStyle: LLVM\nIndentWidth: 5\n" > %t/b/.clang-format
+// RUN: grep -Ev "// *[A-Z-]+:" %s > %t/a/1.cpp
+// RUN: grep -Ev "// *[A-Z-]+:" %s > %t/b/2.cpp
+// RUN: grep -Ev "// *[A-Z-]+:" %s > %t/a/3.cpp
+// RUN: clang-format -style=file -j 2 %t/a/1.cpp %t/b/2.cpp %t/a/3.cpp \
+// RUN:   | FileCheck -strict-whitespace %s
+// RUN: clang-format -style=file -j 0 -i %t/a/1.cpp %t/b/2.cpp %t/a/3.cpp
+// RUN: FileCheck -strict-whitespace -check-prefix=CHECK3 -input-file=%t/a/1.cpp %s
+// RUN: FileCheck -strict-whitespace -check-prefix=CHECK5 -input-file=%t/b/2.cpp %s
+// RUN: FileCheck -strict-whitespace -check-prefix=CHECK3 -input-file=%t/a/3.cpp %s
+
+// CHECK: {{^void\ f\(\)\ {$}}
+// CHECK-NEXT: {{^\ \ \ g\(\);$}}
+// CHECK: {{^void\ f\(\)\ {$}}
+// CHECK-NEXT: {{^\ \ \ \ \ g\(\);$}}
+// CHECK: {{^void\ f\(\)\ {$}}
+// CHECK-NEXT: {{^\ \ \ g\(\);$}}
+// CHECK3: {{^\ \ \ g\(\);$}}
+// CHECK5: {{^\ \ \ \ \ g\(\);$}}
+void f() {
+g();
+}
@@ -0,0 +1,3 @@
+static inline int system_fn(void) {
+  return system_undeclared;
+}
@@ -0,0 +1,3 @@
+static inline int user_fn(void) {
+  return user_undeclared;
+}
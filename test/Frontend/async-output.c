@@ -0,0 +1,16 @@
+// REQUIRES: x86-registered-target
+
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj -o %t.o %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-obj -fasync-output -o %t.async.o %s
+// RUN: cmp %t.o %t.async.o
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm-bc -o %t.bc %s
+// RUN: %clang_cc1 -triple x86_64-unknown-linux-gnu -emit-llvm-bc -fasync-output -o %t.async.bc %s
+// RUN: cmp %t.bc %t.async.bc
+
+// RUN: %clang -### -c -fasync-output %s 2>&1 | FileCheck %s
+// CHECK: "-cc1"
+// CHECK-SAME: "-fasync-output"
+
+int table[4096] = {1, 2, 3};
+
+int f(int x) { return table[x & 4095] + x; }
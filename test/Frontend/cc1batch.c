@@ -0,0 +1,38 @@
+// RUN: rm -rf %t && mkdir -p %t
+// RUN: echo '-cc1 -triple x86_64-unknown-unknown -emit-llvm -DVALUE=1 -o %t/a.ll %s' > %t/jobs
+// RUN: echo '# Comments and blank lines are skipped.' >> %t/jobs
+// RUN: echo '' >> %t/jobs
+// RUN: echo '-triple x86_64-unknown-unknown -emit-llvm -o %t/b.ll %s' >> %t/jobs
+// RUN: %clang -cc1batch %t/jobs
+// RUN: FileCheck --check-prefix=A %s < %t/a.ll
+// RUN: FileCheck --check-prefix=B %s < %t/b.ll
+//
+// A failing job makes the batch fail, but later jobs still run.
+// RUN: echo '-triple x86_64-unknown-unknown -fsyntax-only -DBROKEN %s' > %t/bad
+// RUN: echo '-triple x86_64-unknown-unknown -emit-llvm -o %t/c.ll %s' >> %t/bad
+// RUN: not %clang -cc1batch %t/bad 2>&1 | FileCheck --check-prefix=BAD %s
+// RUN: FileCheck --check-prefix=B %s < %t/c.ll
+//
+// With -j, jobs run concurrently, and the result is the same.
+// RUN: rm -f %t/a.ll %t/b.ll %t/c.ll
+// RUN: %clang -cc1batch -j 4 %t/jobs
+// RUN: FileCheck --check-prefix=A %s < %t/a.ll
+// RUN: FileCheck --check-prefix=B %s < %t/b.ll
+// RUN: not %clang -cc1batch -j4 %t/bad 2>&1 | FileCheck --check-prefix=BAD %s
+// RUN: FileCheck --check-prefix=B %s < %t/c.ll
+// RUN: not %clang -cc1batch -j0 %t/jobs 2>&1 | FileCheck --check-prefix=BADJ %s
+// BADJ: error: invalid -j value '0' given to -cc1batch
+
+#ifdef BROKEN
+#error broken job
+// BAD: error: broken job
+#endif
+
+// Macros of one job are not seen by the next.
+#ifdef VALUE
+int value = VALUE;
+// A: @value = global i32 1
+#else
+int value = 0;
+// B: @value = global i32 0
+#endif
@@ -0,0 +1,27 @@
+// RUN: not %clang_cc1 -fsyntax-only -I %S/Inputs/skip-function-bodies -isystem %S/Inputs/skip-function-bodies/system %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefixes=SYSTEM,USER,MAIN
+// RUN: not %clang_cc1 -fsyntax-only -I %S/Inputs/skip-function-bodies -isystem %S/Inputs/skip-function-bodies/system %s 2>&1 \
+// RUN:     -fskip-function-bodies=system-headers \
+// RUN:   | FileCheck %s --check-prefixes=NO-SYSTEM,USER,MAIN
+// RUN: not %clang_cc1 -fsyntax-only -I %S/Inputs/skip-function-bodies -isystem %S/Inputs/skip-function-bodies/system %s 2>&1 \
+// RUN:     -fskip-function-bodies=headers \
+// RUN:   | FileCheck %s --check-prefixes=NO-SYSTEM,NO-USER,MAIN
+// RUN: %clang_cc1 -fsyntax-only -I %S/Inputs/skip-function-bodies -isystem %S/Inputs/skip-function-bodies/system %s \
+// RUN:     -fskip-function-bodies=all
+// RUN: not %clang_cc1 -fsyntax-only -fskip-function-bodies=bogus %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=BOGUS
+
+// BOGUS: invalid value 'bogus' in '-fskip-function-bodies=bogus'
+
+#include "user.h"
+#include <system.h>
+
+int main_fn(void) {
+  return main_undeclared;
+}
+
+// NO-USER-NOT: user_undeclared
+// USER: user.h:2:10: error: use of undeclared identifier 'user_undeclared'
+// NO-SYSTEM-NOT: system_undeclared
+// SYSTEM: system.h:2:10: error: use of undeclared identifier 'system_undeclared'
+// MAIN: skip-function-bodies.c:20:10: error: use of undeclared identifier 'main_undeclared'
@@ -0,0 +1,3 @@
+int h(int); int h(long);
+static_assert(sizeof(h(1u)) == sizeof(int), "");
+static_assert(false, "bad header");
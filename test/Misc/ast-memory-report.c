@@ -0,0 +1,15 @@
+// RUN: %clang_cc1 -fsyntax-only -fcheckedc-extension -fast-memory-report %s 2>&1 | FileCheck %s
+
+int f(_Array_ptr<int> p : count(n), int n) {
+  return n > 0 ? p[0] : 0;
+}
+
+// CHECK: {
+// CHECK-NEXT: "total": {{[0-9]+}},
+// CHECK-NEXT: "allocated": {"decls": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}}, "stmts": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}}, "other": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}}},
+// CHECK-NEXT: "types": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}, "kinds": {{.*}}"FunctionProto": {"count": {{[0-9]+}}
+// CHECK-NEXT: "decls": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}, "templateSpecializations": {"count": 0, "bytes": 0}, "kinds": {{.*}}"ParmVar": {"count": {{[0-9]+}},
+// CHECK-NEXT: "stmts": {"count": {{[0-9]+}}, "bytes": {{[0-9]+}}, "boundsExprs": {"count": {{[1-9][0-9]*}}, "bytes": {{[1-9][0-9]*}}}, "kinds": {{.*}}"CountBoundsExpr": {"count":
+// CHECK-NEXT: "sideTables": {"bytes": {{[0-9]+}}, "bounds": {{[0-9]+}}, "templates": {{[0-9]+}}},
+// CHECK-NEXT: "sourceManager": {"contentCaches": {{[0-9]+}}, "dataStructures": {{[0-9]+}}, "mallocBuffers": {{[0-9]+}}, "mmapBuffers": {{[0-9]+}}}
+// CHECK-NEXT: }
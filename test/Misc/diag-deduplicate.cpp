@@ -0,0 +1,34 @@
+// RUN: not %clang_cc1 -std=c++11 -fsyntax-only -fdiagnostics-deduplicate %s 2>&1 | FileCheck %s
+// RUN: not %clang_cc1 -std=c++11 -fsyntax-only %s 2>&1 | FileCheck -check-prefix=ALL %s
+// RUN: not %clang_cc1 -std=c++11 -fsyntax-only -fdiagnostics-snippet-repeat-limit 1 %s 2>&1 | FileCheck -check-prefix=SNIPPET %s
+
+// The header has no include guard, so its errors are reported for each
+// inclusion.
+#include "Inputs/diag-deduplicate.h"
+#include "Inputs/diag-deduplicate.h"
+#include "Inputs/diag-deduplicate.h"
+
+// CHECK: diag-deduplicate.h:2:{{[0-9]+}}: error: call to 'h' is ambiguous
+// CHECK: note: candidate function
+// CHECK: note: candidate function
+// CHECK: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// CHECK-NOT: error:
+// CHECK-NOT: note:
+// CHECK: 6 errors generated.
+
+// ALL: diag-deduplicate.h:2:{{[0-9]+}}: error: call to 'h' is ambiguous
+// ALL: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// ALL: diag-deduplicate.h:2:{{[0-9]+}}: error: call to 'h' is ambiguous
+// ALL: note: candidate function
+// ALL: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// ALL: diag-deduplicate.h:2:{{[0-9]+}}: error: call to 'h' is ambiguous
+// ALL: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// ALL: 6 errors generated.
+
+// SNIPPET: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// SNIPPET-NEXT: static_assert(false, "bad header");
+// SNIPPET: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// SNIPPET-NOT: static_assert(false
+// SNIPPET: diag-deduplicate.h:3:1: error: static_assert failed "bad header"
+// SNIPPET-NOT: static_assert(false
+// SNIPPET: 6 errors generated.
@@ -0,0 +1,42 @@
+// RUN: rm -rf %t
+// RUN: mkdir -p %t
+// RUN: %clang_cc1 -fsyntax-only -Wall -serialize-diagnostic-file %t/a.dia %s
+// RUN: %clang_cc1 -fsyntax-only -Wall -DSECOND -serialize-diagnostic-file %t/b.dia %s
+// RUN: diagtool aggregate-diagnostics -o %t/table %t/a.dia %t/b.dia
+// RUN: diagtool dump-diagnostic-table %t/table | FileCheck %s
+// RUN: diagtool dump-diagnostic-table -flag=unused-variable %t/table \
+// RUN:   | FileCheck -check-prefix=FLAG %s
+// RUN: diagtool dump-diagnostic-table -file=%s -flag=uninitialized %t/table \
+// RUN:   | FileCheck -check-prefix=FILE %s
+// RUN: printf "%t/a.dia\n%t/b.dia\n" > %t/inputs
+// RUN: diagtool aggregate-diagnostics -o %t/table2 -inputs-from=%t/inputs
+// RUN: cmp %t/table %t/table2
+// RUN: not diagtool dump-diagnostic-table %t/a.dia 2>&1 \
+// RUN:   | FileCheck -check-prefix=INVALID %s
+
+void foo() {
+  int voodoo;
+  voodoo = voodoo + 1;
+}
+
+#ifdef SECOND
+void bar() {
+  int unused;
+}
+#endif
+
+// CHECK: a.dia: {{.*}}diagnostic-table.c:19:12: warning: variable 'voodoo' is uninitialized when used here [-Wuninitialized]
+// CHECK-NEXT: a.dia: {{.*}}diagnostic-table.c:18:13: note: initialize the variable 'voodoo' to silence this warning
+// CHECK-NEXT: b.dia: {{.*}}diagnostic-table.c:19:12: warning: variable 'voodoo' is uninitialized when used here [-Wuninitialized]
+// CHECK-NEXT: b.dia: {{.*}}diagnostic-table.c:18:13: note: initialize the variable 'voodoo' to silence this warning
+// CHECK-NEXT: b.dia: {{.*}}diagnostic-table.c:24:7: warning: unused variable 'unused' [-Wunused-variable]
+// CHECK-NEXT: Number of diagnostics: 5
+
+// FLAG: b.dia: {{.*}}diagnostic-table.c:24:7: warning: unused variable 'unused' [-Wunused-variable]
+// FLAG-NEXT: Number of diagnostics: 1
+
+// FILE: a.dia: {{.*}}diagnostic-table.c:19:12: warning: variable 'voodoo'
+// FILE-NEXT: b.dia: {{.*}}diagnostic-table.c:19:12: warning: variable 'voodoo'
+// FILE-NEXT: Number of diagnostics: 2
+
+// INVALID: error: Not a diagnostic table.
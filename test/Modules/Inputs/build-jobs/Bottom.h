@@ -0,0 +1 @@
+int bottom(void);
@@ -0,0 +1,2 @@
+#include "Bottom.h"
+int right(void);
@@ -0,0 +1,3 @@
+#include "Left.h"
+#include "Right.h"
+int top(void);
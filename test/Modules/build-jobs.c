@@ -0,0 +1,23 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-jobs=4 -I %S/Inputs/build-jobs -Rmodule-build \
+// RUN:   -fsyntax-only %s 2>&1 | FileCheck %s
+//
+// The modules are only built once.
+// RUN: %clang_cc1 -fmodules -fimplicit-module-maps -fmodules-cache-path=%t \
+// RUN:   -fmodules-build-jobs=4 -I %S/Inputs/build-jobs -Rmodule-build \
+// RUN:   -fsyntax-only %s 2>&1 | FileCheck %s --check-prefix=CHECK-CACHED \
+// RUN:   --allow-empty
+
+#include "Top.h"
+
+int f(void) { return top() + left() + right() + bottom(); }
+
+// The modules that Top uses are built before it.
+// CHECK-DAG: remark: building module 'Bottom'
+// CHECK-DAG: remark: building module 'Left'
+// CHECK-DAG: remark: building module 'Right'
+// CHECK: remark: building module 'Top'
+// CHECK-NOT: remark: building module
+
+// CHECK-CACHED-NOT: remark: building module
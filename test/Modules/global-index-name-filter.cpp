@@ -0,0 +1,15 @@
+// RUN: rm -rf %t
+// Run and create the global module index
+// RUN: %clang_cc1 -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -I %S/Inputs/global-index-name-filter %s -verify
+// RUN: ls %t|grep modules.idx
+// Run and use the name filters of the global module index
+// RUN: %clang_cc1 -fmodules-cache-path=%t -fdisable-module-hash -fmodules -fimplicit-module-maps -I %S/Inputs/global-index-name-filter %s -verify -print-stats 2>&1 | FileCheck %s
+
+// expected-no-diagnostics
+#include "a.h"
+#include "b.h"
+
+int f() { return N::alpha() + N::beta(); }
+
+// CHECK: *** Global Module Index Statistics:
+// CHECK: name filter lookups ruled out a module file
@@ -0,0 +1,11 @@
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -fsyntax-only -fmodules-cache-path=%t -fmodules -fimplicit-module-maps -F %S/Inputs -ftime-report %s 2>&1 | FileCheck %s
+
+// Each module file that is loaded, including the ones that are only imported
+// by other modules, gets its own timer.
+
+@import DependsOnModule;
+
+// CHECK-DAG: Reading module file {{.*}}DependsOnModule-{{.*}}.pcm
+// CHECK-DAG: Reading module file {{.*}}Module-{{.*}}.pcm
+// CHECK: Reading modules
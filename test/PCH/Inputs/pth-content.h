@@ -0,0 +1,2 @@
+/* The lexer warns about the nested /* only when it lexes this file. */
+int from_header;
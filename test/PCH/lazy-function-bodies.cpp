@@ -0,0 +1,23 @@
+// Check that the bodies of inline functions from a PCH are only
+// de-serialized when they are needed.
+//
+// RUN: %clang_cc1 -emit-pch -o %t %s
+// RUN: %clang_cc1 -include-pch %t -fsyntax-only -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-SYNTAX
+// RUN: %clang_cc1 -include-pch %t -emit-llvm -o %t.ll -print-stats %s 2>&1 \
+// RUN:   | FileCheck %s --check-prefix=CHECK-CODEGEN
+
+#ifndef HEADER
+#define HEADER
+
+inline int used(int x) { return x + 1; }
+inline int unused(int x) { return x * 2; }
+
+#else
+
+int f() { return used(1) + used(2); }
+
+// CHECK-SYNTAX: 0/1 function bodies read
+// CHECK-CODEGEN: 1/1 function bodies read
+
+#endif
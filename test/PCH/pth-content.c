@@ -0,0 +1,23 @@
+// Test the lookup of files in a token cache by the hash of their contents.
+//
+// RUN: rm -rf %t && mkdir -p %t/a %t/b %t/c
+// RUN: cp %S/Inputs/pth-content.h %t/a/pth-content.h
+// RUN: cp %S/Inputs/pth-content.h %t/b/pth-content.h
+// RUN: cp %S/Inputs/pth-content.h %t/c/pth-content.h
+// RUN: echo 'int changed;' >> %t/c/pth-content.h
+// RUN: %clang_cc1 -triple i386-unknown-unknown -w -emit-pth -o %t/cache.pth %t/a/pth-content.h
+//
+// A copy of the header at another path is replayed from the cache, so the
+// warning that the lexer emits is not repeated.
+// RUN: %clang_cc1 -triple i386-unknown-unknown -fsyntax-only -I %t/b -token-cache %t/cache.pth -token-cache-by-content %s 2>&1 | count 0
+//
+// The copy is not found by name, and a changed header is not found by
+// contents, so both are lexed.
+// RUN: %clang_cc1 -triple i386-unknown-unknown -fsyntax-only -I %t/b -token-cache %t/cache.pth %s 2>&1 | FileCheck %s
+// RUN: %clang_cc1 -triple i386-unknown-unknown -fsyntax-only -I %t/c -token-cache %t/cache.pth -token-cache-by-content %s 2>&1 | FileCheck %s
+
+// CHECK: warning: '/*' within block comment
+
+#include "pth-content.h"
+
+int *p = &from_header;
@@ -0,0 +1,31 @@
+// Test that -fvalidate-ast-input-files-content keeps a PCH whose input
+// files were only touched, and that the input files manifest is diagnosed.
+
+// RUN: rm -rf %t-dir
+// RUN: mkdir -p %t-dir
+// RUN: echo 'int f(void);' > %t-dir/header.h
+
+// RUN: %clang_cc1 -x c-header -emit-pch -fvalidate-ast-input-files-content -o %t-dir/header.pch %t-dir/header.h
+// RUN: llvm-bcanalyzer -dump %t-dir/header.pch | FileCheck -check-prefix=CHECK-BITCODE %s
+// RUN: touch -m -a -t 201008011501 %t-dir/header.h
+
+// The contents did not change, so the PCH is still valid.
+// RUN: %clang_cc1 -fvalidate-ast-input-files-content -include-pch %t-dir/header.pch -fsyntax-only %s
+
+// Without content validation, the PCH is out of date.
+// RUN: not %clang_cc1 -include-pch %t-dir/header.pch -fsyntax-only %s 2>&1 | FileCheck -check-prefix=CHECK-MODIFIED %s
+
+// A manifest that doesn't list the right hash doesn't vouch for the file.
+// RUN: echo "0123456789abcdef %t-dir/header.h" > %t-dir/manifest
+// RUN: not %clang_cc1 -fast-input-files-manifest=%t-dir/manifest -include-pch %t-dir/header.pch -fsyntax-only %s 2>&1 | FileCheck -check-prefix=CHECK-MODIFIED %s
+
+// RUN: echo "not-a-hash" > %t-dir/bad-manifest
+// RUN: not %clang_cc1 -fast-input-files-manifest=%t-dir/bad-manifest -include-pch %t-dir/header.pch -fsyntax-only %s 2>&1 | FileCheck -check-prefix=CHECK-BAD-MANIFEST %s
+
+// CHECK-BITCODE: <INPUT_FILE_HASH
+
+// CHECK-MODIFIED: fatal error: file {{.*}}header.h' has been modified since the precompiled header {{.*}} was built
+
+// CHECK-BAD-MANIFEST: error: invalid AST input files manifest '{{.*}}bad-manifest': malformed line 'not-a-hash'
+
+int g(void) { return f(); }
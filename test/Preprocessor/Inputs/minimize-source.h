@@ -0,0 +1,7 @@
+#ifndef MINIMIZE_SOURCE_H
+#define MINIMIZE_SOURCE_H
+struct header_only_type { int field; };
+/*
+#include "in-comment.h"
+*/
+#endif
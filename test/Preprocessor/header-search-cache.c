@@ -0,0 +1,43 @@
+// REQUIRES: shell
+//
+// Results are not recorded for a directory that was modified recently, so
+// give the include directories an old modification time.
+// RUN: rm -rf %t && mkdir -p %t/a %t/b
+// RUN: echo '#define WHICH 2' > %t/b/which.h
+// RUN: touch -t 200001010000 %t/a %t/b
+// RUN: %clang_cc1 -fsyntax-only -header-search-cache %t/lookups -I %t/a -I %t/b -DEXPECT=2 -verify %s
+// RUN: test -f %t/lookups
+// RUN: %clang_cc1 -fsyntax-only -header-search-cache %t/lookups -I %t/a -I %t/b -DEXPECT=2 -verify %s
+//
+// The cached result that skips the first directory is invalidated when the
+// header is added to it.
+// RUN: echo '#define WHICH 1' > %t/a/which.h
+// RUN: %clang_cc1 -fsyntax-only -header-search-cache %t/lookups -I %t/a -I %t/b -DEXPECT=1 -verify %s
+//
+// The cached miss for late.h is invalidated when the header is added.
+// RUN: echo 'int late;' > %t/b/late.h
+// RUN: %clang_cc1 -fsyntax-only -header-search-cache %t/lookups -I %t/a -I %t/b -DEXPECT=1 -DHAVE_LATE -verify %s
+//
+// Results are not shared with a different search path.
+// RUN: %clang_cc1 -fsyntax-only -header-search-cache %t/lookups -I %t/b -I %t/a -DEXPECT=2 -DHAVE_LATE -verify %s
+//
+// A header search cache file that is not valid is replaced.
+// RUN: echo 'garbage' > %t/lookups
+// RUN: %clang_cc1 -fsyntax-only -header-search-cache %t/lookups -I %t/a -I %t/b -DEXPECT=1 -DHAVE_LATE -verify %s
+
+// expected-no-diagnostics
+
+#include <which.h>
+#if WHICH != EXPECT
+#error which.h found in the wrong directory
+#endif
+
+#ifdef HAVE_LATE
+#if !__has_include(<late.h>)
+#error late.h should be found
+#endif
+#else
+#if __has_include(<late.h>)
+#error late.h should not be found
+#endif
+#endif
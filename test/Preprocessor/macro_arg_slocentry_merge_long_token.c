@@ -0,0 +1,9 @@
+// RUN: not %clang_cc1 -fsyntax-only %s 2>&1 | FileCheck %s
+
+// Tokens of a macro argument are merged into one SLocEntry across a token
+// longer than the merge distance; their locations must still be exact.
+
+#define ID(x) x
+
+// CHECK: macro_arg_slocentry_merge_long_token.c:[[@LINE+1]]:95: error: use of undeclared identifier 'undeclared_var'
+const char *p = ID("0123456789012345678901234567890123456789012345678901234567890123456789" + undeclared_var);
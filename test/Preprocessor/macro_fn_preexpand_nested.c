@@ -0,0 +1,20 @@
+// RUN: %clang_cc1 %s -E | FileCheck %s
+
+/* Pre-expansion nested deeper than the expanders and token buffers that the
+   preprocessor keeps for reuse, with arguments longer than those buffers. */
+#define ID(x) x
+#define D4(x) ID(ID(ID(ID(x))))
+#define D16(x) D4(D4(D4(D4(x))))
+#define L8(x) x x x x x x x x
+#define L64(x) L8(L8(x))
+#define L256(x) L64(x) L64(x) L64(x) L64(x)
+#define COUNT(x) D16(L256(x))
+
+// CHECK: deep: [a]
+deep: D16(D16([a]))
+
+// CHECK: long: {{\[b( b){255} c\]$}}
+long: [COUNT(b) c]
+
+// CHECK: again: [a]
+again: D16(D16([a]))
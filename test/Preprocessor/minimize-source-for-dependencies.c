@@ -0,0 +1,35 @@
+// RUN: %clang_cc1 -E -minimize-source-for-dependencies -I %S/Inputs %s | FileCheck %s
+// RUN: %clang_cc1 -E -minimize-source-for-dependencies -I %S/Inputs %s \
+// RUN:   -MT out.o -dependency-file %t.d -o /dev/null
+// RUN: FileCheck -check-prefix=DEPS %s < %t.d
+//
+// Minimized files are shared through the cache.
+// RUN: rm -rf %t
+// RUN: %clang_cc1 -E -minimize-source-for-dependencies -minimized-source-cache %t -I %S/Inputs %s | FileCheck %s
+// RUN: ls %t | count 2
+// RUN: %clang_cc1 -E -minimize-source-for-dependencies -minimized-source-cache %t -I %S/Inputs %s | FileCheck %s
+//
+// Only preprocessing minimizes sources.
+// RUN: %clang_cc1 -fsyntax-only -minimize-source-for-dependencies -I %S/Inputs %s
+
+#include "minimize-source.h"
+#include "minimize-source.h"
+
+#define LIST(X) X(a) X(b)
+#define DECLARE(name) int name;
+LIST(DECLARE)
+
+#if 0
+#include "missing.h"
+#endif
+
+int use(struct header_only_type *p) { return p->field; }
+
+// CHECK-NOT: header_only_type
+// CHECK-NOT: int a;
+// CHECK-NOT: use
+
+// DEPS: out.o:
+// DEPS-NEXT: minimize-source-for-dependencies.c
+// DEPS-NEXT: minimize-source.h
+// DEPS-NOT: in-comment.h
@@ -0,0 +1,29 @@
+// REQUIRES: shell
+//
+// Results are not recorded for a directory that was modified recently, so
+// give the include directory an old modification time.
+// RUN: rm -rf %t && mkdir -p %t/inc
+// RUN: touch -t 200001010000 %t/inc
+// RUN: %clang_cc1 -fsyntax-only -stat-cache %t/stats -I %t/inc -verify %s
+// RUN: test -f %t/stats
+//
+// The cached miss for late.h is invalidated when the header is added,
+// because that changes the modification time of its directory.
+// RUN: echo 'int late;' > %t/inc/late.h
+// RUN: %clang_cc1 -fsyntax-only -stat-cache %t/stats -I %t/inc -DHAVE_LATE -verify %s
+//
+// A stat cache file that is not valid is replaced.
+// RUN: echo 'garbage' > %t/stats
+// RUN: %clang_cc1 -fsyntax-only -stat-cache %t/stats -I %t/inc -DHAVE_LATE -verify %s
+
+// expected-no-diagnostics
+
+#ifdef HAVE_LATE
+#if !__has_include("late.h")
+#error late.h should be found
+#endif
+#else
+#if __has_include("late.h")
+#error late.h should not be found
+#endif
+#endif
@@ -0,0 +1,7 @@
+// RUN: %clang_cc1 %s -verify -fsyntax-only
+
+int a __attribute__((threaded_dispatch)); // expected-warning {{'threaded_dispatch' attribute only applies to functions}}
+
+void t1(void) __attribute__((threaded_dispatch));
+
+void t2(void) __attribute__((threaded_dispatch(1))); // expected-error {{'threaded_dispatch' attribute takes no arguments}}
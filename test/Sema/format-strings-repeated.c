@@ -0,0 +1,28 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -fsyntax-only %s 2>&1 | FileCheck %s
+
+// A format string used by several calls is parsed once.  Each call is still
+// checked against its own arguments, with locations in its own literal.
+
+int printf(const char *restrict, ...);
+int scanf(const char *restrict, ...);
+
+#define LOG(...) printf("%s: %d\n", __VA_ARGS__)
+
+void f(const char *s, int i, long l, int *p) {
+  LOG(s, i);
+  LOG(s, l); // expected-warning{{format specifies type 'int' but the argument has type 'long'}}
+  LOG(i, i); // expected-warning{{format specifies type 'char *' but the argument has type 'int'}}
+
+  printf("%s: %d\n", s, i);
+  // CHECK: format-strings-repeated.c:[[@LINE+1]]:15: warning: more '%' conversions than data arguments
+  printf("%s: %d\n", s); // expected-warning{{more '%' conversions than data arguments}}
+  // CHECK: format-strings-repeated.c:[[@LINE+1]]:19: warning: more '%' conversions than data arguments
+      printf("%s: %d\n", s); // expected-warning{{more '%' conversions than data arguments}}
+
+  printf("%@", 12); // expected-warning{{invalid conversion specifier '@'}}
+  printf("%@", 12); // expected-warning{{invalid conversion specifier '@'}}
+
+  scanf("%d", p);
+  scanf("%d", l); // expected-warning{{format specifies type 'int *' but the argument has type 'long'}}
+}
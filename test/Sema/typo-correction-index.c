@@ -0,0 +1,14 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+
+// Typo correction indexes the identifiers on its first use; the identifiers
+// created after that must still be found.
+
+int counter; // expected-note {{'counter' declared here}}
+int a = countr; // expected-error {{use of undeclared identifier 'countr'; did you mean 'counter'?}}
+
+int maximum_width; // expected-note {{'maximum_width' declared here}}
+int b = maximun_width; // expected-error {{use of undeclared identifier 'maximun_width'; did you mean 'maximum_width'?}}
+
+// Names too different from the typo are not suggested.
+int unrelated_name;
+int c = unrelated_zzzzzzz; // expected-error-re {{use of undeclared identifier 'unrelated_zzzzzzz'{{$}}}}
@@ -0,0 +1,32 @@
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -verify %s
+// RUN: %clang_cc1 -std=c++14 -fsyntax-only -fconstexpr-cache-stats %s 2>&1 | FileCheck %s
+
+// Without reusing the results of previous calls, this would take far more
+// steps than the evaluator allows.
+constexpr int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+static_assert(fib(40) == 102334155, "");
+
+struct Pair { int a, b; };
+constexpr Pair swap(Pair p) { return {p.b, p.a}; }
+static_assert(swap({1, 2}).a == 2, "");
+static_assert(swap({1, 2}).b == 1, "");
+static_assert(swap({3, 2}).a == 2, "");
+
+// A call which is not a constant expression is diagnosed every time.
+constexpr int recip(int n) { return 1 / n; } // expected-note 2{{division by zero}}
+constexpr int a = recip(0); // expected-error {{constant expression}} expected-note {{in call to 'recip(0)'}}
+constexpr int b = recip(0); // expected-error {{constant expression}} expected-note {{in call to 'recip(0)'}}
+
+constexpr int inc(int n) { return n + 1; } // expected-note {{value 2147483648 is outside the range}}
+static_assert(inc(1) == 2, "");
+constexpr int c = inc(__INT_MAX__); // expected-error {{constant expression}} expected-note {{in call to 'inc(2147483647)'}}
+
+// Calls which may modify their arguments are evaluated again.
+constexpr int bump(int &n) { return ++n; }
+constexpr int twice() {
+  int n = 0;
+  return bump(n) + bump(n);
+}
+static_assert(twice() == 3, "");
+
+// CHECK: {{[1-9][0-9]*}}/{{[0-9]+}} constexpr call results reused, {{[1-9][0-9]*}} cached
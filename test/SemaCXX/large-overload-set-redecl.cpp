@@ -0,0 +1,37 @@
+// RUN: %clang_cc1 -fsyntax-only -verify %s
+// expected-no-diagnostics
+
+// Redeclarations must still replace the declarations they redeclare in the
+// lookup table once an overload set is large enough to be indexed.
+
+struct T0 {}; struct T1 {}; struct T2 {}; struct T3 {}; struct T4 {};
+struct T5 {}; struct T6 {}; struct T7 {}; struct T8 {}; struct T9 {};
+struct T10 {}; struct T11 {}; struct T12 {}; struct T13 {}; struct T14 {};
+struct T15 {}; struct T16 {}; struct T17 {}; struct T18 {}; struct T19 {};
+
+namespace N {
+  int f(int);
+  int f(T0); int f(T1); int f(T2); int f(T3); int f(T4);
+  int f(T5); int f(T6); int f(T7); int f(T8); int f(T9);
+  int f(T10); int f(T11); int f(T12); int f(T13); int f(T14);
+  int f(T15); int f(T16); int f(T17); int f(T18); int f(T19);
+
+  // Only the redeclaration has the default argument, so calling f() finds
+  // it only if it replaced the first declaration.
+  int f(int = 0);
+  int f(T7);
+}
+
+int a = N::f();
+int b = N::f(0) + N::f(T7()) + N::f(T19());
+
+struct S {
+  int m(int);
+  int m(T0); int m(T1); int m(T2); int m(T3); int m(T4);
+  int m(T5); int m(T6); int m(T7); int m(T8); int m(T9);
+  int m(T10); int m(T11); int m(T12); int m(T13); int m(T14);
+  int m(T15); int m(T16); int m(T17); int m(T18); int m(T19);
+};
+
+int S::m(int) { return 0; }
+int d = S().m(0) + S().m(T12());
@@ -0,0 +1,39 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++11 %s
+
+// Candidates that share a parameter type share the conversion sequence of
+// the argument; check that each candidate is still ranked and diagnosed on
+// its own.
+
+struct Stream {};
+struct A {};
+struct B {};
+struct C { operator A() const; };
+struct D {
+  explicit D(int);
+};
+
+Stream &operator<<(Stream &, const A &); // expected-note {{candidate function not viable: no known conversion from 'int *' to 'const A' for 2nd argument}}
+Stream &operator<<(Stream &, const B &); // expected-note {{candidate function not viable: no known conversion from 'int *' to 'const B' for 2nd argument}}
+Stream &operator<<(Stream &, int);       // expected-note {{candidate function not viable: no known conversion from 'int *' to 'int' for 2nd argument; dereference the argument with *}}
+Stream &operator<<(Stream &, double);    // expected-note {{candidate function not viable: no known conversion from 'int *' to 'double' for 2nd argument; dereference the argument with *}}
+Stream &operator<<(Stream &, D);         // expected-note {{candidate function not viable: no known conversion from 'int *' to 'D' for 2nd argument}}
+
+void test(Stream &S, A a, B b, C c, int i, int *p) {
+  S << a << b << i << 1.0;
+  S << c; // user-defined conversion to A
+  Stream &R = S << 'x'; // promotion to int is better than conversion to double
+  (void)R;
+  S << 1.0f; // promotion to double
+  S << p;    // expected-error {{invalid operands to binary expression ('Stream' and 'int *')}}
+}
+
+// The same argument is converted to the same parameter type with and
+// without user-defined conversions.
+struct E {
+  E(const E &);
+  E(const C &);
+};
+int f(E, E);
+int f(A, int);
+
+int g(C c, E e) { return f(e, c) + f(c, 0); }
@@ -0,0 +1,39 @@
+// RUN: %clang_cc1 -fsyntax-only -verify -std=c++11 %s
+
+// Check that repeated typename-specifiers within one instantiation resolve to
+// the same types, and are diagnosed at each use when they are ill-formed.
+
+template<typename T> struct Traits {
+  typedef T value_type;
+  typedef T *pointer;
+};
+
+template<typename T, typename U> struct IsSame {
+  static const bool value = false;
+};
+template<typename T> struct IsSame<T, T> { static const bool value = true; };
+
+template<typename T> int f(T t) {
+  typename Traits<T>::value_type a = t;
+  typename Traits<T>::value_type b = a;
+  typename Traits<T>::pointer p = &a;
+  static_assert(IsSame<decltype(a), T>::value, "");
+  static_assert(IsSame<decltype(b), T>::value, "");
+  static_assert(IsSame<decltype(p), T *>::value, "");
+  typename Traits<T>::missing m1; // expected-error {{no type named 'missing' in 'Traits<int>'}}
+  typename Traits<T>::missing m2; // expected-error {{no type named 'missing' in 'Traits<int>'}}
+  return *p + b;
+}
+
+int i = f(0); // expected-note 2 {{in instantiation of function template specialization 'f<int>' requested here}}
+
+// The instantiated nested-name-specifier, not the dependent one, determines
+// the type.
+template<typename T, typename U> void g() {
+  typename Traits<T>::value_type t;
+  typename Traits<U>::value_type u;
+  static_assert(IsSame<decltype(t), T>::value, "");
+  static_assert(IsSame<decltype(u), U>::value, "");
+}
+
+template void g<int, float>();
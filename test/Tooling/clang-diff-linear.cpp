@@ -0,0 +1,41 @@
+// RUN: %clang_cc1 -E %s > %t.src.cpp
+// RUN: %clang_cc1 -E %s > %t.dst.cpp -DDEST
+// RUN: clang-diff -dump-matches -matching=linear %t.src.cpp %t.dst.cpp -- | FileCheck %s
+// RUN: clang-diff -matching=linear %t.src.cpp %t.dst.cpp -- 2>&1 | FileCheck -check-prefix=LINEAR %s
+// RUN: clang-diff -linear-threshold=0 %t.src.cpp %t.dst.cpp -- 2>&1 | FileCheck -check-prefix=LINEAR %s
+// RUN: clang-diff -matching=gumtree %t.src.cpp %t.dst.cpp -- 2>&1 | FileCheck -check-prefix=GUMTREE %s
+//
+// Test the linear-time matching: identical subtrees are matched by their
+// hashes, and the parents of matched nodes are matched bottom-up.
+
+// LINEAR: Note: Matched {{[0-9]+}} nodes in linear time.
+// GUMTREE-NOT: Note: Matched
+
+#ifndef DEST
+
+void f1() { {{;}} }
+
+void f2() {
+  int a = 1;
+  {{;;}}
+}
+
+#else
+
+// CHECK: Match FunctionDecl: {{.*}}f1{{.*}} to FunctionDecl: {{.*}}f1
+// CHECK-NEXT: Match CompoundStmt
+void f1() { {{;}} }
+
+// The body is matched through the identical block that it contains, and the
+// declaration is then matched optimally.
+// CHECK: Match FunctionDecl: {{.*}}f2{{.*}} to FunctionDecl: {{.*}}f2
+// CHECK-NEXT: Match CompoundStmt
+// CHECK-NEXT: Match DeclStmt
+// CHECK-NEXT: Match VarDecl: {{.*}}a(int){{.*}} to VarDecl: {{.*}}b(int)
+// CHECK-NEXT: Update VarDecl: {{.*}}a(int){{.*}} to {{.*}}b(int)
+void f2() {
+  int b = 1;
+  {{;;}}
+}
+
+#endif
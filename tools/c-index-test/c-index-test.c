@@ -3610,11 +3610,45 @@ static int index_tu(int argc, const char **argv) {
   return result;
 }
 
+static int index_compile_db_in_parallel(CXCompilationDatabase db,
+                                        CXIndexAction idxAction,
+                                        unsigned num_threads,
+                                        const char *check_prefix) {
+  IndexData index_data;
+  int result;
+
+  index_data.check_prefix = check_prefix;
+  index_data.first_check_printed = 0;
+  index_data.fail_for_error = 0;
+  index_data.abort = 0;
+  index_data.main_filename = "";
+  index_data.importedASTs = 0;
+  index_data.strings = NULL;
+  index_data.TU = NULL;
+
+  result = clang_indexCompilationDatabase(idxAction, &index_data,
+                                          &IndexCB, sizeof(IndexCB),
+                                          getIndexOptions(), db,
+                                          getDefaultParsingOptions(),
+                                          num_threads);
+  if (result < 0)
+    describeLibclangFailure(-result);
+  else if (result > 0)
+    fprintf(stderr, "failed to index %d compile commands\n", result);
+
+  if (index_data.fail_for_error)
+    result = -1;
+
+  free_client_data(&index_data);
+  return result;
+}
+
 static int index_compile_db(int argc, const char **argv) {
   const char *check_prefix;
   CXIndex Idx;
   CXIndexAction idxAction;
   int errorCode = 0;
+  int num_threads = -1;
 
   check_prefix = 0;
   if (argc > 0) {
@@ -3624,6 +3658,13 @@ static int index_compile_db(int argc, const char **argv) {
       --argc;
     }
   }
+  if (argc > 0) {
+    if (strstr(argv[0], "-threads=") == argv[0]) {
+      num_threads = atoi(argv[0] + strlen("-threads="));
+      ++argv;
+      --argc;
+    }
+  }
 
   if (argc == 0) {
     fprintf(stderr, "no compilation database\n");
@@ -3673,6 +3714,12 @@ static int index_compile_db(int argc, const char **argv) {
         goto cdb_end;
       }
 
+      if (num_threads >= 0) {
+        errorCode = index_compile_db_in_parallel(db, idxAction, num_threads,
+                                                 check_prefix);
+        goto cdb_end;
+      }
+
       CCmds = clang_CompilationDatabase_getAllCompileCommands(db);
       if (!CCmds) {
         printf("compilation db is empty\n");
@@ -4405,7 +4452,7 @@ static void print_usage(void) {
     "       c-index-test -index-file [-check-prefix=<FileCheck prefix>] <compiler arguments>\n"
     "       c-index-test -index-file-full [-check-prefix=<FileCheck prefix>] <compiler arguments>\n"
     "       c-index-test -index-tu [-check-prefix=<FileCheck prefix>] <AST file>\n"
-    "       c-index-test -index-compile-db [-check-prefix=<FileCheck prefix>] <compilation database>\n"
+    "       c-index-test -index-compile-db [-check-prefix=<FileCheck prefix>] [-threads=<n>] <compilation database>\n"
     "       c-index-test -test-file-scan <AST file> <source file> "
           "[FileCheck prefix]\n");
   fprintf(stderr,
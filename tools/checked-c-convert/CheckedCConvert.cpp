@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 #include "clang/AST/ASTConsumer.h"
 #include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Rewrite/Core/Rewriter.h"
@@ -20,16 +21,22 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <sstream>
+#include <vector>
 
 #include "Constraints.h"
 
 #include "ConstraintBuilder.h"
+#include "ConstraintCache.h"
 #include "PersistentSourceLoc.h"
 #include "ProgramInfo.h"
+#include "Progress.h"
+#include "StringStore.h"
 #include "MappingVisitor.h"
 
 using namespace clang::driver;
@@ -62,6 +69,79 @@ static cl::opt<bool> DumpStats( "dump-stats",
                                 cl::init(false),
                                 cl::cat(ConvertCategory));
 
+static cl::opt<unsigned> NumJobs("j",
+  cl::desc("Number of compilation units to gather constraints from, "
+           "and of rewritten files to write, in parallel"),
+  cl::init(1),
+  cl::cat(ConvertCategory));
+
+static cl::opt<std::string>
+ConstraintCacheFile("constraint-cache",
+  cl::desc("File to keep the constraints of each compilation unit in "
+           "between runs, so that only the compilation units that changed "
+           "are visited again"),
+  cl::init(""),
+  cl::cat(ConvertCategory));
+
+static cl::opt<std::string>
+Shard("shard",
+  cl::desc("Gather the constraints of only the <i>th of every <n> of the "
+           "given files, and write them to the constraint cache instead of "
+           "solving them. A later run with -shard-caches solves and "
+           "rewrites the whole program"),
+  cl::value_desc("i/n"),
+  cl::init(""),
+  cl::cat(ConvertCategory));
+
+static cl::list<std::string>
+ShardCaches("shard-caches",
+  cl::desc("Constraint caches written by runs with -shard, whose "
+           "constraints are used for the files they hold"),
+  cl::CommaSeparated,
+  cl::cat(ConvertCategory));
+
+static cl::opt<bool> KeepASTs("keep-asts",
+  cl::desc("Parse each compilation unit once, and keep its AST in memory "
+           "for rewriting instead of parsing it again. Not used with -j or "
+           "-constraint-cache"),
+  cl::init(false),
+  cl::cat(ConvertCategory));
+
+static cl::opt<std::string>
+SpillMetadata("spill-metadata",
+  cl::desc("Keep the type and name strings of constraint variables in this "
+           "side file instead of in memory, to bound memory use on very "
+           "large programs"),
+  cl::init(""),
+  cl::cat(ConvertCategory));
+
+static cl::opt<bool> TimePhases("time-phases",
+  cl::desc("Print the time taken by each phase of the conversion"),
+  cl::init(false),
+  cl::cat(ConvertCategory));
+
+static cl::opt<unsigned> ProgressInterval("progress",
+  cl::desc("Report the progress of gathering constraints, solving them, and "
+           "rewriting, at most every <seconds> seconds"),
+  cl::value_desc("seconds"),
+  cl::init(0),
+  cl::cat(ConvertCategory));
+
+static cl::opt<std::string>
+TraceFile("trace",
+  cl::desc("Write the phases and compilation units of the conversion to "
+           "this file in the Chrome trace format"),
+  cl::init(""),
+  cl::cat(ConvertCategory));
+
+static cl::opt<std::string>
+ExplainWild("explain-wild",
+  cl::desc("Print the constraints that made the pointers declared at "
+           "<file:line:col> WILD"),
+  cl::value_desc("file:line:col"),
+  cl::init(""),
+  cl::cat(ConvertCategory));
+
 static cl::opt<std::string>
 BaseDir("base-dir",
   cl::desc("Base directory for the code we're translating"),
@@ -389,13 +469,29 @@ canWrite(std::string filePath, std::set<std::string> &iof, std::string b) {
     return false;
 }
 
+// The rewritten files of a run. A file that is included by several
+// compilation units is rewritten with each of them; as when each unit
+// wrote its files out in turn, the text from the last of them is the one
+// that is written.
+struct RewriteOutput {
+  explicit RewriteOutput(std::set<std::string> &F) : InOutFiles(F) {}
+
+  // The files that were given on the command line.
+  std::set<std::string> &InOutFiles;
+  // The rewritten text of each file, by the absolute name of the file to
+  // write it to.
+  std::map<std::string, std::string> Files;
+};
+
+// Record the rewritten text of the files in Files that may be written in
+// Output, or print the rewritten main file if the output is STDOUT.
 void emit(Rewriter &R, ASTContext &C, std::set<FileID> &Files,
-          std::set<std::string> &InOutFiles) {
+          RewriteOutput &Output) {
 
   // Check if we are outputing to stdout or not, if we are, just output the
   // main file ID to stdout.
   if (Verbose)
-    errs() << "Writing files out\n";
+    errs() << "Collecting rewritten files\n";
 
   SmallString<254> baseAbs(BaseDir);
   std::error_code ec = sys::fs::make_absolute(baseAbs);
@@ -425,9 +521,6 @@ void emit(Rewriter &R, ASTContext &C, std::set<FileID> &Files,
           std::string ext = sys::path::extension(fileName).str();
           std::string stem = sys::path::stem(fileName).str();
           std::string nFileName = stem + "." + OutputPostfix + ext;
-          std::string nFile = nFileName;
-          if (dirName.size() > 0)
-            nFile = dirName + sys::path::get_separator().str() + nFileName;
           
           // Write this file out if it was specified as a file on the command
           // line.
@@ -436,28 +529,67 @@ void emit(Rewriter &R, ASTContext &C, std::set<FileID> &Files,
           if (std::error_code ec = sys::fs::make_absolute(feAbs)) {
             if (Verbose)
               errs() << "could not make path absolote\n";
-          } else
+          } else {
             feAbsS = sys::path::remove_leading_dotslash(feAbs.str());
+            // The files are written once every compilation unit has been
+            // rewritten, from another working directory, so name the
+            // output file by its absolute path.
+            dirName = sys::path::parent_path(feAbsS).str();
+          }
 
-          if(canWrite(feAbsS, InOutFiles, base)) {
-            std::error_code EC;
-            raw_fd_ostream out(nFile, EC, sys::fs::F_None);
+          std::string nFile = nFileName;
+          if (dirName.size() > 0)
+            nFile = dirName + sys::path::get_separator().str() + nFileName;
 
-            if (!EC) {
-              if (Verbose)
-                outs() << "writing out " << nFile << "\n";
-              B->write(out);
-            }
-            else
-              errs() << "could not open file " << nFile << "\n";
-            // This is awkward. What to do? Since we're iterating,
-            // we could have created other files successfully. Do we go back
-            // and erase them? Is that surprising? For now, let's just keep
-            // going.
+          if(canWrite(feAbsS, Output.InOutFiles, base)) {
+            std::string &Text = Output.Files[nFile];
+            Text.clear();
+            raw_string_ostream out(Text);
+            B->write(out);
           }
         }
 }
 
+// Write out the rewritten files in Output, NumJobs at a time. The files
+// are distinct, so they can be written in any order; messages are printed
+// in the order of the file names.
+static void writeOutputFiles(RewriteOutput &Output) {
+  if (Verbose)
+    errs() << "Writing files out\n";
+
+  std::vector<const std::pair<const std::string, std::string> *> Files;
+  for (const auto &F : Output.Files)
+    Files.push_back(&F);
+  std::vector<std::error_code> Errors(Files.size());
+
+  auto write = [&Files, &Errors](unsigned i) {
+    raw_fd_ostream out(Files[i]->first, Errors[i], sys::fs::F_None);
+    if (!Errors[i])
+      out << Files[i]->second;
+  };
+
+  if (NumJobs > 1 && Files.size() > 1) {
+    ThreadPool Pool(NumJobs);
+    for (unsigned i = 0; i < Files.size(); i++)
+      Pool.async([&write, i]() { write(i); });
+    Pool.wait();
+  } else {
+    for (unsigned i = 0; i < Files.size(); i++)
+      write(i);
+  }
+
+  for (unsigned i = 0; i < Files.size(); i++) {
+    if (!Errors[i]) {
+      if (Verbose)
+        outs() << "writing out " << Files[i]->first << "\n";
+    } else
+      errs() << "could not open file " << Files[i]->first << "\n";
+    // This is awkward. What to do? We could have created other files
+    // successfully. Do we go back and erase them? Is that surprising? For
+    // now, let's just keep going.
+  }
+}
+
 // Class for visiting declarations during re-writing to find locations to
 // insert casts. Right now, it looks specifically for 'free'. 
 class CastPlacementVisitor : public RecursiveASTVisitor<CastPlacementVisitor> {
@@ -538,7 +670,8 @@ bool CastPlacementVisitor::VisitCallExpr(CallExpr *E) {
 class RewriteConsumer : public ASTConsumer {
 public:
   explicit RewriteConsumer(ProgramInfo &I, 
-    std::set<std::string> &F, ASTContext *Context) : Info(I), InOutFiles(F) {}
+    RewriteOutput &O, ASTContext *Context) : Info(I), Output(O),
+    Start(Progress::Clock::now()) {}
 
   virtual void HandleTranslationUnit(ASTContext &Context) {
     Info.enterCompilationUnit(Context);
@@ -555,17 +688,15 @@ public:
     // Build a map of all of the PersistentSourceLoc's back to some kind of 
     // Stmt, Decl, or Type.
     VariableMap &VarMap = Info.getVarMap();
-    std::set<PersistentSourceLoc> keys;
+    PersistentSourceLocSet keys;
 
     for (const auto &I : VarMap)
       keys.insert(I.first);
-    std::map<PersistentSourceLoc, MappingVisitor::StmtDeclOrType> PSLMap;
+    MappingVisitor::SourceLocMap PSLMap;
     VariableDecltoStmtMap VDLToStmtMap;
 
     MappingVisitor V(keys, Context);
-    TranslationUnitDecl *TUD = Context.getTranslationUnitDecl();
-    for (const auto &D : TUD->decls())
-      V.TraverseDecl(D);
+    V.visitIndex(ASTNodeIndex(Context));
 
     std::tie(PSLMap, VDLToStmtMap) = V.getResults();
 
@@ -629,15 +760,20 @@ public:
     rewrite(R, rewriteThese, Context.getSourceManager(), Context, Files);
 
     // Output files.
-    emit(R, Context, Files, InOutFiles);
+    emit(R, Context, Files, Output);
 
+    SourceManager &SM = Context.getSourceManager();
+    const FileEntry *FE = SM.getFileEntryForID(SM.getMainFileID());
+    Progress::get().unitDone("rewrite", FE != NULL ? FE->getName() : "",
+                             Start, 0);
     Info.exitCompilationUnit();
     return;
   }
 
 private:
   ProgramInfo &Info;
-  std::set<std::string> &InOutFiles;
+  RewriteOutput &Output;
+  Progress::Clock::time_point Start;
 };
 
 template <typename T, typename V>
@@ -687,25 +823,206 @@ newFrontendActionFactoryA(ProgramInfo &I) {
       new ArgFrontendActionFactory(I));
 }
 
-template <typename T>
+template <typename T, typename U>
 std::unique_ptr<FrontendActionFactory>
-newFrontendActionFactoryB(ProgramInfo &I, std::set<std::string> &PS) {
+newFrontendActionFactoryB(ProgramInfo &I, U &PS) {
   class ArgFrontendActionFactory : public FrontendActionFactory {
   public:
     explicit ArgFrontendActionFactory(ProgramInfo &I,
-      std::set<std::string> &PS) : Info(I),Files(PS) {}
+      U &PS) : Info(I),Files(PS) {}
 
     FrontendAction *create() override { return new T(Info, Files); }
 
   private:
     ProgramInfo &Info;
-    std::set<std::string> &Files;
+    U &Files;
   };
 
   return std::unique_ptr<FrontendActionFactory>(
     new ArgFrontendActionFactory(I, PS));
 }
 
+// Gather the constraints of each of the compilation units of Files into a
+// ProgramInfo of its own, and merge them into Info in the order of Files.
+// Compilation units are visited NumJobs at a time. With a constraint cache,
+// the ones that did not change since the last run are read from the cache
+// instead of being visited.
+//
+// ClangTool changes the working directory of the process to the directory
+// of each compile command it runs, which would race between threads. So 
+// all the compile commands must share one directory; the working directory
+// is changed to it once, for the whole of the parallel run. If they don't,
+// the compilation units are visited one after another instead.
+static bool gatherConstraintsPerUnit(const CompilationDatabase &DB,
+                                     const std::vector<std::string> &Files,
+                                     ProgramInfo &Info) {
+  std::vector<std::string> AbsFiles;
+  std::string Directory;
+  bool OneDirectory = true;
+  for (const auto &F : Files) {
+    SmallString<255> AbsPath(F);
+    if (std::error_code ec = sys::fs::make_absolute(AbsPath)) {
+      errs() << "could not make absolute\n";
+      return false;
+    }
+    AbsFiles.push_back(AbsPath.str());
+
+    for (const auto &C : DB.getCompileCommands(AbsPath)) {
+      if (Directory.empty())
+        Directory = C.Directory;
+      else if (Directory != C.Directory)
+        OneDirectory = false;
+    }
+  }
+
+  ConstraintCache Cache;
+  if (!ConstraintCacheFile.empty())
+    Cache.read(ConstraintCacheFile);
+  for (const auto &F : ShardCaches)
+    if (!Cache.add(F)) {
+      errs() << "could not read shard cache " << F << "\n";
+      return false;
+    }
+  bool UseCache = !ConstraintCacheFile.empty() || !ShardCaches.empty();
+
+  std::vector<std::unique_ptr<ProgramInfo>> Locals(AbsFiles.size());
+  std::vector<uint64_t> CommandHashes(AbsFiles.size());
+  std::vector<unsigned> Pending;
+  for (unsigned i = 0; i < AbsFiles.size(); i++) {
+    if (UseCache) {
+      CommandHashes[i] = ConstraintCache::hashCommands(DB, AbsFiles[i]);
+      Locals[i] = Cache.lookup(AbsFiles[i], CommandHashes[i]);
+    }
+    if (!Locals[i]) {
+      Locals[i] = llvm::make_unique<ProgramInfo>();
+      Pending.push_back(i);
+    }
+  }
+
+  if (Verbose && UseCache)
+    outs() << "Read constraints of " << (AbsFiles.size() - Pending.size())
+           << " of " << AbsFiles.size() << " files from the cache\n";
+
+  SmallString<256> InitialDir;
+  if (std::error_code ec = sys::fs::current_path(InitialDir)) {
+    errs() << "could not get current working dir\n";
+    return false;
+  }
+
+  auto visit = [&DB](const std::string &File, ProgramInfo &Local) {
+    ClangTool Tool(DB, File);
+    std::unique_ptr<ToolAction> ConstraintTool = newFrontendActionFactoryA<
+        GenericAction<ConstraintBuilderConsumer, ProgramInfo>>(Local);
+    Tool.run(ConstraintTool.get());
+  };
+
+  if (NumJobs > 1 && Pending.size() > 1 && OneDirectory &&
+      !Directory.empty() && !sys::fs::set_current_path(Directory)) {
+    {
+      ThreadPool Pool(NumJobs);
+      for (const auto &i : Pending) {
+        ProgramInfo *Local = Locals[i].get();
+        const std::string &File = AbsFiles[i];
+        Pool.async([&visit, Local, File]() { visit(File, *Local); });
+      }
+      Pool.wait();
+    }
+
+    if (sys::fs::set_current_path(InitialDir))
+      errs() << "could not restore current working dir\n";
+  } else {
+    if (Verbose && NumJobs > 1 && Pending.size() > 1)
+      outs() << "Compile commands do not share one directory, "
+             << "gathering constraints serially\n";
+    for (const auto &i : Pending)
+      visit(AbsFiles[i], *Locals[i]);
+  }
+
+  // The cache has to be updated before the ProgramInfos are merged, since
+  // merging takes over their ConstraintVariables.
+  if (!ConstraintCacheFile.empty()) {
+    for (const auto &i : Pending)
+      Cache.insert(AbsFiles[i], CommandHashes[i], *Locals[i]);
+    Cache.prune(AbsFiles);
+    if (!Cache.write(ConstraintCacheFile))
+      errs() << "could not write constraint cache " << ConstraintCacheFile
+             << "\n";
+  }
+
+  // A shard only writes its constraints, which are merged by a later run.
+  if (!Shard.empty())
+    return true;
+
+  if (Verbose)
+    outs() << "Merging constraints\n";
+  for (const auto &Local : Locals)
+    Info.merge(*Local);
+
+  return true;
+}
+
+// Parse the value of -shard, I/N, and select the Ith of every N files of
+// Files. Files are kept in their order, so shards are stable across runs.
+static bool selectShard(tooling::CommandLineArguments &Files) {
+  StringRef Index, Count;
+  std::tie(Index, Count) = StringRef(Shard).split('/');
+  unsigned I, N;
+  if (Index.getAsInteger(10, I) || Count.getAsInteger(10, N) || N == 0 ||
+      I >= N) {
+    errs() << "-shard must be i/n with i < n, not " << Shard << "\n";
+    return false;
+  }
+  if (ConstraintCacheFile.empty()) {
+    errs() << "-shard needs a -constraint-cache to write to\n";
+    return false;
+  }
+
+  tooling::CommandLineArguments Selected;
+  for (unsigned i = I; i < Files.size(); i += N)
+    Selected.push_back(Files[i]);
+  Files.swap(Selected);
+  return true;
+}
+
+// Call F on the ASTContext of each of ASTs. The working directory is
+// changed to the directory of the compile command of each AST while F runs,
+// as ClangTool does, so that relative file names mean the same thing as
+// they did when the AST was parsed.
+static void forEachAST(std::vector<std::unique_ptr<ASTUnit>> &ASTs,
+                       const CompilationDatabase &DB,
+                       llvm::function_ref<void (ASTContext &)> F) {
+  SmallString<256> InitialDir;
+  if (std::error_code ec = sys::fs::current_path(InitialDir)) {
+    errs() << "could not get current working dir\n";
+    return;
+  }
+
+  for (const auto &AST : ASTs) {
+    std::vector<CompileCommand> Commands =
+      DB.getCompileCommands(AST->getMainFileName());
+    if (!Commands.empty() && sys::fs::set_current_path(Commands[0].Directory))
+      errs() << "could not change to " << Commands[0].Directory << "\n";
+
+    F(AST->getASTContext());
+
+    if (sys::fs::set_current_path(InitialDir))
+      errs() << "could not restore current working dir\n";
+  }
+}
+
+// Remove the side file of -spill-metadata, print the phase times and write
+// the trace of the run, and return the exit code of the tool.
+static int finishRun(Progress &P) {
+  if (!SpillMetadata.empty())
+    sys::fs::remove(SpillMetadata);
+  P.printPhaseTimes(errs());
+  if (!TraceFile.empty() && !P.writeTrace(TraceFile)) {
+    errs() << "could not write trace " << TraceFile << "\n";
+    return 1;
+  }
+  return 0;
+}
+
 int main(int argc, const char **argv) {
   sys::PrintStackTraceOnErrorSignal(argv[0]);
 
@@ -728,6 +1045,8 @@ int main(int argc, const char **argv) {
   CommonOptionsParser OptionsParser(argc, argv, ConvertCategory);
 
   tooling::CommandLineArguments args = OptionsParser.getSourcePathList();
+  if (!Shard.empty() && !selectShard(args))
+    return 1;
 
   ClangTool Tool(OptionsParser.getCompilations(), args);
   std::set<std::string> inoutPaths;
@@ -740,53 +1059,115 @@ int main(int argc, const char **argv) {
       inoutPaths.insert(abs_path.str());
   }
 
-  if (OutputPostfix == "-" && inoutPaths.size() > 1) {
+  if (OutputPostfix == "-" && inoutPaths.size() > 1 && Shard.empty()) {
     errs() << "If rewriting more than one , can't output to stdout\n";
     return 1;
   }
 
+  if (!SpillMetadata.empty()) {
+    if (!StringStore::get().spillTo(SpillMetadata)) {
+      errs() << "could not create " << SpillMetadata << "\n";
+      return 1;
+    }
+    sys::RemoveFileOnSignal(SpillMetadata);
+  }
+
+  Progress &P = Progress::get();
+  P.setReportInterval(ProgressInterval);
+  P.setTimePhases(TimePhases);
+  P.setTracing(!TraceFile.empty());
+  P.setNumUnits(args.size());
+
   ProgramInfo Info;
+  // With -keep-asts, the ASTs built for gathering constraints, which are 
+  // used again for rewriting.
+  std::vector<std::unique_ptr<ASTUnit>> ASTs;
+  bool UseASTs = false;
 
   // 1. Gather constraints.
-  std::unique_ptr<ToolAction> ConstraintTool = newFrontendActionFactoryA<
-      GenericAction<ConstraintBuilderConsumer, ProgramInfo>>(Info);
-  
-  if (ConstraintTool)
-    Tool.run(ConstraintTool.get());
-  else
-    llvm_unreachable("No action");
+  {
+    Progress::Phase Gather("gather");
+    if (!ConstraintCacheFile.empty() || !ShardCaches.empty() ||
+        (NumJobs > 1 && args.size() > 1)) {
+      if (!gatherConstraintsPerUnit(OptionsParser.getCompilations(), args,
+                                    Info))
+        return 1;
+    } else if (KeepASTs) {
+      UseASTs = true;
+      Tool.buildASTs(ASTs);
+      forEachAST(ASTs, OptionsParser.getCompilations(), [&](ASTContext &C) {
+        ConstraintBuilderConsumer(Info, &C).HandleTranslationUnit(C);
+      });
+    } else {
+      std::unique_ptr<ToolAction> ConstraintTool = newFrontendActionFactoryA<
+          GenericAction<ConstraintBuilderConsumer, ProgramInfo>>(Info);
 
-  if (!Info.link()) {
-    errs() << "Linking failed!\n";
-    return 1;
+      if (ConstraintTool)
+        Tool.run(ConstraintTool.get());
+      else
+        llvm_unreachable("No action");
+    }
+  }
+
+  if (!Shard.empty())
+    return finishRun(P);
+
+  {
+    Progress::Phase Link("link");
+    if (!Info.link()) {
+      errs() << "Linking failed!\n";
+      return 1;
+    }
   }
 
   // 2. Solve constraints.
   if (Verbose)
     outs() << "Solving constraints\n";
   Constraints &CS = Info.getConstraints();
-  std::pair<Constraints::ConstraintSet, bool> R = CS.solve();
-  // TODO: In the future, R.second will be false when there's a conflict, 
-  //       and the tool will need to do something about that. 
-  assert(R.second == true);
+  {
+    Progress::Phase Solve("solve");
+    std::pair<Constraints::ConstraintSet, bool> R = CS.solve();
+    // TODO: In the future, R.second will be false when there's a conflict, 
+    //       and the tool will need to do something about that. 
+    assert(R.second == true);
+  }
+  P.solved(CS.getSolveRounds());
   if (Verbose)
     outs() << "Constraints solved\n";
   if (DumpIntermediate)
     Info.dump();
+  if (!ExplainWild.empty() && !Info.explainWild(ExplainWild, errs()))
+    errs() << "no pointers are declared at " << ExplainWild << "\n";
 
   // 3. Re-write based on constraints.
-  std::unique_ptr<ToolAction> RewriteTool =
-      newFrontendActionFactoryB
-      <GenericAction2<RewriteConsumer, ProgramInfo, std::set<std::string>>>(
-          Info, inoutPaths);
-  
-  if (RewriteTool)
-    Tool.run(RewriteTool.get());
-  else
-    llvm_unreachable("No action");
+  RewriteOutput Output(inoutPaths);
+  {
+    Progress::Phase Rewrite("rewrite");
+    if (UseASTs) {
+      forEachAST(ASTs, OptionsParser.getCompilations(), [&](ASTContext &C) {
+        RewriteConsumer(Info, Output, &C).HandleTranslationUnit(C);
+      });
+    } else {
+      std::unique_ptr<ToolAction> RewriteTool =
+          newFrontendActionFactoryB
+          <GenericAction2<RewriteConsumer, ProgramInfo, RewriteOutput>>(
+              Info, Output);
+
+      if (RewriteTool)
+        Tool.run(RewriteTool.get());
+      else
+        llvm_unreachable("No action");
+    }
+  }
+
+  // 4. Write out the rewritten files.
+  {
+    Progress::Phase Write("write");
+    writeOutputFiles(Output);
+  }
 
   if (DumpStats)
     Info.dump_stats(inoutPaths);
 
-  return 0;
+  return finishRun(P);
 }
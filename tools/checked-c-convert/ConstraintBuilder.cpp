@@ -8,6 +8,7 @@
 // visitors create constraints based on the AST of the program. 
 //===----------------------------------------------------------------------===//
 #include "ConstraintBuilder.h"
+#include "llvm/Support/MD5.h"
 
 using namespace llvm;
 using namespace clang;
@@ -78,11 +79,11 @@ void constrainEq(ConstraintVariable *LHS,
     else if (const PVConstraint *PCLHS = dyn_cast<PVConstraint>(CLHS)) {
       if (const PVConstraint *PCRHS = dyn_cast<PVConstraint>(CRHS)) {
         // Element-wise constrain PCLHS and PCRHS to be equal
-        CVars CLHS = PCLHS->getCvars();
-        CVars CRHS = PCRHS->getCvars();
+        const CVars &CLHS = PCLHS->getCvars();
+        const CVars &CRHS = PCRHS->getCvars();
         if (CLHS.size() == CRHS.size()) {
-          CVars::iterator I = CLHS.begin();
-          CVars::iterator J = CRHS.begin();
+          CVars::const_iterator I = CLHS.begin();
+          CVars::const_iterator J = CRHS.begin();
           while (I != CLHS.end()) {
             CS.addConstraint(
               CS.createEq(CS.getOrCreateVar(*I), CS.getOrCreateVar(*J)));
@@ -543,7 +544,8 @@ public:
     
     if (G->hasGlobalStorage())
       if (G->getType()->isPointerType() || G->getType()->isArrayType())
-        Info.addVariable(G, nullptr, Context);
+        if (!Info.deferVariable(G, Context))
+          Info.addVariable(G, nullptr, Context);
 
     Info.seeGlobalDecl(G);
 
@@ -555,8 +557,10 @@ public:
 
     if (FL.isValid()) {
 
-      Info.addVariable(D, nullptr, Context);
-      Info.seeFunctionDecl(D, Context);
+      if (!Info.deferVariable(D, Context)) {
+        Info.addVariable(D, nullptr, Context);
+        Info.seeFunctionDecl(D, Context);
+      }
 
       if (D->hasBody() && D->isThisDeclarationADefinition()) {
         Stmt *Body = D->getBody();
@@ -605,25 +609,47 @@ private:
 
 void ConstraintBuilderConsumer::HandleTranslationUnit(ASTContext &C) {
   Info.enterCompilationUnit(C);
+  size_t NumConstraints = Info.getConstraints().getNumConstraints();
+  SourceManager &SM = C.getSourceManager();
+  const FileEntry *FE = SM.getFileEntryForID(SM.getMainFileID());
+  StringRef MainFile = FE != NULL ? FE->getName() : StringRef();
   if (Verbose) {
-    SourceManager &SM = C.getSourceManager();
-    FileID mainFileID = SM.getMainFileID();
-    const FileEntry *FE = SM.getFileEntryForID(mainFileID);
     if (FE != NULL)
-      errs() << "Analyzing file " << FE->getName() << "\n";
+      errs() << "Analyzing file " << MainFile << "\n";
     else
       errs() << "Analyzing\n";
   }
   GlobalVisitor GV = GlobalVisitor(&C, Info);
   TranslationUnitDecl *TUD = C.getTranslationUnitDecl();
-  // Generate constraints.
+  // Generate constraints. The declarations of headers that earlier 
+  // compilation units included already have theirs.
+  unsigned Skipped = 0;
   for (const auto &D : TUD->decls()) {
+    if (Info.seenHeaderDecl(D, &C)) {
+      Skipped++;
+      continue;
+    }
     GV.TraverseDecl(D);
   }
 
+  // Remember the files that were read, so that cached constraints can be
+  // checked against them.
+  for (auto I = SM.fileinfo_begin(), E = SM.fileinfo_end(); I != E; ++I) {
+    bool Invalid = false;
+    llvm::MemoryBuffer *Buf = SM.getMemoryBufferForFile(I->first, &Invalid);
+    if (Invalid || Buf == nullptr)
+      continue;
+    SmallString<256> Path(I->first->getName());
+    SM.getFileManager().makeAbsolutePath(Path);
+    Info.seeInputFile(Path, llvm::MD5Hash(Buf->getBuffer()));
+  }
+
   if (Verbose)
-    outs() << "Done analyzing\n";
+    outs() << "Done analyzing, skipped " << Skipped
+           << " declarations of headers seen before\n";
 
+  Progress::get().unitDone("gather", MainFile, Start,
+    Info.getConstraints().getNumConstraints() - NumConstraints);
   Info.exitCompilationUnit();
   return;
 }
@@ -11,6 +11,7 @@
 #include "clang/AST/ASTConsumer.h"
 
 #include "ProgramInfo.h"
+#include "Progress.h"
 
 void constrainEq(std::set<ConstraintVariable*> &RHS,
                  std::set<ConstraintVariable*> &LHS, ProgramInfo &Info);
@@ -20,12 +21,14 @@ void constrainEq( ConstraintVariable *LHS,
 class ConstraintBuilderConsumer : public clang::ASTConsumer {
 public:
   explicit ConstraintBuilderConsumer(ProgramInfo &I, clang::ASTContext *C) :
-    Info(I) { }
+    Info(I), Start(Progress::Clock::now()) { }
 
   virtual void HandleTranslationUnit(clang::ASTContext &);
 
 private:
   ProgramInfo &Info;
+  // When the compilation unit started, for progress reports.
+  Progress::Clock::time_point Start;
 };
 
 #endif
@@ -0,0 +1,585 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Implementation of the on-disk cache of the constraints gathered from each
+// compilation unit.
+//===----------------------------------------------------------------------===//
+#include "ConstraintCache.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <functional>
+
+using namespace clang;
+using namespace llvm;
+using namespace llvm::support;
+
+static const char CacheMagic[] = { 'C', 'C', 'V', 'C' };
+// Bump this when the format changes, so that old caches are ignored.
+static const uint32_t CacheVersion = 2;
+// Stands for a missing ConstraintVariable.
+static const uint32_t NoIndex = ~0u;
+
+enum SerializedConstraintKind {
+  SC_Eq,
+  SC_Not,
+  SC_Implies
+};
+
+static void writeU8(raw_ostream &OS, uint8_t V) {
+  OS << (char)V;
+}
+
+static void writeU32(raw_ostream &OS, uint32_t V) {
+  char B[sizeof(V)];
+  endian::write<uint32_t, little, unaligned>(B, V);
+  OS.write(B, sizeof(B));
+}
+
+static void writeU64(raw_ostream &OS, uint64_t V) {
+  char B[sizeof(V)];
+  endian::write<uint64_t, little, unaligned>(B, V);
+  OS.write(B, sizeof(B));
+}
+
+static void writeString(raw_ostream &OS, StringRef S) {
+  writeU32(OS, S.size());
+  OS << S;
+}
+
+template <typename T>
+static void writeCVars(raw_ostream &OS, const T &S) {
+  writeU32(OS, S.size());
+  for (const auto &K : S)
+    writeU32(OS, K);
+}
+
+namespace {
+// Reads the values written by the functions above. Reading past the end of
+// the data, or a call to fail, puts the Reader in a failed state, after
+// which all reads return zero.
+class Reader {
+public:
+  Reader(StringRef Data) : Ptr(Data.begin()), End(Data.end()),
+    Failed(false) {}
+
+  uint8_t readU8() {
+    if (!take(1))
+      return 0;
+    return (uint8_t)*Ptr++;
+  }
+
+  uint32_t readU32() {
+    if (!take(sizeof(uint32_t)))
+      return 0;
+    uint32_t V = endian::read<uint32_t, little, unaligned>(Ptr);
+    Ptr += sizeof(V);
+    return V;
+  }
+
+  uint64_t readU64() {
+    if (!take(sizeof(uint64_t)))
+      return 0;
+    uint64_t V = endian::read<uint64_t, little, unaligned>(Ptr);
+    Ptr += sizeof(V);
+    return V;
+  }
+
+  StringRef readString() {
+    uint32_t N = readU32();
+    if (!take(N))
+      return StringRef();
+    StringRef S(Ptr, N);
+    Ptr += N;
+    return S;
+  }
+
+  std::set<uint32_t> readCVars() {
+    std::set<uint32_t> S;
+    uint32_t N = readU32();
+    for (uint32_t i = 0; i < N && !Failed; i++)
+      S.insert(readU32());
+    return S;
+  }
+
+  // Read the constraint variables of the levels of a pointer, in order.
+  CVars readLevels() {
+    CVars V;
+    uint32_t N = readU32();
+    for (uint32_t i = 0; i < N && !Failed; i++)
+      V.push_back(readU32());
+    return V;
+  }
+
+  void fail() { Failed = true; }
+  bool failed() const { return Failed; }
+  bool atEnd() const { return Ptr == End; }
+
+private:
+  bool take(size_t N) {
+    if (Failed || (size_t)(End - Ptr) < N)
+      Failed = true;
+    return !Failed;
+  }
+
+  const char *Ptr;
+  const char *End;
+  bool Failed;
+};
+}
+
+static void writeAtom(raw_ostream &OS, Atom *A) {
+  writeU8(OS, A->getKind());
+  if (VarAtom *V = dyn_cast<VarAtom>(A))
+    writeU32(OS, V->getLoc());
+}
+
+static void writeConstraint(raw_ostream &OS, Constraint *C) {
+  if (Eq *E = dyn_cast<Eq>(C)) {
+    writeU8(OS, SC_Eq);
+    writeAtom(OS, E->getLHS());
+    writeAtom(OS, E->getRHS());
+  } else if (Not *N = dyn_cast<Not>(C)) {
+    writeU8(OS, SC_Not);
+    writeConstraint(OS, N->getBody());
+  } else if (Implies *I = dyn_cast<Implies>(C)) {
+    writeU8(OS, SC_Implies);
+    writeConstraint(OS, I->getPremise());
+    writeConstraint(OS, I->getConclusion());
+  } else {
+    llvm_unreachable("unsupported constraint");
+  }
+}
+
+static Atom *readAtom(Reader &R, Constraints &CS, uint32_t FreeKey) {
+  switch (R.readU8()) {
+  case Atom::A_Var: {
+    uint32_t K = R.readU32();
+    if (K >= FreeKey)
+      break;
+    return CS.getOrCreateVar(K);
+  }
+  case Atom::A_Ptr:
+    return CS.getPtr();
+  case Atom::A_Arr:
+    return CS.getArr();
+  case Atom::A_Wild:
+    return CS.getWild();
+  default:
+    break;
+  }
+  R.fail();
+  return nullptr;
+}
+
+// Constraints nest at most two deep, as in Not(Eq) or Implies(Eq, Eq), so
+// anything much deeper is malformed.
+static Constraint *readConstraint(Reader &R, Constraints &CS,
+                                  uint32_t FreeKey, unsigned Depth = 0) {
+  if (Depth > 4) {
+    R.fail();
+    return nullptr;
+  }
+
+  switch (R.readU8()) {
+  case SC_Eq: {
+    Atom *LHS = readAtom(R, CS, FreeKey);
+    Atom *RHS = readAtom(R, CS, FreeKey);
+    if (R.failed())
+      return nullptr;
+    return CS.createEq(LHS, RHS);
+  }
+  case SC_Not: {
+    Constraint *Body = readConstraint(R, CS, FreeKey, Depth + 1);
+    if (R.failed())
+      return nullptr;
+    return CS.createNot(Body);
+  }
+  case SC_Implies: {
+    Constraint *Premise = readConstraint(R, CS, FreeKey, Depth + 1);
+    Constraint *Conclusion = readConstraint(R, CS, FreeKey, Depth + 1);
+    if (R.failed())
+      return nullptr;
+    return CS.createImplies(Premise, Conclusion);
+  }
+  default:
+    break;
+  }
+  R.fail();
+  return nullptr;
+}
+
+void ConstraintCache::serialize(ProgramInfo &Info, raw_ostream &OS) {
+  // Number the ConstraintVariables, including the ones that are only
+  // reachable from others.
+  std::map<ConstraintVariable*, uint32_t> Index;
+  std::vector<ConstraintVariable*> Objects;
+  std::function<void (ConstraintVariable*)> number =
+    [&](ConstraintVariable *C) {
+    if (!Index.insert(std::make_pair(C, Objects.size())).second)
+      return;
+    Objects.push_back(C);
+
+    if (PVConstraint *PV = dyn_cast<PVConstraint>(C)) {
+      if (PV->FV)
+        number(PV->FV);
+    } else if (FVConstraint *FV = dyn_cast<FVConstraint>(C)) {
+      for (const auto &R : FV->returnVars)
+        number(R);
+      for (const auto &P : FV->paramVars)
+        for (const auto &A : P)
+          number(A);
+    }
+  };
+  for (const auto &V : Info.Variables)
+    for (const auto &C : V.second)
+      number(C);
+  for (const auto &S : Info.GlobalSymbols)
+    for (const auto &F : S.second)
+      number(F);
+
+  auto writeObjects = [&](const std::set<ConstraintVariable*> &S) {
+    writeU32(OS, S.size());
+    for (const auto &C : S)
+      writeU32(OS, Index[C]);
+  };
+
+  writeU32(OS, Info.freeKey);
+
+  // The kinds of all of the ConstraintVariables come first, so that they
+  // can be allocated before any references between them are read.
+  writeU32(OS, Objects.size());
+  for (const auto &C : Objects)
+    writeU8(OS, C->getKind());
+
+  for (const auto &C : Objects) {
+    if (PVConstraint *PV = dyn_cast<PVConstraint>(C)) {
+      writeString(OS, PV->BaseType.str());
+      writeString(OS, PV->Name.str());
+      writeCVars(OS, PV->ConstrainedVars);
+      writeCVars(OS, PV->vars);
+      writeU32(OS, PV->FV ? Index[PV->FV] : NoIndex);
+      writeU32(OS, PV->QualMap.size());
+      for (const auto &Q : PV->QualMap) {
+        writeU32(OS, Q.first);
+        writeU8(OS, Q.second);
+      }
+      writeU32(OS, PV->arrSizes.size());
+      for (const auto &A : PV->arrSizes) {
+        writeU32(OS, A.first);
+        writeU8(OS, A.second.first);
+        writeU64(OS, A.second.second);
+      }
+      writeU8(OS, PV->arrPresent);
+    } else {
+      FVConstraint *FV = cast<FVConstraint>(C);
+      writeString(OS, FV->BaseType.str());
+      writeString(OS, FV->Name.str());
+      writeCVars(OS, FV->ConstrainedVars);
+      writeObjects(FV->returnVars);
+      writeU32(OS, FV->paramVars.size());
+      for (const auto &P : FV->paramVars)
+        writeObjects(P);
+      writeString(OS, FV->name.str());
+      writeU8(OS, FV->hasproto);
+      writeU8(OS, FV->hasbody);
+    }
+  }
+
+  writeU32(OS, Info.Variables.size());
+  for (const auto &V : Info.Variables) {
+    const PersistentSourceLoc &PSL = V.first;
+    writeU8(OS, PSL.valid());
+    writeString(OS, PSL.getFileName());
+    writeU32(OS, PSL.getLineNo());
+    writeU32(OS, PSL.getColNo());
+    writeObjects(V.second);
+  }
+
+  Constraints &CS = Info.getConstraints();
+  writeU32(OS, CS.getVariables().size());
+  for (const auto &V : CS.getVariables())
+    writeU32(OS, V.first->getLoc());
+  Constraints::ConstraintSet &Cons = CS.getConstraints();
+  writeU32(OS, Cons.size());
+  for (const auto &C : Cons)
+    writeConstraint(OS, C);
+
+  writeU32(OS, Info.ExternFunctions.size());
+  for (const auto &E : Info.ExternFunctions) {
+    writeString(OS, E.getKey());
+    writeU8(OS, E.second);
+  }
+
+  writeU32(OS, Info.GlobalSymbols.size());
+  for (const auto &S : Info.GlobalSymbols) {
+    writeString(OS, S.getKey());
+    writeU32(OS, S.second.size());
+    for (const auto &F : S.second)
+      writeU32(OS, Index[F]);
+  }
+}
+
+std::unique_ptr<ProgramInfo> ConstraintCache::deserialize(StringRef Data) {
+  Reader R(Data);
+  std::unique_ptr<ProgramInfo> Info = llvm::make_unique<ProgramInfo>();
+  Info->freeKey = R.readU32();
+
+  std::vector<ConstraintVariable*> Objects;
+  uint32_t NumObjects = R.readU32();
+  for (uint32_t i = 0; i < NumObjects && !R.failed(); i++) {
+    switch (R.readU8()) {
+    case ConstraintVariable::PointerVariable:
+      Objects.push_back(new PVConstraint(CVars(), "", "", nullptr, false));
+      break;
+    case ConstraintVariable::FunctionVariable:
+      Objects.push_back(new FVConstraint());
+      break;
+    default:
+      R.fail();
+      break;
+    }
+  }
+
+  auto readObject = [&]() -> ConstraintVariable * {
+    uint32_t I = R.readU32();
+    if (I >= Objects.size()) {
+      R.fail();
+      return nullptr;
+    }
+    return Objects[I];
+  };
+  auto readObjects = [&]() {
+    std::set<ConstraintVariable*> S;
+    uint32_t N = R.readU32();
+    for (uint32_t i = 0; i < N && !R.failed(); i++)
+      S.insert(readObject());
+    return S;
+  };
+  auto readFunction = [&]() -> FVConstraint * {
+    ConstraintVariable *C = readObject();
+    if (C && !isa<FVConstraint>(C))
+      R.fail();
+    return R.failed() ? nullptr : cast<FVConstraint>(C);
+  };
+
+  for (const auto &C : Objects) {
+    if (R.failed())
+      break;
+
+    if (PVConstraint *PV = dyn_cast<PVConstraint>(C)) {
+      PV->BaseType = R.readString();
+      PV->Name = R.readString();
+      PV->ConstrainedVars = R.readCVars();
+      PV->vars = R.readLevels();
+      uint32_t F = R.readU32();
+      if (F != NoIndex) {
+        if (F < Objects.size() && isa<FVConstraint>(Objects[F]))
+          PV->FV = cast<FVConstraint>(Objects[F]);
+        else
+          R.fail();
+      }
+      uint32_t NumQuals = R.readU32();
+      for (uint32_t i = 0; i < NumQuals && !R.failed(); i++) {
+        uint32_t K = R.readU32();
+        if (R.readU8() != PVConstraint::ConstQualification)
+          R.fail();
+        PV->QualMap[K] = PVConstraint::ConstQualification;
+      }
+      uint32_t NumArrs = R.readU32();
+      for (uint32_t i = 0; i < NumArrs && !R.failed(); i++) {
+        uint32_t K = R.readU32();
+        uint8_t Ty = R.readU8();
+        uint64_t Size = R.readU64();
+        if (Ty > PVConstraint::O_UnSizedArray)
+          R.fail();
+        PV->arrSizes[K] =
+          std::make_pair((PVConstraint::OriginalArrType)Ty, Size);
+      }
+      PV->arrPresent = R.readU8();
+    } else {
+      FVConstraint *FV = cast<FVConstraint>(C);
+      FV->BaseType = R.readString();
+      FV->Name = R.readString();
+      FV->ConstrainedVars = R.readCVars();
+      FV->returnVars = readObjects();
+      uint32_t NumParams = R.readU32();
+      for (uint32_t i = 0; i < NumParams && !R.failed(); i++)
+        FV->paramVars.push_back(readObjects());
+      FV->name = R.readString();
+      FV->hasproto = R.readU8();
+      FV->hasbody = R.readU8();
+    }
+  }
+
+  uint32_t NumVariables = R.readU32();
+  for (uint32_t i = 0; i < NumVariables && !R.failed(); i++) {
+    bool Valid = R.readU8();
+    std::string FileName = R.readString();
+    uint32_t Line = R.readU32();
+    uint32_t Col = R.readU32();
+    PersistentSourceLoc PSL = Valid ?
+      PersistentSourceLoc::mkPSL(FileName, Line, Col) : PersistentSourceLoc();
+    Info->Variables[PSL] = readObjects();
+  }
+
+  Constraints &CS = Info->getConstraints();
+  uint32_t NumVars = R.readU32();
+  for (uint32_t i = 0; i < NumVars && !R.failed(); i++) {
+    uint32_t K = R.readU32();
+    if (K < Info->freeKey)
+      CS.getOrCreateVar(K);
+    else
+      R.fail();
+  }
+  uint32_t NumConstraints = R.readU32();
+  for (uint32_t i = 0; i < NumConstraints && !R.failed(); i++)
+    if (Constraint *C = readConstraint(R, CS, Info->freeKey))
+      CS.addConstraint(C);
+
+  uint32_t NumExterns = R.readU32();
+  for (uint32_t i = 0; i < NumExterns && !R.failed(); i++) {
+    std::string Name = R.readString();
+    Info->ExternFunctions[Name] = R.readU8();
+  }
+
+  uint32_t NumSymbols = R.readU32();
+  for (uint32_t i = 0; i < NumSymbols && !R.failed(); i++) {
+    std::set<FVConstraint*> &S = Info->GlobalSymbols[R.readString()];
+    uint32_t N = R.readU32();
+    for (uint32_t j = 0; j < N && !R.failed(); j++)
+      if (FVConstraint *F = readFunction())
+        S.insert(F);
+  }
+
+  if (R.failed() || !R.atEnd()) {
+    for (const auto &C : Objects)
+      delete C;
+    return nullptr;
+  }
+
+  return Info;
+}
+
+uint64_t ConstraintCache::hashCommands(const tooling::CompilationDatabase &DB,
+                                       StringRef SourceFile) {
+  std::string S;
+  for (const auto &C : DB.getCompileCommands(SourceFile)) {
+    S += C.Directory;
+    S += '\0';
+    for (const auto &A : C.CommandLine) {
+      S += A;
+      S += '\0';
+    }
+    S += '\0';
+  }
+  return MD5Hash(S);
+}
+
+void ConstraintCache::read(StringRef File) {
+  Entries.clear();
+  add(File);
+}
+
+bool ConstraintCache::add(StringRef File) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buf = MemoryBuffer::getFile(File);
+  if (!Buf)
+    return false;
+
+  StringRef Data = (*Buf)->getBuffer();
+  if (!Data.startswith(StringRef(CacheMagic, sizeof(CacheMagic))))
+    return false;
+  Reader R(Data.drop_front(sizeof(CacheMagic)));
+  if (R.readU32() != CacheVersion)
+    return false;
+
+  std::map<std::string, Entry> Read;
+  uint32_t NumEntries = R.readU32();
+  for (uint32_t i = 0; i < NumEntries && !R.failed(); i++) {
+    std::string SourceFile = R.readString();
+    Entry &E = Read[SourceFile];
+    E.CommandHash = R.readU64();
+    uint32_t NumInputs = R.readU32();
+    for (uint32_t j = 0; j < NumInputs && !R.failed(); j++) {
+      std::string Name = R.readString();
+      E.InputFiles[Name] = R.readU64();
+    }
+    E.Data = R.readString();
+  }
+
+  if (R.failed() || !R.atEnd())
+    return false;
+
+  for (auto &I : Read)
+    Entries[I.first] = std::move(I.second);
+  return true;
+}
+
+bool ConstraintCache::write(StringRef File) {
+  std::error_code EC;
+  raw_fd_ostream OS(File, EC, sys::fs::F_None);
+  if (EC)
+    return false;
+
+  OS.write(CacheMagic, sizeof(CacheMagic));
+  writeU32(OS, CacheVersion);
+  writeU32(OS, Entries.size());
+  for (const auto &I : Entries) {
+    const Entry &E = I.second;
+    writeString(OS, I.first);
+    writeU64(OS, E.CommandHash);
+    writeU32(OS, E.InputFiles.size());
+    for (const auto &F : E.InputFiles) {
+      writeString(OS, F.first);
+      writeU64(OS, F.second);
+    }
+    writeString(OS, E.Data);
+  }
+
+  OS.close();
+  return !OS.has_error();
+}
+
+std::unique_ptr<ProgramInfo>
+ConstraintCache::lookup(const std::string &SourceFile, uint64_t CommandHash) {
+  auto I = Entries.find(SourceFile);
+  if (I == Entries.end() || I->second.CommandHash != CommandHash)
+    return nullptr;
+
+  for (const auto &F : I->second.InputFiles) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buf =
+      MemoryBuffer::getFile(F.first);
+    if (!Buf || MD5Hash((*Buf)->getBuffer()) != F.second)
+      return nullptr;
+  }
+
+  std::unique_ptr<ProgramInfo> Info = deserialize(I->second.Data);
+  if (Info)
+    Info->InputFiles = I->second.InputFiles;
+  return Info;
+}
+
+void ConstraintCache::insert(const std::string &SourceFile,
+                             uint64_t CommandHash, ProgramInfo &Info) {
+  Entry &E = Entries[SourceFile];
+  E.CommandHash = CommandHash;
+  E.InputFiles = Info.InputFiles;
+  E.Data.clear();
+  raw_string_ostream OS(E.Data);
+  serialize(Info, OS);
+  OS.flush();
+}
+
+void ConstraintCache::prune(const std::vector<std::string> &Files) {
+  std::set<std::string> Keep(Files.begin(), Files.end());
+  for (auto I = Entries.begin(); I != Entries.end(); ) {
+    if (Keep.count(I->first))
+      ++I;
+    else
+      I = Entries.erase(I);
+  }
+}
@@ -0,0 +1,84 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// A cache of the constraints gathered from each compilation unit, kept on
+// disk between runs of checked-c-convert. A compilation unit whose compile
+// command and input files have not changed since its constraints were
+// cached is not visited again; its ProgramInfo is read from the cache and
+// merged with the others, as if it had just been visited.
+//
+// The cache is a single file in a compact binary format:
+//
+//  header:  "CCVC", version
+//  entries: source file, compile command hash,
+//           (input file, content hash)*, serialized ProgramInfo
+//
+// The serialized ProgramInfo holds the ConstraintVariables (shared ones
+// are written once and referred to by index), the variable map keyed by
+// PersistentSourceLoc, the constraint system, and the global symbol
+// tables used when linking.
+//===----------------------------------------------------------------------===//
+#ifndef _CONSTRAINT_CACHE_H
+#define _CONSTRAINT_CACHE_H
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include "ProgramInfo.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class ConstraintCache {
+public:
+  // Read the cache in File. If File doesn't exist or is not a cache, the
+  // cache starts out empty.
+  void read(llvm::StringRef File);
+
+  // Add the entries of the cache in File, such as one written by a shard
+  // of a run, to the ones here. Entries of File replace the ones here for
+  // the same source files. Returns false, and adds nothing, if File can't
+  // be read or is not a cache.
+  bool add(llvm::StringRef File);
+
+  // Write the cache to File. Returns false on failure.
+  bool write(llvm::StringRef File);
+
+  // A hash of the compile commands of SourceFile in DB.
+  static uint64_t hashCommands(const clang::tooling::CompilationDatabase &DB,
+                               llvm::StringRef SourceFile);
+
+  // If the constraints of SourceFile were cached with CommandHash, and none
+  // of the input files of its compilation unit changed since, return a
+  // ProgramInfo holding them. Otherwise return null.
+  std::unique_ptr<ProgramInfo> lookup(const std::string &SourceFile,
+                                      uint64_t CommandHash);
+
+  // Cache the constraints that were gathered from SourceFile into Info,
+  // which must hold only that compilation unit. This has to be done before
+  // Info is merged into another ProgramInfo.
+  void insert(const std::string &SourceFile, uint64_t CommandHash,
+              ProgramInfo &Info);
+
+  // Drop the entries for source files that are not in Files.
+  void prune(const std::vector<std::string> &Files);
+
+  // Serialize Info to OS, or read back a ProgramInfo that was serialized.
+  // deserialize returns null if Data is malformed.
+  static void serialize(ProgramInfo &Info, llvm::raw_ostream &OS);
+  static std::unique_ptr<ProgramInfo> deserialize(llvm::StringRef Data);
+
+private:
+  struct Entry {
+    uint64_t CommandHash;
+    std::map<std::string, uint64_t> InputFiles;
+    std::string Data;
+  };
+
+  std::map<std::string, Entry> Entries;
+};
+
+#endif
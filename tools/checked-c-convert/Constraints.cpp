@@ -9,50 +9,109 @@
 
 #include "Constraints.h"
 #include "llvm/Support/CommandLine.h"
+#include <algorithm>
+#include <atomic>
 #include <set>
 
 using namespace llvm;
 
 static cl::OptionCategory SolverCategory("solver options");
+// Stands for no constraint in the causes of bindings.
+static const uint32_t NoCause = ~0u;
+// The stamp of the last solution of any Constraints.
+static std::atomic<uint32_t> LastStamp(0);
 static cl::opt<bool> DebugSolver("debug-solver",
   cl::desc("Dump intermediate solver state"),
   cl::init(false), cl::cat(SolverCategory));
 
+// Convert _C_ to the solver's form. Returns false if the solver doesn't
+// propagate constraints of its form.
+bool Constraints::toSolverConstraint(Constraint *C, SolverConstraint &SC) {
+  SC.Kind = SolverConstraint::SC_Other;
+  SC.LHSConst = 0;
+  SC.RHSConst = 0;
+  SC.Fired = false;
+  SC.LHS = 0;
+  SC.RHS = 0;
+
+  if (Eq *E = dyn_cast<Eq>(C)) {
+    SC.LHS = AtomHandle::get(E->getLHS()).getVarNum();
+    AtomHandle RHS = AtomHandle::get(E->getRHS());
+    if (RHS.isVar()) {
+      SC.Kind = SolverConstraint::SC_EqVar;
+      SC.RHS = RHS.getVarNum();
+    } else {
+      SC.Kind = SolverConstraint::SC_EqConst;
+      SC.RHSConst = RHS.getKind();
+    }
+    return true;
+  }
+  else if (Not *N = dyn_cast<Not>(C)) {
+    if (Eq *E = dyn_cast<Eq>(N->getBody())) {
+      SC.Kind = SolverConstraint::SC_NotConst;
+      SC.LHS = cast<VarAtom>(E->getLHS())->getLoc();
+      SC.RHSConst = E->getRHS()->getKind();
+      return true;
+    }
+    return false;
+  }
+  else if (Implies *I = dyn_cast<Implies>(C)) {
+    Eq *P = cast<Eq>(I->getPremise());
+    Eq *CO = cast<Eq>(I->getConclusion());
+    SC.Kind = SolverConstraint::SC_Implies;
+    SC.LHS = cast<VarAtom>(P->getLHS())->getLoc();
+    SC.LHSConst = P->getRHS()->getKind();
+    SC.RHS = cast<VarAtom>(CO->getLHS())->getLoc();
+    SC.RHSConst = CO->getRHS()->getKind();
+    return true;
+  }
+  else
+    llvm_unreachable("unsupported constraint");
+}
+
 // Add a constraint to the set of constraints. If the constraint is already 
 // present (by syntactic equality) return false. 
 bool Constraints::addConstraint(Constraint *C) {
   // Validate the constraint to be added.
   assert(check(C));
 
-  // Check if C is already in the set of constraints. 
-  if (constraints.find(C) == constraints.end()) {
-    constraints.insert(C);
-
-    // Update the variables that depend on this constraint
-    if (Eq *E = dyn_cast<Eq>(C)) {
-      if (VarAtom *vLHS = dyn_cast<VarAtom>(E->getLHS()))
-        vLHS->Constraints.insert(C);
-    }
-    else if (Not *N = dyn_cast<Not>(C)) {
-      if (Eq *E = dyn_cast<Eq>(N->getBody())) {
-        if (VarAtom *vLHS = dyn_cast<VarAtom>(E->getLHS()))
-          vLHS->Constraints.insert(C);
+  // Check if C is already in the set of constraints. Constraints that the 
+  // solver propagates are compared by their solver form, and the others 
+  // by the ordering of constraints.
+  SolverConstraint SC;
+  if (toSolverConstraint(C, SC)) {
+    uint64_t Key = (uint64_t(SC.Kind) << 48) | (uint64_t(SC.LHSConst) << 40) |
+                   (uint64_t(SC.RHSConst) << 32) | SC.LHS;
+    if (!constraintKeys.insert(std::make_pair(Key, SC.RHS)).second)
+      return false;
+  } else {
+    for (const auto &O : constraintList)
+      if (*O == *C)
+        return false;
+  }
 
-      }
-    }
-    else if (Implies *I = dyn_cast<Implies>(C)) {
-      if (Eq *E = dyn_cast<Eq>(I->getPremise())) {
-        if (VarAtom *vLHS = dyn_cast<VarAtom>(E->getLHS()))
-          vLHS->Constraints.insert(C);
-      }
-    }
-    else
-      llvm_unreachable("unsupported constraint");
+  uint32_t Index = solverConstraints.size();
+  constraintList.push_back(C);
+  solverConstraints.push_back(SC);
+  constraintsValid = false;
 
-    return true;
+  // Update the variables that depend on this constraint
+  if (SC.Kind != SolverConstraint::SC_Other) {
+    if (SC.LHS >= lhsConstraints.size())
+      lhsConstraints.resize(SC.LHS + 1);
+    lhsConstraints[SC.LHS].push_back(Index);
   }
 
-  return false;
+  return true;
+}
+
+Constraints::ConstraintSet &Constraints::getConstraints() {
+  if (!constraintsValid) {
+    constraints.clear();
+    constraints.insert(constraintList.begin(), constraintList.end());
+    constraintsValid = true;
+  }
+  return constraints;
 }
 
 // Checks to see if the constraint is of a form that we expect.
@@ -93,137 +152,155 @@ bool Constraints::check(Constraint *C) {
   return true;
 }
 
-// Given an equality constraint _Dyn_, and a current variable binding 
-// _CurValLHS_, where _CurValLHS_ represents the pair (q_i:C) and the
-// equality constraint _Dyn_ := q_i == K, pattern match over K. It 
-// could be either a constant value such as WildAtom, or, it could be
-// another variable. 
-//
-// T is constrained to be one of the types from the constant lattice. 
-// T is parametric because the logic for equality propagation is common
-// between different cases of constraint solving. 
-// 
-// Return true if propEq modified the binding of (q_i:C) or the binding
-// of (q_j:K) if _Dyn_ was of the form q_i == q_k.
-template <typename T>
-bool
-Constraints::propEq(EnvironmentMap &env, Eq *Dyn, T *A, ConstraintSet &R,
-  EnvironmentMap::iterator &CurValLHS) {
-  bool changedEnvironment = false;
-
-  if (isa<T>(Dyn->getRHS())) {
-    if (*(CurValLHS->second) < *A) {
-      CurValLHS->second = A;
-      R.insert(Dyn);
-      changedEnvironment = true;
-    }
-  } // Also propagate from equality when v = v'.
-  else if (VarAtom *RHSVar = dyn_cast<VarAtom>(Dyn->getRHS())) {
-    EnvironmentMap::iterator CurValRHS = env.find(RHSVar);
-    assert(CurValRHS != env.end()); // The var on the RHS should be in the env.
-
-    if (*(CurValLHS->second) < *(CurValRHS->second)) {
-      CurValLHS->second = CurValRHS->second;
-      changedEnvironment = true;
-    }
-    else if (*(CurValRHS->second) < *(CurValLHS->second)) {
-      CurValRHS->second = CurValLHS->second;
-      changedEnvironment = true;
-    }
-    else
-      assert(*(CurValRHS->second) == *(CurValLHS->second));
+ConstAtom *Constraints::getConst(uint8_t K) const {
+  switch (K) {
+  case Atom::A_Ptr:
+    return getPtr();
+  case Atom::A_Arr:
+    return getArr();
+  case Atom::A_Wild:
+    return getWild();
+  default:
+    llvm_unreachable("not a constant in the lattice");
   }
+}
 
-  return changedEnvironment;
+// Find the representative of the class of q_Var, halving the paths to it
+// on the way.
+uint32_t Constraints::findClass(uint32_t Var) {
+  while (classOf[Var] != Var) {
+    classOf[Var] = classOf[classOf[Var]];
+    Var = classOf[Var];
+  }
+  return Var;
 }
 
-// Propagates implication through the environment for a single 
-// variable (whose value is given by _V_) used in an implication 
-// constraint _Imp_.
-template <typename T>
-bool
-Constraints::propImp(Implies *Imp, T *A, ConstraintSet &R, ConstAtom *V) {
-  Constraint *Con = NULL;
-  bool changedEnvironment = false;
-
-  if (Eq *DynP = dyn_cast<Eq>(Imp->getPremise())) 
-    if (isa<T>(DynP->getRHS()) && *V == *A) {
-      Con = Imp->getConclusion();
-      R.insert(Imp);
-      addConstraint(Con);
-      changedEnvironment = true;
+// Collapse the variables that are equated by q_i == q_k constraints into
+// classes, and gather the other constraints of each class. A class is
+// bound to the highest binding of its variables. Returns the number of 
+// classes.
+size_t Constraints::buildClasses() {
+  size_t N = std::max(environment.Vars.size(), lhsConstraints.size());
+  lhsConstraints.resize(N);
+  inWorklist.assign(N, false);
+  classOf.resize(N);
+  for (uint32_t V = 0; V < N; V++)
+    classOf[V] = V;
+
+  for (const auto &SC : solverConstraints)
+    if (SC.Kind == SolverConstraint::SC_EqVar) {
+      uint32_t L = findClass(SC.LHS);
+      uint32_t R = findClass(SC.RHS);
+      if (L < R)
+        classOf[R] = L;
+      else if (R < L)
+        classOf[L] = R;
     }
 
-  return changedEnvironment;
+  for (uint32_t V = 0; V < N; V++)
+    classOf[V] = findClass(V);
+
+  classConstraints.assign(N, std::vector<uint32_t>());
+  for (uint32_t I = 0; I < solverConstraints.size(); I++)
+    addClassConstraint(I);
+
+  // The causes of bindings from an earlier solution carry over.
+  classBinding.assign(N, Atom::A_Ptr);
+  classCause.assign(2 * N, NoCause);
+  size_t NumClasses = 0;
+  for (uint32_t V = 0; V < environment.Vars.size(); V++) {
+    if (environment.Vars[V] == nullptr)
+      continue;
+    uint32_t C = classOf[V];
+    if (C == V)
+      NumClasses++;
+    classBinding[C] = joinConsts(Atom::AtomKind(classBinding[C]),
+                                 environment.Vals[V]->getKind());
+    for (uint32_t L = 0; L < 2 && 2 * V + L < raisedBy.size(); L++)
+      if (classCause[2 * C + L] == NoCause)
+        classCause[2 * C + L] = raisedBy[2 * V + L];
+  }
+  return NumClasses;
 }
 
-// Takes one iteration to solve the system of constraints. Each step 
-// involves the propagation of quantifiers and the potential firing of
-// implications. Accepts a single parameter, _env_, that is a map of 
-// variables to their current value in the ConstAtom lattice. 
-//
-// Returns true if the step didn't change any bindings of variables in
-// the environment. 
-bool Constraints::step_solve(EnvironmentMap &env) {
-  bool changedEnvironment = false;
-
-  EnvironmentMap::iterator VI = env.begin();
-  // Step 1. Propagate any WILD constraint as far as we can.
-  while(VI != env.end()) {
-    // Iterate over the environment, VI is a pair of a variable q_i and 
-    // the constant (one of Ptr, Arr, Wild) that the variable is bound to.
-    VarAtom *Var = VI->first;
-    ConstAtom *Val = VI->second;
-    
-    ConstraintSet rmConstraints;
-    for (const auto &C : Var->Constraints) 
-      if (Eq *E = dyn_cast<Eq>(C)) 
-        changedEnvironment |= propEq<WildAtom>(env, E, getWild(), rmConstraints, VI);
-      else if (Implies *Imp = dyn_cast<Implies>(C)) 
-        changedEnvironment |= propImp<WildAtom>(Imp, getWild(), rmConstraints, Val);
-
-    for (const auto &RC : rmConstraints)
-      Var->Constraints.erase(RC);
-
-    ++VI;
+// Add the constraint at Index to the constraints of the class of its LHS.
+// Equalities between variables are already accounted for by the classes.
+void Constraints::addClassConstraint(uint32_t Index) {
+  const SolverConstraint &SC = solverConstraints[Index];
+  if (SC.Kind != SolverConstraint::SC_EqVar &&
+      SC.Kind != SolverConstraint::SC_Other)
+    classConstraints[classOf[SC.LHS]].push_back(Index);
+}
+
+// Add the class _Class_ to the worklist _W_, unless it is already on it.
+void Constraints::enqueue(uint32_t Class, VarWorklist &W) {
+  if (!inWorklist[Class]) {
+    inWorklist[Class] = true;
+    W.push_back(Class);
   }
+}
+
+// Raise the binding of the class _Class_ to the constant _K_ because of
+// the constraint at _Cause_. Its constraints are revisited.
+void Constraints::raise(uint32_t Class, Atom::AtomKind K, uint32_t Cause,
+                        VarWorklist &W) {
+  assert(classBinding[Class] < K);
+  classBinding[Class] = K;
+  classCause[2 * Class + (K == Atom::A_Wild)] = Cause;
+  rounds.back().Raised++;
+  enqueue(Class, W);
+}
 
-  VI = env.begin();
-  // Step 2. Propagate any ARITH constraints.
-  while(VI != env.end()) {
-    VarAtom *Var = VI->first;
-    ConstAtom *Val = VI->second;
-
-    ConstraintSet rmConstraints;
-    for (const auto &C : Var->Constraints) {
-      // Propagate the Neg constraint.
-      if (Not *N = dyn_cast<Not>(C)) {
-        if (Eq *E = dyn_cast<Eq>(N->getBody()))
-          // If this is Not ( q == Ptr ) and the current value 
-          // of q is Ptr ( < *getArr() ) then bump q up to Arr.
-          if (isa<PtrAtom>(E->getRHS()))
-            if (*Val < *getArr()) {
-              VI->second = getArr();
-              changedEnvironment = true;
-            }
+// Propagates the constraints of the class _Class_ through the environment.
+// The constants are ordered by their AtomKinds, in the same order as the 
+// lattice Ptr < Arr < Wild. Each kind of constraint is handled as follows:
+//  - q_i == A for A one of Arr or Wild raises the class of q_i to A.
+//  - NOT(q_i == Ptr) raises the class of q_i to Arr.
+//  - (q_i == A) => (q_k == B) for A one of Arr or Wild adds the conclusion
+//    q_k == B if the class of q_i is bound to A.
+// q_i == q_k holds within each class by construction.
+void Constraints::propagate(uint32_t Class, VarWorklist &W) {
+  assert(environment.Vars[Class] != nullptr);
+
+  // Implications may add constraints to the class, so the list is indexed 
+  // rather than iterated.
+  for (size_t I = 0; I < classConstraints[Class].size(); I++) {
+    uint32_t CI = classConstraints[Class][I];
+    SolverConstraint &SC = solverConstraints[CI];
+    switch (SC.Kind) {
+    case SolverConstraint::SC_EqConst:
+      if ((SC.RHSConst == Atom::A_Arr || SC.RHSConst == Atom::A_Wild) &&
+          classBinding[Class] < SC.RHSConst)
+        raise(Class, Atom::AtomKind(SC.RHSConst), CI, W);
+      break;
+    case SolverConstraint::SC_NotConst:
+      // If this is Not ( q == Ptr ) and the current value 
+      // of q is Ptr ( < *getArr() ) then bump q up to Arr.
+      if (SC.RHSConst == Atom::A_Ptr && classBinding[Class] < Atom::A_Arr)
+        raise(Class, Atom::A_Arr, CI, W);
+      break;
+    case SolverConstraint::SC_Implies:
+      if (!SC.Fired &&
+          (SC.LHSConst == Atom::A_Arr || SC.LHSConst == Atom::A_Wild) &&
+          classBinding[Class] == SC.LHSConst) {
+        SC.Fired = true;
+        Implies *Imp = cast<Implies>(constraintList[CI]);
+        uint32_t ConClass = classOf[SC.RHS];
+        if (addConstraint(Imp->getConclusion())) {
+          firedBy[solverConstraints.size() - 1] = CI;
+          addClassConstraint(solverConstraints.size() - 1);
+        }
+        enqueue(ConClass, W);
       }
-      else if (Eq *E = dyn_cast<Eq>(C)) 
-        changedEnvironment |= propEq<ArrAtom>(env, E, getArr(), rmConstraints, VI);
-      else if (Implies *Imp = dyn_cast<Implies>(C)) 
-        changedEnvironment |= propImp<ArrAtom>(Imp, getArr(), rmConstraints, Val);
+      break;
+    case SolverConstraint::SC_EqVar:
+    case SolverConstraint::SC_Other:
+      break;
     }
-
-    for (const auto &RC : rmConstraints)
-      Var->Constraints.erase(RC);
-
-    ++VI;
   }
-
-  return (changedEnvironment == false);
 }
 
 std::pair<Constraints::ConstraintSet, bool> Constraints::solve(void) {
-  bool fixed = false;
   Constraints::ConstraintSet conflicts;
 
   if (DebugSolver) {
@@ -231,31 +308,98 @@ std::pair<Constraints::ConstraintSet, bool> Constraints::solve(void) {
     dump();
   }
 
-  // It's (probably) possible that a pathologically constructed environment 
-  // could cause us to loop n**2 times. It would be ideal to have an upper 
-  // bound of k*n for k lattice levels and n variables. This will require 
-  // some dependency tracking, we will do that later.
-  while (fixed == false) {
-    
-    if (DebugSolver) {
-      errs() << "constraints pre step\n";
-      dump();
+  // Most constraints equate two variables, so the system is much smaller
+  // once the classes of equal variables are collapsed.
+  size_t NumClasses = buildClasses();
+  if (DebugSolver)
+    errs() << "solving " << NumClasses << " classes of " 
+           << environment.size() << " variables\n";
+
+  // Every class is visited once, and again whenever its binding is raised
+  // or an implication adds to its constraints. Bindings only go up the 
+  // lattice Ptr < Arr < Wild, so each class is visited at most once per 
+  // level and once per implication that fires into it.
+  VarWorklist W;
+  for (uint32_t V = 0; V < environment.Vars.size(); V++)
+    if (environment.Vars[V] != nullptr && classOf[V] == V)
+      enqueue(V, W);
+
+  // A round ends once the classes that were queued when it began have
+  // been visited.
+  rounds.clear();
+  size_t RoundLeft = 0;
+  while (!W.empty()) {
+    if (RoundLeft == 0) {
+      RoundLeft = W.size();
+      rounds.push_back(SolveRound{0, 0});
     }
+    uint32_t Class = W.front();
+    W.pop_front();
+    RoundLeft--;
+    rounds.back().Visited++;
+    inWorklist[Class] = false;
+    propagate(Class, W);
+  }
 
-    fixed = step_solve(environment);
-
-    if (DebugSolver) {
-      errs() << "constraints post step\n";
-      dump();
+  // Give every variable the binding of its class, and its causes.
+  raisedBy.assign(2 * environment.Vars.size(), NoCause);
+  for (uint32_t V = 0; V < environment.Vars.size(); V++)
+    if (environment.Vars[V] != nullptr) {
+      environment.Vals[V] = getConst(classBinding[classOf[V]]);
+      raisedBy[2 * V] = classCause[2 * classOf[V]];
+      raisedBy[2 * V + 1] = classCause[2 * classOf[V] + 1];
     }
+
+  classConstraints.clear();
+  classBinding.clear();
+  classCause.clear();
+  environment.Stamp = ++LastStamp;
+
+  if (DebugSolver) {
+    errs() << "constraints end solve\n";
+    dump();
   }
 
   return std::pair<Constraints::ConstraintSet, bool>(conflicts, true);
 }
 
+std::vector<Constraint*> Constraints::explain(uint32_t V) const {
+  std::vector<Constraint*> Chain;
+  if (2 * V + 1 >= raisedBy.size() || environment.Vars[V] == nullptr)
+    return Chain;
+
+  // Implications only fire once their premise holds, so following them
+  // can't go around in a cycle, and there are no more steps than there 
+  // are constraints.
+  Atom::AtomKind K = environment.Vals[V]->getKind();
+  for (size_t Step = 0; Step <= constraintList.size(); Step++) {
+    if (K != Atom::A_Arr && K != Atom::A_Wild)
+      break;
+    // A variable that jumped straight to Wild was raised past Arr by the 
+    // same constraint.
+    uint32_t Cause = raisedBy[2 * V + (K == Atom::A_Wild)];
+    if (Cause == NoCause && K == Atom::A_Arr)
+      Cause = raisedBy[2 * V + 1];
+    if (Cause == NoCause)
+      break;
+    Chain.push_back(constraintList[Cause]);
+
+    auto I = firedBy.find(Cause);
+    if (I == firedBy.end())
+      break;
+    const SolverConstraint &Imp = solverConstraints[I->second];
+    Chain.push_back(constraintList[I->second]);
+    V = Imp.LHS;
+    K = Atom::AtomKind(Imp.LHSConst);
+    if (2 * V + 1 >= raisedBy.size())
+      break;
+  }
+  return Chain;
+}
+
 void Constraints::print(raw_ostream &O) const {
   O << "CONSTRAINTS: \n";
-  for (const auto &C : constraints) {
+  for (const auto &C : constraintList) {
     C->print(O);
     O << "\n";
   }
@@ -274,24 +418,20 @@ void Constraints::dump(void) const {
 }
 
 VarAtom *Constraints::getOrCreateVar(uint32_t v) {
-  VarAtom tv(v);
-  EnvironmentMap::iterator I = environment.find(&tv);
-
-  if (I != environment.end())
-    return I->first;
-  else {
-    VarAtom *V = new VarAtom(tv);
-    environment[V] = getPtr();
+  if (VarAtom *V = getVar(v))
     return V;
-  }
+
+  VarAtom *V = new VarAtom(v);
+  environment.Stamp = 0;
+  environment[V] = getPtr();
+  environment.Vars[v] = V;
+  environment.NumVars++;
+  return V;
 }
 
 VarAtom *Constraints::getVar(uint32_t v) const {
-  VarAtom tv(v);
-  EnvironmentMap::const_iterator I = environment.find(&tv);
-
-  if (I != environment.end())
-    return I->first;
+  if (v < environment.Vars.size())
+    return environment.Vars[v];
   else
     return nullptr;
 }
@@ -17,10 +17,14 @@
 //===----------------------------------------------------------------------===//
 #ifndef _CONSTRAINTS_H
 #define _CONSTRAINTS_H
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/raw_ostream.h"
+#include <deque>
 #include <set>
 #include <map>
+#include <vector>
 
 class Constraint;
 class Constraints;
@@ -60,7 +64,6 @@ public:
 
 // This refers to a location that we are trying to solve for.
 class VarAtom : public Atom {
-  friend class Constraints;
 public:
   VarAtom(uint32_t D) : Atom(A_Var), Loc(D) {}
 
@@ -100,9 +103,6 @@ public:
 
 private:
   uint32_t  Loc;
-  // The constraint expressions where this variable is mentioned on the 
-  // LHS of an equality.
-  std::set<Constraint*, PComp<Constraint*>> Constraints;
 };
 
 class ConstAtom : public Atom {
@@ -215,6 +215,49 @@ public:
   }
 };
 
+// A compact handle for an atom, which is compared and copied without 
+// going through the Atom classes. A constant is its AtomKind, and a 
+// variable is its number. Variables are numbered below 2^31.
+class AtomHandle {
+public:
+  static AtomHandle getVar(uint32_t V) {
+    assert(V < (1u << 31) && "variable number out of range");
+    return AtomHandle((V << 1) | 1);
+  }
+
+  static AtomHandle getConst(Atom::AtomKind K) {
+    assert(K != Atom::A_Var && K != Atom::A_Const && "not a constant");
+    return AtomHandle(uint32_t(K) << 1);
+  }
+
+  static AtomHandle get(const Atom *A) {
+    if (const VarAtom *V = llvm::dyn_cast<VarAtom>(A))
+      return getVar(V->getLoc());
+    return getConst(A->getKind());
+  }
+
+  bool isVar() const { return Bits & 1; }
+  uint32_t getVarNum() const { assert(isVar()); return Bits >> 1; }
+  Atom::AtomKind getKind() const {
+    return isVar() ? Atom::A_Var : Atom::AtomKind(Bits >> 1);
+  }
+
+  bool operator==(AtomHandle O) const { return Bits == O.Bits; }
+  bool operator!=(AtomHandle O) const { return Bits != O.Bits; }
+
+private:
+  explicit AtomHandle(uint32_t B) : Bits(B) {}
+  uint32_t Bits;
+};
+
+// The join of two constants in the lattice Ptr < Arr < Wild, whose order 
+// is that of their AtomKinds.
+inline Atom::AtomKind joinConsts(Atom::AtomKind A, Atom::AtomKind B) {
+  assert(A >= Atom::A_Ptr && A <= Atom::A_Wild &&
+         B >= Atom::A_Ptr && B <= Atom::A_Wild && "not a constant");
+  return A < B ? B : A;
+}
+
 // Represents constraints of the form:
 //  - a = b
 //  - not a
@@ -412,14 +455,94 @@ public:
   ~Constraints();
 
   typedef std::set<Constraint*, PComp<Constraint*> > ConstraintSet;
-  // The environment maps from Vars to Consts (one of Ptr, Arr, Wild).
-  typedef std::map<VarAtom*, ConstAtom*, PComp<VarAtom*> > EnvironmentMap;
+
+  // The environment maps from Vars to Consts (one of Ptr, Arr, Wild). 
+  // Variables are numbered densely from 0, so the environment is a vector
+  // indexed by the number of each variable.
+  class EnvironmentMap {
+  public:
+    typedef std::pair<VarAtom*, ConstAtom*> value_type;
+
+    // Iterates over the variables in the environment, in order of their
+    // numbers.
+    class iterator {
+    public:
+      iterator(const EnvironmentMap *M, uint32_t I) : Map(M), Index(I) {
+        settle();
+      }
+
+      const value_type &operator*() const { return Current; }
+      const value_type *operator->() const { return &Current; }
+
+      iterator &operator++() {
+        ++Index;
+        settle();
+        return *this;
+      }
+
+      bool operator==(const iterator &other) const {
+        return Index == other.Index;
+      }
+
+      bool operator!=(const iterator &other) const {
+        return Index != other.Index;
+      }
+
+    private:
+      const EnvironmentMap *Map;
+      uint32_t Index;
+      value_type Current;
+
+      // Skip the numbers that aren't variables.
+      void settle() {
+        while (Index < Map->Vars.size() && Map->Vars[Index] == nullptr)
+          ++Index;
+        if (Index < Map->Vars.size())
+          Current = value_type(Map->Vars[Index], Map->Vals[Index]);
+      }
+    };
+    typedef iterator const_iterator;
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, Vars.size()); }
+
+    iterator find(const VarAtom *V) const {
+      uint32_t L = V->getLoc();
+      if (L < Vars.size() && Vars[L] != nullptr)
+        return iterator(this, L);
+      return end();
+    }
+
+    ConstAtom *&operator[](const VarAtom *V) {
+      uint32_t L = V->getLoc();
+      if (L >= Vals.size()) {
+        Vars.resize(L + 1, nullptr);
+        Vals.resize(L + 1, nullptr);
+      }
+      return Vals[L];
+    }
+
+    size_t size() const { return NumVars; }
+
+    // Identifies the solution in the environment, or is 0 if a variable
+    // was added since the constraints were last solved. Every solve, of
+    // any Constraints, gets a stamp of its own, so that what is computed
+    // from a solution can be kept for as long as the stamp is the same.
+    uint32_t getStamp() const { return Stamp; }
+
+  private:
+    friend class Constraints;
+    std::vector<VarAtom*> Vars;
+    std::vector<ConstAtom*> Vals;
+    size_t NumVars = 0;
+    uint32_t Stamp = 0;
+  };
 
   bool addConstraint(Constraint *c);
   // It's important to return these by reference. Programs can have 
   // 10-100-100000 constraints and variables, and copying them each time
   // a client wants to examine the environment is untenable.
-  ConstraintSet &getConstraints() { return constraints; }
+  ConstraintSet &getConstraints();
   EnvironmentMap &getVariables() { return environment; }
   // Solve the system of constraints. Return true in the second position if
   // the system is solved. If the system is solved, the first position is 
@@ -427,6 +550,24 @@ public:
   // are returned in the first position.
   // TODO: this functionality is not implemented yet.
   std::pair<ConstraintSet, bool> solve(void);
+
+  // A round of the last solve: the classes that were on the worklist when
+  // the round began were visited, and Raised of them had their bindings
+  // raised.
+  struct SolveRound {
+    uint32_t Visited;
+    uint32_t Raised;
+  };
+  const std::vector<SolveRound> &getSolveRounds() const { return rounds; }
+
+  // Explain the binding of the variable numbered V in the last solution.
+  // The result starts with the constraint that raised V to its binding. 
+  // If that is the conclusion of an implication, the implication and the
+  // constraints that raised its premise follow, and so on. It is empty if
+  // V was not raised. This takes time linear in the length of the result.
+  std::vector<Constraint*> explain(uint32_t V) const;
+  size_t getNumConstraints() const { return constraintList.size(); }
+
   void dump() const;
   void print(llvm::raw_ostream &) const;
 
@@ -441,21 +582,81 @@ public:
   WildAtom *getWild() const;
 
 private:
+  // The solver's form of a constraint. LHS and RHS are the numbers of 
+  // variables and LHSConst and RHSConst are constants, as Atom::AtomKinds:
+  //  - SC_EqConst : q_LHS = RHSConst
+  //  - SC_EqVar : q_LHS = q_RHS
+  //  - SC_NotConst : NOT(q_LHS = RHSConst)
+  //  - SC_Implies : (q_LHS = LHSConst) => (q_RHS = RHSConst)
+  //  - SC_Other : a constraint that the solver doesn't propagate.
+  struct SolverConstraint {
+    enum SolverKind : uint8_t {
+      SC_EqConst,
+      SC_EqVar,
+      SC_NotConst,
+      SC_Implies,
+      SC_Other
+    };
+
+    SolverKind Kind;
+    uint8_t LHSConst;
+    uint8_t RHSConst;
+    // Whether an implication has added its conclusion.
+    bool Fired;
+    uint32_t LHS;
+    uint32_t RHS;
+  };
+
+  // The classes of variables that the solver has yet to visit.
+  typedef std::deque<uint32_t> VarWorklist;
+
+  // The constraints in the order they were added, both as they were given
+  // and in the solver's form. The first is only needed to print and to 
+  // return the constraints.
+  std::vector<Constraint*> constraintList;
+  std::vector<SolverConstraint> solverConstraints;
+  // The keys of the constraints, which are used to reject duplicates.
+  llvm::DenseSet<std::pair<uint64_t, uint32_t>> constraintKeys;
+  // For each variable, the constraints where it is mentioned on the LHS.
+  std::vector<std::vector<uint32_t>> lhsConstraints;
+  // While solving, the variables that are equated by q_i == q_k 
+  // constraints form classes, which are solved as single variables. Each
+  // class is represented by its lowest numbered variable. classOf maps a
+  // variable to its representative, and classConstraints maps a 
+  // representative to the constraints of its class, other than the 
+  // equalities within it.
+  std::vector<uint32_t> classOf;
+  std::vector<std::vector<uint32_t>> classConstraints;
+  // While solving, the binding of each class, as the AtomKind of a 
+  // constant. The environment is only updated once the solver is done.
+  std::vector<uint8_t> classBinding;
+  // Whether each class is on the solver's worklist.
+  std::vector<bool> inWorklist;
+  // The rounds of the last solve.
+  std::vector<SolveRound> rounds;
+  // The index of the constraint that raised each variable to Arr, at 
+  // 2 * V, and to Wild, at 2 * V + 1, in the last solution, or NoCause.
+  // While solving, classCause holds the same for each class.
+  std::vector<uint32_t> raisedBy;
+  std::vector<uint32_t> classCause;
+  // The implication that added each conclusion that was new when it fired.
+  llvm::DenseMap<uint32_t, uint32_t> firedBy;
+  // The constraints as a set, which is built when it is asked for.
   ConstraintSet constraints;
+  bool constraintsValid = true;
   EnvironmentMap environment;
 
-  bool step_solve(EnvironmentMap &);
+  bool toSolverConstraint(Constraint *C, SolverConstraint &SC);
+  uint32_t findClass(uint32_t Var);
+  size_t buildClasses();
+  void addClassConstraint(uint32_t Index);
+  void propagate(uint32_t Class, VarWorklist &W);
+  void raise(uint32_t Class, Atom::AtomKind K, uint32_t Cause,
+             VarWorklist &W);
+  void enqueue(uint32_t Class, VarWorklist &W);
+  ConstAtom *getConst(uint8_t K) const;
   bool check(Constraint *C);
 
-  template <typename T>
-  bool
-  propEq(EnvironmentMap &env, Eq *Dyn, T *A, ConstraintSet &R,
-      EnvironmentMap::iterator &CurValLHS);
-
-  template <typename T>
-  bool
-  propImp(Implies *, T*, ConstraintSet &, ConstAtom *);
-
   // These atoms can be singletons, so we'll store them in the 
   // Constraints class.
   PtrAtom *prebuiltPtr;
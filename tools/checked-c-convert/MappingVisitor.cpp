@@ -4,7 +4,8 @@
 // License. See LICENSE.TXT for details.
 //
 //===----------------------------------------------------------------------===//
-// Implementations of the MappingVisitor functions for VisitStmt and VisitDecl.
+// Implementations of the MappingVisitor functions for VisitDeclStmt, VisitDecl
+// and visitIndex.
 //===----------------------------------------------------------------------===//
 #include "MappingVisitor.h"
 #include "llvm/Support/Path.h"
@@ -20,7 +21,7 @@ bool MappingVisitor::VisitDeclStmt(DeclStmt *S) {
     // of S appears in the set of PersistentSourceLocs we are tasked to 
     // resolve. If it is, then create a mapping mapping the current 
     // PersistentSourceLocation to the Stmt object S.
-    std::set<PersistentSourceLoc>::iterator I = SourceLocs.find(PSL);
+    PersistentSourceLocSet::iterator I = SourceLocs.find(PSL);
     if (I != SourceLocs.end()) {
       Decl *D = NULL;
       Stmt *So = NULL;
@@ -60,7 +61,7 @@ bool MappingVisitor::VisitDecl(Decl *D) {
   PersistentSourceLoc PSL = 
     PersistentSourceLoc::mkPSL(D, Context);
   if (PSL.valid()) {
-    std::set<PersistentSourceLoc>::iterator I = SourceLocs.find(PSL);
+    PersistentSourceLocSet::iterator I = SourceLocs.find(PSL);
     if (I != SourceLocs.end()) {
       Decl *Do = NULL;
       Stmt *S = NULL;
@@ -82,3 +83,10 @@ bool MappingVisitor::VisitDecl(Decl *D) {
 
   return true;
 }
+
+void MappingVisitor::visitIndex(const ASTNodeIndex &Index) {
+  for (Stmt *S : Index.getStmts(Stmt::DeclStmtClass))
+    VisitDeclStmt(cast<DeclStmt>(S));
+  for (Decl *D : Index.getDeclsOf<Decl>())
+    VisitDecl(D);
+}
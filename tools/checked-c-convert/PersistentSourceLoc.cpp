@@ -7,10 +7,47 @@
 // Implementation of the PersistentSourceLoc infrastructure.
 //===----------------------------------------------------------------------===//
 #include "PersistentSourceLoc.h"
+#include "llvm/ADT/StringMap.h"
+#include <mutex>
+#include <vector>
 
 using namespace clang;
 using namespace llvm;
 
+namespace {
+struct FileNameTable {
+  std::mutex Lock;
+  StringMap<uint32_t> Ids;
+  std::vector<std::string> Names;
+
+  FileNameTable() { Names.push_back(""); }
+};
+}
+
+static FileNameTable &getFileNameTable() {
+  static FileNameTable Table;
+  return Table;
+}
+
+uint32_t PersistentSourceLoc::internFileName(StringRef Name) {
+  if (Name.empty())
+    return 0;
+
+  FileNameTable &T = getFileNameTable();
+  std::lock_guard<std::mutex> Guard(T.Lock);
+  auto I = T.Ids.insert(std::make_pair(Name, (uint32_t)T.Names.size()));
+  if (I.second)
+    T.Names.push_back(Name.str());
+  return I.first->second;
+}
+
+std::string PersistentSourceLoc::getInternedFileName(uint32_t Id) {
+  FileNameTable &T = getFileNameTable();
+  std::lock_guard<std::mutex> Guard(T.Lock);
+  assert(Id < T.Names.size());
+  return T.Names[Id];
+}
+
 // Given a Decl, look up the source location for that Decl and create a 
 // PersistentSourceLoc that represents the location of the Decl. 
 // For Function and Parameter Decls, use the Spelling location, while for
@@ -50,9 +87,7 @@ PersistentSourceLoc::mkPSL(SourceLocation SL, ASTContext &Context) {
   FullSourceLoc FESL = Context.getFullLoc(ESL);
   assert(FESL.isValid());
   
-  std::string fn = PL.getFilename();
-
-  PersistentSourceLoc PSL(fn, 
+  PersistentSourceLoc PSL(PL.getFilename(), 
     FESL.getExpansionLineNumber(), FESL.getExpansionColumnNumber());
 
   return PSL;
@@ -22,34 +22,50 @@
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/ErrorHandling.h"
+#include <functional>
 
 class PersistentSourceLoc {
 protected:
-  PersistentSourceLoc(std::string f, uint32_t l, uint32_t c) :
-    fileName(f), lineNo(l), colNo(c), isValid(true) {}
+  PersistentSourceLoc(llvm::StringRef f, uint32_t l, uint32_t c) :
+    fileId(internFileName(f)), lineNo(l), colNo(c), isValid(true) {}
   
 public:
-  PersistentSourceLoc() : fileName(""), lineNo(0), colNo(0), isValid(false) {}
-  std::string getFileName() const { return fileName; }
+  PersistentSourceLoc() : fileId(0), lineNo(0), colNo(0), isValid(false) {}
+  std::string getFileName() const { return getInternedFileName(fileId); }
   uint32_t getLineNo() const { return lineNo; }
   uint32_t getColNo() const { return colNo; }
-  bool valid() { return isValid; }
+  bool valid() const { return isValid; }
 
+  // File names are interned, so locations in the same file are compared
+  // by the index of the file name. The order of files is the order in 
+  // which they were first seen, not the order of their names.
   bool operator<(const PersistentSourceLoc &o) const {
-    if (fileName == o.fileName)
-      if (lineNo == o.lineNo)
-        if (colNo == o.colNo)
-          return false;
-        else
-          return colNo < o.colNo;
-      else
-        return lineNo < o.lineNo;
-    else
-      return fileName < o.fileName;
+    if (fileId != o.fileId)
+      return fileId < o.fileId;
+    if (lineNo != o.lineNo)
+      return lineNo < o.lineNo;
+    return colNo < o.colNo;
   }
 
+  bool operator==(const PersistentSourceLoc &o) const {
+    return fileId == o.fileId && lineNo == o.lineNo && colNo == o.colNo;
+  }
+
+  // The file, line and column packed into 64 bits, as 24, 24 and 16 bits.
+  // Locations beyond those ranges share keys with others, so this is only
+  // suitable as a hash.
+  uint64_t getHashKey() const {
+    return ((uint64_t)fileId << 40) ^ ((uint64_t)lineNo << 16) ^ colNo;
+  }
+
+  struct Hash {
+    size_t operator()(const PersistentSourceLoc &P) const {
+      return std::hash<uint64_t>()(P.getHashKey());
+    }
+  };
+
   void print(llvm::raw_ostream &O) const {
-    O << fileName << ":" << lineNo << ":" << colNo;
+    O << getFileName() << ":" << lineNo << ":" << colNo;
   }
 
   void dump() const { print(llvm::errs()); }
@@ -60,10 +76,24 @@ public:
   static
     PersistentSourceLoc mkPSL(const clang::Stmt *S, clang::ASTContext &Context);
 
+  // Recreate a PersistentSourceLoc from its parts, such as when reading
+  // one back from disk.
+  static
+    PersistentSourceLoc mkPSL(llvm::StringRef FileName, uint32_t LineNo, 
+                              uint32_t ColNo) {
+    return PersistentSourceLoc(FileName, LineNo, ColNo);
+  }
+
 private:
   static
     PersistentSourceLoc mkPSL(clang::SourceLocation SL, clang::ASTContext &Context);
-  std::string fileName;
+
+  // The table of file names. Index 0 is the empty name. The table is 
+  // shared by all threads, and is locked.
+  static uint32_t internFileName(llvm::StringRef Name);
+  static std::string getInternedFileName(uint32_t Id);
+
+  uint32_t fileId;
   uint32_t lineNo;
   uint32_t colNo;
   bool isValid;
@@ -9,7 +9,11 @@
 #include "ProgramInfo.h"
 #include "MappingVisitor.h"
 #include "ConstraintBuilder.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/MD5.h"
+#include <algorithm>
+#include <functional>
 #include <sstream>
 
 using namespace clang;
@@ -29,8 +33,7 @@ PointerVariableConstraint::PointerVariableConstraint(DeclaratorDecl *D,
 
 PointerVariableConstraint::PointerVariableConstraint(const QualType &QT, uint32_t &K,
   DeclaratorDecl *D, std::string N, Constraints &CS, const ASTContext &C) : 
-  ConstraintVariable(ConstraintVariable::PointerVariable, 
-             tyToStr(QT.getTypePtr()),N),FV(nullptr)
+  ConstraintVariable(ConstraintVariable::PointerVariable, "", N),FV(nullptr)
 {
   QualType QTy = QT;
   const Type *Ty = QTy.getTypePtr();
@@ -57,7 +60,7 @@ PointerVariableConstraint::PointerVariableConstraint(const QualType &QT, uint32_
       // If it's an array, then we need both a constraint variable 
       // for each level of the array, and a constraint variable for 
       // values stored in the array. 
-      vars.insert(K);
+      vars.push_back(K);
       CS.getOrCreateVar(K);
 
       // See if there is a constant size to this array type at this position.
@@ -86,7 +89,7 @@ PointerVariableConstraint::PointerVariableConstraint(const QualType &QT, uint32_
       }
     } else {
       // Allocate a new constraint variable for this level of pointer.
-      vars.insert(K);
+      vars.push_back(K);
       VarAtom * V = CS.getOrCreateVar(K);
      
       if (Ty->isCheckedPointerType()) {
@@ -136,16 +139,17 @@ PointerVariableConstraint::PointerVariableConstraint(const QualType &QT, uint32_
     // There is possibly something more elegant to do in the code here.
     FV = new FVConstraint(Ty, K, D, (isTypedef ? "" : N), CS, C);
 
-  BaseType = tyToStr(Ty);
+  std::string BaseTy = tyToStr(Ty);
 
   if (QTy.isConstQualified()) {
-    BaseType = "const " + BaseType;
+    BaseTy = "const " + BaseTy;
   }
+  BaseType = BaseTy;
 
   // TODO: Github issue #61: improve handling of types for
   // variable arguments.
-  if (BaseType == "struct __va_list_tag *" || BaseType == "va_list" || 
-      BaseType == "struct __va_list_tag")
+  if (BaseTy == "struct __va_list_tag *" || BaseTy == "va_list" || 
+      BaseTy == "struct __va_list_tag")
     for (const auto &V : vars)
       CS.addConstraint(CS.createEq(CS.getOrCreateVar(V), CS.getWild()));
 }
@@ -167,8 +171,8 @@ bool PVConstraint::liftedOnCVars(const ConstraintVariable &O,
 
   auto I = getCvars().begin();
   auto J = OC.begin();
-  auto CS = Info.getConstraints();
-  auto env = CS.getVariables();
+  Constraints &CS = Info.getConstraints();
+  Constraints::EnvironmentMap &env = CS.getVariables();
 
   while(I != getCvars().end() && J != OC.end()) {
     // Look up the valuation for I and J. 
@@ -218,7 +222,8 @@ void PointerVariableConstraint::print(raw_ostream &O) const {
 // variables and potentially nested function pointer declaration. Produces a 
 // string that can be replaced in the source code.
 std::string
-PointerVariableConstraint::mkString(Constraints::EnvironmentMap &E) {
+PointerVariableConstraint::render(Constraints::EnvironmentMap &E) {
+  std::string BaseTy = getTy();
   std::ostringstream ss;
   std::ostringstream pss;
   unsigned caratsToAdd = 0;
@@ -232,7 +237,7 @@ PointerVariableConstraint::mkString(Constraints::EnvironmentMap &E) {
     std::map<uint32_t, Qualification>::iterator q;
     Atom::AtomKind K = C->getKind();
 
-    if (BaseType == "void")
+    if (BaseTy == "void")
       K = Atom::A_Wild;
 
     switch (K) {
@@ -287,12 +292,12 @@ PointerVariableConstraint::mkString(Constraints::EnvironmentMap &E) {
       if (emittedBase) {
         ss << "*";
       } else {
-        assert(BaseType.size() > 0);
+        assert(BaseTy.size() > 0);
         emittedBase = true;
         if (FV) {
           ss << FV->mkString(E);
         } else {
-          ss << BaseType << "*";
+          ss << BaseTy << "*";
         }
       }
 
@@ -314,7 +319,7 @@ PointerVariableConstraint::mkString(Constraints::EnvironmentMap &E) {
     if (FV) {
       ss << FV->mkString(E);
     } else {
-      ss << BaseType;
+      ss << BaseTy;
     }
   }
 
@@ -499,6 +504,104 @@ void FunctionVariableConstraint::constrainTo(Constraints &CS, ConstAtom *A, bool
       U->constrainTo(CS, A, checkSkip);
 }
 
+std::string ConstraintVariable::mkString(Constraints::EnvironmentMap &E) {
+  // A declaration in a header is rewritten with every compilation unit that
+  // includes it, so only make its text once for a solution. Before the 
+  // constraints are solved nothing is kept.
+  uint32_t Stamp = E.getStamp();
+  if (Stamp != 0 && Stamp == RenderedStamp)
+    return Rendered;
+  std::string S = render(E);
+  if (Stamp != 0) {
+    Rendered = S;
+    RenderedStamp = Stamp;
+  }
+  return S;
+}
+
+void ConstraintVariable::renumber(llvm::function_ref<uint32_t (uint32_t)> M,
+  std::set<ConstraintVariable*> &Done) {
+  std::set<uint32_t> N;
+  for (const auto &K : ConstrainedVars)
+    N.insert(M(K));
+  ConstrainedVars = N;
+}
+
+// The ConstraintVariables in S, in the order their constraint variables were
+// allocated.
+static std::vector<ConstraintVariable*>
+inAllocationOrder(const std::set<ConstraintVariable*> &S) {
+  std::vector<std::pair<uint32_t, ConstraintVariable*>> Keyed;
+  for (const auto &C : S) {
+    std::vector<uint32_t> V;
+    C->getAllCvars(V);
+    Keyed.push_back(std::make_pair(V.empty() ? UINT32_MAX : V.front(), C));
+  }
+  std::stable_sort(Keyed.begin(), Keyed.end(),
+    [](const std::pair<uint32_t, ConstraintVariable*> &A,
+       const std::pair<uint32_t, ConstraintVariable*> &B) {
+      return A.first < B.first;
+    });
+  std::vector<ConstraintVariable*> R;
+  for (const auto &K : Keyed)
+    R.push_back(K.second);
+  return R;
+}
+
+void FunctionVariableConstraint::getAllCvars(std::vector<uint32_t> &V) const {
+  for (const auto &C : inAllocationOrder(returnVars))
+    C->getAllCvars(V);
+
+  for (const auto &P : paramVars)
+    for (const auto &C : inAllocationOrder(P))
+      C->getAllCvars(V);
+}
+
+void FunctionVariableConstraint::renumber(
+  llvm::function_ref<uint32_t (uint32_t)> M,
+  std::set<ConstraintVariable*> &Done) {
+  if (!Done.insert(this).second)
+    return;
+  ConstraintVariable::renumber(M, Done);
+
+  for (const auto &C : returnVars)
+    C->renumber(M, Done);
+
+  for (const auto &P : paramVars)
+    for (const auto &C : P)
+      C->renumber(M, Done);
+}
+
+void PointerVariableConstraint::getAllCvars(std::vector<uint32_t> &V) const {
+  V.insert(V.end(), vars.begin(), vars.end());
+  if (FV)
+    FV->getAllCvars(V);
+}
+
+void PointerVariableConstraint::renumber(
+  llvm::function_ref<uint32_t (uint32_t)> M,
+  std::set<ConstraintVariable*> &Done) {
+  if (!Done.insert(this).second)
+    return;
+  ConstraintVariable::renumber(M, Done);
+
+  for (auto &K : vars)
+    K = M(K);
+
+  std::map<uint32_t, Qualification> NewQualMap;
+  for (const auto &Q : QualMap)
+    NewQualMap[M(Q.first)] = Q.second;
+  QualMap = NewQualMap;
+
+  std::map<uint32_t, std::pair<OriginalArrType, uint64_t>> NewArrSizes;
+  for (const auto &A : arrSizes)
+    NewArrSizes[M(A.first)] = A.second;
+  arrSizes = NewArrSizes;
+
+  if (FV)
+    FV->renumber(M, Done);
+}
+
 bool FunctionVariableConstraint::anyChanges(Constraints::EnvironmentMap &E) {
   bool f = false;
 
@@ -548,7 +651,7 @@ void FunctionVariableConstraint::print(raw_ostream &O) const {
   for (const auto &I : returnVars)
    I->print(O); 
   O << " )";
-  O << " " << name << " ";
+  O << " " << name.str() << " ";
   for (const auto &I : paramVars) {
     O << "( ";
     for (const auto &J : I)
@@ -558,7 +661,7 @@ void FunctionVariableConstraint::print(raw_ostream &O) const {
 }
 
 std::string
-FunctionVariableConstraint::mkString(Constraints::EnvironmentMap &E) {
+FunctionVariableConstraint::render(Constraints::EnvironmentMap &E) {
   std::string s = "";
   // TODO punting on what to do here. The right thing to do is to figure out
   // the LUB of all of the V in returnVars.
@@ -617,8 +720,8 @@ void ProgramInfo::print(raw_ostream &O) const {
 // a function, then recurses on the return and parameter
 // constraints.
 static
-CVars getVarsFromConstraint(ConstraintVariable *V, CVars T) {
-  CVars R = T;
+std::set<uint32_t> getVarsFromConstraint(ConstraintVariable *V, std::set<uint32_t> T) {
+  std::set<uint32_t> R = T;
 
   if (PVConstraint *PVC = dyn_cast<PVConstraint>(V)) {
     R.insert(PVC->getCvars().begin(), PVC->getCvars().end());
@@ -626,12 +729,12 @@ CVars getVarsFromConstraint(ConstraintVariable *V, CVars T) {
      return getVarsFromConstraint(FVC, R);
   } else if (FVConstraint *FVC = dyn_cast<FVConstraint>(V)) {
     for (const auto &C : FVC->getReturnVars()) {
-      CVars tmp = getVarsFromConstraint(C, R);
+      std::set<uint32_t> tmp = getVarsFromConstraint(C, R);
       R.insert(tmp.begin(), tmp.end());
     }
     for (unsigned i = 0; i < FVC->numParams(); i++) {
       for (const auto &C : FVC->getParamVar(i)) {
-        CVars tmp = getVarsFromConstraint(C, R);
+        std::set<uint32_t> tmp = getVarsFromConstraint(C, R);
         R.insert(tmp.begin(), tmp.end());
       }
     }
@@ -658,9 +761,9 @@ void ProgramInfo::print_stats(std::set<std::string> &F, raw_ostream &O) {
       if (J != filesToVars.end())
         std::tie(varC, pC, aC, wC) = J->second;
 
-      CVars foundVars;
+      std::set<uint32_t> foundVars;
       for (auto &C : I.second) {
-        CVars tmp = getVarsFromConstraint(C, foundVars);
+        std::set<uint32_t> tmp = getVarsFromConstraint(C, foundVars);
         foundVars.insert(tmp.begin(), tmp.end());
         }
 
@@ -729,6 +832,83 @@ bool ProgramInfo::checkStructuralEquality(QualType D, QualType S) {
   return false;
 }
 
+// Add the variables that C mentions to Vars.
+static void getConstraintVars(Constraint *C, std::vector<uint32_t> &Vars) {
+  if (Eq *E = dyn_cast<Eq>(C)) {
+    if (VarAtom *V = dyn_cast<VarAtom>(E->getLHS()))
+      Vars.push_back(V->getLoc());
+    if (VarAtom *V = dyn_cast<VarAtom>(E->getRHS()))
+      Vars.push_back(V->getLoc());
+  } else if (Not *N = dyn_cast<Not>(C)) {
+    getConstraintVars(N->getBody(), Vars);
+  } else if (Implies *I = dyn_cast<Implies>(C)) {
+    getConstraintVars(I->getPremise(), Vars);
+    getConstraintVars(I->getConclusion(), Vars);
+  }
+}
+
+bool ProgramInfo::explainWild(StringRef Loc, raw_ostream &O) {
+  StringRef Rest, LineStr, ColStr, File;
+  std::tie(Rest, ColStr) = Loc.rsplit(':');
+  std::tie(File, LineStr) = Rest.rsplit(':');
+  uint32_t Line, Col;
+  if (File.empty() || LineStr.getAsInteger(10, Line) ||
+      ColStr.getAsInteger(10, Col))
+    return false;
+
+  // Where each constraint variable was declared, to show the constraints
+  // in terms of the program. 
+  std::map<uint32_t, const PersistentSourceLoc *> Where;
+  std::vector<ConstraintVariable*> Found;
+  for (const auto &V : Variables) {
+    const PersistentSourceLoc &PSL = V.first;
+    std::string Name = PSL.getFileName();
+    bool Here = PSL.getLineNo() == Line && PSL.getColNo() == Col &&
+      (Name == File || StringRef(Name).endswith(("/" + File).str()));
+    for (const auto &CV : V.second) {
+      std::vector<uint32_t> Ks;
+      CV->getAllCvars(Ks);
+      for (const auto &K : Ks)
+        Where.insert(std::make_pair(K, &PSL));
+      if (Here)
+        Found.push_back(CV);
+    }
+  }
+  if (Found.empty())
+    return false;
+
+  Constraints::EnvironmentMap &Env = CS.getVariables();
+  bool AnyWild = false;
+  for (const auto &CV : Found) {
+    std::vector<uint32_t> Ks;
+    CV->getAllCvars(Ks);
+    for (const auto &K : Ks) {
+      if (Env[CS.getVar(K)]->getKind() != Atom::A_Wild)
+        continue;
+      AnyWild = true;
+      O << "q_" << K << " of " << CV->getName() << " at " << Loc 
+        << " is WILD because of:\n";
+      for (const auto &C : CS.explain(K)) {
+        O << "  ";
+        C->print(O);
+        std::vector<uint32_t> Vars;
+        getConstraintVars(C, Vars);
+        for (const auto &V : Vars) {
+          auto I = Where.find(V);
+          if (I == Where.end())
+            continue;
+          O << ", q_" << V << " at ";
+          I->second->print(O);
+        }
+        O << "\n";
+      }
+    }
+  }
+  if (!AnyWild)
+    O << "nothing declared at " << Loc << " is WILD\n";
+  return true;
+}
+
 bool ProgramInfo::isExternOkay(std::string ext) {
   return llvm::StringSwitch<bool>(ext)
     .Cases("malloc", "free", true)
@@ -745,61 +925,50 @@ bool ProgramInfo::link() {
   // constrain that everything that is at the same location is explicitly
   // equal.
   for (const auto &V : Variables) {
-    std::set<ConstraintVariable*> C = V.second;
-
+    const std::set<ConstraintVariable*> &C = V.second;
     if (C.size() > 1) {
-      std::set<ConstraintVariable*>::iterator I = C.begin();
-      std::set<ConstraintVariable*>::iterator J = C.begin();
-      ++J;
-
-      while (J != C.end()) {
-        constrainEq(*I, *J, *this);
-        ++I;
-        ++J;
-      }
+      ConstraintVariable *First = *C.begin();
+      for (auto I = std::next(C.begin()); I != C.end(); ++I)
+        constrainEq(First, *I, *this);
     }
   }
 
+  // The declarations of a function that have no body are constrained 
+  // against one of them, preferably one with a prototype, so that a 
+  // function declared in many compilation units adds constraints linear in
+  // the number of its declarations.
   for (const auto &S : GlobalSymbols) {
-    std::string fname = S.first;
-    std::set<FVConstraint*> P = S.second;
-    
-    if (P.size() > 1) {
-      std::set<FVConstraint*>::iterator I = P.begin();
-      std::set<FVConstraint*>::iterator J = P.begin();
-      ++J;
-      
-      while (J != P.end()) {
-        FVConstraint *P1 = *I;
-        FVConstraint *P2 = *J;
-
-        // Constrain the return values to be equal
-        // TODO: make this behavior optional?
-        if (!P1->hasBody() && !P2->hasBody()) {
-          constrainEq(P1->getReturnVars(), P2->getReturnVars(), *this);
-
-          // Constrain the parameters to be equal, if the parameter arity is
-          // the same. If it is not the same, constrain both to be wild.
-          if (P1->numParams() == P2->numParams()) {
-            for ( unsigned i = 0;
-                  i < P1->numParams();
-                  i++)
-            {
-              constrainEq(P1->getParamVar(i), P2->getParamVar(i), *this);
-            } 
-
-          } else {
-            // It could be the case that P1 or P2 is missing a prototype, in
-            // which case we don't need to constrain anything.
-            if (P1->hasProtoType() && P2->hasProtoType()) {
-              // Nope, we have no choice. Constrain everything to wild.
-              P1->constrainTo(CS, CS.getWild(), true);
-              P2->constrainTo(CS, CS.getWild(), true);
-            }
-          }
-        }
-        ++I;
-        ++J;
+    const std::set<FVConstraint*> &P = S.second;
+    if (P.size() < 2)
+      continue;
+
+    FVConstraint *Rep = nullptr;
+    for (const auto &F : P)
+      if (!F->hasBody() &&
+          (!Rep || (F->hasProtoType() && !Rep->hasProtoType())))
+        Rep = F;
+    if (Rep == nullptr)
+      continue;
+
+    for (const auto &F : P) {
+      if (F == Rep || F->hasBody())
+        continue;
+
+      // Constrain the return values to be equal
+      // TODO: make this behavior optional?
+      constrainEq(Rep->getReturnVars(), F->getReturnVars(), *this);
+
+      // Constrain the parameters to be equal, if the parameter arity is
+      // the same. If it is not the same, constrain both to be wild.
+      if (Rep->numParams() == F->numParams()) {
+        for (unsigned i = 0; i < Rep->numParams(); i++)
+          constrainEq(Rep->getParamVar(i), F->getParamVar(i), *this);
+      } else if (Rep->hasProtoType() && F->hasProtoType()) {
+        // It could be the case that one of them is missing a prototype, in
+        // which case we don't need to constrain anything. Otherwise, we 
+        // have no choice. Constrain everything to wild.
+        Rep->constrainTo(CS, CS.getWild(), true);
+        F->constrainTo(CS, CS.getWild(), true);
       }
     }
   }
@@ -809,12 +978,10 @@ bool ProgramInfo::link() {
   for (const auto &U : ExternFunctions) {
     // If we've seen this symbol, but never seen a body for it, constrain
     // everything about it.
-    if (U.second == false && isExternOkay(U.first) == false) {
+    if (U.second == false && isExternOkay(U.getKey()) == false) {
       // Some global symbols we don't need to constrain to wild, like 
       // malloc and free. Check those here and skip if we find them. 
-      std::string UnkSymbol = U.first;
-      std::map<std::string, std::set<FVConstraint*> >::iterator I =
-        GlobalSymbols.find(UnkSymbol);
+      auto I = GlobalSymbols.find(U.getKey());
       assert(I != GlobalSymbols.end());
       const std::set<FVConstraint*> &Gs = (*I).second;
 
@@ -833,6 +1000,125 @@ bool ProgramInfo::link() {
   return true;
 }
 
+void ProgramInfo::merge(ProgramInfo &Local) {
+  assert(persisted == true && Local.persisted == true);
+
+  // Map from the constraint variables of Local to the ones here. Those that
+  // are not identified with one here get the next free keys. The keys of
+  // Local are dense, so the map is a vector, and merging takes time linear
+  // in the size of Local.
+  const uint32_t NoVar = UINT32_MAX;
+  std::vector<uint32_t> VarMap(Local.freeKey, NoVar);
+  auto slot = [&](uint32_t K) -> uint32_t & {
+    if (K >= VarMap.size())
+      VarMap.resize(K + 1, NoVar);
+    return VarMap[K];
+  };
+  auto mapVar = [&](uint32_t K) {
+    uint32_t &N = slot(K);
+    if (N == NoVar)
+      N = freeKey++;
+    return N;
+  };
+
+  // 1. Identify the ConstraintVariables of Local with the ones of the same
+  // kind at the same location here. 
+  llvm::DenseMap<ConstraintVariable*, ConstraintVariable*> Objects;
+  for (const auto &LV : Local.Variables) {
+    auto I = Variables.find(LV.first);
+    if (I == Variables.end())
+      continue;
+
+    for (const auto &L : LV.second) {
+      if (Objects.find(L) != Objects.end())
+        continue;
+
+      ConstraintVariable *G = nullptr;
+      for (const auto &C : I->second)
+        if (C->getKind() == L->getKind()) {
+          G = C;
+          break;
+        }
+      if (G == nullptr)
+        continue;
+
+      std::vector<uint32_t> LVars;
+      std::vector<uint32_t> GVars;
+      L->getAllCvars(LVars);
+      G->getAllCvars(GVars);
+      for (unsigned i = 0; i < LVars.size() && i < GVars.size(); i++) {
+        uint32_t &N = slot(LVars[i]);
+        // If a variable of Local is identified with two variables here, 
+        // those must be equal.
+        if (N == NoVar)
+          N = GVars[i];
+        else if (N != GVars[i])
+          CS.addConstraint(CS.createEq(CS.getOrCreateVar(N),
+                                       CS.getOrCreateVar(GVars[i])));
+      }
+      Objects[L] = G;
+    }
+  }
+
+  // 2. Adopt the other ConstraintVariables of Local, with new numbers.
+  std::set<ConstraintVariable*> Done;
+  for (const auto &LV : Local.Variables)
+    for (const auto &L : LV.second)
+      if (Objects.find(L) == Objects.end()) {
+        L->renumber(mapVar, Done);
+        Objects[L] = L;
+        Variables[LV.first].insert(L);
+      }
+
+  // 3. Add the variables and constraints of Local.
+  Constraints &LCS = Local.getConstraints();
+  for (const auto &V : LCS.getVariables())
+    CS.getOrCreateVar(mapVar(V.first->getLoc()));
+
+  std::function<Atom *(Atom *)> mapAtom = [&](Atom *A) -> Atom * {
+    switch (A->getKind()) {
+    case Atom::A_Var:
+      return CS.getOrCreateVar(mapVar(cast<VarAtom>(A)->getLoc()));
+    case Atom::A_Ptr:
+      return CS.getPtr();
+    case Atom::A_Arr:
+      return CS.getArr();
+    case Atom::A_Wild:
+      return CS.getWild();
+    case Atom::A_Const:
+      llvm_unreachable("bad constant in constraint");
+    }
+    llvm_unreachable("unknown atom");
+  };
+  std::function<Constraint *(Constraint *)> mapConstraint = 
+    [&](Constraint *C) -> Constraint * {
+    if (Eq *E = dyn_cast<Eq>(C))
+      return CS.createEq(mapAtom(E->getLHS()), mapAtom(E->getRHS()));
+    else if (Not *N = dyn_cast<Not>(C))
+      return CS.createNot(mapConstraint(N->getBody()));
+    else if (Implies *I = dyn_cast<Implies>(C))
+      return CS.createImplies(mapConstraint(I->getPremise()),
+                              mapConstraint(I->getConclusion()));
+    llvm_unreachable("unsupported constraint");
+  };
+  for (const auto &C : LCS.getConstraints())
+    CS.addConstraint(mapConstraint(C));
+
+  // 4. Merge the global symbol information used for linking.
+  for (const auto &E : Local.ExternFunctions)
+    if (!ExternFunctions[E.getKey()])
+      ExternFunctions[E.getKey()] = E.second;
+
+  for (const auto &S : Local.GlobalSymbols) {
+    std::set<FVConstraint*> &G = GlobalSymbols[S.getKey()];
+    for (const auto &F : S.second) {
+      auto I = Objects.find(F);
+      assert(I != Objects.end());
+      G.insert(cast<FVConstraint>(I->second));
+    }
+  }
+}
+
 void ProgramInfo::seeFunctionDecl(FunctionDecl *F, ASTContext *C) {
   if (!F->isGlobal())
     return;
@@ -851,15 +1137,7 @@ void ProgramInfo::seeFunctionDecl(FunctionDecl *F, ASTContext *C) {
 
   assert(toAdd.size() > 0);
 
-  std::map<std::string, std::set<FVConstraint*> >::iterator it = 
-    GlobalSymbols.find(fn);
-  
-  if (it == GlobalSymbols.end()) {
-    GlobalSymbols.insert(std::pair<std::string, std::set<FVConstraint*> >
-      (fn, toAdd));
-  } else {
-    (*it).second.insert(toAdd.begin(), toAdd.end());
-  }
+  GlobalSymbols[fn].insert(toAdd.begin(), toAdd.end());
 
   // Look up the constraint variables for the return type and parameter 
   // declarations of this function, if any.
@@ -910,20 +1188,16 @@ void ProgramInfo::seeGlobalDecl(clang::VarDecl *G) {
 void ProgramInfo::enterCompilationUnit(ASTContext &Context) {
   assert(persisted == true);
   // Get a set of all of the PersistentSourceLoc's we need to fill in
-  std::set<PersistentSourceLoc> P;
+  PersistentSourceLocSet P;
   //for (auto I : PersistentVariables)
   //  P.insert(I.first);
 
   // Resolve the PersistentSourceLoc to one of Decl,Stmt,Type.
   MappingVisitor V(P, Context);
-  TranslationUnitDecl *TUD = Context.getTranslationUnitDecl();
-  for (const auto &D : TUD->decls())
-    V.TraverseDecl(D);
-  std::pair<std::map<PersistentSourceLoc, MappingVisitor::StmtDeclOrType>,
-    VariableDecltoStmtMap>
+  V.visitIndex(ASTNodeIndex(Context));
+  std::pair<MappingVisitor::SourceLocMap, VariableDecltoStmtMap>
     res = V.getResults();
-  std::map<PersistentSourceLoc, MappingVisitor::StmtDeclOrType> 
-    PSLtoDecl = res.first;
+  MappingVisitor::SourceLocMap PSLtoDecl = res.first;
 
   // Re-populate VarDeclToStatement.
   VarDeclToStatement = res.second;
@@ -938,6 +1212,9 @@ void ProgramInfo::enterCompilationUnit(ASTContext &Context) {
 void ProgramInfo::exitCompilationUnit() {
   assert(persisted == false);
   VarDeclToStatement.clear();
+  ExprVariables.clear();
+  DeferredDecls.clear();
+  HeaderKeys.clear();
   persisted = true;
   return;
 }
@@ -946,6 +1223,8 @@ void ProgramInfo::exitCompilationUnit() {
 // constraint system for that pointer type.
 bool ProgramInfo::addVariable(DeclaratorDecl *D, DeclStmt *St, ASTContext *C) {
   assert(persisted == false);
+  // The variables of the expressions looked up so far may change.
+  VariableGeneration++;
   PersistentSourceLoc PLoc = 
     PersistentSourceLoc::mkPSL(D, *C);
   assert(PLoc.valid());
@@ -970,36 +1249,36 @@ bool ProgramInfo::addVariable(DeclaratorDecl *D, DeclStmt *St, ASTContext *C) {
   else
     llvm_unreachable("unknown decl type");
   
+  std::set<ConstraintVariable*> &S = Variables[PLoc];
+  bool foundF = false;
+  bool foundP = false;
+  for (const auto &I : S) {
+    if (isa<FVConstraint>(I))
+      foundF = true;
+    else if (isa<PVConstraint>(I))
+      foundP = true;
+  }
+
+  // A declaration that is seen again, as the ones in headers are with every
+  // compilation unit, already has its variables, so no new ones are made.
   FVConstraint *F = nullptr;
   PVConstraint *P = nullptr;
   
-  if (Ty->isPointerType() || Ty->isArrayType()) 
+  if (!foundP && (Ty->isPointerType() || Ty->isArrayType())) 
     // Create a pointer value for the type.
     P = new PVConstraint(D, freeKey, CS, *C);
 
   // Only create a function type if the type is a base Function type. The case
   // for creating function pointers is handled above, with a PVConstraint that
   // contains a FVConstraint.
-  if (Ty->isFunctionType()) 
+  if (!foundF && Ty->isFunctionType()) 
     // Create a function value for the type.
     F = new FVConstraint(D, freeKey, CS, *C);
 
-  std::set<ConstraintVariable*> &S = Variables[PLoc];
-  bool found = false;
-  for (const auto &I : S)
-    if (isa<FVConstraint>(I))
-      found = true;
-
-  if (found == false && F != nullptr)
-    Variables[PLoc].insert(F);
-  found = false;
-
-  for (const auto &I : S)
-    if (isa<PVConstraint>(I))
-      found = true;
-
-  if (found == false && P != nullptr)
-    Variables[PLoc].insert(P);
+  if (F != nullptr)
+    S.insert(F);
+  if (P != nullptr)
+    S.insert(P);
 
   // Did we create a function?
   if (F) {
@@ -1032,6 +1311,55 @@ bool ProgramInfo::addVariable(DeclaratorDecl *D, DeclStmt *St, ASTContext *C) {
   return true;
 }
 
+bool ProgramInfo::deferVariable(DeclaratorDecl *D, ASTContext *C) {
+  assert(persisted == false);
+  FullSourceLoc FL = C->getFullLoc(D->getLocStart());
+  if (!FL.isValid() || !FL.isInSystemHeader())
+    return false;
+  // The body of a function is visited where it is defined, which can't wait
+  // for a use.
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(D))
+    if (FD->hasBody())
+      return false;
+  DeferredDecls.insert(D);
+  return true;
+}
+
+bool ProgramInfo::seenHeaderDecl(Decl *D, ASTContext *C) {
+  assert(persisted == false);
+  SourceManager &SM = C->getSourceManager();
+  std::pair<FileID, unsigned> Loc =
+    SM.getDecomposedExpansionLoc(D->getLocStart());
+  if (Loc.first.isInvalid() || Loc.first == SM.getMainFileID())
+    return false;
+
+  auto I = HeaderKeys.find(Loc.first);
+  if (I == HeaderKeys.end()) {
+    uint64_t Key = 0;
+    const FileEntry *FE = SM.getFileEntryForID(Loc.first);
+    bool Invalid = false;
+    StringRef Buf = SM.getBufferData(Loc.first, &Invalid);
+    if (FE && !Invalid && !SM.isInSystemHeader(D->getLocStart()))
+      Key = llvm::hash_combine(FE->getName(), llvm::MD5Hash(Buf));
+    I = HeaderKeys.insert(std::make_pair(Loc.first, Key)).first;
+  }
+  if (I->second == 0)
+    return false;
+
+  uint64_t Key =
+    llvm::hash_combine(I->second, Loc.second, unsigned(D->getKind()));
+  return !HeaderDecls.insert(Key).second;
+}
+
+void ProgramInfo::materialize(Decl *D, ASTContext *C) {
+  DeclaratorDecl *DD = dyn_cast<DeclaratorDecl>(D);
+  if (!DD || !DeferredDecls.erase(DD))
+    return;
+  addVariable(DD, nullptr, C);
+  if (FunctionDecl *FD = dyn_cast<FunctionDecl>(DD))
+    seeFunctionDecl(FD, C);
+}
+
 bool ProgramInfo::getDeclStmtForDecl(Decl *D, DeclStmt *&St) {
   assert(persisted == false);
   auto I = VarDeclToStatement.find(D);
@@ -1042,6 +1370,30 @@ bool ProgramInfo::getDeclStmtForDecl(Decl *D, DeclStmt *&St) {
     return false;
 }
 
+// Add the constraint variables in Vs to R, if they are not in it already.
+template <typename T>
+static void insertVariables(CVarList &R, const T &Vs) {
+  for (ConstraintVariable *V : Vs)
+    if (std::find(R.begin(), R.end(), V) == R.end())
+      R.push_back(V);
+}
+
+// Add a copy of PVC without its outer-most pointer level to R. If that
+// leaves no levels, nothing is added.
+static void insertDereferenced(CVarList &R, PVConstraint *PVC) {
+  // Subtract one from this constraint. If that generates an empty 
+  // constraint, then, don't add it 
+  const CVars &Levels = PVC->getCvars();
+  if (Levels.size() > 0) {
+    CVars C(std::next(Levels.begin()), Levels.end());
+    if (C.size() > 0) {
+      bool a = PVC->getArrPresent();
+      FVConstraint *b = PVC->getFV();
+      R.push_back(new PVConstraint(C, PVC->getTy(), PVC->getName(), b, a));
+    }
+  }
+}
+
 // This is a bit of a hack. What we need to do is traverse the AST in a
 // bottom-up manner, and, for a given expression, decide which singular,
 // if any, constraint variable is involved in that expression. However,
@@ -1051,83 +1403,43 @@ bool ProgramInfo::getDeclStmtForDecl(Decl *D, DeclStmt *&St) {
 // variable involved. This is probably incomplete, but, we're going to
 // go with it for now.
 //
-// V is (currentVariable, baseVariable, limitVariable)
-// E is an expression to recursively traverse.
-//
-// Returns true if E resolves to a constraint variable q_i and the
-// currentVariable field of V is that constraint variable. Returns false if
-// a constraint variable cannot be found.
+// E is an expression to recursively traverse. The constraint variables
+// that E refers to are added to R.
 // ifc mirrors the inFunctionContext boolean parameter to getVariable. 
-std::set<ConstraintVariable *> 
+void
 ProgramInfo::getVariableHelper( Expr                            *E,
-                                std::set<ConstraintVariable *>  V,
+                                CVarList                        &R,
                                 ASTContext                      *C,
                                 bool                            ifc)
 {
   E = E->IgnoreParenImpCasts();
   if (DeclRefExpr *DRE = dyn_cast<DeclRefExpr>(E)) {
-    return getVariable(DRE->getDecl(), C, ifc);
+    if (std::set<ConstraintVariable*> *S = lookupVariables(DRE->getDecl(), C, ifc))
+      insertVariables(R, *S);
   } else if (MemberExpr *ME = dyn_cast<MemberExpr>(E)) {
-    return getVariable(ME->getMemberDecl(), C, ifc);
+    if (std::set<ConstraintVariable*> *S = lookupVariables(ME->getMemberDecl(), C, ifc))
+      insertVariables(R, *S);
   } else if (BinaryOperator *BO = dyn_cast<BinaryOperator>(E)) {
-    std::set<ConstraintVariable*> T1 = getVariableHelper(BO->getLHS(), V, C, ifc);
-    std::set<ConstraintVariable*> T2 = getVariableHelper(BO->getRHS(), V, C, ifc);
-    T1.insert(T2.begin(), T2.end());
-    return T1;
+    insertVariables(R, getExprVariables(BO->getLHS(), C, ifc));
+    insertVariables(R, getExprVariables(BO->getRHS(), C, ifc));
   } else if (ArraySubscriptExpr *AE = dyn_cast<ArraySubscriptExpr>(E)) {
     // In an array subscript, we want to do something sort of similar to taking
     // the address or doing a dereference. 
-    std::set<ConstraintVariable *> T = getVariableHelper(AE->getBase(), V, C, ifc);
-    std::set<ConstraintVariable*> tmp;
-    for (const auto &CV : T) {
-      if (PVConstraint *PVC = dyn_cast<PVConstraint>(CV)) {
-        // Subtract one from this constraint. If that generates an empty 
-        // constraint, then, don't add it 
-        std::set<uint32_t> C = PVC->getCvars();
-        if(C.size() > 0) {
-          C.erase(C.begin());
-          if (C.size() > 0) {
-            bool a = PVC->getArrPresent();
-            FVConstraint *b = PVC->getFV();
-            tmp.insert(new PVConstraint(C, PVC->getTy(), PVC->getName(), b, a));
-          }
-        }
-      }
-    }
-
-    T.swap(tmp);
-    return T;
+    for (const auto &CV : getExprVariables(AE->getBase(), C, ifc))
+      if (PVConstraint *PVC = dyn_cast<PVConstraint>(CV))
+        insertDereferenced(R, PVC);
   } else if (UnaryOperator *UO = dyn_cast<UnaryOperator>(E)) {
-    std::set<ConstraintVariable *> T = 
-      getVariableHelper(UO->getSubExpr(), V, C, ifc);
-   
-    std::set<ConstraintVariable*> tmp;
+    const CVarList &T = getExprVariables(UO->getSubExpr(), C, ifc);
     if (UO->getOpcode() == UO_Deref) {
       for (const auto &CV : T) {
-        if (PVConstraint *PVC = dyn_cast<PVConstraint>(CV)) {
-          // Subtract one from this constraint. If that generates an empty 
-          // constraint, then, don't add it 
-          std::set<uint32_t> C = PVC->getCvars();
-          if(C.size() > 0) {
-            C.erase(C.begin());
-            if (C.size() > 0) {
-              bool a = PVC->getArrPresent();
-              FVConstraint *b = PVC->getFV();
-              tmp.insert(new PVConstraint(C, PVC->getTy(), PVC->getName(), b, a));
-            }
-          }
-        } else {
+        if (PVConstraint *PVC = dyn_cast<PVConstraint>(CV))
+          insertDereferenced(R, PVC);
+        else
           llvm_unreachable("Shouldn't dereference a function pointer!");
-        }
       }
-      T.swap(tmp);
+    } else {
+      R.append(T.begin(), T.end());
     }
-
-    return T;
-  } else if (ImplicitCastExpr *IE = dyn_cast<ImplicitCastExpr>(E)) {
-    return getVariableHelper(IE->getSubExpr(), V, C, ifc);
-  } else if (ParenExpr *PE = dyn_cast<ParenExpr>(E)) {
-    return getVariableHelper(PE->getSubExpr(), V, C, ifc);
   } else if (CallExpr *CE = dyn_cast<CallExpr>(E)) {
     // Here, we need to look up the target of the call and return the
     // constraints for the return value of that function.
@@ -1136,78 +1448,91 @@ ProgramInfo::getVariableHelper( Expr                            *E,
       // There are a few reasons that we couldn't get a decl. For example,
       // the call could be done through an array subscript. 
       Expr *CalledExpr = CE->getCallee();
-      std::set<ConstraintVariable*> tmp = getVariableHelper(CalledExpr, V, C, ifc);
-      std::set<ConstraintVariable*> T;
-
-      for (ConstraintVariable *C : tmp) {
-        if (FVConstraint *FV = dyn_cast<FVConstraint>(C)) {
-          T.insert(FV->getReturnVars().begin(), FV->getReturnVars().end());
-        } else if(PVConstraint *PV = dyn_cast<PVConstraint>(C)) {
+      for (ConstraintVariable *CV : getExprVariables(CalledExpr, C, ifc)) {
+        if (FVConstraint *FV = dyn_cast<FVConstraint>(CV)) {
+          insertVariables(R, FV->getReturnVars());
+        } else if(PVConstraint *PV = dyn_cast<PVConstraint>(CV)) {
           if (FVConstraint *FV = PV->getFV()) {
-            T.insert(FV->getReturnVars().begin(), FV->getReturnVars().end());
+            insertVariables(R, FV->getReturnVars());
           }
         }
       }
-
-      return T;
+      return;
     }
     assert(D != nullptr);
     // D could be a FunctionDecl, or a VarDecl, or a FieldDecl. 
     // Really it could be any DeclaratorDecl. 
     if (DeclaratorDecl *FD = dyn_cast<DeclaratorDecl>(D)) {
-      std::set<ConstraintVariable*> CS = getVariable(FD, C, ifc);
-      std::set<ConstraintVariable*> TR;
       FVConstraint *FVC = nullptr;
-      for (const auto &J : CS) {
-        if (FVConstraint *tmp = dyn_cast<FVConstraint>(J))
-          // The constraint we retrieved is a function constraint already.
-          // This happens if what is being called is a reference to a 
-          // function declaration, but it isn't all that can happen.
-          FVC = tmp;
-        else if (PVConstraint *tmp = dyn_cast<PVConstraint>(J))
-          if (FVConstraint *tmp2 = tmp->getFV())
-            // Or, we could have a PVConstraint to a function pointer. 
-            // In that case, the function pointer value will work just
-            // as well.
-            FVC = tmp2;
+      if (std::set<ConstraintVariable*> *CS = lookupVariables(FD, C, ifc)) {
+        for (const auto &J : *CS) {
+          if (FVConstraint *tmp = dyn_cast<FVConstraint>(J))
+            // The constraint we retrieved is a function constraint already.
+            // This happens if what is being called is a reference to a 
+            // function declaration, but it isn't all that can happen.
+            FVC = tmp;
+          else if (PVConstraint *tmp = dyn_cast<PVConstraint>(J))
+            if (FVConstraint *tmp2 = tmp->getFV())
+              // Or, we could have a PVConstraint to a function pointer. 
+              // In that case, the function pointer value will work just
+              // as well.
+              FVC = tmp2;
+        }
       }
 
       if (FVC) {
-        TR.insert(FVC->getReturnVars().begin(), FVC->getReturnVars().end());
+        insertVariables(R, FVC->getReturnVars());
       } else {
         // Our options are slim. For some reason, we have failed to find a 
         // FVConstraint for the Decl that we are calling. This can't be good
         // so we should constrain everything in the caller to top. We can
         // fake this by returning a nullary-ish FVConstraint and that will
         // make the logic above us freak out and over-constrain everything.
-        TR.insert(new FVConstraint()); 
+        R.push_back(new FVConstraint()); 
       }
-
-      return TR;
     } else {
       // If it ISN'T, though... what to do? How could this happen?
       llvm_unreachable("TODO");
     }
   } else if (ConditionalOperator *CO = dyn_cast<ConditionalOperator>(E)) {
     // Explore the three exprs individually.
-    std::set<ConstraintVariable*> T;
-    std::set<ConstraintVariable*> R;
-    T = getVariableHelper(CO->getCond(), V, C, ifc);
-    R.insert(T.begin(), T.end());
-    T = getVariableHelper(CO->getLHS(), V, C, ifc);
-    R.insert(T.begin(), T.end());
-    T = getVariableHelper(CO->getRHS(), V, C, ifc);
-    R.insert(T.begin(), T.end());
-    return R;
-  } else {
-    return std::set<ConstraintVariable*>();
+    insertVariables(R, getExprVariables(CO->getCond(), C, ifc));
+    insertVariables(R, getExprVariables(CO->getLHS(), C, ifc));
+    insertVariables(R, getExprVariables(CO->getRHS(), C, ifc));
   }
 }
 
-// Given a decl, return the variables for the constraints of the Decl.
-std::set<ConstraintVariable*>
-ProgramInfo::getVariable(Decl *D, ASTContext *C, bool inFunctionContext) {
+const CVarList &
+ProgramInfo::getExprVariables(Expr *E, ASTContext *C, bool ifc) {
+  E = E->IgnoreParenImpCasts();
+  llvm::PointerIntPair<Expr*, 1, bool> Key(E, ifc);
+  auto I = ExprVariables.find(Key);
+  if (I != ExprVariables.end() && I->second.Generation == VariableGeneration)
+    return I->second.Vars;
+
+  // Looking up the subexpressions of E can add entries, so the entry for E
+  // is only made once they are done.
+  CVarList R;
+  getVariableHelper(E, R, C, ifc);
+  ExprVariablesEntry &Entry = ExprVariables[Key];
+  Entry.Generation = VariableGeneration;
+  Entry.Vars = std::move(R);
+  return Entry.Vars;
+}
+
+std::set<ConstraintVariable*> *
+ProgramInfo::lookupVariables(Decl *D, ASTContext *C, bool inFunctionContext) {
   assert(persisted == false);
+  // The variables of a deferred declaration are made when they are first
+  // looked up. Those of a parameter are made with its function.
+  if (!DeferredDecls.empty()) {
+    if (ParmVarDecl *PD = dyn_cast<ParmVarDecl>(D)) {
+      if (const DeclContext *DC = PD->getParentFunctionOrMethod())
+        if (const FunctionDecl *Parent = dyn_cast<FunctionDecl>(DC))
+          materialize(const_cast<FunctionDecl*>(Parent), C);
+    } else
+      materialize(D, C);
+  }
   VariableMap::iterator I = Variables.find(PersistentSourceLoc::mkPSL(D, *C));
   if (I != Variables.end()) {
     // If we are looking up a variable, and that variable is a parameter variable,
@@ -1262,6 +1587,7 @@ ProgramInfo::getVariable(Decl *D, ASTContext *C, bool inFunctionContext) {
 
               assert(idx >= 0);
 
+              materialize(const_cast<FunctionDecl*>(fwdDecl), C);
               const ParmVarDecl *otherDecl = fwdDecl->getParamDecl(idx);
               I = Variables.find(PersistentSourceLoc::mkPSL(otherDecl, *C));
               assert(I != Variables.end());
@@ -1270,11 +1596,20 @@ ProgramInfo::getVariable(Decl *D, ASTContext *C, bool inFunctionContext) {
         }
       }
     }
-    return I->second;
+    return &I->second;
   } else {
-    return std::set<ConstraintVariable*>();
+    return nullptr;
   }
 }
+
+// Given a decl, return the variables for the constraints of the Decl.
+std::set<ConstraintVariable*>
+ProgramInfo::getVariable(Decl *D, ASTContext *C, bool inFunctionContext) {
+  if (std::set<ConstraintVariable*> *S = lookupVariables(D, C, inFunctionContext))
+    return *S;
+  return std::set<ConstraintVariable*>();
+}
+
 // Given some expression E, what is the top-most constraint variable that
 // E refers to? It could be none, in which case the returned set is empty. 
 // Otherwise, the returned setcontains the constraint variable(s) that E 
@@ -1284,9 +1619,8 @@ ProgramInfo::getVariable(Expr *E, ASTContext *C, bool inFunctionContext) {
   assert(persisted == false);
 
   // Get the constraint variables represented by this Expr
-  std::set<ConstraintVariable*> T;
-  if (E)
-    return getVariableHelper(E, T, C, inFunctionContext);
-  else
-    return T;
+  if (!E)
+    return std::set<ConstraintVariable*>();
+  const CVarList &T = getExprVariables(E, C, inFunctionContext);
+  return std::set<ConstraintVariable*>(T.begin(), T.end());
 }
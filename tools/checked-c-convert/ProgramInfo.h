@@ -28,16 +28,24 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/PointerIntPair.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
 
 #include "Constraints.h"
 #include "utils.h"
 #include "PersistentSourceLoc.h"
+#include "StringStore.h"
 
 class ProgramInfo;
 
 // Holds integers representing constraint variables, with semantics as 
-// defined in the comment at the top of the file.
-typedef std::set<uint32_t> CVars;
+// defined in the comment at the top of the file. There is one for each
+// level of a pointer type, outer-most first, and most pointers have one or 
+// two levels, so they are kept inline.
+typedef llvm::SmallVector<uint32_t, 2> CVars;
 
 // Base class for ConstraintVariables. A ConstraintVariable can either be a 
 // PointerVariableConstraint or a FunctionVariableConstraint. The difference
@@ -55,9 +63,9 @@ public:
 private:
   ConstraintVariableKind Kind;
 protected:
-  std::string BaseType;
+  StoredString BaseType;
   // Underlying name of the C variable this ConstraintVariable represents.
-  std::string Name;
+  StoredString Name;
   // Set of constraint variables that have been constrained due to a 
   // bounds-safe interface. They are remembered as being constrained
   // so that later on we do not introduce a spurious constraint 
@@ -69,7 +77,8 @@ public:
     Kind(K),BaseType(T),Name(N) {}
 
   // Create a "for-rewriting" representation of this ConstraintVariable.
-  virtual std::string mkString(Constraints::EnvironmentMap &E) = 0;
+  // It is made once for each solution in E, and kept until E changes.
+  std::string mkString(Constraints::EnvironmentMap &E);
 
   // Debug printing of the constraint variable.
   virtual void print(llvm::raw_ostream &O) const = 0;
@@ -87,8 +96,8 @@ public:
   // environment.
   virtual bool anyChanges(Constraints::EnvironmentMap &E) = 0;
 
-  std::string getTy() { return BaseType; }
-  std::string getName() { return Name; }
+  std::string getTy() { return BaseType.str(); }
+  std::string getName() { return Name.str(); }
 
   void constrainedVariable(uint32_t K) {
     ConstrainedVars.insert(K);
@@ -113,7 +122,29 @@ public:
   virtual bool liftedOnCVars(const ConstraintVariable &O, 
       ProgramInfo &Info,
       llvm::function_ref<bool (ConstAtom *, ConstAtom *)>) const = 0;
- 
+
+  // Append the constraint variables 'within' this ConstraintVariable to V,
+  // in the order they were allocated. Two ConstraintVariables built from 
+  // the same declaration give their constraint variables in the same 
+  // order.
+  virtual void getAllCvars(std::vector<uint32_t> &V) const = 0;
+
+  // Replace every constraint variable K 'within' this ConstraintVariable 
+  // by M(K). Done holds the ConstraintVariables that have already been 
+  // renumbered, which are skipped, so that ConstraintVariables reachable
+  // in more than one way are only renumbered once.
+  virtual void renumber(llvm::function_ref<uint32_t (uint32_t)> M,
+      std::set<ConstraintVariable*> &Done);
+
+protected:
+  // Make the representation returned by mkString.
+  virtual std::string render(Constraints::EnvironmentMap &E) = 0;
+
+private:
+  // The last representation made by mkString, and the stamp of the
+  // solution it was made from.
+  std::string Rendered;
+  uint32_t RenderedStamp = 0;
 };
 
 class PointerVariableConstraint;
@@ -170,8 +201,6 @@ public:
     return S->getKind() == PointerVariable;
   }
 
-  std::string mkString(Constraints::EnvironmentMap &E);
-
   FunctionVariableConstraint *getFV() { return FV; }
 
   void print(llvm::raw_ostream &O) const ;
@@ -184,8 +213,16 @@ public:
   bool liftedOnCVars(const ConstraintVariable &O, 
       ProgramInfo &Info,
       llvm::function_ref<bool (ConstAtom *, ConstAtom *)>) const;
+  void getAllCvars(std::vector<uint32_t> &V) const;
+  void renumber(llvm::function_ref<uint32_t (uint32_t)> M,
+      std::set<ConstraintVariable*> &Done);
 
   virtual ~PointerVariableConstraint() {};
+
+  friend class ConstraintCache;
+
+protected:
+  std::string render(Constraints::EnvironmentMap &E);
 };
 
 typedef PointerVariableConstraint PVConstraint;
@@ -200,7 +237,7 @@ private:
   // K parameters accepted by the function.
   std::vector<std::set<ConstraintVariable*>> paramVars;
   // Name of the function or function variable. Used by mkString.
-  std::string name;
+  StoredString name;
   bool hasproto;
   bool hasbody;
 public:
@@ -216,7 +253,7 @@ public:
   getReturnVars() { return returnVars; }
 
   size_t numParams() { return paramVars.size(); }
-  std::string getName() { return name; }
+  std::string getName() { return name.str(); }
 
   bool hasProtoType() { return hasproto; }
   bool hasBody() { return hasbody; }
@@ -231,7 +268,6 @@ public:
     return paramVars.at(i);
   }
 
-  std::string mkString(Constraints::EnvironmentMap &E);
   void print(llvm::raw_ostream &O) const;
   void dump() const { print(llvm::errs()); }
   void constrainTo(Constraints &CS, ConstAtom *C, bool checkSkip=false);
@@ -242,19 +278,36 @@ public:
   bool liftedOnCVars(const ConstraintVariable &O, 
       ProgramInfo &Info,
       llvm::function_ref<bool (ConstAtom *, ConstAtom *)>) const;
+  void getAllCvars(std::vector<uint32_t> &V) const;
+  void renumber(llvm::function_ref<uint32_t (uint32_t)> M,
+      std::set<ConstraintVariable*> &Done);
  
   virtual ~FunctionVariableConstraint() {};
+
+  friend class ConstraintCache;
+
+protected:
+  std::string render(Constraints::EnvironmentMap &E);
 };
 
 typedef FunctionVariableConstraint FVConstraint;
 
+// The ConstraintVariables of an expression, without duplicates. There are
+// rarely more than two.
+typedef llvm::SmallVector<ConstraintVariable*, 2> CVarList;
+
 class ProgramInfo {
 public:
-  ProgramInfo() : freeKey(0), persisted(true) {}
+  ProgramInfo() : freeKey(0), VariableGeneration(0), persisted(true) {}
   void print(llvm::raw_ostream &O) const;
   void dump() const { print(llvm::errs()); }
   void dump_stats(std::set<std::string> &F) { print_stats(F, llvm::errs()); }
   void print_stats(std::set<std::string> &F, llvm::raw_ostream &O);
+  // Print why the constraint variables declared at Loc, given as 
+  // file:line:col, are WILD in the solution, as the chain of constraints
+  // that made each of them WILD. Returns false if Loc is malformed or no
+  // constraint variables are declared there.
+  bool explainWild(llvm::StringRef Loc, llvm::raw_ostream &O);
 
   Constraints &getConstraints() { return CS;  }
 
@@ -272,6 +325,12 @@ public:
   // constraint system for that pointer type. 
   bool addVariable(clang::DeclaratorDecl *D, clang::DeclStmt *St, clang::ASTContext *C);
 
+  // If D is a declaration in a system header, other than the definition of
+  // a function, don't add its variables until they are looked up in this
+  // compilation unit, and return true. Most of the declarations in system
+  // headers are never used, and they can't be rewritten.
+  bool deferVariable(clang::DeclaratorDecl *D, clang::ASTContext *C);
+
   bool getDeclStmtForDecl(clang::Decl *D, clang::DeclStmt *&St);
 
   // Checks the structural type equality of two constrained locations. This is 
@@ -284,6 +343,29 @@ public:
                                 clang::QualType UTy);
   bool checkStructuralEquality(clang::QualType, clang::QualType);
 
+  // Add the constraint variables, constraints and global symbols that 
+  // Local gathered from other compilation units. Constraint variables in
+  // Local are identified with the ones of the same kind at the same 
+  // PersistentSourceLoc here, as if the compilation units of Local had 
+  // been visited after those of this ProgramInfo. The others are given 
+  // new numbers. Local should not be used afterwards.
+  void merge(ProgramInfo &Local);
+
+  // Record that the compilation unit read the file Name, whose contents
+  // hash to Hash. Used to tell whether cached constraints are up to date.
+  void seeInputFile(llvm::StringRef Name, uint64_t Hash) {
+    InputFiles[Name] = Hash;
+  }
+
+  // Determine whether the top-level declaration D, which is in a header, 
+  // was visited in an earlier compilation unit, that is, whether a header
+  // with the same name and contents had a declaration of the same kind at
+  // the same offset. If not, D is recorded for the compilation units that
+  // follow. Visiting such a declaration again would only add the variables
+  // and constraints that it added before. Declarations in system headers 
+  // are deferred instead, and are always visited.
+  bool seenHeaderDecl(clang::Decl *D, clang::ASTContext *C);
+
   // Called when we are done adding constraints and visiting ASTs. 
   // Links information about global symbols together and adds 
   // constraints where appropriate.
@@ -294,25 +376,6 @@ public:
   void seeFunctionDecl(clang::FunctionDecl *, clang::ASTContext *);
   void seeGlobalDecl(clang::VarDecl *);
 
-  // This is a bit of a hack. What we need to do is traverse the AST in a 
-  // bottom-up manner, and, for a given expression, decide which,
-  // if any, constraint variable(s) are involved in that expression. However, 
-  // in the current version of clang (3.8.1), bottom-up traversal is not 
-  // supported. So instead, we do a manual top-down traversal, considering
-  // the different cases and their meaning on the value of the constraint
-  // variable involved. This is probably incomplete, but, we're going to 
-  // go with it for now. 
-  //
-  // V is (currentVariable, baseVariable, limitVariable)
-  // E is an expression to recursively traverse.
-  //
-  // Returns true if E resolves to a constraint variable q_i and the 
-  // currentVariable field of V is that constraint variable. Returns false if 
-  // a constraint variable cannot be found.
-  std::set<ConstraintVariable *> 
-  getVariableHelper(clang::Expr *E,std::set<ConstraintVariable *>V,
-    clang::ASTContext *C, bool ifc);
-
   // Given some expression E, what is the top-most constraint variable that
   // E refers to? 
   // inFunctionContext controls whether or not this operation is within
@@ -332,6 +395,35 @@ private:
   // constrained. 
   bool isExternOkay(std::string ext);
 
+  // This is a bit of a hack. What we need to do is traverse the AST in a 
+  // bottom-up manner, and, for a given expression, decide which,
+  // if any, constraint variable(s) are involved in that expression. However, 
+  // in the current version of clang (3.8.1), bottom-up traversal is not 
+  // supported. So instead, we do a manual top-down traversal, considering
+  // the different cases and their meaning on the value of the constraint
+  // variable involved. This is probably incomplete, but, we're going to 
+  // go with it for now. 
+  //
+  // E is an expression to recursively traverse. The constraint variables
+  // that E refers to are added to R, which starts out empty.
+  void getVariableHelper(clang::Expr *E, CVarList &R, clang::ASTContext *C,
+                         bool ifc);
+
+  // The constraint variables of E, looked up through getVariableHelper the
+  // first time they are asked for in the compilation unit. The list stays
+  // valid until getExprVariables is called again.
+  const CVarList &getExprVariables(clang::Expr *E, clang::ASTContext *C,
+                                   bool ifc);
+
+  // Add the variables of D, and see it as a function declaration if it is
+  // one, if they were deferred by deferVariable.
+  void materialize(clang::Decl *D, clang::ASTContext *C);
+
+  // The constraint variables of D, or null if D has none.
+  std::set<ConstraintVariable*> *lookupVariables(clang::Decl *D,
+                                                 clang::ASTContext *C,
+                                                 bool inFunctionContext);
+
   std::list<clang::RecordDecl*> Records;
   // Next available integer to assign to a variable.
   uint32_t freeKey;
@@ -341,12 +433,34 @@ private:
   // out how to break up variable declarations that should span lines in the
   // new program.
   VariableDecltoStmtMap VarDeclToStatement;
+  // The declarations of the compilation unit whose variables are deferred.
+  llvm::DenseSet<clang::DeclaratorDecl*> DeferredDecls;
+  // The top-level declarations of headers that were visited, by a hash of
+  // the name and contents of the header and the offset and kind of the 
+  // declaration.
+  llvm::DenseSet<uint64_t> HeaderDecls;
+  // For the compilation unit, the hash of the name and contents of each
+  // header, or 0 for a file whose declarations are always visited.
+  llvm::DenseMap<clang::FileID, uint64_t> HeaderKeys;
 
   // List of all constraint variables, indexed by their location in the source.
   // This information persists across invocations of the constraint analysis
   // from compilation unit to compilation unit.
   VariableMap Variables;
 
+  // The constraint variables of the expressions that were looked up in the
+  // compilation unit, by expression and function context. An entry is only
+  // used if no variables were added since it was computed, that is, if its
+  // generation is VariableGeneration.
+  struct ExprVariablesEntry {
+    uint32_t Generation;
+    CVarList Vars;
+  };
+  llvm::DenseMap<llvm::PointerIntPair<clang::Expr*, 1, bool>,
+                 ExprVariablesEntry>
+    ExprVariables;
+  uint32_t VariableGeneration;
+
   // Constraint system.
   Constraints CS;
   // Is the ProgramInfo persisted? Only tested in asserts. Starts at true.
@@ -355,8 +469,14 @@ private:
   // Map of global functions for whom we don't have a body, the keys are 
   // names of external functions, the value is whether the body has been
   // seen before.
-  std::map<std::string, bool> ExternFunctions;
-  std::map<std::string, std::set<FVConstraint*>> GlobalSymbols;
+  llvm::StringMap<bool> ExternFunctions;
+  // The declarations of each global function, from every compilation unit.
+  llvm::StringMap<std::set<FVConstraint*>> GlobalSymbols;
+  // The files read by the compilation units visited, with the hashes of
+  // their contents.
+  std::map<std::string, uint64_t> InputFiles;
+
+  friend class ConstraintCache;
 };
 
 #endif
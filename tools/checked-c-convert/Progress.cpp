@@ -0,0 +1,169 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Implementation of progress reports, phase times and traces.
+//===----------------------------------------------------------------------===//
+#include "Progress.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+
+using namespace llvm;
+
+// The solver's rounds are summarized in at most this many lines.
+static const size_t MaxRoundLines = 32;
+
+static double seconds(Progress::Clock::duration D) {
+  return std::chrono::duration<double>(D).count();
+}
+
+static uint64_t microseconds(Progress::Clock::duration D) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(D).count();
+}
+
+// Write S to OS as a JSON string.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (unsigned char C : S) {
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+Progress &Progress::get() {
+  static Progress P;
+  return P;
+}
+
+Progress::Phase::Phase(StringRef Name) : Name(Name), Start(Clock::now()) {}
+
+Progress::Phase::~Phase() {
+  Progress &P = Progress::get();
+  Clock::time_point End = Clock::now();
+  std::lock_guard<std::mutex> Guard(P.Lock);
+  if (P.TimePhases)
+    P.PhaseTimes.push_back(std::make_pair(Name, seconds(End - Start)));
+  P.addEvent(Name, "phase", "", Start, End);
+}
+
+void Progress::addEvent(StringRef Name, StringRef Category, StringRef File,
+                        Clock::time_point Start, Clock::time_point End) {
+  if (!Tracing)
+    return;
+  auto T = Threads.insert(
+    std::make_pair(std::this_thread::get_id(), unsigned(Threads.size())));
+  Events.push_back(Event{Name.str(), Category.str(), File.str(), Start, End,
+                         T.first->second});
+}
+
+void Progress::unitDone(StringRef UnitStage, StringRef File,
+                        Clock::time_point Start, size_t NumConstraints) {
+  Clock::time_point Now = Clock::now();
+  std::lock_guard<std::mutex> Guard(Lock);
+  addEvent(UnitStage, "unit", File, Start, Now);
+
+  if (Stage != UnitStage) {
+    Stage = UnitStage;
+    StageStart = Start;
+    LastReport = Start;
+    UnitsDone = 0;
+    ConstraintsAdded = 0;
+  }
+  UnitsDone++;
+  ConstraintsAdded += NumConstraints;
+
+  if (Interval == 0 ||
+      (seconds(Now - LastReport) < Interval && UnitsDone != NumUnits))
+    return;
+  LastReport = Now;
+
+  double Elapsed = seconds(Now - StageStart);
+  errs() << "[progress] " << Stage << ": " << UnitsDone;
+  if (NumUnits)
+    errs() << "/" << NumUnits;
+  errs() << " units, "
+         << format("%.2f", Elapsed > 0 ? UnitsDone / Elapsed : 0.0)
+         << " units/s, " << ConstraintsAdded << " constraints, "
+         << format("%.1f", seconds(Now - RunStart)) << " s\n";
+}
+
+void Progress::solved(const std::vector<Constraints::SolveRound> &Rounds) {
+  if (Interval == 0)
+    return;
+  uint64_t Visited = 0, Raised = 0;
+  for (const auto &R : Rounds) {
+    Visited += R.Visited;
+    Raised += R.Raised;
+  }
+  errs() << "[progress] solve: " << Rounds.size() << " rounds, " << Visited
+         << " class visits, " << Raised << " classes raised\n";
+
+  // Many rounds, as from long chains of implications, are put together so
+  // that the report stays short.
+  size_t PerLine = (Rounds.size() + MaxRoundLines - 1) / MaxRoundLines;
+  for (size_t I = 0; I < Rounds.size(); I += PerLine) {
+    size_t E = std::min(Rounds.size(), I + PerLine);
+    Visited = 0;
+    Raised = 0;
+    for (size_t J = I; J < E; J++) {
+      Visited += Rounds[J].Visited;
+      Raised += Rounds[J].Raised;
+    }
+    errs() << "[progress]   round " << (I + 1);
+    if (E - I > 1)
+      errs() << "-" << E;
+    errs() << ": " << Visited << " visited, " << Raised << " raised\n";
+  }
+}
+
+void Progress::printPhaseTimes(raw_ostream &OS) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  if (!TimePhases)
+    return;
+  double Total = seconds(Clock::now() - RunStart);
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                      checked-c-convert phase times\n"
+     << "===" << std::string(73, '-') << "===\n"
+     << format("  Total Execution Time: %.4f seconds\n\n", Total)
+     << "   ---Wall Time---  --- Phase ---\n";
+  for (const auto &P : PhaseTimes)
+    OS << format("  %8.4f (%5.1f%%)  ", P.second,
+                 Total > 0 ? 100 * P.second / Total : 0.0)
+       << P.first << "\n";
+  OS << "\n";
+}
+
+bool Progress::writeTrace(StringRef File) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  std::error_code EC;
+  raw_fd_ostream OS(File, EC, sys::fs::F_Text);
+  if (EC)
+    return false;
+
+  OS << "{\"traceEvents\": [\n";
+  for (size_t I = 0; I < Events.size(); I++) {
+    const Event &E = Events[I];
+    OS << "{\"name\": ";
+    writeJSONString(OS, E.File.empty() ? E.Name : E.Name + " " + E.File);
+    OS << ", \"cat\": ";
+    writeJSONString(OS, E.Category);
+    OS << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << E.Thread
+       << ", \"ts\": " << microseconds(E.Start - RunStart)
+       << ", \"dur\": " << microseconds(E.End - E.Start);
+    if (!E.File.empty()) {
+      OS << ", \"args\": {\"file\": ";
+      writeJSONString(OS, E.File);
+      OS << "}";
+    }
+    OS << "}" << (I + 1 < Events.size() ? ",\n" : "\n");
+  }
+  OS << "]}\n";
+  return !OS.has_error();
+}
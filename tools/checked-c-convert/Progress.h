@@ -0,0 +1,119 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Progress reports, phase times and a trace of long runs of 
+// checked-c-convert.
+//
+// A run goes through the phases of gathering constraints, linking,
+// solving, rewriting and writing files. With -time-phases the wall time
+// of each phase is printed at the end of the run. With -progress, the
+// number of compilation units done and their rate, and the number of 
+// constraints, are printed every so often while compilation units are 
+// gathered and rewritten, and a summary of the solver's rounds once it is
+// done. With -trace, the phases and each compilation unit are written out
+// as events in the Chrome trace format, which can be loaded in 
+// chrome://tracing.
+//===----------------------------------------------------------------------===//
+#ifndef _PROGRESS_H
+#define _PROGRESS_H
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "Constraints.h"
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Progress {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  // The progress of this run of the tool.
+  static Progress &get();
+
+  // Print a progress report at most every Seconds seconds. 0 turns the
+  // reports off.
+  void setReportInterval(unsigned Seconds) { Interval = Seconds; }
+  // Keep the times of the phases, to be printed by printPhaseTimes.
+  void setTimePhases(bool B) { TimePhases = B; }
+  // Keep the events to be written by writeTrace.
+  void setTracing(bool B) { Tracing = B; }
+  // The number of compilation units that will be gathered and rewritten.
+  void setNumUnits(size_t N) { NumUnits = N; }
+
+  // A phase of the run, from the construction of the Phase to its 
+  // destruction.
+  class Phase {
+  public:
+    explicit Phase(llvm::StringRef Name);
+    ~Phase();
+
+  private:
+    std::string Name;
+    Clock::time_point Start;
+  };
+
+  // Record that the compilation unit of File was done with Stage, which
+  // started at Start, and added NumConstraints constraints. This may be
+  // called from more than one thread.
+  void unitDone(llvm::StringRef Stage, llvm::StringRef File,
+                Clock::time_point Start, size_t NumConstraints);
+
+  // Report the rounds of a solve.
+  void solved(const std::vector<Constraints::SolveRound> &Rounds);
+
+  // Print the time taken by each phase, with -time-phases.
+  void printPhaseTimes(llvm::raw_ostream &OS);
+
+  // Write the events recorded so far to File. Returns false on failure.
+  bool writeTrace(llvm::StringRef File);
+
+private:
+  Progress() : Interval(0), TimePhases(false), Tracing(false), NumUnits(0),
+               RunStart(Clock::now()), UnitsDone(0), ConstraintsAdded(0) {}
+
+  struct Event {
+    std::string Name;
+    std::string Category;
+    std::string File;
+    Clock::time_point Start;
+    Clock::time_point End;
+    unsigned Thread;
+  };
+
+  // Record an event, with the lock held.
+  void addEvent(llvm::StringRef Name, llvm::StringRef Category, 
+                llvm::StringRef File, Clock::time_point Start,
+                Clock::time_point End);
+
+  // Compilation units are gathered from more than one thread with -j.
+  std::mutex Lock;
+
+  unsigned Interval;
+  bool TimePhases;
+  bool Tracing;
+  size_t NumUnits;
+  Clock::time_point RunStart;
+
+  // The stage that units are going through, and how far along it is.
+  std::string Stage;
+  Clock::time_point StageStart;
+  Clock::time_point LastReport;
+  size_t UnitsDone;
+  size_t ConstraintsAdded;
+
+  // The phases in the order they ended, with their wall times.
+  std::vector<std::pair<std::string, double>> PhaseTimes;
+  std::vector<Event> Events;
+  // Small numbers for the threads that recorded events.
+  std::map<std::thread::id, unsigned> Threads;
+};
+
+#endif
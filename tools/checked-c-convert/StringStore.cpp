@@ -0,0 +1,87 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Implementation of the StringStore.
+//===----------------------------------------------------------------------===//
+#include "StringStore.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace llvm;
+using namespace llvm::support;
+
+static const uint64_t SpilledBit = 1ULL << 63;
+
+StringStore &StringStore::get() {
+  static StringStore Store;
+  return Store;
+}
+
+bool StringStore::spillTo(StringRef File) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  std::error_code EC;
+  std::unique_ptr<raw_fd_ostream> OS(
+    new raw_fd_ostream(File, EC, sys::fs::F_None));
+  if (EC)
+    return false;
+
+  SpillFile = File;
+  Spill = std::move(OS);
+  SpillSize = 0;
+  Mapped.reset();
+  return true;
+}
+
+uint64_t StringStore::add(StringRef S) {
+  if (S.empty())
+    return 0;
+
+  std::lock_guard<std::mutex> Guard(Lock);
+  if (Spill) {
+    uint64_t H = SpilledBit | SpillSize;
+    char B[sizeof(uint32_t)];
+    endian::write<uint32_t, little, unaligned>(B, S.size());
+    Spill->write(B, sizeof(B));
+    *Spill << S;
+    SpillSize += sizeof(B) + S.size();
+    return H;
+  }
+
+  auto I = Ids.insert(std::make_pair(S, (uint64_t)Strings.size() + 1));
+  if (I.second)
+    Strings.push_back(S.str());
+  return I.first->second;
+}
+
+std::string StringStore::lookup(uint64_t H) {
+  if (H == 0)
+    return std::string();
+
+  std::lock_guard<std::mutex> Guard(Lock);
+  if (!(H & SpilledBit)) {
+    assert(H <= Strings.size());
+    return Strings[H - 1];
+  }
+
+  uint64_t Offset = H & ~SpilledBit;
+  assert(Spill && Offset < SpillSize);
+  if (!Mapped || Offset + sizeof(uint32_t) > Mapped->getBufferSize()) {
+    // Map the strings written so far.
+    Spill->flush();
+    ErrorOr<std::unique_ptr<MemoryBuffer>> Buf =
+      MemoryBuffer::getFile(SpillFile, -1, false);
+    if (!Buf)
+      report_fatal_error(Twine("could not read ") + SpillFile);
+    Mapped = std::move(*Buf);
+  }
+
+  StringRef Data = Mapped->getBuffer();
+  uint32_t Size = endian::read<uint32_t, little, unaligned>(
+    Data.data() + Offset);
+  assert(Offset + sizeof(uint32_t) + Size <= Data.size());
+  return Data.substr(Offset + sizeof(uint32_t), Size).str();
+}
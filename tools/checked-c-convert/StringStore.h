@@ -0,0 +1,79 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Storage for the type and name strings of ConstraintVariables. The solver
+// never looks at these strings; they are only needed to re-write the 
+// program. By default they are interned in memory. With -spill-metadata, 
+// new strings are appended to a side file instead, and only their offsets
+// are kept in memory. The side file is memory mapped when the strings are 
+// read back, which is normally only during re-writing.
+//===----------------------------------------------------------------------===//
+#ifndef _STRING_STORE_H
+#define _STRING_STORE_H
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class StringStore {
+public:
+  // The store shared by all ConstraintVariables.
+  static StringStore &get();
+
+  // Append the strings added from now on to File, which is created or 
+  // truncated. Returns false if File can't be created.
+  bool spillTo(llvm::StringRef File);
+
+  // Add S to the store and return a handle for it. The empty string has
+  // handle 0.
+  uint64_t add(llvm::StringRef S);
+
+  // Get the string with handle H.
+  std::string lookup(uint64_t H);
+
+private:
+  StringStore() : SpillSize(0) {}
+
+  // Strings are added and looked up from more than one thread with -j.
+  std::mutex Lock;
+
+  // Strings kept in memory. Handle i + 1 is Strings[i].
+  llvm::StringMap<uint64_t> Ids;
+  std::vector<std::string> Strings;
+
+  // Strings in the side file. The handle of one of these has the top bit
+  // set, and the offset of its length in the file in the other bits.
+  std::string SpillFile;
+  std::unique_ptr<llvm::raw_fd_ostream> Spill;
+  uint64_t SpillSize;
+  // A mapping of the side file, which is replaced once it is too short.
+  std::unique_ptr<llvm::MemoryBuffer> Mapped;
+};
+
+// A string held in the StringStore.
+class StoredString {
+public:
+  StoredString() : Handle(0) {}
+  StoredString(llvm::StringRef S) : Handle(StringStore::get().add(S)) {}
+  StoredString(const std::string &S) : StoredString(llvm::StringRef(S)) {}
+  StoredString(const char *S) : StoredString(llvm::StringRef(S)) {}
+
+  std::string str() const { 
+    return Handle == 0 ? std::string() : StringStore::get().lookup(Handle); 
+  }
+
+  bool empty() const { return Handle == 0; }
+
+private:
+  uint64_t Handle;
+};
+
+#endif
@@ -0,0 +1,232 @@
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// A benchmark of the checked-c-convert constraint solver. It generates
+// synthetic constraint systems with the shapes that show up in large
+// programs, solves them, and prints one line of JSON per run with the
+// time taken and the memory used, so that runs can be compared across
+// changes to the solver.
+//
+// The shapes are:
+//  chain   - q_0 = q_1 = ... = q_n-1, with the last one WILD, as from a
+//            long sequence of assignments between pointers.
+//  implies - q_i = WILD => q_i+1 = WILD, with q_0 WILD, as from the
+//            implications between a function and its call sites.
+//  star    - many pointers cast to and from one pointer, some of them
+//            used as arrays and some of the hubs WILD.
+//  fptable - tables of function pointers whose entries have the same
+//            number of parameters, each parameter equal to the parameter
+//            of the table, as from arrays of function pointers and from
+//            linking many declarations of the same function.
+//===----------------------------------------------------------------------===//
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "../Constraints.h"
+
+using namespace llvm;
+
+static cl::OptionCategory BenchCategory("checked-c-convert-bench options");
+
+static cl::list<std::string> Shapes("shape",
+  cl::desc("Shapes of constraint systems to solve (chain, implies, star, "
+           "fptable). All of them by default"),
+  cl::CommaSeparated, cl::cat(BenchCategory));
+
+static cl::opt<unsigned> MinVars("min-vars",
+  cl::desc("Number of variables in the smallest system"),
+  cl::init(1000), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> MaxVars("max-vars",
+  cl::desc("Number of variables in the largest system"),
+  cl::init(1000000), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> Step("step",
+  cl::desc("Factor between the sizes of successive systems"),
+  cl::init(10), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> Repeat("repeat",
+  cl::desc("Number of times to solve each system; the fastest is reported"),
+  cl::init(1), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> StarWidth("star-width",
+  cl::desc("Number of pointers cast to each hub in the star shape"),
+  cl::init(1000), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> TableWidth("table-width",
+  cl::desc("Number of entries in each table in the fptable shape"),
+  cl::init(64), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> TableParams("table-params",
+  cl::desc("Number of parameters of each entry in the fptable shape"),
+  cl::init(4), cl::cat(BenchCategory));
+
+typedef void (*Generator)(Constraints &CS, uint32_t N);
+
+static void addEq(Constraints &CS, uint32_t A, uint32_t B) {
+  CS.addConstraint(CS.createEq(CS.getOrCreateVar(A), CS.getOrCreateVar(B)));
+}
+
+static void addEq(Constraints &CS, uint32_t A, ConstAtom *C) {
+  CS.addConstraint(CS.createEq(CS.getOrCreateVar(A), C));
+}
+
+static void genChain(Constraints &CS, uint32_t N) {
+  for (uint32_t I = 0; I + 1 < N; I++)
+    addEq(CS, I, I + 1);
+  addEq(CS, N - 1, CS.getWild());
+}
+
+static void genImplies(Constraints &CS, uint32_t N) {
+  for (uint32_t I = 0; I + 1 < N; I++)
+    CS.addConstraint(CS.createImplies(
+      CS.createEq(CS.getOrCreateVar(I), CS.getWild()),
+      CS.createEq(CS.getOrCreateVar(I + 1), CS.getWild())));
+  addEq(CS, 0, CS.getWild());
+}
+
+static void genStar(Constraints &CS, uint32_t N) {
+  uint32_t Width = std::max(StarWidth.getValue(), 1u);
+  for (uint32_t Hub = 0; Hub < N; Hub += Width + 1) {
+    uint32_t End = std::min(N, Hub + Width + 1);
+    CS.getOrCreateVar(Hub);
+    for (uint32_t I = Hub + 1; I < End; I++) {
+      addEq(CS, I, Hub);
+      if (I % 7 == 0)
+        CS.addConstraint(CS.createNot(
+          CS.createEq(CS.getOrCreateVar(I), CS.getPtr())));
+    }
+    if ((Hub / (Width + 1)) % 4 == 0)
+      addEq(CS, Hub, CS.getWild());
+  }
+}
+
+static void genFPTable(Constraints &CS, uint32_t N) {
+  uint32_t Params = std::max(TableParams.getValue(), 1u);
+  uint32_t Width = std::max(TableWidth.getValue(), 1u);
+  // The parameters of the table, then those of each of its entries.
+  uint32_t TableSize = Params * (Width + 1);
+  for (uint32_t T = 0; T + TableSize <= N; T += TableSize) {
+    for (uint32_t E = 1; E <= Width; E++)
+      for (uint32_t P = 0; P < Params; P++)
+        addEq(CS, T + E * Params + P, T + P);
+    // One entry of every other table takes an unchecked parameter.
+    if ((T / TableSize) % 2 == 0)
+      addEq(CS, T + Params, CS.getWild());
+  }
+}
+
+static const struct {
+  const char *Name;
+  Generator Gen;
+} AllShapes[] = {
+  { "chain", genChain },
+  { "implies", genImplies },
+  { "star", genStar },
+  { "fptable", genFPTable },
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point Start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - Start)
+    .count();
+}
+
+// The peak resident set size of the process in kilobytes, or 0 if it is
+// not known. The sizes are run from smallest to largest, so this is the
+// peak of the largest system so far.
+static uint64_t peakRSSKB() {
+#ifndef _WIN32
+  struct rusage RU;
+  if (getrusage(RUSAGE_SELF, &RU) == 0) {
+#ifdef __APPLE__
+    return RU.ru_maxrss / 1024;
+#else
+    return RU.ru_maxrss;
+#endif
+  }
+#endif
+  return 0;
+}
+
+static void run(const char *Shape, Generator Gen, uint32_t N) {
+  double BuildMs = 0, SolveMs = 0;
+  size_t NumVars = 0, NumConstraints = 0, NumWild = 0, HeapBytes = 0;
+  bool Solved = false;
+
+  for (unsigned R = 0; R < std::max(Repeat.getValue(), 1u); R++) {
+    size_t HeapBefore = sys::Process::GetMallocUsage();
+    Constraints CS;
+    Clock::time_point Start = Clock::now();
+    Gen(CS, N);
+    double Build = msSince(Start);
+
+    Start = Clock::now();
+    Solved = CS.solve().second;
+    double Solve = msSince(Start);
+
+    if (R == 0 || Solve < SolveMs) {
+      BuildMs = Build;
+      SolveMs = Solve;
+    }
+    HeapBytes = sys::Process::GetMallocUsage() - HeapBefore;
+    NumVars = CS.getVariables().size();
+    NumConstraints = CS.getConstraints().size();
+    NumWild = 0;
+    for (const auto &V : CS.getVariables())
+      if (isa<WildAtom>(V.second))
+        NumWild++;
+  }
+
+  outs() << "{\"shape\": \"" << Shape << "\""
+         << ", \"vars\": " << NumVars
+         << ", \"constraints\": " << NumConstraints
+         << ", \"wild\": " << NumWild
+         << ", \"solved\": " << (Solved ? "true" : "false")
+         << ", \"build_ms\": " << format("%.3f", BuildMs)
+         << ", \"solve_ms\": " << format("%.3f", SolveMs)
+         << ", \"heap_bytes\": " << HeapBytes
+         << ", \"peak_rss_kb\": " << peakRSSKB() << "}\n";
+  outs().flush();
+}
+
+int main(int argc, const char **argv) {
+  cl::HideUnrelatedOptions(BenchCategory);
+  cl::ParseCommandLineOptions(argc, argv,
+    "Benchmark of the checked-c-convert constraint solver\n");
+
+  if (MinVars < 2 || MaxVars < MinVars || Step < 2) {
+    errs() << "error: need 2 <= -min-vars <= -max-vars and -step >= 2\n";
+    return 1;
+  }
+
+  bool Ran = false;
+  for (const auto &S : AllShapes) {
+    if (!Shapes.empty() &&
+        std::find(Shapes.begin(), Shapes.end(), S.Name) == Shapes.end())
+      continue;
+    Ran = true;
+    for (uint64_t N = MinVars; N <= MaxVars; N *= Step)
+      run(S.Name, S.Gen, N);
+  }
+
+  if (!Ran) {
+    errs() << "error: no known shape given with -shape\n";
+    return 1;
+  }
+  return 0;
+}
@@ -118,6 +118,171 @@ TEST(BasicConstraintTest, equality) {
   EXPECT_TRUE(*env[CS.getVar(1)] == *CS.getWild());
 }
 
+TEST(BasicConstraintTest, chains) {
+  Constraints CS;
+
+  // q_0 = q_1
+  // q_1 = q_2
+  // q_3 = q_2
+  // q_2 = ARR
+  // q_4 = q_0
+  // q_1 = WILD
+  //
+  // should derive the value of q_1 for every variable, whichever side 
+  // of the equalities it is on:
+  // q_0 = q_1 = q_2 = q_3 = q_4 = WILD
+
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(0), CS.getOrCreateVar(1))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(1), CS.getOrCreateVar(2))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(3), CS.getOrCreateVar(2))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(2), CS.getArr())));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(4), CS.getOrCreateVar(0))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(1), CS.getWild())));
+
+  EXPECT_TRUE(CS.solve().second);
+  Constraints::EnvironmentMap env = CS.getVariables();
+
+  for (uint32_t i = 0; i < 5; i++)
+    EXPECT_TRUE(*env[CS.getVar(i)] == *CS.getWild());
+}
+
+TEST(BasicConstraintTest, classes) {
+  Constraints CS;
+
+  // q_0 = q_1
+  // q_2 = q_1
+  // q_3 = WILD
+  // q_3 = WILD => q_2 = WILD
+  // q_4 = q_5
+  // q_5 = q_4
+  //
+  // should derive that the class of q_2 is WILD through the implication,
+  // and leave the other class alone:
+  // q_0 = q_1 = q_2 = q_3 = WILD
+  // q_4 = q_5 = PTR
+
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(0), CS.getOrCreateVar(1))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(2), CS.getOrCreateVar(1))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(3), CS.getWild())));
+  EXPECT_TRUE(CS.addConstraint(CS.createImplies(CS.createEq(CS.getOrCreateVar(3), CS.getWild()),
+                                CS.createEq(CS.getOrCreateVar(2), CS.getWild()))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(4), CS.getOrCreateVar(5))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(5), CS.getOrCreateVar(4))));
+
+  EXPECT_TRUE(CS.solve().second);
+  Constraints::EnvironmentMap env = CS.getVariables();
+
+  for (uint32_t i = 0; i < 4; i++)
+    EXPECT_TRUE(*env[CS.getVar(i)] == *CS.getWild());
+  EXPECT_TRUE(*env[CS.getVar(4)] == *CS.getPtr());
+  EXPECT_TRUE(*env[CS.getVar(5)] == *CS.getPtr());
+}
+
+TEST(BasicConstraintTest, stamps) {
+  Constraints CS;
+  Constraints Other;
+
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(CS.getOrCreateVar(0), CS.getWild())));
+  EXPECT_EQ(CS.getVariables().getStamp(), 0u);
+
+  EXPECT_TRUE(CS.solve().second);
+  uint32_t S1 = CS.getVariables().getStamp();
+  EXPECT_NE(S1, 0u);
+
+  // Adding a variable invalidates the solution.
+  CS.getOrCreateVar(1);
+  EXPECT_EQ(CS.getVariables().getStamp(), 0u);
+
+  EXPECT_TRUE(CS.solve().second);
+  uint32_t S2 = CS.getVariables().getStamp();
+  EXPECT_NE(S2, 0u);
+  EXPECT_NE(S2, S1);
+
+  // Solutions of different constraints get different stamps.
+  Other.getOrCreateVar(0);
+  EXPECT_TRUE(Other.solve().second);
+  EXPECT_NE(Other.getVariables().getStamp(), S2);
+}
+
+TEST(BasicConstraintTest, handles) {
+  Constraints CS;
+  AtomHandle V = AtomHandle::get(CS.getOrCreateVar(7));
+  AtomHandle W = AtomHandle::get(CS.getWild());
+
+  EXPECT_TRUE(V.isVar());
+  EXPECT_EQ(V.getVarNum(), 7u);
+  EXPECT_FALSE(W.isVar());
+  EXPECT_EQ(W.getKind(), Atom::A_Wild);
+  EXPECT_TRUE(V == AtomHandle::getVar(7));
+  EXPECT_TRUE(W != AtomHandle::getConst(Atom::A_Ptr));
+
+  EXPECT_EQ(joinConsts(Atom::A_Ptr, Atom::A_Arr), Atom::A_Arr);
+  EXPECT_EQ(joinConsts(Atom::A_Wild, Atom::A_Arr), Atom::A_Wild);
+  EXPECT_EQ(joinConsts(Atom::A_Ptr, Atom::A_Ptr), Atom::A_Ptr);
+}
+
+TEST(BasicConstraintTest, rounds) {
+  Constraints CS;
+  VarAtom *q_0 = CS.getOrCreateVar(0);
+  VarAtom *q_1 = CS.getOrCreateVar(1);
+  VarAtom *q_2 = CS.getOrCreateVar(2);
+
+  // q_0 = WILD
+  // (q_0 = WILD) => (q_1 = WILD)
+  // (q_1 = WILD) => (q_2 = WILD)
+  EXPECT_TRUE(CS.addConstraint(CS.createImplies(
+    CS.createEq(q_0, CS.getWild()), CS.createEq(q_1, CS.getWild()))));
+  EXPECT_TRUE(CS.addConstraint(CS.createImplies(
+    CS.createEq(q_1, CS.getWild()), CS.createEq(q_2, CS.getWild()))));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(q_0, CS.getWild())));
+  EXPECT_EQ(CS.getNumConstraints(), 3u);
+
+  EXPECT_TRUE(CS.solve().second);
+  const std::vector<Constraints::SolveRound> &Rounds = CS.getSolveRounds();
+  ASSERT_FALSE(Rounds.empty());
+  // Every class is visited in the first round.
+  EXPECT_EQ(Rounds[0].Visited, 3u);
+  uint32_t Raised = 0;
+  for (const auto &R : Rounds)
+    Raised += R.Raised;
+  EXPECT_EQ(Raised, 3u);
+}
+
+TEST(BasicConstraintTest, explain) {
+  Constraints CS;
+  VarAtom *q_0 = CS.getOrCreateVar(0);
+  VarAtom *q_1 = CS.getOrCreateVar(1);
+  VarAtom *q_2 = CS.getOrCreateVar(2);
+  VarAtom *q_3 = CS.getOrCreateVar(3);
+
+  // q_0 = WILD
+  // (q_0 = WILD) => (q_1 = WILD)
+  // q_1 = q_2
+  // NOT(q_3 = PTR)
+  Eq *Root = CS.createEq(q_0, CS.getWild());
+  Implies *Imp = CS.createImplies(CS.createEq(q_0, CS.getWild()),
+                                  CS.createEq(q_1, CS.getWild()));
+  Not *Arr = CS.createNot(CS.createEq(q_3, CS.getPtr()));
+  EXPECT_TRUE(CS.addConstraint(Imp));
+  EXPECT_TRUE(CS.addConstraint(CS.createEq(q_1, q_2)));
+  EXPECT_TRUE(CS.addConstraint(Root));
+  EXPECT_TRUE(CS.addConstraint(Arr));
+  EXPECT_TRUE(CS.solve().second);
+
+  std::vector<Constraint*> E = CS.explain(2);
+  ASSERT_EQ(E.size(), 3u);
+  EXPECT_TRUE(*E[0] == *Imp->getConclusion());
+  EXPECT_EQ(E[1], Imp);
+  EXPECT_EQ(E[2], Root);
+
+  E = CS.explain(3);
+  ASSERT_EQ(E.size(), 1u);
+  EXPECT_EQ(E[0], Arr);
+
+  CS.getOrCreateVar(4);
+  EXPECT_TRUE(CS.explain(4).empty());
+}
+
 TEST(Conflicts, test1) {
   Constraints CS;
 
@@ -9,6 +9,8 @@
 #ifndef _UTILS_H
 #define _UTILS_H
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include "llvm/Support/CommandLine.h"
 #include "PersistentSourceLoc.h"
 
@@ -16,8 +18,11 @@ class ConstraintVariable;
 class ProgramInfo;
 
 // Maps a Decl to the set of constraint variables for that Decl.
-typedef std::map<PersistentSourceLoc, 
-  std::set<ConstraintVariable*>> VariableMap;
+typedef std::unordered_map<PersistentSourceLoc, 
+  std::set<ConstraintVariable*>, PersistentSourceLoc::Hash> VariableMap;
+
+typedef std::unordered_set<PersistentSourceLoc, PersistentSourceLoc::Hash>
+  PersistentSourceLocSet;
 
 // Maps a Decl to the DeclStmt that defines the Decl.
 typedef std::map<clang::Decl*, clang::DeclStmt*> VariableDecltoStmtMap;
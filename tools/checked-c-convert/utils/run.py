@@ -9,6 +9,11 @@ import subprocess
 This tool will invoke checked-c-convert on a compile_commands.json database. 
 It contains some work-arounds for cmake+nmake generated compile_commands.json 
 files, where the files are malformed. 
+
+With --shards N, the constraints are gathered by N converter processes, each
+of which owns every Nth file and writes them to a constraint cache of its 
+own. A last process reads the caches of the shards, then solves the 
+constraints and rewrites the files.
 """
 
 DEFAULT_ARGS = ["-verbose", "-dump-stats", "-extra-arg-before=--driver-mode=cl", "-output-postfix=checked"]
@@ -45,20 +50,62 @@ def runMain(args):
     s.add(os.path.realpath(i['file']))
 
   print s
-  args = []
-  args.append(args.prog_name)
-  args.extend(DEFAULT_ARGS)
-  args.extend(list(s))
+  files = sorted(s)
+
+  if args.shards > 1:
+    caches = runShards(args, files)
+    if caches == None:
+      return
+    cmd = [args.prog_name]
+    cmd.extend(DEFAULT_ARGS)
+    cmd.append("-shard-caches=" + ",".join(caches))
+    cmd.extend(files)
+    subprocess.check_call(cmd)
+    return
+
+  cmd = []
+  cmd.append(args.prog_name)
+  cmd.extend(DEFAULT_ARGS)
+  cmd.extend(files)
   f = open('bla', 'w')
-  f.write(" ".join(args))
+  f.write(" ".join(cmd))
   f.close()
-  subprocess.check_call(args)
+  subprocess.check_call(cmd)
 
   return
 
+def runShards(args, files):
+  """
+  Gather the constraints of files in args.shards processes, which run at 
+  the same time. Returns the constraint caches they wrote, or None if one
+  of them failed.
+  """
+  caches = []
+  procs = []
+  for i in range(args.shards):
+    cache = os.path.join(args.shard_dir, "shard-%d.ccvc" % i)
+    cmd = [args.prog_name, "-extra-arg-before=--driver-mode=cl",
+           "-shard=%d/%d" % (i, args.shards), "-constraint-cache=" + cache]
+    cmd.extend(files)
+    caches.append(cache)
+    procs.append(subprocess.Popen(cmd))
+
+  failed = False
+  for p in procs:
+    if p.wait() != 0:
+      failed = True
+  if failed:
+    print "a shard failed"
+    return None
+  return caches
+
 if __name__ == '__main__':
   parser = argparse.ArgumentParser("runner")
   parser.add_argument("compile_commands", type=str)
   parser.add_argument("prog_name", type=str)
+  parser.add_argument("--shards", type=int, default=1,
+                      help="number of processes to gather constraints in")
+  parser.add_argument("--shard-dir", type=str, default=".",
+                      help="directory for the constraint caches of shards")
   args = parser.parse_args()
   runMain(args)
@@ -0,0 +1,69 @@
+//===- ClangCompdbConvert.cpp ---------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Clang tool which converts a JSON compilation database to the binary format,
+// which clang tools load from 'compile_commands.bin' in the build directory
+// without parsing it.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Tooling/BinaryCompilationDatabase.h"
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/raw_ostream.h"
+#include <string>
+
+using namespace llvm;
+using namespace clang;
+using namespace clang::tooling;
+
+static cl::opt<std::string>
+    InputPath(cl::Positional,
+              cl::desc("<build directory or compile_commands.json>"),
+              cl::Required);
+
+static cl::opt<std::string> OutputFile(
+    "o", cl::desc("Write the binary database to <filename> instead of "
+                  "compile_commands.bin next to the JSON database"),
+    cl::value_desc("filename"));
+
+int main(int argc, const char **argv) {
+  sys::PrintStackTraceOnErrorSignal(argv[0]);
+  cl::ParseCommandLineOptions(argc, argv, "clang-compdb-convert\n");
+
+  SmallString<256> JSONPath(InputPath);
+  if (sys::fs::is_directory(JSONPath))
+    sys::path::append(JSONPath, "compile_commands.json");
+  std::string ErrorMessage;
+  std::unique_ptr<JSONCompilationDatabase> Database =
+      JSONCompilationDatabase::loadFromFile(JSONPath, ErrorMessage,
+                                            JSONCommandLineSyntax::AutoDetect);
+  if (!Database) {
+    errs() << "error: " << ErrorMessage << "\n";
+    return 1;
+  }
+
+  SmallString<256> BinaryPath(OutputFile);
+  if (BinaryPath.empty()) {
+    BinaryPath = sys::path::parent_path(JSONPath);
+    sys::path::append(BinaryPath, "compile_commands.bin");
+  }
+  std::error_code EC;
+  raw_fd_ostream OS(BinaryPath, EC, sys::fs::F_None);
+  if (EC) {
+    errs() << "error: cannot open " << BinaryPath << ": " << EC.message()
+           << "\n";
+    return 1;
+  }
+  OS << BinaryCompilationDatabase::serialize(*Database);
+  return 0;
+}
@@ -58,6 +58,22 @@ static cl::opt<std::string> StopAfter("stop-diff-after",
 static cl::opt<int> MaxSize("s", cl::desc("<maxsize>"), cl::Optional,
                             cl::init(-1), cl::cat(ClangDiffCategory));
 
+static cl::opt<std::string>
+    Matching("matching", cl::desc("<gumtree|linear|auto>"), cl::Optional,
+             cl::init("auto"), cl::cat(ClangDiffCategory));
+
+static cl::opt<int> LinearThreshold(
+    "linear-threshold",
+    cl::desc("With -matching=auto, the number of nodes of the two trees "
+             "above which they are matched in linear time"),
+    cl::Optional, cl::init(100000), cl::cat(ClangDiffCategory));
+
+static cl::opt<unsigned> TimeBudget(
+    "time-budget",
+    cl::desc("With linear matching, the milliseconds after which no more "
+             "optimal mappings are computed"),
+    cl::Optional, cl::init(0), cl::cat(ClangDiffCategory));
+
 static cl::opt<std::string> BuildPath("p", cl::desc("Build path"), cl::init(""),
                                       cl::Optional, cl::cat(ClangDiffCategory));
 
@@ -497,9 +513,21 @@ int main(int argc, const char **argv) {
       return 1;
     }
   }
+  if (Matching == "linear")
+    Options.Mode = diff::MatchingMode::Linear;
+  else if (Matching == "auto")
+    Options.LinearMatchingThreshold = LinearThreshold;
+  else if (Matching != "gumtree") {
+    llvm::errs() << "Error: Invalid argument for -matching\n";
+    return 1;
+  }
+  Options.TimeBudgetMs = TimeBudget;
   diff::SyntaxTree SrcTree(Src->getASTContext());
   diff::SyntaxTree DstTree(Dst->getASTContext());
   diff::ASTDiff Diff(SrcTree, DstTree, Options);
+  if (Diff.getMatchingMode() == diff::MatchingMode::Linear)
+    llvm::errs() << "Note: Matched " << SrcTree.getSize() + DstTree.getSize()
+                 << " nodes in linear time.\n";
 
   if (HtmlDiff) {
     llvm::outs() << HtmlDiffHeader << "<pre>";
@@ -23,6 +23,9 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <thread>
 
 using namespace llvm;
 using clang::tooling::Replacements;
@@ -102,10 +105,23 @@ static cl::opt<bool> SortIncludes(
              "SortIncludes style flag"),
     cl::cat(ClangFormatCategory));
 
+static cl::opt<bool> Incremental(
+    "incremental",
+    cl::desc("Only lex and format the top-level declarations around the\n"
+             "formatted lines. The result is the same as without it."),
+    cl::cat(ClangFormatCategory));
+
 static cl::opt<bool>
     Verbose("verbose", cl::desc("If set, shows the list of processed files"),
             cl::cat(ClangFormatCategory));
 
+static cl::opt<unsigned>
+    Jobs("j",
+         cl::desc("The number of files to format in parallel.\n"
+                  "Set to 0 for hardware concurrency. The output\n"
+                  "is written in the order of the files."),
+         cl::init(1), cl::cat(ClangFormatCategory));
+
 static cl::list<std::string> FileNames(cl::Positional, cl::desc("[<file> ...]"),
                                        cl::cat(ClangFormatCategory));
 
@@ -129,8 +145,8 @@ static bool parseLineRange(StringRef Input, unsigned &FromLine,
          LineRange.second.getAsInteger(0, ToLine);
 }
 
-static bool fillRanges(MemoryBuffer *Code,
-                       std::vector<tooling::Range> &Ranges) {
+static bool fillRanges(MemoryBuffer *Code, std::vector<tooling::Range> &Ranges,
+                       raw_ostream &ErrOS) {
   IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
       new vfs::InMemoryFileSystem);
   FileManager Files(FileSystemOptions(), InMemoryFileSystem);
@@ -142,18 +158,18 @@ static bool fillRanges(MemoryBuffer *Code,
                                  InMemoryFileSystem.get());
   if (!LineRanges.empty()) {
     if (!Offsets.empty() || !Lengths.empty()) {
-      errs() << "error: cannot use -lines with -offset/-length\n";
+      ErrOS << "error: cannot use -lines with -offset/-length\n";
       return true;
     }
 
     for (unsigned i = 0, e = LineRanges.size(); i < e; ++i) {
       unsigned FromLine, ToLine;
       if (parseLineRange(LineRanges[i], FromLine, ToLine)) {
-        errs() << "error: invalid <start line>:<end line> pair\n";
+        ErrOS << "error: invalid <start line>:<end line> pair\n";
         return true;
       }
       if (FromLine > ToLine) {
-        errs() << "error: start line should be less than end line\n";
+        ErrOS << "error: start line should be less than end line\n";
         return true;
       }
       SourceLocation Start = Sources.translateLineCol(ID, FromLine, 1);
@@ -167,16 +183,22 @@ static bool fillRanges(MemoryBuffer *Code,
     return false;
   }
 
+  // Without ranges, the whole file is formatted. The options are not changed,
+  // as files may be formatted on several threads.
+  if (Offsets.empty() && Lengths.empty()) {
+    Ranges.push_back(tooling::Range(0, Code->getBufferSize()));
+    return false;
+  }
   if (Offsets.empty())
     Offsets.push_back(0);
   if (Offsets.size() != Lengths.size() &&
       !(Offsets.size() == 1 && Lengths.empty())) {
-    errs() << "error: number of -offset and -length arguments must match.\n";
+    ErrOS << "error: number of -offset and -length arguments must match.\n";
     return true;
   }
   for (unsigned i = 0, e = Offsets.size(); i != e; ++i) {
     if (Offsets[i] >= Code->getBufferSize()) {
-      errs() << "error: offset " << Offsets[i] << " is outside the file\n";
+      ErrOS << "error: offset " << Offsets[i] << " is outside the file\n";
       return true;
     }
     SourceLocation Start =
@@ -184,9 +206,9 @@ static bool fillRanges(MemoryBuffer *Code,
     SourceLocation End;
     if (i < Lengths.size()) {
       if (Offsets[i] + Lengths[i] > Code->getBufferSize()) {
-        errs() << "error: invalid length " << Lengths[i]
-               << ", offset + length (" << Offsets[i] + Lengths[i]
-               << ") is outside the file.\n";
+        ErrOS << "error: invalid length " << Lengths[i]
+              << ", offset + length (" << Offsets[i] + Lengths[i]
+              << ") is outside the file.\n";
         return true;
       }
       End = Start.getLocWithOffset(Lengths[i]);
@@ -200,48 +222,52 @@ static bool fillRanges(MemoryBuffer *Code,
   return false;
 }
 
-static void outputReplacementXML(StringRef Text) {
+static void outputReplacementXML(StringRef Text, raw_ostream &OS) {
   // FIXME: When we sort includes, we need to make sure the stream is correct
   // utf-8.
   size_t From = 0;
   size_t Index;
   while ((Index = Text.find_first_of("\n\r<&", From)) != StringRef::npos) {
-    outs() << Text.substr(From, Index - From);
+    OS << Text.substr(From, Index - From);
     switch (Text[Index]) {
     case '\n':
-      outs() << "&#10;";
+      OS << "&#10;";
       break;
     case '\r':
-      outs() << "&#13;";
+      OS << "&#13;";
       break;
     case '<':
-      outs() << "&lt;";
+      OS << "&lt;";
       break;
     case '&':
-      outs() << "&amp;";
+      OS << "&amp;";
       break;
     default:
       llvm_unreachable("Unexpected character encountered!");
     }
     From = Index + 1;
   }
-  outs() << Text.substr(From);
+  OS << Text.substr(From);
 }
 
-static void outputReplacementsXML(const Replacements &Replaces) {
+static void outputReplacementsXML(const Replacements &Replaces,
+                                  raw_ostream &OS) {
   for (const auto &R : Replaces) {
-    outs() << "<replacement "
-           << "offset='" << R.getOffset() << "' "
-           << "length='" << R.getLength() << "'>";
-    outputReplacementXML(R.getReplacementText());
-    outs() << "</replacement>\n";
+    OS << "<replacement "
+       << "offset='" << R.getOffset() << "' "
+       << "length='" << R.getLength() << "'>";
+    outputReplacementXML(R.getReplacementText(), OS);
+    OS << "</replacement>\n";
   }
 }
 
+// Formats \p FileName, writing the output to \p OS and the errors to \p ErrOS.
+// The styles loaded from configuration files are shared through \p Cache.
 // Returns true on error.
-static bool format(StringRef FileName) {
+static bool format(StringRef FileName, raw_ostream &OS, raw_ostream &ErrOS,
+                   StyleCache &Cache) {
   if (!OutputXML && Inplace && FileName == "-") {
-    errs() << "error: cannot use -i when reading from stdin.\n";
+    ErrOS << "error: cannot use -i when reading from stdin.\n";
     return false;
   }
   // On Windows, overwriting a file with an open file mapping doesn't work,
@@ -250,21 +276,22 @@ static bool format(StringRef FileName) {
       !OutputXML && Inplace ? MemoryBuffer::getFileAsStream(FileName) :
                               MemoryBuffer::getFileOrSTDIN(FileName);
   if (std::error_code EC = CodeOrErr.getError()) {
-    errs() << EC.message() << "\n";
+    ErrOS << EC.message() << "\n";
     return true;
   }
   std::unique_ptr<llvm::MemoryBuffer> Code = std::move(CodeOrErr.get());
   if (Code->getBufferSize() == 0)
     return false; // Empty files are formatted correctly.
   std::vector<tooling::Range> Ranges;
-  if (fillRanges(Code.get(), Ranges))
+  if (fillRanges(Code.get(), Ranges, ErrOS))
     return true;
   StringRef AssumedFileName = (FileName == "-") ? AssumeFileName : FileName;
 
   llvm::Expected<FormatStyle> FormatStyle =
-      getStyle(Style, AssumedFileName, FallbackStyle, Code->getBuffer());
+      getStyle(Style, AssumedFileName, FallbackStyle, Code->getBuffer(),
+               /*FS=*/nullptr, &Cache);
   if (!FormatStyle) {
-    llvm::errs() << llvm::toString(FormatStyle.takeError()) << "\n";
+    ErrOS << llvm::toString(FormatStyle.takeError()) << "\n";
     return true;
   }
 
@@ -275,29 +302,31 @@ static bool format(StringRef FileName) {
                                        AssumedFileName, &CursorPosition);
   auto ChangedCode = tooling::applyAllReplacements(Code->getBuffer(), Replaces);
   if (!ChangedCode) {
-    llvm::errs() << llvm::toString(ChangedCode.takeError()) << "\n";
+    ErrOS << llvm::toString(ChangedCode.takeError()) << "\n";
     return true;
   }
   // Get new affected ranges after sorting `#includes`.
   Ranges = tooling::calculateRangesAfterReplacements(Replaces, Ranges);
   FormattingAttemptStatus Status;
-  Replacements FormatChanges = reformat(*FormatStyle, *ChangedCode, Ranges,
-                                        AssumedFileName, &Status);
+  Replacements FormatChanges =
+      Incremental ? reformatIncrementally(*FormatStyle, *ChangedCode, Ranges,
+                                          AssumedFileName, &Status)
+                  : reformat(*FormatStyle, *ChangedCode, Ranges,
+                             AssumedFileName, &Status);
   Replaces = Replaces.merge(FormatChanges);
   if (OutputXML) {
-    outs() << "<?xml version='1.0'?>\n<replacements "
-              "xml:space='preserve' incomplete_format='"
-           << (Status.FormatComplete ? "false" : "true") << "'";
+    OS << "<?xml version='1.0'?>\n<replacements "
+          "xml:space='preserve' incomplete_format='"
+       << (Status.FormatComplete ? "false" : "true") << "'";
     if (!Status.FormatComplete)
-      outs() << " line=" << Status.Line;
-    outs() << ">\n";
+      OS << " line=" << Status.Line;
+    OS << ">\n";
     if (Cursor.getNumOccurrences() != 0)
-      outs() << "<cursor>"
-             << FormatChanges.getShiftedCodePosition(CursorPosition)
-             << "</cursor>\n";
+      OS << "<cursor>" << FormatChanges.getShiftedCodePosition(CursorPosition)
+         << "</cursor>\n";
 
-    outputReplacementsXML(Replaces);
-    outs() << "</replacements>\n";
+    outputReplacementsXML(Replaces, OS);
+    OS << "</replacements>\n";
   } else {
     IntrusiveRefCntPtr<vfs::InMemoryFileSystem> InMemoryFileSystem(
         new vfs::InMemoryFileSystem);
@@ -315,15 +344,15 @@ static bool format(StringRef FileName) {
         return true;
     } else {
       if (Cursor.getNumOccurrences() != 0) {
-        outs() << "{ \"Cursor\": "
-               << FormatChanges.getShiftedCodePosition(CursorPosition)
-               << ", \"IncompleteFormat\": "
-               << (Status.FormatComplete ? "false" : "true");
+        OS << "{ \"Cursor\": "
+           << FormatChanges.getShiftedCodePosition(CursorPosition)
+           << ", \"IncompleteFormat\": "
+           << (Status.FormatComplete ? "false" : "true");
         if (!Status.FormatComplete)
-          outs() << ", \"Line\": " << Status.Line;
-        outs() << " }\n";
+          OS << ", \"Line\": " << Status.Line;
+        OS << " }\n";
       }
-      Rewrite.getEditBuffer(ID).write(outs());
+      Rewrite.getEditBuffer(ID).write(OS);
     }
   }
   return false;
@@ -371,8 +400,9 @@ int main(int argc, const char **argv) {
   }
 
   bool Error = false;
+  clang::format::StyleCache Cache;
   if (FileNames.empty()) {
-    Error = clang::format::format("-");
+    Error = clang::format::format("-", outs(), errs(), Cache);
     return Error ? 1 : 0;
   }
   if (FileNames.size() != 1 && (!Offsets.empty() || !Lengths.empty() || !LineRanges.empty())) {
@@ -380,10 +410,45 @@ int main(int argc, const char **argv) {
               "single file.\n";
     return 1;
   }
-  for (const auto &FileName : FileNames) {
-    if (Verbose)
-      errs() << "Formatting " << FileName << "\n";
-    Error |= clang::format::format(FileName);
+  unsigned NumThreads = Jobs;
+  if (NumThreads == 0)
+    NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  if (NumThreads == 1 || FileNames.size() == 1) {
+    for (const auto &FileName : FileNames) {
+      if (Verbose)
+        errs() << "Formatting " << FileName << "\n";
+      Error |= clang::format::format(FileName, outs(), errs(), Cache);
+    }
+    return Error ? 1 : 0;
+  }
+
+  // The output and the errors of each file are buffered, and written once the
+  // files before it are done, so that they are not interleaved.
+  struct FileResult {
+    std::string Output;
+    std::string Errors;
+    bool Error = false;
+  };
+  std::vector<FileResult> Results(FileNames.size());
+  llvm::ThreadPool Pool(NumThreads);
+  std::vector<std::shared_future<void>> Futures;
+  for (unsigned I = 0, E = FileNames.size(); I != E; ++I) {
+    Futures.push_back(Pool.async([&, I]() {
+      FileResult &Result = Results[I];
+      raw_string_ostream OS(Result.Output);
+      raw_string_ostream ErrOS(Result.Errors);
+      if (Verbose)
+        ErrOS << "Formatting " << FileNames[I] << "\n";
+      Result.Error = clang::format::format(FileNames[I], OS, ErrOS, Cache);
+    }));
+  }
+  for (unsigned I = 0, E = FileNames.size(); I != E; ++I) {
+    Futures[I].wait();
+    FileResult Result = std::move(Results[I]);
+    errs() << Result.Errors;
+    outs() << Result.Output;
+    Error |= Result.Error;
   }
+  Pool.wait();
   return Error ? 1 : 0;
 }
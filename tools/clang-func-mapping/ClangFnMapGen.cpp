@@ -8,7 +8,9 @@
 //===--------------------------------------------------------------------===//
 //
 // Clang tool which creates a list of defined functions and the files in which
-// they are defined.
+// they are defined, or a summary of the Checked C bounds of the arguments of
+// the calls in the files. It also converts a merged list to the binary index
+// format.
 //
 //===--------------------------------------------------------------------===//
 
@@ -23,10 +25,14 @@
 #include "clang/Frontend/CompilerInstance.h"
 #include "clang/Frontend/FrontendActions.h"
 #include "clang/Index/USRGeneration.h"
+#include "clang/Sema/Sema.h"
+#include "clang/Sema/SemaConsumer.h"
 #include "clang/Tooling/CommonOptionsParser.h"
 #include "clang/Tooling/Tooling.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
 #include "llvm/Support/Signals.h"
 #include <sstream>
 #include <string>
@@ -39,6 +45,48 @@ using namespace clang::tooling;
 
 static cl::OptionCategory ClangFnMapGenCategory("clang-fnmapgen options");
 
+static cl::opt<bool> BoundsSummary(
+    "bounds-summary",
+    cl::desc("List, for each function called, the smallest number of "
+             "elements that the calls pass for its Checked C array pointer "
+             "parameters, instead of the function definitions"),
+    cl::cat(ClangFnMapGenCategory));
+
+static cl::opt<std::string> BinaryIndex(
+    "binary-index",
+    cl::desc("Convert the given index, which lists the function definitions "
+             "of all the files, to the binary format that the analyzer memory "
+             "maps, instead of listing the definitions in the source files"),
+    cl::value_desc("filename"), cl::cat(ClangFnMapGenCategory));
+
+static cl::opt<std::string> OutputFile(
+    "o", cl::desc("Write the binary index to <filename> instead of standard "
+                  "output"),
+    cl::value_desc("filename"), cl::cat(ClangFnMapGenCategory));
+
+static int convertIndex() {
+  llvm::Expected<llvm::StringMap<std::string>> IndexOrErr =
+      parseCrossTUIndex(BinaryIndex, "");
+  if (!IndexOrErr) {
+    llvm::errs() << "error: " << llvm::toString(IndexOrErr.takeError());
+    return 1;
+  }
+  std::string Buffer = createCrossTUBinaryIndex(*IndexOrErr);
+  if (OutputFile.empty() || OutputFile == "-") {
+    sys::ChangeStdoutToBinary();
+    llvm::outs() << Buffer;
+    return 0;
+  }
+  std::error_code EC;
+  llvm::raw_fd_ostream OS(OutputFile, EC, sys::fs::F_None);
+  if (EC) {
+    llvm::errs() << "error: " << OutputFile << ": " << EC.message() << '\n';
+    return 1;
+  }
+  OS << Buffer;
+  return 0;
+}
+
 class MapFunctionNamesConsumer : public ASTConsumer {
 public:
   MapFunctionNamesConsumer(ASTContext &Context) : Ctx(Context) {}
@@ -94,10 +142,31 @@ void MapFunctionNamesConsumer::handleDecl(const Decl *D) {
       handleDecl(D);
 }
 
+class BoundsSummaryConsumer : public SemaConsumer {
+public:
+  void InitializeSema(Sema &S) override { SemaRef = &S; }
+
+  void HandleTranslationUnit(ASTContext &Ctx) override {
+    if (SemaRef && SemaRef->CallBoundsSummary)
+      llvm::outs() << createBoundsSummaryString(*SemaRef->CallBoundsSummary);
+  }
+
+private:
+  Sema *SemaRef = nullptr;
+};
+
 class MapFunctionNamesAction : public ASTFrontendAction {
 protected:
+  bool BeginSourceFileAction(CompilerInstance &CI) override {
+    if (BoundsSummary)
+      CI.getLangOpts().CheckedCBoundsSummary = true;
+    return true;
+  }
+
   std::unique_ptr<ASTConsumer> CreateASTConsumer(CompilerInstance &CI,
                                                  llvm::StringRef) {
+    if (BoundsSummary)
+      return llvm::make_unique<BoundsSummaryConsumer>();
     std::unique_ptr<ASTConsumer> PFC(
         new MapFunctionNamesConsumer(CI.getASTContext()));
     return PFC;
@@ -113,9 +182,14 @@ int main(int argc, const char **argv) {
 
   const char *Overview = "\nThis tool collects the USR name and location "
                          "of all functions definitions in the source files "
-                         "(excluding headers).\n";
+                         "(excluding headers), or with -bounds-summary the "
+                         "Checked C bounds of the arguments of the calls in "
+                         "them. With -binary-index, it converts a merged "
+                         "list to the binary index format.\n";
   CommonOptionsParser OptionsParser(argc, argv, ClangFnMapGenCategory,
                                     cl::ZeroOrMore, Overview);
+  if (!BinaryIndex.empty())
+    return convertIndex();
 
   ClangTool Tool(OptionsParser.getCompilations(),
                  OptionsParser.getSourcePathList());
@@ -0,0 +1,189 @@
+//===- IdentifierBench.cpp - Benchmark of the identifier table ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// A benchmark of IdentifierTable, which the lexer goes through for each
+// occurrence of every identifier. It prints one line of JSON per phase with
+// the time taken and the number of lookups per second, so that runs can be
+// compared across changes to the table.
+//
+// The phases are:
+//  create   - creating tables for Checked C, which used to add all the
+//             keywords up front.
+//  new      - looking up distinct identifiers in a fresh table, each of
+//             which is created and classified.
+//  warm     - looking up the same identifiers again.
+//  keywords - looking up all the keywords of TokenKinds.def in a fresh
+//             table, then again in the same table.
+//  mixed    - looking up a stream of identifiers and keywords, a third of
+//             them keywords, as in C source.
+//===----------------------------------------------------------------------===//
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace clang;
+using namespace llvm;
+
+static cl::OptionCategory BenchCategory("clang-identifier-bench options");
+
+static cl::opt<unsigned> NumIdentifiers("identifiers",
+  cl::desc("Number of distinct identifiers to look up"),
+  cl::init(100000), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> NumLookups("lookups",
+  cl::desc("Number of lookups in the mixed phase"),
+  cl::init(10000000), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> NumTables("tables",
+  cl::desc("Number of tables created in the create phase"),
+  cl::init(1000), cl::cat(BenchCategory));
+
+static cl::opt<unsigned> Repeat("repeat",
+  cl::desc("Number of times to run each phase; the fastest is reported"),
+  cl::init(3), cl::cat(BenchCategory));
+
+static const char *const Keywords[] = {
+#define KEYWORD(NAME, FLAGS) #NAME,
+#define ALIAS(NAME, TOK, FLAGS) NAME,
+#include "clang/Basic/TokenKinds.def"
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point Start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - Start)
+    .count();
+}
+
+static LangOptions getLangOpts() {
+  LangOptions LangOpts;
+  LangOpts.C99 = true;
+  LangOpts.C11 = true;
+  LangOpts.GNUKeywords = true;
+  LangOpts.CheckedC = true;
+  return LangOpts;
+}
+
+// Names with the lengths and prefixes of the names of C programs.
+static std::vector<std::string> makeIdentifiers(unsigned N) {
+  static const char *const Prefixes[] = {
+    "", "p", "buf_", "num", "get_", "set_", "__", "is", "cur", "tmp_",
+  };
+  std::vector<std::string> Names;
+  Names.reserve(N);
+  for (unsigned I = 0; I < N; ++I)
+    Names.push_back(std::string(Prefixes[I % 10]) + "id" + std::to_string(I));
+  return Names;
+}
+
+// Runs Phase -repeat times, and prints the fastest run, which did
+// NumLookups lookups.
+template <typename PhaseT>
+static void run(const char *Name, uint64_t Lookups, PhaseT Phase) {
+  double BestMs = 0;
+  unsigned Checksum = 0;
+  for (unsigned R = 0; R < std::max(Repeat.getValue(), 1u); ++R) {
+    Clock::time_point Start = Clock::now();
+    Checksum = Phase();
+    double Ms = msSince(Start);
+    if (R == 0 || Ms < BestMs)
+      BestMs = Ms;
+  }
+
+  outs() << "{\"phase\": \"" << Name << "\""
+         << ", \"lookups\": " << Lookups
+         << ", \"ms\": " << format("%.3f", BestMs)
+         << ", \"ns_per_lookup\": "
+         << format("%.2f", Lookups ? BestMs * 1e6 / Lookups : 0.0)
+         << ", \"lookups_per_s\": "
+         << format("%.0f", BestMs > 0 ? Lookups * 1e3 / BestMs : 0.0)
+         << ", \"checksum\": " << Checksum << "}\n";
+  outs().flush();
+}
+
+int main(int argc, const char **argv) {
+  cl::HideUnrelatedOptions(BenchCategory);
+  cl::ParseCommandLineOptions(argc, argv,
+    "Benchmark of the identifier table\n");
+
+  if (NumIdentifiers == 0 || NumLookups == 0) {
+    errs() << "error: need -identifiers and -lookups to be positive\n";
+    return 1;
+  }
+
+  LangOptions LangOpts = getLangOpts();
+  std::vector<std::string> Names = makeIdentifiers(NumIdentifiers);
+  const size_t NumKeywords = sizeof(Keywords) / sizeof(Keywords[0]);
+
+  // The checksums depend on the results of the lookups, so that they are
+  // not optimized away.
+  run("create", NumTables, [&] {
+    unsigned Sum = 0;
+    for (unsigned I = 0; I < NumTables; ++I) {
+      IdentifierTable Table(LangOpts);
+      Sum += Table.get("int").getTokenID();
+    }
+    return Sum;
+  });
+
+  run("new", Names.size(), [&] {
+    IdentifierTable Table(LangOpts);
+    unsigned Sum = 0;
+    for (const std::string &Name : Names)
+      Sum += Table.get(Name).getTokenID();
+    return Sum;
+  });
+
+  IdentifierTable Warm(LangOpts);
+  for (const std::string &Name : Names)
+    Warm.get(Name);
+  run("warm", Names.size(), [&] {
+    unsigned Sum = 0;
+    for (const std::string &Name : Names)
+      Sum += Warm.get(Name).getTokenID();
+    return Sum;
+  });
+
+  run("keywords", 2 * NumKeywords, [&] {
+    IdentifierTable Table(LangOpts);
+    unsigned Sum = 0;
+    for (unsigned Pass = 0; Pass < 2; ++Pass)
+      for (const char *Keyword : Keywords)
+        Sum += Table.get(Keyword).getTokenID();
+    return Sum;
+  });
+
+  // Tokens of the stream are picked with a linear congruential generator,
+  // so that the stream is the same on every run.
+  std::vector<StringRef> Stream;
+  unsigned StreamSize = std::min(NumLookups.getValue(), 1u << 20);
+  Stream.reserve(StreamSize);
+  uint32_t Seed = 1;
+  for (unsigned I = 0; I < StreamSize; ++I) {
+    Seed = Seed * 1664525u + 1013904223u;
+    if (Seed % 3 == 0)
+      Stream.push_back(Keywords[(Seed >> 8) % NumKeywords]);
+    else
+      Stream.push_back(Names[(Seed >> 8) % Names.size()]);
+  }
+  run("mixed", NumLookups, [&] {
+    IdentifierTable Table(LangOpts);
+    unsigned Sum = 0;
+    for (unsigned I = 0; I < NumLookups; ++I)
+      Sum += Table.get(Stream[I % Stream.size()]).getTokenID();
+    return Sum;
+  });
+  return 0;
+}
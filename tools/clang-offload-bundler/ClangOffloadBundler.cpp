@@ -17,6 +17,7 @@
 
 #include "clang/Basic/Version.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
@@ -37,6 +38,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Signals.h"
@@ -130,6 +132,44 @@ static bool hasHostKind(StringRef Target) {
   return OffloadKind == "host";
 }
 
+/// The size of the chunks in which bundles are copied between files, so that
+/// a bundle never needs to be in memory as a whole.
+static const uint64_t CopyChunkSize = 1 << 20;
+
+/// Copy \a Size bytes at offset \a Offset of the file \a FileName, open as
+/// \a FD, to \a OS, a chunk at a time. Return true if an error was found.
+static bool CopyFileSlice(raw_fd_ostream &OS, int FD, StringRef FileName,
+                          uint64_t Offset, uint64_t Size) {
+  while (Size) {
+    uint64_t ChunkSize = std::min(Size, CopyChunkSize);
+    ErrorOr<std::unique_ptr<MemoryBuffer>> ChunkOrErr =
+        MemoryBuffer::getOpenFileSlice(FD, FileName, ChunkSize, Offset);
+    if (std::error_code EC = ChunkOrErr.getError()) {
+      errs() << "error: Can't read file " << FileName << ": " << EC.message()
+             << "\n";
+      return true;
+    }
+    OS.write(ChunkOrErr.get()->getBufferStart(), ChunkSize);
+    Offset += ChunkSize;
+    Size -= ChunkSize;
+  }
+  return false;
+}
+
+/// Copy the first \a Size bytes of the file \a FileName to \a OS. Return true
+/// if an error was found.
+static bool CopyFile(raw_fd_ostream &OS, StringRef FileName, uint64_t Size) {
+  int FD;
+  if (std::error_code EC = sys::fs::openFileForRead(FileName, FD)) {
+    errs() << "error: Can't open file " << FileName << ": " << EC.message()
+           << "\n";
+    return true;
+  }
+  bool Error = CopyFileSlice(OS, FD, FileName, 0, Size);
+  sys::Process::SafelyCloseFileDescriptor(FD);
+  return Error;
+}
+
 /// Generic file handler interface.
 class FileHandler {
 public:
@@ -168,6 +208,24 @@ public:
 
   /// Write the bundle from \a Input into \a OS.
   virtual void WriteBundle(raw_fd_ostream &OS, MemoryBuffer &Input) = 0;
+
+  /// Return true if the bundles are stored as they are, at offsets that only
+  /// depend on the sizes of the inputs. The bundles are then copied between
+  /// files a chunk at a time, using WriteHeaderForSizes and GetBundleRange,
+  /// instead of WriteBundle and ReadBundle.
+  virtual bool CanStream() { return false; }
+
+  /// Write the header of the bundled file to \a OS for inputs of the sizes
+  /// \a InputSizes.
+  virtual void WriteHeaderForSizes(raw_fd_ostream &OS,
+                                   ArrayRef<uint64_t> InputSizes) {
+    llvm_unreachable("The handler can't stream.");
+  }
+
+  /// Return the offset and the size of the current bundle in the bundled file.
+  virtual std::pair<uint64_t, uint64_t> GetBundleRange() {
+    llvm_unreachable("The handler can't stream.");
+  }
 };
 
 /// Handler for binary files. The bundled file will have the following format
@@ -325,6 +383,14 @@ public:
 
   void WriteHeader(raw_fd_ostream &OS,
                    ArrayRef<std::unique_ptr<MemoryBuffer>> Inputs) final {
+    std::vector<uint64_t> InputSizes;
+    for (auto &MB : Inputs)
+      InputSizes.push_back(MB->getBufferSize());
+    WriteHeaderForSizes(OS, InputSizes);
+  }
+
+  void WriteHeaderForSizes(raw_fd_ostream &OS,
+                           ArrayRef<uint64_t> InputSizes) final {
     // Compute size of the header.
     uint64_t HeaderSize = 0;
 
@@ -343,12 +409,12 @@ public:
 
     unsigned Idx = 0;
     for (auto &T : TargetNames) {
-      MemoryBuffer &MB = *Inputs[Idx++].get();
+      uint64_t Size = InputSizes[Idx++];
       // Bundle offset.
       Write8byteIntegerToBuffer(OS, HeaderSize);
       // Size of the bundle (adds to the next bundle's offset)
-      Write8byteIntegerToBuffer(OS, MB.getBufferSize());
-      HeaderSize += MB.getBufferSize();
+      Write8byteIntegerToBuffer(OS, Size);
+      HeaderSize += Size;
       // Size of the triple
       Write8byteIntegerToBuffer(OS, T.size());
       // Triple
@@ -365,6 +431,14 @@ public:
   void WriteBundle(raw_fd_ostream &OS, MemoryBuffer &Input) final {
     OS.write(Input.getBufferStart(), Input.getBufferSize());
   }
+
+  bool CanStream() final { return true; }
+
+  std::pair<uint64_t, uint64_t> GetBundleRange() final {
+    assert(CurBundleInfo != BundlesInfo.end() && "Invalid reader info!");
+    return std::make_pair(CurBundleInfo->second.Offset,
+                          CurBundleInfo->second.Size);
+  }
 };
 
 /// Handler for object files. The bundles are organized by sections with a
@@ -770,12 +844,68 @@ static bool BundleFiles() {
     return true;
   }
 
+  // Open the host input, which the handler is chosen from. It is mapped
+  // rather than read where possible, so that only the parts of it that the
+  // handler looks at are loaded.
+  assert(HostInputIndex != ~0u && "Host input index undefined??");
+  StringRef HostInputName = InputFileNames[HostInputIndex];
+  ErrorOr<std::unique_ptr<MemoryBuffer>> HostOrErr =
+      MemoryBuffer::getFileOrSTDIN(HostInputName, /*FileSize=*/-1,
+                                   /*RequiresNullTerminator=*/false);
+  if (std::error_code EC = HostOrErr.getError()) {
+    errs() << "error: Can't open file " << HostInputName << ": "
+           << EC.message() << "\n";
+    return true;
+  }
+
+  // Get the file handler. We use the host buffer as reference.
+  std::unique_ptr<FileHandler> FH;
+  FH.reset(CreateFileHandler(*HostOrErr.get()));
+
+  // Quit if we don't have a handler.
+  if (!FH.get())
+    return true;
+
+  // If the handler can stream, compute the offsets of the bundles from the
+  // sizes of the inputs, and copy the inputs a chunk at a time, so that they
+  // are never in memory as a whole.
+  if (FH.get()->CanStream() &&
+      std::find(InputFileNames.begin(), InputFileNames.end(), "-") ==
+          InputFileNames.end()) {
+    std::vector<uint64_t> InputSizes;
+    for (auto &I : InputFileNames) {
+      uint64_t Size;
+      if (std::error_code EC = sys::fs::file_size(I, Size)) {
+        errs() << "error: Can't open file " << I << ": " << EC.message()
+               << "\n";
+        return true;
+      }
+      InputSizes.push_back(Size);
+    }
+
+    FH.get()->WriteHeaderForSizes(OutputFile, InputSizes);
+    unsigned Idx = 0;
+    for (auto &Triple : TargetNames) {
+      FH.get()->WriteBundleStart(OutputFile, Triple);
+      if (CopyFile(OutputFile, InputFileNames[Idx], InputSizes[Idx]))
+        return true;
+      if (FH.get()->WriteBundleEnd(OutputFile, Triple))
+        return true;
+      ++Idx;
+    }
+    return false;
+  }
+
   // Open input files.
   std::vector<std::unique_ptr<MemoryBuffer>> InputBuffers(
       InputFileNames.size());
 
   unsigned Idx = 0;
   for (auto &I : InputFileNames) {
+    if (Idx == HostInputIndex) {
+      InputBuffers[Idx++] = std::move(HostOrErr.get());
+      continue;
+    }
     ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
         MemoryBuffer::getFileOrSTDIN(I);
     if (std::error_code EC = CodeOrErr.getError()) {
@@ -785,15 +915,6 @@ static bool BundleFiles() {
     InputBuffers[Idx++] = std::move(CodeOrErr.get());
   }
 
-  // Get the file handler. We use the host buffer as reference.
-  assert(HostInputIndex != ~0u && "Host input index undefined??");
-  std::unique_ptr<FileHandler> FH;
-  FH.reset(CreateFileHandler(*InputBuffers[HostInputIndex].get()));
-
-  // Quit if we don't have a handler.
-  if (!FH.get())
-    return true;
-
   // Write header.
   FH.get()->WriteHeader(OutputFile, InputBuffers);
 
@@ -812,12 +933,15 @@ static bool BundleFiles() {
 
 // Unbundle the files. Return true if an error was found.
 static bool UnbundleFiles() {
-  // Open Input file.
+  // Open Input file. It is mapped rather than read where possible, so that
+  // only the parts of it that the handler looks at are loaded.
+  StringRef InputName = InputFileNames.front();
   ErrorOr<std::unique_ptr<MemoryBuffer>> CodeOrErr =
-      MemoryBuffer::getFileOrSTDIN(InputFileNames.front());
+      MemoryBuffer::getFileOrSTDIN(InputName, /*FileSize=*/-1,
+                                   /*RequiresNullTerminator=*/false);
   if (std::error_code EC = CodeOrErr.getError()) {
-    errs() << "error: Can't open file " << InputFileNames.front() << ": "
-           << EC.message() << "\n";
+    errs() << "error: Can't open file " << InputName << ": " << EC.message()
+           << "\n";
     return true;
   }
 
@@ -831,6 +955,21 @@ static bool UnbundleFiles() {
   if (!FH.get())
     return true;
 
+  // If the handler can stream, the bundles are copied from the file a chunk
+  // at a time, rather than through the mapping of the whole file.
+  int InputFD = -1;
+  if (FH.get()->CanStream() && InputName != "-") {
+    if (std::error_code EC = sys::fs::openFileForRead(InputName, InputFD)) {
+      errs() << "error: Can't open file " << InputName << ": " << EC.message()
+             << "\n";
+      return true;
+    }
+  }
+  auto CloseInput = make_scope_exit([&] {
+    if (InputFD != -1)
+      sys::Process::SafelyCloseFileDescriptor(InputFD);
+  });
+
   // Read the header of the bundled file.
   FH.get()->ReadHeader(Input);
 
@@ -867,7 +1006,13 @@ static bool UnbundleFiles() {
              << EC.message() << "\n";
       return true;
     }
-    FH.get()->ReadBundle(OutputFile, Input);
+    if (InputFD != -1) {
+      std::pair<uint64_t, uint64_t> Range = FH.get()->GetBundleRange();
+      if (CopyFileSlice(OutputFile, InputFD, InputName, Range.first,
+                        Range.second))
+        return true;
+    } else
+      FH.get()->ReadBundle(OutputFile, Input);
     FH.get()->ReadBundleEnd(Input);
     Worklist.erase(Output);
 
@@ -889,8 +1034,13 @@ static bool UnbundleFiles() {
       }
 
       // If this entry has a host kind, copy the input file to the output file.
-      if (hasHostKind(E.first()))
-        OutputFile.write(Input.getBufferStart(), Input.getBufferSize());
+      if (hasHostKind(E.first())) {
+        if (InputFD == -1)
+          OutputFile.write(Input.getBufferStart(), Input.getBufferSize());
+        else if (CopyFileSlice(OutputFile, InputFD, InputName, 0,
+                               Input.getBufferSize()))
+          return true;
+      }
     }
     return false;
   }
@@ -0,0 +1,184 @@
+//===- DiagnosticTable.cpp - diagtool tools for diagnostic tables ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "DiagTool.h"
+#include "clang/Frontend/SerializedDiagnosticTable.h"
+#include "clang/Frontend/SerializedDiagnostics.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <algorithm>
+#include <iterator>
+
+DEF_DIAGTOOL("aggregate-diagnostics",
+             "Aggregate serialized diagnostics files into a diagnostic table",
+             AggregateDiagnostics)
+
+DEF_DIAGTOOL("dump-diagnostic-table",
+             "Print the diagnostics of a diagnostic table", DumpDiagnosticTable)
+
+using namespace clang;
+using namespace diagtool;
+
+int AggregateDiagnostics::run(unsigned int argc, char **argv,
+                              llvm::raw_ostream &OS) {
+  static llvm::cl::OptionCategory AggregateDiagnosticsOptions(
+      "diagtool aggregate-diagnostics options");
+
+  static llvm::cl::opt<std::string> OutputFile(
+      "o", llvm::cl::desc("The diagnostic table to write"),
+      llvm::cl::value_desc("filename"), llvm::cl::Required,
+      llvm::cl::cat(AggregateDiagnosticsOptions));
+
+  static llvm::cl::opt<std::string> InputList(
+      "inputs-from",
+      llvm::cl::desc("A file listing serialized diagnostics files, one per "
+                     "line, to add after the positional ones"),
+      llvm::cl::value_desc("filename"),
+      llvm::cl::cat(AggregateDiagnosticsOptions));
+
+  static llvm::cl::list<std::string> Inputs(
+      llvm::cl::Positional, llvm::cl::desc("<file.dia> ..."),
+      llvm::cl::cat(AggregateDiagnosticsOptions));
+
+  std::vector<const char *> Args;
+  Args.push_back("diagtool aggregate-diagnostics");
+  for (const char *A : llvm::makeArrayRef(argv, argc))
+    Args.push_back(A);
+
+  llvm::cl::HideUnrelatedOptions(AggregateDiagnosticsOptions);
+  llvm::cl::ParseCommandLineOptions((int)Args.size(), Args.data(),
+                                    "Serialized diagnostics aggregator");
+
+  std::vector<std::string> Files(Inputs.begin(), Inputs.end());
+  if (!InputList.empty()) {
+    auto ListOrErr = llvm::MemoryBuffer::getFileOrSTDIN(InputList);
+    if (std::error_code EC = ListOrErr.getError()) {
+      llvm::errs() << "error: cannot read '" << InputList
+                   << "': " << EC.message() << '\n';
+      return 1;
+    }
+    SmallVector<StringRef, 16> Lines;
+    (*ListOrErr)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                    /*KeepEmpty=*/false);
+    for (StringRef Line : Lines) {
+      Line = Line.trim();
+      if (!Line.empty())
+        Files.push_back(Line);
+    }
+  }
+
+  // A file which cannot be read is reported, and the others are still added.
+  serialized_diags::DiagnosticTableBuilder Builder;
+  bool Failed = false;
+  for (const std::string &File : Files) {
+    if (std::error_code EC = Builder.addSerializedDiagnostics(File)) {
+      llvm::errs() << "error: cannot read '" << File << "': " << EC.message()
+                   << '\n';
+      Failed = true;
+    }
+  }
+
+  std::error_code EC;
+  llvm::raw_fd_ostream Out(OutputFile, EC, llvm::sys::fs::F_None);
+  if (EC) {
+    llvm::errs() << "error: cannot write '" << OutputFile
+                 << "': " << EC.message() << '\n';
+    return 1;
+  }
+  Out << Builder.serialize();
+  return Failed ? 1 : 0;
+}
+
+static StringRef getSeverityName(unsigned Severity) {
+  switch (Severity) {
+  case serialized_diags::Ignored:
+    return "ignored";
+  case serialized_diags::Note:
+    return "note";
+  case serialized_diags::Warning:
+    return "warning";
+  case serialized_diags::Error:
+    return "error";
+  case serialized_diags::Fatal:
+    return "fatal error";
+  case serialized_diags::Remark:
+    return "remark";
+  }
+  return "unknown";
+}
+
+int DumpDiagnosticTable::run(unsigned int argc, char **argv,
+                             llvm::raw_ostream &OS) {
+  static llvm::cl::OptionCategory DumpDiagnosticTableOptions(
+      "diagtool dump-diagnostic-table options");
+
+  static llvm::cl::opt<std::string> TableFile(
+      llvm::cl::Positional, llvm::cl::desc("<table>"), llvm::cl::Required,
+      llvm::cl::cat(DumpDiagnosticTableOptions));
+
+  static llvm::cl::opt<std::string> FileFilter(
+      "file", llvm::cl::desc("Only print the diagnostics in this file"),
+      llvm::cl::cat(DumpDiagnosticTableOptions));
+
+  static llvm::cl::opt<std::string> FlagFilter(
+      "flag",
+      llvm::cl::desc("Only print the diagnostics of this warning option, "
+                     "without the leading -W"),
+      llvm::cl::cat(DumpDiagnosticTableOptions));
+
+  std::vector<const char *> Args;
+  Args.push_back("diagtool dump-diagnostic-table");
+  for (const char *A : llvm::makeArrayRef(argv, argc))
+    Args.push_back(A);
+
+  llvm::cl::HideUnrelatedOptions(DumpDiagnosticTableOptions);
+  llvm::cl::ParseCommandLineOptions((int)Args.size(), Args.data(),
+                                    "Diagnostic table printer");
+
+  std::string ErrorMessage;
+  using serialized_diags::DiagnosticTable;
+  std::unique_ptr<DiagnosticTable> Table =
+      DiagnosticTable::loadFromFile(TableFile, ErrorMessage);
+  if (!Table) {
+    llvm::errs() << "error: " << ErrorMessage << '\n';
+    return 1;
+  }
+
+  std::vector<unsigned> Indices;
+  if (FileFilter.getNumOccurrences() != 0) {
+    Indices = Table->getDiagnosticsInFile(FileFilter);
+    if (FlagFilter.getNumOccurrences() != 0) {
+      std::vector<unsigned> WithFlag =
+          Table->getDiagnosticsWithFlag(FlagFilter);
+      std::vector<unsigned> Both;
+      std::set_intersection(Indices.begin(), Indices.end(), WithFlag.begin(),
+                            WithFlag.end(), std::back_inserter(Both));
+      Indices = std::move(Both);
+    }
+  } else if (FlagFilter.getNumOccurrences() != 0) {
+    Indices = Table->getDiagnosticsWithFlag(FlagFilter);
+  } else {
+    for (unsigned I = 0, E = Table->getNumDiagnostics(); I != E; ++I)
+      Indices.push_back(I);
+  }
+
+  for (unsigned Index : Indices) {
+    DiagnosticTable::Entry Diag = Table->getDiagnostic(Index);
+    OS << Diag.Compilation << ": ";
+    if (!Diag.Filename.empty())
+      OS << Diag.Filename << ':' << Diag.Line << ':' << Diag.Column << ": ";
+    OS << getSeverityName(Diag.Severity) << ": " << Diag.Message;
+    if (!Diag.Flag.empty())
+      OS << " [-W" << Diag.Flag << ']';
+    OS << '\n';
+  }
+  OS << "Number of diagnostics: " << Indices.size() << '\n';
+  return 0;
+}
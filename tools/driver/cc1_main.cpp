@@ -14,6 +14,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Option/Arg.h"
+#include "clang/Basic/TimeTrace.h"
 #include "clang/CodeGen/ObjectFilePCHContainerOperations.h"
 #include "clang/Config/config.h"
 #include "clang/Driver/DriverDiagnostic.h"
@@ -29,14 +30,22 @@
 #include "llvm/LinkAllPasses.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptTable.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/RWMutex.h"
 #include "llvm/Support/Signals.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cstdio>
+#include <mutex>
+#include <vector>
 
 #ifdef CLANG_HAVE_RLIMITS
 #include <sys/resource.h>
@@ -167,18 +176,7 @@ static void ensureSufficientStack() {
 static void ensureSufficientStack() {}
 #endif
 
-int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
-  ensureSufficientStack();
-
-  std::unique_ptr<CompilerInstance> Clang(new CompilerInstance());
-  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
-
-  // Register the support for object-file-wrapped Clang modules.
-  auto PCHOps = Clang->getPCHContainerOperations();
-  PCHOps->registerWriter(llvm::make_unique<ObjectFilePCHContainerWriter>());
-  PCHOps->registerReader(llvm::make_unique<ObjectFilePCHContainerReader>());
-
-  // Initialize targets first, so that --version shows registered targets.
+static void initializeTargets() {
   llvm::InitializeAllTargets();
   llvm::InitializeAllTargetMCs();
   llvm::InitializeAllAsmPrinters();
@@ -188,6 +186,44 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   llvm::PassRegistry &Registry = *llvm::PassRegistry::getPassRegistry();
   polly::initializePollyPasses(Registry);
 #endif
+}
+
+/// Get the builtin include path, which only depends on where the running
+/// executable is.
+static const std::string &getResourcesPath(const char *Argv0,
+                                           void *MainAddr) {
+  static const std::string Path =
+      CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
+  return Path;
+}
+
+namespace {
+/// State shared by the invocations of a -cc1batch run.
+struct BatchContext {
+  /// Held for writing by the invocations that set LLVM options, which are
+  /// global, and for reading by the others, which only use them.
+  llvm::sys::RWMutex LLVMOptionsLock;
+
+  /// Whether invocations run concurrently. If so, they don't install the
+  /// fatal error handler, which is global too.
+  bool Concurrent = false;
+};
+} // end anonymous namespace
+
+/// Run one -cc1 invocation. If it is part of the batch \p Batch, the
+/// compiler instance is destroyed even under -disable-free, because the
+/// process goes on to run other invocations. Diagnostics are printed to
+/// \p DiagOS if it is given, and to stderr otherwise.
+static int runInvocation(ArrayRef<const char *> Argv, const char *Argv0,
+                         void *MainAddr, BatchContext *Batch = nullptr,
+                         raw_ostream *DiagOS = nullptr) {
+  std::unique_ptr<CompilerInstance> Clang(new CompilerInstance());
+  IntrusiveRefCntPtr<DiagnosticIDs> DiagID(new DiagnosticIDs());
+
+  // Register the support for object-file-wrapped Clang modules.
+  auto PCHOps = Clang->getPCHContainerOperations();
+  PCHOps->registerWriter(llvm::make_unique<ObjectFilePCHContainerWriter>());
+  PCHOps->registerReader(llvm::make_unique<ObjectFilePCHContainerReader>());
 
   // Buffer diagnostics from argument parsing so that we can output them using a
   // well formed diagnostic object.
@@ -201,24 +237,75 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   if (Clang->getHeaderSearchOpts().UseBuiltinIncludes &&
       Clang->getHeaderSearchOpts().ResourceDir.empty())
     Clang->getHeaderSearchOpts().ResourceDir =
-      CompilerInvocation::GetResourcesPath(Argv0, MainAddr);
+      getResourcesPath(Argv0, MainAddr);
 
   // Create the actual diagnostics engine.
-  Clang->createDiagnostics();
+  if (DiagOS)
+    Clang->createDiagnostics(
+        new TextDiagnosticPrinter(*DiagOS, &Clang->getDiagnosticOpts()));
+  else
+    Clang->createDiagnostics();
   if (!Clang->hasDiagnostics())
     return 1;
 
   // Set an error handler, so that any LLVM backend diagnostics go through our
   // error handler.
-  llvm::install_fatal_error_handler(LLVMErrorHandler,
-                                  static_cast<void*>(&Clang->getDiagnostics()));
+  bool InstallErrorHandler = !Batch || !Batch->Concurrent;
+  if (InstallErrorHandler)
+    llvm::install_fatal_error_handler(
+        LLVMErrorHandler, static_cast<void *>(&Clang->getDiagnostics()));
 
   DiagsBuffer->FlushDiagnostics(Clang->getDiagnostics());
-  if (!Success)
+  if (!Success) {
+    if (InstallErrorHandler)
+      llvm::remove_fatal_error_handler();
     return 1;
+  }
+
+  // In a batch, an invocation that sets LLVM options runs alone, and starts
+  // and ends with the options at their defaults.
+  const CodeGenOptions &CGOpts = Clang->getCodeGenOpts();
+  bool SetsLLVMOptions = !Clang->getFrontendOpts().LLVMArgs.empty() ||
+                         !CGOpts.DebugPass.empty() ||
+                         !CGOpts.LimitFloatPrecision.empty() ||
+                         !CGOpts.BackendOptions.empty();
+  Optional<llvm::sys::ScopedReader> SharedOptions;
+  Optional<llvm::sys::ScopedWriter> ExclusiveOptions;
+  if (Batch && SetsLLVMOptions) {
+    ExclusiveOptions.emplace(Batch->LLVMOptionsLock);
+    llvm::cl::ResetAllOptionOccurrences();
+  } else if (Batch) {
+    SharedOptions.emplace(Batch->LLVMOptionsLock);
+  }
+
+  const FrontendOptions &FEOpts = Clang->getFrontendOpts();
+  if (FEOpts.TimeTrace)
+    timeTraceProfilerInitialize(FEOpts.TimeTraceGranularity);
 
   // Execute the frontend actions.
-  Success = ExecuteCompilerInvocation(Clang.get());
+  {
+    TimeTraceScope TimeScope("ExecuteCompiler");
+    Success = ExecuteCompilerInvocation(Clang.get());
+  }
+
+  if (FEOpts.TimeTrace) {
+    // Write the trace next to the output, or in the current directory when
+    // the output goes to stdout.
+    SmallString<128> Path;
+    if (!FEOpts.OutputFile.empty() && FEOpts.OutputFile != "-")
+      Path = FEOpts.OutputFile;
+    else if (!FEOpts.Inputs.empty() && FEOpts.Inputs[0].isFile())
+      Path = llvm::sys::path::filename(FEOpts.Inputs[0].getFile());
+    if (!Path.empty()) {
+      llvm::sys::path::replace_extension(Path, "json");
+      if (auto OS = Clang->createOutputFile(
+              Path, /*Binary=*/false, /*RemoveFileOnSignal=*/false, "", "",
+              /*UseTemporary=*/false))
+        timeTraceProfilerWrite(*OS);
+      Clang->clearOutputFiles(/*EraseFiles=*/false);
+    }
+    timeTraceProfilerCleanup();
+  }
 
   // If any timers were active but haven't been destroyed yet, print their
   // results now.  This happens in -disable-free mode.
@@ -227,13 +314,116 @@ int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
   // Our error handler depends on the Diagnostics object, which we're
   // potentially about to delete. Uninstall the handler now so that any
   // later errors use the default handling behavior instead.
-  llvm::remove_fatal_error_handler();
+  if (InstallErrorHandler)
+    llvm::remove_fatal_error_handler();
+
+  if (ExclusiveOptions)
+    llvm::cl::ResetAllOptionOccurrences();
 
   // When running with -disable-free, don't do any destruction or shutdown.
-  if (Clang->getFrontendOpts().DisableFree) {
+  if (!Batch && Clang->getFrontendOpts().DisableFree) {
     BuryPointer(std::move(Clang));
     return !Success;
   }
 
   return !Success;
 }
+
+int cc1_main(ArrayRef<const char *> Argv, const char *Argv0, void *MainAddr) {
+  ensureSufficientStack();
+
+  // Initialize targets first, so that --version shows registered targets.
+  initializeTargets();
+
+  return runInvocation(Argv, Argv0, MainAddr);
+}
+
+/// Run the -cc1 invocations listed in the job files \p Argv, one per line,
+/// in this process. This pays once for process startup and target
+/// initialization instead of once per invocation. Each invocation still
+/// gets a compiler instance, file manager and diagnostics of its own, so no
+/// state leaks from one translation unit to the next.
+///
+/// With -j <N> before the job files, up to N invocations run at the same
+/// time, each on a thread of its own. Their diagnostics are buffered and
+/// printed when they finish, so that they don't interleave.
+int cc1batch_main(ArrayRef<const char *> Argv, const char *Argv0,
+                  void *MainAddr) {
+  ensureSufficientStack();
+  initializeTargets();
+
+  unsigned Threads = 1;
+  if (!Argv.empty() && StringRef(Argv.front()).startswith("-j")) {
+    StringRef Value = StringRef(Argv.front()).drop_front(2);
+    Argv = Argv.drop_front();
+    if (Value.empty() && !Argv.empty()) {
+      Value = Argv.front();
+      Argv = Argv.drop_front();
+    }
+    if (Value.getAsInteger(10, Threads) || Threads == 0) {
+      llvm::errs() << "error: invalid -j value '" << Value
+                   << "' given to -cc1batch\n";
+      return 1;
+    }
+  }
+
+  if (Argv.empty()) {
+    llvm::errs() << "error: no job files given to -cc1batch\n";
+    return 1;
+  }
+
+  bool Failed = false;
+  llvm::BumpPtrAllocator Alloc;
+  llvm::StringSaver Saver(Alloc);
+  std::vector<SmallVector<const char *, 64>> Jobs;
+  for (const char *JobFile : Argv) {
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> Buffer =
+        llvm::MemoryBuffer::getFileOrSTDIN(JobFile);
+    if (!Buffer) {
+      llvm::errs() << "error: cannot read job file '" << JobFile
+                   << "': " << Buffer.getError().message() << "\n";
+      Failed = true;
+      continue;
+    }
+
+    SmallVector<StringRef, 32> Lines;
+    (*Buffer)->getBuffer().split(Lines, '\n', /*MaxSplit=*/-1,
+                                 /*KeepEmpty=*/false);
+    for (StringRef Line : Lines) {
+      Line = Line.trim();
+      if (Line.empty() || Line.startswith("#"))
+        continue;
+
+      Jobs.emplace_back();
+      llvm::cl::TokenizeGNUCommandLine(Line, Saver, Jobs.back());
+      // Accept lines copied from the output of -###.
+      if (!Jobs.back().empty() && StringRef(Jobs.back().front()) == "-cc1")
+        Jobs.back().erase(Jobs.back().begin());
+    }
+  }
+
+  BatchContext Batch;
+  std::vector<int> Results(Jobs.size());
+  if (Threads > 1 && Jobs.size() > 1) {
+    Batch.Concurrent = true;
+    std::mutex OutputMutex;
+    llvm::ThreadPool Pool(std::min<size_t>(Threads, Jobs.size()));
+    for (size_t I = 0, E = Jobs.size(); I != E; ++I)
+      Pool.async([&, I] {
+        std::string Diagnostics;
+        llvm::raw_string_ostream DiagOS(Diagnostics);
+        Results[I] = runInvocation(Jobs[I], Argv0, MainAddr, &Batch, &DiagOS);
+        std::lock_guard<std::mutex> Lock(OutputMutex);
+        llvm::errs() << DiagOS.str();
+      });
+    Pool.wait();
+  } else {
+    for (size_t I = 0, E = Jobs.size(); I != E; ++I)
+      Results[I] = runInvocation(Jobs[I], Argv0, MainAddr, &Batch);
+  }
+
+  for (int Result : Results)
+    if (Result)
+      Failed = true;
+  return Failed;
+}
@@ -3976,7 +3976,7 @@ unsigned clang_suspendTranslationUnit(CXTranslationUnit CTUnit) {
   if (CTUnit) {
     ASTUnit *Unit = cxtu::getASTUnit(CTUnit);
 
-    if (Unit && Unit->isUnsafeToFree())
+    if (Unit && (Unit->isUnsafeToFree() || Unit->isFrozen()))
       return false;
 
     Unit->ResetForParse();
@@ -3986,6 +3986,24 @@ unsigned clang_suspendTranslationUnit(CXTranslationUnit CTUnit) {
   return false;
 }
 
+enum CXErrorCode clang_freezeTranslationUnit(CXTranslationUnit TU) {
+  LOG_FUNC_SECTION {
+    *Log << TU;
+  }
+
+  if (isNotUsableTU(TU)) {
+    LOG_BAD_TU(TU);
+    return CXError_InvalidArguments;
+  }
+
+  ASTUnit *CXXUnit = cxtu::getASTUnit(TU);
+  {
+    ASTUnit::ConcurrencyCheck Check(*CXXUnit);
+    CXXUnit->freeze();
+  }
+  return CXError_Success;
+}
+
 unsigned clang_defaultReparseOptions(CXTranslationUnit TU) {
   return CXReparse_None;
 }
@@ -4000,6 +4018,10 @@ clang_reparseTranslationUnit_Impl(CXTranslationUnit TU,
     return CXError_InvalidArguments;
   }
 
+  // A frozen translation unit may be in use by other threads.
+  if (cxtu::getASTUnit(TU)->isFrozen())
+    return CXError_Failure;
+
   // Reset the associated diagnostics.
   delete static_cast<CXDiagnosticSetImpl*>(TU->Diagnostics);
   TU->Diagnostics = nullptr;
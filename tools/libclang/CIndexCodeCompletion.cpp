@@ -657,7 +657,8 @@ clang_codeCompleteAt_Impl(CXTranslationUnit TU, const char *complete_filename,
   }
 
   ASTUnit *AST = cxtu::getASTUnit(TU);
-  if (!AST)
+  // Code completion reparses the translation unit, which a frozen one can't.
+  if (!AST || AST->isFrozen())
     return nullptr;
 
   CIndexer *CXXIdx = TU->CIdx;
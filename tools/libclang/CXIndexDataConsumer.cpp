@@ -406,6 +406,8 @@ const char *ScratchAlloc::copyCStr(StringRef Str) {
 }
 
 void CXIndexDataConsumer::setASTContext(ASTContext &ctx) {
+  if (Ctx != &ctx)
+    USRs.clear();
   Ctx = &ctx;
   cxtu::getASTUnit(CXTU)->setASTContext(&ctx);
 }
@@ -1188,15 +1190,10 @@ void CXIndexDataConsumer::getEntityInfo(const NamedDecl *D,
     EntityInfo.name = SA.copyCStr(StrBuf.str());
   }
 
-  {
-    SmallString<512> StrBuf;
-    bool Ignore = getDeclCursorUSR(D, StrBuf);
-    if (Ignore) {
-      EntityInfo.USR = nullptr;
-    } else {
-      EntityInfo.USR = SA.copyCStr(StrBuf.str());
-    }
-  }
+  // Entities are reported once per reference, so their USRs are generated
+  // once and kept for the rest of the translation unit.
+  StringRef USR = USRs.getUSR(D);
+  EntityInfo.USR = USR.empty() ? nullptr : USR.data();
 }
 
 void CXIndexDataConsumer::getContainerInfo(const DeclContext *DC,
@@ -133,6 +133,7 @@ CXStringPool::~CXStringPool() {
 }
 
 CXStringBuf *CXStringPool::getCXStringBuf(CXTranslationUnit TU) {
+  std::lock_guard<std::mutex> Lock(Mutex);
   if (Pool.empty())
     return new CXStringBuf(TU);
 
@@ -147,6 +148,7 @@ CXStringBuf *getCXStringBuf(CXTranslationUnit TU) {
 }
 
 void CXStringBuf::dispose() {
+  std::lock_guard<std::mutex> Lock(TU->StringPool->Mutex);
   TU->StringPool->Pool.push_back(this);
 }
 
@@ -19,6 +19,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Compiler.h"
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -71,6 +72,9 @@ CXString createCXString(CXStringBuf *buf);
 CXStringSet *createSet(const std::vector<std::string> &Strings);
 
 /// \brief A string pool used for fast allocation/deallocation of strings.
+///
+/// The pool is locked, since the strings of a frozen translation unit can be
+/// created and disposed of by several threads at once.
 class CXStringPool {
 public:
   ~CXStringPool();
@@ -79,6 +83,7 @@ public:
 
 private:
   std::vector<CXStringBuf *> Pool;
+  std::mutex Mutex;
 
   friend struct CXStringBuf;
 };
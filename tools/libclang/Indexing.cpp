@@ -27,11 +27,16 @@
 #include "clang/Lex/PPConditionalDirectiveRecord.h"
 #include "clang/Lex/Preprocessor.h"
 #include "clang/Lex/PreprocessorOptions.h"
+#include "clang/Tooling/CompilationDatabase.h"
 #include "llvm/Support/CrashRecoveryContext.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
+#include <thread>
 #include <utility>
 
 using namespace clang;
@@ -125,6 +130,13 @@ namespace llvm {
 
 namespace {
 
+/// \brief The regions whose function bodies were parsed by the translation
+/// units of an indexing session.
+///
+/// The session may be shared by translation units that are indexed
+/// concurrently, so a region is claimed by the first translation unit that
+/// reaches it, and the bodies of that region are skipped by all the others,
+/// including those that are still being parsed.
 class SessionSkipBodyData {
   llvm::sys::Mutex Mux;
   PPRegionSetTy ParsedRegions;
@@ -135,14 +147,19 @@ public:
     //llvm::errs() << "RegionData: " << Skipped.size() << " - " << Skipped.getMemorySize() << "\n";
   }
 
-  void copyTo(PPRegionSetTy &Set) {
+  /// \brief Returns true if \p Region was not claimed yet, in which case the
+  /// caller is now responsible for parsing its bodies.
+  bool claim(const PPRegion &Region) {
     llvm::MutexGuard MG(Mux);
-    Set = ParsedRegions;
+    return ParsedRegions.insert(Region).second;
   }
 
-  void update(ArrayRef<PPRegion> Regions) {
+  /// \brief Gives up regions that were claimed by a translation unit that did
+  /// not finish parsing, so that the next translation unit parses them.
+  void release(ArrayRef<PPRegion> Regions) {
     llvm::MutexGuard MG(Mux);
-    ParsedRegions.insert(Regions.begin(), Regions.end());
+    for (const PPRegion &Region : Regions)
+      ParsedRegions.erase(Region);
   }
 };
 
@@ -151,17 +168,23 @@ class TUSkipBodyControl {
   PPConditionalDirectiveRecord &PPRec;
   Preprocessor &PP;
 
-  PPRegionSetTy ParsedRegions;
+  /// \brief The regions that were looked up by this translation unit, mapped
+  /// to whether their bodies are parsed by another translation unit.
+  llvm::DenseMap<PPRegion, bool> KnownRegions;
   SmallVector<PPRegion, 32> NewParsedRegions;
   PPRegion LastRegion;
   bool LastIsParsed;
+  bool IsFinished = false;
 
 public:
   TUSkipBodyControl(SessionSkipBodyData &sessionData,
                     PPConditionalDirectiveRecord &ppRec,
                     Preprocessor &pp)
-    : SessionData(sessionData), PPRec(ppRec), PP(pp) {
-    SessionData.copyTo(ParsedRegions);
+    : SessionData(sessionData), PPRec(ppRec), PP(pp) { }
+
+  ~TUSkipBodyControl() {
+    if (!IsFinished)
+      SessionData.release(NewParsedRegions);
   }
 
   bool isParsed(SourceLocation Loc, FileID FID, const FileEntry *FE) {
@@ -174,14 +197,21 @@ public:
       return LastIsParsed;
 
     LastRegion = region;
-    LastIsParsed = ParsedRegions.count(region);
+    auto Known = KnownRegions.find(region);
+    if (Known != KnownRegions.end()) {
+      LastIsParsed = Known->second;
+      return LastIsParsed;
+    }
+
+    LastIsParsed = !SessionData.claim(region);
     if (!LastIsParsed)
       NewParsedRegions.push_back(region);
+    KnownRegions[region] = LastIsParsed;
     return LastIsParsed;
   }
 
   void finished() {
-    SessionData.update(NewParsedRegions);
+    IsFinished = true;
   }
 
 private:
@@ -862,7 +892,8 @@ int clang_indexSourceFileFullArgv(
     struct CXUnsavedFile *unsaved_files, unsigned num_unsaved_files,
     CXTranslationUnit *out_TU, unsigned TU_options) {
   LOG_FUNC_SECTION {
-    *Log << source_filename << ": ";
+    if (source_filename)
+      *Log << source_filename << ": ";
     for (int i = 0; i != num_command_line_args; ++i)
       *Log << command_line_args[i] << " ";
   }
@@ -889,7 +920,8 @@ int clang_indexSourceFileFullArgv(
 
   if (!RunSafely(CRC, IndexSourceFileImpl)) {
     fprintf(stderr, "libclang: crash detected during indexing source file: {\n");
-    fprintf(stderr, "  'source_filename' : '%s'\n", source_filename);
+    fprintf(stderr, "  'source_filename' : '%s'\n",
+            source_filename ? source_filename : "");
     fprintf(stderr, "  'command_line_args' : [");
     for (int i = 0; i != num_command_line_args; ++i) {
       if (i)
@@ -917,6 +949,57 @@ int clang_indexSourceFileFullArgv(
   return result;
 }
 
+int clang_indexCompilationDatabase(CXIndexAction idxAction,
+                                   CXClientData client_data,
+                                   IndexerCallbacks *index_callbacks,
+                                   unsigned index_callbacks_size,
+                                   unsigned index_options,
+                                   CXCompilationDatabase database,
+                                   unsigned TU_options, unsigned num_threads) {
+  LOG_FUNC_SECTION {
+    *Log << "threads: " << num_threads;
+  }
+
+  if (!idxAction || !database)
+    return -CXError_InvalidArguments;
+  if (!index_callbacks || index_callbacks_size == 0)
+    return -CXError_InvalidArguments;
+
+  auto *DB = static_cast<clang::tooling::CompilationDatabase *>(database);
+  std::vector<clang::tooling::CompileCommand> Commands =
+      DB->getAllCompileCommands();
+
+  if (num_threads == 0)
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  std::atomic<int> NumFailures(0);
+  {
+    llvm::ThreadPool Pool(num_threads);
+    for (const clang::tooling::CompileCommand &Cmd : Commands) {
+      Pool.async([&, Cmd]() {
+        // Each file is parsed relative to the directory of its command,
+        // without changing the working directory of the process.
+        std::string WorkingDir = "-working-directory=" + Cmd.Directory;
+        SmallVector<const char *, 32> Args;
+        for (const std::string &Arg : Cmd.CommandLine)
+          Args.push_back(Arg.c_str());
+        Args.push_back(WorkingDir.c_str());
+
+        int Result = clang_indexSourceFileFullArgv(
+            idxAction, client_data, index_callbacks, index_callbacks_size,
+            index_options, /*source_filename=*/nullptr, Args.data(),
+            Args.size(), /*unsaved_files=*/nullptr, /*num_unsaved_files=*/0,
+            /*out_TU=*/nullptr, TU_options);
+        if (Result != CXError_Success)
+          ++NumFailures;
+      });
+    }
+    Pool.wait();
+  }
+
+  return NumFailures;
+}
+
 int clang_indexTranslationUnit(CXIndexAction idxAction,
                                CXClientData client_data,
                                IndexerCallbacks *index_callbacks,
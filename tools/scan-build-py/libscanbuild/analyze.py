@@ -19,6 +19,7 @@ import logging
 import multiprocessing
 import tempfile
 import functools
+import time
 import subprocess
 import contextlib
 import datetime
@@ -118,13 +119,105 @@ def run_analyzer_parallel(args):
                      for cmd in json.load(handle) if not exclude(cmd['file']))
         # when verbose output requested execute sequentially
         pool = multiprocessing.Pool(1 if args.verbose > 2 else None)
+        costs = {}
+        if args.shard_functions:
+            costs = read_function_costs(args.function_costs)
+            generator = shard_by_function(pool, generator, costs)
         for current in pool.imap_unordered(run, generator):
             if current is not None:
                 # display error message from the static analyzer
                 for line in current['error_output']:
                     logging.info(line.rstrip())
+                if 'elapsed' in current:
+                    costs.setdefault(current['file'], {})[
+                        current['function']] = current['elapsed']
         pool.close()
         pool.join()
+        if args.shard_functions and args.function_costs:
+            write_function_costs(args.function_costs, costs)
+
+
+def shard_by_function(pool, entries, costs):
+    """ Split the analysis of the given compilation database entries by the
+    functions the analyzer starts from. The functions are listed on the
+    pool, and the returned tasks are ordered by the given costs. """
+
+    entries = list(entries)
+    return function_tasks(entries, pool.map(list_functions, entries), costs)
+
+
+def function_tasks(entries, listings, costs):
+    """ Create a task which analyzes a single function with
+    '-analyze-function' for each function listed for each entry.
+
+    The entries whose functions could not be listed, or which have none,
+    are analyzed at once, because the checks of a whole translation unit
+    still have to run on them. The tasks are ordered from the costliest,
+    as known from the previous runs, so that the pool hands the long tasks
+    out first and the workers which are done with the short ones take the
+    rest. The functions without a known cost are taken to cost the average.
+
+    :param entries: the compilation database entries
+    :param listings: the list of functions for each entry, or None
+    :param costs: the analysis time of the functions by file and name
+    :return: the tasks to run """
+
+    known = [cost for functions in costs.values()
+             for cost in functions.values()]
+    default = sum(known) / len(known) if known else 1.0
+
+    tasks = []
+    for entry, functions in zip(entries, listings):
+        previous = costs.get(entry['file'], {})
+        if not functions:
+            tasks.append((sum(previous.values()) or default, entry))
+            continue
+        for function in functions:
+            task = dict(entry,
+                        analyze_function=function,
+                        direct_args=entry['direct_args'] +
+                        ['-Xclang', '-analyze-function=' + function])
+            tasks.append((previous.get(function, default), task))
+    # the sort is stable, so the functions of an entry stay together
+    tasks.sort(key=lambda task: task[0], reverse=True)
+    return [task for _, task in tasks]
+
+
+def list_functions(opts):
+    """ Returns the names of the functions the analyzer starts from for the
+    given compilation database entry, or None when those can not be listed.
+    The names are as '-analyze-function' accepts them. """
+
+    prefix = 'FUNCTION: '
+    result = run(dict(opts,
+                      list_functions=True,
+                      direct_args=opts['direct_args'] +
+                      ['-Xclang', '-analyzer-list-functions']))
+    if result is None or result['exit_code'] != 0:
+        return None
+    return [line[len(prefix):].rstrip() for line in result['error_output']
+            if line.startswith(prefix)]
+
+
+def read_function_costs(filename):
+    """ Read the analysis time of the functions by file and name, as written
+    by the previous run. Returns an empty dictionary when there is none. """
+
+    if not filename or not os.path.exists(filename):
+        return {}
+    try:
+        with open(filename, 'r') as handle:
+            return json.load(handle)
+    except ValueError:
+        logging.warning('Ignoring malformed function costs %s', filename)
+        return {}
+
+
+def write_function_costs(filename, costs):
+    """ Write the analysis time of the functions by file and name. """
+
+    with open(filename, 'w') as handle:
+        json.dump(costs, handle, sort_keys=True, indent=4)
 
 
 def setup_environment(args):
@@ -383,6 +476,8 @@ def run_analyzer(opts, continuation=report_failure):
 
     def target():
         """ Creates output file name for reports. """
+        if opts.get('list_functions', False):
+            return os.devnull
         if opts['output_format'] in {'plist', 'plist-html'}:
             (handle, name) = tempfile.mkstemp(prefix='report-',
                                               suffix='.plist',
@@ -391,6 +486,7 @@ def run_analyzer(opts, continuation=report_failure):
             return name
         return opts['output_dir']
 
+    start = time.time()
     try:
         cwd = opts['directory']
         cmd = get_arguments([opts['clang'], '--analyze'] +
@@ -398,13 +494,20 @@ def run_analyzer(opts, continuation=report_failure):
                             [opts['file'], '-o', target()],
                             cwd)
         output = run_command(cmd, cwd=cwd)
-        return {'error_output': output, 'exit_code': 0}
+        result = {'error_output': output, 'exit_code': 0}
     except subprocess.CalledProcessError as ex:
         result = {'error_output': ex.output, 'exit_code': ex.returncode}
-        if opts.get('output_failures', False):
+        # failures are reported when the functions are analyzed
+        if opts.get('output_failures', False) and \
+                not opts.get('list_functions', False):
             opts.update(result)
             continuation(opts)
-        return result
+    # record the cost of the function for the next runs
+    if 'analyze_function' in opts:
+        result.update({'file': opts['file'],
+                       'function': opts['analyze_function'],
+                       'elapsed': time.time() - start})
+    return result
 
 
 @require(['flags', 'force_debug'])
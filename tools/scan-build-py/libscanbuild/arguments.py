@@ -298,6 +298,22 @@ def create_analyze_parser(from_build_command):
         action='store_true',
         help="""Tells analyzer to enable assertions in code even if they were
         disabled during compilation, enabling more precise results.""")
+    advanced.add_argument(
+        '--shard-functions',
+        action='store_true',
+        help="""Schedule the analysis by function instead of by translation
+        unit, so that the functions of a large translation unit are spread
+        across the worker processes. The analyzer lists the functions of
+        each translation unit, which are then analyzed one by one with
+        '-analyze-function'. (Only used when the analyzer runs against a
+        compilation database.)""")
+    advanced.add_argument(
+        '--function-costs',
+        metavar='<file>',
+        help="""With '--shard-functions', read the time it took to analyze
+        each function in the previous runs from this file, to start the
+        costliest functions first. The file is then updated with the times
+        of this run.""")
 
     plugins = parser.add_argument_group('checker options')
     plugins.add_argument(
@@ -333,3 +333,43 @@ class RequireDecoratorTest(unittest.TestCase):
 
     def test_method_exception_not_caught(self):
         self.assertRaises(Exception, method_exception_from_inside, dict())
+
+
+class FunctionTasksTest(unittest.TestCase):
+
+    @staticmethod
+    def entry(filename):
+        return {'file': filename, 'direct_args': ['-Xclang', '-x']}
+
+    def test_tasks_are_created_per_function(self):
+        entries = [self.entry('a.c')]
+        tasks = sut.function_tasks(entries, [['f', 'g']], {})
+        self.assertEqual(['f', 'g'],
+                         [task['analyze_function'] for task in tasks])
+        self.assertEqual(['-Xclang', '-x', '-Xclang', '-analyze-function=f'],
+                         tasks[0]['direct_args'])
+        self.assertEqual(['-Xclang', '-x'], entries[0]['direct_args'])
+
+    def test_unlisted_entries_are_analyzed_at_once(self):
+        entries = [self.entry('a.c'), self.entry('b.c')]
+        tasks = sut.function_tasks(entries, [None, []], {})
+        self.assertEqual(entries, tasks)
+
+    def test_costliest_tasks_come_first(self):
+        entries = [self.entry('a.c'), self.entry('b.c')]
+        costs = {'a.c': {'f': 1.0, 'g': 5.0}, 'b.c': {'h': 3.0}}
+        tasks = sut.function_tasks(entries, [['f', 'g'], ['h', 'i']], costs)
+        # the unknown function 'i' costs the average
+        self.assertEqual(['g', 'h', 'i', 'f'],
+                         [task['analyze_function'] for task in tasks])
+
+    def test_function_costs_round_trip(self):
+        with libear.TemporaryDirectory() as tmpdir:
+            filename = os.path.join(tmpdir, 'costs.json')
+            self.assertEqual({}, sut.read_function_costs(filename))
+            costs = {'a.c': {'f': 1.5}}
+            sut.write_function_costs(filename, costs)
+            self.assertEqual(costs, sut.read_function_costs(filename))
+            with open(filename, 'w') as handle:
+                handle.write('not json')
+            self.assertEqual({}, sut.read_function_costs(filename))
@@ -0,0 +1,77 @@
+//===- unittests/AST/APValueTest.cpp - APValue tests ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/APValue.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+
+namespace {
+
+APValue makeInt(int64_t V) { return APValue(llvm::APSInt::get(V)); }
+
+APValue makePair(int64_t A, int64_t B) {
+  APValue Pair(APValue::UninitStruct(), 0, 2);
+  Pair.getStructField(0) = makeInt(A);
+  Pair.getStructField(1) = makeInt(B);
+  return Pair;
+}
+
+TEST(APValueTest, ElementPoolReusesStorage) {
+  APValue::ElementPool Pool;
+  APValue Sum = makeInt(0);
+  for (int64_t I = 0; I != 100; ++I) {
+    APValue Pair = makePair(I, 2 * I);
+    APValue Copy = Pair;
+    Sum = makeInt(Sum.getInt().getExtValue() +
+                  Copy.getStructField(1).getInt().getExtValue());
+  }
+  EXPECT_EQ(9900, Sum.getInt().getExtValue());
+}
+
+TEST(APValueTest, ValuesOutliveElementPool) {
+  APValue Escaped;
+  APValue Array;
+  {
+    APValue::ElementPool Pool;
+    // Recycle some storage before creating the values that escape.
+    for (int64_t I = 0; I != 10; ++I)
+      makePair(I, I);
+    Escaped = makePair(1, 2);
+    Array = APValue(APValue::UninitArray(), 2, 3);
+    Array.getArrayInitializedElt(0) = makePair(3, 4);
+    Array.getArrayInitializedElt(1) = Escaped;
+    Array.getArrayFiller() = makePair(0, 0);
+  }
+  ASSERT_TRUE(Escaped.isStruct());
+  EXPECT_EQ(1, Escaped.getStructField(0).getInt().getExtValue());
+  EXPECT_EQ(2, Escaped.getStructField(1).getInt().getExtValue());
+  ASSERT_TRUE(Array.isArray());
+  EXPECT_EQ(3, Array.getArrayInitializedElt(0).getStructField(0)
+                   .getInt().getExtValue());
+  EXPECT_EQ(2, Array.getArrayInitializedElt(1).getStructField(1)
+                   .getInt().getExtValue());
+  EXPECT_EQ(0, Array.getArrayFiller().getStructField(0).getInt().getExtValue());
+}
+
+TEST(APValueTest, NestedElementPools) {
+  APValue::ElementPool Outer;
+  APValue FromInner;
+  {
+    APValue::ElementPool Inner;
+    FromInner = makePair(5, 6);
+  }
+  // Destroyed while only the outer pool is alive.
+  FromInner = makeInt(7);
+  APValue Pair = makePair(8, 9);
+  EXPECT_EQ(9, Pair.getStructField(1).getInt().getExtValue());
+  EXPECT_EQ(7, FromInner.getInt().getExtValue());
+}
+
+} // end anonymous namespace
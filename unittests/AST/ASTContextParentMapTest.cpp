@@ -15,6 +15,7 @@
 #include "MatchVerifier.h"
 #include "clang/ASTMatchers/ASTMatchFinder.h"
 #include "clang/ASTMatchers/ASTMatchers.h"
+#include "clang/Frontend/ASTUnit.h"
 #include "clang/Tooling/Tooling.h"
 #include "gtest/gtest.h"
 
@@ -78,5 +79,20 @@ TEST(GetParents, ReturnsMultipleParentsInTemplateInstantiations) {
           hasAncestor(cxxRecordDecl(unless(isTemplateInstantiation())))))));
 }
 
+TEST(GetParents, ReturnsNoParentForTranslationUnit) {
+  std::unique_ptr<ASTUnit> AST =
+      tooling::buildASTFromCode("class C { void f() { if (true) {} } };");
+  ASTContext &Context = AST->getASTContext();
+  TranslationUnitDecl *TU = Context.getTranslationUnitDecl();
+  EXPECT_TRUE(Context.getParents(*TU).empty());
+
+  auto Methods = match(cxxMethodDecl(hasName("f")).bind("f"), Context);
+  ASSERT_EQ(1u, Methods.size());
+  const auto *F = Methods[0].getNodeAs<CXXMethodDecl>("f");
+  auto Parents = Context.getParents(*F);
+  ASSERT_EQ(1u, Parents.size());
+  EXPECT_EQ(F->getParent(), Parents[0].get<CXXRecordDecl>());
+}
+
 } // end namespace ast_matchers
 } // end namespace clang
@@ -0,0 +1,83 @@
+//===- unittests/AST/ASTNodeIndexTest.cpp - AST node index tests ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains tests for ASTNodeIndex and StmtPreorderIterator.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/AST/ASTNodeIndex.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/Decl.h"
+#include "clang/AST/Expr.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Tooling/Tooling.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+
+namespace {
+
+TEST(ASTNodeIndex, GroupsNodesByKind) {
+  std::unique_ptr<ASTUnit> AST = tooling::buildASTFromCode(
+      "int g;\n"
+      "int f(int p) { int a = p, b; return a + b + g; }\n");
+  ASTNodeIndex Index(AST->getASTContext());
+
+  ASSERT_EQ(1u, Index.getDecls(Decl::Function).size());
+  EXPECT_EQ("f", cast<FunctionDecl>(Index.getDecls(Decl::Function)[0])
+                     ->getNameAsString());
+  EXPECT_EQ(1u, Index.getDecls(Decl::ParmVar).size());
+  EXPECT_EQ(1u, Index.getStmts(Stmt::DeclStmtClass).size());
+  EXPECT_EQ(2u, Index.getStmts(Stmt::BinaryOperatorClass).size());
+
+  // The declarations of a kind are in the order of the traversal.
+  ArrayRef<Decl *> Vars = Index.getDecls(Decl::Var);
+  ASSERT_EQ(3u, Vars.size());
+  EXPECT_EQ("g", cast<VarDecl>(Vars[0])->getNameAsString());
+  EXPECT_EQ("a", cast<VarDecl>(Vars[1])->getNameAsString());
+  EXPECT_EQ("b", cast<VarDecl>(Vars[2])->getNameAsString());
+
+  // Derived classes are included.
+  EXPECT_EQ(4u, Index.getDeclsOf<VarDecl>().size());
+  std::vector<Expr *> Exprs = Index.getStmtsOf<Expr>();
+  EXPECT_EQ(Index.getNumStmts() - 3, Exprs.size());
+}
+
+TEST(StmtPreorderIterator, VisitsParentsBeforeChildren) {
+  std::unique_ptr<ASTUnit> AST =
+      tooling::buildASTFromCode("int f(int x) { return (x + 1) * 2; }");
+  ASTNodeIndex Index(AST->getASTContext());
+  ArrayRef<Decl *> Functions = Index.getDecls(Decl::Function);
+  ASSERT_EQ(1u, Functions.size());
+  Stmt *Body = cast<FunctionDecl>(Functions[0])->getBody();
+
+  std::vector<Stmt::StmtClass> Classes;
+  for (Stmt *S : Body->preorder())
+    Classes.push_back(S->getStmtClass());
+  std::vector<Stmt::StmtClass> Expected = {
+      Stmt::CompoundStmtClass,     Stmt::ReturnStmtClass,
+      Stmt::BinaryOperatorClass,   Stmt::ParenExprClass,
+      Stmt::BinaryOperatorClass,   Stmt::ImplicitCastExprClass,
+      Stmt::DeclRefExprClass,      Stmt::IntegerLiteralClass,
+      Stmt::IntegerLiteralClass};
+  EXPECT_EQ(Expected, Classes);
+
+  // Skipping the operands of the multiplication ends the iteration there.
+  unsigned Count = 0;
+  for (StmtPreorderIterator I(Body), E; I != E;) {
+    ++Count;
+    if (isa<BinaryOperator>(*I))
+      I.skipChildren();
+    else
+      ++I;
+  }
+  EXPECT_EQ(3u, Count);
+}
+
+} // end anonymous namespace
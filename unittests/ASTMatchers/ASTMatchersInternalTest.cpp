@@ -119,6 +119,55 @@ TEST(MatchFinder, CheckProfiling) {
   EXPECT_EQ("MyID", Records.begin()->getKey());
 }
 
+TEST(MatchFinder, CheckProfilingCountsMatches) {
+  MatchFinder::MatchFinderOptions Options;
+  llvm::StringMap<llvm::TimeRecord> Records;
+  llvm::StringMap<MatchFinder::MatchFinderOptions::Profiling::MatchCounts>
+      Counts;
+  Options.CheckProfiling.emplace(Records, &Counts);
+  MatchFinder Finder(std::move(Options));
+
+  struct NamedCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override {}
+    StringRef getID() const override { return "MyID"; }
+  } Callback;
+  Finder.addMatcher(varDecl(hasName("y")), &Callback);
+  std::unique_ptr<FrontendActionFactory> Factory(
+      newFrontendActionFactory(&Finder));
+  ASSERT_TRUE(tooling::runToolOnCode(Factory->create(), "int x; int y;"));
+
+  ASSERT_EQ(1u, Counts.size());
+  EXPECT_EQ("MyID", Counts.begin()->getKey());
+  EXPECT_EQ(2u, Counts.begin()->getValue().Attempts);
+  EXPECT_EQ(1u, Counts.begin()->getValue().Matches);
+}
+
+TEST(MatchFinder, MatchByNodeKind) {
+  struct CountingCallback : public MatchFinder::MatchCallback {
+    void run(const MatchFinder::MatchResult &Result) override { ++Count; }
+    unsigned Count = 0;
+  };
+
+  const char *Code = "class B {}; typedef B A; class C : public A {};\n"
+                     "int f(int x) { return x; }\n"
+                     "int y = f(1) + f(2);\n";
+  for (bool MatchByNodeKind : {false, true}) {
+    MatchFinder::MatchFinderOptions Options;
+    Options.MatchByNodeKind = MatchByNodeKind;
+    MatchFinder Finder(std::move(Options));
+    CountingCallback Calls, Derived;
+    Finder.addMatcher(callExpr(callee(functionDecl(hasName("f")))), &Calls);
+    Finder.addMatcher(cxxRecordDecl(isDerivedFrom("A"), unless(isImplicit())),
+                      &Derived);
+    std::unique_ptr<FrontendActionFactory> Factory(
+        newFrontendActionFactory(&Finder));
+    ASSERT_TRUE(tooling::runToolOnCode(Factory->create(), Code));
+
+    EXPECT_EQ(2u, Calls.Count);
+    EXPECT_EQ(1u, Derived.Count);
+  }
+}
+
 class VerifyStartOfTranslationUnit : public MatchFinder::MatchCallback {
 public:
   VerifyStartOfTranslationUnit() : Called(false) {}
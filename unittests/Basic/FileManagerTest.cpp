@@ -255,6 +255,27 @@ TEST_F(FileManagerTest, getFileReturnsSameFileEntryForAliasedVirtualFiles) {
   EXPECT_EQ(manager.getFile("abc/foo.cpp"), manager.getFile("abc/bar.cpp"));
 }
 
+// getFile() reuses the result of an earlier lookup of a file in a directory
+// that has since been found under another name, without a stat.
+TEST_F(FileManagerTest, getFileReusesLookupsInAliasedDirectories) {
+  auto statCache = llvm::make_unique<FakeStatCache>();
+  statCache->InjectDirectory("abc", 41);
+  statCache->InjectDirectory("link", 41);
+  statCache->InjectFile("abc/foo.cpp", 42);
+  manager.addStatCache(std::move(statCache));
+
+  const FileEntry *file = manager.getFile("abc/foo.cpp");
+  ASSERT_TRUE(file != nullptr);
+  EXPECT_EQ(nullptr, manager.getFile("abc/bar.cpp"));
+
+  // "link/foo.cpp" is not known to the stat cache, so it can only be found
+  // through "abc".
+  EXPECT_EQ(manager.getDirectory("abc"), manager.getDirectory("link"));
+  EXPECT_EQ(file, manager.getFile("link/foo.cpp"));
+  EXPECT_EQ("link/foo.cpp", file->getName());
+  EXPECT_EQ(nullptr, manager.getFile("link/bar.cpp"));
+}
+
 TEST_F(FileManagerTest, addRemoveStatCache) {
   manager.addStatCache(llvm::make_unique<FakeStatCache>());
   auto statCacheOwner = llvm::make_unique<FakeStatCache>();
@@ -0,0 +1,98 @@
+//===- unittests/Basic/IdentifierTableTest.cpp - Keyword lookup tests -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Basic/IdentifierTable.h"
+#include "clang/Basic/LangOptions.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+
+namespace {
+
+TEST(IdentifierTableTest, KeywordsOfC) {
+  LangOptions LangOpts;
+  LangOpts.C99 = true;
+  IdentifierTable Table(LangOpts);
+
+  EXPECT_EQ(tok::kw_int, Table.get("int").getTokenID());
+  EXPECT_EQ(tok::kw_restrict, Table.get("restrict").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("class").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("and").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("_Ptr").getTokenID());
+  EXPECT_EQ(tok::identifier, Table.get("integer").getTokenID());
+  EXPECT_TRUE(Table.get("int").isKeyword(LangOpts));
+  EXPECT_FALSE(Table.get("class").isKeyword(LangOpts));
+  EXPECT_TRUE(Table.get("import").isModulesImport());
+}
+
+TEST(IdentifierTableTest, KeywordsOfCheckedC) {
+  LangOptions LangOpts;
+  LangOpts.C99 = true;
+  LangOpts.CheckedC = true;
+  IdentifierTable Table(LangOpts);
+
+  EXPECT_EQ(tok::kw__Ptr, Table.get("_Ptr").getTokenID());
+  EXPECT_EQ(tok::kw__Array_ptr, Table.get("_Array_ptr").getTokenID());
+  EXPECT_EQ(tok::kw__Nt_array_ptr, Table.get("_Nt_array_ptr").getTokenID());
+  EXPECT_EQ(tok::kw__Where, Table.get("_Where").getTokenID());
+  EXPECT_TRUE(Table.get("_Ptr").isKeyword(LangOpts));
+}
+
+TEST(IdentifierTableTest, ExtensionAndFutureKeywords) {
+  LangOptions LangOpts;
+  LangOpts.CPlusPlus = true;
+  LangOpts.GNUKeywords = true;
+  IdentifierTable Table(LangOpts);
+
+  IdentifierInfo &Typeof = Table.get("typeof");
+  EXPECT_EQ(tok::kw_typeof, Typeof.getTokenID());
+  EXPECT_TRUE(Typeof.isExtensionToken());
+
+  IdentifierInfo &Constexpr = Table.get("constexpr");
+  EXPECT_EQ(tok::identifier, Constexpr.getTokenID());
+  EXPECT_TRUE(Constexpr.isFutureCompatKeyword());
+}
+
+TEST(IdentifierTableTest, OperatorAndObjCKeywords) {
+  LangOptions LangOpts;
+  LangOpts.CPlusPlus = true;
+  LangOpts.CXXOperatorNames = true;
+  LangOpts.ObjC1 = true;
+  IdentifierTable Table(LangOpts);
+
+  IdentifierInfo &And = Table.get("and");
+  EXPECT_EQ(tok::ampamp, And.getTokenID());
+  EXPECT_TRUE(And.isCPlusPlusOperatorKeyword());
+
+  IdentifierInfo &Class = Table.get("class");
+  EXPECT_EQ(tok::kw_class, Class.getTokenID());
+  EXPECT_EQ(tok::objc_class, Class.getObjCKeywordID());
+  EXPECT_EQ(tok::objc_interface, Table.get("interface").getObjCKeywordID());
+  // @property is an Objective-C 2 keyword.
+  EXPECT_EQ(tok::objc_not_keyword, Table.get("property").getObjCKeywordID());
+}
+
+TEST(IdentifierTableTest, AliasOfKeyword) {
+  LangOptions LangOpts;
+  LangOpts.OpenCL = true;
+  IdentifierTable Table(LangOpts);
+
+  EXPECT_EQ(tok::kw___private, Table.get("private").getTokenID());
+  EXPECT_EQ(tok::kw___private, Table.get("__private").getTokenID());
+}
+
+TEST(IdentifierTableTest, GetOwnAddsKeywordInfo) {
+  LangOptions LangOpts;
+  IdentifierTable Table(LangOpts);
+
+  EXPECT_EQ(tok::kw_while, Table.getOwn("while").getTokenID());
+  EXPECT_TRUE(Table.getOwn("import").isModulesImport());
+}
+
+} // anonymous namespace
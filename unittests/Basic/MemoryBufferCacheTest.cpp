@@ -91,4 +91,67 @@ TEST(MemoryBufferCacheTest, finalizeCurrentBuffers) {
   EXPECT_TRUE(Cache.isBufferFinal("2"));
 }
 
+TEST(MemoryBufferCacheTest, sharedBuffers) {
+  IntrusiveRefCntPtr<SharedMemoryBufferCache> Shared(
+      new SharedMemoryBufferCache(/*MaxSize=*/1024));
+  auto B1 = getBuffer(1);
+  auto *RawB1 = B1.get();
+
+  // Publish a buffer from one user.
+  MemoryBufferCache Cache1;
+  Cache1.setSharedCache(Shared);
+  Cache1.addBuffer("1", std::move(B1));
+  Cache1.shareBuffer("1", /*Size=*/6, /*ModTime=*/1);
+  EXPECT_EQ(6u, Shared->getTotalSize());
+
+  // Another user only gets it for the same version of the file.
+  MemoryBufferCache Cache2;
+  Cache2.setSharedCache(Shared);
+  EXPECT_EQ(nullptr, Cache2.addSharedBuffer("1", /*Size=*/6, /*ModTime=*/2));
+  EXPECT_EQ(nullptr, Cache2.addSharedBuffer("2", /*Size=*/6, /*ModTime=*/1));
+  EXPECT_EQ(RawB1, Cache2.addSharedBuffer("1", /*Size=*/6, /*ModTime=*/1));
+  EXPECT_EQ(RawB1, Cache2.lookupBuffer("1"));
+  EXPECT_FALSE(Cache2.isBufferFinal("1"));
+
+  // Removing an out-of-date buffer drops it from the shared cache, but not
+  // from the other users.
+  EXPECT_FALSE(Cache2.tryToRemoveBuffer("1"));
+  EXPECT_EQ(0u, Shared->getTotalSize());
+  EXPECT_EQ(RawB1, Cache1.lookupBuffer("1"));
+
+  // Adding a new version of a file drops the old one.
+  Cache1.shareBuffer("1", /*Size=*/6, /*ModTime=*/1);
+  Cache2.addBuffer("1", getBuffer(2));
+  EXPECT_EQ(0u, Shared->getTotalSize());
+}
+
+TEST(MemoryBufferCacheTest, sharedBuffersEviction) {
+  IntrusiveRefCntPtr<SharedMemoryBufferCache> Shared(
+      new SharedMemoryBufferCache(/*MaxSize=*/12));
+  {
+    MemoryBufferCache Cache;
+    Cache.setSharedCache(Shared);
+    Cache.addBuffer("1", getBuffer(1));
+    Cache.shareBuffer("1", 6, 1);
+    Cache.addBuffer("2", getBuffer(2));
+    Cache.shareBuffer("2", 6, 1);
+    Cache.addBuffer("3", getBuffer(3));
+    Cache.shareBuffer("3", 6, 1);
+
+    // All the buffers are in use, so none can be evicted.
+    EXPECT_EQ(18u, Shared->getTotalSize());
+  }
+
+  // Buffers that are not in use are evicted, least recently used first.
+  MemoryBufferCache Cache;
+  Cache.setSharedCache(Shared);
+  EXPECT_NE(nullptr, Cache.addSharedBuffer("1", 6, 1));
+  Shared->setMaxSize(12);
+  EXPECT_EQ(12u, Shared->getTotalSize());
+  EXPECT_NE(nullptr, Cache.addSharedBuffer("3", 6, 1));
+  Shared->setMaxSize(0);
+  EXPECT_EQ(12u, Shared->getTotalSize());
+  EXPECT_EQ(nullptr, Cache.addSharedBuffer("2", 6, 1));
+}
+
 } // namespace
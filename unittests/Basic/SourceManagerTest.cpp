@@ -155,6 +155,46 @@ TEST_F(SourceManagerTest, getColumnNumber) {
   EXPECT_EQ(1U, SourceMgr.getColumnNumber(MainFileID, 0, nullptr));
 }
 
+TEST_F(SourceManagerTest, getLineNumberInLargeFile) {
+  // Four million lines of "x;\n", followed by a line without a newline.
+  const unsigned NumLines = 4000000;
+  std::string Source;
+  Source.reserve(NumLines * 3 + 2);
+  for (unsigned I = 0; I != NumLines; ++I)
+    Source += "x;\n";
+  Source += "y;";
+
+  std::unique_ptr<llvm::MemoryBuffer> Buf =
+      llvm::MemoryBuffer::getMemBuffer(Source);
+  FileID MainFileID = SourceMgr.createFileID(std::move(Buf));
+  SourceMgr.setMainFileID(MainFileID);
+  const SrcMgr::ContentCache *Content =
+      SourceMgr.getSLocEntry(MainFileID).getFile().getContentCache();
+
+  // Only the start of the file is scanned for a query near its start.
+  EXPECT_EQ(2U, SourceMgr.getLineNumber(MainFileID, 4));
+  EXPECT_FALSE(Content->LineTableComplete);
+  EXPECT_LT(Content->NumLines, NumLines);
+
+  EXPECT_EQ(1000001U, SourceMgr.getLineNumber(MainFileID, 3000001));
+  EXPECT_EQ(3U, SourceMgr.getColumnNumber(MainFileID, 3000002));
+  EXPECT_FALSE(Content->LineTableComplete);
+
+  // Line numbers from earlier chunks are still found.
+  EXPECT_EQ(11U, SourceMgr.getLineNumber(MainFileID, 30));
+
+  SourceLocation Loc = SourceMgr.translateLineCol(MainFileID, 3000000, 2);
+  EXPECT_EQ(SourceMgr.getLocForStartOfFile(MainFileID).getLocWithOffset(
+                2999999 * 3 + 1),
+            Loc);
+
+  EXPECT_EQ(NumLines + 1,
+            SourceMgr.getLineNumber(MainFileID, Source.size()));
+  EXPECT_TRUE(Content->LineTableComplete);
+  EXPECT_EQ(NumLines + 1, Content->NumLines);
+  EXPECT_EQ(NumLines, SourceMgr.getLineNumber(MainFileID, Source.size() - 3));
+}
+
 #if defined(LLVM_ON_UNIX)
 
 TEST_F(SourceManagerTest, getMacroArgExpandedLocation) {
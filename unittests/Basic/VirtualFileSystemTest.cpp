@@ -760,6 +760,126 @@ TEST_F(InMemoryFileSystemTest, WorkingDirectory) {
                       NormalizedFS.getCurrentWorkingDirectory().get()));
 }
 
+#if !defined(_WIN32)
+static IntrusiveRefCntPtr<vfs::FileSystem>
+getContentStoreFS(vfs::ContentStoreWriter &Writer, std::string &Storage) {
+  llvm::raw_string_ostream OS(Storage);
+  Writer.write(OS);
+  OS.flush();
+  EXPECT_TRUE(vfs::isContentStore(Storage));
+  return vfs::getVFSFromContentStore(MemoryBuffer::getMemBuffer(
+      Storage, "store", /*RequiresNullTerminator=*/false));
+}
+
+TEST(ContentStoreFileSystemTest, StatusQueries) {
+  vfs::ContentStoreWriter Writer;
+  Writer.addFile("/src/a.c", "#include \"b.h\"\n", 10);
+  Writer.addFile("/src/inc/b.h", "int b;\n", 20);
+  Writer.addFile("/src/inc/c.h", "int b;\n", 30);
+  std::string Storage;
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = getContentStoreFS(Writer, Storage);
+  ASSERT_TRUE(FS);
+
+  ErrorOr<vfs::Status> Stat = FS->status("/src/inc/b.h");
+  ASSERT_FALSE(Stat.getError());
+  EXPECT_TRUE(Stat->isRegularFile());
+  EXPECT_EQ(7U, Stat->getSize());
+  EXPECT_EQ(sys::toTimePoint(20), Stat->getLastModificationTime());
+  EXPECT_EQ("/src/inc/b.h", Stat->getName());
+
+  // Files with the same contents are still different files.
+  ErrorOr<vfs::Status> Stat2 = FS->status("/src/inc/../inc/./c.h");
+  ASSERT_FALSE(Stat2.getError());
+  EXPECT_FALSE(Stat->equivalent(*Stat2));
+  EXPECT_TRUE(Stat->equivalent(*FS->status("/src/inc/b.h")));
+
+  EXPECT_TRUE(FS->status("/")->isDirectory());
+  EXPECT_TRUE(FS->status("/src/inc")->isDirectory());
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS->status("/src/inc/d.h").getError());
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS->status("/src/in").getError());
+
+  ASSERT_FALSE(FS->setCurrentWorkingDirectory("/src"));
+  EXPECT_FALSE(FS->status("inc/b.h").getError());
+}
+
+TEST(ContentStoreFileSystemTest, OpenFileForRead) {
+  vfs::ContentStoreWriter Writer;
+  Writer.addFile("/a", "a", 0);
+  Writer.addFile("/b/c", "c", 0);
+  std::string Storage;
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = getContentStoreFS(Writer, Storage);
+  ASSERT_TRUE(FS);
+
+  auto File = FS->openFileForRead("/b/c");
+  ASSERT_FALSE(File.getError());
+  auto Buffer = (*File)->getBuffer("/b/c");
+  ASSERT_FALSE(Buffer.getError());
+  // The buffer references the store, and outlives the file system.
+  FS = nullptr;
+  EXPECT_EQ("c", (*Buffer)->getBuffer());
+  EXPECT_EQ(Storage.data() + Storage.size() - 2, (*Buffer)->getBufferStart());
+  EXPECT_EQ("/b/c", (*Buffer)->getBufferIdentifier());
+
+  std::string Storage2;
+  FS = getContentStoreFS(Writer, Storage2);
+  EXPECT_EQ(errc::invalid_argument, FS->openFileForRead("/b").getError());
+  EXPECT_EQ(errc::no_such_file_or_directory,
+            FS->openFileForRead("/d").getError());
+}
+
+TEST(ContentStoreFileSystemTest, DirectoryIteration) {
+  vfs::ContentStoreWriter Writer;
+  Writer.addFile("/a", "", 0);
+  Writer.addFile("/b/c", "", 0);
+  Writer.addFile("/b/d/e", "", 0);
+  Writer.addFile("/b-f", "", 0);
+  std::string Storage;
+  IntrusiveRefCntPtr<vfs::FileSystem> FS = getContentStoreFS(Writer, Storage);
+  ASSERT_TRUE(FS);
+
+  std::error_code EC;
+  vfs::directory_iterator I = FS->dir_begin("/", EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/a", I->getName());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/b", I->getName());
+  EXPECT_TRUE(I->isDirectory());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/b-f", I->getName());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ(vfs::directory_iterator(), I);
+
+  I = FS->dir_begin("/b", EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/b/c", I->getName());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ("/b/d", I->getName());
+  I.increment(EC);
+  ASSERT_FALSE(EC);
+  ASSERT_EQ(vfs::directory_iterator(), I);
+
+  FS->dir_begin("/a", EC);
+  EXPECT_EQ(errc::not_a_directory, EC);
+}
+
+TEST(ContentStoreFileSystemTest, InvalidStore) {
+  vfs::ContentStoreWriter Writer;
+  Writer.addFile("/a", "a", 0);
+  std::string Storage;
+  ASSERT_TRUE(getContentStoreFS(Writer, Storage));
+
+  EXPECT_FALSE(vfs::getVFSFromContentStore(
+      MemoryBuffer::getMemBufferCopy(Storage.substr(0, 30))));
+  EXPECT_FALSE(vfs::isContentStore("roots: []"));
+}
+#endif
+
 // NOTE: in the tests below, we use '//root/' as our root directory, since it is
 // a legal *absolute* path on Windows as well as *nix.
 class VFSFromYAMLTest : public ::testing::Test {
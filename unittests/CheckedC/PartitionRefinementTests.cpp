@@ -429,3 +429,112 @@ TEST(PartitionRefinementTest, DumpAll) {
   OS.flush();
   EXPECT_TRUE(std::regex_search(Result, Output));
 }
+
+// Test copying and comparing partitions, which the dataflow analysis uses
+// to propagate facts between blocks.
+TEST(PartitionRefinementTest, AssignAndEquals) {
+  Partition P1;
+  P1.add(0, 1);
+  P1.add(2, 3);
+  P1.add(2, 4);
+
+  Partition P2;
+  EXPECT_FALSE(P2.equals(P1));
+  P2.assign(P1);
+  EXPECT_TRUE(P2.equals(P1));
+  EXPECT_TRUE(P1.equals(P2));
+  EXPECT_EQ(P2.getRepresentative(0), P2.getRepresentative(1));
+  EXPECT_EQ(P2.getRepresentative(2), P2.getRepresentative(4));
+  EXPECT_NE(P2.getRepresentative(0), P2.getRepresentative(2));
+
+  // The same elements in differently grouped sets are not equal.
+  Partition P3;
+  P3.add(0, 1);
+  P3.add(1, 2);
+  P3.add(3, 4);
+  EXPECT_FALSE(P3.equals(P1));
+  EXPECT_FALSE(P1.equals(P3));
+
+  // Copies are independent of the original.
+  P2.makeSingleton(4);
+  EXPECT_FALSE(P2.equals(P1));
+  EXPECT_FALSE(P1.isSingleton(4));
+
+  SmallVector<SmallVector<Element, 4>, 4> Classes;
+  P2.getClasses(Classes);
+  EXPECT_EQ(2u, Classes.size());
+
+  P2.clear();
+  EXPECT_TRUE(P2.isSingleton(0));
+  EXPECT_TRUE(P2.isSingleton(2));
+  Classes.clear();
+  P2.getClasses(Classes);
+  EXPECT_TRUE(Classes.empty());
+}
+
+// Test refinement of partitions with many elements, as in the facts of
+// large functions.  The classes of P1 are the residues modulo 100 and those
+// of P2 the residues modulo 6, so the classes of the refinement are the
+// residues modulo 300.
+TEST(PartitionRefinementTest, LargePartitions) {
+  const int Size = 30000;
+  Partition P1;
+  Partition P2;
+  for (int i = 100; i < Size; i++)
+    P1.add(i % 100, i);
+  for (int i = 6; i < Size; i++)
+    P2.add(i % 6, i);
+
+  Partition Copy;
+  Copy.assign(P1);
+  EXPECT_TRUE(Copy.equals(P1));
+
+  P1.refine(&P2);
+  for (int i = 0; i < Size; i += 7) {
+    EXPECT_EQ(P1.getRepresentative(i), P1.getRepresentative(i % 300));
+    EXPECT_NE(P1.getRepresentative(i), P1.getRepresentative((i + 1) % 300));
+  }
+  SmallVector<SmallVector<Element, 4>, 4> Classes;
+  P1.getClasses(Classes);
+  EXPECT_EQ(300u, Classes.size());
+  EXPECT_FALSE(Copy.equals(P1));
+
+  // Elements that are singletons in the refining partition become
+  // singletons.
+  for (int i = 0; i < Size; i += 2)
+    P2.makeSingleton(i);
+  P1.refine(&P2);
+  for (int i = 0; i < Size; i += 2)
+    EXPECT_TRUE(P1.isSingleton(i));
+  for (int i = 301; i < Size; i += 2)
+    EXPECT_EQ(P1.getRepresentative(i), P1.getRepresentative(i % 300));
+}
+
+// Test the operations of the dataflow analysis repeated many times on
+// partitions with a few large classes: facts are copied, changed by
+// assignments and merged by refinement at each of a sequence of blocks.
+TEST(PartitionRefinementTest, RepeatedRefinement) {
+  const int Size = 5000;
+  const int Blocks = 200;
+  Partition Facts;
+  for (int i = 1; i < Size; i++)
+    Facts.add(0, i);
+
+  Partition Branch;
+  for (int b = 0; b < Blocks; b++) {
+    Branch.assign(Facts);
+    // An assignment on one branch separates an element from its class,
+    // and adds it to the class of another element.
+    Branch.makeSingleton(b);
+    Branch.add(Size + b, b);
+    Facts.refine(&Branch);
+    EXPECT_TRUE(Facts.isSingleton(b));
+    EXPECT_FALSE(Facts.equals(Branch));
+  }
+  for (int i = Blocks; i < Size; i++)
+    EXPECT_EQ(Facts.getRepresentative(Blocks), Facts.getRepresentative(i));
+  SmallVector<SmallVector<Element, 4>, 4> Classes;
+  Facts.getClasses(Classes);
+  ASSERT_EQ(1u, Classes.size());
+  EXPECT_EQ(unsigned(Size - Blocks), Classes[0].size());
+}
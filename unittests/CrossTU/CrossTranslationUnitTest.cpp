@@ -25,8 +25,9 @@ namespace {
 
 class CTUASTConsumer : public clang::ASTConsumer {
 public:
-  explicit CTUASTConsumer(clang::CompilerInstance &CI, bool *Success)
-      : CTU(CI), Success(Success) {}
+  explicit CTUASTConsumer(clang::CompilerInstance &CI, bool *Success,
+                          bool BinaryIndex)
+      : CTU(CI), Success(Success), BinaryIndex(BinaryIndex) {}
 
   void HandleTranslationUnit(ASTContext &Ctx) {
     const TranslationUnitDecl *TU = Ctx.getTranslationUnitDecl();
@@ -51,7 +52,10 @@ public:
     ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("index", "txt", IndexFD,
                                                     IndexFileName));
     llvm::ToolOutputFile IndexFile(IndexFileName, IndexFD);
-    IndexFile.os() << "c:@F@f#I# " << ASTFileName << "\n";
+    llvm::StringMap<std::string> Index;
+    Index["c:@F@f#I#"] = ASTFileName.str();
+    IndexFile.os() << (BinaryIndex ? createCrossTUBinaryIndex(Index)
+                                   : createCrossTUIndexString(Index));
     IndexFile.os().flush();
     EXPECT_TRUE(llvm::sys::fs::exists(IndexFileName));
 
@@ -83,20 +87,23 @@ public:
 private:
   CrossTranslationUnitContext CTU;
   bool *Success;
+  bool BinaryIndex;
 };
 
 class CTUAction : public clang::ASTFrontendAction {
 public:
-  CTUAction(bool *Success) : Success(Success) {}
+  CTUAction(bool *Success, bool BinaryIndex = false)
+      : Success(Success), BinaryIndex(BinaryIndex) {}
 
 protected:
   std::unique_ptr<clang::ASTConsumer>
   CreateASTConsumer(clang::CompilerInstance &CI, StringRef) override {
-    return llvm::make_unique<CTUASTConsumer>(CI, Success);
+    return llvm::make_unique<CTUASTConsumer>(CI, Success, BinaryIndex);
   }
 
 private:
   bool *Success;
+  bool BinaryIndex;
 };
 
 } // end namespace
@@ -107,6 +114,14 @@ TEST(CrossTranslationUnit, CanLoadFunctionDefinition) {
   EXPECT_TRUE(Success);
 }
 
+TEST(CrossTranslationUnit, CanLoadFunctionDefinitionFromBinaryIndex) {
+  bool Success = false;
+  EXPECT_TRUE(tooling::runToolOnCode(new CTUAction(&Success,
+                                                   /*BinaryIndex=*/true),
+                                     "int f(int);"));
+  EXPECT_TRUE(Success);
+}
+
 TEST(CrossTranslationUnit, IndexFormatCanBeParsed) {
   llvm::StringMap<std::string> Index;
   Index["a"] = "/b/f1";
@@ -154,5 +169,46 @@ TEST(CrossTranslationUnit, CTUDirIsHandledCorrectly) {
   EXPECT_EQ(ParsedIndex["a"], "/ctudir/b/c/d");
 }
 
+TEST(CrossTranslationUnit, BinaryIndexCanBeLookedUp) {
+  llvm::StringMap<std::string> Index;
+  for (unsigned I = 0; I != 100; ++I)
+    Index["c:@F@f" + std::to_string(I)] = "/b/f" + std::to_string(I % 7);
+  std::string Buffer = createCrossTUBinaryIndex(Index);
+
+  EXPECT_TRUE(isCrossTUBinaryIndex(Buffer));
+  ASSERT_TRUE(isValidCrossTUBinaryIndex(Buffer));
+  for (const auto &E : Index)
+    EXPECT_EQ(E.getValue(), lookupCrossTUBinaryIndex(Buffer, E.getKey()));
+  EXPECT_EQ("", lookupCrossTUBinaryIndex(Buffer, "c:@F@g"));
+
+  EXPECT_FALSE(isCrossTUBinaryIndex(createCrossTUIndexString(Index)));
+  EXPECT_FALSE(isValidCrossTUBinaryIndex(Buffer.substr(0, 16)));
+}
+
+TEST(CrossTranslationUnit, BoundsSummariesAreMerged) {
+  int SummaryFD;
+  llvm::SmallString<256> SummaryFileName;
+  ASSERT_FALSE(llvm::sys::fs::createTemporaryFile("summary", "txt", SummaryFD,
+                                                  SummaryFileName));
+  llvm::ToolOutputFile SummaryFile(SummaryFileName, SummaryFD);
+  SummaryFile.os() << "c:@F@f 2 8 -1 4\n"
+                   << "c:@F@g 1\n"
+                   << "c:@F@f 1 6 3\n";
+  SummaryFile.os().flush();
+  llvm::Expected<llvm::StringMap<sema::BoundsSummary::CallBounds>>
+      SummaryOrErr = parseBoundsSummary(SummaryFileName);
+  ASSERT_TRUE((bool)SummaryOrErr);
+  llvm::StringMap<sema::BoundsSummary::CallBounds> Summary =
+      SummaryOrErr.get();
+  EXPECT_EQ(Summary.size(), 2u);
+  EXPECT_EQ(Summary["c:@F@f"].CallSites, 3u);
+  ASSERT_EQ(Summary["c:@F@f"].MinElements.size(), 3u);
+  EXPECT_EQ(Summary["c:@F@f"].MinElements[0], 6);
+  EXPECT_EQ(Summary["c:@F@f"].MinElements[1], -1);
+  EXPECT_EQ(Summary["c:@F@f"].MinElements[2], -1);
+  EXPECT_EQ(Summary["c:@F@g"].CallSites, 1u);
+  EXPECT_TRUE(Summary["c:@F@g"].MinElements.empty());
+}
+
 } // end namespace cross_tu
 } // end namespace clang
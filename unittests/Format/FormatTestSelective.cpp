@@ -34,6 +34,18 @@ protected:
     return *Result;
   }
 
+  std::string formatIncrementally(llvm::StringRef Code, unsigned Offset,
+                                  unsigned Length) {
+    std::vector<tooling::Range> Ranges(1, tooling::Range(Offset, Length));
+    FormattingAttemptStatus Status;
+    tooling::Replacements Replaces =
+        reformatIncrementally(Style, Code, Ranges, "<stdin>", &Status);
+    EXPECT_TRUE(Status.FormatComplete) << Code << "\n\n";
+    auto Result = applyAllReplacements(Code, Replaces);
+    EXPECT_TRUE(static_cast<bool>(Result));
+    return *Result;
+  }
+
   FormatStyle Style = getLLVMStyle();
 };
 
@@ -538,6 +550,49 @@ TEST_F(FormatTestSelective, KeepsIndentAfterCommentSectionImport) {
   EXPECT_EQ(Code, format(Code, 47, 1));
 }
 
+TEST_F(FormatTestSelective, IncrementalFormattingMatchesFullFormatting) {
+  std::string Code = "#include <a.h>\n"
+                     "\n"
+                     "namespace n {\n"
+                     "int  a;\n"
+                     "\n"
+                     "void  f() {\n"
+                     "  int x =1;\n"
+                     "\n"
+                     "  g( x);\n"
+                     "}\n"
+                     "\n"
+                     "struct S {int  b;};\n"
+                     "\n"
+                     "// clang-format off\n"
+                     "int   c;\n"
+                     "\n"
+                     "int   d;\n"
+                     "// clang-format on\n"
+                     "\n"
+                     "#if X\n"
+                     "int  e;\n"
+                     "\n"
+                     "#endif\n"
+                     "int  g = 1 ;\n"
+                     "}\n"
+                     "\n"
+                     "\n"
+                     "int  h();\n";
+  for (unsigned Offset = 0; Offset < Code.size(); ++Offset) {
+    EXPECT_EQ(format(Code, Offset, 0), formatIncrementally(Code, Offset, 0))
+        << "at offset " << Offset;
+    unsigned Length = std::min<unsigned>(4, Code.size() - Offset);
+    EXPECT_EQ(format(Code, Offset, Length),
+              formatIncrementally(Code, Offset, Length))
+        << "at offset " << Offset;
+  }
+
+  // A style derived from the whole file falls back to formatting all of it.
+  Style = getGoogleStyle();
+  EXPECT_EQ(format(Code, 40, 0), formatIncrementally(Code, 40, 0));
+}
+
 } // end namespace
 } // end namespace format
 } // end namespace clang
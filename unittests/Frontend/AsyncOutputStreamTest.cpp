@@ -0,0 +1,88 @@
+//===- unittests/Frontend/AsyncOutputStreamTest.cpp -----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/AsyncOutputStream.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+class AsyncOutputStreamTest : public ::testing::Test {
+protected:
+  SmallString<128> Path;
+
+  std::shared_ptr<AsyncFileWriter> createWriter(size_t ChunkSize) {
+    int FD;
+    EXPECT_FALSE(sys::fs::createTemporaryFile("async-output", "o", FD, Path));
+    return std::make_shared<AsyncFileWriter>(
+        llvm::make_unique<raw_fd_ostream>(FD, /*shouldClose=*/true),
+        ChunkSize);
+  }
+
+  std::string readFile() {
+    auto Buffer = MemoryBuffer::getFile(Path);
+    EXPECT_TRUE(bool(Buffer));
+    return Buffer ? (*Buffer)->getBuffer().str() : std::string();
+  }
+
+  void TearDown() override { sys::fs::remove(Path); }
+};
+
+TEST_F(AsyncOutputStreamTest, write) {
+  std::string Expected;
+  {
+    AsyncOutputStream OS(createWriter(16));
+    for (unsigned I = 0; I != 100; ++I) {
+      OS << I << ',';
+      Expected += std::to_string(I) + ',';
+    }
+    EXPECT_EQ(Expected.size(), OS.tell());
+  }
+  EXPECT_EQ(Expected, readFile());
+}
+
+TEST_F(AsyncOutputStreamTest, pwrite) {
+  {
+    AsyncOutputStream OS(createWriter(16));
+    OS.SetUnbuffered();
+    // The first 20 bytes are queued, the last 10 are still pending.
+    OS << std::string(20, '.') << std::string(10, '.');
+    OS.pwrite("head", 4, 0);
+    OS.pwrite("split", 5, 18);
+    OS.pwrite("tail", 4, 26);
+    OS << "end";
+  }
+  EXPECT_EQ("head" + std::string(14, '.') + "split..." + "tailend",
+            readFile());
+}
+
+TEST_F(AsyncOutputStreamTest, closeBeforeStreamIsDestroyed) {
+  {
+    auto Writer = createWriter(16);
+    AsyncOutputStream OS(Writer);
+    OS << std::string(20, 'a');
+    OS.flush();
+    Writer->close();
+    EXPECT_EQ(std::string(20, 'a'), readFile());
+
+    // Later writes go to the file directly.
+    OS << "bb";
+    OS.flush();
+    OS.pwrite("c", 1, 0);
+  }
+  EXPECT_EQ("c" + std::string(19, 'a') + "bb", readFile());
+}
+
+} // anonymous namespace
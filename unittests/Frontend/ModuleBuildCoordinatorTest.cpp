@@ -0,0 +1,105 @@
+//===- unittests/Frontend/ModuleBuildCoordinatorTest.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Frontend/ModuleBuildCoordinator.h"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+TEST(ModuleBuildCoordinatorTest, claim) {
+  ModuleBuildCoordinator Coordinator;
+  {
+    auto Claim = Coordinator.claim("A.pcm", std::chrono::seconds(0));
+    EXPECT_TRUE(Claim.isOwned());
+    EXPECT_TRUE(Coordinator.isBeingBuilt("A.pcm"));
+    EXPECT_FALSE(Coordinator.isBeingBuilt("B.pcm"));
+
+    EXPECT_EQ(ModuleBuildCoordinator::CS_Busy,
+              Coordinator.tryClaim("A.pcm").getState());
+    EXPECT_EQ(ModuleBuildCoordinator::CS_Busy,
+              Coordinator.claim("A.pcm", std::chrono::seconds(0)).getState());
+    EXPECT_TRUE(Coordinator.tryClaim("B.pcm").isOwned());
+    EXPECT_FALSE(Coordinator.isBeingBuilt("B.pcm"));
+  }
+  EXPECT_FALSE(Coordinator.isBeingBuilt("A.pcm"));
+  EXPECT_TRUE(Coordinator.tryClaim("A.pcm").isOwned());
+}
+
+TEST(ModuleBuildCoordinatorTest, claimWaitsForOtherThread) {
+  ModuleBuildCoordinator Coordinator;
+  std::atomic<bool> Built(false);
+  auto Claim = Coordinator.claim("A.pcm", std::chrono::seconds(0));
+  ASSERT_TRUE(Claim.isOwned());
+
+  std::thread Builder([&](ModuleBuildCoordinator::BuildClaim Claim) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    Built = true;
+  }, std::move(Claim));
+  auto Other = Coordinator.claim("A.pcm", std::chrono::seconds(60));
+  EXPECT_EQ(ModuleBuildCoordinator::CS_BuiltElsewhere, Other.getState());
+  EXPECT_TRUE(Built);
+  Builder.join();
+  EXPECT_FALSE(Coordinator.isBeingBuilt("A.pcm"));
+}
+
+TEST(ModuleBuildCoordinatorTest, buildInDependencyOrder) {
+  // 0 uses 1 and 2, which both use 3; 4 stands alone.
+  std::vector<SmallVector<unsigned, 2>> Dependencies(5);
+  Dependencies[0] = {1, 2};
+  Dependencies[1] = {3};
+  Dependencies[2] = {3};
+
+  std::atomic<unsigned> Order(0);
+  std::vector<unsigned> BuiltAt(5);
+  std::vector<bool> Built = ModuleBuildCoordinator::buildInDependencyOrder(
+      4, Dependencies, [&](unsigned Node) {
+        BuiltAt[Node] = Order++;
+        return true;
+      });
+
+  EXPECT_EQ(std::vector<bool>(5, true), Built);
+  EXPECT_LT(BuiltAt[3], BuiltAt[1]);
+  EXPECT_LT(BuiltAt[3], BuiltAt[2]);
+  EXPECT_LT(BuiltAt[1], BuiltAt[0]);
+  EXPECT_LT(BuiltAt[2], BuiltAt[0]);
+}
+
+TEST(ModuleBuildCoordinatorTest, buildInDependencyOrderFailure) {
+  // 0 uses 1, and 1 and 2 use each other. The use of 1 by 2 closes the
+  // cycle and is ignored, so 2 is built first; it fails, so neither 1 nor 0
+  // is built. 3 does not depend on the others.
+  std::vector<SmallVector<unsigned, 2>> Dependencies(4);
+  Dependencies[0] = {1};
+  Dependencies[1] = {2};
+  Dependencies[2] = {1};
+  Dependencies[3] = {};
+
+  std::vector<char> Attempted(4, false);
+  std::vector<bool> Built = ModuleBuildCoordinator::buildInDependencyOrder(
+      2, Dependencies, [&](unsigned Node) {
+        Attempted[Node] = true;
+        return Node != 2;
+      });
+
+  EXPECT_FALSE(Built[0]);
+  EXPECT_FALSE(Built[1]);
+  EXPECT_FALSE(Built[2]);
+  EXPECT_TRUE(Built[3]);
+  EXPECT_FALSE(Attempted[0]);
+  EXPECT_FALSE(Attempted[1]);
+  EXPECT_TRUE(Attempted[2]);
+  EXPECT_TRUE(Attempted[3]);
+}
+
+} // anonymous namespace
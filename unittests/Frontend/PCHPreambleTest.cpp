@@ -153,6 +153,44 @@ TEST_F(PCHPreambleTest, ReparseWithOverriddenFileDoesNotInvalidatePreamble) {
   ASSERT_EQ(initialCounts[2], GetFileReadCount(Header2));
 }
 
+TEST_F(PCHPreambleTest, ReparseWithAppendedIncludeExtendsPreamble) {
+  std::string Header1 = "//./header1.h";
+  std::string Header2 = "//./header2.h";
+  std::string MainName = "//./main.cpp";
+  AddFile(Header1, "static const int ONE = 1;\n");
+  AddFile(Header2, "static const int TWO = 2;\n");
+  AddFile(MainName,
+    "#include \"//./header1.h\"\n"
+    "int main() { return ONE; }");
+
+  std::unique_ptr<ASTUnit> AST(ParseAST(MainName));
+  ASSERT_TRUE(AST.get());
+  ASSERT_FALSE(AST->getDiagnostics().hasErrorOccurred());
+
+  unsigned Header1ReadCount = GetFileReadCount(Header1);
+  ASSERT_EQ(0u, GetFileReadCount(Header2));
+
+  RemapFile(MainName,
+    "#include \"//./header1.h\"\n"
+    "#include \"//./header2.h\"\n"
+    "int main() { return ONE + TWO; }");
+
+  ASSERT_TRUE(ReparseAST(AST));
+  ASSERT_FALSE(AST->getDiagnostics().hasErrorOccurred());
+
+  // Only the new include was precompiled.
+  ASSERT_EQ(Header1ReadCount, GetFileReadCount(Header1));
+  ASSERT_NE(0u, GetFileReadCount(Header2));
+
+  unsigned Header2ReadCount = GetFileReadCount(Header2);
+
+  // The extended preamble is reused as any other.
+  ASSERT_TRUE(ReparseAST(AST));
+  ASSERT_FALSE(AST->getDiagnostics().hasErrorOccurred());
+  ASSERT_EQ(Header1ReadCount, GetFileReadCount(Header1));
+  ASSERT_EQ(Header2ReadCount, GetFileReadCount(Header2));
+}
+
 TEST_F(PCHPreambleTest, ParseWithBom) {
   std::string Header = "//./header.h";
   std::string Main = "//./main.cpp";
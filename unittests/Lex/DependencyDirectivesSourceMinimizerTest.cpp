@@ -0,0 +1,68 @@
+//===- unittests/Lex/DependencyDirectivesSourceMinimizerTest.cpp ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Lex/DependencyDirectivesSourceMinimizer.h"
+#include "llvm/ADT/SmallString.h"
+#include "gtest/gtest.h"
+
+using namespace clang;
+using namespace llvm;
+
+namespace {
+
+// Minimize Input, and return the result, or "<error>".
+std::string minimize(StringRef Input) {
+  SmallString<128> Out;
+  if (minimizeSourceToDependencyDirectives(Input, Out))
+    return "<error>";
+  return Out.str();
+}
+
+TEST(MinimizeSourceTest, KeepsDirectives) {
+  EXPECT_EQ("#include <a.h>\n#include \"b.h\"\n#import <c.h>\n",
+            minimize("#include <a.h>\n  #  include \"b.h\" // b\n"
+                     "int x;\n#import <c.h>"));
+  EXPECT_EQ("#ifdef A\n#define B(x) x + 1\n#elif defined(C)\n#else\n"
+            "#pragma once\n#endif\n",
+            minimize("#ifdef A\n#define B(x) x /* one */ + 1\nvoid f();\n"
+                     "#elif defined(C)\n#else\n#pragma once\n#endif\n"));
+  EXPECT_EQ("#include MACRO\n#undef X\n", minimize("#include MACRO\n#undef X"));
+}
+
+TEST(MinimizeSourceTest, DropsOtherDirectives) {
+  EXPECT_EQ("#define A\n",
+            minimize("#error no\n#warning no\n#line 5\n# 33 \"x.c\"\n#\n"
+                     "#define A\n"));
+}
+
+TEST(MinimizeSourceTest, JoinsContinuedLines) {
+  EXPECT_EQ("#define A 1 + 2\n", minimize("#define A 1 \\\n  + 2\n"));
+  EXPECT_EQ("#define A 1 + 2\n", minimize("#define A 1 /* \n */ + 2\n"));
+  EXPECT_EQ("#include <a.h>\n", minimize("#inc\\\nlude <a.h>\n"));
+}
+
+TEST(MinimizeSourceTest, IgnoresHashesInCommentsAndLiterals) {
+  EXPECT_EQ("", minimize("/*\n#define A\n*/\n"));
+  EXPECT_EQ("", minimize("// \\\n#define A\n"));
+  EXPECT_EQ("", minimize("const char *s = \"\\\n#define A\";\n"));
+  EXPECT_EQ("", minimize("const char *s = R\"x(\n#define A\n)x\";\n"));
+  EXPECT_EQ("", minimize("int x = 1'000; /* '\n#define A */\n"));
+  EXPECT_EQ("", minimize("/* a\n*/ #define A\n"));
+  EXPECT_EQ("#define A\n", minimize("/* a */ #define A\n"));
+  EXPECT_EQ("#define A \"// /*\" '\"'\n",
+            minimize("#define A \"// /*\" '\"'\n"));
+  EXPECT_EQ("#include <a//b.h>\n", minimize("#include <a//b.h>\n"));
+}
+
+TEST(MinimizeSourceTest, Errors) {
+  EXPECT_EQ("<error>", minimize("#define A\n/* unterminated"));
+  EXPECT_EQ("<error>", minimize("const char *s = R\"x(unterminated)\";\n"));
+}
+
+} // end anonymous namespace
@@ -478,4 +478,24 @@ TEST_F(LexerTest, AvoidPastEndOfStringDereference) {
   EXPECT_TRUE(LexedTokens.empty());
 }
 
+TEST_F(LexerTest, SkipLongRunsOfCharacters) {
+  // Runs of whitespace, line comment characters and identifier characters
+  // that are shorter and longer than the 16-byte chunks the lexer scans, and
+  // that end at each offset within a chunk.
+  for (unsigned Length = 1; Length != 40; ++Length) {
+    std::string Run(Length, 'a');
+    std::string Spaces(Length, ' ');
+    std::string TextToLex = Spaces + "\t\f\v" + Run + "_0Z" + Spaces + "1\n" +
+                            "// " + Run + " \\\n" + Run + "\n" + Run;
+    std::vector<Token> LexedTokens =
+        CheckLex(TextToLex, {tok::identifier, tok::numeric_constant,
+                             tok::identifier});
+    ASSERT_EQ(3u, LexedTokens.size());
+    EXPECT_EQ(Length + 3, LexedTokens[0].getLength());
+    EXPECT_TRUE(LexedTokens[1].hasLeadingSpace());
+    EXPECT_TRUE(LexedTokens[2].isAtStartOfLine());
+    EXPECT_EQ(Length, LexedTokens[2].getLength());
+  }
+}
+
 } // anonymous namespace
@@ -48,4 +48,48 @@ TEST(RewriteBuffer, TagRanges) {
   EXPECT_EQ(Output, Result);
 }
 
+TEST(RewriteBuffer, WriteEditedBuffer) {
+  StringRef Input = "int *p; int *q;";
+  RewriteEdit Edits[] = {RewriteEdit(0, 0, "/* p */ "),
+                         RewriteEdit(0, 5, "_Ptr<int> "),
+                         RewriteEdit(8, 6, "_Array_ptr<int> q"),
+                         RewriteEdit(15, 0, "\n")};
+
+  std::string Result;
+  raw_string_ostream OS(Result);
+  EXPECT_FALSE(writeEditedBuffer(OS, Input, Edits));
+  OS.flush();
+  EXPECT_EQ("/* p */ _Ptr<int> p; _Array_ptr<int> q;\n", Result);
+
+  // The result is the same as with a RewriteBuffer.
+  RewriteBuffer Buf;
+  Buf.Initialize(Input);
+  for (const RewriteEdit &E : Edits) {
+    if (E.OrigLength == 0)
+      Buf.InsertTextBefore(E.OrigOffset, E.NewText);
+    else
+      Buf.ReplaceText(E.OrigOffset, E.OrigLength, E.NewText);
+  }
+  std::string BufResult;
+  raw_string_ostream BufOS(BufResult);
+  Buf.write(BufOS);
+  BufOS.flush();
+  EXPECT_EQ(Result, BufResult);
+}
+
+TEST(RewriteBuffer, WriteEditedBufferFailures) {
+  StringRef Input = "hello world";
+  std::string Result;
+  raw_string_ostream OS(Result);
+
+  RewriteEdit Overlapping[] = {RewriteEdit(0, 5, "a"), RewriteEdit(4, 1, "b")};
+  EXPECT_TRUE(writeEditedBuffer(OS, Input, Overlapping));
+  RewriteEdit Unsorted[] = {RewriteEdit(6, 5, "a"), RewriteEdit(0, 5, "b")};
+  EXPECT_TRUE(writeEditedBuffer(OS, Input, Unsorted));
+  RewriteEdit PastEnd[] = {RewriteEdit(6, 6, "a")};
+  EXPECT_TRUE(writeEditedBuffer(OS, Input, PastEnd));
+  OS.flush();
+  EXPECT_TRUE(Result.empty());
+}
+
 } // anonymous namespace
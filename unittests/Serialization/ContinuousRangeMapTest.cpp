@@ -0,0 +1,133 @@
+//===- unittests/Serialization/ContinuousRangeMapTest.cpp -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "clang/Serialization/ContinuousRangeMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <random>
+
+using namespace llvm;
+using namespace clang;
+
+namespace {
+
+typedef ContinuousRangeMap<uint32_t, int, 2> RemapType;
+
+// Map the local IDs of an AST file that imports NumModules modules of
+// IDsPerModule declarations each, as ReadModuleOffsetMap does.
+void buildRemap(RemapType &Remap, unsigned NumModules, unsigned IDsPerModule) {
+  RemapType::Builder Builder(Remap);
+  for (unsigned M = NumModules; M != 0; --M)
+    Builder.insert(std::make_pair((M - 1) * IDsPerModule, int(M * 7)));
+}
+
+int expectedOffset(uint32_t LocalID, unsigned IDsPerModule) {
+  return (LocalID / IDsPerModule + 1) * 7;
+}
+
+TEST(ContinuousRangeMapTest, find) {
+  RemapType Remap;
+  EXPECT_EQ(Remap.end(), Remap.find(0));
+
+  Remap.insert(std::make_pair(10u, 1));
+  Remap.insert(std::make_pair(20u, 2));
+  Remap.insert(std::make_pair(30u, 3));
+
+  EXPECT_EQ(Remap.end(), Remap.find(9));
+  EXPECT_EQ(1, Remap.find(10)->second);
+  EXPECT_EQ(1, Remap.find(19)->second);
+  EXPECT_EQ(2, Remap.find(20)->second);
+  EXPECT_EQ(3, Remap.find(30)->second);
+  EXPECT_EQ(3, Remap.find(1000)->second);
+  // Lookups behind the last one found.
+  EXPECT_EQ(1, Remap.find(15)->second);
+  EXPECT_EQ(Remap.end(), Remap.find(0));
+  EXPECT_EQ(2, Remap.find(25)->second);
+}
+
+TEST(ContinuousRangeMapTest, insertOrReplace) {
+  RemapType Remap;
+  Remap.insert(std::make_pair(10u, 1));
+  Remap.insert(std::make_pair(30u, 3));
+  EXPECT_EQ(1, Remap.find(25)->second);
+
+  Remap.insertOrReplace(std::make_pair(20u, 2));
+  EXPECT_EQ(2, Remap.find(25)->second);
+  EXPECT_EQ(1, Remap.find(15)->second);
+
+  Remap.insertOrReplace(std::make_pair(10u, 4));
+  EXPECT_EQ(4, Remap.find(15)->second);
+  EXPECT_EQ(3, Remap.find(30)->second);
+}
+
+TEST(ContinuousRangeMapTest, builderRemovesDuplicates) {
+  RemapType Remap;
+  {
+    RemapType::Builder Builder(Remap);
+    Builder.insert(std::make_pair(20u, 2));
+    Builder.insert(std::make_pair(0u, 0));
+    Builder.insert(std::make_pair(0u, 0));
+    Builder.insert(std::make_pair(10u, 1));
+  }
+  EXPECT_EQ(3, std::distance(Remap.begin(), Remap.end()));
+  EXPECT_EQ(0, Remap.find(5)->second);
+  EXPECT_EQ(1, Remap.find(10)->second);
+  EXPECT_EQ(2, Remap.find(25)->second);
+}
+
+TEST(ContinuousRangeMapTest, manyRanges) {
+  const unsigned NumModules = 300, IDsPerModule = 50;
+  RemapType Remap;
+  buildRemap(Remap, NumModules, IDsPerModule);
+
+  std::mt19937 Random(42);
+  for (unsigned I = 0; I != 10000; ++I) {
+    uint32_t LocalID = Random() % (NumModules * IDsPerModule);
+    ASSERT_EQ(expectedOffset(LocalID, IDsPerModule),
+              Remap.find(LocalID)->second);
+  }
+  for (uint32_t LocalID = 0; LocalID != NumModules * IDsPerModule; ++LocalID)
+    ASSERT_EQ(expectedOffset(LocalID, IDsPerModule),
+              Remap.find(LocalID)->second);
+}
+
+// Micro-benchmark of the local to global ID remapping of an AST file that
+// imports many modules. Run with --gtest_also_run_disabled_tests.
+TEST(ContinuousRangeMapTest, DISABLED_benchmark) {
+  const unsigned NumModules = 500, IDsPerModule = 200;
+  const unsigned NumLookups = 20000000;
+  RemapType Remap;
+  buildRemap(Remap, NumModules, IDsPerModule);
+
+  std::mt19937 Random(42);
+  std::vector<uint32_t> RandomIDs(1 << 16);
+  for (uint32_t &ID : RandomIDs)
+    ID = Random() % (NumModules * IDsPerModule);
+
+  auto measure = [&](const char *Name, llvm::function_ref<uint32_t(unsigned)>
+                                           NextID) {
+    auto Start = std::chrono::steady_clock::now();
+    int64_t Sum = 0;
+    for (unsigned I = 0; I != NumLookups; ++I)
+      Sum += Remap.find(NextID(I))->second;
+    std::chrono::duration<double, std::nano> Elapsed =
+        std::chrono::steady_clock::now() - Start;
+    outs() << Name << ": " << Elapsed.count() / NumLookups
+           << " ns per lookup (checksum " << Sum << ")\n";
+  };
+  measure("sequential", [&](unsigned I) {
+    return I % (NumModules * IDsPerModule);
+  });
+  measure("random", [&](unsigned I) {
+    return RandomIDs[I % RandomIDs.size()];
+  });
+}
+
+} // anonymous namespace
@@ -10,6 +10,7 @@
 #include "clang/AST/DeclCXX.h"
 #include "clang/AST/DeclGroup.h"
 #include "clang/Frontend/FrontendAction.h"
+#include "clang/Tooling/BinaryCompilationDatabase.h"
 #include "clang/Tooling/FileMatchTrie.h"
 #include "clang/Tooling/JSONCompilationDatabase.h"
 #include "clang/Tooling/Tooling.h"
@@ -360,6 +361,71 @@ TEST(findCompileArgsInJsonDatabase, FindsEntry) {
   EXPECT_EQ("command4", FoundCommand.CommandLine[0]) << ErrorMessage;
 }
 
+static std::unique_ptr<BinaryCompilationDatabase>
+convertJsonDatabase(StringRef JSONDatabase, std::string &ErrorMessage) {
+  std::unique_ptr<CompilationDatabase> Database(
+      JSONCompilationDatabase::loadFromBuffer(JSONDatabase, ErrorMessage,
+                                              JSONCommandLineSyntax::Gnu));
+  if (!Database)
+    return nullptr;
+  return BinaryCompilationDatabase::loadFromBuffer(
+      llvm::MemoryBuffer::getMemBufferCopy(
+          BinaryCompilationDatabase::serialize(*Database)),
+      ErrorMessage);
+}
+
+TEST(BinaryCompilationDatabase, ErrsOnInvalidFormat) {
+  std::string ErrorMessage;
+  EXPECT_EQ(nullptr, BinaryCompilationDatabase::loadFromBuffer(
+                         llvm::MemoryBuffer::getMemBuffer(""), ErrorMessage));
+  EXPECT_EQ(nullptr,
+            BinaryCompilationDatabase::loadFromBuffer(
+                llvm::MemoryBuffer::getMemBuffer("[{\"file\":\"a\"}]"),
+                ErrorMessage));
+  std::string Truncated =
+      BinaryCompilationDatabase::serialize(FixedCompilationDatabase(
+          ".", std::vector<std::string>()));
+  Truncated.resize(Truncated.size() - 8);
+  EXPECT_EQ(nullptr, BinaryCompilationDatabase::loadFromBuffer(
+                         llvm::MemoryBuffer::getMemBuffer(Truncated),
+                         ErrorMessage));
+}
+
+TEST(BinaryCompilationDatabase, FindsEntries) {
+  std::string JsonDatabase = "[";
+  for (int I = 0; I < 10; ++I) {
+    if (I > 0) JsonDatabase += ",";
+    JsonDatabase +=
+      ("{\"directory\":\"//net/directory" + Twine(I) + "\"," +
+        "\"command\":\"command" + Twine(I) + " -c file\","
+        "\"file\":\"file" + Twine(I) + "\"}").str();
+  }
+  JsonDatabase += ",{\"directory\":\"//net/directory4\","
+                  "\"arguments\":[\"other\",\"-c\",\"file\"],"
+                  "\"file\":\"//net/directory4/file4\","
+                  "\"output\":\"file4.o\"}]";
+  std::string ErrorMessage;
+  std::unique_ptr<BinaryCompilationDatabase> Database =
+      convertJsonDatabase(JsonDatabase, ErrorMessage);
+  ASSERT_TRUE((bool)Database) << ErrorMessage;
+
+  std::vector<CompileCommand> Commands =
+      Database->getCompileCommands("//net/directory4/file4");
+  ASSERT_EQ(2u, Commands.size());
+  EXPECT_EQ("//net/directory4", Commands[0].Directory);
+  EXPECT_EQ("file4", Commands[0].Filename);
+  EXPECT_EQ(std::vector<std::string>({"command4", "-c", "file"}),
+            Commands[0].CommandLine);
+  EXPECT_EQ("", Commands[0].Output);
+  EXPECT_EQ(std::vector<std::string>({"other", "-c", "file"}),
+            Commands[1].CommandLine);
+  EXPECT_EQ("file4.o", Commands[1].Output);
+
+  EXPECT_TRUE(Database->getCompileCommands("//net/directory4/file5").empty());
+  EXPECT_EQ(10u, Database->getAllFiles().size());
+  EXPECT_EQ(11u, Database->getAllCompileCommands().size());
+}
+
 static std::vector<std::string> unescapeJsonCommandLine(StringRef Command) {
   std::string JsonDatabase =
     ("[{\"directory\":\"//net/root\", \"file\":\"test\", \"command\": \"" +
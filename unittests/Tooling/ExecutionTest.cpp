@@ -13,6 +13,7 @@
 #include "clang/Frontend/ASTUnit.h"
 #include "clang/Frontend/FrontendAction.h"
 #include "clang/Frontend/FrontendActions.h"
+#include "clang/Tooling/AllTUsExecution.h"
 #include "clang/Tooling/CompilationDatabase.h"
 #include "clang/Tooling/Execution.h"
 #include "clang/Tooling/StandaloneExecution.h"
@@ -224,5 +225,87 @@ TEST(StandaloneToolTest, SimpleActionWithResult) {
       [](StringRef, StringRef Value) { EXPECT_EQ("1", Value); });
 }
 
+class FixedCompilationDatabaseWithFiles : public CompilationDatabase {
+public:
+  FixedCompilationDatabaseWithFiles(Twine Directory,
+                                    ArrayRef<std::string> Files,
+                                    ArrayRef<std::string> CommandLine)
+      : FixedCompilations(Directory, CommandLine), Files(Files) {}
+
+  std::vector<CompileCommand>
+  getCompileCommands(StringRef FilePath) const override {
+    return FixedCompilations.getCompileCommands(FilePath);
+  }
+
+  std::vector<std::string> getAllFiles() const override { return Files; }
+
+  std::vector<CompileCommand> getAllCompileCommands() const override {
+    return std::vector<CompileCommand>();
+  }
+
+private:
+  FixedCompilationDatabase FixedCompilations;
+  std::vector<std::string> Files;
+};
+
+static std::vector<std::string> getResultKeys(ToolResults &Results) {
+  std::vector<std::string> Keys;
+  Results.forEachResult(
+      [&](StringRef Key, StringRef) { Keys.push_back(Key); });
+  std::sort(Keys.begin(), Keys.end());
+  return Keys;
+}
+
+TEST(AllTUsToolTest, AFewFiles) {
+  FixedCompilationDatabaseWithFiles Compilations(
+      ".", {"a.cc", "b.cc", "c.cc", "ignore.cc"}, std::vector<std::string>());
+  AllTUsToolExecutor Executor(Compilations, /*ThreadCount=*/0,
+                              {"a.cc", "b.cc", "c.cc"});
+  Executor.mapVirtualFile("a.cc", "void x() {}");
+  Executor.mapVirtualFile("b.cc", "void y() {}");
+  Executor.mapVirtualFile("c.cc", "void z() {}");
+
+  auto Err = Executor.execute(std::unique_ptr<FrontendActionFactory>(
+      new ReportResultActionFactory(Executor.getExecutionContext())));
+  ASSERT_TRUE(!Err);
+  EXPECT_EQ(std::vector<std::string>({"x", "y", "z"}),
+            getResultKeys(*Executor.getToolResults()));
+}
+
+TEST(AllTUsToolTest, ManyFiles) {
+  unsigned NumFiles = 100;
+  std::vector<std::string> Files;
+  std::vector<std::string> ExpectedSymbols;
+  for (unsigned i = 1; i <= NumFiles; ++i) {
+    Files.push_back("f" + std::to_string(i) + ".cc");
+    ExpectedSymbols.push_back("function_" + std::to_string(i));
+  }
+  FixedCompilationDatabaseWithFiles Compilations(".", Files,
+                                                 std::vector<std::string>());
+  AllTUsToolExecutor Executor(Compilations, /*ThreadCount=*/0);
+  for (unsigned i = 0; i != NumFiles; ++i)
+    Executor.mapVirtualFile(Files[i], "void " + ExpectedSymbols[i] + "() {}");
+
+  auto Err = Executor.execute(std::unique_ptr<FrontendActionFactory>(
+      new ReportResultActionFactory(Executor.getExecutionContext())));
+  ASSERT_TRUE(!Err);
+  std::sort(ExpectedSymbols.begin(), ExpectedSymbols.end());
+  EXPECT_EQ(ExpectedSymbols, getResultKeys(*Executor.getToolResults()));
+}
+
+TEST(AllTUsToolTest, MissingFile) {
+  FixedCompilationDatabaseWithFiles Compilations(
+      ".", {"a.cc", "missing.cc"}, std::vector<std::string>());
+  AllTUsToolExecutor Executor(Compilations, /*ThreadCount=*/2);
+  Executor.mapVirtualFile("a.cc", "void x() {}");
+
+  auto Err = Executor.execute(std::unique_ptr<FrontendActionFactory>(
+      new ReportResultActionFactory(Executor.getExecutionContext())));
+  ASSERT_FALSE(!Err);
+  llvm::consumeError(std::move(Err));
+  EXPECT_EQ(std::vector<std::string>({"x"}),
+            getResultKeys(*Executor.getToolResults()));
+}
+
 } // end namespace tooling
 } // end namespace clang
@@ -502,6 +502,38 @@ TEST_F(ReplacementTest, FailOrderDependentReplacements) {
   EXPECT_EQ("line1\nother\nline3\nline4", Context.getRewrittenText(ID));
 }
 
+TEST_F(ReplacementTest, CreateFromUnsortedReplacements) {
+  std::vector<Replacement> Unsorted = {
+      Replacement("x.cc", 20, 2, "b"),   Replacement("x.cc", 10, 0, "a"),
+      Replacement("x.cc", 0, 3, "345"),  Replacement("x.cc", 10, 0, "a"),
+      Replacement("x.cc", 2, 3, "543"),  Replacement("x.cc", 10, 3, "c"),
+      Replacement("x.cc", UINT_MAX, 0, "#include \"a.h\"\n")};
+  Replacements Expected;
+  for (const Replacement &R : Unsorted) {
+    auto Err = Expected.add(R);
+    EXPECT_TRUE(!Err);
+    llvm::consumeError(std::move(Err));
+  }
+
+  auto Created = Replacements::createFromUnsorted(Unsorted);
+  ASSERT_TRUE(static_cast<bool>(Created));
+  EXPECT_EQ(5u, Created->size());
+  EXPECT_EQ(Expected, *Created);
+
+  Created = Replacements::createFromUnsorted(
+      {Replacement("x.cc", 5, 3, "rehto"), Replacement("x.cc", 5, 3, "other")});
+  EXPECT_FALSE(static_cast<bool>(Created));
+  llvm::consumeError(Created.takeError());
+
+  Replacement WrongPathReplacement("y.cc", 0, 2, "");
+  Created = Replacements::createFromUnsorted(
+      {Replacement("x.cc", 5, 3, ""), WrongPathReplacement});
+  EXPECT_TRUE(checkReplacementError(Created.takeError(),
+                                    replacement_error::wrong_file_path,
+                                    Replacement("x.cc", 5, 3, ""),
+                                    WrongPathReplacement));
+}
+
 TEST_F(ReplacementTest, InvalidSourceLocationFailsApplyAll) {
   Replacements Replaces =
       toReplacements({Replacement(Context.Sources, SourceLocation(), 5, "2")});
@@ -18,6 +18,7 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <thread>
 #define DEBUG_TYPE "libclang-test"
 
 TEST(libclang, clang_parseTranslationUnit2_InvalidArgs) {
@@ -546,6 +547,120 @@ TEST_F(LibclangReparseTest, ReparseWithModule) {
   EXPECT_EQ(0U, clang_getNumDiagnostics(ClangTU));
 }
 
+static unsigned countCompletions(CXCodeCompleteResults *Results,
+                                 llvm::StringRef TypedText) {
+  unsigned Count = 0;
+  for (unsigned I = 0; I != Results->NumResults; ++I) {
+    CXCompletionString Completion = Results->Results[I].CompletionString;
+    for (unsigned C = 0, N = clang_getNumCompletionChunks(Completion); C != N;
+         ++C) {
+      if (clang_getCompletionChunkKind(Completion, C) !=
+          CXCompletionChunk_TypedText)
+        continue;
+      CXString Text = clang_getCompletionChunkText(Completion, C);
+      if (TypedText == clang_getCString(Text))
+        ++Count;
+      clang_disposeString(Text);
+    }
+  }
+  return Count;
+}
+
+TEST_F(LibclangReparseTest, CachedCompletionsAfterPreamble) {
+  std::string HeaderName = "HeaderFile.h";
+  std::string CppName = "CppFile.cpp";
+  WriteFile(HeaderName, "#define HEADER_MACRO 1\nint headerFunction();\n");
+  WriteFile(CppName, "#include \"HeaderFile.h\"\n"
+                     "int firstFunction();\n"
+                     "void f() {\n"
+                     "\n"
+                     "}\n");
+
+  ClangTU = clang_parseTranslationUnit(Index, CppName.c_str(), nullptr, 0,
+                                       nullptr, 0, TUFlags);
+  // Build the preamble, and cache the completions with it.
+  ASSERT_TRUE(ReparseTU(0, nullptr));
+  ASSERT_TRUE(ReparseTU(0, nullptr));
+
+  // Only the declarations after the preamble change.
+  WriteFile(CppName, "#include \"HeaderFile.h\"\n"
+                     "int firstFunction();\n"
+                     "void f() {\n"
+                     "\n"
+                     "}\n"
+                     "int headerFunction();\n"
+                     "#define FILE_MACRO 2\n"
+                     "int secondFunction();\n");
+  ASSERT_TRUE(ReparseTU(0, nullptr));
+
+  CXCodeCompleteResults *Results =
+      clang_codeCompleteAt(ClangTU, CppName.c_str(), 4, 1, nullptr, 0,
+                           clang_defaultCodeCompleteOptions());
+  ASSERT_TRUE(Results);
+  EXPECT_EQ(1U, countCompletions(Results, "headerFunction"));
+  EXPECT_EQ(1U, countCompletions(Results, "HEADER_MACRO"));
+  EXPECT_EQ(1U, countCompletions(Results, "firstFunction"));
+  EXPECT_EQ(1U, countCompletions(Results, "secondFunction"));
+  EXPECT_EQ(1U, countCompletions(Results, "FILE_MACRO"));
+  clang_disposeCodeCompleteResults(Results);
+}
+
+static CXChildVisitResult countFunctionDecls(CXCursor C, CXCursor Parent,
+                                             CXClientData Data) {
+  if (clang_getCursorKind(C) == CXCursor_FunctionDecl) {
+    CXString Name = clang_getCursorSpelling(C);
+    if (clang_getCString(Name)[0] != '\0')
+      ++*static_cast<unsigned *>(Data);
+    clang_disposeString(Name);
+  }
+  return CXChildVisit_Recurse;
+}
+
+TEST_F(LibclangReparseTest, ConcurrentReadsOfFrozenTU) {
+  std::string HeaderName = "HeaderFile.h";
+  std::string CppName = "CppFile.cpp";
+  WriteFile(HeaderName, "int headerFunction();\n"
+                        "struct S { int a; char b; };\n");
+  WriteFile(CppName, "#include \"HeaderFile.h\"\n"
+                     "int firstFunction() { return headerFunction(); }\n"
+                     "int secondFunction(struct S s) { return s.a; }\n");
+
+  ClangTU = clang_parseTranslationUnit(Index, CppName.c_str(), nullptr, 0,
+                                       nullptr, 0, TUFlags);
+  // Build the preamble, so that the header is deserialized lazily.
+  ASSERT_TRUE(ReparseTU(0, nullptr));
+  ASSERT_EQ(CXError_Success, clang_freezeTranslationUnit(ClangTU));
+
+  const unsigned NumThreads = 4;
+  std::vector<unsigned> Counts(NumThreads, 0);
+  std::vector<unsigned> Lines(NumThreads, 0);
+  std::vector<std::thread> Threads;
+  for (unsigned I = 0; I != NumThreads; ++I) {
+    Threads.emplace_back([&, I]() {
+      clang_visitChildren(clang_getTranslationUnitCursor(ClangTU),
+                          countFunctionDecls, &Counts[I]);
+      CXFile File = clang_getFile(ClangTU, CppName.c_str());
+      CXCursor C = clang_getCursor(ClangTU,
+                                   clang_getLocation(ClangTU, File, 3, 5));
+      clang_getSpellingLocation(clang_getCursorLocation(C), nullptr, &Lines[I],
+                                nullptr, nullptr);
+    });
+  }
+  for (std::thread &T : Threads)
+    T.join();
+
+  for (unsigned I = 0; I != NumThreads; ++I) {
+    EXPECT_EQ(3U, Counts[I]);
+    EXPECT_EQ(3U, Lines[I]);
+  }
+
+  // A frozen translation unit cannot be modified anymore.
+  EXPECT_EQ(CXError_Failure,
+            clang_reparseTranslationUnit(ClangTU, 0, nullptr,
+                                         clang_defaultReparseOptions(ClangTU)));
+  EXPECT_EQ(0U, clang_suspendTranslationUnit(ClangTU));
+}
+
 TEST_F(LibclangReparseTest, clang_parseTranslationUnit2FullArgv) {
   // Provide a fake GCC 99.9.9 standard library that always overrides any local
   // GCC installation.
@@ -0,0 +1,289 @@
+#!/usr/bin/env python
+#===- checkedc-bench.py - Runtime overhead of Checked C checks -*- python -*-===#
+#
+#                     The LLVM Compiler Infrastructure
+#
+# This file is distributed under the University of Illinois Open Source
+# License. See LICENSE.TXT for details.
+#
+#===------------------------------------------------------------------------===#
+#
+# Builds each kernel of kernels/ twice, as plain C and with checked pointers,
+# runs both and reports the overhead of the checked version.  A third build
+# with -fcheckedc-check-profile counts how often each dynamic check executes,
+# and a fourth with -fcheckedc-check-calls gives the code size and speed of
+# checks done by calls instead of inline.
+# The results are printed, and written as one line of JSON per kernel.
+#
+#===------------------------------------------------------------------------===#
+
+from __future__ import print_function
+
+import argparse
+import json
+import os
+import shlex
+import subprocess
+import sys
+import time
+
+KERNELS = ['string', 'packet', 'matrix', 'list']
+
+# The kinds reported by the -fcheckedc-check-profile runtime, and the
+# statistics of lib/CodeGen/CGDynamicCheck.cpp that count their checks.
+CHECK_KINDS = [
+  ('explicit', 'NumDynamicChecksExplicit'),
+  ('non-null', 'NumDynamicChecksNonNull'),
+  ('range', 'NumDynamicChecksRange'),
+  ('cast', 'NumDynamicChecksCast'),
+  ('overflow', 'NumDynamicChecksOverflow'),
+]
+
+def which(program):
+  for path in os.environ.get('PATH', '').split(os.pathsep):
+    candidate = os.path.join(path, program)
+    if os.path.isfile(candidate) and os.access(candidate, os.X_OK):
+      return candidate
+  return None
+
+def run(cmd, env=None):
+  proc = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                          env=env, universal_newlines=True)
+  out, err = proc.communicate()
+  if proc.returncode != 0:
+    raise RuntimeError('%s failed with exit code %d:\n%s' %
+                       (' '.join(cmd), proc.returncode, err))
+  return out, err
+
+def compile_kernel(args, source, output, flags, stats_file=None):
+  """Compiles source to the object file output, and returns its path."""
+  cmd = [args.clang, '-fcheckedc-extension', '-c', source, '-o', output]
+  cmd += shlex.split(args.cflags) + flags
+  if stats_file:
+    cmd += ['-Xclang', '-stats-file=' + stats_file]
+  run(cmd)
+  return output
+
+def link(args, objects, output, flags):
+  run([args.clang] + objects + ['-o', output] + flags)
+  return output
+
+def text_size(obj):
+  """Returns the size of the .text sections of obj, or None."""
+  tool = which('llvm-size') or which('size')
+  if not tool:
+    return None
+  try:
+    out, _ = run([tool, '-A', obj])
+  except (OSError, RuntimeError):
+    return None
+  size = 0
+  for line in out.splitlines():
+    fields = line.split()
+    if len(fields) >= 2 and fields[0].startswith('.text'):
+      size += int(fields[1])
+  return size
+
+def time_kernel(exe, iterations, repeat, env=None):
+  """Runs exe repeat times, and returns its fastest time and its output."""
+  best = None
+  output = None
+  for _ in range(max(repeat, 1)):
+    start = time.time()
+    out, _ = run([exe, str(iterations)] if iterations else [exe], env)
+    elapsed = time.time() - start
+    if best is None or elapsed < best:
+      best = elapsed
+    output = out.strip()
+  return best, output
+
+def count_instructions(exe, iterations):
+  """Returns the number of user-space instructions of a run of exe, or
+  None if perf is not available."""
+  if not which('perf'):
+    return None
+  cmd = ['perf', 'stat', '-x,', '-e', 'instructions:u', exe]
+  if iterations:
+    cmd.append(str(iterations))
+  try:
+    _, err = run(cmd)
+  except (OSError, RuntimeError):
+    return None
+  for line in err.splitlines():
+    fields = line.split(',')
+    if len(fields) > 2 and fields[2].startswith('instructions'):
+      try:
+        return int(fields[0])
+      except ValueError:
+        return None
+  return None
+
+def read_stats(stats_file):
+  """Returns the dynamic check statistics of a -stats-file, which is empty
+  unless clang was built with statistics enabled."""
+  try:
+    with open(stats_file) as f:
+      stats = json.load(f)
+  except (IOError, ValueError):
+    return {}
+  prefix = 'DynamicCheckCodeGen.'
+  return dict((k[len(prefix):], v) for k, v in stats.items()
+              if k.startswith(prefix))
+
+def read_profile(profile_file):
+  """Returns, per kind, the number of checks in the profile and the number
+  of times they executed.  The runtime writes no profile for a program
+  without checks."""
+  checks = dict((kind, {'emitted': 0, 'executed': 0})
+                for kind, _ in CHECK_KINDS)
+  if not os.path.exists(profile_file):
+    return checks
+  with open(profile_file) as f:
+    for line in f:
+      # file:line:column: kind count
+      location, _, rest = line.rstrip('\n').rpartition(': ')
+      fields = rest.split()
+      if not location or len(fields) != 2:
+        continue
+      entry = checks.setdefault(fields[0], {'emitted': 0, 'executed': 0})
+      entry['emitted'] += 1
+      entry['executed'] += int(fields[1])
+  return checks
+
+def ratio(a, b):
+  if a is None or not b:
+    return None
+  return float(a) / b
+
+def bench_kernel(args, kernel):
+  source = os.path.join(args.kernels_dir, kernel + '.c')
+  base = os.path.join(args.build_dir, kernel)
+  checked_flags = ['-DCHECKEDC_BENCH_CHECKED']
+  stats_file = base + '.checked.stats.json'
+
+  unchecked_obj = compile_kernel(args, source, base + '.unchecked.o', [])
+  checked_obj = compile_kernel(args, source, base + '.checked.o',
+                               checked_flags, stats_file)
+  profile_flags = checked_flags + ['-fcheckedc-check-profile']
+  profile_obj = compile_kernel(args, source, base + '.profile.o',
+                               profile_flags)
+  calls_obj = compile_kernel(args, source, base + '.calls.o',
+                             checked_flags + ['-fcheckedc-check-calls'])
+
+  unchecked_exe = link(args, [unchecked_obj], base + '.unchecked', [])
+  checked_exe = link(args, [checked_obj], base + '.checked', [])
+  profile_exe = link(args, [profile_obj], base + '.profile',
+                     ['-fcheckedc-check-profile'])
+  calls_exe = link(args, [calls_obj], base + '.calls', [])
+
+  iterations = args.iterations
+  unchecked_time, unchecked_out = time_kernel(unchecked_exe, iterations,
+                                              args.repeat)
+  checked_time, checked_out = time_kernel(checked_exe, iterations,
+                                          args.repeat)
+  calls_time, calls_out = time_kernel(calls_exe, iterations, args.repeat)
+
+  profile_file = base + '.profile.txt'
+  if os.path.exists(profile_file):
+    os.remove(profile_file)
+  env = dict(os.environ)
+  env['CHECKEDC_CHECK_PROFILE'] = profile_file
+  time_kernel(profile_exe, iterations, 1, env)
+  checks = read_profile(profile_file)
+
+  stats = read_stats(stats_file)
+  for kind, stat in CHECK_KINDS:
+    entry = checks[kind]
+    entry['executed_per_emitted'] = ratio(entry['executed'], entry['emitted'])
+    entry['statistic'] = stats.get(stat)
+
+  unchecked_insts = count_instructions(unchecked_exe, iterations)
+  checked_insts = count_instructions(checked_exe, iterations)
+  unchecked_size = text_size(unchecked_obj)
+  checked_size = text_size(checked_obj)
+  calls_size = text_size(calls_obj)
+
+  return {
+    'kernel': kernel,
+    'cflags': args.cflags,
+    'outputs_match': unchecked_out == checked_out == calls_out,
+    'time_s': {'unchecked': unchecked_time, 'checked': checked_time,
+               'ratio': ratio(checked_time, unchecked_time)},
+    'instructions': {'unchecked': unchecked_insts, 'checked': checked_insts,
+                     'ratio': ratio(checked_insts, unchecked_insts)},
+    'text_bytes': {'unchecked': unchecked_size, 'checked': checked_size,
+                   'ratio': ratio(checked_size, unchecked_size)},
+    # The build with -fcheckedc-check-calls, against the checked build.
+    'check_calls': {
+      'time_s': {'calls': calls_time,
+                 'ratio': ratio(calls_time, checked_time)},
+      'text_bytes': {'calls': calls_size,
+                     'ratio': ratio(calls_size, checked_size)},
+    },
+    'checks': checks,
+    'statistics': stats,
+  }
+
+def format_ratio(value):
+  return '-' if value is None else '%.3f' % value
+
+def main():
+  parser = argparse.ArgumentParser(
+    description='Measures the runtime overhead of Checked C checks.')
+  parser.add_argument('--clang', required=True,
+                      help='the clang to build the kernels with')
+  parser.add_argument('--build-dir', required=True,
+                      help='the directory to build the kernels in')
+  parser.add_argument('--output',
+                      help='the file to write the JSON results to')
+  parser.add_argument('--kernels', default=','.join(KERNELS),
+                      help='a comma-separated list of kernels to run')
+  parser.add_argument('--iterations', type=int, default=0,
+                      help='the number of iterations of each kernel, or 0 '
+                           'for the default of the kernel')
+  parser.add_argument('--repeat', type=int, default=5,
+                      help='the number of runs of each build; the fastest '
+                           'is reported')
+  parser.add_argument('--cflags', default='-O2',
+                      help='the flags to build the kernels with')
+  args = parser.parse_args()
+  args.kernels_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                  'kernels')
+
+  if not os.path.isdir(args.build_dir):
+    os.makedirs(args.build_dir)
+
+  results = []
+  failed = False
+  for kernel in args.kernels.split(','):
+    kernel = kernel.strip()
+    if not kernel:
+      continue
+    try:
+      result = bench_kernel(args, kernel)
+    except (OSError, RuntimeError) as e:
+      print('error: %s: %s' % (kernel, e), file=sys.stderr)
+      failed = True
+      continue
+    results.append(result)
+    executed = sum(c['executed'] for c in result['checks'].values())
+    emitted = sum(c['emitted'] for c in result['checks'].values())
+    print('%-8s time x%s  instructions x%s  text x%s  checks %d emitted, '
+          '%d executed  calls: time x%s text x%s%s' %
+          (kernel, format_ratio(result['time_s']['ratio']),
+           format_ratio(result['instructions']['ratio']),
+           format_ratio(result['text_bytes']['ratio']), emitted, executed,
+           format_ratio(result['check_calls']['time_s']['ratio']),
+           format_ratio(result['check_calls']['text_bytes']['ratio']),
+           '' if result['outputs_match'] else '  (outputs differ)'))
+    if not result['outputs_match']:
+      failed = True
+
+  if args.output:
+    with open(args.output, 'w') as f:
+      for result in results:
+        f.write(json.dumps(result, sort_keys=True) + '\n')
+  return 1 if failed else 0
+
+if __name__ == '__main__':
+  sys.exit(main())
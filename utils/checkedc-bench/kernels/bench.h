@@ -0,0 +1,62 @@
+/*===- bench.h - Checked and unchecked versions of the kernels ------------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+/*
+ * Each kernel of checkedc-bench is compiled twice.  With
+ * -DCHECKEDC_BENCH_CHECKED, its pointers are Checked C pointers with bounds
+ * and its arrays are checked arrays; without it, they are plain C pointers
+ * and arrays, so the two versions only differ by their dynamic checks.
+ *
+ * A kernel takes the number of iterations to run as its argument and prints
+ * a checksum, which must be the same for both versions.
+ */
+
+#ifndef CHECKEDC_BENCH_H
+#define CHECKEDC_BENCH_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef CHECKEDC_BENCH_CHECKED
+#define PTR(T) _Ptr<T>
+#define ARRAY_PTR(T) _Array_ptr<T>
+#define NT_ARRAY_PTR(T) _Nt_array_ptr<T>
+#define COUNT(N) : count(N)
+#define CHECKED _Checked
+#define NT_CHECKED _Nt_checked
+/* The element E of an array, as a _Ptr, checked against the array bounds. */
+#define TO_PTR(T, E) _Dynamic_bounds_cast<_Ptr<T>>(E)
+/* The N elements at E, as an _Array_ptr checked against the bounds of E. */
+#define WITH_COUNT(T, E, N) _Dynamic_bounds_cast<_Array_ptr<T>>(E, count(N))
+#else
+#define PTR(T) T *
+#define ARRAY_PTR(T) T *
+#define NT_ARRAY_PTR(T) T *
+#define COUNT(N)
+#define CHECKED
+#define NT_CHECKED
+#define TO_PTR(T, E) (E)
+#define WITH_COUNT(T, E, N) (E)
+#endif
+
+/* Returns the number of iterations given on the command line, or Default. */
+static long bench_iterations(int argc, char **argv, long Default) {
+  long n = argc > 1 ? atol(argv[1]) : Default;
+  return n > 0 ? n : Default;
+}
+
+/* A linear congruential generator, so that the inputs are the same for both
+ * versions and on every run. */
+static unsigned bench_seed = 1;
+
+static unsigned bench_random(void) {
+  bench_seed = bench_seed * 1664525u + 1013904223u;
+  return bench_seed >> 8;
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*===- list.c - Traversals of linked lists ---------------------------------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+/*
+ * Links the nodes of a pool into a list in a scattered order, then sums,
+ * reverses and filters the list, going through _Ptr links.
+ */
+
+#include "bench.h"
+
+#define NUM_NODES 65536
+
+struct node {
+  PTR(struct node) next;
+  int value;
+};
+
+static struct node pool CHECKED[NUM_NODES];
+
+static PTR(struct node) build(int n, ARRAY_PTR(struct node) nodes COUNT(n)) {
+  PTR(struct node) head = NULL;
+  for (int i = 0; i < n; i++) {
+    /* 7919 is prime, so the nodes are linked in a permutation of the pool. */
+    int j = (int)(((unsigned)i * 7919u) % (unsigned)n);
+    PTR(struct node) p = TO_PTR(struct node, &nodes[j]);
+    p->value = (int)(bench_random() % 1000);
+    p->next = head;
+    head = p;
+  }
+  return head;
+}
+
+static long sum(PTR(struct node) p) {
+  long total = 0;
+  for (; p != NULL; p = p->next)
+    total += p->value;
+  return total;
+}
+
+static PTR(struct node) reverse(PTR(struct node) p) {
+  PTR(struct node) prev = NULL;
+  while (p != NULL) {
+    PTR(struct node) next = p->next;
+    p->next = prev;
+    prev = p;
+    p = next;
+  }
+  return prev;
+}
+
+static int count_above(PTR(struct node) p, int threshold) {
+  int count = 0;
+  for (; p != NULL; p = p->next)
+    if (p->value > threshold)
+      count++;
+  return count;
+}
+
+int main(int argc, char **argv) {
+  long iterations = bench_iterations(argc, argv, 500);
+  unsigned long checksum = 0;
+
+  PTR(struct node) head = build(NUM_NODES, pool);
+  for (long i = 0; i < iterations; i++) {
+    checksum += sum(head);
+    head = reverse(head);
+    checksum += count_above(head, (int)(i % 1000));
+    head->value = (int)(i % 1000);
+  }
+  printf("%lu\n", checksum);
+  return 0;
+}
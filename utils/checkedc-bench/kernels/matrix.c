@@ -0,0 +1,62 @@
+/*===- matrix.c - Loops over matrices through array pointers --------------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+/*
+ * Multiplies square matrices and applies a five-point stencil to the
+ * product, with the matrices stored row by row behind counted array
+ * pointers.
+ */
+
+#include "bench.h"
+
+#define N 128
+
+static double a CHECKED[N * N];
+static double b CHECKED[N * N];
+static double c CHECKED[N * N];
+static double d CHECKED[N * N];
+
+static void multiply(int n, ARRAY_PTR(double) x COUNT(n * n),
+                     ARRAY_PTR(double) y COUNT(n * n),
+                     ARRAY_PTR(double) z COUNT(n * n)) {
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++) {
+      double sum = 0;
+      for (int k = 0; k < n; k++)
+        sum += x[i * n + k] * y[k * n + j];
+      z[i * n + j] = sum;
+    }
+}
+
+static void stencil(int n, ARRAY_PTR(double) in COUNT(n * n),
+                    ARRAY_PTR(double) out COUNT(n * n)) {
+  for (int i = 1; i + 1 < n; i++)
+    for (int j = 1; j + 1 < n; j++)
+      out[i * n + j] = 0.5 * in[i * n + j] +
+                       0.125 * (in[(i - 1) * n + j] + in[(i + 1) * n + j] +
+                                in[i * n + j - 1] + in[i * n + j + 1]);
+}
+
+int main(int argc, char **argv) {
+  long iterations = bench_iterations(argc, argv, 20);
+  double checksum = 0;
+
+  for (int i = 0; i < N * N; i++) {
+    a[i] = (bench_random() % 1000) / 1000.0;
+    b[i] = (bench_random() % 1000) / 1000.0;
+  }
+
+  for (long i = 0; i < iterations; i++) {
+    multiply(N, a, b, c);
+    stencil(N, c, d);
+    checksum += d[(N / 2) * N + 1 + i % (N - 2)];
+    a[i % (N * N)] += 0.001;
+  }
+  printf("%.6f\n", checksum);
+  return 0;
+}
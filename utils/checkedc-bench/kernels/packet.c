@@ -0,0 +1,95 @@
+/*===- packet.c - Parsing of length-prefixed packets ----------------------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+/*
+ * Parses a buffer of packets, each a type byte and a big-endian 16-bit
+ * length followed by that many bytes of payload.  The payload of each packet
+ * is given its own bounds, and is summed, hashed or checked depending on the
+ * type of the packet.  The bytes after the last packet are zero, and parse
+ * as empty packets.
+ */
+
+#include "bench.h"
+
+#define BUF_SIZE (1 << 20)
+
+static unsigned char buffer CHECKED[BUF_SIZE];
+
+static unsigned sum_bytes(int len, ARRAY_PTR(unsigned char) p COUNT(len)) {
+  unsigned sum = 0;
+  for (int i = 0; i < len; i++)
+    sum += p[i];
+  return sum;
+}
+
+static unsigned sum_words(int len, ARRAY_PTR(unsigned char) p COUNT(len)) {
+  unsigned sum = 0;
+  for (int i = 0; i + 1 < len; i += 2)
+    sum += (p[i] << 8) | p[i + 1];
+  return sum;
+}
+
+static unsigned checksum_bytes(int len, ARRAY_PTR(unsigned char) p COUNT(len)) {
+  unsigned a = 1, b = 0;
+  for (int i = 0; i < len; i++) {
+    a = (a + p[i]) % 65521;
+    b = (b + a) % 65521;
+  }
+  return (b << 16) | a;
+}
+
+static unsigned long parse(int n, ARRAY_PTR(unsigned char) buf COUNT(n)) {
+  unsigned long result = 0;
+  int pos = 0;
+  while (pos + 3 <= n) {
+    int type = buf[pos];
+    int len = (buf[pos + 1] << 8) | buf[pos + 2];
+    pos += 3;
+    if (len > n - pos)
+      break;
+    ARRAY_PTR(unsigned char) payload COUNT(len) =
+        WITH_COUNT(unsigned char, buf + pos, len);
+    switch (type % 3) {
+    case 0:
+      result += sum_bytes(len, payload);
+      break;
+    case 1:
+      result += sum_words(len, payload);
+      break;
+    default:
+      result += checksum_bytes(len, payload);
+      break;
+    }
+    pos += len;
+  }
+  return result;
+}
+
+int main(int argc, char **argv) {
+  long iterations = bench_iterations(argc, argv, 200);
+  unsigned long checksum = 0;
+
+  int pos = 0;
+  while (pos + 3 + 1500 <= BUF_SIZE) {
+    int len = 20 + bench_random() % 1480;
+    buffer[pos] = bench_random() % 256;
+    buffer[pos + 1] = len >> 8;
+    buffer[pos + 2] = len & 0xff;
+    pos += 3;
+    for (int i = 0; i < len; i++)
+      buffer[pos + i] = bench_random() % 256;
+    pos += len;
+  }
+
+  for (long i = 0; i < iterations; i++) {
+    checksum += parse(BUF_SIZE, buffer);
+    buffer[3 + i % 17] ^= 1;
+  }
+  printf("%lu\n", checksum);
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*===- string.c - String processing over null-terminated arrays -----------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+/*
+ * Counts the words of a text, copies it in upper case and hashes the copy,
+ * reading and writing through null-terminated pointers.
+ */
+
+#include "bench.h"
+
+#define TEXT_LEN 65536
+
+static char text NT_CHECKED[TEXT_LEN + 1];
+static char copy NT_CHECKED[TEXT_LEN + 1];
+
+static int count_words(int n, NT_ARRAY_PTR(char) s COUNT(n)) {
+  int words = 0, in_word = 0;
+  for (int i = 0; i < n && s[i] != '\0'; i++) {
+    int space = s[i] == ' ' || s[i] == '\n';
+    if (!space && !in_word)
+      words++;
+    in_word = !space;
+  }
+  return words;
+}
+
+static int copy_upper(int n, NT_ARRAY_PTR(char) dst COUNT(n),
+                      NT_ARRAY_PTR(char) src COUNT(n)) {
+  int i = 0;
+  for (; i < n && src[i] != '\0'; i++) {
+    char c = src[i];
+    dst[i] = c >= 'a' && c <= 'z' ? c - 'a' + 'A' : c;
+  }
+  dst[i] = '\0';
+  return i;
+}
+
+static unsigned hash(int n, NT_ARRAY_PTR(char) s COUNT(n)) {
+  unsigned h = 2166136261u;
+  for (int i = 0; i < n && s[i] != '\0'; i++)
+    h = (h ^ (unsigned char)s[i]) * 16777619u;
+  return h;
+}
+
+int main(int argc, char **argv) {
+  static const char *const words[] = {
+    "checked", "pointer", "bounds", "a", "of", "the", "array", "null",
+    "terminated", "string", "x", "dynamic", "check", "is", "in", "loop",
+  };
+  long iterations = bench_iterations(argc, argv, 2000);
+  unsigned long checksum = 0;
+
+  int len = 0;
+  while (len < TEXT_LEN - 16) {
+    const char *w = words[bench_random() % 16];
+    while (*w)
+      text[len++] = *w++;
+    text[len++] = bench_random() % 8 == 0 ? '\n' : ' ';
+  }
+  text[len] = '\0';
+
+  for (long i = 0; i < iterations; i++) {
+    checksum += count_words(TEXT_LEN, text);
+    checksum += copy_upper(TEXT_LEN, copy, text);
+    checksum += hash(TEXT_LEN, copy);
+    /* Change the text a little, so that the work cannot be reused. */
+    text[i % len] = text[i % len] == ' ' ? 'z' : ' ';
+  }
+  printf("%lu\n", checksum);
+  return 0;
+}